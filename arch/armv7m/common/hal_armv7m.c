@@ -0,0 +1,538 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file hal_armv7m.c
+ * @brief ARMv7-M Hardware Abstraction Layer Implementation
+ *
+ * This file implements the HAL interface defined in arch/common/hal.h
+ * for ARMv7-M cores (Cortex-M3/M4/M7).
+ *
+ * Features:
+ * - SysTick system tick, with a one-shot mode for tickless idle
+ * - DWT cycle counter (hal_cycles) and delays
+ * - PendSV context switch, tail-chained after the tick ISR
+ * - Lazy FPU stacking: s16-s31 are saved only for tasks that have
+ *   touched the FPU, and the hardware defers s0-s15 until needed
+ * - MPU stack guard: the scheduler moves one no-access region under
+ *   each task's stack as it switches to it
+ */
+
+#include "arch/common/hal.h"
+#include "arch/armv7m/include/hal_armv7m.h"
+
+#include <string.h>
+
+/*═══════════════════════════════════════════════════════════════════
+ * GLOBAL STATE
+ *═══════════════════════════════════════════════════════════════════*/
+
+static volatile uint32_t hal_tick_count = 0;
+static volatile uint8_t  hal_oneshot_armed = 0;
+static volatile uint8_t  hal_oneshot_fired = 0;
+static uint32_t          hal_tick_reload = F_CPU / 1000UL;
+
+/*
+ * The switch the next PendSV performs.  Read by the handler in asm, so
+ * the layout is fixed: from at +0, to at +4, pending at +8.
+ */
+struct hal_armv7m_switch {
+    hal_context_t   *from;
+    hal_context_t   *to;
+    volatile uint8_t pending;
+};
+
+/* Not static: referenced by name from PendSV_Handler */
+struct hal_armv7m_switch hal_armv7m_switch;
+
+_Static_assert(offsetof(struct hal_armv7m_switch, to) == 4, "PendSV_Handler offsets");
+_Static_assert(offsetof(struct hal_armv7m_switch, pending) == 8, "PendSV_Handler offsets");
+
+/*═══════════════════════════════════════════════════════════════════
+ * SYSTEM INITIALIZATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+void hal_init(void) {
+    /* PendSV and SysTick at the lowest priority: a switch never
+     * preempts a device ISR, and PendSV tail-chains after the tick */
+    HAL_SCB_SHPR3 |= (0xFFUL << 16) | (0xFFUL << 24);
+
+    /* Cycle counter for hal_cycles() and hal_timer_delay_us() */
+    HAL_DEMCR |= 1UL << 24;                 /* TRCENA */
+    HAL_DWT_CYCCNT = 0;
+    HAL_DWT_CTRL |= 1UL;                    /* CYCCNTENA */
+
+#if HAL_HAS_FPU
+    /* CP10/CP11 full access, automatic + lazy state preservation */
+    HAL_SCB_CPACR |= 0xFUL << 20;
+    HAL_FPU_FPCCR |= HAL_FPCCR_ASPEN | HAL_FPCCR_LSPEN;
+    hal_dsb();
+    hal_isb();
+#endif
+
+#if HAL_HAS_MPU
+    hal_mpu_init();
+    hal_mpu_enable();
+#endif
+
+    hal_tick_count = 0;
+}
+
+void hal_reset(void) {
+    hal_dsb();
+    HAL_SCB_AIRCR = (0x05FAUL << 16) | (1UL << 2);  /* VECTKEY | SYSRESETREQ */
+    hal_dsb();
+    for (;;) {
+        /* Wait for the reset to take */
+    }
+}
+
+/* Reset-cause registers are vendor-specific (RCC_CSR, RSTC_SR, ...) */
+__attribute__((weak))
+hal_reset_reason_t hal_reset_reason(void) {
+    return HAL_RESET_UNKNOWN;
+}
+
+void hal_get_caps(hal_caps_t *caps) {
+    if (!caps) return;
+
+    memset(caps, 0, sizeof(hal_caps_t));
+
+    caps->has_mpu          = HAL_HAS_MPU && (HAL_MPU_TYPE >> 8 & 0xFF) != 0;
+    caps->has_fpu          = HAL_HAS_FPU;
+    caps->has_hardware_div = HAL_HAS_HARDWARE_DIV;
+    caps->has_atomic_ops   = HAL_HAS_ATOMIC_U32;
+    caps->has_dma          = HAL_HAS_DMA;
+    caps->has_cache        = HAL_HAS_CACHE;
+    caps->num_cores        = 1;
+    caps->cpu_freq_hz      = HAL_CPU_FREQ_HZ;
+}
+
+const char *hal_arch_name(void) {
+    return "ARMv7-M";
+}
+
+const char *hal_cpu_model(void) {
+    return HAL_MCU_NAME;
+}
+
+/* Stop-mode wake-up: regulator and HSI restart (see the part datasheet) */
+#ifndef HAL_DEEP_EXIT_US
+#  define HAL_DEEP_EXIT_US 100
+#endif
+
+#define HAL_SCR_SLEEPDEEP (1UL << 2)
+
+/* No intermediate level: SAVE falls back to WFI */
+static const hal_sleep_info_t hal_sleep_tab[HAL_SLEEP_LEVELS] = {
+    [HAL_SLEEP_IDLE] = { 1,                0, HAL_SLEEP_F_TIMED },
+    [HAL_SLEEP_SAVE] = { 1,                0, HAL_SLEEP_F_NONE },
+    [HAL_SLEEP_DEEP] = { HAL_DEEP_EXIT_US, 0, 0 },
+};
+
+const hal_sleep_info_t *hal_sleep_info(void) {
+    return hal_sleep_tab;
+}
+
+/*
+ * SLEEPDEEP usually stops SysTick and the PLL as well: the board's
+ * wake-up interrupt is responsible for bringing its clock tree back.
+ */
+void hal_sleep(hal_sleep_t level) {
+    if (level == HAL_SLEEP_DEEP) {
+        HAL_SCB_SCR |= HAL_SCR_SLEEPDEEP;
+        hal_idle();
+        HAL_SCB_SCR &= ~HAL_SCR_SLEEPDEEP;
+    } else {
+        hal_idle();
+    }
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * TIMER & TICK MANAGEMENT
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief System tick handler - called from SysTick_Handler
+ *
+ * Weak so that the kernel scheduler can override it.
+ */
+__attribute__((weak))
+void hal_timer_tick_handler(void) {
+}
+
+void SysTick_Handler(void) {
+    if (hal_oneshot_armed) {
+        /* One-shot expired: stop the counter, hal_timer_resume() accounts */
+        HAL_SYST_CSR = 0;
+        hal_oneshot_fired = 1;
+        return;
+    }
+    hal_tick_count++;
+    hal_timer_tick_handler();
+}
+
+static void systick_start(uint32_t counts) {
+    HAL_SYST_CSR = 0;
+    HAL_SYST_RVR = counts - 1;
+    HAL_SYST_CVR = 0;                       /* any write reloads */
+    HAL_SYST_CSR = HAL_SYST_CLKSOURCE | HAL_SYST_TICKINT | HAL_SYST_ENABLE;
+}
+
+void hal_timer_init(uint32_t freq_hz) {
+    uint32_t counts = freq_hz ? F_CPU / freq_hz : F_CPU / 1000UL;
+    if (counts > HAL_SYST_RELOAD_MAX + 1) counts = HAL_SYST_RELOAD_MAX + 1;
+
+    hal_tick_reload = counts;
+    hal_tick_count = 0;
+    systick_start(counts);
+}
+
+/*
+ * Tickless idle: SysTick is simply reloaded with ticks * reload, capped
+ * by its 24-bit counter (~100 ms at 168 MHz).
+ */
+uint16_t hal_timer_oneshot(uint16_t ticks) {
+    uint32_t max = (HAL_SYST_RELOAD_MAX + 1) / hal_tick_reload;
+    if (ticks > max) ticks = (uint16_t)max;
+    if (ticks == 0) ticks = 1;
+
+    hal_oneshot_fired = 0;
+    hal_oneshot_armed = 1;
+    systick_start((uint32_t)ticks * hal_tick_reload);
+    return ticks;
+}
+
+uint16_t hal_timer_resume(void) {
+    uint32_t load = HAL_SYST_RVR + 1;
+    uint32_t left = HAL_SYST_CVR;
+    HAL_SYST_CSR = 0;
+
+    uint32_t counts = hal_oneshot_fired ? load : load - left;
+    hal_oneshot_armed = 0;
+
+    /* Back to the periodic tick */
+    systick_start(hal_tick_reload);
+    return (uint16_t)(counts / hal_tick_reload);
+}
+
+uint32_t hal_timer_ticks(void) {
+    return hal_tick_count;                  /* aligned word: one load */
+}
+
+void hal_timer_delay_us(uint32_t us) {
+    uint32_t start = hal_cycles();
+    uint32_t cycles = us * (F_CPU / 1000000UL);
+
+    while (hal_cycles() - start < cycles) {
+    }
+}
+
+void hal_timer_delay_ms(uint32_t ms) {
+    while (ms--) {
+        hal_timer_delay_us(1000);
+    }
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONTEXT MANAGEMENT
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* A task entry that returns lands here */
+static void hal_task_return(void) {
+    hal_irq_disable();
+    for (;;) hal_idle();
+}
+
+/**
+ * @brief Initialize a new task context
+ *
+ * Builds the frame PendSV_Handler expects to pop (grows downward):
+ *   [stack + stack_size, rounded down to 8]
+ *   - xPSR, PC, LR, r12, r3-r0   [hardware frame, T bit set]
+ *   - EXC_RETURN                 [0xFFFFFFFD: thread mode, PSP, no FP]
+ *   - r11-r4                     [all zero]
+ *   [lower addresses]            <- saved PSP
+ */
+void hal_context_init(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size) {
+    if (!ctx || !entry || !stack || stack_size < 128) {
+        return;  /* Invalid parameters */
+    }
+
+    uint32_t *sp = (uint32_t *)(((uintptr_t)stack + stack_size) & ~(uintptr_t)7);
+
+    *--sp = 0x01000000UL;                           /* xPSR: Thumb */
+    *--sp = (uint32_t)(uintptr_t)entry & ~1UL;      /* PC */
+    *--sp = (uint32_t)(uintptr_t)hal_task_return;   /* LR */
+    sp -= 5;                                        /* r12, r3-r0 */
+    memset(sp, 0, 5 * sizeof(uint32_t));
+
+    *--sp = 0xFFFFFFFDUL;                           /* EXC_RETURN */
+    sp -= 8;                                        /* r11-r4 */
+    memset(sp, 0, 8 * sizeof(uint32_t));
+
+    ctx->sp = (uint16_t)(((uintptr_t)sp - HAL_SRAM_BASE) >> 2);
+}
+
+/**
+ * @brief Request a switch; PendSV_Handler performs it
+ *
+ * From the tick ISR this only pends PendSV, which tail-chains once the
+ * ISR (and any nested one) returns.  From a task the caller holds the
+ * scheduler lock, so PRIMASK is opened for just long enough to take
+ * the PendSV here; the task resumes on the same instruction when it is
+ * switched back in and re-masks, as if the call had simply returned.
+ *
+ * If a second request arrives before PendSV has run (a nested ISR),
+ * the task that is really on the CPU stays the one to save.
+ */
+void hal_context_switch(hal_context_t *from, hal_context_t *to) {
+    if (!hal_armv7m_switch.pending) {
+        hal_armv7m_switch.from = from;
+    } else if (to == hal_armv7m_switch.from) {
+        HAL_SCB_ICSR = HAL_ICSR_PENDSVCLR;          /* back where we started */
+        hal_armv7m_switch.pending = 0;
+        return;
+    }
+    hal_armv7m_switch.to = to;
+    hal_armv7m_switch.pending = 1;
+    HAL_SCB_ICSR = HAL_ICSR_PENDSVSET;
+
+    if (!hal_in_isr()) {
+        __asm__ volatile ("cpsie i\n\t"
+                          "isb\n\t"
+                          "cpsid i" ::: "memory");
+    }
+}
+
+/**
+ * @brief PendSV: save the outgoing task, restore the incoming one
+ *
+ * On entry the hardware has stacked r0-r3, r12, LR, PC and xPSR on the
+ * task's PSP, plus (lazily) s0-s15/FPSCR if the task has an active FP
+ * context.  EXC_RETURN bit 4 is clear exactly in that case, and only
+ * then does the handler push s16-s31; the VSTM itself is what triggers
+ * the deferred s0-s15 save.  Integer-only tasks never pay for the FPU.
+ *
+ * EXC_RETURN is saved with the task, so each one resumes with its own
+ * frame type.  A switch away from the boot code (thread mode on MSP,
+ * EXC_RETURN bit 2 clear) or with a NULL @c from saves nothing.
+ */
+__attribute__((naked))
+void PendSV_Handler(void) {
+    __asm__ volatile (
+        "cpsid   i\n\t"
+        "movw    r2, #:lower16:hal_armv7m_switch\n\t"
+        "movt    r2, #:upper16:hal_armv7m_switch\n\t"
+        "movw    r3, #:lower16:%c[base]\n\t"
+        "movt    r3, #:upper16:%c[base]\n\t"
+
+        /* Save the outgoing task */
+        "ldr     r1, [r2, #0]\n\t"          /* from */
+        "cbz     r1, 1f\n\t"
+        "tst     lr, #4\n\t"                /* came from MSP (boot)? */
+        "beq     1f\n\t"
+        "mrs     r0, psp\n\t"
+#if HAL_HAS_FPU
+        "tst     lr, #0x10\n\t"             /* bit 4 clear: FP frame */
+        "it      eq\n\t"
+        "vstmdbeq r0!, {s16-s31}\n\t"
+#endif
+        "stmdb   r0!, {r4-r11, lr}\n\t"
+        "sub     r0, r0, r3\n\t"
+        "lsrs    r0, r0, #2\n\t"
+        "strh    r0, [r1]\n\t"
+
+        /* Restore the incoming one */
+        "1:\n\t"
+        "ldr     r1, [r2, #4]\n\t"          /* to */
+        "ldrh    r0, [r1]\n\t"
+        "add     r0, r3, r0, lsl #2\n\t"
+        "ldmia   r0!, {r4-r11, lr}\n\t"
+#if HAL_HAS_FPU
+        "tst     lr, #0x10\n\t"
+        "it      eq\n\t"
+        "vldmiaeq r0!, {s16-s31}\n\t"
+#endif
+        "msr     psp, r0\n\t"
+        "movs    r0, #0\n\t"
+        "strb    r0, [r2, #8]\n\t"          /* pending = 0 */
+        "clrex\n\t"
+        "cpsie   i\n\t"
+        "bx      lr\n\t"
+        :: [base] "i"(HAL_SRAM_BASE)
+    );
+}
+
+#if HAL_HAS_MPU
+/*═══════════════════════════════════════════════════════════════════
+ * MPU (PMSAv7)
+ *═══════════════════════════════════════════════════════════════════
+ *
+ * Privileged code keeps the default memory map (PRIVDEFENA) wherever
+ * no region matches, so an enabled MPU with no regions behaves as if it
+ * were off.  Regions only carve exceptions out of that map; the stack
+ * guard is the highest-numbered one so it overrides the rest.
+ */
+
+/* RASR.AP for a permission set; XN is added separately */
+static uint32_t mpu_ap(uint8_t perm) {
+    if (perm & HAL_MPU_WRITE) return 3UL;           /* full access */
+    if (perm & (HAL_MPU_READ | HAL_MPU_EXEC)) return 6UL; /* read-only */
+    return 0UL;                                     /* no access */
+}
+
+void hal_mpu_init(void) {
+    uint8_t n = (uint8_t)(HAL_MPU_TYPE >> 8);       /* DREGION */
+
+    HAL_MPU_CTRL = 0;
+    for (uint8_t r = 0; r < n; r++) {
+        HAL_MPU_RNR = r;
+        HAL_MPU_RASR = 0;
+    }
+    /* A guard hit raises MemManage rather than escalating to HardFault */
+    HAL_SCB_SHCSR |= HAL_SHCSR_MEMFAULTENA;
+    hal_dsb();
+    hal_isb();
+}
+
+/* Regions must be a power of two from 32 bytes, aligned to their size */
+void hal_mpu_configure_region(uint8_t region_num, const hal_mpu_region_t *config) {
+    if (!config || region_num >= (uint8_t)(HAL_MPU_TYPE >> 8)) return;
+    if (config->size < 32 || (config->size & (config->size - 1)) ||
+        (config->base_addr & (config->size - 1))) {
+        return;
+    }
+
+    uint32_t rasr = 0;
+    if (config->enable) {
+        rasr = mpu_ap(config->permissions) << 24 |
+               (uint32_t)(__builtin_ctz(config->size) - 1) << 1 |
+               HAL_MPU_RASR_ENABLE;
+        if (!(config->permissions & HAL_MPU_EXEC)) rasr |= HAL_MPU_RASR_XN;
+    }
+    HAL_MPU_RBAR = config->base_addr | HAL_MPU_RBAR_VALID | region_num;
+    HAL_MPU_RASR = rasr;
+    hal_dsb();
+    hal_isb();
+}
+
+void hal_mpu_enable(void) {
+    HAL_MPU_CTRL = HAL_MPU_CTRL_PRIVDEFENA | HAL_MPU_CTRL_ENABLE;
+    hal_dsb();
+    hal_isb();
+}
+
+void hal_mpu_disable(void) {
+    hal_dmb();
+    HAL_MPU_CTRL = 0;
+    hal_dsb();
+    hal_isb();
+}
+
+_Static_assert(HAL_STACK_GUARD_SIZE >= 32 &&
+               (HAL_STACK_GUARD_SIZE & (HAL_STACK_GUARD_SIZE - 1)) == 0,
+               "PMSAv7 regions are powers of two from 32 bytes");
+
+#define HAL_GUARD_RASR (HAL_MPU_RASR_XN |                                  \
+                        (uint32_t)(__builtin_ctz(HAL_STACK_GUARD_SIZE) - 1) << 1 | \
+                        HAL_MPU_RASR_ENABLE)
+
+/*
+ * Two stores per switch.  This runs before PendSV, still on the outgoing
+ * task, which never touches the memory under the incoming stack; the
+ * exception entry stacking onto the new PSP already sees the guard.
+ */
+void hal_mpu_stack_guard(const void *stack_lo) {
+    if (!stack_lo) {
+        HAL_MPU_RNR = HAL_MPU_GUARD_REGION;
+        HAL_MPU_RASR = 0;
+    } else {
+        HAL_MPU_RBAR = ((uint32_t)(uintptr_t)stack_lo - HAL_STACK_GUARD_SIZE) |
+                       HAL_MPU_RBAR_VALID | HAL_MPU_GUARD_REGION;
+        HAL_MPU_RASR = HAL_GUARD_RASR;
+    }
+    hal_dsb();
+}
+
+/*
+ * Stack overflow (or any other region violation): halt like the
+ * scheduler's canary panic.  Weak so a board can log MMFSR/MMFAR first.
+ */
+__attribute__((weak))
+void MemManage_Handler(void) {
+    hal_irq_disable();
+    for (;;) hal_idle();
+}
+#endif /* HAL_HAS_MPU */
+
+/*═══════════════════════════════════════════════════════════════════
+ * OPTIONAL: EARLY INIT (can be overridden)
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Platform-specific early initialization (weak)
+ *
+ * Called before hal_init(); clock tree and external memory setup go
+ * here in the board glue.
+ */
+__attribute__((weak))
+void hal_early_init(void) {
+    /* Default: do nothing */
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONSOLE UART (board glue)
+ *═══════════════════════════════════════════════════════════════════*/
+
+/*
+ * UART blocks differ per vendor; the board file overrides these and
+ * feeds tty_rx_isr()/tty_tx_isr() from its own vectors.
+ */
+__attribute__((weak))
+void hal_uart_attach(struct tty_s *t, uint32_t baud) {
+    (void)t;
+    (void)baud;
+}
+
+__attribute__((weak))
+void hal_uart_tx_kick(void) {
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PROGRAM FLASH (board glue)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if HAL_HAS_FLASH_WRITE
+
+/*
+ * Flash controllers differ per vendor (FLASH_CR/SR, NVMC, EEFC...); the
+ * board file overrides these three, starting the erase and program in
+ * hal_flash_write_page() and reporting the controller's BSY bit (or a
+ * completion flag set from its interrupt) in hal_flash_busy().  The
+ * defaults report no writable flash.
+ */
+__attribute__((weak))
+uint32_t hal_flash_size(void) {
+    return 0;
+}
+
+__attribute__((weak))
+bool hal_flash_write_page(uint32_t addr, const void *page) {
+    (void)addr;
+    (void)page;
+    return false;
+}
+
+__attribute__((weak))
+bool hal_flash_busy(void) {
+    return false;
+}
+
+void hal_flash_read(void *dst, uint32_t addr, size_t len) {
+    while (hal_flash_busy()) {}     /* reads stall on most parts anyway */
+    memcpy(dst, (const void *)(HAL_FLASH_BASE + addr), len);
+}
+
+#endif /* HAL_HAS_FLASH_WRITE */
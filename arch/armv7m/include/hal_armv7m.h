@@ -0,0 +1,443 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file hal_armv7m.h
+ * @brief ARMv7-M (Cortex-M3/M4/M7) Architecture-Specific HAL Definitions
+ *
+ * This header provides the ARMv7-M implementations and types for the
+ * common HAL interface defined in arch/common/hal.h.  Only core
+ * peripherals (NVIC/SCB, SysTick, DWT, FPU) are touched here; UARTs,
+ * DMA and reset-cause registers are vendor-specific and come from the
+ * board glue.
+ *
+ * - Interrupts: PRIMASK (cpsid/cpsie)
+ * - Atomics:    LDREX/STREX retry loops, no interrupt masking
+ * - Tick:       SysTick at the scheduler's 1 kHz
+ * - Switch:     PendSV at the lowest priority, tail-chained after SysTick
+ * - FPU:        s16-s31 saved only for tasks with an active FP context
+ * - MPU:        one no-access region below the running task's stack
+ */
+
+#ifndef HAL_ARMV7M_H
+#define HAL_ARMV7M_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+/*═══════════════════════════════════════════════════════════════════
+ * ARMV7-M-SPECIFIC CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if defined(__ARM_FP) && !defined(__SOFTFP__)
+#  define HAL_HAS_FPU       1   /* Cortex-M4F/M7 built with -mfloat-abi=hard/softfp */
+#else
+#  define HAL_HAS_FPU       0
+#endif
+
+/* PMSAv7 MPU: optional in the core, -DHAL_HAS_MPU=0 on parts without one */
+#ifndef HAL_HAS_MPU
+#  define HAL_HAS_MPU       1
+#endif
+#define HAL_HAS_CACHE       0
+#define HAL_HAS_HARDWARE_DIV 1
+#define HAL_SWITCH_DEFERRED 1   /* hal_context_switch() pends PendSV */
+
+/* Chip glue that implements the hal_dma_* section sets this to 1 */
+#ifndef HAL_HAS_DMA
+#  define HAL_HAS_DMA       0
+#endif
+
+#define HAL_HAS_ATOMIC_U8   1
+#define HAL_HAS_ATOMIC_U16  1
+#define HAL_HAS_ATOMIC_U32  1
+
+#ifndef HAL_MCU_NAME
+#  if defined(__ARM_ARCH_7EM__)
+#    define HAL_MCU_NAME "Cortex-M4/M7"
+#  else
+#    define HAL_MCU_NAME "Cortex-M3"
+#  endif
+#endif
+
+/* Core clock - pass -DF_CPU=... (SystemCoreClock after PLL setup) */
+#ifndef F_CPU
+#  warning "F_CPU not defined, assuming 16 MHz"
+#  define F_CPU 16000000UL
+#endif
+
+#define HAL_CPU_FREQ_HZ F_CPU
+
+/* Highest region wins where regions overlap, so the stack guard takes it */
+#ifndef HAL_MPU_GUARD_REGION
+#  define HAL_MPU_GUARD_REGION 7
+#endif
+
+/* Program flash: memory-mapped for reads; erase/program is in the
+ * vendor's flash controller, which the board glue drives (section 18) */
+#ifndef HAL_HAS_FLASH_WRITE
+#  define HAL_HAS_FLASH_WRITE 1
+#endif
+#define HAL_FLASH_ASYNC     1
+#ifndef HAL_FLASH_PAGE_SIZE
+#  define HAL_FLASH_PAGE_SIZE 1024u
+#endif
+#ifndef HAL_FLASH_BASE
+#  define HAL_FLASH_BASE 0x00000000UL
+#endif
+
+/* On-chip SRAM; task stacks must live in the first 256 KB of it */
+#ifndef HAL_SRAM_BASE
+#  define HAL_SRAM_BASE 0x20000000UL
+#endif
+#ifndef HAL_SRAM_SIZE
+#  define HAL_SRAM_SIZE 65536UL
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONTEXT STRUCTURE
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief ARMv7-M task context
+ *
+ * The scheduler keeps a task's context in the 16-bit nk_tcb_t::sp, so
+ * the saved PSP is stored as a word offset from HAL_SRAM_BASE: stacks
+ * are 8-byte aligned and 256 KB of SRAM is reachable.  Everything else
+ * (r4-r11, EXC_RETURN and, for FP tasks, s16-s31) sits on the task's
+ * own stack below the hardware exception frame.
+ */
+typedef struct {
+    uint16_t sp;  /**< (PSP - HAL_SRAM_BASE) / 4 */
+} hal_context_t;
+
+_Static_assert(sizeof(hal_context_t) == 2, "ARMv7-M context must fit nk_tcb_t::sp");
+
+/*═══════════════════════════════════════════════════════════════════
+ * CORE PERIPHERAL REGISTERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define HAL_REG32(addr)     (*(volatile uint32_t *)(addr))
+
+#define HAL_SCB_ICSR        HAL_REG32(0xE000ED04UL)
+#define HAL_SCB_AIRCR       HAL_REG32(0xE000ED0CUL)
+#define HAL_SCB_SCR         HAL_REG32(0xE000ED10UL)
+#define HAL_SCB_SHPR3       HAL_REG32(0xE000ED20UL)
+#define HAL_SCB_CPACR       HAL_REG32(0xE000ED88UL)
+#define HAL_FPU_FPCCR       HAL_REG32(0xE000EF34UL)
+
+#define HAL_SYST_CSR        HAL_REG32(0xE000E010UL)
+#define HAL_SYST_RVR        HAL_REG32(0xE000E014UL)
+#define HAL_SYST_CVR        HAL_REG32(0xE000E018UL)
+
+#define HAL_SCB_SHCSR       HAL_REG32(0xE000ED24UL)
+#define HAL_MPU_TYPE        HAL_REG32(0xE000ED90UL)
+#define HAL_MPU_CTRL        HAL_REG32(0xE000ED94UL)
+#define HAL_MPU_RNR         HAL_REG32(0xE000ED98UL)
+#define HAL_MPU_RBAR        HAL_REG32(0xE000ED9CUL)
+#define HAL_MPU_RASR        HAL_REG32(0xE000EDA0UL)
+
+#define HAL_DEMCR           HAL_REG32(0xE000EDFCUL)
+#define HAL_DWT_CTRL        HAL_REG32(0xE0001000UL)
+#define HAL_DWT_CYCCNT      HAL_REG32(0xE0001004UL)
+
+#define HAL_ICSR_PENDSVSET  (1UL << 28)
+#define HAL_ICSR_PENDSVCLR  (1UL << 27)
+#define HAL_SYST_ENABLE     (1UL << 0)
+#define HAL_SYST_TICKINT    (1UL << 1)
+#define HAL_SYST_CLKSOURCE  (1UL << 2)
+#define HAL_SYST_RELOAD_MAX 0x00FFFFFFUL
+#define HAL_SHCSR_MEMFAULTENA (1UL << 16)
+#define HAL_MPU_CTRL_ENABLE (1UL << 0)
+#define HAL_MPU_CTRL_PRIVDEFENA (1UL << 2)
+#define HAL_MPU_RBAR_VALID  (1UL << 4)
+#define HAL_MPU_RASR_ENABLE (1UL << 0)
+#define HAL_MPU_RASR_XN     (1UL << 28)
+#define HAL_FPCCR_ASPEN     (1UL << 31)
+#define HAL_FPCCR_LSPEN     (1UL << 30)
+
+/*═══════════════════════════════════════════════════════════════════
+ * INLINE HAL FUNCTIONS (PERFORMANCE-CRITICAL)
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Enable global interrupts (clear PRIMASK)
+ */
+static inline void hal_irq_enable(void) {
+    __asm__ volatile ("cpsie i" ::: "memory");
+}
+
+/**
+ * @brief Disable global interrupts (set PRIMASK)
+ */
+static inline void hal_irq_disable(void) {
+    __asm__ volatile ("cpsid i" ::: "memory");
+}
+
+/**
+ * @brief Check if interrupts are enabled
+ */
+static inline bool hal_irq_enabled(void) {
+    uint32_t primask;
+    __asm__ volatile ("mrs %0, primask" : "=r"(primask));
+    return (primask & 1u) == 0;
+}
+
+/**
+ * @brief Save interrupt state and disable
+ */
+static inline uint32_t hal_irq_save(void) {
+    uint32_t primask;
+    __asm__ volatile ("mrs %0, primask\n\t"
+                      "cpsid i" : "=r"(primask) :: "memory");
+    return primask;
+}
+
+/**
+ * @brief Restore interrupt state
+ */
+static inline void hal_irq_restore(uint32_t state) {
+    __asm__ volatile ("msr primask, %0" :: "r"(state) : "memory");
+}
+
+/**
+ * @brief True in an exception handler (IPSR holds the vector number)
+ */
+static inline bool hal_in_isr(void) {
+    uint32_t ipsr;
+    __asm__ volatile ("mrs %0, ipsr" : "=r"(ipsr));
+    return ipsr != 0;
+}
+
+/**
+ * @brief Memory barriers
+ *
+ * Single core, but the bus matrix and DMA masters can still observe
+ * stores out of order, so these are the real instructions.
+ */
+static inline void hal_memory_barrier(void) {
+    __asm__ volatile ("dmb" ::: "memory");
+}
+
+static inline void hal_dmb(void) {
+    __asm__ volatile ("dmb" ::: "memory");
+}
+
+static inline void hal_dsb(void) {
+    __asm__ volatile ("dsb" ::: "memory");
+}
+
+static inline void hal_isb(void) {
+    __asm__ volatile ("isb" ::: "memory");
+}
+
+/**
+ * @brief Enter idle/low-power mode
+ *
+ * WFI wakes on any pending interrupt even with PRIMASK set, so the
+ * scheduler's "unlock, idle, lock" loop cannot miss a wakeup.
+ */
+static inline void hal_idle(void) {
+    __asm__ volatile ("dsb\n\t"
+                      "wfi" ::: "memory");
+}
+
+/**
+ * @brief Get CPU frequency
+ */
+static inline uint32_t hal_cpu_freq_hz(void) {
+    return HAL_CPU_FREQ_HZ;
+}
+
+/**
+ * @brief Cycle counter (DWT CYCCNT, enabled by hal_init())
+ */
+#define HAL_CYCLES_HZ HAL_CPU_FREQ_HZ
+
+static inline uint32_t hal_cycles(void) {
+    return HAL_DWT_CYCCNT;
+}
+
+/* Single core */
+static inline uint8_t hal_cpu_id(void) {
+    return 0;
+}
+
+static inline void hal_ipi_send(uint8_t core) {
+    (void)core;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * ATOMIC OPERATIONS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/*
+ * Exclusive-monitor loops: load-exclusive, compute, store-exclusive,
+ * retry if anything (an interrupt, another master) touched the monitor
+ * in between.  Interrupts stay enabled throughout; the exception entry
+ * clears the monitor, so an ISR's update is never lost.  All of them
+ * are full barriers, like the seq_cst builtins they stand in for.
+ */
+#define HAL_ARMV7M_EXCL(bits, sfx)                                           \
+    static inline uint##bits##_t hal_armv7m_ldrex_u##bits(                   \
+        volatile uint##bits##_t *p) {                                        \
+        uint32_t v;                                                          \
+        __asm__ volatile ("ldrex" sfx " %0, %1" : "=r"(v) : "Q"(*p));        \
+        return (uint##bits##_t)v;                                            \
+    }                                                                        \
+    static inline uint32_t hal_armv7m_strex_u##bits(                         \
+        volatile uint##bits##_t *p, uint##bits##_t v) {                      \
+        uint32_t fail;                                                       \
+        __asm__ volatile ("strex" sfx " %0, %2, %1"                          \
+                          : "=&r"(fail), "=Q"(*p) : "r"((uint32_t)v));       \
+        return fail;                                                         \
+    }
+
+HAL_ARMV7M_EXCL(8, "b")
+HAL_ARMV7M_EXCL(16, "h")
+HAL_ARMV7M_EXCL(32, "")
+
+#undef HAL_ARMV7M_EXCL
+
+static inline void hal_armv7m_clrex(void) {
+    __asm__ volatile ("clrex" ::: "memory");
+}
+
+#define HAL_ARMV7M_XCHG(bits)                                                \
+    static inline uint##bits##_t hal_atomic_exchange_u##bits(                \
+        volatile uint##bits##_t *ptr, uint##bits##_t val) {                  \
+        uint##bits##_t old;                                                  \
+        hal_dmb();                                                           \
+        do {                                                                 \
+            old = hal_armv7m_ldrex_u##bits(ptr);                             \
+        } while (hal_armv7m_strex_u##bits(ptr, val));                        \
+        hal_dmb();                                                           \
+        return old;                                                          \
+    }                                                                        \
+    static inline bool hal_atomic_compare_exchange_u##bits(                  \
+        volatile uint##bits##_t *ptr, uint##bits##_t *expected,              \
+        uint##bits##_t val) {                                                \
+        uint##bits##_t cur;                                                  \
+        hal_dmb();                                                           \
+        do {                                                                 \
+            cur = hal_armv7m_ldrex_u##bits(ptr);                             \
+            if (cur != *expected) {                                          \
+                hal_armv7m_clrex();                                          \
+                *expected = cur;                                             \
+                return false;                                                \
+            }                                                                \
+        } while (hal_armv7m_strex_u##bits(ptr, val));                        \
+        hal_dmb();                                                           \
+        return true;                                                         \
+    }
+
+HAL_ARMV7M_XCHG(8)
+HAL_ARMV7M_XCHG(16)
+HAL_ARMV7M_XCHG(32)
+
+#undef HAL_ARMV7M_XCHG
+
+/**
+ * @brief Atomic test-and-set (8-bit)
+ */
+static inline uint8_t hal_atomic_test_and_set_u8(volatile uint8_t *ptr) {
+    return hal_atomic_exchange_u8(ptr, 1);
+}
+
+/**
+ * @brief Atomic fetch-and-{add,sub,or,and} (8/16/32-bit)
+ */
+#define HAL_ARMV7M_FETCH_OP(name, op, bits)                                  \
+    static inline uint##bits##_t hal_atomic_fetch_##name##_u##bits(          \
+        volatile uint##bits##_t *ptr, uint##bits##_t val) {                  \
+        uint##bits##_t old;                                                  \
+        hal_dmb();                                                           \
+        do {                                                                 \
+            old = hal_armv7m_ldrex_u##bits(ptr);                             \
+        } while (hal_armv7m_strex_u##bits(ptr,                               \
+                                          (uint##bits##_t)(old op val)));    \
+        hal_dmb();                                                           \
+        return old;                                                          \
+    }
+#define HAL_ARMV7M_FETCH_OPS(name, op) \
+    HAL_ARMV7M_FETCH_OP(name, op, 8)   \
+    HAL_ARMV7M_FETCH_OP(name, op, 16)  \
+    HAL_ARMV7M_FETCH_OP(name, op, 32)
+
+HAL_ARMV7M_FETCH_OPS(add, +)
+HAL_ARMV7M_FETCH_OPS(sub, -)
+HAL_ARMV7M_FETCH_OPS(or, |)
+HAL_ARMV7M_FETCH_OPS(and, &)
+
+#undef HAL_ARMV7M_FETCH_OPS
+#undef HAL_ARMV7M_FETCH_OP
+
+/*═══════════════════════════════════════════════════════════════════
+ * EEPROM (none on Cortex-M; flash emulation belongs to the board)
+ *═══════════════════════════════════════════════════════════════════*/
+
+static inline bool hal_eeprom_available(void) { return false; }
+static inline uint16_t hal_eeprom_size(void) { return 0; }
+static inline uint8_t hal_eeprom_read_byte(uint16_t addr) { (void)addr; return 0xFF; }
+static inline void hal_eeprom_write_byte(uint16_t addr, uint8_t val) { (void)addr; (void)val; }
+
+static inline void hal_eeprom_read_block(void *dest, uint16_t addr, size_t len) {
+    (void)addr;
+    memset(dest, 0xFF, len);
+}
+
+static inline void hal_eeprom_update_block(uint16_t addr, const void *src, size_t len) {
+    (void)addr; (void)src; (void)len;
+}
+
+typedef void (*hal_eeprom_done_t)(void *arg);
+
+static inline bool hal_eeprom_write_async(uint16_t addr, const void *src, size_t len,
+                                          hal_eeprom_done_t done, void *arg) {
+    (void)addr; (void)src; (void)len; (void)done; (void)arg;
+    return false;
+}
+
+static inline bool hal_eeprom_busy(void) { return false; }
+static inline void hal_eeprom_flush(void) {}
+
+/*═══════════════════════════════════════════════════════════════════
+ * ARMV7-M-SPECIFIC FUNCTION PROTOTYPES
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Context switching - implemented in hal_armv7m.c (PendSV_Handler) */
+void hal_context_init(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size);
+void hal_context_switch(hal_context_t *from, hal_context_t *to);
+
+/*
+ * The PendSV path is already as light as a voluntary switch gets
+ * (hardware stacks the caller-saved half), so the cooperative entry
+ * points share it.
+ */
+static inline void hal_context_init_coop(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size) {
+    hal_context_init(ctx, entry, stack, stack_size);
+}
+
+static inline void hal_context_switch_coop(hal_context_t *from, hal_context_t *to) {
+    hal_context_switch(from, to);
+}
+
+/* Vector table entries (the startup code's table must point at these) */
+void PendSV_Handler(void);
+void SysTick_Handler(void);
+
+/* Internal helper for ISR */
+extern void hal_timer_tick_handler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAL_ARMV7M_H */
@@ -15,10 +15,15 @@
  * - Delay functions (microsecond/millisecond precision)
  * - Capability detection
  * - Reset reason tracking
+ * - Interrupt-driven console UART (USART0)
  */
 
+#include "avrix-config.h"          /* mm_xmem_kb for HAL_XMEM_SIZE */
 #include "arch/common/hal.h"
 #include "arch/avr8/include/hal_avr8.h"
+#include "arch/avr8/include/hal_avr8_ctx.h"
+#include "drivers/tty/tty.h"
+#include "kernel/sync/nk_trace.h"
 
 #include <string.h>
 
@@ -27,15 +32,22 @@
  *═══════════════════════════════════════════════════════════════════*/
 
 static volatile uint32_t hal_tick_count = 0;
+static volatile uint8_t  hal_oneshot_armed = 0;
+static volatile uint8_t  hal_oneshot_fired = 0;
+#if HAL_CYCLES_TIMER
+static volatile uint16_t hal_cycles_hi = 0;   /* Timer1 overflows */
+#endif
 static hal_reset_reason_t hal_last_reset_reason = HAL_RESET_UNKNOWN;
 
 /*═══════════════════════════════════════════════════════════════════
  * SYSTEM INITIALIZATION
  *═══════════════════════════════════════════════════════════════════*/
 
+static hal_reset_reason_t read_reset_flags(void);
+
 void hal_init(void) {
     /* Detect reset reason before MCUSR is cleared */
-    hal_last_reset_reason = hal_reset_reason();
+    hal_last_reset_reason = read_reset_flags();
 
     /* Clear reset flags (required for watchdog handling) */
 #if defined(MCUSR)
@@ -44,8 +56,11 @@ void hal_init(void) {
     MCUCSR = 0;
 #endif
 
-    /* Disable watchdog timer (in case it was enabled) */
-#if defined(WDTCSR)
+    /* Disable watchdog timer (in case it was enabled); after a watchdog
+     * reset it is still running and needs the timed WDCE sequence */
+#if defined(__AVR__)
+    wdt_disable();
+#elif defined(WDTCSR)
     WDTCSR = 0;
 #elif defined(WDTCR)
     WDTCR = 0;
@@ -54,6 +69,15 @@ void hal_init(void) {
     /* Initialize tick counter */
     hal_tick_count = 0;
 
+#if defined(__AVR__) && HAL_CYCLES_TIMER
+    /* Timer1: normal mode, /1, overflow extends it to 32 bits */
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);
+    TCNT1 = 0;
+    TIFR1 = _BV(TOV1);
+    TIMSK1 |= _BV(TOIE1);
+#endif
+
     /* Additional platform-specific init can be added here */
 }
 
@@ -71,7 +95,15 @@ void hal_reset(void) {
 #endif
 }
 
+/* Reset cause by hal_init(), which clears the flags */
 hal_reset_reason_t hal_reset_reason(void) {
+    if (hal_last_reset_reason != HAL_RESET_UNKNOWN) {
+        return hal_last_reset_reason;
+    }
+    return read_reset_flags();
+}
+
+static hal_reset_reason_t read_reset_flags(void) {
 #if defined(MCUSR)
     uint8_t mcusr = MCUSR;
 #elif defined(MCUCSR)
@@ -112,6 +144,48 @@ const char *hal_cpu_model(void) {
     return HAL_MCU_NAME;
 }
 
+/* Crystal start-up after power-save / power-down (CKSEL/SUT fuses) */
+#ifndef HAL_AVR_WAKE_CK
+#  define HAL_AVR_WAKE_CK 16384UL
+#endif
+
+#define HAL_AVR_WAKE_US ((uint16_t)(HAL_AVR_WAKE_CK * 1000000UL / F_CPU))
+
+/*
+ * The tick runs from a synchronous timer, so only idle mode keeps it.
+ * Power-save and power-down wake on external, pin-change, TWI address
+ * and watchdog interrupts, plus Timer2 in power-save when it is clocked
+ * from a 32 kHz crystal.
+ */
+static const hal_sleep_info_t hal_sleep_tab[HAL_SLEEP_LEVELS] = {
+    [HAL_SLEEP_IDLE] = { 1,               0, HAL_SLEEP_F_TIMED },
+    [HAL_SLEEP_SAVE] = { HAL_AVR_WAKE_US, 0, 0 },
+    [HAL_SLEEP_DEEP] = { HAL_AVR_WAKE_US, 0, 0 },
+};
+
+const hal_sleep_info_t *hal_sleep_info(void) {
+    return hal_sleep_tab;
+}
+
+void hal_sleep(hal_sleep_t level) {
+#if defined(__AVR__)
+    /* A queued EEPROM write advances on EE_READY, which only idle keeps */
+    if (hal_eeprom_busy()) {
+        level = HAL_SLEEP_IDLE;
+    }
+    if (level == HAL_SLEEP_DEEP) {
+        set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    } else if (level == HAL_SLEEP_SAVE) {
+        set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+    } else {
+        set_sleep_mode(SLEEP_MODE_IDLE);
+    }
+    sleep_mode();
+#else
+    (void)level;
+#endif
+}
+
 /*═══════════════════════════════════════════════════════════════════
  * TIMER & TICK MANAGEMENT
  *═══════════════════════════════════════════════════════════════════*/
@@ -120,11 +194,10 @@ const char *hal_cpu_model(void) {
  * @brief System tick handler - called from ISR
  *
  * This is a weak symbol that can be overridden by the kernel scheduler.
- * Default implementation just increments tick counter.
+ * The ISR itself keeps hal_tick_count, so the default does nothing.
  */
 __attribute__((weak))
 void hal_timer_tick_handler(void) {
-    hal_tick_count++;
 }
 
 /**
@@ -132,10 +205,23 @@ void hal_timer_tick_handler(void) {
  */
 #if defined(HAL_TIMER0_COMPA_ISR)
 ISR(HAL_TIMER0_COMPA_ISR) {
+    if (hal_oneshot_armed) {
+        /* One-shot expired: stop the counter, hal_timer_resume() accounts */
+        TCCR0B = 0;
+        hal_oneshot_fired = 1;
+        return;
+    }
+    hal_tick_count++;
     hal_timer_tick_handler();
 }
 #endif
 
+#if defined(__AVR__) && HAL_CYCLES_TIMER
+ISR(TIMER1_OVF_vect) {
+    hal_cycles_hi++;
+}
+#endif
+
 void hal_timer_init(uint32_t freq_hz) {
 #if defined(__AVR__)
     /* We use Timer0 in CTC mode for system tick */
@@ -159,17 +245,86 @@ void hal_timer_init(uint32_t freq_hz) {
 #endif
 }
 
+/*
+ * Tickless idle: Timer0 is re-clocked at /1024 so one 8-bit compare
+ * spans up to 256 * 1024 / F_CPU seconds (~16 ms at 16 MHz).
+ */
+#define HAL_ONESHOT_PRESCALE 1024UL
+#define HAL_ONESHOT_HZ       (F_CPU / HAL_ONESHOT_PRESCALE)
+
+uint16_t hal_timer_oneshot(uint16_t ticks) {
+#if defined(__AVR__)
+    uint32_t counts = ((uint32_t)ticks * HAL_ONESHOT_HZ) / HAL_TIMER_HZ;
+    if (counts > 256) counts = 256;
+    if (counts == 0) counts = 1;
+
+    TCCR0B = 0;
+    TCNT0 = 0;
+    OCR0A = (uint8_t)(counts - 1);
+    TIFR0 = _BV(OCF0A);
+    hal_oneshot_fired = 0;
+    hal_oneshot_armed = 1;
+    TCCR0B = _BV(CS02) | _BV(CS00);     /* /1024 */
+
+    ticks = (uint16_t)((counts * HAL_TIMER_HZ) / HAL_ONESHOT_HZ);
+    return ticks ? ticks : 1;
+#else
+    return ticks;
+#endif
+}
+
+uint16_t hal_timer_resume(void) {
+#if defined(__AVR__)
+    TCCR0B = 0;
+    uint32_t counts = hal_oneshot_fired ? (uint32_t)OCR0A + 1 : TCNT0;
+    hal_oneshot_armed = 0;
+
+    /* Back to the periodic 1 kHz tick */
+    TCNT0 = 0;
+    OCR0A = (uint8_t)HAL_TIMER_RELOAD;
+    TIFR0 = _BV(OCF0A);
+    TCCR0B = _BV(CS01) | _BV(CS00);
+
+    return (uint16_t)((counts * HAL_TIMER_HZ) / HAL_ONESHOT_HZ);
+#else
+    return 1;
+#endif
+}
+
 uint32_t hal_timer_ticks(void) {
     uint32_t ticks;
 
-    /* Read tick counter atomically */
-    hal_irq_disable();
+    /* Read tick counter atomically; callers may already have IRQs off */
+    uint32_t s = (hal_irq_save)();
     ticks = hal_tick_count;
-    hal_irq_enable();
+    (hal_irq_restore)(s);
 
     return ticks;
 }
 
+uint32_t hal_cycles(void) {
+#if defined(__AVR__)
+    uint8_t sreg = SREG;
+    cli();
+#  if HAL_CYCLES_TIMER
+    uint16_t lo = TCNT1;
+    uint16_t hi = hal_cycles_hi;
+    /* Wrapped since cli() but the ISR has not run yet */
+    if ((TIFR1 & _BV(TOV1)) && lo < 0x8000u) hi++;
+    SREG = sreg;
+    return ((uint32_t)hi << 16) | lo;
+#  else
+    uint8_t  cnt = TCNT0;
+    uint32_t t = hal_tick_count;
+    if ((TIFR0 & _BV(OCF0A)) && cnt < HAL_TIMER_RELOAD / 2) t++;
+    SREG = sreg;
+    return t * (F_CPU / HAL_TIMER_HZ) + (uint32_t)cnt * HAL_TIMER_PRESCALE;
+#  endif
+#else
+    return hal_tick_count * (F_CPU / 1000UL);
+#endif
+}
+
 void hal_timer_delay_us(uint32_t us) {
 #if defined(__AVR__)
     /* Busy-wait delay using cycle counting */
@@ -201,6 +356,34 @@ void hal_timer_delay_ms(uint32_t ms) {
  * CONTEXT MANAGEMENT
  *═══════════════════════════════════════════════════════════════════*/
 
+/*
+ * Lay out a task's first frame below @p top and return its saved SP.
+ * The entry address goes where `ret` pops it (high byte nearest SP).
+ * With HAL_AVR_CTX_FRESH that is all: the tag tells the switch to
+ * return into it directly.  Otherwise SREG (I set) and @p regs zeroed
+ * registers follow, as a suspended task would have left them.
+ */
+static uint16_t ctx_frame(void (*entry)(void), uint8_t *top, uint8_t regs) {
+    uint8_t *sp = top;
+    uint16_t pc = (uint16_t)entry;
+
+    *--sp = (uint8_t)pc;                    /* PCL */
+    *--sp = (uint8_t)(pc >> 8);             /* PCH */
+#if HAL_AVR_PC_BYTES == 3
+    *--sp = 0;                              /* EIND: entries sit below 128 KB */
+#endif
+#if HAL_AVR_CTX_FRESH
+    (void)regs;
+    return (uint16_t)((uint16_t)(sp - 1) | HAL_AVR_CTX_FRESH);
+#else
+    *--sp = 0x80;                           /* SREG: I=1 */
+    sp -= regs;
+    memset(sp, 0, regs);
+    /* SP points at the next free byte (AVR push is post-decrement) */
+    return (uint16_t)(sp - 1);
+#endif
+}
+
 /**
  * @brief Initialize a new task context
  *
@@ -209,34 +392,35 @@ void hal_timer_delay_ms(uint32_t ms) {
  *
  * AVR stack frame (grows downward):
  *   [stack_base + stack_size]  <- SP starts here
- *   - Entry point address (PC) [2 bytes, little-endian]
+ *   - Entry point address (PC) [2-3 bytes, high byte lowest]
  *   - SREG (status register)   [1 byte, I-flag set]
- *   - 32 general registers     [32 bytes, all zero]
+ *   - r2-r31 less HAL_AVR_FIXED_REGS [HAL_AVR_FULL_REGS bytes, zero]
  *   [lower addresses]
  *
- * @note This is compatible with the existing µ-UNIX context switch code
+ * With HAL_AVR_CTX_FRESH only the PC is written (see hal_avr8_ctx.h).
  */
 void hal_context_init(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size) {
     if (!ctx || !entry || !stack || stack_size < 64) {
         return;  /* Invalid parameters */
     }
+    ctx->sp = ctx_frame(entry, (uint8_t *)stack + stack_size, HAL_AVR_FULL_REGS);
+}
 
-    /* Start at top of stack (AVR stack grows downward) */
-    uint8_t *sp = (uint8_t *)stack + stack_size;
-
-    /* Push entry point address (16-bit, little-endian) */
-    *--sp = (uint16_t)entry & 0xFF;         /* PCL */
-    *--sp = ((uint16_t)entry >> 8) & 0xFF;  /* PCH */
-
-    /* Push SREG with interrupts enabled (I-flag = bit 7) */
-    *--sp = 0x80;  /* SREG: I=1, all other flags cleared */
-
-    /* Push 32 general-purpose registers (r0-r31), all zero */
-    memset(sp - 32, 0, 32);
-    sp -= 32;
-
-    /* Save stack pointer to context */
-    ctx->sp = (uint16_t)sp;
+/**
+ * @brief Initialize a context for hal_context_switch_coop()
+ *
+ * AVR stack frame (grows downward):
+ *   [stack_base + stack_size]  <- SP starts here
+ *   - Entry point address (PC) [2-3 bytes, high byte lowest]
+ *   - SREG (status register)   [1 byte, I-flag set]
+ *   - r2-r17, r28-r29 less HAL_AVR_FIXED_REGS [HAL_AVR_COOP_REGS bytes, zero]
+ *   [lower addresses]
+ */
+void hal_context_init_coop(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size) {
+    if (!ctx || !entry || !stack || stack_size < 32) {
+        return;  /* Invalid parameters */
+    }
+    ctx->sp = ctx_frame(entry, (uint8_t *)stack + stack_size, HAL_AVR_COOP_REGS);
 }
 
 /**
@@ -272,6 +456,122 @@ void hal_early_init(void) {
 
 #include <avr/eeprom.h>
 
+#ifndef EEMPE                 /* ATmega128 and older names */
+#  define EEMPE EEMWE
+#  define EEPE  EEWE
+#endif
+
+/*
+ * Asynchronous write queue, drained by EE_READY_vect.  The interrupt
+ * is level-triggered: it fires whenever EERIE is set and no write is in
+ * progress, so each invocation programs the next byte that differs and
+ * returns, and the hardware calls it again ~3.4 ms later.  Synchronous
+ * accessors mask it (ee_pause) because they drive EEAR/EECR themselves.
+ */
+#ifndef HAL_EEPROM_QUEUE
+#  define HAL_EEPROM_QUEUE 4
+#endif
+_Static_assert((HAL_EEPROM_QUEUE & (HAL_EEPROM_QUEUE - 1)) == 0 &&
+               HAL_EEPROM_QUEUE <= 128, "EEPROM queue must be a power of two");
+
+typedef struct {
+    uint16_t          addr;
+    const uint8_t    *src;
+    uint16_t          len;
+    hal_eeprom_done_t done;
+    void             *arg;
+} ee_req_t;
+
+static ee_req_t ee_q[HAL_EEPROM_QUEUE];
+static volatile uint8_t ee_head, ee_tail;   /* free-running */
+static volatile uint8_t ee_paused;
+
+#define EE_MASK (HAL_EEPROM_QUEUE - 1u)
+
+/* Stop the queue so the caller may use the EEPROM registers. */
+static void ee_pause(void) {
+    uint32_t s = hal_irq_save();
+    ee_paused++;
+    EECR &= (uint8_t)~_BV(EERIE);
+    hal_irq_restore(s);
+}
+
+static void ee_resume(void) {
+    uint32_t s = hal_irq_save();
+    if (--ee_paused == 0 && ee_head != ee_tail) {
+        EECR |= _BV(EERIE);
+    }
+    hal_irq_restore(s);
+}
+
+ISR(EE_READY_vect) {
+    while (ee_tail != ee_head) {
+        ee_req_t *r = &ee_q[ee_tail & EE_MASK];
+        while (r->len) {
+            uint16_t a = r->addr++;
+            uint8_t v = *r->src++;
+            r->len--;
+            EEAR = a;
+            EECR |= _BV(EERE);
+            if (EEDR != v) {
+                EEDR = v;
+                EECR |= _BV(EEMPE);
+                EECR |= _BV(EEPE);
+                return;             /* back when this byte is done */
+            }
+        }
+        hal_eeprom_done_t done = r->done;
+        void *arg = r->arg;
+        ee_tail++;
+        if (done) {
+            done(arg);
+        }
+    }
+    EECR &= (uint8_t)~_BV(EERIE);
+}
+
+bool hal_eeprom_write_async(uint16_t addr, const void *src, size_t len,
+                            hal_eeprom_done_t done, void *arg) {
+    if (addr >= HAL_EEPROM_SIZE) {
+        len = 0;
+    } else if (addr + len > HAL_EEPROM_SIZE) {
+        len = HAL_EEPROM_SIZE - addr;
+    }
+
+    uint32_t s = hal_irq_save();
+    if ((uint8_t)(ee_head - ee_tail) == HAL_EEPROM_QUEUE) {
+        hal_irq_restore(s);
+        return false;
+    }
+    ee_q[ee_head & EE_MASK] = (ee_req_t){ addr, (const uint8_t *)src,
+                                          (uint16_t)len, done, arg };
+    ee_head++;
+    if (!ee_paused) {
+        EECR |= _BV(EERIE);         /* fires at once if the EEPROM is idle */
+    }
+    hal_irq_restore(s);
+    return true;
+}
+
+bool hal_eeprom_busy(void) {
+    return ee_head != ee_tail;
+}
+
+__attribute__((weak))
+void hal_eeprom_wait_hook(void) {
+    hal_idle();
+}
+
+void hal_eeprom_flush(void) {
+    while (hal_eeprom_busy()) {
+        hal_eeprom_wait_hook();
+    }
+}
+
+/* Synchronous access: reads just pause the queue, writes drain it first */
+#define EE_READ(stmt)  do { ee_pause(); stmt; ee_resume(); } while (0)
+#define EE_WRITE(stmt) do { hal_eeprom_flush(); EE_READ(stmt); } while (0)
+
 /**
  * @brief Check if EEPROM is available
  *
@@ -297,7 +597,9 @@ uint8_t hal_eeprom_read_byte(uint16_t addr) {
     if (addr >= HAL_EEPROM_SIZE) {
         return 0xFF;  /* Out of bounds */
     }
-    return eeprom_read_byte((const uint8_t *)(uintptr_t)addr);
+    uint8_t v;
+    EE_READ(v = eeprom_read_byte((const uint8_t *)(uintptr_t)addr));
+    return v;
 }
 
 /**
@@ -307,7 +609,9 @@ uint16_t hal_eeprom_read_word(uint16_t addr) {
     if (addr + 1 >= HAL_EEPROM_SIZE) {
         return 0xFFFF;
     }
-    return eeprom_read_word((const uint16_t *)(uintptr_t)addr);
+    uint16_t v;
+    EE_READ(v = eeprom_read_word((const uint16_t *)(uintptr_t)addr));
+    return v;
 }
 
 /**
@@ -317,7 +621,9 @@ uint32_t hal_eeprom_read_dword(uint16_t addr) {
     if (addr + 3 >= HAL_EEPROM_SIZE) {
         return 0xFFFFFFFF;
     }
-    return eeprom_read_dword((const uint32_t *)(uintptr_t)addr);
+    uint32_t v;
+    EE_READ(v = eeprom_read_dword((const uint32_t *)(uintptr_t)addr));
+    return v;
 }
 
 /**
@@ -327,7 +633,7 @@ void hal_eeprom_read_block(void *dest, uint16_t addr, size_t len) {
     if (addr + len > HAL_EEPROM_SIZE) {
         len = HAL_EEPROM_SIZE - addr;  /* Truncate to bounds */
     }
-    eeprom_read_block(dest, (const void *)(uintptr_t)addr, len);
+    EE_READ(eeprom_read_block(dest, (const void *)(uintptr_t)addr, len));
 }
 
 /**
@@ -335,7 +641,7 @@ void hal_eeprom_read_block(void *dest, uint16_t addr, size_t len) {
  */
 void hal_eeprom_write_byte(uint16_t addr, uint8_t val) {
     if (addr < HAL_EEPROM_SIZE) {
-        eeprom_write_byte((uint8_t *)(uintptr_t)addr, val);
+        EE_WRITE(eeprom_write_byte((uint8_t *)(uintptr_t)addr, val));
     }
 }
 
@@ -344,7 +650,7 @@ void hal_eeprom_write_byte(uint16_t addr, uint8_t val) {
  */
 void hal_eeprom_write_word(uint16_t addr, uint16_t val) {
     if (addr + 1 < HAL_EEPROM_SIZE) {
-        eeprom_write_word((uint16_t *)(uintptr_t)addr, val);
+        EE_WRITE(eeprom_write_word((uint16_t *)(uintptr_t)addr, val));
     }
 }
 
@@ -353,7 +659,7 @@ void hal_eeprom_write_word(uint16_t addr, uint16_t val) {
  */
 void hal_eeprom_write_dword(uint16_t addr, uint32_t val) {
     if (addr + 3 < HAL_EEPROM_SIZE) {
-        eeprom_write_dword((uint32_t *)(uintptr_t)addr, val);
+        EE_WRITE(eeprom_write_dword((uint32_t *)(uintptr_t)addr, val));
     }
 }
 
@@ -364,7 +670,7 @@ void hal_eeprom_write_block(uint16_t addr, const void *src, size_t len) {
     if (addr + len > HAL_EEPROM_SIZE) {
         len = HAL_EEPROM_SIZE - addr;
     }
-    eeprom_write_block(src, (void *)(uintptr_t)addr, len);
+    EE_WRITE(eeprom_write_block(src, (void *)(uintptr_t)addr, len));
 }
 
 /**
@@ -374,7 +680,7 @@ void hal_eeprom_write_block(uint16_t addr, const void *src, size_t len) {
  */
 void hal_eeprom_update_byte(uint16_t addr, uint8_t val) {
     if (addr < HAL_EEPROM_SIZE) {
-        eeprom_update_byte((uint8_t *)(uintptr_t)addr, val);
+        EE_WRITE(eeprom_update_byte((uint8_t *)(uintptr_t)addr, val));
     }
 }
 
@@ -383,7 +689,7 @@ void hal_eeprom_update_byte(uint16_t addr, uint8_t val) {
  */
 void hal_eeprom_update_word(uint16_t addr, uint16_t val) {
     if (addr + 1 < HAL_EEPROM_SIZE) {
-        eeprom_update_word((uint16_t *)(uintptr_t)addr, val);
+        EE_WRITE(eeprom_update_word((uint16_t *)(uintptr_t)addr, val));
     }
 }
 
@@ -392,7 +698,7 @@ void hal_eeprom_update_word(uint16_t addr, uint16_t val) {
  */
 void hal_eeprom_update_dword(uint16_t addr, uint32_t val) {
     if (addr + 3 < HAL_EEPROM_SIZE) {
-        eeprom_update_dword((uint32_t *)(uintptr_t)addr, val);
+        EE_WRITE(eeprom_update_dword((uint32_t *)(uintptr_t)addr, val));
     }
 }
 
@@ -403,7 +709,7 @@ void hal_eeprom_update_block(uint16_t addr, const void *src, size_t len) {
     if (addr + len > HAL_EEPROM_SIZE) {
         len = HAL_EEPROM_SIZE - addr;
     }
-    eeprom_update_block(src, (void *)(uintptr_t)addr, len);
+    EE_WRITE(eeprom_update_block(src, (void *)(uintptr_t)addr, len));
 }
 
 /**
@@ -412,11 +718,275 @@ void hal_eeprom_update_block(uint16_t addr, const void *src, size_t len) {
  * @warning This is VERY slow on AVR! ~3.4 seconds for 1KB.
  */
 void hal_eeprom_erase_all(void) {
+    hal_eeprom_flush();
+    ee_pause();
     for (uint16_t addr = 0; addr < HAL_EEPROM_SIZE; addr++) {
         eeprom_write_byte((uint8_t *)(uintptr_t)addr, 0xFF);
     }
+    ee_resume();
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * FLASH SELF-PROGRAMMING (SPM)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if HAL_HAS_FLASH_WRITE
+
+/*
+ * SPM only executes from the boot section, so the page writer goes in
+ * .bootloader; link with -Wl,--section-start=.bootloader=<boot start>
+ * and build with -DHAL_FLASH_APP_SIZE=<boot start> so the boot section
+ * itself is never rewritten.  While the RWW section is erased or
+ * written nothing in it can be read, and the vectors and the kernel
+ * live there, so interrupts stay masked for the whole page (~4 ms
+ * erase + ~4 ms write).  The temporary buffer is filled before the
+ * erase (datasheet "alternative 1"), so the caller's page is free as
+ * soon as hal_flash_write_page() returns.
+ */
+BOOTLOADER_SECTION __attribute__((noinline))
+static void flash_spm_page(uint32_t addr, const uint8_t *page) {
+    for (uint16_t i = 0; i < SPM_PAGESIZE; i += 2) {
+        boot_page_fill(addr + i, page[i] | (uint16_t)page[i + 1] << 8);
+    }
+    boot_page_erase(addr);
+    boot_spm_busy_wait();
+    boot_page_write(addr);
+    boot_spm_busy_wait();
+    boot_rww_enable();
+}
+
+uint32_t hal_flash_size(void) {
+    return HAL_FLASH_APP_SIZE;
+}
+
+bool hal_flash_write_page(uint32_t addr, const void *page) {
+    if ((addr & (SPM_PAGESIZE - 1u)) || addr >= HAL_FLASH_APP_SIZE) {
+        return false;
+    }
+    hal_eeprom_flush();                 /* SPM waits for no EEPROM write */
+    uint32_t s = hal_irq_save();
+    eeprom_busy_wait();
+    flash_spm_page(addr, page);
+    hal_irq_restore(s);
+    return true;
+}
+
+bool hal_flash_busy(void) {
+    return false;                       /* every page completes in the call */
+}
+
+void hal_flash_read(void *dst, uint32_t addr, size_t len) {
+    hal_memcpy_PF(dst, addr, len);
+}
+
+#endif /* HAL_HAS_FLASH_WRITE */
+
+/*═══════════════════════════════════════════════════════════════════
+ * EXTERNAL MEMORY BUS
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if HAL_HAS_XMEM
+
+/*
+ * One sector covering the whole range (SRL = 0) and all 16 address
+ * lines.  The bus sees every address, but the bottom RAMEND + 1 bytes
+ * are served by internal SRAM, so a 64 KB part yields 56 KB and a
+ * 32 KB part what lies between RAMEND + 1 and 0x7FFF.
+ */
+void *hal_xmem_init(size_t *len) {
+    uint32_t end = HAL_XMEM_SIZE < (uint32_t)XRAMEND + 1u
+                 ? HAL_XMEM_SIZE : (uint32_t)XRAMEND + 1u;
+
+    *len = 0;
+    if (end <= (uint32_t)RAMEND + 1u) {
+        return NULL;
+    }
+    XMCRB = 0;
+    XMCRA = (uint8_t)(_BV(SRE) | ((HAL_XMEM_WAIT & 3u) << SRW10));
+    *len = (size_t)(end - ((uint32_t)RAMEND + 1u));
+    return (void *)((uintptr_t)RAMEND + 1u);
 }
 
+#endif /* HAL_HAS_XMEM */
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONSOLE UART (USART0)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if defined(HAL_UART_RX_ISR)
+
+/*
+ * The RX ISR is the only writer of the TTY's rx_head and the UDRE ISR
+ * the only writer of tx_tail, so tasks never mask interrupts to use the
+ * rings.  UDRE is level-triggered (it fires whenever UDR0 is empty and
+ * UDRIE0 is set), hence enabled only while bytes are queued.
+ */
+static tty_t *volatile hal_uart_tty;
+
+void hal_uart_attach(struct tty_s *t, uint32_t baud) {
+    /* Double speed: 115200 baud at 16 MHz is 2.1% off instead of 3.5% */
+    uint16_t ubrr = (uint16_t)((F_CPU / 4u / baud - 1u) / 2u);
+
+    UCSR0B = 0;
+    hal_uart_tty = t;
+    UBRR0H = (uint8_t)(ubrr >> 8);
+    UBRR0L = (uint8_t)ubrr;
+    UCSR0A = _BV(U2X0);
+    UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);     /* 8N1 */
+    UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+    if (t->tx_head != t->tx_tail) {
+        hal_uart_tx_kick();
+    }
+}
+
+void hal_uart_tx_kick(void) {
+    /* UCSR0B is outside the sbi range: mask the RMW against the ISR */
+    uint32_t s = hal_irq_save();
+    UCSR0B |= _BV(UDRIE0);
+    hal_irq_restore(s);
+}
+
+ISR(HAL_UART_RX_ISR) {
+    uint8_t c = UDR0;               /* Reading clears RXC0 */
+    tty_t *t = hal_uart_tty;
+
+    nk_trace_isr_enter(NK_TRACE_IRQ_UART_RX);
+    if (t) {
+        tty_rx_isr(t, c);
+    }
+    nk_trace_isr_exit(NK_TRACE_IRQ_UART_RX);
+}
+
+ISR(HAL_UART_UDRE_ISR) {
+    tty_t *t = hal_uart_tty;
+
+    nk_trace_isr_enter(NK_TRACE_IRQ_UART_TX);
+    int c = t ? tty_tx_isr(t) : -1;
+
+    if (c < 0) {
+        UCSR0B &= (uint8_t)~_BV(UDRIE0);   /* Ring empty: until the next kick */
+    } else {
+        UDR0 = (uint8_t)c;
+    }
+    nk_trace_isr_exit(NK_TRACE_IRQ_UART_TX);
+}
+
+#endif /* HAL_UART_RX_ISR */
+
+/*═══════════════════════════════════════════════════════════════════
+ * PC SAMPLING TIMER (Timer2, debug_prof)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if HAL_HAS_PROF_TIMER
+
+/* log2 of the Timer2 prescalers, indexed by CS2x - 1 */
+static const uint8_t hal_prof_div_log2[] = {0, 3, 5, 6, 7, 8, 10};
+
+bool hal_prof_timer_start(uint16_t hz) {
+    if (hz == 0) {
+        return false;
+    }
+    for (uint8_t cs = 0; cs < sizeof hal_prof_div_log2; cs++) {
+        uint32_t top = (F_CPU >> hal_prof_div_log2[cs]) / hz;
+        if (top == 0) {
+            return false;                   /* Faster than the CPU clock */
+        }
+        if (top <= 256) {
+            uint32_t s = hal_irq_save();
+            TCCR2B = 0;
+            TCCR2A = _BV(WGM21);            /* CTC on OCR2A */
+            TCNT2 = 0;
+            OCR2A = (uint8_t)(top - 1);
+            TIFR2 = _BV(OCF2A);
+            TIMSK2 |= _BV(OCIE2A);
+            TCCR2B = (uint8_t)(cs + 1);
+            hal_irq_restore(s);
+            return true;
+        }
+    }
+    return false;
+}
+
+void hal_prof_timer_stop(void) {
+    uint32_t s = hal_irq_save();
+    TCCR2B = 0;
+    TIMSK2 &= (uint8_t)~_BV(OCIE2A);
+    hal_irq_restore(s);
+}
+
+__attribute__((weak))
+void hal_prof_sample(uint32_t pc) {
+    (void)pc;
+}
+
+/*
+ * Naked so the return address the CPU pushed sits at a known offset:
+ * save SREG and the call-clobbered registers (15 bytes, 16 with RAMPZ),
+ * read the PC from above them, turn the word address into a byte
+ * address and pass it in r22..r25.  The PC is pushed low byte first,
+ * so its high byte is nearest SP.
+ */
+#if defined(__AVR_HAVE_RAMPZ__)
+#  define HAL_PROF_PUSH_RAMPZ "in r0, __RAMPZ__\n\tpush r0\n\t"
+#  define HAL_PROF_POP_RAMPZ  "pop r0\n\tout __RAMPZ__, r0\n\t"
+#  define HAL_PROF_PC_OFF     "17"
+#else
+#  define HAL_PROF_PUSH_RAMPZ ""
+#  define HAL_PROF_POP_RAMPZ  ""
+#  define HAL_PROF_PC_OFF     "16"
+#endif
+
+#if defined(__AVR_3_BYTE_PC__)
+#  define HAL_PROF_LOAD_PC \
+    "ldd r24, Z+" HAL_PROF_PC_OFF "\n\t" \
+    "ldd r23, Z+" HAL_PROF_PC_OFF "+1\n\t" \
+    "ldd r22, Z+" HAL_PROF_PC_OFF "+2\n\t"
+#else
+#  define HAL_PROF_LOAD_PC \
+    "ldd r23, Z+" HAL_PROF_PC_OFF "\n\t" \
+    "ldd r22, Z+" HAL_PROF_PC_OFF "+1\n\t" \
+    "clr r24\n\t"
+#endif
+
+#if defined(__AVR_HAVE_JMP_CALL__)
+#  define HAL_PROF_CALL "call hal_prof_sample\n\t"
+#else
+#  define HAL_PROF_CALL "rcall hal_prof_sample\n\t"
+#endif
+
+ISR(TIMER2_COMPA_vect, ISR_NAKED) {
+    __asm__ __volatile__(
+        "push r1\n\t"
+        "push r0\n\t"
+        "in r0, __SREG__\n\t"
+        "push r0\n\t"
+        "clr r1\n\t"
+        HAL_PROF_PUSH_RAMPZ
+        "push r18\n\t" "push r19\n\t" "push r20\n\t" "push r21\n\t"
+        "push r22\n\t" "push r23\n\t" "push r24\n\t" "push r25\n\t"
+        "push r26\n\t" "push r27\n\t" "push r30\n\t" "push r31\n\t"
+        "in r30, __SP_L__\n\t"
+        "in r31, __SP_H__\n\t"
+        HAL_PROF_LOAD_PC
+        "clr r25\n\t"
+        "lsl r22\n\t"
+        "rol r23\n\t"
+        "rol r24\n\t"
+        HAL_PROF_CALL
+        "pop r31\n\t" "pop r30\n\t" "pop r27\n\t" "pop r26\n\t"
+        "pop r25\n\t" "pop r24\n\t" "pop r23\n\t" "pop r22\n\t"
+        "pop r21\n\t" "pop r20\n\t" "pop r19\n\t" "pop r18\n\t"
+        HAL_PROF_POP_RAMPZ
+        "pop r0\n\t"
+        "out __SREG__, r0\n\t"
+        "pop r0\n\t"
+        "pop r1\n\t"
+        "reti\n\t"
+    );
+}
+
+#endif /* HAL_HAS_PROF_TIMER */
+
 /*═══════════════════════════════════════════════════════════════════
  * END OF FILE
  *═══════════════════════════════════════════════════════════════════*/
@@ -27,6 +27,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
 
 /* AVR-specific headers */
 #if defined(__AVR__)
@@ -67,7 +68,8 @@ extern "C" {
  * AVR8 context switch requires saving/restoring:
  * - Stack pointer (SPH:SPL) - 16 bits
  * - SREG (status register)
- * - 32 general-purpose registers (r0-r31)
+ * - r2-r31, or r2-r17/r28-r29 for the coop path, less any -ffixed-rN
+ *   kernel registers (hal_avr8_ctx.h)
  *
  * For space efficiency, we only store the stack pointer here.
  * Registers are saved/restored on the stack by the context switch routine.
@@ -181,6 +183,20 @@ _Static_assert(sizeof(hal_context_t) == 2, "AVR8 context must be 2 bytes");
    _Static_assert(HAL_TIMER_RELOAD <= 255, "Timer0 reload exceeds 8-bit range");
 #endif
 
+/**
+ * @brief Cycle counter source for hal_cycles()
+ *
+ * 1: Timer1 free-running at /1, extended to 32 bits by its overflow
+ *    ISR (one interrupt per 65536 cycles, ~4 ms at 16 MHz).
+ * 0: derived from the Timer0 tick; HAL_TIMER_PRESCALE-cycle resolution,
+ *    leaves Timer1 to the application.
+ */
+#ifndef HAL_CYCLES_TIMER
+#  define HAL_CYCLES_TIMER 1
+#endif
+
+#define HAL_CYCLES_HZ F_CPU
+
 /*═══════════════════════════════════════════════════════════════════
  * INTERRUPT VECTOR TABLE
  *═══════════════════════════════════════════════════════════════════*/
@@ -194,6 +210,54 @@ _Static_assert(sizeof(hal_context_t) == 2, "AVR8 context must be 2 bytes");
 #  warning "Unknown Timer0 compare A vector"
 #endif
 
+/* USART0 (ATmega328P: USART_*, ATmega644/1284/2560: USART0_*) */
+#if defined(USART0_RX_vect)
+#  define HAL_UART_RX_ISR   USART0_RX_vect
+#  define HAL_UART_UDRE_ISR USART0_UDRE_vect
+#elif defined(USART_RX_vect)
+#  define HAL_UART_RX_ISR   USART_RX_vect
+#  define HAL_UART_UDRE_ISR USART_UDRE_vect
+#endif
+
+/* Timer2 compare A: the PC-sampling profiler (debug_prof), else unused */
+#if defined(__AVR__) && defined(TIMER2_COMPA_vect)
+#  define HAL_HAS_PROF_TIMER 1
+#else
+#  define HAL_HAS_PROF_TIMER 0
+#endif
+
+/* SPM self-programming from the boot section (hal.h section 18) */
+#if defined(__AVR__) && defined(SPM_PAGESIZE)
+#  define HAL_HAS_FLASH_WRITE 1
+#  define HAL_FLASH_ASYNC     0
+#  define HAL_FLASH_PAGE_SIZE SPM_PAGESIZE
+/* Start of the boot section (fuse BOOTSZ): pages from here on are refused */
+#  ifndef HAL_FLASH_APP_SIZE
+#    define HAL_FLASH_APP_SIZE ((uint32_t)FLASHEND + 1u)
+#  endif
+#else
+#  define HAL_HAS_FLASH_WRITE 0
+#endif
+
+/* External SRAM interface, ATmega640/1280/1281/2560/2561 (hal.h section 19) */
+#if defined(__AVR__) && defined(XMCRA)
+#  define HAL_HAS_XMEM 1
+/* Bytes of SRAM on the bus (follows mm_xmem_kb; 0 = none fitted) */
+#  ifndef HAL_XMEM_SIZE
+#    if defined(CONFIG_MM_XMEM_KB)
+#      define HAL_XMEM_SIZE ((uint32_t)CONFIG_MM_XMEM_KB * 1024u)
+#    else
+#      define HAL_XMEM_SIZE 0u
+#    endif
+#  endif
+/* Wait states for the whole range (SRW11:SRW10, 0-3) */
+#  ifndef HAL_XMEM_WAIT
+#    define HAL_XMEM_WAIT 1
+#  endif
+#else
+#  define HAL_HAS_XMEM 0
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * INLINE HAL FUNCTIONS (PERFORMANCE-CRITICAL)
  *═══════════════════════════════════════════════════════════════════*/
@@ -437,6 +501,118 @@ static inline bool hal_atomic_compare_exchange_u32(volatile uint32_t *ptr,
 #endif
 }
 
+/**
+ * @brief Atomic fetch-and-{add,sub,or,and} (8/16/32-bit)
+ *
+ * AVR has no read-modify-write on SRAM, so each one is a load, the
+ * operation and a store with interrupts masked: cli plus a SREG
+ * restore, 3-9 cycles of IRQ latency depending on width.  Cheaper
+ * than a compare-exchange loop, which masks interrupts on every try.
+ */
+#if defined(__AVR__)
+#define HAL_AVR_FETCH_OP(name, op, bits)                                     \
+    static inline uint##bits##_t hal_atomic_fetch_##name##_u##bits(          \
+        volatile uint##bits##_t *ptr, uint##bits##_t val) {                  \
+        uint8_t sreg = SREG;                                                 \
+        cli();                                                               \
+        uint##bits##_t old = *ptr;                                           \
+        *ptr = (uint##bits##_t)(old op val);                                 \
+        SREG = sreg;                                                         \
+        return old;                                                          \
+    }
+#else
+#define HAL_AVR_FETCH_OP(name, op, bits)                                     \
+    static inline uint##bits##_t hal_atomic_fetch_##name##_u##bits(          \
+        volatile uint##bits##_t *ptr, uint##bits##_t val) {                  \
+        return __atomic_fetch_##name(ptr, val, __ATOMIC_SEQ_CST);            \
+    }
+#endif
+#define HAL_AVR_FETCH_OPS(name, op) \
+    HAL_AVR_FETCH_OP(name, op, 8)   \
+    HAL_AVR_FETCH_OP(name, op, 16)  \
+    HAL_AVR_FETCH_OP(name, op, 32)
+
+HAL_AVR_FETCH_OPS(add, +)
+HAL_AVR_FETCH_OPS(sub, -)
+HAL_AVR_FETCH_OPS(or, |)
+HAL_AVR_FETCH_OPS(and, &)
+
+#undef HAL_AVR_FETCH_OPS
+#undef HAL_AVR_FETCH_OP
+
+/*═══════════════════════════════════════════════════════════════════
+ * BLOCK COPY & FILL
+ *═══════════════════════════════════════════════════════════════════*/
+
+/*
+ * hal_memcpy_fast() / hal_memset_fast() for SRAM: four ld/st (or st)
+ * with post-increment per pass and one sbiw loop test per four bytes,
+ * ~5 cycles/byte copying against ~7 for avr-libc's byte loop.  n is at
+ * most the size of SRAM, so the pass count fits sbiw's 16-bit pair.
+ */
+#define HAL_HAS_FAST_COPY   1
+
+#if defined(__AVR__)
+static inline void hal_memcpy_fast(void *dst, const void *src, size_t n) {
+    uint16_t quads = (uint16_t)(n >> 2);
+    uint8_t rest = (uint8_t)(n & 3u), t;
+
+    __asm__ volatile(
+        "sbiw %[q], 0"      "\n\t"
+        "breq 2f"           "\n"
+        "1: ld %[t], Z+"    "\n\t"
+        "st X+, %[t]"       "\n\t"
+        "ld %[t], Z+"       "\n\t"
+        "st X+, %[t]"       "\n\t"
+        "ld %[t], Z+"       "\n\t"
+        "st X+, %[t]"       "\n\t"
+        "ld %[t], Z+"       "\n\t"
+        "st X+, %[t]"       "\n\t"
+        "sbiw %[q], 1"      "\n\t"
+        "brne 1b"           "\n"
+        "2: subi %[r], 1"   "\n\t"
+        "brcs 3f"           "\n\t"
+        "ld %[t], Z+"       "\n\t"
+        "st X+, %[t]"       "\n\t"
+        "rjmp 2b"           "\n"
+        "3:"
+        : "+x" (dst), "+z" (src), [q] "+w" (quads), [r] "+d" (rest), [t] "=&r" (t)
+        :
+        : "memory");
+}
+
+static inline void hal_memset_fast(void *dst, uint8_t c, size_t n) {
+    uint16_t quads = (uint16_t)(n >> 2);
+    uint8_t rest = (uint8_t)(n & 3u);
+
+    __asm__ volatile(
+        "sbiw %[q], 0"      "\n\t"
+        "breq 2f"           "\n"
+        "1: st X+, %[c]"    "\n\t"
+        "st X+, %[c]"       "\n\t"
+        "st X+, %[c]"       "\n\t"
+        "st X+, %[c]"       "\n\t"
+        "sbiw %[q], 1"      "\n\t"
+        "brne 1b"           "\n"
+        "2: subi %[r], 1"   "\n\t"
+        "brcs 3f"           "\n\t"
+        "st X+, %[c]"       "\n\t"
+        "rjmp 2b"           "\n"
+        "3:"
+        : "+x" (dst), [q] "+w" (quads), [r] "+d" (rest)
+        : [c] "r" (c)
+        : "memory");
+}
+#else
+static inline void hal_memcpy_fast(void *dst, const void *src, size_t n) {
+    memcpy(dst, src, n);
+}
+
+static inline void hal_memset_fast(void *dst, uint8_t c, size_t n) {
+    memset(dst, c, n);
+}
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * AVR8-SPECIFIC FUNCTION PROTOTYPES
  *═══════════════════════════════════════════════════════════════════*/
@@ -451,6 +627,10 @@ static inline bool hal_atomic_compare_exchange_u32(volatile uint32_t *ptr,
 void hal_context_init(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size);
 void hal_context_switch(hal_context_t *from, hal_context_t *to);
 
+/* Cooperative switch - call-saved registers only (hal_context_switch_coop.S) */
+void hal_context_init_coop(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size);
+void hal_context_switch_coop(hal_context_t *from, hal_context_t *to);
+
 /* Internal helper for ISR */
 extern void hal_timer_tick_handler(void);
 
@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file hal_avr8_ctx.h
+ * @brief AVR8 context frame layout, shared by hal_avr8.c and the switch .S
+ *
+ * Included from C and from the assembler.  It fixes two compile-time
+ * specialisations of hal_context_switch() / hal_context_switch_coop():
+ *
+ * - Fixed registers.  HAL_AVR_FIXED_REGS is a bit mask (bit n = rn) of
+ *   the registers the whole image is built with -ffixed-rN, for kernel
+ *   globals held in registers.  They belong to no task, so neither
+ *   switch saves them and the frames shrink by one byte each.  Set it
+ *   with the avr_fixed_regs meson option, which also adds the
+ *   -ffixed-rN flags; a plain integer, since gas reads it too.
+ *
+ * - Fast start.  A task that has never run has a frame of just its
+ *   entry address, and its saved SP is tagged with HAL_AVR_CTX_FRESH
+ *   (bit 15, never set in an SRAM address below 32 KB).  The switch
+ *   sees the tag, loads SP, enables interrupts and returns straight
+ *   into the entry: no register file to pop.  Define HAL_AVR_CTX_FRESH
+ *   0 (zero-filled frames) if task stacks can live in external RAM at
+ *   0x8000 and up.
+ */
+
+#ifndef HAL_AVR8_CTX_H
+#define HAL_AVR8_CTX_H
+
+#include "avrix-config.h"
+
+#ifndef HAL_AVR_FIXED_REGS
+#  if defined(CONFIG_HAL_AVR_FIXED_REGS)
+#    define HAL_AVR_FIXED_REGS CONFIG_HAL_AVR_FIXED_REGS
+#  else
+#    define HAL_AVR_FIXED_REGS 0
+#  endif
+#endif
+
+#ifndef HAL_AVR_CTX_FRESH
+#  if defined(RAMEND) && RAMEND < 0x8000
+#    define HAL_AVR_CTX_FRESH 0x8000
+#  else
+#    define HAL_AVR_CTX_FRESH 0
+#  endif
+#endif
+
+/* Registers each frame holds besides SREG and the return address */
+#define HAL_AVR_FULL_MASK 0xFFFFFFFCul   /* r2-r31 (r0 scratch, r1 zero) */
+#define HAL_AVR_COOP_MASK 0x3003FFFCul   /* r2-r17, r28-r29 */
+
+#ifdef __ASSEMBLER__
+
+/* push/pop rN unless the image reserves it */
+.macro CTX_PUSH n
+  .if ((HAL_AVR_FIXED_REGS >> \n) & 1) == 0
+    push r\n
+  .endif
+.endm
+
+.macro CTX_POP n
+  .if ((HAL_AVR_FIXED_REGS >> \n) & 1) == 0
+    pop r\n
+  .endif
+.endm
+
+#else
+
+#define HAL_AVR_FULL_REGS \
+    (30 - __builtin_popcountl(HAL_AVR_FULL_MASK & (unsigned long)(HAL_AVR_FIXED_REGS)))
+#define HAL_AVR_COOP_REGS \
+    (18 - __builtin_popcountl(HAL_AVR_COOP_MASK & (unsigned long)(HAL_AVR_FIXED_REGS)))
+
+#if defined(__AVR_3_BYTE_PC__)
+#  define HAL_AVR_PC_BYTES 3
+#else
+#  define HAL_AVR_PC_BYTES 2
+#endif
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* HAL_AVR8_CTX_H */
@@ -16,6 +16,10 @@
  * - Context switching (for scheduler)
  * - Memory barriers
  * - Atomic operations
+ * - Interrupt-driven console UART
+ * - DMA channels (optional)
+ * - Flash self-programming (optional)
+ * - External memory bus (optional)
  *
  * Each architecture implements this interface in arch/<arch>/hal_impl.c
  */
@@ -52,7 +56,7 @@ extern "C" {
     #elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
         #define HAL_ARCH_ARMV7M 1
         #define HAL_WORD_SIZE 32
-        #include "arch/armcm/cortex-m3/hal_armv7m.h"
+        #include "arch/armv7m/include/hal_armv7m.h"
     #else
         #error "Unsupported ARM architecture variant"
     #endif
@@ -107,8 +111,10 @@ extern "C" {
 #if defined(__AVR__)
     #include <avr/pgmspace.h>
     #define HAL_PROGMEM PROGMEM
+    #define HAL_PGM_SEPARATE 1  /* HAL_PROGMEM data needs hal_pgm_read_*() */
 #else
     #define HAL_PROGMEM  /* No separate program memory */
+    #define HAL_PGM_SEPARATE 0
 #endif
 
 /**
@@ -135,6 +141,22 @@ extern "C" {
     #define hal_pgm_read_word(addr) (*(const uint16_t *)(addr))
 #endif
 
+/**
+ * @brief Read a data pointer stored in program memory
+ *
+ * Pointer tables in flash (directory entries, name lists) must be read
+ * with this rather than hal_pgm_read_word(): pointers are 16-bit on
+ * AVR but 32/64-bit elsewhere.
+ *
+ * @param addr Address of the pointer in program memory
+ * @return Pointer value
+ */
+#if defined(__AVR__)
+    #define hal_pgm_read_ptr(addr) ((const void *)pgm_read_word(addr))
+#else
+    #define hal_pgm_read_ptr(addr) (*(const void *const *)(addr))
+#endif
+
 /**
  * @brief Read dword (32-bit) from program memory
  *
@@ -161,6 +183,44 @@ extern "C" {
     #define hal_memcpy_P(dest, src, n) memcpy(dest, src, n)
 #endif
 
+/**
+ * @brief Far program memory: flash beyond the first 64 KB
+ *
+ * AVR data pointers are 16 bits, so hal_pgm_read_*() and hal_memcpy_P()
+ * only reach the low 64 KB of flash.  On parts with ELPM (ATmega128,
+ * 1284, 2560) these take a 32-bit byte address instead, obtained at run
+ * time with hal_pgm_far(object).  Elsewhere hal_pgm_far_t is an ordinary
+ * address and the calls fall back to the near ones, so code written
+ * against them builds for every target.
+ *
+ * HAL_PROGMEM_FAR puts large constant data in .progmemx, which the
+ * avr-binutils linker script places after the code: it then no longer
+ * pushes code and near PROGMEM tables past 64 KB.
+ *
+ * Example:
+ *   static const uint8_t font[] HAL_PROGMEM_FAR = {...};
+ *   uint8_t b = hal_pgm_read_byte_far(hal_pgm_far(font) + i);
+ */
+#if defined(__AVR__) && defined(__AVR_HAVE_ELPM__)
+    #define HAL_PGM_FAR 1
+    typedef uint32_t hal_pgm_far_t;
+    #define HAL_PROGMEM_FAR               __attribute__((section(".progmemx.data")))
+    #define hal_pgm_far(obj)              pgm_get_far_address(obj)
+    #define hal_pgm_read_byte_far(addr)   pgm_read_byte_far(addr)
+    #define hal_pgm_read_word_far(addr)   pgm_read_word_far(addr)
+    #define hal_pgm_read_dword_far(addr)  pgm_read_dword_far(addr)
+    #define hal_memcpy_PF(dest, src, n)   memcpy_PF(dest, src, n)
+#else
+    #define HAL_PGM_FAR 0
+    typedef uintptr_t hal_pgm_far_t;
+    #define HAL_PROGMEM_FAR               HAL_PROGMEM
+    #define hal_pgm_far(obj)              ((hal_pgm_far_t)(uintptr_t)&(obj))
+    #define hal_pgm_read_byte_far(addr)   hal_pgm_read_byte((const void *)(uintptr_t)(addr))
+    #define hal_pgm_read_word_far(addr)   hal_pgm_read_word((const void *)(uintptr_t)(addr))
+    #define hal_pgm_read_dword_far(addr)  hal_pgm_read_dword((const void *)(uintptr_t)(addr))
+    #define hal_memcpy_PF(dest, src, n)   hal_memcpy_P(dest, (const void *)(uintptr_t)(src), n)
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * 3. COMMON TYPE DEFINITIONS
  *═══════════════════════════════════════════════════════════════════*/
@@ -224,6 +284,48 @@ void hal_reset(void) __attribute__((noreturn));
  */
 void hal_idle(void);
 
+/**
+ * @brief Sleep depth, shallowest first
+ *
+ * IDLE stops only the CPU clock; every peripheral and the tick keep
+ * running.  SAVE keeps an asynchronous timer (AVR Timer2 power-save)
+ * and DEEP keeps nothing but external / pin-change / watchdog wake-up.
+ * What each level costs and preserves on a part comes from
+ * hal_sleep_info(); the idle governor (kernel/sched/idle.h) picks one.
+ */
+typedef enum {
+    HAL_SLEEP_IDLE = 0,
+    HAL_SLEEP_SAVE = 1,
+    HAL_SLEEP_DEEP = 2,
+} hal_sleep_t;
+
+#define HAL_SLEEP_LEVELS 3
+
+#define HAL_SLEEP_F_TIMED 0x01  /**< Tick / one-shot still wakes the CPU */
+#define HAL_SLEEP_F_NONE  0x80  /**< Level not implemented on this part */
+
+/**
+ * @brief What a sleep level costs on this part
+ */
+typedef struct {
+    uint16_t exit_us;           /**< Wake-up latency (oscillator start-up) */
+    uint16_t min_ticks;         /**< Shortest idle period worth entering it */
+    uint8_t  flags;             /**< HAL_SLEEP_F_* */
+} hal_sleep_info_t;
+
+/**
+ * @brief Enter a sleep level until the next interrupt
+ *
+ * Same contract as hal_idle() (HAL_SLEEP_IDLE is hal_idle()); a level
+ * flagged HAL_SLEEP_F_NONE falls back to the next shallower one.
+ */
+void hal_sleep(hal_sleep_t level);
+
+/**
+ * @brief Per-level table, HAL_SLEEP_LEVELS entries
+ */
+const hal_sleep_info_t *hal_sleep_info(void);
+
 /**
  * @brief Get reset reason
  *
@@ -238,6 +340,30 @@ hal_reset_reason_t hal_reset_reason(void);
  */
 void hal_get_caps(hal_caps_t *caps);
 
+/**
+ * @brief Index of the executing core (0 on single-core parts)
+ *
+ * Only required from ports with hal_caps_t::num_cores > 1; the
+ * scheduler calls it only when built with kernel_smp_cores > 1.
+ */
+uint8_t hal_cpu_id(void);
+
+/**
+ * @brief Raise a reschedule inter-processor interrupt on a core
+ *
+ * The target core runs hal_ipi_handler() (defined by the scheduler)
+ * from its IPI vector.  Sending to the calling core is allowed and
+ * may be ignored.
+ *
+ * @param core Target core index
+ */
+void hal_ipi_send(uint8_t core);
+
+/**
+ * @brief Reschedule IPI entry point (provided by the scheduler)
+ */
+extern void hal_ipi_handler(void);
+
 /*═══════════════════════════════════════════════════════════════════
  * 5. INTERRUPT MANAGEMENT
  *═══════════════════════════════════════════════════════════════════*/
@@ -294,6 +420,26 @@ void hal_irq_restore(uint32_t state);
  */
 void hal_timer_init(uint32_t freq_hz);
 
+/**
+ * @brief Arm a one-shot tick for tickless idle
+ *
+ * Stops the periodic tick and programs the timer to interrupt once
+ * after roughly @p ticks tick periods.  Requests beyond the hardware
+ * range are clamped; the caller simply re-arms after waking.
+ *
+ * @param ticks Desired timeout in tick periods (>= 1)
+ * @return Number of tick periods actually programmed
+ */
+uint16_t hal_timer_oneshot(uint16_t ticks);
+
+/**
+ * @brief Leave one-shot mode and restore the periodic tick
+ *
+ * @return Whole tick periods elapsed since hal_timer_oneshot(), which
+ *         may be fewer than programmed if another interrupt woke the CPU
+ */
+uint16_t hal_timer_resume(void);
+
 /**
  * @brief Get current timer tick count
  *
@@ -301,6 +447,20 @@ void hal_timer_init(uint32_t freq_hz);
  */
 uint32_t hal_timer_ticks(void);
 
+/**
+ * @brief Free-running cycle counter for fine-grained timing
+ *
+ * Counts at HAL_CYCLES_HZ (the CPU clock on targets, 1 GHz on the host)
+ * and wraps at 32 bits, so only differences are meaningful:
+ * `hal_cycles_to_ns(hal_cycles() - t0)`.  Cheap enough to bracket a
+ * door call or a context switch; safe from ISRs and with IRQs off.
+ *
+ * - AVR8:    Timer1 at /1 with a software overflow word (HAL_CYCLES_TIMER)
+ * - ARMv7-M: DWT CYCCNT
+ * - Host:    CLOCK_MONOTONIC in nanoseconds
+ */
+uint32_t hal_cycles(void);
+
 /**
  * @brief Busy-wait delay in microseconds
  *
@@ -324,6 +484,20 @@ void hal_timer_delay_ms(uint32_t ms);
  */
 uint32_t hal_cpu_freq_hz(void);
 
+/**
+ * @brief Convert a hal_cycles() difference to nanoseconds
+ *
+ * Saturates at UINT32_MAX (~4.3 s).
+ */
+static inline uint32_t hal_cycles_to_ns(uint32_t cycles) {
+#if HAL_CYCLES_HZ % 1000000UL == 0
+    uint64_t ns = ((uint64_t)cycles * 1000u) / (HAL_CYCLES_HZ / 1000000UL);
+#else
+    uint64_t ns = ((uint64_t)cycles * 1000000000ULL) / HAL_CYCLES_HZ;
+#endif
+    return ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+}
+
 /*═══════════════════════════════════════════════════════════════════
  * 7. CONTEXT SWITCHING (for scheduler)
  *═══════════════════════════════════════════════════════════════════*/
@@ -377,6 +551,40 @@ void hal_context_init(hal_context_t *ctx, void (*entry)(void), void *stack, size
  */
 void hal_context_switch(hal_context_t *from, hal_context_t *to);
 
+/**
+ * @brief 1 if hal_context_switch() only requests the switch
+ *
+ * ARMv7-M pends PendSV, which switches once interrupts are unmasked, so
+ * the code after the call still runs in the outgoing task and an ISR
+ * never resumes the incoming task in its own frame.  Elsewhere the
+ * switch happens inside the call.
+ */
+#ifndef HAL_SWITCH_DEFERRED
+#define HAL_SWITCH_DEFERRED 0
+#endif
+
+/**
+ * @brief Initialize a context for the cooperative switch path
+ *
+ * Same contract as hal_context_init(), but lays out the smaller frame
+ * expected by hal_context_switch_coop().  The two kinds of context must
+ * not be mixed.
+ */
+void hal_context_init_coop(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size);
+
+/**
+ * @brief Voluntary (yield-only) context switch
+ *
+ * Because the switch is always entered through an ordinary function
+ * call, only the ABI's call-saved registers and the status register
+ * need preserving; the compiler already treats everything else as
+ * clobbered.  Must never be called from an ISR.
+ *
+ * @param from  Context to save current state into
+ * @param to    Context to restore and switch to
+ */
+void hal_context_switch_coop(hal_context_t *from, hal_context_t *to);
+
 /*═══════════════════════════════════════════════════════════════════
  * 8. MEMORY BARRIERS & SYNCHRONIZATION
  *═══════════════════════════════════════════════════════════════════*/
@@ -480,6 +688,75 @@ bool hal_atomic_compare_exchange_u32(volatile uint32_t *ptr, uint32_t *expected,
  */
 uint8_t hal_atomic_test_and_set_u8(volatile uint8_t *ptr);
 
+/**
+ * @brief Atomic fetch-and-add (8-bit)
+ *
+ * Atomically: old = *ptr; *ptr = old + val; return old;
+ * Use for counters, reference counts and ticket draws instead of a
+ * compare-exchange loop.  Arithmetic wraps modulo the type width.
+ *
+ * @param ptr Pointer to value
+ * @param val Amount to add
+ * @return Previous value at `ptr`
+ */
+uint8_t hal_atomic_fetch_add_u8(volatile uint8_t *ptr, uint8_t val);
+
+/** @brief Atomic fetch-and-add (16-bit) */
+uint16_t hal_atomic_fetch_add_u16(volatile uint16_t *ptr, uint16_t val);
+
+/** @brief Atomic fetch-and-add (32-bit) */
+uint32_t hal_atomic_fetch_add_u32(volatile uint32_t *ptr, uint32_t val);
+
+/**
+ * @brief Atomic fetch-and-subtract (8-bit)
+ *
+ * @param ptr Pointer to value
+ * @param val Amount to subtract
+ * @return Previous value at `ptr`
+ */
+uint8_t hal_atomic_fetch_sub_u8(volatile uint8_t *ptr, uint8_t val);
+
+/** @brief Atomic fetch-and-subtract (16-bit) */
+uint16_t hal_atomic_fetch_sub_u16(volatile uint16_t *ptr, uint16_t val);
+
+/** @brief Atomic fetch-and-subtract (32-bit) */
+uint32_t hal_atomic_fetch_sub_u32(volatile uint32_t *ptr, uint32_t val);
+
+/**
+ * @brief Atomic fetch-and-OR (8-bit)
+ *
+ * Sets the bits of `val`; the previous value tells whether any of
+ * them were already set.
+ *
+ * @param ptr Pointer to value
+ * @param val Bits to set
+ * @return Previous value at `ptr`
+ */
+uint8_t hal_atomic_fetch_or_u8(volatile uint8_t *ptr, uint8_t val);
+
+/** @brief Atomic fetch-and-OR (16-bit) */
+uint16_t hal_atomic_fetch_or_u16(volatile uint16_t *ptr, uint16_t val);
+
+/** @brief Atomic fetch-and-OR (32-bit) */
+uint32_t hal_atomic_fetch_or_u32(volatile uint32_t *ptr, uint32_t val);
+
+/**
+ * @brief Atomic fetch-and-AND (8-bit)
+ *
+ * Clears the bits not in `val`.
+ *
+ * @param ptr Pointer to value
+ * @param val Mask of bits to keep
+ * @return Previous value at `ptr`
+ */
+uint8_t hal_atomic_fetch_and_u8(volatile uint8_t *ptr, uint8_t val);
+
+/** @brief Atomic fetch-and-AND (16-bit) */
+uint16_t hal_atomic_fetch_and_u16(volatile uint16_t *ptr, uint16_t val);
+
+/** @brief Atomic fetch-and-AND (32-bit) */
+uint32_t hal_atomic_fetch_and_u32(volatile uint32_t *ptr, uint32_t val);
+
 /*═══════════════════════════════════════════════════════════════════
  * 10. PLATFORM-SPECIFIC FUNCTIONS
  *═══════════════════════════════════════════════════════════════════*/
@@ -654,19 +931,78 @@ void hal_eeprom_update_block(uint16_t addr, const void *src, size_t len);
  */
 void hal_eeprom_erase_all(void);
 
+/**
+ * @brief Completion callback for hal_eeprom_write_async()
+ *
+ * Runs in interrupt context once the last byte is programmed; keep it
+ * short (set a flag, nk_waitq_wake_one() under nk_sched_lock(), ...).
+ */
+typedef void (*hal_eeprom_done_t)(void *arg);
+
+/**
+ * @brief Queue a block write and return without waiting
+ *
+ * The bytes are programmed in the background with update semantics
+ * (unchanged bytes are skipped), one per EEPROM-ready interrupt on
+ * AVR, so other tasks run during the ~3.4 ms each byte takes.
+ * Requests complete in submission order.  The synchronous write and
+ * update functions first wait for the queue to drain, so they do not
+ * reorder with it; reads do not wait and may return the old contents
+ * of bytes still queued.
+ *
+ * @param addr Destination address in EEPROM
+ * @param src  Source buffer in RAM; must stay valid and unchanged
+ *             until @p done runs (or hal_eeprom_flush() returns)
+ * @param len  Number of bytes (clipped to the EEPROM size)
+ * @param done Called on completion, or NULL
+ * @param arg  Passed to @p done
+ * @return false if the queue is full (nothing was queued)
+ *
+ * @note Platforms without a write-complete interrupt write
+ *       synchronously and call @p done before returning.
+ */
+bool hal_eeprom_write_async(uint16_t addr, const void *src, size_t len,
+                            hal_eeprom_done_t done, void *arg);
+
+/**
+ * @brief true while queued asynchronous writes are outstanding
+ */
+bool hal_eeprom_busy(void);
+
+/**
+ * @brief Wait until every queued asynchronous write has completed
+ *
+ * Calls hal_eeprom_wait_hook() while waiting; must be called with
+ * interrupts enabled.
+ */
+void hal_eeprom_flush(void);
+
+/**
+ * @brief Called repeatedly by hal_eeprom_flush() while it waits
+ *
+ * Weak; the default idles the CPU until the next interrupt.  The
+ * scheduler overrides it to yield to other tasks.
+ */
+void hal_eeprom_wait_hook(void);
+
 /*═══════════════════════════════════════════════════════════════════
  * 12. OPTIONAL: MPU/MMU SUPPORT (high-end only)
  *═══════════════════════════════════════════════════════════════════*/
 
 #if defined(HAL_HAS_MPU) && HAL_HAS_MPU
 
+/** hal_mpu_region_t::permissions bits; 0 is no access at all */
+#define HAL_MPU_READ    0x01
+#define HAL_MPU_WRITE   0x02
+#define HAL_MPU_EXEC    0x04
+
 /**
  * @brief MPU region configuration
  */
 typedef struct {
     uint32_t base_addr;     /**< Base address (must be aligned) */
     uint32_t size;          /**< Region size in bytes */
-    uint8_t  permissions;   /**< Read/write/execute flags */
+    uint8_t  permissions;   /**< HAL_MPU_READ/WRITE/EXEC */
     bool     enable;        /**< Enable this region */
 } hal_mpu_region_t;
 
@@ -693,10 +1029,337 @@ void hal_mpu_enable(void);
  */
 void hal_mpu_disable(void);
 
+/**
+ * @brief Bytes below a stack that hal_mpu_stack_guard() makes no-access
+ *
+ * Also the alignment the guard needs: the scheduler places pooled
+ * stacks on multiples of it, each above its own unused guard block.
+ */
+#ifndef HAL_STACK_GUARD_SIZE
+#  define HAL_STACK_GUARD_SIZE 32
+#endif
+
+/**
+ * @brief Point the stack guard region at the block just below @p stack_lo
+ *
+ * The scheduler calls this for the incoming task on every switch, so a
+ * push past the bottom of the running task's stack faults on the spot
+ * instead of being found by a canary check afterwards.  @p stack_lo is
+ * aligned to HAL_STACK_GUARD_SIZE; NULL disables the guard.
+ */
+void hal_mpu_stack_guard(const void *stack_lo);
+
 #endif /* HAL_HAS_MPU */
 
+/*═══════════════════════════════════════════════════════════════════
+ * 13. CONSOLE UART (interrupt-driven TTY)
+ *═══════════════════════════════════════════════════════════════════*/
+
+struct tty_s;
+
+/**
+ * @brief Run the console UART under interrupts, feeding TTY @p t
+ *
+ * Programs the baud rate (8N1) and enables the receiver, transmitter
+ * and RX-complete interrupt.  The RX ISR stores each byte with
+ * tty_rx_isr(); the data-register-empty ISR sends with tty_tx_isr()
+ * and turns itself off when the ring runs dry.  Initialise @p t with
+ * tty_init_irq(..., hal_uart_tx_kick) first.
+ *
+ * With tty_dma on a HAL_HAS_DMA target, RX instead runs as a circular
+ * DMA into the ring with the idle-line interrupt calling
+ * tty_rx_dma_isr(), and TX as DMA bursts (see hal_uart_tx_kick()).
+ *
+ * @note On AVR this is USART0 and claims its RX and UDRE vectors
+ * @note On host: no-op (drive tty_rx_isr()/tty_tx_isr() directly)
+ */
+void hal_uart_attach(struct tty_s *t, uint32_t baud);
+
+/**
+ * @brief Enable the TX-empty interrupt (tty_kick_fn for tty_init_irq())
+ *
+ * Safe to call from any context and while TX is already running.  In
+ * DMA mode it starts a burst over tty_tx_dma_span() unless one is in
+ * flight; the burst's complete ISR retires it with tty_tx_dma_done()
+ * and chains the next span.
+ */
+void hal_uart_tx_kick(void);
+
+/*═══════════════════════════════════════════════════════════════════
+ * 14. OPTIONAL: DMA (32-bit targets)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if defined(HAL_HAS_DMA) && HAL_HAS_DMA
+
+/**
+ * @brief Transfer-complete callback; runs in the DMA ISR
+ */
+typedef void (*hal_dma_done_t)(void *arg);
+
+/**
+ * @brief Start a circular peripheral-to-memory transfer on @p ch
+ *
+ * Reads @p src (a peripheral data register) into @p buf, restarting at
+ * @p buf after @p size bytes, until hal_dma_stop().
+ *
+ * @return false if @p ch is busy or invalid
+ */
+bool hal_dma_rx_circular(uint8_t ch, const volatile void *src,
+                         uint8_t *buf, uint16_t size);
+
+/**
+ * @brief Start a one-shot memory-to-peripheral transfer on @p ch
+ *
+ * @param done Called from the DMA ISR when the last byte has gone, or NULL
+ * @return false if @p ch is busy or invalid
+ */
+bool hal_dma_tx(uint8_t ch, volatile void *dst, const void *src, uint16_t len,
+                hal_dma_done_t done, void *arg);
+
+/**
+ * @brief Bytes @p ch still has to move in the current (circular) pass
+ */
+uint16_t hal_dma_remaining(uint8_t ch);
+
+/** true while a transfer is running on @p ch. */
+bool hal_dma_busy(uint8_t ch);
+
+/**
+ * @brief Abort the transfer on @p ch
+ */
+void hal_dma_stop(uint8_t ch);
+
+/**
+ * @brief Memory-to-memory copy on a free channel, waiting for the end
+ *
+ * Backs hal_memcpy_fast() for blocks of HAL_DMA_MEMCPY_MIN bytes and up.
+ *
+ * @return false if no channel is free (the caller copies with the CPU)
+ */
+bool hal_dma_memcpy(void *dst, const void *src, size_t n);
+
+/**
+ * @brief Fill @p n bytes at @p dst with @p c by DMA, waiting for the end
+ *
+ * @return false if no channel is free
+ */
+bool hal_dma_memset(void *dst, uint8_t c, size_t n);
+
+#endif /* HAL_HAS_DMA */
+
+/*═══════════════════════════════════════════════════════════════════
+ * 15. BLOCK COPY & FILL
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief memcpy() for the kernel's block moves
+ *
+ * Door messages, stack painting, file blocks and packet buffers go
+ * through these rather than libc: AVR gets an unrolled ld/st loop
+ * (hal_avr8.h), 32-bit cores copy aligned words four at a time and,
+ * with HAL_HAS_DMA, hand blocks of HAL_DMA_MEMCPY_MIN bytes and up to
+ * hal_dma_memcpy().  The host uses libc.
+ *
+ * RAM only, buffers must not overlap.
+ */
+#if !defined(HAL_HAS_FAST_COPY) || !HAL_HAS_FAST_COPY
+
+/** Smallest block offered to DMA: below it, setup costs more than it saves */
+#ifndef HAL_DMA_MEMCPY_MIN
+#  define HAL_DMA_MEMCPY_MIN 64u
+#endif
+
+typedef uint32_t __attribute__((may_alias)) hal_word_t;
+
+static inline void hal_memcpy_fast(void *dst, const void *src, size_t n) {
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+
+#if defined(HAL_HAS_DMA) && HAL_HAS_DMA
+    if (n >= HAL_DMA_MEMCPY_MIN && hal_dma_memcpy(dst, src, n)) {
+        return;
+    }
+#endif
+    if ((((uintptr_t)d ^ (uintptr_t)s) & 3u) == 0) {
+        while (((uintptr_t)d & 3u) && n) {
+            *d++ = *s++;
+            n--;
+        }
+        hal_word_t *dw = (hal_word_t *)d;
+        const hal_word_t *sw = (const hal_word_t *)s;
+        for (; n >= 16; n -= 16, dw += 4, sw += 4) {
+            dw[0] = sw[0];
+            dw[1] = sw[1];
+            dw[2] = sw[2];
+            dw[3] = sw[3];
+        }
+        for (; n >= 4; n -= 4) {
+            *dw++ = *sw++;
+        }
+        d = (uint8_t *)dw;
+        s = (const uint8_t *)sw;
+    }
+    while (n--) {
+        *d++ = *s++;
+    }
+}
+
+/**
+ * @brief memset() for the kernel's block fills (see hal_memcpy_fast())
+ */
+static inline void hal_memset_fast(void *dst, uint8_t c, size_t n) {
+    uint8_t *d = (uint8_t *)dst;
+
+#if defined(HAL_HAS_DMA) && HAL_HAS_DMA
+    if (n >= HAL_DMA_MEMCPY_MIN && hal_dma_memset(dst, c, n)) {
+        return;
+    }
+#endif
+    while (((uintptr_t)d & 3u) && n) {
+        *d++ = c;
+        n--;
+    }
+    hal_word_t w = c * 0x01010101u, *dw = (hal_word_t *)d;
+    for (; n >= 16; n -= 16, dw += 4) {
+        dw[0] = w;
+        dw[1] = w;
+        dw[2] = w;
+        dw[3] = w;
+    }
+    for (; n >= 4; n -= 4) {
+        *dw++ = w;
+    }
+    d = (uint8_t *)dw;
+    while (n--) {
+        *d++ = c;
+    }
+}
+
+#endif /* !HAL_HAS_FAST_COPY */
+
+/*═══════════════════════════════════════════════════════════════════
+ * 16. OPTIONAL: PC SAMPLING TIMER (debug_prof)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if defined(HAL_HAS_PROF_TIMER) && HAL_HAS_PROF_TIMER
+
+/**
+ * @brief Interrupt @p hz times a second on a timer the kernel leaves
+ *        alone, passing the interrupted PC to hal_prof_sample()
+ *
+ * @return false if @p hz cannot be reached with the timer's prescalers
+ */
+bool hal_prof_timer_start(uint16_t hz);
+
+/**
+ * @brief Stop the sampling interrupt
+ */
+void hal_prof_timer_stop(void);
+
+/**
+ * @brief One sample, from the timer ISR with interrupts masked
+ *
+ * Weak no-op in the HAL; kernel/sync/nk_prof.c overrides it.
+ *
+ * @param pc Interrupted program counter as a byte address
+ */
+void hal_prof_sample(uint32_t pc);
+
+#endif /* HAL_HAS_PROF_TIMER */
+
+/*═══════════════════════════════════════════════════════════════════
+ * 17. OPTIONAL: CRC UNIT (crc_strategy=hw)
+ *═══════════════════════════════════════════════════════════════════*/
+
+/*
+ * A backend with a CRC peripheral sets HAL_HAS_CRC8/16/32 and provides
+ * the matching function, computing exactly the model nk_crc.h documents
+ * for that width (same seed and chaining).  Widths it lacks fall back
+ * to the byte tables.
+ */
+#if defined(HAL_HAS_CRC8) && HAL_HAS_CRC8
+uint8_t hal_crc8(uint8_t crc, const void *p, size_t len);
+#endif
+#if defined(HAL_HAS_CRC16) && HAL_HAS_CRC16
+uint16_t hal_crc16(uint16_t crc, const void *p, size_t len);
+#endif
+#if defined(HAL_HAS_CRC32) && HAL_HAS_CRC32
+uint32_t hal_crc32(uint32_t crc, const void *p, size_t len);
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * 18. OPTIONAL: FLASH SELF-PROGRAMMING (firmware update)
+ *═══════════════════════════════════════════════════════════════════*/
+
+/*
+ * A backend that can rewrite its own program flash sets
+ * HAL_HAS_FLASH_WRITE, the page size HAL_FLASH_PAGE_SIZE (the erase
+ * and program unit, a power of two) and HAL_FLASH_ASYNC: 1 if a page
+ * programs in the background while the CPU runs on, 0 if
+ * hal_flash_write_page() does the whole job before returning (AVR: the
+ * kernel lives in the RWW section, which cannot be read while SPM is
+ * busy, so it stalls either way).
+ */
+#if defined(HAL_HAS_FLASH_WRITE) && HAL_HAS_FLASH_WRITE
+
+/**
+ * @brief Bytes of program flash hal_flash_write_page() may reach
+ */
+uint32_t hal_flash_size(void);
+
+/**
+ * @brief Erase the page at @p addr and program it with @p page
+ *
+ * @param addr Page-aligned byte address
+ * @param page HAL_FLASH_PAGE_SIZE bytes; with HAL_FLASH_ASYNC they must
+ *             stay valid and unchanged until hal_flash_busy() is false
+ * @return false if a page is still programming, @p addr is unaligned
+ *         or out of range, or the controller refused (nothing started)
+ */
+bool hal_flash_write_page(uint32_t addr, const void *page);
+
+/**
+ * @brief true while a page started by hal_flash_write_page() programs
+ */
+bool hal_flash_busy(void);
+
+/**
+ * @brief Copy @p len bytes of program flash at @p addr into RAM
+ *
+ * Waits for a page still programming first.
+ */
+void hal_flash_read(void *dst, uint32_t addr, size_t len);
+
+#endif /* HAL_HAS_FLASH_WRITE */
+
+/*═══════════════════════════════════════════════════════════════════
+ * 19. OPTIONAL: EXTERNAL MEMORY BUS (heap regions)
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * RAM on a parallel bus (AVR XMEM) is switched on by software.  A
+ * backend that has one sets HAL_HAS_XMEM and HAL_XMEM_SIZE, the bytes
+ * fitted (0 = none); kalloc_init() then adds the range as a
+ * KALLOC_BULK heap region (kalloc.h).
+ */
+#if defined(HAL_HAS_XMEM) && HAL_HAS_XMEM
+
+/**
+ * @brief Switch the external memory interface on
+ *
+ * @param[out] len Bytes usable from the returned address on
+ * @return First usable byte above internal RAM, or NULL if no RAM is
+ *         fitted or all of it is shadowed by internal RAM
+ */
+void *hal_xmem_init(size_t *len);
+
+#endif /* HAL_HAS_XMEM */
+
 #ifdef __cplusplus
 }
 #endif
 
+/* IRQ-off window tracing (debug_irq_trace) wraps the masking calls */
+#include "kernel/sync/irqstat.h"
+
 #endif /* HAL_COMMON_H */
@@ -0,0 +1,139 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file hal_host.c
+ * @brief Host HAL: signal-driven tick and ucontext task switching
+ *
+ * The out-of-line half of hal_host.h.  A SIGALRM interval timer plays
+ * the timer interrupt and the signal mask plays SREG's I bit, so the
+ * preemptive scheduler, locks and doors run unmodified and at native
+ * speed on a PC.  A preempting switch happens inside the signal
+ * handler: the interrupted task's context (mask included) is saved by
+ * swapcontext() and the handler returns only when it is resumed.
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <ucontext.h>
+
+#include "arch/common/hal.h"
+
+/** Contexts that can exist at once (tasks plus each core's boot context) */
+#ifndef HAL_HOST_CONTEXTS
+#  define HAL_HOST_CONTEXTS 64
+#endif
+
+static struct {
+    void      *stack;       /**< Task stack, NULL for a boot context */
+    bool       used;
+    ucontext_t uc;
+} hal_host_ctx[HAL_HOST_CONTEXTS];
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONTEXT SWITCHING
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Claim a slot: the one already holding @p stack, else a free one */
+static uint16_t ctx_alloc(void *stack) {
+    int free_slot = -1;
+
+    for (int i = 0; i < HAL_HOST_CONTEXTS; i++) {
+        if (hal_host_ctx[i].used && stack && hal_host_ctx[i].stack == stack) {
+            return (uint16_t)(i + 1);       /* task re-created on its stack */
+        }
+        if (!hal_host_ctx[i].used && free_slot < 0) {
+            free_slot = i;
+        }
+    }
+    if (free_slot < 0) {
+        abort();                            /* raise HAL_HOST_CONTEXTS */
+    }
+    hal_host_ctx[free_slot].used = true;
+    hal_host_ctx[free_slot].stack = stack;
+    return (uint16_t)(free_slot + 1);
+}
+
+void hal_context_init(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size) {
+    uint32_t s = hal_irq_save();
+    ctx->slot = ctx_alloc(stack);
+    hal_irq_restore(s);
+
+    ucontext_t *uc = &hal_host_ctx[ctx->slot - 1].uc;
+    getcontext(uc);
+    uc->uc_stack.ss_sp = stack;
+    uc->uc_stack.ss_size = stack_size;
+    uc->uc_link = NULL;
+    sigdelset(&uc->uc_sigmask, HAL_HOST_TICK_SIGNAL);   /* starts interruptible */
+    makecontext(uc, entry, 0);
+}
+
+/* Called with the tick masked (scheduler lock or the tick handler) */
+void hal_context_switch(hal_context_t *from, hal_context_t *to) {
+    ucontext_t *next = &hal_host_ctx[to->slot - 1].uc;
+
+    if (!from) {
+        setcontext(next);
+        return;
+    }
+    if (!from->slot) {
+        from->slot = ctx_alloc(NULL);       /* first switch away from boot */
+    }
+    swapcontext(&hal_host_ctx[from->slot - 1].uc, next);
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * TICK
+ *═══════════════════════════════════════════════════════════════════*/
+
+static void hal_host_tick(int sig) {
+    int saved = errno;      /* the interrupted code may be mid-syscall */
+    (void)sig;
+    hal_timer_tick_handler();
+    errno = saved;
+}
+
+void hal_timer_init(uint32_t freq_hz) {
+    struct sigaction sa;
+    struct itimerval it;
+    long us = freq_hz ? (long)(1000000u / freq_hz) : 0;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = hal_host_tick;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;               /* handler itself runs masked */
+    sigaction(HAL_HOST_TICK_SIGNAL, &sa, NULL);
+
+    it.it_interval.tv_sec = us / 1000000;
+    it.it_interval.tv_usec = us % 1000000;
+    it.it_value = it.it_interval;
+    setitimer(ITIMER_REAL, &it, NULL);
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * SLEEP
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* One level: the tick signal is the only thing that wakes a host */
+static const hal_sleep_info_t hal_sleep_tab[HAL_SLEEP_LEVELS] = {
+    [HAL_SLEEP_IDLE] = { 1, 0, HAL_SLEEP_F_TIMED },
+    [HAL_SLEEP_SAVE] = { 0, 0, HAL_SLEEP_F_NONE },
+    [HAL_SLEEP_DEEP] = { 0, 0, HAL_SLEEP_F_NONE },
+};
+
+const hal_sleep_info_t *hal_sleep_info(void) {
+    return hal_sleep_tab;
+}
+
+void hal_sleep(hal_sleep_t level) {
+    (void)level;
+    hal_idle();
+}
@@ -7,13 +7,27 @@
  * @brief HAL Implementation for Host (Linux/x86)
  *
  * Provides dummy implementations and emulation for testing the OS on a PC.
+ *
+ * Interrupts are emulated with signals: the tick is a SIGALRM from
+ * setitimer() that calls hal_timer_tick_handler(), and "interrupts
+ * disabled" means SIGALRM blocked in the signal mask.  The scheduler
+ * therefore preempts on the host exactly where it would on target, at
+ * native speed, and its critical sections hold off the tick.  Contexts
+ * are ucontexts kept in a table in hal_host.c; hal_context_t is just a
+ * 2-byte slot number, so it fits the TCB's @c sp field like the AVR one.
  */
 
 #ifndef HAL_HOST_H
 #define HAL_HOST_H
 
-#define _DEFAULT_SOURCE /* For usleep, etc. */
-#define _XOPEN_SOURCE 700
+/* Only effective before the first libc header; host builds also pass
+ * them on the command line (meson.build) */
+#ifndef _DEFAULT_SOURCE
+#  define _DEFAULT_SOURCE /* For usleep, etc. */
+#endif
+#ifndef _XOPEN_SOURCE
+#  define _XOPEN_SOURCE 700
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,16 +38,23 @@ extern "C" {
 #include <unistd.h>
 #include <string.h>
 #include <signal.h>
-#include <ucontext.h>
 #include <sys/time.h>
+#include <time.h>
 
-/* Architecture definitions */
+/** Signal standing in for the timer interrupt */
+#define HAL_HOST_TICK_SIGNAL SIGALRM
+
+/** Stack for a host task: signal frames and libc (printf) need far more
+ *  than a target task's few hundred bytes */
+#define HAL_HOST_STACK 32768
+
+/* Architecture definitions: slot in hal_host.c's context table, 0 = none yet */
 typedef struct {
-    ucontext_t uc;
-    void *stack;
-    size_t stack_size;
+    uint16_t slot;
 } hal_context_t;
 
+_Static_assert(sizeof(hal_context_t) == 2, "host context must fit nk_tcb_t.sp");
+
 /* Inline functions for HAL */
 
 static inline void hal_init(void) {
@@ -45,51 +66,127 @@ static inline void hal_reset(void) {
 }
 
 static inline void hal_idle(void) {
-    usleep(1000); /* Sleep 1ms */
+    usleep(1000); /* Sleep 1ms, or until the next tick */
+}
+
+/* Interrupt masking = blocking the tick signal; the mask is the state */
+static inline uint32_t hal_host_irq_mask(int how) {
+    sigset_t set, old;
+    sigemptyset(&set);
+    sigaddset(&set, HAL_HOST_TICK_SIGNAL);
+    sigprocmask(how, &set, &old);
+    return sigismember(&old, HAL_HOST_TICK_SIGNAL) ? 0u : 1u;
 }
 
 static inline void hal_irq_enable(void) {
-    /* Host simulation of IRQ enable */
+    (void)hal_host_irq_mask(SIG_UNBLOCK);
 }
 
 static inline void hal_irq_disable(void) {
-    /* Host simulation of IRQ disable */
+    (void)hal_host_irq_mask(SIG_BLOCK);
+}
+
+static inline bool hal_irq_enabled(void) {
+    sigset_t cur;
+    sigprocmask(SIG_BLOCK, NULL, &cur);
+    return !sigismember(&cur, HAL_HOST_TICK_SIGNAL);
 }
 
 static inline uint32_t hal_irq_save(void) {
-    return 0;
+    return hal_host_irq_mask(SIG_BLOCK);
 }
 
 static inline void hal_irq_restore(uint32_t state) {
-    (void)state;
+    if (state) {
+        hal_irq_enable();
+    }
 }
 
-static inline void hal_context_switch(hal_context_t *from, hal_context_t *to) {
-    if (from) {
-        swapcontext(&from->uc, &to->uc);
-    } else {
-        setcontext(&to->uc);
-    }
+/* Context switching (hal_host.c): a fresh context starts with the tick
+ * unmasked, like a new AVR frame; a switch carries each side's mask. */
+void hal_context_init(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size);
+void hal_context_switch(hal_context_t *from, hal_context_t *to);
+
+/* swapcontext() already behaves like a call; coop is the same path */
+static inline void hal_context_init_coop(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size) {
+    hal_context_init(ctx, entry, stack, stack_size);
+}
+
+static inline void hal_context_switch_coop(hal_context_t *from, hal_context_t *to) {
+    hal_context_switch(from, to);
 }
 
-static inline void hal_context_init(hal_context_t *ctx, void (*entry)(void), void *stack, size_t stack_size) {
-    getcontext(&ctx->uc);
-    ctx->uc.uc_stack.ss_sp = stack;
-    ctx->uc.uc_stack.ss_size = stack_size;
-    ctx->uc.uc_link = NULL;
-    ctx->stack = stack;
-    ctx->stack_size = stack_size;
-    makecontext(&ctx->uc, entry, 0);
+/* SMP: the host simulation is a single core */
+static inline uint8_t hal_cpu_id(void) {
+    return 0;
+}
+
+static inline void hal_ipi_send(uint8_t core) {
+    (void)core;
 }
 
 /* Timer */
 extern void hal_timer_tick_handler(void); /* From scheduler */
 
-static inline void hal_timer_init(uint32_t freq_hz) {
-    /* In a real host port, we'd set up a SIGALRM or similar. */
-    (void)freq_hz;
+/**
+ * @brief Start the tick: SIGALRM every 1/@p freq_hz s (hal_host.c)
+ *
+ * The handler runs hal_timer_tick_handler() unless the tick is masked,
+ * in which case it is delivered on unmask (one pending tick at most,
+ * as with a real timer interrupt flag).
+ */
+void hal_timer_init(uint32_t freq_hz);
+
+/* One-shot tick: hal_idle() sleeps 1 ms, so one tick elapses per wake */
+static inline uint16_t hal_timer_oneshot(uint16_t ticks) {
+    return ticks;
+}
+
+static inline uint16_t hal_timer_resume(void) {
+    return 1;
+}
+
+/* Millisecond ticks from the monotonic-enough wall clock */
+static inline uint32_t hal_timer_ticks(void) {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint32_t)((uint64_t)tv.tv_sec * 1000u + (uint64_t)tv.tv_usec / 1000u);
+}
+
+/* "Cycles" are monotonic nanoseconds: no calibration, immune to TSC drift */
+#define HAL_CYCLES_HZ 1000000000UL
+
+static inline uint32_t hal_cycles(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+/* Busy-waits spin on the cycle clock, so they also work with the tick masked */
+static inline void hal_timer_delay_us(uint32_t us) {
+    uint32_t t0 = hal_cycles();
+    while (hal_cycles() - t0 < us * 1000u) {}
 }
 
+static inline void hal_timer_delay_ms(uint32_t ms) {
+    while (ms--) hal_timer_delay_us(1000);
+}
+
+/* Block copy/fill: libc's are already vectorised (0 = test hal.h's) */
+#ifndef HAL_HAS_FAST_COPY
+#define HAL_HAS_FAST_COPY 1
+#endif
+
+#if HAL_HAS_FAST_COPY
+static inline void hal_memcpy_fast(void *dst, const void *src, size_t n) {
+    memcpy(dst, src, n);
+}
+
+static inline void hal_memset_fast(void *dst, uint8_t c, size_t n) {
+    memset(dst, c, n);
+}
+#endif
+
 /* Atomics (Host uses GCC builtins) */
 static inline uint8_t hal_atomic_test_and_set_u8(volatile uint8_t *ptr) {
     return __sync_lock_test_and_set(ptr, 1);
@@ -99,25 +196,159 @@ static inline uint8_t hal_atomic_exchange_u8(volatile uint8_t *ptr, uint8_t val)
     return __sync_lock_test_and_set(ptr, val);
 }
 
+static inline bool hal_atomic_compare_exchange_u8(volatile uint8_t *ptr, uint8_t *expected, uint8_t val) {
+    return __atomic_compare_exchange_n(ptr, expected, val, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline bool hal_atomic_compare_exchange_u16(volatile uint16_t *ptr, uint16_t *expected, uint16_t val) {
+    return __atomic_compare_exchange_n(ptr, expected, val, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline bool hal_atomic_compare_exchange_u32(volatile uint32_t *ptr, uint32_t *expected, uint32_t val) {
+    return __atomic_compare_exchange_n(ptr, expected, val, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static inline uint16_t hal_atomic_exchange_u16(volatile uint16_t *ptr, uint16_t val) {
+    return __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+static inline uint32_t hal_atomic_exchange_u32(volatile uint32_t *ptr, uint32_t val) {
+    return __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+/* hal_atomic_fetch_{add,sub,or,and}_u{8,16,32} */
+#define HAL_HOST_FETCH_OP(op, bits)                                          \
+    static inline uint##bits##_t hal_atomic_fetch_##op##_u##bits(            \
+        volatile uint##bits##_t *ptr, uint##bits##_t val) {                  \
+        return __atomic_fetch_##op(ptr, val, __ATOMIC_SEQ_CST);              \
+    }
+#define HAL_HOST_FETCH_OPS(op) \
+    HAL_HOST_FETCH_OP(op, 8) HAL_HOST_FETCH_OP(op, 16) HAL_HOST_FETCH_OP(op, 32)
+
+HAL_HOST_FETCH_OPS(add)
+HAL_HOST_FETCH_OPS(sub)
+HAL_HOST_FETCH_OPS(or)
+HAL_HOST_FETCH_OPS(and)
+
+#undef HAL_HOST_FETCH_OPS
+#undef HAL_HOST_FETCH_OP
+
 static inline void hal_memory_barrier(void) {
     __sync_synchronize();
 }
 
-/* EEPROM Stubs */
-static inline bool hal_eeprom_available(void) { return false; }
-static inline uint16_t hal_eeprom_size(void) { return 0; }
-static inline uint8_t hal_eeprom_read_byte(uint16_t addr) { (void)addr; return 0xFF; }
-static inline void hal_eeprom_write_byte(uint16_t addr, uint8_t val) { (void)addr; (void)val; }
+/*
+ * Non-volatile memory (hal_host_nvm.c).  EEPROM and flash are byte arrays
+ * mmap'd from image files, so their contents outlive the process and a
+ * soak run can be resumed or inspected with a hex dump.  Byte i's
+ * program/erase count is kept in the same way in "<image>.wear".
+ * Without a path the arrays are anonymous and last for the run only.
+ *
+ * hal_eeprom_*() use hal_host_eeprom.  Until something maps it, the
+ * first call configures it from the environment:
+ *
+ *   AVRIX_EEPROM=<file>         image (omit for an anonymous array)
+ *   AVRIX_EEPROM_SIZE=<bytes>   size (default 1024 once a file is named)
+ *   AVRIX_EEPROM_WRITE_NS=<ns>  latency charged per programmed byte
+ *   AVRIX_EEPROM_SLEEP=1        really wait it out, not only count it
+ *
+ * and stays unavailable (reads 0xFF, size 0) if neither AVRIX_EEPROM
+ * nor AVRIX_EEPROM_SIZE is set.  hal_host_flash is configured from the
+ * matching AVRIX_FLASH* variables (plus AVRIX_FLASH_ERASE_NS per sector)
+ * when blkdev_host_nor_init() first needs it, else an anonymous 1 MiB.
+ */
+typedef struct hal_host_nvm {
+    uint8_t  *mem;          /**< Image, NULL until mapped */
+    uint32_t *wear;         /**< Program/erase cycles per byte */
+    size_t    size;
+    uint32_t  write_ns;     /**< Latency per byte programmed */
+    uint32_t  erase_ns;     /**< Latency per hal_host_nvm_erase() */
+    bool      sleep;        /**< Wait the latency out as well as count it */
+    bool      nor;          /**< Programming only clears bits (flash) */
+    bool      probed;       /**< Environment already consulted */
+    uint64_t  programmed;   /**< Bytes programmed since mapping */
+    uint64_t  erased;       /**< Bytes erased since mapping */
+    uint64_t  busy_ns;      /**< Latency charged since mapping */
+} hal_host_nvm_t;
 
-static inline void hal_eeprom_read_block(void *dest, uint16_t addr, size_t len) {
-    (void)addr;
-    memset(dest, 0xFF, len);
-}
+extern hal_host_nvm_t hal_host_eeprom;
+extern hal_host_nvm_t hal_host_flash;
 
-static inline void hal_eeprom_update_block(uint16_t addr, const void *src, size_t len) {
-    (void)addr; (void)src; (void)len;
+/**
+ * @brief Map @p size bytes of @p path (NULL: anonymous) into @p m
+ *
+ * Bytes past the old end of the file read as erased (0xFF).  The
+ * latency and nor fields are left as the caller set them.
+ *
+ * @return 0, or -1 if the file or its wear counters cannot be mapped
+ */
+int  hal_host_nvm_map(hal_host_nvm_t *m, const char *path, size_t size);
+
+/**
+ * @brief Map @p m as $<prefix>, $<prefix>_SIZE (default @p size),
+ *        _WRITE_NS, _ERASE_NS and _SLEEP say
+ *
+ * @return 0, 1 if neither the image nor a size is set (left unmapped),
+ *         or -1 on error
+ */
+int  hal_host_nvm_env(hal_host_nvm_t *m, const char *prefix, size_t size);
+
+/** Unmap @p m, writing the image back to its file */
+void hal_host_nvm_unmap(hal_host_nvm_t *m);
+
+/**
+ * @brief Program @p n bytes at @p off
+ *
+ * With @p update, bytes already holding their value are skipped and
+ * cost nothing, like eeprom_update_block().  On NOR media a byte
+ * becomes old & new.  Each byte programmed counts one cycle of wear
+ * and write_ns of latency.  Clipped to the image.
+ */
+void hal_host_nvm_write(hal_host_nvm_t *m, size_t off, const void *src, size_t n,
+                        bool update);
+
+/** Set @p n bytes at @p off to 0xFF, one cycle of wear each */
+void hal_host_nvm_erase(hal_host_nvm_t *m, size_t off, size_t n);
+
+/** Highest per-byte wear count */
+uint32_t hal_host_nvm_max_wear(const hal_host_nvm_t *m);
+
+/*
+ * Program flash (hal.h section 18) is hal_host_flash too, set up as for
+ * blkdev_host_nor_init().  A page programs in the background: it is
+ * copied from the caller's buffer only once erase_ns plus write_ns per
+ * byte have passed on hal_cycles(), so a buffer reused too early shows
+ * up in the image.
+ */
+#define HAL_HAS_FLASH_WRITE 1
+#define HAL_FLASH_ASYNC     1
+#ifndef HAL_FLASH_PAGE_SIZE
+#  define HAL_FLASH_PAGE_SIZE 256u
+#endif
+
+static inline bool hal_eeprom_busy(void) { return false; }
+static inline void hal_eeprom_flush(void) {}
+
+typedef void (*hal_eeprom_done_t)(void *arg);
+
+void hal_eeprom_update_block(uint16_t addr, const void *src, size_t len);
+
+/* Synchronous: completes (and calls done) before returning */
+static inline bool hal_eeprom_write_async(uint16_t addr, const void *src, size_t len,
+                                          hal_eeprom_done_t done, void *arg) {
+    hal_eeprom_update_block(addr, src, len);
+    if (done) done(arg);
+    return true;
 }
 
+/* UART Stubs: tests call tty_rx_isr()/tty_tx_isr() in place of the ISRs */
+struct tty_s;
+static inline void hal_uart_attach(struct tty_s *t, uint32_t baud) { (void)t; (void)baud; }
+static inline void hal_uart_tx_kick(void) {}
+
 #ifdef __cplusplus
 }
 #endif
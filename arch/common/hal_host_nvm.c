@@ -0,0 +1,344 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file hal_host_nvm.c
+ * @brief Host HAL: EEPROM and flash as mmap'd image files
+ *
+ * Kept apart from hal_host.c so a test that links the EEPROM functions
+ * does not also pull in the tick and, through it, the scheduler.
+ * Every programmed or erased byte bumps its wear counter and charges
+ * the configured latency, so endurance and throughput runs on the host
+ * see the same write pattern the part would.
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 700
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "arch/common/hal.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * IMAGES
+ *═══════════════════════════════════════════════════════════════════*/
+
+hal_host_nvm_t hal_host_eeprom;
+hal_host_nvm_t hal_host_flash = { .nor = true };
+
+/* Map @p len bytes of @p path (anonymous if NULL); *old = previous size */
+static void *nvm_mmap(const char *path, size_t len, size_t *old) {
+    void *p;
+
+    *old = 0;
+    if (!path) {
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return p == MAP_FAILED ? NULL : p;
+    }
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &st) != 0 || ftruncate(fd, (off_t)len) != 0) {
+        close(fd);
+        return NULL;
+    }
+    *old = (size_t)st.st_size < len ? (size_t)st.st_size : len;
+    p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);                              /* the mapping keeps the file */
+    return p == MAP_FAILED ? NULL : p;
+}
+
+int hal_host_nvm_map(hal_host_nvm_t *m, const char *path, size_t size) {
+    size_t old, old_wear;
+    char wear_path[4096];
+
+    hal_host_nvm_unmap(m);
+    m->probed = true;
+    if (size == 0) {
+        return -1;
+    }
+    if (path && snprintf(wear_path, sizeof wear_path, "%s.wear", path) >= (int)sizeof wear_path) {
+        return -1;
+    }
+    m->mem = nvm_mmap(path, size, &old);
+    m->wear = m->mem ? nvm_mmap(path ? wear_path : NULL, size * sizeof *m->wear, &old_wear)
+                     : NULL;
+    if (!m->wear) {
+        if (m->mem) {
+            munmap(m->mem, size);
+            m->mem = NULL;
+        }
+        return -1;
+    }
+    memset(m->mem + old, 0xFF, size - old);  /* new cells come erased */
+    m->size = size;
+    m->programmed = m->erased = m->busy_ns = 0;
+    return 0;
+}
+
+static unsigned long env_ul(const char *prefix, const char *name, unsigned long def) {
+    char key[64];
+    snprintf(key, sizeof key, "%s%s", prefix, name);
+    const char *v = getenv(key);
+    return v && *v ? strtoul(v, NULL, 0) : def;
+}
+
+int hal_host_nvm_env(hal_host_nvm_t *m, const char *prefix, size_t size) {
+    const char *path = getenv(prefix);
+    char key[64];
+
+    m->probed = true;
+    snprintf(key, sizeof key, "%s_SIZE", prefix);
+    if (path && !*path) {
+        path = NULL;
+    }
+    if (!path && !getenv(key)) {
+        return 1;
+    }
+    m->write_ns = (uint32_t)env_ul(prefix, "_WRITE_NS", m->write_ns);
+    m->erase_ns = (uint32_t)env_ul(prefix, "_ERASE_NS", m->erase_ns);
+    m->sleep = env_ul(prefix, "_SLEEP", m->sleep) != 0;
+    return hal_host_nvm_map(m, path, env_ul(prefix, "_SIZE", size));
+}
+
+void hal_host_nvm_unmap(hal_host_nvm_t *m) {
+    if (m->mem) {
+        munmap(m->mem, m->size);
+        munmap(m->wear, m->size * sizeof *m->wear);
+    }
+    m->mem = NULL;
+    m->wear = NULL;
+    m->size = 0;
+}
+
+static void nvm_charge(hal_host_nvm_t *m, uint64_t ns) {
+    m->busy_ns += ns;
+    if (m->sleep && ns) {
+        struct timespec ts = { (time_t)(ns / 1000000000u), (long)(ns % 1000000000u) };
+        while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+    }
+}
+
+void hal_host_nvm_write(hal_host_nvm_t *m, size_t off, const void *src, size_t n,
+                        bool update) {
+    const uint8_t *s = src;
+    uint64_t done = 0;
+
+    if (off >= m->size) {
+        return;
+    }
+    if (n > m->size - off) {
+        n = m->size - off;
+    }
+    for (size_t i = 0; i < n; i++) {
+        uint8_t v = m->nor ? (uint8_t)(m->mem[off + i] & s[i]) : s[i];
+        if (update && m->mem[off + i] == v) {
+            continue;
+        }
+        m->mem[off + i] = v;
+        m->wear[off + i]++;
+        done++;
+    }
+    m->programmed += done;
+    nvm_charge(m, done * m->write_ns);
+}
+
+void hal_host_nvm_erase(hal_host_nvm_t *m, size_t off, size_t n) {
+    if (off >= m->size) {
+        return;
+    }
+    if (n > m->size - off) {
+        n = m->size - off;
+    }
+    memset(m->mem + off, 0xFF, n);
+    for (size_t i = 0; i < n; i++) {
+        m->wear[off + i]++;
+    }
+    m->erased += n;
+    nvm_charge(m, m->erase_ns);
+}
+
+uint32_t hal_host_nvm_max_wear(const hal_host_nvm_t *m) {
+    uint32_t w = 0;
+    for (size_t i = 0; i < m->size; i++) {
+        w = m->wear[i] > w ? m->wear[i] : w;
+    }
+    return w;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * EEPROM (hal.h section 11) on hal_host_eeprom
+ *═══════════════════════════════════════════════════════════════════*/
+
+static hal_host_nvm_t *eeprom(void) {
+    if (!hal_host_eeprom.probed) {
+        hal_host_nvm_env(&hal_host_eeprom, "AVRIX_EEPROM", 1024);
+    }
+    return &hal_host_eeprom;
+}
+
+bool hal_eeprom_available(void) {
+    return eeprom()->mem != NULL;
+}
+
+uint16_t hal_eeprom_size(void) {
+    size_t n = eeprom()->size;
+    return n > UINT16_MAX ? UINT16_MAX : (uint16_t)n;
+}
+
+void hal_eeprom_read_block(void *dest, uint16_t addr, size_t len) {
+    const hal_host_nvm_t *m = eeprom();
+    size_t n = addr < m->size ? m->size - addr : 0;
+    n = n < len ? n : len;
+    if (n) {
+        memcpy(dest, m->mem + addr, n);
+    }
+    memset((uint8_t *)dest + n, 0xFF, len - n);
+}
+
+uint8_t hal_eeprom_read_byte(uint16_t addr) {
+    uint8_t v;
+    hal_eeprom_read_block(&v, addr, 1);
+    return v;
+}
+
+uint16_t hal_eeprom_read_word(uint16_t addr) {
+    uint8_t b[2];
+    hal_eeprom_read_block(b, addr, sizeof b);
+    return (uint16_t)(b[0] | b[1] << 8);
+}
+
+uint32_t hal_eeprom_read_dword(uint16_t addr) {
+    return hal_eeprom_read_word(addr) | (uint32_t)hal_eeprom_read_word((uint16_t)(addr + 2u)) << 16;
+}
+
+void hal_eeprom_write_block(uint16_t addr, const void *src, size_t len) {
+    hal_host_nvm_t *m = eeprom();
+    if (m->mem) {
+        hal_host_nvm_write(m, addr, src, len, false);
+    }
+}
+
+void hal_eeprom_update_block(uint16_t addr, const void *src, size_t len) {
+    hal_host_nvm_t *m = eeprom();
+    if (m->mem) {
+        hal_host_nvm_write(m, addr, src, len, true);
+    }
+}
+
+void hal_eeprom_write_byte(uint16_t addr, uint8_t val) {
+    hal_eeprom_write_block(addr, &val, 1);
+}
+
+void hal_eeprom_write_word(uint16_t addr, uint16_t val) {
+    const uint8_t b[2] = { (uint8_t)val, (uint8_t)(val >> 8) };
+    hal_eeprom_write_block(addr, b, sizeof b);
+}
+
+void hal_eeprom_write_dword(uint16_t addr, uint32_t val) {
+    hal_eeprom_write_word(addr, (uint16_t)val);
+    hal_eeprom_write_word((uint16_t)(addr + 2u), (uint16_t)(val >> 16));
+}
+
+void hal_eeprom_update_byte(uint16_t addr, uint8_t val) {
+    hal_eeprom_update_block(addr, &val, 1);
+}
+
+void hal_eeprom_update_word(uint16_t addr, uint16_t val) {
+    const uint8_t b[2] = { (uint8_t)val, (uint8_t)(val >> 8) };
+    hal_eeprom_update_block(addr, b, sizeof b);
+}
+
+void hal_eeprom_update_dword(uint16_t addr, uint32_t val) {
+    hal_eeprom_update_word(addr, (uint16_t)val);
+    hal_eeprom_update_word((uint16_t)(addr + 2u), (uint16_t)(val >> 16));
+}
+
+void hal_eeprom_erase_all(void) {
+    hal_host_nvm_t *m = eeprom();
+    if (m->mem) {
+        const uint8_t ff = 0xFF;
+        for (size_t a = 0; a < m->size; a++) {
+            hal_host_nvm_write(m, a, &ff, 1, true);
+        }
+    }
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PROGRAM FLASH (hal.h section 18) on hal_host_flash
+ *═══════════════════════════════════════════════════════════════════*/
+
+static struct {
+    const uint8_t *page;    /* Caller's buffer, NULL when idle */
+    uint32_t       addr;
+    uint32_t       due;     /* hal_cycles() when the page is done */
+} flash_op;
+
+static hal_host_nvm_t *flash(void) {
+    hal_host_nvm_t *m = &hal_host_flash;
+    if (!m->mem) {
+        int rc = m->probed ? 1 : hal_host_nvm_env(m, "AVRIX_FLASH", 1u << 20);
+        if (rc > 0) {
+            hal_host_nvm_map(m, NULL, 1u << 20);
+        }
+    }
+    return m;
+}
+
+uint32_t hal_flash_size(void) {
+    size_t n = flash()->size;
+    return n > UINT32_MAX ? UINT32_MAX : (uint32_t)n;
+}
+
+bool hal_flash_busy(void) {
+    if (!flash_op.page) {
+        return false;
+    }
+    if ((int32_t)(hal_cycles() - flash_op.due) < 0) {
+        return true;
+    }
+    /* Done: the page lands now, from whatever the buffer holds now */
+    hal_host_nvm_t *m = flash();
+    bool sleep = m->sleep;
+    m->sleep = false;                       /* the deadline was the wait */
+    hal_host_nvm_erase(m, flash_op.addr, HAL_FLASH_PAGE_SIZE);
+    hal_host_nvm_write(m, flash_op.addr, flash_op.page, HAL_FLASH_PAGE_SIZE, false);
+    m->sleep = sleep;
+    flash_op.page = NULL;
+    return false;
+}
+
+bool hal_flash_write_page(uint32_t addr, const void *page) {
+    hal_host_nvm_t *m = flash();
+
+    if (hal_flash_busy() || !m->mem || (addr & (HAL_FLASH_PAGE_SIZE - 1u)) ||
+        addr >= m->size || m->size - addr < HAL_FLASH_PAGE_SIZE) {
+        return false;
+    }
+    flash_op.addr = addr;
+    flash_op.due = hal_cycles() + m->erase_ns + HAL_FLASH_PAGE_SIZE * m->write_ns;
+    flash_op.page = page;
+    return true;
+}
+
+void hal_flash_read(void *dst, uint32_t addr, size_t len) {
+    const hal_host_nvm_t *m = flash();
+    size_t n = addr < m->size ? m->size - addr : 0;
+
+    while (hal_flash_busy()) {}
+    n = n < len ? n : len;
+    if (n) {
+        memcpy(dst, m->mem + addr, n);
+    }
+    memset((uint8_t *)dst + n, 0xFF, len - n);
+}
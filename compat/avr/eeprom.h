@@ -2,17 +2,18 @@
 #define AVR_EEPROM_H
 #include <stdint.h>
 #ifndef __AVR__
-extern uint8_t nk_sim_eeprom[1024];
+#include "arch/common/hal.h"
+/* Addresses index the host HAL's EEPROM image (see hal_host.h) */
 #define EEMEM
 #define memcpy_P memcpy
 #define memcmp_P memcmp
 static inline uint8_t eeprom_read_byte(const uint8_t *addr)
 {
-    return nk_sim_eeprom[(uintptr_t)addr];
+    return hal_eeprom_read_byte((uint16_t)(uintptr_t)addr);
 }
 static inline void eeprom_update_byte(uint8_t *addr, uint8_t value)
 {
-    nk_sim_eeprom[(uintptr_t)addr] = value;
+    hal_eeprom_update_byte((uint16_t)(uintptr_t)addr, value);
 }
 #endif
 #endif /* AVR_EEPROM_H */
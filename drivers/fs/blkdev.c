@@ -0,0 +1,228 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file blkdev.c
+ * @brief Byte access to block devices through the shared block cache
+ */
+
+#include "avrix-config.h"
+#include "blkdev.h"
+#include <string.h>
+
+#define BS BLKDEV_BLOCK_SIZE
+
+/*═══════════════════════════════════════════════════════════════════
+ * BLOCK CACHE
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if BLKDEV_CACHE > 0
+typedef struct {
+    blkdev_t *dev;                 /**< NULL while the line is free */
+    uint32_t  lba;
+    uint8_t   stamp;               /**< blk_clock at last use */
+    bool      dirty;
+    uint8_t   data[BS];
+} blk_line_t;
+
+static blk_line_t blk_lines[BLKDEV_CACHE];
+static uint8_t    blk_clock;
+
+static int line_flush(blk_line_t *l) {
+    if (l->dirty) {
+        if (l->dev->ops->write(l->dev, l->lba, l->data, 1) != 0) {
+            return -1;
+        }
+        l->dirty = false;
+    }
+    return 0;
+}
+
+/* Line holding block @p lba of @p d, loaded from the device if new. */
+static blk_line_t *line_get(blkdev_t *d, uint32_t lba) {
+    blk_line_t *slot = NULL;
+
+    for (uint8_t i = 0; i < BLKDEV_CACHE; i++) {
+        blk_line_t *l = &blk_lines[i];
+        if (l->dev == d && l->lba == lba) {
+            l->stamp = ++blk_clock;
+            return l;
+        }
+        /* Free lines first, then the least recently used */
+        if (!slot || (slot->dev && (!l->dev ||
+            (uint8_t)(blk_clock - l->stamp) > (uint8_t)(blk_clock - slot->stamp)))) {
+            slot = l;
+        }
+    }
+    if (slot->dev && line_flush(slot) != 0) {
+        return NULL;
+    }
+    slot->dev = NULL;
+    if (d->ops->read(d, lba, slot->data, 1) != 0) {
+        return NULL;
+    }
+    slot->dev = d;
+    slot->lba = lba;
+    slot->dirty = false;
+    slot->stamp = ++blk_clock;
+    return slot;
+}
+
+/* Write back (@p keep) or drop every line of @p d in [lba, lba + n). */
+static int lines_range(blkdev_t *d, uint32_t lba, uint32_t n, bool keep) {
+    int rc = 0;
+    for (uint8_t i = 0; i < BLKDEV_CACHE; i++) {
+        blk_line_t *l = &blk_lines[i];
+        if (l->dev == d && l->lba - lba < n) {
+            if (keep) {
+                rc |= line_flush(l);
+            } else {
+                l->dev = NULL;
+                l->dirty = false;
+            }
+        }
+    }
+    return rc;
+}
+#endif /* BLKDEV_CACHE > 0 */
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API IMPLEMENTATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+static bool in_range(const blkdev_t *d, uint32_t pos, uint16_t len) {
+    uint32_t end = pos + len;
+    return end >= pos && (end + BS - 1) / BS <= d->blocks;
+}
+
+int blkdev_pread(blkdev_t *d, uint32_t pos, void *buf, uint16_t len) {
+    uint8_t *p = (uint8_t *)buf;
+
+    if (!d || !in_range(d, pos, len)) {
+        return -1;
+    }
+    while (len) {
+        uint32_t lba = pos / BS;
+        uint16_t at = (uint16_t)(pos % BS);
+        uint16_t n;
+
+        if (at == 0 && len >= BS) {
+            /* Whole blocks: one burst; the media must be current first */
+            uint16_t blocks = (uint16_t)(len / BS);
+#if BLKDEV_CACHE > 0
+            if (lines_range(d, lba, blocks, true) != 0) {
+                return -1;
+            }
+#endif
+            if (d->ops->read(d, lba, p, blocks) != 0) {
+                return -1;
+            }
+            n = (uint16_t)(blocks * BS);
+        } else {
+#if BLKDEV_CACHE > 0
+            blk_line_t *l = line_get(d, lba);
+            if (!l) {
+                return -1;
+            }
+            n = (uint16_t)(BS - at);
+            if (n > len) {
+                n = len;
+            }
+            memcpy(p, &l->data[at], n);
+#else
+            return -1;  /* partial blocks need a cache line */
+#endif
+        }
+        pos += n;
+        p += n;
+        len = (uint16_t)(len - n);
+    }
+    return 0;
+}
+
+int blkdev_pwrite(blkdev_t *d, uint32_t pos, const void *buf, uint16_t len) {
+    const uint8_t *p = (const uint8_t *)buf;
+
+    if (!d || !in_range(d, pos, len)) {
+        return -1;
+    }
+    while (len) {
+        uint32_t lba = pos / BS;
+        uint16_t at = (uint16_t)(pos % BS);
+        uint16_t n;
+
+        if (at == 0 && len >= BS) {
+            /* Whole blocks: cached copies are superseded, not written */
+            uint16_t blocks = (uint16_t)(len / BS);
+#if BLKDEV_CACHE > 0
+            lines_range(d, lba, blocks, false);
+#endif
+            if (d->ops->write(d, lba, p, blocks) != 0) {
+                return -1;
+            }
+            n = (uint16_t)(blocks * BS);
+        } else {
+#if BLKDEV_CACHE > 0
+            blk_line_t *l = line_get(d, lba);
+            if (!l) {
+                return -1;
+            }
+            n = (uint16_t)(BS - at);
+            if (n > len) {
+                n = len;
+            }
+            memcpy(&l->data[at], p, n);
+            l->dirty = true;
+#else
+            return -1;  /* partial blocks need a cache line */
+#endif
+        }
+        pos += n;
+        p += n;
+        len = (uint16_t)(len - n);
+    }
+    return 0;
+}
+
+int blkdev_erase(blkdev_t *d, uint32_t lba, uint32_t n) {
+    const uint32_t unit = (uint32_t)1 << d->erase_shift;
+
+    if (!d->ops->erase) {
+        return 0;
+    }
+    if ((lba | n) & (unit - 1) || lba + n < lba || lba + n > d->blocks) {
+        return -1;
+    }
+#if BLKDEV_CACHE > 0
+    lines_range(d, lba, n, false);
+#endif
+    while (n) {
+        /* ops take a 16-bit count: whole units at a time */
+        uint16_t chunk = n > (0xFFFFu & ~(unit - 1)) ? (uint16_t)(0xFFFFu & ~(unit - 1))
+                                                    : (uint16_t)n;
+        if (d->ops->erase(d, lba, chunk) != 0) {
+            return -1;
+        }
+        lba += chunk;
+        n -= chunk;
+    }
+    return 0;
+}
+
+int blkdev_sync(blkdev_t *d) {
+#if BLKDEV_CACHE > 0
+    return lines_range(d, 0, UINT32_MAX, true);
+#else
+    (void)d;
+    return 0;
+#endif
+}
+
+void blkdev_invalidate(blkdev_t *d) {
+#if BLKDEV_CACHE > 0
+    lines_range(d, 0, UINT32_MAX, false);
+#else
+    (void)d;
+#endif
+}
@@ -0,0 +1,219 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file blkdev.h
+ * @brief Block devices (SPI NOR flash, SD cards) and a shared block cache
+ *
+ * Storage too large for EEPROM is reached through a blkdev_t: a small
+ * ops table that moves whole BLKDEV_BLOCK_SIZE blocks, several at a
+ * time, so a backend can run one bus burst per call instead of one per
+ * block.  Filesystems (see blkfs.h) never call the ops directly; they
+ * go through blkdev_pread()/blkdev_pwrite(), which work in bytes.
+ *
+ * ## Block cache
+ * BLKDEV_CACHE lines, shared by every device, hold recently used
+ * blocks.  Partial-block reads and writes go through a line; writes
+ * stay there (dirty) until evicted or blkdev_sync()ed.  Runs of whole
+ * aligned blocks bypass the cache and reach the backend in a single
+ * multi-block call - the only way to approach the bus limit - after
+ * dirty lines in the range are written back (reads) or dropped as
+ * superseded (writes).  Lines are replaced least recently used first.
+ *
+ * ## SPI backends
+ * blkdev_spi_nor_init() drives 25-series NOR flash (JEDEC commands,
+ * 24-bit addresses, so up to 16 MiB): a read is one READ command
+ * streaming every requested block, a write is 256-byte page programs,
+ * and erase works in 4 KiB sectors.  NOR bits only go from 1 to 0, so
+ * a block must be erased before new data lands on it; blkfs erases
+ * ahead of appends.
+ *
+ * blkdev_spi_sd_init() drives SD/SDHC/SDXC cards in SPI mode with
+ * CMD18/CMD25 multi-block transfers.  Cards need no erase.
+ *
+ * Both talk through a board-supplied blkdev_spi_bus_t: chip select and
+ * a byte exchange, plus an optional block transfer for SPI hardware
+ * with a FIFO or DMA.
+ *
+ * On the host, blkdev_host_nor_init() puts the same NOR behaviour on
+ * the HAL's mmap'd flash image (hal_host_flash), with wear counters.
+ *
+ * ## Memory Footprint
+ * - RAM: BLKDEV_CACHE * (BLKDEV_BLOCK_SIZE + 10) bytes, plus ~12 bytes
+ *   per device
+ */
+
+#ifndef DRIVERS_FS_BLKDEV_H
+#define DRIVERS_FS_BLKDEV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Block size in bytes (an SD sector, two NOR pages)
+ */
+#ifndef BLKDEV_BLOCK_SIZE
+#  define BLKDEV_BLOCK_SIZE 512u
+#endif
+
+/**
+ * @brief Cached blocks shared by all devices (0 = no cache)
+ *
+ * Without a cache, partial-block reads and writes are refused: every
+ * access must cover whole aligned blocks.  Follows fs_blkdev_cache.
+ */
+#ifndef BLKDEV_CACHE
+#  if defined(CONFIG_FS_BLKDEV_CACHE)
+#    define BLKDEV_CACHE CONFIG_FS_BLKDEV_CACHE
+#  else
+#    define BLKDEV_CACHE 2
+#  endif
+#endif
+
+_Static_assert(BLKDEV_BLOCK_SIZE >= 512 && BLKDEV_BLOCK_SIZE <= 4096 &&
+               (BLKDEV_BLOCK_SIZE & (BLKDEV_BLOCK_SIZE - 1)) == 0,
+               "block size must be a power of two from an SD sector to a NOR sector");
+_Static_assert(BLKDEV_CACHE <= 16, "cache is scanned linearly");
+
+/*═══════════════════════════════════════════════════════════════════
+ * DEVICE INTERFACE
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef struct blkdev blkdev_t;
+
+/**
+ * @brief Backend operations; @p n blocks starting at @p lba in one burst
+ *
+ * Each returns 0 on success or -1 on a bus or media error.
+ */
+typedef struct {
+    int (*read)(blkdev_t *d, uint32_t lba, void *buf, uint16_t n);
+    int (*write)(blkdev_t *d, uint32_t lba, const void *buf, uint16_t n);
+    /** Optional: erase whole erase units; NULL if the media needs none */
+    int (*erase)(blkdev_t *d, uint32_t lba, uint16_t n);
+} blkdev_ops_t;
+
+/**
+ * @brief A block device
+ */
+struct blkdev {
+    const blkdev_ops_t *ops;
+    void     *ctx;          /**< Backend state */
+    uint32_t  blocks;       /**< Capacity in blocks */
+    uint8_t   erase_shift;  /**< log2(blocks per erase unit) if ops->erase */
+};
+
+/**
+ * @brief SPI transport supplied by the board
+ */
+typedef struct {
+    void    (*select)(bool on);       /**< Assert (true) or release CS */
+    uint8_t (*xfer)(uint8_t out);     /**< Exchange one byte */
+    /** Optional: exchange @p n bytes; @p tx NULL sends 0xFF, @p rx NULL drops */
+    void    (*xfer_block)(const uint8_t *tx, uint8_t *rx, uint16_t n);
+} blkdev_spi_bus_t;
+
+/** SPI NOR backend state */
+typedef struct {
+    const blkdev_spi_bus_t *bus;
+} blkdev_spi_nor_t;
+
+/** SD card backend state */
+typedef struct {
+    const blkdev_spi_bus_t *bus;
+    bool block_addr;                  /**< SDHC/SDXC: addresses are LBAs */
+} blkdev_spi_sd_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Probe a 25-series NOR flash and describe it in @p d
+ *
+ * Reads the JEDEC ID for the capacity.
+ *
+ * @return 0 on success, -1 if no flash answers
+ */
+int blkdev_spi_nor_init(blkdev_t *d, blkdev_spi_nor_t *st, const blkdev_spi_bus_t *bus);
+
+/**
+ * @brief Bring an SD card into SPI mode and describe it in @p d
+ *
+ * The bus must run at 400 kHz or less until this returns; it may be
+ * sped up afterwards.
+ *
+ * @return 0 on success, -1 if no usable card answers
+ */
+int blkdev_spi_sd_init(blkdev_t *d, blkdev_spi_sd_t *st, const blkdev_spi_bus_t *bus);
+
+struct hal_host_nvm;
+
+/**
+ * @brief Describe a host flash image (normally &hal_host_flash) as NOR
+ *
+ * Maps it first if nothing has: from AVRIX_FLASH* (see hal_host.h),
+ * else anonymous 1 MiB.  Host builds only.
+ *
+ * @return 0 on success, -1 if it cannot be mapped or is not a whole
+ *         number of 4 KiB sectors
+ */
+int blkdev_host_nor_init(blkdev_t *d, struct hal_host_nvm *m);
+
+/**
+ * @brief Read @p len bytes at byte offset @p pos
+ *
+ * @return 0 on success, -1 on error or past the end of the device
+ */
+int blkdev_pread(blkdev_t *d, uint32_t pos, void *buf, uint16_t len);
+
+/**
+ * @brief Write @p len bytes at byte offset @p pos
+ *
+ * On erase-before-write media the blocks must have been erased (see
+ * blkdev_erase()); rewriting bytes already there is harmless.
+ *
+ * @return 0 on success, -1 on error or past the end of the device
+ */
+int blkdev_pwrite(blkdev_t *d, uint32_t pos, const void *buf, uint16_t len);
+
+/**
+ * @brief Erase @p n blocks from @p lba, both multiples of the erase unit
+ *
+ * Cached copies of the blocks are discarded.  A no-op (0) on media
+ * that need no erase.
+ *
+ * @return 0 on success, -1 on error
+ */
+int blkdev_erase(blkdev_t *d, uint32_t lba, uint32_t n);
+
+/**
+ * @brief Write back every dirty cached block of @p d
+ *
+ * @return 0 on success, -1 if a write-back failed
+ */
+int blkdev_sync(blkdev_t *d);
+
+/**
+ * @brief Forget every cached block of @p d without writing it back
+ *
+ * For a device that is going away or has been rewritten behind the
+ * cache.
+ */
+void blkdev_invalidate(blkdev_t *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_FS_BLKDEV_H */
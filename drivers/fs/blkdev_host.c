@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file blkdev_host.c
+ * @brief NOR flash block device on the host HAL's mmap'd flash image
+ *
+ * Behaves like blkdev_spi_nor_init()'s device: 4 KiB erase sectors,
+ * programming only clears bits, and every program or erase is counted
+ * in the image's wear map, so blkfs runs on the host wear the same
+ * cells it would on the part.
+ */
+
+#include "blkdev.h"
+#include "arch/common/hal.h"
+
+#if defined(HAL_ARCH_HOST)
+
+#define BS         BLKDEV_BLOCK_SIZE
+#define NOR_SECTOR 4096u
+
+static int host_read(blkdev_t *d, uint32_t lba, void *buf, uint16_t n) {
+    const hal_host_nvm_t *m = d->ctx;
+    memcpy(buf, m->mem + (size_t)lba * BS, (size_t)n * BS);
+    return 0;
+}
+
+static int host_write(blkdev_t *d, uint32_t lba, const void *buf, uint16_t n) {
+    hal_host_nvm_write(d->ctx, (size_t)lba * BS, buf, (size_t)n * BS, false);
+    return 0;
+}
+
+static int host_erase(blkdev_t *d, uint32_t lba, uint16_t n) {
+    for (uint16_t i = 0; i < n; i += NOR_SECTOR / BS) {
+        hal_host_nvm_erase(d->ctx, (size_t)(lba + i) * BS, NOR_SECTOR);
+    }
+    return 0;
+}
+
+static const blkdev_ops_t host_nor_ops = {
+    .read  = host_read,
+    .write = host_write,
+    .erase = host_erase,
+};
+
+int blkdev_host_nor_init(blkdev_t *d, struct hal_host_nvm *m) {
+    if (!d || !m) {
+        return -1;
+    }
+    if (!m->mem) {
+        int rc = m->probed ? 1 : hal_host_nvm_env(m, "AVRIX_FLASH", 1u << 20);
+        if (rc < 0 || (rc > 0 && hal_host_nvm_map(m, NULL, 1u << 20) != 0)) {
+            return -1;
+        }
+    }
+    if (m->size < NOR_SECTOR || m->size % NOR_SECTOR) {
+        return -1;
+    }
+    m->nor = true;
+    d->ops = &host_nor_ops;
+    d->ctx = m;
+    d->blocks = (uint32_t)(m->size / BS);
+    d->erase_shift = 0;
+    for (uint16_t u = NOR_SECTOR / BS; u > 1; u >>= 1) {
+        d->erase_shift++;
+    }
+    return 0;
+}
+
+#endif /* HAL_ARCH_HOST */
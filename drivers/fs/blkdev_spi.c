@@ -0,0 +1,384 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file blkdev_spi.c
+ * @brief SPI NOR flash and SD card block device backends
+ */
+
+#include "blkdev.h"
+
+#define BS BLKDEV_BLOCK_SIZE
+
+/*═══════════════════════════════════════════════════════════════════
+ * SPI HELPERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Exchange @p n bytes, in one call when the bus can. */
+static void bus_block(const blkdev_spi_bus_t *bus, const uint8_t *tx,
+                      uint8_t *rx, uint16_t n) {
+    if (bus->xfer_block) {
+        bus->xfer_block(tx, rx, n);
+        return;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        uint8_t v = bus->xfer(tx ? tx[i] : 0xFF);
+        if (rx) {
+            rx[i] = v;
+        }
+    }
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * SPI NOR FLASH
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define NOR_READ      0x03
+#define NOR_PROGRAM   0x02
+#define NOR_WREN      0x06
+#define NOR_RDSR      0x05
+#define NOR_ERASE_4K  0x20
+#define NOR_JEDEC_ID  0x9F
+#define NOR_SR_WIP    0x01
+#define NOR_PAGE      256u
+#define NOR_SECTOR    4096u
+#define NOR_WIP_SPINS 2000000ul  /* > 400 ms sector erase at 8 MHz SPI */
+
+_Static_assert(BS <= NOR_SECTOR, "a block must fit in one NOR sector");
+
+static void nor_cmd(const blkdev_spi_bus_t *bus, uint8_t op, uint32_t addr) {
+    bus->xfer(op);
+    bus->xfer((uint8_t)(addr >> 16));
+    bus->xfer((uint8_t)(addr >> 8));
+    bus->xfer((uint8_t)addr);
+}
+
+static int nor_wait(const blkdev_spi_bus_t *bus) {
+    int rc = -1;
+    bus->select(true);
+    bus->xfer(NOR_RDSR);
+    for (uint32_t i = 0; i < NOR_WIP_SPINS; i++) {
+        if (!(bus->xfer(0xFF) & NOR_SR_WIP)) {
+            rc = 0;
+            break;
+        }
+    }
+    bus->select(false);
+    return rc;
+}
+
+static void nor_wren(const blkdev_spi_bus_t *bus) {
+    bus->select(true);
+    bus->xfer(NOR_WREN);
+    bus->select(false);
+}
+
+static int nor_read(blkdev_t *d, uint32_t lba, void *buf, uint16_t n) {
+    const blkdev_spi_bus_t *bus = ((blkdev_spi_nor_t *)d->ctx)->bus;
+    uint8_t *p = (uint8_t *)buf;
+
+    /* One command streams the whole run */
+    bus->select(true);
+    nor_cmd(bus, NOR_READ, lba * BS);
+    for (uint16_t i = 0; i < n; i++) {
+        bus_block(bus, NULL, p + (uint32_t)i * BS, BS);
+    }
+    bus->select(false);
+    return 0;
+}
+
+static int nor_write(blkdev_t *d, uint32_t lba, const void *buf, uint16_t n) {
+    const blkdev_spi_bus_t *bus = ((blkdev_spi_nor_t *)d->ctx)->bus;
+    const uint8_t *p = (const uint8_t *)buf;
+    uint32_t addr = lba * BS;
+
+    for (uint32_t left = (uint32_t)n * (BS / NOR_PAGE); left; left--) {
+        nor_wren(bus);
+        bus->select(true);
+        nor_cmd(bus, NOR_PROGRAM, addr);
+        bus_block(bus, p, NULL, NOR_PAGE);
+        bus->select(false);
+        if (nor_wait(bus) != 0) {
+            return -1;
+        }
+        addr += NOR_PAGE;
+        p += NOR_PAGE;
+    }
+    return 0;
+}
+
+static int nor_erase(blkdev_t *d, uint32_t lba, uint16_t n) {
+    const blkdev_spi_bus_t *bus = ((blkdev_spi_nor_t *)d->ctx)->bus;
+
+    for (uint16_t i = 0; i < n; i += NOR_SECTOR / BS) {
+        nor_wren(bus);
+        bus->select(true);
+        nor_cmd(bus, NOR_ERASE_4K, (lba + i) * BS);
+        bus->select(false);
+        if (nor_wait(bus) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static const blkdev_ops_t nor_ops = {
+    .read  = nor_read,
+    .write = nor_write,
+    .erase = nor_erase,
+};
+
+int blkdev_spi_nor_init(blkdev_t *d, blkdev_spi_nor_t *st, const blkdev_spi_bus_t *bus) {
+    uint8_t id[3];
+
+    if (!d || !st || !bus || !bus->select || !bus->xfer) {
+        return -1;
+    }
+    bus->select(false);
+    bus->select(true);
+    bus->xfer(NOR_JEDEC_ID);
+    bus_block(bus, NULL, id, sizeof(id));
+    bus->select(false);
+
+    /* Nobody home reads as all zeros or all ones */
+    if (id[0] == 0x00 || id[0] == 0xFF || id[2] < 12 || id[2] > 31) {
+        return -1;
+    }
+    uint8_t cap_log2 = id[2] > 24 ? 24 : id[2];  /* 3-byte addressing */
+
+    st->bus = bus;
+    d->ops = &nor_ops;
+    d->ctx = st;
+    d->blocks = ((uint32_t)1 << cap_log2) / BS;
+    d->erase_shift = 0;
+    for (uint16_t u = NOR_SECTOR / BS; u > 1; u >>= 1) {
+        d->erase_shift++;
+    }
+    return nor_wait(bus);
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * SD CARD (SPI MODE)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define SD_SECTOR        512u
+#define SD_TOKEN_START   0xFE
+#define SD_TOKEN_MULTI   0xFC
+#define SD_TOKEN_STOP    0xFD
+#define SD_DATA_ACCEPTED 0x05
+#define SD_R1_IDLE       0x01
+#define SD_SPINS         50000u    /* token / busy polls (> 250 ms) */
+#define SD_INIT_TRIES    2000u     /* ACMD41 rounds (~1 s) */
+
+#define SECTORS (BS / SD_SECTOR)
+
+/* Send a command with CS already low; returns R1 (bit 7 set = no reply). */
+static uint8_t sd_cmd(const blkdev_spi_bus_t *bus, uint8_t cmd, uint32_t arg) {
+    /* Only CMD0 and CMD8 are CRC-checked before SPI mode is set up */
+    uint8_t crc = cmd == 0 ? 0x95 : cmd == 8 ? 0x87 : 0x01;
+    uint8_t r1 = 0xFF;
+
+    bus->xfer(0xFF);
+    bus->xfer((uint8_t)(0x40 | cmd));
+    bus->xfer((uint8_t)(arg >> 24));
+    bus->xfer((uint8_t)(arg >> 16));
+    bus->xfer((uint8_t)(arg >> 8));
+    bus->xfer((uint8_t)arg);
+    bus->xfer(crc);
+    if (cmd == 12) {
+        bus->xfer(0xFF);               /* stuff byte after STOP_TRANSMISSION */
+    }
+    for (uint8_t i = 0; i < 10 && (r1 & 0x80); i++) {
+        r1 = bus->xfer(0xFF);
+    }
+    return r1;
+}
+
+static uint8_t sd_acmd(const blkdev_spi_bus_t *bus, uint8_t cmd, uint32_t arg) {
+    sd_cmd(bus, 55, 0);
+    return sd_cmd(bus, cmd, arg);
+}
+
+static int sd_wait_token(const blkdev_spi_bus_t *bus) {
+    for (uint16_t i = 0; i < SD_SPINS; i++) {
+        uint8_t v = bus->xfer(0xFF);
+        if (v != 0xFF) {
+            return v == SD_TOKEN_START ? 0 : -1;
+        }
+    }
+    return -1;
+}
+
+static int sd_wait_ready(const blkdev_spi_bus_t *bus) {
+    for (uint16_t i = 0; i < SD_SPINS; i++) {
+        if (bus->xfer(0xFF) == 0xFF) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* One data packet: payload plus the CRC nobody checks in SPI mode. */
+static int sd_rx_packet(const blkdev_spi_bus_t *bus, uint8_t *p, uint16_t len) {
+    if (sd_wait_token(bus) != 0) {
+        return -1;
+    }
+    bus_block(bus, NULL, p, len);
+    bus->xfer(0xFF);
+    bus->xfer(0xFF);
+    return 0;
+}
+
+static int sd_tx_sector(const blkdev_spi_bus_t *bus, uint8_t token, const uint8_t *p) {
+    bus->xfer(token);
+    bus_block(bus, p, NULL, SD_SECTOR);
+    bus->xfer(0xFF);
+    bus->xfer(0xFF);
+    if ((bus->xfer(0xFF) & 0x1F) != SD_DATA_ACCEPTED) {
+        return -1;
+    }
+    return sd_wait_ready(bus);
+}
+
+static uint32_t sd_addr(const blkdev_spi_sd_t *st, uint32_t sector) {
+    return st->block_addr ? sector : sector * SD_SECTOR;
+}
+
+static int sd_read(blkdev_t *d, uint32_t lba, void *buf, uint16_t n) {
+    const blkdev_spi_sd_t *st = (const blkdev_spi_sd_t *)d->ctx;
+    const blkdev_spi_bus_t *bus = st->bus;
+    uint32_t count = (uint32_t)n * SECTORS;
+    uint8_t *p = (uint8_t *)buf;
+    int rc = -1;
+
+    bus->select(true);
+    if (count == 1) {
+        if (sd_cmd(bus, 17, sd_addr(st, lba * SECTORS)) == 0) {
+            rc = sd_rx_packet(bus, p, SD_SECTOR);
+        }
+    } else if (sd_cmd(bus, 18, sd_addr(st, lba * SECTORS)) == 0) {
+        rc = 0;
+        for (uint32_t i = 0; i < count && rc == 0; i++) {
+            rc = sd_rx_packet(bus, p + i * SD_SECTOR, SD_SECTOR);
+        }
+        if (sd_cmd(bus, 12, 0) & 0x80 || sd_wait_ready(bus) != 0) {
+            rc = -1;
+        }
+    }
+    bus->select(false);
+    bus->xfer(0xFF);
+    return rc;
+}
+
+static int sd_write(blkdev_t *d, uint32_t lba, const void *buf, uint16_t n) {
+    const blkdev_spi_sd_t *st = (const blkdev_spi_sd_t *)d->ctx;
+    const blkdev_spi_bus_t *bus = st->bus;
+    uint32_t count = (uint32_t)n * SECTORS;
+    const uint8_t *p = (const uint8_t *)buf;
+    int rc = -1;
+
+    bus->select(true);
+    if (count == 1) {
+        if (sd_cmd(bus, 24, sd_addr(st, lba * SECTORS)) == 0) {
+            rc = sd_tx_sector(bus, SD_TOKEN_START, p);
+        }
+    } else if (sd_cmd(bus, 25, sd_addr(st, lba * SECTORS)) == 0) {
+        rc = 0;
+        for (uint32_t i = 0; i < count && rc == 0; i++) {
+            rc = sd_tx_sector(bus, SD_TOKEN_MULTI, p + i * SD_SECTOR);
+        }
+        bus->xfer(SD_TOKEN_STOP);
+        bus->xfer(0xFF);
+        if (sd_wait_ready(bus) != 0) {
+            rc = -1;
+        }
+    }
+    bus->select(false);
+    bus->xfer(0xFF);
+    return rc;
+}
+
+static const blkdev_ops_t sd_ops = {
+    .read  = sd_read,
+    .write = sd_write,
+};
+
+/* Card capacity in 512-byte sectors from the CSD register. */
+static uint32_t sd_csd_sectors(const uint8_t *csd) {
+    if ((csd[0] >> 6) == 1) {
+        /* CSD 2.0: (C_SIZE + 1) * 512 KiB */
+        uint32_t c_size = ((uint32_t)(csd[7] & 0x3F) << 16) |
+                          ((uint32_t)csd[8] << 8) | csd[9];
+        return (c_size + 1) << 10;
+    }
+    /* CSD 1.0: (C_SIZE + 1) << (C_SIZE_MULT + 2 + READ_BL_LEN - 9) */
+    uint16_t c_size = (uint16_t)(((csd[6] & 0x03) << 10) | (csd[7] << 2) | (csd[8] >> 6));
+    uint8_t mult = (uint8_t)(((csd[9] & 0x03) << 1) | (csd[10] >> 7));
+    uint8_t bl_len = csd[5] & 0x0F;
+    return (uint32_t)(c_size + 1) << (mult + 2 + bl_len - 9);
+}
+
+int blkdev_spi_sd_init(blkdev_t *d, blkdev_spi_sd_t *st, const blkdev_spi_bus_t *bus) {
+    uint8_t r[4];
+    uint8_t csd[16];
+    uint32_t hcs = 0;
+    int rc = -1;
+
+    if (!d || !st || !bus || !bus->select || !bus->xfer) {
+        return -1;
+    }
+    st->bus = bus;
+    st->block_addr = false;
+
+    /* 74+ clocks with CS high put the card in native mode, then CMD0 */
+    bus->select(false);
+    for (uint8_t i = 0; i < 10; i++) {
+        bus->xfer(0xFF);
+    }
+    bus->select(true);
+    if (sd_cmd(bus, 0, 0) != SD_R1_IDLE) {
+        goto out;
+    }
+
+    /* CMD8 answers only on v2 cards, which may be high capacity */
+    if (sd_cmd(bus, 8, 0x1AA) == SD_R1_IDLE) {
+        bus_block(bus, NULL, r, sizeof(r));
+        if (r[2] != 0x01 || r[3] != 0xAA) {
+            goto out;
+        }
+        hcs = 1ul << 30;
+    }
+
+    uint16_t tries = 0;
+    while (sd_acmd(bus, 41, hcs) != 0) {
+        if (++tries == SD_INIT_TRIES) {
+            goto out;
+        }
+    }
+
+    if (hcs) {
+        if (sd_cmd(bus, 58, 0) != 0) {
+            goto out;
+        }
+        bus_block(bus, NULL, r, sizeof(r));
+        st->block_addr = (r[0] & 0x40) != 0;   /* CCS */
+    }
+    if (!st->block_addr && sd_cmd(bus, 16, SD_SECTOR) != 0) {
+        goto out;
+    }
+
+    if (sd_cmd(bus, 9, 0) != 0 || sd_rx_packet(bus, csd, sizeof(csd)) != 0) {
+        goto out;
+    }
+    d->ops = &sd_ops;
+    d->ctx = st;
+    d->blocks = sd_csd_sectors(csd) / SECTORS;
+    d->erase_shift = 0;
+    rc = d->blocks ? 0 : -1;
+
+out:
+    bus->select(false);
+    bus->xfer(0xFF);
+    return rc;
+}
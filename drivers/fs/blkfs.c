@@ -0,0 +1,331 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file blkfs.c
+ * @brief Extent filesystem for block devices
+ */
+
+#include "avrix-config.h"
+#include "blkfs.h"
+#include <string.h>
+
+#define BS          BLKDEV_BLOCK_SIZE
+#define BLKFS_MAGIC 0x53464B42u     /* "BKFS" */
+
+/*═══════════════════════════════════════════════════════════════════
+ * DIRECTORY
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef struct {
+    uint32_t     magic;
+    uint32_t     seq;               /**< Bumped by every directory write */
+    uint32_t     next;              /**< First unallocated block */
+    blkfs_file_t files[BLKFS_MAX_FILES];
+    uint32_t     check;             /**< dir_check() of everything above */
+} blkfs_dir_t;
+
+_Static_assert(sizeof(blkfs_dir_t) <= BS, "the directory must fit in one block");
+
+static struct {
+    blkdev_t   *dev;                /**< NULL while unmounted */
+    blkfs_dir_t dir;
+    uint8_t     slot;               /**< Directory copy in use (0/1) */
+    bool        dirty;              /**< dir differs from the media */
+    /** Per file: blocks below this are erased or written */
+    uint32_t    erased[BLKFS_MAX_FILES];
+} bfs;
+
+static uint32_t dir_check(const blkfs_dir_t *d) {
+    const uint8_t *p = (const uint8_t *)d;
+    uint16_t a = 1, b = 0;
+    for (size_t i = 0; i < offsetof(blkfs_dir_t, check); i++) {
+        a = (uint16_t)((a + p[i]) % 65521u);
+        b = (uint16_t)((b + a) % 65521u);
+    }
+    return ((uint32_t)b << 16) | a;
+}
+
+static uint32_t unit_blocks(void) {
+    return (uint32_t)1 << bfs.dev->erase_shift;
+}
+
+static uint32_t round_unit(uint32_t blocks) {
+    uint32_t u = unit_blocks();
+    return (blocks + u - 1) & ~(u - 1);
+}
+
+static bool needs_erase(void) {
+    return bfs.dev->ops->erase != NULL;
+}
+
+/* Read directory copy @p slot into bfs.dir; true if it is valid. */
+static bool dir_load(uint8_t slot) {
+    if (blkdev_pread(bfs.dev, (uint32_t)slot * unit_blocks() * BS,
+                     &bfs.dir, sizeof(bfs.dir)) != 0) {
+        return false;
+    }
+    return bfs.dir.magic == BLKFS_MAGIC && bfs.dir.check == dir_check(&bfs.dir) &&
+           bfs.dir.next <= bfs.dev->blocks;
+}
+
+static int dir_store(uint8_t slot) {
+    uint32_t lba = (uint32_t)slot * unit_blocks();
+
+    bfs.dir.check = dir_check(&bfs.dir);
+    if (blkdev_erase(bfs.dev, lba, unit_blocks()) != 0 ||
+        blkdev_pwrite(bfs.dev, lba * BS, &bfs.dir, sizeof(bfs.dir)) != 0 ||
+        blkdev_sync(bfs.dev) != 0) {
+        return -1;
+    }
+    bfs.slot = slot;
+    bfs.dirty = false;
+    return 0;
+}
+
+/* Entry name for @p path, or NULL if it cannot be one. */
+static const char *base_name(const char *path) {
+    if (!path) {
+        return NULL;
+    }
+    while (*path == '/') {
+        path++;
+    }
+    size_t n = strlen(path);
+    return n && n <= BLKFS_NAME_MAX && !strchr(path, '/') ? path : NULL;
+}
+
+static blkfs_file_t *entry(const blkfs_file_t *f) {
+    if (!bfs.dev || f < bfs.dir.files || f >= bfs.dir.files + BLKFS_MAX_FILES ||
+        !f->name[0]) {
+        return NULL;
+    }
+    return (blkfs_file_t *)f;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * MOUNT
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Extend @p e over appends the last sync did not record (see blkfs.h). */
+static void recover_tail(blkfs_file_t *e, uint8_t i) {
+    const uint32_t unit = unit_blocks() * BS;
+
+    bfs.erased[i] = e->start + round_unit((e->size + BS - 1) / BS);
+    if (!needs_erase() || e->size % unit == 0) {
+        return;             /* the next unit was never erased for us */
+    }
+
+    uint32_t base = e->start * BS;
+    uint32_t end = (e->size / unit + 1) * unit;
+    uint32_t last = e->size;
+    uint8_t chunk[16];
+
+    for (uint32_t pos = e->size; pos < end; pos += sizeof(chunk)) {
+        uint8_t n = end - pos < sizeof(chunk) ? (uint8_t)(end - pos) : sizeof(chunk);
+        if (blkdev_pread(bfs.dev, base + pos, chunk, n) != 0) {
+            return;
+        }
+        for (uint8_t k = 0; k < n; k++) {
+            if (chunk[k] != 0xFF) {
+                last = pos + k + 1;
+            }
+        }
+    }
+    if (last != e->size) {
+        e->size = last;
+        bfs.dirty = true;
+    }
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API IMPLEMENTATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+int blkfs_format(blkdev_t *dev) {
+    if (!dev) {
+        return -1;
+    }
+    bfs.dev = dev;
+    if (dev->blocks < 3 * unit_blocks()) {
+        bfs.dev = NULL;
+        return -1;
+    }
+    blkdev_invalidate(dev);
+    memset(&bfs.dir, 0, sizeof(bfs.dir));
+    memset(bfs.erased, 0, sizeof(bfs.erased));
+    bfs.dir.magic = BLKFS_MAGIC;
+    bfs.dir.next = 2 * unit_blocks();
+
+    /* Copy B goes first so a stale one cannot outrank the new A */
+    if (blkdev_erase(dev, unit_blocks(), unit_blocks()) != 0 ||
+        dir_store(0) != 0) {
+        bfs.dev = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int blkfs_mount(blkdev_t *dev) {
+    if (!dev) {
+        return -1;
+    }
+    bfs.dev = dev;
+    blkdev_invalidate(dev);
+
+    bool ok0 = dir_load(0);
+    uint32_t seq0 = bfs.dir.seq;
+    bool ok1 = dir_load(1);
+
+    if (ok1 && (!ok0 || (int32_t)(bfs.dir.seq - seq0) > 0)) {
+        bfs.slot = 1;
+    } else if (ok0 && dir_load(0)) {
+        bfs.slot = 0;
+    } else {
+        bfs.dev = NULL;
+        return -1;
+    }
+    bfs.dirty = false;
+    for (uint8_t i = 0; i < BLKFS_MAX_FILES; i++) {
+        if (bfs.dir.files[i].name[0]) {
+            recover_tail(&bfs.dir.files[i], i);
+        }
+    }
+    return 0;
+}
+
+const blkfs_file_t *blkfs_open(const char *path) {
+    const char *name = base_name(path);
+
+    if (!bfs.dev || !name) {
+        return NULL;
+    }
+    for (uint8_t i = 0; i < BLKFS_MAX_FILES; i++) {
+        if (strcmp(bfs.dir.files[i].name, name) == 0) {
+            return &bfs.dir.files[i];
+        }
+    }
+    return NULL;
+}
+
+const blkfs_file_t *blkfs_create(const char *path, uint32_t bytes) {
+    const char *name = base_name(path);
+    blkfs_file_t *e = NULL;
+
+    if (!bfs.dev || !name || !bytes || blkfs_open(name)) {
+        return NULL;
+    }
+    for (uint8_t i = 0; i < BLKFS_MAX_FILES && !e; i++) {
+        if (!bfs.dir.files[i].name[0]) {
+            e = &bfs.dir.files[i];
+        }
+    }
+    uint32_t cap = round_unit(bytes / BS + (bytes % BS != 0));
+    if (!e || cap > bfs.dev->blocks - bfs.dir.next) {
+        return NULL;
+    }
+    memset(e, 0, sizeof(*e));
+    strcpy(e->name, name);
+    e->start = bfs.dir.next;
+    e->cap = cap;
+    bfs.erased[e - bfs.dir.files] = e->start;
+    bfs.dir.next += cap;
+    bfs.dirty = true;
+    return e;
+}
+
+int blkfs_read(const blkfs_file_t *f, uint32_t off, void *buf, uint16_t len) {
+    const blkfs_file_t *e = entry(f);
+
+    if (!e || (!buf && len)) {
+        return -1;
+    }
+    if (off >= e->size) {
+        return 0;
+    }
+    if (len > e->size - off) {
+        len = (uint16_t)(e->size - off);
+    }
+    if (blkdev_pread(bfs.dev, e->start * BS + off, buf, len) != 0) {
+        return -1;
+    }
+    return len;
+}
+
+int blkfs_write(const blkfs_file_t *f, uint32_t off, const void *buf, uint16_t len) {
+    blkfs_file_t *e = entry(f);
+
+    if (!e || (!buf && len) || off > e->size ||
+        (needs_erase() && off < e->size)) {
+        return -1;
+    }
+    uint32_t room = e->cap * BS - off;
+    if (len > room) {
+        len = (uint16_t)room;
+    }
+    if (!len) {
+        return 0;
+    }
+
+    /* Erase up to the last block touched, if blkfs_idle() has not */
+    uint8_t i = (uint8_t)(e - bfs.dir.files);
+    uint32_t end = e->start + (off + len + BS - 1) / BS;
+    if (needs_erase() && bfs.erased[i] < end) {
+        uint32_t n = round_unit(end - bfs.erased[i]);
+        if (blkdev_erase(bfs.dev, bfs.erased[i], n) != 0) {
+            return -1;
+        }
+        bfs.erased[i] += n;
+    }
+
+    if (blkdev_pwrite(bfs.dev, e->start * BS + off, buf, len) != 0) {
+        return -1;
+    }
+    if (off + len > e->size) {
+        e->size = off + len;
+        bfs.dirty = true;
+    }
+    return len;
+}
+
+uint32_t blkfs_size(const blkfs_file_t *f) {
+    const blkfs_file_t *e = entry(f);
+    return e ? e->size : 0;
+}
+
+int blkfs_sync(void) {
+    if (!bfs.dev || blkdev_sync(bfs.dev) != 0) {
+        return -1;
+    }
+    if (!bfs.dirty) {
+        return 0;
+    }
+    bfs.dir.seq++;
+    return dir_store(bfs.slot ^ 1);
+}
+
+bool blkfs_idle(void) {
+    if (!bfs.dev || !needs_erase()) {
+        return false;
+    }
+    for (uint8_t i = 0; i < BLKFS_MAX_FILES; i++) {
+        const blkfs_file_t *e = &bfs.dir.files[i];
+        if (!e->name[0]) {
+            continue;
+        }
+        /* Keep the unit after the one holding the end erased */
+        uint32_t want = e->start + round_unit(e->size / BS + 1) + unit_blocks();
+        if (want > e->start + e->cap) {
+            want = e->start + e->cap;
+        }
+        if (bfs.erased[i] < want) {
+            if (blkdev_erase(bfs.dev, bfs.erased[i], unit_blocks()) != 0) {
+                return false;
+            }
+            bfs.erased[i] += unit_blocks();
+            return true;
+        }
+    }
+    return false;
+}
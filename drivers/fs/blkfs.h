@@ -0,0 +1,175 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file blkfs.h
+ * @brief Extent filesystem for block devices (BLKFS)
+ *
+ * A FAT-lite layout for data loggers on SPI NOR flash and SD cards: a
+ * flat directory of up to BLKFS_MAX_FILES named files, each one
+ * contiguous extent reserved when it is created.  There is no
+ * allocation table to update while data is written, so appends are
+ * plain sequential block writes, and runs of whole blocks reach the
+ * device as single multi-block bursts (see blkdev.h).
+ *
+ * ## Layout
+ * ```
+ * unit 0      directory copy A
+ * unit 1      directory copy B
+ * unit 2..    file extents, in creation order
+ * ```
+ * A unit is the device's erase unit (one block on SD cards).  Each
+ * directory copy carries a sequence number and a check word;
+ * blkfs_sync() writes the copy not in use, so a reset mid-update leaves
+ * the previous directory valid and mount takes the newest good copy.
+ *
+ * ## Erase-before-write media
+ * On NOR flash files are append-only: data is never rewritten in
+ * place.  A file's units are erased just before the first write that
+ * reaches them, or earlier by blkfs_idle(), which erases one unit past
+ * the end of a file per call so a logger calling it between samples
+ * never waits for an erase in the write path.
+ *
+ * File sizes reach the media only on blkfs_sync().  Appends made since
+ * are still found by mount as long as they lie in the erase unit that
+ * held the synced end, minus trailing 0xFF bytes, which cannot be told
+ * apart from erased flash.
+ *
+ * ## VFS
+ * Mounted as VFS_TYPE_BLKFS after blkfs_mount() or blkfs_format();
+ * vfs_close() of a writable descriptor calls blkfs_sync().  VFS offsets
+ * are 16 bits, so through the VFS only the first 64 KiB of each file
+ * are visible; the blkfs_*() calls below take 32-bit offsets.
+ *
+ * ## Memory Footprint
+ * - RAM: 20 + 28 * BLKFS_MAX_FILES bytes (directory and erase marks)
+ * - Media: two erase units for the directory
+ */
+
+#ifndef DRIVERS_FS_BLKFS_H
+#define DRIVERS_FS_BLKFS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "blkdev.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Directory slots (follows fs_blkfs_files)
+ */
+#ifndef BLKFS_MAX_FILES
+#  if defined(CONFIG_FS_BLKFS_FILES)
+#    define BLKFS_MAX_FILES CONFIG_FS_BLKFS_FILES
+#  else
+#    define BLKFS_MAX_FILES 8
+#  endif
+#endif
+
+#define BLKFS_NAME_MAX 11   /**< Name bytes, excluding the terminator */
+
+_Static_assert(BLKFS_MAX_FILES >= 1 && BLKFS_MAX_FILES <= 20,
+               "the directory must fit in one block");
+_Static_assert(BLKDEV_CACHE > 0, "blkfs writes partial blocks");
+
+/*═══════════════════════════════════════════════════════════════════
+ * DATA STRUCTURES
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Directory entry (also the on-media format)
+ */
+typedef struct {
+    char     name[BLKFS_NAME_MAX + 1];  /**< NUL-terminated; "" = free */
+    uint32_t start;                     /**< First block of the extent */
+    uint32_t cap;                       /**< Extent length in blocks */
+    uint32_t size;                      /**< Bytes written */
+} blkfs_file_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Write an empty filesystem to @p dev and mount it
+ *
+ * Only the two directory units are erased; file units are erased as
+ * they are used.
+ *
+ * @return 0 on success, -1 on error or a device too small
+ */
+int blkfs_format(blkdev_t *dev);
+
+/**
+ * @brief Mount the filesystem on @p dev
+ *
+ * @return 0 on success, -1 if neither directory copy is valid
+ */
+int blkfs_mount(blkdev_t *dev);
+
+/**
+ * @brief Find a file by name ("/log" or "log")
+ *
+ * @return Directory entry, or NULL if not found or nothing is mounted
+ */
+const blkfs_file_t *blkfs_open(const char *path);
+
+/**
+ * @brief Create an empty file with room for @p bytes
+ *
+ * The extent is rounded up to whole erase units.  The new entry is
+ * persistent after the next blkfs_sync().
+ *
+ * @return Directory entry, or NULL if the name is taken or invalid, the
+ *         directory is full or the device has no room
+ */
+const blkfs_file_t *blkfs_create(const char *path, uint32_t bytes);
+
+/**
+ * @brief Read up to @p len bytes at @p off
+ *
+ * @return Bytes read (0 at end of file), or -1 on error
+ */
+int blkfs_read(const blkfs_file_t *f, uint32_t off, void *buf, uint16_t len);
+
+/**
+ * @brief Write @p len bytes at @p off
+ *
+ * Writes may not leave a hole, and on erase-before-write media may
+ * only append (@p off equal to the size).  They stop at the end of the
+ * extent.
+ *
+ * @return Bytes written, or -1 on error or a rejected offset
+ */
+int blkfs_write(const blkfs_file_t *f, uint32_t off, const void *buf, uint16_t len);
+
+/**
+ * @brief Current size of @p f in bytes
+ */
+uint32_t blkfs_size(const blkfs_file_t *f);
+
+/**
+ * @brief Write back cached blocks and, if it changed, the directory
+ *
+ * @return 0 on success, -1 on error
+ */
+int blkfs_sync(void);
+
+/**
+ * @brief Erase one unit ahead of a file's end, for an idle loop
+ *
+ * @return true if a unit was erased (more may follow), false if every
+ *         file already has an erased unit after its end
+ */
+bool blkfs_idle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_FS_BLKFS_H */
@@ -10,12 +10,25 @@
  * Optimized for minimal wear with update-only writes.
  */
 
+#include "avrix-config.h"
 #include "eepfs.h"
 #include "arch/common/hal.h"
+#include "kernel/lib/nk_warm.h"
 #include <string.h>
 
 #define ARRAY_LEN(x) ((sizeof(x) / sizeof((x)[0])))
 
+/* EEPROM access; tests point these at a RAM image */
+#ifndef EEPFS_EE_READ
+#  define EEPFS_EE_READ(dst, addr, n)   hal_eeprom_read_block(dst, addr, n)
+#endif
+#ifndef EEPFS_EE_UPDATE
+#  define EEPFS_EE_UPDATE(addr, src, n) hal_eeprom_update_block(addr, src, n)
+#endif
+#ifndef EEPFS_EE_SIZE
+#  define EEPFS_EE_SIZE hal_eeprom_size()
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * EEPFS DESCRIPTOR LAYOUT
  *═══════════════════════════════════════════════════════════════════*/
@@ -47,6 +60,7 @@ typedef struct {
  *═══════════════════════════════════════════════════════════════════
  * Address 0x0000: File 0 data (message.txt)
  * Address 0x000A: (future files...)
+ * (Without wear levelling; otherwise see LOG-STRUCTURED STORAGE.)
  *═══════════════════════════════════════════════════════════════════*/
 
 /* Initial file content for EEPROM (written during format) */
@@ -99,6 +113,642 @@ static bool equal_p(const char *s, const char *pstr) {
     return hal_pgm_read_byte(pstr) == 0;
 }
 
+/*═══════════════════════════════════════════════════════════════════
+ * WRITE-BACK CACHE
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if EEPFS_CACHE_LINES > 0
+
+#define LINE_MASK ((uint16_t)(EEPFS_CACHE_LINE - 1u))
+
+typedef struct {
+    uint16_t addr;                     /**< EEPROM address (line aligned) */
+    uint8_t  dirty;                    /**< Holds data not yet written back */
+    uint8_t  stamp;                    /**< eep_clock at the last write */
+    uint8_t  data[EEPFS_CACHE_LINE];
+} eep_line_t;
+
+static eep_line_t eep_lines[EEPFS_CACHE_LINES];
+static uint8_t eep_clock;
+
+static void line_flush(eep_line_t *l) {
+    EEPFS_EE_UPDATE(l->addr, l->data, EEPFS_CACHE_LINE);
+    l->dirty = 0;
+}
+
+/* Dirty line written least recently, or NULL. */
+static eep_line_t *line_oldest(void) {
+    eep_line_t *old = NULL;
+    for (uint8_t i = 0; i < EEPFS_CACHE_LINES; i++) {
+        eep_line_t *l = &eep_lines[i];
+        if (l->dirty && (!old || (uint8_t)(eep_clock - l->stamp) >
+                                 (uint8_t)(eep_clock - old->stamp))) {
+            old = l;
+        }
+    }
+    return old;
+}
+
+/* Line caching @p base, loaded from EEPROM if new; may write one back. */
+static eep_line_t *line_get(uint16_t base) {
+    eep_line_t *slot = NULL;
+    for (uint8_t i = 0; i < EEPFS_CACHE_LINES; i++) {
+        eep_line_t *l = &eep_lines[i];
+        if (l->dirty && l->addr == base) {
+            return l;
+        }
+        if (!l->dirty && !slot) {
+            slot = l;
+        }
+    }
+    if (!slot) {
+        slot = line_oldest();
+        line_flush(slot);
+    }
+    slot->addr = base;
+    EEPFS_EE_READ(slot->data, base, EEPFS_CACHE_LINE);
+    return slot;
+}
+
+static void cache_write(uint16_t addr, const uint8_t *src, uint16_t len) {
+    while (len) {
+        uint16_t base = addr & (uint16_t)~LINE_MASK;
+        uint16_t at = addr & LINE_MASK;
+        uint16_t n = (uint16_t)(EEPFS_CACHE_LINE - at);
+        if (n > len) {
+            n = len;
+        }
+        eep_line_t *l = line_get(base);
+        memcpy(&l->data[at], src, n);
+        l->dirty = 1;
+        l->stamp = ++eep_clock;
+        addr = (uint16_t)(addr + n);
+        src += n;
+        len = (uint16_t)(len - n);
+    }
+}
+
+/* Overlay cached bytes of [addr, addr + len) onto @p dst. */
+static void cache_overlay(uint8_t *dst, uint16_t addr, uint16_t len) {
+    uint32_t end = (uint32_t)addr + len;
+    for (uint8_t i = 0; i < EEPFS_CACHE_LINES; i++) {
+        const eep_line_t *l = &eep_lines[i];
+        uint32_t lo = l->addr, hi = lo + EEPFS_CACHE_LINE;
+        if (!l->dirty || hi <= addr || lo >= end) {
+            continue;
+        }
+        if (lo < addr) lo = addr;
+        if (hi > end) hi = end;
+        memcpy(dst + (lo - addr), &l->data[lo - l->addr], hi - lo);
+    }
+}
+
+#if !EEPFS_WEAR_LEVELING
+/* Write back dirty lines overlapping [addr, addr + len). */
+static int cache_flush_range(uint16_t addr, uint32_t len) {
+    int n = 0;
+    for (uint8_t i = 0; i < EEPFS_CACHE_LINES; i++) {
+        eep_line_t *l = &eep_lines[i];
+        if (l->dirty && (uint32_t)l->addr + EEPFS_CACHE_LINE > addr &&
+            l->addr < (uint32_t)addr + len) {
+            line_flush(l);
+            n++;
+        }
+    }
+    return n;
+}
+#endif
+
+/* Write back everything, oldest first, so the EEPROM sees writes in order. */
+static int cache_flush_all(void) {
+    int n = 0;
+    for (eep_line_t *l; (l = line_oldest()) != NULL; n++) {
+        line_flush(l);
+    }
+    return n;
+}
+
+#endif /* EEPFS_CACHE_LINES > 0 */
+
+/* Segment length capped at @p max bytes */
+static inline uint16_t iov_clip(size_t len, uint16_t max) {
+    return len < max ? (uint16_t)len : max;
+}
+
+/* EEPROM as seen through the cache */
+static void eep_read(void *dst, uint16_t addr, uint16_t len) {
+    EEPFS_EE_READ(dst, addr, len);
+#if EEPFS_CACHE_LINES > 0
+    cache_overlay((uint8_t *)dst, addr, len);
+#endif
+}
+
+static void eep_write(uint16_t addr, const void *src, uint16_t len) {
+#if EEPFS_CACHE_LINES > 0
+    /* Park in RAM; written back (update semantics) on flush */
+    cache_write(addr, (const uint8_t *)src, len);
+#else
+    /* Write to EEPROM using update (only writes changed bytes) */
+    EEPFS_EE_UPDATE(addr, src, len);
+#endif
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * LOG-STRUCTURED STORAGE (EEPFS_WEAR_LEVELING)
+ *═══════════════════════════════════════════════════════════════════
+ * The EEPROM is an array of EEPFS_PAGE-byte pages, each holding one
+ * block of one file:
+ *
+ *   fid blk len seq[4] check | data[len]   (WL_PAYLOAD bytes reserved)
+ *
+ * A write never modifies a live page.  The new contents of a block go
+ * to the next free page after the write head, stamped with the next
+ * sequence number, and the old page simply becomes free.  Rewrites of
+ * a hot file therefore walk across every free page instead of wearing
+ * out the same cells.  At mount the newest valid copy of each block
+ * wins; a torn write fails its check byte, so the previous copy
+ * survives a reset.  The 32-bit sequence outlasts the EEPROM's rated
+ * endurance, so it is compared without wrap-around.  file_table[].addr
+ * is unused in this mode.
+ *
+ * With EEPFS_CHECKPOINT, the block map, sizes, head and sequence are
+ * also saved every few writes to one of two slots after the log pages.
+ * Mount loads the newest valid slot and replays only the pages written
+ * since: allocation is deterministic, so they are the free pages after
+ * the saved head, numbered from the saved sequence on.  A page there
+ * with a later number than expected means the slot is stale, and mount
+ * falls back to the full scan.  Replay can only meet such a page if a
+ * page written after the checkpoint was reused, which takes more writes
+ * than there are free pages, so the interval is kept below half that.
+ *
+ * With NK_WARM the whole map sits in .noinit, saved whenever it agrees
+ * with the EEPROM (after each block write that the cache does not hold
+ * back, and after a sync), so mount after a warm reset is a CRC check.
+ */
+
+#if EEPFS_WEAR_LEVELING
+
+#define WL_HDR       8u
+#define WL_PAYLOAD   (EEPFS_PAGE - WL_HDR)
+#define WL_FILES     ARRAY_LEN(file_table)
+#define WL_MAX_PAGES 254u
+#define WL_NONE      0xFFu
+
+_Static_assert(EEPFS_PAGE > WL_HDR && WL_PAYLOAD <= 255, "bad EEPFS_PAGE");
+
+#if EEPFS_CHECKPOINT
+#define WL_CKPT_MAGIC 0xC5u
+#define WL_CKPT_BYTES (7u + WL_FILES * (EEPFS_MAX_BLOCKS + 2u) + 1u)
+#define WL_CKPT_PAGES ((WL_CKPT_BYTES + EEPFS_PAGE - 1u) / EEPFS_PAGE)
+
+typedef struct {
+    uint8_t magic;     /**< WL_CKPT_MAGIC */
+    uint8_t pages;     /**< Log pages it was taken with */
+    uint8_t head;
+    uint8_t seq[4];    /**< Next write's sequence number */
+} wl_ckpt_t;           /* followed by wl.map, wl.size and a check byte */
+#endif
+
+typedef struct {
+    uint8_t fid;       /**< file_table index, 0xFF = never written */
+    uint8_t blk;       /**< Block within the file */
+    uint8_t len;       /**< Valid data bytes */
+    uint8_t seq[4];    /**< Little-endian write sequence number */
+    uint8_t check;     /**< wl_check() of header and data */
+} wl_hdr_t;
+
+static struct {
+    uint8_t  map[WL_FILES][EEPFS_MAX_BLOCKS];   /**< Live page of each block */
+    uint16_t size[WL_FILES];
+    uint8_t  live[(WL_MAX_PAGES + 7u) / 8u];    /**< Pages holding live blocks */
+    uint8_t  pages;
+    uint8_t  head;                              /**< Next page to allocate */
+    uint32_t seq;                               /**< Stamp for the next write */
+#if EEPFS_CHECKPOINT
+    uint32_t ckpt_seq;                          /**< seq saved by the last checkpoint */
+    uint8_t  ckpt_every;                        /**< Writes between checkpoints */
+    uint8_t  ckpt_slot;                         /**< Slot written last */
+#endif
+} wl NK_WARM_DATA;
+
+static nk_warm_hdr_t wl_warm NK_WARM_DATA;
+static bool wl_mounted;
+
+/* Keep the warm copy of wl unless the cache holds writes it refers to. */
+static void wl_warm_save(void) {
+#if NK_WARM
+    if (wl_mounted && !eepfs_dirty()) {
+        nk_warm_save(&wl_warm, &wl, sizeof wl);
+    }
+#endif
+}
+
+static inline uint16_t wl_addr(uint8_t page) {
+    return (uint16_t)((uint16_t)page * EEPFS_PAGE);
+}
+
+static inline bool wl_is_live(uint8_t page) {
+    return wl.live[page >> 3] & (1u << (page & 7u));
+}
+
+static inline void wl_set_live(uint8_t page, bool on) {
+    if (on) {
+        wl.live[page >> 3] |= (uint8_t)(1u << (page & 7u));
+    } else {
+        wl.live[page >> 3] &= (uint8_t)~(1u << (page & 7u));
+    }
+}
+
+static inline uint32_t wl_get32(const uint8_t *b) {
+    return b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+static inline void wl_put32(uint8_t *b, uint32_t v) {
+    for (uint8_t i = 0; i < 4u; i++) {
+        b[i] = (uint8_t)(v >> (8u * i));
+    }
+}
+
+static inline uint32_t wl_seq(const wl_hdr_t *h) {
+    return wl_get32(h->seq);
+}
+
+/* Rotate-xor check over @p n bytes, continuing from @p c */
+static uint8_t wl_sum(uint8_t c, const void *p, uint16_t n) {
+    const uint8_t *b = (const uint8_t *)p;
+    for (uint16_t i = 0; i < n; i++) {
+        c = (uint8_t)(((c << 1) | (c >> 7)) ^ b[i]);
+    }
+    return c;
+}
+
+static uint8_t wl_check(const wl_hdr_t *h, const uint8_t *data) {
+    return wl_sum(wl_sum(0x5A, h, WL_HDR - 1u), data, h->len);
+}
+
+/* Header of @p page if it holds a valid block; data into @p data if given. */
+static bool wl_load(uint8_t page, wl_hdr_t *h, uint8_t *data) {
+    uint8_t tmp[WL_PAYLOAD];
+    eep_read(h, wl_addr(page), WL_HDR);
+    if (h->fid >= WL_FILES || h->blk >= EEPFS_MAX_BLOCKS || h->len > WL_PAYLOAD) {
+        return false;
+    }
+    if (!data) {
+        data = tmp;
+    }
+    eep_read(data, (uint16_t)(wl_addr(page) + WL_HDR), h->len);
+    return wl_check(h, data) == h->check;
+}
+
+/* Rebuild the block map from every page on the EEPROM. */
+static void wl_scan(void) {
+    bool any = false;
+    uint32_t top = 0;
+
+    memset(wl.map, WL_NONE, sizeof wl.map);
+    memset(wl.size, 0, sizeof wl.size);
+    memset(wl.live, 0, sizeof wl.live);
+    wl.head = 0;
+
+    for (uint8_t p = 0; p < wl.pages; p++) {
+        wl_hdr_t h, o;
+        if (!wl_load(p, &h, NULL)) {
+            continue;
+        }
+        uint8_t *slot = &wl.map[h.fid][h.blk];
+        if (*slot != WL_NONE) {
+            eep_read(&o, wl_addr(*slot), WL_HDR);
+            if (wl_seq(&h) <= wl_seq(&o)) {
+                continue;
+            }
+            wl_set_live(*slot, false);
+        }
+        *slot = p;
+        wl_set_live(p, true);
+        if (!any || wl_seq(&h) > top) {
+            top = wl_seq(&h);
+            wl.head = (uint8_t)(p + 1u);
+            any = true;
+        }
+    }
+    wl.seq = any ? top + 1u : 0u;
+    if (wl.head >= wl.pages) {
+        wl.head = 0;
+    }
+
+    /* Writes never leave holes: a file is its blocks up to the first short one */
+    for (uint8_t f = 0; f < WL_FILES; f++) {
+        for (uint8_t b = 0; b < EEPFS_MAX_BLOCKS && wl.map[f][b] != WL_NONE; b++) {
+            wl_hdr_t h;
+            eep_read(&h, wl_addr(wl.map[f][b]), WL_HDR);
+            wl.size[f] = (uint16_t)(b * WL_PAYLOAD + h.len);
+            if (h.len < WL_PAYLOAD) {
+                break;
+            }
+        }
+    }
+}
+
+/* Next free page at or after the head, or WL_NONE if every page is live. */
+static uint8_t wl_alloc(void) {
+    for (uint8_t i = 0; i < wl.pages; i++) {
+        uint8_t p = wl.head;
+        wl.head = (uint8_t)(p + 1u == wl.pages ? 0u : p + 1u);
+        if (!wl_is_live(p)) {
+            return p;
+        }
+    }
+    return WL_NONE;
+}
+
+#if EEPFS_CHECKPOINT
+static inline uint16_t wl_ckpt_addr(uint8_t slot) {
+    return wl_addr((uint8_t)(wl.pages + slot * WL_CKPT_PAGES));
+}
+
+/* Save the mount state to the slot not written last. */
+static void wl_checkpoint(void) {
+    wl_ckpt_t c = { WL_CKPT_MAGIC, wl.pages, wl.head, { 0 } };
+    uint8_t slot = (uint8_t)(wl.ckpt_slot ^ 1u);
+    uint16_t a = wl_ckpt_addr(slot);
+
+#if EEPFS_CACHE_LINES > 0
+    cache_flush_all();  /* the pages it describes must be there first */
+    memset(eep_lines, 0, sizeof(eep_lines));  /* and no line may span the slot */
+#endif
+    wl_put32(c.seq, wl.seq);
+    uint8_t sum = wl_sum(wl_sum(wl_sum(0x5A, &c, sizeof c), wl.map, sizeof wl.map),
+                         wl.size, sizeof wl.size);
+    const uint8_t bad = 0;
+    EEPFS_EE_UPDATE(a, &bad, 1);  /* invalid until complete */
+    EEPFS_EE_UPDATE((uint16_t)(a + 1u), (const uint8_t *)&c + 1, sizeof c - 1u);
+    a = (uint16_t)(a + sizeof c);
+    EEPFS_EE_UPDATE(a, wl.map, sizeof wl.map);
+    a = (uint16_t)(a + sizeof wl.map);
+    EEPFS_EE_UPDATE(a, wl.size, sizeof wl.size);
+    a = (uint16_t)(a + sizeof wl.size);
+    EEPFS_EE_UPDATE(a, &sum, 1);
+    EEPFS_EE_UPDATE(wl_ckpt_addr(slot), &c, 1);
+
+    wl.ckpt_slot = slot;
+    wl.ckpt_seq = wl.seq;
+}
+
+/* Header of @p slot if its check byte matches. */
+static bool wl_ckpt_valid(uint8_t slot, wl_ckpt_t *c) {
+    uint8_t buf[16];
+    uint16_t a = wl_ckpt_addr(slot);
+    uint16_t left = (uint16_t)(sizeof wl.map + sizeof wl.size);
+
+    EEPFS_EE_READ(c, a, sizeof *c);
+    if (c->magic != WL_CKPT_MAGIC || c->pages != wl.pages || c->head >= wl.pages) {
+        return false;
+    }
+    uint8_t sum = wl_sum(0x5A, c, sizeof *c);
+    for (a = (uint16_t)(a + sizeof *c); left; ) {
+        uint16_t n = left < sizeof buf ? left : sizeof buf;
+        EEPFS_EE_READ(buf, a, n);
+        sum = wl_sum(sum, buf, n);
+        a = (uint16_t)(a + n);
+        left = (uint16_t)(left - n);
+    }
+    EEPFS_EE_READ(buf, a, 1);
+    return buf[0] == sum;
+}
+
+/* Load the newest checkpoint and replay the writes after it. */
+static bool wl_resume(void) {
+    wl_ckpt_t c[2];
+    bool ok0 = wl_ckpt_valid(0, &c[0]), ok1 = wl_ckpt_valid(1, &c[1]);
+    if (!ok0 && !ok1) {
+        return false;
+    }
+    uint8_t slot = (ok0 && (!ok1 || wl_get32(c[0].seq) > wl_get32(c[1].seq))) ? 0u : 1u;
+    uint16_t a = (uint16_t)(wl_ckpt_addr(slot) + sizeof c[0]);
+
+    EEPFS_EE_READ(wl.map, a, sizeof wl.map);
+    EEPFS_EE_READ(wl.size, (uint16_t)(a + sizeof wl.map), sizeof wl.size);
+    memset(wl.live, 0, sizeof wl.live);
+    for (uint8_t f = 0; f < WL_FILES; f++) {
+        for (uint8_t b = 0; b < EEPFS_MAX_BLOCKS; b++) {
+            if (wl.map[f][b] < wl.pages) {
+                wl_set_live(wl.map[f][b], true);
+            } else if (wl.map[f][b] != WL_NONE) {
+                return false;
+            }
+        }
+    }
+    wl.head = c[slot].head;
+    wl.seq = wl.ckpt_seq = wl_get32(c[slot].seq);
+    wl.ckpt_slot = slot;
+
+    for (;;) {
+        uint8_t at = wl.head;
+        uint8_t p = wl_alloc();
+        wl_hdr_t h;
+        if (p == WL_NONE || !wl_load(p, &h, NULL) || wl_seq(&h) < wl.seq) {
+            wl.head = at;  /* where this write would have gone */
+            return true;
+        }
+        if (wl_seq(&h) != wl.seq) {
+            return false;  /* page reused since: checkpoint is stale */
+        }
+        uint8_t *map = &wl.map[h.fid][h.blk];
+        if (*map != WL_NONE) {
+            wl_set_live(*map, false);
+        }
+        *map = p;
+        wl_set_live(p, true);
+        uint16_t end = (uint16_t)(h.blk * WL_PAYLOAD + h.len);
+        if (end > wl.size[h.fid]) {
+            wl.size[h.fid] = end;
+        }
+        wl.seq++;
+    }
+}
+#endif /* EEPFS_CHECKPOINT */
+
+/* Forget everything; size the log (and checkpoint interval) to the EEPROM. */
+static void wl_reset(void) {
+    uint16_t pages = EEPFS_EE_SIZE / EEPFS_PAGE;
+
+    memset(&wl, 0, sizeof wl);
+#if EEPFS_CHECKPOINT
+    pages = pages > 2u * WL_CKPT_PAGES ? (uint16_t)(pages - 2u * WL_CKPT_PAGES) : 0u;
+#endif
+    wl.pages = (uint8_t)(pages > WL_MAX_PAGES ? WL_MAX_PAGES : pages);
+
+#if EEPFS_CHECKPOINT
+    /* Replay must not run into reused pages, even from the older slot */
+    uint16_t room = wl.pages > WL_FILES * EEPFS_MAX_BLOCKS ?
+                    (uint16_t)((wl.pages - WL_FILES * EEPFS_MAX_BLOCKS - 1u) / 2u) : 0u;
+    wl.ckpt_every = (uint8_t)(room < EEPFS_CHECKPOINT ? room : EEPFS_CHECKPOINT);
+#endif
+}
+
+/* Build the block map: from a checkpoint if there is one, else a scan. */
+static void wl_mount(void) {
+    if (nk_warm_restore(&wl_warm, &wl, sizeof wl)) {
+        wl_mounted = true;  /* warm reset: the map is still current */
+        return;
+    }
+    wl_reset();
+#if EEPFS_CHECKPOINT
+    if (!wl.ckpt_every || !wl_resume()) {
+        wl_scan();
+        wl.ckpt_slot = 0;
+        wl.ckpt_seq = wl.seq - wl.ckpt_every;  /* checkpoint on the next write */
+    }
+#else
+    wl_scan();
+#endif
+    wl_mounted = true;
+    wl_warm_save();
+}
+
+static inline void wl_ready(void) {
+    if (!wl_mounted) {
+        wl_mount();
+    }
+}
+
+/* Replace bytes [at, at + n) of block @p blk, writing a fresh page. */
+static bool wl_write_block(uint8_t fid, uint8_t blk, uint8_t at,
+                           const uint8_t *src, uint8_t n) {
+    uint8_t data[WL_PAYLOAD];
+    wl_hdr_t h = { fid, blk, 0, { 0 }, 0 };
+    uint8_t old = wl.map[fid][blk];
+
+    if (old != WL_NONE) {
+        wl_hdr_t o;
+        eep_read(&o, wl_addr(old), WL_HDR);
+        h.len = o.len <= WL_PAYLOAD ? o.len : 0u;  /* validated at mount */
+        eep_read(data, (uint16_t)(wl_addr(old) + WL_HDR), h.len);
+        if (at + n <= h.len && memcmp(&data[at], src, n) == 0) {
+            return true;  /* Unchanged: the EEPROM sees nothing */
+        }
+    }
+    memcpy(&data[at], src, n);
+    if (at + n > h.len) {
+        h.len = (uint8_t)(at + n);
+    }
+
+    nk_warm_invalidate(&wl_warm);
+    uint8_t p = wl_alloc();
+    if (p == WL_NONE) {
+        wl_warm_save();
+        return false;
+    }
+    wl_put32(h.seq, wl.seq);
+    h.check = wl_check(&h, data);
+    eep_write((uint16_t)(wl_addr(p) + WL_HDR), data, h.len);
+    eep_write(wl_addr(p), &h, WL_HDR);
+    wl.seq++;
+
+    wl.map[fid][blk] = p;
+    wl_set_live(p, true);
+    if (old != WL_NONE) {
+        wl_set_live(old, false);
+    }
+    /* Before any checkpoint or warm copy, which must see the new size */
+    uint16_t end = (uint16_t)(blk * WL_PAYLOAD + h.len);
+    if (end > wl.size[fid]) {
+        wl.size[fid] = end;
+    }
+#if EEPFS_CHECKPOINT
+    if (wl.ckpt_every && wl.seq - wl.ckpt_seq >= wl.ckpt_every) {
+        wl_checkpoint();
+    }
+#endif
+    wl_warm_save();
+    return true;
+}
+
+static int wl_readv(uint8_t fid, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt) {
+    const uint16_t size = wl.size[fid];
+    uint16_t done = 0;
+
+    for (uint8_t i = 0; i < cnt && off < size; i++) {
+        uint8_t *buf = (uint8_t *)iov[i].base;
+        uint16_t len = iov_clip(iov[i].len, (uint16_t)(size - off));
+        for (uint16_t k = 0; k < len;) {
+            uint16_t pos = (uint16_t)(off + k);
+            uint8_t blk = (uint8_t)(pos / WL_PAYLOAD);
+            uint8_t at = (uint8_t)(pos % WL_PAYLOAD);
+            uint16_t n = (uint16_t)(WL_PAYLOAD - at);
+            if (n > len - k) {
+                n = (uint16_t)(len - k);
+            }
+            eep_read(buf + k, (uint16_t)(wl_addr(wl.map[fid][blk]) + WL_HDR + at), n);
+            k = (uint16_t)(k + n);
+        }
+        off = (uint16_t)(off + len);
+        done = (uint16_t)(done + len);
+    }
+    return done;
+}
+
+/*
+ * Each block gets one wl_write_block() however many segments cover it:
+ * a run inside one segment is passed in place, anything else is
+ * gathered into a block-sized buffer first.
+ */
+static int wl_writev(uint8_t fid, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt) {
+    const uint16_t cap = (uint16_t)(EEPFS_MAX_BLOCKS * WL_PAYLOAD);
+    uint16_t len = 0, done = 0;
+    uint8_t seg = 0;
+    size_t used = 0;                         /* bytes of iov[seg] taken */
+
+    if (off > wl.size[fid] || off >= cap) {
+        return 0;  /* No holes, no growth past EEPFS_MAX_BLOCKS */
+    }
+    for (uint8_t i = 0; i < cnt; i++) {
+        len = (uint16_t)(len + iov_clip(iov[i].len, (uint16_t)(cap - len)));
+    }
+    if (len > cap - off) {
+        len = (uint16_t)(cap - off);
+    }
+    while (done < len) {
+        uint16_t pos = (uint16_t)(off + done);
+        uint8_t at = (uint8_t)(pos % WL_PAYLOAD);
+        uint16_t n = (uint16_t)(WL_PAYLOAD - at);
+        uint8_t gather[WL_PAYLOAD];
+        const uint8_t *src = gather;
+        if (n > len - done) {
+            n = (uint16_t)(len - done);
+        }
+        while (used == iov[seg].len) {
+            seg++;
+            used = 0;
+        }
+        if (iov[seg].len - used >= n) {
+            src = (const uint8_t *)iov[seg].base + used;
+            used += n;
+        } else {
+            for (uint16_t k = 0; k < n;) {
+                while (used == iov[seg].len) {
+                    seg++;
+                    used = 0;
+                }
+                size_t take = iov[seg].len - used;
+                if (take > (size_t)(n - k)) {
+                    take = (size_t)(n - k);
+                }
+                memcpy(&gather[k], (const uint8_t *)iov[seg].base + used, take);
+                k = (uint16_t)(k + take);
+                used += take;
+            }
+        }
+        if (!wl_write_block(fid, (uint8_t)(pos / WL_PAYLOAD), at, src, (uint8_t)n)) {
+            break;  /* EEPROM full */
+        }
+        done = (uint16_t)(done + n);
+    }
+    return done;
+}
+
+#endif /* EEPFS_WEAR_LEVELING */
+
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API IMPLEMENTATION
  *═══════════════════════════════════════════════════════════════════*/
@@ -136,15 +786,15 @@ const eepfs_file_t *eepfs_open(const char *path) {
         const eepfs_entry_t *entries;
 
         /* Read entries pointer from program memory */
-        entries = (const eepfs_entry_t *)hal_pgm_read_word(&dir->entries);
+        entries = (const eepfs_entry_t *)hal_pgm_read_ptr(&dir->entries);
 
         bool found = false;
         for (uint8_t i = 0; i < count; i++) {
             /* Copy entry from program memory to RAM */
             hal_memcpy_P(&entry, &entries[i], sizeof(entry));
 
-            /* Read entry name pointer from program memory */
-            const char *nm = (const char *)hal_pgm_read_word(&entry.name);
+            /* Entry was copied to RAM: its name pointer is plain data */
+            const char *nm = entry.name;
 
             if (equal_p(seg, nm)) {
                 found = true;
@@ -183,23 +833,31 @@ const eepfs_file_t *eepfs_open(const char *path) {
  * @brief Read from an EEPFS file
  */
 int eepfs_read(const eepfs_file_t *f, uint16_t off, void *buf, uint16_t len) {
+    const vfs_iovec_t iov = { buf, len };
+    return eepfs_readv(f, off, &iov, 1);
+}
+
+int eepfs_readv(const eepfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt) {
+#if EEPFS_WEAR_LEVELING
+    wl_ready();
+    return wl_readv((uint8_t)(f - file_table), off, iov, cnt);
+#else
     eepfs_file_t tmp;
+    uint16_t done = 0;
 
     /* Copy file descriptor from program memory to RAM */
     hal_memcpy_P(&tmp, f, sizeof(tmp));
 
-    /* Check bounds */
-    if (off >= tmp.size) {
-        return 0;  /* Offset past end of file */
-    }
-    if (off + len > tmp.size) {
-        len = tmp.size - off;  /* Truncate to EOF */
-    }
-
-    /* Read from EEPROM using HAL */
-    hal_eeprom_read_block(buf, tmp.addr + off, len);
+    for (uint8_t i = 0; i < cnt && off < tmp.size; i++) {
+        uint16_t len = iov_clip(iov[i].len, (uint16_t)(tmp.size - off));  /* EOF */
 
-    return len;
+        /* Read from EEPROM using HAL */
+        eep_read(iov[i].base, (uint16_t)(tmp.addr + off), len);
+        off = (uint16_t)(off + len);
+        done = (uint16_t)(done + len);
+    }
+    return done;
+#endif
 }
 
 /**
@@ -208,37 +866,141 @@ int eepfs_read(const eepfs_file_t *f, uint16_t off, void *buf, uint16_t len) {
  * Uses update semantics to minimize EEPROM wear.
  */
 int eepfs_write(const eepfs_file_t *f, uint16_t off, const void *buf, uint16_t len) {
+    const vfs_iovec_t iov = { (void *)buf, len };
+    return eepfs_writev(f, off, &iov, 1);
+}
+
+int eepfs_writev(const eepfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt) {
+#if EEPFS_WEAR_LEVELING
+    wl_ready();
+    return wl_writev((uint8_t)(f - file_table), off, iov, cnt);
+#else
     eepfs_file_t tmp;
+    uint16_t done = 0;
 
     /* Copy file descriptor from program memory to RAM */
     hal_memcpy_P(&tmp, f, sizeof(tmp));
 
-    /* Check bounds */
-    if (off >= tmp.size) {
-        return 0;  /* Cannot extend file */
-    }
-    if (off + len > tmp.size) {
-        len = tmp.size - off;  /* Truncate to EOF */
+    /* Cannot extend file: writes are truncated at EOF */
+    for (uint8_t i = 0; i < cnt && off < tmp.size; i++) {
+        uint16_t len = iov_clip(iov[i].len, (uint16_t)(tmp.size - off));
+
+        eep_write((uint16_t)(tmp.addr + off), iov[i].base, len);
+        off = (uint16_t)(off + len);
+        done = (uint16_t)(done + len);
     }
+    return done;
+#endif
+}
 
-    /* Write to EEPROM using update (only writes changed bytes) */
-    hal_eeprom_update_block(tmp.addr + off, buf, len);
+uint16_t eepfs_size(const eepfs_file_t *f) {
+#if EEPFS_WEAR_LEVELING
+    wl_ready();
+    return wl.size[f - file_table];
+#else
+    return hal_pgm_read_word(&f->size);
+#endif
+}
+
+void eepfs_mount(void) {
+#if EEPFS_WEAR_LEVELING
+    wl_mount();
+#endif
+}
+
+int eepfs_fsync(const eepfs_file_t *f) {
+#if EEPFS_CACHE_LINES > 0 && EEPFS_WEAR_LEVELING
+    (void)f;
+    return eepfs_sync();        /* pages must land in write order */
+#elif EEPFS_CACHE_LINES > 0
+    eepfs_file_t tmp;
+    hal_memcpy_P(&tmp, f, sizeof(tmp));
+    return cache_flush_range(tmp.addr, tmp.size);
+#else
+    (void)f;
+    return 0;
+#endif
+}
+
+int eepfs_sync(void) {
+#if EEPFS_CACHE_LINES > 0
+    int n = cache_flush_all();
+#if EEPFS_WEAR_LEVELING
+    wl_warm_save();
+#endif
+    return n;
+#else
+    return 0;
+#endif
+}
 
-    return len;
+bool eepfs_sync_step(void) {
+#if EEPFS_CACHE_LINES > 0
+    eep_line_t *l = line_oldest();
+    if (l) {
+        line_flush(l);
+    }
+    if (eepfs_dirty()) {
+        return true;
+    }
+#if EEPFS_WEAR_LEVELING
+    if (l) {
+        wl_warm_save();
+    }
+#endif
+    return false;
+#else
+    return false;
+#endif
+}
+
+uint8_t eepfs_dirty(void) {
+    uint8_t n = 0;
+#if EEPFS_CACHE_LINES > 0
+    for (uint8_t i = 0; i < EEPFS_CACHE_LINES; i++) {
+        n = (uint8_t)(n + eep_lines[i].dirty);
+    }
+#endif
+    return n;
 }
 
 /**
  * @brief Format EEPROM with initial filesystem structure
  */
 void eepfs_format(void) {
+    uint8_t init[FILE0_SIZE];
+
     /* Check if EEPROM is available */
-    if (!hal_eeprom_available()) {
+    if (EEPFS_EE_SIZE == 0) {
         return;  /* No EEPROM on this platform */
     }
 
+#if EEPFS_CACHE_LINES > 0
+    memset(eep_lines, 0, sizeof(eep_lines));  /* Pending writes are void */
+#endif
+
+    hal_memcpy_P(init, initial_message, FILE0_SIZE);
+#if EEPFS_WEAR_LEVELING
+    /* Invalidate every page, then log the initial contents */
+    const uint8_t erased = 0xFF;
+    nk_warm_invalidate(&wl_warm);
+    wl_mounted = false;
+    wl_reset();
+    for (uint8_t p = 0; p < wl.pages; p++) {
+        EEPFS_EE_UPDATE(wl_addr(p), &erased, 1);
+    }
+#if EEPFS_CHECKPOINT
+    EEPFS_EE_UPDATE(wl_ckpt_addr(0), &erased, 1);
+    EEPFS_EE_UPDATE(wl_ckpt_addr(1), &erased, 1);
+#endif
+    wl_mount();
+    const vfs_iovec_t iov = { init, FILE0_SIZE };
+    wl_writev(0, 0, &iov, 1);
+#else
     /* Write initial file content to EEPROM */
     /* Using update to avoid unnecessary writes if already formatted */
-    hal_eeprom_update_block(FILE0_ADDR, initial_message, FILE0_SIZE);
+    EEPFS_EE_UPDATE(FILE0_ADDR, init, FILE0_SIZE);
+#endif
 }
 
 /**
@@ -246,6 +1008,14 @@ void eepfs_format(void) {
  */
 void eepfs_stats(uint16_t *used_bytes, uint16_t *total_bytes) {
     if (used_bytes) {
+#if EEPFS_WEAR_LEVELING
+        uint16_t used = 0;
+        wl_ready();
+        for (uint8_t p = 0; p < wl.pages; p++) {
+            used = (uint16_t)(used + (wl_is_live(p) ? EEPFS_PAGE : 0u));
+        }
+        *used_bytes = used;
+#else
         /* Calculate total bytes used by all files */
         uint16_t used = 0;
         for (uint8_t i = 0; i < ARRAY_LEN(file_table); i++) {
@@ -254,9 +1024,10 @@ void eepfs_stats(uint16_t *used_bytes, uint16_t *total_bytes) {
             used += f.size;
         }
         *used_bytes = used;
+#endif
     }
 
     if (total_bytes) {
-        *total_bytes = hal_eeprom_size();
+        *total_bytes = EEPFS_EE_SIZE;
     }
 }
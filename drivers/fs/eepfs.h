@@ -6,8 +6,9 @@
  * @file eepfs.h
  * @brief Portable EEPROM Filesystem (EEPFS)
  *
- * Read-only filesystem stored in EEPROM/non-volatile storage.
- * Similar structure to ROMFS but with EEPROM-specific optimizations.
+ * Filesystem stored in EEPROM/non-volatile storage.  The namespace is
+ * fixed like ROMFS (directory tables in flash); file data lives in
+ * EEPROM, either at fixed addresses or in a wear-levelled page log.
  *
  * ## Design
  * - Directory entries: 4 bytes each (like ROMFS)
@@ -18,13 +19,53 @@
  * ## EEPROM Considerations
  * - Limited write cycles (~100k on AVR)
  * - Use hal_eeprom_update_*() to extend lifetime
- * - Reads are fast (~3.4ms/byte on AVR)
+ * - Reads are fast; each changed byte takes ~3.4ms to write on AVR
  * - Consider wear-leveling for frequently written data
  *
+ * ## Wear levelling
+ * With EEPFS_WEAR_LEVELING the whole EEPROM is a log of EEPFS_PAGE-byte
+ * pages, each carrying one block of one file (EEPFS_PAGE - 8 data bytes)
+ * behind a header with the file, block number, length, a sequence
+ * number and a check byte.  Writing a block puts its new contents on
+ * the next free page after a rotating head and releases the old page,
+ * so a file rewritten in a loop spreads its wear over the whole device.
+ * A block whose bytes do not change is not written at all.
+ *
+ * The first access (or eepfs_mount()) scans every page once and keeps
+ * the newest valid copy of each block in a RAM map, after which reads
+ * and writes go straight to the right page.  A write torn by a reset
+ * fails its check byte and the previous copy is used instead.  Files
+ * start empty, grow by appending (writes may not leave a hole) up to
+ * EEPFS_MAX_BLOCKS blocks, and their size is kept by the log; the
+ * flash file table only names them.
+ *
+ * EEPFS_CHECKPOINT > 0 saves the map every that many block writes to
+ * two slots after the log, so mount reads a checkpoint and replays only
+ * the pages written since instead of scanning the whole EEPROM.
+ * Changing it moves the end of the log: reformat afterwards.
+ *
+ * With warm restart (kernel/lib/nk_warm.h) the map is kept in .noinit,
+ * and mount after a watchdog or software reset reads nothing from the
+ * EEPROM.  Writes still held by the cache below make it unsaved until
+ * the next sync.
+ *
+ * ## Write-back cache
+ * With EEPFS_CACHE_LINES > 0, eepfs_write() only updates RAM: writes
+ * land in EEPFS_CACHE_LINE-byte lines covering aligned EEPROM blocks,
+ * and reads see them.  Rewriting the same bytes before a flush costs
+ * nothing, and a line is written back with update semantics, so only
+ * bytes differing from the EEPROM are programmed.  Lines are flushed
+ * by eepfs_fsync()/eepfs_sync() (vfs_fsync() and vfs_close() of a
+ * writable fd call them), one at a time by eepfs_sync_step() from a
+ * background task, or when a write needs a line and all are dirty.
+ * Unflushed data is lost on reset.  Not locked, like the rest of EEPFS.
+ *
  * ## Memory Footprint
  * - Flash: ~250 bytes code + directory metadata
  * - EEPROM: file data only
- * - RAM: 0 bytes (except during file operations)
+ * - RAM: 0 bytes (except during file operations); with wear levelling,
+ *   a block map of EEPFS_MAX_BLOCKS + 2 bytes per file plus a page
+ *   bitmap
  *
  * ## Usage
  * ```c
@@ -58,6 +99,56 @@ extern "C" {
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "vfs_iovec.h"
+
+/** Write-back cache lines (0 = write through, as before). */
+#ifndef EEPFS_CACHE_LINES
+#  if defined(CONFIG_FS_EEPFS_CACHE)
+#    define EEPFS_CACHE_LINES CONFIG_FS_EEPFS_CACHE
+#  else
+#    define EEPFS_CACHE_LINES 0
+#  endif
+#endif
+
+/** Bytes per cache line (power of two). */
+#ifndef EEPFS_CACHE_LINE
+#  define EEPFS_CACHE_LINE 16
+#endif
+
+/** Log-structured, wear-levelled storage (see Wear levelling above). */
+#ifndef EEPFS_WEAR_LEVELING
+#  if defined(CONFIG_FS_EEPFS_WEAR_LEVELING)
+#    define EEPFS_WEAR_LEVELING CONFIG_FS_EEPFS_WEAR_LEVELING
+#  else
+#    define EEPFS_WEAR_LEVELING 0
+#  endif
+#endif
+
+/** Block writes between fast-mount checkpoints of the log (0 = off). */
+#ifndef EEPFS_CHECKPOINT
+#  if defined(CONFIG_FS_EEPFS_CHECKPOINT)
+#    define EEPFS_CHECKPOINT CONFIG_FS_EEPFS_CHECKPOINT
+#  else
+#    define EEPFS_CHECKPOINT 0
+#  endif
+#endif
+
+/** Bytes per log page including its 8-byte header (power of two). */
+#ifndef EEPFS_PAGE
+#  define EEPFS_PAGE 32
+#endif
+
+/** Maximum blocks per file in the log. */
+#ifndef EEPFS_MAX_BLOCKS
+#  define EEPFS_MAX_BLOCKS 8
+#endif
+
+_Static_assert((EEPFS_PAGE & (EEPFS_PAGE - 1)) == 0 && EEPFS_PAGE >= 16 &&
+               EEPFS_PAGE <= 256, "EEPFS page must be a power of two in 16..256");
+
+_Static_assert((EEPFS_CACHE_LINE & (EEPFS_CACHE_LINE - 1)) == 0 &&
+               EEPFS_CACHE_LINE >= 4 && EEPFS_CACHE_LINE <= 128,
+               "EEPFS cache line must be a power of two in 4..128");
 
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API
@@ -69,8 +160,8 @@ extern "C" {
  * Describes a file in EEPFS. Unlike ROMFS, data is in EEPROM not flash.
  */
 typedef struct {
-    uint16_t addr;  /**< EEPROM address of file data */
-    uint16_t size;  /**< File size in bytes */
+    uint16_t addr;  /**< EEPROM address of file data (unused when wear levelling) */
+    uint16_t size;  /**< File size in bytes (capacity when wear levelling) */
 } eepfs_file_t;
 
 /**
@@ -117,13 +208,78 @@ int eepfs_read(const eepfs_file_t *f, uint16_t off, void *buf, uint16_t len);
  * @return Number of bytes actually written
  *
  * @note Uses hal_eeprom_update_block() to avoid unnecessary writes.
- * @note Cannot extend file size (writes truncated at EOF).
- * @note This is a write-through operation (no caching).
+ * @note Without wear levelling, cannot extend file size (writes are
+ *       truncated at EOF).  With it, writes may extend the file from
+ *       its current end up to EEPFS_MAX_BLOCKS blocks; a write past
+ *       the end returns 0, and a full EEPROM ends it short.
+ * @note With EEPFS_CACHE_LINES > 0 the data reaches EEPROM only when
+ *       flushed (see Write-back cache above).
  *
  * @warning EEPROM has limited write cycles! Use sparingly.
  */
 int eepfs_write(const eepfs_file_t *f, uint16_t off, const void *buf, uint16_t len);
 
+/**
+ * @brief Read consecutive file bytes into several buffers (cf. preadv(2))
+ *
+ * @return Bytes read in total (short at EOF)
+ */
+int eepfs_readv(const eepfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt);
+
+/**
+ * @brief Write several buffers to consecutive file bytes (cf. pwritev(2))
+ *
+ * Same limits as eepfs_write() for the concatenated data.  With wear
+ * levelling the segments are gathered per block, so a header, payload
+ * and CRC that share a block cost one page write instead of three.
+ *
+ * @return Bytes written in total
+ */
+int eepfs_writev(const eepfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt);
+
+/**
+ * @brief Current size of an EEPFS file in bytes
+ */
+uint16_t eepfs_size(const eepfs_file_t *f);
+
+/**
+ * @brief Rebuild the wear-levelling block map from EEPROM
+ *
+ * Done automatically on first use; call again only if something other
+ * than EEPFS changed the EEPROM.  No-op without wear levelling.
+ */
+void eepfs_mount(void);
+
+/**
+ * @brief Write back cached data of one file
+ *
+ * @param f Pointer to file descriptor
+ * @return Cache lines written back
+ */
+int eepfs_fsync(const eepfs_file_t *f);
+
+/**
+ * @brief Write back every dirty cache line
+ *
+ * @return Cache lines written back
+ */
+int eepfs_sync(void);
+
+/**
+ * @brief Write back the least recently written dirty line
+ *
+ * Bounded work for an idle or background task:
+ * `while (eepfs_sync_step()) nk_yield();`
+ *
+ * @return true if dirty lines remain
+ */
+bool eepfs_sync_step(void);
+
+/**
+ * @brief Number of dirty cache lines
+ */
+uint8_t eepfs_dirty(void);
+
 /**
  * @brief Format EEPROM with initial filesystem structure
  *
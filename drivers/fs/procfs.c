@@ -0,0 +1,233 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file procfs.c
+ * @brief Kernel counters as files
+ *
+ * A file is a show function; reading prints it through a window onto
+ * the caller's buffer (procfs_out_t), sizing prints it into an empty one.
+ */
+
+#include "avrix-config.h"
+#include "procfs.h"
+#include "vfs.h"
+#include "kernel/sched/scheduler.h"
+#include "kernel/mm/kalloc.h"
+#include "kernel/sync/lockstat.h"
+#if CONFIG_TTY_ENABLED
+#  include "drivers/tty/tty.h"
+#endif
+#include <string.h>
+
+#define ARRAY_LEN(x) ((sizeof(x) / sizeof((x)[0])))
+
+typedef struct {
+    const char   *name;
+    procfs_show_t show;
+    const void   *arg;
+} procfs_entry_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * OUTPUT
+ *═══════════════════════════════════════════════════════════════════*/
+
+void procfs_putc(procfs_out_t *o, char c) {
+    uint16_t rel = (uint16_t)(o->pos - o->off);
+    if (o->pos >= o->off && rel < o->len) {
+        o->buf[rel] = (uint8_t)c;
+    }
+    if (o->pos != 0xFFFFu) o->pos++;
+}
+
+void procfs_puts(procfs_out_t *o, const char *s) {
+    while (*s) procfs_putc(o, *s++);
+}
+
+void procfs_putu(procfs_out_t *o, uint32_t v) {
+    char d[10];
+    uint8_t n = 0;
+    do {
+        d[n++] = (char)('0' + v % 10u);
+        v /= 10u;
+    } while (v);
+    while (n) procfs_putc(o, d[--n]);
+}
+
+void procfs_kv(procfs_out_t *o, const char *key, uint32_t v) {
+    procfs_puts(o, key);
+    procfs_putc(o, ' ');
+    procfs_putu(o, v);
+    procfs_putc(o, '\n');
+}
+
+/* Space-separated row of @p n values */
+static void put_row(procfs_out_t *o, const uint32_t *v, uint8_t n) {
+    for (uint8_t i = 0; i < n; i++) {
+        if (i) procfs_putc(o, ' ');
+        procfs_putu(o, v[i]);
+    }
+    procfs_putc(o, '\n');
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * BUILT-IN FILES
+ *═══════════════════════════════════════════════════════════════════*/
+
+static void show_sched(procfs_out_t *o, const void *arg) {
+    (void)arg;
+    procfs_kv(o, "ticks", nk_ticks());
+    procfs_puts(o, "tid prio run vol invol stack\n");
+    for (uint8_t tid = 0; nk_task_stack_size(tid) >= 0; tid++) {
+        nk_task_stats_t st;
+        if (nk_task_stats(tid, &st) < 0) {
+            memset(&st, 0, sizeof st);
+        }
+        int used = nk_task_stack_usage(tid);
+        uint32_t row[] = {
+            tid, nk_task_priority(tid), st.run_ticks,
+            st.vol_switches, st.invol_switches, used < 0 ? 0u : (uint32_t)used
+        };
+        put_row(o, row, ARRAY_LEN(row));
+    }
+}
+
+#if NK_KALLOC_STATS
+static void show_mem(procfs_out_t *o, const void *arg) {
+    kalloc_stats_t st;
+    (void)arg;
+    kalloc_get_stats(&st);
+    procfs_kv(o, "total", st.total_size);
+    procfs_kv(o, "used", st.used_bytes);
+    procfs_kv(o, "free", st.free_bytes);
+    procfs_kv(o, "peak", st.peak_used);
+    procfs_kv(o, "largest", st.largest_free);
+    procfs_kv(o, "free_blocks", st.free_blocks);
+    procfs_kv(o, "allocs", st.alloc_count);
+    procfs_kv(o, "frees", st.free_count);
+    procfs_puts(o, "hist");
+    for (uint8_t i = 0; i < NK_KALLOC_HIST_BINS; i++) {
+        procfs_putc(o, ' ');
+        procfs_putu(o, st.free_hist[i]);
+    }
+    procfs_putc(o, '\n');
+}
+#endif
+
+static void show_vfs(procfs_out_t *o, const void *arg) {
+    vfs_stats_t st;
+    (void)arg;
+    vfs_get_stats(&st);
+    procfs_kv(o, "mounts", st.mounts_used);
+    procfs_kv(o, "mounts_total", st.mounts_total);
+    procfs_kv(o, "fds", st.fds_used);
+    procfs_kv(o, "fds_total", st.fds_total);
+    procfs_kv(o, "cache_hits", st.cache_hits);
+    procfs_kv(o, "cache_misses", st.cache_misses);
+}
+
+#if NK_LOCK_STATS
+static void show_locks(procfs_out_t *o, const void *arg) {
+    (void)arg;
+    procfs_puts(o, "name acquired contended spins hold_max\n");
+    for (const nk_lockstat_t *st = nk_lockstat_next(NULL); st; st = nk_lockstat_next(st)) {
+        uint32_t row[] = { st->acquired, st->contended, st->spins, st->hold_max };
+        procfs_puts(o, st->name ? st->name : "?");
+        procfs_putc(o, ' ');
+        put_row(o, row, ARRAY_LEN(row));
+    }
+}
+#endif
+
+#if CONFIG_TTY_ENABLED
+void procfs_show_tty(procfs_out_t *o, const void *tty) {
+    const tty_t *t = (const tty_t *)tty;
+#if TTY_ENABLE_STATS
+    tty_stats_t st;
+    tty_get_stats(t, &st);
+    procfs_kv(o, "rx_bytes", st.rx_bytes);
+    procfs_kv(o, "tx_bytes", st.tx_bytes);
+    procfs_kv(o, "rx_overflows", st.rx_overflows);
+#endif
+    procfs_kv(o, "rx_avail", (uint32_t)tty_rx_available(t));
+    procfs_kv(o, "tx_free", (uint32_t)tty_tx_free(t));
+}
+#endif
+
+static const procfs_entry_t procfs_builtin[] = {
+    { "sched", show_sched, NULL },
+#if NK_KALLOC_STATS
+    { "mem",   show_mem,   NULL },
+#endif
+    { "vfs",   show_vfs,   NULL },
+#if NK_LOCK_STATS
+    { "locks", show_locks, NULL },
+#endif
+};
+
+static procfs_entry_t procfs_user[PROCFS_ENTRIES];
+
+/* The mount root: one name per line */
+static void show_dir(procfs_out_t *o, const void *arg) {
+    (void)arg;
+    for (uint8_t i = 0; i < ARRAY_LEN(procfs_builtin); i++) {
+        procfs_puts(o, procfs_builtin[i].name);
+        procfs_putc(o, '\n');
+    }
+    for (uint8_t i = 0; i < PROCFS_ENTRIES && procfs_user[i].show; i++) {
+        procfs_puts(o, procfs_user[i].name);
+        procfs_putc(o, '\n');
+    }
+}
+
+static const procfs_entry_t procfs_dir = { "", show_dir, NULL };
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
+int procfs_add(const char *name, procfs_show_t show, const void *arg) {
+    if (!name || !*name || strchr(name, '/') || !show || procfs_open(name)) return -1;
+
+    for (uint8_t i = 0; i < PROCFS_ENTRIES; i++) {
+        if (!procfs_user[i].show) {
+            procfs_user[i].name = name;
+            procfs_user[i].arg = arg;
+            procfs_user[i].show = show;     /* last: marks the slot used */
+            return 0;
+        }
+    }
+    return -1;
+}
+
+const void *procfs_open(const char *path) {
+    if (!path) return NULL;
+    if (*path == '/') path++;
+    if (!*path) return &procfs_dir;
+
+    for (uint8_t i = 0; i < ARRAY_LEN(procfs_builtin); i++) {
+        if (strcmp(path, procfs_builtin[i].name) == 0) return &procfs_builtin[i];
+    }
+    for (uint8_t i = 0; i < PROCFS_ENTRIES && procfs_user[i].show; i++) {
+        if (strcmp(path, procfs_user[i].name) == 0) return &procfs_user[i];
+    }
+    return NULL;
+}
+
+int procfs_read(const void *f, uint16_t off, void *buf, uint16_t len) {
+    const procfs_entry_t *e = (const procfs_entry_t *)f;
+    procfs_out_t o = { (uint8_t *)buf, off, len, 0 };
+
+    e->show(&o, e->arg);
+    if (o.pos <= off) return 0;
+    return o.pos - off < len ? o.pos - off : len;
+}
+
+uint16_t procfs_size(const void *f) {
+    const procfs_entry_t *e = (const procfs_entry_t *)f;
+    procfs_out_t o = { NULL, 0, 0, 0 };
+
+    e->show(&o, e->arg);
+    return o.pos;
+}
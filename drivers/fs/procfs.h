@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file procfs.h
+ * @brief Kernel counters as files (VFS_TYPE_PROCFS)
+ *
+ * Nothing is stored: every file is a function that prints a snapshot of
+ * some counters as short "key value" lines, run again on each read.  A
+ * read at offset @e off with room for @e len bytes keeps only the bytes
+ * of the output that fall in [off, off + len), so no buffer is needed
+ * however long a file gets; the cost is printing the file once per read.
+ * Counters keep moving between reads, so read a file whole (vfs_size()
+ * or more bytes) to get one consistent snapshot.
+ *
+ * Built-in files (those whose source is compiled in):
+ *
+ *   sched   ticks, then one row per task: tid prio run vol invol stack
+ *           (run/vol/invol from nk_task_stats(), 0 without
+ *           kernel_sched_stats; stack is nk_task_stack_usage())
+ *   mem     kalloc_get_stats() (mm_kalloc_stats)
+ *   vfs     vfs_get_stats()
+ *   locks   one row per lock: name acquired contended spins hold_max
+ *           (sync_lock_stats)
+ *
+ * The mount root itself lists the file names, one per line.  Drivers
+ * and applications add their own files with procfs_add(); for a TTY
+ * (tty_get_stats() and queue levels) procfs_show_tty() is ready-made.
+ *
+ * ```c
+ * vfs_mount(VFS_TYPE_PROCFS, "/proc");
+ * procfs_add("tty0", procfs_show_tty, &serial);
+ *
+ * char buf[96];
+ * int fd = vfs_open("/proc/sched", O_RDONLY);
+ * int n = vfs_read(fd, buf, sizeof buf);      // "ticks 5120\ntid prio ..."
+ * vfs_close(fd);
+ * ```
+ *
+ * ## Memory Footprint
+ * - RAM: 6 bytes per PROCFS_ENTRIES slot (AVR)
+ * - Stack: ~30 bytes while a file prints
+ */
+
+#ifndef DRIVERS_FS_PROCFS_H
+#define DRIVERS_FS_PROCFS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "avrix-config.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Files procfs_add() can register on top of the built-in ones */
+#ifndef PROCFS_ENTRIES
+#  define PROCFS_ENTRIES 4
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * OUTPUT
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Where a show function's output goes
+ *
+ * Output position @c pos counts every byte printed; only those in
+ * [off, off + len) are stored, at @c buf[pos - off].
+ */
+typedef struct {
+    uint8_t  *buf;
+    uint16_t  off;
+    uint16_t  len;
+    uint16_t  pos;      /**< Bytes printed so far (saturates at 0xFFFF) */
+} procfs_out_t;
+
+/**
+ * @brief Print one file into @p o
+ *
+ * @param arg As given to procfs_add()
+ */
+typedef void (*procfs_show_t)(procfs_out_t *o, const void *arg);
+
+/** Print one character */
+void procfs_putc(procfs_out_t *o, char c);
+
+/** Print a NUL-terminated string */
+void procfs_puts(procfs_out_t *o, const char *s);
+
+/** Print @p v in decimal */
+void procfs_putu(procfs_out_t *o, uint32_t v);
+
+/** Print the line "key v\n" */
+void procfs_kv(procfs_out_t *o, const char *key, uint32_t v);
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Add a file
+ *
+ * @param name File name without slashes; the string must outlive procfs
+ * @param show Prints the file
+ * @param arg  Passed to @p show
+ * @return 0, or -1 if the name is taken or all PROCFS_ENTRIES are used
+ */
+int procfs_add(const char *name, procfs_show_t show, const void *arg);
+
+#if CONFIG_TTY_ENABLED
+/**
+ * @brief Show function for a TTY: pass the tty_t as @p arg
+ *
+ * Prints rx_bytes, tx_bytes and rx_overflows (TTY_ENABLE_STATS), then
+ * rx_avail and tx_free.
+ */
+void procfs_show_tty(procfs_out_t *o, const void *tty);
+#endif
+
+/*----------------------------------------------------------------------
+ * Backend entry points (vfs.c)
+ *--------------------------------------------------------------------*/
+
+/**
+ * @brief Find a file
+ *
+ * @param path Path below the mount point ("/sched", or "/" for the list)
+ * @return Handle, or NULL if there is no such file
+ */
+const void *procfs_open(const char *path);
+
+/**
+ * @brief Print file @p f and keep bytes [off, off + len) of it
+ *
+ * @return Bytes stored in @p buf (0 at or past the end)
+ */
+int procfs_read(const void *f, uint16_t off, void *buf, uint16_t len);
+
+/**
+ * @brief Length of file @p f if it were printed now
+ */
+uint16_t procfs_size(const void *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_FS_PROCFS_H */
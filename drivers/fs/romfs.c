@@ -9,40 +9,21 @@
  * Read-only filesystem stored in program flash/ROM using HAL abstractions.
  */
 
+#include "avrix-config.h"
 #include "romfs.h"
 #include "arch/common/hal.h"
 #include <string.h>
 
 #define ARRAY_LEN(x) ((sizeof(x) / sizeof((x)[0])))
 
-/*═══════════════════════════════════════════════════════════════════
- * ROMFS DESCRIPTOR LAYOUT
- *═══════════════════════════════════════════════════════════════════*/
-
-#define ROMFS_FILE 1u
-#define ROMFS_DIR  2u
-
-/**
- * @brief Directory entry (stored in program memory)
- *
- * Each entry describes either a file or a subdirectory.
- * Size: 4 bytes on 8/16-bit, 6+ bytes on 32-bit (pointer size dependent).
- */
-typedef struct {
-    const char *name;  /**< Pointer to name string in program memory */
-    uint8_t type;      /**< ROMFS_FILE or ROMFS_DIR */
-    uint8_t idx;       /**< Index into dir_table or file_table */
-} romfs_entry_t;
-
-/**
- * @brief Directory descriptor (stored in program memory)
- *
- * Describes a directory and its entries.
- */
-typedef struct {
-    const romfs_entry_t *entries;  /**< Pointer to entry array in program memory */
-    uint8_t count;                 /**< Number of entries in this directory */
-} romfs_dir_t;
+/* File data is read through these: near PROGMEM, or far with ROMFS_FAR */
+#if ROMFS_FAR
+#  define data_byte(a)          hal_pgm_read_byte_far(a)
+#  define data_copy(dst, a, n)  hal_memcpy_PF(dst, a, n)
+#else
+#  define data_byte(a)          hal_pgm_read_byte(a)
+#  define data_copy(dst, a, n)  hal_memcpy_P(dst, a, n)
+#endif
 
 /*═══════════════════════════════════════════════════════════════════
  * SAMPLE FILESYSTEM (3-LEVEL HIERARCHY)
@@ -54,9 +35,15 @@ typedef struct {
  * └── README
  *═══════════════════════════════════════════════════════════════════*/
 
+#if defined(ROMFS_IMAGE)
+#  include ROMFS_IMAGE
+#elif defined(CONFIG_FS_ROMFS_IMAGE) && CONFIG_FS_ROMFS_IMAGE
+#  include "romfs_image.h"      /* fs_romfs_image, built by scripts/mkromfs.py */
+#elif !defined(ROMFS_ROOT)
+
 /* File data (stored in program memory) */
-static const uint8_t ver_txt[] HAL_PROGMEM = "1.0\n";
-static const uint8_t readme_txt[] HAL_PROGMEM = "ROMFS demo\n";
+static const uint8_t ver_txt[] ROMFS_DATA = "1.0\n";
+static const uint8_t readme_txt[] ROMFS_DATA = "ROMFS demo\n";
 
 /* Entry names (stored in program memory) */
 static const char name_ver[] HAL_PROGMEM = "version.txt";
@@ -65,10 +52,18 @@ static const char name_etc[] HAL_PROGMEM = "etc";
 static const char name_readme[] HAL_PROGMEM = "README";
 
 /* File table (stored in program memory) */
+#if ROMFS_FAR && HAL_PGM_FAR
+extern const romfs_file_t file_table[2];
+__asm__(ROMFS_FAR_TABLE(file_table)
+        ROMFS_FAR_FILE(ver_txt, 4, 0)
+        ROMFS_FAR_FILE(readme_txt, 11, 0)
+        ROMFS_FAR_END);
+#else
 static const romfs_file_t file_table[] HAL_PROGMEM = {
-    { ver_txt, sizeof(ver_txt) - 1 },
-    { readme_txt, sizeof(readme_txt) - 1 }
+    { ROMFS_ADDR(ver_txt), sizeof(ver_txt) - 1, 0 },
+    { ROMFS_ADDR(readme_txt), sizeof(readme_txt) - 1, 0 }
 };
+#endif
 
 /* Directory: /etc/config/ */
 static const romfs_entry_t config_entries[] HAL_PROGMEM = {
@@ -80,40 +75,86 @@ static const romfs_entry_t etc_entries[] HAL_PROGMEM = {
     { name_cfg, ROMFS_DIR, 0 }
 };
 
-/* Directory: / (root) */
+/* Directory: / (root), sorted: "README" < "etc" */
 static const romfs_entry_t root_entries[] HAL_PROGMEM = {
-    { name_etc, ROMFS_DIR, 1 },
-    { name_readme, ROMFS_FILE, 1 }
+    { name_readme, ROMFS_FILE, 1 },
+    { name_etc, ROMFS_DIR, 1 }
 };
 
-/* Directory table (stored in program memory) - use compound literals for C11 */
+/* Directory table (stored in program memory) */
 static const romfs_dir_t dir_table[] HAL_PROGMEM = {
-    { config_entries, 1 }, /* 0: /etc/config/ */
-    { etc_entries, 1 },    /* 1: /etc/ */
-    { root_entries, 2 }    /* 2: / (root) */
+    { config_entries, 1, ROMFS_DIR_SORTED }, /* 0: /etc/config/ */
+    { etc_entries, 1, ROMFS_DIR_SORTED },    /* 1: /etc/ */
+    { root_entries, 2, ROMFS_DIR_SORTED }    /* 2: / (root) */
 };
 
-#define ROOT_DIR (&dir_table[2])
+#define ROMFS_ROOT (&dir_table[2])
+#endif /* sample image */
 
 /*═══════════════════════════════════════════════════════════════════
- * HELPER: COMPARE RAM STRING TO FLASH STRING
+ * HELPER: COMPARE RAM SEGMENT TO FLASH STRING
  *═══════════════════════════════════════════════════════════════════*/
 
 /**
- * @brief Compare a RAM string to one in flash
+ * @brief Compare a path segment in RAM to a name in flash
  *
- * @param s String in RAM
- * @param pstr String in program memory (flash)
- * @return true if strings are equal, false otherwise
+ * @param s    Segment (not terminated)
+ * @param n    Segment length
+ * @param pstr NUL-terminated name in program memory
+ * @return <0, 0 or >0 as strcmp() of the segment against the name
  */
-static bool equal_p(const char *s, const char *pstr) {
-    char c;
-    while ((c = *s++)) {
-        if (c != hal_pgm_read_byte(pstr++)) {
-            return false;
+static int cmp_p(const char *s, size_t n, const char *pstr) {
+    for (size_t i = 0; i < n; i++) {
+        uint8_t c = hal_pgm_read_byte(pstr + i);
+        if ((uint8_t)s[i] != c) {
+            return (uint8_t)s[i] < c ? -1 : 1;
+        }
+    }
+    return hal_pgm_read_byte(pstr + n) ? -1 : 0;
+}
+
+/**
+ * @brief Look a segment up in one directory
+ *
+ * Sorted directories are binary-searched; others are scanned.
+ *
+ * @param dir Directory in program memory
+ * @param s   Segment
+ * @param n   Segment length
+ * @param out Receives the matching entry (copied to RAM)
+ * @return true if found
+ */
+static bool dir_lookup(const romfs_dir_t *dir, const char *s, size_t n,
+                       romfs_entry_t *out) {
+    uint16_t count = hal_pgm_read_word(&dir->count);
+    const romfs_entry_t *entries =
+        (const romfs_entry_t *)hal_pgm_read_ptr(&dir->entries);
+
+    if (hal_pgm_read_byte(&dir->flags) & ROMFS_DIR_SORTED) {
+        uint16_t lo = 0, hi = count;
+        while (lo < hi) {
+            uint16_t mid = (uint16_t)(lo + (hi - lo) / 2u);
+            hal_memcpy_P(out, &entries[mid], sizeof(*out));
+            int c = cmp_p(s, n, out->name);
+            if (c == 0) {
+                return true;
+            }
+            if (c < 0) {
+                hi = mid;
+            } else {
+                lo = (uint16_t)(mid + 1u);
+            }
+        }
+        return false;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        hal_memcpy_P(out, &entries[i], sizeof(*out));
+        if (cmp_p(s, n, out->name) == 0) {
+            return true;
         }
     }
-    return hal_pgm_read_byte(pstr) == 0;
+    return false;
 }
 
 /*═══════════════════════════════════════════════════════════════════
@@ -129,82 +170,224 @@ static bool equal_p(const char *s, const char *pstr) {
  * @return Pointer to file descriptor, or NULL if not found
  */
 const romfs_file_t *romfs_open(const char *path) {
-    const romfs_dir_t *dir = ROOT_DIR;
+    const romfs_dir_t *dir = ROMFS_ROOT;
     const char *p = path;
 
-    /* Skip leading '/' */
-    if (*p == '/') {
-        p++;
-    }
-
-    char seg[12];  /* Path segment buffer (max 11 chars + null) */
+    for (;;) {
+        while (*p == '/') {
+            p++;
+        }
+        if (*p == '\0') {
+            return NULL;  /* Path ended in directory, not file */
+        }
 
-    while (*p) {
-        /* Extract next path segment */
+        /* Next path segment */
         size_t n = 0;
-        while (p[n] && p[n] != '/' && n < sizeof(seg) - 1) {
-            seg[n] = p[n];
+        while (p[n] && p[n] != '/') {
             n++;
         }
-        seg[n] = '\0';
+
+        romfs_entry_t entry;
+        if (!dir_lookup(dir, p, n, &entry)) {
+            return NULL;  /* Path component not found */
+        }
         p += n;
-        if (*p == '/') {
+        while (*p == '/') {
             p++;
         }
 
-        /* Search current directory for segment */
-        uint8_t count = hal_pgm_read_byte(&dir->count);
-        romfs_entry_t entry;
-        const romfs_entry_t *entries;
-
-        /* Read entries pointer from program memory */
-        entries = (const romfs_entry_t *)hal_pgm_read_word(&dir->entries);
-
-        bool found = false;
-        for (uint8_t i = 0; i < count; i++) {
-            /* Copy entry from program memory to RAM */
-            hal_memcpy_P(&entry, &entries[i], sizeof(entry));
-
-            /* Read entry name pointer from program memory */
-            const char *nm = (const char *)hal_pgm_read_word(&entry.name);
-
-            if (equal_p(seg, nm)) {
-                found = true;
-
-                /* If this is the last segment and it's a file, return it */
-                if (*p == '\0' && entry.type == ROMFS_FILE) {
-                    if (entry.idx >= ARRAY_LEN(file_table)) {
-                        return NULL;
-                    }
-                    return &file_table[entry.idx];
-                }
-                /* If it's a directory, descend into it */
-                else if (entry.type == ROMFS_DIR) {
-                    if (entry.idx >= ARRAY_LEN(dir_table)) {
-                        return NULL;
-                    }
-                    dir = &dir_table[entry.idx];
-                }
-                /* Path component is a file but not the last segment */
-                else {
-                    return NULL;
-                }
-                break;
+        if (entry.type == ROMFS_DIR) {
+            if (entry.idx >= ARRAY_LEN(dir_table)) {
+                return NULL;
+            }
+            dir = &dir_table[entry.idx];
+        } else if (*p == '\0' && entry.type == ROMFS_FILE) {
+            if (entry.idx >= ARRAY_LEN(file_table)) {
+                return NULL;
             }
+            return &file_table[entry.idx];
+        } else {
+            return NULL;  /* File used as a directory */
         }
+    }
+}
 
-        if (!found) {
-            return NULL;  /* Path component not found */
+/*═══════════════════════════════════════════════════════════════════
+ * COMPRESSED FILES
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if ROMFS_LZ_STREAMS > 0
+
+#define LZ_WINDOW    (1u << ROMFS_LZ_WINDOW_BITS)
+#define LZ_MIN_MATCH 3u
+
+typedef struct {
+    const romfs_file_t *file;  /**< File being decoded, NULL if free */
+    romfs_addr_t in;           /**< Next stream byte */
+    uint16_t out;              /**< Offset of the next output byte */
+    uint16_t match;            /**< Bytes left in the current match */
+    uint8_t dist;              /**< Match distance - 1 */
+    uint8_t ctrl;              /**< Remaining control flags */
+    uint8_t bits;              /**< Flags left in ctrl */
+    uint8_t head;              /**< Window write position */
+    uint8_t age;               /**< Reads since last use (for eviction) */
+    uint8_t window[LZ_WINDOW];
+} lz_stream_t;
+
+static lz_stream_t lz_streams[ROMFS_LZ_STREAMS];
+
+static uint16_t pgm_le16(romfs_addr_t p) {
+    return (uint16_t)(data_byte(p) | (data_byte(p + 1) << 8));
+}
+
+/*
+ * Stream for a read of @p f at @p off: one already stopped there,
+ * else a free one, else another one on @p f, else the least recently
+ * used.
+ */
+static lz_stream_t *lz_stream_for(const romfs_file_t *f, uint16_t off) {
+    lz_stream_t *hit = NULL, *same = NULL, *victim = &lz_streams[0];
+
+    for (uint8_t i = 0; i < ROMFS_LZ_STREAMS; i++) {
+        lz_stream_t *s = &lz_streams[i];
+        if (s->file == f) {
+            if (s->out == off && !hit) {
+                hit = s;
+            } else if (!same) {
+                same = s;
+            }
+        }
+        if (s->age < UINT8_MAX) {
+            s->age++;
         }
+        if (!s->file || (victim->file && s->age > victim->age)) {
+            victim = s;
+        }
+    }
+
+    lz_stream_t *s = hit ? hit : !victim->file ? victim : same ? same : victim;
+    if (s->file != f) {
+        s->file = NULL;
     }
+    s->age = 0;
+    return s;
+}
 
-    return NULL;  /* Path ended in directory, not file */
+/* Point @p s at the checkpoint at or before @p off (@p tmp: RAM copy of @p f). */
+static void lz_seek(lz_stream_t *s, const romfs_file_t *f,
+                    const romfs_file_t *tmp, uint16_t off) {
+    romfs_addr_t hdr = tmp->data;
+    uint8_t shift = data_byte(hdr);
+    uint16_t nblocks = (uint16_t)(((uint32_t)tmp->size + (1ul << shift) - 1u) >> shift);
+    uint16_t blk = (uint16_t)(off >> shift);
+    romfs_addr_t stream = hdr + 2 + 2u * (nblocks - 1u);
+
+    s->file = f;
+    s->in = stream + (blk ? pgm_le16(hdr + 2 + 2u * (blk - 1u)) : 0u);
+    s->out = (uint16_t)((uint32_t)blk << shift);
+    s->match = 0;
+    s->bits = 0;
+}
+
+/**
+ * @brief Decode the next @p len bytes of @p s into @p buf (NULL = skip)
+ */
+static void lz_decode(lz_stream_t *s, uint8_t wbits, uint8_t shift,
+                      uint8_t *buf, uint16_t len) {
+    const uint16_t wmask = (uint16_t)((1u << wbits) - 1u);
+    const uint16_t bmask = (uint16_t)((1ul << shift) - 1u);
+    romfs_addr_t in = s->in;
+    uint16_t out = s->out, match = s->match;
+    uint8_t dist = s->dist, ctrl = s->ctrl, bits = s->bits, head = s->head;
+
+    while (len--) {
+        uint8_t c = 0;
+        if (!match) {
+            if (!bits) {
+                ctrl = data_byte(in++);
+                bits = 8;
+            }
+            bits--;
+            bool literal = ctrl & 1u;
+            ctrl >>= 1;
+            if (literal) {
+                c = data_byte(in++);
+            } else {
+                uint16_t w = pgm_le16(in);
+                in += 2;
+                dist = (uint8_t)(w & wmask);
+                match = (uint16_t)((w >> wbits) + LZ_MIN_MATCH);
+            }
+        }
+        if (match) {
+            c = s->window[(uint8_t)(head - dist - 1u) & (LZ_WINDOW - 1u)];
+            match--;
+        }
+        s->window[head & (LZ_WINDOW - 1u)] = c;
+        head++;
+        if (buf) {
+            *buf++ = c;
+        }
+        if ((++out & bmask) == 0) {
+            bits = 0;      /* next block starts with a fresh control byte */
+            match = 0;
+        }
+    }
+
+    s->in = in;
+    s->out = out;
+    s->match = match;
+    s->dist = dist;
+    s->ctrl = ctrl;
+    s->bits = bits;
+    s->head = head;
+}
+
+static int lz_read(const romfs_file_t *f, const romfs_file_t *tmp,
+                   uint16_t off, uint8_t *buf, uint16_t len) {
+    uint8_t shift = data_byte(tmp->data);
+    uint8_t wbits = data_byte(tmp->data + 1);
+
+    if (wbits > ROMFS_LZ_WINDOW_BITS || shift > 15) {
+        return -1;  /* Image built with a larger window than this decoder */
+    }
+
+    lz_stream_t *s = lz_stream_for(f, off);
+    if (s->file != f || s->out > off || (off >> shift) != (s->out >> shift)) {
+        lz_seek(s, f, tmp, off);
+    }
+    lz_decode(s, wbits, shift, NULL, (uint16_t)(off - s->out));
+    lz_decode(s, wbits, shift, buf, len);
+    return len;
+}
+
+#endif /* ROMFS_LZ_STREAMS > 0 */
+
+const uint8_t *romfs_map(const romfs_file_t *f, uint16_t *len) {
+    romfs_file_t tmp;
+
+    hal_memcpy_P(&tmp, f, sizeof(tmp));
+    if (tmp.flags & ROMFS_FILE_LZ) {
+        return NULL;  /* Only romfs_read() can decode it */
+    }
+    *len = tmp.size;
+#if ROMFS_FAR
+#  if HAL_PGM_FAR
+    if (tmp.data + tmp.size > 0x10000ul) {
+        return NULL;  /* Not reachable through a 16-bit pointer */
+    }
+#  endif
+    return (const uint8_t *)(uintptr_t)tmp.data;
+#else
+    return tmp.data;
+#endif
 }
 
 /**
  * @brief Read from a ROMFS file
  *
- * Copies data from flash/ROM into a RAM buffer.
+ * Copies data from flash/ROM into a RAM buffer, decompressing
+ * ROMFS_FILE_LZ files on the way.
  *
  * @param f Pointer to file descriptor
  * @param off Offset into file (bytes)
@@ -213,21 +396,39 @@ const romfs_file_t *romfs_open(const char *path) {
  * @return Number of bytes actually read
  */
 int romfs_read(const romfs_file_t *f, uint16_t off, void *buf, uint16_t len) {
+    const vfs_iovec_t iov = { buf, len };
+    return romfs_readv(f, off, &iov, 1);
+}
+
+int romfs_readv(const romfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt) {
     romfs_file_t tmp;
+    uint16_t done = 0;
 
     /* Copy file descriptor from program memory to RAM */
     hal_memcpy_P(&tmp, f, sizeof(tmp));
 
-    /* Check bounds */
-    if (off >= tmp.size) {
-        return 0;  /* Offset past end of file */
-    }
-    if (off + len > tmp.size) {
-        len = tmp.size - off;  /* Truncate to EOF */
+    for (uint8_t i = 0; i < cnt && off < tmp.size; i++) {
+        /* Truncate to EOF */
+        uint16_t len = (iov[i].len < (size_t)(tmp.size - off)) ?
+                       (uint16_t)iov[i].len : (uint16_t)(tmp.size - off);
+
+        if (tmp.flags & ROMFS_FILE_LZ) {
+#if ROMFS_LZ_STREAMS > 0
+            /* Consecutive offsets: the decoder stream carries on */
+            int n = lz_read(f, &tmp, off, (uint8_t *)iov[i].base, len);
+            if (n < 0) {
+                return done ? (int)done : -1;
+            }
+            len = (uint16_t)n;
+#else
+            return -1;  /* Compression support not built in */
+#endif
+        } else {
+            /* Copy file data from program memory to RAM */
+            data_copy(iov[i].base, tmp.data + off, len);
+        }
+        off = (uint16_t)(off + len);
+        done = (uint16_t)(done + len);
     }
-
-    /* Copy file data from program memory to RAM */
-    hal_memcpy_P(buf, tmp.data + off, len);
-
-    return len;
+    return done;
 }
@@ -10,10 +10,14 @@
  * Originally designed for AVR (4 bytes per entry), now portable via HAL.
  *
  * ## Design
- * - Directory entries: 4 bytes each
+ * - Directory entries: 5 bytes each on AVR
  * - All metadata stored in flash/ROM (zero RAM overhead)
  * - Path lookups traverse tables directly from flash
  * - Simple hierarchical directory structure
+ * - Directories flagged ROMFS_DIR_SORTED are binary-searched:
+ *   O(log n) entry reads and name compares instead of O(n)
+ * - Files flagged ROMFS_FILE_LZ are LZSS-compressed and decoded on the
+ *   fly by romfs_read() (see COMPRESSED FILES below)
  *
  * ## Memory Footprint
  * - Flash: ~200 bytes code + filesystem data
@@ -51,10 +55,70 @@ extern "C" {
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "vfs_iovec.h"
 
 /*═══════════════════════════════════════════════════════════════════
- * PUBLIC API
- *═══════════════════════════════════════════════════════════════════*/
+ * IMAGE FORMAT
+ *═══════════════════════════════════════════════════════════════════
+ * An image is three PROGMEM tables: file_table[] (romfs_file_t),
+ * dir_table[] (romfs_dir_t) and one romfs_entry_t array per directory,
+ * plus ROMFS_ROOT naming the root entry of dir_table.  romfs.c builds
+ * a small demo image unless ROMFS_IMAGE names a header defining these,
+ * the fs_romfs_image option packs a host directory into one with
+ * scripts/mkromfs.py, or the including file defines them and
+ * ROMFS_ROOT itself.
+ */
+
+/*═══════════════════════════════════════════════════════════════════
+ * FAR IMAGES
+ *═══════════════════════════════════════════════════════════════════
+ * With ROMFS_FAR, romfs_file_t::data is a 32-bit hal_pgm_far_t and all
+ * file data is read with the HAL's far accessors, so assets can sit
+ * anywhere in the 128/256 KB of an ATmega1284/2560.  Directory tables
+ * and names stay near: they are small and placed first.  File data is
+ * declared ROMFS_DATA (HAL_PROGMEM_FAR: after the code).
+ *
+ * C cannot initialise a 32-bit field with a flash address on AVR, so on
+ * HAL_PGM_FAR parts file_table[] is emitted as top-level asm with
+ * ROMFS_FAR_TABLE() / ROMFS_FAR_FILE() / ROMFS_FAR_END rows instead;
+ * scripts/mkromfs.py writes both forms.  Elsewhere ROMFS_ADDR() makes
+ * the usual C initialiser.
+ */
+#ifndef ROMFS_FAR
+#  if defined(CONFIG_FS_ROMFS_FAR)
+#    define ROMFS_FAR CONFIG_FS_ROMFS_FAR
+#  else
+#    define ROMFS_FAR 0
+#  endif
+#endif
+
+#if ROMFS_FAR
+#  include "arch/common/hal.h"
+
+typedef hal_pgm_far_t romfs_addr_t;     /**< Flash byte address of file data */
+#  define ROMFS_DATA      HAL_PROGMEM_FAR __attribute__((used))
+#  define ROMFS_ADDR(sym) ((romfs_addr_t)(uintptr_t)(sym))
+#else
+typedef const uint8_t *romfs_addr_t;    /**< Pointer to file data */
+#  define ROMFS_DATA      HAL_PROGMEM
+#  define ROMFS_ADDR(sym) (sym)
+#endif
+
+#if ROMFS_FAR && HAL_PGM_FAR
+/* file_table[] as asm: a label, then one romfs_file_t row per file */
+#  define ROMFS_FAR_TABLE(sym)                                             \
+    "\t.section .progmem.data." #sym ",\"a\",@progbits\n" #sym ":\n"
+#  define ROMFS_FAR_FILE(sym, size, flags)                                 \
+    "\t.byte lo8(" #sym "), hi8(" #sym "), hh8(" #sym "), 0\n"           \
+    "\t.word " #size "\n\t.byte " #flags "\n"
+#  define ROMFS_FAR_END "\t.previous\n"
+#endif
+
+#define ROMFS_FILE 1u          /**< Entry is a file (idx into file_table) */
+#define ROMFS_DIR  2u          /**< Entry is a directory (idx into dir_table) */
+
+#define ROMFS_DIR_SORTED 0x01u /**< Entries in strcmp() order of name */
+#define ROMFS_FILE_LZ    0x01u /**< File data is an LZSS stream */
 
 /**
  * @brief File descriptor for ROMFS objects
@@ -62,10 +126,85 @@ extern "C" {
  * Describes a file in the ROMFS. All data resides in flash/ROM.
  */
 typedef struct {
-    const uint8_t *data;  /**< Pointer to file data in flash/ROM */
-    uint16_t size;        /**< File size in bytes */
+    romfs_addr_t data;    /**< File data in flash/ROM */
+    uint16_t size;        /**< File size in bytes (uncompressed) */
+    uint8_t flags;        /**< ROMFS_FILE_LZ or 0 */
 } romfs_file_t;
 
+#if ROMFS_FAR && HAL_PGM_FAR
+_Static_assert(sizeof(romfs_file_t) == 7, "ROMFS_FAR_FILE() row layout");
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * COMPRESSED FILES
+ *═══════════════════════════════════════════════════════════════════
+ * A ROMFS_FILE_LZ file's data is
+ *
+ *   uint8_t  block_shift;          checkpoint every 1 << block_shift bytes
+ *   uint8_t  window_bits;          match distance field width (W)
+ *   uint16_t start[nblocks - 1];   little-endian offset of blocks 1.. in
+ *                                  the stream (block 0 starts at 0)
+ *   uint8_t  stream[];
+ *
+ * with nblocks = ceil(size / block).  Each block is compressed on its
+ * own, so decoding can restart at any block boundary: a read at offset
+ * @e off decodes at most one block's worth of bytes it throws away.
+ *
+ * Within a block, a control byte supplies eight flags, LSB first.  A
+ * set flag is one literal byte; a clear flag is a little-endian 16-bit
+ * match: distance - 1 in the low W bits, length - 3 in the rest.  The
+ * decoder keeps the last 1 << W output bytes in a RAM window, so the
+ * image's W must not exceed ROMFS_LZ_WINDOW_BITS.
+ *
+ * romfs_read() keeps ROMFS_LZ_STREAMS decoder states, each remembering
+ * the file and offset it stopped at.  A read that continues where an
+ * earlier one ended (sequential reads through one fd) resumes without
+ * touching the checkpoint table, so give each concurrently-read
+ * compressed file its own stream.  Like the rest of ROMFS the states
+ * are not locked.
+ */
+
+/** Decoder states for compressed files (0 = compression unsupported). */
+#ifndef ROMFS_LZ_STREAMS
+#  if defined(CONFIG_FS_ROMFS_LZ_STREAMS)
+#    define ROMFS_LZ_STREAMS CONFIG_FS_ROMFS_LZ_STREAMS
+#  else
+#    define ROMFS_LZ_STREAMS 1
+#  endif
+#endif
+
+/** Largest window the decoder accepts; each stream holds 1 << this bytes. */
+#ifndef ROMFS_LZ_WINDOW_BITS
+#  define ROMFS_LZ_WINDOW_BITS 6
+#endif
+
+_Static_assert(ROMFS_LZ_WINDOW_BITS >= 1 && ROMFS_LZ_WINDOW_BITS <= 8,
+               "LZ window must be 2..256 bytes");
+
+/**
+ * @brief Directory entry (stored in program memory)
+ *
+ * Each entry describes either a file or a subdirectory.
+ */
+typedef struct {
+    const char *name;  /**< Pointer to name string in program memory */
+    uint8_t type;      /**< ROMFS_FILE or ROMFS_DIR */
+    uint16_t idx;      /**< Index into dir_table or file_table */
+} romfs_entry_t;
+
+/**
+ * @brief Directory descriptor (stored in program memory)
+ */
+typedef struct {
+    const romfs_entry_t *entries;  /**< Entry array in program memory */
+    uint16_t count;                /**< Number of entries */
+    uint8_t flags;                 /**< ROMFS_DIR_SORTED or 0 */
+} romfs_dir_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
 /**
  * @brief Open a file by absolute path
  *
@@ -76,7 +215,7 @@ typedef struct {
  *
  * @note The returned pointer points to static data in flash/ROM.
  * @note Path lookup is case-sensitive.
- * @note Maximum path segment length: 11 characters (+ null terminator).
+ * @note Repeated or trailing '/' are ignored.
  */
 const romfs_file_t *romfs_open(const char *path);
 
@@ -89,14 +228,39 @@ const romfs_file_t *romfs_open(const char *path);
  * @param off Offset into file (bytes)
  * @param buf Destination buffer in RAM
  * @param len Number of bytes to read
- * @return Number of bytes actually read (may be less than `len` if EOF)
+ * @return Number of bytes actually read (may be less than `len` if EOF),
+ *         or -1 for a compressed file this build cannot decode
  *
  * @note If `off` >= file size, returns 0.
  * @note If `off + len` > file size, reads up to EOF.
- * @note On AVR, uses memcpy_P() for flash access.
+ * @note On AVR, uses memcpy_P() (memcpy_PF() with ROMFS_FAR) for flash access.
  */
 int romfs_read(const romfs_file_t *f, uint16_t off, void *buf, uint16_t len);
 
+/**
+ * @brief Read consecutive file bytes into several buffers (cf. preadv(2))
+ *
+ * Fills @p iov in order from @p off with one descriptor fetch, and for a
+ * compressed file one pass of the decoder.
+ *
+ * @return Bytes read in total (short at EOF), or -1 as for romfs_read()
+ */
+int romfs_readv(const romfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt);
+
+/**
+ * @brief Address of a file's data in flash/ROM
+ *
+ * Lets a consumer stream the file straight from program memory instead
+ * of romfs_read()ing it into RAM first.  On AVR the bytes must be read
+ * with hal_pgm_read_byte() and friends.
+ *
+ * @param f   Pointer to file descriptor returned by romfs_open()
+ * @param len Receives the file size in bytes
+ * @return Data address, or NULL for a compressed (ROMFS_FILE_LZ) file
+ *         or, in a far image, one not wholly within the low 64 KB
+ */
+const uint8_t *romfs_map(const romfs_file_t *f, uint16_t *len);
+
 #ifdef __cplusplus
 }
 #endif
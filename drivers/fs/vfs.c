@@ -14,8 +14,64 @@
 
 #include "romfs.h"
 #include "eepfs.h"
+#if CONFIG_FS_BLKDEV_ENABLED
+#  include "blkfs.h"
+#endif
+#include "procfs.h"
+#include "nk_pool.h"
+#include "arch/common/hal.h"
 #include <string.h>
 
+#if VFS_MAX_PIPES > 0 || VFS_POLL || VFS_TASK_FDS > 0
+#  include "kernel/sched/scheduler.h"
+#endif
+#if VFS_TASK_FDS > 0
+#  include "task.h"                     /* NK_MAX_TASKS */
+#endif
+
+/* Filesystems vfs_mount() knows; each defaults to its driver's option */
+#ifndef VFS_ROMFS
+#  define VFS_ROMFS CONFIG_FS_ROMFS_ENABLED
+#endif
+#ifndef VFS_EEPFS
+#  define VFS_EEPFS CONFIG_FS_EEPFS_ENABLED
+#endif
+#ifndef VFS_BLKFS
+#  if defined(CONFIG_FS_BLKDEV_ENABLED)
+#    define VFS_BLKFS CONFIG_FS_BLKDEV_ENABLED
+#  else
+#    define VFS_BLKFS 0
+#  endif
+#endif
+#ifndef VFS_PROCFS
+#  if defined(CONFIG_FS_PROCFS_ENABLED)
+#    define VFS_PROCFS CONFIG_FS_PROCFS_ENABLED
+#  else
+#    define VFS_PROCFS 0
+#  endif
+#endif
+
+#if VFS_POLL
+#  include "kernel/sync/nk_event.h"
+#  define VFS_TTY CONFIG_TTY_ENABLED
+#  define VFS_UDP CONFIG_NET_UDP_ENABLED
+#  define VFS_TCP CONFIG_NET_TCP_ENABLED
+#else
+#  define VFS_TTY 0
+#  define VFS_UDP 0
+#  define VFS_TCP 0
+#endif
+
+#if VFS_TTY
+#  include "drivers/tty/tty.h"
+#endif
+#if VFS_UDP
+#  include "drivers/net/udp.h"
+#endif
+#if VFS_TCP
+#  include "drivers/net/tcp.h"
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * FILESYSTEM OPERATIONS INTERFACE
  *═══════════════════════════════════════════════════════════════════*/
@@ -25,13 +81,23 @@ typedef struct {
     int (*read)(const void *f, uint16_t off, void *buf, uint16_t len);
     int (*write)(const void *f, uint16_t off, const void *buf, uint16_t len);
     uint16_t (*size)(const void *f);
+    void (*close)(const void *f, uint8_t flags);  /**< Optional */
+    int (*sync)(const void *f);                   /**< Optional: flush caches */
+    /** Optional: whole-file address and size; returns VFS_MAP_* or -1 */
+    int (*map)(const void *f, const void **ptr, uint16_t *len);
+    /** Optional: a whole segment list in one pass */
+    int (*readv)(const void *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt);
+    int (*writev)(const void *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt);
+    /** Optional: VFS_POLL* ready now for a descriptor opened with flags */
+    uint8_t (*poll)(const void *f, uint8_t flags);
+    bool stream;                                  /**< No seeking (pipes) */
 } vfs_ops_t;
 
 /*═══════════════════════════════════════════════════════════════════
  * ROMFS OPERATIONS WRAPPER
  *═══════════════════════════════════════════════════════════════════*/
 
-#if CONFIG_FS_ROMFS_ENABLED
+#if VFS_ROMFS
 static const void *romfs_vfs_open(const char *path) {
     return romfs_open(path);
 }
@@ -48,23 +114,35 @@ static int romfs_vfs_write(const void *f, uint16_t off, const void *buf, uint16_
 static uint16_t romfs_vfs_size(const void *f) {
     const romfs_file_t *file = (const romfs_file_t *)f;
     romfs_file_t tmp;
-    memcpy(&tmp, file, sizeof(tmp));  /* Copy from flash */
+    hal_memcpy_P(&tmp, file, sizeof(tmp));  /* Copy from flash */
     return tmp.size;
 }
 
+static int romfs_vfs_readv(const void *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt) {
+    return romfs_readv((const romfs_file_t *)f, off, iov, cnt);
+}
+
+static int romfs_vfs_map(const void *f, const void **ptr, uint16_t *len) {
+    *ptr = romfs_map((const romfs_file_t *)f, len);
+    if (!*ptr) return -1;
+    return HAL_PGM_SEPARATE ? VFS_MAP_PROGMEM : VFS_MAP_RAM;
+}
+
 static const vfs_ops_t romfs_ops = {
     .open = romfs_vfs_open,
     .read = romfs_vfs_read,
     .write = romfs_vfs_write,
-    .size = romfs_vfs_size
+    .size = romfs_vfs_size,
+    .map = romfs_vfs_map,
+    .readv = romfs_vfs_readv
 };
-#endif /* CONFIG_FS_ROMFS_ENABLED */
+#endif /* VFS_ROMFS */
 
 /*═══════════════════════════════════════════════════════════════════
  * EEPFS OPERATIONS WRAPPER
  *═══════════════════════════════════════════════════════════════════*/
 
-#if CONFIG_FS_EEPFS_ENABLED
+#if VFS_EEPFS
 static const void *eepfs_vfs_open(const char *path) {
     return eepfs_open(path);
 }
@@ -77,20 +155,409 @@ static int eepfs_vfs_write(const void *f, uint16_t off, const void *buf, uint16_
     return eepfs_write((const eepfs_file_t *)f, off, buf, len);
 }
 
+static int eepfs_vfs_readv(const void *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt) {
+    return eepfs_readv((const eepfs_file_t *)f, off, iov, cnt);
+}
+
+static int eepfs_vfs_writev(const void *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt) {
+    return eepfs_writev((const eepfs_file_t *)f, off, iov, cnt);
+}
+
 static uint16_t eepfs_vfs_size(const void *f) {
-    const eepfs_file_t *file = (const eepfs_file_t *)f;
-    eepfs_file_t tmp;
-    memcpy(&tmp, file, sizeof(tmp));  /* Copy from flash */
-    return tmp.size;
+    return eepfs_size((const eepfs_file_t *)f);
+}
+
+static int eepfs_vfs_sync(const void *f) {
+    eepfs_fsync((const eepfs_file_t *)f);
+    return 0;
+}
+
+static void eepfs_vfs_close(const void *f, uint8_t flags) {
+    if (flags & (O_WRONLY | O_RDWR)) {
+        eepfs_fsync((const eepfs_file_t *)f);
+    }
 }
 
 static const vfs_ops_t eepfs_ops = {
     .open = eepfs_vfs_open,
     .read = eepfs_vfs_read,
     .write = eepfs_vfs_write,
-    .size = eepfs_vfs_size
+    .size = eepfs_vfs_size,
+    .close = eepfs_vfs_close,
+    .sync = eepfs_vfs_sync,
+    .readv = eepfs_vfs_readv,
+    .writev = eepfs_vfs_writev
+};
+#endif /* VFS_EEPFS */
+
+/*═══════════════════════════════════════════════════════════════════
+ * BLKFS OPERATIONS WRAPPER
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if VFS_BLKFS
+static const void *blkfs_vfs_open(const char *path) {
+    return blkfs_open(path);
+}
+
+static int blkfs_vfs_read(const void *f, uint16_t off, void *buf, uint16_t len) {
+    return blkfs_read((const blkfs_file_t *)f, off, buf, len);
+}
+
+static int blkfs_vfs_write(const void *f, uint16_t off, const void *buf, uint16_t len) {
+    /* Offsets stop at 64 KiB: keep the size from wrapping below */
+    if ((uint32_t)off + len > 0xFFFFu) {
+        len = (uint16_t)(0xFFFFu - off);
+    }
+    return blkfs_write((const blkfs_file_t *)f, off, buf, len);
+}
+
+static uint16_t blkfs_vfs_size(const void *f) {
+    uint32_t size = blkfs_size((const blkfs_file_t *)f);
+    return size > 0xFFFFu ? 0xFFFFu : (uint16_t)size;
+}
+
+static int blkfs_vfs_sync(const void *f) {
+    (void)f;
+    return blkfs_sync();
+}
+
+static void blkfs_vfs_close(const void *f, uint8_t flags) {
+    (void)f;
+    if (flags & (O_WRONLY | O_RDWR)) {
+        blkfs_sync();
+    }
+}
+
+static const vfs_ops_t blkfs_ops = {
+    .open = blkfs_vfs_open,
+    .read = blkfs_vfs_read,
+    .write = blkfs_vfs_write,
+    .size = blkfs_vfs_size,
+    .close = blkfs_vfs_close,
+    .sync = blkfs_vfs_sync
+};
+#endif /* VFS_BLKFS */
+
+/*═══════════════════════════════════════════════════════════════════
+ * PROCFS OPERATIONS WRAPPER
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if VFS_PROCFS
+static int procfs_vfs_write(const void *f, uint16_t off, const void *buf, uint16_t len) {
+    (void)f; (void)off; (void)buf; (void)len;
+    return -1;  /* Counters are read-only */
+}
+
+static const vfs_ops_t procfs_ops = {
+    .open = procfs_open,
+    .read = procfs_read,
+    .write = procfs_vfs_write,
+    .size = procfs_size
+};
+#endif /* VFS_PROCFS */
+
+/*═══════════════════════════════════════════════════════════════════
+ * PIPES
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if VFS_MAX_PIPES > 0
+/*
+ * Power-of-two ring as in drivers/tty/tty.c, but with free-running
+ * indices masked on access, so all VFS_PIPE_BUF bytes are usable and
+ * head - tail is the fill level.  The writer only moves head and the
+ * reader only moves tail.
+ */
+typedef struct {
+    uint8_t          buf[VFS_PIPE_BUF];
+    volatile uint8_t head;      /**< Next byte to write (free-running) */
+    volatile uint8_t tail;      /**< Next byte to read (free-running) */
+    uint8_t          readers;   /**< Open read ends */
+    uint8_t          writers;   /**< Open write ends */
+    nk_waitq_t       rq;        /**< Reader waiting for data */
+    nk_waitq_t       wq;        /**< Writer waiting for space */
+} vfs_pipe_t;
+
+#define PIPE_MASK (VFS_PIPE_BUF - 1u)
+
+NK_POOL_DEFINE(vfs_pipes, vfs_pipe_t, VFS_MAX_PIPES);
+
+static inline uint8_t pipe_used(const vfs_pipe_t *p) {
+    return (uint8_t)(p->head - p->tail);
+}
+
+/* Wake the other end if it sleeps on @p wq, and any poller. */
+static void pipe_wake(nk_waitq_t *wq) {
+    hal_memory_barrier();
+#if VFS_POLL
+    nk_io_notify(NK_IO_PIPE);
+#endif
+    if (*wq) {
+        uint32_t s = nk_sched_lock();
+        nk_waitq_wake_one(wq);
+        nk_sched_unlock(s);
+    }
+}
+
+static int pipe_read(const void *f, uint16_t off, void *buf, uint16_t len) {
+    vfs_pipe_t *p = (vfs_pipe_t *)f;
+    (void)off;
+
+    uint8_t avail;
+    for (;;) {
+        if ((avail = pipe_used(p)) != 0 || p->writers == 0 || len == 0) break;
+        uint32_t s = nk_sched_lock();
+        if (pipe_used(p) == 0 && p->writers) {
+            nk_waitq_block(&p->rq);
+        } else {
+            nk_sched_unlock(s);
+        }
+    }
+
+    uint8_t n = (uint8_t)(len < avail ? len : avail);
+    uint8_t at = (uint8_t)(p->tail & PIPE_MASK);
+    uint8_t first = (uint8_t)(VFS_PIPE_BUF - at);      /* up to the end */
+    if (first > n) first = n;
+    memcpy(buf, &p->buf[at], first);
+    memcpy((uint8_t *)buf + first, p->buf, (size_t)(n - first));
+    hal_memory_barrier();
+    p->tail = (uint8_t)(p->tail + n);
+
+    pipe_wake(&p->wq);
+    return n;
+}
+
+static int pipe_write(const void *f, uint16_t off, const void *buf, uint16_t len) {
+    vfs_pipe_t *p = (vfs_pipe_t *)f;
+    const uint8_t *src = (const uint8_t *)buf;
+    uint16_t done = 0;
+    (void)off;
+
+    while (done < len) {
+        if (p->readers == 0) {
+            return done ? (int)done : -1;              /* EPIPE */
+        }
+        uint8_t space = (uint8_t)(VFS_PIPE_BUF - pipe_used(p));
+        if (space == 0) {
+            uint32_t s = nk_sched_lock();
+            if (pipe_used(p) == VFS_PIPE_BUF && p->readers) {
+                nk_waitq_block(&p->wq);
+            } else {
+                nk_sched_unlock(s);
+            }
+            continue;
+        }
+
+        uint16_t want = (uint16_t)(len - done);
+        uint8_t n = (uint8_t)(want < space ? want : space);
+        uint8_t at = (uint8_t)(p->head & PIPE_MASK);
+        uint8_t first = (uint8_t)(VFS_PIPE_BUF - at);
+        if (first > n) first = n;
+        memcpy(&p->buf[at], src + done, first);
+        memcpy(p->buf, src + done + first, (size_t)(n - first));
+        hal_memory_barrier();
+        p->head = (uint8_t)(p->head + n);
+        done = (uint16_t)(done + n);
+
+        pipe_wake(&p->rq);
+    }
+    return (int)done;
+}
+
+static uint16_t pipe_size(const void *f) {
+    return pipe_used((const vfs_pipe_t *)f);
+}
+
+static void pipe_close(const void *f, uint8_t flags) {
+    vfs_pipe_t *p = (vfs_pipe_t *)f;
+    uint32_t s = nk_sched_lock();
+    if (flags & O_WRONLY) {
+        p->writers--;
+        nk_waitq_wake_all(&p->rq);     /* readers may now see EOF */
+    } else {
+        p->readers--;
+        nk_waitq_wake_all(&p->wq);     /* writers may now see EPIPE */
+    }
+    bool last = (p->readers == 0 && p->writers == 0);
+    nk_sched_unlock(s);
+#if VFS_POLL
+    nk_io_notify(NK_IO_PIPE);
+#endif
+    if (last) {
+        nk_pool_free(&vfs_pipes, p);
+    }
+}
+
+/* A write end without readers is "ready": vfs_write() fails at once */
+static uint8_t pipe_poll(const void *f, uint8_t flags) {
+    const vfs_pipe_t *p = (const vfs_pipe_t *)f;
+
+    if (flags & O_WRONLY) {
+        if (!p->readers) return VFS_POLLOUT | VFS_POLLERR;
+        return pipe_used(p) < VFS_PIPE_BUF ? VFS_POLLOUT : 0;
+    }
+    if (!p->writers) return VFS_POLLIN | VFS_POLLHUP;   /* EOF */
+    return pipe_used(p) ? VFS_POLLIN : 0;
+}
+
+static const vfs_ops_t pipe_ops = {
+    .read = pipe_read,
+    .write = pipe_write,
+    .size = pipe_size,
+    .close = pipe_close,
+    .poll = pipe_poll,
+    .stream = true
+};
+#endif /* VFS_MAX_PIPES > 0 */
+
+/*═══════════════════════════════════════════════════════════════════
+ * DEVICE DESCRIPTORS (TTY, SOCKETS)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if VFS_TTY
+static int tty_vfs_read(const void *f, uint16_t off, void *buf, uint16_t len) {
+    (void)off;
+    return tty_read((tty_t *)f, (uint8_t *)buf, len);
+}
+
+static int tty_vfs_write(const void *f, uint16_t off, const void *buf, uint16_t len) {
+    (void)off;
+    return tty_write((tty_t *)f, (const uint8_t *)buf, len);
+}
+
+static uint16_t tty_vfs_size(const void *f) {
+    return (uint16_t)tty_rx_available((const tty_t *)f);
+}
+
+static uint8_t tty_vfs_poll(const void *f, uint8_t flags) {
+    const tty_t *t = (const tty_t *)f;
+    (void)flags;
+    return (uint8_t)((tty_rx_available(t) ? VFS_POLLIN : 0) |
+                     (tty_tx_free(t) ? VFS_POLLOUT : 0));
+}
+
+static const vfs_ops_t tty_ops = {
+    .read = tty_vfs_read,
+    .write = tty_vfs_write,
+    .size = tty_vfs_size,
+    .poll = tty_vfs_poll,
+    .stream = true
+};
+#endif
+
+#if VFS_UDP || VFS_TCP
+/* Socket handles are small ints; stored off by one so none is NULL */
+static inline const void *sock_file(int s) {
+    return (const void *)(uintptr_t)(s + 1);
+}
+
+static inline int sock_of(const void *f) {
+    return (int)((uintptr_t)f - 1u);
+}
+
+static uint16_t sock_vfs_size(const void *f) {
+    (void)f;
+    return 0;
+}
+#endif
+
+#if VFS_UDP
+static int udp_vfs_read(const void *f, uint16_t off, void *buf, uint16_t len) {
+    (void)off;
+    return udp_recvfrom(sock_of(f), buf, len, NULL, NULL);
+}
+
+static int udp_vfs_write(const void *f, uint16_t off, const void *buf, uint16_t len) {
+    (void)f; (void)off; (void)buf; (void)len;
+    return -1;  /* no destination: use udp_sendto() */
+}
+
+static uint8_t udp_vfs_poll(const void *f, uint8_t flags) {
+    (void)flags;
+    return udp_pending(sock_of(f)) > 0 ? VFS_POLLIN : 0;
+}
+
+static void udp_vfs_close(const void *f, uint8_t flags) {
+    (void)flags;
+    udp_close(sock_of(f));
+}
+
+static const vfs_ops_t udp_ops = {
+    .read = udp_vfs_read,
+    .write = udp_vfs_write,
+    .size = sock_vfs_size,
+    .close = udp_vfs_close,
+    .poll = udp_vfs_poll,
+    .stream = true
+};
+#endif
+
+#if VFS_TCP
+static int tcp_vfs_read(const void *f, uint16_t off, void *buf, uint16_t len) {
+    (void)off;
+    return tcp_recv(sock_of(f), buf, len);
+}
+
+static int tcp_vfs_write(const void *f, uint16_t off, const void *buf, uint16_t len) {
+    (void)off;
+    return tcp_send(sock_of(f), buf, len);
+}
+
+static uint8_t tcp_vfs_poll(const void *f, uint8_t flags) {
+    int c = sock_of(f);
+    uint8_t r = 0;
+    (void)flags;
+
+    if (tcp_readable(c)) r |= VFS_POLLIN;
+    if (tcp_sndbuf(c)) r |= VFS_POLLOUT;
+    if (tcp_state(c) == TCP_CLOSED || tcp_reset(c)) r |= VFS_POLLHUP;
+    return r;
+}
+
+static void tcp_vfs_close(const void *f, uint8_t flags) {
+    (void)flags;
+    tcp_close(sock_of(f));
+}
+
+static const vfs_ops_t tcp_ops = {
+    .read = tcp_vfs_read,
+    .write = tcp_vfs_write,
+    .size = sock_vfs_size,
+    .close = tcp_vfs_close,
+    .poll = tcp_vfs_poll,
+    .stream = true
 };
-#endif /* CONFIG_FS_EEPFS_ENABLED */
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * DISPATCH
+ *═══════════════════════════════════════════════════════════════════*/
+
+/*
+ * With one filesystem compiled in and no pipes or device descriptors,
+ * every mount and fd would point at the same table, so none stores it:
+ * VFS_OPS() names the table itself.  Its members are then constants the
+ * compiler turns into direct (inlinable) calls, and tests for missing
+ * optional members fold away.  Otherwise VFS_OPS() loads the pointer.
+ */
+#if VFS_MAX_PIPES == 0 && !VFS_TTY && !VFS_UDP && !VFS_TCP && \
+    VFS_ROMFS + VFS_EEPFS + VFS_BLKFS + VFS_PROCFS == 1
+#  define VFS_SOLE 1
+#  if VFS_ROMFS
+#    define VFS_SOLE_OPS romfs_ops
+#  elif VFS_EEPFS
+#    define VFS_SOLE_OPS eepfs_ops
+#  elif VFS_PROCFS
+#    define VFS_SOLE_OPS procfs_ops
+#  else
+#    define VFS_SOLE_OPS blkfs_ops
+#  endif
+#  define VFS_OPS(x)        (&VFS_SOLE_OPS)
+#  define VFS_SET_OPS(x, o) ((void)(x), (void)(o))
+#else
+#  define VFS_SOLE 0
+#  define VFS_OPS(x)        ((x)->ops)
+#  define VFS_SET_OPS(x, o) ((x)->ops = (o))
+#endif
 
 /*═══════════════════════════════════════════════════════════════════
  * VFS INTERNAL STATE
@@ -99,34 +566,102 @@ static const vfs_ops_t eepfs_ops = {
 typedef struct {
     char path[16];
     vfs_type_t type;
+#if !VFS_SOLE
     const vfs_ops_t *ops;
+#endif
 } vfs_mount_t;
 
 typedef struct {
     const void *fs_file;
+#if !VFS_SOLE
     const vfs_ops_t *ops;
+#endif
     uint16_t position;
     uint8_t flags;
-    bool in_use;
+#if VFS_TASK_FDS > 0
+    volatile uint8_t refs;              /**< Task descriptors naming it */
+#endif
+#if VFS_READAHEAD > 0
+    uint16_t ra_off;                    /**< File offset of ra_buf[0] */
+    uint8_t  ra_len;                    /**< Valid bytes in ra_buf */
+    uint8_t  ra_buf[VFS_READAHEAD];
+#endif
 } vfs_fd_t;
 
 static struct {
     vfs_mount_t mounts[VFS_MAX_MOUNTS];
-    vfs_fd_t fds[VFS_MAX_FDS];
     bool initialized;
 } vfs_state;
 
+/* Open files; without per-task tables, descriptor number == slot index */
+NK_POOL_DEFINE(vfs_fds, vfs_fd_t, VFS_MAX_FDS);
+
+#if VFS_TASK_FDS > 0
+/*
+ * Per-task descriptor tables.  A descriptor is a bit in its task's map
+ * plus the vfs_fds slot it names; the open file counts the descriptors
+ * naming it.  Bits are claimed and dropped with atomic or/and (as in
+ * nk_pool), so vfs_dup_to() can fill another task's table while that
+ * task opens files of its own.
+ */
+#  if VFS_TASK_FDS <= 8
+typedef uint8_t vfs_fdmap_t;
+#    define FDMAP_OR  hal_atomic_fetch_or_u8
+#    define FDMAP_AND hal_atomic_fetch_and_u8
+#  elif VFS_TASK_FDS <= 16
+typedef uint16_t vfs_fdmap_t;
+#    define FDMAP_OR  hal_atomic_fetch_or_u16
+#    define FDMAP_AND hal_atomic_fetch_and_u16
+#  else
+typedef uint32_t vfs_fdmap_t;
+#    define FDMAP_OR  hal_atomic_fetch_or_u32
+#    define FDMAP_AND hal_atomic_fetch_and_u32
+#  endif
+#  define FDMAP_ALL ((vfs_fdmap_t)((2ull << (VFS_TASK_FDS - 1)) - 1u))
+
+static struct {
+    volatile vfs_fdmap_t used;
+    uint8_t              file[VFS_TASK_FDS];   /**< vfs_fds slot per fd */
+} vfs_task[NK_MAX_TASKS];
+#endif
+
+#if VFS_PATH_CACHE > 0
+/*
+ * Resolved paths, most recently used first.  Filesystem handles point
+ * into static tables (flash or RAM), so they stay valid for as long
+ * as the mount does.
+ */
+typedef struct {
+    uint32_t    hash;       /**< FNV-1a of the full path */
+    const void *fs_file;    /**< Handle from ops->open() */
+    uint8_t     mount;      /**< Index into vfs_state.mounts */
+} vfs_pcache_t;
+
+static struct {
+    vfs_pcache_t ent[VFS_PATH_CACHE];
+    uint8_t      used;
+    uint16_t     hits;
+    uint16_t     misses;
+} vfs_pcache;
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * HELPER: GET OPERATIONS FOR FILESYSTEM TYPE
  *═══════════════════════════════════════════════════════════════════*/
 
 static const vfs_ops_t *get_ops(vfs_type_t type) {
     switch (type) {
-#if CONFIG_FS_ROMFS_ENABLED
+#if VFS_ROMFS
         case VFS_TYPE_ROMFS: return &romfs_ops;
 #endif
-#if CONFIG_FS_EEPFS_ENABLED
+#if VFS_EEPFS
         case VFS_TYPE_EEPFS: return &eepfs_ops;
+#endif
+#if VFS_BLKFS
+        case VFS_TYPE_BLKFS: return &blkfs_ops;
+#endif
+#if VFS_PROCFS
+        case VFS_TYPE_PROCFS: return &procfs_ops;
 #endif
         default: return NULL;
     }
@@ -154,19 +689,162 @@ static vfs_mount_t *find_mount(const char *path, const char **fs_path) {
     return NULL;
 }
 
-static int alloc_fd(void) {
-    for (int i = 0; i < VFS_MAX_FDS; i++) {
-        if (!vfs_state.fds[i].in_use) return i;
+/*═══════════════════════════════════════════════════════════════════
+ * HELPER: PATH CACHE
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if VFS_PATH_CACHE > 0
+static uint32_t path_hash(const char *path) {
+    uint32_t h = 2166136261u;
+    while (*path) {
+        h = (h ^ (uint8_t)*path++) * 16777619u;
+    }
+    return h;
+}
+
+/* Cached handle for @p hash, moved to the front; NULL on a miss. */
+static const void *pcache_find(uint32_t hash, vfs_mount_t **mount) {
+    for (uint8_t i = 0; i < vfs_pcache.used; i++) {
+        if (vfs_pcache.ent[i].hash == hash) {
+            vfs_pcache_t e = vfs_pcache.ent[i];
+            memmove(&vfs_pcache.ent[1], &vfs_pcache.ent[0], i * sizeof(e));
+            vfs_pcache.ent[0] = e;
+            vfs_pcache.hits++;
+            *mount = &vfs_state.mounts[e.mount];
+            return e.fs_file;
+        }
+    }
+    vfs_pcache.misses++;
+    return NULL;
+}
+
+/* Insert at the front, dropping the least recently used entry. */
+static void pcache_add(uint32_t hash, const vfs_mount_t *mount, const void *fs_file) {
+    uint8_t n = vfs_pcache.used < VFS_PATH_CACHE ? vfs_pcache.used++ : VFS_PATH_CACHE - 1;
+    memmove(&vfs_pcache.ent[1], &vfs_pcache.ent[0], n * sizeof(vfs_pcache.ent[0]));
+    vfs_pcache.ent[0].hash = hash;
+    vfs_pcache.ent[0].fs_file = fs_file;
+    vfs_pcache.ent[0].mount = (uint8_t)(mount - vfs_state.mounts);
+}
+
+static inline void pcache_flush(void) {
+    vfs_pcache.used = 0;
+}
+#else
+static inline void pcache_flush(void) {}
+#endif
+
+/* Open file in pool slot @p i, or NULL */
+static inline vfs_fd_t *file_at(int i) {
+    return (vfs_fd_t *)nk_pool_at(&vfs_fds, i);
+}
+
+#if VFS_TASK_FDS > 0
+static inline vfs_fd_t *get_fd(int fd) {
+    if ((unsigned)fd >= VFS_TASK_FDS) return NULL;
+    uint8_t tid = nk_current_tid();
+    if (!(vfs_task[tid].used & (vfs_fdmap_t)((vfs_fdmap_t)1 << fd))) return NULL;
+    return file_at(vfs_task[tid].file[fd]);
+}
+
+/* Lowest free descriptor of @p tid, now naming @p f; -1 if none */
+static int fd_install(uint8_t tid, vfs_fd_t *f) {
+    volatile vfs_fdmap_t *m = &vfs_task[tid].used;
+    vfs_fdmap_t freeb;
+
+    /* Retry if another installer took the bit between scan and claim */
+    while ((freeb = (vfs_fdmap_t)(~*m & FDMAP_ALL)) != 0) {
+        vfs_fdmap_t bit = (vfs_fdmap_t)(freeb & -freeb);
+        if (!(FDMAP_OR(m, bit) & bit)) {
+            int fd = __builtin_ctz(bit);
+            vfs_task[tid].file[fd] = (uint8_t)nk_pool_index(&vfs_fds, f);
+            return fd;
+        }
     }
     return -1;
 }
 
+/* Descriptor for the freshly set-up open file @p f; frees it on failure */
+static int fd_new(vfs_fd_t *f) {
+    f->refs = 1;
+    int fd = fd_install(nk_current_tid(), f);
+    if (fd < 0) nk_pool_free(&vfs_fds, f);
+    return fd;
+}
+
+/* Forget descriptor @p fd of the calling task, not the file behind it */
+static inline void fd_forget(int fd) {
+    FDMAP_AND(&vfs_task[nk_current_tid()].used, (vfs_fdmap_t)~((vfs_fdmap_t)1 << fd));
+}
+#else
+static inline vfs_fd_t *get_fd(int fd) {
+    return file_at(fd);
+}
+
+static inline int fd_new(vfs_fd_t *f) {
+    return nk_pool_index(&vfs_fds, f);
+}
+
+static inline void fd_forget(int fd) { (void)fd; }
+#endif
+
+/* Drop one reference to @p f; the last closes it in its backend */
+static void file_put(vfs_fd_t *f) {
+#if VFS_TASK_FDS > 0
+    if (hal_atomic_fetch_sub_u8(&f->refs, 1) != 1) return;
+#endif
+    if (VFS_OPS(f)->close) VFS_OPS(f)->close(f->fs_file, f->flags);
+    f->fs_file = NULL;
+    VFS_SET_OPS(f, NULL);
+    nk_pool_free(&vfs_fds, f);
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * HELPER: READAHEAD
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if VFS_READAHEAD > 0
+/* Bytes buffered at the fd's position (0 if it lies outside ra_buf). */
+static inline uint8_t ra_avail(const vfs_fd_t *f) {
+    uint16_t at = (uint16_t)(f->position - f->ra_off);
+    return at < f->ra_len ? (uint8_t)(f->ra_len - at) : 0;
+}
+
+/* Refill from the fd's position; the backend's result (0 at EOF). */
+static int ra_fill(vfs_fd_t *f) {
+    int n = VFS_OPS(f)->read(f->fs_file, f->position, f->ra_buf, VFS_READAHEAD);
+    f->ra_off = f->position;
+    f->ra_len = n > 0 ? (uint8_t)n : 0;
+    return n;
+}
+
+/* Drop every buffer holding data of @p fs_file, which is changing. */
+static void ra_drop(const void *fs_file) {
+    for (int i = 0; i < VFS_MAX_FDS; i++) {
+        vfs_fd_t *f = file_at(i);
+        if (f && f->fs_file == fs_file) f->ra_len = 0;
+    }
+}
+#else
+static inline void ra_drop(const void *fs_file) { (void)fs_file; }
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API
  *═══════════════════════════════════════════════════════════════════*/
 
 void vfs_init(void) {
     memset(&vfs_state, 0, sizeof(vfs_state));
+#if VFS_PATH_CACHE > 0
+    memset(&vfs_pcache, 0, sizeof(vfs_pcache));
+#endif
+    nk_pool_reset(&vfs_fds);
+#if VFS_MAX_PIPES > 0
+    nk_pool_reset(&vfs_pipes);
+#endif
+#if VFS_TASK_FDS > 0
+    memset((void *)vfs_task, 0, sizeof(vfs_task));
+#endif
     vfs_state.initialized = true;
 }
 
@@ -188,7 +866,8 @@ int vfs_mount(vfs_type_t type, const char *path) {
             strncpy(vfs_state.mounts[i].path, path, sizeof(vfs_state.mounts[i].path) - 1);
             vfs_state.mounts[i].path[sizeof(vfs_state.mounts[i].path) - 1] = '\0';
             vfs_state.mounts[i].type = type;
-            vfs_state.mounts[i].ops = ops;
+            VFS_SET_OPS(&vfs_state.mounts[i], ops);
+            pcache_flush();     /* may shadow paths under another mount */
             return 0;
         }
     }
@@ -202,16 +881,17 @@ int vfs_unmount(const char *path) {
         if (vfs_state.mounts[i].type != VFS_TYPE_NONE &&
             strcmp(vfs_state.mounts[i].path, path) == 0) {
 
-            for (int fd = 0; fd < VFS_MAX_FDS; fd++) {
-                if (vfs_state.fds[fd].in_use &&
-                    vfs_state.fds[fd].ops == vfs_state.mounts[i].ops) {
+            for (int j = 0; j < VFS_MAX_FDS; j++) {
+                vfs_fd_t *f = file_at(j);
+                if (f && VFS_OPS(f) == VFS_OPS(&vfs_state.mounts[i])) {
                     return -1;
                 }
             }
 
             vfs_state.mounts[i].type = VFS_TYPE_NONE;
-            vfs_state.mounts[i].ops = NULL;
+            VFS_SET_OPS(&vfs_state.mounts[i], NULL);
             vfs_state.mounts[i].path[0] = '\0';
+            pcache_flush();
             return 0;
         }
     }
@@ -221,50 +901,133 @@ int vfs_unmount(const char *path) {
 int vfs_open(const char *path, int flags) {
     if (!vfs_state.initialized) return -1;
 
-    const char *fs_path;
-    vfs_mount_t *mount = find_mount(path, &fs_path);
-    if (!mount) return -1;
+    vfs_mount_t *mount = NULL;
+    const void *fs_file = NULL;
+#if VFS_PATH_CACHE > 0
+    uint32_t hash = path ? path_hash(path) : 0;
+    if (path) fs_file = pcache_find(hash, &mount);
+#endif
 
-    const void *fs_file = mount->ops->open(fs_path);
-    if (!fs_file) return -1;
+    if (!fs_file) {
+        const char *fs_path;
+        mount = find_mount(path, &fs_path);
+        if (!mount) return -1;
 
-    int fd = alloc_fd();
-    if (fd < 0) return -1;
+        fs_file = VFS_OPS(mount)->open(fs_path);
+        if (!fs_file) return -1;
+#if VFS_PATH_CACHE > 0
+        pcache_add(hash, mount, fs_file);
+#endif
+    }
 
-    vfs_state.fds[fd].fs_file = fs_file;
-    vfs_state.fds[fd].ops = mount->ops;
-    vfs_state.fds[fd].position = 0;
-    vfs_state.fds[fd].flags = (uint8_t)flags;
-    vfs_state.fds[fd].in_use = true;
+    vfs_fd_t *f = NK_POOL_ALLOC(vfs_fds);
+    if (!f) return -1;
 
-    return fd;
+    f->fs_file = fs_file;
+    VFS_SET_OPS(f, VFS_OPS(mount));
+    f->position = 0;
+    f->flags = (uint8_t)flags;
+#if VFS_READAHEAD > 0
+    f->ra_len = 0;
+#endif
+
+    return fd_new(f);
 }
 
 int vfs_read(int fd, void *buf, size_t count) {
-    if (fd < 0 || fd >= VFS_MAX_FDS || !vfs_state.fds[fd].in_use) return -1;
-
-    vfs_fd_t *f = &vfs_state.fds[fd];
-    int nread = f->ops->read(f->fs_file, f->position, buf, (uint16_t)count);
+    vfs_fd_t *f = get_fd(fd);
+    if (!f) return -1;
+#if VFS_READAHEAD > 0
+    if (!VFS_OPS(f)->stream && count < VFS_READAHEAD) {
+        uint8_t n = ra_avail(f);
+        if (n == 0) {
+            int r = count ? ra_fill(f) : 0;
+            if (r <= 0) return r;
+            n = f->ra_len;
+        }
+        if (n > count) n = (uint8_t)count;
+        memcpy(buf, &f->ra_buf[f->position - f->ra_off], n);
+        f->position += n;
+        return n;
+    }
+#endif
+    int nread = VFS_OPS(f)->read(f->fs_file, f->position, buf, (uint16_t)count);
     if (nread > 0) f->position += (uint16_t)nread;
     return nread;
 }
 
-int vfs_write(int fd, const void *buf, size_t count) {
-    if (fd < 0 || fd >= VFS_MAX_FDS || !vfs_state.fds[fd].in_use) return -1;
+int vfs_getc(int fd) {
+#if VFS_READAHEAD > 0
+    vfs_fd_t *f = get_fd(fd);
+    if (f && !VFS_OPS(f)->stream && (ra_avail(f) || ra_fill(f) > 0)) {
+        return f->ra_buf[f->position++ - f->ra_off];
+    }
+    if (f && !VFS_OPS(f)->stream) return -1;     /* EOF */
+#endif
+    uint8_t c;
+    return vfs_read(fd, &c, 1) == 1 ? c : -1;
+}
 
-    vfs_fd_t *f = &vfs_state.fds[fd];
+int vfs_write(int fd, const void *buf, size_t count) {
+    vfs_fd_t *f = get_fd(fd);
+    if (!f) return -1;
     if ((f->flags & O_WRONLY) == 0 && (f->flags & O_RDWR) == 0) return -1;
 
-    int nwritten = f->ops->write(f->fs_file, f->position, buf, (uint16_t)count);
+    if (!VFS_OPS(f)->stream) ra_drop(f->fs_file);
+    int nwritten = VFS_OPS(f)->write(f->fs_file, f->position, buf, (uint16_t)count);
     if (nwritten > 0) f->position += (uint16_t)nwritten;
     return nwritten;
 }
 
-int vfs_lseek(int fd, int offset, int whence) {
-    if (fd < 0 || fd >= VFS_MAX_FDS || !vfs_state.fds[fd].in_use) return -1;
+int vfs_readv(int fd, const vfs_iovec_t *iov, int iovcnt) {
+    vfs_fd_t *f = get_fd(fd);
+    if (!f || (!iov && iovcnt) || iovcnt < 0 || iovcnt > VFS_IOV_MAX) return -1;
+
+    if (VFS_OPS(f)->readv) {
+        int n = VFS_OPS(f)->readv(f->fs_file, f->position, iov, (uint8_t)iovcnt);
+        if (n > 0) f->position += (uint16_t)n;
+        return n;
+    }
 
-    vfs_fd_t *f = &vfs_state.fds[fd];
-    uint16_t size = f->ops->size(f->fs_file);
+    /* Fallback: one read per segment until one comes up short */
+    int total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        int n = VFS_OPS(f)->read(f->fs_file, f->position, iov[i].base, (uint16_t)iov[i].len);
+        if (n < 0) return total ? total : -1;
+        f->position += (uint16_t)n;
+        total += n;
+        if ((size_t)n < iov[i].len) break;
+    }
+    return total;
+}
+
+int vfs_writev(int fd, const vfs_iovec_t *iov, int iovcnt) {
+    vfs_fd_t *f = get_fd(fd);
+    if (!f || (!iov && iovcnt) || iovcnt < 0 || iovcnt > VFS_IOV_MAX) return -1;
+    if ((f->flags & O_WRONLY) == 0 && (f->flags & O_RDWR) == 0) return -1;
+
+    if (!VFS_OPS(f)->stream) ra_drop(f->fs_file);
+    if (VFS_OPS(f)->writev) {
+        int n = VFS_OPS(f)->writev(f->fs_file, f->position, iov, (uint8_t)iovcnt);
+        if (n > 0) f->position += (uint16_t)n;
+        return n;
+    }
+
+    int total = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        int n = VFS_OPS(f)->write(f->fs_file, f->position, iov[i].base, (uint16_t)iov[i].len);
+        if (n < 0) return total ? total : -1;
+        f->position += (uint16_t)n;
+        total += n;
+        if ((size_t)n < iov[i].len) break;
+    }
+    return total;
+}
+
+int vfs_lseek(int fd, int offset, int whence) {
+    vfs_fd_t *f = get_fd(fd);
+    if (!f || VFS_OPS(f)->stream) return -1;
+    uint16_t size = VFS_OPS(f)->size(f->fs_file);
     int new_pos = 0;
 
     switch (whence) {
@@ -281,14 +1044,211 @@ int vfs_lseek(int fd, int offset, int whence) {
     return new_pos;
 }
 
+int vfs_fsync(int fd) {
+    vfs_fd_t *f = get_fd(fd);
+    if (!f) return -1;
+    return VFS_OPS(f)->sync ? VFS_OPS(f)->sync(f->fs_file) : 0;
+}
+
+int vfs_map(int fd, const void **ptr, size_t *len) {
+    vfs_fd_t *f = get_fd(fd);
+    if (!f || !ptr || !len || !VFS_OPS(f)->map) return -1;
+
+    const void *base;
+    uint16_t size;
+    int kind = VFS_OPS(f)->map(f->fs_file, &base, &size);
+    if (kind < 0) return -1;
+
+    uint16_t pos = f->position < size ? f->position : size;
+    *ptr = (const uint8_t *)base + pos;
+    *len = (size_t)(size - pos);
+    return kind;
+}
+
 int vfs_close(int fd) {
-    if (fd < 0 || fd >= VFS_MAX_FDS || !vfs_state.fds[fd].in_use) return -1;
-    vfs_state.fds[fd].in_use = false;
-    vfs_state.fds[fd].fs_file = NULL;
-    vfs_state.fds[fd].ops = NULL;
+    vfs_fd_t *f = get_fd(fd);
+    if (!f) return -1;
+    fd_forget(fd);
+    file_put(f);
+    return 0;
+}
+
+#if VFS_TASK_FDS > 0
+int vfs_dup_to(int fd, uint8_t tid) {
+    vfs_fd_t *f = get_fd(fd);
+    if (!f || tid >= NK_MAX_TASKS) return -1;
+
+    hal_atomic_fetch_add_u8(&f->refs, 1);
+    int nfd = fd_install(tid, f);
+    if (nfd < 0) file_put(f);           /* cannot be the last reference */
+    return nfd;
+}
+
+int vfs_dup(int fd) {
+    return vfs_dup_to(fd, nk_current_tid());
+}
+
+int vfs_close_task(uint8_t tid) {
+    if (tid >= NK_MAX_TASKS) return -1;
+
+    vfs_fdmap_t m = FDMAP_AND(&vfs_task[tid].used, 0);
+    int n = 0;
+    for (; m; m &= (vfs_fdmap_t)(m - 1), n++) {
+        file_put(file_at(vfs_task[tid].file[__builtin_ctz(m)]));
+    }
+    return n;
+}
+
+/* Strong override of the scheduler's weak hook */
+void nk_task_exit_hook(uint8_t tid) {
+    (void)vfs_close_task(tid);
+}
+#else
+int vfs_dup(int fd) {
+    (void)fd;
+    return -1;
+}
+
+int vfs_dup_to(int fd, uint8_t tid) {
+    (void)fd; (void)tid;
+    return -1;
+}
+
+int vfs_close_task(uint8_t tid) {
+    (void)tid;
+    return 0;
+}
+#endif
+
+int vfs_pipe(int fds[2]) {
+#if VFS_MAX_PIPES > 0
+    if (!vfs_state.initialized || !fds) return -1;
+
+    vfs_pipe_t *p = NK_POOL_ALLOC(vfs_pipes);
+    if (!p) return -1;
+    vfs_fd_t *r = NK_POOL_ALLOC(vfs_fds);
+    vfs_fd_t *w = r ? NK_POOL_ALLOC(vfs_fds) : NULL;
+    if (!w) {
+        if (r) nk_pool_free(&vfs_fds, r);
+        nk_pool_free(&vfs_pipes, p);
+        return -1;
+    }
+
+    memset(p, 0, sizeof(*p));
+    p->readers = 1;
+    p->writers = 1;
+    *r = (vfs_fd_t){ .fs_file = p, .ops = &pipe_ops, .flags = O_RDONLY };
+    *w = (vfs_fd_t){ .fs_file = p, .ops = &pipe_ops, .flags = O_WRONLY };
+    fds[0] = fd_new(r);
+    fds[1] = fds[0] < 0 ? -1 : fd_new(w);
+    if (fds[1] < 0) {
+        /* fd_new() freed whichever end it could not place */
+        if (fds[0] >= 0) {
+            fd_forget(fds[0]);
+            nk_pool_free(&vfs_fds, r);
+        } else {
+            nk_pool_free(&vfs_fds, w);
+        }
+        nk_pool_free(&vfs_pipes, p);
+        return -1;
+    }
     return 0;
+#else
+    (void)fds;
+    return -1;
+#endif
+}
+
+#if VFS_TTY || VFS_UDP || VFS_TCP
+/* A descriptor for @p file behind @p ops, or -1 */
+static int fd_attach(const void *file, const vfs_ops_t *ops, int flags) {
+    if (!vfs_state.initialized) return -1;
+
+    vfs_fd_t *f = NK_POOL_ALLOC(vfs_fds);
+    if (!f) return -1;
+    *f = (vfs_fd_t){ .fs_file = file, .ops = ops, .flags = (uint8_t)flags };
+    return fd_new(f);
+}
+#endif
+
+int vfs_open_tty(struct tty_s *t, int flags) {
+#if VFS_TTY
+    if (!t) return -1;
+    return fd_attach(t, &tty_ops, flags);
+#else
+    (void)t; (void)flags;
+    return -1;
+#endif
+}
+
+int vfs_open_udp(int s) {
+#if VFS_UDP
+    if (udp_pending(s) < 0) return -1;
+    return fd_attach(sock_file(s), &udp_ops, O_RDWR);
+#else
+    (void)s;
+    return -1;
+#endif
 }
 
+int vfs_open_tcp(int c) {
+#if VFS_TCP
+    if (c < 0) return -1;
+    return fd_attach(sock_file(c), &tcp_ops, O_RDWR);
+#else
+    (void)c;
+    return -1;
+#endif
+}
+
+#if VFS_POLL
+/* What of p->events (plus error conditions) p->fd offers now */
+static uint8_t fd_revents(const vfs_pollfd_t *p) {
+    if (p->fd < 0) return 0;
+
+    vfs_fd_t *f = get_fd(p->fd);
+    if (!f) return VFS_POLLNVAL;
+    uint8_t r = VFS_OPS(f)->poll ? VFS_OPS(f)->poll(f->fs_file, f->flags)
+                             : (uint8_t)(VFS_POLLIN | VFS_POLLOUT);
+    return (uint8_t)(r & (p->events | VFS_POLLERR | VFS_POLLHUP));
+}
+
+int vfs_poll(vfs_pollfd_t *fds, uint8_t nfds, uint16_t ticks) {
+    if (!fds && nfds) return -1;
+
+    uint32_t start = nk_ticks();
+    for (;;) {
+#if NK_IO_POLL
+        /* Taken before the scan, so a report during it ends the wait */
+        uint8_t seq = nk_event_seq(&nk_io_event);
+#endif
+        int ready = 0;
+        for (uint8_t i = 0; i < nfds; i++) {
+            fds[i].revents = fd_revents(&fds[i]);
+            if (fds[i].revents) ready++;
+        }
+        if (ready) return ready;
+
+        uint16_t left = ticks;
+        if (ticks != VFS_POLL_FOREVER) {
+            uint32_t used = nk_ticks() - start;
+            left = used >= ticks ? 0 : (uint16_t)(ticks - used);
+        }
+        if (left == 0) return 0;
+#if NK_IO_POLL
+        (void)nk_event_wait_seq(&nk_io_event, seq, left);
+#else
+        nk_sleep(1);
+#endif
+    }
+}
+#else
+int vfs_poll(vfs_pollfd_t *fds, uint8_t nfds, uint16_t ticks) {
+    (void)fds; (void)nfds; (void)ticks;
+    return -1;
+}
+#endif
+
 int vfs_stat(const char *path, vfs_stat_t *st) {
     if (!path || !st) return -1;
     int fd = vfs_open(path, O_RDONLY);
@@ -299,9 +1259,9 @@ int vfs_stat(const char *path, vfs_stat_t *st) {
 }
 
 int vfs_fstat(int fd, vfs_stat_t *st) {
-    if (fd < 0 || fd >= VFS_MAX_FDS || !vfs_state.fds[fd].in_use || !st) return -1;
-    vfs_fd_t *f = &vfs_state.fds[fd];
-    st->size = f->ops->size(f->fs_file);
+    vfs_fd_t *f = get_fd(fd);
+    if (!f || !st) return -1;
+    st->size = VFS_OPS(f)->size(f->fs_file);
     st->type = 0;
     st->flags = 0;
     return 0;
@@ -315,8 +1275,14 @@ void vfs_get_stats(vfs_stats_t *stats) {
     stats->fds_used = 0;
     for (uint8_t i = 0; i < VFS_MAX_MOUNTS; i++)
         if (vfs_state.mounts[i].type != VFS_TYPE_NONE) stats->mounts_used++;
-    for (int i = 0; i < VFS_MAX_FDS; i++)
-        if (vfs_state.fds[i].in_use) stats->fds_used++;
+    stats->fds_used = nk_pool_used(&vfs_fds);
+#if VFS_PATH_CACHE > 0
+    stats->cache_hits = vfs_pcache.hits;
+    stats->cache_misses = vfs_pcache.misses;
+#else
+    stats->cache_hits = 0;
+    stats->cache_misses = 0;
+#endif
 }
 
 void vfs_print_mounts(void) {}
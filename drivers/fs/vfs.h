@@ -14,10 +14,11 @@
  * **1. Lightweight Dispatch via Function Pointers**
  * - Each filesystem registers operations (open, read, write)
  * - VFS dispatches to correct FS at runtime
- * - Zero overhead when only one FS is used (compiler optimizes)
+ * - Only one FS and no pipes, tty or socket fds: no table pointers are
+ *   stored and every call is direct, so backends inline into vfs_read()
  *
  * **2. Mount Point System**
- * - Mount filesystems at virtual paths (/rom, /eep, /flash, etc.)
+ * - Mount filesystems at virtual paths (/rom, /eep, /flash, /proc, etc.)
  * - Automatic path resolution and routing
  * - Hierarchical namespace unification
  *
@@ -71,6 +72,8 @@ extern "C" {
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "avrix-config.h"
+#include "vfs_iovec.h"
 
 /*═══════════════════════════════════════════════════════════════════
  * CONFIGURATION
@@ -96,6 +99,101 @@ extern "C" {
 #  define VFS_MAX_FDS 8
 #endif
 
+/**
+ * @brief Descriptors per task (0 = one table shared by every task)
+ *
+ * With 0 a descriptor is simply a slot of the VFS_MAX_FDS open-file
+ * pool, visible to all tasks.  Otherwise every task numbers its own
+ * descriptors from 0: a bitmap (find-first-zero on open) and the pool
+ * slot each fd names.  Open files are reference-counted, so vfs_dup()
+ * and vfs_dup_to() can share one between descriptors and tasks, and
+ * everything a task leaves open is closed in one pass when it exits.
+ * Costs NK_MAX_TASKS * (VFS_TASK_FDS + map bytes) plus one byte per
+ * open file.  At most 32.  Follows fs_task_fds.
+ */
+#ifndef VFS_TASK_FDS
+#  if defined(CONFIG_FS_TASK_FDS)
+#    define VFS_TASK_FDS CONFIG_FS_TASK_FDS
+#  else
+#    define VFS_TASK_FDS 0
+#  endif
+#endif
+
+/**
+ * @brief Pipes that may exist at once (0 = no vfs_pipe())
+ *
+ * Each pipe costs VFS_PIPE_BUF + 6 bytes of RAM.  Follows fs_max_pipes.
+ */
+#ifndef VFS_MAX_PIPES
+#  if defined(CONFIG_FS_MAX_PIPES)
+#    define VFS_MAX_PIPES CONFIG_FS_MAX_PIPES
+#  else
+#    define VFS_MAX_PIPES 0
+#  endif
+#endif
+
+/**
+ * @brief Pipe ring size in bytes (power of two, at most 128)
+ */
+#ifndef VFS_PIPE_BUF
+#  define VFS_PIPE_BUF 64
+#endif
+
+/**
+ * @brief Paths remembered by vfs_open() (0 = no cache)
+ *
+ * A hit skips the mount-table scan and the filesystem's directory walk
+ * through flash.  Entries are keyed by a 32-bit FNV-1a hash of the
+ * full path and kept in LRU order; each costs 8 bytes of RAM on AVR.
+ * vfs_mount() and vfs_unmount() drop the whole cache.  Follows
+ * fs_path_cache.
+ */
+#ifndef VFS_PATH_CACHE
+#  if defined(CONFIG_FS_PATH_CACHE)
+#    define VFS_PATH_CACHE CONFIG_FS_PATH_CACHE
+#  else
+#    define VFS_PATH_CACHE 0
+#  endif
+#endif
+
+/**
+ * @brief Read buffer per descriptor, in bytes (0 = no readahead)
+ *
+ * Short vfs_read()s and vfs_getc() are served from a buffer the fd
+ * fills with one backend read of this many bytes, instead of one
+ * vtable dispatch and flash/EEPROM access per call.  Reads of at least
+ * this size bypass it.  Costs VFS_MAX_FDS * (VFS_READAHEAD + 3) bytes
+ * of RAM.  Follows fs_readahead.
+ */
+#ifndef VFS_READAHEAD
+#  if defined(CONFIG_FS_READAHEAD)
+#    define VFS_READAHEAD CONFIG_FS_READAHEAD
+#  else
+#    define VFS_READAHEAD 0
+#  endif
+#endif
+
+/**
+ * @brief TTY and socket descriptors and vfs_poll() (follows kernel_poll)
+ *
+ * Ties the VFS to the TTY and network drivers and to nk_io_event.  Off,
+ * vfs_open_tty(), vfs_open_udp(), vfs_open_tcp() and vfs_poll() fail.
+ */
+#ifndef VFS_POLL
+#  if defined(CONFIG_KERNEL_POLL)
+#    define VFS_POLL CONFIG_KERNEL_POLL
+#  else
+#    define VFS_POLL 0
+#  endif
+#endif
+
+/**
+ * @brief Most segments one vfs_readv()/vfs_writev() takes (cf. IOV_MAX)
+ */
+#ifndef VFS_IOV_MAX
+#  define VFS_IOV_MAX 16
+#endif
+
 /**
  * @brief Maximum path length (including null terminator)
  */
@@ -105,6 +203,11 @@ extern "C" {
 
 _Static_assert(VFS_MAX_MOUNTS >= 1, "Need at least 1 mount point");
 _Static_assert(VFS_MAX_FDS >= 1, "Need at least 1 file descriptor");
+_Static_assert(VFS_TASK_FDS <= 32, "per-task descriptor map is at most 32 bits");
+_Static_assert((VFS_PIPE_BUF & (VFS_PIPE_BUF - 1)) == 0 && VFS_PIPE_BUF <= 128,
+               "pipe buffer must be a power of two <= 128");
+_Static_assert(VFS_READAHEAD <= 255, "readahead length is kept in a byte");
+_Static_assert(VFS_IOV_MAX >= 1 && VFS_IOV_MAX <= 255, "segment count is a byte");
 
 /*═══════════════════════════════════════════════════════════════════
  * FILESYSTEM TYPES
@@ -119,6 +222,8 @@ typedef enum {
     VFS_TYPE_EEPFS,      /**< EEPROM filesystem (persistent) */
     VFS_TYPE_RAMFS,      /**< RAM filesystem (volatile, future) */
     VFS_TYPE_FATFS,      /**< FAT filesystem (SD card, future) */
+    VFS_TYPE_BLKFS,      /**< Extent filesystem on a block device (blkfs.h) */
+    VFS_TYPE_PROCFS,     /**< Kernel counters printed on read (procfs.h) */
 } vfs_type_t;
 
 /*═══════════════════════════════════════════════════════════════════
@@ -214,9 +319,23 @@ int vfs_open(const char *path, int flags);
  *
  * @note Advances file position by number of bytes read
  * @note Reads less than `count` if EOF reached
+ * @note With VFS_READAHEAD, short reads come from the fd's buffer;
+ *       vfs_write() on any fd drops the buffers of the same file
  */
 int vfs_read(int fd, void *buf, size_t count);
 
+/**
+ * @brief Read one byte
+ *
+ * The character-at-a-time counterpart of vfs_read(): with
+ * VFS_READAHEAD, a buffered byte is returned without calling into the
+ * filesystem.
+ *
+ * @param fd File descriptor returned by vfs_open()
+ * @return The byte (0..255), or -1 at EOF or on error
+ */
+int vfs_getc(int fd);
+
 /**
  * @brief Write to a file
  *
@@ -231,6 +350,34 @@ int vfs_read(int fd, void *buf, size_t count);
  */
 int vfs_write(int fd, const void *buf, size_t count);
 
+/**
+ * @brief Read into several buffers (cf. readv(2))
+ *
+ * Fills the segments in order from the file position.  ROMFS and EEPFS
+ * serve the whole list in one backend call; other files are read
+ * segment by segment, stopping at the first short read.
+ *
+ * @param fd     File descriptor
+ * @param iov    Segments to fill
+ * @param iovcnt Number of segments, 0..VFS_IOV_MAX
+ * @return Bytes read in total, 0 on EOF, -1 on error
+ */
+int vfs_readv(int fd, const vfs_iovec_t *iov, int iovcnt);
+
+/**
+ * @brief Write several buffers as one (cf. writev(2))
+ *
+ * The segments land back to back at the file position.  For EEPFS
+ * with wear levelling that means one page write per block touched,
+ * rather than one per vfs_write() of each piece.
+ *
+ * @param fd     File descriptor
+ * @param iov    Segments to write
+ * @param iovcnt Number of segments, 0..VFS_IOV_MAX
+ * @return Bytes written in total, -1 on error
+ */
+int vfs_writev(int fd, const vfs_iovec_t *iov, int iovcnt);
+
 /**
  * @brief Seek to position in file
  *
@@ -245,6 +392,39 @@ int vfs_write(int fd, const void *buf, size_t count);
  */
 int vfs_lseek(int fd, int offset, int whence);
 
+/**
+ * @brief Write a file's cached data back to its medium
+ *
+ * EEPFS keeps writes in RAM (EEPFS_CACHE_LINES) until a flush;
+ * vfs_close() of a writable descriptor flushes too.  A no-op for
+ * filesystems that do not cache.
+ *
+ * @param fd File descriptor
+ * @return 0 on success, -1 on error
+ */
+int vfs_fsync(int fd);
+
+#define VFS_MAP_RAM     0  /**< vfs_map() pointer is ordinary memory */
+#define VFS_MAP_PROGMEM 1  /**< Read it with hal_pgm_read_*() / *_P() */
+
+/**
+ * @brief Map the rest of a file for zero-copy access
+ *
+ * Returns the address of the byte at the current file position and
+ * the number of bytes from there to the end, so the data can be sent
+ * straight from where it is stored (e.g. with slip_send_packet_P())
+ * instead of through a vfs_read() bounce buffer.  The file position
+ * is not moved.  ROMFS files map to flash: VFS_MAP_PROGMEM on AVR,
+ * VFS_MAP_RAM where flash is in the data address space.
+ *
+ * @param fd  File descriptor
+ * @param ptr Receives the data address
+ * @param len Receives the bytes available at @p ptr
+ * @return VFS_MAP_RAM or VFS_MAP_PROGMEM, or -1 if the file cannot be
+ *         mapped (EEPFS, pipes, compressed ROMFS files)
+ */
+int vfs_map(int fd, const void **ptr, size_t *len);
+
 /**
  * @brief Close a file descriptor
  *
@@ -252,9 +432,142 @@ int vfs_lseek(int fd, int offset, int whence);
  * @return 0 on success, -1 on error
  *
  * @note After closing, fd is invalid and can be reused
+ * @note With VFS_TASK_FDS the file itself is closed with the last
+ *       descriptor that refers to it
  */
 int vfs_close(int fd);
 
+/**
+ * @brief Another descriptor for the open file behind @p fd (VFS_TASK_FDS)
+ *
+ * Both share the file position and flags; the file stays open until
+ * both are closed.
+ *
+ * @return The lowest free descriptor of the calling task, or -1 if
+ *         @p fd is not open, the table is full or VFS_TASK_FDS is 0
+ */
+int vfs_dup(int fd);
+
+/**
+ * @brief Hand task @p tid a descriptor for the open file behind @p fd
+ *
+ * How a parent passes a file (a TTY, a pipe end) to a task it creates:
+ * the returned number is valid in @p tid's table, not the caller's.
+ * The caller may close its own descriptor afterwards.
+ *
+ * @return The descriptor in @p tid's table, or -1 as for vfs_dup()
+ */
+int vfs_dup_to(int fd, uint8_t tid);
+
+/**
+ * @brief Close every descriptor task @p tid has open
+ *
+ * Takes the task's whole table at once, then drops one reference per
+ * descriptor.  nk_task_exit() runs it for the exiting task
+ * (nk_task_exit_hook()), so a recycled task slot starts empty.
+ *
+ * @return Descriptors closed, 0 without VFS_TASK_FDS, -1 for a bad @p tid
+ */
+int vfs_close_task(uint8_t tid);
+
+/**
+ * @brief Create a pipe
+ *
+ * fds[0] is the read end (O_RDONLY), fds[1] the write end (O_WRONLY);
+ * both are ordinary descriptors for vfs_read(), vfs_write() and
+ * vfs_close().  vfs_read() blocks while the pipe is empty and returns
+ * 0 once every write end is closed; vfs_write() blocks while it is full
+ * and fails (-1, or the short count) once every read end is closed.
+ * vfs_lseek() on a pipe fails.
+ *
+ * One reader and one writer task per pipe: the ring itself is not
+ * locked.
+ *
+ * @param fds Receives the two descriptors
+ * @return 0 on success, -1 if no pipe or descriptor is free
+ */
+int vfs_pipe(int fds[2]);
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - DEVICE DESCRIPTORS & READINESS
+ *═══════════════════════════════════════════════════════════════════*/
+
+struct tty_s;
+
+/**
+ * @brief Descriptor for a TTY
+ *
+ * vfs_read() and vfs_write() are tty_read() and tty_write(): they
+ * never wait, so vfs_read() returns 0 on an empty ring; vfs_poll()
+ * first.  vfs_close() leaves the TTY itself alone.
+ *
+ * @param t     Initialized TTY
+ * @param flags O_RDONLY, O_WRONLY or O_RDWR
+ * @return File descriptor, or -1 if none is free (or built without TTY
+ *         or VFS_POLL)
+ */
+int vfs_open_tty(struct tty_s *t, int flags);
+
+/**
+ * @brief Descriptor for a bound UDP socket
+ *
+ * vfs_read() takes one datagram (udp_recvfrom(), 0 if none is queued);
+ * vfs_write() fails, as a datagram needs a destination.  The
+ * descriptor owns the socket: vfs_close() calls udp_close().
+ *
+ * @param s Socket from udp_bind()
+ * @return File descriptor, or -1
+ */
+int vfs_open_udp(int s);
+
+/**
+ * @brief Descriptor for a TCP connection
+ *
+ * vfs_read() and vfs_write() are tcp_recv() and tcp_send(); neither
+ * waits.  vfs_close() calls tcp_close().
+ *
+ * @param c Handle from tcp_listen() or tcp_connect()
+ * @return File descriptor, or -1
+ */
+int vfs_open_tcp(int c);
+
+/** vfs_poll() events; the values of POSIX POLLIN etc. */
+#define VFS_POLLIN   0x01u  /**< vfs_read() would not wait */
+#define VFS_POLLOUT  0x04u  /**< vfs_write() would not wait */
+#define VFS_POLLERR  0x08u  /**< Pipe with no reader left (revents only) */
+#define VFS_POLLHUP  0x10u  /**< Peer gone: no writer, TCP closed (revents only) */
+#define VFS_POLLNVAL 0x20u  /**< Not an open descriptor (revents only) */
+
+/** vfs_poll() timeout meaning "no timeout" */
+#define VFS_POLL_FOREVER 0xFFFFu
+
+/**
+ * @brief One descriptor for vfs_poll()
+ */
+typedef struct {
+    int     fd;         /**< Descriptor; negative entries are skipped */
+    uint8_t events;     /**< VFS_POLLIN / VFS_POLLOUT wanted */
+    uint8_t revents;    /**< Set by vfs_poll() */
+} vfs_pollfd_t;
+
+/**
+ * @brief Wait until some of @p fds are ready (cf. poll(2))
+ *
+ * Files on mounted filesystems are always ready.  Pipes, TTYs and
+ * sockets report what their buffers hold.  The caller sleeps until a
+ * driver signals nk_io_event, then rescans once, so any number of
+ * sources that became ready together cost one wake-up.  (VFS_POLL
+ * forced on without kernel_poll rescans every tick instead.)
+ *
+ * @param fds   Descriptors and the events wanted
+ * @param nfds  Entries in @p fds
+ * @param ticks Timeout in scheduler ticks (0 = just test,
+ *              VFS_POLL_FOREVER = none)
+ * @return Entries with a non-zero revents, 0 on timeout, -1 if @p fds
+ *         is NULL or VFS_POLL is off
+ */
+int vfs_poll(vfs_pollfd_t *fds, uint8_t nfds, uint16_t ticks);
+
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - FILE INFORMATION
  *═══════════════════════════════════════════════════════════════════*/
@@ -298,6 +611,8 @@ typedef struct {
     uint8_t mounts_total;    /**< Maximum mount points */
     uint8_t fds_used;        /**< Number of open file descriptors */
     uint8_t fds_total;       /**< Maximum file descriptors */
+    uint16_t cache_hits;     /**< vfs_open() lookups served by the path cache */
+    uint16_t cache_misses;   /**< Lookups that walked the filesystem */
 } vfs_stats_t;
 
 /**
@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file vfs_iovec.h
+ * @brief Scatter-gather segment shared by VFS and its backends
+ *
+ * Kept apart from vfs.h so romfs.h and eepfs.h can take segment lists
+ * without depending on the VFS layer above them.
+ */
+
+#ifndef DRIVERS_FS_VFS_IOVEC_H
+#define DRIVERS_FS_VFS_IOVEC_H
+
+#include <stddef.h>
+
+/**
+ * @brief One buffer of a vectored read or write (cf. struct iovec)
+ */
+typedef struct {
+    void  *base;    /**< Start of the buffer */
+    size_t len;     /**< Bytes in it */
+} vfs_iovec_t;
+
+#endif /* DRIVERS_FS_VFS_IOVEC_H */
@@ -0,0 +1,415 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file fwup.c
+ * @brief Firmware update over UDP: two page buffers, CRC check, A/B slots
+ */
+
+#include "fwup.h"
+#include "kernel/lib/nk_crc.h"
+#include <string.h>
+
+#if !(defined(HAL_HAS_FLASH_WRITE) && HAL_HAS_FLASH_WRITE)
+#  error "net_fwup needs a HAL with flash self-programming (hal.h section 18)"
+#endif
+
+#define PAGE HAL_FLASH_PAGE_SIZE
+
+_Static_assert((PAGE & (PAGE - 1u)) == 0 && PAGE >= sizeof(fwup_record_t),
+               "HAL_FLASH_PAGE_SIZE must be a power of two holding a record");
+_Static_assert(FWUP_SLOT_SIZE % PAGE == 0, "slots are whole pages");
+
+/* What each page buffer is doing */
+#define BUF_FREE 0
+#define BUF_FILL 1      /* taking data */
+#define BUF_PEND 2      /* full, waiting for the flash */
+#define BUF_PROG 3      /* being programmed */
+
+static struct {
+    fwup_status_t st;
+    int           sock;
+    uint32_t      peer;
+    uint16_t      peer_port;
+    uint32_t      slot_size;    /* 0 until the geometry is worked out */
+    uint32_t      crc;          /* announced in START */
+    uint16_t      fill;         /* bytes in the BUF_FILL buffer */
+    uint8_t       use[2];       /* BUF_* */
+    uint32_t      addr[2];      /* where a PEND/PROG buffer goes */
+    bool          nacked;       /* told the sender about a gap already */
+    uint8_t       page[2][PAGE];
+} fw = { .sock = -1 };
+
+/*═══════════════════════════════════════════════════════════════════
+ * SLOTS
+ *═══════════════════════════════════════════════════════════════════*/
+
+static uint32_t slot_size(void) {
+    if (!fw.slot_size) {
+        uint32_t n = hal_flash_size();
+        n = n > FWUP_SLOT_BASE ? n - FWUP_SLOT_BASE : 0;
+        uint32_t s = FWUP_SLOT_SIZE ? FWUP_SLOT_SIZE : (n / 2u) & ~(uint32_t)(PAGE - 1u);
+        fw.slot_size = s >= 2u * PAGE && s <= n / 2u ? s : 0;
+    }
+    return fw.slot_size;
+}
+
+uint32_t fwup_slot_addr(uint8_t slot) {
+    return FWUP_SLOT_BASE + (uint32_t)(slot & 1u) * slot_size();
+}
+
+static uint32_t record_addr(uint8_t slot) {
+    return fwup_slot_addr(slot) + slot_size() - PAGE;
+}
+
+static uint32_t record_self(const fwup_record_t *r) {
+    return nk_crc32(0, r, offsetof(fwup_record_t, self));
+}
+
+/* CRC-32 of @p len bytes of flash at @p addr, read through @p buf */
+static uint32_t flash_crc(uint32_t addr, uint32_t len, uint8_t *buf, uint16_t bufsz) {
+    uint32_t crc = 0;
+    while (len) {
+        uint16_t n = len < bufsz ? (uint16_t)len : bufsz;
+        hal_flash_read(buf, addr, n);
+        crc = nk_crc32(crc, buf, n);
+        addr += n;
+        len -= n;
+    }
+    return crc;
+}
+
+/* Record of @p slot if it is well-formed (and its image checks, with @p image) */
+static bool record_read(uint8_t slot, fwup_record_t *r, bool image) {
+    uint8_t buf[32];
+
+    if (!slot_size()) {
+        return false;
+    }
+    hal_flash_read(r, record_addr(slot), sizeof *r);
+    if (r->magic != FWUP_MAGIC || r->self != record_self(r) ||
+        r->len == 0 || r->len > slot_size() - PAGE) {
+        return false;
+    }
+    return !image || flash_crc(fwup_slot_addr(slot), r->len, buf, sizeof buf) == r->crc;
+}
+
+int fwup_boot_slot(void) {
+    fwup_record_t r0, r1;
+    bool v0 = record_read(0, &r0, true);
+    bool v1 = record_read(1, &r1, true);
+
+    if (v0 && v1) {
+        return (int32_t)(r1.gen - r0.gen) > 0 ? 1 : 0;
+    }
+    return v0 ? 0 : v1 ? 1 : -1;
+}
+
+/* Program @p page at @p addr and wait for it */
+static bool flash_page_sync(uint32_t addr, const void *page) {
+    while (!hal_flash_write_page(addr, page)) {
+        if (!hal_flash_busy()) {
+            return false;
+        }
+    }
+    while (hal_flash_busy()) {}
+    return true;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PAGE PIPELINE
+ *═══════════════════════════════════════════════════════════════════*/
+
+static int8_t buf_with(uint8_t use) {
+    return fw.use[0] == use ? 0 : fw.use[1] == use ? 1 : -1;
+}
+
+/*
+ * Bytes the sender may have in flight past next: the rest of the buffer
+ * being filled and, when the flash does not stall the CPU, a free one.
+ * Without HAL_FLASH_ASYNC a full page is programmed before the next byte
+ * is taken, so the credit stops at the end of the current page.
+ */
+static uint32_t credit(void) {
+    if (fw.st.state != FWUP_RECV) {
+        return 0;
+    }
+    int8_t f = buf_with(BUF_FILL);
+    uint32_t c = f >= 0 ? PAGE - fw.fill : 0;
+    uint8_t spare = (uint8_t)((fw.use[0] == BUF_FREE) + (fw.use[1] == BUF_FREE));
+#if HAL_FLASH_ASYNC
+    c += spare * (uint32_t)PAGE;
+#else
+    c = f < 0 && spare ? PAGE : c;
+#endif
+    uint32_t left = fw.st.size - fw.st.next;
+    return c < left ? c : left;
+}
+
+static uint16_t ack(void *reply, uint8_t status) {
+    fwup_hdr_t *h = reply;
+    h->op = FWUP_OP_ACK;
+    h->status = status;
+    h->session = ipv4_htons(fw.st.session);
+    h->off = ipv4_htonl(fw.st.next);
+    h->arg = ipv4_htonl(credit());
+    return FWUP_HLEN;
+}
+
+static void fail(void) {
+    fw.st.state = FWUP_FAILED;
+    fw.use[0] = fw.use[1] = BUF_FREE;
+}
+
+/* Retire a programmed page and start the waiting one; true if a buffer came free */
+static bool kick(void) {
+    bool freed = false;
+    int8_t b = buf_with(BUF_PROG);
+
+    if (b >= 0) {
+        if (hal_flash_busy()) {
+            return false;
+        }
+        fw.use[b] = BUF_FREE;
+        fw.st.pages++;
+        freed = true;
+    }
+    b = buf_with(BUF_PEND);
+    if (b >= 0) {
+        if (!hal_flash_write_page(fw.addr[b], fw.page[b])) {
+            fail();
+            return false;
+        }
+        if (HAL_FLASH_ASYNC) {
+            fw.use[b] = BUF_PROG;
+        } else {
+            fw.use[b] = BUF_FREE;           /* programmed in the call */
+            fw.st.pages++;
+            freed = true;
+        }
+    }
+    return freed;
+}
+
+/* The filling buffer is complete: queue it behind the page programming */
+static void page_done(int8_t b) {
+    memset(fw.page[b] + fw.fill, 0xFF, PAGE - fw.fill);
+    fw.addr[b] = fwup_slot_addr((uint8_t)(fw.st.running ^ 1u)) +
+                 ((fw.st.next - 1u) & ~(uint32_t)(PAGE - 1u));
+    fw.use[b] = BUF_PEND;
+    fw.fill = 0;
+    if (buf_with(BUF_PROG) >= 0 && hal_flash_busy()) {
+        fw.st.flash_waits++;
+    }
+    kick();
+}
+
+/* Copy in-order image bytes; returns true if a page was completed */
+static bool take(const uint8_t *p, uint16_t n) {
+    bool paged = false;
+
+    while (n && fw.st.state == FWUP_RECV) {
+        int8_t b = buf_with(BUF_FILL);
+        if (b < 0 && (b = buf_with(BUF_FREE)) < 0) {
+            break;                          /* credit() rules this out */
+        }
+        fw.use[b] = BUF_FILL;
+        uint16_t k = (uint16_t)(PAGE - fw.fill);
+        k = k < n ? k : n;
+        memcpy(fw.page[b] + fw.fill, p, k);
+        fw.fill = (uint16_t)(fw.fill + k);
+        fw.st.next += k;
+        p += k;
+        n = (uint16_t)(n - k);
+        if (fw.fill == PAGE || fw.st.next == fw.st.size) {
+            page_done(b);
+            paged = true;
+        }
+    }
+    return paged;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * REQUESTS
+ *═══════════════════════════════════════════════════════════════════*/
+
+static uint16_t do_start(uint16_t session, uint32_t len, uint32_t crc, void *reply) {
+    if (fw.st.state == FWUP_RECV && session == fw.st.session && len == fw.st.size &&
+        crc == fw.crc) {
+        return ack(reply, FWUP_ST_OK);      /* a repeated START */
+    }
+    /* a new transfer drops the old one; let its last page finish first */
+    while (hal_flash_busy()) {}
+    fw.use[0] = fw.use[1] = BUF_FREE;
+    fw.fill = 0;
+    fw.nacked = false;
+    fw.st.session = session;
+    fw.st.size = len;
+    fw.st.next = 0;
+    fw.st.pages = fw.st.flash_waits = fw.st.rejected = 0;
+    fw.crc = crc;
+    if (len == 0 || len > slot_size() - PAGE) {
+        fw.st.state = FWUP_IDLE;
+        return ack(reply, FWUP_ST_SIZE);
+    }
+    /* the target's old record goes first, before its image is touched */
+    memset(fw.page[0], 0xFF, PAGE);
+    if (!flash_page_sync(record_addr((uint8_t)(fw.st.running ^ 1u)), fw.page[0])) {
+        fail();
+        return ack(reply, FWUP_ST_FLASH);
+    }
+    fw.st.state = FWUP_RECV;
+    return ack(reply, FWUP_ST_OK);
+}
+
+static uint16_t do_data(uint32_t off, const uint8_t *p, uint16_t n, void *reply) {
+    if (fw.st.state != FWUP_RECV) {
+        return fw.st.state == FWUP_DONE ? ack(reply, FWUP_ST_OK) : ack(reply, FWUP_ST_SESSION);
+    }
+    if (off != fw.st.next || n == 0 || n > credit()) {
+        /* one reminder per gap; the sender resends from next */
+        fw.st.rejected++;
+        if (fw.nacked) {
+            return 0;
+        }
+        fw.nacked = true;
+        return ack(reply, FWUP_ST_RESEND);
+    }
+    fw.nacked = false;
+    bool paged = take(p, n);
+    if (fw.st.state == FWUP_FAILED) {
+        return ack(reply, FWUP_ST_FLASH);
+    }
+    return paged ? ack(reply, FWUP_ST_OK) : 0;
+}
+
+static uint16_t do_commit(void *reply) {
+    fwup_record_t *r;
+    uint8_t target = (uint8_t)(fw.st.running ^ 1u);
+
+    if (fw.st.state == FWUP_DONE || fw.st.state == FWUP_FAILED) {
+        return ack(reply, fw.st.state == FWUP_DONE ? FWUP_ST_OK : FWUP_ST_CRC);
+    }
+    if (fw.st.state != FWUP_RECV || fw.st.next != fw.st.size) {
+        return ack(reply, FWUP_ST_BAD);
+    }
+    kick();
+    if (buf_with(BUF_PEND) >= 0 || buf_with(BUF_PROG) >= 0) {
+        return ack(reply, FWUP_ST_BUSY);
+    }
+
+    /* both buffers are free: read the image back through them */
+    if (flash_crc(fwup_slot_addr(target), fw.st.size, fw.page[0], sizeof fw.page) != fw.crc) {
+        fail();
+        return ack(reply, FWUP_ST_CRC);
+    }
+    fwup_record_t cur;
+    uint32_t gen = record_read(fw.st.running, &cur, false) ? cur.gen + 1u : 1u;
+
+    memset(fw.page[0], 0xFF, PAGE);
+    r = (fwup_record_t *)fw.page[0];
+    r->magic = FWUP_MAGIC;
+    r->gen = gen;
+    r->len = fw.st.size;
+    r->crc = fw.crc;
+    r->self = record_self(r);
+    if (!flash_page_sync(record_addr(target), fw.page[0]) ||
+        !record_read(target, &cur, false) || cur.gen != gen) {
+        fail();
+        return ack(reply, FWUP_ST_FLASH);
+    }
+    fw.st.state = FWUP_DONE;
+    return ack(reply, FWUP_ST_OK);
+}
+
+uint16_t fwup_input(const void *msg, uint16_t len, void *reply) {
+    fwup_hdr_t h;
+
+    if (len < FWUP_HLEN) {
+        return 0;
+    }
+    memcpy(&h, msg, FWUP_HLEN);
+    uint16_t session = ipv4_ntohs(h.session);
+    uint32_t off = ipv4_ntohl(h.off);
+    uint32_t arg = ipv4_ntohl(h.arg);
+
+    if (h.op == FWUP_OP_START) {
+        return do_start(session, off, arg, reply);
+    }
+    if (fw.st.state == FWUP_IDLE || session != fw.st.session) {
+        return h.op == FWUP_OP_ACK ? 0 : ack(reply, FWUP_ST_SESSION);
+    }
+    switch (h.op) {
+    case FWUP_OP_DATA:
+        return do_data(off, (const uint8_t *)msg + FWUP_HLEN, (uint16_t)(len - FWUP_HLEN), reply);
+    case FWUP_OP_COMMIT:
+        return do_commit(reply);
+    case FWUP_OP_ABORT:
+        while (hal_flash_busy()) {}
+        fw.st.state = FWUP_IDLE;
+        fw.use[0] = fw.use[1] = BUF_FREE;
+        return ack(reply, FWUP_ST_OK);
+    case FWUP_OP_ACK:
+        return 0;
+    default:
+        return ack(reply, FWUP_ST_BAD);
+    }
+}
+
+uint16_t fwup_step(void *reply) {
+    if (fw.st.state != FWUP_RECV || !kick()) {
+        return 0;
+    }
+    return ack(reply, FWUP_ST_OK);
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * SERVICE
+ *═══════════════════════════════════════════════════════════════════*/
+
+int fwup_init(uint16_t port) {
+    if (fw.sock >= 0) {
+        udp_close(fw.sock);
+    }
+    memset(&fw, 0, sizeof fw);
+    fw.sock = -1;
+    if (!slot_size()) {
+        return -1;
+    }
+    int s = fwup_boot_slot();
+    fw.st.running = s > 0 ? 1 : 0;
+    fw.sock = udp_bind(port ? port : FWUP_PORT);
+    return fw.sock < 0 ? -1 : 0;
+}
+
+int fwup_poll(tty_t *t) {
+    uint8_t reply[FWUP_HLEN];
+    uint32_t src;
+    uint16_t sport, r;
+    pbuf_t *p;
+    int n = 0;
+
+    if (fw.sock < 0) {
+        return 0;
+    }
+    while ((p = udp_recv_pbuf(fw.sock, &src, &sport)) != NULL) {
+        r = p->next ? 0 : fwup_input(pbuf_data(p), p->len, reply);
+        pbuf_free(p);
+        n++;
+        if (r) {
+            fw.peer = src;
+            fw.peer_port = sport;
+            udp_sendto(t, fw.sock, src, sport, reply, r);
+        }
+    }
+    r = fwup_step(reply);
+    if (r && fw.peer_port) {
+        udp_sendto(t, fw.sock, fw.peer, fw.peer_port, reply, r);
+    }
+    return n;
+}
+
+const fwup_status_t *fwup_status(void) {
+    return &fw.st;
+}
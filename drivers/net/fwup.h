@@ -0,0 +1,254 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file fwup.h
+ * @brief Firmware update over UDP on the IPv4/SLIP stack
+ *
+ * Program flash (hal.h section 18) is split into two slots.  The image
+ * that is running stays in its slot; an update is written to the other
+ * one and only becomes the boot image when its record, the last page of
+ * that slot, is programmed after the whole image has been read back and
+ * its CRC-32 (nk_crc32()) checked.  The record carries a generation one
+ * above every other, and fwup_boot_slot() picks the valid record with
+ * the highest generation, so an update interrupted at any point leaves
+ * the old image in charge: the swap is that one page write.  A part
+ * that can only run from one address (AVR) has its boot loader copy
+ * the chosen slot into place.
+ *
+ * The transfer is windowed rather than stop-and-wait.  Data is taken
+ * into one of two page buffers while the other is programmed, and
+ * every acknowledgement grants the sender a credit: how many bytes past
+ * @c next it may send without waiting, i.e. whatever page-buffer space
+ * is not owed to the flash.  With HAL_FLASH_ASYNC the sender therefore
+ * keeps the line busy while pages program, and an update takes as long
+ * as the link needs to carry it, as long as a page programs faster than
+ * it arrives.  Where programming stalls the CPU (AVR) the credit never
+ * runs past the page being filled, so nothing arrives while interrupts
+ * are masked.
+ *
+ * Lost or damaged datagrams (SLIP has no retransmission) are handled
+ * go-back-N: data is only taken in order, and the first datagram past a
+ * gap is answered FWUP_ST_RESEND with @c next, from where the sender
+ * resends.  A sender that hears nothing for a while resends from the
+ * last @c next it was told.
+ *
+ * ## Protocol
+ * Every message starts with fwup_hdr_t, fields in network byte order:
+ *
+ *   op       session  off            arg              then
+ *   START    new id   image length   image CRC-32     -
+ *   DATA     id       byte offset    0                image bytes
+ *   COMMIT   id       0              0                -
+ *   ABORT    id       0              0                -
+ *   ACK      id       next           credit           (status set)
+ *
+ * Each request is answered with an ACK, except in-order DATA, which is
+ * acknowledged when it completes a page or when a programmed page
+ * frees its buffer (fwup_poll()).  COMMIT while pages are still
+ * programming answers FWUP_ST_BUSY: send it again.
+ *
+ * ## Usage
+ * ```c
+ * udp_init(0x0A000001);
+ * fwup_init(0);                           // FWUP_PORT
+ * while (1) {
+ *     tty_poll(&serial);
+ *     udp_poll(&serial);
+ *     fwup_poll(&serial);
+ * }
+ * ```
+ *
+ * ## Memory Footprint
+ * - RAM: 2 * HAL_FLASH_PAGE_SIZE (page buffers; 256 B on ATmega328P)
+ *   plus ~32 bytes of state, one UDP socket
+ * - Flash: one page per slot for its record
+ */
+
+#ifndef DRIVERS_NET_FWUP_H
+#define DRIVERS_NET_FWUP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "udp.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** UDP port fwup_init(0) binds (follows net_fwup_port) */
+#ifndef FWUP_PORT
+#  if defined(CONFIG_NET_FWUP_PORT)
+#    define FWUP_PORT CONFIG_NET_FWUP_PORT
+#  else
+#    define FWUP_PORT 6970u
+#  endif
+#endif
+
+/** First byte of slot 0 in program flash */
+#ifndef FWUP_SLOT_BASE
+#  define FWUP_SLOT_BASE 0u
+#endif
+
+/**
+ * @brief Bytes per slot, record page included (follows net_fwup_slot_kb)
+ *
+ * 0 splits the flash from FWUP_SLOT_BASE up in two.
+ */
+#ifndef FWUP_SLOT_SIZE
+#  if defined(CONFIG_NET_FWUP_SLOT_KB)
+#    define FWUP_SLOT_SIZE ((uint32_t)CONFIG_NET_FWUP_SLOT_KB * 1024u)
+#  else
+#    define FWUP_SLOT_SIZE 0u
+#  endif
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * WIRE FORMAT
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef struct {
+    uint8_t  op;         /**< FWUP_OP_* */
+    uint8_t  status;     /**< FWUP_ST_* in an ACK, 0 otherwise */
+    uint16_t session;    /**< Chosen by the sender in START */
+    uint32_t off;        /**< See the table above */
+    uint32_t arg;
+} __attribute__((packed)) fwup_hdr_t;
+
+#define FWUP_HLEN ((uint16_t)sizeof(fwup_hdr_t))
+
+/** Most image bytes per DATA datagram without IPv4 fragmentation */
+#define FWUP_MAX_DATA ((uint16_t)(IPV4_MTU - sizeof(ipv4_hdr_t) - UDP_HLEN - FWUP_HLEN))
+
+#define FWUP_OP_START   1
+#define FWUP_OP_DATA    2
+#define FWUP_OP_COMMIT  3
+#define FWUP_OP_ABORT   4
+#define FWUP_OP_ACK     0x80
+
+#define FWUP_ST_OK      0   /**< Done, or data taken up to @c next */
+#define FWUP_ST_BUSY    1   /**< Pages still programming: repeat COMMIT */
+#define FWUP_ST_SESSION 2   /**< No transfer with this session */
+#define FWUP_ST_SIZE    3   /**< Image larger than a slot (less its record) */
+#define FWUP_ST_CRC     4   /**< Read-back CRC differs: transfer failed */
+#define FWUP_ST_FLASH   5   /**< The flash refused a page */
+#define FWUP_ST_BAD     6   /**< Malformed or unknown request */
+#define FWUP_ST_RESEND  7   /**< DATA out of order or over credit: go back to @c next */
+
+/*═══════════════════════════════════════════════════════════════════
+ * SLOT RECORDS
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define FWUP_MAGIC 0x55574641u  /* "AFWU" */
+
+/** Last page of a slot, padded with 0xFF; native byte order */
+typedef struct {
+    uint32_t magic;      /**< FWUP_MAGIC */
+    uint32_t gen;        /**< Highest valid one boots */
+    uint32_t len;        /**< Image bytes from the start of the slot */
+    uint32_t crc;        /**< nk_crc32() of the image */
+    uint32_t self;       /**< nk_crc32() of the fields above */
+} fwup_record_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * STATUS
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define FWUP_IDLE    0   /**< No transfer */
+#define FWUP_RECV    1   /**< START accepted, data coming in */
+#define FWUP_DONE    2   /**< Committed: boots after the next reset */
+#define FWUP_FAILED  3   /**< CRC mismatch or flash error; START again */
+
+typedef struct {
+    uint8_t  state;        /**< FWUP_IDLE .. FWUP_FAILED */
+    uint8_t  running;      /**< Slot booted from (0 if none had a record) */
+    uint16_t session;
+    uint32_t size;         /**< Image length announced in START */
+    uint32_t next;         /**< Bytes taken in order */
+    uint16_t pages;        /**< Pages programmed this transfer */
+    uint16_t flash_waits;  /**< Full pages that found the flash still busy */
+    uint16_t rejected;     /**< DATA out of order, over credit or stale */
+} fwup_status_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if CONFIG_NET_FWUP_ENABLED
+
+/**
+ * @brief Bind the service and find the slot running now
+ *
+ * Call after udp_init().  Updates go to the slot fwup_boot_slot() did
+ * not choose.
+ *
+ * @param port UDP port, 0 for FWUP_PORT
+ * @return 0, or -1 if the HAL has no writable flash, the slots do not
+ *         fit in it or the port cannot be bound
+ */
+int fwup_init(uint16_t port);
+
+/**
+ * @brief Take received requests off the socket, answer them and keep
+ *        the flash busy
+ *
+ * Call from the network loop after udp_poll().  Datagrams that needed
+ * IPv4 reassembly are dropped: keep DATA at FWUP_MAX_DATA bytes.
+ *
+ * @return Requests handled
+ */
+int fwup_poll(tty_t *t);
+
+/**
+ * @brief Handle one request of @p len bytes, without the socket
+ *
+ * @param reply FWUP_HLEN bytes for the answer
+ * @return Bytes of @p reply to send back, 0 for none
+ */
+uint16_t fwup_input(const void *msg, uint16_t len, void *reply);
+
+/**
+ * @brief Hand the next full page to the flash once it is free
+ *
+ * fwup_poll() calls this; use it with fwup_input() when not on UDP.
+ *
+ * @param reply FWUP_HLEN bytes for an acknowledgement
+ * @return Bytes of @p reply to send: a page buffer came free, so the
+ *         sender has more credit
+ */
+uint16_t fwup_step(void *reply);
+
+/**
+ * @brief Slot whose record is valid and newest and whose image checks
+ *
+ * Reads every recorded image back to verify its CRC, so it takes about
+ * as long as reading both slots.
+ *
+ * @return 0 or 1, or -1 if neither slot holds a valid image
+ */
+int fwup_boot_slot(void);
+
+/** First byte of slot @p slot (0 or 1) in program flash */
+uint32_t fwup_slot_addr(uint8_t slot);
+
+/** Progress of the current or last transfer */
+const fwup_status_t *fwup_status(void);
+
+#else /* Stubs */
+
+static inline int fwup_init(uint16_t port) { (void)port; return -1; }
+static inline int fwup_poll(tty_t *t) { (void)t; return 0; }
+static inline int fwup_boot_slot(void) { return -1; }
+
+#endif /* CONFIG_NET_FWUP_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_NET_FWUP_H */
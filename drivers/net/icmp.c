@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file icmp.c
+ * @brief In-place ICMP echo responder (see icmp.h)
+ */
+
+#include "icmp.h"
+#include "netif.h"
+#include <string.h>
+
+static uint16_t icmp_replies;
+
+/* Checksums are patched on raw header words: RFC 1624 does not care
+ * about byte order as long as the old word, the new one and the
+ * checksum share it, so nothing is swapped */
+static uint16_t word_at(const void *p) {
+    uint16_t w;
+    memcpy(&w, p, sizeof(w));
+    return w;
+}
+
+bool icmp_input(tty_t *t, pbuf_t *p, const ipv4_hdr_t *h) {
+    if (!p) {
+        return false;
+    }
+
+    uint16_t len = (uint16_t)(ipv4_ntohs(h->len) - sizeof(ipv4_hdr_t));
+    if (len < sizeof(icmp_echo_t) || len > p->len ||
+        pbuf_headroom(p) < sizeof(ipv4_hdr_t)) {
+        pbuf_free(p);
+        return false;
+    }
+    p->len = len;                   /* strip link-layer padding */
+
+    icmp_echo_t *m = (icmp_echo_t *)pbuf_data(p);
+    uint32_t local = ipv4_htonl(ipv4_addr());
+    if (m->type != ICMP_ECHO_REQUEST || m->code != 0 ||
+        (local && h->daddr != local && !netif_find_addr(ipv4_ntohl(h->daddr))) || ipv4_checksum(m, len) != 0) {
+        pbuf_free(p);
+        return false;
+    }
+
+    /* Request → reply: only the type byte of the message changes */
+    uint16_t old = word_at(&m->type);
+    m->type = ICMP_ECHO_REPLY;
+    m->checksum = ipv4_checksum_adjust(m->checksum, old, word_at(&m->type));
+
+    /* The received header is still in front: swap the addresses (the
+     * sum does not change) and restore a full TTL */
+    ipv4_hdr_t *ip = (ipv4_hdr_t *)pbuf_push(p, sizeof(ipv4_hdr_t));
+    uint32_t saddr = ip->saddr;
+    ip->saddr = ip->daddr;
+    ip->daddr = saddr;
+    old = word_at(&ip->ttl);
+    ip->ttl = 64;
+    ip->checksum = ipv4_checksum_adjust(ip->checksum, old, word_at(&ip->ttl));
+
+    ipv4_output(t, pbuf_data(p), p->len, NULL, 0);
+    pbuf_free(p);
+    icmp_replies++;
+    return true;
+}
+
+uint16_t icmp_echo_replies(void) {
+    return icmp_replies;
+}
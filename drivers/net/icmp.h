@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file icmp.h
+ * @brief ICMP echo responder (RFC 792) for the IPv4/SLIP stack
+ *
+ * Echo requests are answered from the receive path, inside
+ * ipv4_poll(), in the pbuf they arrived in: the type byte is flipped,
+ * the addresses swapped and both checksums patched with
+ * ipv4_checksum_adjust() (RFC 1624) instead of being recomputed.  No
+ * buffer is allocated, nothing is copied, and no task is woken.
+ *
+ * Other ICMP messages are dropped.
+ *
+ * ## Memory Footprint
+ * - RAM: 2 bytes (reply counter)
+ */
+
+#ifndef DRIVERS_NET_ICMP_H
+#define DRIVERS_NET_ICMP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ipv4.h"
+#include "pbuf.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * ICMP HEADER (RFC 792)
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef struct {
+    uint8_t  type;
+    uint8_t  code;
+    uint16_t checksum;   /**< Over the whole ICMP message */
+    uint16_t id;         /**< Echo identifier */
+    uint16_t seq;        /**< Echo sequence number */
+} __attribute__((packed)) icmp_echo_t;
+
+#define ICMP_ECHO_REPLY     0
+#define ICMP_ECHO_REQUEST   8
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if CONFIG_NET_ICMP_ENABLED
+
+/**
+ * @brief Deliver a received ICMP message; echo requests are answered
+ *
+ * @p p holds the ICMP message, as returned by ipv4_recv_pbuf() with
+ * header @p h (still in front of it in the pbuf).  Requests addressed
+ * to someone else (once ipv4_set_addr() is set) or with bad checksums
+ * are dropped.  Consumes @p p.
+ *
+ * @return true if a reply was sent on @p t
+ */
+bool icmp_input(tty_t *t, pbuf_t *p, const ipv4_hdr_t *h);
+
+/** Echo replies sent since start-up. */
+uint16_t icmp_echo_replies(void);
+
+#else /* Stubs */
+
+static inline bool icmp_input(tty_t *t, pbuf_t *p, const ipv4_hdr_t *h) {
+    (void)t; (void)h; pbuf_free(p); return false;
+}
+static inline uint16_t icmp_echo_replies(void) { return 0; }
+
+#endif /* CONFIG_NET_ICMP_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_NET_ICMP_H */
@@ -11,49 +11,169 @@
 
 #include "ipv4.h"
 #include "slip.h"
+#include "pbuf.h"
+#include "icmp.h"
+#include "udp.h"
+#include "tcp.h"
+#include "netif.h"
 #include "drivers/tty/tty.h"
+#include "nk_arena.h"
+#include "kernel/lib/nk_warm.h"
 #include <string.h>
 
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - CHECKSUM (RFC 1071 COMPLIANT)
  *═══════════════════════════════════════════════════════════════════*/
 
+/* Fold a wide one's complement sum to 16 bits (end-around carry) */
+static inline uint16_t csum_fold32(uint32_t sum) {
+    sum = (sum & 0xFFFFu) + (sum >> 16);
+    sum = (sum & 0xFFFFu) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+#if defined(__AVR__)
+
+/*
+ * Two words per iteration through one add/adc chain: the carry out of
+ * each 16-bit add goes straight into the next, and the last one is
+ * folded back into the sum.  Network order is big-endian, so even
+ * bytes land in the high half.  About 2.5 cycles per byte.
+ */
+static uint16_t csum_words(const uint8_t *p, size_t len, uint16_t sum) {
+    uint16_t quads = (uint16_t)(len >> 2);
+    uint8_t b0, b1, b2, b3;
+
+    if (quads) {
+        __asm__ volatile (
+            "1:                          \n\t"
+            "ld   %[b0], %a[p]+          \n\t"
+            "ld   %[b1], %a[p]+          \n\t"
+            "ld   %[b2], %a[p]+          \n\t"
+            "ld   %[b3], %a[p]+          \n\t"
+            "add  %A[s], %[b1]           \n\t"
+            "adc  %B[s], %[b0]           \n\t"
+            "adc  %A[s], %[b3]           \n\t"
+            "adc  %B[s], %[b2]           \n\t"
+            "adc  %A[s], __zero_reg__    \n\t"
+            "adc  %B[s], __zero_reg__    \n\t"
+            "sbiw %[n], 1                \n\t"
+            "brne 1b                     \n\t"
+            : [s] "+r" (sum), [p] "+e" (p), [n] "+w" (quads),
+              [b0] "=&r" (b0), [b1] "=&r" (b1), [b2] "=&r" (b2), [b3] "=&r" (b3)
+            :
+            : "memory");
+    }
+    if (len & 2) {
+        uint32_t t = (uint32_t)sum + (uint16_t)((p[0] << 8) | p[1]);
+        sum = csum_fold32(t);
+        p += 2;
+    }
+    if (len & 1) {
+        sum = csum_fold32((uint32_t)sum + (uint16_t)(p[0] << 8));
+    }
+    return sum;
+}
+
+#elif UINTPTR_MAX > 0xFFFFu
+
+/*
+ * 32-bit targets: add native 32-bit words into a 64-bit accumulator
+ * and fold once at the end.  The sum is taken in host byte order and
+ * swapped afterwards, which RFC 1071 section 2(B) allows.
+ */
+static uint16_t csum_words(const uint8_t *p, size_t len, uint16_t sum) {
+    uint64_t acc = 0;
+    uint32_t w;
+
+    while (len >= 16) {
+        uint32_t v[4];
+        memcpy(v, p, sizeof(v));        /* any alignment */
+        acc += (uint64_t)v[0] + v[1] + v[2] + v[3];
+        p += 16;
+        len -= 16;
+    }
+    while (len >= 4) {
+        memcpy(&w, p, 4);
+        acc += w;
+        p += 4;
+        len -= 4;
+    }
+    if (len) {
+        uint8_t tail[4] = { 0, 0, 0, 0 };
+        memcpy(tail, p, len);           /* zero-padded, as RFC 1071 */
+        memcpy(&w, tail, 4);
+        acc += w;
+    }
+    acc = (acc & 0xFFFFFFFFu) + (acc >> 32);
+    acc = (acc & 0xFFFFFFFFu) + (acc >> 32);
+    uint16_t host = csum_fold32((uint32_t)acc);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    host = (uint16_t)((host >> 8) | (host << 8));
+#endif
+    return csum_fold32((uint32_t)sum + host);
+}
+
+#else
+
+/* 16-bit targets: one big-endian word at a time */
+static uint16_t csum_words(const uint8_t *p, size_t len, uint16_t sum) {
+    uint32_t acc = sum;
+
+    while (len > 1) {
+        acc += (uint16_t)((p[0] << 8) | p[1]);
+        p += 2;
+        len -= 2;
+    }
+    if (len) {
+        acc += (uint16_t)(p[0] << 8);
+    }
+    return csum_fold32(acc);
+}
+
+#endif
+
 /**
  * @brief Calculate Internet checksum (RFC 1071)
  *
- * NOVEL IMPROVEMENT: Proper carry propagation (original had bug).
- * Uses the standard one's complement sum algorithm with end-around carry.
- *
- * Algorithm:
- * 1. Sum all 16-bit words
- * 2. Add any leftover byte (odd length) as high-order byte
- * 3. Fold 32-bit sum to 16 bits by adding carry repeatedly
- * 4. Return one's complement
+ * One's complement sum of the buffer as big-endian 16-bit words (an
+ * odd trailing byte is padded with zero), complemented.  The word loop
+ * is picked per target: an add/adc chain on AVR, 32-bit loads with
+ * deferred carry folding on 32-bit CPUs.
  */
 uint16_t ipv4_checksum(const void *buf, size_t len) {
-    const uint8_t *data = (const uint8_t *)buf;
-    uint32_t sum = 0;
+    return (uint16_t)~csum_words((const uint8_t *)buf, len, 0);
+}
 
-    /* Sum all 16-bit words */
-    while (len > 1) {
-        /* Network byte order: high byte first */
-        sum += (uint16_t)((data[0] << 8) | data[1]);
-        data += 2;
-        len -= 2;
-    }
+uint16_t ipv4_checksum_partial(const void *buf, size_t len, uint16_t sum) {
+    return csum_words((const uint8_t *)buf, len, sum);
+}
 
-    /* Add leftover byte (if odd length) as high-order byte */
-    if (len > 0) {
-        sum += (uint16_t)(data[0] << 8);
-    }
+/* Pseudo-header of RFC 768 / RFC 793; addresses already in network order */
+uint16_t ipv4_pseudo_sum(uint32_t saddr, uint32_t daddr, uint8_t proto, uint16_t len) {
+    struct __attribute__((packed)) {
+        uint32_t saddr, daddr;
+        uint8_t  zero, proto;
+        uint16_t len;
+    } ph = { saddr, daddr, 0, proto, ipv4_htons(len) };
 
-    /* NOVEL: Proper carry folding (loop until no carry) */
-    while (sum >> 16) {
-        sum = (sum & 0xFFFF) + (sum >> 16);
-    }
+    return csum_words((const uint8_t *)&ph, sizeof(ph), 0);
+}
 
-    /* Return one's complement */
-    return (uint16_t)~sum;
+/*
+ * RFC 1624 eqn. 3: HC' = ~(~HC + ~m + m').  Byte order does not
+ * matter as long as all three values share it.
+ */
+uint16_t ipv4_checksum_adjust(uint16_t csum, uint16_t old_word, uint16_t new_word) {
+    uint32_t sum = (uint16_t)~csum;
+    sum += (uint16_t)~old_word;
+    sum += new_word;
+    return (uint16_t)~csum_fold32(sum);
+}
+
+uint16_t ipv4_checksum_adjust32(uint16_t csum, uint32_t old_val, uint32_t new_val) {
+    csum = ipv4_checksum_adjust(csum, (uint16_t)(old_val >> 16), (uint16_t)(new_val >> 16));
+    return ipv4_checksum_adjust(csum, (uint16_t)old_val, (uint16_t)new_val);
 }
 
 /*═══════════════════════════════════════════════════════════════════
@@ -63,6 +183,8 @@ uint16_t ipv4_checksum(const void *buf, size_t len) {
 /**
  * @brief Initialize IPv4 header with standard defaults
  */
+static uint16_t ipv4_next_id;       /**< Identification of the next datagram */
+
 void ipv4_init_header(ipv4_hdr_t *h, uint32_t src, uint32_t dst,
                       uint8_t proto, uint16_t payload_len) {
     /* Clear header to zeros */
@@ -72,16 +194,30 @@ void ipv4_init_header(ipv4_hdr_t *h, uint32_t src, uint32_t dst,
     h->ver_ihl = 0x45;  /* Version 4, IHL 5 (20 bytes) */
     h->tos     = 0x00;  /* Best effort */
     h->len     = ipv4_htons(sizeof(ipv4_hdr_t) + payload_len);
-    h->id      = 0;     /* No fragmentation support */
-    h->frag    = ipv4_htons(0x4000);  /* DF=1 (Don't Fragment) */
+    h->id      = ipv4_htons(ipv4_next_id++);
+    /* DF=1 (Don't Fragment) unless it has to be */
+    h->frag    = sizeof(ipv4_hdr_t) + payload_len <= IPV4_MTU ? ipv4_htons(IPV4_DF) : 0;
     h->ttl     = 64;    /* Standard default */
     h->proto   = proto;
     h->saddr   = ipv4_htonl(src);
     h->daddr   = ipv4_htonl(dst);
 
-    /* Calculate and set checksum */
+    /* Calculate and set checksum (network byte order) */
     h->checksum = 0;
-    h->checksum = ipv4_checksum(h, sizeof(*h));
+    h->checksum = ipv4_htons(ipv4_checksum(h, sizeof(*h)));
+}
+
+bool ipv4_dec_ttl(ipv4_hdr_t *h) {
+    if (h->ttl <= 1) {
+        return false;
+    }
+
+    /* TTL is the high byte of the big-endian TTL/protocol word */
+    uint16_t old_word = (uint16_t)((h->ttl << 8) | h->proto);
+    h->ttl--;
+    h->checksum = ipv4_htons(ipv4_checksum_adjust(ipv4_ntohs(h->checksum),
+                                                  old_word, (uint16_t)(old_word - 0x100u)));
+    return true;
 }
 
 /**
@@ -106,69 +242,217 @@ bool ipv4_validate_header(const ipv4_hdr_t *h) {
         return false;
     }
 
-    /* Verify header checksum */
-    uint16_t received_checksum = h->checksum;
-    ipv4_hdr_t tmp;
-    memcpy(&tmp, h, sizeof(tmp));
-    tmp.checksum = 0;
-    uint16_t calculated = ipv4_checksum(&tmp, sizeof(tmp));
-
-    if (received_checksum != calculated) {
-        return false;
-    }
-
-    return true;
+    /* Verify header checksum: summed with it included, a good header gives 0 */
+    return ipv4_checksum(h, sizeof(*h)) == 0;
 }
 
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - PACKET TRANSMISSION
  *═══════════════════════════════════════════════════════════════════*/
 
+static slip_vj_t *ipv4_vj;          /**< CSLIP state, NULL for plain SLIP */
+
+void ipv4_set_cslip(slip_vj_t *vj) {
+    ipv4_vj = vj;
+}
+
+/* CSLIP state for a link: its interface's, else the ipv4_set_cslip() one */
+static slip_vj_t *link_vj(const netif_t *nif) {
+    return nif ? nif->vj : ipv4_vj;
+}
+
+/* One frame onto the link, counted on its interface */
+static void link_send(tty_t *t, netif_t *nif, const slip_iov_t *iov, uint8_t cnt) {
+    if (nif) {
+        uint16_t n = 0;
+        for (uint8_t i = 0; i < cnt; i++) {
+            n = (uint16_t)(n + iov[i].len);
+        }
+        nif->stats.tx_packets++;
+        nif->stats.tx_bytes += n;
+        if (nif->output) {
+            nif->output(nif, iov, cnt);
+            return;
+        }
+    }
+    slip_send_iov(t, iov, cnt);
+}
+
+#if CONFIG_NET_IPV4_FRAG_ENABLED
 /**
- * @brief Send IPv4 packet over SLIP/TTY
+ * @brief Send an oversized datagram as IPV4_FRAG_DATA-byte fragments
+ *
+ * Each fragment is a rewritten copy of the header plus a window into
+ * the pieces, gathered by slip_send_iov(): the payload is never
+ * assembled.  Fragments are not TCP, so CSLIP leaves them alone.
+ */
+static int ipv4_fragment(tty_t *t, netif_t *nif, const uint8_t *a, size_t alen,
+                         const uint8_t *b, size_t blen) {
+    ipv4_hdr_t h;
+    if (alen + blen > IPV4_DGRAM_MAX) {
+        return -1;
+    }
+    memcpy(&h, a, sizeof(h));
+    if (ipv4_ntohs(h.frag) & (IPV4_DF | IPV4_MF | IPV4_OFFSET_MASK)) {
+        return -1;  /* May not be split, or already a fragment */
+    }
+    a += sizeof(h);
+    alen -= sizeof(h);
+
+    size_t data = alen + blen;
+    for (size_t done = 0; done < data;) {
+        size_t n = data - done;
+        bool more = n > IPV4_FRAG_DATA;
+        if (more) {
+            n = IPV4_FRAG_DATA;
+        }
+        h.len = ipv4_htons((uint16_t)(sizeof(h) + n));
+        h.frag = ipv4_htons((uint16_t)((done >> 3) | (more ? IPV4_MF : 0)));
+        h.checksum = 0;
+        h.checksum = ipv4_htons(ipv4_checksum(&h, sizeof(h)));
+
+        /* [done, done + n) of the payload: the tail of a, then b */
+        size_t na = done < alen ? (alen - done < n ? alen - done : n) : 0;
+        size_t ob = n > na ? done + na - alen : 0;
+        const slip_iov_t iov[3] = {
+            { (const uint8_t *)&h, sizeof(h) },
+            { na ? a + done : NULL, na },
+            { n > na ? b + ob : NULL, n - na },
+        };
+        link_send(t, nif, iov, 3);
+        done += n;
+    }
+    return 0;
+}
+#endif
+
+/* ipv4_output() once the link is known */
+static int link_output(tty_t *t, netif_t *nif, const uint8_t *a, size_t head_len,
+                       const uint8_t *b, size_t body_len) {
+#if CONFIG_NET_IPV4_FRAG_ENABLED
+    if (head_len + body_len > IPV4_MTU) {
+        return ipv4_fragment(t, nif, a, head_len, b, body_len);
+    }
+#endif
+
+#if CONFIG_NET_CSLIP_ENABLED
+    slip_vj_t *vj = link_vj(nif);
+    if (slip_vj_tx_active(vj)) {
+        uint8_t hdr[SLIP_VJ_TX_HDR];
+        size_t na = head_len < sizeof(hdr) ? head_len : sizeof(hdr);
+        size_t nb = body_len < sizeof(hdr) - na ? body_len : sizeof(hdr) - na;
+        memcpy(hdr, a, na);
+        if (nb) {
+            memcpy(hdr + na, b, nb);
+        }
+
+        size_t used = na + nb;
+        size_t n = slip_vj_compress(vj, hdr, &used, head_len + body_len);
+        if (used) {
+            size_t skip_a = used < head_len ? used : head_len;
+            size_t skip_b = used - skip_a;
+            const slip_iov_t iov[3] = {
+                { hdr, n },
+                { a + skip_a, head_len - skip_a },
+                { b ? b + skip_b : NULL, body_len - skip_b },
+            };
+            link_send(t, nif, iov, 3);
+            return 0;
+        }
+    }
+#endif
+
+    const slip_iov_t iov[2] = {
+        { a, head_len },
+        { b, body_len },
+    };
+    link_send(t, nif, iov, 2);
+    return 0;
+}
+
+/**
+ * @brief Frame and send a datagram given in two pieces
  *
- * NOVEL OPTIMIZATION: Direct transmission without intermediate buffer
- * (original copied header+payload to frame buffer first).
+ * Both go to slip_send_iov() as segments of one frame: no assembly
+ * buffer, no copy.  With CSLIP active the first SLIP_VJ_TX_HDR bytes
+ * are gathered into a small local copy for the compressor, and
+ * whatever it replaces is skipped in the pieces.  Without a TTY the
+ * destination picks the interface.
+ */
+int ipv4_output(tty_t *t, const void *head, size_t head_len,
+                const void *body, size_t body_len) {
+    const uint8_t *a = head, *b = body;
+    netif_t *nif;
+
+    if (!a || head_len < sizeof(ipv4_hdr_t)) {
+        return -1;
+    }
+    if (!b) {
+        body_len = 0;
+    }
+    if (t) {
+        nif = netif_find(t);
+    } else {
+        uint32_t daddr;
+        memcpy(&daddr, a + offsetof(ipv4_hdr_t, daddr), sizeof(daddr));
+        nif = netif_route(ipv4_ntohl(daddr));
+        if (!nif) {
+            return -1;  /* No route */
+        }
+        t = nif->tty;
+    }
+    return link_output(t, nif, a, head_len, b, body_len);
+}
+
+/**
+ * @brief Send IPv4 packet over SLIP/TTY
  *
- * However, SLIP requires contiguous buffer for encoding, so we still
- * need to assemble the packet. Future optimization: scatter-gather SLIP.
+ * Header and payload go out through ipv4_output() as two pieces of
+ * one frame.
  */
 void ipv4_send(tty_t *t, const ipv4_hdr_t *h, const void *payload, size_t len) {
-    if (!t || !h) {
+    if (!h) {
         return;  /* Invalid parameters */
     }
+    ipv4_output(t, h, sizeof(ipv4_hdr_t), payload, len);
+}
 
-    /* Assemble packet: header + payload */
-    uint8_t frame[sizeof(ipv4_hdr_t) + len];
-    memcpy(frame, h, sizeof(ipv4_hdr_t));
-    if (payload && len > 0) {
-        memcpy(frame + sizeof(ipv4_hdr_t), payload, len);
+int ipv4_send_pbuf(tty_t *t, uint32_t src, uint32_t dst, uint8_t proto,
+                   pbuf_t *p) {
+    if (!p) {
+        return -1;
     }
 
-    /* Transmit via SLIP framing */
-    slip_send_packet(t, frame, sizeof(frame));
+    uint16_t payload_len = p->len;
+    ipv4_hdr_t *h = (ipv4_hdr_t *)pbuf_push(p, sizeof(ipv4_hdr_t));
+    if (!h) {
+        return -1;  /* Caller reserved no room for the header */
+    }
+    ipv4_init_header(h, src, dst, proto, payload_len);
+    return ipv4_output(t, pbuf_data(p), p->len, NULL, 0);
 }
 
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - PACKET RECEPTION
  *═══════════════════════════════════════════════════════════════════*/
 
-/**
- * @brief Receive IPv4 packet from SLIP/TTY
- *
- * NOVEL IMPROVEMENTS:
- * 1. Header validation (version, IHL, checksum)
- * 2. Configurable buffer size (IPV4_MTU instead of fixed 256)
- * 3. Proper error codes (0 vs -1)
- */
-int ipv4_recv(tty_t *t, ipv4_hdr_t *h, void *payload, size_t len) {
-    if (!t || !h) {
-        return -1;  /* Invalid parameters */
-    }
+static nk_arena_t *ipv4_scratch;
+static slip_rx_t  *ipv4_rx;
 
-    /* Receive SLIP frame (header + payload) */
-    uint8_t frame[IPV4_MTU];
-    int frame_len = slip_recv_packet(t, frame, sizeof(frame));
+void ipv4_set_scratch(nk_arena_t *scratch) {
+    ipv4_scratch = scratch;
+}
+
+void ipv4_set_rx(slip_rx_t *rx) {
+    ipv4_rx = rx;
+}
+
+/* Parse one received frame of @p frame_len bytes in a @p cap byte buffer */
+static int ipv4_parse(slip_vj_t *vj, uint8_t *frame, int frame_len, size_t cap,
+                      ipv4_hdr_t *h, void *payload, size_t len) {
+    if (frame_len > 0) {
+        frame_len = slip_vj_uncompress(vj, frame, (size_t)frame_len, cap);
+    }
 
     /* Check if we received enough data for header */
     if (frame_len < (int)sizeof(ipv4_hdr_t)) {
@@ -200,3 +484,432 @@ int ipv4_recv(tty_t *t, ipv4_hdr_t *h, void *payload, size_t len) {
 
     return payload_len;
 }
+
+/* Parse one SLIP frame received into @p frame (IPV4_MTU bytes) */
+static int ipv4_recv_into(tty_t *t, ipv4_hdr_t *h, uint8_t *frame,
+                          void *payload, size_t len) {
+    /* Receive SLIP frame (header + payload) */
+    int frame_len = slip_recv_packet(t, frame, IPV4_MTU);
+    return ipv4_parse(link_vj(netif_find(t)), frame, frame_len, IPV4_MTU, h, payload, len);
+}
+
+/* Kept out of line so only the no-arena path reserves a stack frame */
+static __attribute__((noinline))
+int ipv4_recv_stack(tty_t *t, ipv4_hdr_t *h, void *payload, size_t len) {
+    uint8_t frame[IPV4_MTU];
+    return ipv4_recv_into(t, h, frame, payload, len);
+}
+
+/**
+ * @brief Receive IPv4 packet from SLIP/TTY
+ *
+ * NOVEL IMPROVEMENTS:
+ * 1. Header validation (version, IHL, checksum)
+ * 2. Configurable buffer size (IPV4_MTU instead of fixed 256)
+ * 3. Proper error codes (0 vs -1)
+ *
+ * With a decoder from ipv4_set_rx() frames are parsed where it
+ * assembled them, and a frame still arriving is picked up by a later
+ * call.  Otherwise the frame buffer is bumped from the
+ * ipv4_set_scratch() arena when one is set, falling back to the stack
+ * when it is absent or full.
+ */
+int ipv4_recv(tty_t *t, ipv4_hdr_t *h, void *payload, size_t len) {
+    if (!t || !h) {
+        return -1;  /* Invalid parameters */
+    }
+
+    /* Persistent decoder: parse in place, keep partial frames */
+    if (ipv4_rx) {
+        int frame_len = slip_rx_poll(ipv4_rx, t);
+        if (frame_len == 0) {
+            return 0;
+        }
+        int r = ipv4_parse(link_vj(netif_find(t)), ipv4_rx->buf, frame_len, ipv4_rx->cap,
+                           h, payload, len);
+        slip_rx_done(ipv4_rx);
+        return r;
+    }
+
+    nk_arena_t *a = ipv4_scratch;
+    uint8_t *frame = NULL;
+    nk_arena_mark_t m = 0;
+    if (a) {
+        m = nk_arena_mark(a);
+        frame = nk_arena_alloc(a, IPV4_MTU);
+    }
+    if (!frame) {
+        pbuf_t *p = pbuf_alloc(0);
+        if (!p) {
+            return ipv4_recv_stack(t, h, payload, len);
+        }
+        int r = ipv4_recv_into(t, h, p->buf, payload, len);
+        pbuf_free(p);
+        return r;
+    }
+
+    int r = ipv4_recv_into(t, h, frame, payload, len);
+    nk_arena_release(a, m);
+    return r;
+}
+
+static slip_rx_t ipv4_pbuf_rx;      /**< Decodes into ipv4_pbuf_next */
+static pbuf_t   *ipv4_pbuf_next;    /**< Buffer the next frame lands in */
+
+/* A registered link decodes with its own state, others share one */
+pbuf_t *ipv4_recv_pbuf(tty_t *t, ipv4_hdr_t *h) {
+    if (!t || !h) {
+        return NULL;
+    }
+
+    netif_t *nif = netif_find(t);
+    slip_rx_t *rx = nif ? &nif->rx : &ipv4_pbuf_rx;
+    pbuf_t **next = nif ? &nif->rx_next : &ipv4_pbuf_next;
+    slip_vj_t *vj = link_vj(nif);
+
+    for (;;) {
+        if (!*next) {
+            *next = pbuf_alloc(0);
+            if (!*next) {
+                return NULL;  /* Pool empty: leave frames in the TTY */
+            }
+            rx->buf = (*next)->buf;
+            rx->cap = PBUF_SIZE;
+        }
+
+        int frame_len = slip_rx_poll(rx, t);
+        if (frame_len == 0) {
+            return NULL;  /* Partial frame kept for the next call */
+        }
+        slip_rx_done(rx);
+
+        pbuf_t *p = *next;
+        frame_len = slip_vj_uncompress(vj, p->buf, (size_t)frame_len, PBUF_SIZE);
+        if (frame_len >= (int)sizeof(ipv4_hdr_t)) {
+            p->len = (uint16_t)frame_len;
+            memcpy(h, p->buf, sizeof(ipv4_hdr_t));
+            if (ipv4_validate_header(h)) {
+                *next = NULL;
+                if (nif) {
+                    nif->stats.rx_packets++;
+                    nif->stats.rx_bytes += p->len;
+                }
+                pbuf_pull(p, sizeof(ipv4_hdr_t));
+                return p;
+            }
+        }
+        /* Invalid datagram or undecodable CSLIP: decode the next frame
+         * over it */
+        if (nif) {
+            nif->stats.rx_dropped++;
+        }
+    }
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - REASSEMBLY
+ *═══════════════════════════════════════════════════════════════════*/
+
+static uint32_t ipv4_now;           /**< Last ipv4_timer() time, ms */
+static uint16_t ipv4_reasm_drops;
+
+#if CONFIG_NET_IPV4_FRAG_ENABLED
+
+_Static_assert(IPV4_REASM_SLOTS * IPV4_REASM_FRAGS < PBUF_COUNT,
+               "reassembly must leave a pbuf to receive into (raise net_pbufs)");
+
+/**
+ * One datagram being reassembled: its fragments, in their receive
+ * pbufs, sorted by offset.  Holes wait for later fragments; overlaps
+ * drop the whole datagram (no reassembly ambiguity to exploit).
+ */
+typedef struct {
+    uint32_t saddr, daddr;          /**< Network order, as received */
+    uint16_t id;
+    uint8_t  proto;
+    uint8_t  count;                 /**< Fragments held; 0 = slot free */
+    uint16_t total;                 /**< Payload length once the last fragment is in */
+    uint32_t born;                  /**< ipv4_now at the first fragment */
+    uint16_t off[IPV4_REASM_FRAGS];
+    pbuf_t  *frag[IPV4_REASM_FRAGS];
+} ipv4_reasm_t;
+
+static ipv4_reasm_t ipv4_reasm[IPV4_REASM_SLOTS];
+
+static void reasm_drop(ipv4_reasm_t *r) {
+    for (uint8_t i = 0; i < r->count; i++) {
+        pbuf_free(r->frag[i]);
+    }
+    r->count = 0;
+    if (ipv4_reasm_drops != UINT16_MAX) {
+        ipv4_reasm_drops++;
+    }
+}
+
+static ipv4_reasm_t *reasm_slot(const ipv4_hdr_t *h) {
+    ipv4_reasm_t *free_slot = NULL;
+    for (uint8_t i = 0; i < IPV4_REASM_SLOTS; i++) {
+        ipv4_reasm_t *r = &ipv4_reasm[i];
+        if (!r->count) {
+            free_slot = free_slot ? free_slot : r;
+        } else if (r->id == h->id && r->saddr == h->saddr &&
+                   r->daddr == h->daddr && r->proto == h->proto) {
+            return r;
+        }
+    }
+    if (free_slot) {
+        free_slot->saddr = h->saddr;
+        free_slot->daddr = h->daddr;
+        free_slot->id = h->id;
+        free_slot->proto = h->proto;
+        free_slot->total = 0;
+        free_slot->born = ipv4_now;
+    }
+    return free_slot;
+}
+
+/**
+ * @brief Add fragment @p p (header @p h) to its datagram
+ *
+ * @return The datagram as a chain, with @p h rewritten to cover all of
+ *         it, once the last hole is filled; NULL while incomplete
+ */
+static pbuf_t *reasm_input(pbuf_t *p, ipv4_hdr_t *h) {
+    uint16_t frag = ipv4_ntohs(h->frag);
+    uint16_t len = (uint16_t)(ipv4_ntohs(h->len) - sizeof(ipv4_hdr_t));
+    uint32_t off = (uint32_t)(frag & IPV4_OFFSET_MASK) * 8u;
+    bool more = frag & IPV4_MF;
+
+    ipv4_reasm_t *r = NULL;
+    if (len == 0 || len > p->len || (more && (len & 7u)) ||
+        off + len > IPV4_DGRAM_MAX - sizeof(ipv4_hdr_t) ||
+        (r = reasm_slot(h)) == NULL) {
+        pbuf_free(p);
+        if (ipv4_reasm_drops != UINT16_MAX) {
+            ipv4_reasm_drops++;
+        }
+        return NULL;
+    }
+    p->len = len;                   /* strip link-layer padding */
+    uint16_t end = (uint16_t)(off + len);
+
+    /* Where it goes, and whether it collides with its neighbours */
+    uint8_t i = 0;
+    while (i < r->count && r->off[i] < off) {
+        i++;
+    }
+    if (i < r->count && r->off[i] == off && r->frag[i]->len == len) {
+        pbuf_free(p);               /* duplicate: keep the first copy */
+        return NULL;
+    }
+    if ((i > 0 && r->off[i - 1] + r->frag[i - 1]->len > off) ||
+        (i < r->count && end > r->off[i]) ||
+        (!more && (r->total || (r->count && r->off[r->count - 1] +
+                                             r->frag[r->count - 1]->len > end))) ||
+        (r->total && end > r->total) || r->count == IPV4_REASM_FRAGS) {
+        pbuf_free(p);
+        reasm_drop(r);
+        return NULL;
+    }
+    memmove(&r->off[i + 1], &r->off[i], (size_t)(r->count - i) * sizeof(r->off[0]));
+    memmove(&r->frag[i + 1], &r->frag[i], (size_t)(r->count - i) * sizeof(r->frag[0]));
+    r->off[i] = (uint16_t)off;
+    r->frag[i] = p;
+    r->count++;
+    if (!more) {
+        r->total = end;
+    }
+
+    /* Complete once the pieces run without a gap from 0 to the end */
+    uint16_t at = 0;
+    for (i = 0; i < r->count && r->off[i] == at; i++) {
+        at = (uint16_t)(at + r->frag[i]->len);
+    }
+    if (i < r->count || !r->total || at != r->total) {
+        return NULL;
+    }
+
+    for (i = 0; i + 1 < r->count; i++) {
+        r->frag[i]->next = r->frag[i + 1];
+    }
+    h->len = ipv4_htons((uint16_t)(sizeof(ipv4_hdr_t) + r->total));
+    h->frag = 0;
+    h->checksum = 0;
+    h->checksum = ipv4_htons(ipv4_checksum(h, sizeof(*h)));
+    r->count = 0;
+    return r->frag[0];
+}
+
+void ipv4_timer(uint32_t now_ms) {
+    ipv4_now = now_ms;
+    for (uint8_t i = 0; i < IPV4_REASM_SLOTS; i++) {
+        ipv4_reasm_t *r = &ipv4_reasm[i];
+        if (r->count && (uint32_t)(now_ms - r->born) >= IPV4_REASM_TIMEOUT_MS) {
+            reasm_drop(r);
+        }
+    }
+}
+
+#else /* Fragments are dropped */
+
+static pbuf_t *reasm_input(pbuf_t *p, ipv4_hdr_t *h) {
+    (void)h;
+    pbuf_free(p);
+    if (ipv4_reasm_drops != UINT16_MAX) {
+        ipv4_reasm_drops++;
+    }
+    return NULL;
+}
+
+void ipv4_timer(uint32_t now_ms) {
+    ipv4_now = now_ms;
+}
+
+#endif /* CONFIG_NET_IPV4_FRAG_ENABLED */
+
+uint16_t ipv4_reasm_dropped(void) {
+    return ipv4_reasm_drops;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - DISPATCH
+ *═══════════════════════════════════════════════════════════════════*/
+
+static uint32_t ipv4_local;         /**< Host byte order */
+
+/* Copy of the configured address for a warm restart */
+static uint32_t      ipv4_warm_addr NK_WARM_DATA;
+static nk_warm_hdr_t ipv4_warm NK_WARM_DATA;
+
+void ipv4_set_addr(uint32_t addr) {
+    ipv4_local = addr;
+    ipv4_warm_addr = addr;
+    nk_warm_save(&ipv4_warm, &ipv4_warm_addr, sizeof ipv4_warm_addr);
+}
+
+bool ipv4_resume(void) {
+    if (!nk_warm_restore(&ipv4_warm, &ipv4_warm_addr, sizeof ipv4_warm_addr))
+        return false;
+    ipv4_local = ipv4_warm_addr;
+    return true;
+}
+
+uint32_t ipv4_addr(void) {
+    return ipv4_local;
+}
+
+#if CONFIG_NET_NETIF_ENABLED
+/* Ours: an interface address, the stack address, or broadcast/multicast */
+static bool ipv4_is_local(uint32_t daddr) {
+    return daddr == ipv4_local || netif_find_addr(daddr) ||
+           daddr == 0xFFFFFFFFu || (daddr & 0xF0000000u) == 0xE0000000u;
+}
+
+/**
+ * @brief Send a received datagram on towards its destination
+ *
+ * The header received with @p p is still in its headroom: the TTL is
+ * decremented there and the same buffer goes out whole.
+ */
+static bool ipv4_forward(netif_t *in, pbuf_t *p, const ipv4_hdr_t *h) {
+    netif_t *out = netif_route(ipv4_ntohl(h->daddr));
+    uint16_t len = (uint16_t)(ipv4_ntohs(h->len) - sizeof(ipv4_hdr_t));
+    ipv4_hdr_t *ip = NULL;
+
+    if (out && out != in && len <= p->len) {
+        p->len = len;               /* strip link-layer padding */
+        ip = (ipv4_hdr_t *)pbuf_push(p, sizeof(ipv4_hdr_t));
+    }
+    if (!ip || !ipv4_dec_ttl(ip) ||
+        link_output(out->tty, out, pbuf_data(p), p->len, NULL, 0) < 0) {
+        pbuf_free(p);
+        if (in) {
+            in->stats.rx_dropped++;
+        }
+        return false;
+    }
+    pbuf_free(p);
+    if (in) {
+        in->stats.forwarded++;
+    }
+    return true;
+}
+#endif
+
+/* Deliver or forward a datagram that arrived on @p in (NULL: unregistered) */
+static bool ipv4_deliver(netif_t *in, tty_t *t, pbuf_t *p, const ipv4_hdr_t *h) {
+    ipv4_hdr_t whole;
+
+#if CONFIG_NET_NETIF_ENABLED
+    if (netif_forwarding() && !ipv4_is_local(ipv4_ntohl(h->daddr))) {
+        return ipv4_forward(in, p, h);
+    }
+#endif
+
+    if (ipv4_ntohs(h->frag) & (IPV4_MF | IPV4_OFFSET_MASK)) {
+        whole = *h;
+        p = reasm_input(p, &whole);
+        if (!p) {
+            return false;  /* Held for the rest, or dropped */
+        }
+        h = &whole;
+        if (h->proto != IPV4_PROTO_UDP) {
+            pbuf_free(p);
+            return false;
+        }
+    }
+
+    switch (h->proto) {
+    case IPV4_PROTO_ICMP:
+        return icmp_input(t, p, h);
+    case IPV4_PROTO_UDP:
+        return udp_input(p, h);
+    case IPV4_PROTO_TCP:
+        return tcp_input(t, p, h);
+    default:
+        pbuf_free(p);
+        if (in) {
+            in->stats.rx_dropped++;
+        }
+        return false;
+    }
+}
+
+bool ipv4_input(tty_t *t, pbuf_t *p, const ipv4_hdr_t *h) {
+    return ipv4_deliver(netif_find(t), t, p, h);
+}
+
+int ipv4_poll(tty_t *t) {
+    ipv4_hdr_t h;
+    pbuf_t *p;
+    int n = 0;
+
+    while ((p = ipv4_recv_pbuf(t, &h)) != NULL) {
+        n += ipv4_input(t, p, &h);
+    }
+    return n;
+}
+
+#if CONFIG_NET_NETIF_ENABLED
+bool netif_input(netif_t *nif, pbuf_t *p) {
+    ipv4_hdr_t h;
+
+    if (!p) {
+        return false;
+    }
+    if (!nif || p->len < sizeof(h)) {
+        pbuf_free(p);
+        return false;
+    }
+    memcpy(&h, pbuf_data(p), sizeof(h));
+    if (!ipv4_validate_header(&h)) {
+        pbuf_free(p);
+        nif->stats.rx_dropped++;
+        return false;
+    }
+    nif->stats.rx_packets++;
+    nif->stats.rx_bytes += p->len;
+    pbuf_pull(p, sizeof(h));
+    return ipv4_deliver(nif, nif->tty, p, &h);
+}
+#endif
@@ -28,6 +28,47 @@ extern "C" {
 #  define IPV4_MTU 576
 #endif
 
+/** Reassembly slots: datagrams being put back together at once */
+#ifndef IPV4_REASM_SLOTS
+#  if defined(CONFIG_NET_IPV4_REASM_SLOTS)
+#    define IPV4_REASM_SLOTS CONFIG_NET_IPV4_REASM_SLOTS
+#  else
+#    define IPV4_REASM_SLOTS 1
+#  endif
+#endif
+
+/** Fragments (one pbuf each) a reassembly slot holds at most */
+#ifndef IPV4_REASM_FRAGS
+#  if defined(CONFIG_NET_IPV4_REASM_FRAGS)
+#    define IPV4_REASM_FRAGS CONFIG_NET_IPV4_REASM_FRAGS
+#  else
+#    define IPV4_REASM_FRAGS 4
+#  endif
+#endif
+
+/** A partly reassembled datagram is dropped this long after its first fragment */
+#ifndef IPV4_REASM_TIMEOUT_MS
+#  define IPV4_REASM_TIMEOUT_MS 3000u
+#endif
+
+/** Payload of a full-sized fragment: the MTU less the header, in 8-byte units */
+#define IPV4_FRAG_DATA ((uint16_t)((IPV4_MTU - 20) & ~7u))
+
+/** Largest datagram sent or reassembled (just IPV4_MTU without fragmentation) */
+#if CONFIG_NET_IPV4_FRAG_ENABLED
+#  define IPV4_DGRAM_MAX ((uint16_t)(20u + IPV4_REASM_FRAGS * IPV4_FRAG_DATA))
+#else
+#  define IPV4_DGRAM_MAX ((uint16_t)IPV4_MTU)
+#endif
+
+/** Flags in ipv4_hdr_t.frag (host order) */
+#define IPV4_DF          0x4000u    /**< Don't fragment */
+#define IPV4_MF          0x2000u    /**< More fragments follow */
+#define IPV4_OFFSET_MASK 0x1FFFu    /**< Fragment offset, 8-byte units */
+
+_Static_assert(IPV4_REASM_SLOTS >= 1 && IPV4_REASM_SLOTS <= 4, "net_ipv4_reasm_slots is 1..4");
+_Static_assert(IPV4_REASM_FRAGS >= 2 && IPV4_REASM_FRAGS <= 8, "net_ipv4_reasm_frags is 2..8");
+
 /*═══════════════════════════════════════════════════════════════════
  * IPv4 HEADER STRUCTURE (RFC 791)
  *═══════════════════════════════════════════════════════════════════*/
@@ -76,6 +117,10 @@ static inline uint32_t ipv4_htonl(uint32_t x) {
  *═══════════════════════════════════════════════════════════════════*/
 
 typedef struct tty_s tty_t;
+typedef struct slip_rx slip_rx_t;
+typedef struct slip_vj slip_vj_t;
+typedef struct pbuf pbuf_t;
+struct nk_arena;
 
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API
@@ -84,17 +129,201 @@ typedef struct tty_s tty_t;
 #if CONFIG_NET_IPV4_ENABLED
 
 uint16_t ipv4_checksum(const void *buf, size_t len);
+
+/**
+ * @brief Add @p buf to a running one's complement sum
+ *
+ * For checksums over several pieces (e.g. a UDP pseudo-header and its
+ * datagram): start from 0, chain the calls and complement the result.
+ * Every piece but the last must have an even length.
+ *
+ * @return Updated 16-bit sum, not complemented
+ */
+uint16_t ipv4_checksum_partial(const void *buf, size_t len, uint16_t sum);
+
+/**
+ * @brief Update checksum @p csum after one 16-bit word changed (RFC 1624)
+ *
+ * All three values must be in the same byte order.
+ */
+uint16_t ipv4_checksum_adjust(uint16_t csum, uint16_t old_word, uint16_t new_word);
+
+/** ipv4_checksum_adjust() for a 32-bit field, e.g. an address rewrite. */
+uint16_t ipv4_checksum_adjust32(uint16_t csum, uint32_t old_val, uint32_t new_val);
+
+/**
+ * @brief Fill in a header for a new datagram
+ *
+ * Each datagram gets the next identification.  DF is set when the
+ * datagram fits IPV4_MTU, so only oversized ones may be fragmented.
+ */
 void ipv4_init_header(ipv4_hdr_t *h, uint32_t src, uint32_t dst,
                       uint8_t proto, uint16_t payload_len);
 bool ipv4_validate_header(const ipv4_hdr_t *h);
+
+/**
+ * @brief Decrement the TTL of a forwarded header, patching the checksum
+ *
+ * @return false (header untouched) if the TTL would reach 0
+ */
+bool ipv4_dec_ttl(ipv4_hdr_t *h);
 void ipv4_send(tty_t *t, const ipv4_hdr_t *h, const void *payload, size_t len);
+
+/**
+ * @brief Send one datagram given as two pieces, @p head then @p body
+ *
+ * Every datagram the stack sends goes through here, so this is where
+ * CSLIP compresses headers: the first SLIP_VJ_TX_HDR bytes may be
+ * swapped for a shorter header before the frame goes out.  With
+ * net_ipv4_frag_enabled a datagram longer than IPV4_MTU (and at most
+ * IPV4_DGRAM_MAX, without DF) goes out as fragments gathered straight
+ * from the two pieces; others that do not fit are dropped.
+ *
+ * @param t Link, or NULL to pick the interface routing the destination
+ *          (netif_route())
+ * @param head Starts with the IPv4 header
+ * @return 0, or -1 if there is no route or the datagram cannot be sent
+ */
+int ipv4_output(tty_t *t, const void *head, size_t head_len,
+                const void *body, size_t body_len);
+
+/**
+ * @brief Compress and decompress TCP headers with @p vj (RFC 1144)
+ *
+ * Applies to everything ipv4_output() sends and ipv4_recv() /
+ * ipv4_recv_pbuf() receive on links without a netif (a netif uses
+ * its own @c vj).  NULL (the default) is plain SLIP.  Without
+ * net_cslip_enabled this does nothing.
+ */
+void ipv4_set_cslip(slip_vj_t *vj);
 int ipv4_recv(tty_t *t, ipv4_hdr_t *h, void *payload, size_t len);
 
+/**
+ * @brief Take ipv4_recv() frame buffers from @p scratch
+ *
+ * With an arena set, each receive bumps IPV4_MTU bytes and releases
+ * them before returning, so callers' stacks need not hold a frame.
+ * NULL reverts to an on-stack frame.
+ */
+void ipv4_set_scratch(struct nk_arena *scratch);
+
+/**
+ * @brief Receive through the persistent SLIP decoder @p rx
+ *
+ * ipv4_recv() then drains the TTY into @p rx, so frames split across
+ * polls are kept, and parses each frame in @p rx's buffer (which should
+ * hold IPV4_MTU bytes) instead of a scratch or stack copy.  NULL
+ * reverts to one-shot slip_recv_packet() decoding.
+ */
+void ipv4_set_rx(slip_rx_t *rx);
+
+/**
+ * @brief Receive one datagram into a buffer from the pbuf pool
+ *
+ * SLIP decodes straight into the pbuf; the IPv4 header is validated,
+ * copied to @p h and pulled off, so the returned pbuf holds just the
+ * payload, ready for the transport layer.  A frame still arriving
+ * stays in its pbuf for the next call.  While the pool is empty
+ * nothing is read: frames wait in the TTY.  Fragments are returned as
+ * they arrive; ipv4_input() reassembles them.
+ *
+ * @return Payload pbuf (the caller frees it), or NULL if no valid
+ *         datagram is complete
+ */
+pbuf_t *ipv4_recv_pbuf(tty_t *t, ipv4_hdr_t *h);
+
+/**
+ * @brief Hand a received datagram to its transport protocol
+ *
+ * @p p holds the payload and @p h the header, as returned by
+ * ipv4_recv_pbuf().  Consumes @p p; protocols that are not enabled
+ * drop it.  A fragment is held for reassembly (net_ipv4_frag_enabled,
+ * else dropped); the fragment completing a datagram delivers it as a
+ * pbuf chain.  Only UDP takes chains: reassembled ICMP and TCP are
+ * dropped (the TCP MSS keeps segments within one frame).
+ *
+ * @return true if a protocol accepted it
+ */
+bool ipv4_input(tty_t *t, pbuf_t *p, const ipv4_hdr_t *h);
+
+/**
+ * @brief Receive and dispatch every complete datagram waiting in @p t
+ *
+ * @return Number of datagrams a protocol accepted
+ */
+int ipv4_poll(tty_t *t);
+
+/**
+ * @brief Set the local address (host byte order) transports send from
+ */
+void ipv4_set_addr(uint32_t addr);
+
+/** Local address, host byte order. */
+uint32_t ipv4_addr(void);
+
+/**
+ * @brief Take back the address set before a warm reset
+ *
+ * With NK_WARM, ipv4_set_addr() also keeps a CRC-checked copy in
+ * .noinit.  Boot code calls this first and configures the
+ * address as usual only when it returns false.
+ *
+ * @return true if the address of the last boot was restored
+ */
+bool ipv4_resume(void);
+
+/**
+ * @brief Advance IPv4 time to @p now_ms, expiring stale reassemblies
+ *
+ * Call every few hundred milliseconds, like tcp_timer(); fragments of
+ * a datagram not complete IPV4_REASM_TIMEOUT_MS after the first one
+ * arrived are freed.
+ */
+void ipv4_timer(uint32_t now_ms);
+
+/**
+ * @brief Datagrams lost in reassembly: timed out, overlapping or
+ *        oversized fragments, no free slot
+ */
+uint16_t ipv4_reasm_dropped(void);
+
+/**
+ * @brief One's complement sum of a transport pseudo-header
+ *
+ * @param saddr Source address, network order (as in ipv4_hdr_t)
+ * @param daddr Destination address, network order
+ * @param proto IPV4_PROTO_UDP or IPV4_PROTO_TCP
+ * @param len Transport header + payload length, host order
+ * @return Sum to chain into ipv4_checksum_partial()
+ */
+uint16_t ipv4_pseudo_sum(uint32_t saddr, uint32_t daddr, uint8_t proto, uint16_t len);
+
+/**
+ * @brief Send the payload in @p p as one datagram
+ *
+ * The header is built in @p p's headroom (at least PBUF_HLEN_IP bytes)
+ * and the frame goes out in one piece.  On return @p p holds the whole
+ * datagram and is still the caller's.
+ *
+ * @return 0 on success, -1 on bad arguments or too little headroom
+ */
+int ipv4_send_pbuf(tty_t *t, uint32_t src, uint32_t dst, uint8_t proto,
+                   pbuf_t *p);
+
 #else /* Stubs */
 
 static inline uint16_t ipv4_checksum(const void *buf, size_t len) {
     (void)buf; (void)len; return 0;
 }
+static inline uint16_t ipv4_checksum_partial(const void *buf, size_t len, uint16_t sum) {
+    (void)buf; (void)len; return sum;
+}
+static inline uint16_t ipv4_checksum_adjust(uint16_t csum, uint16_t old_word, uint16_t new_word) {
+    (void)old_word; (void)new_word; return csum;
+}
+static inline uint16_t ipv4_checksum_adjust32(uint16_t csum, uint32_t old_val, uint32_t new_val) {
+    (void)old_val; (void)new_val; return csum;
+}
 static inline void ipv4_init_header(ipv4_hdr_t *h, uint32_t src, uint32_t dst,
                                     uint8_t proto, uint16_t payload_len) {
     (void)h; (void)src; (void)dst; (void)proto; (void)payload_len;
@@ -102,12 +331,56 @@ static inline void ipv4_init_header(ipv4_hdr_t *h, uint32_t src, uint32_t dst,
 static inline bool ipv4_validate_header(const ipv4_hdr_t *h) {
     (void)h; return false;
 }
+static inline bool ipv4_dec_ttl(ipv4_hdr_t *h) {
+    (void)h; return false;
+}
 static inline void ipv4_send(tty_t *t, const ipv4_hdr_t *h, const void *payload, size_t len) {
     (void)t; (void)h; (void)payload; (void)len;
 }
+static inline int ipv4_output(tty_t *t, const void *head, size_t head_len,
+                              const void *body, size_t body_len) {
+    (void)t; (void)head; (void)head_len; (void)body; (void)body_len; return -1;
+}
+static inline void ipv4_set_cslip(slip_vj_t *vj) {
+    (void)vj;
+}
 static inline int ipv4_recv(tty_t *t, ipv4_hdr_t *h, void *payload, size_t len) {
     (void)t; (void)h; (void)payload; (void)len; return -ENOSYS;
 }
+static inline void ipv4_set_scratch(struct nk_arena *scratch) {
+    (void)scratch;
+}
+static inline void ipv4_set_rx(slip_rx_t *rx) {
+    (void)rx;
+}
+static inline pbuf_t *ipv4_recv_pbuf(tty_t *t, ipv4_hdr_t *h) {
+    (void)t; (void)h; return NULL;
+}
+static inline bool ipv4_input(tty_t *t, pbuf_t *p, const ipv4_hdr_t *h) {
+    (void)t; (void)p; (void)h; return false;
+}
+static inline int ipv4_poll(tty_t *t) {
+    (void)t; return 0;
+}
+static inline void ipv4_set_addr(uint32_t addr) {
+    (void)addr;
+}
+static inline uint32_t ipv4_addr(void) {
+    return 0;
+}
+static inline void ipv4_timer(uint32_t now_ms) {
+    (void)now_ms;
+}
+static inline uint16_t ipv4_reasm_dropped(void) {
+    return 0;
+}
+static inline uint16_t ipv4_pseudo_sum(uint32_t saddr, uint32_t daddr, uint8_t proto, uint16_t len) {
+    (void)saddr; (void)daddr; (void)proto; (void)len; return 0;
+}
+static inline int ipv4_send_pbuf(tty_t *t, uint32_t src, uint32_t dst,
+                                 uint8_t proto, pbuf_t *p) {
+    (void)t; (void)src; (void)dst; (void)proto; (void)p; return -1;
+}
 
 #endif /* CONFIG_NET_IPV4_ENABLED */
 
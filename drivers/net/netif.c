@@ -0,0 +1,172 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file netif.c
+ * @brief Interface registry and longest-prefix-match routes (see netif.h)
+ *
+ * The data path (receive decoding, netif_input(), forwarding) lives in
+ * ipv4.c next to the rest of it.
+ */
+
+#include "netif.h"
+#include "pbuf.h"
+#include <string.h>
+
+typedef struct {
+    uint32_t prefix;                /**< Host order, masked */
+    netif_t *nif;                   /**< NULL = free entry */
+    uint8_t  len;                   /**< Prefix length, 0..32 */
+} netif_route_t;
+
+static netif_t      *netifs[NETIF_MAX];
+static netif_route_t routes[NETIF_ROUTES];
+static bool          forwarding;
+
+static uint32_t prefix_mask(uint8_t len) {
+    return len ? 0xFFFFFFFFu << (32u - len) : 0;
+}
+
+static uint8_t mask_len(uint32_t mask) {
+    uint8_t n = 0;
+    while (mask & 0x80000000u) {
+        mask <<= 1;
+        n++;
+    }
+    return n;
+}
+
+int netif_add(netif_t *nif, tty_t *t, uint32_t addr, uint32_t mask) {
+    int slot = -1;
+
+    if (!nif || (t && netif_find(t))) {
+        return -1;
+    }
+    for (int i = 0; i < NETIF_MAX; i++) {
+        if (netifs[i] == nif) {
+            return -1;
+        }
+        if (!netifs[i] && slot < 0) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        return -1;
+    }
+
+    nif->tty = t;
+    nif->addr = addr;
+    nif->mask = mask;
+    slip_rx_init(&nif->rx, NULL, 0);
+    nif->rx_next = NULL;
+    memset(&nif->stats, 0, sizeof(nif->stats));
+    netifs[slot] = nif;
+    if (!ipv4_addr()) {
+        ipv4_set_addr(addr);
+    }
+    return 0;
+}
+
+void netif_remove(netif_t *nif) {
+    for (int i = 0; i < NETIF_MAX; i++) {
+        if (netifs[i] == nif) {
+            netifs[i] = NULL;
+            pbuf_free(nif->rx_next);
+            nif->rx_next = NULL;
+        }
+    }
+    for (int i = 0; i < NETIF_ROUTES; i++) {
+        if (routes[i].nif == nif) {
+            routes[i].nif = NULL;
+        }
+    }
+}
+
+netif_t *netif_find(tty_t *t) {
+    if (!t) {
+        return NULL;
+    }
+    for (int i = 0; i < NETIF_MAX; i++) {
+        if (netifs[i] && netifs[i]->tty == t) {
+            return netifs[i];
+        }
+    }
+    return NULL;
+}
+
+netif_t *netif_find_addr(uint32_t addr) {
+    for (int i = 0; i < NETIF_MAX; i++) {
+        if (netifs[i] && netifs[i]->addr == addr) {
+            return netifs[i];
+        }
+    }
+    return NULL;
+}
+
+int netif_route_add(uint32_t prefix, uint8_t len, netif_t *nif) {
+    int slot = -1;
+
+    if (!nif || len > 32) {
+        return -1;
+    }
+    prefix &= prefix_mask(len);
+    for (int i = 0; i < NETIF_ROUTES; i++) {
+        if (routes[i].nif && routes[i].prefix == prefix && routes[i].len == len) {
+            slot = i;               /* replace */
+            break;
+        }
+        if (!routes[i].nif && slot < 0) {
+            slot = i;
+        }
+    }
+    if (slot < 0) {
+        return -1;
+    }
+    routes[slot].prefix = prefix;
+    routes[slot].len = len;
+    routes[slot].nif = nif;
+    return 0;
+}
+
+void netif_route_del(uint32_t prefix, uint8_t len) {
+    if (len > 32) {
+        return;
+    }
+    prefix &= prefix_mask(len);
+    for (int i = 0; i < NETIF_ROUTES; i++) {
+        if (routes[i].nif && routes[i].prefix == prefix && routes[i].len == len) {
+            routes[i].nif = NULL;
+        }
+    }
+}
+
+netif_t *netif_route(uint32_t dst) {
+    netif_t *best = NULL;
+    int best_len = -1;
+
+    /* Connected subnets first: on a tie they win over a table entry */
+    for (int i = 0; i < NETIF_MAX; i++) {
+        netif_t *n = netifs[i];
+        if (n && ((dst ^ n->addr) & n->mask) == 0 && (int)mask_len(n->mask) > best_len) {
+            best = n;
+            best_len = mask_len(n->mask);
+        }
+    }
+    for (int i = 0; i < NETIF_ROUTES; i++) {
+        const netif_route_t *r = &routes[i];
+        if (r->nif && (int)r->len > best_len && (dst & prefix_mask(r->len)) == r->prefix) {
+            best = r->nif;
+            best_len = r->len;
+        }
+    }
+    return best;
+}
+
+void netif_set_forwarding(bool on) {
+    forwarding = on;
+}
+
+bool netif_forwarding(void) {
+    return forwarding;
+}
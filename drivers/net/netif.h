@@ -0,0 +1,212 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file netif.h
+ * @brief Network interfaces and the IPv4 routing table
+ *
+ * A netif is one link with its own address, receive state and
+ * counters.  SLIP links are bound to a TTY: once registered, every
+ * ipv4_recv_pbuf() / ipv4_poll() on that TTY decodes into the
+ * interface's own SLIP decoder (so frames on two links interleave
+ * safely) and CSLIP uses the interface's state.  Other links (a radio,
+ * later) set @c output and hand received datagrams to netif_input().
+ *
+ * Routes are (prefix, length, interface) triples, searched longest
+ * prefix first; each interface's own subnet counts as a route.  Links
+ * are point to point, so the interface is the next hop.  Sending with
+ * a NULL TTY (udp_sendto(), tcp_connect(), ipv4_output()) routes on the
+ * destination.
+ *
+ * With forwarding on, a datagram for an address that is not ours goes
+ * straight back out of the interface its route names: the TTL is
+ * decremented in the header still in front of the payload, and the
+ * same pbuf is framed again, never copied.
+ *
+ * ## Usage
+ * ```c
+ * static netif_t sl0, sl1;
+ * netif_add(&sl0, &uart0, 0x0A000001, 0xFFFFFF00);    // 10.0.0.1/24
+ * netif_add(&sl1, &uart1, 0x0A000101, 0xFFFFFF00);    // 10.0.1.1/24
+ * netif_route_add(0, 0, &sl0);                        // default route
+ * netif_set_forwarding(true);
+ * while (1) {
+ *     tty_poll(&uart0); ipv4_poll(&uart0);
+ *     tty_poll(&uart1); ipv4_poll(&uart1);
+ * }
+ * ```
+ *
+ * ## Memory Footprint
+ * - RAM: about 40 bytes per netif_t (the caller's), plus
+ *   NETIF_MAX * 2 + NETIF_ROUTES * 7 bytes of tables (AVR)
+ */
+
+#ifndef DRIVERS_NET_NETIF_H
+#define DRIVERS_NET_NETIF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ipv4.h"
+#include "pbuf.h"
+#include "slip.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Interfaces that can be registered (follows net_netifs) */
+#ifndef NETIF_MAX
+#  if defined(CONFIG_NET_NETIFS)
+#    define NETIF_MAX CONFIG_NET_NETIFS
+#  else
+#    define NETIF_MAX 2
+#  endif
+#endif
+
+/** Routing table entries, besides each interface's subnet (follows net_routes) */
+#ifndef NETIF_ROUTES
+#  if defined(CONFIG_NET_ROUTES)
+#    define NETIF_ROUTES CONFIG_NET_ROUTES
+#  else
+#    define NETIF_ROUTES 4
+#  endif
+#endif
+
+_Static_assert(NETIF_MAX >= 1 && NETIF_MAX <= 4, "net_netifs is 1..4");
+_Static_assert(NETIF_ROUTES >= 1 && NETIF_ROUTES <= 16, "net_routes is 1..16");
+
+/*═══════════════════════════════════════════════════════════════════
+ * DATA STRUCTURES
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Per-interface counters (wrapping) */
+typedef struct {
+    uint16_t rx_packets;    /**< Valid datagrams received */
+    uint16_t tx_packets;    /**< Frames sent (each fragment counts) */
+    uint16_t rx_dropped;    /**< Bad frames; undeliverable or unroutable datagrams */
+    uint16_t forwarded;     /**< Datagrams received here and sent on elsewhere */
+    uint32_t rx_bytes;
+    uint32_t tx_bytes;
+} netif_stats_t;
+
+typedef struct netif netif_t;
+
+/**
+ * @brief Link output for interfaces without a TTY
+ *
+ * Sends one frame given as @p cnt pieces.
+ */
+typedef void (*netif_output_fn)(netif_t *nif, const slip_iov_t *iov, uint8_t cnt);
+
+/** One interface; the caller owns the storage */
+struct netif {
+    tty_t          *tty;        /**< SLIP link, or NULL with @c output */
+    netif_output_fn output;     /**< Non-SLIP link output, or NULL */
+    slip_vj_t      *vj;         /**< CSLIP state for this link, or NULL */
+    uint32_t        addr;       /**< Host byte order */
+    uint32_t        mask;       /**< Host byte order, e.g. 0xFFFFFF00 */
+    slip_rx_t       rx;         /**< Receive decoder (SLIP links) */
+    pbuf_t         *rx_next;    /**< pbuf @c rx decodes into */
+    netif_stats_t   stats;
+};
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if CONFIG_NET_NETIF_ENABLED
+
+/**
+ * @brief Register @p nif for link @p t with address @p addr / @p mask
+ *
+ * Clears the counters.  @p t may be NULL if the caller then sets
+ * @c output.  The first interface added also becomes ipv4_addr()
+ * unless one is already set.
+ *
+ * @return 0, or -1 if the table is full or @p t already has one
+ */
+int netif_add(netif_t *nif, tty_t *t, uint32_t addr, uint32_t mask);
+
+/**
+ * @brief Unregister @p nif and drop the routes through it
+ */
+void netif_remove(netif_t *nif);
+
+/** Interface bound to @p t, or NULL. */
+netif_t *netif_find(tty_t *t);
+
+/** Interface whose address is @p addr (host order), or NULL. */
+netif_t *netif_find_addr(uint32_t addr);
+
+/**
+ * @brief Route @p prefix / @p len (host order) through @p nif
+ *
+ * Replaces an existing route for the same prefix.  0/0 is the default
+ * route.
+ *
+ * @return 0, or -1 if the table is full or @p len exceeds 32
+ */
+int netif_route_add(uint32_t prefix, uint8_t len, netif_t *nif);
+
+/**
+ * @brief Remove the route for @p prefix / @p len
+ */
+void netif_route_del(uint32_t prefix, uint8_t len);
+
+/**
+ * @brief Interface for destination @p dst (host order), longest prefix
+ *        first, or NULL if there is no route
+ */
+netif_t *netif_route(uint32_t dst);
+
+/**
+ * @brief Forward datagrams not addressed to us (off by default)
+ */
+void netif_set_forwarding(bool on);
+
+/** True if forwarding is on. */
+bool netif_forwarding(void);
+
+/**
+ * @brief Deliver a datagram received on a link without a TTY
+ *
+ * @p p holds the whole datagram from its IPv4 header on.  It is
+ * validated, counted and handled as if ipv4_poll() had received it.
+ * Consumes @p p.
+ *
+ * @return true if a protocol accepted it or it was forwarded
+ */
+bool netif_input(netif_t *nif, pbuf_t *p);
+
+#else /* Stubs */
+
+static inline int netif_add(netif_t *nif, tty_t *t, uint32_t addr, uint32_t mask) {
+    (void)nif; (void)t; (void)addr; (void)mask; return -1;
+}
+static inline void netif_remove(netif_t *nif) { (void)nif; }
+static inline netif_t *netif_find(tty_t *t) { (void)t; return NULL; }
+static inline netif_t *netif_find_addr(uint32_t addr) { (void)addr; return NULL; }
+static inline int netif_route_add(uint32_t prefix, uint8_t len, netif_t *nif) {
+    (void)prefix; (void)len; (void)nif; return -1;
+}
+static inline void netif_route_del(uint32_t prefix, uint8_t len) { (void)prefix; (void)len; }
+static inline netif_t *netif_route(uint32_t dst) { (void)dst; return NULL; }
+static inline void netif_set_forwarding(bool on) { (void)on; }
+static inline bool netif_forwarding(void) { return false; }
+static inline bool netif_input(netif_t *nif, pbuf_t *p) {
+    (void)nif; pbuf_free(p); return false;
+}
+
+#endif /* CONFIG_NET_NETIF_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_NET_NETIF_H */
@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file pbuf.c
+ * @brief Packet buffer pool (see pbuf.h)
+ */
+
+#include "pbuf.h"
+#include "nk_pool.h"
+#include "arch/common/hal.h"
+#include <string.h>
+
+#if PBUF_COUNT > 0
+
+NK_POOL_DEFINE_ISR(pbuf_pool, pbuf_t, PBUF_COUNT);
+
+pbuf_t *pbuf_alloc(uint16_t headroom) {
+    if (headroom > PBUF_SIZE) {
+        return NULL;
+    }
+    pbuf_t *p = NK_POOL_ALLOC(pbuf_pool);
+    if (p) {
+        p->next = NULL;
+        p->off = headroom;
+        p->len = 0;
+        p->ref = 1;
+    }
+    return p;
+}
+
+void pbuf_ref(pbuf_t *p) {
+    if (p) {
+        hal_atomic_fetch_add_u8(&p->ref, 1);
+    }
+}
+
+void pbuf_free(pbuf_t *p) {
+    /* Only the holder of the last reference sees 1 here; that one owns
+     * the chain's reference to the next buffer */
+    while (p && hal_atomic_fetch_sub_u8(&p->ref, 1) == 1) {
+        pbuf_t *next = p->next;
+        nk_pool_free(&pbuf_pool, p);
+        p = next;
+    }
+}
+
+uint8_t pbuf_used(void) {
+    return nk_pool_used(&pbuf_pool);
+}
+
+void pbuf_trim(pbuf_t *p, uint16_t len) {
+    for (; p; p = p->next) {
+        if (p->len >= len) {
+            p->len = len;
+            pbuf_free(p->next);
+            p->next = NULL;
+            return;
+        }
+        len = (uint16_t)(len - p->len);
+    }
+}
+
+uint16_t pbuf_copy_out(const pbuf_t *p, void *dst, uint16_t len) {
+    uint8_t *d = dst;
+    uint16_t n = 0;
+    for (; p && n < len; p = p->next) {
+        uint16_t k = p->len < len - n ? p->len : (uint16_t)(len - n);
+        hal_memcpy_fast(d + n, p->buf + p->off, k);
+        n = (uint16_t)(n + k);
+    }
+    return n;
+}
+
+#else /* No pool: every allocation fails */
+
+pbuf_t *pbuf_alloc(uint16_t headroom) {
+    (void)headroom;
+    return NULL;
+}
+
+void pbuf_ref(pbuf_t *p) {
+    (void)p;
+}
+
+void pbuf_free(pbuf_t *p) {
+    (void)p;
+}
+
+void pbuf_trim(pbuf_t *p, uint16_t len) {
+    (void)p; (void)len;
+}
+
+uint16_t pbuf_copy_out(const pbuf_t *p, void *dst, uint16_t len) {
+    (void)p; (void)dst; (void)len;
+    return 0;
+}
+
+uint8_t pbuf_used(void) {
+    return 0;
+}
+
+#endif /* PBUF_COUNT > 0 */
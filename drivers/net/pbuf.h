@@ -0,0 +1,199 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file pbuf.h
+ * @brief Packet buffer pool for the network stack
+ *
+ * A fixed pool of PBUF_COUNT frame-sized buffers, each holding one
+ * packet as a window [off, off + len) into its storage.  Layers move
+ * the window instead of copying: a receiver pulls its header off the
+ * front and hands the rest up; a sender allocates with headroom for
+ * every header below it and each layer pushes its own in front.
+ *
+ * ```
+ * buf: [ headroom ........ | data (len bytes) ........ | tailroom ]
+ *                          ^ off
+ * ```
+ *
+ * Buffers carry a reference count, so a packet can sit in a queue and
+ * with its consumer at once; the last pbuf_free() returns it to the
+ * pool.  A datagram reassembled from IPv4 fragments is a chain of
+ * buffers linked through @c next, one fragment each; freeing the head
+ * frees the chain.  Everything else is a single buffer.  Allocation and release are ISR-safe (NK_POOL_DEFINE_ISR and
+ * the HAL atomics), so an RX interrupt can take buffers directly.
+ *
+ * ## Memory Footprint
+ * - RAM: PBUF_COUNT * (PBUF_SIZE + 7) bytes (AVR), plus one map byte
+ *   per 8 buffers
+ * - With net_pbufs = 0 the pool is absent and pbuf_alloc() fails
+ */
+
+#ifndef DRIVERS_NET_PBUF_H
+#define DRIVERS_NET_PBUF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ipv4.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Buffers in the pool (follows net_pbufs)
+ */
+#ifndef PBUF_COUNT
+#  if defined(CONFIG_NET_PBUF_COUNT)
+#    define PBUF_COUNT CONFIG_NET_PBUF_COUNT
+#  else
+#    define PBUF_COUNT 2
+#  endif
+#endif
+
+/** Storage per buffer: one whole datagram */
+#define PBUF_SIZE IPV4_MTU
+
+/** Headroom for an IPv4 header (transport headers add their own) */
+#define PBUF_HLEN_IP ((uint16_t)sizeof(ipv4_hdr_t))
+
+/** Headroom for IPv4 plus the largest transport header (TCP, 20 bytes) */
+#define PBUF_HLEN_TRANSPORT ((uint16_t)(PBUF_HLEN_IP + 20u))
+
+_Static_assert(PBUF_COUNT >= 0 && PBUF_COUNT <= 16, "net_pbufs is 0..16");
+
+/*═══════════════════════════════════════════════════════════════════
+ * DATA STRUCTURES
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief One packet buffer
+ */
+typedef struct pbuf {
+    struct pbuf     *next;             /**< Rest of a reassembled datagram */
+    uint16_t         off;              /**< Start of the data in @c buf */
+    uint16_t         len;              /**< Bytes of data */
+    volatile uint8_t ref;              /**< References; 0 = in the pool */
+    uint8_t          buf[PBUF_SIZE];   /**< Storage */
+} pbuf_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Take a buffer with @p headroom bytes reserved in front
+ *
+ * The buffer starts empty (len 0) with one reference.
+ *
+ * @return Buffer, or NULL if the pool is exhausted or @p headroom
+ *         exceeds PBUF_SIZE
+ */
+pbuf_t *pbuf_alloc(uint16_t headroom);
+
+/**
+ * @brief Add a reference to @p p
+ */
+void pbuf_ref(pbuf_t *p);
+
+/**
+ * @brief Drop a reference; the last one returns @p p to the pool
+ *
+ * The rest of a chain goes with it.  NULL is ignored.
+ */
+void pbuf_free(pbuf_t *p);
+
+/**
+ * @brief Shorten the chain at @p p to @p len bytes in all
+ *
+ * Buffers past the new end are freed; a longer @p len changes nothing.
+ */
+void pbuf_trim(pbuf_t *p, uint16_t len);
+
+/**
+ * @brief Copy up to @p len bytes of the chain at @p p into @p dst
+ *
+ * @return Bytes copied
+ */
+uint16_t pbuf_copy_out(const pbuf_t *p, void *dst, uint16_t len);
+
+/** Buffers currently out of the pool. */
+uint8_t pbuf_used(void);
+
+/** Bytes of data in the whole chain at @p p. */
+static inline uint16_t pbuf_chain_len(const pbuf_t *p) {
+    uint16_t n = 0;
+    for (; p; p = p->next) {
+        n = (uint16_t)(n + p->len);
+    }
+    return n;
+}
+
+/** First data byte of @p p. */
+static inline uint8_t *pbuf_data(pbuf_t *p) {
+    return p->buf + p->off;
+}
+
+/** Bytes free in front of the data. */
+static inline uint16_t pbuf_headroom(const pbuf_t *p) {
+    return p->off;
+}
+
+/** Bytes free after the data. */
+static inline uint16_t pbuf_tailroom(const pbuf_t *p) {
+    return (uint16_t)(PBUF_SIZE - p->off - p->len);
+}
+
+/**
+ * @brief Grow the data by @p n bytes at the front, for a header
+ *
+ * @return New first data byte, or NULL if the headroom is too small
+ */
+static inline uint8_t *pbuf_push(pbuf_t *p, uint16_t n) {
+    if (n > p->off) {
+        return NULL;
+    }
+    p->off = (uint16_t)(p->off - n);
+    p->len = (uint16_t)(p->len + n);
+    return pbuf_data(p);
+}
+
+/**
+ * @brief Strip @p n bytes off the front, e.g. a parsed header
+ *
+ * @return New first data byte, or NULL if there are fewer than @p n
+ */
+static inline uint8_t *pbuf_pull(pbuf_t *p, uint16_t n) {
+    if (n > p->len) {
+        return NULL;
+    }
+    p->off = (uint16_t)(p->off + n);
+    p->len = (uint16_t)(p->len - n);
+    return pbuf_data(p);
+}
+
+/**
+ * @brief Grow the data by @p n bytes at the end
+ *
+ * @return Where the new bytes go, or NULL if the tailroom is too small
+ */
+static inline uint8_t *pbuf_put(pbuf_t *p, uint16_t n) {
+    if (n > pbuf_tailroom(p)) {
+        return NULL;
+    }
+    uint8_t *tail = pbuf_data(p) + p->len;
+    p->len = (uint16_t)(p->len + n);
+    return tail;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_NET_PBUF_H */
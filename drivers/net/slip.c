@@ -7,65 +7,227 @@
  * @brief SLIP Protocol Implementation
  *
  * RFC 1055 compliant encoder/decoder for Serial Line IP.
- * Stateless design suitable for embedded systems.
+ * Stateless encoder; the decoder keeps its place in a slip_rx_t.
+ * RFC 1144 TCP/IP header compression keeps per-link state in slip_vj_t.
  */
 
 #include "slip.h"
 #include "drivers/tty/tty.h"
+#include "arch/common/hal.h"
 #include <stdbool.h>
+#include <string.h>
 
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - SLIP ENCODING
  *═══════════════════════════════════════════════════════════════════*/
 
+/** Stack buffer for encoding frames held in program memory */
+#define SLIP_TX_CHUNK 16
+
+/* tty_write() takes what fits in the ring: keep going until all is out.
+ * With tty_blocking a full ring puts the sender to sleep until the TX
+ * ISR has drained half of it, so long frames stream in chunks. */
+static void tx_all(tty_t *t, const uint8_t *p, size_t n) {
+#if TTY_BLOCKING
+    (void)tty_write_wait(t, p, n, TTY_WAIT_FOREVER);
+#else
+    while (n) {
+        int w = tty_write(t, p, n);
+        if (w <= 0) {
+            return;  /* no transmitter */
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+#endif
+}
+
+static void slip_send_ram(tty_t *t, const uint8_t *buf, size_t len) {
+    const uint8_t *run = buf;
+
+    /* Runs of plain bytes go out in one call; only END/ESC split them */
+    for (const uint8_t *p = buf; p < buf + len; ++p) {
+        if (*p == SLIP_END || *p == SLIP_ESC) {
+            const uint8_t esc_seq[2] = {
+                SLIP_ESC, *p == SLIP_END ? SLIP_ESC_END : SLIP_ESC_ESC
+            };
+            tx_all(t, run, (size_t)(p - run));
+            tx_all(t, esc_seq, 2);
+            run = p + 1;
+        }
+    }
+    tx_all(t, run, (size_t)(buf + len - run));
+}
+
+static void slip_send_pgm(tty_t *t, const uint8_t *buf, size_t len) {
+    uint8_t out[SLIP_TX_CHUNK];
+    uint8_t n = 0;
+
+    /* Encode through a small buffer, one write per SLIP_TX_CHUNK bytes */
+    for (size_t i = 0; i < len; ++i) {
+        uint8_t b = hal_pgm_read_byte(buf + i);
+        if (n > SLIP_TX_CHUNK - 2) {
+            tx_all(t, out, n);
+            n = 0;
+        }
+        if (b == SLIP_END) {
+            out[n++] = SLIP_ESC;
+            b = SLIP_ESC_END;
+        } else if (b == SLIP_ESC) {
+            out[n++] = SLIP_ESC;
+            b = SLIP_ESC_ESC;
+        }
+        out[n++] = b;
+    }
+    tx_all(t, out, n);
+}
+
 /**
  * @brief Encode and transmit a SLIP frame
  *
- * Implements RFC 1055 character stuffing algorithm.
+ * Implements RFC 1055 character stuffing algorithm, handing the TTY
+ * whole runs of bytes instead of one call per byte.
+ *
+ * @param pgm @p buf is in program memory
  */
-void slip_send_packet(tty_t *t, const uint8_t *buf, size_t len) {
+static void slip_send(tty_t *t, const uint8_t *buf, size_t len, bool pgm) {
     if (!t) {
         return;  /* Invalid TTY */
     }
 
     /* Send frame start delimiter */
-    const uint8_t start = SLIP_END;
-    tty_write(t, &start, 1);
-
-    /* Encode and transmit payload with character stuffing */
-    for (size_t i = 0; i < len; ++i) {
-        uint8_t b = buf[i];
+    const uint8_t end = SLIP_END;
+    tx_all(t, &end, 1);
 
-        if (b == SLIP_END) {
-            /* Encode END as: ESC ESC_END */
-            const uint8_t esc_seq[2] = {SLIP_ESC, SLIP_ESC_END};
-            tty_write(t, esc_seq, 2);
-        }
-        else if (b == SLIP_ESC) {
-            /* Encode ESC as: ESC ESC_ESC */
-            const uint8_t esc_seq[2] = {SLIP_ESC, SLIP_ESC_ESC};
-            tty_write(t, esc_seq, 2);
-        }
-        else {
-            /* Regular byte - no encoding needed */
-            tty_write(t, &b, 1);
-        }
+    if (pgm) {
+        slip_send_pgm(t, buf, len);
+    } else {
+        slip_send_ram(t, buf, len);
     }
 
     /* Send frame end delimiter */
+    tx_all(t, &end, 1);
+}
+
+void slip_send_packet(tty_t *t, const uint8_t *buf, size_t len) {
+    slip_send(t, buf, len, false);
+}
+
+void slip_send_iov(tty_t *t, const slip_iov_t *iov, uint8_t cnt) {
+    if (!t || (!iov && cnt)) {
+        return;
+    }
+
     const uint8_t end = SLIP_END;
-    tty_write(t, &end, 1);
+    tx_all(t, &end, 1);
+    for (uint8_t i = 0; i < cnt; i++) {
+        if (iov[i].base) {
+            slip_send_ram(t, iov[i].base, iov[i].len);
+        }
+    }
+    tx_all(t, &end, 1);
+}
+
+void slip_send_packet_P(tty_t *t, const uint8_t *buf, size_t len) {
+    slip_send(t, buf, len, true);
 }
 
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - SLIP DECODING
  *═══════════════════════════════════════════════════════════════════*/
 
+void slip_rx_init(slip_rx_t *rx, uint8_t *buf, uint16_t cap) {
+    rx->buf = buf;
+    rx->cap = cap;
+    rx->pos = 0;
+    rx->esc = false;
+    rx->discard = false;
+    rx->dropped = 0;
+    rx->ready = false;
+}
+
+static void rx_lost(slip_rx_t *rx) {
+    rx->discard = true;
+    if (rx->dropped != UINT16_MAX) {
+        rx->dropped++;
+    }
+}
+
+bool slip_rx_feed(slip_rx_t *rx, uint8_t byte) {
+    if (rx->ready) {
+        /* No room until slip_rx_done(): lose whatever this belongs to */
+        if (byte == SLIP_END) {
+            rx->discard = false;
+        } else if (!rx->discard) {
+            rx_lost(rx);
+        }
+        return true;
+    }
+
+    if (byte == SLIP_END) {
+        if (rx->discard) {
+            rx->discard = false;        /* resynchronised */
+        } else if (rx->pos > 0) {
+            rx->esc = false;
+            rx->ready = true;           /* published last, for ISR feeders */
+            return true;
+        }
+        /* Empty frame or leading delimiter */
+        rx->pos = 0;
+        rx->esc = false;
+        return false;
+    }
+    if (rx->discard) {
+        return false;
+    }
+
+    /* Handle escape sequence decoding */
+    if (rx->esc) {
+        rx->esc = false;
+        if (byte == SLIP_ESC_END) {
+            byte = SLIP_END;            /* ESC ESC_END → END */
+        } else if (byte == SLIP_ESC_ESC) {
+            byte = SLIP_ESC;            /* ESC ESC_ESC → ESC */
+        } else {
+            return false;               /* invalid escape: byte dropped */
+        }
+    } else if (byte == SLIP_ESC) {
+        rx->esc = true;
+        return false;
+    }
+
+    if (rx->pos < rx->cap) {
+        rx->buf[rx->pos++] = byte;
+    } else {
+        rx_lost(rx);                    /* frame too large */
+    }
+    return false;
+}
+
+int slip_rx_poll(slip_rx_t *rx, tty_t *t) {
+    uint8_t byte;
+
+    if (!rx || !rx->buf) {
+        return 0;
+    }
+    while (!rx->ready && t && tty_read(t, &byte, 1) > 0) {
+        slip_rx_feed(rx, byte);
+    }
+    return rx->ready ? (int)rx->pos : 0;
+}
+
+void slip_rx_done(slip_rx_t *rx) {
+    if (rx->ready) {
+        rx->pos = 0;
+        rx->esc = false;
+        rx->ready = false;
+    }
+}
+
 /**
  * @brief Decode a SLIP frame from TTY RX buffer
  *
- * Reads bytes from TTY until a complete frame is received.
- * Handles escape sequence decoding per RFC 1055.
+ * A decoder that lives for one call: frames must arrive whole.
  *
  * @return Number of bytes in decoded frame, 0 if incomplete
  */
@@ -74,68 +236,383 @@ int slip_recv_packet(tty_t *t, uint8_t *buf, size_t len) {
         return 0;  /* Invalid parameters */
     }
 
-    size_t pos = 0;          /* Position in output buffer */
-    bool esc = false;        /* Escape sequence state */
-    uint8_t byte;
+    slip_rx_t rx;
+    slip_rx_init(&rx, buf, len > UINT16_MAX ? UINT16_MAX : (uint16_t)len);
+
+    /* Oversized frames are skipped up to their END */
+    return slip_rx_poll(&rx, t);
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - HEADER COMPRESSION (RFC 1144)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if CONFIG_NET_CSLIP_ENABLED
+
+/* Change mask of a compressed header (RFC 1144 section 3.2.2) */
+#define VJ_NEW_C   0x40u    /**< Slot id present */
+#define VJ_NEW_I   0x20u    /**< IP id delta present (else +1) */
+#define VJ_PUSH    0x10u    /**< TCP PSH flag */
+#define VJ_NEW_S   0x08u
+#define VJ_NEW_A   0x04u
+#define VJ_NEW_W   0x02u
+#define VJ_NEW_U   0x01u
+#define VJ_SPECIAL_I (VJ_NEW_S | VJ_NEW_W | VJ_NEW_U)            /**< Echoed terminal traffic */
+#define VJ_SPECIAL_D (VJ_NEW_S | VJ_NEW_A | VJ_NEW_W | VJ_NEW_U) /**< Unidirectional data */
+#define VJ_SPECIALS  VJ_SPECIAL_D
+
+/* Offsets in a 20-byte IPv4 header followed by the TCP header */
+#define VJ_IP_LEN   2u
+#define VJ_IP_ID    4u
+#define VJ_IP_PROTO 9u
+#define VJ_IP_SUM   10u
+#define VJ_TCP      20u
+#define VJ_TCP_SEQ  (VJ_TCP + 4u)
+#define VJ_TCP_ACK  (VJ_TCP + 8u)
+#define VJ_TCP_OFF  (VJ_TCP + 12u)
+#define VJ_TCP_FLAGS (VJ_TCP + 13u)
+#define VJ_TCP_WIN  (VJ_TCP + 14u)
+#define VJ_TCP_SUM  (VJ_TCP + 16u)
+#define VJ_TCP_URP  (VJ_TCP + 18u)
+
+#define VJ_FIN 0x01u
+#define VJ_SYN 0x02u
+#define VJ_RST 0x04u
+#define VJ_PSH 0x08u
+#define VJ_ACK 0x10u
+#define VJ_URG 0x20u
+
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return ((uint32_t)get16(p) << 16) | get16(p + 2);
+}
+
+static void put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    put16(p, (uint16_t)(v >> 16));
+    put16(p + 2, (uint16_t)v);
+}
+
+/* 1..255 in one byte, anything else as 0 and two bytes */
+static uint8_t *vj_encode(uint8_t *d, uint16_t v) {
+    if (v >= 1 && v <= 255) {
+        *d++ = (uint8_t)v;
+    } else {
+        *d++ = 0;
+        *d++ = (uint8_t)(v >> 8);
+        *d++ = (uint8_t)v;
+    }
+    return d;
+}
+
+static bool vj_decode(const uint8_t **p, const uint8_t *end, uint16_t *v) {
+    const uint8_t *s = *p;
+    if (s >= end) {
+        return false;
+    }
+    if (*s) {
+        *v = *s;
+        *p = s + 1;
+        return true;
+    }
+    if (end - s < 3) {
+        return false;
+    }
+    *v = get16(s + 1);
+    *p = s + 3;
+    return true;
+}
+
+/* The IPv4 header checksum of a rebuilt header */
+static void vj_ip_checksum(uint8_t *ip) {
+    uint32_t sum = 0;
+    put16(ip + VJ_IP_SUM, 0);
+    for (uint8_t i = 0; i < 20; i += 2) {
+        sum += get16(ip + i);
+    }
+    sum = (sum & 0xFFFFu) + (sum >> 16);
+    sum += sum >> 16;
+    put16(ip + VJ_IP_SUM, (uint16_t)~sum);
+}
+
+void slip_vj_init(slip_vj_t *vj, slip_vj_mode_t mode) {
+    memset(vj, 0, sizeof(*vj));
+    vj->mode = (uint8_t)mode;
+    vj->tx_last = 0xFF;
+    vj->toss = true;                /* nothing to apply deltas to yet */
+}
+
+bool slip_vj_tx_active(const slip_vj_t *vj) {
+    return vj && (vj->mode == SLIP_VJ_ON || (vj->mode == SLIP_VJ_AUTO && vj->peer));
+}
+
+size_t slip_vj_compress(slip_vj_t *vj, uint8_t *hdr, size_t *hlen, size_t total) {
+    size_t avail = *hlen;
+    *hlen = 0;
+
+    /* Only plain TCP segments in mid-connection are candidates; SYN,
+     * FIN, RST, fragments and TCP options go as ordinary IP */
+    if (!slip_vj_tx_active(vj) || avail < SLIP_VJ_TX_HDR || total < SLIP_VJ_TX_HDR ||
+        hdr[0] != 0x45 || hdr[VJ_IP_PROTO] != 6 || (get16(hdr + 6) & 0x3FFFu) ||
+        hdr[VJ_TCP_OFF] != 0x50 ||
+        (hdr[VJ_TCP_FLAGS] & (VJ_SYN | VJ_FIN | VJ_RST | VJ_ACK)) != VJ_ACK) {
+        return 0;
+    }
 
-    /* Read bytes from TTY until frame complete or no more data */
-    while (tty_rx_available(t) > 0) {
-        /* Read one byte from TTY */
-        int nread = tty_read(t, &byte, 1);
-        if (nread <= 0) {
-            break;  /* No more data available */
+    uint8_t s = 0xFF;
+    for (uint8_t i = 0; i < SLIP_VJ_TX_SLOTS; i++) {
+        const uint8_t *o = vj->tx[i].hdr;
+        if (vj->tx[i].len && memcmp(o + 12, hdr + 12, 8) == 0 &&
+            memcmp(o + VJ_TCP, hdr + VJ_TCP, 4) == 0) {
+            s = i;
+            break;
         }
+    }
 
-        /* Handle escape sequence decoding */
-        if (esc) {
-            if (byte == SLIP_ESC_END) {
-                byte = SLIP_END;  /* ESC ESC_END → END */
-            }
-            else if (byte == SLIP_ESC_ESC) {
-                byte = SLIP_ESC;  /* ESC ESC_ESC → ESC */
-            }
-            else {
-                /* Invalid escape sequence - discard and continue */
-                esc = false;
-                continue;
-            }
-            esc = false;
-        }
-        else {
-            /* Check for special characters */
-            if (byte == SLIP_END) {
-                /* Frame delimiter detected */
-                if (pos > 0) {
-                    /* Complete frame received - return it */
-                    return (int)pos;
-                }
-                /* Empty frame or leading delimiter - continue */
-                continue;
-            }
+    uint8_t deltas[15];
+    uint8_t *d = deltas;
+    uint8_t changes = 0;
+    uint8_t *o;
 
-            if (byte == SLIP_ESC) {
-                /* Start of escape sequence */
-                esc = true;
-                continue;
-            }
+    if (s == 0xFF) {
+        s = vj->tx_next;            /* new connection: recycle a slot */
+        vj->tx_next = (uint8_t)((s + 1u) % SLIP_VJ_TX_SLOTS);
+        goto uncompressed;
+    }
+    o = vj->tx[s].hdr;
+
+    /* Everything but length, id and checksums must match (RFC 1144 3.2.3) */
+    if (memcmp(o, hdr, 2) != 0 || memcmp(o + 6, hdr + 6, 4) != 0) {
+        goto uncompressed;
+    }
+    if (hdr[VJ_TCP_FLAGS] & VJ_URG) {
+        d = vj_encode(d, get16(hdr + VJ_TCP_URP));
+        changes |= VJ_NEW_U;
+    } else if (get16(hdr + VJ_TCP_URP) != get16(o + VJ_TCP_URP)) {
+        goto uncompressed;
+    }
+    uint16_t dw = (uint16_t)(get16(hdr + VJ_TCP_WIN) - get16(o + VJ_TCP_WIN));
+    if (dw) {
+        d = vj_encode(d, dw);
+        changes |= VJ_NEW_W;
+    }
+    uint32_t da = get32(hdr + VJ_TCP_ACK) - get32(o + VJ_TCP_ACK);
+    if (da) {
+        if (da > 0xFFFFu) {
+            goto uncompressed;
+        }
+        d = vj_encode(d, (uint16_t)da);
+        changes |= VJ_NEW_A;
+    }
+    uint32_t ds = get32(hdr + VJ_TCP_SEQ) - get32(o + VJ_TCP_SEQ);
+    if (ds) {
+        if (ds > 0xFFFFu) {
+            goto uncompressed;
+        }
+        d = vj_encode(d, (uint16_t)ds);
+        changes |= VJ_NEW_S;
+    }
+
+    uint16_t last_data = (uint16_t)(get16(o + VJ_IP_LEN) - SLIP_VJ_TX_HDR);
+    switch (changes) {
+    case 0:
+        /* Data after a bare ACK is fine; a repeat (retransmission or
+         * duplicate ACK) goes uncompressed so it is not mistaken */
+        if (get16(hdr + VJ_IP_LEN) != get16(o + VJ_IP_LEN) && last_data == 0) {
+            break;
+        }
+        goto uncompressed;
+    case VJ_SPECIAL_I:
+    case VJ_SPECIAL_D:
+        goto uncompressed;          /* would read as a special case */
+    case VJ_NEW_S | VJ_NEW_A:
+        if (ds == da && ds == last_data) {
+            changes = VJ_SPECIAL_I;
+            d = deltas;
+        }
+        break;
+    case VJ_NEW_S:
+        if (ds == last_data) {
+            changes = VJ_SPECIAL_D;
+            d = deltas;
+        }
+        break;
+    default:
+        break;
+    }
+    uint16_t di = (uint16_t)(get16(hdr + VJ_IP_ID) - get16(o + VJ_IP_ID));
+    if (di != 1) {
+        d = vj_encode(d, di);
+        changes |= VJ_NEW_I;
+    }
+    if (hdr[VJ_TCP_FLAGS] & VJ_PSH) {
+        changes |= VJ_PUSH;
+    }
+    memcpy(o, hdr, SLIP_VJ_TX_HDR);
+
+    /* type+changes, [slot], TCP checksum, deltas */
+    uint8_t *w = hdr;
+    if (vj->tx_last != s) {
+        *w++ = (uint8_t)(SLIP_TYPE_COMPRESSED_TCP | VJ_NEW_C | changes);
+        *w++ = s;
+        vj->tx_last = s;
+    } else {
+        *w++ = (uint8_t)(SLIP_TYPE_COMPRESSED_TCP | changes);
+    }
+    *w++ = o[VJ_TCP_SUM];
+    *w++ = o[VJ_TCP_SUM + 1];
+    memcpy(w, deltas, (size_t)(d - deltas));
+    *hlen = SLIP_VJ_TX_HDR;
+    return (size_t)(w - hdr) + (size_t)(d - deltas);
+
+uncompressed:
+    /* Whole header, with the slot id in the protocol byte */
+    memcpy(vj->tx[s].hdr, hdr, SLIP_VJ_TX_HDR);
+    vj->tx[s].len = SLIP_VJ_TX_HDR;
+    vj->tx_last = s;
+    hdr[VJ_IP_PROTO] = s;
+    hdr[0] |= SLIP_TYPE_UNCOMPRESSED_TCP;
+    *hlen = SLIP_VJ_TX_HDR;
+    return SLIP_VJ_TX_HDR;
+}
+
+static int vj_error(slip_vj_t *vj) {
+    vj->toss = true;
+    if (vj->rx_errors != UINT16_MAX) {
+        vj->rx_errors++;
+    }
+    return -1;
+}
+
+int slip_vj_uncompress(slip_vj_t *vj, uint8_t *buf, size_t len, size_t cap) {
+    if (!vj || vj->mode == SLIP_VJ_OFF || !len) {
+        return (int)len;
+    }
+
+    uint8_t type = buf[0];
+    if (!(type & SLIP_TYPE_COMPRESSED_TCP)) {
+        if (type < SLIP_TYPE_UNCOMPRESSED_TCP) {
+            return (int)len;        /* plain IP */
         }
 
-        /* Add decoded byte to buffer if space available */
-        if (pos < len) {
-            buf[pos++] = byte;
+        /* Restore the header and remember it for the deltas to come */
+        uint8_t s = buf[VJ_IP_PROTO];
+        buf[0] &= 0x4Fu;
+        buf[VJ_IP_PROTO] = 6;
+        size_t h = VJ_TCP + (size_t)(buf[VJ_TCP_OFF] >> 4) * 4u;
+        if (s >= SLIP_VJ_SLOTS || len < SLIP_VJ_TX_HDR || buf[0] != 0x45 ||
+            h < SLIP_VJ_TX_HDR || h > SLIP_VJ_HDR_MAX || h > len) {
+            return vj_error(vj);
         }
-        else {
-            /* Buffer full - discard frame (too large) */
-            /* Continue reading until END to synchronize */
-            while (tty_rx_available(t) > 0) {
-                if (tty_read(t, &byte, 1) > 0 && byte == SLIP_END) {
-                    break;
-                }
+        memcpy(vj->rx[s].hdr, buf, h);
+        vj->rx[s].len = (uint8_t)h;
+        vj->rx_last = s;
+        vj->toss = false;
+        vj->peer = true;
+        return (int)len;
+    }
+
+    const uint8_t *p = buf + 1, *end = buf + len;
+    uint8_t changes = type;
+    uint8_t s;
+    if (changes & VJ_NEW_C) {
+        if (p >= end || *p >= SLIP_VJ_SLOTS || !vj->rx[*p].len) {
+            return vj_error(vj);
+        }
+        s = *p++;
+        vj->rx_last = s;
+        vj->toss = false;
+    } else {
+        if (vj->toss) {
+            return vj_error(vj);    /* lost our place: wait for a slot id */
+        }
+        s = vj->rx_last;
+    }
+    if (end - p < 2) {
+        return vj_error(vj);
+    }
+
+    /* Work on a copy so a malformed packet leaves the slot intact */
+    uint8_t o[SLIP_VJ_HDR_MAX];
+    size_t h = vj->rx[s].len;
+    memcpy(o, vj->rx[s].hdr, h);
+    o[VJ_TCP_SUM] = *p++;
+    o[VJ_TCP_SUM + 1] = *p++;
+    if (changes & VJ_PUSH) {
+        o[VJ_TCP_FLAGS] |= VJ_PSH;
+    } else {
+        o[VJ_TCP_FLAGS] &= (uint8_t)~VJ_PSH;
+    }
+
+    uint16_t v;
+    uint16_t last_data = (uint16_t)(get16(o + VJ_IP_LEN) - h);
+    switch (changes & VJ_SPECIALS) {
+    case VJ_SPECIAL_I:
+        put32(o + VJ_TCP_ACK, get32(o + VJ_TCP_ACK) + last_data);
+        put32(o + VJ_TCP_SEQ, get32(o + VJ_TCP_SEQ) + last_data);
+        break;
+    case VJ_SPECIAL_D:
+        put32(o + VJ_TCP_SEQ, get32(o + VJ_TCP_SEQ) + last_data);
+        break;
+    default:
+        if (changes & VJ_NEW_U) {
+            if (!vj_decode(&p, end, &v)) {
+                return vj_error(vj);
             }
-            return 0;  /* Frame too large */
+            o[VJ_TCP_FLAGS] |= VJ_URG;
+            put16(o + VJ_TCP_URP, v);
+        } else {
+            o[VJ_TCP_FLAGS] &= (uint8_t)~VJ_URG;
         }
+        if (changes & VJ_NEW_W) {
+            if (!vj_decode(&p, end, &v)) {
+                return vj_error(vj);
+            }
+            put16(o + VJ_TCP_WIN, (uint16_t)(get16(o + VJ_TCP_WIN) + v));
+        }
+        if (changes & VJ_NEW_A) {
+            if (!vj_decode(&p, end, &v)) {
+                return vj_error(vj);
+            }
+            put32(o + VJ_TCP_ACK, get32(o + VJ_TCP_ACK) + v);
+        }
+        if (changes & VJ_NEW_S) {
+            if (!vj_decode(&p, end, &v)) {
+                return vj_error(vj);
+            }
+            put32(o + VJ_TCP_SEQ, get32(o + VJ_TCP_SEQ) + v);
+        }
+        break;
     }
+    if (changes & VJ_NEW_I) {
+        if (!vj_decode(&p, end, &v)) {
+            return vj_error(vj);
+        }
+    } else {
+        v = 1;
+    }
+    put16(o + VJ_IP_ID, (uint16_t)(get16(o + VJ_IP_ID) + v));
 
-    /* No complete frame available yet */
-    return 0;
+    /* Header back in front of the payload */
+    size_t payload = (size_t)(end - p);
+    size_t total = h + payload;
+    if (total > cap || total > UINT16_MAX) {
+        return vj_error(vj);
+    }
+    put16(o + VJ_IP_LEN, (uint16_t)total);
+    vj_ip_checksum(o);
+    memmove(buf + h, p, payload);
+    memcpy(buf, o, h);
+    memcpy(vj->rx[s].hdr, o, h);
+    vj->peer = true;
+    return (int)total;
 }
+
+#endif /* CONFIG_NET_CSLIP_ENABLED */
@@ -16,7 +16,9 @@
  * - ESC (0xDB): Escape character for encoding END/ESC in data
  *
  * ## Features
- * - Stateless encoder/decoder (no persistent state between packets)
+ * - Stateless encoder
+ * - Resumable decoder (slip_rx_t) fed a byte at a time from tty_poll()
+ *   or an RX ISR, so frames may arrive across any number of polls
  * - Zero-copy encoding where possible
  * - Suitable for tiny microcontrollers (8-bit AVR, Cortex-M0, etc.)
  * - Works with any TTY abstraction (UART, USB-CDC, etc.)
@@ -27,9 +29,20 @@
  * - END in data → ESC ESC_END (0xDB 0xDC)
  * - ESC in data → ESC ESC_ESC (0xDB 0xDD)
  *
+ * ## Header Compression (CSLIP)
+ * With net_cslip_enabled, slip_vj_t holds one link's RFC 1144 (Van
+ * Jacobson) state.  A TCP segment whose headers differ from the last
+ * one on its connection only in the usual ways (sequence, ack, window,
+ * IP id) goes out as a 3–7 byte delta instead of 40 header bytes.
+ * Per link, compression is off, on, or automatic: decode what arrives
+ * and start compressing once the peer does (Linux "adaptive" CSLIP).
+ * ipv4_set_cslip() applies it to the IPv4 stack.
+ *
  * ## Memory Footprint
  * - Flash: ~150 bytes (encoder + decoder)
- * - RAM: 0 bytes persistent state (stateless)
+ * - RAM: 11 bytes per slip_rx_t (AVR) plus its frame buffer
+ * - RAM: 6 + SLIP_VJ_SLOTS * 61 + SLIP_VJ_TX_SLOTS * 41 bytes per
+ *   slip_vj_t
  * - Stack: ~10 bytes during operations
  *
  * ## Usage
@@ -41,16 +54,23 @@
  * uint8_t tx_data[] = {0x45, 0x00, 0x00, 0x54, ...};  // IP packet
  * slip_send_packet(&serial, tx_data, sizeof(tx_data));
  *
- * // Receive packet
- * uint8_t rx_buf[1500];  // MTU size
- * int len = slip_recv_packet(&serial, rx_buf, sizeof(rx_buf));
- * if (len > 0) {
- *     // Process received packet
+ * // Receive packets, however the bytes trickle in
+ * static uint8_t frame[1500];  // MTU size
+ * static slip_rx_t rx;
+ * slip_rx_init(&rx, frame, sizeof(frame));
+ * while (1) {
+ *     tty_poll(&serial);
+ *     int len = slip_rx_poll(&rx, &serial);
+ *     if (len > 0) {
+ *         handle_ip_packet(frame, len);
+ *         slip_rx_done(&rx);
+ *     }
  * }
  * ```
  *
  * ## Limitations
- * - No compression (see RFC 1144 for CSLIP)
+ * - Header compression (RFC 1144 CSLIP) covers TCP only; other
+ *   datagrams go out as plain IP
  * - No error detection (use higher-layer checksums)
  * - No flow control (handled by serial hardware)
  */
@@ -64,6 +84,8 @@ extern "C" {
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+#include "avrix-config.h"
 
 /*═══════════════════════════════════════════════════════════════════
  * SLIP PROTOCOL CONSTANTS (RFC 1055)
@@ -108,6 +130,116 @@ extern "C" {
 /* TTY type forward declaration (defined in drivers/tty/tty.h) */
 typedef struct tty_s tty_t;
 
+/**
+ * @brief One segment of a frame for slip_send_iov()
+ */
+typedef struct {
+    const uint8_t *base;
+    size_t         len;
+} slip_iov_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * RECEIVER STATE
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Resumable SLIP decoder
+ *
+ * Decodes into a caller-provided buffer and keeps its place between
+ * calls, so a frame may arrive in any number of pieces.  Once a frame
+ * is complete it stays in @c buf, reported by every slip_rx_poll(),
+ * until slip_rx_done() hands the buffer back: each frame is delivered
+ * exactly once and never overwritten while in use.
+ *
+ * slip_rx_feed() may run in an RX ISR while the main loop consumes
+ * frames.  Bytes arriving while a frame is waiting cannot be stored;
+ * the frame they belong to is dropped whole (and counted) rather than
+ * delivered damaged.  slip_rx_poll() only reads the TTY when there is
+ * room, so on that path nothing is lost.
+ */
+typedef struct slip_rx {
+    uint8_t      *buf;      /**< Frame storage (caller-provided) */
+    uint16_t      cap;      /**< Capacity of @c buf in bytes */
+    uint16_t      pos;      /**< Bytes decoded so far (frame length when ready) */
+    bool          esc;      /**< Previous byte was SLIP_ESC */
+    bool          discard;  /**< Skipping to the next END (frame lost) */
+    volatile bool ready;    /**< @c buf holds a complete frame */
+    uint16_t      dropped;  /**< Frames lost to overflow (saturating) */
+} slip_rx_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * HEADER COMPRESSION STATE (RFC 1144)
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Receive connection slots (follows net_cslip_slots)
+ *
+ * The peer picks slot ids; Linux and RFC 1144 use 16.  Packets for a
+ * slot beyond the table are dropped.
+ */
+#ifndef SLIP_VJ_SLOTS
+#  if defined(CONFIG_NET_CSLIP_SLOTS)
+#    define SLIP_VJ_SLOTS CONFIG_NET_CSLIP_SLOTS
+#  else
+#    define SLIP_VJ_SLOTS 16
+#  endif
+#endif
+
+/** Transmit slots: one per local TCP connection is enough */
+#ifndef SLIP_VJ_TX_SLOTS
+#  if defined(CONFIG_NET_TCP_CONNS)
+#    define SLIP_VJ_TX_SLOTS CONFIG_NET_TCP_CONNS
+#  else
+#    define SLIP_VJ_TX_SLOTS 2
+#  endif
+#endif
+
+/** Longest header kept per receive slot: IPv4 + TCP with 40 option bytes */
+#define SLIP_VJ_HDR_MAX 60u
+
+/** Longest header kept per transmit slot: segments with options go uncompressed */
+#define SLIP_VJ_TX_HDR 40u
+
+/** Packet types, carried in the first byte of the frame */
+#define SLIP_TYPE_IP               0x40u
+#define SLIP_TYPE_UNCOMPRESSED_TCP 0x70u
+#define SLIP_TYPE_COMPRESSED_TCP   0x80u
+
+_Static_assert(SLIP_VJ_SLOTS >= 1 && SLIP_VJ_SLOTS <= 16, "net_cslip_slots is 1..16");
+_Static_assert(SLIP_VJ_TX_SLOTS >= 1 && SLIP_VJ_TX_SLOTS <= 16, "SLIP_VJ_TX_SLOTS is 1..16");
+
+/** How a link uses CSLIP */
+typedef enum {
+    SLIP_VJ_OFF = 0,    /**< Plain SLIP both ways */
+    SLIP_VJ_AUTO,       /**< Decode; compress once the peer has */
+    SLIP_VJ_ON          /**< Decode and compress */
+} slip_vj_mode_t;
+
+/**
+ * @brief One link's CSLIP state
+ *
+ * Each slot holds the last header seen on one TCP connection, so the
+ * next is sent as a difference.  Transmit slots are recycled round
+ * robin.
+ */
+typedef struct slip_vj {
+    uint8_t  mode;                  /**< slip_vj_mode_t */
+    bool     peer;                  /**< Peer has sent compressed TCP */
+    bool     toss;                  /**< Drop deltas until a slot id is sent */
+    uint8_t  tx_last;               /**< Slot of the last packet sent (0xFF none) */
+    uint8_t  tx_next;               /**< Next transmit slot to recycle */
+    uint8_t  rx_last;               /**< Slot of the last packet received */
+    uint16_t rx_errors;             /**< Undecodable packets dropped */
+    struct {
+        uint8_t len;                /**< 0 = unused */
+        uint8_t hdr[SLIP_VJ_TX_HDR];
+    } tx[SLIP_VJ_TX_SLOTS];
+    struct {
+        uint8_t len;
+        uint8_t hdr[SLIP_VJ_HDR_MAX];
+    } rx[SLIP_VJ_SLOTS];
+} slip_vj_t;
+
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - SLIP ENCODING/DECODING
  *═══════════════════════════════════════════════════════════════════*/
@@ -123,6 +255,10 @@ typedef struct tty_s tty_t;
  *    - Otherwise: send byte as-is
  * 3. Send END character (frame end)
  *
+ * Each run of bytes between END/ESC occurrences reaches tty_write()
+ * in one call, so a typical frame costs a handful of calls rather
+ * than one per byte.
+ *
  * @param t TTY descriptor (serial port)
  * @param buf Data buffer to encode and transmit
  * @param len Length of data buffer in bytes
@@ -139,11 +275,70 @@ typedef struct tty_s tty_t;
  */
 void slip_send_packet(tty_t *t, const uint8_t *buf, size_t len);
 
+/**
+ * @brief Encode and transmit one SLIP frame gathered from @p cnt segments
+ *
+ * The segments are framed as if they were one contiguous buffer, so a
+ * header and its payload need not be copied together first.
+ * Zero-length segments are skipped.
+ *
+ * @param t TTY descriptor (serial port)
+ * @param iov Segments, in order
+ * @param cnt Number of segments
+ */
+void slip_send_iov(tty_t *t, const slip_iov_t *iov, uint8_t cnt);
+
+/**
+ * @brief slip_send_packet() with the payload in program memory
+ *
+ * For frames that live in flash, e.g. a ROMFS file obtained with
+ * vfs_map() (VFS_MAP_PROGMEM), so they need no RAM copy.
+ *
+ * @param t TTY descriptor (serial port)
+ * @param buf Payload address in program memory
+ * @param len Payload length in bytes
+ *
+ * The payload is encoded through a 16-byte stack buffer, one
+ * tty_write() per buffer.
+ */
+void slip_send_packet_P(tty_t *t, const uint8_t *buf, size_t len);
+
+/**
+ * @brief Prepare @p rx to decode into @p buf (@p cap bytes)
+ */
+void slip_rx_init(slip_rx_t *rx, uint8_t *buf, uint16_t cap);
+
+/**
+ * @brief Decode one received byte
+ *
+ * Safe to call from an RX interrupt.
+ *
+ * @return true if a complete frame is now waiting in rx->buf
+ */
+bool slip_rx_feed(slip_rx_t *rx, uint8_t byte);
+
+/**
+ * @brief Move bytes from the TTY RX ring into @p rx
+ *
+ * Reads until a frame completes or the ring is empty, never past the
+ * end of a frame.
+ *
+ * @return Length of the waiting frame, or 0 if none is complete yet
+ */
+int slip_rx_poll(slip_rx_t *rx, tty_t *t);
+
+/**
+ * @brief Release the waiting frame so decoding can continue
+ */
+void slip_rx_done(slip_rx_t *rx);
+
 /**
  * @brief Decode a SLIP frame from TTY RX buffer
  *
  * Attempts to read and decode one complete SLIP frame from the TTY.
- * Returns immediately if no complete frame is available.
+ * Returns immediately if no complete frame is available.  A frame
+ * still arriving when the ring runs dry is lost; use slip_rx_t to
+ * resume across polls.
  *
  * Decoding algorithm:
  * 1. Read bytes from TTY until END character
@@ -160,7 +355,7 @@ void slip_send_packet(tty_t *t, const uint8_t *buf, size_t len);
  * @note Returns 0 if no complete frame is ready (non-blocking)
  * @note Discards incomplete frames if buffer is too small
  * @note Leading END characters (frame delimiters) are skipped
- * @note This function is stateless (no persistent decoder state)
+ * @note Stateless: partial frames do not survive between calls
  *
  * Example:
  * ```c
@@ -177,6 +372,64 @@ void slip_send_packet(tty_t *t, const uint8_t *buf, size_t len);
  */
 int slip_recv_packet(tty_t *t, uint8_t *buf, size_t len);
 
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - HEADER COMPRESSION
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if CONFIG_NET_CSLIP_ENABLED
+
+/**
+ * @brief Forget all connection state and set the link's @p mode
+ */
+void slip_vj_init(slip_vj_t *vj, slip_vj_mode_t mode);
+
+/**
+ * @brief True if datagrams sent on this link should be compressed
+ */
+bool slip_vj_tx_active(const slip_vj_t *vj);
+
+/**
+ * @brief Compress the headers of an outgoing datagram
+ *
+ * @param hdr The datagram's first bytes (SLIP_VJ_TX_HDR of them, or
+ *            all if it is shorter); rewritten with the header to send
+ * @param hlen In: bytes at @p hdr.  Out: datagram bytes the returned
+ *             header replaces (0: send the datagram unchanged)
+ * @param total Length of the whole datagram
+ * @return Bytes of replacement header at @p hdr
+ */
+size_t slip_vj_compress(slip_vj_t *vj, uint8_t *hdr, size_t *hlen, size_t total);
+
+/**
+ * @brief Restore a received frame to a plain IPv4 datagram, in place
+ *
+ * Plain IP frames are returned as they are.  A compressed header is
+ * expanded in front of the payload, which moves up to make room.
+ *
+ * @param buf Frame, rewritten in place
+ * @param len Frame length
+ * @param cap Capacity of @p buf
+ * @return Datagram length, or -1 if the frame must be dropped
+ */
+int slip_vj_uncompress(slip_vj_t *vj, uint8_t *buf, size_t len, size_t cap);
+
+#else /* Stubs */
+
+static inline void slip_vj_init(slip_vj_t *vj, slip_vj_mode_t mode) {
+    (void)vj; (void)mode;
+}
+static inline bool slip_vj_tx_active(const slip_vj_t *vj) {
+    (void)vj; return false;
+}
+static inline size_t slip_vj_compress(slip_vj_t *vj, uint8_t *hdr, size_t *hlen, size_t total) {
+    (void)vj; (void)hdr; (void)total; *hlen = 0; return 0;
+}
+static inline int slip_vj_uncompress(slip_vj_t *vj, uint8_t *buf, size_t len, size_t cap) {
+    (void)vj; (void)buf; (void)cap; return (int)len;
+}
+
+#endif /* CONFIG_NET_CSLIP_ENABLED */
+
 #ifdef __cplusplus
 }
 #endif
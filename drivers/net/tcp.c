@@ -0,0 +1,925 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file tcp.c
+ * @brief Minimal TCP over IPv4/SLIP (see tcp.h)
+ */
+
+#include "tcp.h"
+#include "netif.h"
+#include "kernel/sync/nk_event.h"
+#include "arch/common/hal.h"
+#include <string.h>
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONNECTION TABLE
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define TF_HANDLE     0x01u  /**< The application holds the handle */
+#define TF_RESET      0x02u  /**< Reset by the peer or timed out */
+#define TF_FIN_QUEUED 0x04u  /**< tcp_close(): FIN after queued data */
+#define TF_FIN_SENT   0x08u  /**< FIN is at snd_nxt - 1 */
+#define TF_ACK_NOW    0x10u  /**< Send an ACK on the next output */
+#define TF_DELACK     0x20u  /**< ACK owed by ack_at */
+#define TF_TIMER      0x40u  /**< rto_at armed (retransmit or TIME-WAIT) */
+#define TF_PASSIVE    0x80u  /**< Opened by tcp_listen() */
+
+/** Longest retransmission timeout after backing off */
+#define TCP_RTO_MAX_MS 32000u
+
+typedef struct {
+    tty_t   *tty;
+    uint32_t raddr;                 /**< Peer address, network order */
+    uint16_t lport, rport;          /**< Host order */
+    uint8_t  state;                 /**< tcp_state_t */
+    uint8_t  flags;                 /**< TF_* */
+    uint32_t snd_una;               /**< Oldest unacknowledged sequence */
+    uint32_t snd_nxt;               /**< Next sequence to send */
+    uint16_t snd_wnd;               /**< Peer's window from snd_una */
+    uint16_t mss;                   /**< Segment size we send */
+    uint32_t rcv_nxt;               /**< Next sequence expected */
+    uint32_t rto_at;                /**< Timer deadline (TF_TIMER) */
+    uint32_t ack_at;                /**< Delayed ACK deadline (TF_DELACK) */
+    uint16_t rto;                   /**< Current timeout, ms */
+    uint8_t  retries;
+    uint8_t  dupacks;
+    uint8_t  tx_head, tx_count;     /**< Segments queued from snd_una */
+    uint8_t  tx_sent;               /**< ... of which sent at least once */
+    uint8_t  rx_head, rx_count;     /**< In-order segments not yet read */
+    pbuf_t  *txq[TCP_WINDOW];
+    pbuf_t  *rxq[TCP_WINDOW];
+} tcb_t;
+
+static struct {
+    tcb_t    conn[TCP_MAX_CONNS];
+    uint32_t now;                   /**< Last tcp_timer() time, ms */
+    uint32_t iss;                   /**< Initial sequence generator */
+    uint16_t next_port;             /**< Next ephemeral port to try */
+} tcp;
+
+/* Sequence space comparisons (RFC 793 section 3.3) */
+static inline bool seq_lt(uint32_t a, uint32_t b) { return (int32_t)(a - b) < 0; }
+static inline bool seq_le(uint32_t a, uint32_t b) { return (int32_t)(a - b) <= 0; }
+
+static tcb_t *conn_at(int c) {
+    if (c < 0 || c >= TCP_MAX_CONNS || !(tcp.conn[c].flags & TF_HANDLE)) {
+        return NULL;
+    }
+    return &tcp.conn[c];
+}
+
+/* A slot is reusable once the application let go and the peer is done */
+static int conn_alloc(void) {
+    for (int i = 0; i < TCP_MAX_CONNS; i++) {
+        tcb_t *k = &tcp.conn[i];
+        if (!(k->flags & TF_HANDLE) && k->state == TCP_CLOSED) {
+            memset(k, 0, sizeof(*k));
+            k->flags = TF_HANDLE;
+            k->rto = TCP_RTO_MS;
+            k->mss = TCP_MSS;
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool port_in_use(uint16_t port) {
+    for (int i = 0; i < TCP_MAX_CONNS; i++) {
+        if (tcp.conn[i].state != TCP_CLOSED && tcp.conn[i].lport == port) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool listening_on(uint16_t port) {
+    for (int i = 0; i < TCP_MAX_CONNS; i++) {
+        if (tcp.conn[i].state == TCP_LISTEN && tcp.conn[i].lport == port) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void rx_flush(tcb_t *k) {
+    while (k->rx_count) {
+        pbuf_free(k->rxq[k->rx_head]);
+        k->rx_head = (uint8_t)((k->rx_head + 1u) % TCP_WINDOW);
+        k->rx_count--;
+    }
+}
+
+static void tx_flush(tcb_t *k) {
+    while (k->tx_count) {
+        pbuf_free(k->txq[k->tx_head]);
+        k->tx_head = (uint8_t)((k->tx_head + 1u) % TCP_WINDOW);
+        k->tx_count--;
+    }
+    k->tx_sent = 0;
+}
+
+/* Drop everything; the slot frees itself if nobody holds the handle */
+static void conn_drop(tcb_t *k, bool reset) {
+    rx_flush(k);
+    tx_flush(k);
+    k->state = TCP_CLOSED;
+    k->flags &= TF_HANDLE;
+    if (reset) {
+        k->flags |= TF_RESET;
+    }
+    nk_io_notify(NK_IO_NET);
+}
+
+static void timer_arm(tcb_t *k, uint32_t ms) {
+    k->rto_at = tcp.now + ms;
+    k->flags |= TF_TIMER;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * SEGMENT OUTPUT
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Window we advertise: one MSS per free receive slot */
+static uint16_t rcv_wnd(const tcb_t *k) {
+    return (uint16_t)((TCP_WINDOW - k->rx_count) * TCP_MSS);
+}
+
+static void fill_header(tcp_hdr_t *th, uint16_t sport, uint16_t dport,
+                        uint32_t seq, uint32_t ack, uint8_t flags, uint16_t wnd,
+                        uint8_t hlen) {
+    th->sport = ipv4_htons(sport);
+    th->dport = ipv4_htons(dport);
+    th->seq = ipv4_htonl(seq);
+    th->ack = ipv4_htonl(ack);
+    th->off = (uint8_t)((hlen / 4u) << 4);
+    th->flags = flags;
+    th->wnd = ipv4_htons(wnd);
+    th->checksum = 0;
+    th->urg = 0;
+}
+
+static void fill_checksum(tcp_hdr_t *th, uint32_t raddr, const void *payload, uint16_t hlen,
+                          uint16_t len) {
+    uint16_t sum = ipv4_pseudo_sum(ipv4_htonl(ipv4_addr()), raddr, IPV4_PROTO_TCP,
+                                   (uint16_t)(hlen + len));
+    sum = ipv4_checksum_partial(th, hlen, sum);
+    th->checksum = ipv4_htons((uint16_t)~ipv4_checksum_partial(payload, len, sum));
+}
+
+/* Control segment without payload, built on the stack */
+static void send_ctl(tty_t *t, uint32_t raddr, uint16_t lport, uint16_t rport,
+                     uint32_t seq, uint32_t ack, uint8_t flags, uint16_t wnd) {
+    struct __attribute__((packed)) {
+        ipv4_hdr_t ip;
+        tcp_hdr_t  tcp;
+        uint8_t    mss[4];
+    } s;
+    uint8_t hlen = (flags & TCP_SYN) ? TCP_HLEN + 4u : TCP_HLEN;
+
+    fill_header(&s.tcp, lport, rport, seq, ack, flags, wnd, hlen);
+    s.mss[0] = 2;                   /* kind: maximum segment size */
+    s.mss[1] = 4;
+    s.mss[2] = (uint8_t)(TCP_MSS >> 8);
+    s.mss[3] = (uint8_t)TCP_MSS;
+    fill_checksum(&s.tcp, raddr, NULL, hlen, 0);
+    ipv4_init_header(&s.ip, ipv4_addr(), ipv4_ntohl(raddr), IPV4_PROTO_TCP, hlen);
+    ipv4_send(t, &s.ip, &s.tcp, hlen);
+}
+
+/* Any segment we send carries our ACK, so nothing is owed afterwards */
+static void acked_now(tcb_t *k) {
+    k->flags &= (uint8_t)~(TF_ACK_NOW | TF_DELACK);
+}
+
+static void send_flags(tcb_t *k, uint32_t seq, uint8_t flags) {
+    send_ctl(k->tty, k->raddr, k->lport, k->rport, seq, k->rcv_nxt, flags, rcv_wnd(k));
+    if (flags & TCP_ACK) {
+        acked_now(k);
+    }
+}
+
+/* Data segment: the header goes in front of the payload in its pbuf */
+static void send_data(tcb_t *k, pbuf_t *p, uint32_t seq) {
+    uint16_t len = p->len;
+    tcp_hdr_t *th = (tcp_hdr_t *)pbuf_push(p, TCP_HLEN);
+
+    fill_header(th, k->lport, k->rport, seq, k->rcv_nxt, TCP_ACK | TCP_PSH, rcv_wnd(k),
+                TCP_HLEN);
+    fill_checksum(th, k->raddr, pbuf_data(p) + TCP_HLEN, TCP_HLEN, len);
+    ipv4_send_pbuf(k->tty, ipv4_addr(), ipv4_ntohl(k->raddr), IPV4_PROTO_TCP, p);
+    pbuf_pull(p, PBUF_HLEN_IP + TCP_HLEN);  /* back to the payload view */
+    acked_now(k);
+}
+
+static bool has_outstanding(const tcb_t *k) {
+    return k->snd_una != k->snd_nxt || k->tx_count > k->tx_sent;
+}
+
+/* Send what the windows allow, the FIN once the data is out, and owed ACKs */
+static void output(tcb_t *k) {
+    switch (k->state) {
+    case TCP_ESTABLISHED:
+    case TCP_CLOSE_WAIT:
+    case TCP_FIN_WAIT_1:
+    case TCP_CLOSING:
+    case TCP_LAST_ACK:
+        break;
+    default:
+        if (k->flags & TF_ACK_NOW) {
+            send_flags(k, k->snd_nxt, TCP_ACK);
+        }
+        return;
+    }
+
+    uint32_t seq = k->snd_nxt;
+    while (k->tx_sent < k->tx_count) {
+        pbuf_t *p = k->txq[(k->tx_head + k->tx_sent) % TCP_WINDOW];
+        if ((uint32_t)(seq + p->len - k->snd_una) > k->snd_wnd) {
+            break;                  /* the timer probes a closed window */
+        }
+        send_data(k, p, seq);
+        seq += p->len;
+        k->snd_nxt = seq;
+        k->tx_sent++;
+    }
+
+    if ((k->flags & (TF_FIN_QUEUED | TF_FIN_SENT)) == TF_FIN_QUEUED &&
+        k->tx_sent == k->tx_count) {
+        send_flags(k, k->snd_nxt, TCP_FIN | TCP_ACK);
+        k->snd_nxt++;
+        k->flags |= TF_FIN_SENT;
+        k->state = k->state == TCP_CLOSE_WAIT ? TCP_LAST_ACK : TCP_FIN_WAIT_1;
+    }
+
+    if (k->flags & TF_ACK_NOW) {
+        send_flags(k, k->snd_nxt, TCP_ACK);
+    }
+    if (has_outstanding(k) && !(k->flags & TF_TIMER)) {
+        timer_arm(k, k->rto);
+    }
+}
+
+/* Resend the oldest unacknowledged segment (timeout or fast retransmit) */
+static void retransmit(tcb_t *k) {
+    switch (k->state) {
+    case TCP_SYN_SENT:
+        send_flags(k, k->snd_una, TCP_SYN);
+        return;
+    case TCP_SYN_RCVD:
+        send_flags(k, k->snd_una, TCP_SYN | TCP_ACK);
+        return;
+    default:
+        break;
+    }
+    if (k->tx_count) {
+        pbuf_t *p = k->txq[k->tx_head];
+        send_data(k, p, k->snd_una);
+        if (!k->tx_sent) {          /* zero-window probe */
+            k->tx_sent = 1;
+            k->snd_nxt = k->snd_una + p->len;
+        }
+    } else if (k->flags & TF_FIN_SENT) {
+        send_flags(k, k->snd_nxt - 1u, TCP_FIN | TCP_ACK);
+    }
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * SEGMENT INPUT
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Reply to a segment no connection wants (RFC 793 "Reset Generation") */
+static void send_rst_for(tty_t *t, const ipv4_hdr_t *h, const tcp_hdr_t *th, uint16_t seglen) {
+    uint16_t sport = ipv4_ntohs(th->dport), dport = ipv4_ntohs(th->sport);
+
+    if (th->flags & TCP_RST) {
+        return;
+    }
+    if (th->flags & TCP_ACK) {
+        send_ctl(t, h->saddr, sport, dport, ipv4_ntohl(th->ack), 0, TCP_RST, 0);
+    } else {
+        send_ctl(t, h->saddr, sport, dport, 0, ipv4_ntohl(th->seq) + seglen,
+                 TCP_RST | TCP_ACK, 0);
+    }
+}
+
+static tcb_t *conn_find(const ipv4_hdr_t *h, const tcp_hdr_t *th) {
+    uint16_t lport = ipv4_ntohs(th->dport), rport = ipv4_ntohs(th->sport);
+    tcb_t *listener = NULL;
+
+    for (int i = 0; i < TCP_MAX_CONNS; i++) {
+        tcb_t *k = &tcp.conn[i];
+        if (k->state == TCP_CLOSED || k->lport != lport) {
+            continue;
+        }
+        if (k->state == TCP_LISTEN) {
+            listener = k;
+        } else if (k->rport == rport && k->raddr == h->saddr) {
+            return k;
+        }
+    }
+    return listener;
+}
+
+/* Peer MSS from the SYN's options; 536 when absent (RFC 1122 4.2.2.6) */
+static uint16_t parse_mss(const uint8_t *opt, uint16_t len) {
+    uint16_t mss = 536;
+
+    while (len) {
+        if (opt[0] == 0) {
+            break;
+        }
+        if (opt[0] == 1) {
+            opt++;
+            len--;
+            continue;
+        }
+        if (len < 2 || opt[1] < 2 || opt[1] > len) {
+            break;
+        }
+        if (opt[0] == 2 && opt[1] == 4) {
+            mss = (uint16_t)((opt[2] << 8) | opt[3]);
+        }
+        len = (uint16_t)(len - opt[1]);
+        opt += opt[1];
+    }
+    return mss < TCP_MSS ? (mss ? mss : 1) : TCP_MSS;
+}
+
+static uint32_t next_iss(void) {
+    tcp.iss += 64000u;
+    return tcp.iss + tcp.now * 250u;    /* RFC 793: about 4 us per tick */
+}
+
+/* Process an ACK for a synchronized connection; false if unacceptable */
+static bool ack_input(tcb_t *k, const tcp_hdr_t *th, uint16_t dlen) {
+    uint32_t ack = ipv4_ntohl(th->ack);
+    uint16_t wnd = ipv4_ntohs(th->wnd);
+
+    if (seq_lt(k->snd_nxt, ack)) {
+        k->flags |= TF_ACK_NOW;     /* acks data we never sent */
+        return false;
+    }
+    if (seq_lt(ack, k->snd_una)) {
+        return true;                /* old duplicate: ignore the ACK */
+    }
+
+    if (ack == k->snd_una) {
+        /* RFC 5681 duplicate ACK: nothing new, same window, data out */
+        if (!dlen && wnd == k->snd_wnd && k->tx_sent && ++k->dupacks == 3) {
+            retransmit(k);
+            timer_arm(k, k->rto);
+        }
+        k->snd_wnd = wnd;
+        k->retries = 0;
+        return true;
+    }
+
+    /* New data acknowledged: release whole segments, trim a partial one */
+    uint32_t acked = ack - k->snd_una;
+    k->snd_una = ack;
+    while (acked && k->tx_sent) {
+        pbuf_t *p = k->txq[k->tx_head];
+        if (acked < p->len) {
+            pbuf_pull(p, (uint16_t)acked);
+            break;
+        }
+        acked -= p->len;
+        pbuf_free(p);
+        k->tx_head = (uint8_t)((k->tx_head + 1u) % TCP_WINDOW);
+        k->tx_count--;
+        k->tx_sent--;
+    }
+    k->snd_wnd = wnd;
+    k->dupacks = 0;
+    k->retries = 0;
+    k->rto = TCP_RTO_MS;
+    k->flags &= (uint8_t)~TF_TIMER;
+    if (has_outstanding(k)) {
+        timer_arm(k, k->rto);
+    }
+
+    if ((k->flags & TF_FIN_SENT) && ack == k->snd_nxt) {
+        switch (k->state) {             /* our FIN is acknowledged */
+        case TCP_FIN_WAIT_1:
+            k->state = TCP_FIN_WAIT_2;
+            break;
+        case TCP_CLOSING:
+            k->state = TCP_TIME_WAIT;
+            timer_arm(k, TCP_TIME_WAIT_MS);
+            break;
+        case TCP_LAST_ACK:
+            conn_drop(k, false);
+            return false;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+/* Queue in-order payload; small segments join the previous one's pbuf */
+static bool data_input(tcb_t *k, pbuf_t *p) {
+    if (!(k->flags & TF_HANDLE)) {
+        return true;                /* closed for reading: ACK and discard */
+    }
+    if (k->rx_count) {
+        pbuf_t *tail = k->rxq[(k->rx_head + k->rx_count - 1u) % TCP_WINDOW];
+        if (pbuf_tailroom(tail) >= p->len) {
+            hal_memcpy_fast(pbuf_put(tail, p->len), pbuf_data(p), p->len);
+            return true;
+        }
+    }
+    if (k->rx_count == TCP_WINDOW) {
+        return false;
+    }
+    pbuf_ref(p);                    /* tcp_input() drops its own reference */
+    k->rxq[(k->rx_head + k->rx_count) % TCP_WINDOW] = p;
+    k->rx_count++;
+    return true;
+}
+
+static void fin_input(tcb_t *k) {
+    k->rcv_nxt++;
+    k->flags |= TF_ACK_NOW;
+    switch (k->state) {
+    case TCP_SYN_RCVD:
+    case TCP_ESTABLISHED:
+        k->state = TCP_CLOSE_WAIT;
+        break;
+    case TCP_FIN_WAIT_1:
+        k->state = TCP_CLOSING;     /* our FIN is still unacknowledged */
+        break;
+    case TCP_FIN_WAIT_2:
+        k->state = TCP_TIME_WAIT;
+        timer_arm(k, TCP_TIME_WAIT_MS);
+        break;
+    default:
+        break;
+    }
+}
+
+static void syn_input(tcb_t *k, tty_t *t, const ipv4_hdr_t *h, const tcp_hdr_t *th,
+                      uint16_t hlen) {
+    k->tty = t;
+    k->raddr = h->saddr;
+    k->rport = ipv4_ntohs(th->sport);
+    k->rcv_nxt = ipv4_ntohl(th->seq) + 1u;
+    k->snd_wnd = ipv4_ntohs(th->wnd);
+    k->mss = parse_mss((const uint8_t *)(th + 1), (uint16_t)(hlen - TCP_HLEN));
+}
+
+bool tcp_input(tty_t *t, pbuf_t *p, const ipv4_hdr_t *h) {
+    if (!p) {
+        return false;
+    }
+
+    /* Trim link padding, then check the header and checksum */
+    uint16_t len = (uint16_t)(ipv4_ntohs(h->len) - sizeof(ipv4_hdr_t));
+    const tcp_hdr_t *th = (const tcp_hdr_t *)pbuf_data(p);
+    uint16_t hlen = (uint16_t)((th->off >> 4) * 4u);
+    if (len > p->len || len < TCP_HLEN || hlen < TCP_HLEN || hlen > len) {
+        pbuf_free(p);
+        return false;
+    }
+    p->len = len;
+    uint16_t sum = ipv4_pseudo_sum(h->saddr, h->daddr, IPV4_PROTO_TCP, len);
+    if (ipv4_checksum_partial(th, len, sum) != 0xFFFFu) {
+        pbuf_free(p);
+        return false;
+    }
+
+    uint8_t flags = th->flags;
+    uint32_t seq = ipv4_ntohl(th->seq);
+    uint16_t dlen = (uint16_t)(len - hlen);
+    uint16_t seglen = (uint16_t)(dlen + !!(flags & TCP_SYN) + !!(flags & TCP_FIN));
+    tcb_t *k = conn_find(h, th);
+    bool taken = false;
+
+    if (!k) {
+        send_rst_for(t, h, th, seglen);
+        pbuf_free(p);
+        return false;
+    }
+
+    switch (k->state) {
+    case TCP_LISTEN:
+        if (flags & TCP_RST) {
+            break;
+        }
+        if (flags & TCP_ACK) {
+            send_rst_for(t, h, th, seglen);
+            break;
+        }
+        if (flags & TCP_SYN) {
+            syn_input(k, t, h, th, hlen);
+            k->snd_una = next_iss();
+            k->snd_nxt = k->snd_una + 1u;
+            k->state = TCP_SYN_RCVD;
+            send_flags(k, k->snd_una, TCP_SYN | TCP_ACK);
+            timer_arm(k, k->rto);
+            taken = true;
+        }
+        break;
+
+    case TCP_SYN_SENT:
+        if ((flags & TCP_ACK) && ipv4_ntohl(th->ack) != k->snd_nxt) {
+            send_rst_for(t, h, th, seglen);
+            break;
+        }
+        if (flags & TCP_RST) {
+            if (flags & TCP_ACK) {
+                conn_drop(k, true);     /* connection refused */
+            }
+            break;
+        }
+        if ((flags & (TCP_SYN | TCP_ACK)) == (TCP_SYN | TCP_ACK)) {
+            syn_input(k, t, h, th, hlen);
+            k->snd_una = k->snd_nxt;
+            k->state = TCP_ESTABLISHED;
+            k->retries = 0;
+            k->rto = TCP_RTO_MS;
+            k->flags = (uint8_t)((k->flags & ~TF_TIMER) | TF_ACK_NOW);
+            output(k);
+            taken = true;
+        }
+        break;              /* a bare SYN (simultaneous open) is ignored */
+
+    default: {
+        /* Acceptability (RFC 793 p. 69): some part inside the window */
+        int32_t early = (int32_t)(k->rcv_nxt - seq);  /* bytes already had */
+        bool ok = seglen ? early >= 0 && early < (int32_t)seglen
+                         : early <= 0 && -early <= (int32_t)rcv_wnd(k);
+        if (!ok) {
+            if (!(flags & TCP_RST)) {
+                k->flags |= TF_ACK_NOW;     /* duplicate or out of order */
+                output(k);
+            }
+            break;
+        }
+        if (flags & TCP_RST) {
+            if (seq == k->rcv_nxt) {        /* RFC 5961: exact match only */
+                bool listen = k->state == TCP_SYN_RCVD &&
+                              (k->flags & (TF_PASSIVE | TF_HANDLE)) == (TF_PASSIVE | TF_HANDLE);
+                conn_drop(k, !listen);
+                if (listen) {
+                    k->state = TCP_LISTEN;
+                    k->flags |= TF_PASSIVE;
+                }
+            }
+            break;
+        }
+        if (flags & TCP_SYN) {
+            k->flags |= TF_ACK_NOW;         /* RFC 5961 challenge ACK */
+            output(k);
+            break;
+        }
+        if (!(flags & TCP_ACK)) {
+            break;
+        }
+        if (k->state == TCP_SYN_RCVD) {
+            if (ipv4_ntohl(th->ack) != k->snd_nxt) {
+                send_rst_for(t, h, th, seglen);
+                break;
+            }
+            k->snd_una = k->snd_nxt;
+            k->state = TCP_ESTABLISHED;
+            k->retries = 0;
+            k->rto = TCP_RTO_MS;
+            k->flags &= (uint8_t)~TF_TIMER;
+        }
+        if (!ack_input(k, th, dlen)) {
+            output(k);
+            break;
+        }
+
+        /* Payload past what we already have, then a FIN right after it */
+        pbuf_pull(p, hlen);
+        if (early > 0) {
+            uint16_t dup = (uint16_t)early < dlen ? (uint16_t)early : dlen;
+            pbuf_pull(p, dup);
+            dlen = (uint16_t)(dlen - dup);
+        }
+        bool fin = (flags & TCP_FIN) != 0;
+        if (dlen) {
+            switch (k->state) {
+            case TCP_ESTABLISHED:
+            case TCP_FIN_WAIT_1:
+            case TCP_FIN_WAIT_2:
+                if (data_input(k, p)) {
+                    k->rcv_nxt += dlen;
+                    /* ACK every second segment, else within TCP_DELACK_MS */
+                    if (k->flags & TF_DELACK) {
+                        k->flags |= TF_ACK_NOW;
+                    } else {
+                        k->flags |= TF_DELACK;
+                        k->ack_at = tcp.now + TCP_DELACK_MS;
+                    }
+                    taken = true;
+                } else {
+                    k->flags |= TF_ACK_NOW; /* no room: tell the peer */
+                    fin = false;
+                }
+                break;
+            default:
+                fin = false;        /* data after the peer's FIN */
+                break;
+            }
+        }
+        if (fin && seq_le(k->rcv_nxt, seq + seglen - 1u)) {
+            fin_input(k);
+        }
+        taken = true;
+        output(k);
+        break;
+    }
+    }
+
+    nk_io_notify(NK_IO_NET);        /* data, window or state may have moved */
+    pbuf_free(p);
+    return taken;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API IMPLEMENTATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+void tcp_init(void) {
+    for (int i = 0; i < TCP_MAX_CONNS; i++) {
+        conn_drop(&tcp.conn[i], false);
+        tcp.conn[i].flags = 0;
+    }
+    tcp.next_port = TCP_EPHEMERAL_BASE;
+}
+
+int tcp_listen(tty_t *t, uint16_t port) {
+    if (!port || listening_on(port)) {
+        return -1;
+    }
+    int c = conn_alloc();
+    if (c < 0) {
+        return -1;
+    }
+    tcb_t *k = &tcp.conn[c];
+    k->tty = t;
+    k->lport = port;
+    k->state = TCP_LISTEN;
+    k->flags |= TF_PASSIVE;
+    return c;
+}
+
+int tcp_connect(tty_t *t, uint32_t dst, uint16_t dport) {
+    if (!dport || (!t && !netif_route(dst))) {
+        return -1;
+    }
+
+    uint16_t port = 0;
+    for (uint16_t tries = 0; tries < TCP_MAX_CONNS + 1u && !port; tries++) {
+        uint16_t p = tcp.next_port < TCP_EPHEMERAL_BASE ? TCP_EPHEMERAL_BASE : tcp.next_port;
+        tcp.next_port = (uint16_t)(p + 1u);
+        if (!port_in_use(p)) {
+            port = p;
+        }
+    }
+    int c = port ? conn_alloc() : -1;
+    if (c < 0) {
+        return -1;
+    }
+
+    tcb_t *k = &tcp.conn[c];
+    k->tty = t;
+    k->raddr = ipv4_htonl(dst);
+    k->lport = port;
+    k->rport = dport;
+    k->snd_una = next_iss();
+    k->snd_nxt = k->snd_una + 1u;
+    k->state = TCP_SYN_SENT;
+    send_flags(k, k->snd_una, TCP_SYN);
+    timer_arm(k, k->rto);
+    return c;
+}
+
+tcp_state_t tcp_state(int c) {
+    tcb_t *k = conn_at(c);
+    return k ? (tcp_state_t)k->state : TCP_CLOSED;
+}
+
+bool tcp_reset(int c) {
+    tcb_t *k = conn_at(c);
+    return k && (k->flags & TF_RESET);
+}
+
+static bool can_queue(const tcb_t *k) {
+    if (k->flags & TF_FIN_QUEUED) {
+        return false;
+    }
+    switch (k->state) {
+    case TCP_SYN_SENT:
+    case TCP_SYN_RCVD:
+    case TCP_ESTABLISHED:
+    case TCP_CLOSE_WAIT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Last queued segment if it has not been sent yet (small writes join it) */
+static pbuf_t *tx_open_tail(tcb_t *k) {
+    if (k->tx_count <= k->tx_sent) {
+        return NULL;
+    }
+    return k->txq[(k->tx_head + k->tx_count - 1u) % TCP_WINDOW];
+}
+
+int tcp_send(int c, const void *buf, uint16_t len) {
+    tcb_t *k = conn_at(c);
+    const uint8_t *src = buf;
+    uint16_t done = 0;
+
+    if (!k || (!buf && len) || !can_queue(k)) {
+        return -1;
+    }
+
+    pbuf_t *tail = tx_open_tail(k);
+    if (tail && tail->len < k->mss) {
+        uint16_t n = (uint16_t)(k->mss - tail->len);
+        n = n < len ? n : len;
+        hal_memcpy_fast(pbuf_put(tail, n), src, n);
+        done = n;
+    }
+    while (done < len && k->tx_count < TCP_WINDOW) {
+        pbuf_t *p = pbuf_alloc(PBUF_HLEN_TRANSPORT);
+        if (!p) {
+            break;
+        }
+        uint16_t n = (uint16_t)(len - done) < k->mss ? (uint16_t)(len - done) : k->mss;
+        hal_memcpy_fast(pbuf_put(p, n), src + done, n);
+        done = (uint16_t)(done + n);
+        k->txq[(k->tx_head + k->tx_count) % TCP_WINDOW] = p;
+        k->tx_count++;
+    }
+    output(k);
+    return done;
+}
+
+int tcp_send_pbuf(int c, pbuf_t *p) {
+    tcb_t *k = conn_at(c);
+
+    if (!p) {
+        return -1;
+    }
+    if (!k || !can_queue(k) || k->tx_count == TCP_WINDOW || p->len > k->mss ||
+        pbuf_headroom(p) < PBUF_HLEN_TRANSPORT) {
+        pbuf_free(p);
+        return -1;
+    }
+    k->txq[(k->tx_head + k->tx_count) % TCP_WINDOW] = p;
+    k->tx_count++;
+    output(k);
+    return 0;
+}
+
+uint16_t tcp_sndbuf(int c) {
+    tcb_t *k = conn_at(c);
+
+    if (!k || !can_queue(k)) {
+        return 0;
+    }
+    pbuf_t *tail = tx_open_tail(k);
+    uint16_t room = (uint16_t)((TCP_WINDOW - k->tx_count) * k->mss);
+    return tail && tail->len < k->mss ? (uint16_t)(room + k->mss - tail->len) : room;
+}
+
+/* Reading reopened a window the peer saw as closed: tell it at once */
+static void rx_consumed(tcb_t *k) {
+    if (k->rx_count == TCP_WINDOW - 1u) {
+        k->flags |= TF_ACK_NOW;
+        output(k);
+    }
+}
+
+pbuf_t *tcp_recv_pbuf(int c) {
+    tcb_t *k = conn_at(c);
+
+    if (!k || !k->rx_count) {
+        return NULL;
+    }
+    pbuf_t *p = k->rxq[k->rx_head];
+    k->rx_head = (uint8_t)((k->rx_head + 1u) % TCP_WINDOW);
+    k->rx_count--;
+    rx_consumed(k);
+    return p;
+}
+
+int tcp_recv(int c, void *buf, uint16_t len) {
+    tcb_t *k = conn_at(c);
+    uint8_t *dst = buf;
+    uint16_t done = 0;
+
+    if (!k || (!buf && len)) {
+        return -1;
+    }
+    while (done < len && k->rx_count) {
+        pbuf_t *p = k->rxq[k->rx_head];
+        uint16_t n = (uint16_t)(len - done) < p->len ? (uint16_t)(len - done) : p->len;
+        hal_memcpy_fast(dst + done, pbuf_data(p), n);
+        pbuf_pull(p, n);
+        done = (uint16_t)(done + n);
+        if (!p->len) {
+            pbuf_free(tcp_recv_pbuf(c));
+        }
+    }
+    return done;
+}
+
+bool tcp_readable(int c) {
+    tcb_t *k = conn_at(c);
+
+    if (!k) {
+        return false;
+    }
+    if (k->rx_count) {
+        return true;
+    }
+    switch (k->state) {
+    case TCP_LISTEN:
+    case TCP_SYN_SENT:
+    case TCP_SYN_RCVD:
+    case TCP_ESTABLISHED:
+    case TCP_FIN_WAIT_1:
+    case TCP_FIN_WAIT_2:
+        return false;
+    default:
+        return true;                /* the peer's FIN is in, or it is gone */
+    }
+}
+
+void tcp_close(int c) {
+    tcb_t *k = conn_at(c);
+
+    if (!k) {
+        return;
+    }
+    rx_flush(k);
+    switch (k->state) {
+    case TCP_SYN_RCVD:
+    case TCP_ESTABLISHED:
+    case TCP_CLOSE_WAIT:
+        k->flags |= TF_FIN_QUEUED;
+        output(k);
+        break;
+    case TCP_LISTEN:
+    case TCP_SYN_SENT:
+        conn_drop(k, false);
+        break;
+    default:
+        break;                      /* already closing */
+    }
+    k->flags &= (uint8_t)~TF_HANDLE;
+}
+
+void tcp_abort(int c) {
+    tcb_t *k = conn_at(c);
+
+    if (!k) {
+        return;
+    }
+    if (k->state >= TCP_SYN_RCVD && k->state <= TCP_LAST_ACK) {
+        send_ctl(k->tty, k->raddr, k->lport, k->rport, k->snd_nxt, 0, TCP_RST, 0);
+    }
+    conn_drop(k, false);
+    k->flags = 0;
+}
+
+void tcp_timer(uint32_t now_ms) {
+    tcp.now = now_ms;
+
+    for (int i = 0; i < TCP_MAX_CONNS; i++) {
+        tcb_t *k = &tcp.conn[i];
+
+        if ((k->flags & TF_DELACK) && (int32_t)(now_ms - k->ack_at) >= 0) {
+            k->flags |= TF_ACK_NOW;
+            output(k);
+        }
+        if (!(k->flags & TF_TIMER) || (int32_t)(now_ms - k->rto_at) < 0) {
+            continue;
+        }
+        k->flags &= (uint8_t)~TF_TIMER;
+
+        if (k->state == TCP_TIME_WAIT) {
+            conn_drop(k, false);
+        } else if (k->retries == TCP_MAX_RETRIES) {
+            if (k->state != TCP_SYN_SENT) {
+                send_ctl(k->tty, k->raddr, k->lport, k->rport, k->snd_nxt, 0, TCP_RST, 0);
+            }
+            conn_drop(k, true);
+        } else {
+            k->retries++;
+            k->rto = k->rto < TCP_RTO_MAX_MS / 2u ? (uint16_t)(k->rto * 2u) : TCP_RTO_MAX_MS;
+            retransmit(k);
+            timer_arm(k, k->rto);
+        }
+    }
+}
@@ -0,0 +1,304 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file tcp.h
+ * @brief Minimal TCP (RFC 793/1122) over the IPv4/SLIP stack
+ *
+ * Reliable byte streams to a gateway without an lwIP port: a handful
+ * of connections, each with a fixed window of TCP_WINDOW pbufs in
+ * each direction.
+ *
+ * - Send: tcp_send() copies into MSS-sized segments queued in pbufs
+ *   (tcp_send_pbuf() queues the caller's pbuf itself).  At most
+ *   TCP_WINDOW segments are queued unacknowledged; each stays in its
+ *   pbuf until ACKed, so retransmission needs no other buffer.
+ * - Receive: in-order segments are queued in their pbufs, up to
+ *   TCP_WINDOW of them; the advertised window is the free slots times
+ *   the MSS.  Out-of-order segments are dropped and answered with an
+ *   immediate duplicate ACK.
+ * - Retransmission: one timer per connection (TCP_RTO_MS, doubling per
+ *   retry, TCP_MAX_RETRIES before the connection is reset), plus fast
+ *   retransmit of the oldest segment on the third duplicate ACK.
+ * - Delayed ACKs: an ACK goes out with the next segment sent, after
+ *   every second segment received, or TCP_DELACK_MS later.
+ *
+ * Not implemented: options other than MSS, window scaling, SACK,
+ * urgent data, simultaneous open, congestion control beyond the fixed
+ * window.
+ *
+ * Time comes from the application: call tcp_timer() with a
+ * millisecond clock every few tens of milliseconds, and ipv4_poll() (or
+ * udp_poll()) to feed received segments in.
+ *
+ * ## Usage
+ * ```c
+ * ipv4_set_addr(0x0A000001);
+ * tcp_timer(now_ms());
+ * int c = tcp_connect(&serial, 0x0A000002, 80);
+ * while (tcp_state(c) == TCP_SYN_SENT) { ...poll... }
+ * tcp_send(c, "GET / HTTP/1.0\r\n\r\n", 18);
+ * pbuf_t *p = tcp_recv_pbuf(c);                // in-order payload
+ * tcp_close(c);                                // FIN after queued data
+ * ```
+ *
+ * ## Memory Footprint
+ * - RAM: about 45 + 4 * TCP_WINDOW bytes per connection (AVR)
+ * - Pool: up to 2 * TCP_WINDOW pbufs per connection, plus the one
+ *   ipv4_recv_pbuf() decodes into; size net_pbufs for
+ *   net_tcp_conns * 2 * net_tcp_window + 1 to never stall on buffers
+ */
+
+#ifndef DRIVERS_NET_TCP_H
+#define DRIVERS_NET_TCP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ipv4.h"
+#include "pbuf.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Connection table size (follows net_tcp_conns) */
+#ifndef TCP_MAX_CONNS
+#  if defined(CONFIG_NET_TCP_CONNS)
+#    define TCP_MAX_CONNS CONFIG_NET_TCP_CONNS
+#  else
+#    define TCP_MAX_CONNS 2
+#  endif
+#endif
+
+/** Segments per direction per connection (follows net_tcp_window) */
+#ifndef TCP_WINDOW
+#  if defined(CONFIG_NET_TCP_WINDOW)
+#    define TCP_WINDOW CONFIG_NET_TCP_WINDOW
+#  else
+#    define TCP_WINDOW 2
+#  endif
+#endif
+
+/** Largest segment payload we send or accept (follows net_tcp_mss) */
+#ifndef TCP_MSS
+#  if defined(CONFIG_NET_TCP_MSS)
+#    define TCP_MSS CONFIG_NET_TCP_MSS
+#  else
+#    define TCP_MSS 536
+#  endif
+#endif
+
+#ifndef TCP_RTO_MS
+#  define TCP_RTO_MS 1000u          /**< First retransmission timeout */
+#endif
+#ifndef TCP_MAX_RETRIES
+#  define TCP_MAX_RETRIES 6         /**< Retransmissions before a reset */
+#endif
+#ifndef TCP_DELACK_MS
+#  define TCP_DELACK_MS 200u        /**< Longest an ACK is held back */
+#endif
+#ifndef TCP_TIME_WAIT_MS
+#  define TCP_TIME_WAIT_MS 2000u    /**< TIME-WAIT (a shortened 2 MSL) */
+#endif
+
+/** First port handed out to tcp_connect() */
+#define TCP_EPHEMERAL_BASE 49152u
+
+_Static_assert(TCP_MAX_CONNS >= 1 && TCP_MAX_CONNS <= 8, "net_tcp_conns is 1..8");
+_Static_assert(TCP_WINDOW >= 1 && TCP_WINDOW <= 8, "net_tcp_window is 1..8");
+_Static_assert(TCP_MSS >= 64 && TCP_MSS <= IPV4_MTU - 40, "TCP_MSS must fit one pbuf");
+
+/*═══════════════════════════════════════════════════════════════════
+ * TCP HEADER (RFC 793)
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef struct {
+    uint16_t sport;
+    uint16_t dport;
+    uint32_t seq;
+    uint32_t ack;
+    uint8_t  off;        /**< Data offset in words, high nibble */
+    uint8_t  flags;      /**< TCP_FIN ... TCP_ACK */
+    uint16_t wnd;
+    uint16_t checksum;
+    uint16_t urg;
+} __attribute__((packed)) tcp_hdr_t;
+
+#define TCP_HLEN ((uint16_t)sizeof(tcp_hdr_t))
+
+#define TCP_FIN 0x01u
+#define TCP_SYN 0x02u
+#define TCP_RST 0x04u
+#define TCP_PSH 0x08u
+#define TCP_ACK 0x10u
+
+/** Connection states (RFC 793 section 3.2) */
+typedef enum {
+    TCP_CLOSED = 0,
+    TCP_LISTEN,
+    TCP_SYN_SENT,
+    TCP_SYN_RCVD,
+    TCP_ESTABLISHED,
+    TCP_FIN_WAIT_1,
+    TCP_FIN_WAIT_2,
+    TCP_CLOSE_WAIT,
+    TCP_CLOSING,
+    TCP_LAST_ACK,
+    TCP_TIME_WAIT
+} tcp_state_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if CONFIG_NET_TCP_ENABLED
+
+/**
+ * @brief Drop every connection (queued pbufs are freed)
+ */
+void tcp_init(void);
+
+/**
+ * @brief Wait for one connection on @p port
+ *
+ * The handle becomes the connection when a SYN arrives; listen again
+ * for the next one.  A NULL @p t accepts on any link.
+ *
+ * @return Connection, or -1 if the table is full or @p port is 0
+ */
+int tcp_listen(tty_t *t, uint16_t port);
+
+/**
+ * @brief Open a connection to @p dst:@p dport (sends the SYN)
+ *
+ * A NULL @p t sends through the interface routing @p dst (netif.h).
+ *
+ * @return Connection, or -1 if the table is full or there is no route
+ */
+int tcp_connect(tty_t *t, uint32_t dst, uint16_t dport);
+
+/**
+ * @brief State of @p c (TCP_CLOSED for a bad handle)
+ */
+tcp_state_t tcp_state(int c);
+
+/**
+ * @brief True if @p c was reset by the peer or timed out
+ */
+bool tcp_reset(int c);
+
+/**
+ * @brief Queue up to @p len bytes for sending
+ *
+ * Copies into MSS-sized pbufs and sends what the peer's window allows.
+ *
+ * @return Bytes queued (less than @p len when the window or the pool
+ *         is full), or -1 if @p c cannot send
+ */
+int tcp_send(int c, const void *buf, uint16_t len);
+
+/**
+ * @brief Queue the payload in @p p (at most the MSS) for sending
+ *
+ * Needs PBUF_HLEN_TRANSPORT bytes of headroom.  Takes @p p, also on
+ * failure.
+ *
+ * @return 0 on success, -1 if @p c cannot send or its window is full
+ */
+int tcp_send_pbuf(int c, pbuf_t *p);
+
+/**
+ * @brief Room for tcp_send(), in bytes
+ */
+uint16_t tcp_sndbuf(int c);
+
+/**
+ * @brief Take the oldest received segment without copying
+ *
+ * @return pbuf holding in-order payload (the caller frees it), or NULL
+ */
+pbuf_t *tcp_recv_pbuf(int c);
+
+/**
+ * @brief Copy up to @p len received bytes into @p buf
+ *
+ * @return Bytes copied; 0 if nothing is queued (check tcp_state() for
+ *         end of stream); -1 on a bad handle
+ */
+int tcp_recv(int c, void *buf, uint16_t len);
+
+/**
+ * @brief True if tcp_recv() on @p c would not wait: data is queued, or
+ *        the peer has closed its side (or reset) and it returns 0
+ */
+bool tcp_readable(int c);
+
+/**
+ * @brief Close @p c: FIN after queued data, then release the handle
+ *
+ * Received data not yet read is freed.  The slot is reused once the
+ * close handshake completes; the handle must not be used again.
+ */
+void tcp_close(int c);
+
+/**
+ * @brief Reset @p c at once and release the handle
+ */
+void tcp_abort(int c);
+
+/**
+ * @brief Deliver a received TCP segment
+ *
+ * @p p holds the TCP header and payload, as returned by
+ * ipv4_recv_pbuf() with header @p h.  Consumes @p p.  Segments for
+ * no connection are answered with a reset on @p t.
+ *
+ * @return true if a connection took it
+ */
+bool tcp_input(tty_t *t, pbuf_t *p, const ipv4_hdr_t *h);
+
+/**
+ * @brief Advance TCP time to @p now_ms: retransmissions, delayed ACKs
+ *        and TIME-WAIT expiry
+ */
+void tcp_timer(uint32_t now_ms);
+
+#else /* Stubs */
+
+static inline void tcp_init(void) {}
+static inline int tcp_listen(tty_t *t, uint16_t port) { (void)t; (void)port; return -1; }
+static inline int tcp_connect(tty_t *t, uint32_t dst, uint16_t dport) {
+    (void)t; (void)dst; (void)dport; return -1;
+}
+static inline tcp_state_t tcp_state(int c) { (void)c; return TCP_CLOSED; }
+static inline bool tcp_reset(int c) { (void)c; return false; }
+static inline int tcp_send(int c, const void *buf, uint16_t len) {
+    (void)c; (void)buf; (void)len; return -1;
+}
+static inline int tcp_send_pbuf(int c, pbuf_t *p) { (void)c; pbuf_free(p); return -1; }
+static inline uint16_t tcp_sndbuf(int c) { (void)c; return 0; }
+static inline pbuf_t *tcp_recv_pbuf(int c) { (void)c; return NULL; }
+static inline int tcp_recv(int c, void *buf, uint16_t len) {
+    (void)c; (void)buf; (void)len; return -1;
+}
+static inline bool tcp_readable(int c) { (void)c; return false; }
+static inline void tcp_close(int c) { (void)c; }
+static inline void tcp_abort(int c) { (void)c; }
+static inline bool tcp_input(tty_t *t, pbuf_t *p, const ipv4_hdr_t *h) {
+    (void)t; (void)h; pbuf_free(p); return false;
+}
+static inline void tcp_timer(uint32_t now_ms) { (void)now_ms; }
+
+#endif /* CONFIG_NET_TCP_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_NET_TCP_H */
@@ -0,0 +1,258 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file udp.c
+ * @brief UDP sockets over IPv4/SLIP (see udp.h)
+ */
+
+#include "udp.h"
+#include "kernel/sync/nk_event.h"
+#include <string.h>
+
+/*═══════════════════════════════════════════════════════════════════
+ * SOCKET TABLE
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef struct {
+    uint16_t port;                  /**< Bound port (host order), 0 = free */
+    uint8_t  head;                  /**< Oldest queued datagram */
+    uint8_t  count;                 /**< Datagrams queued */
+    pbuf_t  *q[UDP_RX_QUEUE];
+} udp_sock_t;
+
+static struct {
+    udp_sock_t sock[UDP_MAX_SOCKETS];
+    uint16_t   next_port;           /**< Next ephemeral port to try */
+    uint16_t   dropped;
+} udp;
+
+static udp_sock_t *sock_at(int s) {
+    if (s < 0 || s >= UDP_MAX_SOCKETS || !udp.sock[s].port) {
+        return NULL;
+    }
+    return &udp.sock[s];
+}
+
+static int sock_find(uint16_t port) {
+    for (int i = 0; i < UDP_MAX_SOCKETS; i++) {
+        if (udp.sock[i].port == port) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void drop(pbuf_t *p) {
+    pbuf_free(p);
+    if (udp.dropped != UINT16_MAX) {
+        udp.dropped++;
+    }
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * CHECKSUM
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Fill u->checksum for header @p u followed by @p len payload bytes */
+static void udp_fill_checksum(udp_hdr_t *u, uint32_t daddr, const void *payload, uint16_t len) {
+    u->checksum = 0;
+    uint16_t sum = ipv4_pseudo_sum(ipv4_htonl(ipv4_addr()), daddr, IPV4_PROTO_UDP, ipv4_ntohs(u->len));
+    sum = ipv4_checksum_partial(u, UDP_HLEN, sum);
+    sum = (uint16_t)~ipv4_checksum_partial(payload, len, sum);
+    u->checksum = ipv4_htons(sum ? sum : 0xFFFFu);   /* 0 would mean "none" */
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API IMPLEMENTATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+void udp_init(uint32_t local_addr) {
+    for (int i = 0; i < UDP_MAX_SOCKETS; i++) {
+        if (udp.sock[i].port) {
+            udp_close(i);
+        }
+    }
+    ipv4_set_addr(local_addr);
+    udp.next_port = UDP_EPHEMERAL_BASE;
+    udp.dropped = 0;
+}
+
+int udp_bind(uint16_t port) {
+    if (port == 0) {
+        /* Ephemeral range wraps within 49152..65535 */
+        for (uint16_t tries = 0; tries < UDP_MAX_SOCKETS + 1u && !port; tries++) {
+            uint16_t p = udp.next_port < UDP_EPHEMERAL_BASE ? UDP_EPHEMERAL_BASE
+                                                            : udp.next_port;
+            udp.next_port = (uint16_t)(p + 1u);
+            if (sock_find(p) < 0) {
+                port = p;
+            }
+        }
+        if (!port) {
+            return -1;
+        }
+    } else if (sock_find(port) >= 0) {
+        return -1;  /* Already bound */
+    }
+
+    int s = sock_find(0);
+    if (s < 0) {
+        return -1;  /* Table full */
+    }
+    memset(&udp.sock[s], 0, sizeof(udp.sock[s]));
+    udp.sock[s].port = port;
+    return s;
+}
+
+void udp_close(int s) {
+    udp_sock_t *k = sock_at(s);
+    pbuf_t *p;
+
+    if (!k) {
+        return;
+    }
+    while ((p = udp_recv_pbuf(s, NULL, NULL)) != NULL) {
+        pbuf_free(p);
+    }
+    k->port = 0;
+}
+
+uint16_t udp_port(int s) {
+    udp_sock_t *k = sock_at(s);
+    return k ? k->port : 0;
+}
+
+int udp_sendto(tty_t *t, int s, uint32_t dst, uint16_t dport,
+               const void *buf, uint16_t len) {
+    udp_sock_t *k = sock_at(s);
+
+    if (!k || (!buf && len) || len > UDP_MAX_PAYLOAD) {
+        return -1;
+    }
+
+    /* Both headers in one block, the payload gathered after them */
+    struct __attribute__((packed)) {
+        ipv4_hdr_t ip;
+        udp_hdr_t  udp;
+    } h;
+    ipv4_init_header(&h.ip, ipv4_addr(), dst, IPV4_PROTO_UDP,
+                     (uint16_t)(UDP_HLEN + len));
+    h.udp.sport = ipv4_htons(k->port);
+    h.udp.dport = ipv4_htons(dport);
+    h.udp.len = ipv4_htons((uint16_t)(UDP_HLEN + len));
+    udp_fill_checksum(&h.udp, h.ip.daddr, buf, len);
+
+    if (ipv4_output(t, &h, sizeof(h), buf, len) < 0) {
+        return -1;
+    }
+    return len;
+}
+
+int udp_send_pbuf(tty_t *t, int s, uint32_t dst, uint16_t dport, pbuf_t *p) {
+    udp_sock_t *k = sock_at(s);
+
+    if (!k || !p || pbuf_headroom(p) < PBUF_HLEN_IP + UDP_HLEN) {
+        return -1;
+    }
+
+    uint16_t len = p->len;
+    udp_hdr_t *u = (udp_hdr_t *)pbuf_push(p, UDP_HLEN);
+    u->sport = ipv4_htons(k->port);
+    u->dport = ipv4_htons(dport);
+    u->len = ipv4_htons((uint16_t)(UDP_HLEN + len));
+    udp_fill_checksum(u, ipv4_htonl(dst), pbuf_data(p) + UDP_HLEN, len);
+    return ipv4_send_pbuf(t, ipv4_addr(), dst, IPV4_PROTO_UDP, p);
+}
+
+pbuf_t *udp_recv_pbuf(int s, uint32_t *src, uint16_t *sport) {
+    udp_sock_t *k = sock_at(s);
+
+    if (!k || !k->count) {
+        return NULL;
+    }
+    pbuf_t *p = k->q[k->head];
+    k->head = (uint8_t)((k->head + 1u) % UDP_RX_QUEUE);
+    k->count--;
+
+    /* The headers udp_input() pulled are still in front of the data */
+    const udp_hdr_t *u = (const udp_hdr_t *)(pbuf_data(p) - UDP_HLEN);
+    const ipv4_hdr_t *ip = (const ipv4_hdr_t *)((const uint8_t *)u - sizeof(ipv4_hdr_t));
+    if (src) {
+        *src = ipv4_ntohl(ip->saddr);
+    }
+    if (sport) {
+        *sport = ipv4_ntohs(u->sport);
+    }
+    return p;
+}
+
+int udp_recvfrom(int s, void *buf, uint16_t len, uint32_t *src, uint16_t *sport) {
+    if (!sock_at(s) || (!buf && len)) {
+        return -1;
+    }
+    pbuf_t *p = udp_recv_pbuf(s, src, sport);
+    if (!p) {
+        return 0;
+    }
+    uint16_t n = pbuf_copy_out(p, buf, len);
+    pbuf_free(p);
+    return n;
+}
+
+int udp_pending(int s) {
+    udp_sock_t *k = sock_at(s);
+    return k ? k->count : -1;
+}
+
+bool udp_input(pbuf_t *p, const ipv4_hdr_t *h) {
+    if (!p) {
+        return false;
+    }
+    if (!h || p->len < UDP_HLEN || pbuf_headroom(p) < sizeof(ipv4_hdr_t)) {
+        drop(p);
+        return false;
+    }
+
+    const udp_hdr_t *u = (const udp_hdr_t *)pbuf_data(p);
+    uint16_t ulen = ipv4_ntohs(u->len);
+    if (ulen < UDP_HLEN || ulen > pbuf_chain_len(p)) {
+        drop(p);
+        return false;
+    }
+    pbuf_trim(p, ulen);             /* strip link-layer padding */
+
+    if (u->checksum) {
+        /* Over every buffer of a reassembled chain; all but the last
+         * hold a multiple of 8 bytes, so the words line up */
+        uint16_t sum = ipv4_pseudo_sum(h->saddr, h->daddr, IPV4_PROTO_UDP, ulen);
+        for (const pbuf_t *q = p; q; q = q->next) {
+            sum = ipv4_checksum_partial(q->buf + q->off, q->len, sum);
+        }
+        if (sum != 0xFFFFu) {       /* valid sums to all ones */
+            drop(p);
+            return false;
+        }
+    }
+
+    int s = sock_find(ipv4_ntohs(u->dport));
+    udp_sock_t *k = s >= 0 && u->dport ? &udp.sock[s] : NULL;
+    if (!k || k->count == UDP_RX_QUEUE) {
+        drop(p);
+        return false;
+    }
+    pbuf_pull(p, UDP_HLEN);
+    k->q[(k->head + k->count) % UDP_RX_QUEUE] = p;
+    k->count++;
+    nk_io_notify(NK_IO_NET);
+    return true;
+}
+
+int udp_poll(tty_t *t) {
+    return ipv4_poll(t);
+}
+
+uint16_t udp_dropped(void) {
+    return udp.dropped;
+}
@@ -0,0 +1,241 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file udp.h
+ * @brief UDP (RFC 768) over the IPv4/SLIP stack
+ *
+ * Sockets are small integers indexing a table of UDP_MAX_SOCKETS bound
+ * ports.  udp_poll() (or ipv4_poll()) takes datagrams off the line with
+ * ipv4_recv_pbuf() and queues each one, still in its pbuf, on the
+ * socket bound to its destination port; datagrams for unbound ports or
+ * full queues are dropped.
+ *
+ * Two ways to receive:
+ * - udp_recv_pbuf() hands over the queued pbuf itself: no copy; the
+ *   caller frees it
+ * - udp_recvfrom() copies the payload out and frees the pbuf
+ *
+ * and two to send:
+ * - udp_sendto() gathers the headers and the caller's buffer into one
+ *   SLIP frame without assembling it anywhere
+ * - udp_send_pbuf() builds both headers in the pbuf's headroom
+ *   (allocate it with PBUF_HLEN_TRANSPORT)
+ *
+ * Checksums are computed and verified with ipv4_checksum_partial()
+ * over the pseudo-header and the datagram; a received checksum of 0
+ * means the sender did not compute one.
+ *
+ * ## Usage
+ * ```c
+ * udp_init(0x0A000001);                       // 10.0.0.1
+ * int s = udp_bind(7000);
+ * udp_sendto(&serial, s, 0x0A000002, 7000, "hi", 2);
+ *
+ * while (1) {
+ *     tty_poll(&serial);
+ *     udp_poll(&serial);
+ *     uint32_t from; uint16_t port;
+ *     pbuf_t *p = udp_recv_pbuf(s, &from, &port);
+ *     if (p) {
+ *         handle(pbuf_data(p), p->len);
+ *         pbuf_free(p);
+ *     }
+ * }
+ * ```
+ *
+ * ## Memory Footprint
+ * - RAM: 4 + UDP_MAX_SOCKETS * (6 + UDP_RX_QUEUE pointers) bytes
+ * - Received datagrams live in the pbuf pool (net_pbufs)
+ */
+
+#ifndef DRIVERS_NET_UDP_H
+#define DRIVERS_NET_UDP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "ipv4.h"
+#include "pbuf.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Bound-port table size (follows net_udp_sockets)
+ */
+#ifndef UDP_MAX_SOCKETS
+#  if defined(CONFIG_NET_UDP_SOCKETS)
+#    define UDP_MAX_SOCKETS CONFIG_NET_UDP_SOCKETS
+#  else
+#    define UDP_MAX_SOCKETS 4
+#  endif
+#endif
+
+/** Datagrams queued per socket before new ones are dropped */
+#ifndef UDP_RX_QUEUE
+#  define UDP_RX_QUEUE 2
+#endif
+
+/** First port handed out by udp_bind(0) */
+#define UDP_EPHEMERAL_BASE 49152u
+
+_Static_assert(UDP_MAX_SOCKETS >= 1 && UDP_MAX_SOCKETS <= 16, "net_udp_sockets is 1..16");
+_Static_assert(UDP_RX_QUEUE >= 1 && UDP_RX_QUEUE <= 255, "UDP_RX_QUEUE is 1..255");
+
+/*═══════════════════════════════════════════════════════════════════
+ * UDP HEADER (RFC 768)
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef struct {
+    uint16_t sport;      /**< Source port */
+    uint16_t dport;      /**< Destination port */
+    uint16_t len;        /**< Header + payload length */
+    uint16_t checksum;   /**< Over pseudo-header + datagram; 0 = none */
+} __attribute__((packed)) udp_hdr_t;
+
+#define UDP_HLEN ((uint16_t)sizeof(udp_hdr_t))
+
+/** Largest payload of one datagram (fragmented beyond IPV4_MTU) */
+#define UDP_MAX_PAYLOAD ((uint16_t)(IPV4_DGRAM_MAX - sizeof(ipv4_hdr_t) - UDP_HLEN))
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if CONFIG_NET_UDP_ENABLED
+
+/**
+ * @brief Reset the socket table and set the local address
+ *
+ * Queued datagrams are freed.  @p local_addr (host byte order) becomes
+ * the ipv4_set_addr() source address of everything sent.
+ */
+void udp_init(uint32_t local_addr);
+
+/**
+ * @brief Bind a socket to @p port (0 picks a free ephemeral port)
+ *
+ * @return Socket, or -1 if the port is taken or the table is full
+ */
+int udp_bind(uint16_t port);
+
+/**
+ * @brief Unbind @p s and free its queued datagrams
+ */
+void udp_close(int s);
+
+/**
+ * @brief Local port of @p s, or 0 if it is not bound
+ */
+uint16_t udp_port(int s);
+
+/**
+ * @brief Send @p len bytes from @p buf to @p dst:@p dport
+ *
+ * A NULL @p t sends through the interface routing @p dst (netif.h).
+ *
+ * @return @p len on success, -1 on a bad socket, an oversized payload
+ *         or no route
+ */
+int udp_sendto(tty_t *t, int s, uint32_t dst, uint16_t dport,
+               const void *buf, uint16_t len);
+
+/**
+ * @brief Send the payload in @p p to @p dst:@p dport
+ *
+ * Needs PBUF_HLEN_TRANSPORT (or at least IPv4 + UDP) bytes of headroom.
+ * On return @p p holds the whole datagram and is still the caller's.
+ *
+ * @return 0 on success, -1 on a bad socket or too little headroom
+ */
+int udp_send_pbuf(tty_t *t, int s, uint32_t dst, uint16_t dport, pbuf_t *p);
+
+/**
+ * @brief Take the oldest queued datagram on @p s without copying
+ *
+ * @param src Sender address (host order), or NULL
+ * @param sport Sender port, or NULL
+ * @return pbuf holding the payload (the caller frees it), or NULL if
+ *         none is queued.  A reassembled datagram continues in
+ *         @c next; pbuf_chain_len() gives the whole payload length.
+ */
+pbuf_t *udp_recv_pbuf(int s, uint32_t *src, uint16_t *sport);
+
+/**
+ * @brief Copy the oldest queued datagram on @p s into @p buf
+ *
+ * A payload longer than @p len is truncated; the rest is discarded.
+ *
+ * @return Bytes copied, 0 if none is queued, -1 on a bad socket
+ */
+int udp_recvfrom(int s, void *buf, uint16_t len, uint32_t *src, uint16_t *sport);
+
+/**
+ * @brief Datagrams queued on @p s (for poll()), or -1 on a bad socket
+ */
+int udp_pending(int s);
+
+/**
+ * @brief Deliver a received UDP datagram
+ *
+ * @p p holds the UDP header and payload, as returned by
+ * ipv4_recv_pbuf() with header @p h.  Consumes @p p.
+ *
+ * @return true if it was queued on a socket
+ */
+bool udp_input(pbuf_t *p, const ipv4_hdr_t *h);
+
+/**
+ * @brief Receive every complete datagram waiting in @p t's RX ring
+ *
+ * Same as ipv4_poll(): other enabled protocols get theirs too.
+ *
+ * @return Number of datagrams accepted (queued on sockets)
+ */
+int udp_poll(tty_t *t);
+
+/**
+ * @brief Datagrams dropped: bad checksum or length, no socket, full queue
+ */
+uint16_t udp_dropped(void);
+
+#else /* Stubs */
+
+static inline void udp_init(uint32_t local_addr) { (void)local_addr; }
+static inline int udp_bind(uint16_t port) { (void)port; return -1; }
+static inline void udp_close(int s) { (void)s; }
+static inline uint16_t udp_port(int s) { (void)s; return 0; }
+static inline int udp_sendto(tty_t *t, int s, uint32_t dst, uint16_t dport,
+                             const void *buf, uint16_t len) {
+    (void)t; (void)s; (void)dst; (void)dport; (void)buf; (void)len; return -1;
+}
+static inline int udp_send_pbuf(tty_t *t, int s, uint32_t dst, uint16_t dport, pbuf_t *p) {
+    (void)t; (void)s; (void)dst; (void)dport; (void)p; return -1;
+}
+static inline pbuf_t *udp_recv_pbuf(int s, uint32_t *src, uint16_t *sport) {
+    (void)s; (void)src; (void)sport; return NULL;
+}
+static inline int udp_recvfrom(int s, void *buf, uint16_t len, uint32_t *src, uint16_t *sport) {
+    (void)s; (void)buf; (void)len; (void)src; (void)sport; return -1;
+}
+static inline int udp_pending(int s) { (void)s; return -1; }
+static inline bool udp_input(pbuf_t *p, const ipv4_hdr_t *h) {
+    (void)h; pbuf_free(p); return false;
+}
+static inline int udp_poll(tty_t *t) { (void)t; return 0; }
+static inline uint16_t udp_dropped(void) { return 0; }
+
+#endif /* CONFIG_NET_UDP_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DRIVERS_NET_UDP_H */
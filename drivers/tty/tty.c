@@ -12,6 +12,11 @@
 #include "tty.h"
 #include <string.h>
 
+#if TTY_WATERMARKS
+#  include "arch/common/hal.h"
+#  include "kernel/sched/workq.h"
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * HELPER MACROS
  *═══════════════════════════════════════════════════════════════════*/
@@ -31,56 +36,80 @@
 /**
  * @brief Read bytes from ring buffer
  *
+ * Copies the span up to the wrap point and the rest from the start (at
+ * most two memcpy calls), then frees the slots with one tail store.
+ *
  * @return Number of bytes read
  */
-static int ring_read(uint8_t *buf, uint8_t *head, uint8_t *tail,
-                     uint8_t mask, uint8_t *dst, size_t len) {
-    size_t count = 0;
-
-    while (count < len && *tail != *head) {
-        dst[count++] = buf[*tail];
-        *tail = RING_WRAP(*tail + 1, mask);  /* Fast modulo */
+static int ring_read(const uint8_t *buf, volatile tty_idx_t *head,
+                     volatile tty_idx_t *tail, tty_idx_t mask,
+                     uint8_t *dst, size_t len) {
+    tty_idx_t t = *tail;
+    size_t n = RING_WRAP((tty_idx_t)(tty_idx_load(head) - t), mask);
+
+    if (n > len) {
+        n = len;
+    }
+    if (n == 0) {
+        return 0;
+    }
+    size_t first = (size_t)mask + 1u - t;               /* up to the wrap */
+    if (first > n) {
+        first = n;
     }
+    memcpy(dst, buf + t, first);
+    memcpy(dst + first, buf, n - first);
 
-    return (int)count;
+    TTY_BARRIER();                          /* Copy before freeing the slots */
+    tty_idx_store(tail, RING_WRAP((tty_idx_t)(t + n), mask));
+    return (int)n;
 }
 
 /**
  * @brief Write bytes to ring buffer
  *
+ * Same two-segment copy as ring_read(); the bytes are published with
+ * one head store once they are all in place.
+ *
  * @return Number of bytes written
  */
-static int ring_write(uint8_t *buf, uint8_t *head, uint8_t *tail,
-                      uint8_t mask, const uint8_t *src, size_t len) {
-    size_t count = 0;
-
-    while (count < len) {
-        uint8_t next_head = RING_WRAP(*head + 1, mask);  /* Fast modulo */
-
-        if (next_head == *tail) {
-            break;  /* Buffer full */
-        }
-
-        buf[*head] = src[count++];
-        *head = next_head;
+static int ring_write(uint8_t *buf, volatile tty_idx_t *head,
+                      volatile tty_idx_t *tail, tty_idx_t mask,
+                      const uint8_t *src, size_t len) {
+    tty_idx_t h = *head;
+    size_t n = RING_WRAP((tty_idx_t)(tty_idx_load(tail) - h - 1u), mask);
+
+    if (n > len) {
+        n = len;
+    }
+    if (n == 0) {
+        return 0;
     }
+    size_t first = (size_t)mask + 1u - h;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(buf + h, src, first);
+    memcpy(buf, src + first, n - first);
 
-    return (int)count;
+    TTY_BARRIER();                          /* Store before publishing it */
+    tty_idx_store(head, RING_WRAP((tty_idx_t)(h + n), mask));
+    return (int)n;
 }
 
 /**
  * @brief Get number of bytes available in ring buffer
  */
-static inline size_t ring_available(uint8_t head, uint8_t tail, uint8_t mask) {
-    return RING_WRAP(head - tail, mask);
+static inline size_t ring_available(tty_idx_t head, tty_idx_t tail, tty_idx_t mask) {
+    return RING_WRAP((tty_idx_t)(head - tail), mask);
 }
 
 /**
  * @brief Get number of free bytes in ring buffer
  */
-static inline size_t ring_free(uint8_t head, uint8_t tail, uint8_t mask) {
+static inline size_t ring_free(tty_idx_t head, tty_idx_t tail, tty_idx_t mask) {
     /* Free space = size - used - 1 (one slot reserved for full detection) */
-    return RING_WRAP(tail - head - 1, mask);
+    return RING_WRAP((tty_idx_t)(tail - head - 1u), mask);
 }
 
 /*═══════════════════════════════════════════════════════════════════
@@ -90,7 +119,7 @@ static inline size_t ring_free(uint8_t head, uint8_t tail, uint8_t mask) {
 /**
  * @brief Initialize TTY instance
  */
-void tty_init(tty_t *t, uint8_t *rx_buf, uint8_t *tx_buf, uint8_t size,
+void tty_init(tty_t *t, uint8_t *rx_buf, uint8_t *tx_buf, uint16_t size,
               tty_putc_fn putc, tty_getc_fn getc) {
     /* Store buffer pointers */
     t->rx_buf = rx_buf;
@@ -104,15 +133,35 @@ void tty_init(tty_t *t, uint8_t *rx_buf, uint8_t *tx_buf, uint8_t size,
 
     /* Store size and compute mask (size must be power-of-2) */
     t->size = size;
-    t->mask = size - 1;  /* NOVEL: Precompute mask for fast modulo */
+    t->mask = (tty_idx_t)(size - 1u);  /* NOVEL: Precompute mask for fast modulo */
 
     /* Store callbacks */
     t->putc = putc;
     t->getc = getc;
+    t->kick = NULL;
 
     /* Initialize overflow tracking */
     t->rx_overflow = false;
 
+#if TTY_IDLE_HOLD
+    t->idle_held = false;
+#endif
+
+#if TTY_WATERMARKS
+    t->on_event = NULL;
+    t->wm_events = 0;
+    t->rx_armed = false;
+    t->tx_armed = false;
+    t->wm_pending = 0;
+#endif
+
+#if TTY_BLOCKING
+    t->rx_wait = NK_WAITQ_INIT;
+    t->tx_wait = NK_WAITQ_INIT;
+    t->rx_want = 0;
+    t->tx_want = 0;
+#endif
+
 #if TTY_ENABLE_STATS
     /* Initialize statistics */
     t->rx_bytes = 0;
@@ -121,6 +170,15 @@ void tty_init(tty_t *t, uint8_t *rx_buf, uint8_t *tx_buf, uint8_t size,
 #endif
 }
 
+/**
+ * @brief Initialize TTY instance for interrupt-driven RX/TX
+ */
+void tty_init_irq(tty_t *t, uint8_t *rx_buf, uint8_t *tx_buf, uint16_t size,
+                  tty_kick_fn kick) {
+    tty_init(t, rx_buf, tx_buf, size, NULL, NULL);
+    t->kick = kick;
+}
+
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - DATA TRANSFER
  *═══════════════════════════════════════════════════════════════════*/
@@ -135,9 +193,10 @@ void tty_poll(tty_t *t) {
         return;  /* No RX callback */
     }
 
+    tty_idx_t start = t->rx_head;
     int c;
     while ((c = t->getc()) >= 0) {
-        uint8_t next_head = RING_WRAP(t->rx_head + 1, t->mask);
+        tty_idx_t next_head = RING_WRAP((tty_idx_t)(t->rx_head + 1u), t->mask);
 
         if (next_head == t->rx_tail) {
             /* Buffer overflow - set flag and stop polling */
@@ -156,6 +215,10 @@ void tty_poll(tty_t *t) {
         t->rx_bytes++;
 #endif
     }
+
+    if (t->rx_head != start) {
+        tty_rx_notify(t, t->rx_head);
+    }
 }
 
 /**
@@ -168,6 +231,9 @@ int tty_read(tty_t *t, uint8_t *dst, size_t len) {
     /* Clear overflow flag on successful read */
     if (count > 0) {
         t->rx_overflow = false;
+#if TTY_WATERMARKS
+        t->rx_armed = (t->wm_events & TTY_EV_RX_HIGH) != 0;
+#endif
     }
 
     return count;
@@ -180,6 +246,30 @@ int tty_read(tty_t *t, uint8_t *dst, size_t len) {
  * This version keeps the same immediate-flush behavior but is more explicit.
  */
 int tty_write(tty_t *t, const uint8_t *src, size_t len) {
+    if (t->kick) {
+        /* Interrupt-driven: queue, and let the TX ISR drain it */
+#if TTY_WATERMARKS
+        /* Armed before the bytes can drain, so the crossing is not missed */
+        if (len && (t->wm_events & TTY_EV_TX_LOW)) {
+            t->tx_armed = true;
+        }
+#endif
+        int count = ring_write(t->tx_buf, &t->tx_head, &t->tx_tail,
+                               t->mask, src, len);
+        if (count > 0) {
+#if TTY_IDLE_HOLD
+            /* Held before the flag is set, so the ISR never drops a
+             * hold that was not taken yet */
+            if (!t->idle_held) {
+                nk_idle_hold(HAL_SLEEP_IDLE);
+                t->idle_held = true;
+            }
+#endif
+            t->kick();
+        }
+        return count;
+    }
+
     if (!t->putc) {
         return 0;  /* No TX callback */
     }
@@ -191,7 +281,7 @@ int tty_write(tty_t *t, const uint8_t *src, size_t len) {
     /* Immediately flush all buffered bytes */
     while (t->tx_tail != t->tx_head) {
         t->putc(t->tx_buf[t->tx_tail]);
-        t->tx_tail = RING_WRAP(t->tx_tail + 1, t->mask);
+        t->tx_tail = RING_WRAP((tty_idx_t)(t->tx_tail + 1u), t->mask);
 
 #if TTY_ENABLE_STATS
         t->tx_bytes++;
@@ -209,7 +299,7 @@ int tty_write(tty_t *t, const uint8_t *src, size_t len) {
  * @brief Get number of bytes available in RX buffer
  */
 size_t tty_rx_available(const tty_t *t) {
-    return ring_available(t->rx_head, t->rx_tail, t->mask);
+    return ring_available(tty_idx_load(&t->rx_head), t->rx_tail, t->mask);
 }
 
 /**
@@ -218,7 +308,7 @@ size_t tty_rx_available(const tty_t *t) {
  * NOVEL: New function (original didn't have this)
  */
 size_t tty_tx_free(const tty_t *t) {
-    return ring_free(t->tx_head, t->tx_tail, t->mask);
+    return ring_free(t->tx_head, tty_idx_load(&t->tx_tail), t->mask);
 }
 
 /**
@@ -232,6 +322,173 @@ bool tty_overflow_occurred(tty_t *t) {
     return occurred;
 }
 
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - WATERMARKS
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if TTY_WATERMARKS
+
+/**
+ * @brief Deliver deferred events (work queue, task context)
+ */
+static void tty_wm_work(void *arg) {
+    tty_t *t = arg;
+    uint8_t ev = hal_atomic_exchange_u8(&t->wm_pending, 0);  /* later ones post again */
+
+    if (ev && t->on_event) {
+        t->on_event(t, ev, t->event_arg);
+    }
+}
+
+/**
+ * @brief Report watermark event @p ev (from tty_rx_notify/tty_tx_notify)
+ */
+void tty_wm_fire(tty_t *t, uint8_t ev) {
+    if (ev == TTY_EV_RX_HIGH) {
+        t->rx_armed = false;
+    } else {
+        t->tx_armed = false;
+    }
+    if (!t->on_event) {
+        return;
+    }
+    if (!t->wm_defer) {
+        t->on_event(t, ev, t->event_arg);
+        return;
+    }
+    uint8_t was = t->wm_pending;
+    t->wm_pending = (uint8_t)(was | ev);
+    if (!was && !nk_work_post(tty_wm_work, t)) {
+        t->wm_pending = 0;      /* queue full: fire again once re-armed */
+    }
+}
+
+/**
+ * @brief Set watermarks and the event callback
+ */
+void tty_set_watermarks(tty_t *t, uint16_t rx_high, uint16_t tx_low,
+                        tty_event_fn fn, void *arg, bool deferred) {
+    t->rx_armed = false;        /* quiet while the fields change */
+    t->tx_armed = false;
+    t->on_event = fn;
+    t->event_arg = arg;
+    t->wm_defer = deferred;
+    t->rx_high = (tty_idx_t)(rx_high > t->mask ? t->mask : rx_high);
+    t->tx_low = (tty_idx_t)(tx_low > t->mask ? t->mask : tx_low);
+    t->wm_events = 0;
+    if (fn) {
+        t->wm_events = (uint8_t)((rx_high ? TTY_EV_RX_HIGH : 0) | TTY_EV_TX_LOW);
+    }
+    /* RX already past the mark is reported by the next byte */
+    t->rx_armed = (t->wm_events & TTY_EV_RX_HIGH) != 0;
+}
+
+#endif /* TTY_WATERMARKS */
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - BLOCKING
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if TTY_BLOCKING
+
+/**
+ * @brief Ticks left of a @p ticks timeout started at @p start
+ */
+static uint16_t ticks_left(uint16_t ticks, uint32_t start) {
+    if (ticks == TTY_WAIT_FOREVER) {
+        return ticks;
+    }
+    uint32_t used = nk_ticks() - start;
+    return used >= ticks ? 0 : (uint16_t)(ticks - used);
+}
+
+/**
+ * @brief Sleep on @p q; returns with the scheduler lock released
+ */
+static void tty_block(nk_waitq_t *q, uint16_t left) {
+    if (left == TTY_WAIT_FOREVER) {
+        nk_waitq_block(q);
+    } else {
+        (void)nk_waitq_block_timeout(q, left);
+    }
+}
+
+/**
+ * @brief Read, sleeping until at least @p min bytes have arrived
+ *
+ * The wanted count is published and re-checked under the scheduler
+ * lock, so a byte landing between the check and the sleep still wakes
+ * us (the same discipline as nk_mq).
+ */
+int tty_read_wait(tty_t *t, uint8_t *dst, size_t len, size_t min, uint16_t ticks) {
+    uint32_t start = nk_ticks();
+    size_t n = (size_t)tty_read(t, dst, len);
+
+    if (min > len) {
+        min = len;
+    }
+    while (n < min) {
+        uint16_t left = ticks_left(ticks, start);
+        if (left == 0) {
+            break;
+        }
+        size_t want = min - n;
+        if (want > t->mask) {
+            want = t->mask;                 /* a full ring is all we can wait for */
+        }
+
+        uint32_t s = nk_sched_lock();
+        if (tty_rx_available(t) >= want) {
+            nk_sched_unlock(s);
+        } else {
+            t->rx_want = (tty_idx_t)want;
+            tty_block(&t->rx_wait, left);
+        }
+        n += (size_t)tty_read(t, dst + n, len - n);
+    }
+    return (int)n;
+}
+
+/**
+ * @brief Write all of @p src, sleeping while the TX ring is full
+ */
+int tty_write_wait(tty_t *t, const uint8_t *src, size_t len, uint16_t ticks) {
+    uint32_t start = nk_ticks();
+    size_t n = (size_t)tty_write(t, src, len);
+
+    while (n < len) {
+        if (!t->kick) {
+            /* Polled: every call flushes the ring, so just go again */
+            int c = tty_write(t, src + n, len - n);
+            if (c <= 0) {
+                break;
+            }
+            n += (size_t)c;
+            continue;
+        }
+        uint16_t left = ticks_left(ticks, start);
+        if (left == 0) {
+            break;
+        }
+        size_t want = len - n;
+        if (want > t->size / 2u) {
+            want = t->size / 2u;            /* refill in half-ring batches */
+        }
+
+        uint32_t s = nk_sched_lock();
+        if (tty_tx_free(t) >= want) {
+            nk_sched_unlock(s);
+        } else {
+            t->tx_want = (tty_idx_t)want;
+            tty_block(&t->tx_wait, left);
+        }
+        n += (size_t)tty_write(t, src + n, len - n);
+    }
+    return (int)n;
+}
+
+#endif /* TTY_BLOCKING */
+
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - STATISTICS (if enabled)
  *═══════════════════════════════════════════════════════════════════*/
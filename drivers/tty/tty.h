@@ -11,8 +11,9 @@
  *
  * ## Features
  * - Ring buffer RX/TX (configurable size, must be power-of-2)
- * - Polling-based RX (non-interrupt, caller-driven)
- * - Immediate or deferred TX (configurable per write)
+ * - Polling-based RX (non-interrupt, caller-driven), or interrupt-driven
+ *   RX/TX where the UART ISRs (or DMA) fill and drain the rings
+ * - Immediate TX via putc, or queued TX drained by the TX-empty ISR
  * - Hardware-agnostic via callbacks (putc/getc)
  * - Overflow detection and tracking
  * - Optional statistics (byte counters, overflow counts)
@@ -23,11 +24,14 @@
  * 3. **Deferred TX Flush**: Optional buffering for batch transmission
  * 4. **Statistics**: Compile-time optional byte/overflow counters
  * 5. **Zero-Copy Peek**: Read without consuming (for protocol parsing)
+ * 6. **Lock-Free ISR Mode**: Single-producer/single-consumer head/tail
+ *    discipline, so neither side masks interrupts
  *
  * ## Memory Footprint
  * - Flash: ~180 bytes (init + read + write + poll + stats)
  * - RAM: sizeof(tty_t) + 2*buffer_size
- *   - tty_t: 16 bytes (without stats) or 24 bytes (with stats)
+ *   - tty_t: 18 bytes (without stats) or 28 bytes (with stats) on AVR,
+ *     4 more with 16-bit indices
  *   - buffers: User-provided (typically 32-128 bytes each)
  * - Stack: ~8 bytes during operations
  *
@@ -59,10 +63,49 @@
  * }
  * ```
  *
+ * ## Interrupt-Driven Mode
+ * ```c
+ * tty_init_irq(&serial, rx_buf, tx_buf, 64, hal_uart_tx_kick);
+ * hal_uart_attach(&serial, 115200);   // RX ISR on, TX ISR on demand
+ * sei();
+ * tty_write(&serial, msg, len);       // queues, returns at once
+ * int n = tty_read(&serial, buf, sizeof(buf));   // no tty_poll()
+ * ```
+ * The RX-complete ISR calls tty_rx_isr() and the data-register-empty
+ * ISR calls tty_tx_isr(); the kick callback enables the latter only
+ * while bytes are queued.  Each index has one writer (RX: ISR writes
+ * @c rx_head, readers @c rx_tail; TX the reverse), so no side masks
+ * interrupts.
+ *
+ * ## DMA Mode (tty_dma, HAL_HAS_DMA targets)
+ * The same tty_init_irq() / hal_uart_attach() pair; the HAL then runs
+ * RX as a circular DMA into the RX ring, publishing progress from the
+ * idle-line interrupt with tty_rx_dma_isr(), and its kick starts a TX
+ * DMA over tty_tx_dma_span(), retired with tty_tx_dma_done().  The
+ * read/write API, and so SLIP and the shell, are unchanged; the CPU
+ * is interrupted per burst instead of per byte.
+ *
+ * ## Watermarks (tty_watermarks)
+ * tty_set_watermarks() calls back (or posts deferred work) when the RX
+ * ring fills to a high mark or the TX ring drains to a low one, so a
+ * producer refills in chunks and a consumer parses in batches.
+ *
+ * ## Blocking I/O (tty_blocking)
+ * ```c
+ * uint8_t cmd[16];
+ * int n = tty_read_wait(&serial, cmd, sizeof(cmd), 1, 100);  // >= 1 byte or 100 ticks
+ * tty_write_wait(&serial, out, out_len, TTY_WAIT_FOREVER);
+ * ```
+ * A waiting task sleeps on a scheduler wait queue; the RX ISR (or
+ * tty_poll()) wakes it once the bytes it needs are buffered, the TX
+ * ISR once half the ring is free.  An idle terminal costs no CPU.
+ *
  * ## Limitations
- * - Buffer size must be power-of-2 (8, 16, 32, 64, 128, 256)
- * - Maximum buffer size: 256 bytes (uint8_t index)
- * - Polling-based RX (not interrupt-driven, though callbacks can be ISRs)
+ * - Buffer size must be power-of-2 (8, 16, ... TTY_MAX_SIZE)
+ * - Maximum buffer size: 256 bytes with 8-bit indices, 32 KB with
+ *   16-bit ones (tty_index_bits)
+ * - One reader and one writer per TTY (no locking); one blocked task
+ *   per direction
  */
 
 #ifndef DRIVERS_TTY_TTY_H
@@ -75,6 +118,10 @@ extern "C" {
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include "avrix-config.h"
+#if defined(__AVR__)
+#  include <avr/io.h>
+#endif
 
 /*═══════════════════════════════════════════════════════════════════
  * CONFIGURATION
@@ -94,6 +141,117 @@ extern "C" {
 #  define TTY_ENABLE_STATS 0
 #endif
 
+/**
+ * @brief Ring index width in bits (follows tty_index_bits)
+ *
+ * 8 keeps tty_t small and every index access a single byte; 16 allows
+ * rings up to 32 KB (1-2 KB RX rings on the ATmega1284) at 4 bytes of
+ * RAM per TTY and a masked two-byte access where an index is shared
+ * with an ISR.
+ */
+#ifndef TTY_INDEX_BITS
+#  if defined(CONFIG_TTY_INDEX_BITS)
+#    define TTY_INDEX_BITS CONFIG_TTY_INDEX_BITS
+#  else
+#    define TTY_INDEX_BITS 8
+#  endif
+#endif
+
+#if TTY_INDEX_BITS == 8
+typedef uint8_t tty_idx_t;
+#  define TTY_MAX_SIZE 256u
+#elif TTY_INDEX_BITS == 16
+typedef uint16_t tty_idx_t;
+#  define TTY_MAX_SIZE 32768u
+#else
+#  error "TTY_INDEX_BITS must be 8 or 16"
+#endif
+
+/**
+ * @brief Blocking tty_read_wait() / tty_write_wait() (follows tty_blocking)
+ *
+ * Adds two wait queues and two thresholds to tty_t (4-6 bytes) and one
+ * byte test per ISR call while nobody waits.
+ */
+#ifndef TTY_BLOCKING
+#  if defined(CONFIG_TTY_BLOCKING)
+#    define TTY_BLOCKING CONFIG_TTY_BLOCKING
+#  else
+#    define TTY_BLOCKING 0
+#  endif
+#endif
+
+#if TTY_BLOCKING
+#  include "kernel/sched/scheduler.h"   /* nk_waitq_t */
+#endif
+
+/**
+ * @brief Report RX/TX progress through nk_io_event (follows kernel_poll)
+ *
+ * One nk_io_notify(NK_IO_TTY) per ISR call, so vfs_poll() on a TTY
+ * descriptor sleeps until bytes move instead of rescanning.
+ */
+#ifndef TTY_POLL
+#  if defined(CONFIG_KERNEL_POLL)
+#    define TTY_POLL CONFIG_KERNEL_POLL
+#  else
+#    define TTY_POLL 0
+#  endif
+#endif
+
+#if TTY_POLL
+#  include "kernel/sync/nk_event.h"
+#endif
+
+/**
+ * @brief RX-high / TX-low watermark events (follows tty_watermarks)
+ *
+ * Adds about 10 bytes to tty_t; producers and consumers can then sleep
+ * or do other work instead of polling tty_rx_available()/tty_tx_free().
+ */
+#ifndef TTY_WATERMARKS
+#  if defined(CONFIG_TTY_WATERMARKS)
+#    define TTY_WATERMARKS CONFIG_TTY_WATERMARKS
+#  else
+#    define TTY_WATERMARKS 0
+#  endif
+#endif
+
+/**
+ * @brief DMA-driven interrupt mode helpers (follows tty_dma)
+ *
+ * For HALs with HAL_HAS_DMA: RX runs as a circular DMA straight into
+ * the RX ring, TX as one DMA burst per contiguous span of the TX ring.
+ */
+#ifndef TTY_DMA
+#  if defined(CONFIG_TTY_DMA)
+#    define TTY_DMA CONFIG_TTY_DMA
+#  else
+#    define TTY_DMA 0
+#  endif
+#endif
+
+/**
+ * @brief Hold off deep sleep while interrupt-driven TX runs (follows
+ *        kernel_idle_governor)
+ *
+ * The UART clock stops below HAL_SLEEP_IDLE, so tty_write() holds that
+ * level from the kick until the TX ISR finds the ring empty.  RX cannot
+ * wake the part from the deeper levels either: a task that must not
+ * miss input takes its own nk_idle_hold(HAL_SLEEP_IDLE).
+ */
+#ifndef TTY_IDLE_HOLD
+#  if defined(CONFIG_KERNEL_IDLE_GOVERNOR)
+#    define TTY_IDLE_HOLD CONFIG_KERNEL_IDLE_GOVERNOR
+#  else
+#    define TTY_IDLE_HOLD 0
+#  endif
+#endif
+
+#if TTY_IDLE_HOLD
+#  include "kernel/sched/idle.h"
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * CALLBACK TYPES
  *═══════════════════════════════════════════════════════════════════*/
@@ -122,6 +280,33 @@ typedef void (*tty_putc_fn)(uint8_t c);
  */
 typedef int (*tty_getc_fn)(void);
 
+/**
+ * @brief Start-transmit callback (interrupt-driven mode)
+ *
+ * Called by tty_write() after queueing bytes; enables the UART's
+ * TX-empty interrupt, which then drains the ring with tty_tx_isr().
+ *
+ * @note Must be cheap and safe to call while TX is already running
+ */
+typedef void (*tty_kick_fn)(void);
+
+/** Watermark events (bit mask) */
+#define TTY_EV_RX_HIGH 0x01u    /**< RX ring filled up to its high mark */
+#define TTY_EV_TX_LOW  0x02u    /**< TX ring drained down to its low mark */
+
+struct tty_s;
+
+/**
+ * @brief Watermark callback
+ *
+ * @param events TTY_EV_* bits that fired (more than one if deferred
+ *               work coalesced them)
+ *
+ * @note Immediate callbacks run in the context that moved the index:
+ *       the UART ISR, tty_poll() or tty_read()
+ */
+typedef void (*tty_event_fn)(struct tty_s *t, uint8_t events, void *arg);
+
 /*═══════════════════════════════════════════════════════════════════
  * TTY DESCRIPTOR
  *═══════════════════════════════════════════════════════════════════*/
@@ -134,22 +319,50 @@ typedef struct tty_s {
     uint8_t       *rx_buf;      /**< RX ring buffer */
     uint8_t       *tx_buf;      /**< TX ring buffer */
 
-    /* Ring buffer indices (8-bit for up to 256-byte buffers) */
-    uint8_t        rx_head;     /**< RX write index */
-    uint8_t        rx_tail;     /**< RX read index */
-    uint8_t        tx_head;     /**< TX write index */
-    uint8_t        tx_tail;     /**< TX read index */
+    /* Ring buffer indices (TTY_INDEX_BITS wide).  Shared with the ISRs
+     * in interrupt-driven mode, hence volatile. */
+    volatile tty_idx_t rx_head; /**< RX write index (producer: poll/ISR) */
+    volatile tty_idx_t rx_tail; /**< RX read index */
+    volatile tty_idx_t tx_head; /**< TX write index */
+    volatile tty_idx_t tx_tail; /**< TX read index (consumer: putc/ISR) */
 
     /* Buffer configuration */
-    uint8_t        size;        /**< Buffer size (must be power-of-2) */
-    uint8_t        mask;        /**< Size - 1 (for fast modulo) */
+    uint16_t       size;        /**< Buffer size (must be power-of-2) */
+    tty_idx_t      mask;        /**< Size - 1 (for fast modulo) */
 
     /* Hardware callbacks */
     tty_putc_fn    putc;        /**< Byte output callback */
     tty_getc_fn    getc;        /**< Byte input callback */
+    tty_kick_fn    kick;        /**< TX start (interrupt-driven), or NULL */
 
     /* Overflow tracking */
-    bool           rx_overflow; /**< RX overflow flag (sticky) */
+    volatile bool  rx_overflow; /**< RX overflow flag (sticky) */
+
+#if TTY_IDLE_HOLD
+    volatile bool  idle_held;   /**< TX holds HAL_SLEEP_IDLE */
+#endif
+
+#if TTY_BLOCKING
+    /* Blocked callers and what they wait for (set under nk_sched_lock) */
+    nk_waitq_t     rx_wait;     /**< Reader in tty_read_wait() */
+    nk_waitq_t     tx_wait;     /**< Writer in tty_write_wait() */
+    tty_idx_t      rx_want;     /**< Bytes buffered before waking it */
+    tty_idx_t      tx_want;     /**< Free slots before waking it */
+#endif
+
+#if TTY_WATERMARKS
+    /* Watermark events; armed flags are set by the task, cleared by the
+     * context that fires (separate bytes, so neither needs a lock) */
+    tty_event_fn   on_event;    /**< Watermark callback, or NULL */
+    void          *event_arg;   /**< Passed to on_event */
+    tty_idx_t      rx_high;     /**< TTY_EV_RX_HIGH at this many buffered */
+    tty_idx_t      tx_low;      /**< TTY_EV_TX_LOW at this many queued */
+    uint8_t        wm_events;   /**< TTY_EV_* enabled */
+    bool           wm_defer;    /**< Run on_event from the work queue */
+    volatile bool  rx_armed;    /**< RX high not yet reported */
+    volatile bool  tx_armed;    /**< TX low not yet reported */
+    volatile uint8_t wm_pending;/**< Deferred events not yet delivered */
+#endif
 
 #if TTY_ENABLE_STATS
     /* Statistics (optional, +8 bytes) */
@@ -169,7 +382,7 @@ typedef struct tty_s {
  * @param t TTY descriptor to initialize
  * @param rx_buf RX ring buffer (size bytes, user-provided)
  * @param tx_buf TX ring buffer (size bytes, user-provided)
- * @param size Buffer capacity (must be power-of-2: 8, 16, 32, 64, 128, 256)
+ * @param size Buffer capacity (power-of-2, 8 ... TTY_MAX_SIZE)
  * @param putc Transmit callback (required, cannot be NULL)
  * @param getc Receive callback (may be NULL if RX not used)
  *
@@ -185,9 +398,22 @@ typedef struct tty_s {
  * tty_init(&uart, rx, tx, 64, uart_putc, uart_getc);
  * ```
  */
-void tty_init(tty_t *t, uint8_t *rx_buf, uint8_t *tx_buf, uint8_t size,
+void tty_init(tty_t *t, uint8_t *rx_buf, uint8_t *tx_buf, uint16_t size,
               tty_putc_fn putc, tty_getc_fn getc);
 
+/**
+ * @brief Initialize TTY instance for interrupt-driven RX/TX
+ *
+ * Like tty_init() without byte callbacks: the UART RX ISR feeds the RX
+ * ring through tty_rx_isr(), tty_write() only queues and calls
+ * @p kick, and the TX-empty ISR drains the ring with tty_tx_isr().
+ * tty_poll() does nothing on such a TTY.
+ *
+ * @param kick Enables the TX-empty interrupt (e.g. hal_uart_tx_kick)
+ */
+void tty_init_irq(tty_t *t, uint8_t *rx_buf, uint8_t *tx_buf, uint16_t size,
+                  tty_kick_fn kick);
+
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - DATA TRANSFER
  *═══════════════════════════════════════════════════════════════════*/
@@ -245,14 +471,17 @@ int tty_read(tty_t *t, uint8_t *dst, size_t len);
  * @brief Write bytes to TX buffer and transmit
  *
  * Writes up to `len` bytes from `src` to the TX ring buffer,
- * then immediately flushes them via putc() callback.
+ * then immediately flushes them via putc() callback.  In
+ * interrupt-driven mode the bytes stay queued for the TX ISR and the
+ * call returns at once.
  *
  * @param t TTY descriptor
  * @param src Source buffer
  * @param len Number of bytes to write
  * @return Number of bytes actually written (may be less if buffer full)
  *
- * @note Transmits immediately (calls putc for each byte)
+ * @note Transmits immediately (calls putc for each byte), except in
+ *       interrupt-driven mode
  * @note If TX buffer is full, writes as many bytes as possible
  * @note Increments tx_bytes counter if TTY_ENABLE_STATS=1
  *
@@ -315,6 +544,324 @@ size_t tty_tx_free(const tty_t *t);
  */
 bool tty_overflow_occurred(tty_t *t);
 
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - WATERMARKS (TTY_WATERMARKS)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if TTY_WATERMARKS
+
+/**
+ * @brief Call @p fn when RX fills to @p rx_high or TX drains to @p tx_low
+ *
+ * TTY_EV_RX_HIGH fires once the RX ring holds at least @p rx_high bytes
+ * (0 disables it) and re-arms on each tty_read().  TTY_EV_TX_LOW fires
+ * once no more than @p tx_low bytes are still queued, and re-arms on
+ * each tty_write() to an interrupt-driven TTY (polled TTYs never queue,
+ * so it never fires there).  A write below the mark still fires once
+ * the next byte goes out.
+ *
+ * With @p deferred, the firing context only posts nk_work_post() and
+ * @p fn runs later from the work queue, in task context, with the
+ * events that fired meanwhile OR-ed together.  Otherwise @p fn runs in
+ * the firing context, often the UART ISR; keep it short there.
+ *
+ * @param fn NULL disables both events
+ *
+ * Example (stream a long reply without polling tty_tx_free()):
+ * ```c
+ * static void refill(tty_t *t, uint8_t ev, void *arg) {
+ *     reply_pos += tty_write(t, reply + reply_pos, reply_len - reply_pos);
+ * }
+ * tty_set_watermarks(&serial, 0, 16, refill, NULL, true);
+ * ```
+ */
+void tty_set_watermarks(tty_t *t, uint16_t rx_high, uint16_t tx_low,
+                        tty_event_fn fn, void *arg, bool deferred);
+
+#else /* Stubs */
+
+static inline void tty_set_watermarks(tty_t *t, uint16_t rx_high, uint16_t tx_low,
+                                      tty_event_fn fn, void *arg, bool deferred) {
+    (void)t; (void)rx_high; (void)tx_low; (void)fn; (void)arg; (void)deferred;
+}
+
+#endif /* TTY_WATERMARKS */
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - BLOCKING (TTY_BLOCKING)
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Timeout meaning "no timeout" */
+#define TTY_WAIT_FOREVER 0xFFFFu
+
+#if TTY_BLOCKING
+
+/**
+ * @brief Read, sleeping until at least @p min bytes have arrived
+ *
+ * Takes what is buffered, then blocks on the RX wait queue until the
+ * rest of @p min (at most a full ring at a time) is in, and so on.
+ * Once @p min bytes are read it also takes whatever else is ready, up
+ * to @p len.  Must be called from a task, not an ISR.
+ *
+ * @param min   Bytes to wait for (clamped to @p len); 0 never blocks
+ * @param ticks Timeout in scheduler ticks, or TTY_WAIT_FOREVER
+ * @return Bytes read; less than @p min only on timeout
+ */
+int tty_read_wait(tty_t *t, uint8_t *dst, size_t len, size_t min, uint16_t ticks);
+
+/**
+ * @brief Write all of @p src, sleeping while the TX ring is full
+ *
+ * In interrupt-driven mode the caller sleeps until the TX ISR has
+ * freed half the ring (or what is left to write, if less), so a long
+ * write wakes once per half ring rather than once per byte.  Polled
+ * TTYs never block: tty_write() already flushes synchronously.
+ *
+ * @param ticks Timeout in scheduler ticks, or TTY_WAIT_FOREVER
+ * @return Bytes queued; less than @p len only on timeout
+ */
+int tty_write_wait(tty_t *t, const uint8_t *src, size_t len, uint16_t ticks);
+
+#else /* Stubs: never block */
+
+static inline int tty_read_wait(tty_t *t, uint8_t *dst, size_t len, size_t min,
+                                uint16_t ticks) {
+    (void)min; (void)ticks; return tty_read(t, dst, len);
+}
+static inline int tty_write_wait(tty_t *t, const uint8_t *src, size_t len,
+                                 uint16_t ticks) {
+    (void)ticks; return tty_write(t, src, len);
+}
+
+#endif /* TTY_BLOCKING */
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - INTERRUPT CONTEXT
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Keeps the ring store ahead of the index that publishes it */
+#define TTY_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/**
+ * @brief Read or publish an index the other context also uses
+ *
+ * A 16-bit index is two byte accesses on AVR, so outside an ISR they
+ * run with interrupts masked (a few cycles) lest the ISR see or make a
+ * torn value.  Everywhere else a plain access is already atomic.  The
+ * ISR helpers below use plain accesses: AVR ISRs run masked.
+ */
+#if TTY_INDEX_BITS == 16 && defined(__AVR__)
+static inline tty_idx_t tty_idx_load(const volatile tty_idx_t *p) {
+    uint8_t sreg = SREG;
+    __asm__ __volatile__("cli" ::: "memory");
+    tty_idx_t v = *p;
+    SREG = sreg;
+    return v;
+}
+
+static inline void tty_idx_store(volatile tty_idx_t *p, tty_idx_t v) {
+    uint8_t sreg = SREG;
+    __asm__ __volatile__("cli" ::: "memory");
+    *p = v;
+    SREG = sreg;
+}
+#else
+static inline tty_idx_t tty_idx_load(const volatile tty_idx_t *p) { return *p; }
+static inline void tty_idx_store(volatile tty_idx_t *p, tty_idx_t v) { *p = v; }
+#endif
+
+/**
+ * @brief Wake a task blocked in tty_read_wait() / tty_write_wait()
+ *
+ * Called by every producer of RX bytes (with the new @c rx_head) and
+ * every consumer of TX bytes (with the new @c tx_tail); also fires
+ * armed watermark events and, with TTY_POLL, nk_io_event.  One byte
+ * test per feature while nobody waits; nothing at all without
+ * TTY_BLOCKING / TTY_WATERMARKS / TTY_POLL.
+ */
+#if TTY_WATERMARKS
+void tty_wm_fire(tty_t *t, uint8_t ev);
+#endif
+
+static inline void tty_rx_notify(tty_t *t, tty_idx_t head) {
+#if TTY_BLOCKING
+    if (t->rx_wait && (tty_idx_t)((head - t->rx_tail) & t->mask) >= t->rx_want) {
+        nk_waitq_wake_one(&t->rx_wait);
+    }
+#endif
+#if TTY_WATERMARKS
+    if (t->rx_armed && (tty_idx_t)((head - t->rx_tail) & t->mask) >= t->rx_high) {
+        tty_wm_fire(t, TTY_EV_RX_HIGH);
+    }
+#endif
+#if TTY_POLL
+    nk_io_notify(NK_IO_TTY);
+#endif
+    (void)t; (void)head;
+}
+
+static inline void tty_tx_notify(tty_t *t, tty_idx_t tail) {
+#if TTY_BLOCKING
+    if (t->tx_wait && (tty_idx_t)((tail - t->tx_head - 1u) & t->mask) >= t->tx_want) {
+        nk_waitq_wake_one(&t->tx_wait);
+    }
+#endif
+#if TTY_WATERMARKS
+    if (t->tx_armed && (tty_idx_t)((t->tx_head - tail) & t->mask) <= t->tx_low) {
+        tty_wm_fire(t, TTY_EV_TX_LOW);
+    }
+#endif
+#if TTY_POLL
+    nk_io_notify(NK_IO_TTY);
+#endif
+    (void)t; (void)tail;
+}
+
+/**
+ * @brief Drop the TX sleep hold once the ring has drained (ISR side)
+ */
+static inline void tty_tx_idle(tty_t *t) {
+#if TTY_IDLE_HOLD
+    if (t->idle_held) {
+        t->idle_held = false;
+        nk_idle_release(HAL_SLEEP_IDLE);
+    }
+#endif
+    (void)t;
+}
+
+/**
+ * @brief Store a received byte (call from the UART RX ISR)
+ *
+ * Inline so the ISR makes no call (which on AVR would also save every
+ * call-clobbered register).
+ *
+ * @return false if the ring was full (byte dropped, overflow recorded)
+ */
+static inline bool tty_rx_isr(tty_t *t, uint8_t c) {
+    tty_idx_t head = t->rx_head;
+    tty_idx_t next = (tty_idx_t)((head + 1u) & t->mask);
+
+    if (next == t->rx_tail) {
+        t->rx_overflow = true;
+#if TTY_ENABLE_STATS
+        t->rx_overflows++;
+#endif
+        return false;
+    }
+    t->rx_buf[head] = c;
+    TTY_BARRIER();
+    t->rx_head = next;
+#if TTY_ENABLE_STATS
+    t->rx_bytes++;
+#endif
+    tty_rx_notify(t, next);
+    return true;
+}
+
+/**
+ * @brief Next byte to transmit (call from the UART TX-empty ISR)
+ *
+ * @return Byte (0-255), or -1 when the ring is empty: the ISR should
+ *         then disable itself until the next kick
+ */
+static inline int tty_tx_isr(tty_t *t) {
+    tty_idx_t tail = t->tx_tail;
+
+    if (tail == t->tx_head) {
+        tty_tx_idle(t);
+        return -1;
+    }
+    uint8_t c = t->tx_buf[tail];
+    TTY_BARRIER();
+    tail = (tty_idx_t)((tail + 1u) & t->mask);
+    t->tx_tail = tail;
+#if TTY_ENABLE_STATS
+    t->tx_bytes++;
+#endif
+    tty_tx_notify(t, tail);
+    return c;
+}
+
+#if TTY_DMA
+
+/**
+ * @brief Publish RX DMA progress (idle-line, half- and full-transfer ISRs)
+ *
+ * The DMA writes the RX ring circularly; @p pos is its write offset
+ * (ring size minus the remaining count).  Everything up to @p pos
+ * becomes readable in one index store, however many bytes it is.
+ *
+ * A DMA cannot be held off by a full ring: if more arrived than was
+ * free, unread bytes were overwritten and rx_overflow is raised.  A
+ * whole lap between two calls goes unseen, so the idle-line and
+ * half-transfer interrupts must both be enabled.
+ */
+static inline void tty_rx_dma_isr(tty_t *t, uint16_t pos) {
+    tty_idx_t head = t->rx_head;
+    tty_idx_t next = (tty_idx_t)(pos & t->mask);
+    tty_idx_t got  = (tty_idx_t)((next - head) & t->mask);
+
+    if (got == 0) {
+        return;
+    }
+    if (got > (tty_idx_t)((t->rx_tail - head - 1u) & t->mask)) {
+        t->rx_overflow = true;
+#if TTY_ENABLE_STATS
+        t->rx_overflows++;
+#endif
+    }
+    TTY_BARRIER();
+    t->rx_head = next;
+#if TTY_ENABLE_STATS
+    t->rx_bytes += got;
+#endif
+    tty_rx_notify(t, next);
+}
+
+/**
+ * @brief Queued TX bytes that are contiguous in memory
+ *
+ * Sets @p *p to the oldest queued byte and returns how many follow it
+ * before the ring wraps or runs dry: one TX DMA burst.  Call from the
+ * kick (interrupts masked) or the TX DMA complete ISR.
+ *
+ * @return Span length, 0 when nothing is queued
+ */
+static inline uint16_t tty_tx_dma_span(const tty_t *t, const uint8_t **p) {
+    tty_idx_t tail = t->tx_tail;
+    tty_idx_t head = t->tx_head;
+
+    *p = t->tx_buf + tail;
+    if (head >= tail) {
+        return (uint16_t)(head - tail);
+    }
+    return (uint16_t)(t->size - tail);
+}
+
+/**
+ * @brief Retire @p n bytes sent by a TX DMA burst (TX complete ISR)
+ *
+ * Frees the span tty_tx_dma_span() returned; the ISR then asks for the
+ * next span and, if it is empty, stops until the next kick.
+ */
+static inline void tty_tx_dma_done(tty_t *t, uint16_t n) {
+    tty_idx_t tail = (tty_idx_t)((t->tx_tail + n) & t->mask);
+
+    TTY_BARRIER();
+    t->tx_tail = tail;
+#if TTY_ENABLE_STATS
+    t->tx_bytes += n;
+#endif
+    tty_tx_notify(t, tail);
+    if (tail == t->tx_head) {
+        tty_tx_idle(t);
+    }
+}
+
+#endif /* TTY_DMA */
+
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - STATISTICS (if TTY_ENABLE_STATS=1)
  *═══════════════════════════════════════════════════════════════════*/
@@ -50,42 +50,149 @@ void highlight(const char *line)
         printf("\x1b[33m%s\x1b[0m", line);           /* comments/directives */
         return;
     }
-    for (const char *p = line; *p; ++p) {
-        if (isdigit((unsigned char)*p))
-            printf("\x1b[36m%c\x1b[0m", *p);         /* numbers             */
-        else
-            putchar(*p);
+    for (const char *p = line; *p; ) {                /* numbers: one escape
+                                                         pair per run       */
+        if (isdigit((unsigned char)*p)) {
+            fputs("\x1b[36m", stdout);
+            while (isdigit((unsigned char)*p))
+                putchar(*p++);
+            fputs("\x1b[0m", stdout);
+        } else {
+            putchar(*p++);
+        }
     }
 }
 
-/*───────────────────────────  Line-buffer helpers  ─────────────────────────*/
+/*─────────────────────────────────  Gap buffer  ────────────────────────────*/
 
-void insert_line(char lines[][MAX_LINE_LEN], uint8_t *count,
-                 uint8_t idx, const char *text)
+void gb_init(gapbuf_t *g, char *storage, size_t cap)
 {
-    if (*count >= MAX_LINES)
-        return;
-    if (idx > *count)
-        idx = *count;
+    g->text = storage;
+    g->cap  = cap;
+    g->gap  = 0;
+    g->end  = cap;
+}
 
-    for (uint8_t i = *count; i > idx; --i)
-        memcpy(lines[i], lines[i - 1], MAX_LINE_LEN);
+size_t gb_len(const gapbuf_t *g)
+{
+    return g->cap - (g->end - g->gap);
+}
 
-    strncpy(lines[idx], text, MAX_LINE_LEN - 1);
-    lines[idx][MAX_LINE_LEN - 1] = '\0';
-    ++*count;
+char gb_at(const gapbuf_t *g, size_t pos)
+{
+    return g->text[pos < g->gap ? pos : pos + (g->end - g->gap)];
 }
 
-void delete_line(char lines[][MAX_LINE_LEN], uint8_t *count,
-                 uint8_t idx)
+/* Slide the hole to @pos; costs |pos - gap| bytes of memmove. */
+static void gb_move(gapbuf_t *g, size_t pos)
 {
-    if (idx >= *count)
-        return;
+    if (pos < g->gap) {
+        size_t n = g->gap - pos;
+        memmove(g->text + g->end - n, g->text + pos, n);
+        g->gap -= n;
+        g->end -= n;
+    } else if (pos > g->gap) {
+        size_t n = pos - g->gap;
+        memmove(g->text + g->gap, g->text + g->end, n);
+        g->gap += n;
+        g->end += n;
+    }
+}
+
+/* Insert up to @n bytes at @pos; returns how many fitted. */
+size_t gb_insert(gapbuf_t *g, size_t pos, const char *s, size_t n)
+{
+    size_t room = g->end - g->gap;
+    if (n > room)
+        n = room;
+    gb_move(g, pos);
+    memcpy(g->text + g->gap, s, n);
+    g->gap += n;
+    return n;
+}
+
+/* Erase up to @n bytes from @pos on; returns how many went. */
+size_t gb_erase(gapbuf_t *g, size_t pos, size_t n)
+{
+    size_t len = gb_len(g);
+    if (pos >= len)
+        return 0;
+    if (n > len - pos)
+        n = len - pos;
+    gb_move(g, pos);
+    g->end += n;
+    return n;
+}
+
+size_t gb_copy(const gapbuf_t *g, size_t pos, size_t n, char *dst)
+{
+    size_t len = gb_len(g);
+    if (pos >= len)
+        return 0;
+    if (n > len - pos)
+        n = len - pos;
+    for (size_t i = 0; i < n; ++i)
+        dst[i] = gb_at(g, pos + i);
+    return n;
+}
 
-    for (uint8_t i = idx; i + 1 < *count; ++i)
-        memcpy(lines[i], lines[i + 1], MAX_LINE_LEN);
+/* Start of the line holding @pos. */
+size_t gb_bol(const gapbuf_t *g, size_t pos)
+{
+    while (pos > 0 && gb_at(g, pos - 1) != '\n')
+        --pos;
+    return pos;
+}
+
+/* Offset of the '\n' ending the line at @pos, or gb_len(). */
+size_t gb_eol(const gapbuf_t *g, size_t pos)
+{
+    size_t len = gb_len(g);
+    while (pos < len && gb_at(g, pos) != '\n')
+        ++pos;
+    return pos;
+}
+
+/* Start of line @line (0-based), or gb_len() past the last one. */
+size_t gb_line_pos(const gapbuf_t *g, uint16_t line)
+{
+    size_t len = gb_len(g), pos = 0;
+    while (line && pos < len) {
+        if (gb_at(g, pos++) == '\n')
+            --line;
+    }
+    return pos;
+}
+
+uint16_t gb_lines(const gapbuf_t *g)
+{
+    size_t   len = gb_len(g);
+    uint16_t n   = 0;
+    for (size_t i = 0; i < len; ++i)
+        n += gb_at(g, i) == '\n';
+    return (uint16_t)(n + (len && gb_at(g, len - 1) != '\n'));
+}
+
+/* Copy the line at @pos into @dst without its '\n', NUL-terminated and
+ * cut to @max - 1 bytes; returns the full line length. */
+size_t gb_line(const gapbuf_t *g, size_t pos, char *dst, size_t max)
+{
+    size_t n = gb_eol(g, pos) - pos;
+    size_t k = gb_copy(g, pos, n < max ? n : max - 1, dst);
+    dst[k] = '\0';
+    return n;
+}
 
-    --*count;
+/*──────────────────────────────  Terminal output  ──────────────────────────*/
+
+void term_goto(uint8_t row, uint8_t col)
+{
+    printf("\x1b[%u;%uH", (unsigned)row + 1u, (unsigned)col + 1u);
+}
+
+void term_clear_eol(void)
+{
+    fputs("\x1b[K", stdout);
 }
 
 /*─────────────────────  Display-column width calculator  ───────────────────*/
@@ -1,6 +1,7 @@
 #ifndef EDITOR_COMMON_H
 #define EDITOR_COMMON_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
@@ -18,12 +19,54 @@ extern "C" {
 
 void pgm_print(const char *p);
 void highlight(const char *line);
-void insert_line(char lines[][MAX_LINE_LEN], uint8_t *count,
-                 uint8_t idx, const char *text);
-void delete_line(char lines[][MAX_LINE_LEN], uint8_t *count,
-                 uint8_t idx);
 int  display_width(const char *s, size_t byte_offset);
 
+/*
+ * Gap buffer: the whole file in one array with a hole at the last edit.
+ * Typing at the hole is O(1); moving it costs the distance moved, so an
+ * edit session pays for cursor travel, not for the text behind the
+ * cursor.  Lines are '\n'-terminated runs; a last line may lack the
+ * '\n'.  Offsets are logical (the hole is invisible).
+ */
+typedef struct {
+    char  *text;   /* [0, gap) text, [gap, end) hole, [end, cap) text */
+    size_t cap;
+    size_t gap;
+    size_t end;
+} gapbuf_t;
+
+void   gb_init(gapbuf_t *g, char *storage, size_t cap);
+size_t gb_len(const gapbuf_t *g);
+char   gb_at(const gapbuf_t *g, size_t pos);
+size_t gb_insert(gapbuf_t *g, size_t pos, const char *s, size_t n);
+size_t gb_erase(gapbuf_t *g, size_t pos, size_t n);
+size_t gb_copy(const gapbuf_t *g, size_t pos, size_t n, char *dst);
+size_t gb_bol(const gapbuf_t *g, size_t pos);
+size_t gb_eol(const gapbuf_t *g, size_t pos);
+size_t gb_line_pos(const gapbuf_t *g, uint16_t line);
+uint16_t gb_lines(const gapbuf_t *g);
+size_t gb_line(const gapbuf_t *g, size_t pos, char *dst, size_t max);
+
+/*
+ * Screen rows to repaint.  Editors mark what an edit touched and
+ * refresh only those rows, which is what keeps a 9600-baud terminal
+ * responsive.  Up to 32 rows.
+ */
+typedef struct {
+    uint32_t dirty;    /* bit r: row r must be repainted */
+    uint8_t  rows;
+} screen_t;
+
+static inline void scr_touch(screen_t *s, uint8_t row) {
+    if (row < s->rows) s->dirty |= (uint32_t)1 << row;
+}
+static inline void scr_touch_from(screen_t *s, uint8_t row) {
+    if (row < s->rows) s->dirty |= ~(((uint32_t)1 << row) - 1u);
+}
+
+void term_goto(uint8_t row, uint8_t col);
+void term_clear_eol(void);
+
 void set_status_message(const char *fmt, ...);
 extern char status_msg[64];
 
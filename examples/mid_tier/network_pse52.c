@@ -22,6 +22,7 @@
 #include "drivers/tty/tty.h"
 #include "drivers/net/slip.h"
 #include "drivers/net/ipv4.h"
+#include "drivers/net/udp.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -100,6 +101,14 @@ int main(void) {
     printf("--------------------------\n");
 
     const char udp_payload[] = "Hello from PSE52!";
+#if CONFIG_NET_UDP_ENABLED
+    udp_init(local_ip);
+    int sock = udp_bind(0);
+    printf("UDP socket: local port %u -> 10.0.0.2:7000\n", udp_port(sock));
+    printf("  Payload: \"%s\" (%zu bytes)\n", udp_payload, sizeof(udp_payload));
+
+    udp_sendto(&serial, sock, remote_ip, 7000, udp_payload, sizeof(udp_payload));
+#else
     ipv4_hdr_t udp_hdr;
     ipv4_init_header(&udp_hdr, local_ip, remote_ip,
                      IPV4_PROTO_UDP, sizeof(udp_payload));
@@ -110,6 +119,7 @@ int main(void) {
 
     ipv4_send(&serial, &udp_hdr, (const uint8_t *)udp_payload,
               sizeof(udp_payload));
+#endif
     printf("  ✓ UDP packet sent\n\n");
 
     /* Test 3: Receive demonstration (simulated) */
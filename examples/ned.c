@@ -34,7 +34,10 @@
  *   s TEXT       search for TEXT
  *   h            help
  *
- * Lines expand dynamically.  Printing performs extremely simple syntax
+ * The text lives in one gap buffer (editor_common.h) of
+ * MAX_LINES * MAX_LINE_LEN bytes, so lines may be any length and an
+ * edit moves only the bytes between it and the previous one.
+ * Printing performs extremely simple syntax
  * highlighting: lines starting with '#' or '//' appear in yellow and
  * digits are shown in cyan.
  * ────────────────────────────────────────────────────────────────────
@@ -45,31 +48,61 @@
 
 #include "editor_common.h"
 
+#define TEXT_SIZE (MAX_LINES * MAX_LINE_LEN)
+
 struct Buffer {
-  char lines[MAX_LINES][MAX_LINE_LEN];
-  uint8_t count;
+  gapbuf_t text;
   char filename[32];
 };
 
-static void die(const char *msg) {
-  perror(msg);
-  exit(EXIT_FAILURE);
-}
+static char text_store[TEXT_SIZE];
 
 static void buffer_init(struct Buffer *b, const char *path) {
   memset(b, 0, sizeof *b);
+  gb_init(&b->text, text_store, sizeof text_store);
   if (path)
     strncpy(b->filename, path, sizeof b->filename - 1);
 }
 
 static void buffer_free(struct Buffer *b) { (void)b; /* nothing to free */ }
 
+static void insert_text(struct Buffer *b, size_t pos, const char *s,
+                        size_t n) {
+  if (gb_insert(&b->text, pos, s, n) < n) {
+    set_status_message("Buffer full (%u bytes)", (unsigned)TEXT_SIZE);
+    printf("%s\n", status_msg);
+  }
+}
+
+/* Insert @text as a whole line at @pos, adding the '\n' it lacks. */
+static void put_line(struct Buffer *b, size_t pos, const char *text) {
+  size_t n = strlen(text);
+  insert_text(b, pos, text, n);
+  if (!n || text[n - 1] != '\n')
+    insert_text(b, pos + n, "\n", 1);
+}
+
+static void replace_line(struct Buffer *b, uint16_t idx, const char *text) {
+  if (idx >= gb_lines(&b->text))
+    return;
+  size_t pos = gb_line_pos(&b->text, idx);
+  gb_erase(&b->text, pos, gb_eol(&b->text, pos) - pos);
+  insert_text(b, pos, text, strlen(text));
+}
+
+static void insert_line(struct Buffer *b, uint16_t idx, const char *text) {
+  size_t pos = gb_line_pos(&b->text, idx);
+  size_t len = gb_len(&b->text);
+  if (pos == len && len && gb_at(&b->text, len - 1) != '\n')
+    insert_text(b, pos++, "\n", 1);     /* terminate an open last line */
+  put_line(b, pos, text);
+}
 
-static void replace_line(struct Buffer *b, uint8_t idx, const char *text) {
-  if (idx >= b->count)
+static void delete_line(struct Buffer *b, uint16_t idx) {
+  if (idx >= gb_lines(&b->text))
     return;
-  strncpy(b->lines[idx], text, MAX_LINE_LEN - 1);
-  b->lines[idx][MAX_LINE_LEN - 1] = '\0';
+  size_t pos = gb_line_pos(&b->text, idx);
+  gb_erase(&b->text, pos, gb_eol(&b->text, pos) + 1 - pos);
 }
 
 static void load_file(struct Buffer *b, const char *path) {
@@ -79,8 +112,9 @@ static void load_file(struct Buffer *b, const char *path) {
     return;
   }
   char tmp[MAX_LINE_LEN];
-  while (fgets(tmp, sizeof tmp, f) && b->count < MAX_LINES)
-    insert_line(b->lines, &b->count, b->count, tmp);
+  size_t n;
+  while ((n = fread(tmp, 1, sizeof tmp, f)) > 0)
+    insert_text(b, gb_len(&b->text), tmp, n);
   fclose(f);
   strncpy(b->filename, path, sizeof b->filename - 1);
 }
@@ -93,43 +127,66 @@ static void save_file(const struct Buffer *b) {
     perror("open");
     return;
   }
-  for (uint8_t i = 0; i < b->count; ++i)
-    fputs(b->lines[i], f);
+  size_t len = gb_len(&b->text);
+  for (size_t i = 0; i < len; ++i)
+    putc(gb_at(&b->text, i), f);
   fclose(f);
 }
 
-static uint8_t EEMEM ee_buf[1 + MAX_LINES * MAX_LINE_LEN];
+/* Length (little endian) followed by the text; only the used bytes are
+ * written, and eeprom_update_byte() skips the ones that did not change. */
+static uint8_t EEMEM ee_buf[2 + TEXT_SIZE];
 
 static void eeprom_save(const struct Buffer *b) {
-  eeprom_update_byte(&ee_buf[0], b->count);
-  for (uint8_t i = 0; i < b->count; ++i)
-    for (uint8_t j = 0; j < MAX_LINE_LEN; ++j)
-      eeprom_update_byte(&ee_buf[1 + i * MAX_LINE_LEN + j],
-                         (uint8_t)b->lines[i][j]);
+  size_t len = gb_len(&b->text);
+  eeprom_update_byte(&ee_buf[0], (uint8_t)len);
+  eeprom_update_byte(&ee_buf[1], (uint8_t)(len >> 8));
+  for (size_t i = 0; i < len; ++i)
+    eeprom_update_byte(&ee_buf[2 + i], (uint8_t)gb_at(&b->text, i));
 }
 
 static void eeprom_load(struct Buffer *b) {
-  b->count = eeprom_read_byte(&ee_buf[0]);
-  if (b->count > MAX_LINES)
-    b->count = MAX_LINES;
-  for (uint8_t i = 0; i < b->count; ++i)
-    for (uint8_t j = 0; j < MAX_LINE_LEN; ++j)
-      b->lines[i][j] =
-          (char)eeprom_read_byte(&ee_buf[1 + i * MAX_LINE_LEN + j]);
+  size_t len = eeprom_read_byte(&ee_buf[0]) |
+               (size_t)eeprom_read_byte(&ee_buf[1]) << 8;
+  if (len > TEXT_SIZE)
+    len = 0;                            /* blank or foreign EEPROM */
+  gb_init(&b->text, text_store, sizeof text_store);
+  for (size_t i = 0; i < len; ++i) {
+    char c = (char)eeprom_read_byte(&ee_buf[2 + i]);
+    gb_insert(&b->text, i, &c, 1);
+  }
 }
 
-
 static void print_buffer(const struct Buffer *b) {
-  for (uint8_t i = 0; i < b->count; ++i) {
-    printf("%3zu: ", (size_t)i + 1);
-    highlight(b->lines[i]);
+  char line[MAX_LINE_LEN];
+  size_t len = gb_len(&b->text);
+  uint16_t n = 0;
+  for (size_t pos = 0; pos < len; pos = gb_eol(&b->text, pos) + 1) {
+    gb_line(&b->text, pos, line, sizeof line);
+    printf("%3u: ", (unsigned)++n);
+    highlight(line);
+    putchar('\n');
   }
 }
 
 static void search(const struct Buffer *b, const char *term) {
-  for (uint8_t i = 0; i < b->count; ++i)
-    if (strstr(b->lines[i], term))
-      printf("%3zu: %s", (size_t)i + 1, b->lines[i]);
+  char line[MAX_LINE_LEN];
+  size_t len = gb_len(&b->text);
+  uint16_t n = 0;
+  for (size_t pos = 0; pos < len; pos = gb_eol(&b->text, pos) + 1) {
+    gb_line(&b->text, pos, line, sizeof line);
+    ++n;
+    if (strstr(line, term))
+      printf("%3u: %s\n", (unsigned)n, line);
+  }
+}
+
+/* Text argument of a command: leading blanks and the '\n' dropped. */
+static char *arg_text(char *s) {
+  while (*s == ' ')
+    ++s;
+  s[strcspn(s, "\n")] = '\0';
+  return s;
 }
 
 static const char help_msg[] PROGMEM =
@@ -163,50 +220,30 @@ int main(int argc, char **argv) {
       print_buffer(&buf);
       continue;
     }
-    if (cmd[0] == 'e') {
-      unsigned int line;
-      char text[200];
-      if (sscanf(cmd + 1, "%u %[\x00-\xFF]", &line, text) == 2 && line) {
-        if (strlen(text) >= MAX_LINE_LEN) {
-          set_status_message("Line truncated to %d chars", MAX_LINE_LEN - 1);
-          printf("%s\n", status_msg);
-        }
-        replace_line(&buf, (uint8_t)(line - 1), text);
-      }
-      continue;
-    }
-    if (cmd[0] == 'i') {
-      unsigned int line;
-      char text[200];
-      if (sscanf(cmd + 1, "%u %[\x00-\xFF]", &line, text) == 2) {
-        if (strlen(text) >= MAX_LINE_LEN) {
-          set_status_message("Line truncated to %d chars", MAX_LINE_LEN - 1);
-          printf("%s\n", status_msg);
-        }
-        insert_line(buf.lines, &buf.count, (uint8_t)(line - 1), text);
+    if (cmd[0] == 'e' || cmd[0] == 'i') {
+      char *rest;
+      unsigned long line = strtoul(cmd + 1, &rest, 10);
+      if (rest != cmd + 1 && line) {
+        if (cmd[0] == 'e')
+          replace_line(&buf, (uint16_t)(line - 1), arg_text(rest));
+        else
+          insert_line(&buf, (uint16_t)(line - 1), arg_text(rest));
       }
       continue;
     }
     if (cmd[0] == 'a') {
-      char text[200];
-      if (sscanf(cmd + 1, " %[\x00-\xFF]", text) == 1) {
-        if (strlen(text) >= MAX_LINE_LEN) {
-          set_status_message("Line truncated to %d chars", MAX_LINE_LEN - 1);
-          printf("%s\n", status_msg);
-        }
-        insert_line(buf.lines, &buf.count, buf.count, text);
-      }
+      insert_line(&buf, UINT16_MAX, arg_text(cmd + 1));
       continue;
     }
     if (cmd[0] == 'd') {
       unsigned int line;
-      if (sscanf(cmd + 1, "%u", &line) == 1)
-        delete_line(buf.lines, &buf.count, (uint8_t)(line - 1));
+      if (sscanf(cmd + 1, "%u", &line) == 1 && line)
+        delete_line(&buf, (uint16_t)(line - 1));
       continue;
     }
     if (cmd[0] == 's') {
-      char term[64];
-      if (sscanf(cmd + 1, " %[\x00-\xFF]", term) == 1)
+      char *term = arg_text(cmd + 1);
+      if (*term)
         search(&buf, term);
       continue;
     }
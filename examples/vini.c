@@ -1,4 +1,5 @@
 #include <ctype.h>
+#include <poll.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,16 +16,13 @@
 #include <locale.h>
 #endif
 
-static int  status_timer;
-static char yank[MAX_LINE_LEN] = "";
-
-
 /*
  * ────────────────────────────────────────────────────────────────────
  * vini.c — VI Nano Implementation
  * --------------------------------------------------------------------
- * A compact vi-like editor.  The entire file resides in memory and the
- * screen is redrawn after each keystroke.  Only a subset of vi is
+ * A compact vi-like editor.  The entire file resides in memory in a gap
+ * buffer and only the screen rows a keystroke changed are repainted;
+ * the terminal cursor marks the position.  Only a subset of vi is
  * implemented but the basic modal workflow should feel familiar.
  *
  * Command mode
@@ -51,11 +49,36 @@ static char yank[MAX_LINE_LEN] = "";
 
 #include "editor_common.h"
 
+#define TEXT_SIZE (MAX_LINES * MAX_LINE_LEN)
+#define ROWS      MAX_LINES          /* text rows; status and message below */
+#define GUTTER    6                  /* "> 123 " */
+
+/*
+ * The text always ends in '\n', so every line, the cursor's included,
+ * is terminated and nlines is simply the number of '\n'.
+ */
 struct Buffer {
-  char lines[MAX_LINES][MAX_LINE_LEN];
-  uint8_t count;
+  gapbuf_t text;
+  uint16_t nlines;
 };
 
+struct View {
+  size_t   cur;                      /* cursor offset in the text      */
+  uint16_t row;                      /* line of the cursor             */
+  uint16_t top;                      /* first line on screen           */
+  size_t   top_pos;                  /* offset of line top             */
+  uint16_t marked;                   /* line carrying the '>' gutter   */
+  uint8_t  filled;                   /* rows now showing text          */
+  screen_t scr;
+  int      mode, shown_mode;         /* 0=cmd 1=ins                    */
+  int      msg_keys;                 /* keys left to show status_msg   */
+  bool     msg_dirty;
+};
+
+static char text_store[TEXT_SIZE];
+static char yank[MAX_LINE_LEN];
+static bool have_yank;
+
 static struct termios orig_term;
 
 static void enable_raw(void) {
@@ -70,23 +93,35 @@ static void disable_raw(void) {
   tcsetattr(STDIN_FILENO, TCSAFLUSH, &orig_term);
 }
 
-static void buf_init(struct Buffer *b) { memset(b, 0, sizeof *b); }
+static void buf_init(struct Buffer *b) {
+  gb_init(&b->text, text_store, sizeof text_store);
+  b->nlines = 0;
+}
 
 static void buf_free(struct Buffer *b) { (void)b; }
 
+/* Restore the trailing-'\n' invariant and recount lines. */
+static void buf_settle(struct Buffer *b) {
+  size_t len = gb_len(&b->text);
+  if (!len || gb_at(&b->text, len - 1) != '\n') {
+    if (gb_insert(&b->text, len, "\n", 1) == 0)
+      gb_erase(&b->text, len - 1, 1), gb_insert(&b->text, len - 1, "\n", 1);
+  }
+  b->nlines = gb_lines(&b->text);
+}
 
 static void load_file(struct Buffer *b, const char *path) {
   FILE *f = fopen(path, "r");
-  if (!f) {
+  if (f) {
+    char tmp[MAX_LINE_LEN];
+    size_t n;
+    while ((n = fread(tmp, 1, sizeof tmp, f)) > 0)
+      gb_insert(&b->text, gb_len(&b->text), tmp, n);
+    fclose(f);
+  } else {
     perror("open");
-    strncpy(b->lines[0], "\n", MAX_LINE_LEN);
-    b->count = 1;
-    return;
   }
-  char tmp[MAX_LINE_LEN];
-  while (fgets(tmp, sizeof tmp, f) && b->count < MAX_LINES)
-    insert_line(b->lines, &b->count, b->count, tmp);
-  fclose(f);
+  buf_settle(b);
 }
 
 static void save_file(const struct Buffer *b, const char *path) {
@@ -95,144 +130,283 @@ static void save_file(const struct Buffer *b, const char *path) {
     perror("open");
     return;
   }
-  for (uint8_t i = 0; i < b->count; ++i)
-    fputs(b->lines[i], f);
+  size_t len = gb_len(&b->text);
+  for (size_t i = 0; i < len; ++i)
+    putc(gb_at(&b->text, i), f);
   fclose(f);
 }
 
-static uint8_t EEMEM ee_buf[1 + MAX_LINES * MAX_LINE_LEN];
+/* Length (little endian) then the text, as in ned. */
+static uint8_t EEMEM ee_buf[2 + TEXT_SIZE];
 
 static void eeprom_save(const struct Buffer *b) {
-  eeprom_update_byte(&ee_buf[0], b->count);
-  for (uint8_t i = 0; i < b->count; ++i)
-    for (uint8_t j = 0; j < MAX_LINE_LEN; ++j)
-      eeprom_update_byte(&ee_buf[1 + i * MAX_LINE_LEN + j],
-                         (uint8_t)b->lines[i][j]);
+  size_t len = gb_len(&b->text);
+  eeprom_update_byte(&ee_buf[0], (uint8_t)len);
+  eeprom_update_byte(&ee_buf[1], (uint8_t)(len >> 8));
+  for (size_t i = 0; i < len; ++i)
+    eeprom_update_byte(&ee_buf[2 + i], (uint8_t)gb_at(&b->text, i));
 }
 
 static void eeprom_load(struct Buffer *b) {
-  b->count = eeprom_read_byte(&ee_buf[0]);
-  if (b->count > MAX_LINES)
-    b->count = MAX_LINES;
-  for (uint8_t i = 0; i < b->count; ++i)
-    for (uint8_t j = 0; j < MAX_LINE_LEN; ++j)
-      b->lines[i][j] =
-          (char)eeprom_read_byte(&ee_buf[1 + i * MAX_LINE_LEN + j]);
+  size_t len = eeprom_read_byte(&ee_buf[0]) |
+               (size_t)eeprom_read_byte(&ee_buf[1]) << 8;
+  if (len > TEXT_SIZE)
+    len = 0;                          /* blank or foreign EEPROM */
+  buf_init(b);
+  for (size_t i = 0; i < len; ++i) {
+    char c = (char)eeprom_read_byte(&ee_buf[2 + i]);
+    gb_insert(&b->text, i, &c, 1);
+  }
+  buf_settle(b);
+}
+
+/*──────────────────────────────  Screen update  ────────────────────────────*/
+
+static void message(struct View *v, const char *msg) {
+  set_status_message("%s", msg);
+  v->msg_keys  = 3;
+  v->msg_dirty = true;
 }
 
+/* Mark buffer line @line, or everything from it on, for repaint. */
+static void touch(struct View *v, uint16_t line) {
+  if (line >= v->top)
+    scr_touch(&v->scr, (uint8_t)(line - v->top < ROWS ? line - v->top : ROWS));
+}
+
+static void touch_from(struct View *v, uint16_t line) {
+  scr_touch_from(&v->scr, line > v->top ? (uint8_t)(line - v->top < ROWS
+                                                    ? line - v->top : ROWS)
+                                        : 0);
+}
+
+static void paint_gutter(const struct View *v, uint16_t line) {
+  printf("%c %3u ", line == v->row ? '>' : ' ', (unsigned)line + 1u);
+}
+
+static void paint_row(const struct Buffer *b, const struct View *v,
+                      uint8_t r, size_t pos) {
+  uint16_t line = (uint16_t)(v->top + r);
+  term_goto(r, 0);
+  if (line < b->nlines) {
+    char text[MAX_LINE_LEN];
+    gb_line(&b->text, pos, text, sizeof text);
+    paint_gutter(v, line);
+    highlight(text);
+  }
+  term_clear_eol();
+}
 
 static const char ins_str[] PROGMEM = "INSERT";
 static const char cmd_str[] PROGMEM = "COMMAND";
 
-static void draw(const struct Buffer *b, uint8_t row, uint8_t col, int mode) {
-  printf("\x1b[2J\x1b[H");
-  for (uint8_t i = 0; i < b->count; ++i) {
-    if (i == row)
-      printf("> %3zu ", i + 1);
-    else
-      printf("  %3zu ", i + 1);
-    highlight(b->lines[i]);
-    if (i == row && col < strlen(b->lines[i])) {
-      int caret_pos = display_width(b->lines[i], col);
-      printf("%*s^", caret_pos + 1, "");
+/*
+ * Bring the terminal up to date: scroll if the cursor left the window,
+ * repaint the rows marked dirty, move the '>' marker by rewriting one
+ * character, touch the status rows only when they changed, then park
+ * the real cursor at the insertion point.  A keystroke that edits one
+ * line costs one line of output.
+ */
+static void refresh(const struct Buffer *b, struct View *v) {
+  if (v->row < v->top || v->row >= v->top + ROWS) {
+    v->top = v->row < v->top ? v->row : (uint16_t)(v->row - ROWS + 1);
+    v->top_pos = gb_line_pos(&b->text, v->top);
+    scr_touch_from(&v->scr, 0);
+  }
+
+  if (v->marked != v->row) {
+    uint16_t lines[2] = { v->marked, v->row };
+    v->marked = v->row;
+    for (uint8_t i = 0; i < 2; ++i) {
+      uint16_t l = lines[i];
+      if (l >= v->top && l - v->top < ROWS && l < b->nlines &&
+          !(v->scr.dirty & (uint32_t)1 << (l - v->top))) {
+        term_goto((uint8_t)(l - v->top), 0);
+        putchar(l == v->row ? '>' : ' ');
+      }
     }
-    putchar('\n');
   }
-  fputs("-- ", stdout);
-  if (mode)
-    pgm_print(
-#ifdef __AVR__
-        ins_str
-#else
-        "INSERT"
-#endif
-    );
-  else
-    pgm_print(
-#ifdef __AVR__
-        cmd_str
-#else
-        "COMMAND"
-#endif
-    );
-  puts(" --");
-  if (status_timer > 0) {
-    printf("%s\n", status_msg);
-    --status_timer;
-  } else {
-    putchar('\n');
+
+  size_t pos = v->top_pos, len = gb_len(&b->text);
+  uint16_t left = (uint16_t)(b->nlines - v->top);
+  uint8_t filled = left < ROWS ? (uint8_t)left : ROWS;
+  for (uint8_t r = 0; r < ROWS && v->scr.dirty >> r; ++r) {
+    if (r >= filled && r >= v->filled)
+      break;                           /* already blank */
+    if (v->scr.dirty & (uint32_t)1 << r)
+      paint_row(b, v, r, pos);
+    if (pos < len)
+      pos = gb_eol(&b->text, pos) + 1;
+  }
+  v->scr.dirty = 0;
+  v->filled = filled;
+
+  if (v->shown_mode != v->mode) {
+    v->shown_mode = v->mode;
+    term_goto(ROWS, 0);
+    fputs("-- ", stdout);
+    pgm_print(v->mode ? ins_str : cmd_str);
+    fputs(" --", stdout);
+    term_clear_eol();
   }
+  if (v->msg_dirty) {
+    v->msg_dirty = false;
+    term_goto(ROWS + 1, 0);
+    if (v->msg_keys)
+      fputs(status_msg, stdout);
+    term_clear_eol();
+  }
+
+  char text[MAX_LINE_LEN];
+  size_t bol = gb_bol(&b->text, v->cur);
+  gb_line(&b->text, bol, text, sizeof text);
+  term_goto((uint8_t)(v->row - v->top),
+            (uint8_t)(GUTTER + display_width(text, v->cur - bol)));
+  fflush(stdout);
 }
 
+/*─────────────────────────────────  Editing  ───────────────────────────────*/
 
-static void command_loop(struct Buffer *b, const char *path) {
-  uint8_t row = 0, col = 0;
-  int mode = 0; /* 0=cmd 1=ins */
+static bool insert(struct Buffer *b, struct View *v, const char *s, size_t n) {
+  size_t k = gb_insert(&b->text, v->cur, s, n);
+  if (k < n) {
+    gb_erase(&b->text, v->cur, k);    /* no partial lines */
+    message(v, "Buffer full");
+    return false;
+  }
+  return true;
+}
+
+/* Move to the line starting at @bol, keeping the column where possible. */
+static void goto_line(struct Buffer *b, struct View *v, size_t bol,
+                      uint16_t row) {
+  size_t col = v->cur - gb_bol(&b->text, v->cur);
+  size_t eol = gb_eol(&b->text, bol);
+  v->cur = bol + (col < eol - bol ? col : eol - bol);
+  v->row = row;
+}
+
+/* Keys come straight from the descriptor so the escape-sequence read
+ * below sees them too; stdio would have buffered them. */
+static int getkey(void) {
+  unsigned char c;
+  return read(STDIN_FILENO, &c, 1) == 1 ? c : EOF;
+}
+
+/* A ':' or '/' argument, echoed on the message row. */
+static bool read_line(char *buf, size_t n) {
+  size_t i = 0;
   int ch;
+  fflush(stdout);
+  while ((ch = getkey()) != EOF && ch != '\n') {
+    if (ch == 127 && i) {
+      --i;
+      fputs("\b \b", stdout);
+    } else if (ch >= ' ' && ch != 127 && i + 1 < n) {
+      buf[i++] = (char)ch;
+      putchar(ch);
+    }
+    fflush(stdout);
+  }
+  buf[i] = '\0';
+  return ch != EOF;
+}
 
-  enable_raw();
-  draw(b, row, col, mode);
+static void command_loop(struct Buffer *b, const char *path) {
+  struct View v = { .scr = { .rows = ROWS }, .shown_mode = -1 };
+  int ch, prev = 0;
 
-  while ((ch = getchar()) != EOF) {
-    if (ch == '\x1b') { /* arrow keys */
+  enable_raw();
+  fputs("\x1b[2J", stdout);
+  scr_touch_from(&v.scr, 0);
+  refresh(b, &v);
+
+  while ((ch = getkey()) != EOF) {
+    bool arrow = false;
+    if (ch == '\x1b') { /* arrow keys; a lone ESC has nothing behind it */
+      struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
       char seq[2];
-      if (read(STDIN_FILENO, seq, 2) == 2 && seq[0] == '[') {
-        if (seq[1] == 'A')
-          ch = 'k';
-        else if (seq[1] == 'B')
-          ch = 'j';
-        else if (seq[1] == 'C')
-          ch = 'l';
-        else if (seq[1] == 'D')
-          ch = 'h';
+      if (poll(&pfd, 1, 50) == 1 && read(STDIN_FILENO, seq, 2) == 2 &&
+          seq[0] == '[' && seq[1] >= 'A' && seq[1] <= 'D') {
+        ch = "kjlh"[seq[1] - 'A'];
+        arrow = true;
       }
     }
+    if (v.msg_keys && --v.msg_keys == 0)
+      v.msg_dirty = true;
+
+    size_t bol = gb_bol(&b->text, v.cur);
+    size_t eol = gb_eol(&b->text, v.cur);
 
-    if (!mode) { /* command */
-      static int prev = 0;
+    if (!v.mode || arrow) { /* command, or a move while inserting */
       if (ch == 'i') {
-        mode = 1;
-      } else if (ch == 'h' && col)
-        --col;
-      else if (ch == 'l' && col + 1 < strlen(b->lines[row]))
-        ++col;
-      else if (ch == 'j' && row + 1 < b->count) {
-        ++row;
-        if (col >= strlen(b->lines[row]))
-          col = strlen(b->lines[row]);
-      } else if (ch == 'k' && row) {
-        --row;
-        if (col >= strlen(b->lines[row]))
-          col = strlen(b->lines[row]);
-      } else if (ch == 'x' && col < strlen(b->lines[row])) {
-        memmove(&b->lines[row][col], &b->lines[row][col + 1],
-                strlen(b->lines[row]) - col);
+        v.mode = 1;
+      } else if (ch == 'h' && v.cur > bol) {
+        --v.cur;
+      } else if (ch == 'l' && v.cur + !v.mode < eol) {
+        ++v.cur;
+      } else if (ch == 'j' && v.row + 1 < b->nlines) {
+        goto_line(b, &v, eol + 1, (uint16_t)(v.row + 1));
+      } else if (ch == 'k' && v.row) {
+        goto_line(b, &v, gb_bol(&b->text, bol - 1), (uint16_t)(v.row - 1));
+      } else if (ch == 'x' && v.cur < eol) {
+        gb_erase(&b->text, v.cur, 1);
+        if (v.cur + 1 == eol && v.cur > bol)
+          --v.cur;
+        touch(&v, v.row);
       } else if (ch == 'o') {
-        insert_line(b->lines, &b->count, row + 1, "\n");
-        row++;
-        col = 0;
-        mode = 1;
+        v.cur = eol + 1;
+        if (insert(b, &v, "\n", 1)) {
+          ++b->nlines;
+          ++v.row;
+          touch_from(&v, v.row);
+          v.mode = 1;
+        } else {
+          v.cur = eol;
+        }
       } else if (ch == 'd' && prev == 'd') {
-        delete_line(b->lines, &b->count, row);
-        if (row >= b->count)
-          row = b->count - 1;
-        prev = 0;
-      } else if (ch == 'd') {
-        prev = 'd';
+        gb_erase(&b->text, bol, eol + 1 - bol);
+        if (--b->nlines == 0)
+          buf_settle(b);
+        if (v.row >= b->nlines)
+          --v.row;
+        v.cur = gb_line_pos(&b->text, v.row);
+        touch_from(&v, v.row);
+        ch = 0;
       } else if (ch == 'y' && prev == 'y') {
-        strncpy(yank, b->lines[row], sizeof yank - 1);
-        prev = 0;
-      } else if (ch == 'y') {
-        prev = 'y';
-      } else if (ch == 'p' && yank[0]) {
-        insert_line(b->lines, &b->count, row + 1, yank);
+        gb_line(&b->text, bol, yank, sizeof yank);
+        have_yank = true;
+        ch = 0;
+      } else if (ch == 'p' && have_yank) {
+        char line[MAX_LINE_LEN + 1];
+        size_t n = strlen(yank);
+        memcpy(line, yank, n);
+        line[n++] = '\n';
+        v.cur = eol + 1;
+        if (insert(b, &v, line, n)) {
+          ++b->nlines;
+          ++v.row;
+          touch_from(&v, v.row);
+        } else {
+          v.cur = bol;
+        }
       } else if (ch == 'E') {
         eeprom_save(b);
       } else if (ch == 'L') {
         eeprom_load(b);
+        v.cur = 0;
+        v.row = 0;
+        v.top = 0;
+        v.top_pos = 0;
+        scr_touch_from(&v.scr, 0);
       } else if (ch == ':') {
         char cmd[32];
-        fgets(cmd, sizeof cmd, stdin);
+        term_goto(ROWS + 1, 0);
+        putchar(':');
+        term_clear_eol();
+        if (!read_line(cmd, sizeof cmd))
+          break;
+        v.msg_dirty = true;
         if (strncmp(cmd, "wq", 2) == 0) {
           save_file(b, path);
           eeprom_save(b);
@@ -245,52 +419,59 @@ static void command_loop(struct Buffer *b, const char *path) {
         if (cmd[0] == 'q')
           break;
       } else if (ch == '/') {
-        char term[32];
-        fgets(term, sizeof term, stdin);
-        for (uint8_t i = row + 1; i < b->count; ++i)
-          if (strstr(b->lines[i], term)) {
-            row = i;
-            col = 0;
+        char term[32], text[MAX_LINE_LEN];
+        term_goto(ROWS + 1, 0);
+        putchar('/');
+        term_clear_eol();
+        if (!read_line(term, sizeof term))
+          break;
+        v.msg_dirty = true;
+        size_t pos = eol + 1, len = gb_len(&b->text);
+        for (uint16_t i = (uint16_t)(v.row + 1); pos < len; ++i) {
+          gb_line(&b->text, pos, text, sizeof text);
+          if (strstr(text, term)) {
+            v.row = i;
+            v.cur = pos;
             break;
           }
-      } else {
-        prev = 0;
+          pos = gb_eol(&b->text, pos) + 1;
+        }
       }
+      prev = ch;
     } else { /* insert mode */
       if (ch == 27) {
-        mode = 0;
-        continue;
-      }
-      if (ch == 127 && col) { /* backspace */
-        memmove(&b->lines[row][col - 1], &b->lines[row][col],
-                strlen(b->lines[row]) - col + 1);
-        --col;
-        continue;
-      }
-      if (ch == '\n') {
-        char tail[MAX_LINE_LEN];
-        strncpy(tail, b->lines[row] + col, MAX_LINE_LEN - 1);
-        tail[MAX_LINE_LEN - 1] = '\0';
-        b->lines[row][col] = '\n';
-        b->lines[row][col + 1] = '\0';
-        insert_line(b->lines, &b->count, row + 1, tail);
-        row++;
-        col = 0;
-        continue;
-      }
-      uint8_t len = strlen(b->lines[row]);
-      if ((uint8_t)(len + 1) < MAX_LINE_LEN) {
-        memmove(&b->lines[row][col + 1], &b->lines[row][col], len - col + 1);
-        b->lines[row][col] = ch;
-        ++col;
+        v.mode = 0;
+      } else if (ch == 127) { /* backspace */
+        if (v.cur > bol) {
+          gb_erase(&b->text, --v.cur, 1);
+          touch(&v, v.row);
+        } else if (v.cur) {               /* join with the line above */
+          gb_erase(&b->text, --v.cur, 1);
+          --b->nlines;
+          --v.row;
+          touch_from(&v, v.row);
+        }
+      } else if (ch == '\n') {
+        if (insert(b, &v, "\n", 1)) {
+          ++v.cur;
+          ++b->nlines;
+          touch_from(&v, v.row);
+          ++v.row;
+        }
       } else {
-        set_status_message("Line length limit reached");
+        char c = (char)ch;
+        if (insert(b, &v, &c, 1)) {
+          ++v.cur;
+          touch(&v, v.row);
+        }
       }
     }
 
-    draw(b, row, col, mode);
+    refresh(b, &v);
   }
 
+  term_goto(ROWS + 2, 0);
+  fflush(stdout);
   disable_raw();
 }
 
@@ -1,21 +1,60 @@
 /* SPDX-License-Identifier: MIT
  * See LICENSE file in the repository root for full license information.
  */
-/* Minimal on-device GDB remote stub over a TTY. */
+/* Minimal on-device GDB remote stub over a TTY.
+ *
+ * A monitor rather than a full debugger: enough of the remote serial
+ * protocol to read and write memory from GDB or a script while the
+ * kernel keeps running.
+ *
+ *  - m / M      hex memory read and write
+ *  - X          binary memory write (half the bytes of M)
+ *  - qXfer:nk:read:{trace,prof,log}:off,len
+ *               binary bulk read of the nk_trace / nk_prof / nk_log
+ *               images, without knowing their addresses
+ *  - QStartNoAckMode, and run-length encoded replies
+ *  - QBaud:<hex rate>  switch the line speed once OK has been acked,
+ *               when the application installed a hook
+ *
+ * On AVR addresses follow avr-gdb: flash from 0, RAM at 0x800000,
+ * EEPROM at 0x810000.  Elsewhere they are plain pointers.
+ */
 
 #ifndef AVR_GDBSTUB_H
 #define AVR_GDBSTUB_H
 
-#include "tty.h"
+#include <stdint.h>
+#include "drivers/tty/tty.h"
+#include "avrix-config.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/** Largest packet accepted, '$' and checksum excluded (replies may be longer) */
+#ifndef GDBSTUB_PACKET_SIZE
+#  define GDBSTUB_PACKET_SIZE 128
+#endif
+
+/** Highest rate QBaud accepts */
+#ifndef GDBSTUB_BAUD_MAX
+#  if defined(CONFIG_DEBUG_GDB_BAUD_MAX)
+#    define GDBSTUB_BAUD_MAX CONFIG_DEBUG_GDB_BAUD_MAX
+#  else
+#    define GDBSTUB_BAUD_MAX 1000000UL
+#  endif
+#endif
+
+/** Reprograms the line for @p baud (e.g. calls hal_uart_attach()) */
+typedef void (*gdbstub_baud_fn)(uint32_t baud);
+
 void gdbstub_init(tty_t *tty);
 void gdbstub_poll(void);
 void gdbstub_break(void);
 
+/** Allow QBaud; without a hook it is refused */
+void gdbstub_set_baud_hook(gdbstub_baud_fn fn);
+
 #ifdef __cplusplus
 }
 #endif
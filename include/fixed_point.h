@@ -13,7 +13,27 @@ extern "C" {
 
 /**
  * @file fixed_point.h
- * @brief Minimal fixed-point arithmetic for AVR (Q8.8).
+ * @brief Minimal fixed-point arithmetic for AVR (Q8.8 and Q15).
+ *
+ * Besides the scalar q8_8_mul() there are batched kernels: dot product,
+ * FIR, biquad, vector scale and add.  One call walks the whole block,
+ * so a filter pays the call overhead once per buffer instead of once
+ * per sample.  On AVR cores with MUL the inner loops are hand-scheduled
+ * mul/muls/mulsu (multiply-accumulate) and fmul/fmuls/fmulsu (Q15
+ * scale); on Cortex-M4/M7 the dot product and add use SMLAD/QADD16.
+ * Everything else is portable C with the same results bit for bit.
+ *
+ * Sums are kept in a 32-bit accumulator holding the full products:
+ * Q2.30 for Q15 data, Q16.16 for Q8.8, Q3.29 for the biquad.  The
+ * accumulator wraps, so the sum of |a[i]*b[i]| has to stay inside its
+ * range (below 2.0 for a Q15 dot product, true of any FIR whose
+ * coefficients sum to at most 1 in magnitude).  Results are rounded
+ * and saturated to 16 bits.
+ *
+ * Approximate ATmega328P cost per element: 34 cycles per tap of
+ * q15_dot()/q8_8_dot()/q15_fir(), about 200 cycles per biquad sample,
+ * 40 for q15_scale(), 20 for q15_add().  tests/sim_bench_dsp.c
+ * measures them.
  */
 
 /**
@@ -35,6 +55,129 @@ typedef int16_t q8_8_t;
  */
 q8_8_t q8_8_mul(q8_8_t a, q8_8_t b);
 
+/** Q8.8 dot product: sum of a[i]*b[i], rounded and saturated */
+q8_8_t q8_8_dot(const q8_8_t *a, const q8_8_t *b, uint16_t n);
+
+/** y[i] = x[i] * k, rounded and saturated (y may be x) */
+void q8_8_scale(const q8_8_t *x, q8_8_t k, q8_8_t *y, uint16_t n);
+
+/** y[i] = a[i] + b[i], saturated (y may be a or b) */
+void q8_8_add(const q8_8_t *a, const q8_8_t *b, q8_8_t *y, uint16_t n);
+
+/*═══════════════════════════════════════════════════════════════════
+ * Q15: signed fraction in [-1, 1), 15 fractional bits
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef int16_t q15_t;
+
+#define Q15_MAX ((q15_t)0x7FFF)
+#define Q15_MIN ((q15_t)-0x8000)
+
+/** Convert a constant in [-1, 1) at compile time, e.g. Q15(0.5) */
+#define Q15(x) ((q15_t)((x) * 32768.0 + ((x) < 0 ? -0.5 : 0.5)))
+
+/** Q15 product, rounded; -1 * -1 saturates to Q15_MAX */
+q15_t q15_mul(q15_t a, q15_t b);
+
+/** Raw Q2.30 sum of a[i]*b[i] added to @p acc (no rounding) */
+int32_t q15_mac(int32_t acc, const q15_t *a, const q15_t *b, uint16_t n);
+
+/** Round and saturate a Q2.30 accumulator to Q15 */
+q15_t q15_from_acc(int32_t acc);
+
+/** Q15 dot product, rounded and saturated */
+q15_t q15_dot(const q15_t *a, const q15_t *b, uint16_t n);
+
+/** y[i] = x[i] * k, rounded and saturated (y may be x) */
+void q15_scale(const q15_t *x, q15_t k, q15_t *y, uint16_t n);
+
+/** y[i] = a[i] + b[i], saturated (y may be a or b) */
+void q15_add(const q15_t *a, const q15_t *b, q15_t *y, uint16_t n);
+
+/**
+ * @brief FIR filter state.
+ *
+ * The delay line is 2 * ntaps samples: every input is written twice,
+ * ntaps apart, so the newest ntaps samples are always contiguous and
+ * each output is a single q15_mac() over h[].
+ */
+typedef struct {
+    const q15_t *h;      /**< ntaps coefficients, h[0] on the newest sample */
+    q15_t *delay;        /**< 2 * ntaps samples of history */
+    uint16_t ntaps;
+    uint16_t pos;        /**< Slot of the newest sample */
+} q15_fir_t;
+
+/** Bind @p h and @p delay (2 * ntaps samples) to @p f, history cleared */
+void q15_fir_init(q15_fir_t *f, const q15_t *h, q15_t *delay, uint16_t ntaps);
+
+/** Filter n samples, y may be x */
+void q15_fir(q15_fir_t *f, const q15_t *x, q15_t *y, uint16_t n);
+
+/**
+ * @brief Direct form I biquad, coefficients in Q2.14.
+ *
+ *   y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] + a1 y[n-1] + a2 y[n-2]
+ *
+ * The feedback terms are added, so a1/a2 are the negated denominator
+ * coefficients of the usual 1 + a1 z^-1 + a2 z^-2 form.  Q2.14 covers
+ * [-2, 2), enough for any stable section.
+ */
+typedef struct {
+    q15_t c[5];          /**< b0, b1, b2, a1, a2 */
+    q15_t s[4];          /**< x[n-1], x[n-2], y[n-1], y[n-2] */
+} q15_biquad_t;
+
+/** Q2.14 coefficient from a constant in [-2, 2), e.g. Q2_14(-1.8) */
+#define Q2_14(x) ((q15_t)((x) * 16384.0 + ((x) < 0 ? -0.5 : 0.5)))
+
+/** Filter n samples through @p f, y may be x */
+void q15_biquad(q15_biquad_t *f, const q15_t *x, q15_t *y, uint16_t n);
+
+/*═══════════════════════════════════════════════════════════════════
+ * Transcendentals (src/fixed_math.c)
+ *
+ * Table-driven, so control code need not pull in soft-float libm: a
+ * quarter-wave sine, atan and 2^x tables in HAL_PROGMEM (518 bytes),
+ * read with hal_pgm_read_word() and linearly interpolated.
+ *
+ * Q15 angles are fractions of pi: Q15_MIN is -pi, 0x4000 is pi/2, and
+ * the value wraps like a binary angle.  Q8.8 angles are radians.
+ *
+ * Maximum error over every input, against libm (LSB of the result):
+ *
+ *   q15_sin/cos     1.5   q8_8_sin/cos    1
+ *   q15_atan2       1.5   q8_8_atan2      1
+ *   q15_sqrt        0.5   q8_8_sqrt       0.5   (correctly rounded)
+ *   q15_exp         1.5   q8_8_exp        1 LSB or 0.005 %, the larger
+ *
+ * Approximate ATmega328P cycles per call: sin/cos 80, exp 120, atan2
+ * 750 (one 32-bit division), sqrt 2000 (Newton, usually three 32-bit
+ * divisions, at most five).  tests/sim_bench_dsp.c measures them.
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** sin(angle * pi) in Q15 */
+q15_t q15_sin(q15_t angle);
+/** cos(angle * pi) in Q15 */
+q15_t q15_cos(q15_t angle);
+/** atan2(y, x) / pi in Q15; 0 for (0, 0) */
+q15_t q15_atan2(q15_t y, q15_t x);
+/** sqrt(x), 0 for x <= 0 */
+q15_t q15_sqrt(q15_t x);
+/** e^x, saturating to Q15_MAX for x >= 0 */
+q15_t q15_exp(q15_t x);
+
+/** sin of @p rad radians */
+q8_8_t q8_8_sin(q8_8_t rad);
+/** cos of @p rad radians */
+q8_8_t q8_8_cos(q8_8_t rad);
+/** atan2(y, x) in radians, [-pi, pi]; 0 for (0, 0) */
+q8_8_t q8_8_atan2(q8_8_t y, q8_8_t x);
+/** sqrt(x), 0 for x <= 0 */
+q8_8_t q8_8_sqrt(q8_8_t x);
+/** e^x, saturating to INT16_MAX above ln(128) */
+q8_8_t q8_8_exp(q8_8_t x);
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,12 +33,22 @@ extern "C" {
 /** Maximum length of a filename (excluding null terminator). */
 #define FS_MAX_NAME 14
 
+/** Block addresses held in the inode itself. */
+#define FS_NDIRECT 4
+
+/** Block addresses held in the single-indirect block. */
+#define FS_NINDIRECT (FS_BLOCK_SIZE / sizeof(uint16_t))
+
+/** Largest file, in blocks: direct plus single-indirect. */
+#define FS_MAX_FILE_BLOCKS (FS_NDIRECT + FS_NINDIRECT)
+
 /** On-disk inode structure mirroring UNIX V7. */
 typedef struct {
     uint8_t  type;                /**< 0 = free, 1 = file, 2 = directory */
     uint8_t  nlink;               /**< Reference count */
     uint16_t size;                /**< File size in bytes */
-    uint16_t addrs[4];            /**< Direct block addresses */
+    uint16_t addrs[FS_NDIRECT];   /**< Direct block addresses */
+    uint16_t indirect;            /**< Block of FS_NINDIRECT more addresses */
 } dinode_t;
 
 /** File handle used by the simple API. */
@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_arena.h
+ * @brief Bump-pointer arenas with mark/release for scratch memory
+ *
+ * An arena hands out memory from one contiguous buffer by advancing a
+ * pointer.  Nothing is freed individually: take a mark before a
+ * request-scoped burst of allocations and release back to it
+ * afterwards.  Large temporaries (packet frames, editor lines) leave
+ * the task stack, so stacks can be sized for call depth alone.
+ *
+ * ```c
+ * nk_arena_mark_t m = nk_arena_mark(&a);
+ * uint8_t *frame = nk_arena_alloc(&a, IPV4_MTU);
+ * ...
+ * nk_arena_release(&a, m);
+ * ```
+ *
+ * Arenas are not locked; give each task (or each driver) its own.
+ */
+
+#ifndef NK_ARENA_H
+#define NK_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Alignment of every allocation (1 on AVR). */
+#ifndef NK_ARENA_ALIGN
+#  define NK_ARENA_ALIGN _Alignof(max_align_t)
+#endif
+
+typedef struct nk_arena {
+    uint8_t *base;   /**< Backing buffer */
+    size_t   size;   /**< Buffer bytes */
+    size_t   top;    /**< Bytes handed out */
+    size_t   peak;   /**< High-water mark of top */
+    void    *block;  /**< kalloc() block behind base, or NULL */
+} nk_arena_t;
+
+/** Opaque position returned by nk_arena_mark(). */
+typedef size_t nk_arena_mark_t;
+
+/**
+ * @brief Build an arena over a caller-provided buffer
+ */
+void nk_arena_init(nk_arena_t *a, void *buf, size_t size);
+
+/**
+ * @brief Build an arena over a fresh kalloc() block
+ * @return false if the heap cannot supply @p size bytes
+ */
+bool nk_arena_init_heap(nk_arena_t *a, size_t size);
+
+/**
+ * @brief Return the backing block to the heap (heap arenas only)
+ */
+void nk_arena_destroy(nk_arena_t *a);
+
+/**
+ * @brief Bump-allocate @p size bytes aligned to NK_ARENA_ALIGN
+ * @return Pointer, or NULL if the arena is exhausted
+ */
+void *nk_arena_alloc(nk_arena_t *a, size_t size);
+
+/** Current position, for a later nk_arena_release(). */
+static inline nk_arena_mark_t nk_arena_mark(const nk_arena_t *a) {
+    return a->top;
+}
+
+/** Drop everything allocated since @p m. */
+static inline void nk_arena_release(nk_arena_t *a, nk_arena_mark_t m) {
+    if (m <= a->top) a->top = m;
+}
+
+/** Drop every allocation. */
+static inline void nk_arena_reset(nk_arena_t *a) {
+    a->top = 0;
+}
+
+/** Bytes still available (before alignment padding). */
+static inline size_t nk_arena_remaining(const nk_arena_t *a) {
+    return a->size - a->top;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NK_ARENA_H */
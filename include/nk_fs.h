@@ -33,9 +33,68 @@ static inline const uint8_t *ee_cptr(uint16_t addr)
 /**
  * @file nk_fs.h
  * @brief TinyLog-4 EEPROM filesystem API.
+ *
+ * ## Lookup index
+ * nk_fs_init() replays the log once into a RAM table of NK_FS_INDEX
+ * entries mapping each live key to the slot of its newest record
+ * (3 bytes per entry on AVR), kept current by put and delete.  A hit
+ * costs one 4-byte record read; a miss costs nothing while every live
+ * key fits.  Once the table has overflowed, keys it does not hold are
+ * looked up by walking the log backwards as before.
+ *
+ * With NK_FS_BLOOM > 0 a bloom filter of that many bytes screens those
+ * walks: keys never written since boot are rejected without touching
+ * the EEPROM.  NK_FS_INDEX = 0 with a small NK_FS_BLOOM is the variant
+ * for the smallest parts.
+ *
+ * ## Checkpoint
+ * With NK_FS_CHECKPOINT the index and bloom filter are saved every
+ * eight rows to two alternating slots at NK_FS_CKPT_ADDR.  nk_fs_init()
+ * then restores the newest usable slot and replays only the rows
+ * written after it instead of scanning every header and the whole log.
+ * The slots take 2 * (5 + 3 * NK_FS_INDEX + NK_FS_BLOOM) bytes after the
+ * 1 KiB log, so this needs a part with more than 1 KiB of EEPROM.
+ *
+ * ## Warm restart
+ * With NK_WARM (kernel/lib/nk_warm.h) the cursor, index and bloom
+ * filter live in .noinit, saved after every call that writes.  After
+ * a watchdog or software reset nk_fs_init() checks their CRC and
+ * returns without reading the EEPROM at all.
  */
 
-/** Initialise TinyLog-4 by scanning EEPROM for the last valid record. */
+/** RAM index entries (0 = walk the log on every lookup). */
+#ifndef NK_FS_INDEX
+#  if defined(CONFIG_FS_NK_FS_INDEX)
+#    define NK_FS_INDEX CONFIG_FS_NK_FS_INDEX
+#  else
+#    define NK_FS_INDEX 0
+#  endif
+#endif
+
+/** Save the index for fast mounts (needs NK_FS_INDEX or NK_FS_BLOOM). */
+#ifndef NK_FS_CHECKPOINT
+#  if defined(CONFIG_FS_NK_FS_CHECKPOINT)
+#    define NK_FS_CHECKPOINT CONFIG_FS_NK_FS_CHECKPOINT
+#  else
+#    define NK_FS_CHECKPOINT 0
+#  endif
+#endif
+
+/** EEPROM address of the two checkpoint slots (just after the log). */
+#ifndef NK_FS_CKPT_ADDR
+#  define NK_FS_CKPT_ADDR 1024u
+#endif
+
+/** Bloom filter bytes in front of log walks (0 = none). */
+#ifndef NK_FS_BLOOM
+#  if defined(CONFIG_FS_NK_FS_BLOOM)
+#    define NK_FS_BLOOM CONFIG_FS_NK_FS_BLOOM
+#  else
+#    define NK_FS_BLOOM 0
+#  endif
+#endif
+
+/** Initialise TinyLog-4: find the last valid record and build the index. */
 void nk_fs_init(void);
 
 /** Append a key/value pair. Returns false on error or full store. */
@@ -47,8 +106,18 @@ bool nk_fs_get(uint16_t key, uint16_t *val);
 /** Mark a key as deleted. */
 bool nk_fs_del(uint16_t key);
 
-/** Optional garbage collection routine. */
-void nk_fs_gc(void);
+/**
+ * @brief One bounded step of garbage collection
+ *
+ * Copies forward at most one live record of the row the log erases
+ * next.  Writes do the same on demand when they would otherwise reach
+ * that row first, so calling this is optional; doing it from an idle
+ * or background task keeps the work off the write path:
+ * `while (nk_fs_gc()) nk_yield();`
+ *
+ * @return true if that row may still hold live records
+ */
+bool nk_fs_gc(void);
 
 #ifdef __cplusplus
 }
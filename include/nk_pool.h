@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_pool.h
+ * @brief Compile-time fixed-size object pools
+ *
+ * A pool is a static array of @p count objects plus a one-bit-per-slot
+ * occupancy map, both in `.bss`; the descriptor itself is `const`.
+ * Allocation returns the lowest free slot, so index-addressed tables
+ * (file descriptors, thread records) keep their POSIX "lowest free"
+ * numbering.
+ *
+ * ```c
+ * NK_POOL_DEFINE(msg_pool, msg_t, 8);
+ *
+ * msg_t *m = NK_POOL_ALLOC(msg_pool);
+ * ...
+ * nk_pool_free(&msg_pool, m);
+ * ```
+ *
+ * Pools created with NK_POOL_DEFINE_ISR() update the map with
+ * hal_atomic_fetch_or_u8() and hal_atomic_fetch_and_u8(), so slots can
+ * be taken and returned from interrupt handlers and other cores.  Plain
+ * pools leave locking to the caller.
+ *
+ * Cost: (count + 7) / 8 bytes of map; alloc scans at most that many
+ * bytes, free is O(1).  Up to 255 slots per pool.
+ */
+
+#ifndef NK_POOL_H
+#define NK_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * POOL DESCRIPTOR
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define NK_POOL_ISR 0x01u  /**< Map updates are atomic (ISR/SMP safe) */
+
+typedef struct {
+    volatile uint8_t *map;   /**< Occupancy bits, set = in use */
+    uint8_t          *slots; /**< Object storage */
+    uint16_t          stride;/**< sizeof(object) */
+    uint8_t           count; /**< Number of slots */
+    uint8_t           flags; /**< NK_POOL_ISR */
+} nk_pool_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * DEFINITION MACROS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Define a pool with explicit flags (file scope). */
+#define NK_POOL_DEFINE_FLAGS(name, type, n, fl)                           \
+    _Static_assert((n) >= 1 && (n) <= 255, "pool needs 1..255 slots");    \
+    static type name##_slots[n];                                          \
+    static volatile uint8_t name##_map[((n) + 7) / 8];                    \
+    static const nk_pool_t name = {                                       \
+        name##_map, (uint8_t *)name##_slots, sizeof(type), (n), (fl)      \
+    }
+
+/** Define a pool for task context only (caller serialises). */
+#define NK_POOL_DEFINE(name, type, n) NK_POOL_DEFINE_FLAGS(name, type, n, 0)
+
+/** Define a pool usable from ISRs and other cores. */
+#define NK_POOL_DEFINE_ISR(name, type, n) \
+    NK_POOL_DEFINE_FLAGS(name, type, n, NK_POOL_ISR)
+
+/** Typed allocation from a pool defined in this translation unit. */
+#define NK_POOL_ALLOC(name) \
+    ((__typeof__(&name##_slots[0]))nk_pool_alloc(&name))
+
+/*═══════════════════════════════════════════════════════════════════
+ * OPERATIONS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Take the lowest free slot
+ * @return Slot pointer (contents undefined), or NULL if the pool is full
+ */
+void *nk_pool_alloc(const nk_pool_t *p);
+
+/**
+ * @brief Return a slot to its pool
+ * @return false if @p obj is not an in-use slot of @p p
+ */
+bool nk_pool_free(const nk_pool_t *p, void *obj);
+
+/** Release every slot. */
+void nk_pool_reset(const nk_pool_t *p);
+
+/**
+ * @brief Slot index of @p obj
+ * @return 0..count-1, or -1 if @p obj is not a slot of @p p
+ */
+int nk_pool_index(const nk_pool_t *p, const void *obj);
+
+/**
+ * @brief Slot by index
+ * @return Slot pointer, or NULL if @p idx is out of range or free
+ */
+void *nk_pool_at(const nk_pool_t *p, int idx);
+
+/** Number of slots currently allocated. */
+uint8_t nk_pool_used(const nk_pool_t *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NK_POOL_H */
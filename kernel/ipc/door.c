@@ -6,13 +6,60 @@
  * @file door.c
  * @brief Portable Door RPC Implementation
  *
- * Zero-copy RPC for embedded systems. Originally designed for ATmega328P,
- * now portable via HAL abstraction.
+ * Synchronous RPC for embedded systems. Originally designed for
+ * ATmega328P, now portable via HAL abstraction.
+ *
+ * ## Channels
+ * Every call goes through the channel of its target task: a slab plus
+ * the caller, size and flags of the call in progress.  With
+ * DOOR_PER_TARGET each task has its own channel, so calls to different
+ * servers proceed independently and a server may itself call another
+ * server; otherwise all doors share channel 0.  A channel is claimed
+ * with an atomic test-and-set and held until the caller has copied the
+ * reply out, so a second client of a busy server yields instead of
+ * overwriting the message.
+ *
+ * ## Zero-Copy Doors
+ * By default a call costs two copies of the message (request into the
+ * slab, reply back out).  Doors registered with DOOR_F_ZEROCOPY skip
+ * both: the channel records the caller's buffer and door_message()
+ * hands that to the server, which replies in place.  The CRC is then
+ * computed over the caller's buffer and kept in the channel rather
+ * than appended, so `buf` needs no spare trailing byte.
+ *
+ * ## Batches
+ * door_callv() lends a whole vector of messages in one switch.  The
+ * server handles door_message(), calls door_next() to step to the
+ * next one, and door_return()s once door_next() says the batch is
+ * done, so a burst of N small requests costs two switches, not 2N.
+ *
+ * ## Priority Donation
+ * While it serves a call the server runs at the better of its own and
+ * the caller's effective priority (nk_task_boost()), so a preempted
+ * server cannot leave an urgent client waiting behind medium-priority
+ * tasks.  door_return() drops back to the priority the server had when
+ * the call arrived.
+ *
+ * ## Cross-Core Calls
+ * With DOOR_XCORE a server homed on another core is not switched to
+ * directly.  The caller fills the channel as usual, then appends the
+ * server's ID to that core's call queue and sends it an IPI.  The
+ * queue has one slot per task, so it cannot overflow: every entry is
+ * a claimed channel.  Producers reserve a slot with an atomic
+ * fetch-add and publish into it; only the owning core consumes.
+ * door_ipi() on that core enters each queued server in place of the
+ * interrupted task, and the server's door_return() switches back to that
+ * task.  It also wakes the caller, which sleeps on the channel until
+ * the reply is in.
  *
  * ## Memory Footprint
- * - Flash: ~700 bytes (with CRC-8)
- * - SRAM: DOOR_SLAB_SIZE + (NK_MAX_TASKS * DOOR_SLOTS * 2) + 3 bytes
- * - Example: 128 + (8 * 4 * 2) + 3 = 195 bytes for 8 tasks
+ * - Flash: ~700 bytes, plus nk_crc8() when a door uses DOOR_F_CRC
+ * - SRAM: DOOR_CHANNELS * (DOOR_SLAB_SIZE + 8 + 2 * sizeof(void *))
+ *         + DOOR_CAPS * sizeof(door_cap_t) bytes
+ * - Example: 8 * 140 + 48 = 1168 bytes per-target, 188 shared, 8 tasks
+ *   with 16-bit pointers and the default 16 capabilities
+ * - DOOR_XCORE adds 4 bytes per channel and NK_MAX_TASKS + 2 bytes
+ *   per core for the call queues
  *
  * ## Thread Safety
  * - Not reentrant: only one door call per task at a time
@@ -22,6 +69,8 @@
 
 #include "door.h"
 #include "arch/common/hal.h"
+#include "kernel/sync/nk_trace.h"
+#include "kernel/lib/nk_crc.h"
 #include <string.h>
 
 /*═══════════════════════════════════════════════════════════════════
@@ -37,70 +86,173 @@ _Static_assert(sizeof(door_t) == 2, "door_t must remain 2 bytes");
  *═══════════════════════════════════════════════════════════════════*/
 
 /**
- * @brief Shared message buffer
+ * @brief Message buffers, one per channel
  *
  * Lives in .noinit section for warm-reboot persistence.
- * All door messages pass through this single buffer.
  */
 HAL_SECTION(".noinit")
-uint8_t door_slab[DOOR_SLAB_SIZE];
+uint8_t door_slab[DOOR_CHANNELS][DOOR_SLAB_SIZE];
 
 /**
- * @brief Per-task door descriptor vectors
+ * @brief Door capability table, keyed by (task, descriptor index)
  *
- * door_vec[tid][idx] holds the descriptor for task tid, slot idx.
+ * Kept out of .noinit like the channels: a warm start re-registers its
+ * doors anyway, and stale keys after a cold boot would be live doors.
  */
-HAL_SECTION(".noinit")
-door_t door_vec[NK_MAX_TASKS][DOOR_SLOTS];
+door_cap_t door_caps[DOOR_CAPS];
 
 /**
- * @brief Calling task ID (saved during door_call)
- */
-static volatile uint8_t door_caller HAL_SECTION(".noinit");
-
-/**
- * @brief Message length in 8-byte words (1-15)
+ * @brief Call in progress on one channel
+ *
+ * Kept out of .noinit: a stale busy flag would wedge the channel
+ * after a cold boot.
  */
-static volatile uint8_t door_words_v;
+typedef struct {
+    uint8_t *volatile msg;   /**< Slab, or the caller's lent buffer */
+    volatile uint8_t busy;   /**< Claimed from door_call() to reply copy-out */
+    volatile uint8_t caller; /**< Calling task ID */
+    volatile uint8_t words;  /**< Message length in 8-byte words (1-15) */
+    volatile uint8_t flags;  /**< Protocol flags (4 bits) */
+    volatile uint8_t crc;    /**< CRC-8 of the request (DOOR_F_CRC) */
+    volatile uint8_t left;   /**< Batched messages after this one */
+    volatile uint8_t span;   /**< Descriptor size in words (batches) */
+    volatile uint8_t prio;   /**< Server's own priority before donation */
+    const door_iov_t *volatile iov; /**< Next batched message */
+#if DOOR_XCORE
+    volatile uint8_t remote; /**< Caller is on another core */
+    volatile uint8_t replied;/**< Set by door_return() for a remote caller */
+    uint8_t resume;          /**< Task the server took over from */
+    nk_waitq_t reply_q;      /**< Remote caller waiting for the reply */
+#endif
+} door_chan_t;
+
+static door_chan_t door_chan[DOOR_CHANNELS];
+
+#if DOOR_PER_TARGET
+#  define CHAN(tid) (tid)
+#else
+#  define CHAN(tid) ((void)(tid), 0)
+#endif
+
+#if DOOR_XCORE
+#  ifndef DOOR_CORES
+#    if defined(CONFIG_KERNEL_SMP_CORES)
+#      define DOOR_CORES CONFIG_KERNEL_SMP_CORES
+#    else
+#      define DOOR_CORES 1
+#    endif
+#  endif
+
+/* Executing core and IPI; hosted tests stand in for the ports' own */
+#  ifndef DOOR_THIS_CPU
+#    define DOOR_THIS_CPU() hal_cpu_id()
+#  endif
+#  ifndef DOOR_IPI_SEND
+#    define DOOR_IPI_SEND(core) hal_ipi_send(core)
+#  endif
 
 /**
- * @brief Protocol flags (4 bits)
+ * @brief Servers to enter on one core, as (task ID + 1); 0 is empty
+ *
+ * Indices are free-running; NK_MAX_TASKS is a power of two dividing 256.
  */
-static volatile uint8_t door_flags_v;
+typedef struct {
+    volatile uint8_t slot[NK_MAX_TASKS];
+    volatile uint8_t tail;   /**< Next slot to reserve (any core) */
+    uint8_t          head;   /**< Next slot to run (owning core only) */
+} door_xq_t;
+
+static door_xq_t door_xq[DOOR_CORES];
+#endif
+
+/* DOOR_F_CRC: CRC-8/MAXIM over the request (kernel/lib/nk_crc.h) */
+static inline uint8_t crc8_maxim(const uint8_t *p, uint8_t len) {
+    return nk_crc8(0, p, len);
+}
 
 /*═══════════════════════════════════════════════════════════════════
- * CRC-8 (Dallas/Maxim polynomial: 0x31)
+ * INTERNAL HELPERS
  *═══════════════════════════════════════════════════════════════════*/
 
-/**
- * @brief CRC-8 lookup table (Dallas/Maxim polynomial)
- *
- * Polynomial: x^8 + x^5 + x^4 + 1 (0x31)
- * Used for optional message validation (flag bit 0).
+/* Claim the channel carrying calls to @p target. */
+static door_chan_t *chan_claim(uint8_t target) {
+    door_chan_t *ch = &door_chan[CHAN(target)];
+    while (hal_atomic_test_and_set_u8(&ch->busy)) {
+        nk_yield();
+    }
+    return ch;
+}
+
+/*
+ * Claim a free capability entry for @p key.  Only the owning task ever
+ * inserts its keys, but two tasks may race for the same free slot: the
+ * compare-exchange settles it and the loser probes on.  The descriptor
+ * is still empty (words == 0) until door_register() fills it in.
  */
-static const uint8_t crc8_lut[32] = {
-    0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97,
-    0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
-    0x43, 0x72, 0x21, 0x10, 0x87, 0xB6, 0xE5, 0xD4,
-    0xFA, 0xCB, 0x98, 0xA9, 0x3E, 0x0F, 0x5C, 0x6D
-};
+static door_cap_t *cap_claim(door_key_t key) {
+    uint8_t h = (uint8_t)((key - 1u) & (DOOR_CAPS - 1u));
+    for (uint16_t n = 0; n < DOOR_CAPS; ++n) {
+        door_key_t free = 0;
+#if NK_MAX_TASKS * DOOR_SLOTS < 256
+        if (hal_atomic_compare_exchange_u8(&door_caps[h].key, &free, key)) {
+#else
+        if (hal_atomic_compare_exchange_u16(&door_caps[h].key, &free, key)) {
+#endif
+            return &door_caps[h];
+        }
+        h = (uint8_t)((h + 1u) & (DOOR_CAPS - 1u));
+    }
+    return NULL;
+}
 
-/**
- * @brief Compute CRC-8 (Dallas/Maxim)
- *
- * @param p Pointer to data
- * @param len Length in bytes
- * @return CRC-8 value
+/* Lend the caller's priority to the server for the call. */
+static void chan_donate(door_chan_t *ch, uint8_t target, uint8_t caller) {
+    ch->prio = nk_task_priority(target);
+    nk_task_boost(target, nk_task_priority(caller));
+}
+
+/* Present one lent message to the server. */
+static void chan_lend(door_chan_t *ch, void *buf, uint8_t words,
+                      uint8_t flags) {
+    ch->msg   = (uint8_t *)buf;
+    ch->words = words;
+    if (flags & DOOR_F_CRC) {
+        ch->crc = crc8_maxim(ch->msg, (uint8_t)(words * 8));
+    }
+}
+
+/*
+ * Run the server for a call whose channel is filled in.  On the
+ * caller's core that is a direct switch; otherwise the server's core
+ * is asked to run it and the caller sleeps until door_return() says
+ * the reply is in.
  */
-static uint8_t crc8_maxim(const uint8_t *p, uint8_t len) {
-    uint8_t crc = 0;
-    while (len--) {
-        uint8_t in = *p++ ^ crc;
-        crc = (crc << 5)
-            ^ crc8_lut[in >> 3]
-            ^ (in & 0x07);
+static void chan_enter(door_chan_t *ch, uint8_t target) {
+#if DOOR_XCORE
+    const uint8_t core = nk_task_cpu(target);
+    ch->remote = core != DOOR_THIS_CPU();
+    if (ch->remote) {
+        door_xq_t *q = &door_xq[core];
+        ch->replied = 0;
+        uint8_t i = hal_atomic_fetch_add_u8(&q->tail, 1u);
+        hal_memory_barrier();                   /* channel before slot */
+        q->slot[i & (NK_MAX_TASKS - 1u)] = (uint8_t)(target + 1u);
+        DOOR_IPI_SEND(core);
+
+        for (;;) {
+            uint32_t s = nk_sched_lock();
+            if (ch->replied) {
+                nk_sched_unlock(s);
+                break;
+            }
+            nk_waitq_block(&ch->reply_q);
+        }
+        return;
     }
-    return crc;
+#else
+    (void)ch;
+#endif
+    nk_switch_to(target);
 }
 
 /*═══════════════════════════════════════════════════════════════════
@@ -110,28 +262,39 @@ static uint8_t crc8_maxim(const uint8_t *p, uint8_t len) {
 /**
  * @brief Register a door descriptor
  *
- * Creates or updates a door descriptor in the calling task's vector.
+ * Creates or updates descriptor @p idx of the calling task.
  *
  * @param idx Door descriptor index (0 to DOOR_SLOTS-1)
  * @param target Target task ID (callee)
  * @param words Message length in 8-byte words (1-15)
- * @param flags Protocol flags (bit 0: enable CRC-8)
+ * @param flags Protocol flags (DOOR_F_CRC, DOOR_F_ZEROCOPY)
+ * @return 0, or -1 on a bad argument or a full capability table
  */
-void door_register(uint8_t idx, uint8_t target,
-                   uint8_t words, uint8_t flags) {
+int door_register(uint8_t idx, uint8_t target,
+                  uint8_t words, uint8_t flags) {
     /* Validate arguments */
     if (idx >= DOOR_SLOTS) {
-        return;  /* Invalid slot index */
+        return -1;  /* Invalid slot index */
     }
     if (words == 0 || (uint16_t)words * 8 > DOOR_SLAB_SIZE) {
-        return;  /* Invalid message size */
+        return -1;  /* Invalid message size */
     }
 
     /* Get current task ID */
     const uint8_t tid = nk_current_tid();
 
+    /* Find the task's entry, or claim the first free one on its probe */
+    door_t *d = (door_t *)door_lookup(tid, idx);
+    if (!d) {
+        door_cap_t *c = cap_claim((door_key_t)(idx * NK_MAX_TASKS + tid + 1u));
+        if (!c) {
+            return -1;  /* Table full */
+        }
+        d = &c->door;
+    }
+
     /* Install descriptor */
-    door_vec[tid][idx] = (door_t){
+    *d = (door_t){
         .tgt_tid = (uint8_t)(target & (NK_MAX_TASKS - 1)),
         .words   = (uint8_t)(words  & 0x0F),
         .flags   = (uint8_t)(flags  & 0x0F)
@@ -139,6 +302,7 @@ void door_register(uint8_t idx, uint8_t target,
 
     /* Memory barrier to ensure descriptor is visible */
     hal_memory_barrier();
+    return 0;
 }
 
 /*═══════════════════════════════════════════════════════════════════
@@ -148,11 +312,11 @@ void door_register(uint8_t idx, uint8_t target,
 /**
  * @brief Call a door (synchronous RPC)
  *
- * 1. Copies message from `buf` to shared slab
- * 2. Optionally appends CRC-8 (if flag bit 0 set)
+ * 1. Copies message from `buf` to the channel slab (or lends `buf`)
+ * 2. Optionally computes CRC-8 (DOOR_F_CRC)
  * 3. Context-switches to target task
  * 4. Blocks until target calls door_return()
- * 5. Copies reply from slab back to `buf`
+ * 5. Copies reply from slab back to `buf` (copy mode only)
  *
  * @param idx Door descriptor index
  * @param buf Pointer to message buffer (in/out)
@@ -161,64 +325,173 @@ void door_call(uint8_t idx, const void *buf) {
     /* Get current task ID */
     const uint8_t caller = nk_current_tid();
 
-    /* Validate slot index */
-    if (idx >= DOOR_SLOTS) {
-        return;
-    }
-
     /* Load descriptor */
-    const door_t d = door_vec[caller][idx];
-    if (d.words == 0) {
-        return;  /* Descriptor empty */
+    const door_t *dp = door_lookup(caller, idx);
+    if (!dp || dp->words == 0) {
+        return;  /* Bad index or descriptor empty */
     }
+    const door_t d = *dp;
+
+    /* Claim the target's channel; a busy server keeps its message */
+    door_chan_t *ch   = chan_claim(d.tgt_tid);
+    uint8_t     *slab = door_slab[CHAN(d.tgt_tid)];
 
     /* Calculate message size */
     const uint8_t nbytes = (uint8_t)(d.words * 8);
-    const void   *src    = buf;
-    uint8_t       len    = nbytes;
 
-    /* If CRC flag is set, copy message and append CRC */
-    if (d.flags & 0x01) {
-        memcpy(door_slab, buf, nbytes);
-        door_slab[nbytes] = crc8_maxim(door_slab, nbytes);
-        src = door_slab;
-        ++len;
-    } else {
-        /* No CRC - copy directly to slab */
-        memcpy(door_slab, src, len);
+    /* Lend the caller's buffer, or copy the request into the slab */
+    uint8_t *msg = (d.flags & DOOR_F_ZEROCOPY) ? (uint8_t *)buf : slab;
+    if (msg == slab) {
+        hal_memcpy_fast(slab, buf, nbytes);
+    }
+    if (d.flags & DOOR_F_CRC) {
+        ch->crc = crc8_maxim(msg, nbytes);
+        if (msg == slab && nbytes < DOOR_SLAB_SIZE) {
+            slab[nbytes] = ch->crc;    /* legacy trailer after the message */
+        }
     }
 
     /* Save call context */
-    door_caller  = caller;
-    door_words_v = d.words;
-    door_flags_v = d.flags;
+    ch->msg    = msg;
+    ch->caller = caller;
+    ch->words  = d.words;
+    ch->flags  = d.flags;
+    ch->left   = 0;
+    chan_donate(ch, d.tgt_tid, caller);
 
     /* Memory barrier before context switch */
     hal_memory_barrier();
 
-    /* Context switch to callee (blocks until door_return) */
-    nk_switch_to(d.tgt_tid);
+    /* Run the callee (blocks until door_return) */
+    nk_trace_door_call(caller, idx, d.tgt_tid);
+    chan_enter(ch, d.tgt_tid);
+
+    /* Callee has returned - copy reply back, then free the channel */
+    hal_memory_barrier();
+    if (msg == slab) {
+        hal_memcpy_fast((void *)buf, slab, nbytes);
+    }
+    hal_memory_barrier();
+    ch->busy = 0;
+}
+
+/**
+ * @brief Deliver a batch of messages in one context switch
+ *
+ * Every message is lent to the server in place (as for
+ * DOOR_F_ZEROCOPY); the server steps through them with door_next().
+ *
+ * @param idx Door descriptor index
+ * @param iov Messages; words == 0 means the descriptor's size
+ * @param n   Number of messages
+ * @return 0 once the server has returned, -1 if the descriptor is empty
+ *         or a message is larger than the door
+ */
+int door_callv(uint8_t idx, const door_iov_t *iov, uint8_t n) {
+    const uint8_t caller = nk_current_tid();
 
-    /* Callee has returned - copy reply back to caller's buffer */
+    const door_t *dp = door_lookup(caller, idx);
+    if (!dp || dp->words == 0) {
+        return -1;
+    }
+    const door_t d = *dp;
+    for (uint8_t i = 0; i < n; ++i) {
+        if (iov[i].words > d.words) {
+            return -1;
+        }
+    }
+    if (n == 0) {
+        return 0;
+    }
+
+    door_chan_t *ch = chan_claim(d.tgt_tid);
+    ch->caller = caller;
+    ch->flags  = d.flags;
+    ch->iov    = iov + 1;
+    ch->left   = (uint8_t)(n - 1);
+    ch->span   = d.words;
+    chan_lend(ch, iov[0].base, iov[0].words ? iov[0].words : d.words, d.flags);
+    chan_donate(ch, d.tgt_tid, caller);
+
+    hal_memory_barrier();
+    nk_trace_door_call(caller, idx, d.tgt_tid);
+    chan_enter(ch, d.tgt_tid);
     hal_memory_barrier();
-    memcpy((void *)buf, door_slab, nbytes);
+    ch->busy = 0;
+    return 0;
 }
 
 /**
  * @brief Return from a door call
  *
  * Must be called by the callee (target task) to resume the caller.
- * The caller's buffer is updated with the contents of door_slab.
+ * The caller's buffer is updated with the contents of the callee's
+ * channel slab.
  */
 void door_return(void) {
     /* Memory barrier before context switch */
     hal_memory_barrier();
 
+    /* Give back the donated priority; keep any boost held before the call */
+    const uint8_t self = nk_current_tid();
+    door_chan_t *ch = &door_chan[CHAN(self)];
+    nk_task_unboost(self);
+    nk_task_boost(self, ch->prio);
+
     /* Resume caller task */
-    uint8_t caller_tid = door_caller;
-    nk_switch_to(caller_tid);
+    nk_trace_door_return(self, ch->caller);
+#if DOOR_XCORE
+    if (ch->remote) {
+        /*
+         * Wake the caller and give this core back to the task the
+         * server took over from.  Interrupts stay off until we are off
+         * the CPU, so the next call's IPI cannot re-enter us before.
+         */
+        const uint8_t back = ch->resume;
+        uint32_t irq = hal_irq_save();
+        uint32_t s = nk_sched_lock();
+        ch->replied = 1;
+        nk_waitq_wake_one(&ch->reply_q);
+        nk_sched_unlock(s);
+        nk_switch_to(back);
+        hal_irq_restore(irq);
+        return;
+    }
+#endif
+    nk_switch_to(ch->caller);
+}
+
+#if DOOR_XCORE
+/**
+ * @brief Enter the servers other cores have queued calls for
+ *
+ * A slot reserved but not yet published ends the pass; its producer
+ * sends the IPI that brings us back.
+ */
+void door_ipi(void) {
+    door_xq_t *q = &door_xq[DOOR_THIS_CPU()];
+
+    for (;;) {
+        volatile uint8_t *slot = &q->slot[q->head & (NK_MAX_TASKS - 1u)];
+        const uint8_t t = *slot;
+        if (t == 0) {
+            return;
+        }
+        *slot = 0;
+        q->head++;
+        hal_memory_barrier();                   /* slot before channel */
+
+        const uint8_t server = (uint8_t)(t - 1u);
+        door_chan[CHAN(server)].resume = nk_current_tid();
+        nk_switch_to(server);
+    }
 }
 
+void nk_ipi_hook(void) {
+    door_ipi();
+}
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - CALLEE HELPERS
  *═══════════════════════════════════════════════════════════════════*/
@@ -226,10 +499,10 @@ void door_return(void) {
 /**
  * @brief Get pointer to incoming message
  *
- * @return Pointer to message in shared slab
+ * @return Pointer to the slab or the caller's lent buffer
  */
 const void *door_message(void) {
-    return door_slab;
+    return door_chan[CHAN(nk_current_tid())].msg;
 }
 
 /**
@@ -238,7 +511,7 @@ const void *door_message(void) {
  * @return Message length (1-15 words = 8-120 bytes)
  */
 uint8_t door_words(void) {
-    return door_words_v;
+    return door_chan[CHAN(nk_current_tid())].words;
 }
 
 /**
@@ -247,5 +520,33 @@ uint8_t door_words(void) {
  * @return 4-bit flags field from descriptor
  */
 uint8_t door_flags(void) {
-    return door_flags_v;
+    return door_chan[CHAN(nk_current_tid())].flags;
+}
+
+/**
+ * @brief Get the CRC-8 of the request (DOOR_F_CRC doors)
+ *
+ * @return CRC computed by door_call() over the request bytes
+ */
+uint8_t door_crc(void) {
+    return door_chan[CHAN(nk_current_tid())].crc;
+}
+
+/**
+ * @brief Advance to the next message of a batched call
+ *
+ * @return true if door_message()/door_words() now describe the next
+ *         message, false when the batch (or single call) is exhausted
+ */
+bool door_next(void) {
+    door_chan_t *ch = &door_chan[CHAN(nk_current_tid())];
+    if (ch->left == 0) {
+        return false;
+    }
+
+    const door_iov_t *v = ch->iov;
+    chan_lend(ch, v->base, v->words ? v->words : ch->span, ch->flags);
+    ch->iov = v + 1;
+    ch->left--;
+    return true;
 }
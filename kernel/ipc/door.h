@@ -13,10 +13,14 @@
  * via HAL abstraction.
  *
  * ## Features
- * - Synchronous call/return semantics
- * - Zero-copy via shared slab buffer
- * - Per-task descriptor vectors (configurable slots)
+ * - Synchronous call/return semantics with priority donation
+ * - Per-target (or shared) slab buffers, or true zero-copy where the
+ *   caller lends its own buffer to the server (DOOR_F_ZEROCOPY)
+ * - Per-task descriptor indices (configurable slots), kept in a table
+ *   sized by the doors that exist
  * - Optional CRC-8 validation (Dallas/Maxim polynomial)
+ * - Calls to a server on another core go through that core's call
+ *   queue (DOOR_XCORE)
  * - Persistent state across reboots (via .noinit section)
  *
  * ## Usage
@@ -25,9 +29,11 @@
  * void server_task(void) {
  *     while (1) {
  *         // Wait for door call...
- *         const void *msg = door_message();
- *         uint8_t len = door_words() * 8;
- *         // Process request, write reply to door_slab
+ *         do {
+ *             const void *msg = door_message();
+ *             uint8_t len = door_words() * 8;
+ *             // Process request, write reply in place at msg
+ *         } while (door_next());  // Further messages of a door_callv()
  *         door_return();  // Return to caller
  *     }
  * }
@@ -69,17 +75,110 @@ extern "C" {
 #endif
 
 /**
- * @brief Shared slab buffer size in bytes
+ * @brief Slab buffer size in bytes (per channel)
  *
- * All door messages use this single shared buffer. Must be a multiple
- * of 8 for alignment.
+ * Must be a multiple of 8 for alignment.
  */
 #ifndef DOOR_SLAB_SIZE
 #  define DOOR_SLAB_SIZE 128
 #endif
 
+/**
+ * @brief Give every target task its own slab and call record
+ *
+ * With 1, calls to different servers never contend and a server can
+ * call onward while serving.  With 0, all doors share one channel
+ * (one slab of RAM) and calls serialise.  Follows ipc_door_per_target.
+ */
+#ifndef DOOR_PER_TARGET
+#  if defined(CONFIG_IPC_DOOR_PER_TARGET)
+#    define DOOR_PER_TARGET CONFIG_IPC_DOOR_PER_TARGET
+#  else
+#    define DOOR_PER_TARGET 0
+#  endif
+#endif
+
+#if DOOR_PER_TARGET
+#  define DOOR_CHANNELS NK_MAX_TASKS
+#else
+#  define DOOR_CHANNELS 1
+#endif
+
+/**
+ * @brief Queued messages per server for one-way and async doors
+ *
+ * 0 leaves door_send() and door_call_async() out of the build.  Must
+ * be a power of two.  Follows ipc_door_mbox_depth.
+ */
+#ifndef DOOR_MBOX_DEPTH
+#  if defined(CONFIG_IPC_DOOR_MBOX_DEPTH)
+#    define DOOR_MBOX_DEPTH CONFIG_IPC_DOOR_MBOX_DEPTH
+#  else
+#    define DOOR_MBOX_DEPTH 0
+#  endif
+#endif
+
+/**
+ * @brief Largest queued message in bytes (multiple of 8)
+ *
+ * Mailbox RAM is NK_MAX_TASKS * DOOR_MBOX_DEPTH * (DOOR_MBOX_MSG + 4
+ * + sizeof(void *)) bytes.
+ */
+#ifndef DOOR_MBOX_MSG
+#  define DOOR_MBOX_MSG 16
+#endif
+
+/**
+ * @brief Entries in the door capability table (power of two, <= 256)
+ *
+ * Descriptors are kept in one open-addressed table keyed by (task,
+ * index) rather than a dense NK_MAX_TASKS x DOOR_SLOTS matrix, so RAM
+ * follows the doors actually registered: 3 bytes per entry (4 when
+ * NK_MAX_TASKS * DOOR_SLOTS exceeds 255).  The default is two doors
+ * per task; door_register() fails once the table is full.  Follows
+ * ipc_door_caps.
+ */
+#ifndef DOOR_CAPS
+#  if defined(CONFIG_IPC_DOOR_CAPS) && CONFIG_IPC_DOOR_CAPS > 0
+#    define DOOR_CAPS CONFIG_IPC_DOOR_CAPS
+#  else
+#    define DOOR_CAPS (2 * NK_MAX_TASKS)
+#  endif
+#endif
+
+/**
+ * @brief Deliver calls across cores
+ *
+ * A server homed on another core (nk_task_cpu()) cannot simply be
+ * switched to.  With 1, such a call is queued in that core's lock-free
+ * call queue (a per-core mailbox of server IDs, separate from the
+ * DOOR_MBOX_DEPTH message rings), the core is sent an IPI and enters
+ * the server from door_ipi(), and the caller sleeps until
+ * door_return() wakes it.
+ * Calls to a server on the caller's own core keep the direct switch.
+ * Follows kernel_smp_cores > 1.
+ */
+#ifndef DOOR_XCORE
+#  if defined(CONFIG_KERNEL_SMP_CORES) && CONFIG_KERNEL_SMP_CORES > 1
+#    define DOOR_XCORE 1
+#  else
+#    define DOOR_XCORE 0
+#  endif
+#endif
+
+/** @brief Async calls that may be outstanding system-wide */
+#ifndef DOOR_TICKETS
+#  define DOOR_TICKETS 8
+#endif
+
 /* Compile-time validation */
+_Static_assert((DOOR_MBOX_DEPTH & (DOOR_MBOX_DEPTH - 1)) == 0,
+               "door mailbox depth must be a power of two");
+_Static_assert(DOOR_MBOX_MSG % 8 == 0 && DOOR_MBOX_MSG <= 120,
+               "queued door messages are 1-15 words");
 _Static_assert(DOOR_SLOTS <= 15, "door slots must fit in 4-bit field");
+_Static_assert(DOOR_CAPS > 0 && DOOR_CAPS <= 256 && (DOOR_CAPS & (DOOR_CAPS - 1)) == 0,
+               "door capability table size must be a power of two up to 256");
 _Static_assert(DOOR_SLAB_SIZE % 8 == 0, "slab must be 8-byte aligned");
 
 /*═══════════════════════════════════════════════════════════════════
@@ -89,13 +188,14 @@ _Static_assert(DOOR_SLAB_SIZE % 8 == 0, "slab must be 8-byte aligned");
 /**
  * @brief Door descriptor (2 bytes)
  *
- * Stored in each task's descriptor vector. Defines a door endpoint.
+ * Stored in the capability table under its task and index. Defines a
+ * door endpoint.
  *
  * | Field   | Bits | Purpose                              |
  * |---------|------|--------------------------------------|
  * | tgt_tid |  8   | Target task ID (callee)              |
  * | words   |  4   | Message length in 8-byte words (1-15)|
- * | flags   |  4   | Protocol flags (bit 0 = CRC-8)       |
+ * | flags   |  4   | Protocol flags (DOOR_F_*)            |
  */
 typedef struct {
     uint8_t tgt_tid;        /**< Target task ID */
@@ -105,25 +205,88 @@ typedef struct {
 
 _Static_assert(sizeof(door_t) == 2, "door_t must be 2 bytes");
 
+/** Checksum the request with CRC-8; the server reads it via door_crc(). */
+#define DOOR_F_CRC      0x01u
+
+/**
+ * Lend the caller's buffer to the server instead of copying through the
+ * slab.  door_message() then points at the caller's `buf` until
+ * door_return(), so the buffer must stay valid and untouched by anyone
+ * else for the whole call (it does on AVR: the caller is blocked and
+ * all tasks share one address space).
+ */
+#define DOOR_F_ZEROCOPY 0x02u
+
+/**
+ * @brief One message of a batched door_callv()
+ */
+typedef struct {
+    void   *base;   /**< Message buffer, replied to in place */
+    uint8_t words;  /**< Size in 8-byte words; 0 = the door's size */
+} door_iov_t;
+
 /*═══════════════════════════════════════════════════════════════════
  * GLOBAL STATE
  *═══════════════════════════════════════════════════════════════════*/
 
 /**
- * @brief Shared message buffer
+ * @brief Message buffers, one per channel
  *
- * All door calls copy messages into this buffer. Lives in .noinit
- * section for persistence across warm reboots.
+ * door_slab[t] carries calls to task t (or everything, in slab 0,
+ * without DOOR_PER_TARGET).  Lives in .noinit section for persistence
+ * across warm reboots.
  */
-extern uint8_t door_slab[DOOR_SLAB_SIZE];
+extern uint8_t door_slab[DOOR_CHANNELS][DOOR_SLAB_SIZE];
+
+/** Capability key: idx * NK_MAX_TASKS + tid + 1, 0 for a free entry */
+#if NK_MAX_TASKS * DOOR_SLOTS < 256
+typedef uint8_t door_key_t;
+#else
+typedef uint16_t door_key_t;
+#endif
 
 /**
- * @brief Per-task door descriptor vectors
+ * @brief One registered door: whose descriptor it is, and the descriptor
+ */
+typedef struct {
+    volatile door_key_t key;
+    door_t              door;
+} door_cap_t;
+
+/**
+ * @brief Door capability table
  *
- * door_vec[tid][idx] holds the door descriptor for task `tid`,
- * descriptor index `idx`.
+ * Linear probing from slot (key - 1) % DOOR_CAPS.  Keys put index 0 of
+ * every task in consecutive slots, then index 1, and so on: with the
+ * default size, tasks that only use indices 0 and 1 never collide, and
+ * a table of NK_MAX_TASKS * DOOR_SLOTS entries never probes at all.
+ * Entries are never removed, so the first free slot ends a probe.
  */
-extern door_t door_vec[NK_MAX_TASKS][DOOR_SLOTS];
+extern door_cap_t door_caps[DOOR_CAPS];
+
+/**
+ * @brief Descriptor @p idx of task @p tid
+ *
+ * @return The descriptor, or NULL if the task never registered @p idx
+ */
+static inline const door_t *door_lookup(uint8_t tid, uint8_t idx) {
+    if (idx >= DOOR_SLOTS) {
+        return NULL;
+    }
+    const door_key_t key = (door_key_t)(idx * NK_MAX_TASKS + tid + 1u);
+    uint8_t h = (uint8_t)((key - 1u) & (DOOR_CAPS - 1u));
+    for (uint16_t n = 0; n < DOOR_CAPS; ++n) {
+        const door_key_t k = door_caps[h].key;
+        if (k == key) {
+            return &door_caps[h].door;
+        }
+        if (k == 0) {
+            break;
+        }
+        h = (uint8_t)((h + 1u) & (DOOR_CAPS - 1u));
+    }
+    return NULL;
+}
 
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - DOOR MANAGEMENT
@@ -132,18 +295,19 @@ extern door_t door_vec[NK_MAX_TASKS][DOOR_SLOTS];
 /**
  * @brief Register a door descriptor
  *
- * Creates or updates a door descriptor in the calling task's vector.
+ * Creates or updates descriptor @p idx of the calling task.
  *
  * @param idx Door descriptor index (0 to DOOR_SLOTS-1)
  * @param target Target task ID (callee)
  * @param words Message length in 8-byte words (1-15)
- * @param flags Protocol flags (bit 0: enable CRC-8)
+ * @param flags Protocol flags (DOOR_F_CRC, DOOR_F_ZEROCOPY)
+ * @return 0, or -1 if idx >= DOOR_SLOTS, words is 0 or larger than
+ *         the slab, or the capability table is full
  *
- * @note If idx >= DOOR_SLOTS or words == 0, the call is ignored.
  * @note Maximum message size is min(words*8, DOOR_SLAB_SIZE).
  */
-void door_register(uint8_t idx, uint8_t target,
-                   uint8_t words, uint8_t flags);
+int door_register(uint8_t idx, uint8_t target,
+                  uint8_t words, uint8_t flags);
 
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - DOOR COMMUNICATION
@@ -152,11 +316,15 @@ void door_register(uint8_t idx, uint8_t target,
 /**
  * @brief Call a door (synchronous RPC)
  *
- * 1. Copies message from `buf` to shared slab
- * 2. Optionally appends CRC-8 (if flag bit 0 set)
- * 3. Context-switches to target task
- * 4. Blocks until target calls door_return()
- * 5. Copies reply from slab back to `buf`
+ * 1. Claims the target's channel (yields while another call holds it)
+ * 2. Copies message from `buf` to the channel slab, or with
+ *    DOOR_F_ZEROCOPY lends `buf` itself to the server
+ * 3. Optionally computes CRC-8 over the request (DOOR_F_CRC)
+ * 4. Lends the caller's priority to the target and switches to it,
+ *    or queues the call on the target's core (DOOR_XCORE)
+ * 5. Blocks until target calls door_return()
+ * 6. Copies reply from slab back to `buf` (copy mode only) and releases
+ *    the channel
  *
  * @param idx Door descriptor index
  * @param buf Pointer to message buffer (in/out)
@@ -170,17 +338,44 @@ void door_register(uint8_t idx, uint8_t target,
  */
 void door_call(uint8_t idx, const void *buf);
 
+/**
+ * @brief Deliver several messages to a server in one context switch
+ *
+ * Each message is lent to the server in place, as with
+ * DOOR_F_ZEROCOPY, and must be no larger than the door.  Blocks until
+ * the server has processed the whole batch and called door_return().
+ *
+ * @param idx Door descriptor index
+ * @param iov Messages to deliver, in order
+ * @param n   Number of messages (0 returns at once)
+ * @return 0 on success, -1 if the descriptor is empty or a message is
+ *         too large
+ */
+int door_callv(uint8_t idx, const door_iov_t *iov, uint8_t n);
+
 /**
  * @brief Return from a door call
  *
  * Must be called by the callee (target task) to resume the caller.
- * The caller's buffer is updated with the contents of door_slab.
+ * The caller's buffer is updated with the contents of the callee's
+ * channel slab, and the callee drops the priority donated for the call.
  *
  * @note Must be called from the task that received the door call.
  * @note After return, caller resumes execution after door_call().
  */
 void door_return(void);
 
+#if DOOR_XCORE
+/**
+ * @brief Enter the servers other cores have queued calls for
+ *
+ * Runs on the core receiving the IPI, by default from nk_ipi_hook().
+ * Each queued server takes over from the interrupted task, which
+ * resumes once the server calls door_return().
+ */
+void door_ipi(void);
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API - CALLEE HELPERS
  *═══════════════════════════════════════════════════════════════════*/
@@ -190,10 +385,24 @@ void door_return(void);
  *
  * Valid only between door call entry and door_return().
  *
- * @return Pointer to message in shared slab
+ * The server writes its reply in place (cast away const).
+ *
+ * @return Pointer to the message: the channel slab, or the caller's own
+ *         buffer for DOOR_F_ZEROCOPY doors
  */
 const void *door_message(void);
 
+/**
+ * @brief Step to the next message of a batched call
+ *
+ * Servers that loop `do { ... } while (door_next());` before
+ * door_return() handle single and batched calls alike.
+ *
+ * @return true if door_message(), door_words() and door_crc() now
+ *         describe the next message; false once the batch is exhausted
+ */
+bool door_next(void);
+
 /**
  * @brief Get message length in 8-byte words
  *
@@ -212,6 +421,107 @@ uint8_t door_words(void);
  */
 uint8_t door_flags(void);
 
+/**
+ * @brief Get the CRC-8 the caller computed over the request
+ *
+ * Valid only between door call entry and door_return(), and only
+ * meaningful when door_flags() has DOOR_F_CRC.  Compare with a CRC of
+ * door_message() to detect corruption.
+ *
+ * @return CRC-8 (Dallas/Maxim) of the door_words() * 8 request bytes
+ */
+uint8_t door_crc(void);
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - ONE-WAY AND ASYNC DOORS (DOOR_MBOX_DEPTH > 0)
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Queued message as seen by the server
+ */
+typedef struct {
+    uint8_t caller;   /**< Sending task ID */
+    uint8_t words;    /**< Message length in 8-byte words */
+    uint8_t flags;    /**< Descriptor flags */
+    int8_t  ticket;   /**< Ticket to pass to door_complete(), -1 if one-way */
+} door_info_t;
+
+/**
+ * @brief Send a one-way message through a door
+ *
+ * Copies the door_words() * 8 bytes at `buf` into the target's mailbox
+ * and returns at once; no reply is delivered.  The door's message size
+ * must not exceed DOOR_MBOX_MSG.
+ *
+ * @return 0 on success, -1 if the mailbox is full or the door is
+ *         empty or too large to queue
+ */
+int door_send(uint8_t idx, const void *buf);
+
+/**
+ * @brief Queue a request and return a ticket for its reply
+ *
+ * Like door_send(), but the server's door_complete() later copies the
+ * reply into `buf`, which must stay valid until door_poll() or
+ * door_wait() reports completion.  Several requests may be pipelined
+ * to one server this way without a context switch per call.
+ *
+ * @return Ticket (0..DOOR_TICKETS-1), or -1 if no ticket or mailbox
+ *         slot is free
+ */
+int door_call_async(uint8_t idx, void *buf);
+
+struct nk_future;
+
+/**
+ * @brief Queue a request whose reply completes a future
+ *
+ * Like door_call_async(), but no ticket is handed out: door_complete()
+ * copies the reply into `buf`, releases the ticket itself and completes
+ * @p f with the reply length, so the call can be awaited together with
+ * other I/O through nk_await_any().  @p f is armed here.
+ *
+ * @return 0 if queued, -1 if no ticket or mailbox slot is free (@p f
+ *         is then left idle)
+ */
+int door_call_future(uint8_t idx, void *buf, struct nk_future *f);
+
+/**
+ * @brief Check an async call for completion
+ *
+ * @return true once the reply is in the caller's buffer; the ticket is
+ *         released and must not be used again
+ */
+bool door_poll(int ticket);
+
+/**
+ * @brief Yield until an async call has completed
+ *
+ * @return 0 when the reply has arrived, -1 for an invalid ticket
+ */
+int door_wait(int ticket);
+
+/**
+ * @brief Take the oldest queued message for the calling task
+ *
+ * @param buf  Receives the message (at least DOOR_MBOX_MSG bytes)
+ * @param info Receives sender, size, flags and ticket (may be NULL)
+ * @return Message length in bytes, or -1 if the mailbox is empty
+ */
+int door_recv(void *buf, door_info_t *info);
+
+/**
+ * @brief Deliver the reply for a message taken with door_recv()
+ *
+ * Copies `words * 8` bytes from `reply` into the caller's buffer and
+ * marks the ticket complete.  Does nothing for one-way messages
+ * (ticket -1).
+ */
+void door_complete(int8_t ticket, const void *reply);
+
+/** Messages waiting in the calling task's mailbox. */
+uint8_t door_pending(void);
+
 #ifdef __cplusplus
 }
 #endif
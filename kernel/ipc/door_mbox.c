@@ -0,0 +1,246 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file door_mbox.c
+ * @brief One-way and asynchronous doors (per-server mailboxes)
+ *
+ * door_call() costs two context switches per request.  For telemetry
+ * and other fire-and-forget traffic a client can instead door_send()
+ * into the server's bounded mailbox and carry on; door_call_async()
+ * does the same but hands back a ticket that the server completes
+ * with its reply.
+ *
+ * ## Mailboxes
+ * Each task owns a ring of DOOR_MBOX_DEPTH fixed-size entries holding
+ * the copied request, its sender and (for async calls) a ticket.
+ * Producers and the consuming server update the ring under a short
+ * IRQ-off section, plus a spinlock with kernel_smp_cores > 1.
+ *
+ * ## Tickets
+ * Outstanding async calls live in an ISR-safe pool of DOOR_TICKETS
+ * records (caller buffer, size, done flag).  door_complete() copies the
+ * reply straight into the caller's buffer and sets the flag;
+ * door_poll()/door_wait() release the ticket once they see it.
+ */
+
+#include "door.h"
+#include "arch/common/hal.h"
+#include "nk_pool.h"
+#include "kernel/sync/nk_event.h"
+#include "kernel/sync/nk_future.h"
+#include <string.h>
+
+#if DOOR_MBOX_DEPTH > 0
+
+#ifndef CONFIG_KERNEL_SMP_CORES
+#  define CONFIG_KERNEL_SMP_CORES 1
+#endif
+
+#if CONFIG_KERNEL_SMP_CORES > 1
+#  include "kernel/sync/spinlock.h"
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * STATE
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef struct {
+    door_info_t info;                /**< Sender, size, flags, ticket */
+    uint8_t     data[DOOR_MBOX_MSG]; /**< Copied request */
+} door_mail_t;
+
+typedef struct {
+    door_mail_t mail[DOOR_MBOX_DEPTH];
+    uint8_t     head;                /**< Next entry to read (free-running) */
+    uint8_t     tail;                /**< Next entry to write (free-running) */
+} door_mbox_t;
+
+typedef struct {
+    uint8_t *volatile reply;         /**< Caller's buffer */
+    nk_future_t      *fut;           /**< Completed instead of `done`, or NULL */
+    uint8_t           nbytes;        /**< Reply length */
+    volatile uint8_t  done;          /**< Set by door_complete() */
+} door_ticket_t;
+
+_Static_assert(DOOR_MBOX_DEPTH <= 128, "ring indices are 8-bit");
+_Static_assert(DOOR_TICKETS <= 127, "tickets are int8_t");
+
+static door_mbox_t door_mbox[NK_MAX_TASKS];
+NK_POOL_DEFINE_ISR(door_tickets, door_ticket_t, DOOR_TICKETS);
+
+#if CONFIG_KERNEL_SMP_CORES > 1
+static nk_spinlock_t door_mbox_spin = NK_SPINLOCK_DOMAIN_INIT("door_mbox", NK_LOCK_DOM_IPC);
+#endif
+
+static inline uint32_t mbox_lock(void) {
+    uint32_t s = hal_irq_save();
+#if CONFIG_KERNEL_SMP_CORES > 1
+    nk_spinlock_lock_rt(&door_mbox_spin, 0);
+#endif
+    return s;
+}
+
+static inline void mbox_unlock(uint32_t s) {
+#if CONFIG_KERNEL_SMP_CORES > 1
+    nk_spinlock_unlock_rt(&door_mbox_spin);
+#endif
+    hal_irq_restore(s);
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * INTERNAL HELPERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Copy one message into the target's ring; false if it is full. */
+static bool mbox_put(const door_t *d, uint8_t caller,
+                     const void *buf, int8_t ticket) {
+    door_mbox_t *mb = &door_mbox[d->tgt_tid];
+    bool ok = false;
+
+    uint32_t s = mbox_lock();
+    if ((uint8_t)(mb->tail - mb->head) < DOOR_MBOX_DEPTH) {
+        door_mail_t *m = &mb->mail[mb->tail & (DOOR_MBOX_DEPTH - 1)];
+        m->info = (door_info_t){ caller, d->words, d->flags, ticket };
+        hal_memcpy_fast(m->data, buf, (size_t)d->words * 8u);
+        mb->tail++;
+        ok = true;
+    }
+    mbox_unlock(s);
+    return ok;
+}
+
+/* Validated descriptor for a queued door, or NULL. */
+static const door_t *mbox_door(uint8_t caller, uint8_t idx) {
+    const door_t *d = door_lookup(caller, idx);
+    if (!d || d->words == 0 || (uint16_t)d->words * 8u > DOOR_MBOX_MSG) {
+        return NULL;
+    }
+    return d;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - CLIENT SIDE
+ *═══════════════════════════════════════════════════════════════════*/
+
+int door_send(uint8_t idx, const void *buf) {
+    const uint8_t caller = nk_current_tid();
+    const door_t *d = mbox_door(caller, idx);
+    if (!d || !mbox_put(d, caller, buf, -1)) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Take a ticket and queue the request; returns the ticket or -1. */
+static int mbox_call(uint8_t idx, void *buf, nk_future_t *f) {
+    const uint8_t caller = nk_current_tid();
+    const door_t *d = mbox_door(caller, idx);
+    if (!d) {
+        return -1;
+    }
+
+    door_ticket_t *t = NK_POOL_ALLOC(door_tickets);
+    if (!t) {
+        return -1;
+    }
+    t->reply  = (uint8_t *)buf;
+    t->fut    = f;
+    t->nbytes = (uint8_t)(d->words * 8u);
+    t->done   = 0;
+    if (f) {
+        nk_future_arm(f);            /* before the server can see it */
+    }
+
+    int8_t ticket = (int8_t)nk_pool_index(&door_tickets, t);
+    if (!mbox_put(d, caller, buf, ticket)) {
+        nk_pool_free(&door_tickets, t);
+        if (f) {
+            f->state = NK_FUT_IDLE;
+        }
+        return -1;
+    }
+    return ticket;
+}
+
+int door_call_async(uint8_t idx, void *buf) {
+    return mbox_call(idx, buf, NULL);
+}
+
+int door_call_future(uint8_t idx, void *buf, struct nk_future *f) {
+    if (!f) {
+        return -1;
+    }
+    return mbox_call(idx, buf, f) < 0 ? -1 : 0;
+}
+
+bool door_poll(int ticket) {
+    door_ticket_t *t = nk_pool_at(&door_tickets, ticket);
+    if (!t || !t->done) {
+        return false;
+    }
+    hal_memory_barrier();
+    nk_pool_free(&door_tickets, t);
+    return true;
+}
+
+int door_wait(int ticket) {
+    if (!nk_pool_at(&door_tickets, ticket)) {
+        return -1;
+    }
+    while (!door_poll(ticket)) {
+        nk_yield();
+    }
+    return 0;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API - SERVER SIDE
+ *═══════════════════════════════════════════════════════════════════*/
+
+int door_recv(void *buf, door_info_t *info) {
+    door_mbox_t *mb = &door_mbox[nk_current_tid()];
+    int n = -1;
+
+    uint32_t s = mbox_lock();
+    if (mb->head != mb->tail) {
+        door_mail_t *m = &mb->mail[mb->head & (DOOR_MBOX_DEPTH - 1)];
+        n = m->info.words * 8;
+        hal_memcpy_fast(buf, m->data, (size_t)n);
+        if (info) {
+            *info = m->info;
+        }
+        mb->head++;
+    }
+    mbox_unlock(s);
+    return n;
+}
+
+void door_complete(int8_t ticket, const void *reply) {
+    door_ticket_t *t = nk_pool_at(&door_tickets, ticket);
+    if (!t || t->done) {
+        return;
+    }
+    hal_memcpy_fast(t->reply, reply, t->nbytes);
+    hal_memory_barrier();
+    nk_future_t *f = t->fut;
+    if (f) {
+        int16_t n = t->nbytes;
+        nk_pool_free(&door_tickets, t);  /* nobody polls this ticket */
+        nk_future_complete(f, n);
+        return;
+    }
+    t->done = 1;
+    nk_io_notify(NK_IO_DOOR);        /* wakes PT_AWAIT_DOOR() */
+}
+
+uint8_t door_pending(void) {
+    door_mbox_t *mb = &door_mbox[nk_current_tid()];
+    uint32_t s = mbox_lock();
+    uint8_t n = (uint8_t)(mb->tail - mb->head);
+    mbox_unlock(s);
+    return n;
+}
+
+#endif /* DOOR_MBOX_DEPTH > 0 */
@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_chan.c
+ * @brief SPSC streaming channels (see nk_chan.h)
+ */
+
+#include "nk_chan.h"
+#include <string.h>
+
+bool nk_chan_init(nk_chan_t *c, void *buf, uint16_t size) {
+    if (!buf || size < 2 || size > 32768u || (size & (size - 1u))) {
+        return false;
+    }
+    c->buf = (uint8_t *)buf;
+    c->mask = (uint16_t)(size - 1u);
+    c->head = 0;
+    c->tail = 0;
+    return true;
+}
+
+uint16_t nk_chan_write(nk_chan_t *c, const void *src, uint16_t len) {
+    const uint8_t *s = (const uint8_t *)src;
+    uint16_t done = 0;
+
+    /* At most two passes: up to the end of the ring, then from its start */
+    for (uint8_t pass = 0; pass < 2 && done < len; ++pass) {
+        uint8_t *dst;
+        uint16_t n = nk_chan_reserve(c, &dst);
+        if (n == 0) {
+            break;
+        }
+        if (n > len - done) {
+            n = (uint16_t)(len - done);
+        }
+        memcpy(dst, s + done, n);
+        nk_chan_commit(c, n);
+        done = (uint16_t)(done + n);
+    }
+    return done;
+}
+
+uint16_t nk_chan_read(nk_chan_t *c, void *dst, uint16_t len) {
+    uint8_t *d = (uint8_t *)dst;
+    uint16_t done = 0;
+
+    for (uint8_t pass = 0; pass < 2 && done < len; ++pass) {
+        const uint8_t *src;
+        uint16_t n = nk_chan_peek(c, &src);
+        if (n == 0) {
+            break;
+        }
+        if (n > len - done) {
+            n = (uint16_t)(len - done);
+        }
+        memcpy(d + done, src, n);
+        nk_chan_consume(c, n);
+        done = (uint16_t)(done + n);
+    }
+    return done;
+}
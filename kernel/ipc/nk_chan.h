@@ -0,0 +1,191 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_chan.h
+ * @brief Lock-free single-producer/single-consumer streaming channels
+ *
+ * A channel is a small header over a power-of-two byte ring.  The
+ * producer fills the ring in place and the consumer processes it in
+ * place: nothing is copied through an intermediate buffer, and neither
+ * side takes a lock or masks interrupts (except for 16-bit index
+ * accesses on 8-bit CPUs).  Exactly one context may produce and one
+ * consume; either may be an ISR.
+ *
+ * ```c
+ * NK_CHAN_DEFINE(adc_chan, 256);
+ *
+ * // Producer (e.g. ADC ISR): write a block straight into the ring
+ * uint8_t *dst;
+ * if (nk_chan_reserve(&adc_chan, &dst) >= BLOCK) {
+ *     adc_copy_samples(dst, BLOCK);
+ *     nk_chan_commit(&adc_chan, BLOCK);
+ * }
+ *
+ * // Consumer (DSP task): work on the samples where they are
+ * const uint8_t *src;
+ * uint16_t n = nk_chan_peek(&adc_chan, &src);
+ * dsp_process(src, n);
+ * nk_chan_consume(&adc_chan, n);
+ * ```
+ *
+ * reserve() and peek() return the *contiguous* span at the current
+ * position, which stops at the end of the ring; call again after
+ * commit()/consume() for the part that wrapped.  Records whose size
+ * divides the ring size never straddle the end.
+ *
+ * Ordering: data is written before hal_memory_barrier() and the index
+ * store that publishes it (release), and read only after the index
+ * load and a barrier (acquire).
+ */
+
+#ifndef KERNEL_IPC_NK_CHAN_H
+#define KERNEL_IPC_NK_CHAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "arch/common/hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * CHANNEL OBJECT
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef struct {
+    uint8_t           *buf;   /**< Ring storage */
+    uint16_t           mask;  /**< size - 1 */
+    volatile uint16_t  head;  /**< Produced bytes (free-running, producer) */
+    volatile uint16_t  tail;  /**< Consumed bytes (free-running, consumer) */
+} nk_chan_t;
+
+/** Define a channel with static storage of @p size bytes (power of two). */
+#define NK_CHAN_DEFINE(name, size)                                        \
+    _Static_assert((size) >= 2 && (size) <= 32768 &&                      \
+                   ((size) & ((size) - 1)) == 0,                          \
+                   "channel size must be a power of two <= 32768");       \
+    static uint8_t name##_buf[size];                                      \
+    static nk_chan_t name = { name##_buf, (size) - 1, 0, 0 }
+
+/**
+ * @brief Set up a channel over a caller-provided buffer
+ * @return false unless @p size is a power of two in 2..32768
+ */
+bool nk_chan_init(nk_chan_t *c, void *buf, uint16_t size);
+
+/*═══════════════════════════════════════════════════════════════════
+ * INDEX ACCESS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* The other side's index may change mid-load on 8-bit CPUs. */
+static inline uint16_t nk_chan_load_(const volatile uint16_t *p) {
+#if HAL_WORD_SIZE == 8
+    uint32_t s = hal_irq_save();
+    uint16_t v = *p;
+    hal_irq_restore(s);
+    return v;
+#else
+    return *p;
+#endif
+}
+
+static inline void nk_chan_store_(volatile uint16_t *p, uint16_t v) {
+    hal_memory_barrier();
+#if HAL_WORD_SIZE == 8
+    uint32_t s = hal_irq_save();
+    *p = v;
+    hal_irq_restore(s);
+#else
+    *p = v;
+#endif
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PRODUCER SIDE
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Contiguous free space at the write position
+ *
+ * @param c   Channel
+ * @param out Receives the write pointer
+ * @return Bytes that may be written at *out (0 if the ring is full)
+ */
+static inline uint16_t nk_chan_reserve(nk_chan_t *c, uint8_t **out) {
+    uint16_t head = c->head;
+    uint16_t free = (uint16_t)(c->mask + 1u - (uint16_t)(head - nk_chan_load_(&c->tail)));
+    uint16_t at = head & c->mask;
+    uint16_t run = (uint16_t)(c->mask + 1u - at);
+    *out = c->buf + at;
+    return free < run ? free : run;
+}
+
+/**
+ * @brief Publish @p n bytes written after nk_chan_reserve()
+ */
+static inline void nk_chan_commit(nk_chan_t *c, uint16_t n) {
+    nk_chan_store_(&c->head, (uint16_t)(c->head + n));
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONSUMER SIDE
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Contiguous readable data at the read position
+ *
+ * @param c   Channel
+ * @param out Receives the read pointer
+ * @return Bytes readable at *out (0 if the ring is empty)
+ */
+static inline uint16_t nk_chan_peek(nk_chan_t *c, const uint8_t **out) {
+    uint16_t tail = c->tail;
+    uint16_t used = (uint16_t)(nk_chan_load_(&c->head) - tail);
+    hal_memory_barrier();
+    uint16_t at = tail & c->mask;
+    uint16_t run = (uint16_t)(c->mask + 1u - at);
+    *out = c->buf + at;
+    return used < run ? used : run;
+}
+
+/**
+ * @brief Release @p n bytes processed after nk_chan_peek()
+ */
+static inline void nk_chan_consume(nk_chan_t *c, uint16_t n) {
+    nk_chan_store_(&c->tail, (uint16_t)(c->tail + n));
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * STATUS AND COPYING HELPERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Bytes waiting (a snapshot; exact from the consumer's side). */
+static inline uint16_t nk_chan_count(const nk_chan_t *c) {
+    return (uint16_t)(nk_chan_load_(&c->head) - nk_chan_load_(&c->tail));
+}
+
+/** Bytes free (a snapshot; exact from the producer's side). */
+static inline uint16_t nk_chan_space(const nk_chan_t *c) {
+    return (uint16_t)(c->mask + 1u - nk_chan_count(c));
+}
+
+/**
+ * @brief Copy up to @p len bytes in (producer only)
+ * @return Bytes written, in at most two segments
+ */
+uint16_t nk_chan_write(nk_chan_t *c, const void *src, uint16_t len);
+
+/**
+ * @brief Copy up to @p len bytes out (consumer only)
+ * @return Bytes read, in at most two segments
+ */
+uint16_t nk_chan_read(nk_chan_t *c, void *dst, uint16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_IPC_NK_CHAN_H */
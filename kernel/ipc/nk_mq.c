@@ -0,0 +1,203 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_mq.c
+ * @brief Fixed-capacity kernel message queues (see nk_mq.h)
+ *
+ * ## Ring
+ * Bounded MPMC ring after D. Vyukov: slot i starts with sequence i.  A
+ * sender at position p owns the slot when seq == p, claims it by
+ * advancing tail with compare-and-swap, copies the message and
+ * publishes seq = p + 1.  A receiver at p owns it when seq == p + 1
+ * and hands it back as seq = p + depth.  With one sender and one
+ * receiver the CAS never fails.
+ *
+ * Slot layout: [seq][len][prio][msgsize bytes].
+ *
+ * ## Blocking
+ * The wait condition (the next slot's sequence byte, so a slot claimed
+ * but not yet published counts as unavailable) is re-checked under
+ * nk_sched_lock() before nk_waitq_block().  On one core the opposite side cannot run inside
+ * that window, so it only has to look at the wait queue after its own
+ * ring update; with kernel_smp_cores > 1 it takes the scheduler lock to
+ * do so.
+ */
+
+#include "nk_mq.h"
+#include "arch/common/hal.h"
+#include "nk_pool.h"
+#include <string.h>
+
+#if NK_MQ_POOL > 0
+
+#ifndef CONFIG_KERNEL_SMP_CORES
+#  define CONFIG_KERNEL_SMP_CORES 1
+#endif
+
+#define SLOT_HDR 3u
+
+typedef struct {
+    uint8_t bytes[NK_MQ_BUF];
+} mq_buf_t;
+
+NK_POOL_DEFINE_ISR(mq_bufs, mq_buf_t, NK_MQ_POOL);
+
+/*═══════════════════════════════════════════════════════════════════
+ * RING HELPERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+static inline volatile uint8_t *slot(const nk_mq_t *q, uint8_t pos) {
+    return q->ring + (size_t)(pos & q->mask) * (SLOT_HDR + q->msgsize);
+}
+
+/* Tail slot is free / head slot is published (wait conditions). */
+static inline bool can_put(const nk_mq_t *q) {
+    return slot(q, q->tail)[0] == q->tail;
+}
+
+static inline bool can_get(const nk_mq_t *q) {
+    return slot(q, q->head)[0] == (uint8_t)(q->head + 1);
+}
+
+static bool try_put(nk_mq_t *q, const void *msg, uint8_t len, uint8_t prio) {
+    for (;;) {
+        uint8_t pos = q->tail;
+        volatile uint8_t *s = slot(q, pos);
+        int8_t diff = (int8_t)(uint8_t)(s[0] - pos);
+
+        if (diff < 0) {
+            return false;                       /* full */
+        }
+        if (diff == 0 && hal_atomic_compare_exchange_u8(&q->tail, &pos,
+                                                        (uint8_t)(pos + 1))) {
+            s[1] = len;
+            s[2] = prio;
+            memcpy((uint8_t *)s + SLOT_HDR, msg, len);
+            hal_memory_barrier();
+            s[0] = (uint8_t)(pos + 1);          /* publish */
+            return true;
+        }
+        /* Another sender took the slot; retry with the new tail */
+    }
+}
+
+static int try_get(nk_mq_t *q, void *buf, uint8_t *prio) {
+    for (;;) {
+        uint8_t pos = q->head;
+        volatile uint8_t *s = slot(q, pos);
+        int8_t diff = (int8_t)(uint8_t)(s[0] - (uint8_t)(pos + 1));
+
+        if (diff < 0) {
+            return -1;                          /* empty */
+        }
+        if (diff == 0 && hal_atomic_compare_exchange_u8(&q->head, &pos,
+                                                        (uint8_t)(pos + 1))) {
+            uint8_t len = s[1];
+            if (prio) {
+                *prio = s[2];
+            }
+            memcpy(buf, (const uint8_t *)s + SLOT_HDR, len);
+            hal_memory_barrier();
+            s[0] = (uint8_t)(pos + q->mask + 1);  /* free for the next lap */
+            return len;
+        }
+    }
+}
+
+/* Wake one task sleeping on @p wq after the ring changed. */
+static void wake(nk_waitq_t *wq) {
+#if CONFIG_KERNEL_SMP_CORES > 1
+    uint32_t s = nk_sched_lock();
+    nk_waitq_wake_one(wq);
+    nk_sched_unlock(s);
+#else
+    hal_memory_barrier();
+    if (*wq) {
+        nk_waitq_wake_one(wq);
+    }
+#endif
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API IMPLEMENTATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+int nk_mq_create(nk_mq_t *q, uint8_t depth, uint8_t msgsize) {
+    if (depth == 0 || depth > NK_MQ_DEPTH_MAX || (depth & (depth - 1)) ||
+        msgsize == 0 || (size_t)depth * (SLOT_HDR + msgsize) > NK_MQ_BUF) {
+        return -1;
+    }
+
+    mq_buf_t *b = NK_POOL_ALLOC(mq_bufs);
+    if (!b) {
+        return -1;
+    }
+
+    q->ring = b->bytes;
+    q->head = 0;
+    q->tail = 0;
+    q->mask = (uint8_t)(depth - 1);
+    q->msgsize = msgsize;
+    q->not_empty = NK_WAITQ_INIT;
+    q->not_full = NK_WAITQ_INIT;
+    for (uint8_t i = 0; i < depth; ++i) {
+        slot(q, i)[0] = i;
+    }
+    return 0;
+}
+
+void nk_mq_destroy(nk_mq_t *q) {
+    if (q->ring) {
+        nk_pool_free(&mq_bufs, q->ring);
+        q->ring = NULL;
+    }
+}
+
+int nk_mq_send(nk_mq_t *q, const void *msg, uint8_t len,
+               uint8_t prio, bool block) {
+    if (len > q->msgsize) {
+        return -1;
+    }
+
+    while (!try_put(q, msg, len, prio)) {
+        if (!block) {
+            return -1;
+        }
+        uint32_t s = nk_sched_lock();
+        if (!can_put(q)) {
+            nk_waitq_block(&q->not_full);       /* releases the lock */
+        } else {
+            nk_sched_unlock(s);
+        }
+    }
+
+    wake(&q->not_empty);
+    return 0;
+}
+
+int nk_mq_recv(nk_mq_t *q, void *buf, uint8_t cap,
+               uint8_t *prio, bool block) {
+    if (cap < q->msgsize) {
+        return -1;
+    }
+
+    int n;
+    while ((n = try_get(q, buf, prio)) < 0) {
+        if (!block) {
+            return -1;
+        }
+        uint32_t s = nk_sched_lock();
+        if (!can_get(q)) {
+            nk_waitq_block(&q->not_empty);
+        } else {
+            nk_sched_unlock(s);
+        }
+    }
+
+    wake(&q->not_full);
+    return n;
+}
+
+#endif /* NK_MQ_POOL > 0 */
@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_mq.h
+ * @brief Fixed-capacity kernel message queues
+ *
+ * Bounded rings of fixed-size messages, the queued counterpart of the
+ * synchronous doors and the engine under the POSIX mq_*() calls.  Each
+ * slot carries a sequence byte, so senders and receivers claim slots
+ * with a single compare-and-swap on the ring index and never take a
+ * lock: one producer/one consumer costs a couple of loads and stores
+ * per message, and several producers (tasks or ISRs) stay correct.
+ *
+ * Blocking is optional per call.  A sender that finds the ring full (or
+ * a receiver that finds it empty) sleeps on the queue's wait queue and
+ * is woken by the next receive (or send).
+ *
+ * Ring storage never lives on a stack: nk_mq_create() takes one of
+ * NK_MQ_POOL fixed buffers of NK_MQ_BUF bytes from a dedicated pool.
+ *
+ * ```c
+ * nk_mq_t q;
+ * nk_mq_create(&q, 8, 16);              // 8 messages of up to 16 bytes
+ * nk_mq_send(&q, "hi", 2, 0, true);
+ * uint8_t buf[16];
+ * int n = nk_mq_recv(&q, buf, sizeof(buf), NULL, true);
+ * ```
+ */
+
+#ifndef KERNEL_IPC_NK_MQ_H
+#define KERNEL_IPC_NK_MQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "kernel/sched/scheduler.h"  /* nk_waitq_t */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Queues that may exist at once (0 = no message queues)
+ *
+ * Follows ipc_mq_max.
+ */
+#ifndef NK_MQ_POOL
+#  if defined(CONFIG_IPC_MQ_MAX)
+#    define NK_MQ_POOL CONFIG_IPC_MQ_MAX
+#  else
+#    define NK_MQ_POOL 0
+#  endif
+#endif
+
+/**
+ * @brief Ring storage per queue in bytes
+ *
+ * A queue of depth d and message size m needs d * (m + 3) bytes.
+ */
+#ifndef NK_MQ_BUF
+#  define NK_MQ_BUF 128
+#endif
+
+/** Deepest ring (sequence bytes must not alias). */
+#define NK_MQ_DEPTH_MAX 64
+
+/*═══════════════════════════════════════════════════════════════════
+ * QUEUE OBJECT
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef struct {
+    uint8_t          *ring;      /**< Pool buffer holding the slots */
+    volatile uint8_t  head;      /**< Next slot to receive (free-running) */
+    volatile uint8_t  tail;      /**< Next slot to send (free-running) */
+    uint8_t           mask;      /**< depth - 1 */
+    uint8_t           msgsize;   /**< Largest message in bytes */
+    nk_waitq_t        not_empty; /**< Receivers waiting for a message */
+    nk_waitq_t        not_full;  /**< Senders waiting for a free slot */
+} nk_mq_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * OPERATIONS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Create an empty queue
+ *
+ * @param q       Queue object to initialise
+ * @param depth   Messages held (power of two, 1..NK_MQ_DEPTH_MAX)
+ * @param msgsize Largest message in bytes (1..255)
+ * @return 0 on success, -1 if the shape is invalid, does not fit in
+ *         NK_MQ_BUF, or the pool is exhausted
+ */
+int nk_mq_create(nk_mq_t *q, uint8_t depth, uint8_t msgsize);
+
+/**
+ * @brief Return a queue's storage to the pool
+ *
+ * No task may be blocked on, or still using, the queue.
+ */
+void nk_mq_destroy(nk_mq_t *q);
+
+/**
+ * @brief Enqueue one message
+ *
+ * Safe from ISRs when @p block is false.
+ *
+ * @param q     Queue
+ * @param msg   Message bytes
+ * @param len   Message length (0..msgsize)
+ * @param prio  Tag returned to the receiver (delivery stays FIFO)
+ * @param block Sleep while the queue is full
+ * @return 0 on success, -1 if @p len is too large or the queue is full
+ *         and @p block is false
+ */
+int nk_mq_send(nk_mq_t *q, const void *msg, uint8_t len,
+               uint8_t prio, bool block);
+
+/**
+ * @brief Dequeue the oldest message
+ *
+ * Safe from ISRs when @p block is false.
+ *
+ * @param q     Queue
+ * @param buf   Receives the message
+ * @param cap   Bytes available at @p buf (must be >= msgsize)
+ * @param prio  Receives the sender's tag (may be NULL)
+ * @param block Sleep while the queue is empty
+ * @return Message length, or -1 if @p cap is too small or the queue is
+ *         empty and @p block is false
+ */
+int nk_mq_recv(nk_mq_t *q, void *buf, uint8_t cap,
+               uint8_t *prio, bool block);
+
+/** Messages currently queued (a snapshot). */
+static inline uint8_t nk_mq_count(const nk_mq_t *q) {
+    return (uint8_t)(q->tail - q->head);
+}
+
+/** Ring capacity in messages. */
+static inline uint8_t nk_mq_depth(const nk_mq_t *q) {
+    return (uint8_t)(q->mask + 1u);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_IPC_NK_MQ_H */
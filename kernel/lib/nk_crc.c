@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_crc.c
+ * @brief CRC-8/16/32 engine (see nk_crc.h for models and strategies)
+ */
+
+#include "nk_crc.h"
+
+#if (NK_CRC8_STRATEGY >= NK_CRC_NIBBLE && NK_CRC8_STRATEGY <= NK_CRC_SLICE4) || \
+    (NK_CRC16_STRATEGY >= NK_CRC_NIBBLE && NK_CRC16_STRATEGY <= NK_CRC_SLICE4) || \
+    (NK_CRC32_STRATEGY >= NK_CRC_NIBBLE && NK_CRC32_STRATEGY <= NK_CRC_SLICE4)
+#  include "nk_crc_tables.h"   /* generated by scripts/gen_crc_tables.py */
+#endif
+
+#define CRC8_POLY  0x8Cu         /* 0x31 reflected */
+#define CRC16_POLY 0x1021u
+#define CRC32_POLY 0xEDB88320u   /* 0x04C11DB7 reflected */
+
+/*═══════════════════════════════════════════════════════════════════
+ * CRC-8/MAXIM
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define T8(i)   hal_pgm_read_byte(&crc8_slice[(i)])
+
+uint8_t nk_crc8(uint8_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+
+#if NK_CRC8_STRATEGY == NK_CRC_HW
+    return hal_crc8(crc, p, len);
+#else
+#  if NK_CRC8_STRATEGY == NK_CRC_SLICE4
+    for (; len >= 4; len -= 4, p += 4) {
+        crc = (uint8_t)(T8(3 * 256 + (uint8_t)(crc ^ p[0])) ^ T8(2 * 256 + p[1]) ^
+                        T8(1 * 256 + p[2]) ^ T8(p[3]));
+    }
+#  endif
+    while (len--) {
+        crc ^= *p++;
+#  if NK_CRC8_STRATEGY == NK_CRC_SLICE4
+        crc = T8(crc);
+#  elif NK_CRC8_STRATEGY == NK_CRC_BYTE
+        crc = hal_pgm_read_byte(&crc8_byte[crc]);
+#  elif NK_CRC8_STRATEGY == NK_CRC_NIBBLE
+        crc = (uint8_t)(hal_pgm_read_byte(&crc8_nibble[crc & 0x0F]) ^ (crc >> 4));
+        crc = (uint8_t)(hal_pgm_read_byte(&crc8_nibble[crc & 0x0F]) ^ (crc >> 4));
+#  else
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 1) ? (uint8_t)((crc >> 1) ^ CRC8_POLY) : (uint8_t)(crc >> 1);
+        }
+#  endif
+    }
+    return crc;
+#endif
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * CRC-16/CCITT (MSB first)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define T16(i)  hal_pgm_read_word(&crc16_slice[(i)])
+
+uint16_t nk_crc16(uint16_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+
+#if NK_CRC16_STRATEGY == NK_CRC_HW
+    return hal_crc16(crc, p, len);
+#else
+#  if NK_CRC16_STRATEGY == NK_CRC_SLICE4
+    for (; len >= 4; len -= 4, p += 4) {
+        crc = (uint16_t)(T16(3 * 256 + (uint8_t)((crc >> 8) ^ p[0])) ^
+                         T16(2 * 256 + (uint8_t)(crc ^ p[1])) ^
+                         T16(1 * 256 + p[2]) ^ T16(p[3]));
+    }
+#  endif
+    while (len--) {
+#  if NK_CRC16_STRATEGY == NK_CRC_SLICE4
+        crc = (uint16_t)((crc << 8) ^ T16((uint8_t)((crc >> 8) ^ *p++)));
+#  elif NK_CRC16_STRATEGY == NK_CRC_BYTE
+        crc = (uint16_t)((crc << 8) ^
+                         hal_pgm_read_word(&crc16_byte[(uint8_t)((crc >> 8) ^ *p++)]));
+#  elif NK_CRC16_STRATEGY == NK_CRC_NIBBLE
+        uint8_t b = *p++;
+        crc = (uint16_t)((crc << 4) ^
+                         hal_pgm_read_word(&crc16_nibble[(crc >> 12) ^ (b >> 4)]));
+        crc = (uint16_t)((crc << 4) ^
+                         hal_pgm_read_word(&crc16_nibble[(crc >> 12) ^ (b & 0x0F)]));
+#  else
+        crc ^= (uint16_t)(*p++ << 8);
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ CRC16_POLY)
+                                  : (uint16_t)(crc << 1);
+        }
+#  endif
+    }
+    return crc;
+#endif
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * CRC-32/IEEE (reflected, zlib chaining)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define T32(i)  hal_pgm_read_dword(&crc32_slice[(i)])
+
+uint32_t nk_crc32(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+
+#if NK_CRC32_STRATEGY == NK_CRC_HW
+    return hal_crc32(crc, p, len);
+#else
+    crc = ~crc;
+#  if NK_CRC32_STRATEGY == NK_CRC_SLICE4
+    for (; len >= 4; len -= 4, p += 4) {
+        crc ^= (uint32_t)p[0] | (uint32_t)p[1] << 8 |
+               (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+        crc = T32(3 * 256 + (uint8_t)crc) ^ T32(2 * 256 + (uint8_t)(crc >> 8)) ^
+              T32(1 * 256 + (uint8_t)(crc >> 16)) ^ T32((uint8_t)(crc >> 24));
+    }
+#  endif
+    while (len--) {
+        crc ^= *p++;
+#  if NK_CRC32_STRATEGY == NK_CRC_SLICE4
+        crc = T32((uint8_t)crc) ^ (crc >> 8);
+#  elif NK_CRC32_STRATEGY == NK_CRC_BYTE
+        crc = hal_pgm_read_dword(&crc32_byte[(uint8_t)crc]) ^ (crc >> 8);
+#  elif NK_CRC32_STRATEGY == NK_CRC_NIBBLE
+        crc = hal_pgm_read_dword(&crc32_nibble[crc & 0x0F]) ^ (crc >> 4);
+        crc = hal_pgm_read_dword(&crc32_nibble[crc & 0x0F]) ^ (crc >> 4);
+#  else
+        for (uint8_t i = 0; i < 8; i++) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32_POLY : crc >> 1;
+        }
+#  endif
+    }
+    return ~crc;
+#endif
+}
@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_crc.h
+ * @brief Shared CRC-8/16/32 engine with a selectable size/speed point
+ *
+ * One implementation for every checksum user (door requests, nk_fs
+ * records and checkpoints, link layers), instead of a private table
+ * in each.  Three standard models:
+ *
+ *   nk_crc8()   CRC-8/MAXIM (Dallas 1-Wire): poly 0x31 reflected, init 0,
+ *               check("123456789") = 0xA1
+ *   nk_crc16()  CRC-16/CCITT: poly 0x1021 MSB first, no final xor;
+ *               seed 0 is XMODEM (0x31C3), 0xFFFF is CCITT-FALSE (0x29B1)
+ *   nk_crc32()  CRC-32/IEEE as zlib: seed 0, chains, 0xCBF43926
+ *
+ * All three take the running value and continue it, so a message may
+ * be checksummed in pieces.
+ *
+ * STRATEGIES
+ * ──────────
+ * Picked per width (crc_strategy sets all three; NK_CRCn_STRATEGY
+ * overrides one).  Tables come from scripts/gen_crc_tables.py at build
+ * time and live in HAL_PROGMEM; only the selected ones are compiled.
+ *
+ *   strategy   table flash (8/16/32-bit)   AVR cycles per byte (approx.)
+ *   bitwise    0                           60 / 70 / 130
+ *   nibble     16 / 32 / 64                25 / 40 / 70
+ *   byte       256 / 512 / 1024            10 / 16 / 28
+ *   slice4     1 K / 2 K / 4 K             8 / 12 / 18
+ *   hw         HAL unit (HAL_HAS_CRCn), else byte
+ *
+ * slice4 pays off on 32-bit cores, where it folds four bytes into one
+ * step of word-wide XORs.
+ */
+
+#ifndef NK_CRC_H
+#define NK_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "avrix-config.h"
+#include "arch/common/hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NK_CRC_BITWISE 0
+#define NK_CRC_NIBBLE  1
+#define NK_CRC_BYTE    2
+#define NK_CRC_SLICE4  3
+#define NK_CRC_HW      4
+
+/** Default for every width (meson crc_strategy) */
+#ifndef NK_CRC_STRATEGY
+#  if defined(CONFIG_CRC_STRATEGY)
+#    define NK_CRC_STRATEGY CONFIG_CRC_STRATEGY
+#  else
+#    define NK_CRC_STRATEGY NK_CRC_NIBBLE
+#  endif
+#endif
+
+#ifndef NK_CRC8_STRATEGY
+#  define NK_CRC8_STRATEGY NK_CRC_STRATEGY
+#endif
+#ifndef NK_CRC16_STRATEGY
+#  define NK_CRC16_STRATEGY NK_CRC_STRATEGY
+#endif
+#ifndef NK_CRC32_STRATEGY
+#  define NK_CRC32_STRATEGY NK_CRC_STRATEGY
+#endif
+
+/* "hw" without a unit in this HAL: fall back to the byte table */
+#if NK_CRC8_STRATEGY == NK_CRC_HW && !(defined(HAL_HAS_CRC8) && HAL_HAS_CRC8)
+#  undef NK_CRC8_STRATEGY
+#  define NK_CRC8_STRATEGY NK_CRC_BYTE
+#endif
+#if NK_CRC16_STRATEGY == NK_CRC_HW && !(defined(HAL_HAS_CRC16) && HAL_HAS_CRC16)
+#  undef NK_CRC16_STRATEGY
+#  define NK_CRC16_STRATEGY NK_CRC_BYTE
+#endif
+#if NK_CRC32_STRATEGY == NK_CRC_HW && !(defined(HAL_HAS_CRC32) && HAL_HAS_CRC32)
+#  undef NK_CRC32_STRATEGY
+#  define NK_CRC32_STRATEGY NK_CRC_BYTE
+#endif
+
+/**
+ * @brief Continue a CRC-8/MAXIM over @p len bytes
+ *
+ * @param crc Running value, 0 to start
+ * @return Updated CRC
+ */
+uint8_t nk_crc8(uint8_t crc, const void *p, size_t len);
+
+/**
+ * @brief Continue a CRC-16/CCITT (poly 0x1021) over @p len bytes
+ *
+ * @param crc Running value: 0 (XMODEM) or 0xFFFF (CCITT-FALSE) to start
+ * @return Updated CRC
+ */
+uint16_t nk_crc16(uint16_t crc, const void *p, size_t len);
+
+/**
+ * @brief Continue a CRC-32/IEEE over @p len bytes
+ *
+ * The inversions are inside, as in zlib's crc32(): start from 0 and
+ * feed the result back in to chain.
+ *
+ * @param crc Running value, 0 to start
+ * @return Updated CRC
+ */
+uint32_t nk_crc32(uint32_t crc, const void *p, size_t len);
+
+/** One byte of CRC-8, for callers that checksum as they go */
+static inline uint8_t nk_crc8_byte(uint8_t crc, uint8_t b) {
+    return nk_crc8(crc, &b, 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NK_CRC_H */
@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_warm.c
+ * @brief Warm-restart control block and CRC-guarded state blocks
+ */
+
+#include "nk_warm.h"
+
+#if NK_WARM
+
+#include "nk_crc.h"
+
+#define NK_WARM_MAGIC 0x5741u       /* "WA" */
+
+/* The only state that must itself survive: is .noinit set up, and which
+ * cold boot did the blocks come from */
+static struct {
+    uint16_t magic;
+    uint16_t gen;
+} warm_ctl NK_WARM_DATA;
+
+static bool warm;                   /* .bss: false until nk_warm_init() */
+
+void nk_warm_init(hal_reset_reason_t why) {
+    warm = why == HAL_RESET_WATCHDOG || why == HAL_RESET_SOFTWARE ||
+           why == HAL_RESET_EXTERNAL;
+    if (warm_ctl.magic != NK_WARM_MAGIC) {
+        warm_ctl.magic = NK_WARM_MAGIC;
+        warm = false;
+    }
+    if (!warm)
+        warm_ctl.gen++;             /* whatever .noinit holds is stale */
+}
+
+bool nk_warm_is_warm(void) {
+    return warm;
+}
+
+bool nk_warm_restore(const nk_warm_hdr_t *h, const void *data, uint16_t len) {
+    return warm && len && h->len == len &&
+           h->crc == nk_crc16(warm_ctl.gen, data, len);
+}
+
+void nk_warm_save(nk_warm_hdr_t *h, const void *data, uint16_t len) {
+    h->len = 0;                     /* a reset in here leaves it invalid */
+    hal_memory_barrier();
+    h->crc = nk_crc16(warm_ctl.gen, data, len);
+    hal_memory_barrier();
+    h->len = len;
+}
+
+#endif /* NK_WARM */
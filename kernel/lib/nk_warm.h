@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_warm.h
+ * @brief Warm restart: subsystem state kept in .noinit across resets
+ *
+ * The startup code clears .bss and copies .data on every reset, but
+ * leaves .noinit alone, so RAM placed there still holds what it held
+ * when a watchdog or software reset hit.  A subsystem whose mount is
+ * expensive (a log scan, an index rebuild) keeps that state in
+ * NK_WARM_DATA storage with an nk_warm_hdr_t next to it:
+ *
+ * ```c
+ * static struct { ... } st NK_WARM_DATA;
+ * static nk_warm_hdr_t st_warm NK_WARM_DATA;
+ *
+ * void sub_init(void) {
+ *     if (nk_warm_restore(&st_warm, &st, sizeof st))
+ *         return;                         // resumed, nothing to rebuild
+ *     ...slow init...
+ *     nk_warm_save(&st_warm, &st, sizeof st);
+ * }
+ * ```
+ *
+ * and brackets every change with nk_warm_invalidate() before touching
+ * its backing store and nk_warm_save() once RAM and store agree again,
+ * so a reset in between falls back to the slow path.
+ *
+ * nk_warm_init() decides once per boot, from hal_reset_reason(),
+ * whether saved blocks may be trusted: never after power-on or
+ * brown-out (RAM contents are undefined), nor before the control block
+ * has been set up once.  Each cold boot also bumps a generation number
+ * that seeds every block's CRC-16, so a block left over from before it
+ * cannot match by accident.
+ *
+ * Without NK_WARM (-Dkernel_warm_restart=true) the state stays in .bss,
+ * nk_warm_restore() is constant false and the rest compiles away.
+ */
+
+#ifndef NK_WARM_H
+#define NK_WARM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "avrix-config.h"
+#include "arch/common/hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef NK_WARM
+#  if defined(CONFIG_KERNEL_WARM_RESTART)
+#    define NK_WARM CONFIG_KERNEL_WARM_RESTART
+#  else
+#    define NK_WARM 0
+#  endif
+#endif
+
+/** Guard of one saved block (4 bytes, in .noinit with it) */
+typedef struct {
+    volatile uint16_t len;          /**< Size saved, 0 = invalid */
+    uint16_t          crc;          /**< CRC-16 of the block, seeded by gen */
+} nk_warm_hdr_t;
+
+#if NK_WARM
+
+/** Storage that survives warm resets (garbage after a cold one) */
+#define NK_WARM_DATA HAL_SECTION(".noinit")
+
+/**
+ * @brief Classify this boot; call once, before any nk_warm_restore()
+ *
+ * @param why Reset cause, normally hal_reset_reason()
+ */
+void nk_warm_init(hal_reset_reason_t why);
+
+/** True when saved blocks may be restored on this boot */
+bool nk_warm_is_warm(void);
+
+/**
+ * @brief Accept the @p len bytes at @p data as left by the last boot
+ *
+ * @return true on a warm boot whose block at @p data was saved with
+ *         this size and still matches its CRC; the caller then skips
+ *         its initialisation.  false means rebuild (and save) it.
+ */
+bool nk_warm_restore(const nk_warm_hdr_t *h, const void *data, uint16_t len);
+
+/** Record the @p len bytes at @p data as current */
+void nk_warm_save(nk_warm_hdr_t *h, const void *data, uint16_t len);
+
+/** The block is about to disagree with its backing store */
+static inline void nk_warm_invalidate(nk_warm_hdr_t *h) {
+    h->len = 0;
+    hal_memory_barrier();
+}
+
+#else
+
+#define NK_WARM_DATA
+
+static inline void nk_warm_init(hal_reset_reason_t why) { (void)why; }
+static inline bool nk_warm_is_warm(void) { return false; }
+static inline bool nk_warm_restore(const nk_warm_hdr_t *h, const void *data,
+                                   uint16_t len) {
+    (void)h; (void)data; (void)len;
+    return false;
+}
+static inline void nk_warm_save(nk_warm_hdr_t *h, const void *data, uint16_t len) {
+    (void)h; (void)data; (void)len;
+}
+static inline void nk_warm_invalidate(nk_warm_hdr_t *h) { (void)h; }
+
+#endif /* NK_WARM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NK_WARM_H */
@@ -22,12 +22,23 @@
  *         |        +-- Returned to user
  *         +-- Metadata (next ptr + size)
  * ```
+ *
+ * ## Slab Mode (NK_KALLOC_SLAB)
+ * Same block layout, but `size` holds a size-class index and each class
+ * keeps its own LIFO free list.  An empty list is refilled by carving
+ * several equal blocks from the heap top at once.
+ *
+ * ## Regions
+ * Every region (heap[] first, then kalloc_add_region()) has its own
+ * bump pointer and free list(s); kfree() picks the region by address.
  */
 
 #include "kalloc.h"
 #include <stddef.h>
 #include <string.h>
 
+#if !NK_KALLOC_TLSF     /* TLSF backend lives in kalloc_tlsf.c */
+
 /*═══════════════════════════════════════════════════════════════════
  * INTERNAL STRUCTURES
  *═══════════════════════════════════════════════════════════════════*/
@@ -38,11 +49,14 @@
  * Prepended to each allocated block. When freed, the block is added
  * to the free-list via the `next` pointer.
  *
- * Size: 2 bytes (8-bit) or 3 bytes (16/32-bit with padding)
+ * Size on AVR: 3 bytes with 8-bit sizes, 4 with 16-bit, 6 with 32-bit
  */
 typedef struct block {
     struct block *next;  /**< Next block in free-list (NULL if allocated) */
-    uint8_t size;        /**< User-requested size (bytes) */
+    kalloc_size_t size;  /**< Usable size (bytes), capped at KALLOC_SIZE_MAX */
+#if NK_KALLOC_TASK_STATS
+    uint8_t owner;       /**< Allocating task (NK_KALLOC_OWNERS - 1 = none) */
+#endif
 } block_t;
 
 /*═══════════════════════════════════════════════════════════════════
@@ -52,13 +66,49 @@ typedef struct block {
 /**
  * @brief Align size to NK_KALLOC_ALIGN boundary
  *
+ * Computed in uint32_t: rounding KALLOC_SIZE_MAX up overflows the
+ * size type itself.
+ *
  * @param size Unaligned size
  * @return Aligned size
  */
-static inline uint8_t align_size(uint8_t size) {
-    uint8_t mask = NK_KALLOC_ALIGN - 1;
-    return (size + mask) & ~mask;
+static inline uint32_t align_size(kalloc_size_t size) {
+    /* Also keep the next header aligned (8 bytes on LP64 hosts) */
+    const uint32_t mask = (_Alignof(block_t) > NK_KALLOC_ALIGN
+                           ? _Alignof(block_t) : NK_KALLOC_ALIGN) - 1;
+    return ((uint32_t)size + mask) & ~mask;
+}
+
+#if NK_KALLOC_SLAB
+/*═══════════════════════════════════════════════════════════════════
+ * SIZE CLASSES
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define SLAB_MIN     8u
+#if NK_KALLOC_SIZE_BITS == 32
+#  define SLAB_CLASSES 29                       /* up to 2 GiB */
+#else
+#  define SLAB_CLASSES (NK_KALLOC_SIZE_BITS - 2) /* 8 << 0 .. 2^bits */
+#endif
+#define SLAB_MAX     ((uint32_t)SLAB_MIN << (SLAB_CLASSES - 1))
+
+/* Smallest class holding @p size bytes (size >= 1). */
+static inline uint8_t slab_class(kalloc_size_t size) {
+    uint8_t c = 0;
+    for (kalloc_size_t v = (kalloc_size_t)((size - 1) / SLAB_MIN); v; v >>= 1) {
+        ++c;
+    }
+    return c;
+}
+
+/* Bytes one block of class @p c occupies, header included. */
+static inline uint32_t slab_stride(uint8_t c) {
+    const uint32_t a = _Alignof(block_t) > NK_KALLOC_ALIGN
+                     ? _Alignof(block_t) : NK_KALLOC_ALIGN;
+    uint32_t n = sizeof(block_t) + ((uint32_t)SLAB_MIN << c);
+    return (n + a - 1) & ~(a - 1);
 }
+#endif /* NK_KALLOC_SLAB */
 
 /*═══════════════════════════════════════════════════════════════════
  * HEAP STATE
@@ -67,75 +117,167 @@ static inline uint8_t align_size(uint8_t size) {
 /**
  * @brief Static heap buffer
  *
- * Fixed-size heap allocated in BSS section.
+ * Fixed-size heap allocated in BSS section; always region 0.  Aligned
+ * for max_align_t so the first block suits nk_arena_init_heap() too,
+ * wherever the linker puts the region table beside it.
  */
-static uint8_t heap[NK_HEAP_SIZE];
+static uint8_t heap[NK_HEAP_SIZE] __attribute__((aligned(_Alignof(max_align_t))));
 
 /**
- * @brief Current heap top pointer
+ * @brief One heap region
  *
- * Points to the next free location in the heap for bump allocation.
+ * Bump pointer plus free list(s) over [base, end).  Regions never
+ * share blocks, so each is a heap of its own.
  */
-static uint8_t *heap_top;
+typedef struct {
+    uint8_t *base;                      /**< First byte */
+    uint8_t *end;                       /**< One past the last byte */
+    uint8_t *top;                       /**< Next free location for bump allocation */
+#if NK_KALLOC_SLAB
+    block_t *slab_free[SLAB_CLASSES];   /**< Per-class free lists */
+#else
+    block_t *freelist;                  /**< Freed blocks available for reuse */
+#endif
+#if NK_KALLOC_STATS
+    kalloc_stats_t stats;
+#endif
+    uint8_t  kind;                      /**< KALLOC_FAST or KALLOC_BULK */
+} kheap_t;
+
+static kheap_t heaps[NK_KALLOC_REGIONS];
+static uint8_t heap_count;
+
+/* Start region @p h over [base, base + len) with nothing allocated. */
+static void heap_reset(kheap_t *h, uint8_t *base, size_t len, uint8_t kind) {
+    memset(h, 0, sizeof(*h));
+    h->base = base;
+    h->end = base + len;
+    h->top = base;
+    h->kind = kind;
+#if NK_KALLOC_STATS
+    h->stats.total_size = len;
+    h->stats.free_bytes = len;
+#endif
+}
 
-/**
- * @brief Free-list head
- *
- * Singly-linked list of freed blocks available for reuse.
- */
-static block_t *freelist;
+/* Region holding @p ptr; anything outside the others is heap[]. */
+static inline kheap_t *heap_of(const void *ptr) {
+#if NK_KALLOC_REGIONS > 1
+    const uint8_t *p = (const uint8_t *)ptr;
+    for (uint8_t i = 1; i < heap_count; ++i) {
+        if (p >= heaps[i].base && p < heaps[i].end) {
+            return &heaps[i];
+        }
+    }
+#endif
+    (void)ptr;
+    return &heaps[0];
+}
+
+#if NK_KALLOC_TASK_STATS
+static size_t task_used[NK_KALLOC_OWNERS];
+#endif
 
 #if NK_KALLOC_STATS
-/**
- * @brief Heap statistics (optional)
- */
-static kalloc_stats_t stats;
+/* Block @p b of region @p h, occupying @p bytes with its header, goes live. */
+static void stats_take(kheap_t *h, block_t *b, size_t bytes) {
+    kalloc_stats_t *st = &h->stats;
+    st->alloc_count++;
+    st->used_bytes += bytes;
+    st->free_bytes -= bytes;
+    if (st->used_bytes > st->peak_used) {
+        st->peak_used = st->used_bytes;
+    }
+#if NK_KALLOC_TASK_STATS
+    b->owner = kalloc_owner();
+    task_used[b->owner] += bytes;
+#else
+    (void)b;
 #endif
+}
 
-/*═══════════════════════════════════════════════════════════════════
- * PUBLIC API IMPLEMENTATION
- *═══════════════════════════════════════════════════════════════════*/
+/* Block @p b of region @p h, occupying @p bytes with its header, is released. */
+static void stats_give(kheap_t *h, block_t *b, size_t bytes) {
+    kalloc_stats_t *st = &h->stats;
+    st->free_count++;
+    st->used_bytes -= bytes;
+    st->free_bytes += bytes;
+#if NK_KALLOC_TASK_STATS
+    task_used[b->owner] -= bytes;
+#else
+    (void)b;
+#endif
+}
+#endif
 
+#if NK_KALLOC_SLAB
 /**
- * @brief Initialize the kernel heap
+ * @brief Refill an empty class list from the heap top
  *
- * Resets the heap pointer and clears the free-list.
+ * @return true if at least one block was carved
  */
-void kalloc_init(void) {
-    heap_top = heap;
-    freelist = NULL;
-
-#if NK_KALLOC_STATS
-    memset(&stats, 0, sizeof(stats));
-    stats.total_size = NK_HEAP_SIZE;
-    stats.free_bytes = NK_HEAP_SIZE;
-#endif
+static bool slab_refill(kheap_t *h, uint8_t c) {
+    uint32_t stride = slab_stride(c);
+    uint32_t room = (uint32_t)(h->end - h->top) / stride;
+    uint32_t n = NK_KALLOC_SLAB_BYTES / stride;
+
+    if (!n) n = 1;
+    if (n > room) n = room;
+    if (!n) return false;
+
+    for (uint32_t i = 0; i < n; ++i) {
+        block_t *b = (block_t *)h->top;
+        b->size = c;
+        b->next = h->slab_free[c];
+        h->slab_free[c] = b;
+        h->top += stride;
+    }
+    return true;
 }
+#endif /* NK_KALLOC_SLAB */
 
 /**
- * @brief Allocate memory from kernel heap
+ * @brief Allocate @p size (> 0) bytes from region @p h
  *
- * @param size Number of bytes to allocate (max 255)
- * @return Pointer to allocated memory, or NULL if out of memory
+ * @return Pointer to allocated memory, or NULL if the region is full
  */
-void *kalloc(uint8_t size) {
-    if (size == 0) {
+static void *heap_alloc(kheap_t *h, kalloc_size_t size) {
+#if NK_KALLOC_SLAB
+#if NK_KALLOC_SIZE_BITS == 32
+    if (size > SLAB_MAX) {
         return NULL;
     }
+#endif
+    uint8_t c = slab_class(size);
+    if (!h->slab_free[c] && !slab_refill(h, c)) {
+        return NULL;  /* Out of memory */
+    }
+
+    block_t *sb = h->slab_free[c];
+    h->slab_free[c] = sb->next;
+    sb->next = NULL;
 
+#if NK_KALLOC_STATS
+    stats_take(h, sb, slab_stride(c));
+#endif
+    return (void *)(sb + 1);
+#else
     /* Align size to platform requirements */
-    size = align_size(size);
+    uint32_t len = align_size(size);
+    if (len > KALLOC_SIZE_MAX) {
+        len = KALLOC_SIZE_MAX;  /* still >= size; the block keeps its slack */
+    }
+    size = (kalloc_size_t)len;
 
     /* Search free-list for suitable block (first-fit) */
-    block_t **prev = &freelist;
-    for (block_t *b = freelist; b != NULL; b = b->next) {
+    block_t **prev = &h->freelist;
+    for (block_t *b = h->freelist; b != NULL; b = b->next) {
         if (b->size >= size) {
             /* Found suitable block - remove from free-list */
             *prev = b->next;
 
 #if NK_KALLOC_STATS
-            stats.alloc_count++;
-            stats.free_blocks--;
+            stats_take(h, b, sizeof(block_t) + align_size(b->size));
 #endif
 
             /* Return user data area (skip header) */
@@ -145,30 +287,118 @@ void *kalloc(uint8_t size) {
     }
 
     /* No suitable free block - allocate from heap */
-    const size_t total_size = sizeof(block_t) + size;
+    const uint32_t total_size = sizeof(block_t) + align_size(size);
 
     /* Check if enough space remains */
-    if (heap_top + total_size > heap + NK_HEAP_SIZE) {
+    if (total_size > (uint32_t)(h->end - h->top)) {
         return NULL;  /* Out of memory */
     }
 
     /* Allocate new block */
-    block_t *blk = (block_t *)heap_top;
+    block_t *blk = (block_t *)h->top;
     blk->next = NULL;
     blk->size = size;
-    heap_top += total_size;
+    h->top += total_size;
 
 #if NK_KALLOC_STATS
-    stats.alloc_count++;
-    stats.used_bytes += total_size;
-    stats.free_bytes = NK_HEAP_SIZE - (heap_top - heap);
-    if (stats.used_bytes > stats.peak_used) {
-        stats.peak_used = stats.used_bytes;
-    }
+    stats_take(h, blk, total_size);
 #endif
 
     /* Return user data area (skip header) */
     return (void *)(blk + 1);
+#endif /* NK_KALLOC_SLAB */
+}
+
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API IMPLEMENTATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Initialize the kernel heap
+ *
+ * Drops every region but heap[] and resets it.
+ */
+void NK_KALLOC_ENTRY(kalloc_init)(void) {
+    heap_reset(&heaps[0], heap, NK_HEAP_SIZE, KALLOC_FAST);
+    heap_count = 1;
+#if NK_KALLOC_TASK_STATS
+    memset(task_used, 0, sizeof(task_used));
+#endif
+#if NK_KALLOC_XMEM
+    size_t xlen;
+    void *x = hal_xmem_init(&xlen);
+    if (x) {
+        NK_KALLOC_ENTRY(kalloc_add_region)(x, xlen, KALLOC_BULK);
+    }
+#endif
+}
+
+int NK_KALLOC_ENTRY(kalloc_add_region)(void *base, size_t len, uint8_t kind) {
+#if NK_KALLOC_REGIONS > 1
+    const uintptr_t a = _Alignof(block_t) > NK_KALLOC_ALIGN
+                      ? _Alignof(block_t) : NK_KALLOC_ALIGN;
+    uintptr_t lo = ((uintptr_t)base + a - 1) & ~(a - 1);
+    uintptr_t hi = (uintptr_t)base + len;
+
+    if (!base || kind > KALLOC_BULK || heap_count >= NK_KALLOC_REGIONS ||
+        hi < (uintptr_t)base || hi <= lo || hi - lo < sizeof(block_t) + a) {
+        return -1;
+    }
+    for (uint8_t i = 0; i < heap_count; ++i) {
+        if (lo < (uintptr_t)heaps[i].end && hi > (uintptr_t)heaps[i].base) {
+            return -1;  /* Overlaps region i */
+        }
+    }
+    heap_reset(&heaps[heap_count], (uint8_t *)lo, hi - lo, kind);
+    return heap_count++;
+#else
+    (void)base; (void)len; (void)kind;
+    return -1;
+#endif
+}
+
+/**
+ * @brief Allocate memory from a region of the hinted kind
+ *
+ * @param size Number of bytes to allocate (max KALLOC_SIZE_MAX)
+ * @param hint KALLOC_FAST or KALLOC_BULK, optionally | KALLOC_ONLY
+ * @return Pointer to allocated memory, or NULL if out of memory
+ */
+void *NK_KALLOC_ENTRY(kalloc_hint)(kalloc_size_t size, uint8_t hint) {
+    if (size == 0) {
+        return NULL;
+    }
+#if NK_KALLOC_REGIONS > 1
+    uint8_t kind = hint & KALLOC_BULK;
+    for (uint8_t pass = 0; pass < 2; ++pass) {
+        for (uint8_t i = 0; i < heap_count; ++i) {
+            if (heaps[i].kind == kind) {
+                void *p = heap_alloc(&heaps[i], size);
+                if (p) return p;
+            }
+        }
+        if (hint & KALLOC_ONLY) break;
+        kind ^= KALLOC_BULK;
+    }
+    return NULL;
+#else
+    /* heap[] is the one region, and fast */
+    if ((hint & (KALLOC_BULK | KALLOC_ONLY)) == (KALLOC_BULK | KALLOC_ONLY)) {
+        return NULL;
+    }
+    return heap_alloc(&heaps[0], size);
+#endif
+}
+
+/**
+ * @brief Allocate memory from kernel heap
+ *
+ * @param size Number of bytes to allocate (max KALLOC_SIZE_MAX)
+ * @return Pointer to allocated memory, or NULL if out of memory
+ */
+void *NK_KALLOC_ENTRY(kalloc)(kalloc_size_t size) {
+    return NK_KALLOC_ENTRY(kalloc_hint)(size, KALLOC_FAST);
 }
 
 /**
@@ -176,24 +406,52 @@ void *kalloc(uint8_t size) {
  *
  * @param ptr Pointer returned by kalloc(), or NULL (ignored)
  */
-void kfree(void *ptr) {
+void NK_KALLOC_ENTRY(kfree)(void *ptr) {
     if (!ptr) {
         return;
     }
 
     /* Get block header (immediately before user data) */
     block_t *blk = (block_t *)ptr - 1;
+    kheap_t *h = heap_of(ptr);
 
+#if NK_KALLOC_SLAB
+#if NK_KALLOC_STATS
+    stats_give(h, blk, slab_stride((uint8_t)blk->size));
+#endif
+    /* Back onto its class list (LIFO); size holds the class index */
+    blk->next = h->slab_free[blk->size];
+    h->slab_free[blk->size] = blk;
+#else
+#if NK_KALLOC_STATS
+    stats_give(h, blk, sizeof(block_t) + align_size(blk->size));
+#endif
     /* Prepend to free-list (LIFO) */
-    blk->next = freelist;
-    freelist = blk;
+    blk->next = h->freelist;
+    h->freelist = blk;
+#endif
+}
 
-#if NK_KALLOC_STATS
-    stats.free_count++;
-    stats.free_blocks++;
-    /* Note: used_bytes not decremented (would require tracking allocations) */
+int kalloc_kind(const void *ptr) {
+    const uint8_t *p = (const uint8_t *)ptr;
+    for (uint8_t i = 0; i < heap_count; ++i) {
+        if (p >= heaps[i].base && p < heaps[i].end) {
+            return heaps[i].kind;
+        }
+    }
+    return -1;
+}
+
+#if NK_KALLOC_THREAD_SAFE
+size_t kalloc_usable(const void *ptr) {
+    const block_t *blk = (const block_t *)ptr - 1;
+#if NK_KALLOC_SLAB
+    return (size_t)SLAB_MIN << blk->size;
+#else
+    return blk->size;
 #endif
 }
+#endif
 
 /*═══════════════════════════════════════════════════════════════════
  * DEBUGGING & STATISTICS
@@ -202,7 +460,7 @@ void kfree(void *ptr) {
 #if NK_KALLOC_STATS
 
 /**
- * @brief Get heap statistics
+ * @brief Get heap statistics, summed over the regions
  *
  * @param[out] out Pointer to statistics structure to fill
  */
@@ -211,27 +469,69 @@ void kalloc_get_stats(kalloc_stats_t *out) {
         return;
     }
 
+    memset(out, 0, sizeof(*out));
+    for (uint8_t i = 0; i < heap_count; ++i) {
+        kalloc_stats_t one;
+        kalloc_get_region_stats(i, &one);
+        kalloc_stats_merge(out, &one);
+    }
+}
+
+int kalloc_get_region_stats(uint8_t region, kalloc_stats_t *out) {
+    if (region >= heap_count || !out) {
+        return -1;
+    }
+    const kheap_t *h = &heaps[region];
+
     /* Copy current statistics */
-    *out = stats;
+    *out = h->stats;
 
-    /* Count free-list blocks (O(n)) */
+    /* Walk the free lists (O(n)) for block count and histogram */
+    memset(out->free_hist, 0, sizeof(out->free_hist));
+    out->largest_free = 0;
     uint8_t free_count = 0;
-    for (block_t *b = freelist; b != NULL; b = b->next) {
-        free_count++;
-        if (free_count == 255) break;  /* Prevent overflow */
+#if NK_KALLOC_SLAB
+    for (uint8_t c = 0; c < SLAB_CLASSES; ++c) {
+        for (block_t *b = h->slab_free[c]; b != NULL; b = b->next) {
+            kalloc_stats_extent(out, (size_t)SLAB_MIN << c);
+            if (free_count < 255) free_count++;
+        }
     }
+#else
+    for (block_t *b = h->freelist; b != NULL; b = b->next) {
+        kalloc_stats_extent(out, b->size);
+        if (free_count < 255) free_count++;
+    }
+#endif
     out->free_blocks = free_count;
+
+    /* Untouched heap top */
+    size_t top = (size_t)(h->end - h->top);
+    if (top > sizeof(block_t)) {
+        kalloc_stats_extent(out, top - sizeof(block_t));
+    }
+    return h->kind;
 }
 
 /**
  * @brief Reset peak usage counter
  */
 void kalloc_reset_peak(void) {
-    stats.peak_used = stats.used_bytes;
+    for (uint8_t i = 0; i < heap_count; ++i) {
+        heaps[i].stats.peak_used = heaps[i].stats.used_bytes;
+    }
+}
+
+#if NK_KALLOC_TASK_STATS
+size_t kalloc_task_used(uint8_t tid) {
+    return task_used[tid < NK_KALLOC_TASKS ? tid : NK_KALLOC_TASKS];
 }
+#endif
 
 #endif /* NK_KALLOC_STATS */
 
+#endif /* !NK_KALLOC_TLSF */
+
 /*═══════════════════════════════════════════════════════════════════
  * POSIX COMPATIBILITY WRAPPERS
  *═══════════════════════════════════════════════════════════════════*/
@@ -242,10 +542,10 @@ void kalloc_reset_peak(void) {
  * @brief POSIX malloc() compatibility wrapper
  */
 void *malloc(size_t size) {
-    if (size > 255) {
+    if (size > KALLOC_SIZE_MAX) {
         return NULL;  /* Exceeds kalloc limit */
     }
-    return kalloc((uint8_t)size);
+    return kalloc((kalloc_size_t)size);
 }
 
 /**
@@ -259,12 +559,12 @@ void free(void *ptr) {
  * @brief POSIX calloc() compatibility wrapper
  */
 void *calloc(size_t nmemb, size_t size) {
-    size_t total = nmemb * size;
-    if (total > 255) {
+    if (size && nmemb > KALLOC_SIZE_MAX / size) {
         return NULL;  /* Exceeds kalloc limit */
     }
+    size_t total = nmemb * size;
 
-    void *ptr = kalloc((uint8_t)total);
+    void *ptr = kalloc((kalloc_size_t)total);
     if (ptr) {
         memset(ptr, 0, total);
     }
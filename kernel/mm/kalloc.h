@@ -22,10 +22,11 @@
  * - Mid-range (16-bit): 512-1024 bytes (ATmega1284, MSP430)
  * - High-end (32-bit):  2048-4096 bytes (ARM Cortex-M)
  *
- * ## Thread Safety
- * - NOT thread-safe by default (minimal overhead)
- * - Wrap kalloc/kfree in spinlocks for multi-threaded use
- * - Future: Add NK_KALLOC_THREAD_SAFE option for built-in locking
+ * ## Thread Safety (NK_KALLOC_THREAD_SAFE)
+ * - 0: NOT thread-safe (minimal overhead); serialise externally
+ * - 1: every call masks IRQs (plus a spinlock on SMP); ISR-safe
+ * - 2: as 1, but small blocks are recycled through per-task
+ *   magazines first, so the common alloc/free takes no global lock
  *
  * ## Usage
  * ```c
@@ -39,11 +40,34 @@
  * kfree(buf);  // Release memory
  * ```
  *
+ * ## Slab Mode (NK_KALLOC_SLAB)
+ * - Requests are rounded up to a size class: 8/16/32/64/128/256 bytes
+ * - Each class has its own free list, refilled by carving a slab of
+ *   NK_KALLOC_SLAB_BYTES from the heap
+ * - kalloc()/kfree() are O(1) and waste at most half a block, but
+ *   freed memory only serves its own class
+ *
+ * ## TLSF Mode (NK_KALLOC_TLSF)
+ * - Free blocks are binned by size (log2 level, then 4 sub-ranges) and
+ *   found with two bitmap lookups
+ * - Blocks are split on allocation and merged with free neighbours on
+ *   release, so fragmentation stays bounded
+ * - 4-byte header (16-bit heap offsets) on every platform
+ *
+ * ## Heap Regions (NK_KALLOC_REGIONS)
+ * - The static heap is region 0 and tagged KALLOC_FAST; further RAM
+ *   (e.g. external SRAM on the AVR XMEM bus) is added with
+ *   kalloc_add_region() as KALLOC_FAST or KALLOC_BULK
+ * - kalloc_hint() tries regions of the hinted kind first, then the
+ *   other kind unless KALLOC_ONLY is set; kalloc() hints KALLOC_FAST
+ * - Each region is a heap of its own in the selected backend, so
+ *   blocks never span regions and kfree() finds the region by address
+ *
  * ## Limitations
- * - No malloc/free compatibility (uses uint8_t size, not size_t)
+ * - No malloc/free compatibility (uses kalloc_size_t, not size_t)
  * - No realloc support
- * - No coalescing (freed blocks remain fragmented)
- * - Maximum single allocation: 255 bytes
+ * - No coalescing outside TLSF mode (freed blocks remain fragmented)
+ * - Maximum single allocation: KALLOC_SIZE_MAX (255 bytes by default)
  */
 
 #ifndef KERNEL_MM_KALLOC_H
@@ -55,6 +79,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stddef.h>
+#include "avrix-config.h"
 #include "arch/common/hal.h"
 
 /*═══════════════════════════════════════════════════════════════════
@@ -81,6 +106,34 @@ extern "C" {
 #  endif
 #endif
 
+/**
+ * @brief Width of allocation sizes (8, 16 or 32 bits)
+ *
+ * 8 keeps the 2-3 byte block header on AVR and caps requests at 255
+ * bytes; 16 allows MTU-sized buffers; 32 also lifts the 64 KB heap
+ * limit.  Follows mm_kalloc_size_bits unless overridden.
+ */
+#ifndef NK_KALLOC_SIZE_BITS
+#  if defined(CONFIG_MM_KALLOC_SIZE_BITS)
+#    define NK_KALLOC_SIZE_BITS CONFIG_MM_KALLOC_SIZE_BITS
+#  else
+#    define NK_KALLOC_SIZE_BITS 8
+#  endif
+#endif
+
+#if NK_KALLOC_SIZE_BITS == 8
+typedef uint8_t kalloc_size_t;
+#  define KALLOC_SIZE_MAX UINT8_MAX
+#elif NK_KALLOC_SIZE_BITS == 16
+typedef uint16_t kalloc_size_t;
+#  define KALLOC_SIZE_MAX UINT16_MAX
+#elif NK_KALLOC_SIZE_BITS == 32
+typedef uint32_t kalloc_size_t;
+#  define KALLOC_SIZE_MAX UINT32_MAX
+#else
+#  error "NK_KALLOC_SIZE_BITS must be 8, 16 or 32"
+#endif
+
 /**
  * @brief Alignment requirement (bytes)
  *
@@ -97,22 +150,188 @@ extern "C" {
 #endif
 
 /**
- * @brief Enable thread-safe kalloc (future)
- *
- * When enabled, kalloc/kfree will use internal spinlocks.
- * Adds ~50 bytes flash + 1 byte RAM overhead.
+ * @brief Concurrency mode (kalloc_mt.c)
  *
- * @note Not yet implemented. Use external locking for now.
+ * Follows mm_kalloc_concurrency: 'none' (0), 'irq' (1, brief IRQ
+ * masking around the heap) or 'magazine' (2, per-task caches in front
+ * of the locked heap).
  */
+#define NK_KALLOC_LOCK_NONE     0
+#define NK_KALLOC_LOCK_IRQ      1
+#define NK_KALLOC_LOCK_MAGAZINE 2
+
 #ifndef NK_KALLOC_THREAD_SAFE
-#  define NK_KALLOC_THREAD_SAFE 0
+#  if defined(CONFIG_MM_KALLOC_THREAD_SAFE)
+#    define NK_KALLOC_THREAD_SAFE CONFIG_MM_KALLOC_THREAD_SAFE
+#  else
+#    define NK_KALLOC_THREAD_SAFE NK_KALLOC_LOCK_NONE
+#  endif
+#endif
+
+/**
+ * @brief Task ids the allocator tracks one by one
+ *
+ * Sizes the per-task magazines and usage counters; larger ids share the
+ * "no task" slot.  Follows kernel_task_max unless overridden.
+ */
+#ifndef NK_KALLOC_TASKS
+#  if defined(CONFIG_KERNEL_TASK_MAX)
+#    define NK_KALLOC_TASKS CONFIG_KERNEL_TASK_MAX
+#  else
+#    define NK_KALLOC_TASKS 8
+#  endif
+#endif
+
+/**
+ * @brief Magazine geometry (NK_KALLOC_LOCK_MAGAZINE)
+ *
+ * Each task caches up to NK_KALLOC_MAG_DEPTH freed blocks in each of
+ * NK_KALLOC_MAG_CLASSES size classes (8, 16, 32, ... bytes).  Cached
+ * blocks are linked through their own payload, so a magazine costs one
+ * pointer and one count byte per class.
+ */
+#ifndef NK_KALLOC_MAG_CLASSES
+#  define NK_KALLOC_MAG_CLASSES 4
+#endif
+#ifndef NK_KALLOC_MAG_DEPTH
+#  define NK_KALLOC_MAG_DEPTH 4
+#endif
+
+/**
+ * @brief Segregated size-class allocation
+ *
+ * Replaces the first-fit scan with per-class free lists.  Follows
+ * mm_allocator = 'slab' from the build configuration unless overridden.
+ */
+#ifndef NK_KALLOC_SLAB
+#  if defined(CONFIG_MM_KALLOC_SLAB)
+#    define NK_KALLOC_SLAB CONFIG_MM_KALLOC_SLAB
+#  else
+#    define NK_KALLOC_SLAB 0
+#  endif
+#endif
+
+/**
+ * @brief Two-level segregated fit backend (kalloc_tlsf.c)
+ *
+ * Good-fit allocation with immediate boundary-tag coalescing, O(1) for
+ * both kalloc() and kfree().  Follows mm_allocator = 'tlsf'.
+ */
+#ifndef NK_KALLOC_TLSF
+#  if defined(CONFIG_MM_KALLOC_TLSF)
+#    define NK_KALLOC_TLSF CONFIG_MM_KALLOC_TLSF
+#  else
+#    define NK_KALLOC_TLSF 0
+#  endif
+#endif
+
+/**
+ * @brief Heap statistics (kalloc_get_stats)
+ *
+ * Follows mm_kalloc_stats.  Costs a few counter updates per call; the
+ * histogram is only built when statistics are read.
+ */
+#ifndef NK_KALLOC_STATS
+#  if defined(CONFIG_MM_KALLOC_STATS)
+#    define NK_KALLOC_STATS CONFIG_MM_KALLOC_STATS
+#  else
+#    define NK_KALLOC_STATS 0
+#  endif
+#endif
+
+/**
+ * @brief Attribute live bytes to the allocating task
+ *
+ * Adds one owner byte to every block header (two heap offsets in TLSF
+ * mode).  Follows mm_kalloc_task_stats; implies NK_KALLOC_STATS.
+ */
+#ifndef NK_KALLOC_TASK_STATS
+#  if defined(CONFIG_MM_KALLOC_TASK_STATS)
+#    define NK_KALLOC_TASK_STATS CONFIG_MM_KALLOC_TASK_STATS
+#  else
+#    define NK_KALLOC_TASK_STATS 0
+#  endif
+#endif
+
+#if NK_KALLOC_TASK_STATS && !NK_KALLOC_STATS
+#  undef  NK_KALLOC_STATS
+#  define NK_KALLOC_STATS 1
+#endif
+
+/**
+ * @brief Buckets in the free-extent histogram
+ *
+ * Bucket 0 counts extents below 16 bytes, bucket i covers
+ * [8 << i, 16 << i), and the last bucket is open-ended.
+ */
+#ifndef NK_KALLOC_HIST_BINS
+#  define NK_KALLOC_HIST_BINS 8
+#endif
+
+/**
+ * @brief Bytes carved from the heap per slab refill
+ *
+ * Small classes get several blocks per refill; a class whose block is
+ * larger than this is refilled one block at a time.
+ */
+#ifndef NK_KALLOC_SLAB_BYTES
+#  define NK_KALLOC_SLAB_BYTES 64u
+#endif
+
+/**
+ * @brief Heap regions, the static heap included (1 = heap[] only)
+ *
+ * Each extra region costs its backend's free-list heads plus a few
+ * pointers of RAM.  Follows mm_kalloc_regions.
+ */
+#ifndef NK_KALLOC_REGIONS
+#  if defined(CONFIG_MM_KALLOC_REGIONS)
+#    define NK_KALLOC_REGIONS CONFIG_MM_KALLOC_REGIONS
+#  else
+#    define NK_KALLOC_REGIONS 1
+#  endif
+#endif
+
+/**
+ * @brief Add the external RAM bus to the heap in kalloc_init()
+ *
+ * On a HAL with HAL_HAS_XMEM and HAL_XMEM_SIZE set (mm_xmem_kb),
+ * kalloc_init() switches the bus on with hal_xmem_init() and adds what
+ * it reports as a KALLOC_BULK region.  Implies a second region.
+ */
+#ifndef NK_KALLOC_XMEM
+#  if defined(HAL_HAS_XMEM) && HAL_HAS_XMEM
+#    define NK_KALLOC_XMEM (HAL_XMEM_SIZE > 0)
+#  else
+#    define NK_KALLOC_XMEM 0
+#  endif
 #endif
 
+#if NK_KALLOC_XMEM && NK_KALLOC_REGIONS < 2
+#  undef  NK_KALLOC_REGIONS
+#  define NK_KALLOC_REGIONS 2
+#endif
+
+/** Region kinds for kalloc_add_region() and kalloc_hint() */
+#define KALLOC_FAST 0x00    /**< Internal SRAM: TCBs, stacks, ISR data */
+#define KALLOC_BULK 0x01    /**< Bigger, slower RAM: buffers, caches */
+#define KALLOC_ONLY 0x80    /**< kalloc_hint(): no fallback to the other kind */
+
 /* Compile-time validation */
+_Static_assert(NK_KALLOC_REGIONS >= 1 && NK_KALLOC_REGIONS <= 8,
+               "1 to 8 heap regions");
 _Static_assert(NK_HEAP_SIZE >= 64, "heap too small (min 64 bytes)");
-_Static_assert(NK_HEAP_SIZE <= 65535u, "heap too large (max 64K)");
+_Static_assert(NK_KALLOC_SIZE_BITS == 32 || NK_HEAP_SIZE <= 65535u,
+               "heap too large (max 64K unless mm_kalloc_size_bits = 32)");
 _Static_assert((NK_KALLOC_ALIGN & (NK_KALLOC_ALIGN - 1)) == 0,
                "alignment must be power of 2");
+_Static_assert(!(NK_KALLOC_SLAB && NK_KALLOC_TLSF),
+               "choose one kalloc backend");
+_Static_assert(NK_KALLOC_THREAD_SAFE <= NK_KALLOC_LOCK_MAGAZINE,
+               "unknown kalloc concurrency mode");
+_Static_assert(NK_KALLOC_THREAD_SAFE != NK_KALLOC_LOCK_MAGAZINE ||
+               (8u << (NK_KALLOC_MAG_CLASSES - 1)) <= KALLOC_SIZE_MAX,
+               "largest magazine class exceeds KALLOC_SIZE_MAX");
 
 /*═══════════════════════════════════════════════════════════════════
  * PUBLIC API
@@ -134,14 +353,14 @@ void kalloc_init(void);
  * Searches the free-list for a suitable block, or bumps the heap pointer
  * if no freed block is available.
  *
- * @param size Number of bytes to allocate (max 255)
+ * @param size Number of bytes to allocate (max KALLOC_SIZE_MAX)
  * @return Pointer to allocated memory, or NULL if out of memory
  *
  * @note Returned pointer is aligned to NK_KALLOC_ALIGN bytes.
  * @note Actual allocation may be larger due to alignment.
  * @note NOT thread-safe unless NK_KALLOC_THREAD_SAFE is enabled.
  */
-void *kalloc(uint8_t size);
+void *kalloc(kalloc_size_t size);
 
 /**
  * @brief Free previously allocated memory
@@ -156,28 +375,103 @@ void *kalloc(uint8_t size);
  */
 void kfree(void *ptr);
 
+/**
+ * @brief Allocate from a region of the kind @p hint names
+ *
+ * ```c
+ * uint8_t *frame = kalloc_hint(576, KALLOC_BULK);     // XMEM first (16-bit sizes)
+ * nk_tcb_t *tcb = kalloc_hint(sizeof *tcb, KALLOC_FAST | KALLOC_ONLY);
+ * ```
+ *
+ * @param size Number of bytes to allocate (max KALLOC_SIZE_MAX)
+ * @param hint KALLOC_FAST or KALLOC_BULK, optionally | KALLOC_ONLY
+ * @return Pointer to allocated memory, or NULL if no allowed region
+ *         has room
+ */
+void *kalloc_hint(kalloc_size_t size, uint8_t hint);
+
+/**
+ * @brief Add @p len bytes at @p base to the heap as a region of @p kind
+ *
+ * Call after kalloc_init(), which starts over with the static heap
+ * (and the XMEM bus with NK_KALLOC_XMEM).  The memory must not be used
+ * otherwise from then on.  TLSF with 16-bit offsets uses at most the
+ * first 64 KB of a region.
+ *
+ * @param kind KALLOC_FAST or KALLOC_BULK
+ * @return Region index, or -1 if all NK_KALLOC_REGIONS are taken, the
+ *         range is too small or it overlaps a region
+ */
+int kalloc_add_region(void *base, size_t len, uint8_t kind);
+
+/**
+ * @brief Kind of the region @p ptr was allocated from
+ *
+ * @return KALLOC_FAST or KALLOC_BULK, or -1 if @p ptr is in no region
+ */
+int kalloc_kind(const void *ptr);
+
+#if NK_KALLOC_THREAD_SAFE
+/**
+ * @brief Backend entry points behind the locking front end
+ *
+ * With a concurrency mode selected, kalloc.c / kalloc_tlsf.c export
+ * their unlocked kalloc_init/kalloc/kfree under these names and
+ * kalloc_mt.c provides the public ones.
+ */
+#  define NK_KALLOC_ENTRY(fn) fn##_unlocked
+
+void  kalloc_init_unlocked(void);
+void *kalloc_unlocked(kalloc_size_t size);
+void  kfree_unlocked(void *ptr);
+void *kalloc_hint_unlocked(kalloc_size_t size, uint8_t hint);
+int   kalloc_add_region_unlocked(void *base, size_t len, uint8_t kind);
+
+/** Usable bytes of live block @p ptr (backend-specific). */
+size_t kalloc_usable(const void *ptr);
+
+/**
+ * @brief Return task @p tid's cached blocks to the heap
+ *
+ * For a task that has exited (or the caller itself); no-op outside
+ * magazine mode.
+ */
+void kalloc_drain(uint8_t tid);
+#else
+#  define NK_KALLOC_ENTRY(fn) fn
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * DEBUGGING & STATISTICS (optional)
  *═══════════════════════════════════════════════════════════════════*/
 
-#if defined(NK_KALLOC_STATS) && NK_KALLOC_STATS
+#if NK_KALLOC_STATS
 
 /**
  * @brief Heap statistics structure
+ *
+ * used_bytes counts live blocks including their headers and any
+ * rounding, so used_bytes + free_bytes == total_size at all times.
+ * A "free extent" is a free-list block or the untouched heap top.
  */
 typedef struct {
-    uint16_t total_size;      /**< Total heap size (bytes) */
-    uint16_t used_bytes;      /**< Bytes currently allocated */
-    uint16_t free_bytes;      /**< Bytes available (approx) */
-    uint16_t peak_used;       /**< Peak allocation (bytes) */
+    size_t   total_size;      /**< Total heap size (bytes) */
+    size_t   used_bytes;      /**< Bytes held by live blocks */
+    size_t   free_bytes;      /**< Bytes not held by live blocks */
+    size_t   peak_used;       /**< Peak of used_bytes */
+    size_t   largest_free;    /**< Payload of the largest free extent */
     uint8_t  free_blocks;     /**< Number of free-list blocks */
     uint8_t  alloc_count;     /**< Total allocations (wraps at 255) */
     uint8_t  free_count;      /**< Total frees (wraps at 255) */
+    uint8_t  free_hist[NK_KALLOC_HIST_BINS]; /**< Free extents by payload */
 } kalloc_stats_t;
 
 /**
  * @brief Get heap statistics
  *
+ * Covers every region; peak_used is then the sum of the regions'
+ * peaks.
+ *
  * @param[out] stats Pointer to statistics structure to fill
  *
  * @note Only available if NK_KALLOC_STATS is enabled.
@@ -185,11 +479,65 @@ typedef struct {
  */
 void kalloc_get_stats(kalloc_stats_t *stats);
 
+/**
+ * @brief Statistics of one region (0 = the static heap)
+ *
+ * @return Its kind, or -1 if there is no region @p region
+ */
+int kalloc_get_region_stats(uint8_t region, kalloc_stats_t *stats);
+
 /**
  * @brief Reset peak usage counter
  */
 void kalloc_reset_peak(void);
 
+/* Record one free extent of @p bytes payload (shared by the backends). */
+static inline void kalloc_stats_extent(kalloc_stats_t *st, size_t bytes) {
+    uint8_t bin = 0;
+    for (size_t v = bytes >> 4; v && bin < NK_KALLOC_HIST_BINS - 1; v >>= 1) {
+        ++bin;
+    }
+    if (st->free_hist[bin] < UINT8_MAX) st->free_hist[bin]++;
+    if (bytes > st->largest_free) st->largest_free = bytes;
+}
+
+/* Add the statistics of one region to @p sum (shared by the backends). */
+static inline void kalloc_stats_merge(kalloc_stats_t *sum, const kalloc_stats_t *st) {
+    sum->total_size += st->total_size;
+    sum->used_bytes += st->used_bytes;
+    sum->free_bytes += st->free_bytes;
+    sum->peak_used  += st->peak_used;
+    if (st->largest_free > sum->largest_free) sum->largest_free = st->largest_free;
+    sum->free_blocks = (uint8_t)(sum->free_blocks + st->free_blocks < UINT8_MAX
+                                 ? sum->free_blocks + st->free_blocks : UINT8_MAX);
+    sum->alloc_count = (uint8_t)(sum->alloc_count + st->alloc_count);
+    sum->free_count  = (uint8_t)(sum->free_count + st->free_count);
+    for (uint8_t i = 0; i < NK_KALLOC_HIST_BINS; i++) {
+        unsigned n = (unsigned)sum->free_hist[i] + st->free_hist[i];
+        sum->free_hist[i] = (uint8_t)(n < UINT8_MAX ? n : UINT8_MAX);
+    }
+}
+
+#if NK_KALLOC_TASK_STATS
+/* One counter per task plus one for "no task" (boot, ISRs). */
+#define NK_KALLOC_OWNERS (NK_KALLOC_TASKS + 1)
+
+uint8_t nk_current_tid(void);
+
+static inline uint8_t kalloc_owner(void) {
+    uint8_t tid = nk_current_tid();
+    return tid < NK_KALLOC_TASKS ? tid : NK_KALLOC_TASKS;
+}
+
+/**
+ * @brief Live bytes allocated by task @p tid
+ *
+ * Allocations made before the scheduler starts, or from ISRs, are
+ * reported under any @p tid >= NK_KALLOC_TASKS.
+ */
+size_t kalloc_task_used(uint8_t tid);
+#endif
+
 #endif /* NK_KALLOC_STATS */
 
 /*═══════════════════════════════════════════════════════════════════
@@ -204,8 +552,7 @@ void kalloc_reset_peak(void);
  * @param size Number of bytes to allocate
  * @return Pointer to allocated memory, or NULL
  *
- * @note Limited to 255-byte allocations.
- * @note size_t is truncated to uint8_t.
+ * @note Requests above KALLOC_SIZE_MAX fail.
  */
 void *malloc(size_t size);
 
@@ -223,7 +570,7 @@ void free(void *ptr);
  * @param size Size of each element
  * @return Pointer to zero-initialized memory, or NULL
  *
- * @note Limited to 255-byte total allocation.
+ * @note Limited to KALLOC_SIZE_MAX bytes in total.
  */
 void *calloc(size_t nmemb, size_t size);
 
@@ -0,0 +1,223 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file kalloc_mt.c
+ * @brief Concurrency-safe front end for kalloc()/kfree()
+ *
+ * Built when mm_kalloc_concurrency is 'irq' or 'magazine'.  The active
+ * backend (free list, slab or TLSF) exports kalloc_unlocked() and
+ * friends; this file serialises them and, in magazine mode, keeps a
+ * per-task cache of small freed blocks in front of them.
+ *
+ * ## Central lock
+ * IRQs are masked for the duration of one backend call.  With
+ * kernel_smp_cores > 1 a spinlock is taken as well.
+ *
+ * ## Magazines
+ * Requests up to 8 << (NK_KALLOC_MAG_CLASSES - 1) bytes are rounded up
+ * to a power-of-two class.  A task's kfree() of such a block pushes it
+ * onto that task's list for the class (up to NK_KALLOC_MAG_DEPTH), and
+ * its next kalloc() pops it again.  Only the owning task touches its
+ * magazine, so the fast path takes no global lock; interrupts are
+ * masked only for the few instructions of the push or pop.  ISRs
+ * (and code running with IRQs off) always use the central heap.
+ *
+ * Cached blocks still count as used in kalloc_get_stats().  With more
+ * than one heap region only KALLOC_FAST blocks are cached, and only
+ * requests hinted KALLOC_FAST are served from the cache.
+ */
+
+#include "kalloc.h"
+#include <stdbool.h>
+#include <string.h>
+
+#if NK_KALLOC_THREAD_SAFE
+
+#ifndef CONFIG_KERNEL_SMP_CORES
+#  define CONFIG_KERNEL_SMP_CORES 1
+#endif
+
+#if CONFIG_KERNEL_SMP_CORES > 1
+#  include "kernel/sync/spinlock.h"
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * CENTRAL LOCK
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if CONFIG_KERNEL_SMP_CORES > 1
+static nk_spinlock_t kalloc_spin = NK_SPINLOCK_DOMAIN_INIT("kalloc", NK_LOCK_DOM_MM);
+#endif
+
+static inline uint32_t heap_lock(void) {
+    uint32_t s = hal_irq_save();
+#if CONFIG_KERNEL_SMP_CORES > 1
+    nk_spinlock_lock_rt(&kalloc_spin, 0);
+#endif
+    return s;
+}
+
+static inline void heap_unlock(uint32_t s) {
+#if CONFIG_KERNEL_SMP_CORES > 1
+    nk_spinlock_unlock_rt(&kalloc_spin);
+#endif
+    hal_irq_restore(s);
+}
+
+static void *central_alloc(kalloc_size_t size, uint8_t hint) {
+    uint32_t s = heap_lock();
+    void *p = kalloc_hint_unlocked(size, hint);
+    heap_unlock(s);
+    return p;
+}
+
+static void central_free(void *ptr) {
+    uint32_t s = heap_lock();
+    kfree_unlocked(ptr);
+    heap_unlock(s);
+}
+
+#if NK_KALLOC_THREAD_SAFE == NK_KALLOC_LOCK_MAGAZINE
+/*═══════════════════════════════════════════════════════════════════
+ * PER-TASK MAGAZINES
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define MAG_MIN 8u
+#define MAG_MAX (MAG_MIN << (NK_KALLOC_MAG_CLASSES - 1))
+
+_Static_assert(MAG_MIN >= sizeof(void *), "cached blocks hold a link");
+
+typedef struct mag_obj {
+    struct mag_obj *next;
+} mag_obj_t;
+
+typedef struct {
+    mag_obj_t *head;
+    uint8_t    count;
+} mag_t;
+
+static mag_t mags[NK_KALLOC_TASKS][NK_KALLOC_MAG_CLASSES];
+
+uint8_t nk_current_tid(void);
+
+/* Smallest class holding @p size (1..MAG_MAX). */
+static inline uint8_t mag_class(kalloc_size_t size) {
+    uint8_t c = 0;
+    for (kalloc_size_t v = (kalloc_size_t)((size - 1) / MAG_MIN); v; v >>= 1) {
+        ++c;
+    }
+    return c;
+}
+
+/* Magazine of the calling task, or NULL from ISR/boot context. */
+static inline mag_t *my_mags(void) {
+    if (!hal_irq_enabled()) {
+        return NULL;
+    }
+    uint8_t tid = nk_current_tid();
+    return tid < NK_KALLOC_TASKS ? mags[tid] : NULL;
+}
+#endif /* NK_KALLOC_LOCK_MAGAZINE */
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API IMPLEMENTATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+void kalloc_init(void) {
+    uint32_t s = heap_lock();
+#if NK_KALLOC_THREAD_SAFE == NK_KALLOC_LOCK_MAGAZINE
+    memset(mags, 0, sizeof(mags));
+#endif
+    kalloc_init_unlocked();
+    heap_unlock(s);
+}
+
+int kalloc_add_region(void *base, size_t len, uint8_t kind) {
+    uint32_t s = heap_lock();
+    int r = kalloc_add_region_unlocked(base, len, kind);
+    heap_unlock(s);
+    return r;
+}
+
+void *kalloc_hint(kalloc_size_t size, uint8_t hint) {
+#if NK_KALLOC_THREAD_SAFE == NK_KALLOC_LOCK_MAGAZINE
+    if (size && size <= MAG_MAX && !(hint & KALLOC_BULK)) {
+        uint8_t c = mag_class(size);
+        mag_t *m = my_mags();
+        if (m) {
+            uint32_t s = hal_irq_save();
+            mag_obj_t *o = m[c].head;
+            if (o) {
+                m[c].head = o->next;
+                m[c].count--;
+            }
+            hal_irq_restore(s);
+            if (o) {
+                return o;
+            }
+        }
+        size = (kalloc_size_t)(MAG_MIN << c);  /* so it can be cached */
+    }
+#endif
+    return central_alloc(size, hint);
+}
+
+void *kalloc(kalloc_size_t size) {
+    return kalloc_hint(size, KALLOC_FAST);
+}
+
+void kfree(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+
+#if NK_KALLOC_THREAD_SAFE == NK_KALLOC_LOCK_MAGAZINE
+    mag_t *m = my_mags();
+    size_t usable = kalloc_usable(ptr);
+    if (m && usable >= MAG_MIN && usable < 2 * MAG_MAX &&
+        (NK_KALLOC_REGIONS == 1 || kalloc_kind(ptr) == KALLOC_FAST)) {
+        /* Largest class the block satisfies; bigger blocks would waste */
+        uint8_t c = 0;
+        while ((MAG_MIN << (c + 1)) <= usable) {
+            ++c;
+        }
+        if (c < NK_KALLOC_MAG_CLASSES && m[c].count < NK_KALLOC_MAG_DEPTH) {
+            uint32_t s = hal_irq_save();
+            mag_obj_t *o = (mag_obj_t *)ptr;
+            o->next = m[c].head;
+            m[c].head = o;
+            m[c].count++;
+            hal_irq_restore(s);
+            return;
+        }
+    }
+#endif
+    central_free(ptr);
+}
+
+void kalloc_drain(uint8_t tid) {
+#if NK_KALLOC_THREAD_SAFE == NK_KALLOC_LOCK_MAGAZINE
+    if (tid >= NK_KALLOC_TASKS) {
+        return;
+    }
+    for (uint8_t c = 0; c < NK_KALLOC_MAG_CLASSES; ++c) {
+        uint32_t s = hal_irq_save();
+        mag_obj_t *o = mags[tid][c].head;
+        mags[tid][c].head = NULL;
+        mags[tid][c].count = 0;
+        hal_irq_restore(s);
+
+        while (o) {
+            mag_obj_t *next = o->next;
+            central_free(o);
+            o = next;
+        }
+    }
+#else
+    (void)tid;
+#endif
+}
+
+#endif /* NK_KALLOC_THREAD_SAFE */
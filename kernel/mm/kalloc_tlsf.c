@@ -0,0 +1,477 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file kalloc_tlsf.c
+ * @brief Two-Level Segregated Fit backend for kalloc()/kfree()
+ *
+ * Selected with mm_allocator = 'tlsf' (NK_KALLOC_TLSF).  Every block
+ * carries a boundary tag; free blocks are kept in size bins indexed by
+ * a first level (power of two) and a second level (4 linear steps
+ * inside it).  Two bitmaps locate a non-empty bin in constant time.
+ *
+ * ## Block Layout
+ * ```
+ * tlsf_off_t size   total bytes incl. header, bit 0 = free
+ * tlsf_off_t prev   heap offset of the physical predecessor
+ * user data         (free blocks: next/prev free offsets)
+ * ```
+ * All links are heap offsets: 16-bit (4-byte header) unless
+ * mm_kalloc_size_bits = 32, which widens them for heaps above 64 KB.
+ * NK_KALLOC_TASK_STATS adds an owner offset and a spare one.
+ * A zero-size used block at the heap end stops forward coalescing.
+ * Each region (heap[] first, then kalloc_add_region()) has its own bins
+ * and sentinel, with offsets relative to its own base.
+ */
+
+#include "avrix-config.h"
+#include "kalloc.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#if NK_KALLOC_TLSF
+
+/*═══════════════════════════════════════════════════════════════════
+ * PARAMETERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if NK_KALLOC_SIZE_BITS == 32
+typedef uint32_t tlsf_off_t;
+typedef uint32_t tlsf_map_t;
+#  define TLSF_OFF_BITS 32
+#  define TLSF_MAP_ONES 0xFFFFFFFFul
+#  define TLSF_CLZ(x)   __builtin_clzl(x)
+#  define TLSF_CTZ(x)   __builtin_ctzl(x)
+#  define TLSF_CLZ_BITS (sizeof(unsigned long) * 8)
+#else
+typedef uint16_t tlsf_off_t;
+typedef uint16_t tlsf_map_t;
+#  define TLSF_OFF_BITS 16
+#  define TLSF_MAP_ONES 0xFFFFu
+#  define TLSF_CLZ(x)   __builtin_clz(x)
+#  define TLSF_CTZ(x)   __builtin_ctz(x)
+#  define TLSF_CLZ_BITS (sizeof(unsigned) * 8)
+#endif
+
+#define TLSF_GRAN      4u                            /* size granularity */
+#define TLSF_SL_LOG2   2
+#define TLSF_SL_COUNT  (1u << TLSF_SL_LOG2)
+#define TLSF_FL_SHIFT  (TLSF_SL_LOG2 + 2)            /* sizes < 16: level 0 */
+#define TLSF_FL_COUNT  (TLSF_OFF_BITS - TLSF_FL_SHIFT + 1)
+#define TLSF_NIL       ((tlsf_off_t)~(tlsf_off_t)0)
+#define TLSF_FREE      0x0001u
+
+/* Boundary tag: all a used block, or the end sentinel, has room for */
+typedef struct {
+    tlsf_off_t size;              /**< Block bytes | TLSF_FREE */
+    tlsf_off_t prev;              /**< Physical predecessor, or TLSF_NIL */
+#if NK_KALLOC_TASK_STATS
+    tlsf_off_t owner;             /**< Allocating task */
+    tlsf_off_t spare;             /**< Keeps payloads TLSF_GRAN aligned */
+#endif
+} tlsf_tag_t;
+
+typedef struct {
+    tlsf_tag_t tag;
+    tlsf_off_t next_free;         /**< Free blocks only */
+    tlsf_off_t prev_free;         /**< Free blocks only */
+} tlsf_blk_t;
+
+#define TLSF_HDR       sizeof(tlsf_tag_t)               /* boundary tag */
+#define TLSF_MIN       sizeof(tlsf_blk_t)               /* tag + free links */
+
+/*═══════════════════════════════════════════════════════════════════
+ * HEAP STATE
+ *═══════════════════════════════════════════════════════════════════*/
+
+_Static_assert(NK_HEAP_SIZE < TLSF_NIL, "heap offsets must fit tlsf_off_t");
+
+static uint8_t heap[NK_HEAP_SIZE] __attribute__((aligned(4)));
+
+/**
+ * @brief One heap region: its bins and the sentinel at its end
+ *
+ * heap[] is region 0; kalloc_add_region() appends more.  Offsets are
+ * relative to the region's base.
+ */
+typedef struct {
+    uint8_t   *base;
+    tlsf_off_t end;                                 /**< Offset of the sentinel */
+    tlsf_map_t fl_map;                              /**< Non-empty levels */
+    uint8_t    sl_map[TLSF_FL_COUNT];               /**< Non-empty bins */
+    tlsf_off_t head[TLSF_FL_COUNT][TLSF_SL_COUNT];  /**< Bin list heads */
+#if NK_KALLOC_STATS
+    kalloc_stats_t stats;
+#endif
+    uint8_t    kind;                                /**< KALLOC_FAST or KALLOC_BULK */
+} tlsf_t;
+
+static tlsf_t  heaps[NK_KALLOC_REGIONS];
+static uint8_t heap_count;
+
+#if NK_KALLOC_TASK_STATS
+static size_t task_used[NK_KALLOC_OWNERS];
+#endif
+
+static inline tlsf_tag_t *T(const tlsf_t *h, tlsf_off_t off) {
+    return (tlsf_tag_t *)(h->base + off);
+}
+
+static inline tlsf_blk_t *B(const tlsf_t *h, tlsf_off_t off) {
+    return (tlsf_blk_t *)(h->base + off);
+}
+
+static inline tlsf_off_t blk_size(const tlsf_t *h, tlsf_off_t off) {
+    return (tlsf_off_t)(T(h, off)->size & (tlsf_off_t)~TLSF_FREE);
+}
+
+static inline bool blk_free(const tlsf_t *h, tlsf_off_t off) {
+    return T(h, off)->size & TLSF_FREE;
+}
+
+/* Region holding @p ptr; anything outside the others is heap[]. */
+static inline tlsf_t *heap_of(const void *ptr) {
+#if NK_KALLOC_REGIONS > 1
+    const uint8_t *p = (const uint8_t *)ptr;
+    for (uint8_t i = 1; i < heap_count; ++i) {
+        if (p >= heaps[i].base && p < heaps[i].base + heaps[i].end) {
+            return &heaps[i];
+        }
+    }
+#endif
+    (void)ptr;
+    return &heaps[0];
+}
+
+/* Index of the highest set bit; x must be non-zero. */
+static inline uint8_t fls_off(tlsf_off_t x) {
+    return (uint8_t)(TLSF_CLZ_BITS - 1 - TLSF_CLZ(x));
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * BIN MAPPING
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Bin holding blocks of exactly @p size bytes. */
+static void mapping(tlsf_off_t size, uint8_t *fl, uint8_t *sl) {
+    if (size < (1u << TLSF_FL_SHIFT)) {
+        *fl = 0;
+        *sl = (uint8_t)(size / TLSF_GRAN);
+        return;
+    }
+    uint8_t f = fls_off(size);
+    *sl = (uint8_t)((size >> (f - TLSF_SL_LOG2)) & (TLSF_SL_COUNT - 1));
+    *fl = (uint8_t)(f - TLSF_FL_SHIFT + 1);
+}
+
+/* First bin whose every block is at least @p size; false if none. */
+static bool find_bin(const tlsf_t *h, tlsf_off_t size, uint8_t *fl, uint8_t *sl) {
+    if (size >= (1u << TLSF_FL_SHIFT)) {
+        tlsf_off_t round = (tlsf_off_t)(((tlsf_off_t)1 << (fls_off(size) - TLSF_SL_LOG2)) - 1);
+        if (size > TLSF_NIL - round) return false;
+        size = (tlsf_off_t)(size + round);
+    }
+    mapping(size, fl, sl);
+
+    uint8_t m = (uint8_t)(h->sl_map[*fl] & (0xFFu << *sl));
+    if (!m) {
+        tlsf_map_t fm = (tlsf_map_t)(h->fl_map & (TLSF_MAP_ONES << (*fl + 1)));
+        if (!fm) return false;
+        *fl = (uint8_t)TLSF_CTZ(fm);
+        m = h->sl_map[*fl];
+    }
+    *sl = (uint8_t)__builtin_ctz(m);
+    return true;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * FREE LISTS
+ *═══════════════════════════════════════════════════════════════════*/
+
+static void bin_insert(tlsf_t *h, tlsf_off_t off) {
+    uint8_t fl, sl;
+    mapping(blk_size(h, off), &fl, &sl);
+
+    tlsf_off_t n = h->head[fl][sl];
+    B(h, off)->next_free = n;
+    B(h, off)->prev_free = TLSF_NIL;
+    if (n != TLSF_NIL) B(h, n)->prev_free = off;
+    h->head[fl][sl] = off;
+    h->sl_map[fl] |= (uint8_t)(1u << sl);
+    h->fl_map |= (tlsf_map_t)((tlsf_map_t)1 << fl);
+}
+
+static void bin_remove(tlsf_t *h, tlsf_off_t off) {
+    uint8_t fl, sl;
+    mapping(blk_size(h, off), &fl, &sl);
+
+    tlsf_off_t n = B(h, off)->next_free, p = B(h, off)->prev_free;
+    if (n != TLSF_NIL) B(h, n)->prev_free = p;
+    if (p != TLSF_NIL) {
+        B(h, p)->next_free = n;
+        return;
+    }
+    h->head[fl][sl] = n;
+    if (n == TLSF_NIL) {
+        h->sl_map[fl] &= (uint8_t)~(1u << sl);
+        if (!h->sl_map[fl]) h->fl_map &= (tlsf_map_t)~((tlsf_map_t)1 << fl);
+    }
+}
+
+/* Join physical neighbours @p a and @p b (both off the bins) into a. */
+static void merge(tlsf_t *h, tlsf_off_t a, tlsf_off_t b) {
+    tlsf_off_t sz = (tlsf_off_t)(blk_size(h, a) + blk_size(h, b));
+
+    T(h, a)->size = (tlsf_off_t)(sz | TLSF_FREE);
+    T(h, (tlsf_off_t)(a + sz))->prev = a;
+}
+
+/* Start region @p h over @p len bytes at @p base as one free block. */
+static void heap_reset(tlsf_t *h, uint8_t *base, size_t len, uint8_t kind) {
+    memset(h, 0, sizeof(*h));
+    memset(h->head, 0xFF, sizeof(h->head));
+    h->base = base;
+    h->end = (tlsf_off_t)((len - TLSF_HDR) & ~(TLSF_GRAN - 1));
+    h->kind = kind;
+
+    T(h, 0)->size = (tlsf_off_t)(h->end | TLSF_FREE);
+    T(h, 0)->prev = TLSF_NIL;
+    T(h, h->end)->size = 0;                 /* sentinel, never free */
+    T(h, h->end)->prev = 0;
+    bin_insert(h, 0);
+
+#if NK_KALLOC_STATS
+    h->stats.total_size = len;
+    h->stats.free_bytes = len;
+#endif
+}
+
+/* Allocate @p size (> 0) bytes from region @p h, or NULL if it is full. */
+static void *heap_alloc(tlsf_t *h, kalloc_size_t size) {
+    uint32_t want = ((uint32_t)size + TLSF_HDR + TLSF_GRAN - 1) & ~(TLSF_GRAN - 1);
+    if (want > h->end) {
+        return NULL;  /* Larger than the whole region */
+    }
+    tlsf_off_t need = (tlsf_off_t)want;
+    if (need < TLSF_MIN) need = TLSF_MIN;
+
+    uint8_t fl, sl;
+    if (!find_bin(h, need, &fl, &sl)) {
+        return NULL;  /* Out of memory */
+    }
+
+    tlsf_off_t off = h->head[fl][sl];
+    bin_remove(h, off);
+
+    /* Split off the tail if it can stand as a block of its own */
+    tlsf_off_t have = blk_size(h, off);
+    if ((tlsf_off_t)(have - need) >= TLSF_MIN) {
+        tlsf_off_t rest = (tlsf_off_t)(off + need);
+        T(h, rest)->size = (tlsf_off_t)((have - need) | TLSF_FREE);
+        T(h, rest)->prev = off;
+        T(h, (tlsf_off_t)(rest + have - need))->prev = rest;
+        bin_insert(h, rest);
+        have = need;
+    }
+    T(h, off)->size = have;
+
+#if NK_KALLOC_STATS
+    h->stats.alloc_count++;
+    h->stats.used_bytes += have;
+    h->stats.free_bytes -= have;
+    if (h->stats.used_bytes > h->stats.peak_used) {
+        h->stats.peak_used = h->stats.used_bytes;
+    }
+#endif
+#if NK_KALLOC_TASK_STATS
+    T(h, off)->owner = kalloc_owner();
+    task_used[T(h, off)->owner] += have;
+#endif
+
+    return h->base + off + TLSF_HDR;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API IMPLEMENTATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+void NK_KALLOC_ENTRY(kalloc_init)(void) {
+    heap_reset(&heaps[0], heap, NK_HEAP_SIZE, KALLOC_FAST);
+    heap_count = 1;
+#if NK_KALLOC_TASK_STATS
+    memset(task_used, 0, sizeof(task_used));
+#endif
+#if NK_KALLOC_XMEM
+    size_t xlen;
+    void *x = hal_xmem_init(&xlen);
+    if (x) {
+        NK_KALLOC_ENTRY(kalloc_add_region)(x, xlen, KALLOC_BULK);
+    }
+#endif
+}
+
+int NK_KALLOC_ENTRY(kalloc_add_region)(void *base, size_t len, uint8_t kind) {
+#if NK_KALLOC_REGIONS > 1
+    uintptr_t lo = ((uintptr_t)base + 3u) & ~(uintptr_t)3u;
+    uintptr_t hi = (uintptr_t)base + len;
+
+    if (!base || kind > KALLOC_BULK || heap_count >= NK_KALLOC_REGIONS ||
+        hi < (uintptr_t)base || hi <= lo || hi - lo < 2 * TLSF_MIN + TLSF_HDR) {
+        return -1;
+    }
+    if (hi - lo >= TLSF_NIL) {
+        hi = lo + TLSF_NIL - 1;     /* offsets stop there */
+    }
+    for (uint8_t i = 0; i < heap_count; ++i) {
+        uintptr_t b = (uintptr_t)heaps[i].base;
+        if (lo < b + heaps[i].end + TLSF_HDR && hi > b) {
+            return -1;  /* Overlaps region i */
+        }
+    }
+    heap_reset(&heaps[heap_count], (uint8_t *)lo, hi - lo, kind);
+    return heap_count++;
+#else
+    (void)base; (void)len; (void)kind;
+    return -1;
+#endif
+}
+
+void *NK_KALLOC_ENTRY(kalloc_hint)(kalloc_size_t size, uint8_t hint) {
+    if (size == 0) {
+        return NULL;
+    }
+#if NK_KALLOC_REGIONS > 1
+    uint8_t kind = hint & KALLOC_BULK;
+    for (uint8_t pass = 0; pass < 2; ++pass) {
+        for (uint8_t i = 0; i < heap_count; ++i) {
+            if (heaps[i].kind == kind) {
+                void *p = heap_alloc(&heaps[i], size);
+                if (p) return p;
+            }
+        }
+        if (hint & KALLOC_ONLY) break;
+        kind ^= KALLOC_BULK;
+    }
+    return NULL;
+#else
+    /* heap[] is the one region, and fast */
+    if ((hint & (KALLOC_BULK | KALLOC_ONLY)) == (KALLOC_BULK | KALLOC_ONLY)) {
+        return NULL;
+    }
+    return heap_alloc(&heaps[0], size);
+#endif
+}
+
+void *NK_KALLOC_ENTRY(kalloc)(kalloc_size_t size) {
+    return NK_KALLOC_ENTRY(kalloc_hint)(size, KALLOC_FAST);
+}
+
+void NK_KALLOC_ENTRY(kfree)(void *ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    tlsf_t *h = heap_of(ptr);
+    tlsf_off_t off = (tlsf_off_t)((uint8_t *)ptr - h->base - TLSF_HDR);
+
+#if NK_KALLOC_STATS
+    h->stats.free_count++;
+    h->stats.used_bytes -= blk_size(h, off);
+    h->stats.free_bytes += blk_size(h, off);
+#endif
+#if NK_KALLOC_TASK_STATS
+    task_used[T(h, off)->owner] -= blk_size(h, off);
+#endif
+
+    T(h, off)->size |= TLSF_FREE;
+
+    tlsf_off_t nx = (tlsf_off_t)(off + blk_size(h, off));
+    if (blk_free(h, nx)) {
+        bin_remove(h, nx);
+        merge(h, off, nx);
+    }
+
+    tlsf_off_t pv = T(h, off)->prev;
+    if (pv != TLSF_NIL && blk_free(h, pv)) {
+        bin_remove(h, pv);
+        merge(h, pv, off);
+        off = pv;
+    }
+    bin_insert(h, off);
+}
+
+int kalloc_kind(const void *ptr) {
+    const uint8_t *p = (const uint8_t *)ptr;
+    for (uint8_t i = 0; i < heap_count; ++i) {
+        if (p >= heaps[i].base && p < heaps[i].base + heaps[i].end) {
+            return heaps[i].kind;
+        }
+    }
+    return -1;
+}
+
+#if NK_KALLOC_THREAD_SAFE
+size_t kalloc_usable(const void *ptr) {
+    const tlsf_t *h = heap_of(ptr);
+    tlsf_off_t off = (tlsf_off_t)((const uint8_t *)ptr - h->base - TLSF_HDR);
+    return (size_t)(blk_size(h, off) - TLSF_HDR);
+}
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * DEBUGGING & STATISTICS
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if NK_KALLOC_STATS
+
+void kalloc_get_stats(kalloc_stats_t *out) {
+    if (!out) {
+        return;
+    }
+
+    memset(out, 0, sizeof(*out));
+    for (uint8_t i = 0; i < heap_count; ++i) {
+        kalloc_stats_t one;
+        kalloc_get_region_stats(i, &one);
+        kalloc_stats_merge(out, &one);
+    }
+}
+
+int kalloc_get_region_stats(uint8_t region, kalloc_stats_t *out) {
+    if (region >= heap_count || !out) {
+        return -1;
+    }
+    const tlsf_t *h = &heaps[region];
+
+    *out = h->stats;
+
+    /* Walk the physical block chain (O(n)) */
+    memset(out->free_hist, 0, sizeof(out->free_hist));
+    out->largest_free = 0;
+    uint8_t free_count = 0;
+    for (tlsf_off_t off = 0; off < h->end; off = (tlsf_off_t)(off + blk_size(h, off))) {
+        if (!blk_free(h, off)) continue;
+        kalloc_stats_extent(out, blk_size(h, off) - TLSF_HDR);
+        if (free_count < 255) free_count++;
+    }
+    out->free_blocks = free_count;
+    return h->kind;
+}
+
+void kalloc_reset_peak(void) {
+    for (uint8_t i = 0; i < heap_count; ++i) {
+        heaps[i].stats.peak_used = heaps[i].stats.used_bytes;
+    }
+}
+
+#if NK_KALLOC_TASK_STATS
+size_t kalloc_task_used(uint8_t tid) {
+    return task_used[tid < NK_KALLOC_TASKS ? tid : NK_KALLOC_TASKS];
+}
+#endif
+
+#endif /* NK_KALLOC_STATS */
+
+#endif /* NK_KALLOC_TLSF */
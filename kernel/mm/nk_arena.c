@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_arena.c
+ * @brief Bump-pointer arenas (see include/nk_arena.h)
+ */
+
+#include "nk_arena.h"
+#include "kalloc.h"
+
+void nk_arena_init(nk_arena_t *a, void *buf, size_t size) {
+    a->base = (uint8_t *)buf;
+    a->size = buf ? size : 0;
+    a->top = 0;
+    a->peak = 0;
+    a->block = NULL;
+}
+
+/* kalloc() only promises NK_KALLOC_ALIGN: ask for the slack and align */
+bool nk_arena_init_heap(nk_arena_t *a, size_t size) {
+    const size_t slack = NK_ARENA_ALIGN - 1;
+    void *blk = (size && size <= KALLOC_SIZE_MAX - slack)
+                    ? kalloc((kalloc_size_t)(size + slack)) : NULL;
+
+    if (!blk) {
+        nk_arena_init(a, NULL, 0);
+        return false;
+    }
+    nk_arena_init(a, (uint8_t *)blk + (-(uintptr_t)blk & slack), size);
+    a->block = blk;
+    return true;
+}
+
+void nk_arena_destroy(nk_arena_t *a) {
+    if (a->block) {
+        kfree(a->block);
+    }
+    nk_arena_init(a, NULL, 0);
+}
+
+void *nk_arena_alloc(nk_arena_t *a, size_t size) {
+    uintptr_t at = (uintptr_t)(a->base + a->top);
+    size_t pad = (size_t)(-at & (NK_ARENA_ALIGN - 1));
+
+    if (size == 0 || pad > a->size - a->top || size > a->size - a->top - pad) {
+        return NULL;
+    }
+
+    void *p = a->base + a->top + pad;
+    a->top += pad + size;
+    if (a->top > a->peak) {
+        a->peak = a->top;
+    }
+    return p;
+}
@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_pool.c
+ * @brief Fixed-size object pools (see include/nk_pool.h)
+ */
+
+#include "nk_pool.h"
+#include "arch/common/hal.h"
+#include <stddef.h>
+#include <string.h>
+
+/*═══════════════════════════════════════════════════════════════════
+ * MAP HELPERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Bits of map byte @p i that correspond to real slots. */
+static inline uint8_t valid_bits(const nk_pool_t *p, uint8_t i) {
+    uint8_t left = (uint8_t)(p->count - i * 8u);
+    return left >= 8 ? 0xFFu : (uint8_t)((1u << left) - 1u);
+}
+
+/* Set (or clear) @p bit in map byte @p i; false if it already was. */
+static bool map_update(const nk_pool_t *p, uint8_t i, uint8_t bit, bool set) {
+    volatile uint8_t *b = &p->map[i];
+
+    if (p->flags & NK_POOL_ISR) {
+        /* Setting a set bit (or clearing a clear one) is a no-op */
+        uint8_t old = set ? hal_atomic_fetch_or_u8(b, bit)
+                          : hal_atomic_fetch_and_u8(b, (uint8_t)~bit);
+        return !(old & bit) == set;
+    }
+
+    if (!(*b & bit) != set) return false;
+    *b = set ? (uint8_t)(*b | bit) : (uint8_t)(*b & ~bit);
+    return true;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API IMPLEMENTATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+void *nk_pool_alloc(const nk_pool_t *p) {
+    uint8_t bytes = (uint8_t)((p->count + 7u) / 8u);
+
+    for (uint8_t i = 0; i < bytes; ++i) {
+        uint8_t freeb;
+        /* Retry the byte if an ISR took our bit between scan and claim */
+        while ((freeb = (uint8_t)(~p->map[i] & valid_bits(p, i))) != 0) {
+            uint8_t bit = (uint8_t)(freeb & -freeb);
+            if (map_update(p, i, bit, true)) {
+                uint8_t idx = (uint8_t)(i * 8u + (uint8_t)__builtin_ctz(bit));
+                return p->slots + (size_t)idx * p->stride;
+            }
+        }
+    }
+    return NULL;
+}
+
+bool nk_pool_free(const nk_pool_t *p, void *obj) {
+    int idx = nk_pool_index(p, obj);
+    if (idx < 0) {
+        return false;
+    }
+    return map_update(p, (uint8_t)(idx / 8), (uint8_t)(1u << (idx % 8)), false);
+}
+
+void nk_pool_reset(const nk_pool_t *p) {
+    uint8_t bytes = (uint8_t)((p->count + 7u) / 8u);
+    for (uint8_t i = 0; i < bytes; ++i) {
+        p->map[i] = 0;
+    }
+}
+
+int nk_pool_index(const nk_pool_t *p, const void *obj) {
+    const uint8_t *o = (const uint8_t *)obj;
+    if (!o || o < p->slots) {
+        return -1;
+    }
+
+    size_t off = (size_t)(o - p->slots);
+    if (off % p->stride || off / p->stride >= p->count) {
+        return -1;
+    }
+    return (int)(off / p->stride);
+}
+
+void *nk_pool_at(const nk_pool_t *p, int idx) {
+    if (idx < 0 || idx >= p->count) {
+        return NULL;
+    }
+    if (!(p->map[idx / 8] & (1u << (idx % 8)))) {
+        return NULL;
+    }
+    return p->slots + (size_t)idx * p->stride;
+}
+
+uint8_t nk_pool_used(const nk_pool_t *p) {
+    uint8_t bytes = (uint8_t)((p->count + 7u) / 8u);
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < bytes; ++i) {
+        n = (uint8_t)(n + __builtin_popcount(p->map[i]));
+    }
+    return n;
+}
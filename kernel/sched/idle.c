@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file idle.c
+ * @brief Idle Governor (sleep-level selection)
+ */
+
+#include "idle.h"
+
+#if NK_IDLE_GOVERNOR
+
+static struct {
+    volatile uint8_t  holds[HAL_SLEEP_LEVELS];  /**< Active holds per level */
+    volatile uint16_t latency_us;               /**< Exit latency bound */
+    uint32_t          count[HAL_SLEEP_LEVELS];  /**< Periods per level */
+} nk_idle = { .latency_us = UINT16_MAX };
+
+void nk_idle_hold(hal_sleep_t level) {
+    if ((unsigned)level >= HAL_SLEEP_LEVELS) return;
+    uint32_t s = hal_irq_save();
+    if (nk_idle.holds[level] != UINT8_MAX) nk_idle.holds[level]++;
+    hal_irq_restore(s);
+}
+
+void nk_idle_release(hal_sleep_t level) {
+    if ((unsigned)level >= HAL_SLEEP_LEVELS) return;
+    uint32_t s = hal_irq_save();
+    if (nk_idle.holds[level]) nk_idle.holds[level]--;
+    hal_irq_restore(s);
+}
+
+void nk_idle_set_latency(uint16_t us) {
+    nk_idle.latency_us = us;
+}
+
+hal_sleep_t nk_idle_select(const hal_sleep_info_t *tab, uint16_t ticks) {
+    uint8_t ceil = HAL_SLEEP_LEVELS - 1;
+
+    /* The shallowest held level caps the search */
+    for (uint8_t l = 0; l < HAL_SLEEP_LEVELS; ++l) {
+        if (nk_idle.holds[l]) {
+            ceil = l;
+            break;
+        }
+    }
+
+    for (uint8_t l = ceil; l > HAL_SLEEP_IDLE; --l) {
+        const hal_sleep_info_t *i = &tab[l];
+        if (i->flags & HAL_SLEEP_F_NONE) continue;
+        if (i->exit_us > nk_idle.latency_us) continue;
+        if (ticks != NK_IDLE_FOREVER &&
+            (!(i->flags & HAL_SLEEP_F_TIMED) || ticks < i->min_ticks)) {
+            continue;
+        }
+        return (hal_sleep_t)l;
+    }
+    return HAL_SLEEP_IDLE;
+}
+
+void nk_idle_enter(uint16_t ticks) {
+    hal_sleep_t l = nk_idle_select(hal_sleep_info(), ticks);
+    nk_idle.count[l]++;
+    if (l == HAL_SLEEP_IDLE) {
+        hal_idle();
+    } else {
+        hal_sleep(l);
+    }
+}
+
+uint32_t nk_idle_count(hal_sleep_t level) {
+    return (unsigned)level < HAL_SLEEP_LEVELS ? nk_idle.count[level] : 0;
+}
+
+#endif /* NK_IDLE_GOVERNOR */
@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file idle.h
+ * @brief Idle Governor (sleep-level selection)
+ *
+ * When nothing is runnable the scheduler asks the governor how deep to
+ * sleep instead of always taking hal_idle().  It walks the HAL's level
+ * table (hal_sleep_info()) from the deepest level up and takes the first
+ * one that
+ *
+ * - no active peripheral forbids: a driver with work in flight calls
+ *   nk_idle_hold() with the deepest level it survives (an interrupt-
+ *   driven UART TX holds HAL_SLEEP_IDLE, its clock stops below that);
+ * - wakes within the latency bound set by nk_idle_set_latency();
+ * - keeps the tick or one-shot running if a deadline is pending, and
+ *   is worth entering for that long (min_ticks).
+ *
+ * A level without a timed wake-up is only picked when nothing is due at
+ * all, so in tickless mode with no sleepers and no armed timers the part
+ * goes to power-down / deep sleep and only an external event wakes it.
+ * nk_ticks() does not advance across such a sleep.
+ * In periodic-tick mode the next deadline is always one tick away, so
+ * the governor never leaves HAL_SLEEP_IDLE.
+ */
+
+#ifndef KERNEL_IDLE_H
+#define KERNEL_IDLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "arch/common/hal.h"
+#include "avrix-config.h"
+
+#ifndef NK_IDLE_GOVERNOR
+#  if defined(CONFIG_KERNEL_IDLE_GOVERNOR)
+#    define NK_IDLE_GOVERNOR CONFIG_KERNEL_IDLE_GOVERNOR
+#  else
+#    define NK_IDLE_GOVERNOR 0
+#  endif
+#endif
+
+/** Ticks value meaning "no deadline pending" */
+#define NK_IDLE_FOREVER UINT16_MAX
+
+#if NK_IDLE_GOVERNOR
+
+/**
+ * @brief Forbid sleeping deeper than @p level (ISR-safe, counted)
+ *
+ * Every hold needs a matching nk_idle_release() with the same level.
+ */
+void nk_idle_hold(hal_sleep_t level);
+
+/**
+ * @brief Drop a hold taken with nk_idle_hold()
+ */
+void nk_idle_release(hal_sleep_t level);
+
+/**
+ * @brief Bound the wake-up latency of any level chosen from now on
+ *
+ * @param us Worst acceptable exit latency (UINT16_MAX = no bound)
+ */
+void nk_idle_set_latency(uint16_t us);
+
+/**
+ * @brief Pick a level from @p tab for an idle period of @p ticks
+ *
+ * Pure policy: reads the holds and the latency bound, touches no
+ * hardware.
+ *
+ * @param tab   HAL_SLEEP_LEVELS entries (normally hal_sleep_info())
+ * @param ticks Ticks to the next deadline, or NK_IDLE_FOREVER
+ * @return Deepest admissible level (HAL_SLEEP_IDLE at worst)
+ */
+hal_sleep_t nk_idle_select(const hal_sleep_info_t *tab, uint16_t ticks);
+
+/**
+ * @brief Sleep at the level nk_idle_select() picks for this part
+ *
+ * Same contract as hal_idle(): returns after the next interrupt.
+ *
+ * @param ticks Ticks to the next deadline, or NK_IDLE_FOREVER
+ */
+void nk_idle_enter(uint16_t ticks);
+
+/**
+ * @brief Idle periods spent at @p level since boot
+ */
+uint32_t nk_idle_count(hal_sleep_t level);
+
+#else
+
+static inline void nk_idle_hold(hal_sleep_t level) { (void)level; }
+static inline void nk_idle_release(hal_sleep_t level) { (void)level; }
+static inline void nk_idle_set_latency(uint16_t us) { (void)us; }
+static inline hal_sleep_t nk_idle_select(const hal_sleep_info_t *tab,
+                                         uint16_t ticks) {
+    (void)tab; (void)ticks;
+    return HAL_SLEEP_IDLE;
+}
+static inline void nk_idle_enter(uint16_t ticks) { (void)ticks; hal_idle(); }
+static inline uint32_t nk_idle_count(hal_sleep_t level) { (void)level; return 0; }
+
+#endif /* NK_IDLE_GOVERNOR */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_IDLE_H */
@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file ktimer.c
+ * @brief Kernel Software Timers (delta list)
+ */
+
+#include "ktimer.h"
+#include "scheduler.h"
+#include "arch/common/hal.h"
+#include "kernel/sync/nk_trace.h"
+#include <stddef.h>
+
+static nk_timer_t *nk_timers;   /**< Delta-list head */
+
+static void timer_insert(nk_timer_t *t, uint16_t ticks) {
+    nk_timer_t **link = &nk_timers;
+
+    while (*link && (*link)->delta <= ticks) {
+        ticks -= (*link)->delta;
+        link = &(*link)->next;
+    }
+    t->delta = ticks;
+    t->next = *link;
+    if (*link) (*link)->delta -= ticks;
+    *link = t;
+    t->armed = 1;
+}
+
+static bool timer_unlink(nk_timer_t *t) {
+    for (nk_timer_t **link = &nk_timers; *link; link = &(*link)->next) {
+        if (*link == t) {
+            *link = t->next;
+            if (t->next) t->next->delta += t->delta;
+            t->armed = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void nk_timer_init(nk_timer_t *t, nk_work_fn fn, void *arg) {
+    if (!t) return;
+    t->next = NULL;
+    t->delta = 0;
+    t->period = 0;
+    t->fn = fn;
+    t->arg = arg;
+    t->armed = 0;
+}
+
+bool nk_timer_start(nk_timer_t *t, uint16_t delay, uint16_t period) {
+    if (!t || !t->fn || !delay) return false;
+
+    uint32_t s = nk_sched_lock();
+    if (t->armed) timer_unlink(t);
+    t->period = period;
+    timer_insert(t, delay);
+    nk_sched_unlock(s);
+    return true;
+}
+
+bool nk_timer_stop(nk_timer_t *t) {
+    if (!t) return false;
+
+    uint32_t s = nk_sched_lock();
+    bool was = t->armed && timer_unlink(t);
+    nk_sched_unlock(s);
+    return was;
+}
+
+void nk_timer_advance(uint16_t ticks) {
+    while (nk_timers) {
+        nk_timer_t *t = nk_timers;
+        if (t->delta > ticks) {
+            t->delta -= ticks;
+            return;
+        }
+        ticks -= t->delta;
+        nk_timers = t->next;
+        t->armed = 0;
+
+        nk_trace_timer(t);
+        nk_work_post(t->fn, t->arg);
+        if (t->period) timer_insert(t, t->period);
+    }
+}
+
+uint16_t nk_timer_next(void) {
+    return nk_timers ? nk_timers->delta : UINT16_MAX;
+}
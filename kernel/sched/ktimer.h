@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file ktimer.h
+ * @brief Kernel Software Timers
+ *
+ * One-shot and periodic callback timers kept in a delta list, the same
+ * structure as the scheduler's sleep queue, and advanced from the system
+ * tick.  Expired callbacks are handed to the deferred work queue, so they
+ * run in task context rather than inside the tick ISR.  A single worker
+ * task replaces one polling task (and stack) per periodic job.
+ */
+
+#ifndef KERNEL_KTIMER_H
+#define KERNEL_KTIMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "workq.h"
+
+/**
+ * @brief Software timer (caller-allocated)
+ */
+typedef struct nk_timer {
+    struct nk_timer *next;      /**< Delta-list link */
+    uint16_t   delta;           /**< Ticks after previous timer */
+    uint16_t   period;          /**< Reload in ticks (0 = one-shot) */
+    nk_work_fn fn;              /**< Callback (deferred context) */
+    void      *arg;             /**< Callback argument */
+    uint8_t    armed;           /**< Non-zero while queued */
+} nk_timer_t;
+
+/**
+ * @brief Initialize a timer
+ *
+ * @param t   Timer object
+ * @param fn  Callback, run from the deferred work queue on expiry
+ * @param arg Callback argument
+ */
+void nk_timer_init(nk_timer_t *t, nk_work_fn fn, void *arg);
+
+/**
+ * @brief Arm (or re-arm) a timer
+ *
+ * @param t      Timer object
+ * @param delay  Ticks until first expiry (>= 1)
+ * @param period Reload interval in ticks, or 0 for one-shot
+ * @return true on success, false if delay is 0 or t is invalid
+ */
+bool nk_timer_start(nk_timer_t *t, uint16_t delay, uint16_t period);
+
+/**
+ * @brief Disarm a timer
+ *
+ * @param t Timer object
+ * @return true if the timer was armed
+ */
+bool nk_timer_stop(nk_timer_t *t);
+
+/**
+ * @brief Advance all timers by @p ticks (called from the system tick)
+ */
+void nk_timer_advance(uint16_t ticks);
+
+/**
+ * @brief Ticks until the earliest armed timer expires
+ *
+ * @return Ticks to next expiry, or UINT16_MAX if none is armed
+ */
+uint16_t nk_timer_next(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_KTIMER_H */
@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_boot.c
+ * @brief Init registry and boot timestamps
+ *
+ * One singly linked list, kept sorted by prio at insertion, holds every
+ * kind of item; the runners skip the kinds they do not own.  Boot code
+ * registers a handful of items, so the O(n) walks cost less than
+ * separate lists would in RAM.  An item is claimed by moving it to
+ * NK_BOOT_RUNNING under the scheduler lock, so two tasks reaching a
+ * lazy item together run it once.
+ */
+
+#include "nk_boot.h"
+#include "scheduler.h"
+#include "arch/common/hal.h"
+
+static nk_boot_item_t *boot_items;
+
+#if NK_BOOT_PROF
+nk_boot_log_t nk_boot_log;
+#endif
+
+void nk_boot_register(nk_boot_item_t *it) {
+    uint32_t s = nk_sched_lock();
+    nk_boot_item_t **pp = &boot_items;
+    for (nk_boot_item_t *p = boot_items; p; p = p->next) {
+        if (p == it) {
+            nk_sched_unlock(s);
+            return;
+        }
+    }
+    while (*pp && (*pp)->prio <= it->prio)
+        pp = &(*pp)->next;
+    it->next = *pp;
+    *pp = it;
+    nk_sched_unlock(s);
+}
+
+/* Claim a pending (or failed) item; false if it is done or running. */
+static bool claim(nk_boot_item_t *it) {
+    uint32_t s = nk_sched_lock();
+    bool mine = it->state == NK_BOOT_PENDING || it->state == NK_BOOT_FAILED;
+    if (mine)
+        it->state = NK_BOOT_RUNNING;
+    nk_sched_unlock(s);
+    return mine;
+}
+
+static bool run_item(nk_boot_item_t *it) {
+    uint32_t t0 = hal_cycles();
+    bool ok = it->fn();
+    it->cycles = hal_cycles() - t0;
+    hal_memory_barrier();
+    it->state = ok ? NK_BOOT_DONE : NK_BOOT_FAILED;
+    return ok;
+}
+
+uint8_t nk_boot_run(void) {
+    uint8_t failed = 0;
+    for (nk_boot_item_t *it = boot_items; it; it = it->next) {
+        if (it->when == NK_BOOT_EAGER && it->state == NK_BOOT_PENDING &&
+            claim(it) && !run_item(it))
+            failed++;
+    }
+    return failed;
+}
+
+bool nk_boot_step(void) {
+    nk_boot_item_t *it = boot_items;
+    for (; it; it = it->next) {
+        if (it->when == NK_BOOT_BACKGROUND && it->state == NK_BOOT_PENDING &&
+            claim(it))
+            break;
+    }
+    if (!it)
+        return false;
+    run_item(it);
+    for (it = it->next; it; it = it->next) {
+        if (it->when == NK_BOOT_BACKGROUND && it->state == NK_BOOT_PENDING)
+            return true;
+    }
+    return false;
+}
+
+bool nk_boot_need_slow(nk_boot_item_t *it) {
+    while (!claim(it)) {
+        if (it->state == NK_BOOT_DONE)
+            return true;
+        nk_yield();                     /* another task is running it */
+    }
+    return run_item(it);
+}
+
+#if NK_BOOT_PROF
+void nk_boot_mark(uint8_t phase) {
+    uint8_t n = nk_boot_log.n;
+    if (n < NK_BOOT_MARKS) {
+        nk_boot_log.mark[n].phase  = phase;
+        nk_boot_log.mark[n].cycles = hal_cycles();
+    }
+    if (n < UINT8_MAX)
+        nk_boot_log.n = (uint8_t)(n + 1);
+}
+
+const nk_boot_mark_t *nk_boot_marks(uint8_t *n) {
+    *n = nk_boot_log.n < NK_BOOT_MARKS ? nk_boot_log.n : NK_BOOT_MARKS;
+    return nk_boot_log.mark;
+}
+#endif
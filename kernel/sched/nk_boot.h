@@ -0,0 +1,182 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_boot.h
+ * @brief Init registry (eager / background / lazy) and boot timestamps
+ *
+ * A duty-cycled node runs main() on every wake from power-down, so
+ * whatever it initialises before the scheduler starts is paid each
+ * time.  Subsystems describe their setup as an nk_boot_item_t instead
+ * of being called in a fixed sequence, and say when it has to happen:
+ *
+ *   NK_BOOT_EAGER       nk_boot_run(), before the scheduler starts
+ *   NK_BOOT_BACKGROUND  nk_boot_step() from a task once things run
+ *   NK_BOOT_LAZY        the first nk_boot_need() on it
+ *
+ * Items of one kind run in ascending prio, registration order among
+ * equals.  Every item runs at most once successfully; nk_boot_need()
+ * also pulls a background item forward, and retries one that failed:
+ *
+ * ```c
+ * static bool mount_eep(void) { return vfs_mount(VFS_TYPE_EEPFS, "/eep") == 0; }
+ * static nk_boot_item_t eep_init = NK_BOOT_ITEM(mount_eep, 50, NK_BOOT_LAZY);
+ *
+ * nk_boot_register(&eep_init);        // at boot: costs nothing yet
+ * ...
+ * if (nk_boot_need(&eep_init))        // first use mounts, later ones
+ *     fd = vfs_open("/eep/cfg", 0);   // are one byte compare
+ * ```
+ *
+ * Each item records the hal_cycles() its function took.  With
+ * NK_BOOT_PROF (-Ddebug_boot_prof=true) nk_boot_mark() also stamps
+ * numbered phases of main() into nk_boot_log, which a debugger reads by
+ * name; without it the marks compile away.  Timestamps are only
+ * meaningful once hal_init() has started the cycle counter.
+ */
+
+#ifndef KERNEL_NK_BOOT_H
+#define KERNEL_NK_BOOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "avrix-config.h"
+
+#ifndef NK_BOOT_PROF
+#  if defined(CONFIG_DEBUG_BOOT_PROF)
+#    define NK_BOOT_PROF CONFIG_DEBUG_BOOT_PROF
+#  else
+#    define NK_BOOT_PROF 0
+#  endif
+#endif
+
+/** Phase stamps kept by nk_boot_mark() (5 bytes of RAM each) */
+#ifndef NK_BOOT_MARKS
+#  define NK_BOOT_MARKS 8
+#endif
+
+/** When an item runs */
+typedef enum {
+    NK_BOOT_EAGER = 0,
+    NK_BOOT_BACKGROUND,
+    NK_BOOT_LAZY
+} nk_boot_when_t;
+
+/** nk_boot_item_t.state */
+enum {
+    NK_BOOT_PENDING = 0,
+    NK_BOOT_RUNNING,
+    NK_BOOT_DONE,
+    NK_BOOT_FAILED
+};
+
+/** Init function; false when it failed (the item may be retried) */
+typedef bool (*nk_boot_fn)(void);
+
+/** One registered initialisation; static storage, owned by the caller */
+typedef struct nk_boot_item {
+    nk_boot_fn            fn;
+    uint8_t               prio;     /**< Lower runs first */
+    uint8_t               when;     /**< nk_boot_when_t */
+    volatile uint8_t      state;    /**< NK_BOOT_PENDING ... */
+    uint32_t              cycles;   /**< hal_cycles() spent in fn */
+    struct nk_boot_item  *next;
+} nk_boot_item_t;
+
+/** Static initialiser for an nk_boot_item_t */
+#define NK_BOOT_ITEM(fn_, prio_, when_) \
+    { .fn = (fn_), .prio = (prio_), .when = (when_) }
+
+/**
+ * @brief Add @p it to the registry
+ *
+ * Registering an item twice is a no-op.  Safe before the scheduler
+ * runs; afterwards lazy and background items may still be added.
+ */
+void nk_boot_register(nk_boot_item_t *it);
+
+/**
+ * @brief Run every pending eager item, in priority order
+ *
+ * Called once from main() before the scheduler starts.
+ *
+ * @return Number of items that failed
+ */
+uint8_t nk_boot_run(void);
+
+/**
+ * @brief Run the next pending background item
+ *
+ * Bounded work for an idle or low-priority task:
+ * `while (nk_boot_step()) nk_yield();`
+ *
+ * @return true if background items remain
+ */
+bool nk_boot_step(void);
+
+/** Slow path of nk_boot_need() */
+bool nk_boot_need_slow(nk_boot_item_t *it);
+
+/**
+ * @brief Make sure @p it has run, running it now if needed
+ *
+ * Waits (yielding) while another task is inside the same item.  An
+ * item's own function may need other items but not itself.
+ *
+ * @return true once the item completed successfully
+ */
+static inline bool nk_boot_need(nk_boot_item_t *it) {
+    return it->state == NK_BOOT_DONE || nk_boot_need_slow(it);
+}
+
+/** One nk_boot_mark() stamp */
+typedef struct {
+    uint8_t  phase;                 /**< Caller-chosen phase number */
+    uint32_t cycles;                /**< hal_cycles() when it was reached */
+} nk_boot_mark_t;
+
+/** The stamps, as a debugger finds them */
+typedef struct {
+    uint8_t        n;               /**< Stamps taken (may exceed NK_BOOT_MARKS) */
+    nk_boot_mark_t mark[NK_BOOT_MARKS];
+} nk_boot_log_t;
+
+#if NK_BOOT_PROF
+
+extern nk_boot_log_t nk_boot_log;
+
+/**
+ * @brief Stamp the start of boot phase @p phase
+ *
+ * The time a phase took is the next stamp minus this one.  Stamps past
+ * NK_BOOT_MARKS are counted but not kept.
+ */
+void nk_boot_mark(uint8_t phase);
+
+/**
+ * @brief The stamps taken so far
+ *
+ * @param n Receives how many are valid
+ */
+const nk_boot_mark_t *nk_boot_marks(uint8_t *n);
+
+#else
+
+static inline void nk_boot_mark(uint8_t phase) { (void)phase; }
+static inline const nk_boot_mark_t *nk_boot_marks(uint8_t *n) {
+    *n = 0;
+    return (const nk_boot_mark_t *)0;
+}
+
+#endif /* NK_BOOT_PROF */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_NK_BOOT_H */
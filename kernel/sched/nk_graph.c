@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_graph.c
+ * @brief Dataflow task graph executor
+ *
+ * Everything that changes during a pass (the counters, the ready list,
+ * `left`) is touched under nk_sched_lock(), never while a node runs.
+ * Each node is released exactly once per pass, so the ready list needs
+ * n slots and no wrap-around: start resets both of its ends.
+ */
+
+#include "nk_graph.h"
+
+/* Predecessor counts from the edge lists; false on a bad index */
+static bool count_preds(nk_graph_t *g) {
+    for (uint8_t i = 0; i < g->n; i++) {
+        g->pending[i] = 0;
+    }
+    for (uint8_t i = 0; i < g->n; i++) {
+        const nk_graph_node_t *nd = &g->node[i];
+        for (uint8_t e = 0; e < nd->nsucc; e++) {
+            if (nd->succ[e] >= g->n) return false;
+            g->pending[nd->succ[e]]++;
+        }
+    }
+    return true;
+}
+
+/* List @p id as ready; caller holds the scheduler lock */
+static void release(nk_graph_t *g, uint8_t id) {
+    g->ready[g->head++] = id;
+    nk_waitq_wake_one(&g->work);
+}
+
+bool nk_graph_init(nk_graph_t *g) {
+    g->valid = false;
+    g->left = 0;
+    g->head = g->tail = 0;
+    if (!g->n || !count_preds(g)) return false;
+
+    /* Kahn's algorithm on the ready list: all nodes drain iff acyclic */
+    for (uint8_t i = 0; i < g->n; i++) {
+        if (g->pending[i] == 0) g->ready[g->head++] = i;
+    }
+    while (g->tail != g->head) {
+        const nk_graph_node_t *nd = &g->node[g->ready[g->tail++]];
+        for (uint8_t e = 0; e < nd->nsucc; e++) {
+            if (--g->pending[nd->succ[e]] == 0) g->ready[g->head++] = nd->succ[e];
+        }
+    }
+    g->valid = g->head == g->n;
+    g->head = g->tail = 0;
+    return g->valid;
+}
+
+bool nk_graph_start(nk_graph_t *g) {
+    uint32_t s = nk_sched_lock();
+    if (!g->valid || g->left) {
+        if (g->valid) g->overruns++;
+        nk_sched_unlock(s);
+        return false;
+    }
+    count_preds(g);
+    g->head = g->tail = 0;
+    g->left = g->n;
+    for (uint8_t i = 0; i < g->n; i++) {
+        if (g->pending[i] == 0) release(g, i);
+    }
+    nk_sched_unlock(s);
+    return true;
+}
+
+bool nk_graph_step(nk_graph_t *g) {
+    uint32_t s = nk_sched_lock();
+    if (g->tail == g->head) {
+        nk_sched_unlock(s);
+        return false;
+    }
+    const nk_graph_node_t *nd = &g->node[g->ready[g->tail++]];
+    nk_sched_unlock(s);
+
+    nd->fn(nd->arg);
+
+    s = nk_sched_lock();
+    for (uint8_t e = 0; e < nd->nsucc; e++) {
+        if (--g->pending[nd->succ[e]] == 0) release(g, nd->succ[e]);
+    }
+    if (--g->left == 0) {
+        g->passes++;
+        nk_waitq_wake_all(&g->done);
+    }
+    nk_sched_unlock(s);
+    return true;
+}
+
+void nk_graph_worker(nk_graph_t *g) {
+    for (;;) {
+        if (nk_graph_step(g)) continue;
+
+        uint32_t s = nk_sched_lock();
+        if (g->tail == g->head) {
+            nk_waitq_block(&g->work);
+        } else {
+            nk_sched_unlock(s);
+        }
+    }
+}
+
+void nk_graph_wait(nk_graph_t *g) {
+    for (;;) {
+        uint32_t s = nk_sched_lock();
+        if (!g->left) {
+            nk_sched_unlock(s);
+            return;
+        }
+        nk_waitq_block(&g->done);
+    }
+}
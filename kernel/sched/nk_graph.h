@@ -0,0 +1,149 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_graph.h
+ * @brief Dataflow task graphs: run each node once all its inputs are done
+ *
+ * A graph is a const table of nodes, each a {function, argument} and the
+ * list of nodes it feeds.  nk_graph_start() begins a pass: every node
+ * gets a counter of predecessors still to finish, and those with none
+ * go on the graph's ready list.  Whoever finishes a node decrements its
+ * successors and lists the ones that reach zero, so a pipeline such as
+ *
+ * ```c
+ * enum { SENSE, LPF, KALMAN, FUSE, ACT };
+ *
+ * static const nk_graph_node_t nodes[] = {
+ *     [SENSE]  = NK_GRAPH_NODE(sense,  NULL, LPF, KALMAN),
+ *     [LPF]    = NK_GRAPH_NODE(lpf,    NULL, FUSE),
+ *     [KALMAN] = NK_GRAPH_NODE(kalman, NULL, FUSE),
+ *     [FUSE]   = NK_GRAPH_NODE(fuse,   NULL, ACT),
+ *     [ACT]    = NK_GRAPH_SINK(act,    NULL),
+ * };
+ * NK_GRAPH_DEFINE(ctl, nodes);
+ *
+ * static void ctl_worker(void) { nk_graph_worker(&ctl); }
+ *
+ * nk_graph_init(&ctl);                    // false: cycle or bad index
+ * nk_task_create(&w0, ctl_worker, 2, s0, sizeof(s0));
+ * nk_task_create(&w1, ctl_worker, 2, s1, sizeof(s1));
+ * ...
+ * ISR(ADC_vect) { nk_graph_start(&ctl); } // one pass per sample
+ * ```
+ *
+ * runs without anyone polling: idle workers sleep on the graph and are
+ * woken one per released node.  With several workers the two filters
+ * run side by side, in parallel on an SMP port.  A single task can
+ * also drive a pass itself with nk_graph_step() (cf. nk_work_run()).
+ *
+ * One pass at a time: nk_graph_start() during a pass fails and counts
+ * an overrun.  Nodes must not block on the graph they belong to.
+ *
+ * RAM: 2 bytes per node plus ~16 per graph; the node table is const.
+ */
+
+#ifndef KERNEL_SCHED_NK_GRAPH_H
+#define KERNEL_SCHED_NK_GRAPH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "scheduler.h"
+
+/** Node body */
+typedef void (*nk_graph_fn)(void *arg);
+
+/** One node: what it runs and which nodes consume its output */
+typedef struct {
+    nk_graph_fn    fn;
+    void          *arg;
+    const uint8_t *succ;        /**< Indices of successor nodes */
+    uint8_t        nsucc;
+} nk_graph_node_t;
+
+/** Node feeding the nodes listed after @p arg (at least one; file scope) */
+#define NK_GRAPH_NODE(fn, arg, ...)                                     \
+    { (fn), (arg), (const uint8_t[]){ __VA_ARGS__ },                    \
+      (uint8_t)sizeof((const uint8_t[]){ __VA_ARGS__ }) }
+
+/** Node with no successors */
+#define NK_GRAPH_SINK(fn, arg) { (fn), (arg), 0, 0 }
+
+/** Graph state; declare with NK_GRAPH_DEFINE() */
+typedef struct {
+    const nk_graph_node_t *node;
+    uint8_t          *pending;  /**< Per node: predecessors not yet done */
+    uint8_t          *ready;    /**< Released nodes, [tail, head) */
+    uint8_t           n;
+    bool              valid;    /**< nk_graph_init() found no cycle */
+    uint8_t           head;
+    uint8_t           tail;
+    volatile uint8_t  left;     /**< Nodes of this pass still to finish */
+    uint16_t          passes;   /**< Completed passes */
+    uint16_t          overruns; /**< Starts refused during a pass */
+    nk_waitq_t        work;     /**< Idle nk_graph_worker()s */
+    nk_waitq_t        done;     /**< nk_graph_wait() callers */
+} nk_graph_t;
+
+/** Define graph @p name over the const node array @p nodes */
+#define NK_GRAPH_DEFINE(name, nodes)                                    \
+    static uint8_t name##_pending[sizeof(nodes) / sizeof((nodes)[0])];  \
+    static uint8_t name##_ready[sizeof(nodes) / sizeof((nodes)[0])];    \
+    static nk_graph_t name = {                                          \
+        .node = (nodes), .pending = name##_pending,                     \
+        .ready = name##_ready,                                          \
+        .n = (uint8_t)(sizeof(nodes) / sizeof((nodes)[0]))              \
+    }
+
+/**
+ * @brief Check the edges once before the first pass
+ *
+ * @return false if a successor index is out of range or the edges form
+ *         a cycle (a pass could never finish); the graph then never
+ *         starts
+ */
+bool nk_graph_init(nk_graph_t *g);
+
+/**
+ * @brief Begin a pass: release every node without predecessors
+ *
+ * ISR-safe; O(nodes + edges) under the scheduler lock.
+ *
+ * @return false if the previous pass is still running (an overrun) or
+ *         the graph is not valid
+ */
+bool nk_graph_start(nk_graph_t *g);
+
+/**
+ * @brief Run one released node in the caller, then release what it feeds
+ *
+ * @return false if no node was ready
+ */
+bool nk_graph_step(nk_graph_t *g);
+
+/**
+ * @brief Worker task body: run released nodes, sleep while there are none
+ *
+ * Never returns.  Wrap it in an nk_task_fn per graph; create as many
+ * workers as branches should run at once.
+ */
+void nk_graph_worker(nk_graph_t *g) __attribute__((noreturn));
+
+/** Block until the current pass (if any) has finished */
+void nk_graph_wait(nk_graph_t *g);
+
+/** True while a pass is running */
+static inline bool nk_graph_busy(const nk_graph_t *g) {
+    return g->left != 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SCHED_NK_GRAPH_H */
@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_pt.c
+ * @brief Protothread runner
+ *
+ * Live threads sit on a singly linked list.  Spawning pushes at the
+ * head under the scheduler lock; everything else (running, unlinking
+ * exited threads, scanning deadlines) happens on the runner's side, so
+ * the only shared word is the head pointer.  Each pass snapshots the
+ * head first, which makes a thread spawned mid-pass start on the next.
+ */
+
+#include "nk_pt.h"
+#include "scheduler.h"
+#include "kernel/sync/nk_event.h"
+
+static nk_pt_t *pt_head;
+
+static nk_pt_t *pt_first(void) {
+    uint32_t s = nk_sched_lock();
+    nk_pt_t *pt = pt_head;
+    nk_sched_unlock(s);
+    return pt;
+}
+
+static void pt_unlink(nk_pt_t *pt) {
+    uint32_t s = nk_sched_lock();
+    nk_pt_t **pp = &pt_head;
+    while (*pp != pt) {
+        pp = &(*pp)->next;
+    }
+    *pp = pt->next;
+    pt->flags = 0;
+    nk_sched_unlock(s);
+}
+
+bool nk_pt_spawn(nk_pt_t *pt, nk_pt_fn fn) {
+    if (!pt || !fn) return false;
+
+    uint32_t s = nk_sched_lock();
+    if (pt->flags & NK_PT_F_LIVE) {
+        nk_sched_unlock(s);
+        return false;
+    }
+    pt->fn = fn;
+    pt->lc = 0;
+    pt->flags = NK_PT_F_LIVE;
+    pt->next = pt_head;
+    pt_head = pt;
+    nk_sched_unlock(s);
+
+    nk_pt_wake();
+    return true;
+}
+
+uint8_t nk_pt_run(void) {
+    uint8_t n = 0;
+
+    for (nk_pt_t *pt = pt_first(); pt; ) {
+        nk_pt_t *next = pt->next;
+        int8_t r = pt->fn(pt);
+        if (r != NK_PT_WAITING) {
+            ++n;
+        }
+        if (r == NK_PT_EXITED) {
+            pt_unlink(pt);
+        }
+        pt = next;
+    }
+    return n;
+}
+
+uint16_t nk_pt_next(void) {
+    uint16_t now = (uint16_t)nk_ticks();
+    uint16_t best = UINT16_MAX;
+
+    for (nk_pt_t *pt = pt_first(); pt; pt = pt->next) {
+        if (!(pt->flags & NK_PT_F_TIMED)) {
+            continue;
+        }
+        int16_t left = (int16_t)(pt->wake - now);
+        if (left <= 0) {
+            return 0;
+        }
+        if ((uint16_t)left < best) {
+            best = (uint16_t)left;
+        }
+    }
+    return best;
+}
+
+void nk_pt_wake(void) {
+#if NK_IO_POLL
+    nk_event_set(&nk_io_event, 0);    /* bumps the sequence only */
+#endif
+}
+
+void nk_pt_task(void) {
+    for (;;) {
+#if NK_IO_POLL
+        uint8_t seq = nk_event_seq(&nk_io_event);
+#endif
+        if (nk_pt_run()) {
+            nk_yield();
+            continue;
+        }
+        uint16_t t = nk_pt_next();
+        if (t == 0) {
+            continue;
+        }
+#if NK_IO_POLL
+        (void)nk_event_wait_seq(&nk_io_event, seq, t);  /* UINT16_MAX = forever */
+#else
+        nk_sleep(1);                    /* no reports: recheck every tick */
+#endif
+    }
+}
+
+void nk_pt_arm(nk_pt_t *pt, uint16_t ticks) {
+    if (ticks > NK_PT_MAX_TICKS) {
+        ticks = NK_PT_MAX_TICKS;
+    }
+    pt->wake = (uint16_t)((uint16_t)nk_ticks() + ticks);
+    pt->flags |= NK_PT_F_TIMED;
+}
+
+bool nk_pt_expired(const nk_pt_t *pt) {
+    return (int16_t)((uint16_t)nk_ticks() - pt->wake) >= 0;
+}
@@ -0,0 +1,211 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_pt.h
+ * @brief Stackless protothreads sharing one scheduler task
+ *
+ * A protothread is a function that returns whenever it has to wait and
+ * resumes at the same statement on its next call.  The resume point is
+ * a line number kept in the nk_pt_t and dispatched by a switch at the
+ * top of the function, so the thread owns no stack: on the 2 KB 328P a
+ * state machine costs nine bytes instead of a 128-byte task stack.
+ *
+ * All protothreads run from one ordinary kernel task, nk_pt_task(),
+ * which the preemptive scheduler treats like any other.  It calls every
+ * live thread once per pass and sleeps when none can make progress:
+ * until the earliest PT_SLEEP() deadline, or a driver readiness report
+ * on nk_io_event with kernel_poll (one tick without).
+ *
+ * ```c
+ * static nk_pt_t blink;
+ *
+ * static int8_t blink_fn(nk_pt_t *pt) {
+ *     PT_BEGIN(pt);
+ *     for (;;) {
+ *         led_toggle();
+ *         PT_SLEEP(pt, 500);
+ *     }
+ *     PT_END(pt);
+ * }
+ *
+ * nk_pt_spawn(&blink, blink_fn);
+ * nk_task_create(&pt_tcb, nk_pt_task, 3, pt_stack, sizeof(pt_stack));
+ * ```
+ *
+ * Restrictions that come with sharing the stack:
+ * - Locals do not survive a wait; keep state in a struct that embeds
+ *   the nk_pt_t and cast back to it.
+ * - At most one PT_* wait per source line (the line is the resume
+ *   point), and no waits inside a nested switch.
+ * - A protothread must not block the runner (nk_sleep(), door_call(),
+ *   blocking reads); use the PT_* waits instead.
+ */
+
+#ifndef KERNEL_SCHED_NK_PT_H
+#define KERNEL_SCHED_NK_PT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Values a protothread function returns */
+#define NK_PT_WAITING 0     /**< Blocked on a condition */
+#define NK_PT_YIELDED 1     /**< Gave up the CPU, wants to run again */
+#define NK_PT_EXITED  2     /**< Finished; removed from the runner */
+
+struct nk_pt;
+
+/** Protothread body; returns one of the NK_PT_* values */
+typedef int8_t (*nk_pt_fn)(struct nk_pt *pt);
+
+/**
+ * @brief Protothread control block (caller-allocated)
+ */
+typedef struct nk_pt {
+    struct nk_pt *next;     /**< Runner list link */
+    nk_pt_fn      fn;       /**< Body */
+    uint16_t      lc;       /**< Resume point (source line, 0 = start) */
+    uint16_t      wake;     /**< Deadline, low 16 bits of nk_ticks() */
+    uint8_t       flags;    /**< NK_PT_F_* */
+} nk_pt_t;
+
+#define NK_PT_F_LIVE  0x01u /**< On the runner list */
+#define NK_PT_F_TIMED 0x02u /**< `wake` holds a pending deadline */
+
+/** Longest PT_SLEEP() / PT_WAIT_TIMEOUT() in ticks */
+#define NK_PT_MAX_TICKS 0x7FFFu
+
+/*═══════════════════════════════════════════════════════════════════
+ * BODY MACROS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Open the body; everything up to PT_END() may wait */
+#define PT_BEGIN(pt)  switch ((pt)->lc) { case 0:
+
+/** Close the body; falling through here ends the thread */
+#define PT_END(pt)    } (pt)->lc = 0; return NK_PT_EXITED
+
+/** End the thread at once */
+#define PT_EXIT(pt)   do { (pt)->lc = 0; return NK_PT_EXITED; } while (0)
+
+/** Resume here on each pass until @p cond holds */
+#define PT_WAIT_UNTIL(pt, cond)                                            \
+    do {                                                                   \
+        (pt)->lc = __LINE__;                                               \
+        __attribute__((fallthrough));   /* first pass tests at once */     \
+        case __LINE__:                                                     \
+        if (!(cond)) return NK_PT_WAITING;                                 \
+    } while (0)
+
+/** Resume here on each pass while @p cond holds */
+#define PT_WAIT_WHILE(pt, cond) PT_WAIT_UNTIL((pt), !(cond))
+
+/** Let the other protothreads (and tasks) run, then continue */
+#define PT_YIELD(pt)                                                       \
+    do {                                                                   \
+        (pt)->lc = __LINE__; return NK_PT_YIELDED; case __LINE__:;         \
+    } while (0)
+
+/**
+ * @brief Wait until @p cond holds or @p ticks have passed
+ *
+ * Test @p cond again afterwards to tell which one it was.
+ */
+#define PT_WAIT_TIMEOUT(pt, cond, ticks)                                   \
+    do {                                                                   \
+        nk_pt_arm((pt), (ticks));                                          \
+        PT_WAIT_UNTIL((pt), (cond) || nk_pt_expired(pt));                  \
+        (pt)->flags &= (uint8_t)~NK_PT_F_TIMED;                            \
+    } while (0)
+
+/** Sleep for @p ticks (at most NK_PT_MAX_TICKS) */
+#define PT_SLEEP(pt, ticks) PT_WAIT_TIMEOUT((pt), 0, (ticks))
+
+/**
+ * @brief Wait for the reply to door_call_async() ticket @p ticket
+ *
+ * The ticket must be valid (>= 0); it is released once the reply is in
+ * the caller's buffer, as with door_poll().
+ */
+#define PT_AWAIT_DOOR(pt, ticket) PT_WAIT_UNTIL((pt), door_poll(ticket))
+
+/** Wait until nk_future_t @p f has completed */
+#define PT_AWAIT_FUTURE(pt, f) PT_WAIT_UNTIL((pt), nk_future_done(f))
+
+/** Wait until TTY @p t has received bytes */
+#define PT_AWAIT_TTY_RX(pt, t) PT_WAIT_UNTIL((pt), tty_rx_available(t) > 0)
+
+/** Wait until TTY @p t has room for @p n bytes of output */
+#define PT_AWAIT_TTY_TX(pt, t, n) PT_WAIT_UNTIL((pt), tty_tx_free(t) >= (n))
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Add a protothread to the runner
+ *
+ * The thread starts at PT_BEGIN() on the runner's next pass.  Safe from
+ * tasks and from other protothreads.
+ *
+ * @param pt Control block, unused or already exited
+ * @param fn Body
+ * @return true on success, false if @p pt is still running or @p fn is
+ *         NULL
+ */
+bool nk_pt_spawn(nk_pt_t *pt, nk_pt_fn fn);
+
+/** Whether @p pt has been spawned and has not exited yet */
+static inline bool nk_pt_running(const nk_pt_t *pt) {
+    return (pt->flags & NK_PT_F_LIVE) != 0;
+}
+
+/**
+ * @brief Run every live protothread once in the caller's context
+ *
+ * For applications that drive protothreads from their own loop instead
+ * of nk_pt_task().  Must not be called from a protothread.
+ *
+ * @return Threads that yielded or exited (0 = all are waiting)
+ */
+uint8_t nk_pt_run(void);
+
+/**
+ * @brief Ticks until the earliest protothread deadline
+ *
+ * @return 0 if one is already due, UINT16_MAX if none is pending
+ */
+uint16_t nk_pt_next(void);
+
+/**
+ * @brief Make the runner re-check every waiting condition
+ *
+ * Call after changing state a PT_WAIT_UNTIL() tests, when the change
+ * is not already reported through nk_io_event.  Safe from ISRs.
+ */
+void nk_pt_wake(void);
+
+/**
+ * @brief Runner task entry point
+ *
+ * Runs the protothreads for ever.  Create it with nk_task_create()
+ * below the priority of the tasks that feed it.
+ */
+void nk_pt_task(void);
+
+/** Start a PT_WAIT_TIMEOUT() deadline @p ticks from now */
+void nk_pt_arm(nk_pt_t *pt, uint16_t ticks);
+
+/** Whether the deadline set by nk_pt_arm() has passed */
+bool nk_pt_expired(const nk_pt_t *pt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SCHED_NK_PT_H */
@@ -8,7 +8,11 @@
  */
 
 #include "scheduler.h"
+#include "ktimer.h"
+#include "idle.h"
 #include "arch/common/hal.h"
+#include "kernel/sync/nk_trace.h"
+#include "kernel/sync/nk_log.h"
 #include "avrix-config.h"
 #include <string.h>
 
@@ -25,8 +29,96 @@
 #  define CONFIG_KERNEL_STACK_SIZE 128
 #endif
 
+/* Stack arena shared by all pooled task stacks (0 = TASK_MAX * STACK_SIZE) */
+#if !defined(CONFIG_KERNEL_STACK_POOL_SIZE) || CONFIG_KERNEL_STACK_POOL_SIZE == 0
+#  undef  CONFIG_KERNEL_STACK_POOL_SIZE
+#  define CONFIG_KERNEL_STACK_POOL_SIZE \
+          (CONFIG_KERNEL_TASK_MAX * CONFIG_KERNEL_STACK_SIZE)
+#endif
+
+#ifndef CONFIG_KERNEL_SCHED_READYQ
+#  define CONFIG_KERNEL_SCHED_READYQ 0
+#endif
+
+#ifndef CONFIG_KERNEL_SCHED_EDF
+#  define CONFIG_KERNEL_SCHED_EDF 0
+#endif
+
+#ifndef CONFIG_KERNEL_SCHED_STATS
+#  define CONFIG_KERNEL_SCHED_STATS 0
+#endif
+
+#ifndef CONFIG_KERNEL_TICKLESS
+#  define CONFIG_KERNEL_TICKLESS 0
+#endif
+
+#ifndef CONFIG_KERNEL_SMP_CORES
+#  define CONFIG_KERNEL_SMP_CORES 1
+#endif
+
+#ifndef CONFIG_KERNEL_SIGNALS
+#  define CONFIG_KERNEL_SIGNALS 0
+#endif
+
+#ifndef CONFIG_KERNEL_TLS
+#  define CONFIG_KERNEL_TLS 0
+#endif
+
+/* Hash buckets for nk_wait_on()/nk_wake(); must be a power of two */
+#ifndef NK_FUTEX_BUCKETS
+#  define NK_FUTEX_BUCKETS 4
+#endif
+
 #define NK_QUANTUM_MS 10
 #define NK_OPT_STACK_GUARD CONFIG_KERNEL_PANIC_ON_FAULT
+/* With an MPU the guard is a no-access region, not a pair of canaries */
+#if NK_OPT_STACK_GUARD && defined(HAL_HAS_MPU) && HAL_HAS_MPU
+#  define NK_OPT_MPU_GUARD 1
+#else
+#  define NK_OPT_MPU_GUARD 0
+#endif
+#define NK_OPT_READYQ CONFIG_KERNEL_SCHED_READYQ
+#define NK_OPT_TICKLESS CONFIG_KERNEL_TICKLESS
+#define NK_OPT_EDF CONFIG_KERNEL_SCHED_EDF
+#define NK_OPT_STATS CONFIG_KERNEL_SCHED_STATS
+#define NK_OPT_SIGNALS CONFIG_KERNEL_SIGNALS
+#define NK_OPT_TLS CONFIG_KERNEL_TLS
+#define NK_CORES CONFIG_KERNEL_SMP_CORES
+
+#if NK_CORES > 1
+#  if !defined(CONFIG_KERNEL_SCHED_TYPE_PREEMPT)
+#    error "kernel_smp_cores > 1 requires the preemptive scheduler"
+#  endif
+#  if !NK_OPT_READYQ
+#    error "kernel_smp_cores > 1 requires kernel_sched_readyq"
+#  endif
+#  if NK_OPT_EDF
+#    error "kernel_sched_edf is uniprocessor only"
+#  endif
+#  if NK_OPT_TICKLESS
+#    error "kernel_tickless is uniprocessor only"
+#  endif
+#  if NK_OPT_TLS
+#    error "kernel_tls is uniprocessor only (nk_tls_self is one pointer)"
+#  endif
+#  include "kernel/sync/spinlock.h"
+#  define THIS_CPU() hal_cpu_id()
+#else
+#  define THIS_CPU() 0
+#endif
+
+/*
+ * Cooperative mode only switches from nk_yield()/nk_sleep()/blocking
+ * calls, never from the tick ISR, so it can use the lighter HAL path
+ * that saves just the call-saved registers.
+ */
+#if defined(CONFIG_KERNEL_SCHED_TYPE_COOP)
+#  define nk_context_init   hal_context_init_coop
+#  define nk_context_switch hal_context_switch_coop
+#else
+#  define nk_context_init   hal_context_init
+#  define nk_context_switch hal_context_switch
+#endif
 
 /*═══════════════════════════════════════════════════════════════════
  * SCHEDULER STATE
@@ -62,190 +154,1661 @@ void nk_sleep(uint16_t ms) {
     while(i--) hal_idle();
 }
 uint8_t nk_current_tid(void) { return 0; }
+uint32_t nk_sched_lock(void) { return hal_irq_save(); }
+void nk_sched_unlock(uint32_t s) { hal_irq_restore(s); }
+bool nk_task_set_quantum(uint8_t tid, uint8_t ticks) { (void)tid; (void)ticks; return false; }
+uint8_t nk_task_quantum(uint8_t tid) { (void)tid; return 0; }
+bool nk_task_set_policy(uint8_t tid, uint8_t policy) { (void)tid; (void)policy; return false; }
+uint8_t nk_task_policy(uint8_t tid) { (void)tid; return 0xFF; }
+int nk_task_stack_size(uint8_t tid) { (void)tid; return -1; }
+int nk_task_stats(uint8_t tid, nk_task_stats_t *out) { (void)tid; (void)out; return -1; }
+static volatile uint32_t nk_single_ticks;
+static volatile uint32_t nk_single_tick_cyc;
+uint32_t nk_ticks(void) { return nk_single_ticks; }
+uint32_t nk_ticks_fine(uint32_t *since) {
+    uint32_t s = hal_irq_save();
+    uint32_t t = nk_single_ticks;
+    *since = hal_cycles() - nk_single_tick_cyc;
+    hal_irq_restore(s);
+    return t;
+}
+void nk_waitq_init(nk_waitq_t *q) { *q = NK_WAITQ_INIT; }
+void nk_task_boost(uint8_t tid, uint8_t prio) { (void)tid; (void)prio; }
+void nk_task_unboost(uint8_t tid) { (void)tid; }
+uint8_t nk_task_priority(uint8_t tid) { (void)tid; return 0; }
+uint8_t nk_task_cpu(uint8_t tid) { (void)tid; return 0; }
+bool nk_task_set_priority(uint8_t tid, uint8_t prio) { (void)tid; (void)prio; return false; }
+bool nk_task_running(uint8_t tid) { (void)tid; return false; }
+bool nk_task_set_deadline(uint8_t tid, uint16_t period, uint16_t budget) { (void)tid; (void)period; (void)budget; return false; }
+void nk_task_wait_period(void) { }
+void nk_waitq_block(nk_waitq_t *q) { (void)q; hal_irq_enable(); }
+int nk_waitq_block_timeout(nk_waitq_t *q, uint16_t ticks) { (void)q; (void)ticks; hal_irq_enable(); return -1; }
+int nk_waitq_wake_one(nk_waitq_t *q) { (void)q; return -1; }
+uint8_t nk_waitq_wake_all(nk_waitq_t *q) { (void)q; return 0; }
+int nk_wait_on(volatile uint8_t *addr, uint8_t expected) { return *addr == expected ? 0 : -1; }
+uint8_t nk_wake(volatile uint8_t *addr, uint8_t n) { (void)addr; (void)n; return 0; }
+int nk_task_stack_usage(uint8_t tid) { (void)tid; return -1; }
 void nk_task_exit(int status) { (void)status; for(;;) hal_idle(); }
+int nk_task_wait(uint8_t tid) { (void)tid; return -1; }
+void nk_task_release(uint8_t tid) { (void)tid; }
+void nk_sig_dispatch(nk_sig_fn fn) { (void)fn; }
+int nk_sig_post(uint8_t tid, uint8_t sig) { (void)tid; (void)sig; return -1; }
+nk_sigset_t nk_sig_setmask(nk_sigset_t mask) { (void)mask; return 0; }
+nk_sigset_t nk_sig_blocked(void) { return 0; }
+nk_sigset_t nk_sig_pending(void) { return 0; }
+void nk_sig_deliver(void) { }
+int nk_sig_suspend(nk_sigset_t mask) { (void)mask; return -1; }
+#if NK_OPT_TLS
+void *nk_tls_self;
+bool nk_task_set_tls(uint8_t tid, void *block) {
+    if (tid) return false;
+    nk_tls_self = block;
+    return true;
+}
+void *nk_task_tls(uint8_t tid) { return tid ? NULL : nk_tls_self; }
+#else
+bool nk_task_set_tls(uint8_t tid, void *block) { (void)tid; (void)block; return false; }
+void *nk_task_tls(uint8_t tid) { (void)tid; return NULL; }
+#endif
 
-/* IRQ handler does nothing for context switching */
-void hal_timer_tick_handler(void) {}
+/* IRQ handler does no context switching; it only drives soft timers */
+void hal_timer_tick_handler(void) {
+    nk_single_ticks++;
+    nk_single_tick_cyc = hal_cycles();
+    nk_timer_advance(1);
+}
 
 
 #else /* CONFIG_KERNEL_SCHED_TYPE_PREEMPT or COOP */
 
 /* ─── Multi-Task Scheduler (Mid/High Profile) ─── */
 
+#define NK_TID_NONE 0xFF
+
 static struct {
     nk_tcb_t *tasks[CONFIG_KERNEL_TASK_MAX];
     uint8_t   count;
-    uint8_t   current;
-    volatile uint8_t quantum;
+    uint8_t   current[NK_CORES];                  /**< Running task per core */
+    volatile uint8_t quantum[NK_CORES];           /**< Slice left per core */
+    uint8_t   slice[CONFIG_KERNEL_TASK_MAX];      /**< Per-task time slice */
+    uint8_t   policy[CONFIG_KERNEL_TASK_MAX];     /**< NK_SCHED_RR / _FIFO */
+    uint8_t   sleep_head;                         /**< Delta-list head */
+    uint8_t   sleep_next[CONFIG_KERNEL_TASK_MAX]; /**< Delta-list links */
+    uint8_t   wait_next[CONFIG_KERNEL_TASK_MAX];  /**< Wait-queue links (tid+1) */
+    nk_waitq_t *wait_q[CONFIG_KERNEL_TASK_MAX];   /**< Queue of a timed waiter */
+    uint8_t   expired[CONFIG_KERNEL_TASK_MAX];    /**< Timed wait ran out */
+    nk_waitq_t exit_q[CONFIG_KERNEL_TASK_MAX];    /**< nk_task_wait() callers */
+    uint8_t   detached[CONFIG_KERNEL_TASK_MAX];   /**< Free the slot at exit */
+    uint32_t  ticks;                              /**< Ticks since start */
+    uint32_t  tick_cyc;                           /**< hal_cycles() at last tick */
+    uint8_t   in_tick[NK_CORES];                  /**< Inside tick handler */
+#if NK_CORES > 1
+    uint8_t   cpu[CONFIG_KERNEL_TASK_MAX];        /**< Home core (run queue) */
+#endif
+#if NK_OPT_TLS
+    void     *tls[CONFIG_KERNEL_TASK_MAX];        /**< TLS block per task */
+#endif
+#if !NK_OPT_READYQ
+    uint16_t  ready_seq[CONFIG_KERNEL_TASK_MAX];  /**< Queue order among equals */
+    uint16_t  ready_clock;                        /**< Last ready_seq handed out */
+#endif
+#if NK_OPT_SOA
+    /* Aligned so the ready scan can read four states as one word */
+    uint8_t   state[CONFIG_KERNEL_TASK_MAX] __attribute__((aligned(4)));
+    uint8_t   prio[CONFIG_KERNEL_TASK_MAX];       /**< Effective priority */
+    uint8_t   base_prio[CONFIG_KERNEL_TASK_MAX];  /**< Before inheritance */
+    uint16_t  sleep_ticks[CONFIG_KERNEL_TASK_MAX];/**< Delta-list deltas */
+#endif
 } nk_sched = {
     .count   = 0,
-    .current = 0,
-    .quantum = NK_QUANTUM_MS
+    .sleep_head = NK_TID_NONE
 };
 
-/* Stack Management */
-#if NK_OPT_STACK_GUARD
+#define CURRENT nk_sched.current[THIS_CPU()]
+#define QUANTUM nk_sched.quantum[THIS_CPU()]
+#define IN_TICK nk_sched.in_tick[THIS_CPU()]
+
+#if NK_CORES > 1
+#  define TASK_CPU(tid) nk_sched.cpu[tid]
+#else
+#  define TASK_CPU(tid) 0
+#endif
+
+#if NK_OPT_SOA
+#  define TASK_STATE(tid)     nk_sched.state[tid]
+#  define TASK_PRIO(tid)      nk_sched.prio[tid]
+#  define TASK_BASE_PRIO(tid) nk_sched.base_prio[tid]
+#  define TASK_SLEEP(tid)     nk_sched.sleep_ticks[tid]
+#else
+#  define TASK_STATE(tid)     nk_sched.tasks[tid]->state
+#  define TASK_PRIO(tid)      nk_sched.tasks[tid]->priority
+#  define TASK_BASE_PRIO(tid) nk_sched.tasks[tid]->base_priority
+#  define TASK_SLEEP(tid)     nk_sched.tasks[tid]->sleep_ticks
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * SCHEDULER LOCK
+ *═══════════════════════════════════════════════════════════════════
+ *
+ * On one core masking interrupts is enough.  With several cores the
+ * scheduler state is also guarded by one spinlock, made recursive per
+ * core so ISRs and nested helpers can take it freely.  The lock is
+ * held across a context switch and released by the task that resumes,
+ * so each task's nesting depth and saved interrupt state travel with
+ * it in switch_to().
+ */
+
+#if NK_CORES > 1
+#define NK_CPU_NONE 0xFF
+
+static nk_spinlock_t nk_sched_spin = NK_SPINLOCK_DOMAIN_INIT("sched", NK_LOCK_DOM_SCHED);
+
+static struct {
+    volatile uint8_t owner;                     /**< Core holding the lock */
+    uint8_t  depth;
+    uint32_t irq;                               /**< State at first acquire */
+    uint8_t  saved_depth[CONFIG_KERNEL_TASK_MAX];
+    uint32_t saved_irq[CONFIG_KERNEL_TASK_MAX];
+} nk_smp = { .owner = NK_CPU_NONE };
+
+static void smp_lock(void) {
+    uint32_t s = hal_irq_save();
+    uint8_t me = hal_cpu_id();
+
+    if (nk_smp.owner == me) {
+        nk_smp.depth++;
+        return;
+    }
+    nk_spinlock_lock_rt(&nk_sched_spin, 0);
+    nk_smp.owner = me;
+    nk_smp.depth = 1;
+    nk_smp.irq   = s;
+}
+
+static void smp_unlock(void) {
+    if (--nk_smp.depth) return;
+    uint32_t s = nk_smp.irq;
+    nk_smp.owner = NK_CPU_NONE;
+    nk_spinlock_unlock_rt(&nk_sched_spin);
+    hal_irq_restore(s);
+}
+
+#  define sched_lock()        smp_lock()
+#  define sched_unlock()      smp_unlock()
+#  define sched_save()        (smp_lock(), 0u)
+#  define sched_restore(s)    ((void)(s), smp_unlock())
+#  define sched_isr_enter()   smp_lock()
+#  define sched_isr_exit()    smp_unlock()
+#else
+#  define sched_lock()        hal_irq_disable()
+#  define sched_unlock()      hal_irq_enable()
+#  define sched_save()        hal_irq_save()
+#  define sched_restore(s)    hal_irq_restore(s)
+#  define sched_isr_enter()   ((void)0)
+#  define sched_isr_exit()    ((void)0)
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * STACK POOL
+ *═══════════════════════════════════════════════════════════════════
+ *
+ * Stacks for tasks created without a caller buffer are carved from one
+ * contiguous arena, each sized on request.  With the stack guard each
+ * carve is laid out as an nk_stack_t followed by its data and a
+ * trailing guard word.  Tasks never return their stacks.
+ *
+ * On MPU targets each carve instead starts with HAL_STACK_GUARD_SIZE
+ * bytes nothing ever uses, and switch_to() makes the block under the
+ * incoming stack no-access: an overflow faults on the offending push
+ * and a switch costs no checking.  Caller-owned stacks are trimmed to
+ * make room for the same block.
+ */
+
+#if NK_OPT_MPU_GUARD
+#  define NK_STACK_ALIGN HAL_STACK_GUARD_SIZE   /* regions are size-aligned */
+#elif defined(__AVR__)
+#  define NK_STACK_ALIGN 1
+#else
+#  define NK_STACK_ALIGN 8      /* AAPCS / SysV want 8-byte stacks */
+#endif
+
+#if NK_OPT_MPU_GUARD
+#define NK_STACK_OVERHEAD   HAL_STACK_GUARD_SIZE
+#elif NK_OPT_STACK_GUARD
 typedef struct {
     uint32_t guard_lo;
-    uint8_t  data[CONFIG_KERNEL_STACK_SIZE];
-    uint32_t guard_hi;
+    uint8_t  data[];            /* followed by uint32_t guard_hi */
 } nk_stack_t;
 #define STACK_GUARD_PATTERN 0xDEADBEEF
-static nk_stack_t nk_stacks[CONFIG_KERNEL_TASK_MAX] __attribute__((section(".noinit")));
+#define NK_STACK_OVERHEAD   (2 * sizeof(uint32_t))
 #else
-static uint8_t nk_stacks[CONFIG_KERNEL_TASK_MAX][CONFIG_KERNEL_STACK_SIZE] __attribute__((section(".noinit")));
+#define NK_STACK_OVERHEAD   0
+#endif
+
+static uint8_t nk_stack_pool[CONFIG_KERNEL_STACK_POOL_SIZE +
+                             CONFIG_KERNEL_TASK_MAX * NK_STACK_OVERHEAD]
+    __attribute__((section(".noinit"), aligned(NK_STACK_ALIGN)));
+
+static struct {
+    uint8_t  *base[CONFIG_KERNEL_TASK_MAX];  /**< Lowest stack byte */
+    uint16_t  size[CONFIG_KERNEL_TASK_MAX];  /**< Usable stack bytes */
+    uint16_t  brk;                           /**< Pool bytes in use */
+} nk_stk;
+
+/*
+ * High-water painting: every stack is filled with NK_STACK_PAINT at
+ * creation, and the first non-paint byte from the low end marks the
+ * deepest point the task has reached.
+ */
+#define NK_STACK_PAINT 0xA5
+
+static inline bool stack_pooled(uint8_t tid) {
+    return nk_stk.base[tid] >= nk_stack_pool &&
+           nk_stk.base[tid] <  nk_stack_pool + sizeof nk_stack_pool;
+}
+
+/* Carve @p len bytes (rounded up) from the pool; NULL when exhausted. */
+static uint8_t *stack_alloc(uint16_t *len) {
+    uint16_t n = (uint16_t)((*len + NK_STACK_ALIGN - 1) & ~(NK_STACK_ALIGN - 1));
+#if NK_OPT_STACK_GUARD && !NK_OPT_MPU_GUARD
+    n = (uint16_t)((n + 3) & ~3u);      /* keep guard_hi word-aligned */
 #endif
+    if ((size_t)nk_stk.brk + n + NK_STACK_OVERHEAD > sizeof nk_stack_pool) {
+        return NULL;
+    }
+
+    uint8_t *p = nk_stack_pool + nk_stk.brk;
+    nk_stk.brk = (uint16_t)(nk_stk.brk + n + NK_STACK_OVERHEAD);
+    *len = n;
+
+#if NK_OPT_MPU_GUARD
+    return p + HAL_STACK_GUARD_SIZE;
+#elif NK_OPT_STACK_GUARD
+    nk_stack_t *stk = (nk_stack_t *)p;
+    uint32_t guard = STACK_GUARD_PATTERN;
+    stk->guard_lo = guard;
+    memcpy(stk->data + n, &guard, sizeof guard);
+    return stk->data;
+#else
+    return p;
+#endif
+}
+
+#if NK_OPT_MPU_GUARD
+/* Give up the bottom of a caller's buffer to an aligned guard block */
+static uint8_t *stack_trim(uint8_t *p, uint16_t *len) {
+    uintptr_t lo = ((uintptr_t)p + 2 * HAL_STACK_GUARD_SIZE - 1) &
+                   ~(uintptr_t)(HAL_STACK_GUARD_SIZE - 1);
+    uintptr_t end = (uintptr_t)p + *len;
+
+    if (lo + HAL_STACK_GUARD_SIZE > end) return NULL;
+    *len = (uint16_t)(end - lo);
+    return (uint8_t *)lo;
+}
+#endif
+
+#if NK_OPT_READYQ
+/*═══════════════════════════════════════════════════════════════════
+ * READY QUEUE (O(1) priority bitmap)
+ *═══════════════════════════════════════════════════════════════════
+ *
+ * Two-level bitmap over the 64 priority levels: bit g of `grp` is set
+ * when any level in g*8..g*8+7 is non-empty, bit (p & 7) of map[p >> 3]
+ * when level p is non-empty.  Each level is a circular FIFO threaded
+ * through next[] by task ID; only the tail is stored and the head is
+ * next[tail].  The running task is never on the queue.  With SMP each
+ * core owns one queue and a task is queued on its home core.
+ */
+
+#define NK_PRIO_LEVELS 64
+#define NK_RQ_NONE     0xFF
+
+typedef struct {
+    uint8_t grp;
+    uint8_t map[NK_PRIO_LEVELS / 8];
+    uint8_t tail[NK_PRIO_LEVELS];
+    uint8_t next[CONFIG_KERNEL_TASK_MAX];
+} nk_rq_t;
+
+static nk_rq_t nk_rq[NK_CORES];     /* one per core, indexed by TASK_CPU() */
+
+/* Index of lowest set bit; x must be non-zero. */
+static inline uint8_t rq_lsb8(uint8_t x) {
+#if defined(__AVR__)
+    static const uint8_t lut[16] HAL_PROGMEM = {
+        0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0
+    };
+    return (x & 0x0F) ? hal_pgm_read_byte(&lut[x & 0x0F])
+                      : 4 + hal_pgm_read_byte(&lut[x >> 4]);
+#else
+    return (uint8_t)__builtin_ctz(x);
+#endif
+}
+
+static void rq_init(void) {
+    for (uint8_t c = 0; c < NK_CORES; ++c) {
+        nk_rq[c].grp = 0;
+        memset(nk_rq[c].map, 0, sizeof nk_rq[c].map);
+        memset(nk_rq[c].tail, NK_RQ_NONE, sizeof nk_rq[c].tail);
+    }
+}
+
+/* Append task to the tail of its priority level on its home core. */
+static void rq_push(uint8_t tid) {
+    nk_rq_t *q = &nk_rq[TASK_CPU(tid)];
+    uint8_t p = TASK_PRIO(tid);
+    uint8_t t = q->tail[p];
+
+    if (t == NK_RQ_NONE) {
+        q->next[tid] = tid;
+        q->map[p >> 3] |= (uint8_t)(1u << (p & 7));
+        q->grp |= (uint8_t)(1u << (p >> 3));
+    } else {
+        q->next[tid] = q->next[t];
+        q->next[t] = tid;
+    }
+    q->tail[p] = tid;
+}
+
+/* Put task at the head of its level: it runs next among its equals. */
+static void rq_push_head(uint8_t tid) {
+    nk_rq_t *q = &nk_rq[TASK_CPU(tid)];
+    uint8_t p = TASK_PRIO(tid);
+
+    if (q->tail[p] == NK_RQ_NONE) {
+        rq_push(tid);
+        return;
+    }
+    q->next[tid] = q->next[q->tail[p]];
+    q->next[q->tail[p]] = tid;
+}
+
+/* Unlink a queued task from its level (used when its priority changes). */
+static void rq_remove(uint8_t tid) {
+    nk_rq_t *q = &nk_rq[TASK_CPU(tid)];
+    uint8_t p = TASK_PRIO(tid);
+    uint8_t t = q->tail[p];
+    uint8_t prev = t;
+
+    if (t == NK_RQ_NONE) return;
+    while (q->next[prev] != tid) {
+        prev = q->next[prev];
+        if (prev == t) return;          /* not on this level */
+    }
+    if (prev == tid) {                  /* only member */
+        q->tail[p] = NK_RQ_NONE;
+        q->map[p >> 3] &= (uint8_t)~(1u << (p & 7));
+        if (!q->map[p >> 3]) q->grp &= (uint8_t)~(1u << (p >> 3));
+        return;
+    }
+    q->next[prev] = q->next[tid];
+    if (t == tid) q->tail[p] = prev;
+}
+
+/* Highest non-empty priority level on core @p c, or NK_RQ_NONE. */
+static inline uint8_t rq_top(uint8_t c) {
+    const nk_rq_t *q = &nk_rq[c];
+    if (!q->grp) return NK_RQ_NONE;
+    uint8_t g = rq_lsb8(q->grp);
+    return (uint8_t)((g << 3) | rq_lsb8(q->map[g]));
+}
+
+/* Remove and return the head of a non-empty priority level. */
+static uint8_t rq_pop(uint8_t c, uint8_t p) {
+    nk_rq_t *q = &nk_rq[c];
+    uint8_t t = q->tail[p];
+    uint8_t h = q->next[t];
+
+    if (h == t) {
+        q->tail[p] = NK_RQ_NONE;
+        q->map[p >> 3] &= (uint8_t)~(1u << (p & 7));
+        if (!q->map[p >> 3]) q->grp &= (uint8_t)~(1u << (p >> 3));
+    } else {
+        q->next[t] = q->next[h];
+    }
+    return h;
+}
+#endif /* NK_OPT_READYQ */
+
+#if NK_OPT_EDF
+/*═══════════════════════════════════════════════════════════════════
+ * EDF CLASS
+ *═══════════════════════════════════════════════════════════════════
+ *
+ * Deadline tasks sit above every fixed-priority level.  Each has an
+ * implicit deadline equal to its period and a budget of ticks per
+ * period; when the budget runs out the task is throttled until its next
+ * release.  They are picked by linear scan (few in practice) and never
+ * placed on the fixed-priority ready queue.
+ */
+
+#define EDF_WAIT 0x01   /**< Blocked in nk_task_wait_period() */
+
+static struct {
+    uint32_t deadline[CONFIG_KERNEL_TASK_MAX];  /**< Absolute deadline */
+    uint16_t period[CONFIG_KERNEL_TASK_MAX];    /**< 0 = fixed priority */
+    uint16_t budget[CONFIG_KERNEL_TASK_MAX];
+    uint16_t left[CONFIG_KERNEL_TASK_MAX];      /**< Budget remaining */
+    uint8_t  flags[CONFIG_KERNEL_TASK_MAX];
+    uint32_t util;                              /**< Σ budget/period, Q16 */
+} nk_edf;
+
+static inline bool is_edf(uint8_t tid) {
+    return nk_edf.period[tid] != 0;
+}
+
+/* Hand an exiting task's reservation back to the admission test */
+static inline void edf_release(uint8_t tid) {
+    if (is_edf(tid)) {
+        nk_edf.util -= ((uint32_t)nk_edf.budget[tid] << 16) / nk_edf.period[tid];
+        nk_edf.period[tid] = 0;
+    }
+}
+
+/* Earliest-deadline EDF task with budget left, or NK_TID_NONE. */
+static uint8_t edf_pick(void) {
+    uint8_t best = NK_TID_NONE;
 
-static void update_sleep_timers(void) {
     for (uint8_t i = 0; i < nk_sched.count; ++i) {
-        nk_tcb_t *t = nk_sched.tasks[i];
-        if (t->state == NK_SLEEPING && t->sleep_ticks) {
-            if (--t->sleep_ticks == 0) {
-                t->state = NK_READY;
-            }
+        uint8_t st = TASK_STATE(i);
+        if (!is_edf(i) || !nk_edf.left[i]) continue;
+        if (st != NK_READY && st != NK_RUNNING) continue;
+        if (best == NK_TID_NONE ||
+            (int32_t)(nk_edf.deadline[i] - nk_edf.deadline[best]) < 0) {
+            best = i;
         }
     }
+    return best;
 }
+#else
+static inline bool is_edf(uint8_t tid) { (void)tid; return false; }
+#endif /* NK_OPT_EDF */
 
-static uint8_t find_next_task(void) {
-    uint8_t best  = nk_sched.current;
-    uint8_t bestp = 0xFF;
+#if NK_OPT_STATS
+static nk_task_stats_t nk_stats[CONFIG_KERNEL_TASK_MAX];
+#endif
+
+#if NK_OPT_SIGNALS
+static struct {
+    volatile nk_sigset_t pending[CONFIG_KERNEL_TASK_MAX];
+    nk_sigset_t blocked[CONFIG_KERNEL_TASK_MAX];  /**< Written by the task only */
+    uint8_t     suspended[CONFIG_KERNEL_TASK_MAX];/**< In nk_sig_suspend() */
+    nk_sig_fn   fn;
+} nk_sig;
+
+#  define SIG_READY(tid) (nk_sig.pending[tid] & ~nk_sig.blocked[tid])
+
+/* Handlers may only run once the caller's outermost lock is gone */
+static inline bool sig_unlocked(void) {
+#if NK_CORES > 1
+    return nk_smp.owner != hal_cpu_id();
+#else
+    return hal_irq_enabled();
+#endif
+}
+#endif
+
+/* Put a runnable task on the fixed-priority ready queue, if it uses one.
+ * The scan path keeps the same order with stamps: among equals the
+ * oldest ready_seq runs first. */
+static inline void ready_enqueue(uint8_t tid) {
+#if NK_OPT_READYQ
+    if (!is_edf(tid)) rq_push(tid);
+#if NK_CORES > 1
+    /* Let the home core re-evaluate; it may be idle or running lower */
+    if (TASK_CPU(tid) != THIS_CPU()) hal_ipi_send(TASK_CPU(tid));
+#endif
+#else
+    nk_sched.ready_seq[tid] = ++nk_sched.ready_clock;
+#endif
+}
+
+#if !NK_OPT_READYQ
+/* @p a was queued before @p b (stamps wrap) */
+static inline bool ready_before(uint8_t a, uint8_t b) {
+    return (int16_t)(nk_sched.ready_seq[a] - nk_sched.ready_seq[b]) < 0;
+}
 
-    /* Round-robin search */
+/* Stamp @p tid ahead of every ready task of its priority */
+static void ready_push_head(uint8_t tid) {
+    uint16_t seq = (uint16_t)(nk_sched.ready_clock + 1u);
     for (uint8_t i = 0; i < nk_sched.count; ++i) {
-        uint8_t idx = (nk_sched.current + i + 1) % nk_sched.count;
-        nk_tcb_t *t = nk_sched.tasks[idx];
+        if (i != tid && TASK_STATE(i) == NK_READY &&
+            TASK_PRIO(i) == TASK_PRIO(tid) &&
+            (int16_t)(nk_sched.ready_seq[i] - seq) < 0) {
+            seq = nk_sched.ready_seq[i];
+        }
+    }
+    nk_sched.ready_seq[tid] = (uint16_t)(seq - 1u);
+}
+#endif
+
+/* Move a sleeping or blocked task back to the runnable set. */
+static inline void make_ready(uint8_t tid) {
+    TASK_STATE(tid) = NK_READY;
+    ready_enqueue(tid);
+}
+
+/* Requeue a task the tick took the CPU from.  A FIFO task only loses it
+ * to a more urgent one and goes back to the head of its level, so its
+ * equals still wait for it (POSIX SCHED_FIFO). */
+static inline void ready_requeue(uint8_t tid) {
+    if (IN_TICK && nk_sched.policy[tid] == NK_SCHED_FIFO && !is_edf(tid)) {
+#if NK_OPT_READYQ
+        rq_push_head(tid);
+#if NK_CORES > 1
+        if (TASK_CPU(tid) != THIS_CPU()) hal_ipi_send(TASK_CPU(tid));
+#endif
+#else
+        ready_push_head(tid);
+#endif
+        return;
+    }
+    ready_enqueue(tid);
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * SLEEP QUEUE (delta list)
+ *═══════════════════════════════════════════════════════════════════
+ *
+ * Sleepers are kept sorted by wake time; each TCB's sleep_ticks holds
+ * the delay relative to its predecessor, so the tick only ever touches
+ * the head.  Equal wake times stay in FIFO order.
+ */
+
+static void sleepq_insert(uint8_t tid, uint16_t ticks) {
+    uint8_t *link = &nk_sched.sleep_head;
+
+    while (*link != NK_TID_NONE &&
+           TASK_SLEEP(*link) <= ticks) {
+        ticks -= TASK_SLEEP(*link);
+        link = &nk_sched.sleep_next[*link];
+    }
+    TASK_SLEEP(tid) = ticks;
+    nk_sched.sleep_next[tid] = *link;
+    if (*link != NK_TID_NONE) {
+        TASK_SLEEP(*link) -= ticks;
+    }
+    *link = tid;
+}
+
+/* Take @p tid out of the sleep queue (its time goes to the successor). */
+static void sleepq_remove(uint8_t tid) {
+    uint8_t *link = &nk_sched.sleep_head;
+
+    while (*link != NK_TID_NONE && *link != tid) {
+        link = &nk_sched.sleep_next[*link];
+    }
+    if (*link == NK_TID_NONE) return;
+    *link = nk_sched.sleep_next[tid];
+    if (*link != NK_TID_NONE) {
+        TASK_SLEEP(*link) += TASK_SLEEP(tid);
+    }
+}
+
+/* Take @p tid out of wait queue @p q. */
+static void waitq_unlink(nk_waitq_t *q, uint8_t tid) {
+    uint8_t *link = q;
+
+    while (*link && *link != tid + 1) {
+        link = &nk_sched.wait_next[*link - 1];
+    }
+    if (*link) {
+        *link = nk_sched.wait_next[tid];
+    }
+}
 
-        bool ready = (t->state == NK_READY);
+/* Advance the sleep queue by @p n ticks, waking every expired task. */
+static void sleepq_advance(uint16_t n) {
+    uint8_t h = nk_sched.sleep_head;
 
-        if (ready && t->priority < bestp) {
-            best  = idx;
-            bestp = t->priority;
+    while (h != NK_TID_NONE) {
+        if (TASK_SLEEP(h) > n) {
+            TASK_SLEEP(h) -= n;
+            break;
+        }
+        n -= TASK_SLEEP(h);
+        TASK_SLEEP(h) = 0;
+        if (nk_sched.wait_q[h]) {
+            /* Timed wait ran out before anyone woke it */
+            waitq_unlink(nk_sched.wait_q[h], h);
+            nk_sched.wait_q[h] = NULL;
+            nk_sched.expired[h] = 1;
+        }
+        make_ready(h);
+        h = nk_sched.sleep_next[h];
+    }
+    nk_sched.sleep_head = h;
+}
+
+static inline void update_sleep_timers(void) {
+    sleepq_advance(1);
+    nk_timer_advance(1);
+}
+
+#if NK_OPT_READYQ
+/*
+ * Pick the head of the highest ready level.  The running task keeps the
+ * CPU only if it is strictly higher priority; equal priority rotates.
+ */
+#if NK_CORES > 1
+static bool running_elsewhere(uint8_t tid) {
+    for (uint8_t c = 0; c < NK_CORES; ++c) {
+        if (c != THIS_CPU() && nk_sched.current[c] == tid) return true;
+    }
+    return false;
+}
+
+/*
+ * Local queue is empty and the current task cannot run: take the most
+ * urgent queue head from another core and adopt it.  A head that is
+ * still some core's current task (woken while that core idles on its
+ * stack) is left for its owner.
+ */
+static uint8_t rq_steal(void) {
+    uint8_t best = NK_CPU_NONE, bestp = NK_RQ_NONE;
+
+    for (uint8_t c = 0; c < NK_CORES; ++c) {
+        if (c == THIS_CPU()) continue;
+        uint8_t p = rq_top(c);
+        if (p >= bestp) continue;
+        if (running_elsewhere(nk_rq[c].next[nk_rq[c].tail[p]])) continue;
+        best  = c;
+        bestp = p;
+    }
+    if (best == NK_CPU_NONE) return CURRENT;
+
+    uint8_t tid = rq_pop(best, bestp);
+    TASK_CPU(tid) = THIS_CPU();
+    return tid;
+}
+#endif
+
+static uint8_t fp_next_task(void) {
+    uint8_t cur = CURRENT;
+    bool held = cur != NK_TID_NONE &&
+                TASK_STATE(cur) == NK_RUNNING;
+    uint8_t p = rq_top(THIS_CPU());
+
+    if (p == NK_RQ_NONE) {
+#if NK_CORES > 1
+        if (!held) return rq_steal();
+#endif
+        return cur;
+    }
+    if (held && !is_edf(cur) && TASK_PRIO(cur) < p) {
+        return cur;
+    }
+    return rq_pop(THIS_CPU(), p);
+}
+#else
+/* First NK_READY task in [i, end), or @p end.  With the state array on
+ * a 32-bit core, four tasks are skipped per load unless one is ready. */
+static uint8_t ready_from(uint8_t i, uint8_t end) {
+    while (i < end) {
+#if NK_OPT_SOA && HAL_WORD_SIZE >= 32
+        _Static_assert(NK_READY == 0, "word scan looks for a zero byte");
+        if ((i & 3u) == 0 && i + 4u <= end) {
+            uint32_t w;
+            memcpy(&w, &nk_sched.state[i], sizeof w);
+            if (!((w - 0x01010101u) & ~w & 0x80808080u)) {
+                i += 4;
+                continue;
+            }
+        }
+#endif
+        if (TASK_STATE(i) == NK_READY) return i;
+        ++i;
+    }
+    return end;
+}
+
+/* Most urgent ready task, the longest queued among equals */
+static uint8_t fp_next_task(void) {
+    uint8_t best  = CURRENT;
+    uint8_t bestp = 0xFF;
+    uint8_t n     = nk_sched.count;
+
+    for (uint8_t i = ready_from(0, n); i < n; i = ready_from(i + 1, n)) {
+        if (is_edf(i)) continue;
+        if (TASK_PRIO(i) < bestp ||
+            (TASK_PRIO(i) == bestp && ready_before(i, best))) {
+            best  = i;
+            bestp = TASK_PRIO(i);
         }
     }
     return best;
 }
+#endif /* NK_OPT_READYQ */
+
+static uint8_t find_next_task(void) {
+#if NK_OPT_EDF
+    uint8_t e = edf_pick();
+    if (e != NK_TID_NONE) return e;
+#endif
+    return fp_next_task();
+}
 
-#if NK_OPT_STACK_GUARD
+#if NK_OPT_STACK_GUARD && !NK_OPT_MPU_GUARD
 static void panic_stack_overflow(void) __attribute__((noreturn));
 static void panic_stack_overflow(void) {
     hal_irq_disable();
     for (;;) hal_idle();
 }
 static inline void check_canaries(void) {
-    nk_stack_t *stk = &nk_stacks[nk_sched.current];
-    if (stk->guard_lo != STACK_GUARD_PATTERN ||
-        stk->guard_hi != STACK_GUARD_PATTERN) {
+    uint8_t tid = CURRENT;
+    if (!stack_pooled(tid)) return;      /* caller-owned, no guards */
+
+    uint8_t *data = nk_stk.base[tid];
+    uint32_t lo, hi;
+    memcpy(&lo, data - sizeof lo, sizeof lo);
+    memcpy(&hi, data + nk_stk.size[tid], sizeof hi);
+    if (lo != STACK_GUARD_PATTERN || hi != STACK_GUARD_PATTERN) {
         panic_stack_overflow();
     }
 }
 #endif
 
 static void switch_to(uint8_t next) {
-    if (next == nk_sched.current) return;
+    if (next == CURRENT) {
+        /* Picked ourselves (e.g. woken while idling): hold the CPU again */
+        if (nk_sched.count && TASK_STATE(next) == NK_READY) {
+            TASK_STATE(next) = NK_RUNNING;
+        }
+        return;
+    }
 
-#if NK_OPT_STACK_GUARD
+#if NK_OPT_MPU_GUARD
+    hal_mpu_stack_guard(nk_stk.base[next]);
+#elif NK_OPT_STACK_GUARD
     check_canaries();
 #endif
 
-    nk_tcb_t *from = nk_sched.tasks[nk_sched.current];
+    nk_tcb_t *from = nk_sched.tasks[CURRENT];
     nk_tcb_t *to   = nk_sched.tasks[next];
 
-    if (from->state == NK_RUNNING) from->state = NK_READY;
-    to->state = NK_RUNNING;
+#if NK_OPT_STATS
+    if (IN_TICK) nk_stats[CURRENT].invol_switches++;
+    else         nk_stats[CURRENT].vol_switches++;
+    nk_stats[next].last_run = nk_sched.ticks;
+#endif
+
+    if (TASK_STATE(CURRENT) == NK_RUNNING) {
+        TASK_STATE(CURRENT) = NK_READY;
+        ready_requeue(CURRENT);
+    }
+    TASK_STATE(next) = NK_RUNNING;
+
+    QUANTUM = nk_sched.slice[next];
+#if NK_OPT_TLS
+    nk_tls_self = nk_sched.tls[next];
+#endif
+
+#if NK_CORES > 1
+    uint8_t self = CURRENT;
+    nk_smp.saved_depth[self] = nk_smp.depth;
+    nk_smp.saved_irq[self]   = nk_smp.irq;
+#endif
+    nk_trace_switch(CURRENT, next);
+    CURRENT = next;
+    nk_context_switch((hal_context_t *)&from->sp, (hal_context_t *)&to->sp);
+#if NK_CORES > 1
+    /* Resumed, maybe on another core, holding the lock our switcher took */
+    nk_smp.owner = hal_cpu_id();
+    nk_smp.depth = nk_smp.saved_depth[self];
+    nk_smp.irq   = nk_smp.saved_irq[self];
+#endif
+}
+
+/*
+ * Nothing else is runnable and the current task just blocked: idle on
+ * its stack until an interrupt makes something ready.  In tickless mode
+ * the periodic tick is replaced by a one-shot at the earliest sleep
+ * deadline and the elapsed ticks are replayed on wake-up.  The idle
+ * governor chooses how deep to sleep from the distance to that deadline.
+ */
+static void idle_wait(void) {
+#if NK_OPT_TICKLESS
+    uint8_t  h = nk_sched.sleep_head;
+    uint16_t next = nk_timer_next();
+    if (h != NK_TID_NONE && TASK_SLEEP(h) < next) {
+        next = TASK_SLEEP(h);
+    }
+    hal_timer_oneshot(next);
+    sched_unlock();
+    nk_idle_enter(next);
+    sched_lock();
+    uint16_t elapsed = hal_timer_resume();
+    nk_sched.ticks += elapsed;
+    nk_sched.tick_cyc = hal_cycles();
+    sleepq_advance(elapsed);
+    nk_timer_advance(elapsed);
+#else
+    sched_unlock();
+    nk_idle_enter(1);                   /* the tick is always one away */
+    sched_lock();
+#endif
+}
 
-    nk_sched.current = next;
-    hal_context_switch((hal_context_t *)&from->sp, (hal_context_t *)&to->sp);
+static inline bool runnable(uint8_t tid) {
+    return TASK_STATE(tid) == NK_RUNNING || TASK_STATE(tid) == NK_READY;
 }
 
+/* Called inside sched_lock(); returns with it released. */
 static inline void atomic_schedule(void) {
-    hal_irq_disable();
-    switch_to(find_next_task());
-    hal_irq_enable();
+    uint8_t next = find_next_task();
+    while (next == CURRENT && nk_sched.count &&
+           !runnable(next)) {
+        idle_wait();
+        next = find_next_task();
+    }
+    switch_to(next);
+    sched_unlock();
+#if NK_OPT_SIGNALS
+    if (SIG_READY(CURRENT) && sig_unlocked()) nk_sig_deliver();
+#endif
 }
 
 void scheduler_init(void) {
-#if NK_OPT_STACK_GUARD
-    for (uint8_t i = 0; i < CONFIG_KERNEL_TASK_MAX; ++i) {
-        nk_stacks[i].guard_lo = STACK_GUARD_PATTERN;
-        nk_stacks[i].guard_hi = STACK_GUARD_PATTERN;
-    }
+    nk_stk.brk = 0;
+#if NK_OPT_READYQ
+    rq_init();
 #endif
-    hal_timer_init(1000);
     nk_sched.count = 0;
-    nk_sched.current = 0;
-    nk_sched.quantum = NK_QUANTUM_MS;
+    for (uint8_t c = 0; c < NK_CORES; ++c) {
+        nk_sched.current[c] = NK_TID_NONE;      /* until scheduler_run() */
+        nk_sched.quantum[c] = NK_QUANTUM_MS;
+        nk_sched.in_tick[c] = 0;
+    }
+    nk_sched.sleep_head = NK_TID_NONE;
+    nk_trace_init();
+    nk_log_init();
+    hal_timer_init(1000);
+}
+
+#if NK_CORES > 1
+static nk_task_fn nk_entry[CONFIG_KERNEL_TASK_MAX];
+
+/* First run of a task: drop the lock handed over by switch_to(). */
+static void task_trampoline(void) {
+    uint8_t tid = CURRENT;
+
+    nk_smp.owner = NK_CPU_NONE;
+    nk_smp.depth = 0;
+    nk_spinlock_unlock_rt(&nk_sched_spin);
+    hal_irq_enable();
+    nk_entry[tid]();
+    nk_task_exit(0);
+}
+#endif
+
+/*
+ * Released slots point at nk_dead, so every scan over tasks[] still
+ * sees a terminated task there, and not whatever the old TCB's owner
+ * has since reused its memory for.
+ */
+#if NK_OPT_SOA
+static nk_tcb_t nk_dead;
+#else
+static nk_tcb_t nk_dead = { .state = NK_TERMINATED };
+#endif
+
+static inline void slot_free(uint8_t tid) {
+    nk_sched.tasks[tid] = &nk_dead;
+    TASK_STATE(tid) = NK_TERMINATED;
+    nk_sched.detached[tid] = 0;
+}
+
+/* Under sched_lock(): a released slot, else a new one; parks @p tcb there */
+static uint8_t slot_claim(nk_tcb_t *tcb) {
+    uint8_t tid = 0;
+
+    while (tid < nk_sched.count && nk_sched.tasks[tid] != &nk_dead) ++tid;
+    if (tid == CONFIG_KERNEL_TASK_MAX) return NK_TID_NONE;
+    if (tid == nk_sched.count) {
+        nk_stk.base[tid] = NULL;
+        nk_sched.count++;
+    }
+    nk_sched.tasks[tid] = tcb;
+    TASK_STATE(tid) = NK_TERMINATED;        /* not runnable until filled in */
+    return tid;
 }
 
 bool nk_task_create(nk_tcb_t *tcb, nk_task_fn entry, uint8_t prio, void *stack, size_t stack_len) {
     if (!tcb || !entry) return false;
-    if (nk_sched.count >= CONFIG_KERNEL_TASK_MAX) return false;
+    if (stack_len > UINT16_MAX) return false;
 
+    uint16_t len = stack ? (uint16_t)stack_len
+                         : (stack_len ? (uint16_t)stack_len
+                                      : CONFIG_KERNEL_STACK_SIZE);
+    sched_lock();
+    uint8_t tid = slot_claim(tcb);
+    if (tid == NK_TID_NONE) {
+        sched_unlock();
+        return false;
+    }
     if (!stack) {
-#if NK_OPT_STACK_GUARD
-        stack = nk_stacks[nk_sched.count].data;
-        stack_len = CONFIG_KERNEL_STACK_SIZE;
-#else
-        stack = nk_stacks[nk_sched.count];
-        stack_len = CONFIG_KERNEL_STACK_SIZE;
+        /* A recycled slot hands its pooled stack on if the task fits */
+        if (stack_pooled(tid) && len <= nk_stk.size[tid]) {
+            stack = nk_stk.base[tid];
+            len = nk_stk.size[tid];
+        } else {
+            stack = stack_alloc(&len);
+        }
+    }
+#if NK_OPT_MPU_GUARD
+    else {
+        stack = stack_trim(stack, &len);
+    }
 #endif
+    if (!stack) {
+        slot_free(tid);
+        sched_unlock();
+        return false;
     }
+    nk_stk.base[tid] = stack;
+    nk_stk.size[tid] = len;
+    sched_unlock();
+    stack_len = len;
+    hal_memset_fast(stack, NK_STACK_PAINT, stack_len);
 
-    hal_context_init((hal_context_t *)&tcb->sp, entry, stack, stack_len);
-    tcb->state = NK_READY;
-    tcb->priority = (prio & 0x3F);
-    tcb->pid = nk_sched.count;
-    tcb->sleep_ticks = 0;
+#if NK_CORES > 1
+    nk_entry[tid] = entry;
+    nk_context_init((hal_context_t *)&tcb->sp, task_trampoline, stack, stack_len);
+#else
+    nk_context_init((hal_context_t *)&tcb->sp, entry, stack, stack_len);
+#endif
+    TASK_PRIO(tid) = (prio & 0x3F);
+    TASK_BASE_PRIO(tid) = TASK_PRIO(tid);
+    tcb->pid = tid;
+    TASK_SLEEP(tid) = 0;
 
-    hal_irq_disable();
-    nk_sched.tasks[nk_sched.count++] = tcb;
-    hal_irq_enable();
+    sched_lock();
+    TASK_STATE(tid) = NK_READY;
+    nk_sched.slice[tid] = NK_QUANTUM_MS;
+    nk_sched.policy[tid] = NK_SCHED_RR;
+#if NK_OPT_TLS
+    nk_sched.tls[tid] = NULL;
+#endif
+    nk_sched.detached[tid] = 0;
+#if NK_OPT_EDF
+    nk_edf.period[tid] = 0;
+#endif
+#if NK_OPT_SIGNALS
+    nk_sig.pending[tid] = 0;
+    nk_sig.suspended[tid] = 0;
+    nk_sig.blocked[tid] = CURRENT < nk_sched.count ? nk_sig.blocked[CURRENT] : 0;
+#endif
+#if NK_OPT_STATS
+    memset(&nk_stats[tid], 0, sizeof nk_stats[tid]);
+#endif
+#if NK_CORES > 1
+    TASK_CPU(tid) = (uint8_t)(tid % NK_CORES);
+#endif
+    ready_enqueue(tid);
+    sched_unlock();
     return true;
 }
 
+/* Where each core's boot code is parked once it starts its first task */
+static hal_context_t nk_boot_ctx[NK_CORES];
+
 void scheduler_run(void) {
-    hal_irq_enable();
-    switch_to(find_next_task());
+    sched_lock();
+    uint8_t next = find_next_task();
+    while (next == NK_TID_NONE) {
+        sched_unlock();
+        hal_idle();
+        sched_lock();
+        next = find_next_task();
+    }
+
+    nk_tcb_t *to = nk_sched.tasks[next];
+    TASK_STATE(next) = NK_RUNNING;
+#if NK_OPT_STATS
+    nk_stats[next].last_run = nk_sched.ticks;
+#endif
+    QUANTUM = nk_sched.slice[next];
+#if NK_OPT_TLS
+    nk_tls_self = nk_sched.tls[next];
+#endif
+    nk_trace_switch(NK_TID_NONE, next);
+#if NK_OPT_MPU_GUARD
+    hal_mpu_stack_guard(nk_stk.base[next]);
+#endif
+    CURRENT = next;
+    nk_context_switch(&nk_boot_ctx[THIS_CPU()], (hal_context_t *)&to->sp);
     for (;;) hal_idle();
 }
 
 void nk_yield(void) {
-    hal_irq_disable();
-    nk_sched.quantum = 0;
+    sched_lock();
     atomic_schedule();
 }
 
 void nk_sleep(uint16_t ms) {
-    hal_irq_disable();
-    nk_tcb_t *t = nk_sched.tasks[nk_sched.current];
-    t->state = NK_SLEEPING;
-    t->sleep_ticks = ms;
+    if (!ms) {
+        nk_yield();
+        return;
+    }
+    sched_lock();
+    TASK_STATE(CURRENT) = NK_SLEEPING;
+    sleepq_insert(CURRENT, ms);
+    atomic_schedule();
+}
+
+uint8_t nk_current_tid(void) { return CURRENT; }
+
+#if defined(__AVR__)
+/* hal_eeprom_flush(): run other tasks while queued EEPROM writes drain */
+void hal_eeprom_wait_hook(void) {
+    if (CURRENT == NK_TID_NONE) {
+        hal_idle();
+    } else {
+        nk_yield();
+    }
+}
+#endif
+
+uint32_t nk_sched_lock(void) { return sched_save(); }
+void nk_sched_unlock(uint32_t s) { sched_restore(s); }
+
+/*═══════════════════════════════════════════════════════════════════
+ * PRIORITY INHERITANCE
+ *═══════════════════════════════════════════════════════════════════*/
+
+static void set_priority(uint8_t tid, uint8_t prio) {
+    if (TASK_PRIO(tid) == prio) return;
+#if NK_OPT_READYQ
+    if (TASK_STATE(tid) == NK_READY && !is_edf(tid)) {
+        rq_remove(tid);
+        TASK_PRIO(tid) = prio;
+        rq_push(tid);
+        return;
+    }
+#endif
+    TASK_PRIO(tid) = prio;
+}
+
+void nk_task_boost(uint8_t tid, uint8_t prio) {
+    if (tid >= nk_sched.count) return;
+    uint32_t s = sched_save();
+    if ((prio & 0x3F) < TASK_PRIO(tid)) {
+        set_priority(tid, prio & 0x3F);
+    }
+    sched_restore(s);
+}
+
+void nk_task_unboost(uint8_t tid) {
+    if (tid >= nk_sched.count) return;
+    uint32_t s = sched_save();
+    set_priority(tid, TASK_BASE_PRIO(tid));
+    sched_restore(s);
+}
+
+uint8_t nk_task_priority(uint8_t tid) {
+    return tid < nk_sched.count ? TASK_PRIO(tid) : 0xFF;
+}
+
+uint8_t nk_task_cpu(uint8_t tid) {
+    return tid < nk_sched.count ? TASK_CPU(tid) : 0;
+}
+
+bool nk_task_set_priority(uint8_t tid, uint8_t prio) {
+    if (tid >= nk_sched.count) return false;
+    prio &= 0x3F;
+
+    uint32_t s = sched_save();
+    bool boosted = TASK_PRIO(tid) < TASK_BASE_PRIO(tid);
+    TASK_BASE_PRIO(tid) = prio;
+    if (!boosted || prio < TASK_PRIO(tid)) {
+        set_priority(tid, prio);
+    }
+    sched_restore(s);
+    return true;
+}
+
+bool nk_task_running(uint8_t tid) {
+    return tid < nk_sched.count && TASK_STATE(tid) == NK_RUNNING;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * TIME SLICE
+ *═══════════════════════════════════════════════════════════════════*/
+
+bool nk_task_set_quantum(uint8_t tid, uint8_t ticks) {
+    if (tid >= nk_sched.count) return false;
+    nk_sched.slice[tid] = ticks ? ticks : NK_QUANTUM_MS;
+    return true;
+}
+
+uint8_t nk_task_quantum(uint8_t tid) {
+    return tid < nk_sched.count ? nk_sched.slice[tid] : 0;
+}
+
+bool nk_task_set_policy(uint8_t tid, uint8_t policy) {
+    if (tid >= nk_sched.count ||
+        (policy != NK_SCHED_RR && policy != NK_SCHED_FIFO)) return false;
+    nk_sched.policy[tid] = policy;
+    return true;
+}
+
+uint8_t nk_task_policy(uint8_t tid) {
+    return tid < nk_sched.count ? nk_sched.policy[tid] : 0xFF;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * THREAD-LOCAL STORAGE
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if NK_OPT_TLS
+void *nk_tls_self;
+
+bool nk_task_set_tls(uint8_t tid, void *block) {
+    if (tid >= nk_sched.count) return false;
+    uint32_t s = sched_save();
+    nk_sched.tls[tid] = block;
+    if (tid == CURRENT) nk_tls_self = block;
+    sched_restore(s);
+    return true;
+}
+
+void *nk_task_tls(uint8_t tid) {
+    return tid < nk_sched.count ? nk_sched.tls[tid] : NULL;
+}
+#else
+bool nk_task_set_tls(uint8_t tid, void *block) { (void)tid; (void)block; return false; }
+void *nk_task_tls(uint8_t tid) { (void)tid; return NULL; }
+#endif
+
+#ifdef CONFIG_KERNEL_SCHED_TYPE_PREEMPT
+/* A ready task more urgent than @p tid (what ends a FIFO task's turn). */
+static bool outranked(uint8_t tid) {
+    uint8_t prio = TASK_PRIO(tid);
+#if NK_OPT_READYQ
+    uint8_t p = rq_top(THIS_CPU());
+    return p != NK_RQ_NONE && p < prio;
+#else
+    uint8_t n = nk_sched.count;
+    for (uint8_t i = ready_from(0, n); i < n; i = ready_from(i + 1, n)) {
+        if (!is_edf(i) && TASK_PRIO(i) < prio) {
+            return true;
+        }
+    }
+    return false;
+#endif
+}
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * WAIT QUEUES
+ *═══════════════════════════════════════════════════════════════════*/
+
+void nk_waitq_init(nk_waitq_t *q) {
+    *q = NK_WAITQ_INIT;
+}
+
+void nk_waitq_block(nk_waitq_t *q) {
+    uint8_t tid  = CURRENT;
+    uint8_t prio = TASK_PRIO(tid);
+    uint8_t *link = q;
+
+    while (*link && TASK_PRIO(*link - 1) <= prio) {
+        link = &nk_sched.wait_next[*link - 1];
+    }
+    nk_sched.wait_next[tid] = *link;
+    *link = (uint8_t)(tid + 1);
+
+    TASK_STATE(tid) = NK_BLOCKED;
     atomic_schedule();
 }
 
-uint8_t nk_current_tid(void) { return nk_sched.current; }
+int nk_waitq_block_timeout(nk_waitq_t *q, uint16_t ticks) {
+    uint8_t tid = CURRENT;
+
+    if (!ticks) {
+        sched_unlock();
+        return -1;
+    }
+    nk_sched.wait_q[tid] = q;
+    nk_sched.expired[tid] = 0;
+    sleepq_insert(tid, ticks);
+    nk_waitq_block(q);
+    return nk_sched.expired[tid] ? -1 : 0;
+}
+
+int nk_waitq_wake_one(nk_waitq_t *q) {
+    uint32_t s = sched_save();
+    int tid = -1;
+
+    if (*q) {
+        tid = *q - 1;
+        *q = nk_sched.wait_next[tid];
+        if (nk_sched.wait_q[tid]) {
+            sleepq_remove((uint8_t)tid);  /* timed waiter: cancel timeout */
+            nk_sched.wait_q[tid] = NULL;
+        }
+        make_ready((uint8_t)tid);
+    }
+    sched_restore(s);
+    return tid;
+}
+
+uint8_t nk_waitq_wake_all(nk_waitq_t *q) {
+    uint8_t n = 0;
+    while (nk_waitq_wake_one(q) >= 0) ++n;
+    return n;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * ADDRESS-KEYED WAIT
+ *═══════════════════════════════════════════════════════════════════
+ *
+ * Waiters share a few hashed wait queues and remember the address they
+ * sleep on; nk_wake() walks the bucket and wakes only matching tasks.
+ */
+
+static nk_waitq_t nk_futex_q[NK_FUTEX_BUCKETS];
+static volatile uint8_t *nk_futex_addr[CONFIG_KERNEL_TASK_MAX];
+
+static inline nk_waitq_t *futex_bucket(volatile uint8_t *addr) {
+    uintptr_t a = (uintptr_t)addr;
+    return &nk_futex_q[(a ^ (a >> 3)) & (NK_FUTEX_BUCKETS - 1)];
+}
+
+int nk_wait_on(volatile uint8_t *addr, uint8_t expected) {
+    sched_lock();
+    if (*addr != expected) {
+        sched_unlock();
+        return -1;
+    }
+    nk_futex_addr[CURRENT] = addr;
+    nk_waitq_block(futex_bucket(addr));
+    return 0;
+}
+
+uint8_t nk_wake(volatile uint8_t *addr, uint8_t n) {
+    uint32_t s = sched_save();
+    uint8_t *link = futex_bucket(addr);
+    uint8_t woken = 0;
+
+    while (*link && woken < n) {
+        uint8_t tid = (uint8_t)(*link - 1);
+        if (nk_futex_addr[tid] == addr) {
+            *link = nk_sched.wait_next[tid];
+            nk_futex_addr[tid] = NULL;
+            make_ready(tid);
+            ++woken;
+        } else {
+            link = &nk_sched.wait_next[tid];
+        }
+    }
+    sched_restore(s);
+    return woken;
+}
 
+int nk_task_stats(uint8_t tid, nk_task_stats_t *out) {
+#if NK_OPT_STATS
+    if (tid >= nk_sched.count || !out) return -1;
+    uint32_t s = sched_save();
+    *out = nk_stats[tid];
+    sched_restore(s);
+    return 0;
+#else
+    (void)tid; (void)out;
+    return -1;
+#endif
+}
+
+uint32_t nk_ticks(void) {
+    uint32_t s = sched_save();
+    uint32_t t = nk_sched.ticks;
+    sched_restore(s);
+    return t;
+}
+
+uint32_t nk_ticks_fine(uint32_t *since) {
+    uint32_t s = sched_save();
+    uint32_t t = nk_sched.ticks;
+    *since = hal_cycles() - nk_sched.tick_cyc;
+    sched_restore(s);
+    return t;
+}
+
+int nk_task_stack_size(uint8_t tid) {
+    if (tid >= nk_sched.count) return -1;
+    return nk_stk.size[tid];
+}
+
+int nk_task_stack_usage(uint8_t tid) {
+    if (tid >= nk_sched.count) return -1;
+
+    const uint8_t *p   = nk_stk.base[tid];
+    const uint8_t *end = p + nk_stk.size[tid];
+
+#if UINTPTR_MAX > 0xFFFFu
+    /* Word-at-a-time over the aligned middle of the stack */
+    while (p < end && ((uintptr_t)p & 3u) && *p == NK_STACK_PAINT) ++p;
+    if (!((uintptr_t)p & 3u)) {
+        while (p + 4 <= end &&
+               *(const uint32_t *)p == NK_STACK_PAINT * 0x01010101u) {
+            p += 4;
+        }
+    }
+#endif
+    while (p < end && *p == NK_STACK_PAINT) ++p;
+
+    return (int)(end - p);
+}
+
+__attribute__((weak))
+void nk_task_exit_hook(uint8_t tid) {
+    (void)tid;
+}
+
+/*
+ * The joiner is woken and a detached slot freed under the same lock
+ * that switches away, so neither can reuse this stack before we are
+ * off it.  The exit hook runs first, unlocked, since it may block.
+ */
 void nk_task_exit(int status) {
     (void)status;
-    hal_irq_disable();
-    nk_sched.tasks[nk_sched.current]->state = NK_TERMINATED;
+    nk_task_exit_hook(CURRENT);
+    sched_lock();
+    uint8_t self = CURRENT;
+    TASK_STATE(self) = NK_TERMINATED;
+#if NK_OPT_EDF
+    edf_release(self);
+#endif
+    nk_waitq_wake_all(&nk_sched.exit_q[self]);
+    if (nk_sched.detached[self]) {
+        slot_free(self);
+    }
     atomic_schedule();
     for (;;) hal_idle();
 }
 
+int nk_task_wait(uint8_t tid) {
+    sched_lock();
+    if (tid >= nk_sched.count || tid == CURRENT) {
+        sched_unlock();
+        return -1;
+    }
+    while (TASK_STATE(tid) != NK_TERMINATED) {
+        nk_waitq_block(&nk_sched.exit_q[tid]);
+        sched_lock();
+    }
+    sched_unlock();
+    return 0;
+}
+
+void nk_task_release(uint8_t tid) {
+    sched_lock();
+    if (tid < nk_sched.count && nk_sched.tasks[tid] != &nk_dead) {
+        if (TASK_STATE(tid) == NK_TERMINATED) {
+            slot_free(tid);
+        } else {
+            nk_sched.detached[tid] = 1;
+        }
+    }
+    sched_unlock();
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * SIGNALS
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if NK_OPT_SIGNALS
+
+void nk_sig_dispatch(nk_sig_fn fn) {
+    nk_sig.fn = fn;
+}
+
+int nk_sig_post(uint8_t tid, uint8_t sig) {
+    if (sig > NK_SIG_MAX) return -1;
+
+    uint32_t s = sched_save();
+    if (tid >= nk_sched.count ||
+        TASK_STATE(tid) == NK_TERMINATED) {
+        sched_restore(s);
+        return -1;
+    }
+    if (sig == 0) {                     /* existence check only */
+        sched_restore(s);
+        return 0;
+    }
+    nk_sig.pending[tid] |= NK_SIG_BIT(sig);
+    if (!(nk_sig.blocked[tid] & NK_SIG_BIT(sig))) {
+        if (TASK_STATE(tid) == NK_SLEEPING && !nk_sched.wait_q[tid]) {
+            sleepq_remove(tid);         /* nk_sleep(): cut it short */
+            make_ready(tid);
+        } else if (TASK_STATE(tid) == NK_BLOCKED && nk_sig.suspended[tid]) {
+            nk_sig.suspended[tid] = 0;
+            make_ready(tid);
+        }
+    }
+    sched_restore(s);
+    return 0;
+}
+
+nk_sigset_t nk_sig_setmask(nk_sigset_t mask) {
+    nk_sigset_t old = nk_sig.blocked[CURRENT];
+    nk_sig.blocked[CURRENT] = mask;
+    return old;
+}
+
+nk_sigset_t nk_sig_blocked(void) {
+    return nk_sig.blocked[CURRENT];
+}
+
+nk_sigset_t nk_sig_pending(void) {
+    return nk_sig.pending[CURRENT];
+}
+
+void nk_sig_deliver(void) {
+    uint8_t self = CURRENT;
+
+    for (;;) {
+        uint32_t s = sched_save();
+        nk_sigset_t ready = SIG_READY(self);
+        if (!ready) {
+            sched_restore(s);
+            return;
+        }
+        uint8_t sig = 1;
+        while (!(ready & 1)) {
+            ready >>= 1;
+            sig++;
+        }
+        nk_sig.pending[self] &= ~NK_SIG_BIT(sig);
+        nk_sig_fn fn = nk_sig.fn;
+        sched_restore(s);
+        if (fn) fn(sig);
+    }
+}
+
+int nk_sig_suspend(nk_sigset_t mask) {
+    uint8_t self = CURRENT;
+    nk_sigset_t old = nk_sig_setmask(mask);
+
+    /* The wake-up may already have delivered on the way out of
+     * atomic_schedule(), so wait for nk_sig_post() to clear the flag
+     * rather than for a signal to be left pending. */
+    sched_lock();
+    if (!SIG_READY(self)) {
+        nk_sig.suspended[self] = 1;
+        do {
+            TASK_STATE(self) = NK_BLOCKED;
+            atomic_schedule();
+            sched_lock();
+        } while (nk_sig.suspended[self]);
+    }
+    sched_unlock();
+    nk_sig_deliver();
+    nk_sig_setmask(old);
+    return 0;
+}
+
+#else
+
+void nk_sig_dispatch(nk_sig_fn fn) { (void)fn; }
+int nk_sig_post(uint8_t tid, uint8_t sig) { (void)tid; (void)sig; return -1; }
+nk_sigset_t nk_sig_setmask(nk_sigset_t mask) { (void)mask; return 0; }
+nk_sigset_t nk_sig_blocked(void) { return 0; }
+nk_sigset_t nk_sig_pending(void) { return 0; }
+void nk_sig_deliver(void) { }
+int nk_sig_suspend(nk_sigset_t mask) { (void)mask; return -1; }
+
+#endif /* NK_OPT_SIGNALS */
+
+#if NK_OPT_EDF
+/*═══════════════════════════════════════════════════════════════════
+ * EDF API
+ *═══════════════════════════════════════════════════════════════════*/
+
+bool nk_task_set_deadline(uint8_t tid, uint16_t period, uint16_t budget) {
+    if (tid >= nk_sched.count) return false;
+    if (period && (!budget || budget > period)) return false;
+
+    uint32_t s = sched_save();
+    uint32_t old = nk_edf.period[tid]
+        ? ((uint32_t)nk_edf.budget[tid] << 16) / nk_edf.period[tid] : 0;
+    uint32_t add = period ? ((uint32_t)budget << 16) / period : 0;
+
+    /* Admission test: total utilisation must stay <= 1 */
+    if (nk_edf.util - old + add > (1UL << 16)) {
+        sched_restore(s);
+        return false;
+    }
+    nk_edf.util = nk_edf.util - old + add;
+
+#if NK_OPT_READYQ
+    if (TASK_STATE(tid) == NK_READY && !is_edf(tid)) rq_remove(tid);
+#endif
+    nk_edf.period[tid]   = period;
+    nk_edf.budget[tid]   = budget;
+    nk_edf.left[tid]     = budget;
+    nk_edf.deadline[tid] = nk_sched.ticks + period;
+    nk_edf.flags[tid]    = 0;
+    if (TASK_STATE(tid) == NK_READY) ready_enqueue(tid);
+    sched_restore(s);
+    return true;
+}
+
+void nk_task_wait_period(void) {
+    uint8_t tid = CURRENT;
+    if (!is_edf(tid)) {
+        nk_yield();
+        return;
+    }
+    sched_lock();
+    nk_edf.flags[tid] |= EDF_WAIT;
+    TASK_STATE(tid) = NK_BLOCKED;
+    atomic_schedule();
+}
+
+/* Charge the running task and release new periods; true = reschedule. */
+static bool edf_tick(void) {
+    bool resched = false;
+    uint8_t cur = CURRENT;
+
+    if (cur != NK_TID_NONE && is_edf(cur) && nk_edf.left[cur] &&
+        TASK_STATE(cur) == NK_RUNNING) {
+        if (--nk_edf.left[cur] == 0) resched = true;    /* throttled */
+    }
+
+    for (uint8_t i = 0; i < nk_sched.count; ++i) {
+        if (!is_edf(i)) continue;
+        if ((int32_t)(nk_sched.ticks - nk_edf.deadline[i]) < 0) continue;
+
+        nk_edf.deadline[i] += nk_edf.period[i];
+        nk_edf.left[i] = nk_edf.budget[i];
+        if (nk_edf.flags[i] & EDF_WAIT) {
+            nk_edf.flags[i] &= (uint8_t)~EDF_WAIT;
+            make_ready(i);
+        }
+        resched = true;
+    }
+    return resched;
+}
+#endif /* NK_OPT_EDF */
+
+/*
+ * Leaving the tick: on the stack of the task it returns to, so pending
+ * signals run there as if the task had called in at the point it was
+ * interrupted.
+ */
+static inline void sig_tick_exit(void) {
+#if NK_OPT_SIGNALS && defined(CONFIG_KERNEL_SCHED_TYPE_PREEMPT) && !HAL_SWITCH_DEFERRED
+    if (SIG_READY(CURRENT)) {
+        hal_irq_enable();
+        nk_sig_deliver();
+        hal_irq_disable();
+    }
+#endif
+}
+
 void hal_timer_tick_handler(void) {
-    update_sleep_timers();
+    sched_isr_enter();
+    if (THIS_CPU() == 0) {              /* global time runs on core 0 */
+        nk_sched.ticks++;
+        nk_sched.tick_cyc = hal_cycles();
+        update_sleep_timers();
+    }
+    if (CURRENT == NK_TID_NONE) {       /* scheduler_run() not reached */
+        sched_isr_exit();
+        return;
+    }
+#if NK_OPT_STATS
+    nk_stats[CURRENT].run_ticks++;
+#endif
+    IN_TICK = 1;
+#if NK_OPT_EDF && defined(CONFIG_KERNEL_SCHED_TYPE_PREEMPT)
+    if (edf_tick()) {
+        QUANTUM = nk_sched.slice[CURRENT];
+        switch_to(find_next_task());
+        IN_TICK = 0;
+        sched_isr_exit();
+        sig_tick_exit();
+        return;
+    }
+#elif NK_OPT_EDF
+    edf_tick();
+#endif
 #ifdef CONFIG_KERNEL_SCHED_TYPE_PREEMPT
-    if (--nk_sched.quantum == 0) {
-        nk_sched.quantum = NK_QUANTUM_MS;
+    if (nk_sched.policy[CURRENT] == NK_SCHED_FIFO) {
+        if (outranked(CURRENT)) switch_to(find_next_task());
+    } else if (QUANTUM && --QUANTUM == 0) {
         uint8_t next = find_next_task();
-        if (next != nk_sched.current) {
-            switch_to(next);
+        if (next != CURRENT) {
+            switch_to(next);            /* reloads the incoming slice */
+        } else {
+            QUANTUM = nk_sched.slice[CURRENT];
         }
     }
 #endif
+    IN_TICK = 0;
+    sched_isr_exit();
+    sig_tick_exit();
 }
 
+#if NK_CORES > 1
+__attribute__((weak))
+void nk_ipi_hook(void) {
+}
+
+/* Another core queued work for us: pick up anything more urgent. */
+void hal_ipi_handler(void) {
+    nk_ipi_hook();
+    sched_isr_enter();
+    if (CURRENT != NK_TID_NONE) {
+        uint8_t next = find_next_task();
+        if (next != CURRENT) switch_to(next);
+    }
+    sched_isr_exit();
+}
+#endif
+
 #endif /* CONFIG_KERNEL_SCHED_TYPE... */
 
 /* Aliases */
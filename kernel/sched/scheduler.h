@@ -20,6 +20,23 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "avrix-config.h"
+
+/**
+ * @brief Per-field task arrays instead of per-task fields
+ *
+ * State, priority and sleep delta live in dense arrays indexed by TID
+ * inside the scheduler, so scans read contiguous bytes instead of
+ * following one TCB pointer per task.  The TCB keeps the saved context.
+ * Follows kernel_sched_soa.
+ */
+#ifndef NK_OPT_SOA
+#  if defined(CONFIG_KERNEL_SCHED_SOA) && CONFIG_KERNEL_SCHED_SOA
+#    define NK_OPT_SOA 1
+#  else
+#    define NK_OPT_SOA 0
+#  endif
+#endif
 
 /*═══════════════════════════════════════════════════════════════════
  * TASK STATES
@@ -42,14 +59,21 @@ typedef enum {
  * @brief Task Control Block (TCB)
  *
  * Stores all state for a single task. Size is kept minimal (8-10 bytes)
- * to fit many tasks in constrained SRAM.
+ * to fit many tasks in constrained SRAM.  With NK_OPT_SOA the scheduling
+ * fields move into the scheduler's arrays; read them with
+ * nk_task_priority() and friends rather than through the TCB.
  */
 typedef struct nk_tcb {
     uint16_t sp;                /**< Saved stack pointer */
+#if !NK_OPT_SOA
     uint8_t  state;             /**< Task state (nk_state_t) */
-    uint8_t  priority;          /**< Priority (0 = highest, 63 = lowest) */
+    uint8_t  priority;          /**< Effective priority (0 = highest, 63 = lowest) */
+    uint8_t  base_priority;     /**< Assigned priority, before inheritance */
+#endif
     uint8_t  pid;               /**< Task ID (0 to max-1) */
-    uint16_t sleep_ticks;       /**< Remaining sleep time (ms) */
+#if !NK_OPT_SOA
+    uint16_t sleep_ticks;       /**< Sleep delta after previous sleeper (ms) */
+#endif
 
 #if NK_OPT_DAG_WAIT
     uint8_t  deps;              /**< DAG dependency count */
@@ -90,9 +114,11 @@ void scheduler_run(void) __attribute__((noreturn));
  * @param tcb Pointer to task control block (caller-allocated)
  * @param entry Task entry point function
  * @param prio Priority (0 = highest, 63 = lowest)
- * @param stack Pointer to stack buffer (or NULL for internal stack)
- * @param stack_len Stack size in bytes
- * @return true on success, false on failure
+ * @param stack Pointer to stack buffer (or NULL to carve one from the
+ *              kernel stack pool)
+ * @param stack_len Stack size in bytes; with a pooled stack, 0 selects
+ *                  CONFIG_KERNEL_STACK_SIZE
+ * @return true on success, false on failure (including pool exhausted)
  */
 bool nk_task_create(nk_tcb_t *tcb,
                     nk_task_fn entry,
@@ -123,6 +149,129 @@ void nk_sleep(uint16_t ms);
  */
 uint8_t nk_current_tid(void);
 
+/**
+ * @brief Enter a scheduler critical section
+ *
+ * Masks interrupts and, with kernel_smp_cores > 1, takes the scheduler
+ * spinlock.  Nests, and is safe from ISRs.  Code that tests a condition
+ * and then blocks on a wait queue must hold this across both.
+ *
+ * @return Saved state for nk_sched_unlock()
+ */
+uint32_t nk_sched_lock(void);
+
+/**
+ * @brief Leave a scheduler critical section
+ *
+ * @param s Value returned by the matching nk_sched_lock()
+ */
+void nk_sched_unlock(uint32_t s);
+
+/**
+ * @brief Set a task's time slice
+ *
+ * The slice is reloaded every time the task is switched in; when it runs
+ * out the tick rotates to the next task of equal or higher priority.
+ * Short slices suit interactive tasks, long ones cut switch overhead for
+ * CPU-bound work.  New tasks start with the default of 10 ticks.
+ *
+ * @param tid   Task ID
+ * @param ticks Slice in ticks (0 = back to the default)
+ * @return true on success, false if tid is invalid
+ */
+bool nk_task_set_quantum(uint8_t tid, uint8_t ticks);
+
+/**
+ * @brief Get a task's time slice in ticks
+ *
+ * @param tid Task ID
+ * @return Slice in ticks, or 0 if tid is invalid
+ */
+uint8_t nk_task_quantum(uint8_t tid);
+
+#define NK_SCHED_RR   0     /**< Time-sliced among equal priorities (default) */
+#define NK_SCHED_FIFO 1     /**< No time slice: runs until it blocks or yields */
+
+/**
+ * @brief Set a task's scheduling policy
+ *
+ * A NK_SCHED_FIFO task ignores its slice: the tick takes the CPU from it
+ * only for a more urgent ready task, and it then resumes ahead of its
+ * equals.  Tasks of the same priority therefore run one after another,
+ * each to completion, while tasks at other levels are unaffected.
+ *
+ * @param tid    Task ID
+ * @param policy NK_SCHED_RR or NK_SCHED_FIFO
+ * @return true on success, false if tid or policy is invalid
+ */
+bool nk_task_set_policy(uint8_t tid, uint8_t policy);
+
+/**
+ * @brief Get a task's scheduling policy
+ *
+ * @param tid Task ID
+ * @return NK_SCHED_RR / NK_SCHED_FIFO, or 0xFF if tid is invalid
+ */
+uint8_t nk_task_policy(uint8_t tid);
+
+/**
+ * @brief Per-task CPU accounting (kernel_sched_stats)
+ *
+ * run_ticks is tick-sampled: each tick is charged to whichever task was
+ * running when it fired.
+ */
+typedef struct {
+    uint32_t run_ticks;         /**< Ticks spent running */
+    uint32_t last_run;          /**< nk_ticks() when last switched in */
+    uint16_t vol_switches;      /**< Gave up the CPU (yield/sleep/block) */
+    uint16_t invol_switches;    /**< Preempted from the tick */
+} nk_task_stats_t;
+
+/**
+ * @brief Snapshot a task's CPU accounting
+ *
+ * @param tid Task ID
+ * @param[out] out Counters at the time of the call
+ * @return 0 on success, -1 if tid is invalid or stats are not configured
+ */
+int nk_task_stats(uint8_t tid, nk_task_stats_t *out);
+
+/**
+ * @brief Scheduler ticks since start (1 tick = 1 ms)
+ */
+uint32_t nk_ticks(void);
+
+/**
+ * @brief nk_ticks() together with the time since that tick was counted
+ *
+ * Both are read in one critical section, so the pair is consistent:
+ * the current time is the returned tick plus @p since cycles.
+ *
+ * @param[out] since hal_cycles() elapsed since the tick (HAL_CYCLES_HZ)
+ * @return Ticks since start
+ */
+uint32_t nk_ticks_fine(uint32_t *since);
+
+/**
+ * @brief Get a task's stack size
+ *
+ * @param tid Task ID
+ * @return Usable stack bytes, or -1 if tid is invalid
+ */
+int nk_task_stack_size(uint8_t tid);
+
+/**
+ * @brief Get a task's stack high-water mark
+ *
+ * Stacks are painted with a fill pattern at creation; this scans from
+ * the low end for the first overwritten byte.  Use it together with
+ * nk_task_stack_size() to trim stack budgets.
+ *
+ * @param tid Task ID
+ * @return Peak stack bytes used so far, or -1 if tid is invalid
+ */
+int nk_task_stack_usage(uint8_t tid);
+
 /**
  * @brief Switch to specific task (kernel/IPC use)
  *
@@ -149,6 +298,344 @@ void nk_switch_to(uint8_t tid);
  */
 void nk_task_exit(int status) __attribute__((noreturn));
 
+/**
+ * @brief Called by nk_task_exit() in the exiting task, before it stops
+ *
+ * Weak; the default does nothing.  The VFS overrides it when it keeps
+ * per-task descriptor tables, to close whatever the task left open.
+ * May block.
+ *
+ * @param tid The exiting task
+ */
+void nk_task_exit_hook(uint8_t tid);
+
+/**
+ * @brief Called first by the reschedule IPI handler (kernel_smp_cores > 1)
+ *
+ * Weak; the default does nothing.  Door RPC overrides it to run calls
+ * other cores queued for this one (door_ipi()).  Runs in interrupt
+ * context on the interrupted task's stack, unlocked.
+ */
+void nk_ipi_hook(void);
+
+/**
+ * @brief Block until a task has terminated
+ *
+ * Sleeps on the task's exit queue, no polling.  The slot stays claimed
+ * (its TID is not handed out again) until nk_task_release(), so call
+ * that only once every waiter has returned.
+ *
+ * @param tid Task to wait for
+ * @return 0 once it has exited, -1 if @p tid is invalid or the caller
+ */
+int nk_task_wait(uint8_t tid);
+
+/**
+ * @brief Let nk_task_create() reuse a task's slot and pooled stack
+ *
+ * Frees the slot now if the task has exited, else as it exits (a
+ * detached task).  A later task created on that slot gets the same TID
+ * and, if it asks for a pooled stack no larger than the old one, the
+ * old stack.  Slots never released stay claimed, as before.
+ *
+ * @param tid Task whose slot to give back
+ */
+void nk_task_release(uint8_t tid);
+
+/*═══════════════════════════════════════════════════════════════════
+ * SIGNALS (kernel_signals)
+ *═══════════════════════════════════════════════════════════════════
+ *
+ * Every task has a pending and a blocked mask, one bit per signal.
+ * Posting is an OR into the pending mask and, if the signal is not
+ * blocked, a wake-up of a task parked in nk_sleep() or
+ * nk_sig_suspend().  Nothing else looks at the masks until the task
+ * runs again: a resumed task tests `pending & ~blocked` once as it
+ * leaves the scheduler and, only if that is non-zero, calls the
+ * dispatcher registered with nk_sig_dispatch() on its own stack, with
+ * the scheduler lock free and interrupts enabled.
+ *
+ * A task preempted by the tick gets its signals when the tick resumes
+ * it, except on HAL_SWITCH_DEFERRED ports (ARMv7-M), where that happens
+ * at its next pass through the scheduler.  A task woken early from
+ * nk_sleep() returns from it early.
+ */
+
+/** Signals per task (numbers 1 ... NK_SIG_MAX) */
+#define NK_SIG_MAX 32
+
+/** Signal mask, bit (n - 1) for signal n */
+typedef uint32_t nk_sigset_t;
+
+#define NK_SIG_BIT(sig) ((nk_sigset_t)1 << ((sig) - 1))
+
+/** Runs one delivered signal in the receiving task */
+typedef void (*nk_sig_fn)(uint8_t sig);
+
+/**
+ * @brief Install the function that delivers signals (one per system)
+ *
+ * With none installed, delivered signals are discarded.
+ */
+void nk_sig_dispatch(nk_sig_fn fn);
+
+/**
+ * @brief Make @p sig pending for task @p tid (ISR-safe)
+ *
+ * Signal 0 posts nothing and only checks that @p tid exists.
+ *
+ * @return 0, or -1 if @p tid or @p sig is invalid or signals are not
+ *         configured
+ */
+int nk_sig_post(uint8_t tid, uint8_t sig);
+
+/**
+ * @brief Replace the calling task's blocked mask
+ *
+ * Does not deliver anything it unblocks; follow with nk_sig_deliver().
+ *
+ * @return Previous mask
+ */
+nk_sigset_t nk_sig_setmask(nk_sigset_t mask);
+
+/**
+ * @brief The calling task's blocked mask
+ */
+nk_sigset_t nk_sig_blocked(void);
+
+/**
+ * @brief Signals pending for the calling task
+ */
+nk_sigset_t nk_sig_pending(void);
+
+/**
+ * @brief Deliver the calling task's pending, unblocked signals now
+ *
+ * Task context only, with the scheduler lock free.
+ */
+void nk_sig_deliver(void);
+
+/**
+ * @brief Block with @p mask as the blocked mask until a signal arrives
+ *
+ * Delivers it under @p mask, then restores the previous mask.
+ *
+ * @return 0, or -1 if signals are not configured
+ */
+int nk_sig_suspend(nk_sigset_t mask);
+
+/*═══════════════════════════════════════════════════════════════════
+ * THREAD-LOCAL STORAGE (kernel_tls)
+ *═══════════════════════════════════════════════════════════════════
+ *
+ * Each task may own one TLS block; the scheduler only stores the
+ * pointer and copies it into nk_tls_self as it switches the task in.
+ * Reading thread-local state is therefore one load of a global, not a
+ * call.  The layout of the block belongs to whoever installs it (the
+ * POSIX layer keeps errno and pthread keys there).  Uniprocessor only.
+ */
+
+/** TLS block of the running task (NULL if it has none) */
+extern void *nk_tls_self;
+
+/**
+ * @brief Install @p block as task @p tid's TLS block
+ *
+ * @return true on success, false if @p tid is invalid or TLS is not
+ *         configured
+ */
+bool nk_task_set_tls(uint8_t tid, void *block);
+
+/**
+ * @brief Task @p tid's TLS block, or NULL
+ */
+void *nk_task_tls(uint8_t tid);
+
+/*═══════════════════════════════════════════════════════════════════
+ * WAIT QUEUES
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Kernel wait queue
+ *
+ * One byte per queue: 0 when empty, otherwise (task ID + 1) of the first
+ * waiter.  Waiters are kept in priority order, FIFO among equals, so a
+ * zero-initialised object is a valid empty queue.
+ */
+typedef uint8_t nk_waitq_t;
+
+/** Static initializer for an empty wait queue */
+#define NK_WAITQ_INIT 0
+
+/**
+ * @brief Initialize a wait queue
+ */
+void nk_waitq_init(nk_waitq_t *q);
+
+/**
+ * @brief Block the calling task on a wait queue
+ *
+ * Marks the task NK_BLOCKED and switches away until woken.  Call inside
+ * nk_sched_lock(), after testing the wait condition, so a wake-up cannot
+ * slip in between; returns with the lock released.
+ *
+ * @param q Queue to wait on
+ */
+void nk_waitq_block(nk_waitq_t *q);
+
+/**
+ * @brief Block on a wait queue for at most @p ticks
+ *
+ * Same contract as nk_waitq_block(); the task is also put on the sleep
+ * queue and taken off @p q again if the time runs out first.
+ *
+ * @param q     Queue to wait on
+ * @param ticks Timeout in scheduler ticks (0 = give up at once)
+ * @return 0 if woken through @p q, -1 on timeout
+ */
+int nk_waitq_block_timeout(nk_waitq_t *q, uint16_t ticks);
+
+/**
+ * @brief Wake the highest-priority waiter
+ *
+ * Safe from ISRs.  Does not preempt the caller.
+ *
+ * @param q Queue to wake from
+ * @return Task ID that was made ready, or -1 if the queue was empty
+ */
+int nk_waitq_wake_one(nk_waitq_t *q);
+
+/**
+ * @brief Wake every waiter
+ *
+ * @param q Queue to drain
+ * @return Number of tasks made ready
+ */
+uint8_t nk_waitq_wake_all(nk_waitq_t *q);
+
+/*═══════════════════════════════════════════════════════════════════
+ * ADDRESS-KEYED WAIT (futex-style)
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Sleep until woken on an address, if it still holds a value
+ *
+ * Atomically (with respect to nk_wake()) checks `*addr == expected` and,
+ * if so, blocks the caller.  Lets user-level locks keep their fast path
+ * in a plain atomic op and only enter the kernel on contention.
+ *
+ * @param addr     Word to wait on
+ * @param expected Value that means "keep waiting"
+ * @return 0 after being woken, -1 if *addr had already changed
+ */
+int nk_wait_on(volatile uint8_t *addr, uint8_t expected);
+
+/**
+ * @brief Wake tasks waiting on an address
+ *
+ * Safe from ISRs.
+ *
+ * @param addr Address passed to nk_wait_on()
+ * @param n    Maximum number of waiters to wake (0xFF = all)
+ * @return Number of tasks woken
+ */
+uint8_t nk_wake(volatile uint8_t *addr, uint8_t n);
+
+/*═══════════════════════════════════════════════════════════════════
+ * PRIORITY INHERITANCE
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Raise a task's effective priority
+ *
+ * Used by lock owners' waiters: if @p prio is more urgent than the
+ * task's current effective priority, the task runs at @p prio until
+ * nk_task_unboost().  Inheritance is one level deep; an owner that is
+ * itself blocked keeps its place in the other queue.
+ *
+ * @param tid  Task to boost
+ * @param prio Priority to inherit (0 = highest)
+ */
+void nk_task_boost(uint8_t tid, uint8_t prio);
+
+/**
+ * @brief Drop a task back to its assigned priority
+ *
+ * @param tid Task to restore
+ */
+void nk_task_unboost(uint8_t tid);
+
+/**
+ * @brief Get a task's effective priority
+ *
+ * @param tid Task ID
+ * @return Effective priority, or 0xFF if tid is invalid
+ */
+uint8_t nk_task_priority(uint8_t tid);
+
+/**
+ * @brief Core whose run queue a task is on
+ *
+ * The task's home core (it moves only when another core steals it).
+ *
+ * @param tid Task ID
+ * @return Core index; 0 on uniprocessor builds or if tid is invalid
+ */
+uint8_t nk_task_cpu(uint8_t tid);
+
+/**
+ * @brief Change a task's assigned priority
+ *
+ * Takes effect at once unless the task holds an inherited priority that
+ * is more urgent, which it keeps until nk_task_unboost().
+ *
+ * @param tid  Task ID
+ * @param prio New priority (0 = highest, 63 = lowest)
+ * @return true on success, false if tid is invalid
+ */
+bool nk_task_set_priority(uint8_t tid, uint8_t prio);
+
+/**
+ * @brief Is a task on a CPU right now?
+ *
+ * A hint for adaptive locks: spinning on a holder is only worthwhile
+ * while it runs on another core.
+ *
+ * @param tid Task ID
+ * @return true if @p tid is NK_RUNNING (false if invalid)
+ */
+bool nk_task_running(uint8_t tid);
+
+/*═══════════════════════════════════════════════════════════════════
+ * DEADLINE (EDF) CLASS - kernel_sched_edf
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Move a task into the earliest-deadline-first class
+ *
+ * EDF tasks always run ahead of fixed-priority tasks, earliest deadline
+ * first.  Each period the task may consume @p budget ticks; once spent
+ * it is throttled until the next release, so an overrunning job cannot
+ * starve the fixed-priority tasks.  A throttled task only keeps running
+ * if nothing else is runnable.
+ *
+ * @param tid    Task ID
+ * @param period Period and relative deadline in ticks (0 = back to
+ *               fixed priority)
+ * @param budget Execution budget per period in ticks (<= period)
+ * @return true on success; false if tid/parameters are invalid, if the
+ *         total EDF utilisation would exceed 100%, or if EDF is not
+ *         configured
+ */
+bool nk_task_set_deadline(uint8_t tid, uint16_t period, uint16_t budget);
+
+/**
+ * @brief Finish the current job and sleep until the next release
+ *
+ * For EDF tasks only; fixed-priority tasks just yield.
+ */
+void nk_task_wait_period(void);
+
 /*═══════════════════════════════════════════════════════════════════
  * OPTIONAL: DAG DEPENDENCY TRACKING
  *═══════════════════════════════════════════════════════════════════*/
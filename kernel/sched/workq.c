@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file workq.c
+ * @brief Deferred Interrupt Work Queue
+ *
+ * Fixed-capacity ring with one consumer.  The consumer side is lock-free:
+ * it owns `tail` and only reads `head`.  Producers own `head`; posting
+ * takes a few-cycle IRQ save so ISRs that nest (Cortex-M) cannot race on
+ * the same slot, which on AVR is the only critical section in the path.
+ */
+
+#include "workq.h"
+#include "scheduler.h"
+#include "arch/common/hal.h"
+
+_Static_assert((NK_WORKQ_LEN & (NK_WORKQ_LEN - 1)) == 0,
+               "NK_WORKQ_LEN must be a power of two");
+
+typedef struct {
+    nk_work_fn fn;
+    void      *arg;
+} nk_work_t;
+
+static struct {
+    nk_work_t        items[NK_WORKQ_LEN];
+    volatile uint8_t head;      /**< Next slot to fill (producers) */
+    volatile uint8_t tail;      /**< Next slot to run (consumer) */
+    uint16_t         dropped;
+    nk_waitq_t       worker;    /**< Blocked nk_workq_task */
+} nk_wq;
+
+#define WQ_MASK (NK_WORKQ_LEN - 1)
+
+bool nk_work_post(nk_work_fn fn, void *arg) {
+    if (!fn) return false;
+
+    uint32_t s = nk_sched_lock();
+    uint8_t h = nk_wq.head;
+    if ((uint8_t)(h - nk_wq.tail) >= NK_WORKQ_LEN) {
+        nk_wq.dropped++;
+        nk_sched_unlock(s);
+        return false;
+    }
+    nk_wq.items[h & WQ_MASK].fn  = fn;
+    nk_wq.items[h & WQ_MASK].arg = arg;
+    hal_memory_barrier();
+    nk_wq.head = (uint8_t)(h + 1);
+    nk_waitq_wake_one(&nk_wq.worker);
+    nk_sched_unlock(s);
+    return true;
+}
+
+uint8_t nk_work_run(void) {
+    uint8_t n = 0;
+    uint8_t t = nk_wq.tail;
+
+    while (t != nk_wq.head) {
+        nk_work_t w = nk_wq.items[t & WQ_MASK];
+        hal_memory_barrier();
+        nk_wq.tail = ++t;
+        w.fn(w.arg);
+        ++n;
+    }
+    return n;
+}
+
+uint16_t nk_work_dropped(void) {
+    return nk_wq.dropped;
+}
+
+void nk_workq_task(void) {
+    for (;;) {
+        nk_work_run();
+
+        uint32_t s = nk_sched_lock();
+        if (nk_wq.tail == nk_wq.head) {
+            nk_waitq_block(&nk_wq.worker);
+        } else {
+            nk_sched_unlock(s);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file workq.h
+ * @brief Deferred Interrupt Work Queue (bottom halves)
+ *
+ * ISRs post small {function, argument} items and return immediately; the
+ * work runs later in task context with interrupts enabled, either from a
+ * dedicated high-priority kernel task (nk_workq_task) or wherever the
+ * application calls nk_work_run().  Keeps IRQ-off windows short and lets
+ * driver work batch up under load.
+ */
+
+#ifndef KERNEL_WORKQ_H
+#define KERNEL_WORKQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** Queue capacity in items; must be a power of two */
+#ifndef NK_WORKQ_LEN
+#  define NK_WORKQ_LEN 8
+#endif
+
+/** Deferred work handler */
+typedef void (*nk_work_fn)(void *arg);
+
+/**
+ * @brief Queue work for later execution (ISR-safe)
+ *
+ * @param fn  Handler to run in task context
+ * @param arg Opaque argument passed to @p fn
+ * @return true if queued, false if the queue was full (item dropped)
+ */
+bool nk_work_post(nk_work_fn fn, void *arg);
+
+/**
+ * @brief Run all queued work items in the caller's context
+ *
+ * @return Number of items executed
+ */
+uint8_t nk_work_run(void);
+
+/**
+ * @brief Items dropped because the queue was full
+ */
+uint16_t nk_work_dropped(void);
+
+/**
+ * @brief Worker task entry point
+ *
+ * Drains the queue, then blocks until the next nk_work_post().  Create
+ * it with nk_task_create() at a high priority.
+ */
+void nk_workq_task(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_WORKQ_H */
@@ -0,0 +1,216 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file irqstat.c
+ * @brief Interrupts-disabled window tracing (see irqstat.h)
+ */
+
+#include "arch/common/hal.h"
+#include "irqstat.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#if NK_IRQ_STATS
+
+#ifndef CONFIG_KERNEL_SMP_CORES
+#  define CONFIG_KERNEL_SMP_CORES 1
+#endif
+
+/** Time base for windows (must be readable with interrupts masked). */
+#ifndef NK_IRQSTAT_CLOCK
+#  if defined(__AVR__) && HAL_SYSTICK_TIMER == 0
+#    define NK_IRQSTAT_CLOCK() irqstat_avr_clock()
+#  else
+#    define NK_IRQSTAT_CLOCK() hal_timer_ticks()
+#  endif
+#endif
+
+/* Tag in a saved state: this save opened the window, its restore closes */
+#define IRQSTAT_OPENER 0x80000000u
+
+#if defined(__AVR__) && HAL_SYSTICK_TIMER == 0
+/*
+ * Ticks scaled by the compare period plus the live Timer0 count.  With
+ * interrupts masked a compare match only sets OCF0A; a pending flag
+ * and a small count mean the counter has wrapped past the tick.
+ */
+static inline uint32_t irqstat_avr_clock(void) {
+    uint32_t t = hal_timer_ticks();
+    uint8_t c = TCNT0;
+    if ((TIFR0 & _BV(OCF0A)) && c < HAL_TIMER_RELOAD / 2) {
+        ++t;
+    }
+    return t * (HAL_TIMER_RELOAD + 1u) + c;
+}
+#endif
+
+/* Open window per core: start time and masking site (NULL = none) */
+static uint32_t    irq_since[CONFIG_KERNEL_SMP_CORES];
+static const void *irq_site[CONFIG_KERNEL_SMP_CORES];
+
+static nk_irqstat_site_t irq_table[NK_IRQSTAT_SITES];
+static uint32_t          irq_worst;
+static const void       *irq_worst_site;
+#if CONFIG_KERNEL_SMP_CORES > 1
+static volatile uint8_t  irq_table_busy;
+#endif
+
+static inline uint8_t core(void) {
+#if CONFIG_KERNEL_SMP_CORES > 1
+    return hal_cpu_id();
+#else
+    return 0;
+#endif
+}
+
+static inline void open_window(uint8_t c, const void *site) {
+    irq_site[c] = site;
+    irq_since[c] = NK_IRQSTAT_CLOCK();
+}
+
+/* Charge the window open on core @p c; interrupts are still masked. */
+static void close_window(uint8_t c) {
+    uint32_t len = NK_IRQSTAT_CLOCK() - irq_since[c];
+    const void *site = irq_site[c];
+    irq_site[c] = NULL;
+
+#if CONFIG_KERNEL_SMP_CORES > 1
+    while (hal_atomic_test_and_set_u8(&irq_table_busy)) {
+    }
+#endif
+    if (len > irq_worst) {
+        irq_worst = len;
+        irq_worst_site = site;
+    }
+
+    /* Own entry, else a free one, else evict the mildest if we beat it */
+    nk_irqstat_site_t *e = NULL, *low = &irq_table[0];
+    for (uint8_t i = 0; i < NK_IRQSTAT_SITES; ++i) {
+        nk_irqstat_site_t *t = &irq_table[i];
+        if (t->site == site) {
+            e = t;
+            break;
+        }
+        if (low->site && (!t->site || t->max < low->max)) {
+            low = t;
+        }
+    }
+    if (!e && (!low->site || len > low->max)) {
+        e = low;
+        e->site = site;
+        e->max = 0;
+        e->count = 0;
+    }
+    if (e) {
+        e->count++;
+        if (len > e->max) {
+            e->max = len;
+        }
+    }
+#if CONFIG_KERNEL_SMP_CORES > 1
+    hal_atomic_exchange_u8(&irq_table_busy, 0);
+#endif
+}
+
+__attribute__((noinline)) uint32_t nk_irqstat_save(void) {
+    bool was = hal_irq_enabled();
+    uint32_t s = (hal_irq_save)();
+    uint8_t c = core();
+    if (was && !irq_site[c]) {
+        open_window(c, __builtin_return_address(0));
+        s |= IRQSTAT_OPENER;
+    }
+    return s;
+}
+
+__attribute__((noinline)) void nk_irqstat_restore(uint32_t state) {
+    uint8_t c = core();
+    if ((state & IRQSTAT_OPENER) && irq_site[c]) {
+        close_window(c);
+    }
+    (hal_irq_restore)(state & ~IRQSTAT_OPENER);
+}
+
+__attribute__((noinline)) void nk_irqstat_disable(void) {
+    bool was = hal_irq_enabled();
+    (hal_irq_disable)();
+    uint8_t c = core();
+    if (was && !irq_site[c]) {
+        open_window(c, __builtin_return_address(0));
+    }
+}
+
+__attribute__((noinline)) void nk_irqstat_enable(void) {
+    uint8_t c = core();
+    if (irq_site[c]) {
+        close_window(c);
+    }
+    (hal_irq_enable)();
+}
+
+uint8_t nk_irqstat_top(nk_irqstat_site_t *out, uint8_t n) {
+    uint8_t k = 0;
+
+    uint32_t s = (hal_irq_save)();
+    for (uint8_t j = 0; j < NK_IRQSTAT_SITES; ++j) {
+        const nk_irqstat_site_t *e = &irq_table[j];
+        if (!e->site) {
+            continue;
+        }
+        uint8_t i = k < n ? k++ : n;
+        while (i > 0 && out[i - 1].max < e->max) {
+            if (i < n) {
+                out[i] = out[i - 1];
+            }
+            --i;
+        }
+        if (i < n) {
+            out[i] = *e;
+        }
+    }
+    (hal_irq_restore)(s);
+    return k;
+}
+
+uint32_t nk_irqstat_worst(const void **site) {
+    uint32_t s = (hal_irq_save)();
+    uint32_t w = irq_worst;
+    if (site) {
+        *site = irq_worst_site;
+    }
+    (hal_irq_restore)(s);
+    return w;
+}
+
+void nk_irqstat_reset(void) {
+    uint32_t s = (hal_irq_save)();
+    for (uint8_t i = 0; i < NK_IRQSTAT_SITES; ++i) {
+        irq_table[i].site = NULL;
+        irq_table[i].max = 0;
+        irq_table[i].count = 0;
+    }
+    irq_worst = 0;
+    irq_worst_site = NULL;
+    (hal_irq_restore)(s);
+}
+
+#else /* !NK_IRQ_STATS */
+
+uint8_t nk_irqstat_top(nk_irqstat_site_t *out, uint8_t n) {
+    (void)out;
+    (void)n;
+    return 0;
+}
+
+uint32_t nk_irqstat_worst(const void **site) {
+    if (site) {
+        *site = NULL;
+    }
+    return 0;
+}
+
+void nk_irqstat_reset(void) {}
+
+#endif /* NK_IRQ_STATS */
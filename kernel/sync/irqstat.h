@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file irqstat.h
+ * @brief Interrupts-disabled window tracing (debug_irq_trace)
+ *
+ * With NK_IRQ_STATS set, hal_irq_save()/hal_irq_restore() and
+ * hal_irq_disable()/hal_irq_enable() are routed through out-of-line
+ * wrappers that timestamp the moment interrupts go off and the moment
+ * they come back.  Each window is charged to the code address that
+ * masked interrupts, and the longest windows per call site are kept
+ * in a small table.  The worst window bounds interrupt latency, and
+ * with it UART RX overruns.
+ *
+ * ```c
+ * nk_irqstat_site_t top[4];
+ * uint8_t n = nk_irqstat_top(top, 4);
+ * for (uint8_t i = 0; i < n; ++i)
+ *     printf("%p %lu\n", top[i].site, (unsigned long)top[i].max);
+ * ```
+ *
+ * Sites are return addresses; resolve them with addr2line or the
+ * linker map.  Windows are measured in NK_IRQSTAT_CLOCK() units: on
+ * AVR the Timer0 count at F_CPU / 64 (4 µs at 16 MHz), elsewhere
+ * hal_timer_ticks().  Ticks cannot advance while interrupts are
+ * masked, so on AVR a window longer than one tick is reported as at
+ * most about two ticks; any such window is a bug worth chasing anyway.
+ *
+ * Nested save/restore pairs inside an open window are not separate
+ * windows.  The hooks cost a call and two clock reads per window; the
+ * tracer itself runs with interrupts still masked and is included in
+ * what it measures.  Without NK_IRQ_STATS nothing changes.
+ */
+
+#ifndef KERNEL_SYNC_IRQSTAT_H
+#define KERNEL_SYNC_IRQSTAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "avrix-config.h"
+
+#ifndef NK_IRQ_STATS
+#  if defined(CONFIG_DEBUG_IRQ_TRACE)
+#    define NK_IRQ_STATS CONFIG_DEBUG_IRQ_TRACE
+#  else
+#    define NK_IRQ_STATS 0
+#  endif
+#endif
+
+/** Call sites remembered by the worst-window table. */
+#ifndef NK_IRQSTAT_SITES
+#  define NK_IRQSTAT_SITES 8
+#endif
+
+/**
+ * @brief Worst interrupts-off window of one call site
+ */
+typedef struct {
+    const void *site;   /**< Address that masked interrupts */
+    uint32_t    max;    /**< Longest window, NK_IRQSTAT_CLOCK() units */
+    uint32_t    count;  /**< Windows opened here while in the table */
+} nk_irqstat_site_t;
+
+/**
+ * @brief Sites with the longest windows, worst first
+ *
+ * @param out Filled with up to @p n entries (copies)
+ * @param n   Capacity of @p out
+ * @return Number of entries written (0 without stats)
+ */
+uint8_t nk_irqstat_top(nk_irqstat_site_t *out, uint8_t n);
+
+/**
+ * @brief Longest window seen since boot or the last reset
+ *
+ * @param site Receives its call site (may be NULL)
+ * @return Length in NK_IRQSTAT_CLOCK() units
+ */
+uint32_t nk_irqstat_worst(const void **site);
+
+/**
+ * @brief Forget all recorded windows
+ */
+void nk_irqstat_reset(void);
+
+#if NK_IRQ_STATS
+
+uint32_t nk_irqstat_save(void);
+void nk_irqstat_restore(uint32_t state);
+void nk_irqstat_disable(void);
+void nk_irqstat_enable(void);
+
+/*
+ * Reroute the masking calls.  Only function-like uses expand, so the
+ * HAL definitions above stay reachable as (hal_irq_save)() and friends.
+ */
+#define hal_irq_save()       nk_irqstat_save()
+#define hal_irq_restore(s)   nk_irqstat_restore(s)
+#define hal_irq_disable()    nk_irqstat_disable()
+#define hal_irq_enable()     nk_irqstat_enable()
+
+#endif /* NK_IRQ_STATS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SYNC_IRQSTAT_H */
@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file lockstat.c
+ * @brief Per-lock contention statistics (see lockstat.h)
+ */
+
+#include "lockstat.h"
+#include <stddef.h>
+
+#if NK_LOCK_STATS
+
+volatile uint32_t nk_lock_spins[CONFIG_KERNEL_SMP_CORES];
+
+/* Registry: push-only list, guarded by a test-and-set byte */
+static nk_lockstat_t *lockstat_head;
+static volatile uint8_t lockstat_busy;
+
+static void lockstat_list(nk_lockstat_t *st) {
+    while (hal_atomic_test_and_set_u8(&lockstat_busy)) {
+    }
+    if (!st->listed) {
+        st->next = lockstat_head;
+        lockstat_head = st;
+        st->listed = 1;
+    }
+    hal_atomic_exchange_u8(&lockstat_busy, 0);
+}
+
+void nk_lockstat_acquired(nk_lockstat_t *st, uint32_t spins, bool waited) {
+    if (!st->listed) {
+        lockstat_list(st);
+    }
+    st->acquired++;
+    if (spins || waited) {
+        st->contended++;
+        st->spins += spins;
+    }
+    st->held_at = NK_LOCK_CLOCK();
+}
+
+void nk_lockstat_released(nk_lockstat_t *st) {
+    uint32_t held = NK_LOCK_CLOCK() - st->held_at;
+    if (held > st->hold_max) {
+        st->hold_max = held;
+    }
+}
+
+const nk_lockstat_t *nk_lockstat_next(const nk_lockstat_t *prev) {
+    return prev ? prev->next : lockstat_head;
+}
+
+uint8_t nk_lockstat_top(const nk_lockstat_t **out, uint8_t n) {
+    uint8_t k = 0;
+
+    /* Insertion into a sorted window of n entries */
+    for (const nk_lockstat_t *st = lockstat_head; st; st = st->next) {
+        if (!st->contended) {
+            continue;
+        }
+        uint8_t i = k < n ? k++ : n;
+        while (i > 0 && out[i - 1]->contended < st->contended) {
+            if (i < n) {
+                out[i] = out[i - 1];
+            }
+            --i;
+        }
+        if (i < n) {
+            out[i] = st;
+        }
+    }
+    return k;
+}
+
+void nk_lockstat_reset(void) {
+    for (nk_lockstat_t *st = lockstat_head; st; st = st->next) {
+        st->acquired = 0;
+        st->contended = 0;
+        st->spins = 0;
+        st->hold_max = 0;
+    }
+}
+
+void nk_lockstat_forget(nk_lockstat_t *st) {
+    while (hal_atomic_test_and_set_u8(&lockstat_busy)) {
+    }
+    if (st->listed) {
+        nk_lockstat_t **link = &lockstat_head;
+        while (*link && *link != st) {
+            link = &(*link)->next;
+        }
+        if (*link) {
+            *link = st->next;
+        }
+        st->listed = 0;
+    }
+    hal_atomic_exchange_u8(&lockstat_busy, 0);
+}
+
+#else /* !NK_LOCK_STATS */
+
+const nk_lockstat_t *nk_lockstat_next(const nk_lockstat_t *prev) {
+    (void)prev;
+    return NULL;
+}
+
+uint8_t nk_lockstat_top(const nk_lockstat_t **out, uint8_t n) {
+    (void)out;
+    (void)n;
+    return 0;
+}
+
+void nk_lockstat_reset(void) {}
+
+void nk_lockstat_forget(nk_lockstat_t *st) {
+    (void)st;
+}
+
+#endif /* NK_LOCK_STATS */
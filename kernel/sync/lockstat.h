@@ -0,0 +1,158 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file lockstat.h
+ * @brief Per-lock contention statistics (sync_lock_stats)
+ *
+ * With NK_LOCK_STATS set, every nk_spinlock_t and pthread_mutex_t
+ * carries an nk_lockstat_t.  The lock paths count acquisitions,
+ * contended acquisitions and spin-loop iterations, and keep the
+ * longest hold in NK_LOCK_CLOCK() ticks.  A lock joins the global list
+ * the first time it is taken, so nothing needs registering up front;
+ * a lock on the stack or heap must call nk_lockstat_forget() before
+ * its storage is reused.
+ *
+ * ```c
+ * const nk_lockstat_t *hot[4];
+ * uint8_t n = nk_lockstat_top(hot, 4);
+ * for (uint8_t i = 0; i < n; ++i)
+ *     printf("%s %lu/%lu\n", hot[i]->name ? hot[i]->name : "?",
+ *            (unsigned long)hot[i]->contended,
+ *            (unsigned long)hot[i]->acquired);
+ * ```
+ *
+ * Spin iterations are counted per core by NK_SPIN_RELAX() and charged
+ * to the lock being waited for; a spinner preempted by another spinner
+ * on the same core may be charged some of its rounds.
+ *
+ * Counters are updated by the lock holder, so they need no atomics of
+ * their own.  Without NK_LOCK_STATS the hooks compile to nothing.
+ */
+
+#ifndef KERNEL_SYNC_LOCKSTAT_H
+#define KERNEL_SYNC_LOCKSTAT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "arch/common/hal.h"
+#include "avrix-config.h"
+
+#ifndef NK_LOCK_STATS
+#  if defined(CONFIG_SYNC_LOCK_STATS)
+#    define NK_LOCK_STATS CONFIG_SYNC_LOCK_STATS
+#  else
+#    define NK_LOCK_STATS 0
+#  endif
+#endif
+
+/** Time base for hold times. */
+#ifndef NK_LOCK_CLOCK
+#  define NK_LOCK_CLOCK() hal_timer_ticks()
+#endif
+
+#ifndef CONFIG_KERNEL_SMP_CORES
+#  define CONFIG_KERNEL_SMP_CORES 1
+#endif
+
+/**
+ * @brief Statistics for one lock
+ */
+typedef struct nk_lockstat {
+    const char          *name;      /**< Label for dumps (may be NULL) */
+    struct nk_lockstat  *next;      /**< Registry link */
+    uint32_t             acquired;  /**< Successful acquisitions */
+    uint32_t             contended; /**< Acquisitions that had to wait */
+    uint32_t             spins;     /**< Spin-loop rounds spent waiting */
+    uint32_t             hold_max;  /**< Longest hold, NK_LOCK_CLOCK() ticks */
+    uint32_t             held_at;   /**< Clock at current acquisition */
+    uint8_t              listed;    /**< On the registry list */
+} nk_lockstat_t;
+
+/** Initializer for an nk_lockstat_t labelled @p n. */
+#define NK_LOCKSTAT_INIT(n) { (n), 0, 0u, 0u, 0u, 0u, 0u, 0u }
+
+#if NK_LOCK_STATS
+
+/** Per-core spin counters bumped by NK_SPIN_RELAX(). */
+extern volatile uint32_t nk_lock_spins[CONFIG_KERNEL_SMP_CORES];
+
+/** Spin counter of the calling core. */
+static inline volatile uint32_t *nk_lockstat_spin_ctr(void) {
+#if CONFIG_KERNEL_SMP_CORES > 1
+    return &nk_lock_spins[hal_cpu_id()];
+#else
+    return &nk_lock_spins[0];
+#endif
+}
+
+/** Count one spin-loop round (called from NK_SPIN_RELAX()). */
+static inline void nk_lockstat_spin(void) {
+    (*nk_lockstat_spin_ctr())++;
+}
+
+/** Current spin count, to diff around an acquisition. */
+static inline uint32_t nk_lockstat_spins(void) {
+    return *nk_lockstat_spin_ctr();
+}
+
+/**
+ * @brief Record an acquisition (call while holding the lock)
+ *
+ * @param st     Statistics of the lock just taken
+ * @param spins  Spin rounds spent waiting (0 = uncontended)
+ * @param waited true if the caller had to wait, even without spinning
+ */
+void nk_lockstat_acquired(nk_lockstat_t *st, uint32_t spins, bool waited);
+
+/**
+ * @brief Record a release (call just before dropping the lock)
+ */
+void nk_lockstat_released(nk_lockstat_t *st);
+
+#else
+static inline void nk_lockstat_spin(void) {}
+static inline uint32_t nk_lockstat_spins(void) { return 0; }
+static inline void nk_lockstat_acquired(nk_lockstat_t *st, uint32_t spins, bool waited) {
+    (void)st; (void)spins; (void)waited;
+}
+static inline void nk_lockstat_released(nk_lockstat_t *st) { (void)st; }
+#endif /* NK_LOCK_STATS */
+
+/**
+ * @brief Walk every lock that has been taken at least once
+ *
+ * @param prev NULL to start, or the previous result
+ * @return Next entry, or NULL at the end (always NULL without stats)
+ */
+const nk_lockstat_t *nk_lockstat_next(const nk_lockstat_t *prev);
+
+/**
+ * @brief Most contended locks, worst first
+ *
+ * @param out Filled with up to @p n entries
+ * @param n   Capacity of @p out
+ * @return Number of entries written
+ */
+uint8_t nk_lockstat_top(const nk_lockstat_t **out, uint8_t n);
+
+/** Zero every counter (entries stay listed). */
+void nk_lockstat_reset(void);
+
+/**
+ * @brief Drop a lock from the list before its storage goes away
+ *
+ * Needed only for locks that are not static (stack, heap).
+ */
+void nk_lockstat_forget(nk_lockstat_t *st);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SYNC_LOCKSTAT_H */
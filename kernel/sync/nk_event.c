@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_event.c
+ * @brief Event groups and the I/O readiness event (see nk_event.h)
+ */
+
+#include "nk_event.h"
+
+#if NK_IO_POLL
+nk_event_t nk_io_event = NK_EVENT_INIT;
+#endif
+
+/* Ticks left of a @p ticks timeout started at @p start */
+static uint16_t ticks_left(uint16_t ticks, uint32_t start) {
+    if (ticks == NK_EV_FOREVER) {
+        return ticks;
+    }
+    uint32_t used = nk_ticks() - start;
+    return used >= ticks ? 0 : (uint16_t)(ticks - used);
+}
+
+/* Sleep on @p q; returns with the scheduler lock released */
+static void ev_block(nk_waitq_t *q, uint16_t left) {
+    if (left == NK_EV_FOREVER) {
+        nk_waitq_block(q);
+    } else {
+        (void)nk_waitq_block_timeout(q, left);
+    }
+}
+
+void nk_event_init(nk_event_t *ev) {
+    ev->bits = 0;
+    ev->seq = 0;
+    nk_waitq_init(&ev->q);
+}
+
+void nk_event_set(nk_event_t *ev, nk_evbits_t bits) {
+    uint32_t s = nk_sched_lock();
+    ev->bits |= bits;
+    ev->seq++;
+    if (ev->q) {
+        nk_waitq_wake_all(&ev->q);  /* each re-checks its own condition */
+    }
+    nk_sched_unlock(s);
+}
+
+nk_evbits_t nk_event_clear(nk_event_t *ev, nk_evbits_t bits) {
+    uint32_t s = nk_sched_lock();
+    nk_evbits_t old = ev->bits;
+    ev->bits = (nk_evbits_t)(old & ~bits);
+    nk_sched_unlock(s);
+    return old;
+}
+
+nk_evbits_t nk_event_wait(nk_event_t *ev, nk_evbits_t mask, uint8_t opts,
+                          uint16_t ticks) {
+    uint32_t start = nk_ticks();
+
+    for (;;) {
+        uint32_t s = nk_sched_lock();
+        nk_evbits_t got = ev->bits & mask;
+        if ((opts & NK_EV_ALL) ? got == mask : got != 0) {
+            if (opts & NK_EV_CLEAR) {
+                ev->bits = (nk_evbits_t)(ev->bits & ~got);
+            }
+            nk_sched_unlock(s);
+            return got;
+        }
+        uint16_t left = ticks_left(ticks, start);
+        if (left == 0) {
+            nk_sched_unlock(s);
+            return 0;
+        }
+        ev_block(&ev->q, left);
+    }
+}
+
+int nk_event_wait_seq(nk_event_t *ev, uint8_t seq, uint16_t ticks) {
+    uint32_t start = nk_ticks();
+
+    for (;;) {
+        uint32_t s = nk_sched_lock();
+        if (ev->seq != seq) {
+            nk_sched_unlock(s);
+            return 0;
+        }
+        uint16_t left = ticks_left(ticks, start);
+        if (left == 0) {
+            nk_sched_unlock(s);
+            return -1;
+        }
+        ev_block(&ev->q, left);
+    }
+}
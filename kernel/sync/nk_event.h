@@ -0,0 +1,177 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_event.h
+ * @brief Event groups and the I/O readiness event
+ *
+ * An event group is eight flag bits plus a wait queue.  Producers (ISRs
+ * included) OR bits in with nk_event_set(); a consumer sleeps in
+ * nk_event_wait() until any (or all) of the bits it cares about are
+ * set, and may take them off in the same step.  Every waiter whose
+ * condition holds is woken by one set, so a main loop that services
+ * several sources wakes once however many of them became ready.
+ *
+ * ```c
+ * for (;;) {
+ *     nk_evbits_t ev = nk_event_wait(&nk_io_event, NK_IO_TTY | NK_IO_NET,
+ *                                    NK_EV_CLEAR, NK_EV_FOREVER);
+ *     if (ev & NK_IO_TTY) { ...drain the TTY... }
+ *     if (ev & NK_IO_NET) { ...read sockets... }
+ * }
+ * ```
+ *
+ * Each set also bumps a sequence number.  nk_event_wait_seq() sleeps
+ * until it moves, without consuming any bits: vfs_poll() uses that, so
+ * several tasks can poll the same sources and none steals another's
+ * wake-up.
+ *
+ * With kernel_poll, nk_io_event is the one such group the drivers
+ * signal: the TTY on RX/TX progress, pipes on every read, write and
+ * close, UDP/TCP when a segment changes a socket, door_complete()
+ * when an async call's reply lands, and nk_future_complete().
+ */
+
+#ifndef KERNEL_SYNC_NK_EVENT_H
+#define KERNEL_SYNC_NK_EVENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "avrix-config.h"
+#include "kernel/sched/scheduler.h"
+
+/**
+ * @brief Driver readiness reporting through nk_io_event (kernel_poll)
+ *
+ * Off, nk_io_notify() compiles to nothing and vfs_poll() rescans its
+ * descriptors once per tick instead of sleeping until a driver reports.
+ */
+#ifndef NK_IO_POLL
+#  if defined(CONFIG_KERNEL_POLL)
+#    define NK_IO_POLL CONFIG_KERNEL_POLL
+#  else
+#    define NK_IO_POLL 0
+#  endif
+#endif
+
+/** Event flag bits */
+typedef uint8_t nk_evbits_t;
+
+/**
+ * @brief Event group (3 bytes)
+ */
+typedef struct {
+    volatile nk_evbits_t bits;  /**< Flags set and not yet cleared */
+    volatile uint8_t     seq;   /**< Bumped by every nk_event_set() */
+    nk_waitq_t           q;     /**< Tasks in nk_event_wait*() */
+} nk_event_t;
+
+/** Static initializer for an event group with no bits set */
+#define NK_EVENT_INIT { 0u, 0u, NK_WAITQ_INIT }
+
+/** nk_event_wait() options */
+#define NK_EV_ALL   0x01u   /**< Wait for every bit of the mask, not any */
+#define NK_EV_CLEAR 0x02u   /**< Clear the matched bits before returning */
+
+/** Timeout meaning "no timeout" */
+#define NK_EV_FOREVER 0xFFFFu
+
+/**
+ * @brief Initialize an event group
+ */
+void nk_event_init(nk_event_t *ev);
+
+/**
+ * @brief Set @p bits and wake every waiter
+ *
+ * Safe from ISRs.  Does not preempt the caller.
+ */
+void nk_event_set(nk_event_t *ev, nk_evbits_t bits);
+
+/**
+ * @brief Clear @p bits
+ *
+ * @return The bits as they were before
+ */
+nk_evbits_t nk_event_clear(nk_event_t *ev, nk_evbits_t bits);
+
+/**
+ * @brief Bits currently set
+ */
+static inline nk_evbits_t nk_event_get(const nk_event_t *ev) {
+    return ev->bits;
+}
+
+/**
+ * @brief Sleep until bits of @p mask are set
+ *
+ * With NK_EV_CLEAR the first waiter to run takes the bits; others that
+ * wanted the same ones go back to sleep.
+ *
+ * @param mask  Bits to wait for
+ * @param opts  NK_EV_ALL and/or NK_EV_CLEAR
+ * @param ticks Timeout in scheduler ticks (0 = just test,
+ *              NK_EV_FOREVER = none)
+ * @return The set bits of @p mask, or 0 on timeout
+ */
+nk_evbits_t nk_event_wait(nk_event_t *ev, nk_evbits_t mask, uint8_t opts,
+                          uint16_t ticks);
+
+/**
+ * @brief Sequence number, for nk_event_wait_seq()
+ */
+static inline uint8_t nk_event_seq(const nk_event_t *ev) {
+    return ev->seq;
+}
+
+/**
+ * @brief Sleep until nk_event_set() has run since @p seq was read
+ *
+ * Take @p seq before checking the condition, so a set that lands
+ * during the check still ends the wait.
+ *
+ * @param seq   Value from nk_event_seq()
+ * @param ticks Timeout in scheduler ticks (NK_EV_FOREVER = none)
+ * @return 0 once the group was set, -1 on timeout
+ */
+int nk_event_wait_seq(nk_event_t *ev, uint8_t seq, uint16_t ticks);
+
+/*═══════════════════════════════════════════════════════════════════
+ * I/O READINESS (kernel_poll)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define NK_IO_TTY    0x01u  /**< A TTY received bytes or drained TX */
+#define NK_IO_PIPE   0x02u  /**< A pipe was read, written or closed */
+#define NK_IO_NET    0x04u  /**< A UDP/TCP socket changed */
+#define NK_IO_DOOR   0x08u  /**< An async door call completed */
+#define NK_IO_FUTURE 0x10u  /**< An nk_future_t completed */
+
+#if NK_IO_POLL
+
+/** Readiness event signalled by the drivers; NK_IO_* bits */
+extern nk_event_t nk_io_event;
+
+/**
+ * @brief Report that a descriptor of class @p src may have become ready
+ *
+ * Safe from ISRs.
+ */
+static inline void nk_io_notify(nk_evbits_t src) {
+    nk_event_set(&nk_io_event, src);
+}
+
+#else
+
+static inline void nk_io_notify(nk_evbits_t src) { (void)src; }
+
+#endif /* NK_IO_POLL */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SYNC_NK_EVENT_H */
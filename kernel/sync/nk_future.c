@@ -0,0 +1,108 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_future.c
+ * @brief Completion objects (see nk_future.h)
+ *
+ * A task can sit on one wait queue only, so nk_await_any() cannot
+ * queue on every future it watches.  It sleeps on a shared queue
+ * instead, which each completion drains; waiters re-scan their own
+ * set and go back to sleep if none of theirs finished.
+ */
+
+#include "nk_future.h"
+#include "nk_event.h"
+
+static nk_waitq_t fut_any;      /**< Tasks in nk_await_any() */
+
+/* Ticks left of a @p ticks timeout started at @p start */
+static uint16_t ticks_left(uint16_t ticks, uint32_t start) {
+    if (ticks == NK_FUT_FOREVER) {
+        return ticks;
+    }
+    uint32_t used = nk_ticks() - start;
+    return used >= ticks ? 0 : (uint16_t)(ticks - used);
+}
+
+/* Sleep on @p q; returns with the scheduler lock released */
+static void fut_block(nk_waitq_t *q, uint16_t left) {
+    if (left == NK_FUT_FOREVER) {
+        nk_waitq_block(q);
+    } else {
+        (void)nk_waitq_block_timeout(q, left);
+    }
+}
+
+void nk_future_init(nk_future_t *f) {
+    f->state = NK_FUT_IDLE;
+    f->result = 0;
+    nk_waitq_init(&f->q);
+}
+
+void nk_future_complete(nk_future_t *f, int16_t result) {
+    uint32_t s = nk_sched_lock();
+    if (f->state == NK_FUT_PENDING) {
+        f->result = result;
+        hal_memory_barrier();
+        f->state = NK_FUT_DONE;
+        if (f->q) {
+            nk_waitq_wake_all(&f->q);
+        }
+        if (fut_any) {
+            nk_waitq_wake_all(&fut_any);
+        }
+    }
+    nk_sched_unlock(s);
+    nk_io_notify(NK_IO_FUTURE);
+}
+
+void nk_future_cb(void *arg) {
+    nk_future_complete((nk_future_t *)arg, 0);
+}
+
+int nk_await(nk_future_t *f, uint16_t ticks) {
+    uint32_t start = nk_ticks();
+
+    for (;;) {
+        uint32_t s = nk_sched_lock();
+        uint8_t st = f->state;
+        if (st != NK_FUT_PENDING) {
+            nk_sched_unlock(s);
+            return st == NK_FUT_DONE ? 0 : -1;
+        }
+        uint16_t left = ticks_left(ticks, start);
+        if (left == 0) {
+            nk_sched_unlock(s);
+            return -1;
+        }
+        fut_block(&f->q, left);
+    }
+}
+
+int nk_await_any(nk_future_t *const *fs, uint8_t n, uint16_t ticks) {
+    uint32_t start = nk_ticks();
+
+    for (;;) {
+        bool armed = false;
+        uint32_t s = nk_sched_lock();
+        for (uint8_t i = 0; i < n; i++) {
+            if (!fs[i]) {
+                continue;
+            }
+            uint8_t st = fs[i]->state;
+            if (st == NK_FUT_DONE) {
+                nk_sched_unlock(s);
+                return i;
+            }
+            armed |= st == NK_FUT_PENDING;
+        }
+        uint16_t left = armed ? ticks_left(ticks, start) : 0;
+        if (left == 0) {
+            nk_sched_unlock(s);
+            return -1;
+        }
+        fut_block(&fut_any, left);
+    }
+}
@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_future.h
+ * @brief Completion objects for asynchronous I/O
+ *
+ * A future is a state byte, a result and a wait queue.  An async
+ * operation arms the caller's future when it starts and completes it,
+ * usually from an ISR, when it ends; the caller then waits for one
+ * future with nk_await() or for the first of several with
+ * nk_await_any().  One task can so keep an EEPROM flush, a door call
+ * and a transfer in flight together and sleep until any of them is
+ * done.
+ *
+ * ```c
+ * nk_future_t ee, rpc;
+ * nk_future_arm(&ee);
+ * hal_eeprom_write_async(0, cfg, sizeof(cfg), nk_future_cb, &ee);
+ * door_call_future(DOOR_LOG, msg, &rpc);
+ *
+ * nk_future_t *const all[] = { &ee, &rpc };
+ * int i = nk_await_any(all, 2, NK_FUT_FOREVER);
+ * ```
+ *
+ * Completion also reports NK_IO_FUTURE through nk_io_event (with
+ * kernel_poll), so protothreads blocked in PT_AWAIT_FUTURE() notice
+ * it.
+ */
+
+#ifndef KERNEL_SYNC_NK_FUTURE_H
+#define KERNEL_SYNC_NK_FUTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "kernel/sched/scheduler.h"
+#include "arch/common/hal.h"
+
+/** Future states */
+#define NK_FUT_IDLE    0    /**< Not started (or never armed) */
+#define NK_FUT_PENDING 1    /**< Operation in flight */
+#define NK_FUT_DONE    2    /**< Completed; result is valid */
+
+/** Timeout value that waits without limit */
+#define NK_FUT_FOREVER 0xFFFFu
+
+/**
+ * @brief Completion object (caller-allocated)
+ */
+typedef struct nk_future {
+    volatile uint8_t state;     /**< NK_FUT_* */
+    nk_waitq_t       q;         /**< Tasks in nk_await() */
+    volatile int16_t result;    /**< Set by nk_future_complete() */
+} nk_future_t;
+
+/** Static initializer for an idle future */
+#define NK_FUTURE_INIT { NK_FUT_IDLE, NK_WAITQ_INIT, 0 }
+
+/**
+ * @brief Initialize a future to NK_FUT_IDLE
+ */
+void nk_future_init(nk_future_t *f);
+
+/**
+ * @brief Mark a future pending before starting its operation
+ *
+ * Called by the party that starts the operation (an async driver or
+ * its caller).  A future must not be re-armed while still pending.
+ */
+static inline void nk_future_arm(nk_future_t *f) {
+    f->result = 0;
+    f->state = NK_FUT_PENDING;
+}
+
+/**
+ * @brief Complete a pending future and wake its waiters
+ *
+ * Safe from ISRs.  Does nothing unless @p f is pending, so a late or
+ * repeated completion cannot overwrite a result already taken.
+ *
+ * @param result Operation result (bytes moved, or a negative error)
+ */
+void nk_future_complete(nk_future_t *f, int16_t result);
+
+/**
+ * @brief Completion callback that finishes the future at @p arg with 0
+ *
+ * Matches hal_eeprom_done_t and nk_work_fn, so callback-style drivers
+ * can complete a future directly.
+ */
+void nk_future_cb(void *arg);
+
+/** Whether @p f has completed */
+static inline bool nk_future_done(const nk_future_t *f) {
+    return f->state == NK_FUT_DONE;
+}
+
+/** Result of a completed future */
+static inline int16_t nk_future_result(const nk_future_t *f) {
+    hal_memory_barrier();
+    return f->result;
+}
+
+/**
+ * @brief Wait for a future to complete
+ *
+ * @param ticks Timeout in scheduler ticks (0 = just test,
+ *              NK_FUT_FOREVER = none)
+ * @return 0 once completed (see nk_future_result()), -1 on timeout
+ *         or if @p f was never armed
+ */
+int nk_await(nk_future_t *f, uint16_t ticks);
+
+/**
+ * @brief Wait for the first of several futures to complete
+ *
+ * NULL and idle entries are skipped.  The returned future stays
+ * NK_FUT_DONE; re-arm or ignore it before waiting on the set again.
+ *
+ * @param fs    Futures to watch
+ * @param n     Entries in @p fs
+ * @param ticks Timeout in scheduler ticks (NK_FUT_FOREVER = none)
+ * @return Index of the lowest completed entry, -1 on timeout or if no
+ *         entry is armed
+ */
+int nk_await_any(nk_future_t *const *fs, uint8_t n, uint16_t ticks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SYNC_NK_FUTURE_H */
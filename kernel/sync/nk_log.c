@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_log.c
+ * @brief Deferred-format binary log rings (see nk_log.h)
+ */
+
+#include "arch/common/hal.h"
+#include "nk_log.h"
+#include <stdarg.h>
+#include <string.h>
+
+#if NK_LOG_ENABLED
+
+#if NK_LOG_BUF & (NK_LOG_BUF - 1) || NK_LOG_BUF > 32768
+#  error "NK_LOG_BUF must be a power of two, at most 32768"
+#endif
+
+#define ID_BYTES  sizeof(nk_log_id_t)
+#define REC_MAX   (ID_BYTES + 1u + 4u * 8u)
+#define MASK      (NK_LOG_BUF - 1u)
+
+nk_log_buf_t nk_log_buf HAL_SECTION(".noinit");
+
+static inline uint8_t core(void) {
+#if NK_LOG_CORES > 1
+    return hal_cpu_id();
+#else
+    return 0;
+#endif
+}
+
+/* Record length from its size byte */
+static uint8_t rec_len(uint8_t sizes) {
+    uint8_t n = ID_BYTES + 1u;
+    for (; sizes; sizes >>= 2) {
+        uint8_t code = sizes & 3u;
+        if (code) {
+            n = (uint8_t)(n + (1u << code));
+        }
+    }
+    return n;
+}
+
+static uint8_t put_le(uint8_t *p, uint32_t v, uint8_t bytes) {
+    for (uint8_t i = 0; i < bytes; i++, v >>= 8) {
+        p[i] = (uint8_t)v;
+    }
+    return bytes;
+}
+
+static void nk_log_clear(void) {
+    uint32_t s = hal_irq_save();
+    memset(&nk_log_buf, 0, sizeof nk_log_buf);
+    nk_log_buf.version = NK_LOG_VERSION;
+    nk_log_buf.cores   = NK_LOG_CORES;
+    nk_log_buf.size    = NK_LOG_BUF;
+    nk_log_buf.magic   = NK_LOG_MAGIC;
+    hal_irq_restore(s);
+}
+
+void nk_log_init(void) {
+    const nk_log_buf_t *l = &nk_log_buf;
+    bool intact = l->magic == NK_LOG_MAGIC &&
+                  l->version == NK_LOG_VERSION &&
+                  l->cores == NK_LOG_CORES &&
+                  l->size == NK_LOG_BUF;
+    for (uint8_t c = 0; intact && c < NK_LOG_CORES; ++c) {
+        intact = (uint16_t)(l->ring[c].head - l->ring[c].tail) <= NK_LOG_BUF;
+    }
+    if (!intact) {
+        nk_log_clear();
+    }
+}
+
+/* Copy @p n bytes into ring @p c at its head; caller checked the room */
+static void ring_put(uint8_t c, const uint8_t *src, uint8_t n) {
+    uint16_t h = nk_log_buf.ring[c].head;
+    uint8_t *d = nk_log_buf.data[c];
+    for (uint8_t i = 0; i < n; i++, h++) {
+        d[h & MASK] = src[i];
+    }
+    hal_memory_barrier();               /* Bytes before the new head */
+    nk_log_buf.ring[c].head = h;
+}
+
+void nk_log_write(nk_log_id_t id, uint8_t sizes, ...) {
+    if (nk_log_buf.magic != NK_LOG_MAGIC) {
+        return;
+    }
+
+    /* Build the record outside the critical section */
+    uint8_t rec[REC_MAX];
+    uint8_t n = put_le(rec, id, ID_BYTES);
+    rec[n++] = sizes;
+
+    va_list ap;
+    va_start(ap, sizes);
+    for (uint8_t k = 0; k < 8; k += 2) {
+        switch ((sizes >> k) & 3u) {
+        case 1:
+            n += put_le(rec + n, va_arg(ap, unsigned int), 2);
+            break;
+        case 2:
+            if (sizeof(int) == 4) {
+                n += put_le(rec + n, va_arg(ap, unsigned int), 4);
+            } else {
+                n += put_le(rec + n, va_arg(ap, unsigned long), 4);
+            }
+            break;
+        case 3: {
+            unsigned long long v = va_arg(ap, unsigned long long);
+            n += put_le(rec + n, (uint32_t)v, 4);
+            n += put_le(rec + n, (uint32_t)(v >> 32), 4);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    va_end(ap);
+
+    uint32_t s = hal_irq_save();
+    uint8_t c = core();
+    uint16_t used = (uint16_t)(nk_log_buf.ring[c].head -
+                               nk_log_buf.ring[c].tail);
+    uint16_t room = (uint16_t)(NK_LOG_BUF - used);
+    uint16_t lost = nk_log_buf.ring[c].dropped;
+
+    if (lost) {
+        uint8_t drop[ID_BYTES + 3u];
+        uint8_t m = put_le(drop, NK_LOG_ID_DROPPED, ID_BYTES);
+        drop[m++] = 1u;                 /* One 2-byte argument */
+        m += put_le(drop + m, lost, 2);
+        if (room >= (uint16_t)(m + n)) {
+            ring_put(c, drop, m);
+            room = (uint16_t)(room - m);
+            lost = 0;
+        }
+    }
+    if (!lost && room >= n) {
+        ring_put(c, rec, n);
+    } else if (lost != UINT16_MAX) {
+        lost++;
+    }
+    nk_log_buf.ring[c].dropped = lost;
+    hal_irq_restore(s);
+}
+
+size_t nk_log_read(uint8_t c, void *dst, size_t len) {
+    if (nk_log_buf.magic != NK_LOG_MAGIC || c >= NK_LOG_CORES) {
+        return 0;
+    }
+
+    /* 16-bit indices tear on AVR: snapshot and store them masked */
+    uint32_t s = hal_irq_save();
+    uint16_t head = nk_log_buf.ring[c].head;
+    hal_irq_restore(s);
+    hal_memory_barrier();               /* Head before the bytes */
+
+    uint16_t tail = nk_log_buf.ring[c].tail;
+    const uint8_t *src = nk_log_buf.data[c];
+    uint8_t *out = dst;
+    size_t got = 0;
+    while (tail != head) {
+        uint8_t n = rec_len(src[(uint16_t)(tail + ID_BYTES) & MASK]);
+        if (got + n > len) {
+            break;
+        }
+        for (uint8_t i = 0; i < n; i++, tail++) {
+            out[got++] = src[tail & MASK];
+        }
+    }
+
+    hal_memory_barrier();               /* Bytes read before they are freed */
+    s = hal_irq_save();
+    nk_log_buf.ring[c].tail = tail;
+    hal_irq_restore(s);
+    return got;
+}
+
+const void *nk_log_image(size_t *len) {
+    *len = sizeof nk_log_buf;
+    return &nk_log_buf;
+}
+
+#endif /* NK_LOG_ENABLED */
@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_log.h
+ * @brief Deferred-format binary logging (debug_log)
+ *
+ * NK_LOG() does not format anything on the target.  The format string
+ * goes to flash (HAL_PROGMEM) and its address is the record ID; the
+ * record is that ID, one byte of argument sizes and the raw integer
+ * arguments, appended to a byte ring per core:
+ *
+ * ```c
+ * NK_LOG("door %u -> task %u", idx, tid);     // 7 bytes on AVR
+ * ```
+ *
+ * A low-priority task drains the ring with nk_log_read() and ships the
+ * bytes, preferably one SLIP frame per read; or the host dumps the whole
+ * ring (nk_log_buf) through the GDB stub.  scripts/log_decode.py looks
+ * the IDs up in the ELF and prints the text, so a log call costs tens
+ * of cycles and no printf.
+ *
+ * Up to four arguments, integers or pointers only (they are stored at
+ * their promoted size).  %s cannot be deferred and prints the address.
+ * When the ring is full new records are dropped; the next record that
+ * fits is preceded by a count of the lost ones.
+ *
+ * The ring lives in .noinit, so after a watchdog or warm reset the
+ * undrained tail of the crashed run is still there for the debugger.
+ * Without NK_LOG_ENABLED the macros compile to nothing.
+ */
+
+#ifndef KERNEL_SYNC_NK_LOG_H
+#define KERNEL_SYNC_NK_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "avrix-config.h"
+#include "arch/common/hal.h"
+
+#ifndef NK_LOG_ENABLED
+#  if defined(CONFIG_DEBUG_LOG)
+#    define NK_LOG_ENABLED CONFIG_DEBUG_LOG
+#  else
+#    define NK_LOG_ENABLED 0
+#  endif
+#endif
+
+/** Ring bytes per core (power of two, at most 32768) */
+#ifndef NK_LOG_BUF
+#  if defined(CONFIG_DEBUG_LOG_BUF)
+#    define NK_LOG_BUF CONFIG_DEBUG_LOG_BUF
+#  else
+#    define NK_LOG_BUF 128
+#  endif
+#endif
+
+#ifndef CONFIG_KERNEL_SMP_CORES
+#  define CONFIG_KERNEL_SMP_CORES 1
+#endif
+#define NK_LOG_CORES CONFIG_KERNEL_SMP_CORES
+
+#define NK_LOG_MAGIC   0x474C4B4Eu     /**< "NKLG" little-endian */
+#define NK_LOG_VERSION 1u
+
+/** Record ID: the format string's address, as wide as a flash address */
+#if UINTPTR_MAX <= 0xFFFFu
+typedef uint16_t nk_log_id_t;
+#else
+typedef uint32_t nk_log_id_t;
+#endif
+
+/** ID of the record carrying a uint16_t count of dropped records */
+#define NK_LOG_ID_DROPPED 0u
+
+/**
+ * @brief Complete log image, as dumped and decoded
+ *
+ * All fields little-endian.  Ring @c c holds the unread bytes from
+ * `ring[c].tail` to `ring[c].head` (free-running, modulo NK_LOG_BUF).
+ * A record is the ID (sizeof(nk_log_id_t) bytes), a size byte with two
+ * bits per argument (0 = none, else log2 of the size: 1 = 2 bytes,
+ * 2 = 4, 3 = 8) and the arguments.
+ */
+typedef struct {
+    uint32_t magic;             /**< NK_LOG_MAGIC once initialised */
+    uint8_t  version;           /**< NK_LOG_VERSION */
+    uint8_t  cores;             /**< Rings that follow */
+    uint16_t size;              /**< Bytes per ring */
+    struct {
+        uint16_t head;          /**< Written by the logging core */
+        uint16_t tail;          /**< Written by the reader */
+        uint16_t dropped;       /**< Records lost since the last report */
+        uint16_t reserved;
+    } ring[NK_LOG_CORES];
+    uint8_t data[NK_LOG_CORES][NK_LOG_BUF];
+} nk_log_buf_t;
+
+#if NK_LOG_ENABLED
+
+/** The rings; global so a debugger can find them by name */
+extern nk_log_buf_t nk_log_buf;
+
+/**
+ * @brief Prepare the rings at boot
+ *
+ * Keeps undrained records of the previous run when the header is
+ * intact (warm reset), clears them otherwise.
+ */
+void nk_log_init(void);
+
+/**
+ * @brief Append one record to the calling core's ring; safe from ISRs
+ *
+ * Called by NK_LOG(); @p sizes describes the variadic arguments.
+ */
+void nk_log_write(nk_log_id_t id, uint8_t sizes, ...);
+
+/**
+ * @brief Move whole records of @p core's ring into @p dst
+ *
+ * One reader per ring; it may run on any core.
+ *
+ * @return Bytes copied, 0 when the ring is empty or the next record
+ *         does not fit in @p len
+ */
+size_t nk_log_read(uint8_t core, void *dst, size_t len);
+
+/**
+ * @brief The image to dump
+ *
+ * @param len Receives its size in bytes
+ * @return &nk_log_buf
+ */
+const void *nk_log_image(size_t *len);
+
+/** Size code of one argument, after the default promotions */
+#define NK_LOG_SZ_(x) \
+    (sizeof((x) + 0) <= 2 ? 1u : sizeof((x) + 0) == 4 ? 2u : 3u)
+
+#define NK_LOG_AT_(fmt, sizes, ...) do {                          \
+        static const char nk_log_fmt_[] HAL_PROGMEM = fmt;        \
+        nk_log_write((nk_log_id_t)(uintptr_t)nk_log_fmt_, (sizes) \
+                     __VA_ARGS__);                                \
+    } while (0)
+
+#define NK_LOG_0_(f)             NK_LOG_AT_(f, 0u, )
+#define NK_LOG_1_(f, a)          NK_LOG_AT_(f, NK_LOG_SZ_(a), , a)
+#define NK_LOG_2_(f, a, b)                                        \
+    NK_LOG_AT_(f, NK_LOG_SZ_(a) | NK_LOG_SZ_(b) << 2, , a, b)
+#define NK_LOG_3_(f, a, b, c)                                     \
+    NK_LOG_AT_(f, NK_LOG_SZ_(a) | NK_LOG_SZ_(b) << 2 |            \
+                  NK_LOG_SZ_(c) << 4, , a, b, c)
+#define NK_LOG_4_(f, a, b, c, d)                                  \
+    NK_LOG_AT_(f, NK_LOG_SZ_(a) | NK_LOG_SZ_(b) << 2 |            \
+                  NK_LOG_SZ_(c) << 4 | NK_LOG_SZ_(d) << 6, , a, b, c, d)
+
+#define NK_LOG_PICK_(_1, _2, _3, _4, _5, m, ...) m
+
+/**
+ * @brief Log a printf-style message, formatted later on the host
+ *
+ * @param ... A string literal, then up to four integer arguments
+ */
+#define NK_LOG(...)                                               \
+    NK_LOG_PICK_(__VA_ARGS__, NK_LOG_4_, NK_LOG_3_, NK_LOG_2_,    \
+                 NK_LOG_1_, NK_LOG_0_, _)(__VA_ARGS__)
+
+#else
+
+static inline void nk_log_init(void) {}
+static inline size_t nk_log_read(uint8_t core, void *dst, size_t len) {
+    (void)core; (void)dst; (void)len;
+    return 0;
+}
+static inline const void *nk_log_image(size_t *len) {
+    *len = 0;
+    return NULL;
+}
+
+#define NK_LOG(...) do { } while (0)
+
+#endif /* NK_LOG_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SYNC_NK_LOG_H */
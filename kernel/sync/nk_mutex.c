@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_mutex.c
+ * @brief Adaptive spin-then-block kernel mutex (see nk_mutex.h)
+ */
+
+#include "nk_mutex.h"
+#include "spinlock.h"
+#include "nk_trace.h"
+#include "arch/common/hal.h"
+
+void nk_mutex_init(nk_mutex_t *m) {
+    m->lock = 0u;
+    m->owner = NK_MUTEX_NO_OWNER;
+    nk_waitq_init(&m->waiters);
+    hal_memory_barrier();
+}
+
+bool nk_mutex_trylock(nk_mutex_t *m) {
+    if (hal_atomic_test_and_set_u8(&m->lock)) {
+        return false;
+    }
+    m->owner = nk_current_tid();
+    return true;
+}
+
+bool nk_mutex_spin(volatile uint8_t *lock, uint8_t owner) {
+#if NK_MUTEX_SPIN > 0
+    for (uint16_t i = 0; i < NK_MUTEX_SPIN; ++i) {
+        if (!*lock && !hal_atomic_test_and_set_u8(lock)) {
+            return true;
+        }
+        if (!nk_task_running(owner)) {
+            break;  /* Holder is off-CPU: it will not let go soon */
+        }
+        NK_SPIN_RELAX();
+    }
+#else
+    (void)lock;
+    (void)owner;
+#endif
+    return false;
+}
+
+void nk_mutex_lock(nk_mutex_t *m) {
+    if (nk_mutex_trylock(m)) {
+        return;
+    }
+
+    uint8_t self = nk_current_tid();
+    nk_trace_lock(self, m);
+    if (nk_mutex_spin(&m->lock, m->owner)) {
+        m->owner = self;
+        return;
+    }
+
+    /* Re-check under the scheduler lock, then park until handed over */
+    uint32_t s = nk_sched_lock();
+    if (!hal_atomic_test_and_set_u8(&m->lock)) {
+        m->owner = self;
+        nk_sched_unlock(s);
+        return;
+    }
+    nk_waitq_block(&m->waiters);
+}
+
+void nk_mutex_unlock(nk_mutex_t *m) {
+    uint32_t s = nk_sched_lock();
+    int next = nk_waitq_wake_one(&m->waiters);
+    if (next >= 0) {
+        m->owner = (uint8_t)next;  /* lock stays set: ownership moves */
+    } else {
+        m->owner = NK_MUTEX_NO_OWNER;
+        hal_atomic_exchange_u8(&m->lock, 0);
+    }
+    nk_sched_unlock(s);
+}
@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_mutex.h
+ * @brief Adaptive spin-then-block kernel mutex
+ *
+ * Uncontended lock and unlock are one test-and-set and one exchange.
+ * On contention the caller spins for up to NK_MUTEX_SPIN rounds, but
+ * only while the holder is running on another core (nk_task_running());
+ * a holder that is preempted or blocked will not release the lock
+ * soon, so the caller then parks on the mutex wait queue.  Unlock hands
+ * ownership straight to the first parked waiter.
+ *
+ * ```c
+ * static nk_mutex_t tbl_lock = NK_MUTEX_INIT;
+ *
+ * nk_mutex_lock(&tbl_lock);
+ * ...
+ * nk_mutex_unlock(&tbl_lock);
+ * ```
+ *
+ * Task context only; not recursive.
+ */
+
+#ifndef KERNEL_SYNC_NK_MUTEX_H
+#define KERNEL_SYNC_NK_MUTEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "avrix-config.h"
+#include "kernel/sched/scheduler.h"
+
+/**
+ * @brief Spin rounds before parking (sync_mutex_spin)
+ *
+ * 0 parks at once, which is right for single-core parts: a holder can
+ * never be running while the caller is.
+ */
+#ifndef NK_MUTEX_SPIN
+#  if defined(CONFIG_SYNC_MUTEX_SPIN)
+#    define NK_MUTEX_SPIN CONFIG_SYNC_MUTEX_SPIN
+#  else
+#    define NK_MUTEX_SPIN 0
+#  endif
+#endif
+
+#define NK_MUTEX_NO_OWNER 0xFFu  /**< owner value while unlocked */
+
+/**
+ * @brief Kernel mutex (3 bytes)
+ */
+typedef struct {
+    volatile uint8_t lock;     /**< 0 = free, 1 = held */
+    volatile uint8_t owner;    /**< Holder's tid, NK_MUTEX_NO_OWNER if free */
+    nk_waitq_t       waiters;  /**< Parked lockers */
+} nk_mutex_t;
+
+/** Static initializer for a kernel mutex. */
+#define NK_MUTEX_INIT { 0u, NK_MUTEX_NO_OWNER, NK_WAITQ_INIT }
+
+/**
+ * @brief Initialize a mutex
+ */
+void nk_mutex_init(nk_mutex_t *m);
+
+/**
+ * @brief Take the mutex if it is free
+ * @return true if acquired
+ */
+bool nk_mutex_trylock(nk_mutex_t *m);
+
+/**
+ * @brief Take the mutex, spinning briefly and then blocking
+ */
+void nk_mutex_lock(nk_mutex_t *m);
+
+/**
+ * @brief Release the mutex (hands it to the first waiter, if any)
+ */
+void nk_mutex_unlock(nk_mutex_t *m);
+
+/**
+ * @brief Adaptive spin phase on a test-and-set word
+ *
+ * Spins up to NK_MUTEX_SPIN rounds while @p owner is running,
+ * retrying the test-and-set whenever @p lock reads free.  Shared with
+ * pthread_mutex_lock() so both mutex flavours back off the same way.
+ *
+ * @param lock  Test-and-set lock byte
+ * @param owner Holder's tid as seen when contention began
+ * @return true if the lock was taken while spinning
+ */
+bool nk_mutex_spin(volatile uint8_t *lock, uint8_t owner);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SYNC_NK_MUTEX_H */
@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_prof.c
+ * @brief PC-sampling profiler histogram (see nk_prof.h)
+ */
+
+#include "arch/common/hal.h"
+#include "nk_prof.h"
+#include <string.h>
+
+#if NK_PROF
+
+/** End of the default range: all of flash */
+#ifndef NK_PROF_TEXT_END
+#  if defined(FLASHEND)
+#    define NK_PROF_TEXT_END ((uint32_t)FLASHEND + 1u)
+#  else
+#    define NK_PROF_TEXT_END 0x10000u
+#  endif
+#endif
+
+nk_prof_buf_t nk_prof_buf;
+
+void nk_prof_range(uint32_t lo, uint32_t hi) {
+    if (hi <= lo) {
+        hi = NK_PROF_TEXT_END;
+    }
+    uint8_t shift = 0;
+    while (shift < 31 && ((hi - lo - 1u) >> shift) >= NK_PROF_BINS) {
+        ++shift;
+    }
+
+    uint32_t s = hal_irq_save();
+    uint32_t hz = nk_prof_buf.hz;
+    memset(&nk_prof_buf, 0, sizeof nk_prof_buf);
+    nk_prof_buf.magic   = NK_PROF_MAGIC;
+    nk_prof_buf.version = NK_PROF_VERSION;
+    nk_prof_buf.shift   = shift;
+    nk_prof_buf.bins    = NK_PROF_BINS;
+    nk_prof_buf.base    = lo;
+    nk_prof_buf.hz      = hz;
+    hal_irq_restore(s);
+}
+
+/* Runs in the sampling ISR, interrupts masked */
+void nk_prof_hit(uint32_t pc) {
+    nk_prof_buf_t *p = &nk_prof_buf;
+    p->samples++;
+
+    uint32_t off = pc - p->base;
+    uint32_t bin = off >> p->shift;
+    if (pc < p->base || bin >= NK_PROF_BINS) {
+        p->outside++;
+    } else if (p->count[bin] != UINT16_MAX) {
+        p->count[bin]++;
+    }
+}
+
+#if HAL_HAS_PROF_TIMER
+/* Sink of the HAL's sampling ISR (weak no-op there) */
+void hal_prof_sample(uint32_t pc) {
+    nk_prof_hit(pc);
+}
+#endif
+
+bool nk_prof_start(uint16_t hz) {
+#if HAL_HAS_PROF_TIMER
+    if (nk_prof_buf.magic != NK_PROF_MAGIC) {
+        nk_prof_range(0, 0);
+    }
+    if (!hal_prof_timer_start(hz)) {
+        return false;
+    }
+    nk_prof_buf.hz = hz;
+    return true;
+#else
+    (void)hz;
+    return false;
+#endif
+}
+
+void nk_prof_stop(void) {
+#if HAL_HAS_PROF_TIMER
+    hal_prof_timer_stop();
+#endif
+    nk_prof_buf.hz = 0;
+}
+
+const void *nk_prof_image(size_t *len) {
+    *len = sizeof nk_prof_buf;
+    return &nk_prof_buf;
+}
+
+#endif /* NK_PROF */
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_prof.h
+ * @brief PC-sampling profiler for target builds (debug_prof)
+ *
+ * With NK_PROF set, a spare hardware timer (Timer2 on AVR) interrupts
+ * the CPU at a fixed rate and the ISR charges the interrupted program
+ * counter to a histogram: NK_PROF_BINS 16-bit counters, each covering
+ * 2^shift bytes of flash from a base address.  This is the gprof
+ * histogram, not a call graph; attribution is to the function under
+ * the PC, which is what a flat profile of a small firmware needs.
+ *
+ * ```c
+ * nk_prof_range(0, 0);              // all of flash
+ * nk_prof_start(997);               // prime rate: no beat with the tick
+ * run_workload();
+ * nk_prof_stop();
+ * size_t len;
+ * slip_send_packet(&uart, nk_prof_image(&len), len);
+ * ```
+ *
+ * scripts/prof_fold.py symbolises the image against the ELF and prints
+ * folded stacks; `flamegraph_analysis.sh --avr image elf` draws them.
+ * The image can also be dumped from the GDB stub (symbol nk_prof_buf),
+ * which works the same under simavr's gdb server.
+ *
+ * 256 bins over the 328P's 32 KB give 128-byte buckets; narrow the
+ * range with nk_prof_range() to zoom in on hot code.  Without NK_PROF
+ * nothing is linked and nk_prof_start() fails.
+ */
+
+#ifndef KERNEL_SYNC_NK_PROF_H
+#define KERNEL_SYNC_NK_PROF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "avrix-config.h"
+
+#ifndef NK_PROF
+#  if defined(CONFIG_DEBUG_PROF)
+#    define NK_PROF CONFIG_DEBUG_PROF
+#  else
+#    define NK_PROF 0
+#  endif
+#endif
+
+/** Histogram buckets (2 bytes of RAM each) */
+#ifndef NK_PROF_BINS
+#  if defined(CONFIG_DEBUG_PROF_BINS)
+#    define NK_PROF_BINS CONFIG_DEBUG_PROF_BINS
+#  else
+#    define NK_PROF_BINS 256
+#  endif
+#endif
+
+#define NK_PROF_MAGIC   0x46504B4Eu    /**< "NKPF" little-endian */
+#define NK_PROF_VERSION 1u
+
+/**
+ * @brief Histogram image, as dumped and decoded (little-endian)
+ *
+ * Bucket i counts samples with base + (i << shift) <= pc <
+ * base + ((i + 1) << shift); PCs are byte addresses.
+ */
+typedef struct {
+    uint32_t magic;                 /**< NK_PROF_MAGIC */
+    uint8_t  version;               /**< NK_PROF_VERSION */
+    uint8_t  shift;                 /**< log2 of the bucket width */
+    uint16_t bins;                  /**< NK_PROF_BINS */
+    uint32_t base;                  /**< Address of bucket 0 */
+    uint32_t hz;                    /**< Sample rate, 0 = not running */
+    uint32_t samples;               /**< All samples taken */
+    uint32_t outside;               /**< Samples outside the range */
+    uint16_t count[NK_PROF_BINS];   /**< Saturating bucket counters */
+} nk_prof_buf_t;
+
+#if NK_PROF
+
+/** The histogram; global so a debugger can find it by name */
+extern nk_prof_buf_t nk_prof_buf;
+
+/**
+ * @brief Choose the profiled address range and clear the histogram
+ *
+ * The bucket width is the smallest power of two that spreads
+ * [lo, hi) over NK_PROF_BINS buckets.
+ *
+ * @param lo First byte address
+ * @param hi One past the last; 0 = end of flash
+ */
+void nk_prof_range(uint32_t lo, uint32_t hi);
+
+/**
+ * @brief Start sampling @p hz times a second
+ *
+ * Pick a rate that does not divide the scheduler tick, or the samples
+ * line up with it.
+ *
+ * @return false without a profiling timer or if @p hz is out of its
+ *         range
+ */
+bool nk_prof_start(uint16_t hz);
+
+/** Stop sampling; the histogram is kept */
+void nk_prof_stop(void);
+
+/** Charge one sample at byte address @p pc (called by the timer ISR) */
+void nk_prof_hit(uint32_t pc);
+
+/**
+ * @brief The image to send to the host
+ *
+ * @param len Receives its size in bytes
+ * @return &nk_prof_buf
+ */
+const void *nk_prof_image(size_t *len);
+
+#else
+
+static inline void nk_prof_range(uint32_t lo, uint32_t hi) { (void)lo; (void)hi; }
+static inline bool nk_prof_start(uint16_t hz) { (void)hz; return false; }
+static inline void nk_prof_stop(void) {}
+static inline void nk_prof_hit(uint32_t pc) { (void)pc; }
+static inline const void *nk_prof_image(size_t *len) {
+    *len = 0;
+    return NULL;
+}
+
+#endif /* NK_PROF */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SYNC_NK_PROF_H */
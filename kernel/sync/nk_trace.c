@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_trace.c
+ * @brief Binary kernel event trace (see nk_trace.h)
+ */
+
+#include "arch/common/hal.h"
+#include "nk_trace.h"
+#include <string.h>
+
+#if NK_TRACE
+
+#if NK_TRACE_EVENTS & (NK_TRACE_EVENTS - 1) || NK_TRACE_EVENTS > 32768
+#  error "NK_TRACE_EVENTS must be a power of two, at most 32768"
+#endif
+
+/** Timestamp source */
+#ifndef NK_TRACE_CLOCK
+#  define NK_TRACE_CLOCK() hal_cycles()
+#endif
+
+#ifndef NK_TRACE_HZ
+#  define NK_TRACE_HZ HAL_CYCLES_HZ
+#endif
+
+nk_trace_buf_t nk_trace_buf HAL_SECTION(".noinit");
+
+static volatile uint8_t trace_paused;
+
+static inline uint8_t core(void) {
+#if NK_TRACE_CORES > 1
+    return hal_cpu_id();
+#else
+    return 0;
+#endif
+}
+
+void nk_trace_clear(void) {
+    uint32_t s = hal_irq_save();
+    memset(&nk_trace_buf, 0, sizeof nk_trace_buf);
+    nk_trace_buf.version = NK_TRACE_VERSION;
+    nk_trace_buf.cores   = NK_TRACE_CORES;
+    nk_trace_buf.events  = NK_TRACE_EVENTS;
+    nk_trace_buf.hz      = NK_TRACE_HZ;
+    nk_trace_buf.magic   = NK_TRACE_MAGIC;
+    hal_irq_restore(s);
+}
+
+void nk_trace_init(void) {
+    const nk_trace_buf_t *t = &nk_trace_buf;
+    bool intact = t->magic == NK_TRACE_MAGIC &&
+                  t->version == NK_TRACE_VERSION &&
+                  t->cores == NK_TRACE_CORES &&
+                  t->events == NK_TRACE_EVENTS;
+    for (uint8_t c = 0; intact && c < NK_TRACE_CORES; ++c) {
+        intact = t->head[c].count <= NK_TRACE_EVENTS;
+    }
+    if (!intact) {
+        nk_trace_clear();
+    }
+    trace_paused = 0;
+}
+
+void nk_trace_pause(bool paused) {
+    trace_paused = paused;
+    hal_memory_barrier();
+}
+
+void nk_trace_rec(uint8_t type, uint8_t a, uint16_t b) {
+    if (trace_paused || nk_trace_buf.magic != NK_TRACE_MAGIC) {
+        return;
+    }
+
+    uint32_t s = hal_irq_save();
+    uint8_t c = core();
+    uint16_t n = nk_trace_buf.head[c].next;
+    nk_trace_ev_t *e = &nk_trace_buf.ev[c][n & (NK_TRACE_EVENTS - 1u)];
+    e->ts   = NK_TRACE_CLOCK();
+    e->type = type;
+    e->a    = a;
+    e->b    = b;
+    nk_trace_buf.head[c].next = (uint16_t)(n + 1u);
+    if (nk_trace_buf.head[c].count < NK_TRACE_EVENTS) {
+        nk_trace_buf.head[c].count++;
+    }
+    hal_irq_restore(s);
+}
+
+const void *nk_trace_image(size_t *len) {
+    *len = sizeof nk_trace_buf;
+    return &nk_trace_buf;
+}
+
+#endif /* NK_TRACE */
@@ -0,0 +1,204 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file nk_trace.h
+ * @brief Binary kernel event trace in .noinit (debug_trace)
+ *
+ * With NK_TRACE set, the scheduler, doors, locks, ISRs and software
+ * timers append fixed-size records to a ring per core.  Each record is
+ * eight bytes: a hal_cycles() timestamp, an event type and two
+ * operands.  The ring lives in .noinit, so a watchdog or warm reset
+ * leaves the last NK_TRACE_EVENTS events of the crashed run in place
+ * for the debugger; nk_trace_init() only clears it when the header does
+ * not match.
+ *
+ * The whole ring is one self-describing image, nk_trace_buf: dump it
+ * from the GDB stub, or pause recording and send nk_trace_image() as a
+ * SLIP frame.  scripts/trace_decode.py turns either into Chrome trace /
+ * Perfetto JSON with one track per task.
+ *
+ * ```c
+ * size_t len;
+ * nk_trace_pause(true);
+ * slip_send_packet(&uart, nk_trace_image(&len), len);
+ * nk_trace_pause(false);
+ * ```
+ *
+ * Recording masks interrupts for a handful of stores.  Without
+ * NK_TRACE the hooks compile to nothing and the ring is not linked.
+ */
+
+#ifndef KERNEL_SYNC_NK_TRACE_H
+#define KERNEL_SYNC_NK_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "avrix-config.h"
+
+#ifndef NK_TRACE
+#  if defined(CONFIG_DEBUG_TRACE)
+#    define NK_TRACE CONFIG_DEBUG_TRACE
+#  else
+#    define NK_TRACE 0
+#  endif
+#endif
+
+/** Records per core (power of two, at most 32768) */
+#ifndef NK_TRACE_EVENTS
+#  if defined(CONFIG_DEBUG_TRACE_EVENTS)
+#    define NK_TRACE_EVENTS CONFIG_DEBUG_TRACE_EVENTS
+#  else
+#    define NK_TRACE_EVENTS 64
+#  endif
+#endif
+
+#ifndef CONFIG_KERNEL_SMP_CORES
+#  define CONFIG_KERNEL_SMP_CORES 1
+#endif
+#define NK_TRACE_CORES CONFIG_KERNEL_SMP_CORES
+
+#define NK_TRACE_MAGIC   0x52544B4Eu   /**< "NKTR" little-endian */
+#define NK_TRACE_VERSION 1u
+
+/** Event types; operands a / b as listed */
+enum {
+    NK_TR_SWITCH      = 1,  /**< a = from tid, b = to tid */
+    NK_TR_DOOR_CALL   = 2,  /**< a = caller, b = door idx | target << 8 */
+    NK_TR_DOOR_RETURN = 3,  /**< a = server, b = caller */
+    NK_TR_LOCK        = 4,  /**< Contended: a = tid, b = lock address */
+    NK_TR_ISR_ENTER   = 5,  /**< a = NK_TRACE_IRQ_* */
+    NK_TR_ISR_EXIT    = 6,  /**< a = NK_TRACE_IRQ_* */
+    NK_TR_TIMER       = 7,  /**< ktimer expired: b = timer address */
+    NK_TR_USER        = 16, /**< First application-defined type */
+};
+
+/** Interrupt sources named by the decoder */
+enum {
+    NK_TRACE_IRQ_UART_RX = 1,
+    NK_TRACE_IRQ_UART_TX = 2,
+    NK_TRACE_IRQ_EEPROM  = 3,
+    NK_TRACE_IRQ_USER    = 16,
+};
+
+/**
+ * @brief One trace record
+ */
+typedef struct {
+    uint32_t ts;        /**< hal_cycles() */
+    uint8_t  type;      /**< NK_TR_* */
+    uint8_t  a;
+    uint16_t b;
+} nk_trace_ev_t;
+
+/**
+ * @brief Complete trace image, as dumped and decoded
+ *
+ * All fields little-endian.  Ring @c c holds its oldest record at
+ * `head[c].next - head[c].count` (modulo NK_TRACE_EVENTS).
+ */
+typedef struct {
+    uint32_t magic;             /**< NK_TRACE_MAGIC once initialised */
+    uint8_t  version;           /**< NK_TRACE_VERSION */
+    uint8_t  cores;             /**< Rings that follow */
+    uint16_t events;            /**< Records per ring */
+    uint32_t hz;                /**< Timestamp clock (HAL_CYCLES_HZ) */
+    struct {
+        uint16_t next;          /**< Records written, modulo 2^16 */
+        uint16_t count;         /**< Valid records, saturates at events */
+    } head[NK_TRACE_CORES];
+    nk_trace_ev_t ev[NK_TRACE_CORES][NK_TRACE_EVENTS];
+} nk_trace_buf_t;
+
+#if NK_TRACE
+
+/** The ring; global so a debugger can find it by name */
+extern nk_trace_buf_t nk_trace_buf;
+
+/**
+ * @brief Prepare the ring at boot
+ *
+ * Keeps the records of the previous run when the header is intact
+ * (warm reset), clears them otherwise.
+ */
+void nk_trace_init(void);
+
+/** Drop every record */
+void nk_trace_clear(void);
+
+/** Stop (true) or resume (false) recording, e.g. around a dump */
+void nk_trace_pause(bool paused);
+
+/**
+ * @brief Append one record to the calling core's ring; safe from ISRs
+ */
+void nk_trace_rec(uint8_t type, uint8_t a, uint16_t b);
+
+/**
+ * @brief The image to send to the host
+ *
+ * @param len Receives its size in bytes
+ * @return &nk_trace_buf
+ */
+const void *nk_trace_image(size_t *len);
+
+#else
+
+static inline void nk_trace_init(void) {}
+static inline void nk_trace_clear(void) {}
+static inline void nk_trace_pause(bool paused) { (void)paused; }
+static inline void nk_trace_rec(uint8_t type, uint8_t a, uint16_t b) {
+    (void)type; (void)a; (void)b;
+}
+static inline const void *nk_trace_image(size_t *len) {
+    *len = 0;
+    return NULL;
+}
+
+#endif /* NK_TRACE */
+
+/*═══════════════════════════════════════════════════════════════════
+ * HOOKS (used by the kernel)
+ *═══════════════════════════════════════════════════════════════════*/
+
+static inline void nk_trace_switch(uint8_t from, uint8_t to) {
+    nk_trace_rec(NK_TR_SWITCH, from, to);
+}
+
+static inline void nk_trace_door_call(uint8_t caller, uint8_t idx,
+                                      uint8_t target) {
+    nk_trace_rec(NK_TR_DOOR_CALL, caller,
+                 (uint16_t)(idx | (uint16_t)target << 8));
+}
+
+static inline void nk_trace_door_return(uint8_t server, uint8_t caller) {
+    nk_trace_rec(NK_TR_DOOR_RETURN, server, caller);
+}
+
+static inline void nk_trace_lock(uint8_t tid, const volatile void *lock) {
+    nk_trace_rec(NK_TR_LOCK, tid, (uint16_t)(uintptr_t)lock);
+}
+
+static inline void nk_trace_isr_enter(uint8_t irq) {
+    nk_trace_rec(NK_TR_ISR_ENTER, irq, 0);
+}
+
+static inline void nk_trace_isr_exit(uint8_t irq) {
+    nk_trace_rec(NK_TR_ISR_EXIT, irq, 0);
+}
+
+static inline void nk_trace_timer(const void *timer) {
+    nk_trace_rec(NK_TR_TIMER, 0, (uint16_t)(uintptr_t)timer);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SYNC_NK_TRACE_H */
@@ -0,0 +1,187 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file rwlock.h
+ * @brief Writer-preferring reader-writer spinlock
+ *
+ * Any number of readers (up to 255) hold the lock together; a writer
+ * holds it alone.  All state lives in one 16-bit word updated with
+ * hal_atomic_compare_exchange_u16(), so taking a read lock costs one
+ * CAS and readers never wait for each other.
+ *
+ * ```
+ *  bit 15     : a writer holds the lock
+ *  bits 14..8 : writers waiting
+ *  bits  7..0 : readers holding the lock
+ * ```
+ *
+ * A waiting writer stops new readers from entering, so a steady stream
+ * of readers cannot starve updates (a steady stream of writers can
+ * starve readers; use nk_seqlock_t when writes are frequent).
+ *
+ * ```c
+ * static nk_rwlock_t mounts_lock = NK_RWLOCK_STATIC_INIT;
+ *
+ * nk_rwlock_read_lock(&mounts_lock);    // lookups run concurrently
+ * ...
+ * nk_rwlock_read_unlock(&mounts_lock);
+ * ```
+ *
+ * Like all spinlocks here it does not mask interrupts; an ISR must not
+ * take a lock whose holder it may have interrupted.
+ */
+
+#ifndef KERNEL_SYNC_RWLOCK_H
+#define KERNEL_SYNC_RWLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "spinlock.h"
+
+#define NK_RW_WRITER    0x8000u  /**< Write-held flag */
+#define NK_RW_WAIT_ONE  0x0100u  /**< One waiting writer */
+#define NK_RW_WAIT_MASK 0x7F00u  /**< Waiting-writer count */
+#define NK_RW_READERS   0x00FFu  /**< Reader count */
+
+/**
+ * @brief Reader-writer lock (2 bytes)
+ */
+typedef struct {
+    volatile uint16_t state;  /**< See file comment for the layout */
+} nk_rwlock_t;
+
+/** Static initializer for a reader-writer lock. */
+#define NK_RWLOCK_STATIC_INIT { 0u }
+
+/**
+ * @brief Initialize a reader-writer lock
+ *
+ * @param l Pointer to lock
+ */
+static inline void nk_rwlock_init(nk_rwlock_t *l) {
+    l->state = 0u;
+    hal_memory_barrier();
+}
+
+/**
+ * @brief Try to take a read lock (non-blocking)
+ *
+ * Fails while a writer holds or waits for the lock.
+ *
+ * @param l Pointer to lock
+ * @return true if acquired
+ */
+static inline bool nk_rwlock_read_trylock(nk_rwlock_t *l) {
+    uint16_t s = l->state;
+    for (;;) {
+        if ((s & (NK_RW_WRITER | NK_RW_WAIT_MASK)) ||
+            (s & NK_RW_READERS) == NK_RW_READERS) {
+            return false;
+        }
+        if (hal_atomic_compare_exchange_u16(&l->state, &s, (uint16_t)(s + 1u))) {
+            hal_memory_barrier();
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Take a read lock (blocking)
+ *
+ * @param l Pointer to lock
+ */
+static inline void nk_rwlock_read_lock(nk_rwlock_t *l) {
+    while (!nk_rwlock_read_trylock(l)) {
+        NK_SPIN_RELAX();
+    }
+}
+
+/**
+ * @brief Drop a read lock
+ *
+ * @param l Pointer to lock
+ */
+static inline void nk_rwlock_read_unlock(nk_rwlock_t *l) {
+    hal_memory_barrier();
+    hal_atomic_fetch_sub_u16(&l->state, 1u);
+}
+
+/**
+ * @brief Try to take the write lock (non-blocking)
+ *
+ * @param l Pointer to lock
+ * @return true if acquired; false while readers or a writer hold it
+ */
+static inline bool nk_rwlock_write_trylock(nk_rwlock_t *l) {
+    uint16_t s = l->state;
+    for (;;) {
+        if (s & (NK_RW_WRITER | NK_RW_READERS)) {
+            return false;
+        }
+        if (hal_atomic_compare_exchange_u16(&l->state, &s,
+                                            (uint16_t)(s | NK_RW_WRITER))) {
+            hal_memory_barrier();
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Take the write lock (blocking)
+ *
+ * Registers as a waiting writer first, which holds off new readers,
+ * then waits for current holders to drain.
+ *
+ * @param l Pointer to lock
+ */
+static inline void nk_rwlock_write_lock(nk_rwlock_t *l) {
+    uint16_t s = l->state;
+    for (;;) {
+        if ((s & NK_RW_WAIT_MASK) == NK_RW_WAIT_MASK) {
+            NK_SPIN_RELAX();
+            s = l->state;
+            continue;
+        }
+        if (hal_atomic_compare_exchange_u16(&l->state, &s,
+                                            (uint16_t)(s + NK_RW_WAIT_ONE))) {
+            break;
+        }
+    }
+
+    s = l->state;
+    for (;;) {
+        if (s & (NK_RW_WRITER | NK_RW_READERS)) {
+            NK_SPIN_RELAX();
+            s = l->state;
+            continue;
+        }
+        uint16_t v = (uint16_t)((s - NK_RW_WAIT_ONE) | NK_RW_WRITER);
+        if (hal_atomic_compare_exchange_u16(&l->state, &s, v)) {
+            break;
+        }
+    }
+    hal_memory_barrier();
+}
+
+/**
+ * @brief Drop the write lock
+ *
+ * @param l Pointer to lock
+ */
+static inline void nk_rwlock_write_unlock(nk_rwlock_t *l) {
+    hal_memory_barrier();
+    /* Waiting writers may bump their count concurrently: RMW, not store */
+    hal_atomic_fetch_and_u16(&l->state, (uint16_t)~NK_RW_WRITER);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SYNC_RWLOCK_H */
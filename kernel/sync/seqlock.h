@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file seqlock.h
+ * @brief Sequence locks for small read-mostly records
+ *
+ * Writers serialise on an nk_slock_t and bump a sequence counter on
+ * entry and exit, so the counter is odd while an update is in flight.
+ * Readers take no lock at all: they copy the data out and retry if the
+ * counter was odd or moved meanwhile.  Readers never delay each other
+ * or the writer.
+ *
+ * ```c
+ * nk_seq_t seq;
+ * do {
+ *     seq = nk_seq_read_begin(&stats_lock);
+ *     copy = stats;
+ * } while (nk_seq_read_retry(&stats_lock, seq));
+ * ```
+ *
+ * Suits plain-data records (statistics, configuration) that a reader
+ * can copy in a few instructions.  Data holding pointers a writer may
+ * free needs nk_rwlock_t instead.  A reader must not interrupt a
+ * writer on the same core (it would spin forever); update data that
+ * ISRs read with interrupts masked.
+ */
+
+#ifndef KERNEL_SYNC_SEQLOCK_H
+#define KERNEL_SYNC_SEQLOCK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "spinlock.h"
+
+/**
+ * @brief Sequence counter type
+ *
+ * One byte on 8-bit parts so readers load it atomically; a reader
+ * would have to be stalled across 128 updates to be fooled by the wrap.
+ */
+#if HAL_WORD_SIZE == 8
+typedef uint8_t nk_seq_t;
+#else
+typedef uint32_t nk_seq_t;
+#endif
+
+/**
+ * @brief Sequence lock
+ */
+typedef struct {
+    volatile nk_seq_t seq;  /**< Odd while a writer is inside */
+    nk_slock_t        wlock;/**< Serialises writers */
+} nk_seqlock_t;
+
+/** Static initializer for a sequence lock. */
+#define NK_SEQLOCK_STATIC_INIT { 0u, NK_SLOCK_STATIC_INIT }
+
+/**
+ * @brief Initialize a sequence lock
+ *
+ * @param s Pointer to sequence lock
+ */
+static inline void nk_seqlock_init(nk_seqlock_t *s) {
+    s->seq = 0u;
+    nk_slock_init(&s->wlock);
+}
+
+/**
+ * @brief Start a read section
+ *
+ * Waits out a writer already inside.
+ *
+ * @param s Pointer to sequence lock
+ * @return Sequence number to hand to nk_seq_read_retry()
+ */
+static inline nk_seq_t nk_seq_read_begin(const nk_seqlock_t *s) {
+    nk_seq_t seq;
+    while ((seq = s->seq) & 1u) {
+        NK_SPIN_RELAX();
+    }
+    hal_memory_barrier();
+    return seq;
+}
+
+/**
+ * @brief End a read section
+ *
+ * @param s   Pointer to sequence lock
+ * @param seq Value returned by nk_seq_read_begin()
+ * @return true if a writer intervened and the data must be read again
+ */
+static inline bool nk_seq_read_retry(const nk_seqlock_t *s, nk_seq_t seq) {
+    hal_memory_barrier();
+    return s->seq != seq;
+}
+
+/**
+ * @brief Enter a write section (excludes other writers)
+ *
+ * @param s Pointer to sequence lock
+ */
+static inline void nk_seq_write_lock(nk_seqlock_t *s) {
+    nk_slock_lock(&s->wlock);
+    s->seq = (nk_seq_t)(s->seq + 1u);
+    hal_memory_barrier();
+}
+
+/**
+ * @brief Leave a write section
+ *
+ * @param s Pointer to sequence lock
+ */
+static inline void nk_seq_write_unlock(nk_seqlock_t *s) {
+    hal_memory_barrier();
+    s->seq = (nk_seq_t)(s->seq + 1u);
+    nk_slock_unlock(&s->wlock);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KERNEL_SYNC_SEQLOCK_H */
@@ -6,13 +6,18 @@
  * @file spinlock.c
  * @brief Composite Spinlock Implementation
  *
- * Implements high-level spinlock operations with global Big Kernel Lock (BKL).
+ * Implements high-level spinlock operations with global Big Kernel Lock (BKL)
+ * or, with NK_SPIN_BKL = 0, one lock per subsystem domain.
  * Provides both normal and real-time (BKL-bypass) modes.
  */
 
 #include "spinlock.h"
+#include "nk_trace.h"
 #include "arch/common/hal.h"
 #include <stddef.h>
+#if NK_TRACE
+#  include "kernel/sched/scheduler.h"
+#endif
 
 /*═══════════════════════════════════════════════════════════════════
  * GLOBAL BIG KERNEL LOCK (BKL)
@@ -26,6 +31,21 @@
  */
 nk_slock_t nk_bkl = {0};
 
+#if !NK_SPIN_BKL
+/* Domain locks; NK_LOCK_DOM_GLOBAL uses nk_bkl, so slot 0 is unused */
+static nk_slock_t nk_domain_lock[NK_LOCK_DOMAINS];
+#endif
+
+/* Lock serializing nk_spinlock_lock() sections of @p s's domain */
+static inline nk_slock_t *domain_lock(const nk_spinlock_t *s) {
+#if NK_SPIN_BKL
+    (void)s;
+    return &nk_bkl;
+#else
+    return s->domain ? &nk_domain_lock[s->domain] : &nk_bkl;
+#endif
+}
+
 /*═══════════════════════════════════════════════════════════════════
  * GLOBAL INITIALIZATION
  *═══════════════════════════════════════════════════════════════════*/
@@ -39,31 +59,70 @@ nk_slock_t nk_bkl = {0};
  */
 void nk_spinlock_global_init(void) {
     nk_slock_init(&nk_bkl);
+#if !NK_SPIN_BKL
+    for (uint8_t d = 1; d < NK_LOCK_DOMAINS; d++) {
+        nk_slock_init(&nk_domain_lock[d]);
+    }
+#endif
 }
 
 /*═══════════════════════════════════════════════════════════════════
  * COMPOSITE SPINLOCK OPERATIONS
  *═══════════════════════════════════════════════════════════════════*/
 
+#if NK_LOCK_STATS
+#  define SPIN_STAT(s) (&(s)->stat)
+#else
+#  define SPIN_STAT(s) ((nk_lockstat_t *)NULL)
+#endif
+
+/* Take the instance lock, charging any spinning to its statistics */
+static inline void spin_core_lock(nk_spinlock_t *s) {
+    uint32_t spins = nk_lockstat_spins();
+#if NK_TRACE
+    if (!nk_slock_trylock(&s->core)) {
+        nk_trace_lock(nk_current_tid(), s);
+        nk_slock_lock(&s->core);
+    }
+#else
+    nk_slock_lock(&s->core);
+#endif
+    nk_lockstat_acquired(SPIN_STAT(s), nk_lockstat_spins() - spins, false);
+}
+
 /**
  * @brief Initialize a composite spinlock
  *
  * @param s Pointer to spinlock
  */
 void nk_spinlock_init(nk_spinlock_t *s) {
+    nk_spinlock_init_domain(s, NK_LOCK_DOM_GLOBAL);
+}
+
+/**
+ * @brief Initialize a composite spinlock of domain @p d
+ *
+ * @param s Pointer to spinlock
+ * @param d Subsystem the lock belongs to
+ */
+void nk_spinlock_init_domain(nk_spinlock_t *s, nk_lock_domain_t d) {
     if (!s) return;
 
     nk_slock_init(&s->core);
     s->dag_mask = 0u;
     s->rt_mode  = 0u;
+    s->domain   = (d < NK_LOCK_DOMAINS) ? (uint8_t)d : (uint8_t)NK_LOCK_DOM_GLOBAL;
     for (size_t i = 0; i < 4; ++i) {
         s->matrix[i] = 0u;
     }
+#if NK_LOCK_STATS
+    s->stat = (nk_lockstat_t)NK_LOCKSTAT_INIT(NULL);
+#endif
     hal_memory_barrier();
 }
 
 /**
- * @brief Acquire spinlock (global BKL + core lock)
+ * @brief Acquire spinlock (BKL or domain lock + core lock)
  *
  * @param s Pointer to spinlock
  * @param mask Dependency mask to record
@@ -71,9 +130,9 @@ void nk_spinlock_init(nk_spinlock_t *s) {
 void nk_spinlock_lock(nk_spinlock_t *s, uint8_t mask) {
     if (!s) return;
 
-    /* Acquire global BKL first, then instance lock */
-    nk_slock_lock(&nk_bkl);
-    nk_slock_lock(&s->core);
+    /* Acquire BKL or domain lock first, then instance lock */
+    nk_slock_lock(domain_lock(s));
+    spin_core_lock(s);
 
     /* Memory barrier for acquire semantics */
     hal_memory_barrier();
@@ -93,16 +152,18 @@ void nk_spinlock_lock(nk_spinlock_t *s, uint8_t mask) {
 bool nk_spinlock_trylock(nk_spinlock_t *s, uint8_t mask) {
     if (!s) return false;
 
-    /* Try to acquire global BKL */
-    if (!nk_slock_trylock(&nk_bkl)) {
+    /* Try to acquire BKL or domain lock */
+    nk_slock_t *outer = domain_lock(s);
+    if (!nk_slock_trylock(outer)) {
         return false;
     }
 
     /* Try to acquire instance lock */
     if (!nk_slock_trylock(&s->core)) {
-        nk_slock_unlock(&nk_bkl);
+        nk_slock_unlock(outer);
         return false;
     }
+    nk_lockstat_acquired(SPIN_STAT(s), 0, false);
 
     /* Memory barrier for acquire semantics */
     hal_memory_barrier();
@@ -115,7 +176,7 @@ bool nk_spinlock_trylock(nk_spinlock_t *s, uint8_t mask) {
 }
 
 /**
- * @brief Release spinlock (core lock + global BKL)
+ * @brief Release spinlock (core lock + BKL or domain lock)
  *
  * @param s Pointer to spinlock
  */
@@ -130,8 +191,9 @@ void nk_spinlock_unlock(nk_spinlock_t *s) {
     s->rt_mode  = 0u;
 
     /* Release locks in reverse order */
+    nk_lockstat_released(SPIN_STAT(s));
     nk_slock_unlock(&s->core);
-    nk_slock_unlock(&nk_bkl);
+    nk_slock_unlock(domain_lock(s));
 }
 
 /*═══════════════════════════════════════════════════════════════════
@@ -150,7 +212,7 @@ void nk_spinlock_lock_rt(nk_spinlock_t *s, uint8_t mask) {
     if (!s) return;
 
     /* Only acquire instance lock, skip BKL */
-    nk_slock_lock(&s->core);
+    spin_core_lock(s);
 
     /* Memory barrier for acquire semantics */
     hal_memory_barrier();
@@ -174,6 +236,7 @@ bool nk_spinlock_trylock_rt(nk_spinlock_t *s, uint8_t mask) {
     if (!nk_slock_trylock(&s->core)) {
         return false;
     }
+    nk_lockstat_acquired(SPIN_STAT(s), 0, false);
 
     /* Memory barrier for acquire semantics */
     hal_memory_barrier();
@@ -201,5 +264,6 @@ void nk_spinlock_unlock_rt(nk_spinlock_t *s) {
     s->rt_mode  = 0u;
 
     /* Release instance lock only */
+    nk_lockstat_released(SPIN_STAT(s));
     nk_slock_unlock(&s->core);
 }
@@ -20,14 +20,19 @@
  *    - Slightly larger but provides fairness
  *    - Enable with NK_ENABLE_QLOCK=1
  *
- * 3. **Smart Lock (slock)** - Composable lock with optional features
- *    - Base: TAS spinlock
+ * 3. **MCS Lock (mcslock)** - Queue lock for SMP (2 pointers)
+ *    - Each waiter spins on its own stack node, not on the lock word
+ *    - FIFO hand-off; releasing touches only the next waiter's line
+ *
+ * 4. **Smart Lock (slock)** - Composable lock with optional features
+ *    - Base: TAS, ticket or MCS lock, chosen by NK_SPINLOCK_IMPL
  *    - Optional: Beatty lattice fairness (compile-time)
  *    - Optional: DAG dependency tracking (compile-time)
  *    - Enable features with NK_ENABLE_LATTICE and NK_ENABLE_DAG
  *
- * 4. **Composite Spinlock** - High-level spinlock with BKL
- *    - Global Big Kernel Lock (BKL) for coarse-grained serialization
+ * 5. **Composite Spinlock** - High-level spinlock with BKL
+ *    - Global Big Kernel Lock (BKL) for coarse-grained serialization,
+ *      or one lock per subsystem domain (NK_SPIN_BKL = 0)
  *    - Per-instance locks for fine-grained control
  *    - Real-time mode to bypass BKL
  *    - Speculative COW snapshot support
@@ -68,11 +73,50 @@ extern "C" {
 #include <stdbool.h>
 #include <stddef.h>
 #include "arch/common/hal.h"
+#include "avrix-config.h"
+#include "lockstat.h"
 
 /*═══════════════════════════════════════════════════════════════════
  * CONFIGURATION
  *═══════════════════════════════════════════════════════════════════*/
 
+/**
+ * @brief Lock underneath nk_slock_t / nk_spinlock_t
+ *
+ * Follows sync_spinlock_impl: 'tas' (0, 1-byte test-and-set), 'ticket'
+ * (1, FIFO ticket lock) or 'mcs' (2, queue lock with per-waiter
+ * spinning).  The MCS lock needs pointer-wide atomics, so 8-bit parts
+ * (all single-core) stay on the TAS lock whatever the profile asks.
+ */
+#define NK_SPINLOCK_TAS    0
+#define NK_SPINLOCK_TICKET 1
+#define NK_SPINLOCK_MCS    2
+
+#ifndef NK_SPINLOCK_IMPL
+#  if defined(CONFIG_SYNC_SPINLOCK_IMPL) && \
+      (HAL_WORD_SIZE > 8 || CONFIG_SYNC_SPINLOCK_IMPL != NK_SPINLOCK_MCS)
+#    define NK_SPINLOCK_IMPL CONFIG_SYNC_SPINLOCK_IMPL
+#  else
+#    define NK_SPINLOCK_IMPL NK_SPINLOCK_TAS
+#  endif
+#endif
+
+/**
+ * @brief Body of every spin-wait loop
+ *
+ * A barrier by default (plus a spin count with NK_LOCK_STATS).  Hosted
+ * builds where "cores" are threads that may share one CPU can define
+ * it to sched_yield() so a preempted lock holder or next-in-line
+ * waiter gets to run.
+ */
+#ifndef NK_SPIN_RELAX
+#  if NK_LOCK_STATS
+#    define NK_SPIN_RELAX() (nk_lockstat_spin(), hal_memory_barrier())
+#  else
+#    define NK_SPIN_RELAX() hal_memory_barrier()
+#  endif
+#endif
+
 /**
  * @brief Enable quaternion ticket lock (fair FIFO ordering)
  *
@@ -80,14 +124,14 @@ extern "C" {
  * Provides starvation-free fairness.
  */
 #ifndef NK_ENABLE_QLOCK
-#  define NK_ENABLE_QLOCK 0
+#  define NK_ENABLE_QLOCK (NK_SPINLOCK_IMPL == NK_SPINLOCK_TICKET)
 #endif
 
 /**
  * @brief Enable Beatty lattice fairness for smart locks
  *
  * Uses golden ratio (φ) increment for starvation-free ticket assignment.
- * Adds ~100 bytes flash, 2-4 bytes RAM per lock.
+ * Adds ~100 bytes flash, 4-8 bytes RAM per lock (two ticket counters).
  */
 #ifndef NK_ENABLE_LATTICE
 #  define NK_ENABLE_LATTICE 0
@@ -103,6 +147,22 @@ extern "C" {
 #  define NK_ENABLE_DAG 0
 #endif
 
+/**
+ * @brief One Big Kernel Lock behind every nk_spinlock_lock()
+ *
+ * Follows sync_bkl (default on).  Off, nk_spinlock_lock() serializes
+ * only on the lock of the spinlock's domain (nk_lock_domain_t), so
+ * scheduler, heap, VFS, network and TTY sections stop waiting on each
+ * other.  Single-core parts gain nothing from domains; keep the BKL.
+ */
+#ifndef NK_SPIN_BKL
+#  if defined(CONFIG_SYNC_BKL)
+#    define NK_SPIN_BKL CONFIG_SYNC_BKL
+#  else
+#    define NK_SPIN_BKL 1
+#  endif
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * WORD SIZE DETECTION
  *═══════════════════════════════════════════════════════════════════*/
@@ -164,7 +224,7 @@ static inline bool nk_flock_try(nk_flock_t *f) {
  */
 static inline void nk_flock_lock(nk_flock_t *f) {
     while (!nk_flock_try(f)) {
-        /* Busy-wait - could add hal_cpu_relax() here */
+        NK_SPIN_RELAX();
     }
 }
 
@@ -188,7 +248,7 @@ static inline void nk_flock_unlock(nk_flock_t *f) {
  * @brief Quaternion ticket lock (2 bytes)
  *
  * Provides fair FIFO ordering using ticket numbers.
- * Prevents starvation.
+ * Prevents starvation.  Up to 255 contenders at once.
  */
 typedef struct {
     volatile uint8_t head;  /**< Current serving ticket */
@@ -212,17 +272,33 @@ static inline void nk_qlock_init(nk_qlock_t *q) {
  * @param q Pointer to quaternion lock
  */
 static inline void nk_qlock_lock(nk_qlock_t *q) {
-    /* Atomically fetch and increment tail to get our ticket */
-    uint8_t my_ticket = q->tail;
-    hal_atomic_exchange_u8((volatile uint8_t *)&q->tail, my_ticket + 1);
+    /* Fetch-and-increment tail to draw our ticket */
+    uint8_t my_ticket = hal_atomic_fetch_add_u8(&q->tail, 1);
 
     /* Wait until our ticket is being served */
     while (q->head != my_ticket) {
-        hal_memory_barrier();
+        NK_SPIN_RELAX();
     }
     hal_memory_barrier();
 }
 
+/**
+ * @brief Try to acquire quaternion lock (non-blocking)
+ *
+ * Draws a ticket only if it would be served at once.
+ *
+ * @param q Pointer to quaternion lock
+ * @return true if lock acquired, false if held or contended
+ */
+static inline bool nk_qlock_try(nk_qlock_t *q) {
+    uint8_t t = q->head;
+    if (!hal_atomic_compare_exchange_u8(&q->tail, &t, (uint8_t)(t + 1))) {
+        return false;
+    }
+    hal_memory_barrier();
+    return true;
+}
+
 /**
  * @brief Release quaternion lock
  *
@@ -230,13 +306,143 @@ static inline void nk_qlock_lock(nk_qlock_t *q) {
  */
 static inline void nk_qlock_unlock(nk_qlock_t *q) {
     hal_memory_barrier();
-    /* Increment head to serve next ticket */
-    uint8_t next = q->head + 1;
-    hal_atomic_exchange_u8((volatile uint8_t *)&q->head, next);
+    /* Only the holder writes head: serve the next ticket */
+    uint8_t next = (uint8_t)(q->head + 1);
+    hal_atomic_exchange_u8(&q->head, next);
 }
 
 #endif /* NK_ENABLE_QLOCK */
 
+/*═══════════════════════════════════════════════════════════════════
+ * MCS QUEUE LOCK (MCSLOCK) - Local-Spinning FIFO Lock for SMP
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if NK_SPINLOCK_IMPL == NK_SPINLOCK_MCS
+
+/**
+ * @brief MCS queue node; the lock itself is one too
+ *
+ * This is the variant that needs no node from the caller: a waiter
+ * queues a node on its own stack, spins on that node's @c tail until
+ * its predecessor clears it, then moves its successor link into the
+ * lock and returns.  The holder is represented by the lock node, so
+ * lock/unlock keep the plain one-argument signature.
+ *
+ * In the lock: @c tail is NULL (free), the lock itself (held, no
+ * waiters) or the last waiter; @c next is the first waiter.  In a
+ * waiter: @c tail points at the lock until the lock is handed over.
+ *
+ * The HAL exposes no pointer-wide compare-exchange, so this lock uses
+ * the compiler's __atomic builtins directly (it is never selected on
+ * 8-bit parts).
+ */
+typedef struct nk_mcs_node {
+    struct nk_mcs_node *volatile tail;  /**< Last waiter / "still waiting" */
+    struct nk_mcs_node *volatile next;  /**< First waiter / successor */
+} nk_mcslock_t;
+
+/** Waiter's queue node (stack-allocated inside nk_mcs_lock()). */
+typedef nk_mcslock_t nk_mcs_node_t;
+
+static inline nk_mcs_node_t *nk_mcs_load(nk_mcs_node_t *volatile *p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void nk_mcs_store(nk_mcs_node_t *volatile *p, nk_mcs_node_t *v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline bool nk_mcs_cas(nk_mcs_node_t *volatile *p,
+                              nk_mcs_node_t *expected, nk_mcs_node_t *v) {
+    return __atomic_compare_exchange_n(p, &expected, v, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Initialize an MCS lock
+ *
+ * @param m Pointer to MCS lock
+ */
+static inline void nk_mcs_init(nk_mcslock_t *m) {
+    m->tail = NULL;
+    m->next = NULL;
+    hal_memory_barrier();
+}
+
+/**
+ * @brief Try to acquire MCS lock (non-blocking)
+ *
+ * @param m Pointer to MCS lock
+ * @return true if lock acquired, false if held
+ */
+static inline bool nk_mcs_try(nk_mcslock_t *m) {
+    return nk_mcs_cas(&m->tail, NULL, m);
+}
+
+/**
+ * @brief Acquire MCS lock (blocking, FIFO)
+ *
+ * @param m Pointer to MCS lock
+ */
+static inline void nk_mcs_lock(nk_mcslock_t *m) {
+    for (;;) {
+        nk_mcs_node_t *prev = nk_mcs_load(&m->tail);
+        if (!prev) {
+            if (nk_mcs_cas(&m->tail, NULL, m)) {
+                return;
+            }
+            continue;
+        }
+
+        nk_mcs_node_t n = { m, NULL };
+        if (!nk_mcs_cas(&m->tail, prev, &n)) {
+            continue;
+        }
+        nk_mcs_store(&prev->next, &n);
+
+        /* Spin on our own node until the holder hands over */
+        while (nk_mcs_load(&n.tail) == m) {
+            NK_SPIN_RELAX();
+        }
+
+        /* n is about to go out of scope: move its successor link */
+        nk_mcs_node_t *succ = nk_mcs_load(&n.next);
+        if (!succ) {
+            nk_mcs_store(&m->next, NULL);
+            if (nk_mcs_cas(&m->tail, &n, m)) {
+                return;
+            }
+            /* Someone queued behind n but has not linked in yet */
+            while (!(succ = nk_mcs_load(&n.next))) {
+                NK_SPIN_RELAX();
+            }
+        }
+        nk_mcs_store(&m->next, succ);
+        return;
+    }
+}
+
+/**
+ * @brief Release MCS lock
+ *
+ * @param m Pointer to MCS lock
+ */
+static inline void nk_mcs_unlock(nk_mcslock_t *m) {
+    nk_mcs_node_t *succ = nk_mcs_load(&m->next);
+    if (!succ) {
+        if (nk_mcs_cas(&m->tail, m, NULL)) {
+            return;
+        }
+        /* A waiter swung tail but has not linked in yet */
+        while (!(succ = nk_mcs_load(&m->next))) {
+            NK_SPIN_RELAX();
+        }
+    }
+    nk_mcs_store(&succ->tail, NULL);
+}
+
+#endif /* NK_SPINLOCK_MCS */
+
 /*═══════════════════════════════════════════════════════════════════
  * BEATTY LATTICE (TOURMALINE) - Starvation-Free Fairness
  *═══════════════════════════════════════════════════════════════════*/
@@ -258,23 +464,22 @@ _Static_assert(NK_LATTICE_DELTA <= (nk_ticket_t)-1,
                "NK_LATTICE_DELTA exceeds ticket type range");
 
 /**
- * @brief Global lattice ticket counter
+ * @brief Draw the next ticket from a lock's counter
  *
- * Monotonically increasing ticket using golden ratio increment.
- * Wraparound is harmless due to modular arithmetic.
- */
-static volatile nk_ticket_t nk_lattice_ticket = 0;
-
-/**
- * @brief Get next lattice ticket
+ * Each lock counts its own tickets: with one counter shared by every
+ * lock (and every translation unit including this header) a ticket
+ * drawn for one lock left a hole in another's sequence that no waiter
+ * could ever fill.  Wraparound is harmless due to modular arithmetic.
  *
- * @return Next ticket number
+ * @param next The lock's counter
+ * @return Ticket to wait for; served once the owner field equals it
  */
-static inline nk_ticket_t nk_next_ticket(void) {
-    nk_ticket_t ticket = nk_lattice_ticket + NK_LATTICE_DELTA;
-    nk_lattice_ticket = ticket;
-    hal_memory_barrier();
-    return ticket;
+static inline nk_ticket_t nk_next_ticket(volatile nk_ticket_t *next) {
+#if NK_WORD_BITS == 32
+    return hal_atomic_fetch_add_u32(next, NK_LATTICE_DELTA);
+#else
+    return hal_atomic_fetch_add_u16(next, NK_LATTICE_DELTA);
+#endif
 }
 
 #endif /* NK_ENABLE_LATTICE */
@@ -283,18 +488,29 @@ static inline nk_ticket_t nk_next_ticket(void) {
  * SMART LOCK (SLOCK) - Composable Lock with Optional Features
  *═══════════════════════════════════════════════════════════════════*/
 
+#if NK_ENABLE_LATTICE && NK_SPINLOCK_IMPL != NK_SPINLOCK_TAS
+#  error "NK_ENABLE_LATTICE layers on the TAS lock; ticket and mcs are already FIFO"
+#endif
+
 /**
  * @brief Smart lock structure
  *
  * Composable lock that can include optional features at compile time:
- * - Base: Fast lock (always included)
- * - Optional: Beatty lattice fairness
+ * - Base: TAS, ticket or MCS lock (NK_SPINLOCK_IMPL)
+ * - Optional: Beatty lattice fairness (TAS base only)
  * - Optional: DAG dependency tracking
  */
 typedef struct {
+#if NK_SPINLOCK_IMPL == NK_SPINLOCK_MCS
+    nk_mcslock_t base;            /**< Underlying queue lock */
+#elif NK_SPINLOCK_IMPL == NK_SPINLOCK_TICKET
+    nk_qlock_t base;              /**< Underlying ticket lock */
+#else
     nk_flock_t base;              /**< Underlying fast lock */
+#endif
 #if NK_ENABLE_LATTICE
-    volatile nk_ticket_t owner;   /**< Current ticket owner */
+    volatile nk_ticket_t owner;   /**< Ticket being served */
+    volatile nk_ticket_t next;    /**< Next ticket to draw */
 #endif
 #if NK_ENABLE_DAG
     uint8_t dag_mask;             /**< DAG dependency mask (8 deps max) */
@@ -304,7 +520,11 @@ typedef struct {
 /**
  * @brief Static initializer for smart lock
  */
-#define NK_SLOCK_STATIC_INIT {0}
+#if NK_SPINLOCK_IMPL == NK_SPINLOCK_TAS
+#  define NK_SLOCK_STATIC_INIT {0}
+#else
+#  define NK_SLOCK_STATIC_INIT {{0}}
+#endif
 
 /**
  * @brief Initialize a smart lock
@@ -312,9 +532,16 @@ typedef struct {
  * @param s Pointer to smart lock
  */
 static inline void nk_slock_init(nk_slock_t *s) {
+#if NK_SPINLOCK_IMPL == NK_SPINLOCK_MCS
+    nk_mcs_init(&s->base);
+#elif NK_SPINLOCK_IMPL == NK_SPINLOCK_TICKET
+    nk_qlock_init(&s->base);
+#else
     nk_flock_init(&s->base);
+#endif
 #if NK_ENABLE_LATTICE
-    s->owner = NK_LATTICE_DELTA;  /* First waiter wins immediately */
+    s->owner = 0;                 /* First ticket drawn wins at once */
+    s->next = 0;
 #endif
 #if NK_ENABLE_DAG
     s->dag_mask = 0;
@@ -329,12 +556,16 @@ static inline void nk_slock_init(nk_slock_t *s) {
  */
 static inline void nk_slock_lock(nk_slock_t *s) {
 #if NK_ENABLE_LATTICE
-    nk_ticket_t my = nk_next_ticket();
+    nk_ticket_t my = nk_next_ticket(&s->next);
     for (;;) {
         nk_flock_lock(&s->base);
         if (s->owner == my) break;  /* My turn */
         nk_flock_unlock(&s->base);  /* Busy wait */
     }
+#elif NK_SPINLOCK_IMPL == NK_SPINLOCK_MCS
+    nk_mcs_lock(&s->base);
+#elif NK_SPINLOCK_IMPL == NK_SPINLOCK_TICKET
+    nk_qlock_lock(&s->base);
 #else
     nk_flock_lock(&s->base);
 #endif
@@ -349,12 +580,24 @@ static inline void nk_slock_lock(nk_slock_t *s) {
  */
 static inline bool nk_slock_trylock(nk_slock_t *s) {
 #if NK_ENABLE_LATTICE
-    nk_ticket_t my = nk_next_ticket();
-    if (!nk_flock_try(&s->base)) {
+    /* Draw a ticket only if it is served now: an abandoned one would
+     * stall every later waiter */
+    nk_ticket_t my = s->owner;
+#  if NK_WORD_BITS == 32
+    if (!hal_atomic_compare_exchange_u32(&s->next, &my, my + NK_LATTICE_DELTA)) {
+#  else
+    if (!hal_atomic_compare_exchange_u16(&s->next, &my,
+                                         (nk_ticket_t)(my + NK_LATTICE_DELTA))) {
+#  endif
+        return false;
+    }
+    nk_flock_lock(&s->base);        /* only waiters peeking at owner */
+#elif NK_SPINLOCK_IMPL == NK_SPINLOCK_MCS
+    if (!nk_mcs_try(&s->base)) {
         return false;
     }
-    if (s->owner != my) {
-        nk_flock_unlock(&s->base);
+#elif NK_SPINLOCK_IMPL == NK_SPINLOCK_TICKET
+    if (!nk_qlock_try(&s->base)) {
         return false;
     }
 #else
@@ -376,13 +619,52 @@ static inline void nk_slock_unlock(nk_slock_t *s) {
 #if NK_ENABLE_LATTICE
     s->owner += NK_LATTICE_DELTA;  /* Next ticket wins */
 #endif
+#if NK_SPINLOCK_IMPL == NK_SPINLOCK_MCS
+    nk_mcs_unlock(&s->base);
+#elif NK_SPINLOCK_IMPL == NK_SPINLOCK_TICKET
+    nk_qlock_unlock(&s->base);
+#else
     nk_flock_unlock(&s->base);
+#endif
 }
 
 /*═══════════════════════════════════════════════════════════════════
  * COMPOSITE SPINLOCK - High-Level Spinlock with BKL
  *═══════════════════════════════════════════════════════════════════*/
 
+/**
+ * @brief Subsystem a composite spinlock belongs to
+ *
+ * nk_spinlock_lock() takes the domain's lock before the instance lock:
+ * the BKL for every domain with NK_SPIN_BKL, otherwise one lock per
+ * domain.  NK_LOCK_DOM_GLOBAL is the BKL itself and holds locks that
+ * belong to no subsystem.
+ *
+ * ## Lock Order
+ *
+ * Domains are listed outermost first.  While holding a lock of one
+ * domain, take only locks of domains further down:
+ *
+ *   GLOBAL → VFS → NET → TTY → IPC → MM → SCHED
+ *
+ * (a file write may reach the network, both may feed a TTY, everything
+ * may allocate, and anything may wake a task).  At most one lock per
+ * domain is held through nk_spinlock_lock(), since the domain lock is
+ * not recursive; the inner locks of a nested section use the _rt calls,
+ * which take only the instance lock and so behave the same with and
+ * without the BKL.
+ */
+typedef enum {
+    NK_LOCK_DOM_GLOBAL = 0,
+    NK_LOCK_DOM_VFS,
+    NK_LOCK_DOM_NET,
+    NK_LOCK_DOM_TTY,
+    NK_LOCK_DOM_IPC,
+    NK_LOCK_DOM_MM,
+    NK_LOCK_DOM_SCHED,
+    NK_LOCK_DOMAINS
+} nk_lock_domain_t;
+
 /**
  * @brief Composite spinlock structure
  *
@@ -393,19 +675,41 @@ typedef struct {
     nk_slock_t core;       /**< Per-instance smart lock */
     uint8_t    dag_mask;   /**< Dependency bitmap for speculative ops */
     uint8_t    rt_mode;    /**< Real-time flag: bypass global BKL */
+    uint8_t    domain;     /**< nk_lock_domain_t */
     uint32_t   matrix[4];  /**< Snapshot of speculative COW state */
+#if NK_LOCK_STATS
+    nk_lockstat_t stat;    /**< Contention counters (lockstat.h) */
+#endif
 } nk_spinlock_t;
 
+/**
+ * @brief Static initializer for a spinlock of domain @p d labelled @p n
+ *
+ * The label names the lock in nk_lockstat dumps.
+ */
+#if NK_LOCK_STATS
+#  define NK_SPINLOCK_DOMAIN_INIT(n, d) \
+    { NK_SLOCK_STATIC_INIT, 0u, 0u, (d), {0u, 0u, 0u, 0u}, NK_LOCKSTAT_INIT(n) }
+#else
+#  define NK_SPINLOCK_DOMAIN_INIT(n, d) \
+    { NK_SLOCK_STATIC_INIT, 0u, 0u, (d), {0u, 0u, 0u, 0u} }
+#endif
+
+/**
+ * @brief Static initializer for a composite spinlock labelled @p n
+ */
+#define NK_SPINLOCK_NAMED_INIT(n) NK_SPINLOCK_DOMAIN_INIT(n, NK_LOCK_DOM_GLOBAL)
+
 /**
  * @brief Static initializer for composite spinlock
  */
-#define NK_SPINLOCK_STATIC_INIT \
-    { {0}, 0u, 0u, {0u, 0u, 0u, 0u} }
+#define NK_SPINLOCK_STATIC_INIT NK_SPINLOCK_NAMED_INIT(NULL)
 
 /**
  * @brief Global Big Kernel Lock (BKL)
  *
- * Coarse-grained global lock for serialization across all spinlocks.
+ * Coarse-grained global lock for serialization across all spinlocks
+ * (with NK_SPIN_BKL = 0, only those of NK_LOCK_DOM_GLOBAL).
  * Must be initialized before any spinlock operations.
  */
 extern nk_slock_t nk_bkl;
@@ -414,19 +718,27 @@ extern nk_slock_t nk_bkl;
  * @brief Initialize the global Big Kernel Lock
  *
  * Must be called once during system initialization before any
- * spinlock operations.
+ * spinlock operations.  Also resets the domain locks.
  */
 void nk_spinlock_global_init(void);
 
 /**
- * @brief Initialize a composite spinlock
+ * @brief Initialize a composite spinlock (NK_LOCK_DOM_GLOBAL)
  *
  * @param s Pointer to spinlock
  */
 void nk_spinlock_init(nk_spinlock_t *s);
 
 /**
- * @brief Acquire spinlock (BKL + instance lock)
+ * @brief Initialize a composite spinlock of domain @p d
+ *
+ * @param s Pointer to spinlock
+ * @param d Subsystem; out-of-range values mean NK_LOCK_DOM_GLOBAL
+ */
+void nk_spinlock_init_domain(nk_spinlock_t *s, nk_lock_domain_t d);
+
+/**
+ * @brief Acquire spinlock (BKL or domain lock + instance lock)
  *
  * @param s Pointer to spinlock
  * @param mask Dependency mask to record
@@ -443,7 +755,7 @@ void nk_spinlock_lock(nk_spinlock_t *s, uint8_t mask);
 bool nk_spinlock_trylock(nk_spinlock_t *s, uint8_t mask);
 
 /**
- * @brief Release spinlock (instance lock + BKL)
+ * @brief Release spinlock (instance lock + BKL or domain lock)
  *
  * @param s Pointer to spinlock
  */
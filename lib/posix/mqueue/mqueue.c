@@ -0,0 +1,257 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file mqueue.c
+ * @brief POSIX message queues on kernel message rings
+ *
+ * A small table maps names to kernel queues (nk_mq_t); descriptors are
+ * indices into a second table that records the queue and the per-open
+ * O_NONBLOCK flag.  Data movement is entirely nk_mq_send()/nk_mq_recv(),
+ * so a single sender and receiver never take a lock.
+ */
+
+#include "mqueue.h"
+#include "kernel/ipc/nk_mq.h"
+#include <stdarg.h>
+#include <string.h>
+
+#if NK_MQ_POOL > 0
+
+/* Named queue */
+typedef struct {
+    nk_mq_t q;
+    char    name[MQ_NAME_MAX + 1];
+    uint8_t refs;      /**< Open descriptors */
+    uint8_t linked;    /**< Name still visible (not unlinked) */
+} mq_obj_t;
+
+/* Open descriptor */
+typedef struct {
+    uint8_t  obj;      /**< mq_objs index + 1, 0 = free */
+    uint16_t flags;    /**< O_NONBLOCK, access mode */
+} mq_desc_t;
+
+static mq_obj_t  mq_objs[NK_MQ_POOL];
+static mq_desc_t mq_descs[MQ_OPEN_MAX];
+
+/*═══════════════════════════════════════════════════════════════════
+ * INTERNAL HELPERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+static int8_t find(const char *name) {
+    for (int8_t i = 0; i < NK_MQ_POOL; ++i) {
+        if (mq_objs[i].linked && strcmp(mq_objs[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static mq_desc_t *desc(mqd_t mqdes) {
+    if (mqdes < 0 || mqdes >= MQ_OPEN_MAX || !mq_descs[mqdes].obj) {
+        errno = EBADF;
+        return NULL;
+    }
+    return &mq_descs[mqdes];
+}
+
+static void put_obj(int8_t i) {
+    mq_obj_t *o = &mq_objs[i];
+    if (--o->refs == 0 && !o->linked) {
+        nk_mq_destroy(&o->q);
+    }
+}
+
+/* Smallest power of two >= n (n in 1..NK_MQ_DEPTH_MAX). */
+static uint8_t pow2_up(long n) {
+    uint8_t d = 1;
+    while (d < n) {
+        d = (uint8_t)(d << 1);
+    }
+    return d;
+}
+
+static int8_t create(const char *name, const struct mq_attr *attr) {
+    long maxmsg  = attr ? attr->mq_maxmsg : 4;
+    long msgsize = attr ? attr->mq_msgsize : 16;
+    if (maxmsg <= 0 || maxmsg > NK_MQ_DEPTH_MAX ||
+        msgsize <= 0 || msgsize > 255) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (int8_t i = 0; i < NK_MQ_POOL; ++i) {
+        mq_obj_t *o = &mq_objs[i];
+        if (o->linked || o->refs) {
+            continue;
+        }
+        if (nk_mq_create(&o->q, pow2_up(maxmsg), (uint8_t)msgsize) < 0) {
+            errno = ENOSPC;           /* too big for the pool buffer */
+            return -1;
+        }
+        strcpy(o->name, name);
+        o->linked = 1;
+        return i;
+    }
+    errno = ENFILE;
+    return -1;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * PUBLIC API IMPLEMENTATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+mqd_t mq_open(const char *name, int oflag, ...) {
+    if (!name || name[0] != '/') {
+        errno = EINVAL;
+        return (mqd_t)-1;
+    }
+    if (strlen(name + 1) > MQ_NAME_MAX) {
+        errno = ENAMETOOLONG;
+        return (mqd_t)-1;
+    }
+
+    mqd_t d = 0;
+    while (d < MQ_OPEN_MAX && mq_descs[d].obj) {
+        ++d;
+    }
+    if (d == MQ_OPEN_MAX) {
+        errno = EMFILE;
+        return (mqd_t)-1;
+    }
+
+    int8_t i = find(name + 1);
+    if (i >= 0 && (oflag & O_CREAT) && (oflag & O_EXCL)) {
+        errno = EEXIST;
+        return (mqd_t)-1;
+    }
+    if (i < 0) {
+        if (!(oflag & O_CREAT)) {
+            errno = ENOENT;
+            return (mqd_t)-1;
+        }
+        va_list ap;
+        va_start(ap, oflag);
+        (void)va_arg(ap, int);                        /* mode (promoted) */
+        const struct mq_attr *attr = va_arg(ap, const struct mq_attr *);
+        va_end(ap);
+        if ((i = create(name + 1, attr)) < 0) {
+            return (mqd_t)-1;
+        }
+    }
+
+    mq_objs[i].refs++;
+    mq_descs[d] = (mq_desc_t){ (uint8_t)(i + 1),
+                               (uint16_t)(oflag & (O_NONBLOCK | 0x03)) };
+    return d;
+}
+
+int mq_close(mqd_t mqdes) {
+    mq_desc_t *dp = desc(mqdes);
+    if (!dp) {
+        return -1;
+    }
+    int8_t i = (int8_t)(dp->obj - 1);
+    dp->obj = 0;
+    put_obj(i);
+    return 0;
+}
+
+int mq_unlink(const char *name) {
+    int8_t i = (name && name[0] == '/') ? find(name + 1) : -1;
+    if (i < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    mq_objs[i].linked = 0;
+    if (mq_objs[i].refs == 0) {
+        nk_mq_destroy(&mq_objs[i].q);
+    }
+    return 0;
+}
+
+int mq_send(mqd_t mqdes, const char *msg_ptr, size_t msg_len,
+            unsigned msg_prio) {
+    mq_desc_t *dp = desc(mqdes);
+    if (!dp) {
+        return -1;
+    }
+    if ((dp->flags & 0x03) == O_RDONLY) {
+        errno = EBADF;
+        return -1;
+    }
+    nk_mq_t *q = &mq_objs[dp->obj - 1].q;
+    if (msg_len > q->msgsize) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    if (msg_prio >= MQ_PRIO_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (nk_mq_send(q, msg_ptr, (uint8_t)msg_len, (uint8_t)msg_prio,
+                   !(dp->flags & O_NONBLOCK)) < 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    return 0;
+}
+
+ssize_t mq_receive(mqd_t mqdes, char *msg_ptr, size_t msg_len,
+                   unsigned *msg_prio) {
+    mq_desc_t *dp = desc(mqdes);
+    if (!dp) {
+        return -1;
+    }
+    if ((dp->flags & 0x03) == O_WRONLY) {
+        errno = EBADF;
+        return -1;
+    }
+    nk_mq_t *q = &mq_objs[dp->obj - 1].q;
+    if (msg_len < q->msgsize) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    uint8_t prio;
+    int n = nk_mq_recv(q, msg_ptr, q->msgsize, &prio,
+                       !(dp->flags & O_NONBLOCK));
+    if (n < 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+    if (msg_prio) {
+        *msg_prio = prio;
+    }
+    return (ssize_t)n;
+}
+
+int mq_getattr(mqd_t mqdes, struct mq_attr *attr) {
+    mq_desc_t *dp = desc(mqdes);
+    if (!dp) {
+        return -1;
+    }
+    const nk_mq_t *q = &mq_objs[dp->obj - 1].q;
+    attr->mq_flags   = dp->flags & O_NONBLOCK;
+    attr->mq_maxmsg  = nk_mq_depth(q);
+    attr->mq_msgsize = q->msgsize;
+    attr->mq_curmsgs = nk_mq_count(q);
+    return 0;
+}
+
+int mq_setattr(mqd_t mqdes, const struct mq_attr *attr,
+               struct mq_attr *oattr) {
+    if (oattr && mq_getattr(mqdes, oattr) < 0) {
+        return -1;
+    }
+    mq_desc_t *dp = desc(mqdes);
+    if (!dp) {
+        return -1;
+    }
+    dp->flags = (uint16_t)((dp->flags & ~O_NONBLOCK) |
+                           (attr->mq_flags & O_NONBLOCK));
+    return 0;
+}
+
+#endif /* NK_MQ_POOL > 0 */
@@ -0,0 +1,148 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file mqueue.h
+ * @brief POSIX Message Queues for Embedded Systems
+ *
+ * mq_open()/mq_send()/mq_receive() on top of the kernel's lock-free
+ * message rings (kernel/ipc/nk_mq.h).  Queues are named, live until
+ * mq_unlink() and the last mq_close(), and take their storage from the
+ * kernel's fixed queue pool.
+ *
+ * Profile Support:
+ * - Low-end (PSE51): Not available (ipc_mq_max = 0)
+ * - Mid-range (PSE52): Optional
+ * - High-end (PSE54): Enabled
+ *
+ * Deviations from POSIX.1-2008:
+ * - Delivery is FIFO.  msg_prio is carried with each message and
+ *   returned by mq_receive(), but does not reorder the queue.
+ * - mq_maxmsg is rounded up to a power of two; mq_getattr() reports the
+ *   rounded value.
+ * - Names are flat ("/name"), at most MQ_NAME_MAX characters.
+ */
+
+#ifndef POSIX_MQUEUE_H
+#define POSIX_MQUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../posix_types.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONSTANTS
+ *═══════════════════════════════════════════════════════════════════*/
+
+#ifndef O_RDONLY
+#define O_RDONLY    0x00
+#define O_WRONLY    0x01
+#define O_RDWR      0x02
+#endif
+#ifndef O_CREAT
+#define O_CREAT     0x40
+#endif
+#ifndef O_EXCL
+#define O_EXCL      0x100
+#endif
+#ifndef O_NONBLOCK
+#define O_NONBLOCK  0x800
+#endif
+
+/** Longest queue name, excluding the leading '/' */
+#ifndef MQ_NAME_MAX
+#define MQ_NAME_MAX 8
+#endif
+
+/** Open queue descriptors system-wide */
+#ifndef MQ_OPEN_MAX
+#define MQ_OPEN_MAX 8
+#endif
+
+/** Highest msg_prio accepted (exclusive) */
+#define MQ_PRIO_MAX 32
+
+/*═══════════════════════════════════════════════════════════════════
+ * TYPES
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Message queue descriptor */
+typedef int8_t mqd_t;
+
+/** Queue attributes */
+struct mq_attr {
+    long mq_flags;    /**< O_NONBLOCK or 0 */
+    long mq_maxmsg;   /**< Messages the queue holds */
+    long mq_msgsize;  /**< Largest message in bytes */
+    long mq_curmsgs;  /**< Messages currently queued */
+};
+
+/*═══════════════════════════════════════════════════════════════════
+ * MESSAGE QUEUE API
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Open (and optionally create) a named queue
+ *
+ * With O_CREAT, a `mode_t` and a `struct mq_attr *` follow; a NULL attr
+ * gives 4 messages of 16 bytes.
+ *
+ * @return Descriptor, or (mqd_t)-1 with errno set (ENOENT, EEXIST,
+ *         EINVAL, ENAMETOOLONG, EMFILE, ENFILE, ENOSPC)
+ */
+mqd_t mq_open(const char *name, int oflag, ...);
+
+/**
+ * @brief Close a descriptor
+ * @return 0, or -1 with errno = EBADF
+ */
+int mq_close(mqd_t mqdes);
+
+/**
+ * @brief Remove a queue name; storage goes once the last descriptor closes
+ * @return 0, or -1 with errno = ENOENT
+ */
+int mq_unlink(const char *name);
+
+/**
+ * @brief Send a message
+ *
+ * Blocks while the queue is full unless the descriptor is O_NONBLOCK.
+ *
+ * @return 0, or -1 with errno set (EBADF, EMSGSIZE, EINVAL, EAGAIN)
+ */
+int mq_send(mqd_t mqdes, const char *msg_ptr, size_t msg_len,
+            unsigned msg_prio);
+
+/**
+ * @brief Receive the oldest message
+ *
+ * Blocks while the queue is empty unless the descriptor is O_NONBLOCK.
+ *
+ * @return Message length, or -1 with errno set (EBADF, EMSGSIZE,
+ *         EAGAIN)
+ */
+ssize_t mq_receive(mqd_t mqdes, char *msg_ptr, size_t msg_len,
+                   unsigned *msg_prio);
+
+/**
+ * @brief Get queue attributes
+ * @return 0, or -1 with errno = EBADF
+ */
+int mq_getattr(mqd_t mqdes, struct mq_attr *attr);
+
+/**
+ * @brief Change O_NONBLOCK on a descriptor
+ * @return 0, or -1 with errno = EBADF
+ */
+int mq_setattr(mqd_t mqdes, const struct mq_attr *attr,
+               struct mq_attr *oattr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POSIX_MQUEUE_H */
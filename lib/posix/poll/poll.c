@@ -0,0 +1,146 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file poll.c
+ * @brief poll() and select() on vfs_poll()
+ *
+ * POLLIN, POLLOUT, POLLERR, POLLHUP and POLLNVAL have the values of
+ * their VFS_POLL* counterparts, so events pass straight through.  The
+ * kernel tick is one millisecond; timeouts longer than one vfs_poll()
+ * wait are served in several.
+ */
+
+#include "poll.h"
+#include "../posix_timeout.h"
+#include "avrix-config.h"
+#include "drivers/fs/vfs.h"
+#include <limits.h>
+
+#if CONFIG_FS_ENABLED && VFS_POLL
+
+_Static_assert(POLLIN == VFS_POLLIN && POLLOUT == VFS_POLLOUT &&
+               POLLERR == VFS_POLLERR && POLLHUP == VFS_POLLHUP &&
+               POLLNVAL == VFS_POLLNVAL, "poll bits match vfs_poll()");
+
+/* Longest vfs_poll() wait that still has a limit */
+#define POLL_CHUNK (VFS_POLL_FOREVER - 1u)
+
+static int poll_ticks(vfs_pollfd_t *v, uint8_t n, int timeout) {
+    if (timeout < 0) {
+        return vfs_poll(v, n, VFS_POLL_FOREVER);
+    }
+    uint32_t left = (uint32_t)timeout * (POSIX_TICK_HZ / 1000u);
+    for (;;) {
+        uint16_t t = left > POLL_CHUNK ? (uint16_t)POLL_CHUNK : (uint16_t)left;
+        int r = vfs_poll(v, n, t);
+        left -= t;
+        if (r != 0 || left == 0) {
+            return r;
+        }
+    }
+}
+
+#endif
+
+/**
+ * @brief Wait for events on a set of descriptors
+ */
+int poll(struct pollfd *fds, nfds_t nfds, int timeout) {
+#if CONFIG_FS_ENABLED && VFS_POLL
+    vfs_pollfd_t v[VFS_MAX_FDS];
+
+    if (nfds > VFS_MAX_FDS) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!fds && nfds) {
+        errno = EFAULT;
+        return -1;
+    }
+    for (nfds_t i = 0; i < nfds; i++) {
+        v[i].fd = fds[i].fd;
+        v[i].events = (uint8_t)(fds[i].events & (POLLIN | POLLOUT));
+    }
+    int r = poll_ticks(v, (uint8_t)nfds, timeout);
+    for (nfds_t i = 0; i < nfds; i++) {
+        fds[i].revents = v[i].revents;
+    }
+    return r;
+#else
+    (void)fds; (void)nfds; (void)timeout;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/**
+ * @brief Wait until descriptors are ready to read or write
+ */
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+           struct timeval *timeout) {
+#if CONFIG_FS_ENABLED && VFS_POLL
+    struct pollfd p[VFS_MAX_FDS];
+    nfds_t n = 0;
+
+    if (nfds < 0 || nfds > FD_SETSIZE ||
+        (timeout && (timeout->tv_usec < 0 || timeout->tv_usec >= 1000000L))) {
+        errno = EINVAL;
+        return -1;
+    }
+    for (int fd = 0; fd < nfds; fd++) {
+        short ev = (short)((readfds && FD_ISSET(fd, readfds) ? POLLIN : 0) |
+                           (writefds && FD_ISSET(fd, writefds) ? POLLOUT : 0));
+        if (!ev) {
+            continue;
+        }
+        if (n == VFS_MAX_FDS) {
+            errno = EBADF;              /* more than can be open at once */
+            return -1;
+        }
+        p[n++] = (struct pollfd){ fd, ev, 0 };
+    }
+
+    int ms = -1;
+    if (timeout) {
+        if (timeout->tv_sec >= INT_MAX / 1000) {
+            ms = INT_MAX;
+        } else {
+            ms = (int)(timeout->tv_sec * 1000 + (timeout->tv_usec + 999) / 1000);
+            if (ms < 0) {
+                ms = 0;                 /* a negative tv_sec: just test */
+            }
+        }
+    }
+    if (poll(p, n, ms) < 0) {
+        return -1;
+    }
+    for (nfds_t i = 0; i < n; i++) {
+        if (p[i].revents & POLLNVAL) {
+            errno = EBADF;
+            return -1;
+        }
+    }
+
+    if (readfds) FD_ZERO(readfds);
+    if (writefds) FD_ZERO(writefds);
+    if (exceptfds) FD_ZERO(exceptfds);
+    int ready = 0;
+    for (nfds_t i = 0; i < n; i++) {
+        if ((p[i].events & POLLIN) && (p[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+            FD_SET(p[i].fd, readfds);
+            ready++;
+        }
+        if ((p[i].events & POLLOUT) && (p[i].revents & (POLLOUT | POLLHUP | POLLERR))) {
+            FD_SET(p[i].fd, writefds);
+            ready++;
+        }
+    }
+    return ready;
+#else
+    (void)nfds; (void)readfds; (void)writefds; (void)exceptfds; (void)timeout;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
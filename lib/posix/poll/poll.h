@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file poll.h
+ * @brief POSIX poll() and select() over VFS descriptors
+ *
+ * Every descriptor vfs_poll() knows can be waited on: files, pipes,
+ * TTYs (vfs_open_tty()) and UDP/TCP sockets (vfs_open_udp(),
+ * vfs_open_tcp()).  The caller sleeps until a driver reports progress
+ * through nk_io_event and then checks its descriptors once, so a
+ * main loop no longer spins over tty_rx_available() and friends.
+ *
+ * Profile Support:
+ * - Low-end (PSE51): Not available (no kernel_poll)
+ * - Mid-range (PSE52): Enabled with kernel_poll
+ * - High-end (PSE54): Enabled with kernel_poll
+ *
+ * Deviations from POSIX.1-2008:
+ * - At most VFS_MAX_FDS entries per poll(); select() takes descriptors
+ *   below FD_SETSIZE.
+ * - No out-of-band data: POLLPRI never fires and select()'s exceptfds
+ *   come back empty.
+ * - Signals do not interrupt the wait (no EINTR).
+ */
+
+#ifndef POSIX_POLL_H
+#define POSIX_POLL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../posix_types.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * poll()
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define POLLIN   0x001  /**< Data to read (or end of file) */
+#define POLLPRI  0x002  /**< Urgent data (never reported) */
+#define POLLOUT  0x004  /**< Writing will not block */
+#define POLLERR  0x008  /**< Error: pipe without readers (revents only) */
+#define POLLHUP  0x010  /**< Hang-up (revents only) */
+#define POLLNVAL 0x020  /**< fd is not open (revents only) */
+
+#define POLLRDNORM POLLIN
+#define POLLWRNORM POLLOUT
+
+/** Number of poll() entries. */
+typedef unsigned int nfds_t;
+
+/**
+ * @brief One descriptor for poll()
+ */
+struct pollfd {
+    int   fd;          /**< Descriptor; negative entries are ignored */
+    short events;      /**< POLLIN / POLLOUT wanted */
+    short revents;     /**< Returned events */
+};
+
+/**
+ * @brief Wait for events on a set of descriptors
+ *
+ * @param fds     Descriptors and the events wanted
+ * @param nfds    Entries in @p fds (at most VFS_MAX_FDS)
+ * @param timeout Milliseconds to wait; 0 returns at once, negative
+ *                waits without limit
+ * @return Entries with non-zero revents, 0 on timeout, -1 with errno
+ *         EINVAL (too many entries), EFAULT or ENOSYS (no kernel_poll)
+ */
+int poll(struct pollfd *fds, nfds_t nfds, int timeout);
+
+/*═══════════════════════════════════════════════════════════════════
+ * select()
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Descriptors an fd_set can hold. */
+#define FD_SETSIZE 32
+
+/**
+ * @brief Descriptor set (one bit per fd)
+ */
+typedef struct {
+    uint32_t bits;
+} fd_set;
+
+#define FD_ZERO(s)     ((s)->bits = 0)
+#define FD_SET(fd, s)  ((s)->bits |= (uint32_t)1 << (fd))
+#define FD_CLR(fd, s)  ((s)->bits &= ~((uint32_t)1 << (fd)))
+#define FD_ISSET(fd, s) (((s)->bits >> (fd)) & 1u)
+
+/**
+ * @brief Time interval for select()
+ */
+struct timeval {
+    time_t tv_sec;     /**< Seconds */
+    long   tv_usec;    /**< Microseconds (0..999999) */
+};
+
+/**
+ * @brief Wait until descriptors are ready to read or write
+ *
+ * Built on poll(): on return each set holds only the descriptors that
+ * are ready.  A descriptor at end of file or with a hung-up peer counts
+ * as readable.
+ *
+ * @param nfds      One more than the highest descriptor in the sets
+ *                  (at most FD_SETSIZE)
+ * @param readfds   Descriptors to test for reading, or NULL
+ * @param writefds  Descriptors to test for writing, or NULL
+ * @param exceptfds Cleared (no exceptional conditions), or NULL
+ * @param timeout   Longest wait, or NULL for no limit
+ * @return Ready descriptors counted once per set, 0 on timeout, -1
+ *         with errno EBADF (a descriptor is not open), EINVAL or ENOSYS
+ */
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+           struct timeval *timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POSIX_POLL_H */
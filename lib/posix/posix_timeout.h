@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file posix_timeout.h
+ * @brief Absolute-deadline helpers shared by the timed POSIX waits
+ *
+ * The kernel tick is 1 ms (hal_timer_init(1000)), and CLOCK_MONOTONIC
+ * counts those ticks from boot, so a struct timespec deadline becomes a
+ * tick count directly.
+ */
+
+#ifndef POSIX_TIMEOUT_H
+#define POSIX_TIMEOUT_H
+
+#include "posix_types.h"
+
+extern uint32_t nk_ticks(void);
+
+/** Ticks per second of the kernel clock. */
+#define POSIX_TICK_HZ 1000u
+
+/**
+ * @brief Ticks left until @p abstime
+ *
+ * @param abstime Absolute CLOCK_MONOTONIC deadline
+ * @param err     Set to EINVAL if @p abstime is malformed, else 0
+ * @return Remaining ticks clamped to UINT16_MAX, or 0 once the
+ *         deadline has passed (or on error)
+ */
+static inline uint16_t posix_ticks_until(const struct timespec *abstime, int *err) {
+    *err = 0;
+    if (abstime->tv_nsec < 0 || abstime->tv_nsec >= 1000000000L) {
+        *err = EINVAL;
+        return 0;
+    }
+    uint32_t due = (uint32_t)abstime->tv_sec * POSIX_TICK_HZ +
+                   (uint32_t)(abstime->tv_nsec / (1000000000L / POSIX_TICK_HZ));
+    int32_t left = (int32_t)(due - nk_ticks());
+    if (left <= 0) {
+        return 0;
+    }
+    return left > UINT16_MAX ? UINT16_MAX : (uint16_t)left;
+}
+
+#endif /* POSIX_TIMEOUT_H */
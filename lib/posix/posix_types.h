@@ -33,6 +33,8 @@ extern "C" {
 
 /* Detect word size from HAL */
 #include "arch/common/hal.h"
+#include "avrix-config.h"
+#include "kernel/sync/lockstat.h"
 
 #if HAL_WORD_SIZE == 8
     /* 8-bit architecture (AVR) */
@@ -117,6 +119,17 @@ typedef POSIX_TIME_T time_t;
  */
 typedef POSIX_CLOCK_T clock_t;
 
+/**
+ * @brief Time with nanosecond resolution
+ *
+ * Absolute timeouts (sem_timedwait(), pthread_cond_timedwait()) are
+ * measured on the kernel tick clock from boot (CLOCK_MONOTONIC).
+ */
+struct timespec {
+    time_t tv_sec;           /**< Seconds */
+    long   tv_nsec;          /**< Nanoseconds (0..999999999) */
+};
+
 /**
  * @brief Mode type (file permissions)
  */
@@ -163,11 +176,20 @@ typedef pid_t pthread_t;
  */
 typedef struct {
     uint8_t  detachstate;    /**< Detached or joinable */
-    uint8_t  priority;       /**< Thread priority */
+    uint8_t  priority;       /**< 0 ... SCHED_PRIO_MAX, higher runs first */
+    uint8_t  policy;         /**< SCHED_OTHER, SCHED_FIFO or SCHED_RR */
+    uint8_t  quantum;        /**< Time slice in ticks (0 = default) */
     size_t   stacksize;      /**< Stack size in bytes */
     void    *stackaddr;      /**< Stack address (if pre-allocated) */
 } pthread_attr_t;
 
+/**
+ * @brief Scheduling parameters
+ */
+struct sched_param {
+    int sched_priority;      /**< 0 ... SCHED_PRIO_MAX, higher runs first */
+};
+
 /**
  * @brief Mutex type (opaque)
  */
@@ -175,6 +197,11 @@ typedef struct {
     volatile uint8_t lock;   /**< Lock state (0=unlocked, 1=locked) */
     pid_t            owner;  /**< Owning thread ID */
     uint8_t          type;   /**< Mutex type (normal, recursive, etc.) */
+    uint8_t          waiters;/**< Kernel wait queue (nk_waitq_t) */
+    uint8_t          protocol;/**< PTHREAD_PRIO_NONE or _INHERIT */
+#if NK_LOCK_STATS
+    nk_lockstat_t    stat;   /**< Contention counters (sync_lock_stats) */
+#endif
 } pthread_mutex_t;
 
 /**
@@ -189,7 +216,8 @@ typedef struct {
  * @brief Condition variable (opaque)
  */
 typedef struct {
-    volatile uint8_t waiters; /**< Number of waiting threads */
+    uint8_t          waiters; /**< Kernel wait queue (nk_waitq_t) */
+    volatile uint8_t seq;     /**< Bumped by every signal/broadcast */
 } pthread_cond_t;
 
 /**
@@ -216,6 +244,27 @@ typedef struct {
  */
 typedef uint8_t pthread_key_t;
 
+/* Keys per process */
+#ifndef PTHREAD_KEYS_MAX
+#define PTHREAD_KEYS_MAX 4
+#endif
+
+/* Destructor passes at thread exit */
+#ifndef PTHREAD_DESTRUCTOR_ITERATIONS
+#define PTHREAD_DESTRUCTOR_ITERATIONS 4
+#endif
+
+/**
+ * @brief Per-thread state (the kernel TLS block of a pthread)
+ */
+typedef struct {
+#if defined(__arm__)
+    uint8_t    *tp;                      /**< __thread pointer (first: read_tp) */
+#endif
+    int         err;                     /**< errno */
+    const void *key[PTHREAD_KEYS_MAX];   /**< pthread_setspecific() values */
+} posix_tls_t;
+
 /*═══════════════════════════════════════════════════════════════════
  * FILE DESCRIPTOR TYPES
  *═══════════════════════════════════════════════════════════════════*/
@@ -227,6 +276,36 @@ typedef uint8_t pthread_key_t;
  */
 typedef int8_t fd_t;
 
+/*═══════════════════════════════════════════════════════════════════
+ * ERRNO
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Per-thread errno and keys through the kernel TLS pointer */
+#ifndef POSIX_TLS
+#  if defined(CONFIG_KERNEL_TLS)
+#    define POSIX_TLS CONFIG_KERNEL_TLS
+#  else
+#    define POSIX_TLS 0
+#  endif
+#endif
+
+#if POSIX_TLS
+#include "kernel/sched/scheduler.h"
+
+/** State of tasks that are not pthreads (and of ISRs) */
+extern posix_tls_t posix_tls_shared;
+
+/** Calling thread's state: one load, no call into the scheduler */
+static inline posix_tls_t *posix_tls(void) {
+    posix_tls_t *t = (posix_tls_t *)nk_tls_self;
+    return t ? t : &posix_tls_shared;
+}
+
+#define errno (posix_tls()->err)
+#else
+extern int errno;
+#endif
+
 /*═══════════════════════════════════════════════════════════════════
  * ERROR CODES (errno values)
  *═══════════════════════════════════════════════════════════════════*/
@@ -274,6 +353,8 @@ typedef int8_t fd_t;
 #define EWOULDBLOCK     EAGAIN  /**< Operation would block */
 #define ENOMSG          42  /**< No message of desired type */
 #define EIDRM           43  /**< Identifier removed */
+#define EOVERFLOW       75  /**< Value too large for defined data type */
+#define EMSGSIZE        90  /**< Message too long */
 #define ENOTSUP         95  /**< Not supported */
 #define ETIMEDOUT       110 /**< Connection timed out */
 
@@ -51,12 +51,25 @@ extern "C" {
 /* Return values */
 #define PTHREAD_CANCELED ((void *)-1)
 
+/* Scheduling policy */
+#define SCHED_OTHER                 0   /**< Same as SCHED_RR */
+#define SCHED_FIFO                  1   /**< No time slice among equals */
+#define SCHED_RR                    2   /**< Time-sliced among equals */
+
+/** Highest priority in every policy (the kernel's level 0); lowest is 0 */
+#define SCHED_PRIO_MAX              63
+
 /*═══════════════════════════════════════════════════════════════════
  * STATIC INITIALIZERS
  *═══════════════════════════════════════════════════════════════════*/
 
-#define PTHREAD_MUTEX_INITIALIZER { 0, 0, PTHREAD_MUTEX_NORMAL }
-#define PTHREAD_COND_INITIALIZER  { 0 }
+#if NK_LOCK_STATS
+#define PTHREAD_MUTEX_INITIALIZER \
+    { 0, 0, PTHREAD_MUTEX_NORMAL, 0, PTHREAD_PRIO_NONE, NK_LOCKSTAT_INIT(NULL) }
+#else
+#define PTHREAD_MUTEX_INITIALIZER { 0, 0, PTHREAD_MUTEX_NORMAL, 0, PTHREAD_PRIO_NONE }
+#endif
+#define PTHREAD_COND_INITIALIZER  { 0, 0 }
 
 /*═══════════════════════════════════════════════════════════════════
  * THREAD MANAGEMENT
@@ -148,6 +161,33 @@ int pthread_attr_getstacksize(const pthread_attr_t *attr, size_t *stacksize);
 int pthread_attr_setstackaddr(pthread_attr_t *attr, void *stackaddr);
 int pthread_attr_getstackaddr(const pthread_attr_t *attr, void **stackaddr);
 
+/**
+ * @brief Set the time slice for threads created with @p attr (non-portable)
+ *
+ * @param attr    Thread attributes
+ * @param quantum Slice in scheduler ticks (0 = kernel default)
+ * @return 0 on success
+ */
+int pthread_attr_setquantum_np(pthread_attr_t *attr, uint8_t quantum);
+int pthread_attr_getquantum_np(const pthread_attr_t *attr, uint8_t *quantum);
+
+/**
+ * @brief Set the policy for threads created with @p attr
+ *
+ * @param policy SCHED_OTHER (default), SCHED_FIFO or SCHED_RR
+ * @return 0, or EINVAL
+ */
+int pthread_attr_setschedpolicy(pthread_attr_t *attr, int policy);
+int pthread_attr_getschedpolicy(const pthread_attr_t *attr, int *policy);
+
+/**
+ * @brief Set the priority for threads created with @p attr
+ *
+ * @return 0, or EINVAL if sched_priority is outside 0 ... SCHED_PRIO_MAX
+ */
+int pthread_attr_setschedparam(pthread_attr_t *attr, const struct sched_param *param);
+int pthread_attr_getschedparam(const pthread_attr_t *attr, struct sched_param *param);
+
 /*═══════════════════════════════════════════════════════════════════
  * MUTEX (Mutual Exclusion)
  *═══════════════════════════════════════════════════════════════════*/
@@ -217,11 +257,48 @@ int pthread_mutexattr_getprotocol(const pthread_mutexattr_t *attr, int *protocol
  * CONDITION VARIABLES (high-end only)
  *═══════════════════════════════════════════════════════════════════*/
 
+/**
+ * @brief Initialize a condition variable
+ *
+ * @param cond Pointer to condition variable
+ * @param attr Attributes (ignored, may be NULL)
+ * @return 0 on success, EINVAL if cond is NULL
+ */
 int pthread_cond_init(pthread_cond_t *cond, const pthread_condattr_t *attr);
+
+/**
+ * @brief Destroy a condition variable
+ *
+ * @return 0 on success, EBUSY if threads are still waiting
+ */
 int pthread_cond_destroy(pthread_cond_t *cond);
+
+/**
+ * @brief Release @p mutex, block until signalled, then re-lock @p mutex
+ *
+ * The caller sleeps on a kernel wait queue (no polling).  A signal
+ * issued after the caller released the mutex is never lost.
+ *
+ * @return 0 on success, EINVAL on bad arguments
+ */
 int pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex);
+
+/**
+ * @brief pthread_cond_wait() with an absolute CLOCK_MONOTONIC deadline
+ *
+ * @return 0 if signalled (or a spurious wake-up), ETIMEDOUT once
+ *         @p abstime has passed; @p mutex is re-locked either way
+ */
 int pthread_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex, const struct timespec *abstime);
+
+/**
+ * @brief Wake the highest-priority waiter
+ */
 int pthread_cond_signal(pthread_cond_t *cond);
+
+/**
+ * @brief Wake every waiter
+ */
 int pthread_cond_broadcast(pthread_cond_t *cond);
 
 /*═══════════════════════════════════════════════════════════════════
@@ -241,12 +318,26 @@ int pthread_cond_broadcast(pthread_cond_t *cond);
 int pthread_once(pthread_once_t *once_control, void (*init_routine)(void));
 
 /*═══════════════════════════════════════════════════════════════════
- * THREAD-SPECIFIC DATA (limited support)
+ * THREAD-SPECIFIC DATA
  *═══════════════════════════════════════════════════════════════════*/
 
+/**
+ * @brief Allocate one of PTHREAD_KEYS_MAX keys
+ *
+ * The value starts as NULL in every thread.  At pthread_exit() each
+ * non-NULL value is reset to NULL and passed to @p destructor, for up
+ * to PTHREAD_DESTRUCTOR_ITERATIONS passes.  Tasks that are not
+ * pthreads share one set of values.
+ *
+ * @return 0, EINVAL or EAGAIN (all keys in use)
+ */
 int pthread_key_create(pthread_key_t *key, void (*destructor)(void *));
 int pthread_key_delete(pthread_key_t key);
+
+/** @return 0, or EINVAL for a key that is not allocated */
 int pthread_setspecific(pthread_key_t key, const void *value);
+
+/** @brief Calling thread's value for @p key (no scheduler call with kernel_tls) */
 void *pthread_getspecific(pthread_key_t key);
 
 /*═══════════════════════════════════════════════════════════════════
@@ -264,6 +355,48 @@ void *pthread_getspecific(pthread_key_t key);
 int pthread_yield(void);
 int sched_yield(void);  /* Alias */
 
+/**
+ * @brief Change a thread's policy and priority
+ *
+ * A SCHED_FIFO thread keeps the CPU until it blocks or yields, or a
+ * higher-priority thread becomes ready; the tick never hands it to a
+ * thread of the same priority.  Attributes are always explicit: a new
+ * thread does not inherit its creator's policy.
+ *
+ * @return 0, EINVAL (bad policy or priority) or ESRCH (no such thread)
+ */
+int pthread_setschedparam(pthread_t thread, int policy,
+                          const struct sched_param *param);
+
+/**
+ * @brief A thread's policy and priority
+ *
+ * SCHED_OTHER threads report SCHED_RR, and the priority includes any
+ * inherited from a PTHREAD_PRIO_INHERIT mutex.
+ *
+ * @return 0 or ESRCH
+ */
+int pthread_getschedparam(pthread_t thread, int *policy,
+                          struct sched_param *param);
+
+/**
+ * @brief pthread_setschedparam() for task @p pid (0 = the caller)
+ *
+ * @return Previous policy, or -1 with errno EINVAL or ESRCH
+ */
+int sched_setscheduler(pid_t pid, int policy, const struct sched_param *param);
+
+/** @return Policy of task @p pid (0 = the caller), or -1 with errno ESRCH */
+int sched_getscheduler(pid_t pid);
+
+/** @brief Change only the priority of task @p pid (0 = the caller) */
+int sched_setparam(pid_t pid, const struct sched_param *param);
+int sched_getparam(pid_t pid, struct sched_param *param);
+
+/** @return SCHED_PRIO_MAX / 0 for any valid policy, or -1 with errno EINVAL */
+int sched_get_priority_max(int policy);
+int sched_get_priority_min(int policy);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file pthread_cond.c
+ * @brief Condition variables on kernel wait queues
+ *
+ * A waiter samples the signal sequence while it still holds the mutex,
+ * releases the mutex, and blocks only if no signal has been issued
+ * since; the check and the enqueue happen under the scheduler lock, so
+ * a signal can never fall into the gap between unlock and sleep.
+ * Signals wake the highest-priority waiter first.
+ */
+
+#include "pthread.h"
+#include "../posix_timeout.h"
+
+extern uint32_t nk_sched_lock(void);
+extern void nk_sched_unlock(uint32_t s);
+extern void nk_waitq_block(uint8_t *q);
+extern int  nk_waitq_block_timeout(uint8_t *q, uint16_t ticks);
+extern int  nk_waitq_wake_one(uint8_t *q);
+extern uint8_t nk_waitq_wake_all(uint8_t *q);
+
+int pthread_cond_init(pthread_cond_t *cond, const pthread_condattr_t *attr) {
+    (void)attr;
+    if (!cond) {
+        return EINVAL;
+    }
+    cond->waiters = 0;
+    cond->seq = 0;
+    return 0;
+}
+
+int pthread_cond_destroy(pthread_cond_t *cond) {
+    if (!cond) {
+        return EINVAL;
+    }
+    return cond->waiters ? EBUSY : 0;
+}
+
+static int cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                     const struct timespec *abstime) {
+    if (!cond || !mutex) {
+        return EINVAL;
+    }
+
+    uint16_t ticks = 0;
+    if (abstime) {
+        int err;
+        ticks = posix_ticks_until(abstime, &err);
+        if (err) {
+            return err;
+        }
+        if (!ticks) {
+            return ETIMEDOUT;
+        }
+    }
+
+    uint8_t seq = cond->seq;
+    pthread_mutex_unlock(mutex);
+
+    int rc = 0;
+    uint32_t s = nk_sched_lock();
+    if (cond->seq != seq) {
+        nk_sched_unlock(s);            /* signalled while we let go */
+    } else if (!abstime) {
+        nk_waitq_block(&cond->waiters);
+    } else if (nk_waitq_block_timeout(&cond->waiters, ticks) < 0) {
+        /* A clamped (>65 s) timeout that ran out early is a spurious wake */
+        int err;
+        if (!posix_ticks_until(abstime, &err)) {
+            rc = ETIMEDOUT;
+        }
+    }
+
+    pthread_mutex_lock(mutex);
+    return rc;
+}
+
+int pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex) {
+    return cond_wait(cond, mutex, NULL);
+}
+
+int pthread_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                           const struct timespec *abstime) {
+    if (!abstime) {
+        return EINVAL;
+    }
+    return cond_wait(cond, mutex, abstime);
+}
+
+int pthread_cond_signal(pthread_cond_t *cond) {
+    if (!cond) {
+        return EINVAL;
+    }
+    uint32_t s = nk_sched_lock();
+    cond->seq++;
+    nk_waitq_wake_one(&cond->waiters);
+    nk_sched_unlock(s);
+    return 0;
+}
+
+int pthread_cond_broadcast(pthread_cond_t *cond) {
+    if (!cond) {
+        return EINVAL;
+    }
+    uint32_t s = nk_sched_lock();
+    cond->seq++;
+    nk_waitq_wake_all(&cond->waiters);
+    nk_sched_unlock(s);
+    return 0;
+}
@@ -12,36 +12,87 @@
 
 #include "pthread.h"
 #include "arch/common/hal.h"
+#include "kernel/sched/scheduler.h"
 
-extern int errno;
+/* pthread_tls.c */
+void pthread_tls_start(uint8_t tid);
+void pthread_tls_exit(void);
 
-/* Forward declarations of kernel functions (will be implemented in Phase 4) */
-extern bool nk_task_create(hal_context_t *ctx, void (*entry)(void), uint8_t prio, void *stack, size_t stack_len);
-extern void nk_task_exit(int status) __attribute__((noreturn));
-extern uint8_t nk_current_tid(void);
-extern void nk_yield(void);
+/** Stack of a thread created without stackaddr (bigger ones use the kernel pool) */
+#ifndef PTHREAD_STACK_DEFAULT
+#define PTHREAD_STACK_DEFAULT 256
+#endif
 
-/* Thread wrapper structure */
+#if defined(CONFIG_KERNEL_TASK_MAX) && CONFIG_KERNEL_TASK_MAX > PTHREAD_THREADS_MAX
+#error "thread_info[] is indexed by task ID: raise PTHREAD_THREADS_MAX"
+#endif
+
+/* Thread wrapper structure (indexed by task ID = pthread_t) */
 typedef struct {
     void *(*start_routine)(void *);
     void *arg;
     void *retval;
     uint8_t joinable;
+    uint8_t exited;
+    uint8_t slot;           /**< TCB/stack slot + 1, 0 when none held */
 } pthread_info_t;
 
-/* Thread info table (one per task) */
 static pthread_info_t thread_info[PTHREAD_THREADS_MAX];
 
+/** Priority of threads created without attributes (kernel level 31) */
+#define PRIO_DEFAULT ((SCHED_PRIO_MAX + 1) / 2)
+
+/* POSIX priorities count up, kernel levels down from 0 = most urgent */
+static inline uint8_t prio_to_nk(uint8_t prio) {
+    return (uint8_t)(SCHED_PRIO_MAX - (prio > SCHED_PRIO_MAX ? SCHED_PRIO_MAX : prio));
+}
+
+static inline bool policy_valid(int policy) {
+    return policy == SCHED_OTHER || policy == SCHED_FIFO || policy == SCHED_RR;
+}
+
+/*
+ * TCB and default stack per slot.  A slot is handed back when its
+ * thread is joined, or as a detached thread exits, so spawning workers
+ * forever needs only as many slots as run at once.
+ */
+static nk_tcb_t thread_tcb[PTHREAD_THREADS_MAX];
+static uint8_t  thread_stacks[PTHREAD_THREADS_MAX][PTHREAD_STACK_DEFAULT]
+    __attribute__((section(".noinit")));
+static uint8_t  thread_slot_used[PTHREAD_THREADS_MAX];
+
+/* Under nk_sched_lock(); returns slot + 1, or 0 if all are taken */
+static uint8_t slot_get(void) {
+    for (uint8_t i = 0; i < PTHREAD_THREADS_MAX; i++) {
+        if (!thread_slot_used[i]) {
+            thread_slot_used[i] = 1;
+            return (uint8_t)(i + 1);
+        }
+    }
+    return 0;
+}
+
+static void slot_put(pthread_info_t *info) {
+    if (info->slot) {
+        thread_slot_used[info->slot - 1] = 0;
+        info->slot = 0;
+    }
+}
+
+/* Under nk_sched_lock(): give the kernel slot back, then our TCB/stack */
+static void thread_reap(pthread_t tid) {
+    pthread_info_t *info = &thread_info[tid];
+
+    nk_task_release((uint8_t)tid);
+    slot_put(info);
+}
+
 /* Thread entry wrapper */
 static void pthread_entry_wrapper(void) {
-    pthread_t self = pthread_self();
-    pthread_info_t *info = &thread_info[self];
-
-    /* Call user's start routine */
-    info->retval = info->start_routine(info->arg);
+    pthread_info_t *info = &thread_info[pthread_self()];
 
-    /* Exit thread */
-    pthread_exit(info->retval);
+    /* Call user's start routine, then exit with its result */
+    pthread_exit(info->start_routine(info->arg));
 }
 
 /**
@@ -57,44 +108,64 @@ int pthread_create(pthread_t *thread,
 
     /* Default attributes */
     uint8_t detachstate = PTHREAD_CREATE_JOINABLE;
-    size_t stacksize = 256;  /* Default stack size */
+    size_t stacksize = PTHREAD_STACK_DEFAULT;
     void *stackaddr = NULL;
+    uint8_t prio = PRIO_DEFAULT;
+    uint8_t policy = SCHED_OTHER;
 
     /* Parse attributes if provided */
     if (attr) {
         detachstate = attr->detachstate;
-        stacksize = attr->stacksize ? attr->stacksize : 256;
+        stacksize = attr->stacksize ? attr->stacksize : PTHREAD_STACK_DEFAULT;
         stackaddr = attr->stackaddr;
+        prio = attr->priority;
+        policy = attr->policy;
     }
 
-    /* Allocate stack if not provided */
-    static uint8_t thread_stacks[PTHREAD_THREADS_MAX][256] __attribute__((section(".noinit")));
-    static uint8_t next_thread = 0;
-
-    if (!stackaddr) {
-        if (next_thread >= PTHREAD_THREADS_MAX) {
-            return EAGAIN;  /* Too many threads */
-        }
-        stackaddr = thread_stacks[next_thread];
-        next_thread++;
+    /*
+     * Held until thread_info[] is filled in: the new thread cannot run
+     * (and look itself up) before then, and a detached one cannot exit
+     * before it is marked detached.
+     */
+    uint32_t s = nk_sched_lock();
+
+    uint8_t slot = slot_get();
+    if (!slot) {
+        nk_sched_unlock(s);
+        return EAGAIN;  /* Too many threads */
+    }
+    if (!stackaddr && stacksize <= PTHREAD_STACK_DEFAULT) {
+        stackaddr = thread_stacks[slot - 1];
+        stacksize = PTHREAD_STACK_DEFAULT;
     }
 
-    /* Find free slot in thread info table */
-    pthread_t tid = next_thread - 1;
+    /* Create kernel task (stackaddr NULL: carved from the kernel pool) */
+    nk_tcb_t *tcb = &thread_tcb[slot - 1];
+    if (!nk_task_create(tcb, pthread_entry_wrapper, prio_to_nk(prio),
+                        stackaddr, stacksize)) {
+        thread_slot_used[slot - 1] = 0;
+        nk_sched_unlock(s);
+        return EAGAIN;  /* Task creation failed */
+    }
 
-    /* Initialize thread info */
+    pthread_t tid = tcb->pid;
     thread_info[tid].start_routine = start_routine;
     thread_info[tid].arg = arg;
     thread_info[tid].retval = NULL;
     thread_info[tid].joinable = (detachstate == PTHREAD_CREATE_JOINABLE);
-
-    /* Create kernel task */
-    hal_context_t ctx;
-    uint8_t prio = attr ? attr->priority : 128;  /* Default mid-priority */
-
-    if (!nk_task_create(&ctx, pthread_entry_wrapper, prio, stackaddr, stacksize)) {
-        return EAGAIN;  /* Task creation failed */
+    thread_info[tid].exited = 0;
+    thread_info[tid].slot = slot;
+    pthread_tls_start((uint8_t)tid);
+    if (!thread_info[tid].joinable) {
+        nk_task_release((uint8_t)tid);     /* kernel frees the slot at exit */
+    }
+    if (attr && attr->quantum) {
+        nk_task_set_quantum((uint8_t)tid, attr->quantum);
     }
+    if (policy == SCHED_FIFO) {
+        nk_task_set_policy((uint8_t)tid, NK_SCHED_FIFO);
+    }
+    nk_sched_unlock(s);
 
     *thread = tid;
     return 0;
@@ -102,27 +173,36 @@ int pthread_create(pthread_t *thread,
 
 /**
  * @brief Wait for thread termination
+ *
+ * Sleeps on the kernel's exit queue for the thread, then recycles its
+ * slot and stack.
  */
 int pthread_join(pthread_t thread, void **retval) {
     if (thread >= PTHREAD_THREADS_MAX) {
         return EINVAL;
     }
+    if (thread == pthread_self()) {
+        return EDEADLK;
+    }
 
     pthread_info_t *info = &thread_info[thread];
 
-    if (!info->joinable) {
-        return EINVAL;  /* Thread is detached */
+    uint32_t s = nk_sched_lock();
+    if (!info->joinable || !info->slot) {
+        nk_sched_unlock(s);
+        return EINVAL;  /* Detached, already joined or never created */
     }
+    info->joinable = 0;  /* One joiner only */
+    nk_sched_unlock(s);
 
-    /* Wait for thread to exit (busy-wait for now, will be improved) */
-    /* TODO: Implement proper wait queue in kernel */
-    while (info->start_routine != NULL) {
-        nk_yield();
-    }
+    nk_task_wait((uint8_t)thread);
 
+    s = nk_sched_lock();
     if (retval) {
         *retval = info->retval;
     }
+    thread_reap(thread);
+    nk_sched_unlock(s);
 
     return 0;
 }
@@ -135,19 +215,40 @@ int pthread_detach(pthread_t thread) {
         return EINVAL;
     }
 
-    thread_info[thread].joinable = 0;
-    return 0;
+    pthread_info_t *info = &thread_info[thread];
+    int err = 0;
+
+    uint32_t s = nk_sched_lock();
+    if (!info->joinable || !info->slot) {
+        err = EINVAL;
+    } else if (info->exited) {
+        thread_reap(thread);            /* already gone: reclaim now */
+    } else {
+        info->joinable = 0;
+        nk_task_release((uint8_t)thread);
+    }
+    nk_sched_unlock(s);
+    return err;
 }
 
 /**
  * @brief Terminate calling thread
+ *
+ * A detached thread gives its TCB/stack slot back here.  The scheduler
+ * lock stays held into nk_task_exit(), which only drops it by switching
+ * away, so nobody can hand the slot out while this stack is still live.
  */
 void pthread_exit(void *retval) {
     pthread_t self = pthread_self();
     pthread_info_t *info = &thread_info[self];
 
+    pthread_tls_exit();
+    (void)nk_sched_lock();
     info->retval = retval;
-    info->start_routine = NULL;  /* Mark as exited */
+    info->exited = 1;
+    if (!info->joinable) {
+        slot_put(info);
+    }
 
     /* Exit kernel task */
     nk_task_exit(0);
@@ -179,6 +280,115 @@ int sched_yield(void) {
     return pthread_yield();
 }
 
+/*═══════════════════════════════════════════════════════════════════
+ * SCHEDULING POLICY
+ *═══════════════════════════════════════════════════════════════════*/
+
+int pthread_setschedparam(pthread_t thread, int policy,
+                          const struct sched_param *param) {
+    if (!param || !policy_valid(policy) ||
+        param->sched_priority < 0 || param->sched_priority > SCHED_PRIO_MAX) {
+        return EINVAL;
+    }
+    uint32_t tid = (uint32_t)thread;
+    if (tid > UINT8_MAX) {
+        return ESRCH;
+    }
+
+    /* Both at once: the thread never runs with half the change */
+    uint32_t s = nk_sched_lock();
+    if (!nk_task_set_policy((uint8_t)tid,
+                            policy == SCHED_FIFO ? NK_SCHED_FIFO : NK_SCHED_RR)) {
+        nk_sched_unlock(s);
+        return ESRCH;
+    }
+    nk_task_set_priority((uint8_t)tid, prio_to_nk((uint8_t)param->sched_priority));
+    nk_sched_unlock(s);
+    return 0;
+}
+
+int pthread_getschedparam(pthread_t thread, int *policy,
+                          struct sched_param *param) {
+    uint32_t tid = (uint32_t)thread;
+    uint8_t p = tid > UINT8_MAX ? 0xFF : nk_task_policy((uint8_t)tid);
+    if (p == 0xFF) {
+        return ESRCH;
+    }
+    if (policy) {
+        *policy = p == NK_SCHED_FIFO ? SCHED_FIFO : SCHED_RR;
+    }
+    if (param) {
+        param->sched_priority = SCHED_PRIO_MAX - nk_task_priority((uint8_t)tid);
+    }
+    return 0;
+}
+
+static inline pthread_t sched_target(pid_t pid) {
+    return pid ? (pthread_t)pid : (pthread_t)nk_current_tid();
+}
+
+int sched_setscheduler(pid_t pid, int policy, const struct sched_param *param) {
+    int old;
+    int err = pthread_getschedparam(sched_target(pid), &old, NULL);
+    if (!err) {
+        err = pthread_setschedparam(sched_target(pid), policy, param);
+    }
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return old;
+}
+
+int sched_getscheduler(pid_t pid) {
+    int policy;
+    int err = pthread_getschedparam(sched_target(pid), &policy, NULL);
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return policy;
+}
+
+int sched_setparam(pid_t pid, const struct sched_param *param) {
+    int policy = sched_getscheduler(pid);
+    if (policy < 0) {
+        return -1;
+    }
+    int err = pthread_setschedparam(sched_target(pid), policy, param);
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+int sched_getparam(pid_t pid, struct sched_param *param) {
+    int err = param ? pthread_getschedparam(sched_target(pid), NULL, param)
+                    : EINVAL;
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+int sched_get_priority_max(int policy) {
+    if (!policy_valid(policy)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return SCHED_PRIO_MAX;
+}
+
+int sched_get_priority_min(int policy) {
+    if (!policy_valid(policy)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
 /*═══════════════════════════════════════════════════════════════════
  * THREAD ATTRIBUTES
  *═══════════════════════════════════════════════════════════════════*/
@@ -187,9 +397,11 @@ int pthread_attr_init(pthread_attr_t *attr) {
     if (!attr) return EINVAL;
 
     attr->detachstate = PTHREAD_CREATE_JOINABLE;
-    attr->priority = 128;
+    attr->priority = PRIO_DEFAULT;
+    attr->policy = SCHED_OTHER;
     attr->stacksize = 256;
     attr->stackaddr = NULL;
+    attr->quantum = 0;
 
     return 0;
 }
@@ -243,3 +455,48 @@ int pthread_attr_getstackaddr(const pthread_attr_t *attr, void **stackaddr) {
     *stackaddr = attr->stackaddr;
     return 0;
 }
+
+int pthread_attr_setquantum_np(pthread_attr_t *attr, uint8_t quantum) {
+    if (!attr) return EINVAL;
+
+    attr->quantum = quantum;
+    return 0;
+}
+
+int pthread_attr_getquantum_np(const pthread_attr_t *attr, uint8_t *quantum) {
+    if (!attr || !quantum) return EINVAL;
+
+    *quantum = attr->quantum;
+    return 0;
+}
+
+int pthread_attr_setschedpolicy(pthread_attr_t *attr, int policy) {
+    if (!attr || !policy_valid(policy)) return EINVAL;
+
+    attr->policy = (uint8_t)policy;
+    return 0;
+}
+
+int pthread_attr_getschedpolicy(const pthread_attr_t *attr, int *policy) {
+    if (!attr || !policy) return EINVAL;
+
+    *policy = attr->policy;
+    return 0;
+}
+
+int pthread_attr_setschedparam(pthread_attr_t *attr, const struct sched_param *param) {
+    if (!attr || !param ||
+        param->sched_priority < 0 || param->sched_priority > SCHED_PRIO_MAX) {
+        return EINVAL;
+    }
+
+    attr->priority = (uint8_t)param->sched_priority;
+    return 0;
+}
+
+int pthread_attr_getschedparam(const pthread_attr_t *attr, struct sched_param *param) {
+    if (!attr || !param) return EINVAL;
+
+    param->sched_priority = attr->priority;
+    return 0;
+}
@@ -6,16 +6,49 @@
  * @file pthread_mutex.c
  * @brief Mutex (mutual exclusion) implementation
  *
- * Implements pthread_mutex_*() functions. Wraps kernel spinlock/mutex
- * primitives for portability.
+ * Implements pthread_mutex_*() functions on top of the scheduler's wait
+ * queues.  The uncontended path is a single test-and-set; contended
+ * lockers block in NK_BLOCKED and unlock hands ownership straight to the
+ * highest-priority waiter, so the lock word never drops to 0 in between.
+ *
+ * Before blocking, a contended locker spins for up to sync_mutex_spin
+ * rounds while the owner is running (nk_mutex_spin(), shared with the
+ * kernel's adaptive nk_mutex_t).  The high profile enables this; with
+ * 0 rounds the locker blocks at once.
  */
 
 #include "pthread.h"
 #include "arch/common/hal.h"
+#include "kernel/sync/nk_mutex.h"
 
-extern int errno;
 extern uint8_t nk_current_tid(void);
 extern void nk_yield(void);
+extern uint32_t nk_sched_lock(void);
+extern void nk_sched_unlock(uint32_t s);
+extern void nk_waitq_block(uint8_t *q);
+extern int  nk_waitq_wake_one(uint8_t *q);
+extern void nk_task_boost(uint8_t tid, uint8_t prio);
+extern void nk_task_unboost(uint8_t tid);
+extern uint8_t nk_task_priority(uint8_t tid);
+
+/*
+ * PTHREAD_PRIO_INHERIT bookkeeping: how many inheriting mutexes each
+ * thread holds.  A boosted owner only drops back to its base priority
+ * once it has released all of them.
+ */
+static uint8_t pi_held[PTHREAD_THREADS_MAX];
+
+static inline void pi_acquired(pthread_mutex_t *mutex, pthread_t tid) {
+    if (mutex->protocol == PTHREAD_PRIO_INHERIT && tid < PTHREAD_THREADS_MAX) {
+        pi_held[tid]++;
+    }
+}
+
+#if NK_LOCK_STATS
+#  define MUTEX_STAT(m) (&(m)->stat)
+#else
+#  define MUTEX_STAT(m) ((nk_lockstat_t *)NULL)
+#endif
 
 /**
  * @brief Initialize a mutex
@@ -28,6 +61,11 @@ int pthread_mutex_init(pthread_mutex_t *mutex, const pthread_mutexattr_t *attr)
     mutex->lock = 0;
     mutex->owner = 0;
     mutex->type = attr ? attr->type : PTHREAD_MUTEX_NORMAL;
+    mutex->waiters = 0;
+    mutex->protocol = attr ? attr->protocol : PTHREAD_PRIO_NONE;
+#if NK_LOCK_STATS
+    mutex->stat = (nk_lockstat_t)NK_LOCKSTAT_INIT(NULL);
+#endif
 
     return 0;
 }
@@ -45,13 +83,15 @@ int pthread_mutex_destroy(pthread_mutex_t *mutex) {
         return EBUSY;
     }
 
+    nk_lockstat_forget(MUTEX_STAT(mutex));
     return 0;
 }
 
 /**
  * @brief Lock a mutex
  *
- * Uses HAL atomic operations for thread-safe locking.
+ * Fast path is one HAL test-and-set; on contention the caller sleeps on
+ * the mutex wait queue until unlock hands it the lock.
  */
 int pthread_mutex_lock(pthread_mutex_t *mutex) {
     if (!mutex) {
@@ -72,15 +112,38 @@ int pthread_mutex_lock(pthread_mutex_t *mutex) {
         return EDEADLK;
     }
 
-    /* Spin until we acquire the lock */
-    while (hal_atomic_test_and_set_u8(&mutex->lock)) {
-        /* Lock is held, yield to other threads */
-        nk_yield();
+    if (!hal_atomic_test_and_set_u8(&mutex->lock)) {
+        mutex->owner = self;
+        pi_acquired(mutex, self);
+        nk_lockstat_acquired(MUTEX_STAT(mutex), 0, false);
+        return 0;
     }
 
-    /* Lock acquired */
-    mutex->owner = self;
+    uint32_t spins = nk_lockstat_spins();
+    if (nk_mutex_spin(&mutex->lock, (uint8_t)mutex->owner)) {
+        mutex->owner = self;
+        pi_acquired(mutex, self);
+        nk_lockstat_acquired(MUTEX_STAT(mutex), nk_lockstat_spins() - spins, true);
+        return 0;
+    }
 
+    /* Contended: re-check under the scheduler lock, then block */
+    uint32_t s = nk_sched_lock();
+    if (!hal_atomic_test_and_set_u8(&mutex->lock)) {
+        mutex->owner = self;
+        pi_acquired(mutex, self);
+        nk_sched_unlock(s);
+        nk_lockstat_acquired(MUTEX_STAT(mutex), nk_lockstat_spins() - spins, true);
+        return 0;
+    }
+    if (mutex->protocol == PTHREAD_PRIO_INHERIT) {
+        /* Lend our priority to the owner while we wait */
+        nk_task_boost((uint8_t)mutex->owner, nk_task_priority((uint8_t)self));
+    }
+    nk_waitq_block(&mutex->waiters);
+
+    /* Woken by unlock: ownership (and PI accounting) was transferred */
+    nk_lockstat_acquired(MUTEX_STAT(mutex), nk_lockstat_spins() - spins, true);
     return 0;
 }
 
@@ -106,6 +169,8 @@ int pthread_mutex_trylock(pthread_mutex_t *mutex) {
 
     /* Lock acquired */
     mutex->owner = self;
+    pi_acquired(mutex, self);
+    nk_lockstat_acquired(MUTEX_STAT(mutex), 0, false);
 
     return 0;
 }
@@ -128,9 +193,36 @@ int pthread_mutex_unlock(pthread_mutex_t *mutex) {
     /* Recursive mutex: (in full implementation, would decrement count) */
     /* For now, just release the lock */
 
-    /* Release the lock */
-    mutex->owner = 0;
-    hal_atomic_exchange_u8(&mutex->lock, 0);
+    /* Hand off to the first waiter, or release the lock */
+    nk_lockstat_released(MUTEX_STAT(mutex));
+    uint32_t s = nk_sched_lock();
+    int next = nk_waitq_wake_one(&mutex->waiters);
+    if (next >= 0) {
+        mutex->owner = (pid_t)next;
+        pi_acquired(mutex, (pthread_t)next);
+    } else {
+        mutex->owner = 0;
+        hal_atomic_exchange_u8(&mutex->lock, 0);
+    }
+
+    bool inherit = (mutex->protocol == PTHREAD_PRIO_INHERIT);
+    if (inherit) {
+        /* New owner inherits from whoever is still queued behind it */
+        if (next >= 0 && mutex->waiters) {
+            nk_task_boost((uint8_t)next,
+                          nk_task_priority((uint8_t)(mutex->waiters - 1)));
+        }
+        if (self < PTHREAD_THREADS_MAX && pi_held[self] && --pi_held[self] == 0) {
+            nk_task_unboost((uint8_t)self);
+        }
+    }
+    nk_sched_unlock(s);
+
+    /* Let a more urgent new owner run now rather than at the next tick */
+    if (inherit && next >= 0 &&
+        nk_task_priority((uint8_t)next) < nk_task_priority((uint8_t)self)) {
+        nk_yield();
+    }
 
     return 0;
 }
@@ -171,10 +263,13 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type) {
 int pthread_mutexattr_setprotocol(pthread_mutexattr_t *attr, int protocol) {
     if (!attr) return EINVAL;
 
-    /* Priority inheritance not yet supported */
-    if (protocol != PTHREAD_PRIO_NONE) {
+    /* Priority ceiling (PRIO_PROTECT) is not supported */
+    if (protocol == PTHREAD_PRIO_PROTECT) {
         return ENOTSUP;
     }
+    if (protocol != PTHREAD_PRIO_NONE && protocol != PTHREAD_PRIO_INHERIT) {
+        return EINVAL;
+    }
 
     attr->protocol = (uint8_t)protocol;
     return 0;
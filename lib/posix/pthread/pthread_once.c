@@ -12,8 +12,6 @@
 #include "pthread.h"
 #include "arch/common/hal.h"
 
-extern int errno;
-
 /**
  * @brief Execute a function exactly once
  *
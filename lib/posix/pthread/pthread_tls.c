@@ -0,0 +1,191 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file pthread_tls.c
+ * @brief errno and thread-specific data
+ *
+ * Every pthread owns a posix_tls_t, indexed by task ID.  With
+ * kernel_tls the scheduler keeps a pointer to the running thread's
+ * block in nk_tls_self, so errno and pthread_getspecific() are a load
+ * and an offset; tasks that are not pthreads share posix_tls_shared.
+ * Without it, errno is one global and the keys find the block by
+ * nk_current_tid().
+ *
+ * On ARM, GCC's __thread (-mtp=soft) reads the thread pointer through
+ * __aeabi_read_tp(), provided here.  Each pthread then gets its own
+ * copy of .tdata/.tbss, POSIX_TLS_IMAGE bytes at most; the copy is
+ * found with the linker script symbols __tdata_start, __tdata_end,
+ * __tbss_start and __tbss_end.  Tasks that are not pthreads share one
+ * zero-filled copy.
+ */
+
+#include "pthread.h"
+#include "arch/common/hal.h"
+#include "kernel/sched/scheduler.h"
+#include <string.h>
+
+/** Bytes of __thread data per thread (0 = no __thread support) */
+#ifndef POSIX_TLS_IMAGE
+#define POSIX_TLS_IMAGE 0
+#endif
+
+static posix_tls_t thread_tls[PTHREAD_THREADS_MAX];
+
+#if POSIX_TLS
+posix_tls_t posix_tls_shared;
+#define TLS() posix_tls()
+#else
+/* Global errno (weak symbol, can be overridden) */
+__attribute__((weak))
+int errno = 0;
+
+static posix_tls_t posix_tls_shared;
+
+static posix_tls_t *tls_lookup(void) {
+    uint8_t tid = nk_current_tid();
+    return tid < PTHREAD_THREADS_MAX ? &thread_tls[tid] : &posix_tls_shared;
+}
+#define TLS() tls_lookup()
+#endif
+
+/** Destructor per key; NULL with key_used set means "none" */
+static void (*key_dtor[PTHREAD_KEYS_MAX])(void *);
+static uint8_t key_used[PTHREAD_KEYS_MAX];
+
+/*═══════════════════════════════════════════════════════════════════
+ * __thread (ARM)
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if POSIX_TLS && defined(__arm__) && POSIX_TLS_IMAGE > 0
+extern const uint8_t __tdata_start[] __attribute__((weak));
+extern const uint8_t __tdata_end[]   __attribute__((weak));
+extern const uint8_t __tbss_start[]  __attribute__((weak));
+extern const uint8_t __tbss_end[]    __attribute__((weak));
+
+/* One copy per pthread plus the shared one, 8-aligned for the ABI */
+static uint8_t tls_image[PTHREAD_THREADS_MAX + 1][POSIX_TLS_IMAGE]
+    __attribute__((aligned(8)));
+
+/* The ABI's thread pointer sits 8 bytes (the TCB) before the data */
+static void image_init(posix_tls_t *t, uint8_t *img) {
+    size_t data = (size_t)(__tdata_end - __tdata_start);
+    size_t bss  = (size_t)(__tbss_end - __tbss_start);
+
+    if (data > POSIX_TLS_IMAGE) data = POSIX_TLS_IMAGE;
+    if (bss > POSIX_TLS_IMAGE - data) bss = POSIX_TLS_IMAGE - data;
+    memcpy(img, __tdata_start, data);
+    memset(img + data, 0, bss);
+    t->tp = img - 8;
+}
+
+/*
+ * r0 only, as the AEABI requires of this helper: nk_tls_self, or the
+ * shared block, and its first member is the thread pointer.
+ */
+__attribute__((naked)) void *__aeabi_read_tp(void) {
+    __asm__ volatile(
+        "ldr  r0, =nk_tls_self      \n\t"
+        "ldr  r0, [r0]              \n\t"
+        "cbnz r0, 1f                \n\t"
+        "ldr  r0, =posix_tls_shared \n"
+        "1:                         \n\t"
+        "ldr  r0, [r0]              \n\t"
+        "bx   lr                    \n\t"
+        ".ltorg");
+}
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * THREAD LIFETIME (pthread_create.c)
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Fresh state for thread @p tid, installed as its TLS block
+ *
+ * Called under nk_sched_lock(), before the thread first runs.
+ */
+void pthread_tls_start(uint8_t tid) {
+    posix_tls_t *t = &thread_tls[tid];
+
+    memset(t, 0, sizeof *t);
+#if POSIX_TLS && defined(__arm__) && POSIX_TLS_IMAGE > 0
+    image_init(t, tls_image[tid]);
+    if (!posix_tls_shared.tp) {
+        posix_tls_shared.tp = tls_image[PTHREAD_THREADS_MAX] - 8;
+    }
+#endif
+    nk_task_set_tls(tid, t);
+}
+
+/**
+ * @brief Run the calling thread's key destructors
+ */
+void pthread_tls_exit(void) {
+    posix_tls_t *t = TLS();
+
+    for (uint8_t pass = 0; pass < PTHREAD_DESTRUCTOR_ITERATIONS; pass++) {
+        bool ran = false;
+        for (uint8_t k = 0; k < PTHREAD_KEYS_MAX; k++) {
+            void *v = (void *)t->key[k];
+            if (!v || !key_used[k] || !key_dtor[k]) {
+                continue;
+            }
+            t->key[k] = NULL;
+            key_dtor[k](v);
+            ran = true;
+        }
+        if (!ran) {
+            break;
+        }
+    }
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * KEYS
+ *═══════════════════════════════════════════════════════════════════*/
+
+int pthread_key_create(pthread_key_t *key, void (*destructor)(void *)) {
+    if (!key) return EINVAL;
+
+    uint32_t s = nk_sched_lock();
+    for (uint8_t k = 0; k < PTHREAD_KEYS_MAX; k++) {
+        if (key_used[k]) {
+            continue;
+        }
+        /* A recycled key reads NULL in every thread */
+        for (uint8_t i = 0; i < PTHREAD_THREADS_MAX; i++) {
+            thread_tls[i].key[k] = NULL;
+        }
+        posix_tls_shared.key[k] = NULL;
+        key_used[k] = 1;
+        key_dtor[k] = destructor;
+        nk_sched_unlock(s);
+        *key = k;
+        return 0;
+    }
+    nk_sched_unlock(s);
+    return EAGAIN;
+}
+
+int pthread_key_delete(pthread_key_t key) {
+    if (key >= PTHREAD_KEYS_MAX || !key_used[key]) return EINVAL;
+
+    key_used[key] = 0;
+    key_dtor[key] = NULL;
+    return 0;
+}
+
+int pthread_setspecific(pthread_key_t key, const void *value) {
+    if (key >= PTHREAD_KEYS_MAX || !key_used[key]) return EINVAL;
+
+    TLS()->key[key] = value;
+    return 0;
+}
+
+void *pthread_getspecific(pthread_key_t key) {
+    if (key >= PTHREAD_KEYS_MAX) return NULL;
+
+    return (void *)TLS()->key[key];
+}
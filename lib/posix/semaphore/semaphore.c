@@ -0,0 +1,133 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file semaphore.c
+ * @brief POSIX unnamed semaphores on kernel wait queues
+ *
+ * The count and the wait queue are only touched under the scheduler
+ * lock, which masks interrupts, so sem_post() may run in an ISR.  A
+ * post with waiters hands its unit directly to the first of them; the
+ * count stays zero and a later sem_trywait() cannot steal it.
+ */
+
+#include "semaphore.h"
+#include "../posix_timeout.h"
+
+extern uint32_t nk_sched_lock(void);
+extern void nk_sched_unlock(uint32_t s);
+extern void nk_waitq_block(uint8_t *q);
+extern int  nk_waitq_block_timeout(uint8_t *q, uint16_t ticks);
+extern int  nk_waitq_wake_one(uint8_t *q);
+
+int sem_init(sem_t *sem, int pshared, unsigned int value) {
+    (void)pshared;
+    if (!sem || value > SEM_VALUE_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+    sem->value = (uint16_t)value;
+    sem->waiters = 0;
+    return 0;
+}
+
+int sem_destroy(sem_t *sem) {
+    if (!sem) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (sem->waiters) {
+        errno = EBUSY;
+        return -1;
+    }
+    return 0;
+}
+
+/* Take a unit, waiting up to @p abstime (NULL = forever). */
+static int sem_take(sem_t *sem, const struct timespec *abstime) {
+    if (!sem) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (;;) {
+        uint32_t s = nk_sched_lock();
+        if (sem->value) {
+            sem->value--;
+            nk_sched_unlock(s);
+            return 0;
+        }
+        if (!abstime) {
+            nk_waitq_block(&sem->waiters);
+            return 0;                  /* sem_post() handed us its unit */
+        }
+
+        int err;
+        uint16_t ticks = posix_ticks_until(abstime, &err);
+        if (!ticks) {
+            nk_sched_unlock(s);
+            errno = err ? err : ETIMEDOUT;
+            return -1;
+        }
+        if (nk_waitq_block_timeout(&sem->waiters, ticks) == 0) {
+            return 0;
+        }
+        /* Timed out: loop re-checks the deadline (long waits are clamped) */
+    }
+}
+
+int sem_wait(sem_t *sem) {
+    return sem_take(sem, NULL);
+}
+
+int sem_timedwait(sem_t *sem, const struct timespec *abstime) {
+    if (!abstime) {
+        errno = EINVAL;
+        return -1;
+    }
+    return sem_take(sem, abstime);
+}
+
+int sem_trywait(sem_t *sem) {
+    if (!sem) {
+        errno = EINVAL;
+        return -1;
+    }
+    uint32_t s = nk_sched_lock();
+    if (!sem->value) {
+        nk_sched_unlock(s);
+        errno = EAGAIN;
+        return -1;
+    }
+    sem->value--;
+    nk_sched_unlock(s);
+    return 0;
+}
+
+int sem_post(sem_t *sem) {
+    if (!sem) {
+        errno = EINVAL;
+        return -1;
+    }
+    uint32_t s = nk_sched_lock();
+    if (nk_waitq_wake_one(&sem->waiters) < 0) {
+        if (sem->value >= SEM_VALUE_MAX) {
+            nk_sched_unlock(s);
+            errno = EOVERFLOW;
+            return -1;
+        }
+        sem->value++;
+    }
+    nk_sched_unlock(s);
+    return 0;
+}
+
+int sem_getvalue(sem_t *sem, int *sval) {
+    if (!sem || !sval) {
+        errno = EINVAL;
+        return -1;
+    }
+    *sval = sem->value;
+    return 0;
+}
@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file semaphore.h
+ * @brief POSIX Unnamed Semaphores for Embedded Systems
+ *
+ * Counting semaphores on a kernel wait queue.  sem_wait() on a zero
+ * count blocks the caller (no polling); sem_post() hands the unit
+ * straight to the highest-priority waiter, or bumps the count if
+ * nobody waits.  sem_post() is safe from interrupt handlers, which
+ * makes a semaphore the usual way for an ISR to wake a driver task.
+ *
+ * Profile Support:
+ * - Low-end (PSE51): Not available (single task)
+ * - Mid-range (PSE52): Enabled
+ * - High-end (PSE54): Enabled
+ *
+ * Deviations from POSIX.1-2008:
+ * - Named semaphores (sem_open() and friends) are not provided.
+ * - pshared is accepted and ignored: every task shares one address space.
+ * - sem_timedwait() deadlines are on CLOCK_MONOTONIC (ticks since boot).
+ */
+
+#ifndef POSIX_SEMAPHORE_H
+#define POSIX_SEMAPHORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../posix_types.h"
+
+/** Largest count a semaphore can hold. */
+#define SEM_VALUE_MAX 32767
+
+/**
+ * @brief Unnamed semaphore (3 bytes)
+ */
+typedef struct {
+    volatile uint16_t value;   /**< Units available */
+    uint8_t           waiters; /**< Kernel wait queue (nk_waitq_t) */
+} sem_t;
+
+/**
+ * @brief Initialize a semaphore
+ *
+ * @param sem     Semaphore
+ * @param pshared Ignored
+ * @param value   Initial count (<= SEM_VALUE_MAX)
+ * @return 0 on success, -1 with errno EINVAL
+ */
+int sem_init(sem_t *sem, int pshared, unsigned int value);
+
+/**
+ * @brief Destroy a semaphore
+ *
+ * @return 0 on success, -1 with errno EBUSY if tasks are waiting
+ */
+int sem_destroy(sem_t *sem);
+
+/**
+ * @brief Take a unit, blocking while the count is zero
+ *
+ * @return 0 on success, -1 with errno EINVAL
+ */
+int sem_wait(sem_t *sem);
+
+/**
+ * @brief Take a unit if one is available
+ *
+ * @return 0 on success, -1 with errno EAGAIN if the count is zero
+ */
+int sem_trywait(sem_t *sem);
+
+/**
+ * @brief sem_wait() with an absolute CLOCK_MONOTONIC deadline
+ *
+ * @return 0 on success, -1 with errno ETIMEDOUT or EINVAL
+ */
+int sem_timedwait(sem_t *sem, const struct timespec *abstime);
+
+/**
+ * @brief Release a unit (ISR-safe)
+ *
+ * @return 0 on success, -1 with errno EOVERFLOW at SEM_VALUE_MAX
+ */
+int sem_post(sem_t *sem);
+
+/**
+ * @brief Read the current count
+ *
+ * @param sem  Semaphore
+ * @param sval Receives the count (0 while tasks are waiting)
+ * @return 0 on success, -1 with errno EINVAL
+ */
+int sem_getvalue(sem_t *sem, int *sval);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POSIX_SEMAPHORE_H */
@@ -0,0 +1,298 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file signal.c
+ * @brief POSIX signals over the kernel's per-task signal masks
+ *
+ * The kernel keeps the pending and blocked masks and decides when a
+ * task takes its signals; this file owns the dispositions and turns a
+ * delivered signal number into a handler call or a default action.
+ * The dispatcher is installed on first use, by whichever of sigaction(),
+ * signal() or the senders runs first.
+ */
+
+#include "signal.h"
+#include "kernel/sched/scheduler.h"
+
+/** Signals nobody can catch, block or ignore */
+#define SIG_UNBLOCKABLE (NK_SIG_BIT(SIGKILL) | NK_SIG_BIT(SIGSTOP))
+
+static inline bool sig_valid(int sig) {
+    return sig > 0 && sig < NSIG;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * SIGNAL SETS
+ *═══════════════════════════════════════════════════════════════════*/
+
+int sigemptyset(sigset_t *set) {
+    *set = 0;
+    return 0;
+}
+
+int sigfillset(sigset_t *set) {
+    *set = ~(sigset_t)0;
+    return 0;
+}
+
+int sigaddset(sigset_t *set, int sig) {
+    if (!sig_valid(sig)) {
+        errno = EINVAL;
+        return -1;
+    }
+    *set |= NK_SIG_BIT(sig);
+    return 0;
+}
+
+int sigdelset(sigset_t *set, int sig) {
+    if (!sig_valid(sig)) {
+        errno = EINVAL;
+        return -1;
+    }
+    *set &= ~NK_SIG_BIT(sig);
+    return 0;
+}
+
+int sigismember(const sigset_t *set, int sig) {
+    if (!sig_valid(sig)) {
+        errno = EINVAL;
+        return -1;
+    }
+    return (*set & NK_SIG_BIT(sig)) ? 1 : 0;
+}
+
+#if POSIX_SIGNALS
+
+/*═══════════════════════════════════════════════════════════════════
+ * DISPATCH
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Dispositions, indexed by signal number (zero = SIG_DFL) */
+static struct sigaction sig_act[NSIG];
+
+/** Default action "ignore"; for the rest it is "terminate" or "stop" */
+#define SIG_DFL_IGNORE (NK_SIG_BIT(SIGCHLD) | NK_SIG_BIT(SIGCONT) | \
+                        NK_SIG_BIT(SIGURG)  | NK_SIG_BIT(SIGWINCH))
+#define SIG_DFL_STOP   (NK_SIG_BIT(SIGSTOP) | NK_SIG_BIT(SIGTSTP))
+
+/**
+ * @brief Run one delivered signal in the receiving task
+ */
+static void sig_dispatch(uint8_t sig) {
+    struct sigaction act = sig_act[sig];
+
+    if (act.sa_handler == SIG_IGN) {
+        return;
+    }
+    if (act.sa_handler == SIG_DFL) {
+        if (SIG_DFL_IGNORE & NK_SIG_BIT(sig)) {
+            return;
+        }
+        if (SIG_DFL_STOP & NK_SIG_BIT(sig)) {
+            /* Stopped until SIGCONT (ignored by default) or SIGKILL */
+            (void)nk_sig_suspend(~(NK_SIG_BIT(SIGCONT) | NK_SIG_BIT(SIGKILL)));
+            return;
+        }
+        nk_task_exit(128 + sig);
+    }
+
+    if (act.sa_flags & SA_RESETHAND) {
+        sig_act[sig].sa_handler = SIG_DFL;
+    }
+
+    nk_sigset_t mask = act.sa_mask;
+    if (!(act.sa_flags & SA_NODEFER)) {
+        mask |= NK_SIG_BIT(sig);
+    }
+    nk_sigset_t old = nk_sig_setmask((nk_sig_blocked() | mask) & ~SIG_UNBLOCKABLE);
+    act.sa_handler(sig);
+    nk_sig_setmask(old);
+}
+
+static inline void sig_init(void) {
+    nk_sig_dispatch(sig_dispatch);
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * DISPOSITION AND MASK
+ *═══════════════════════════════════════════════════════════════════*/
+
+int sigaction(int sig, const struct sigaction *act, struct sigaction *oact) {
+    if (!sig_valid(sig) ||
+        (act && (NK_SIG_BIT(sig) & SIG_UNBLOCKABLE))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    sig_init();
+    if (oact) {
+        *oact = sig_act[sig];
+    }
+    if (act) {
+        uint32_t s = hal_irq_save();
+        sig_act[sig] = *act;
+        sig_act[sig].sa_mask &= ~SIG_UNBLOCKABLE;
+        hal_irq_restore(s);
+    }
+    return 0;
+}
+
+sighandler_t signal(int sig, sighandler_t handler) {
+    struct sigaction act = { .sa_handler = handler };
+    struct sigaction old;
+
+    if (sigaction(sig, &act, &old) != 0) {
+        return SIG_ERR;
+    }
+    return old.sa_handler;
+}
+
+int pthread_sigmask(int how, const sigset_t *set, sigset_t *oset) {
+    nk_sigset_t cur = nk_sig_blocked();
+
+    if (oset) {
+        *oset = cur;
+    }
+    if (!set) {
+        return 0;
+    }
+
+    switch (how) {
+    case SIG_BLOCK:   cur |= *set;  break;
+    case SIG_UNBLOCK: cur &= ~*set; break;
+    case SIG_SETMASK: cur = *set;   break;
+    default:          return EINVAL;
+    }
+
+    sig_init();
+    nk_sig_setmask(cur & ~SIG_UNBLOCKABLE);
+    nk_sig_deliver();
+    return 0;
+}
+
+int sigprocmask(int how, const sigset_t *set, sigset_t *oset) {
+    int err = pthread_sigmask(how, set, oset);
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+int sigpending(sigset_t *set) {
+    *set = nk_sig_pending();
+    return 0;
+}
+
+int sigsuspend(const sigset_t *mask) {
+    sig_init();
+    (void)nk_sig_suspend(*mask & ~SIG_UNBLOCKABLE);
+    errno = EINTR;
+    return -1;
+}
+
+int pause(void) {
+    sig_init();
+    (void)nk_sig_suspend(nk_sig_blocked());
+    errno = EINTR;
+    return -1;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * SENDING
+ *═══════════════════════════════════════════════════════════════════*/
+
+int pthread_kill(pthread_t thread, int sig) {
+    if (sig < 0 || sig >= NSIG) {
+        return EINVAL;
+    }
+    uint32_t tid = (uint32_t)thread;   /* negative pids become huge */
+    if (tid > UINT8_MAX) {
+        return ESRCH;
+    }
+
+    sig_init();
+    if (nk_sig_post((uint8_t)tid, (uint8_t)sig) != 0) {
+        return ESRCH;
+    }
+    if (sig && tid == nk_current_tid()) {
+        nk_sig_deliver();
+    }
+    return 0;
+}
+
+int kill(pid_t pid, int sig) {
+    int err = pthread_kill((pthread_t)pid, sig);
+    if (err) {
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+int raise(int sig) {
+    return kill((pid_t)nk_current_tid(), sig);
+}
+
+#else /* !POSIX_SIGNALS */
+
+int sigaction(int sig, const struct sigaction *act, struct sigaction *oact) {
+    (void)sig; (void)act; (void)oact;
+    errno = ENOSYS;
+    return -1;
+}
+
+sighandler_t signal(int sig, sighandler_t handler) {
+    (void)sig; (void)handler;
+    errno = ENOSYS;
+    return SIG_ERR;
+}
+
+int pthread_sigmask(int how, const sigset_t *set, sigset_t *oset) {
+    (void)how; (void)set; (void)oset;
+    return ENOSYS;
+}
+
+int sigprocmask(int how, const sigset_t *set, sigset_t *oset) {
+    (void)how; (void)set; (void)oset;
+    errno = ENOSYS;
+    return -1;
+}
+
+int sigpending(sigset_t *set) {
+    (void)set;
+    errno = ENOSYS;
+    return -1;
+}
+
+int sigsuspend(const sigset_t *mask) {
+    (void)mask;
+    errno = ENOSYS;
+    return -1;
+}
+
+int pause(void) {
+    errno = ENOSYS;
+    return -1;
+}
+
+int pthread_kill(pthread_t thread, int sig) {
+    (void)thread; (void)sig;
+    return ENOSYS;
+}
+
+int kill(pid_t pid, int sig) {
+    (void)pid; (void)sig;
+    errno = ENOSYS;
+    return -1;
+}
+
+int raise(int sig) {
+    (void)sig;
+    errno = ENOSYS;
+    return -1;
+}
+
+#endif /* POSIX_SIGNALS */
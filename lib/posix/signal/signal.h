@@ -0,0 +1,236 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file signal.h
+ * @brief POSIX Signals for Embedded Systems
+ *
+ * kill() and pthread_kill() set a bit in the target task's pending mask
+ * and wake it if it sleeps; that is the whole cost of sending.  The
+ * scheduler tests `pending & ~blocked` as the task resumes and only
+ * then runs handlers, on the task's own stack (see the SIGNALS section
+ * of kernel/sched/scheduler.h).  A signal sent to the calling task is
+ * delivered before kill() returns.
+ *
+ * Profile Support:
+ * - Needs the kernel_signals option; without it every call fails with
+ *   ENOSYS, as the old stubs did.
+ *
+ * Deviations from POSIX.1-2008:
+ * - A pid is a task ID (getpid()), so pid 0 is task 0; there are no
+ *   process groups and negative pids fail with ESRCH.
+ * - Dispositions are shared by all tasks; default "terminate" ends
+ *   only the receiving task (nk_task_exit(128 + sig)), and default
+ *   "stop" suspends it until SIGCONT or SIGKILL.
+ * - No SA_SIGINFO / siginfo_t, no real-time signals, no sigqueue().
+ * - Nothing is interrupted with EINTR: a blocked call resumes after
+ *   the handler, and nanosleep() runs to its deadline.  SA_RESTART is
+ *   accepted and changes nothing.
+ */
+
+#ifndef POSIX_SIGNAL_H
+#define POSIX_SIGNAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../posix_types.h"
+#include "avrix-config.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Signal delivery (follows kernel_signals) */
+#ifndef POSIX_SIGNALS
+#  if defined(CONFIG_KERNEL_SIGNALS)
+#    define POSIX_SIGNALS CONFIG_KERNEL_SIGNALS
+#  else
+#    define POSIX_SIGNALS 0
+#  endif
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * SIGNAL NUMBERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+#define SIGHUP    1
+#define SIGINT    2
+#define SIGQUIT   3
+#define SIGILL    4
+#define SIGTRAP   5
+#define SIGABRT   6
+#define SIGBUS    7
+#define SIGFPE    8
+#define SIGKILL   9     /**< Cannot be caught, blocked or ignored */
+#define SIGUSR1   10
+#define SIGSEGV   11
+#define SIGUSR2   12
+#define SIGPIPE   13
+#define SIGALRM   14
+#define SIGTERM   15
+#define SIGCHLD   17
+#define SIGCONT   18
+#define SIGSTOP   19    /**< Cannot be caught, blocked or ignored */
+#define SIGTSTP   20
+#define SIGURG    23
+#define SIGWINCH  28
+
+/** One more than the highest signal number */
+#define NSIG      33
+
+/*═══════════════════════════════════════════════════════════════════
+ * TYPES
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Signal set, bit (n - 1) for signal n */
+typedef uint32_t sigset_t;
+
+/** Signal handler */
+typedef void (*sighandler_t)(int);
+
+#define SIG_DFL ((sighandler_t)0)   /**< Default action */
+#define SIG_IGN ((sighandler_t)1)   /**< Discard */
+#define SIG_ERR ((sighandler_t)-1)  /**< signal() failure */
+
+#define SA_NODEFER   0x01   /**< Do not block the signal in its handler */
+#define SA_RESETHAND 0x02   /**< Back to SIG_DFL on entry to the handler */
+#define SA_RESTART   0x04   /**< Accepted; calls are never interrupted */
+
+/**
+ * @brief Disposition of a signal
+ */
+struct sigaction {
+    sighandler_t sa_handler;    /**< SIG_DFL, SIG_IGN or a function */
+    sigset_t     sa_mask;       /**< Also blocked while the handler runs */
+    uint8_t      sa_flags;      /**< SA_* */
+};
+
+#define SIG_BLOCK   0   /**< sigprocmask(): add to the mask */
+#define SIG_UNBLOCK 1   /**< sigprocmask(): remove from the mask */
+#define SIG_SETMASK 2   /**< sigprocmask(): replace the mask */
+
+/** Value passed with a timer notification */
+union sigval {
+    int   sival_int;
+    void *sival_ptr;
+};
+
+#define SIGEV_SIGNAL 0  /**< Send sigev_signo to the timer's creator */
+#define SIGEV_NONE   1  /**< No notification (poll timer_gettime()) */
+#define SIGEV_THREAD 2  /**< Call sigev_notify_function */
+
+/**
+ * @brief How a timer reports expiry
+ */
+struct sigevent {
+    int          sigev_notify;                       /**< SIGEV_* */
+    int          sigev_signo;                        /**< SIGEV_SIGNAL */
+    union sigval sigev_value;                        /**< Notify argument */
+    void       (*sigev_notify_function)(union sigval);
+};
+
+/*═══════════════════════════════════════════════════════════════════
+ * SIGNAL SETS
+ *═══════════════════════════════════════════════════════════════════*/
+
+int sigemptyset(sigset_t *set);
+int sigfillset(sigset_t *set);
+
+/** @return 0, or -1 with errno EINVAL for a bad signal number */
+int sigaddset(sigset_t *set, int sig);
+
+/** @return 0, or -1 with errno EINVAL for a bad signal number */
+int sigdelset(sigset_t *set, int sig);
+
+/** @return 1 if @p sig is in @p set, 0 if not, -1 with errno EINVAL */
+int sigismember(const sigset_t *set, int sig);
+
+/*═══════════════════════════════════════════════════════════════════
+ * DISPOSITION AND MASK
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Examine and change a signal's disposition
+ *
+ * @return 0, or -1 with errno EINVAL (bad number, or SIGKILL/SIGSTOP)
+ */
+int sigaction(int sig, const struct sigaction *act, struct sigaction *oact);
+
+/**
+ * @brief sigaction() with just a handler
+ *
+ * @return Previous handler, or SIG_ERR with errno set
+ */
+sighandler_t signal(int sig, sighandler_t handler);
+
+/**
+ * @brief Examine and change the calling task's blocked mask
+ *
+ * Signals it unblocks are delivered before it returns.  SIGKILL and
+ * SIGSTOP are silently left unblocked.
+ *
+ * @return 0, or -1 with errno EINVAL for a bad @p how
+ */
+int sigprocmask(int how, const sigset_t *set, sigset_t *oset);
+
+/**
+ * @brief sigprocmask() for the calling thread
+ *
+ * @return 0, or EINVAL
+ */
+int pthread_sigmask(int how, const sigset_t *set, sigset_t *oset);
+
+/**
+ * @brief Signals pending for the calling task
+ */
+int sigpending(sigset_t *set);
+
+/**
+ * @brief Wait for a signal with @p mask blocked
+ *
+ * @return -1 with errno EINTR once a handler has run
+ */
+int sigsuspend(const sigset_t *mask);
+
+/**
+ * @brief Wait for a signal
+ *
+ * @return -1 with errno EINTR once a handler has run
+ */
+int pause(void);
+
+/*═══════════════════════════════════════════════════════════════════
+ * SENDING
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Send @p sig to task @p pid (ISR-safe unless @p pid is the caller)
+ *
+ * Signal 0 only checks that @p pid exists.
+ *
+ * @return 0, or -1 with errno EINVAL (bad signal) or ESRCH (no such task)
+ */
+int kill(pid_t pid, int sig);
+
+/**
+ * @brief Send @p sig to @p thread
+ *
+ * @return 0, EINVAL or ESRCH
+ */
+int pthread_kill(pthread_t thread, int sig);
+
+/**
+ * @brief Send @p sig to the calling task
+ *
+ * @return 0, or -1 with errno set
+ */
+int raise(int sig);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POSIX_SIGNAL_H */
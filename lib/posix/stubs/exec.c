@@ -14,8 +14,6 @@
 
 #include "../posix_types.h"
 
-extern int errno;
-
 /**
  * @brief Execute a program (NOT SUPPORTED)
  *
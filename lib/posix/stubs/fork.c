@@ -14,10 +14,6 @@
 
 #include "../posix_types.h"
 
-/* Global errno (weak symbol, can be overridden) */
-__attribute__((weak))
-int errno = 0;
-
 /**
  * @brief Create a child process (NOT SUPPORTED)
  *
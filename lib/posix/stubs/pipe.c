@@ -4,38 +4,46 @@
 
 /**
  * @file pipe.c
- * @brief pipe() stub implementation
+ * @brief pipe() on VFS pipes
  *
  * pipe() creates a unidirectional data channel (pipe) that can be used
  * for inter-process communication.
  *
  * POSIX Compliance:
  * - Low-end: Stub (always fails)
- * - Mid-range: Stub (could be implemented with Door RPC)
- * - High-end: Full implementation (future)
+ * - Mid-range / High-end: VFS ring-buffer pipes when fs_max_pipes > 0
  */
 
 #include "../posix_types.h"
-
-extern int errno;
+#include "avrix-config.h"
+#include "drivers/fs/vfs.h"
 
 /**
- * @brief Create a pipe (LIMITED SUPPORT)
+ * @brief Create a pipe
  *
- * Creates a pipe, a unidirectional data channel that can be used
- * for IPC. On embedded systems, this is typically not needed as
- * tasks share the same address space.
+ * pipefd[0] is the read end and pipefd[1] the write end; use them with
+ * vfs_read(), vfs_write() and vfs_close().  Reads block while the pipe
+ * is empty, writes while it is full.
  *
  * @param pipefd Array of two integers for read/write file descriptors
  * @return 0 on success, -1 on error
- * @retval -1 Error, errno set to ENOSYS (stub)
- *
- * @note This is a stub in low/mid-range profiles.
- * @note High-end profiles may implement this in the future.
- * @note Use Door RPC for efficient IPC on mid-range systems.
+ * @retval -1 Error, errno set to EMFILE (no pipe or descriptor free)
+ *            or ENOSYS (built without pipes)
  */
 int pipe(int pipefd[2]) {
+#if CONFIG_FS_ENABLED && VFS_MAX_PIPES > 0
+    if (!pipefd) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (vfs_pipe(pipefd) < 0) {
+        errno = EMFILE;
+        return -1;
+    }
+    return 0;
+#else
     (void)pipefd;
     errno = ENOSYS;  /* Function not implemented */
     return -1;
+#endif
 }
@@ -0,0 +1,443 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file time.c
+ * @brief POSIX clocks, nanosleep() and timers
+ *
+ * Times are handled internally as a tick number plus nanoseconds into
+ * that tick, so nothing needs 64-bit arithmetic beyond the one
+ * hal_cycles_to_ns() conversion.  Tick differences are taken as signed
+ * 32-bit values and wrap freely; relative times are therefore limited to
+ * about 24 days (2^31 ticks).
+ *
+ * A ktimer armed for d ticks fires at the d-th tick boundary, i.e. after
+ * d ticks minus the part of the current tick already gone.  Timers are
+ * armed for the tick count from the start of the current tick, rounded
+ * up, so they never expire early.  nanosleep() uses the same property:
+ * nk_sleep() for the whole ticks left never overshoots the deadline, and
+ * the loop finishes with a microsecond busy-wait on the remainder.
+ */
+
+#include "time.h"
+#include "../posix_timeout.h"
+#include "kernel/sched/scheduler.h"
+#include "kernel/sched/ktimer.h"
+
+#define NS_PER_SEC  1000000000L
+#define NS_PER_TICK (NS_PER_SEC / POSIX_TICK_HZ)
+
+/** Longest relative time in seconds (keeps tick differences signed) */
+#define REL_MAX_S   ((uint32_t)INT32_MAX / POSIX_TICK_HZ - 1u)
+
+/*═══════════════════════════════════════════════════════════════════
+ * TICK + NANOSECOND TIME
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** CLOCK_REALTIME - CLOCK_MONOTONIC (clock_settime()) */
+static struct {
+    uint32_t ticks;
+    uint32_t ns;
+} rt_offset;
+
+static inline bool ts_valid(const struct timespec *ts) {
+    return ts && (int32_t)ts->tv_sec >= 0 &&
+           ts->tv_nsec >= 0 && ts->tv_nsec < NS_PER_SEC;
+}
+
+static inline bool ts_zero(const struct timespec *ts) {
+    return ts->tv_sec == 0 && ts->tv_nsec == 0;
+}
+
+/* Current CLOCK_MONOTONIC as tick + ns into it */
+static uint32_t now_fine(uint32_t *ns) {
+    uint32_t since;
+    uint32_t t = nk_ticks_fine(&since);
+    uint32_t n = hal_cycles_to_ns(since);
+    *ns = n < NS_PER_TICK ? n : NS_PER_TICK - 1;   /* tick counted late */
+    return t;
+}
+
+static uint32_t ts_to_fine(const struct timespec *ts, uint32_t *ns) {
+    *ns = (uint32_t)(ts->tv_nsec % NS_PER_TICK);
+    return (uint32_t)ts->tv_sec * POSIX_TICK_HZ +
+           (uint32_t)(ts->tv_nsec / NS_PER_TICK);
+}
+
+static void fine_to_ts(uint32_t t, uint32_t ns, struct timespec *ts) {
+    ts->tv_sec = (time_t)(t / POSIX_TICK_HZ);
+    ts->tv_nsec = (long)(t % POSIX_TICK_HZ) * NS_PER_TICK + (long)ns;
+}
+
+/* a += b, both tick + ns */
+static uint32_t fine_add(uint32_t a, uint32_t *ans, uint32_t b, uint32_t bns) {
+    *ans += bns;
+    if (*ans >= NS_PER_TICK) {
+        *ans -= NS_PER_TICK;
+        a++;
+    }
+    return a + b;
+}
+
+/* Absolute time on @p clk to an absolute CLOCK_MONOTONIC tick + ns */
+static uint32_t abs_to_mono(clockid_t clk, const struct timespec *ts, uint32_t *ns) {
+    uint32_t t = ts_to_fine(ts, ns);
+    if (clk == CLOCK_REALTIME) {
+        uint32_t s = hal_irq_save();
+        uint32_t ot = rt_offset.ticks, ons = rt_offset.ns;
+        hal_irq_restore(s);
+        if (*ns < ons) {
+            *ns += NS_PER_TICK;
+            t--;
+        }
+        *ns -= ons;
+        t -= ot;
+    }
+    return t;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * CLOCKS
+ *═══════════════════════════════════════════════════════════════════*/
+
+int clock_gettime(clockid_t clk, struct timespec *tp) {
+    if (!tp || (clk != CLOCK_MONOTONIC && clk != CLOCK_REALTIME)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint32_t ns;
+    uint32_t t = now_fine(&ns);
+    if (clk == CLOCK_REALTIME) {
+        uint32_t s = hal_irq_save();
+        t = fine_add(t, &ns, rt_offset.ticks, rt_offset.ns);
+        hal_irq_restore(s);
+    }
+    fine_to_ts(t, ns, tp);
+    return 0;
+}
+
+int clock_settime(clockid_t clk, const struct timespec *tp) {
+    if (clk != CLOCK_REALTIME || !ts_valid(tp)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint32_t ns, now_ns;
+    uint32_t t = ts_to_fine(tp, &ns);
+    uint32_t now = now_fine(&now_ns);
+    if (ns < now_ns) {
+        ns += NS_PER_TICK;
+        t--;
+    }
+
+    uint32_t s = hal_irq_save();
+    rt_offset.ticks = t - now;
+    rt_offset.ns = ns - now_ns;
+    hal_irq_restore(s);
+    return 0;
+}
+
+int clock_getres(clockid_t clk, struct timespec *res) {
+    if (clk != CLOCK_MONOTONIC && clk != CLOCK_REALTIME) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (res) {
+        long ns = (long)(NS_PER_SEC / HAL_CYCLES_HZ);
+        res->tv_sec = 0;
+        res->tv_nsec = ns ? ns : 1;
+    }
+    return 0;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * SLEEP
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Block until CLOCK_MONOTONIC reaches tick @p dt + @p dns */
+static void sleep_until(uint32_t dt, uint32_t dns) {
+    for (;;) {
+        uint32_t ns;
+        uint32_t t = now_fine(&ns);
+        int32_t left = (int32_t)(dt - t);
+        int32_t lns = (int32_t)dns - (int32_t)ns;
+        if (lns < 0) {
+            lns += NS_PER_TICK;
+            left--;
+        }
+        if (left < 0) {
+            return;
+        }
+        if (left == 0) {
+            if (lns) {
+                hal_timer_delay_us(((uint32_t)lns + 999u) / 1000u);
+            }
+            return;
+        }
+        nk_sleep(left > UINT16_MAX ? UINT16_MAX : (uint16_t)left);
+    }
+}
+
+/* Sleep for @p req from now, in chunks that keep tick differences signed */
+static void sleep_rel(const struct timespec *req) {
+    struct timespec r = *req;
+
+    while (!ts_zero(&r)) {
+        struct timespec part = r;
+        if ((uint32_t)part.tv_sec > REL_MAX_S) {
+            part.tv_sec = REL_MAX_S;
+            part.tv_nsec = 0;
+        }
+        r.tv_sec -= part.tv_sec;
+        r.tv_nsec -= part.tv_nsec;
+
+        uint32_t ns, pns;
+        uint32_t t = now_fine(&ns);
+        uint32_t p = ts_to_fine(&part, &pns);
+        t = fine_add(t, &ns, p, pns);
+        sleep_until(t, ns);
+    }
+}
+
+int nanosleep(const struct timespec *req, struct timespec *rem) {
+    if (!ts_valid(req)) {
+        errno = EINVAL;
+        return -1;
+    }
+    sleep_rel(req);
+    if (rem) {
+        rem->tv_sec = 0;
+        rem->tv_nsec = 0;
+    }
+    return 0;
+}
+
+int clock_nanosleep(clockid_t clk, int flags, const struct timespec *req,
+                    struct timespec *rem) {
+    if ((clk != CLOCK_MONOTONIC && clk != CLOCK_REALTIME) || !ts_valid(req)) {
+        return EINVAL;
+    }
+
+    if (flags & TIMER_ABSTIME) {
+        uint32_t ns;
+        uint32_t t = abs_to_mono(clk, req, &ns);
+        sleep_until(t, ns);
+        return 0;
+    }
+    sleep_rel(req);
+    if (rem) {
+        rem->tv_sec = 0;
+        rem->tv_nsec = 0;
+    }
+    return 0;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * TIMERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+typedef struct {
+    nk_timer_t      kt;
+    struct sigevent ev;
+    uint32_t        due;        /**< Tick of the next expiry */
+    uint32_t        left;       /**< Ticks still to arm beyond this one */
+    uint16_t        interval;   /**< Reload in ticks (0 = one-shot) */
+    clockid_t       clock;
+    pid_t           owner;      /**< SIGEV_SIGNAL target */
+    uint8_t         used;
+    volatile uint8_t armed;     /**< An expiry is pending */
+} posix_timer_t;
+
+static posix_timer_t timers[TIMER_MAX];
+
+static posix_timer_t *timer_get(timer_t id) {
+    if (id >= TIMER_MAX || !timers[id].used) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return &timers[id];
+}
+
+/* Arm the next stretch: the last one carries the period, so the
+ * reload happens in the tick rather than after the work queue ran. */
+static void timer_arm(posix_timer_t *pt) {
+    uint16_t chunk = pt->left > UINT16_MAX ? UINT16_MAX : (uint16_t)pt->left;
+    pt->left -= chunk;
+    nk_timer_start(&pt->kt, chunk, pt->left ? 0 : pt->interval);
+}
+
+/* ktimer callback, work queue context */
+static void timer_expire(void *arg) {
+    posix_timer_t *pt = arg;
+
+    if (pt->left) {
+        timer_arm(pt);
+        return;
+    }
+    if (pt->interval) {
+        pt->due += pt->interval;
+    } else {
+        pt->armed = 0;
+    }
+    if (pt->ev.sigev_notify == SIGEV_THREAD) {
+        pt->ev.sigev_notify_function(pt->ev.sigev_value);
+    } else if (pt->ev.sigev_notify == SIGEV_SIGNAL) {
+        (void)kill(pt->owner, pt->ev.sigev_signo);
+    }
+}
+
+static bool sev_valid(const struct sigevent *sev) {
+    switch (sev->sigev_notify) {
+    case SIGEV_NONE:
+        return true;
+    case SIGEV_THREAD:
+        return sev->sigev_notify_function != NULL;
+    case SIGEV_SIGNAL:
+        return POSIX_SIGNALS && sev->sigev_signo > 0 && sev->sigev_signo < NSIG;
+    default:
+        return false;
+    }
+}
+
+int timer_create(clockid_t clk, struct sigevent *sev, timer_t *id) {
+    if (!id || (clk != CLOCK_MONOTONIC && clk != CLOCK_REALTIME) ||
+        (sev && !sev_valid(sev))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint32_t s = nk_sched_lock();
+    for (uint8_t i = 0; i < TIMER_MAX; i++) {
+        posix_timer_t *pt = &timers[i];
+        if (pt->used) {
+            continue;
+        }
+        pt->used = 1;
+        nk_sched_unlock(s);
+
+        nk_timer_init(&pt->kt, timer_expire, pt);
+        if (sev) {
+            pt->ev = *sev;
+        } else {
+            pt->ev.sigev_notify = POSIX_SIGNALS ? SIGEV_SIGNAL : SIGEV_NONE;
+            pt->ev.sigev_signo = SIGALRM;
+        }
+        pt->clock = clk;
+        pt->owner = (pid_t)nk_current_tid();
+        pt->armed = 0;
+        pt->interval = 0;
+        pt->left = 0;
+        *id = i;
+        return 0;
+    }
+    nk_sched_unlock(s);
+    errno = EAGAIN;
+    return -1;
+}
+
+int timer_delete(timer_t id) {
+    posix_timer_t *pt = timer_get(id);
+    if (!pt) {
+        return -1;
+    }
+    nk_timer_stop(&pt->kt);
+    pt->armed = 0;
+    pt->used = 0;
+    return 0;
+}
+
+int timer_gettime(timer_t id, struct itimerspec *value) {
+    posix_timer_t *pt = timer_get(id);
+    if (!pt || !value) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint32_t ns = 0;
+    fine_to_ts(pt->interval, 0, &value->it_interval);
+    if (pt->armed) {
+        uint32_t now = now_fine(&ns);
+        int32_t left = (int32_t)(pt->due - now);
+        if (left > 0) {
+            if (ns) {
+                fine_to_ts((uint32_t)left - 1, NS_PER_TICK - ns, &value->it_value);
+            } else {
+                fine_to_ts((uint32_t)left, 0, &value->it_value);
+            }
+            return 0;
+        }
+        /* Due this tick, the work queue has not run it yet */
+        value->it_value.tv_sec = 0;
+        value->it_value.tv_nsec = 1;
+        return 0;
+    }
+    value->it_value.tv_sec = 0;
+    value->it_value.tv_nsec = 0;
+    return 0;
+}
+
+int timer_settime(timer_t id, int flags, const struct itimerspec *value,
+                  struct itimerspec *ovalue) {
+    posix_timer_t *pt = timer_get(id);
+    if (!pt) {
+        return -1;
+    }
+    if (!value || !ts_valid(&value->it_value) || !ts_valid(&value->it_interval)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* Interval: whole ticks, rounded up, within one ktimer period */
+    uint32_t ins, interval = UINT32_MAX;
+    if ((uint32_t)value->it_interval.tv_sec <= UINT16_MAX / POSIX_TICK_HZ + 1) {
+        interval = ts_to_fine(&value->it_interval, &ins) + (ins ? 1 : 0);
+    }
+    if (interval > UINT16_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (ovalue) {
+        timer_gettime(id, ovalue);
+    }
+    nk_timer_stop(&pt->kt);
+    pt->armed = 0;
+    if (ts_zero(&value->it_value)) {
+        return 0;
+    }
+
+    /* Expiry as an absolute CLOCK_MONOTONIC tick + ns */
+    uint32_t ns;
+    uint32_t now = now_fine(&ns);
+    uint32_t t, tns;
+    if (flags & TIMER_ABSTIME) {
+        t = abs_to_mono(pt->clock, &value->it_value, &tns);
+    } else {
+        if ((uint32_t)value->it_value.tv_sec > REL_MAX_S) {
+            errno = EINVAL;
+            return -1;
+        }
+        tns = ns;
+        t = fine_add(now, &tns, ts_to_fine(&value->it_value, &ins), ins);
+    }
+
+    /* Ticks from now to the first boundary at or after the expiry */
+    int32_t d = (int32_t)(t - now) + (tns ? 1 : 0);
+    if (d < 1) {
+        d = 1;                      /* already past: expire next tick */
+    }
+
+    pt->interval = (uint16_t)interval;
+    pt->due = now + (uint32_t)d;
+    pt->left = (uint32_t)d;
+    pt->armed = 1;
+    timer_arm(pt);
+    return 0;
+}
+
+int timer_getoverrun(timer_t id) {
+    /* Every expiry is posted to the work queue as its own notification */
+    return timer_get(id) ? 0 : -1;
+}
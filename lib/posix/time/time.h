@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file time.h
+ * @brief POSIX Clocks, nanosleep() and Per-Process Timers
+ *
+ * CLOCK_MONOTONIC is the kernel tick count since boot plus the part of
+ * the current tick already elapsed, read from the HAL cycle counter
+ * (nk_ticks_fine()).  Resolution is therefore one CPU cycle on the
+ * targets (62.5 ns at 16 MHz), not one tick; the sub-tick part is
+ * clamped below one tick so the clock never runs backwards across an
+ * interrupt that is late to count the tick.
+ *
+ * nanosleep() blocks in the scheduler for the whole ticks of the
+ * request and busy-waits only the final sub-tick remainder, so a 1.5 ms
+ * sleep costs at most one tick of spinning instead of being rounded to
+ * 2 ms.
+ *
+ * timer_create() timers are kernel software timers (kernel/sched/ktimer)
+ * and fire with tick resolution.  Notification runs from the deferred
+ * work queue, in task context; SIGEV_SIGNAL sends the signal to the
+ * task that created the timer (needs kernel_signals).
+ *
+ * Profile Support:
+ * - All profiles.  On the single-task build nanosleep() waits with
+ *   hal_idle() and timer notifications run from nk_work_run().
+ *
+ * Deviations from POSIX.1-2008:
+ * - CLOCK_REALTIME is CLOCK_MONOTONIC plus an offset that only
+ *   clock_settime() changes; there is no RTC behind it.
+ * - SIGEV_THREAD calls the notify function on the work queue thread
+ *   instead of a new thread; it must not block.
+ * - Timer intervals are limited to 65535 ticks (the first expiry is not).
+ * - nanosleep() is not interrupted; @p rem is always zero.
+ */
+
+#ifndef POSIX_TIME_H
+#define POSIX_TIME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../posix_types.h"
+#include "../signal/signal.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Timers available to timer_create() */
+#ifndef TIMER_MAX
+#define TIMER_MAX 4
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * TYPES
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Clock identifier */
+typedef uint8_t clockid_t;
+
+#define CLOCK_REALTIME  0   /**< Settable wall clock */
+#define CLOCK_MONOTONIC 1   /**< Time since boot, never set */
+
+/** clock_nanosleep() / timer_settime(): the time is absolute */
+#define TIMER_ABSTIME 0x01
+
+/** Timer identifier (slot number) */
+typedef uint8_t timer_t;
+
+/**
+ * @brief Timer period and next expiry
+ */
+struct itimerspec {
+    struct timespec it_interval;    /**< Reload (zero = one-shot) */
+    struct timespec it_value;       /**< Next expiry (zero = disarmed) */
+};
+
+/*═══════════════════════════════════════════════════════════════════
+ * CLOCKS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Read a clock (ISR-safe)
+ *
+ * @return 0, or -1 with errno EINVAL for an unknown clock
+ */
+int clock_gettime(clockid_t clk, struct timespec *tp);
+
+/**
+ * @brief Set CLOCK_REALTIME
+ *
+ * @return 0, or -1 with errno EINVAL for a malformed time or another
+ *         clock
+ */
+int clock_settime(clockid_t clk, const struct timespec *tp);
+
+/**
+ * @brief Resolution of a clock (one hal_cycles() count)
+ *
+ * @return 0, or -1 with errno EINVAL for an unknown clock
+ */
+int clock_getres(clockid_t clk, struct timespec *res);
+
+/*═══════════════════════════════════════════════════════════════════
+ * SLEEP
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Sleep for at least @p req
+ *
+ * @param req Duration
+ * @param rem Set to zero if not NULL
+ * @return 0, or -1 with errno EINVAL if @p req is malformed
+ */
+int nanosleep(const struct timespec *req, struct timespec *rem);
+
+/**
+ * @brief nanosleep() on a given clock, optionally until an absolute time
+ *
+ * @param clk   CLOCK_MONOTONIC or CLOCK_REALTIME
+ * @param flags 0 or TIMER_ABSTIME
+ * @param req   Duration, or deadline with TIMER_ABSTIME
+ * @param rem   Set to zero if not NULL (relative sleeps only)
+ * @return 0, or EINVAL (returned, not set in errno, as POSIX specifies)
+ */
+int clock_nanosleep(clockid_t clk, int flags, const struct timespec *req,
+                    struct timespec *rem);
+
+/*═══════════════════════════════════════════════════════════════════
+ * TIMERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Allocate a timer
+ *
+ * @param clk  Clock that TIMER_ABSTIME values refer to
+ * @param sev  SIGEV_SIGNAL, SIGEV_NONE or SIGEV_THREAD; NULL means
+ *             SIGALRM to the caller, or SIGEV_NONE without signals
+ * @param[out] id Timer identifier
+ * @return 0, or -1 with errno EINVAL on bad arguments, EAGAIN if all
+ *         TIMER_MAX are in use
+ */
+int timer_create(clockid_t clk, struct sigevent *sev, timer_t *id);
+
+/**
+ * @brief Release a timer, disarming it first
+ *
+ * @return 0, or -1 with errno EINVAL for an unknown timer
+ */
+int timer_delete(timer_t id);
+
+/**
+ * @brief Arm or disarm a timer
+ *
+ * A zero it_value disarms.  Times are rounded up to whole ticks.
+ *
+ * @param id    Timer
+ * @param flags 0 or TIMER_ABSTIME (it_value is a time on the timer's clock)
+ * @param value New setting
+ * @param ovalue Previous setting, or NULL
+ * @return 0, or -1 with errno EINVAL for an unknown timer, a malformed
+ *         time or an interval over 65535 ticks
+ */
+int timer_settime(timer_t id, int flags, const struct itimerspec *value,
+                  struct itimerspec *ovalue);
+
+/**
+ * @brief Time to the next expiry and the interval
+ *
+ * @return 0, or -1 with errno EINVAL for an unknown timer
+ */
+int timer_gettime(timer_t id, struct itimerspec *value);
+
+/**
+ * @brief Expiries missed because the notify function was still pending
+ *
+ * @return Count for the last notification, or -1 with errno EINVAL
+ */
+int timer_getoverrun(timer_t id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POSIX_TIME_H */
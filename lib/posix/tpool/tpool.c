@@ -0,0 +1,278 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file tpool.c
+ * @brief Fixed-size thread pool with a lock-free job queue
+ *
+ * Each ring is the bounded MPMC queue of D. Vyukov.  Cell i starts with
+ * seq = i.  A producer that claims position p (CAS on head) finds
+ * seq == p, fills the cell and publishes seq = p + 1.  A consumer that
+ * claims p (CAS on tail) finds seq == p + 1, copies the job out and
+ * frees the cell for the next lap with seq = p + TPOOL_QUEUE_LEN.
+ * Positions are 16-bit and compared as signed differences, so they may
+ * wrap freely.
+ *
+ * Sleeping workers are counted in `sleepers` before they re-check the
+ * rings under the scheduler lock; a producer publishes its job first and
+ * then reads the count, so one of the two always sees the other and no
+ * wake-up is lost.  Producers only take the lock when someone sleeps.
+ */
+
+#include "tpool.h"
+#include "arch/common/hal.h"
+
+_Static_assert((TPOOL_QUEUE_LEN & (TPOOL_QUEUE_LEN - 1)) == 0 &&
+               TPOOL_QUEUE_LEN <= 32768, "TPOOL_QUEUE_LEN must be a power of two");
+
+#define TPOOL_MASK (TPOOL_QUEUE_LEN - 1u)
+
+/*═══════════════════════════════════════════════════════════════════
+ * MPMC RING
+ *═══════════════════════════════════════════════════════════════════*/
+
+static void ring_init(tpool_queue_t *q) {
+    for (uint16_t i = 0; i < TPOOL_QUEUE_LEN; i++) {
+        q->cell[i].seq = i;
+    }
+    q->head = 0;
+    q->tail = 0;
+}
+
+static bool ring_put(tpool_queue_t *q, tpool_fn fn, void *arg, tpool_future_t *f) {
+    uint16_t pos = q->head;
+    tpool_cell_t *c;
+
+    for (;;) {
+        c = &q->cell[pos & TPOOL_MASK];
+        int16_t dif = (int16_t)(c->seq - pos);
+        if (dif == 0) {
+            if (hal_atomic_compare_exchange_u16(&q->head, &pos, (uint16_t)(pos + 1))) {
+                break;
+            }
+        } else if (dif < 0) {
+            return false;               /* full */
+        } else {
+            pos = q->head;              /* another producer got it */
+        }
+    }
+    c->fn = fn;
+    c->arg = arg;
+    c->future = f;
+    hal_memory_barrier();
+    c->seq = (uint16_t)(pos + 1);
+    return true;
+}
+
+static bool ring_take(tpool_queue_t *q, tpool_cell_t *out) {
+    uint16_t pos = q->tail;
+    tpool_cell_t *c;
+
+    for (;;) {
+        c = &q->cell[pos & TPOOL_MASK];
+        int16_t dif = (int16_t)(c->seq - (uint16_t)(pos + 1));
+        if (dif == 0) {
+            if (hal_atomic_compare_exchange_u16(&q->tail, &pos, (uint16_t)(pos + 1))) {
+                break;
+            }
+        } else if (dif < 0) {
+            return false;               /* empty */
+        } else {
+            pos = q->tail;
+        }
+    }
+    out->fn = c->fn;
+    out->arg = c->arg;
+    out->future = c->future;
+    hal_memory_barrier();
+    c->seq = (uint16_t)(pos + TPOOL_QUEUE_LEN);
+    return true;
+}
+
+static inline bool ring_empty(const tpool_queue_t *q) {
+    return q->head == q->tail;
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * WORKERS
+ *═══════════════════════════════════════════════════════════════════*/
+
+/* Own ring first, then (SMP) everyone else's */
+static bool pool_take(tpool_t *pool, uint8_t self, tpool_cell_t *job) {
+#if TPOOL_STEAL
+    for (uint8_t i = 0; i < pool->nworkers; i++) {
+        uint8_t q = (uint8_t)((self + i) % pool->nworkers);
+        if (ring_take(&pool->queue[q], job)) {
+            return true;
+        }
+    }
+    return false;
+#else
+    (void)self;
+    return ring_take(&pool->queue[0], job);
+#endif
+}
+
+static bool pool_empty(const tpool_t *pool) {
+    for (uint8_t i = 0; i < TPOOL_QUEUES; i++) {
+        if (!ring_empty(&pool->queue[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void future_complete(tpool_future_t *f, void *result) {
+    uint32_t s = nk_sched_lock();
+    f->result = result;
+    f->done = 1;
+    nk_waitq_wake_all(&f->waiters);
+    nk_sched_unlock(s);
+}
+
+static void *worker_main(void *arg) {
+    tpool_worker_t *w = arg;
+    tpool_t *pool = w->pool;
+    tpool_cell_t job;
+
+    for (;;) {
+        if (pool_take(pool, w->index, &job)) {
+            void *r = job.fn(job.arg);
+            if (job.future) {
+                future_complete(job.future, r);
+            }
+            continue;
+        }
+
+        uint32_t s = nk_sched_lock();
+        pool->sleepers++;
+        hal_memory_barrier();
+        if (!pool_empty(pool)) {
+            pool->sleepers--;           /* raced with a submit: go again */
+            nk_sched_unlock(s);
+        } else if (pool->stop) {
+            pool->sleepers--;
+            nk_sched_unlock(s);
+            return NULL;
+        } else {
+            nk_waitq_block(&pool->idle);    /* waker takes us off sleepers */
+        }
+    }
+}
+
+/* Under nk_sched_lock() */
+static void wake_workers(tpool_t *pool, bool all) {
+    while (pool->sleepers && nk_waitq_wake_one(&pool->idle) >= 0) {
+        pool->sleepers--;
+        if (!all) break;
+    }
+}
+
+/*═══════════════════════════════════════════════════════════════════
+ * API
+ *═══════════════════════════════════════════════════════════════════*/
+
+int tpool_init(tpool_t *pool, uint8_t nworkers, const pthread_attr_t *attr) {
+    if (!pool || nworkers == 0 || nworkers > TPOOL_WORKERS_MAX) {
+        return EINVAL;
+    }
+
+    for (uint8_t i = 0; i < TPOOL_QUEUES; i++) {
+        ring_init(&pool->queue[i]);
+    }
+    pool->nworkers = 0;
+    pool->next = 0;
+    pool->sleepers = 0;
+    pool->stop = 0;
+    nk_waitq_init(&pool->idle);
+
+    for (uint8_t i = 0; i < nworkers; i++) {
+        tpool_worker_t *w = &pool->worker[i];
+        w->pool = pool;
+        w->index = i;
+        if (pthread_create(&w->thread, attr, worker_main, w) != 0) {
+            tpool_shutdown(pool);
+            return EAGAIN;
+        }
+        pool->nworkers++;
+    }
+    return 0;
+}
+
+int tpool_submit(tpool_t *pool, tpool_fn fn, void *arg, tpool_future_t *future) {
+    if (!pool || !fn || pool->stop) {
+        return EINVAL;
+    }
+    if (future) {
+        future->done = 0;
+    }
+
+    uint8_t q = 0;
+#if TPOOL_STEAL
+    /* A worker keeps its own jobs local; the rest are spread out */
+    pthread_t self = pthread_self();
+    q = (uint8_t)(pool->next++ % pool->nworkers);
+    for (uint8_t i = 0; i < pool->nworkers; i++) {
+        if (pool->worker[i].thread == self) {
+            q = i;
+            break;
+        }
+    }
+    bool queued = false;
+    for (uint8_t i = 0; i < pool->nworkers && !queued; i++) {
+        queued = ring_put(&pool->queue[(q + i) % pool->nworkers], fn, arg, future);
+    }
+    if (!queued) {
+        return EAGAIN;
+    }
+#else
+    if (!ring_put(&pool->queue[q], fn, arg, future)) {
+        return EAGAIN;
+    }
+#endif
+
+    hal_memory_barrier();
+    if (pool->sleepers) {
+        uint32_t s = nk_sched_lock();
+        wake_workers(pool, false);
+        nk_sched_unlock(s);
+    }
+    return 0;
+}
+
+int tpool_shutdown(tpool_t *pool) {
+    if (!pool) {
+        return EINVAL;
+    }
+
+    uint32_t s = nk_sched_lock();
+    pool->stop = 1;
+    wake_workers(pool, true);
+    nk_sched_unlock(s);
+
+    for (uint8_t i = 0; i < pool->nworkers; i++) {
+        pthread_join(pool->worker[i].thread, NULL);
+    }
+    pool->nworkers = 0;
+    return 0;
+}
+
+void tpool_future_init(tpool_future_t *future) {
+    if (!future) {
+        return;
+    }
+    future->result = NULL;
+    future->done = 0;
+    nk_waitq_init(&future->waiters);
+}
+
+void *tpool_future_wait(tpool_future_t *future) {
+    uint32_t s = nk_sched_lock();
+    while (!future->done) {
+        nk_waitq_block(&future->waiters);
+        s = nk_sched_lock();
+    }
+    nk_sched_unlock(s);
+    return future->result;
+}
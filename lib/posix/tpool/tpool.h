@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/**
+ * @file tpool.h
+ * @brief Fixed-size thread pool with a lock-free job queue
+ *
+ * A job is a function and an argument.  Submitting one costs a few
+ * atomic operations on a bounded MPMC ring (Vyukov-style: one sequence
+ * number per cell), instead of the TCB, stack and hal_context_init() of
+ * a thread per job.  Workers are ordinary pthreads started once by
+ * tpool_init(); idle ones sleep on a kernel wait queue, so an empty pool
+ * costs no CPU.
+ *
+ * A job may carry a tpool_future_t, which receives its return value
+ * and can be waited on.  tpool_submit() is safe from ISRs.
+ *
+ * On SMP builds (kernel_smp_cores > 1) every worker has its own ring.
+ * Submissions from a worker go to its own ring, others are spread
+ * round-robin, and a worker that runs dry steals from the other rings
+ * before it sleeps.
+ *
+ * Profile Support:
+ * - Low-end (PSE51): Not available (no threads)
+ * - Mid-range (PSE52) / High-end (PSE54): Available
+ */
+
+#ifndef POSIX_TPOOL_H
+#define POSIX_TPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../pthread/pthread.h"
+#include "kernel/sched/scheduler.h"
+
+/*═══════════════════════════════════════════════════════════════════
+ * CONFIGURATION
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Jobs per ring; a power of two */
+#ifndef TPOOL_QUEUE_LEN
+#define TPOOL_QUEUE_LEN 16
+#endif
+
+/** Workers per pool */
+#ifndef TPOOL_WORKERS_MAX
+#define TPOOL_WORKERS_MAX 4
+#endif
+
+/** Per-worker rings with stealing (follows kernel_smp_cores) */
+#ifndef TPOOL_STEAL
+#  if defined(CONFIG_KERNEL_SMP_CORES) && CONFIG_KERNEL_SMP_CORES > 1
+#    define TPOOL_STEAL 1
+#  else
+#    define TPOOL_STEAL 0
+#  endif
+#endif
+
+/*═══════════════════════════════════════════════════════════════════
+ * TYPES
+ *═══════════════════════════════════════════════════════════════════*/
+
+/** Job function; the return value goes to the job's future */
+typedef void *(*tpool_fn)(void *arg);
+
+/**
+ * @brief Completion of one job (caller-allocated)
+ */
+typedef struct {
+    void *volatile   result;    /**< Job's return value */
+    volatile uint8_t done;      /**< Set once result is valid */
+    nk_waitq_t       waiters;   /**< tpool_future_wait() callers */
+} tpool_future_t;
+
+/** Static initializer for a future */
+#define TPOOL_FUTURE_INIT { NULL, 0, NK_WAITQ_INIT }
+
+typedef struct {
+    volatile uint16_t seq;      /**< Cell state, see tpool.c */
+    tpool_fn          fn;
+    void             *arg;
+    tpool_future_t   *future;
+} tpool_cell_t;
+
+typedef struct {
+    tpool_cell_t      cell[TPOOL_QUEUE_LEN];
+    volatile uint16_t head;     /**< Next position to fill */
+    volatile uint16_t tail;     /**< Next position to take */
+} tpool_queue_t;
+
+#if TPOOL_STEAL
+#  define TPOOL_QUEUES TPOOL_WORKERS_MAX
+#else
+#  define TPOOL_QUEUES 1
+#endif
+
+struct tpool;
+
+typedef struct {
+    struct tpool *pool;
+    pthread_t     thread;
+    uint8_t       index;        /**< Own ring (TPOOL_STEAL) */
+} tpool_worker_t;
+
+/**
+ * @brief Thread pool (caller-allocated)
+ */
+typedef struct tpool {
+    tpool_queue_t     queue[TPOOL_QUEUES];
+    tpool_worker_t    worker[TPOOL_WORKERS_MAX];
+    uint8_t           nworkers;
+    volatile uint8_t  next;     /**< Round-robin ring for outside submits */
+    volatile uint8_t  sleepers; /**< Workers blocked on idle */
+    volatile uint8_t  stop;     /**< tpool_shutdown() called */
+    nk_waitq_t        idle;
+} tpool_t;
+
+/*═══════════════════════════════════════════════════════════════════
+ * API
+ *═══════════════════════════════════════════════════════════════════*/
+
+/**
+ * @brief Start a pool
+ *
+ * @param pool     Pool object
+ * @param nworkers Worker threads, 1 ... TPOOL_WORKERS_MAX
+ * @param attr     Worker thread attributes (priority, stack), or NULL
+ * @return 0, EINVAL on bad arguments, EAGAIN if a worker could not be
+ *         created (those already started are stopped again)
+ */
+int tpool_init(tpool_t *pool, uint8_t nworkers, const pthread_attr_t *attr);
+
+/**
+ * @brief Queue a job (ISR-safe, never blocks)
+ *
+ * @param pool   Pool object
+ * @param fn     Job function
+ * @param arg    Passed to @p fn
+ * @param future Receives the result, or NULL; must not be
+ *               reused before the job has completed
+ * @return 0, EINVAL on bad arguments or a stopped pool, EAGAIN if the
+ *         queue is full
+ */
+int tpool_submit(tpool_t *pool, tpool_fn fn, void *arg, tpool_future_t *future);
+
+/**
+ * @brief Run the queued jobs, then stop and join the workers
+ *
+ * @return 0, or EINVAL if @p pool is NULL
+ */
+int tpool_shutdown(tpool_t *pool);
+
+/**
+ * @brief Prepare a future for (re)use
+ */
+void tpool_future_init(tpool_future_t *future);
+
+/**
+ * @brief Test whether the job has completed
+ */
+static inline bool tpool_future_done(const tpool_future_t *future) {
+    return future->done != 0;
+}
+
+/**
+ * @brief Block until the job has completed
+ *
+ * @return The job's return value
+ */
+void *tpool_future_wait(tpool_future_t *future);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* POSIX_TPOOL_H */
@@ -6,14 +6,11 @@
  * @file sleep.c
  * @brief sleep() and usleep() implementations
  *
- * Provides POSIX sleep functions using the kernel scheduler.
+ * Provides POSIX sleep functions on top of nanosleep().
  */
 
 #include "unistd.h"
-#include "arch/common/hal.h"
-
-/* Forward declaration of kernel sleep function */
-extern void nk_sleep(uint16_t ms);
+#include "../time/time.h"
 
 /**
  * @brief Sleep for specified number of seconds
@@ -24,24 +21,12 @@ extern void nk_sleep(uint16_t ms);
  * @param seconds Number of seconds to sleep
  * @return 0 (cannot be interrupted on this implementation)
  *
- * @note Resolution is limited by system tick (typically 1 ms).
  * @note Sleeps for at least the requested time, may be longer.
  */
 unsigned int sleep(unsigned int seconds) {
-    if (seconds == 0) {
-        return 0;
-    }
-
-    /* Convert seconds to milliseconds */
-    /* Avoid overflow: sleep in 32-second chunks if needed */
-    while (seconds > 32) {
-        nk_sleep(32000);  /* 32 seconds */
-        seconds -= 32;
-    }
-
-    /* Sleep remaining time */
-    nk_sleep((uint16_t)(seconds * 1000));
+    struct timespec req = { (time_t)seconds, 0 };
 
+    nanosleep(&req, NULL);
     return 0;  /* Successfully slept (no signal interruption) */
 }
 
@@ -53,26 +38,14 @@ unsigned int sleep(unsigned int seconds) {
  * @param usec Number of microseconds to sleep
  * @return 0 on success, -1 on error
  *
- * @note Precision depends on profile:
- *       - Low-end: May be stub (returns ENOSYS)
- *       - Mid/high-end: Millisecond precision via scheduler
- * @note For sub-millisecond delays, use hal_timer_delay_us() directly.
+ * @note Whole ticks are slept in the scheduler; only the sub-tick
+ *       remainder is busy-waited (see nanosleep()).
  */
 int usleep(unsigned int usec) {
-    if (usec == 0) {
-        return 0;
-    }
-
-    /* Convert microseconds to milliseconds (round up) */
-    uint16_t ms = (uint16_t)((usec + 999) / 1000);
-
-    if (ms == 0) {
-        /* Sub-millisecond delay: use HAL busy-wait */
-        hal_timer_delay_us(usec);
-    } else {
-        /* Use scheduler sleep for millisecond delays */
-        nk_sleep(ms);
-    }
+    struct timespec req = {
+        (time_t)(usec / 1000000u),
+        (long)(usec % 1000000u) * 1000L
+    };
 
-    return 0;
+    return nanosleep(&req, NULL);
 }
@@ -161,9 +161,8 @@ unsigned int sleep(unsigned int seconds);
  * @param usec Number of microseconds to sleep
  * @return 0 on success, -1 on error
  *
- * @note Mid/high-end profiles: Uses scheduler with ms resolution.
- * @note Low-end profiles: May be a stub (returns ENOSYS).
- * @note Actual resolution depends on system tick frequency.
+ * @note Blocks in the scheduler for whole ticks and busy-waits only the
+ *       sub-tick remainder, so the delay is accurate to about 1 µs.
  */
 int usleep(unsigned int usec);
 
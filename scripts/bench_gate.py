@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""
+------------------------------------------------------------------------
+bench_gate.py ― Cycle-count regression gate for Avrix benchmarks        │
+------------------------------------------------------------------------
+Companion to ``size_gate.py``: where that one rejects flash growth, this
+one rejects slowdowns.  It reads the JSON written by ``sim_bench.py``
+(a list of ``{"mcu", "name", "cycles", "unit"}`` objects) and compares
+every entry with ``tests/bench_baseline.json``::
+
+    {
+     "tolerance": 0.05,
+     "tolerances": { "ctx_switch": 0.02, "romfs_open": 0.10 },
+     "baseline": { "atmega328p": { "ctx_switch": 143, ... }, ... }
+    }
+
+A metric fails when it exceeds its baseline by more than its tolerance
+(the per-metric entry, else the file-wide default, else ``--tolerance``).
+Metrics missing from the baseline are shown as ``new`` and do not fail;
+baseline metrics absent from the run are shown as ``gone``.  A table of
+every comparison is printed either way.
+
+    bench_gate.py --baseline tests/bench_baseline.json results.json
+    bench_gate.py --baseline tests/bench_baseline.json --update results.json
+
+``--update`` folds the run into the baseline instead of checking it, for
+commits that make something deliberately slower (or faster: a lower
+figure is only ever reported, so ratchet the baseline down by hand).
+Exit status is 1 on any regression.  ``main()`` does the work so the
+module may be imported without side effects.
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import sys
+from pathlib import Path
+
+DEFAULT_TOLERANCE = 0.05  # 5 %
+
+
+# ────────────────────────── helpers ───────────────────────────────────
+def load_results(paths: list[Path]) -> list[dict]:
+    """Concatenate the measurement lists stored in *paths*."""
+    results: list[dict] = []
+    for p in paths:
+        results.extend(json.loads(p.read_text()))
+    return results
+
+
+def tolerance_for(base: dict, name: str, default: float) -> float:
+    """Allowed relative growth for metric *name*."""
+    per = base.get('tolerances', {})
+    return float(per.get(name, base.get('tolerance', default)))
+
+
+def compare(base: dict, results: list[dict],
+            default: float) -> tuple[list[tuple], int]:
+    """Return table rows ``(mcu, name, old, new, delta, verdict)`` and
+    the number of regressions."""
+    rows: list[tuple] = []
+    failures = 0
+    seen: set[tuple[str, str]] = set()
+    ref = base.get('baseline', {})
+
+    for r in results:
+        mcu, name, cycles = r['mcu'], r['name'], int(r['cycles'])
+        seen.add((mcu, name))
+        old = ref.get(mcu, {}).get(name)
+        if old is None:
+            rows.append((mcu, name, '-', cycles, '', 'new'))
+            continue
+        tol = tolerance_for(base, name, default)
+        delta = (cycles - old) / old if old else (1.0 if cycles else 0.0)
+        if delta > tol:
+            verdict = f'FAIL (>{tol:.0%})'
+            failures += 1
+        else:
+            verdict = 'ok'
+        rows.append((mcu, name, old, cycles, f'{delta:+.1%}', verdict))
+
+    for mcu, metrics in ref.items():
+        for name, old in metrics.items():
+            if (mcu, name) not in seen:
+                rows.append((mcu, name, old, '-', '', 'gone'))
+    return rows, failures
+
+
+def print_table(rows: list[tuple]) -> None:
+    """Print *rows* as an aligned plain-text table."""
+    head = ('mcu', 'metric', 'baseline', 'cycles', 'delta', '')
+    cells = [head] + [tuple(str(c) for c in r) for r in rows]
+    width = [max(len(r[i]) for r in cells) for i in range(len(head))]
+    for r in cells:
+        print('  '.join(c.ljust(w) for c, w in zip(r, width)).rstrip())
+
+
+def update(base: dict, results: list[dict]) -> dict:
+    """Return *base* with every measured figure replaced by the new one."""
+    ref = base.setdefault('baseline', {})
+    for r in results:
+        ref.setdefault(r['mcu'], {})[r['name']] = int(r['cycles'])
+    for mcu in ref:
+        ref[mcu] = dict(sorted(ref[mcu].items()))
+    return base
+
+
+# ────────────────────────── main routine ─────────────────────────────-
+def main(argv: list[str]) -> int:
+    parser = argparse.ArgumentParser(
+        description='Fail when benchmark cycle counts regress'
+    )
+    parser.add_argument('--baseline', type=Path, required=True,
+                        help='Checked-in baseline JSON')
+    parser.add_argument('--tolerance', type=float, default=DEFAULT_TOLERANCE,
+                        help='Relative growth allowed when the baseline '
+                             'sets none (default: %(default)s)')
+    parser.add_argument('--update', action='store_true',
+                        help='Write the results into the baseline and exit')
+    parser.add_argument('results', type=Path, nargs='+',
+                        help='JSON written by sim_bench.py --json')
+    args = parser.parse_args(argv)
+
+    base = json.loads(args.baseline.read_text())
+    results = load_results(args.results)
+
+    if args.update:
+        args.baseline.write_text(json.dumps(update(base, results),
+                                            indent=1) + '\n')
+        print(f'bench_gate: {len(results)} figures written to '
+              f'{args.baseline}')
+        return 0
+
+    rows, failures = compare(base, results, args.tolerance)
+    print_table(rows)
+    if failures:
+        print(f'bench_gate: {failures} metric(s) regressed', file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -2,6 +2,9 @@
 # ═══════════════════════════════════════════════════════════════════════
 # Flamegraph Generation for Avrix
 # Profiles runtime performance and generates flamegraphs
+#
+#   flamegraph_analysis.sh                  perf on the host test binaries
+#   flamegraph_analysis.sh --avr IMAGE ELF  nk_prof dump from an AVR target
 # ═══════════════════════════════════════════════════════════════════════
 set -euo pipefail
 
@@ -22,8 +25,20 @@ echo -e "${BLUE}  Avrix Performance Profiling & Flamegraph Generation${NC}"
 echo -e "${BLUE}════════════════════════════════════════════════════════════${NC}"
 echo
 
+# --avr IMAGE ELF: draw an nk_prof histogram (debug_prof) instead of perf
+AVR_IMAGE=""
+AVR_ELF=""
+if [ "${1:-}" = "--avr" ]; then
+    if [ $# -ne 3 ]; then
+        echo "usage: $0 --avr IMAGE ELF" >&2
+        exit 2
+    fi
+    AVR_IMAGE="$2"
+    AVR_ELF="$3"
+fi
+
 # Check for perf
-if ! command -v perf &> /dev/null; then
+if [ -z "${AVR_ELF}" ] && ! command -v perf &> /dev/null; then
     echo -e "${RED}✗ perf not found. Install with: sudo apt-get install linux-tools-generic${NC}"
     exit 1
 fi
@@ -128,6 +143,18 @@ else
     fi
 fi
 
+if [ -n "${AVR_ELF}" ]; then
+    name="$(basename "${AVR_ELF}" .elf)"
+    echo -e "${YELLOW}Folding PC samples of ${name}...${NC}"
+    "${SCRIPT_DIR}/prof_fold.py" "${AVR_IMAGE}" "${AVR_ELF}" \
+        -o "${REPORT_DIR}/${name}.folded"
+    "${FLAMEGRAPH_DIR}/flamegraph.pl" --title "${name} (PC samples)" \
+        --countname samples "${REPORT_DIR}/${name}.folded" \
+        > "${REPORT_DIR}/${name}_flamegraph.svg"
+    echo -e "${GREEN}✓ ${REPORT_DIR}/${name}_flamegraph.svg${NC}"
+    exit 0
+fi
+
 # Build for profiling
 echo -e "${YELLOW}[1/4] Building for profiling...${NC}"
 cd "${PROJECT_ROOT}"
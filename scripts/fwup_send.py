@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+------------------------------------------------------------------------
+fwup_send.py ― push a firmware image to the fwup service over UDP      │
+------------------------------------------------------------------------
+Talks to drivers/net/fwup.c (``-Dnet_fwup_enabled=true``) through the
+host's IP stack, so the SLIP line is whatever ``slattach`` (or a
+tun bridge) turned the serial port into::
+
+    slattach -s 115200 -p slip /dev/ttyUSB0 &
+    ifconfig sl0 10.0.0.2 pointopoint 10.0.0.1 up
+    fwup_send.py 10.0.0.1 build_328p/unix0.bin
+
+The sender keeps as many bytes in flight as the last acknowledgement's
+credit allows, goes back to ``next`` whenever an acknowledgement shows a
+gap, and resends from there after ``--timeout`` seconds of silence.
+COMMIT is repeated while the device still programs pages; the image
+boots after the next reset once it answers OK.
+
+``main()`` does the work so the module may be imported without side
+effects.
+"""
+from __future__ import annotations
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import time
+import zlib
+from pathlib import Path
+
+HDR = struct.Struct('!BBHII')           # fwup_hdr_t
+OP_START, OP_DATA, OP_COMMIT, OP_ABORT, OP_ACK = 1, 2, 3, 4, 0x80
+STATUS = ('ok', 'busy', 'no such session', 'image too large',
+          'CRC mismatch', 'flash error', 'bad request', 'resend')
+ST_BUSY, ST_RESEND = 1, 7
+MAX_DATA = 576 - 20 - 8 - HDR.size       # FWUP_MAX_DATA
+
+
+class Failed(Exception):
+    pass
+
+
+class Sender:
+    def __init__(self, host: str, port: int, timeout: float):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.connect((host, port))
+        self.timeout = timeout
+        self.session = random.randrange(1, 0x10000)
+
+    def send(self, op: int, off: int = 0, arg: int = 0, data: bytes = b'') -> None:
+        self.sock.send(HDR.pack(op, 0, self.session, off, arg) + data)
+
+    def ack(self, wait: float) -> tuple[int, int, int] | None:
+        """(status, next, credit) of the next acknowledgement, or None."""
+        self.sock.settimeout(wait)
+        while True:
+            try:
+                pkt = self.sock.recv(64)
+            except socket.timeout:
+                return None
+            if len(pkt) >= HDR.size:
+                op, st, session, nxt, credit = HDR.unpack_from(pkt)
+                if op == OP_ACK and session == self.session:
+                    return st, nxt, credit
+
+    def request(self, op: int, off: int = 0, arg: int = 0) -> tuple[int, int, int]:
+        for _ in range(10):
+            self.send(op, off, arg)
+            a = self.ack(self.timeout)
+            if a:
+                return a
+        raise Failed('no answer')
+
+    def push(self, image: bytes, chunk: int, quiet: bool) -> None:
+        crc = zlib.crc32(image)                 # nk_crc32(0, ...)
+        st, nxt, credit = self.request(OP_START, len(image), crc)
+        if st:
+            raise Failed(STATUS[st] if st < len(STATUS) else f'status {st}')
+        t0 = time.monotonic()
+        sent = nxt
+        while nxt < len(image):
+            limit = nxt + credit
+            sent = max(sent, nxt)
+            while sent < limit:
+                n = min(chunk, limit - sent)
+                self.send(OP_DATA, sent, 0, image[sent:sent + n])
+                sent += n
+            a = self.ack(self.timeout)
+            if a is None:
+                a = self.request(OP_START, len(image), crc)     # where is it?
+                sent = a[1]
+            st, ack_next, credit = a
+            if st == ST_RESEND:
+                sent = ack_next                                 # a gap: go back
+            elif st:
+                raise Failed(STATUS[st] if st < len(STATUS) else f'status {st}')
+            nxt = ack_next
+            if not quiet:
+                rate = nxt / max(time.monotonic() - t0, 1e-6)
+                print(f'\r{nxt}/{len(image)} bytes, {rate:.0f} B/s', end='', file=sys.stderr)
+        if not quiet:
+            print(file=sys.stderr)
+        while True:
+            st, _, _ = self.request(OP_COMMIT)
+            if st != ST_BUSY:
+                break
+            time.sleep(0.01)
+        if st:
+            raise Failed(STATUS[st] if st < len(STATUS) else f'status {st}')
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[2])
+    ap.add_argument('host', help='device address')
+    ap.add_argument('image', type=Path, help='raw binary (objcopy -O binary)')
+    ap.add_argument('-p', '--port', type=int, default=6970, help='net_fwup_port')
+    ap.add_argument('-c', '--chunk', type=int, default=MAX_DATA,
+                    help=f'image bytes per datagram (at most {MAX_DATA})')
+    ap.add_argument('-t', '--timeout', type=float, default=0.5,
+                    help='seconds without an answer before resending')
+    ap.add_argument('-q', '--quiet', action='store_true')
+    args = ap.parse_args()
+
+    image = args.image.read_bytes()
+    if not image or not 0 < args.chunk <= MAX_DATA:
+        ap.error('empty image or bad --chunk')
+    s = Sender(args.host, args.port, args.timeout)
+    try:
+        s.push(image, args.chunk, args.quiet)
+    except (Failed, OSError) as e:
+        print(f'fwup_send: {e}', file=sys.stderr)
+        try:
+            s.send(OP_ABORT)
+        except OSError:
+            pass
+        return 1
+    if not args.quiet:
+        print('committed: boots after the next reset', file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,200 @@
+#!/usr/bin/env python3
+"""
+------------------------------------------------------------------------
+gdb_fetch.py ― pull nk_trace / nk_prof / nk_log images off the GDB stub │
+------------------------------------------------------------------------
+Speaks just enough of the GDB remote protocol to the on-device stub
+(``-Ddebug_gdb=true``, src/avr_gdbstub.c) to copy a debug image to a
+file, faster than ``dump binary value`` from avr-gdb:
+
+* ``QStartNoAckMode`` drops the per-packet acknowledgements,
+* ``QBaud`` raises the line rate when the firmware installed a hook,
+* ``qXfer:nk:read:<image>`` moves the image as escaped binary instead
+  of hex, and the stub run-length encodes the replies.
+
+The link is a serial port, or ``host:port`` for a TCP bridge::
+
+    gdb_fetch.py /dev/ttyUSB0 trace -o trace.bin --baud 1000000
+    trace_decode.py trace.bin -o trace.json
+
+``main()`` does the work so the module may be imported without side
+effects.
+"""
+from __future__ import annotations
+
+import argparse
+import os
+import socket
+import sys
+import termios
+import time
+from pathlib import Path
+
+IMAGES = ('trace', 'prof', 'log')
+CHUNK = 0x400
+
+
+# ────────────────────────── link ─────────────────────────────────────
+class Link:
+    """A serial port or TCP socket carrying RSP bytes."""
+
+    def __init__(self, target: str, baud: int):
+        self.sock = None
+        self.fd = -1
+        host, _, port = target.rpartition(':')
+        if host and port.isdigit() and not os.path.exists(target):
+            self.sock = socket.create_connection((host, int(port)), 5)
+        else:
+            self.fd = os.open(target, os.O_RDWR | os.O_NOCTTY)
+            self.set_baud(baud)
+        self.pending = bytearray()
+
+    def set_baud(self, baud: int) -> None:
+        if self.fd < 0:
+            return
+        speed = getattr(termios, f'B{baud}', None)
+        if speed is None:
+            raise ValueError(f'{baud} baud not supported by termios')
+        a = termios.tcgetattr(self.fd)
+        a[0] = 0                                    # iflag: raw
+        a[1] = 0                                    # oflag
+        a[2] = termios.CS8 | termios.CREAD | termios.CLOCAL
+        a[3] = 0                                    # lflag
+        a[4] = a[5] = speed
+        a[6][termios.VMIN] = 1
+        a[6][termios.VTIME] = 0
+        termios.tcsetattr(self.fd, termios.TCSADRAIN, a)
+
+    def write(self, data: bytes) -> None:
+        if self.sock:
+            self.sock.sendall(data)
+        else:
+            os.write(self.fd, data)
+
+    def read(self) -> int:
+        while not self.pending:
+            chunk = self.sock.recv(4096) if self.sock else os.read(self.fd, 4096)
+            if not chunk:
+                raise OSError('link closed')
+            self.pending += chunk
+        return self.pending.pop(0)
+
+
+# ────────────────────────── protocol ──────────────────────────────────
+class Remote:
+    """Packet layer: checksums, acks, run-length and binary escapes."""
+
+    def __init__(self, link: Link):
+        self.link = link
+        self.ack = True
+
+    def send(self, body: bytes) -> None:
+        frame = b'$' + body + b'#%02x' % (sum(body) & 0xFF)
+        while True:
+            self.link.write(frame)
+            if not self.ack:
+                return
+            c = self.link.read()
+            while c not in (ord('+'), ord('-')):
+                c = self.link.read()
+            if c == ord('+'):
+                return
+
+    def recv(self) -> bytes:
+        while self.link.read() != ord('$'):
+            pass
+        raw = bytearray()
+        while (c := self.link.read()) != ord('#'):
+            raw.append(c)
+        want = int(bytes([self.link.read(), self.link.read()]), 16)
+        if sum(raw) & 0xFF != want:
+            if self.ack:
+                self.link.write(b'-')
+                return self.recv()
+            raise ValueError('bad checksum in no-ack mode')
+        if self.ack:
+            self.link.write(b'+')
+        body = bytearray()
+        i = 0
+        while i < len(raw):
+            if raw[i] == ord('*'):
+                body += bytes([body[-1]]) * (raw[i + 1] - 29)
+                i += 2
+            else:
+                body.append(raw[i])
+                i += 1
+        return bytes(body)
+
+    def command(self, body: str) -> bytes:
+        self.send(body.encode())
+        return self.recv()
+
+
+def unescape(data: bytes) -> bytes:
+    """Undo the '}' escapes of a binary reply."""
+    out, esc = bytearray(), False
+    for b in data:
+        if esc:
+            out.append(b ^ 0x20)
+            esc = False
+        elif b == ord('}'):
+            esc = True
+        else:
+            out.append(b)
+    return bytes(out)
+
+
+def fetch(remote: Remote, image: str) -> bytes:
+    """Read a whole image with qXfer."""
+    data = bytearray()
+    while True:
+        r = remote.command(f'qXfer:nk:read:{image}:{len(data):x},{CHUNK:x}')
+        if r[:1] not in (b'm', b'l'):
+            raise ValueError(f'{image}: stub replied {r.decode(errors="replace")!r}'
+                             ' (built without it?)')
+        data += unescape(r[1:])
+        if r[:1] == b'l':
+            return bytes(data)
+
+
+# ────────────────────────── main routine ─────────────────────────────-
+def main(argv: list[str]) -> int:
+    parser = argparse.ArgumentParser(
+        description='Copy a debug image off the on-device GDB stub'
+    )
+    parser.add_argument('target', help='Serial device or host:port')
+    parser.add_argument('image', choices=IMAGES)
+    parser.add_argument('-o', '--output', type=Path, required=True)
+    parser.add_argument('--line', type=int, default=115200,
+                        help='Current line rate (default: 115200)')
+    parser.add_argument('--baud', type=int, default=0,
+                        help='Ask the stub to switch to this rate first')
+    args = parser.parse_args(argv)
+
+    try:
+        link = Link(args.target, args.line)
+        remote = Remote(link)
+        if b'QStartNoAckMode+' in remote.command('qSupported'):
+            if remote.command('QStartNoAckMode') == b'OK':
+                remote.ack = False
+        if args.baud:
+            r = remote.command(f'QBaud:{args.baud:x}')
+            if r != b'OK':
+                raise ValueError(f'QBaud refused ({r.decode()})')
+            time.sleep(0.01)                # Stub drains, then retunes
+            link.set_baud(args.baud)
+        t0 = time.monotonic()
+        data = fetch(remote, args.image)
+        dt = time.monotonic() - t0
+    except (OSError, ValueError) as e:
+        print(f'gdb_fetch: {e}', file=sys.stderr)
+        return 1
+
+    args.output.write_bytes(data)
+    print(f'gdb_fetch: {args.image}: {len(data)} bytes in {dt:.2f} s '
+          f'-> {args.output}')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
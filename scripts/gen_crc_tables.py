@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+------------------------------------------------------------------------
+gen_crc_tables.py ― lookup tables for kernel/lib/nk_crc.c             │
+------------------------------------------------------------------------
+Writes ``nk_crc_tables.h`` with every table the CRC engine can use, one
+``#if`` per width and strategy, so the build keeps only the ones that
+``NK_CRC8_STRATEGY`` / ``NK_CRC16_STRATEGY`` / ``NK_CRC32_STRATEGY``
+select.  The tables are ``HAL_PROGMEM``:
+
+* nibble:  16 entries,         processes 4 bits per lookup
+* byte:    256 entries,        one lookup per byte
+* slice4:  4 x 256 entries,    four bytes per step (Sarwate, sliced)
+
+Models (the same ones ``nk_crc.h`` documents):
+
+* CRC-8/MAXIM   poly 0x31 reflected (0x8C), init 0
+* CRC-16/CCITT  poly 0x1021, MSB first, init supplied by the caller
+* CRC-32/IEEE   poly 0x04C11DB7 reflected (0xEDB88320), zlib chaining
+
+Usage: ``gen_crc_tables.py OUT_HEADER``
+"""
+from __future__ import annotations
+
+import argparse
+import sys
+from pathlib import Path
+
+# Strategy numbers, as in nk_crc.h
+NIBBLE, BYTE, SLICE4 = 1, 2, 3
+
+# name, width, polynomial as shifted, reflected?
+MODELS = (
+    ('crc8', 8, 0x8C, True),
+    ('crc16', 16, 0x1021, False),
+    ('crc32', 32, 0xEDB88320, True),
+)
+
+
+# ────────────────────────── table maths ──────────────────────────────
+def step(crc: int, bits: int, width: int, poly: int, refl: bool) -> int:
+    """Clock @bits zero bits through the register."""
+    mask = (1 << width) - 1
+    for _ in range(bits):
+        if refl:
+            crc = (crc >> 1) ^ poly if crc & 1 else crc >> 1
+        else:
+            top = crc & (1 << (width - 1))
+            crc = ((crc << 1) ^ poly if top else crc << 1) & mask
+    return crc
+
+
+def table(entries: int, width: int, poly: int, refl: bool) -> list[int]:
+    """Register effect of each index, for log2(entries) input bits."""
+    bits = entries.bit_length() - 1
+    shift = 0 if refl else width - bits
+    return [step(i << shift, bits, width, poly, refl) for i in range(entries)]
+
+
+def slices(width: int, poly: int, refl: bool) -> list[list[int]]:
+    """T[k][n]: byte n followed by k zero bytes."""
+    mask = (1 << width) - 1
+    t = [table(256, width, poly, refl)]
+    for _ in range(3):
+        prev = t[-1]
+        if width == 8:
+            t.append([t[0][v] for v in prev])
+        elif refl:
+            t.append([(v >> 8) ^ t[0][v & 0xFF] for v in prev])
+        else:
+            t.append([((v << 8) & mask) ^ t[0][v >> (width - 8)] for v in prev])
+    return t
+
+
+# ────────────────────────── output ───────────────────────────────────
+def c_array(name: str, width: int, values: list[int]) -> str:
+    digits = width // 4
+    per = {8: 12, 16: 8, 32: 6}[width]
+    rows = []
+    for i in range(0, len(values), per):
+        rows.append('    ' + ', '.join(f'0x{v:0{digits}X}' for v in values[i:i + per]) + ',')
+    return (f'static const uint{width}_t {name} HAL_PROGMEM = {{\n'
+            + '\n'.join(rows) + '\n};\n')
+
+
+def render() -> str:
+    out = ['/* Generated by scripts/gen_crc_tables.py -- do not edit */',
+           '',
+           '#ifndef NK_CRC_TABLES_H',
+           '#define NK_CRC_TABLES_H',
+           '']
+    for name, width, poly, refl in MODELS:
+        sel = f'NK_{name.upper()}_STRATEGY'
+        out.append(f'#if {sel} == NK_CRC_NIBBLE')
+        out.append(c_array(f'{name}_nibble[16]', width, table(16, width, poly, refl)))
+        out.append(f'#elif {sel} == NK_CRC_BYTE')
+        out.append(c_array(f'{name}_byte[256]', width, table(256, width, poly, refl)))
+        out.append(f'#elif {sel} == NK_CRC_SLICE4')
+        flat = [v for t in slices(width, poly, refl) for v in t]
+        out.append(c_array(f'{name}_slice[4 * 256]', width, flat))
+        out.append(f'#endif /* {sel} */')
+        out.append('')
+    out.append('#endif /* NK_CRC_TABLES_H */')
+    return '\n'.join(out) + '\n'
+
+
+# ────────────────────────── main routine ─────────────────────────────
+def main(argv: list[str]) -> int:
+    parser = argparse.ArgumentParser(
+        description='Write the lookup tables for kernel/lib/nk_crc.c'
+    )
+    parser.add_argument('output', type=Path,
+                        help='Header to write (nk_crc_tables.h)')
+    args = parser.parse_args(argv)
+
+    out = args.output
+    text = render()
+    if not out.exists() or out.read_text() != text:
+        out.write_text(text)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+"""
+------------------------------------------------------------------------
+log_decode.py ― nk_log records + ELF → text                             │
+------------------------------------------------------------------------
+Formats the deferred log of ``kernel/sync/nk_log.h`` (built with
+``-Ddebug_log=true``) on the host.  Each record carries the address of
+its format string; the string is read out of the firmware ELF, so the
+target never runs printf.
+
+The input is any of
+
+* a SLIP capture of the frames a drain task sent with
+  ``slip_send_packet(&uart, buf, nk_log_read(0, buf, sizeof buf))``,
+* the same records written back to back into a file,
+* or the ``nk_log_buf`` image dumped from the debugger, whose unread
+  bytes are decoded per core::
+
+      (gdb) dump binary value log.bin nk_log_buf
+
+The ID width follows the ELF: two bytes for AVR, four otherwise.
+
+    log_decode.py build_328p/unix0.elf capture.slip
+    log_decode.py --follow build_328p/unix0.elf /dev/ttyUSB0
+
+``main()`` does the work so the module may be imported without side
+effects.
+"""
+from __future__ import annotations
+
+import argparse
+import re
+import struct
+import sys
+from pathlib import Path
+
+MAGIC = 0x474C4B4E          # "NKLG"
+VERSION = 1
+HEADER = struct.Struct('<IBBH')
+RING = struct.Struct('<HHHH')
+
+ID_DROPPED = 0
+EM_AVR = 83
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+SLIP_END, SLIP_ESC, SLIP_ESC_END, SLIP_ESC_ESC = 0xC0, 0xDB, 0xDC, 0xDD
+
+# printf conversions: flags, width, precision, length, conversion
+CONV = re.compile(r'%([-+ #0]*)(\d+|\*)?(?:\.(\d+))?(hh|h|ll|l|j|z|t)?([diouxXcsp%])')
+
+
+# ────────────────────────── ELF ───────────────────────────────────────
+class Elf:
+    """Just enough of an ELF reader to fetch strings by address."""
+
+    def __init__(self, path: Path):
+        data = path.read_bytes()
+        if data[:4] != b'\x7fELF':
+            raise ValueError(f'{path}: not an ELF file')
+        wide = data[4] == 2
+        if data[5] != 1:
+            raise ValueError(f'{path}: big-endian ELF not supported')
+        self.machine = struct.unpack_from('<H', data, 18)[0]
+        if wide:
+            shoff, = struct.unpack_from('<Q', data, 0x28)
+            shentsize, shnum = struct.unpack_from('<HH', data, 0x3A)
+            sh = struct.Struct('<IIQQQQIIQQ')
+        else:
+            shoff, = struct.unpack_from('<I', data, 0x20)
+            shentsize, shnum = struct.unpack_from('<HH', data, 0x2E)
+            sh = struct.Struct('<IIIIIIIIII')
+        self.sections = []
+        for i in range(shnum):
+            f = sh.unpack_from(data, shoff + i * shentsize)
+            typ, flags, addr, off, size = f[1], f[2], f[3], f[4], f[5]
+            if flags & SHF_ALLOC and typ != SHT_NOBITS and size:
+                self.sections.append((addr, data[off:off + size]))
+        self.id_bytes = 2 if self.machine == EM_AVR else 4
+
+    def string(self, addr: int) -> str | None:
+        """The NUL-terminated string at *addr*, or None."""
+        for base, blob in self.sections:
+            if base <= addr < base + len(blob):
+                end = blob.find(b'\0', addr - base)
+                raw = blob[addr - base:end if end >= 0 else None]
+                return raw.decode('utf-8', 'replace')
+        return None
+
+
+# ────────────────────────── input ─────────────────────────────────────
+def slip_frames(data: bytes) -> list[bytes]:
+    """Split a SLIP byte stream into decoded frames."""
+    frames, cur, esc = [], bytearray(), False
+    for b in data:
+        if esc:
+            cur.append({SLIP_ESC_END: SLIP_END, SLIP_ESC_ESC: SLIP_ESC}.get(b, b))
+            esc = False
+        elif b == SLIP_ESC:
+            esc = True
+        elif b == SLIP_END:
+            if cur:
+                frames.append(bytes(cur))
+            cur = bytearray()
+        else:
+            cur.append(b)
+    if cur:
+        frames.append(bytes(cur))
+    return frames
+
+
+def image_streams(img: bytes) -> list[bytes]:
+    """Unread bytes of each ring of an nk_log_buf image."""
+    magic, version, cores, size = HEADER.unpack_from(img)
+    if version != VERSION:
+        raise ValueError(f'log version {version}, expected {VERSION}')
+    base = HEADER.size + cores * RING.size
+    if len(img) < base + cores * size:
+        raise ValueError('image truncated')
+    out = []
+    for c in range(cores):
+        head, tail, _, _ = RING.unpack_from(img, HEADER.size + c * RING.size)
+        ring = img[base + c * size:base + (c + 1) * size]
+        n = (head - tail) & 0xFFFF
+        out.append(bytes(ring[(tail + k) % size] for k in range(min(n, size))))
+    return out
+
+
+def streams(data: bytes) -> list[bytes]:
+    """Record streams in *data*: image rings, SLIP frames or raw."""
+    if len(data) >= HEADER.size and HEADER.unpack_from(data)[0] == MAGIC:
+        return image_streams(data)
+    if SLIP_END in data:
+        return slip_frames(data)
+    return [data]
+
+
+# ────────────────────────── formatting ────────────────────────────────
+def records(stream: bytes, id_bytes: int):
+    """Yield (id, [(value, size), ...]) from a record stream."""
+    pos = 0
+    while pos + id_bytes + 1 <= len(stream):
+        rid = int.from_bytes(stream[pos:pos + id_bytes], 'little')
+        sizes = stream[pos + id_bytes]
+        pos += id_bytes + 1
+        args = []
+        for k in range(4):
+            code = (sizes >> (2 * k)) & 3
+            if code:
+                n = 1 << code
+                args.append((int.from_bytes(stream[pos:pos + n], 'little'), n))
+                pos += n
+        if pos > len(stream):
+            return                      # cut off mid-record
+        yield rid, args
+
+
+def cformat(fmt: str, args: list[tuple[int, int]]) -> str:
+    """Apply a printf format to raw integer arguments."""
+    it = iter(args)
+
+    def conv(m: re.Match) -> str:
+        flags, width, prec, _, c = m.groups()
+        if c == '%':
+            return '%'
+        try:
+            v, n = next(it)
+        except StopIteration:
+            return m.group(0)
+        if c in 'di' and v >= 1 << (8 * n - 1):
+            v -= 1 << (8 * n)           # sign from the stored size
+        spec = '%' + flags + (width or '') + ('.' + prec if prec else '')
+        if c in 'diu':
+            return (spec + 'd') % v
+        if c in 'oxX':
+            return (spec + c) % v
+        if c == 'c':
+            return (spec + 'c') % chr(v & 0xFF)
+        return (spec + 's') % f'0x{v:x}'    # %p, or %s: only its address
+    return CONV.sub(conv, fmt)
+
+
+def decode(stream: bytes, elf: Elf) -> list[str]:
+    """Text lines for one record stream."""
+    lines = []
+    for rid, args in records(stream, elf.id_bytes):
+        if rid == ID_DROPPED:
+            lines.append(f'[{args[0][0] if args else "?"} records lost]')
+            continue
+        fmt = elf.string(rid)
+        if fmt is None:
+            vals = ' '.join(f'0x{v:x}' for v, _ in args)
+            lines.append(f'[unknown format 0x{rid:x}] {vals}'.rstrip())
+        else:
+            lines.append(cformat(fmt, args))
+    return lines
+
+
+# ────────────────────────── main routine ─────────────────────────────-
+def main(argv: list[str]) -> int:
+    parser = argparse.ArgumentParser(
+        description='Print nk_log records using the format strings in the ELF'
+    )
+    parser.add_argument('elf', type=Path, help='Firmware that logged')
+    parser.add_argument('input', type=Path,
+                        help='SLIP capture, raw records or nk_log_buf dump')
+    parser.add_argument('--follow', action='store_true',
+                        help='Keep reading SLIP frames (e.g. a serial port)')
+    args = parser.parse_args(argv)
+
+    try:
+        elf = Elf(args.elf)
+        if args.follow:
+            with open(args.input, 'rb', buffering=0) as f:
+                buf = bytearray()
+                while chunk := f.read(64):
+                    buf += chunk
+                    *done, rest = bytes(buf).split(bytes([SLIP_END]))
+                    buf = bytearray(rest)
+                    for frame in slip_frames(bytes([SLIP_END]).join(done)):
+                        for line in decode(frame, elf):
+                            print(line, flush=True)
+            return 0
+        found = streams(args.input.read_bytes())
+    except (ValueError, OSError) as e:
+        print(f'log_decode: {e}', file=sys.stderr)
+        return 1
+
+    for s in found:
+        for line in decode(s, elf):
+            print(line)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+"""Turn a host directory into ROMFS tables (``romfs_image.h``).
+
+The output defines the PROGMEM tables ``drivers/fs/romfs.c`` expects:
+``file_table[]``, ``dir_table[]`` and ``ROMFS_ROOT`` (see the IMAGE
+FORMAT section of ``drivers/fs/romfs.h``).
+
+* Every directory is emitted with ``ROMFS_DIR_SORTED``: entries are in
+  byte order of their UTF-8 names, so ``romfs_open()`` binary-searches.
+* Files with identical contents share one data array and file_table
+  slot, and identical names (``README`` in several directories) share
+  one string.
+* File data is aligned to ``--align`` bytes so ``hal_memcpy_P`` can copy
+  whole words on targets that care (the attribute is harmless on AVR).
+* File data is declared ``ROMFS_DATA``; with ``ROMFS_FAR`` on an ELPM
+  part that is far flash and ``file_table[]`` is written as asm rows
+  (see FAR IMAGES in ``romfs.h``), so one header serves every build.
+* ``--compress`` stores each file as LZSS blocks (``ROMFS_FILE_LZ``, see
+  the COMPRESSED FILES section of ``romfs.h``) when that is smaller.
+  ``--lz-window`` must not exceed the target's ``ROMFS_LZ_WINDOW_BITS``.
+
+Usage: ``mkromfs.py SRC_DIR OUT_HEADER [--align N] [--compress]
+[--lz-window BITS] [--lz-block BITS]``
+"""
+from __future__ import annotations
+
+import argparse
+import hashlib
+import sys
+from pathlib import Path
+
+MAX_SIZE = 0xFFFF     # romfs_file_t.size
+MAX_INDEX = 0xFFFF    # romfs_entry_t.idx / romfs_dir_t.count
+LZ_MIN_MATCH = 3
+
+
+def lz_block(block: bytes, wbits: int) -> bytes:
+    """Greedy LZSS of one block; matches never reach before its start."""
+    window = 1 << wbits
+    max_len = LZ_MIN_MATCH + (1 << (16 - wbits)) - 1
+    out = bytearray()
+    i = 0
+    while i < len(block):
+        ctrl_at = len(out)
+        out.append(0)
+        for bit in range(8):
+            if i >= len(block):
+                break
+            best_len, best_dist = 0, 0
+            limit = min(max_len, len(block) - i)
+            for dist in range(1, min(window, i) + 1):
+                n = 0
+                while n < limit and block[i + n] == block[i + n - dist]:
+                    n += 1
+                if n > best_len:
+                    best_len, best_dist = n, dist
+                    if n == limit:
+                        break
+            if best_len >= LZ_MIN_MATCH:
+                word = (best_dist - 1) | ((best_len - LZ_MIN_MATCH) << wbits)
+                out += word.to_bytes(2, 'little')
+                i += best_len
+            else:
+                out[ctrl_at] |= 1 << bit
+                out.append(block[i])
+                i += 1
+    return bytes(out)
+
+
+def lz_compress(data: bytes, wbits: int, block_shift: int) -> bytes:
+    """ROMFS_FILE_LZ layout: header, block start table, blocks."""
+    size = 1 << block_shift
+    blocks = [lz_block(data[i:i + size], wbits) for i in range(0, len(data), size)]
+    starts, pos = [], 0
+    for b in blocks[:-1]:
+        pos += len(b)
+        if pos > 0xFFFF:
+            raise SystemExit('mkromfs: compressed stream too long')
+        starts.append(pos)
+    head = bytes([block_shift, wbits]) + b''.join(s.to_bytes(2, 'little') for s in starts)
+    return head + b''.join(blocks)
+
+
+def lz_expand(blob: bytes, size: int) -> bytes:
+    """Reference decoder (mirrors lz_decode() in romfs.c)."""
+    shift, wbits = blob[0], blob[1]
+    nblocks = (size + (1 << shift) - 1) >> shift
+    pos = 2 + 2 * (nblocks - 1)
+    out = bytearray()
+    while len(out) < size:
+        end = min(size, len(out) + (1 << shift))
+        start = len(out)
+        while len(out) < end:
+            ctrl = blob[pos]
+            pos += 1
+            for bit in range(8):
+                if len(out) >= end:
+                    break
+                if ctrl >> bit & 1:
+                    out.append(blob[pos])
+                    pos += 1
+                else:
+                    word = int.from_bytes(blob[pos:pos + 2], 'little')
+                    pos += 2
+                    dist = (word & ((1 << wbits) - 1)) + 1
+                    assert len(out) - dist >= start
+                    for _ in range((word >> wbits) + LZ_MIN_MATCH):
+                        out.append(out[-dist])
+    return bytes(out)
+
+
+def c_string(raw: bytes) -> str:
+    """Render bytes as a C string literal body."""
+    out = []
+    for b in raw:
+        ch = chr(b)
+        if ch in '\\"':
+            out.append('\\' + ch)
+        elif 0x20 <= b < 0x7F and ch != '?':   # '?' avoids trigraphs
+            out.append(ch)
+        else:
+            out.append(f'\\{b:03o}')
+    return ''.join(out)
+
+
+def comment(text: str) -> str:
+    """Make @p text safe inside a C comment."""
+    return c_string(text.encode()).replace('*/', '*\\/')
+
+
+def c_bytes(data: bytes, indent: str = '    ') -> str:
+    lines = []
+    for i in range(0, len(data), 12):
+        lines.append(indent + ', '.join(f'0x{b:02x}' for b in data[i:i + 12]) + ',')
+    return '\n'.join(lines)
+
+
+class Image:
+    def __init__(self, lz: tuple[int, int] | None = None) -> None:
+        self.lz = lz                          # (window bits, block shift)
+        self.blobs: dict[str, int] = {}       # sha256 -> file_table index
+        self.files: list[bytes] = []          # stored bytes
+        self.sizes: list[int] = []            # uncompressed sizes
+        self.flags: list[str] = []
+        self.names: dict[bytes, int] = {}
+        self.dirs: list[list[tuple[bytes, str, int]]] = []
+        self.dir_paths: list[str] = []
+
+    def name(self, raw: bytes) -> int:
+        return self.names.setdefault(raw, len(self.names))
+
+    def add_file(self, path: Path) -> int:
+        data = path.read_bytes()
+        if len(data) > MAX_SIZE:
+            raise SystemExit(f'mkromfs: {path}: {len(data)} bytes exceeds {MAX_SIZE}')
+        key = hashlib.sha256(data).hexdigest()
+        if key not in self.blobs:
+            self.blobs[key] = len(self.files)
+            stored, flags = data, '0'
+            if self.lz and data:
+                packed = lz_compress(data, *self.lz)
+                if len(packed) < len(data):
+                    stored, flags = packed, 'ROMFS_FILE_LZ'
+            self.files.append(stored)
+            self.sizes.append(len(data))
+            self.flags.append(flags)
+        return self.blobs[key]
+
+    def add_dir(self, path: Path, rel: str) -> int:
+        """Add @p path depth-first; children get lower indices than parents."""
+        entries = []
+        for child in sorted(path.iterdir(), key=lambda p: p.name.encode()):
+            raw = child.name.encode()
+            self.name(raw)
+            if child.is_dir():
+                entries.append((raw, 'ROMFS_DIR', self.add_dir(child, f'{rel}{child.name}/')))
+            elif child.is_file():
+                entries.append((raw, 'ROMFS_FILE', self.add_file(child)))
+        if len(entries) > MAX_INDEX:
+            raise SystemExit(f'mkromfs: {path}: too many entries')
+        self.dirs.append(entries)
+        self.dir_paths.append(rel)
+        if len(self.dirs) > MAX_INDEX or len(self.files) > MAX_INDEX:
+            raise SystemExit('mkromfs: too many files or directories')
+        return len(self.dirs) - 1
+
+    def emit(self, align: int, src: str) -> str:
+        attr = f' __attribute__((aligned({align})))' if align > 1 else ''
+        o = [
+            f'/* Generated by scripts/mkromfs.py from {comment(src)} - do not edit. */',
+            '',
+            '#ifndef ROMFS_IMAGE_H',
+            '#define ROMFS_IMAGE_H',
+            '',
+            f'/* {len(self.files)} unique files, {len(self.dirs)} directories, '
+            f'{len(self.names)} names */',
+            '',
+        ]
+        if 'ROMFS_FILE_LZ' in self.flags:
+            wbits = self.lz[0]
+            o += [
+                f'#if ROMFS_LZ_STREAMS == 0 || ROMFS_LZ_WINDOW_BITS < {wbits}',
+                f'#  error "image needs ROMFS_LZ_STREAMS > 0 and ROMFS_LZ_WINDOW_BITS >= {wbits}"',
+                '#endif',
+                '',
+            ]
+        for i, data in enumerate(self.files):
+            if data:
+                o.append(f'static const uint8_t romfs_blob{i}[{len(data)}]{attr} ROMFS_DATA = {{')
+                o.append(c_bytes(data))
+                o.append('};')
+            else:
+                o.append(f'static const uint8_t romfs_blob{i}[1] ROMFS_DATA = {{ 0 }};')
+        o.append('')
+
+        names = sorted(self.names.items(), key=lambda kv: kv[1])
+        for raw, i in names:
+            o.append(f'static const char romfs_name{i}[] HAL_PROGMEM = "{c_string(raw)}";')
+        o.append('')
+
+        # Far data addresses on AVR need 24-bit relocations: asm rows
+        rows = [(f'romfs_blob{i}', size, self.flags[i])
+                for i, size in enumerate(self.sizes)] or [('0', 0, '0')]
+        o.append('#if ROMFS_FAR && HAL_PGM_FAR')
+        o.append(f'extern const romfs_file_t file_table[{len(rows)}];')
+        o.append('__asm__(ROMFS_FAR_TABLE(file_table)')
+        for sym, size, flags in rows:
+            num = 1 if flags == 'ROMFS_FILE_LZ' else 0
+            o.append(f'        ROMFS_FAR_FILE({sym}, {size}, {num})')
+        o.append('        ROMFS_FAR_END);')
+        o.append('#else')
+        o.append('static const romfs_file_t file_table[] HAL_PROGMEM = {')
+        for sym, size, flags in rows:
+            addr = f'ROMFS_ADDR({sym})' if sym != '0' else '0'
+            o.append(f'    {{ {addr}, {size}, {flags} }},')
+        o.append('};')
+        o.append('#endif')
+        o.append('')
+
+        for d, entries in enumerate(self.dirs):
+            if not entries:
+                continue
+            o.append(f'/* Directory: /{comment(self.dir_paths[d])} */')
+            o.append(f'static const romfs_entry_t romfs_dir{d}[] HAL_PROGMEM = {{')
+            for raw, kind, idx in entries:
+                o.append(f'    {{ romfs_name{self.name(raw)}, {kind}, {idx} }},')
+            o.append('};')
+            o.append('')
+
+        o.append('static const romfs_dir_t dir_table[] HAL_PROGMEM = {')
+        for d, entries in enumerate(self.dirs):
+            ents = f'romfs_dir{d}' if entries else '0'
+            o.append(f'    {{ {ents}, {len(entries)}, ROMFS_DIR_SORTED }}, '
+                     f'/* {d}: /{comment(self.dir_paths[d])} */')
+        o.append('};')
+        o.append('')
+        o.append(f'#define ROMFS_ROOT (&dir_table[{len(self.dirs) - 1}])')
+        o.append('')
+        o.append('#endif /* ROMFS_IMAGE_H */')
+        return '\n'.join(o) + '\n'
+
+
+def main(argv: list[str]) -> int:
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('src', type=Path, help='directory to pack')
+    ap.add_argument('out', type=Path, help='header to write')
+    ap.add_argument('--align', type=int, default=4,
+                    help='file data alignment in bytes (power of two, default 4)')
+    ap.add_argument('--compress', action='store_true',
+                    help='LZSS-compress files where that saves space')
+    ap.add_argument('--lz-window', type=int, default=6, metavar='BITS',
+                    help='match window, 1..8 bits (default 6 = 64 bytes)')
+    ap.add_argument('--lz-block', type=int, default=9, metavar='BITS',
+                    help='seek checkpoint interval, 4..15 bits (default 9 = 512 bytes)')
+    args = ap.parse_args(argv[1:])
+
+    if not args.src.is_dir():
+        raise SystemExit(f'mkromfs: {args.src}: not a directory')
+    if args.align < 1 or args.align & (args.align - 1):
+        raise SystemExit('mkromfs: --align must be a power of two')
+    if not 1 <= args.lz_window <= 8 or not 4 <= args.lz_block <= 15:
+        raise SystemExit('mkromfs: --lz-window must be 1..8 and --lz-block 4..15')
+
+    img = Image((args.lz_window, args.lz_block) if args.compress else None)
+    img.add_dir(args.src, '')
+
+    text = img.emit(args.align, args.src.name)
+    if not args.out.exists() or args.out.read_text(encoding='utf-8') != text:
+        args.out.write_text(text, encoding='utf-8')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,187 @@
+#!/usr/bin/env python3
+"""
+------------------------------------------------------------------------
+prof_fold.py ― nk_prof histogram + ELF → folded stacks for flamegraph    │
+------------------------------------------------------------------------
+Symbolises the PC-sampling histogram of ``kernel/sync/nk_prof.h``
+(built with ``-Ddebug_prof=true``) against the firmware ELF and prints
+Brendan Gregg's folded-stack format, one ``<elf>;<function> <count>``
+line per function, ready for ``flamegraph.pl``.
+
+The input is the ``nk_prof_buf`` image, either
+
+* dumped raw from the debugger (the GDB stub, or simavr's ``-g``)::
+
+      (gdb) dump binary value prof.bin nk_prof_buf
+
+* or captured off the serial line after the target sent
+  ``nk_prof_image()`` with ``slip_send_packet()``; the first SLIP frame
+  holding a profile header is taken.
+
+A bucket spans ``1 << shift`` bytes and may straddle functions; its
+count is shared out in proportion to the bytes each function covers.
+Counts outside every text symbol go to ``[unknown]``, samples outside
+the profiled range to ``[outside]``.
+
+    prof_fold.py prof.bin build_328p/unix0.elf > prof.folded
+    flamegraph_analysis.sh --avr prof.bin build_328p/unix0.elf
+
+``main()`` does the work so the module may be imported without side
+effects.
+"""
+from __future__ import annotations
+
+import argparse
+import struct
+import subprocess
+import sys
+from pathlib import Path
+
+MAGIC = 0x46504B4E          # "NKPF"
+VERSION = 1
+HEADER = struct.Struct('<IBBHIIII')
+
+TEXT_TYPES = set('tTwW')
+
+SLIP_END, SLIP_ESC, SLIP_ESC_END, SLIP_ESC_ESC = 0xC0, 0xDB, 0xDC, 0xDD
+
+
+# ────────────────────────── input ─────────────────────────────────────
+def slip_frames(data: bytes) -> list[bytes]:
+    """Split a SLIP byte stream into decoded frames."""
+    frames, cur, esc = [], bytearray(), False
+    for b in data:
+        if esc:
+            cur.append({SLIP_ESC_END: SLIP_END, SLIP_ESC_ESC: SLIP_ESC}.get(b, b))
+            esc = False
+        elif b == SLIP_ESC:
+            esc = True
+        elif b == SLIP_END:
+            if cur:
+                frames.append(bytes(cur))
+            cur = bytearray()
+        else:
+            cur.append(b)
+    if cur:
+        frames.append(bytes(cur))
+    return frames
+
+
+def find_image(data: bytes) -> bytes:
+    """Return the profile image in *data*, raw or inside a SLIP frame."""
+    candidates = [data] if data[:1] != bytes([SLIP_END]) else []
+    candidates += slip_frames(data)
+    for c in candidates:
+        if len(c) >= HEADER.size and HEADER.unpack_from(c)[0] == MAGIC:
+            return c
+    raise ValueError('no nk_prof image (magic "NKPF") in input')
+
+
+def parse_image(img: bytes) -> dict:
+    """Return the header fields and the bucket counts."""
+    (_, version, shift, bins, base, hz,
+     samples, outside) = HEADER.unpack_from(img)
+    if version != VERSION:
+        raise ValueError(f'profile version {version}, expected {VERSION}')
+    need = HEADER.size + 2 * bins
+    if len(img) < need:
+        raise ValueError(f'image truncated: {len(img)} of {need} bytes')
+    counts = struct.unpack_from(f'<{bins}H', img, HEADER.size)
+    return {'shift': shift, 'base': base, 'hz': hz, 'samples': samples,
+            'outside': outside, 'counts': counts}
+
+
+def text_symbols(elf: Path, nm: str) -> list[tuple[int, int, str]]:
+    """Return (start, end, name) of the ELF's functions, by address."""
+    out = subprocess.run([nm, '-n', '-S', '--defined-only', str(elf)],
+                         check=True, capture_output=True, text=True).stdout
+    syms: list[list] = []
+    for line in out.splitlines():
+        f = line.split()
+        if len(f) == 4 and f[2] in TEXT_TYPES:
+            syms.append([int(f[0], 16), int(f[1], 16), f[3]])
+        elif len(f) == 3 and f[1] in TEXT_TYPES:
+            syms.append([int(f[0], 16), None, f[2]])    # asm label
+    # Unsized labels run to the next symbol
+    for i, s in enumerate(syms):
+        if s[1] is None:
+            nxt = syms[i + 1][0] if i + 1 < len(syms) else s[0]
+            s[1] = nxt - s[0]
+    return [(a, a + n, name) for a, n, name in syms if n > 0]
+
+
+# ────────────────────────── attribution ───────────────────────────────
+def attribute(prof: dict,
+              syms: list[tuple[int, int, str]]) -> dict[str, float]:
+    """Share each bucket's count out over the functions it overlaps."""
+    width = 1 << prof['shift']
+    hits: dict[str, float] = {}
+    j = 0
+    for i, count in enumerate(prof['counts']):
+        if not count:
+            continue
+        lo = prof['base'] + i * width
+        hi = lo + width
+        while j < len(syms) and syms[j][1] <= lo:
+            j += 1
+        covered = 0
+        k = j
+        while k < len(syms) and syms[k][0] < hi:
+            a, b, name = syms[k]
+            part = min(b, hi) - max(a, lo)
+            if part > 0:
+                hits[name] = hits.get(name, 0.0) + count * part / width
+                covered += part
+            k += 1
+        if covered < width:
+            hits['[unknown]'] = (hits.get('[unknown]', 0.0) +
+                                 count * (width - covered) / width)
+    if prof['outside']:
+        hits['[outside]'] = float(prof['outside'])
+    return hits
+
+
+def fold(hits: dict[str, float], root: str) -> list[str]:
+    """Folded-stack lines, heaviest first; rounding drops no function."""
+    lines = []
+    for name, n in sorted(hits.items(), key=lambda kv: -kv[1]):
+        lines.append(f'{root};{name} {max(1, round(n))}')
+    return lines
+
+
+# ────────────────────────── main routine ─────────────────────────────-
+def main(argv: list[str]) -> int:
+    parser = argparse.ArgumentParser(
+        description='Turn an nk_prof dump into folded stacks'
+    )
+    parser.add_argument('input', type=Path,
+                        help='Raw nk_prof_buf dump or SLIP capture')
+    parser.add_argument('elf', type=Path, help='Firmware the profile came from')
+    parser.add_argument('-o', '--output', type=Path, default=None,
+                        help='Write folded stacks here (default: stdout)')
+    parser.add_argument('--nm', default='avr-nm',
+                        help='nm for the target (default: avr-nm)')
+    args = parser.parse_args(argv)
+
+    try:
+        prof = parse_image(find_image(args.input.read_bytes()))
+        syms = text_symbols(args.elf, args.nm)
+    except (ValueError, OSError, subprocess.CalledProcessError) as e:
+        print(f'prof_fold: {e}', file=sys.stderr)
+        return 1
+
+    lines = fold(attribute(prof, syms), args.elf.stem)
+    text = ''.join(line + '\n' for line in lines)
+    if args.output is None:
+        sys.stdout.write(text)
+    else:
+        args.output.write_text(text)
+    rate = f' at {prof["hz"]} Hz' if prof['hz'] else ''
+    print(f'prof_fold: {prof["samples"]} samples{rate}, '
+          f'{1 << prof["shift"]}-byte buckets, {len(lines)} functions',
+          file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+------------------------------------------------------------------------
+sim_bench.py ― Run an Avrix benchmark ELF under simavr                  │
+------------------------------------------------------------------------
+The sim_bench_* programs in ``tests/`` print one line per measurement on
+UART0::
+
+    bench <name> <cycles> <unit>
+
+and ``bench done`` when they finish.  This helper runs one ELF under
+``simavr``, collects those lines and prints them as JSON, one object per
+measurement, so CI can diff the figures between commits:
+
+    sim_bench.py --simavr simavr --mcu atmega328p sim_bench_kernel.elf
+    sim_bench.py --mcu atmega1284p --json out.json sim_bench_door.elf
+
+With ``--json`` the list is also written to a file, the input of
+``bench_gate.py``.  The script exits with status 1 if the run times out
+or never reaches ``bench done``.  ``main()`` does the work so the module
+may be imported without side effects.
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import re
+import subprocess
+import sys
+from pathlib import Path
+
+BENCH_RE = re.compile(r'^bench (\S+) (\d+) (\S+)$')
+ANSI_RE = re.compile(r'\x1b\[[0-9;]*m')
+
+
+# ────────────────────────── helpers ───────────────────────────────────
+def run_simavr(simavr: str, mcu: str, freq: int, elf: Path,
+               timeout: int) -> str:
+    """Run *elf* to completion and return everything it printed."""
+    cmd = [simavr, '-m', mcu, '-f', str(freq), str(elf)]
+    proc = subprocess.run(cmd, capture_output=True, text=True,
+                          errors='replace', timeout=timeout)
+    return proc.stdout + proc.stderr
+
+
+def parse(output: str, mcu: str) -> tuple[list[dict], bool]:
+    """Return the measurements in *output* and whether the run finished."""
+    results: list[dict] = []
+    done = False
+    for raw in output.splitlines():
+        # simavr's UART echo colours the text and may prefix a tag
+        line = ANSI_RE.sub('', raw).strip()
+        line = line[line.find('bench '):] if 'bench ' in line else line
+        if line == 'bench done':
+            done = True
+            continue
+        m = BENCH_RE.match(line)
+        if m:
+            results.append({'mcu': mcu, 'name': m.group(1),
+                            'cycles': int(m.group(2)), 'unit': m.group(3)})
+    return results, done
+
+
+def write_json(path: Path, results: list[dict]) -> None:
+    """Store *results* in *path*, replacing any earlier run."""
+    path.write_text(json.dumps(results, indent=1) + '\n')
+
+
+# ────────────────────────── main routine ─────────────────────────────-
+def main(argv: list[str]) -> int:
+    parser = argparse.ArgumentParser(
+        description='Run a sim_bench ELF under simavr and report cycles'
+    )
+    parser.add_argument('--simavr', default='simavr',
+                        help='simavr executable (default: %(default)s)')
+    parser.add_argument('--mcu', default='atmega328p',
+                        help='MCU passed to simavr -m (default: %(default)s)')
+    parser.add_argument('--freq', type=int, default=16_000_000,
+                        help='Clock in Hz, must match F_CPU '
+                             '(default: %(default)s)')
+    parser.add_argument('--timeout', type=int, default=60,
+                        help='Seconds before the run is abandoned')
+    parser.add_argument('--json', type=Path, default=None,
+                        help='Also write the results to this file')
+    parser.add_argument('elf', type=Path, help='Benchmark ELF')
+    args = parser.parse_args(argv)
+
+    try:
+        output = run_simavr(args.simavr, args.mcu, args.freq, args.elf,
+                            args.timeout)
+    except subprocess.TimeoutExpired:
+        print(f'sim_bench: {args.elf.name} timed out after '
+              f'{args.timeout} s', file=sys.stderr)
+        return 1
+
+    results, done = parse(output, args.mcu)
+    print(json.dumps(results, indent=1))
+    if args.json is not None:
+        write_json(args.json, results)
+
+    if not done:
+        print(f'sim_bench: {args.elf.name} stopped before "bench done"',
+              file=sys.stderr)
+        sys.stderr.write(output[-2000:])
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -25,16 +25,48 @@ Two invocation patterns are supported:
 
 The default limit is taken from ``--limit``, or the environment variable
 ``FLASH_LIMIT``, falling back to 30 kB.
+
+RAM gate
+--------
+With ``--ram-limit`` (bytes, or ``0`` for the SRAM of ``--mcu``) each ELF
+must also fit in RAM::
+
+    .data + .bss + .noinit  +  worst-case main stack  +  deepest ISR
+        <=  ram-limit - ram-margin
+
+The stack figures come from GCC's ``-fstack-usage -fcallgraph-info=su``
+output (``*.ci``) found under ``--stack-dir``: the ELF's own object
+directory and LTO partitions, plus every static library's.  The depth of
+an entry point is its frame and return address plus the deepest path
+through its callees.
+Task stacks are arrays in ``.bss`` and so already counted; pass
+``--entry fn=bytes`` to check a task entry's depth against the stack it
+is given.  Recursion and calls through pointers cannot be bounded
+statically; they are reported and counted once / as zero.
 """
 from __future__ import annotations
 
 import argparse
 import os
+import re
 import subprocess
 import sys
 from pathlib import Path
 
 DEFAULT_LIMIT = 30 * 1024  # 30 kB
+DEFAULT_RAM_MARGIN = 128   # bytes kept free for what analysis cannot see
+
+# Internal SRAM per MCU (-m names as in the cross files)
+MCU_SRAM = {
+    'atmega32':    2048,
+    'atmega328p':  2048,
+    'atmega32u4':  2560,
+    'atmega128':   4096,
+    'atmega644p':  4096,
+    'atmega1284p': 16384,
+}
+
+RAM_SECTIONS = ('.data', '.bss', '.noinit')
 
 
 # ────────────────────────── helpers ───────────────────────────────────
@@ -61,6 +93,152 @@ def record_size(path: Path, size: int) -> None:
     path.write_text(f"{size}\n")
 
 
+def is_elf(path: Path) -> bool:
+    """Whether *path* starts with the ELF magic (dummy targets do not)."""
+    with path.open('rb') as f:
+        return f.read(4) == b'\x7fELF'
+
+
+def ram_usage(elf: Path) -> int:
+    """Return the static RAM footprint (.data+.bss+.noinit) of *elf*."""
+    out = subprocess.check_output(['avr-size', '-A', str(elf)], text=True)
+    total = 0
+    for line in out.splitlines():
+        cols = line.split()
+        if len(cols) >= 2 and cols[0] in RAM_SECTIONS:
+            total += int(cols[1])
+    return total
+
+
+# ── call graph (-fcallgraph-info=su) ──────────────────────────────────
+CI_NODE = re.compile(r'node: \{ title: "([^"]+)" label: "([^"]*)"')
+CI_EDGE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+CI_FRAME = re.compile(r'\\n(\d+) bytes \((static|dynamic|bounded)')
+INDIRECT = '__indirect_call'
+RET_BYTES = 2   # return address pushed by each call (3 on >128 kB parts)
+
+
+class CallGraph:
+    """Frames and call edges merged from a set of ``.ci`` files."""
+
+    def __init__(self) -> None:
+        self.frame: dict[str, int] = {}
+        self.calls: dict[str, set[str]] = {}
+        self.dynamic: set[str] = set()
+
+    def load(self, ci: Path) -> None:
+        for line in ci.read_text(errors='replace').splitlines():
+            m = CI_NODE.match(line)
+            if m:
+                f = CI_FRAME.search(m.group(2))
+                if f:
+                    # Same-named statics in two units: keep the larger
+                    size = int(f.group(1))
+                    self.frame[m.group(1)] = max(size,
+                                                 self.frame.get(m.group(1), 0))
+                    if f.group(2) == 'dynamic':
+                        self.dynamic.add(m.group(1))
+                continue
+            m = CI_EDGE.match(line)
+            if m:
+                self.calls.setdefault(m.group(1), set()).add(m.group(2))
+
+    def depth(self, fn: str, notes: set[str]) -> int:
+        """Worst-case stack bytes from entering *fn*; adds caveats to
+        *notes*."""
+        memo: dict[str, int] = {}
+
+        def walk(f: str, path: tuple[str, ...]) -> int:
+            if f in path:
+                notes.add(f'recursion through {f}')
+                return 0
+            if f in memo:
+                return memo[f]
+            if f == INDIRECT:
+                notes.add(f'indirect call in {path[-1]}')
+                return 0
+            if f in self.dynamic:
+                notes.add(f'dynamic frame in {f}')
+            deepest = 0
+            for callee in self.calls.get(f, ()):
+                deepest = max(deepest, walk(callee, path + (f,)))
+            memo[f] = RET_BYTES + self.frame.get(f, 0) + deepest
+            return memo[f]
+
+        return walk(fn, ())
+
+    def resolve(self, fn: str) -> str:
+        """Map *fn* to its node, allowing for LTO's ``fn.lto_priv.0``."""
+        if fn in self.frame:
+            return fn
+        return next((f for f in self.frame if f.startswith(fn + '.')), fn)
+
+    def isrs(self) -> list[str]:
+        return [f for f in self.frame if f.startswith('__vector_')]
+
+
+def load_graph(elf: Path, stack_dir: Path) -> CallGraph:
+    """Gather the ``.ci`` files that describe *elf*."""
+    graph = CallGraph()
+    files = set(elf.parent.glob(f'{elf.name}.p/**/*.ci'))
+    files |= set(elf.parent.glob(f'{elf.stem}*.ltrans*.ci'))
+    files |= set(stack_dir.rglob('*.a.p/**/*.ci'))
+    for ci in sorted(files):
+        graph.load(ci)
+    return graph
+
+
+def parse_entries(specs: list[str]) -> list[tuple[str, int | None]]:
+    """Split ``fn`` / ``fn=bytes`` arguments."""
+    out: list[tuple[str, int | None]] = []
+    for spec in specs:
+        name, _, size = spec.partition('=')
+        out.append((name, int(size, 0) if size else None))
+    return out
+
+
+def check_ram(elf: Path, budget: int, stack_dir: Path | None,
+              entries: list[tuple[str, int | None]]) -> bool:
+    """Print the RAM account of *elf*; return False if it does not fit."""
+    static = ram_usage(elf)
+    stack = isr = 0
+    ok = True
+    if stack_dir is not None:
+        graph = load_graph(elf, stack_dir)
+        if not graph.frame:
+            print(f'[ram-gate] {elf} : no -fcallgraph-info output, '
+                  'stack not counted', file=sys.stderr)
+        else:
+            notes: set[str] = set()
+            stack = graph.depth('main', notes)
+            isr = max((graph.depth(v, notes) for v in graph.isrs()),
+                      default=0)
+            for name, given in entries:
+                name = graph.resolve(name)
+                if name not in graph.frame:
+                    continue                # entry of another image
+                need = graph.depth(name, notes)
+                if given is not None and need > given:
+                    print(f'[ram-gate] {elf} : task {name} needs {need} '
+                          f'bytes of stack > {given}', file=sys.stderr)
+                    ok = False
+                else:
+                    print(f'[ram-gate] {elf} : task {name} stack {need}'
+                          + (f'/{given}' if given is not None else ''))
+            for n in sorted(notes):
+                print(f'[ram-gate] {elf} : unbounded: {n}', file=sys.stderr)
+
+    total = static + stack + isr
+    line = (f'{elf} : {static} static + {stack} main + {isr} ISR '
+            f'= {total} bytes')
+    if total > budget:
+        print(f'[ram-gate] {line} > {budget}', file=sys.stderr)
+        return False
+    print(f'[ram-gate] {line} OK (budget {budget})')
+    return ok
+
+
+
 # ────────────────────────── main routine ─────────────────────────────-
 def main(argv: list[str]) -> int:
     parser = argparse.ArgumentParser(
@@ -84,6 +262,33 @@ def main(argv: list[str]) -> int:
         default=None,
         help='Path of stamp file to write the largest size to'
     )
+    parser.add_argument(
+        '--ram-limit',
+        type=int,
+        default=None,
+        help='Also gate RAM against this many bytes (0 = SRAM of --mcu)'
+    )
+    parser.add_argument(
+        '--ram-margin',
+        type=int,
+        default=DEFAULT_RAM_MARGIN,
+        help='Bytes of the RAM limit kept free (default: %(default)s)'
+    )
+    parser.add_argument('--mcu', default=None,
+                        help='Target MCU, for --ram-limit 0')
+    parser.add_argument(
+        '--stack-dir',
+        type=Path,
+        default=None,
+        help='Build directory holding -fcallgraph-info=su output'
+    )
+    parser.add_argument(
+        '--entry',
+        action='append',
+        default=[],
+        metavar='FN[=BYTES]',
+        help='Task entry whose stack depth to report / check (repeatable)'
+    )
     parser.add_argument('positional', nargs='*',
                         help='[ELF …] stamp.file   (explicit-list mode)')
 
@@ -125,6 +330,19 @@ def main(argv: list[str]) -> int:
         else:
             print(f'[size-gate] {elf} : {size} bytes OK')
 
+    if args.ram_limit is not None:
+        ram = args.ram_limit or MCU_SRAM.get(args.mcu or '', 0)
+        if not ram:
+            print(f'[ram-gate] unknown SRAM size for MCU {args.mcu!r}; '
+                  'pass --ram-limit', file=sys.stderr)
+            return 1
+        budget = ram - args.ram_margin
+        entries = parse_entries(args.entry)
+        for elf in elfs:
+            if is_elf(elf) and not check_ram(elf, budget, args.stack_dir,
+                                             entries):
+                status = 1
+
     record_size(out_path, max_size)
     return status
 
@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+"""
+------------------------------------------------------------------------
+trace_decode.py ― nk_trace image → Chrome trace / Perfetto JSON         │
+------------------------------------------------------------------------
+Decodes the kernel event ring of ``kernel/sync/nk_trace.h`` (built with
+``-Ddebug_trace=true``) into the JSON trace format that
+``chrome://tracing`` and https://ui.perfetto.dev open directly.
+
+The input is the ``nk_trace_buf`` image, either
+
+* dumped raw from the debugger::
+
+      (gdb) dump binary value trace.bin nk_trace_buf
+
+* or captured off the serial line after the target sent
+  ``nk_trace_image()`` with ``slip_send_packet()``; the first SLIP frame
+  holding a trace header is taken.
+
+Each core is a process and each task a thread whose slices run from the
+switch to it until the switch away.  Door calls are async slices on the
+caller from call to return, contended locks and timer expiries are
+instants, and ISRs are slices on an ``ISR`` thread.
+
+    trace_decode.py trace.bin -o trace.json
+    trace_decode.py --task 1=shell --task 2=net capture.slip -o trace.json
+
+``main()`` does the work so the module may be imported without side
+effects.
+"""
+from __future__ import annotations
+
+import argparse
+import json
+import struct
+import sys
+from pathlib import Path
+
+MAGIC = 0x52544B4E          # "NKTR"
+VERSION = 1
+HEADER = struct.Struct('<IBBHI')
+HEAD = struct.Struct('<HH')
+EVENT = struct.Struct('<IBBH')
+
+TID_NONE = 0xFF
+ISR_TID = 1000
+TIMER_TID = 1001
+
+SWITCH, DOOR_CALL, DOOR_RETURN, LOCK, ISR_ENTER, ISR_EXIT, TIMER = range(1, 8)
+IRQ_NAMES = {1: 'UART RX', 2: 'UART TX', 3: 'EEPROM'}
+
+SLIP_END, SLIP_ESC, SLIP_ESC_END, SLIP_ESC_ESC = 0xC0, 0xDB, 0xDC, 0xDD
+
+
+# ────────────────────────── input ─────────────────────────────────────
+def slip_frames(data: bytes) -> list[bytes]:
+    """Split a SLIP byte stream into decoded frames."""
+    frames, cur, esc = [], bytearray(), False
+    for b in data:
+        if esc:
+            cur.append({SLIP_ESC_END: SLIP_END, SLIP_ESC_ESC: SLIP_ESC}.get(b, b))
+            esc = False
+        elif b == SLIP_ESC:
+            esc = True
+        elif b == SLIP_END:
+            if cur:
+                frames.append(bytes(cur))
+            cur = bytearray()
+        else:
+            cur.append(b)
+    if cur:
+        frames.append(bytes(cur))
+    return frames
+
+
+def find_image(data: bytes) -> bytes:
+    """Return the trace image in *data*, raw or inside a SLIP frame."""
+    candidates = [data] if data[:1] != bytes([SLIP_END]) else []
+    candidates += slip_frames(data)
+    for c in candidates:
+        if len(c) >= HEADER.size and HEADER.unpack_from(c)[0] == MAGIC:
+            return c
+    raise ValueError('no nk_trace image (magic "NKTR") in input')
+
+
+def parse_image(img: bytes) -> tuple[int, list[list[tuple]]]:
+    """Return (hz, per-core lists of (ts, type, a, b), oldest first)."""
+    magic, version, cores, events, hz = HEADER.unpack_from(img)
+    if version != VERSION:
+        raise ValueError(f'trace version {version}, expected {VERSION}')
+    need = HEADER.size + cores * HEAD.size + cores * events * EVENT.size
+    if len(img) < need:
+        raise ValueError(f'image truncated: {len(img)} of {need} bytes')
+
+    rings = []
+    ev_base = HEADER.size + cores * HEAD.size
+    for c in range(cores):
+        nxt, count = HEAD.unpack_from(img, HEADER.size + c * HEAD.size)
+        count = min(count, events)
+        ring = []
+        for k in range(count):
+            i = (nxt - count + k) % events
+            off = ev_base + (c * events + i) * EVENT.size
+            ring.append(EVENT.unpack_from(img, off))
+        rings.append(ring)
+    return hz, rings
+
+
+# ────────────────────────── conversion ────────────────────────────────
+def to_chrome(hz: int, rings: list[list[tuple]],
+              names: dict[int, str]) -> list[dict]:
+    """Build the Chrome trace event list."""
+    out: list[dict] = []
+
+    def meta(pid: int, tid: int, name: str) -> None:
+        out.append({'ph': 'M', 'name': 'thread_name', 'pid': pid,
+                    'tid': tid, 'args': {'name': name}})
+
+    for core, ring in enumerate(rings):
+        out.append({'ph': 'M', 'name': 'process_name', 'pid': core,
+                    'args': {'name': f'core {core}'}})
+        meta(core, ISR_TID, 'ISR')
+        meta(core, TIMER_TID, 'timers')
+
+        tasks: set[int] = set()
+        doors: dict[int, str] = {}          # caller -> open call
+        running: int | None = None
+        wrap, last = 0, None
+        for ts, typ, a, b in ring:
+            if last is not None and ts < last:
+                wrap += 1 << 32             # 32-bit counter rolled over
+            last = ts
+            us = (ts + wrap) * 1e6 / hz
+            ev = {'pid': core, 'ts': us}
+
+            if typ == SWITCH:
+                if running is not None:
+                    out.append(dict(ev, ph='E', tid=running))
+                running = b
+                tasks.add(b)
+                out.append(dict(ev, ph='B', tid=b,
+                                name=names.get(b, f'task {b}')))
+            elif typ == DOOR_CALL:
+                tasks.add(a)
+                doors[a] = f'door {b & 0xFF} -> task {b >> 8}'
+                out.append(dict(ev, ph='b', tid=a, cat='door', id=a,
+                                name=doors[a]))
+            elif typ == DOOR_RETURN:
+                if b in doors:              # call may predate the ring
+                    out.append(dict(ev, ph='e', tid=b, cat='door', id=b,
+                                    name=doors.pop(b)))
+            elif typ == LOCK:
+                tasks.add(a)
+                out.append(dict(ev, ph='i', s='t', tid=a,
+                                name=f'lock contended 0x{b:04x}'))
+            elif typ in (ISR_ENTER, ISR_EXIT):
+                out.append(dict(ev, tid=ISR_TID,
+                                ph='B' if typ == ISR_ENTER else 'E',
+                                name=IRQ_NAMES.get(a, f'irq {a}')))
+            elif typ == TIMER:
+                out.append(dict(ev, ph='i', s='t', tid=TIMER_TID,
+                                name=f'timer 0x{b:04x}'))
+            else:
+                out.append(dict(ev, ph='i', s='p', tid=ISR_TID,
+                                name=f'event {typ}',
+                                args={'a': a, 'b': b}))
+        if running is not None and last is not None:
+            out.append({'pid': core, 'tid': running, 'ph': 'E',
+                        'ts': (last + wrap) * 1e6 / hz})
+        for t in sorted(tasks - {TID_NONE}):
+            meta(core, t, names.get(t, f'task {t}'))
+    return out
+
+
+def parse_names(specs: list[str]) -> dict[int, str]:
+    """Turn ``tid=name`` arguments into a map."""
+    names = {}
+    for spec in specs:
+        tid, _, name = spec.partition('=')
+        names[int(tid, 0)] = name or tid
+    return names
+
+
+# ────────────────────────── main routine ─────────────────────────────-
+def main(argv: list[str]) -> int:
+    parser = argparse.ArgumentParser(
+        description='Convert an nk_trace dump to Chrome trace JSON'
+    )
+    parser.add_argument('input', type=Path,
+                        help='Raw nk_trace_buf dump or SLIP capture')
+    parser.add_argument('-o', '--output', type=Path, default=None,
+                        help='Write JSON here (default: stdout)')
+    parser.add_argument('--task', action='append', default=[],
+                        metavar='TID=NAME', help='Name a task (repeatable)')
+    args = parser.parse_args(argv)
+
+    try:
+        hz, rings = parse_image(find_image(args.input.read_bytes()))
+    except ValueError as e:
+        print(f'trace_decode: {e}', file=sys.stderr)
+        return 1
+
+    trace = {'traceEvents': to_chrome(hz, rings, parse_names(args.task)),
+             'displayTimeUnit': 'ns'}
+    text = json.dumps(trace, indent=1) + '\n'
+    if args.output is None:
+        sys.stdout.write(text)
+    else:
+        args.output.write_text(text)
+        n = sum(len(r) for r in rings)
+        print(f'trace_decode: {n} events from {len(rings)} core(s) '
+              f'-> {args.output}')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -1,57 +1,485 @@
 /* SPDX-License-Identifier: MIT */
+/* On-device GDB remote stub over a TTY (see avr_gdbstub.h).
+ *
+ * Replies are streamed straight into the TTY while the checksum is
+ * summed, so the only buffer is the received packet.  Runs of a
+ * repeated character are run-length encoded on the way out; a memory
+ * dump of zeroed RAM shrinks to a few bytes per packet. */
+
 #include "avr_gdbstub.h"
+#include "arch/common/hal.h"
+#include "kernel/sync/nk_trace.h"
+#include "kernel/sync/nk_prof.h"
+#include "kernel/sync/nk_log.h"
+#include <stdbool.h>
 #include <stddef.h>
+#include <string.h>
+
+#if defined(__AVR__)
+typedef uint32_t gdb_addr_t;            /* avr-gdb: flash, 0x80.. RAM */
+#  define GDB_RAM_BASE    0x800000UL
+#  define GDB_EEPROM_BASE 0x810000UL
+#else
+typedef uintptr_t gdb_addr_t;
+#endif
 
 static tty_t *gdb_tty;
+static gdbstub_baud_fn gdb_baud;
+static bool gdb_noack;
+
+/* Receive state, kept across gdbstub_poll() calls */
+enum { RX_IDLE, RX_DATA, RX_SUM_HI, RX_SUM_LO };
+static char     rx_buf[GDBSTUB_PACKET_SIZE + 1];
+static uint16_t rx_len;
+static uint8_t  rx_state;
+static uint8_t  rx_sum;
+static uint8_t  rx_want;
+
+/* Transmit state: a small chunk for tty_write(), checksum, open run */
+static uint8_t  tx_chunk[16];
+static uint8_t  tx_len;
+static uint8_t  tx_sum;
+static int16_t  run_c = -1;
+static uint8_t  run_n;
+static bool     replied;
+
+static const char hexdig[] = "0123456789abcdef";
+
+/*───────────────────────── byte I/O ─────────────────────────*/
+
+static int get(void) {
+    uint8_t c;
+    tty_poll(gdb_tty);
+    return tty_read(gdb_tty, &c, 1) == 1 ? c : -1;
+}
+
+static int get_wait(void) {
+    int c;
+    while ((c = get()) < 0) {
+    }
+    return c;
+}
+
+static void flush(void) {
+    const uint8_t *p = tx_chunk;
+    while (tx_len) {
+        int n = tty_write(gdb_tty, p, tx_len);
+        if (n > 0) {
+            p += n;
+            tx_len = (uint8_t)(tx_len - n);
+        }
+    }
+}
 
 static void put(uint8_t c) {
-    if (gdb_tty && gdb_tty->putc)
-        gdb_tty->putc(c);
+    if (tx_len == sizeof tx_chunk) {
+        flush();
+    }
+    tx_chunk[tx_len++] = c;
 }
 
-static int get(void) {
-    return (gdb_tty && gdb_tty->getc) ? gdb_tty->getc() : -1;
+static void emit(uint8_t c) {
+    put(c);
+    tx_sum += c;
+}
+
+/*───────────────────────── reply encoding ─────────────────────────*/
+
+/* Close the open run: '*' and 29 + repeats, never '#' or '$' */
+static void run_flush(void) {
+    if (run_c < 0) {
+        return;
+    }
+    uint8_t c = (uint8_t)run_c, extra = (uint8_t)(run_n - 1u);
+    emit(c);
+    while (extra) {
+        if (extra < 3) {
+            emit(c);
+            extra--;
+            continue;
+        }
+        uint8_t n = extra > 97 ? 97 : extra;
+        if (n == 6 || n == 7) {
+            n = 5;
+        }
+        emit('*');
+        emit((uint8_t)(n + 29u));
+        extra = (uint8_t)(extra - n);
+    }
+    run_c = -1;
 }
 
-static void hex(uint8_t b) {
-    const char h[] = "0123456789abcdef";
-    put(h[(b >> 4) & 0xF]);
-    put(h[b & 0xF]);
+static void out(char ch) {
+    uint8_t c = (uint8_t)ch;
+    if (run_c == c && run_n < 255) {
+        run_n++;
+        return;
+    }
+    run_flush();
+    run_c = c;
+    run_n = 1;
 }
 
-static void packet(const char *p) {
-    uint8_t sum = 0;
-    put('$');
-    for (; p && *p; ++p) {
-        put((uint8_t)*p);
-        sum += (uint8_t)*p;
+static void out_str(const char *s) {
+    while (*s) {
+        out(*s++);
     }
+}
+
+static void out_hex(uint8_t b) {
+    out(hexdig[b >> 4]);
+    out(hexdig[b & 0xF]);
+}
+
+static void out_num(uint32_t v) {
+    char d[8];
+    uint8_t n = 0;
+    do {
+        d[n++] = hexdig[v & 0xF];
+        v >>= 4;
+    } while (v);
+    while (n) {
+        out(d[--n]);
+    }
+}
+
+/* Binary data: escape the framing characters, which never join runs */
+static void out_bin(uint8_t c) {
+    if (c == '$' || c == '#' || c == '}' || c == '*') {
+        run_flush();
+        emit('}');
+        emit(c ^ 0x20u);
+    } else {
+        out((char)c);
+    }
+}
+
+static void reply_begin(void) {
+    put('$');
+    tx_sum = 0;
+    run_c = -1;
+    replied = true;
+}
+
+static void reply(const char *s) {
+    reply_begin();
+    out_str(s);
+}
+
+static void reply_end(void) {
+    run_flush();
     put('#');
-    hex(sum);
-    while (get() != '+') {}
+    put((uint8_t)hexdig[tx_sum >> 4]);
+    put((uint8_t)hexdig[tx_sum & 0xF]);
+    flush();
+}
+
+/*───────────────────────── parsing & memory ─────────────────────────*/
+
+static int hexval(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static const char *parse_hex(const char *p, gdb_addr_t *v) {
+    int d;
+    *v = 0;
+    while ((d = hexval(*p)) >= 0) {
+        *v = (*v << 4) | (gdb_addr_t)d;
+        p++;
+    }
+    return p;
+}
+
+/* "addr,len" followed by @p end; NULL if malformed */
+static const char *parse_range(const char *p, gdb_addr_t *addr,
+                               gdb_addr_t *len, char end) {
+    p = parse_hex(p, addr);
+    if (*p++ != ',') {
+        return NULL;
+    }
+    p = parse_hex(p, len);
+    return *p == end ? p + 1 : NULL;
+}
+
+static uint8_t mem_read(gdb_addr_t a) {
+#if defined(__AVR__)
+    if (a >= GDB_EEPROM_BASE) {
+        return hal_eeprom_read_byte((uint16_t)(a - GDB_EEPROM_BASE));
+    }
+    if (a >= GDB_RAM_BASE) {
+        return *(volatile const uint8_t *)(uintptr_t)(uint16_t)(a - GDB_RAM_BASE);
+    }
+    return hal_pgm_read_byte_far(a);
+#else
+    return *(volatile const uint8_t *)a;
+#endif
+}
+
+static bool mem_write(gdb_addr_t a, uint8_t v) {
+#if defined(__AVR__)
+    if (a >= GDB_EEPROM_BASE) {
+        hal_eeprom_write_byte((uint16_t)(a - GDB_EEPROM_BASE), v);
+        return true;
+    }
+    if (a < GDB_RAM_BASE) {
+        return false;                   /* Flash is not writable here */
+    }
+    *(volatile uint8_t *)(uintptr_t)(uint16_t)(a - GDB_RAM_BASE) = v;
+#else
+    *(volatile uint8_t *)a = v;
+#endif
+    return true;
+}
+
+/*───────────────────────── commands ─────────────────────────*/
+
+static uint32_t pending_baud;
+
+/* 'g': no exception frame to report, so zeros with the live SREG/SP */
+static void cmd_regs(void) {
+#if defined(__AVR__)
+    reply_begin();
+    for (uint8_t i = 0; i < 32; i++) {
+        out_hex(0);
+    }
+    uint16_t sp = SP;
+    out_hex(SREG);
+    out_hex((uint8_t)sp);
+    out_hex((uint8_t)(sp >> 8));
+    for (uint8_t i = 0; i < 4; i++) {
+        out_hex(0);
+    }
+#else
+    reply("E01");
+#endif
+}
+
+static void cmd_read(const char *p) {
+    gdb_addr_t a, n;
+    if (!parse_range(p, &a, &n, '\0')) {
+        reply("E01");
+        return;
+    }
+    reply_begin();
+    while (n--) {
+        out_hex(mem_read(a++));
+    }
+}
+
+static void cmd_write_hex(const char *p) {
+    gdb_addr_t a, n;
+    p = parse_range(p, &a, &n, ':');
+    if (!p) {
+        reply("E01");
+        return;
+    }
+    for (; n; n--, p += 2) {
+        int hi = hexval(p[0]), lo = hi < 0 ? -1 : hexval(p[1]);
+        if (lo < 0 || !mem_write(a++, (uint8_t)(hi << 4 | lo))) {
+            reply("E02");
+            return;
+        }
+    }
+    reply("OK");
+}
+
+/* 'X': binary, '}' escapes; the data may hold NULs, so go by rx_len */
+static void cmd_write_bin(const char *p) {
+    gdb_addr_t a, n;
+    p = parse_range(p, &a, &n, ':');
+    if (!p) {
+        reply("E01");
+        return;
+    }
+    const char *end = rx_buf + rx_len;
+    for (; n && p < end; n--) {
+        uint8_t c = (uint8_t)*p++;
+        if (c == '}' && p < end) {
+            c = (uint8_t)*p++ ^ 0x20u;
+        }
+        if (!mem_write(a++, c)) {
+            reply("E02");
+            return;
+        }
+    }
+    reply(n ? "E03" : "OK");
+}
+
+/* qXfer:nk:read:<image>:off,len */
+static void cmd_xfer(const char *p) {
+    size_t size = 0;
+    const uint8_t *img = NULL;
+    if (!strncmp(p, "trace:", 6)) {
+        img = nk_trace_image(&size);
+    } else if (!strncmp(p, "prof:", 5)) {
+        img = nk_prof_image(&size);
+    } else if (!strncmp(p, "log:", 4)) {
+        img = nk_log_image(&size);
+    }
+    p = strchr(p, ':');
+    gdb_addr_t off, n;
+    if (!img || !p || !parse_range(p + 1, &off, &n, '\0')) {
+        reply("E00");
+        return;
+    }
+    if (off >= size) {
+        reply("l");
+        return;
+    }
+    if (n > size - off) {
+        n = size - off;
+    }
+    reply_begin();
+    out(off + n < size ? 'm' : 'l');
+    for (gdb_addr_t i = 0; i < n; i++) {
+        out_bin(img[off + i]);
+    }
+}
+
+static void cmd_query(const char *p) {
+    if (!strncmp(p, "Supported", 9)) {
+        reply("PacketSize=");
+        out_num(GDBSTUB_PACKET_SIZE);
+        out_str(";QStartNoAckMode+;qXfer:nk:read+");
+    } else if (!strncmp(p, "Xfer:nk:read:", 13)) {
+        cmd_xfer(p + 13);
+    } else if (!strcmp(p, "Attached")) {
+        reply("1");
+    } else {
+        reply("");
+    }
+}
+
+static void cmd_set(const char *p) {
+    gdb_addr_t rate;
+    if (!strcmp(p, "StartNoAckMode")) {
+        reply("OK");
+    } else if (!strncmp(p, "Baud:", 5)) {
+        p = parse_hex(p + 5, &rate);
+        if (!gdb_baud || *p || rate == 0 || rate > GDBSTUB_BAUD_MAX) {
+            reply("E01");
+        } else {
+            pending_baud = (uint32_t)rate;
+            reply("OK");
+        }
+    } else {
+        reply("");
+    }
+}
+
+static void handle(void) {
+    const char *p = rx_buf + 1;
+    replied = false;
+    switch (rx_buf[0]) {
+    case '?': reply("S05"); break;
+    case 'g': cmd_regs(); break;
+    case 'm': cmd_read(p); break;
+    case 'M': cmd_write_hex(p); break;
+    case 'X': cmd_write_bin(p); break;
+    case 'q': cmd_query(p); break;
+    case 'Q': cmd_set(p); break;
+    case 'D': reply("OK"); break;
+    case 'c': break;                    /* Keeps running until Ctrl-C */
+    default: reply(""); break;
+    }
+    if (replied) {
+        reply_end();
+    }
+}
+
+/* Run the packet in rx_buf, resending the reply until it is acked */
+static void dispatch(void) {
+    pending_baud = 0;
+    do {
+        handle();
+    } while (replied && !gdb_noack && get_wait() == '-');
+
+    if (rx_buf[0] == 'Q' && !strcmp(rx_buf, "QStartNoAckMode")) {
+        gdb_noack = true;
+    }
+    if (pending_baud) {
+        while (gdb_tty->tx_head != gdb_tty->tx_tail) {
+        }
+        hal_timer_delay_us(2000);       /* Last character off the wire */
+        gdb_baud(pending_baud);
+    }
+}
+
+/*───────────────────────── public API ─────────────────────────*/
+
+static void packet(const char *p) {
+    reply(p);
+    reply_end();
+    while (get_wait() != '+') {}
 }
 
 void gdbstub_init(tty_t *tty) {
     gdb_tty = tty;
+    gdb_noack = false;
+    rx_state = RX_IDLE;
     packet("OK");
 }
 
+void gdbstub_set_baud_hook(gdbstub_baud_fn fn) {
+    gdb_baud = fn;
+}
+
 void gdbstub_poll(void) {
     if (!gdb_tty) return;
     int c;
     while ((c = get()) >= 0) {
-        if (c == 0x03) {         /* Ctrl-C */
-            asm volatile("break");
-            packet("S05");
-        } else if (c == '?') {
-            packet("S05");
-        } else {
-            packet("");          /* nack unsupported */
+        switch (rx_state) {
+        case RX_IDLE:
+            if (c == 0x03) {            /* Ctrl-C */
+                gdbstub_break();
+                rx_buf[0] = '?';
+                rx_len = 1;
+                dispatch();
+            } else if (c == '$') {
+                rx_len = 0;
+                rx_sum = 0;
+                rx_state = RX_DATA;
+            }
+            break;
+        case RX_DATA:
+            if (c == '#') {
+                rx_state = RX_SUM_HI;
+            } else if (rx_len < GDBSTUB_PACKET_SIZE) {
+                rx_buf[rx_len++] = (char)c;
+                rx_sum += (uint8_t)c;
+            } else {
+                rx_state = RX_IDLE;     /* Too long: let GDB retry */
+                if (!gdb_noack) {
+                    put('-');
+                    flush();
+                }
+            }
+            break;
+        case RX_SUM_HI:
+            rx_want = (uint8_t)(hexval((char)c) << 4);
+            rx_state = RX_SUM_LO;
+            break;
+        case RX_SUM_LO:
+            rx_state = RX_IDLE;
+            rx_want |= (uint8_t)hexval((char)c);
+            if (!gdb_noack) {
+                put(rx_want == rx_sum ? '+' : '-');
+                flush();
+            }
+            if (rx_want == rx_sum || gdb_noack) {
+                rx_buf[rx_len] = '\0';
+                dispatch();
+            }
+            break;
         }
     }
 }
 
 void gdbstub_break(void) {
-    asm volatile("break");
+#if defined(__AVR__)
+    __asm__ __volatile__("break");
+#endif
 }
-
@@ -6,5 +6,4 @@
 #ifndef __AVR__
 #include <stdint.h>
 uint8_t nk_sim_io[0x40];
-uint8_t nk_sim_eeprom[1024];
 #endif
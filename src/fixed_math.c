@@ -0,0 +1,218 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Fixed-point sin/cos/atan2/sqrt/exp (fixed_point.h).
+ *
+ * Three small tables in program memory, read with hal_pgm_read_word()
+ * and linearly interpolated: a quarter-wave sine (129 words), atan on
+ * [0, 1] (65 words) and 2^x on [0, 1] (65 words), 518 bytes of flash in
+ * all.  sqrt is integer Newton and needs no table.
+ */
+
+#include "fixed_point.h"
+#include "arch/common/hal.h"
+#include <stdbool.h>
+
+/* sin(i * pi/256) in Q15, i = 0..128, the last clamped to 0x7FFF */
+static const uint16_t sin_lut[129] HAL_PROGMEM = {
+        0,   402,   804,  1206,  1608,  2009,  2411,  2811,
+     3212,  3612,  4011,  4410,  4808,  5205,  5602,  5998,
+     6393,  6787,  7180,  7571,  7962,  8351,  8740,  9127,
+     9512,  9896, 10279, 10660, 11039, 11417, 11793, 12167,
+    12540, 12910, 13279, 13646, 14010, 14373, 14733, 15091,
+    15447, 15800, 16151, 16500, 16846, 17190, 17531, 17869,
+    18205, 18538, 18868, 19195, 19520, 19841, 20160, 20475,
+    20788, 21097, 21403, 21706, 22006, 22302, 22595, 22884,
+    23170, 23453, 23732, 24008, 24279, 24548, 24812, 25073,
+    25330, 25583, 25833, 26078, 26320, 26557, 26791, 27020,
+    27246, 27467, 27684, 27897, 28106, 28311, 28511, 28707,
+    28899, 29086, 29269, 29448, 29622, 29792, 29957, 30118,
+    30274, 30425, 30572, 30715, 30853, 30986, 31114, 31238,
+    31357, 31471, 31581, 31686, 31786, 31881, 31972, 32058,
+    32138, 32214, 32286, 32352, 32413, 32470, 32522, 32568,
+    32610, 32647, 32679, 32706, 32729, 32746, 32758, 32766,
+    32767,
+};
+
+/* atan(i / 64) in binary angle units (0x10000 per turn), i = 0..64 */
+static const uint16_t atan_lut[65] HAL_PROGMEM = {
+        0,   163,   326,   489,   651,   813,   975,  1136,
+     1297,  1457,  1617,  1775,  1933,  2090,  2246,  2401,
+     2555,  2708,  2860,  3010,  3159,  3307,  3453,  3599,
+     3742,  3884,  4025,  4164,  4302,  4438,  4572,  4705,
+     4836,  4966,  5094,  5220,  5344,  5467,  5589,  5708,
+     5826,  5943,  6058,  6171,  6282,  6392,  6500,  6607,
+     6712,  6815,  6917,  7018,  7117,  7214,  7310,  7405,
+     7498,  7589,  7679,  7768,  7856,  7942,  8026,  8110,
+     8192,
+};
+
+/* (2^(i / 64) - 1) * 32768, i = 0..64 */
+static const uint16_t exp2_lut[65] HAL_PROGMEM = {
+        0,   357,   718,  1082,  1451,  1823,  2200,  2581,
+     2966,  3355,  3748,  4146,  4548,  4954,  5365,  5780,
+     6200,  6624,  7053,  7487,  7925,  8368,  8816,  9269,
+     9727, 10190, 10657, 11130, 11608, 12091, 12580, 13074,
+    13573, 14078, 14588, 15103, 15625, 16152, 16684, 17223,
+    17767, 18317, 18874, 19436, 20005, 20579, 21160, 21747,
+    22341, 22941, 23548, 24161, 24781, 25408, 26041, 26681,
+    27329, 27983, 28645, 29313, 29989, 30673, 31364, 32062,
+    32768,
+};
+
+static inline int16_t sat16(int32_t v) {
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+}
+
+/*─────────────────────────── sin / cos ────────────────────────────*/
+
+/* sin of a binary angle (0x10000 per turn) in Q15 */
+static int16_t sin_bam(uint16_t a) {
+    uint16_t p = a & 0x3FFFu;
+    if (a & 0x4000u) {
+        p = 0x4000u - p;                    /* Second half of the hump */
+    }
+    uint8_t i = (uint8_t)(p >> 7);
+    uint8_t f = (uint8_t)(p & 0x7Fu);
+    uint16_t v = hal_pgm_read_word(&sin_lut[i]);
+    if (f) {
+        uint16_t d = (uint16_t)(hal_pgm_read_word(&sin_lut[i + 1]) - v);
+        v += (uint16_t)((uint16_t)(d * f + 64u) >> 7);  /* d <= 402 */
+    }
+    return (a & 0x8000u) ? -(int16_t)v : (int16_t)v;
+}
+
+/* Q8.8 radians to a binary angle: 65536 / 2pi / 256 = 41722 / 1024 */
+static uint16_t rad_to_bam(q8_8_t rad) {
+    return (uint16_t)(((int32_t)rad * 41722 + 512) >> 10);
+}
+
+q15_t q15_sin(q15_t angle) {
+    return sin_bam((uint16_t)angle);
+}
+
+q15_t q15_cos(q15_t angle) {
+    return sin_bam((uint16_t)((uint16_t)angle + 0x4000u));
+}
+
+q8_8_t q8_8_sin(q8_8_t rad) {
+    return (q8_8_t)((sin_bam(rad_to_bam(rad)) + 64) >> 7);
+}
+
+q8_8_t q8_8_cos(q8_8_t rad) {
+    return (q8_8_t)((sin_bam((uint16_t)(rad_to_bam(rad) + 0x4000u)) + 64) >> 7);
+}
+
+/*─────────────────────────── atan2 ────────────────────────────────*/
+
+/* Binary angle of (x, y), -0x8000..0x7FFF */
+static int16_t atan2_bam(int16_t y, int16_t x) {
+    uint16_t ax = x < 0 ? (uint16_t)-(int32_t)x : (uint16_t)x;
+    uint16_t ay = y < 0 ? (uint16_t)-(int32_t)y : (uint16_t)y;
+    uint16_t a;
+
+    if (ax == 0 && ay == 0) {
+        return 0;
+    }
+    /* Fold into the first octant: r = min / max in [0, 1], Q15 */
+    bool steep = ay > ax;
+    uint16_t lo = steep ? ax : ay;
+    uint16_t hi = steep ? ay : ax;
+    uint16_t r = (uint16_t)(((uint32_t)lo << 15) / hi);
+    uint8_t i = (uint8_t)(r >> 9);
+    uint16_t f = r & 0x1FFu;
+    a = hal_pgm_read_word(&atan_lut[i]);
+    if (f) {
+        uint16_t d = (uint16_t)(hal_pgm_read_word(&atan_lut[i + 1]) - a);
+        a += (uint16_t)(((uint32_t)d * f + 256u) >> 9);
+    }
+    if (steep) {
+        a = 0x4000u - a;                    /* pi/2 - a */
+    }
+    if (x < 0) {
+        a = 0x8000u - a;                    /* pi - a */
+    }
+    if (y < 0) {
+        a = (uint16_t)-a;
+    }
+    return (int16_t)a;
+}
+
+q15_t q15_atan2(q15_t y, q15_t x) {
+    return atan2_bam(y, x);
+}
+
+q8_8_t q8_8_atan2(q8_8_t y, q8_8_t x) {
+    /* Binary angle to Q8.8 radians: 2pi * 256 / 65536 = 804 / 32768 */
+    return (q8_8_t)(((int32_t)atan2_bam(y, x) * 804 + 16384) >> 15);
+}
+
+/*─────────────────────────── sqrt ─────────────────────────────────*/
+
+/* sqrt(n) rounded to nearest, saturated to 0xFFFF */
+static uint16_t isqrt32(uint32_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    /* 2^e >= sqrt(n); the first Newton step from it needs no division */
+    uint8_t bits = (uint8_t)(8 * sizeof(unsigned long) - __builtin_clzl(n));
+    uint8_t e = (uint8_t)((bits + 1u) / 2u);
+    uint32_t x = (((uint32_t)1 << e) + (n >> e)) >> 1;
+    for (;;) {                              /* Decreasing onto floor(sqrt) */
+        uint32_t y = (x + n / x) >> 1;
+        if (y >= x) {
+            break;
+        }
+        x = y;
+    }
+    if (n - x * x > x) {                    /* n > (x + 1/2)^2 */
+        x++;
+    }
+    return x > 0xFFFFu ? 0xFFFFu : (uint16_t)x;
+}
+
+q15_t q15_sqrt(q15_t x) {
+    return x <= 0 ? 0 : sat16(isqrt32((uint32_t)x << 15));
+}
+
+q8_8_t q8_8_sqrt(q8_8_t x) {
+    return x <= 0 ? 0 : (q8_8_t)isqrt32((uint32_t)x << 8);
+}
+
+/*─────────────────────────── exp ──────────────────────────────────*/
+
+/* 2^(t / 65536) with @p frac fractional bits, saturated */
+static int16_t pow2_q(int32_t t, uint8_t frac) {
+    int16_t k = (int16_t)(t >> 16);         /* floor */
+    uint16_t f = (uint16_t)t;
+    uint8_t i = (uint8_t)(f >> 10);
+    uint16_t r = f & 0x3FFu;
+    uint16_t e0 = hal_pgm_read_word(&exp2_lut[i]);
+    uint32_t m = 32768u + e0;               /* 2^f, 1.0 = 32768 */
+    if (r) {
+        uint16_t d = (uint16_t)(hal_pgm_read_word(&exp2_lut[i + 1]) - e0);
+        m += ((uint32_t)d * r + 512u) >> 10;
+    }
+    int16_t s = (int16_t)(15 - frac - k);   /* m * 2^k >> (15 - frac) */
+    if (s <= 0) {
+        return INT16_MAX;                   /* m >= 32768 already */
+    }
+    if (s > 17) {
+        return 0;
+    }
+    return sat16((int32_t)((m + ((uint32_t)1 << (s - 1))) >> s));
+}
+
+/* log2(e) * 2^15 */
+#define LOG2E_Q15 47274
+
+q15_t q15_exp(q15_t x) {
+    return pow2_q(((int32_t)x * LOG2E_Q15) >> 14, 15);
+}
+
+q8_8_t q8_8_exp(q8_8_t x) {
+    return pow2_q(((int32_t)x * LOG2E_Q15) >> 7, 8);
+}
@@ -39,3 +39,240 @@ q8_8_t q8_8_mul(q8_8_t a, q8_8_t b) {
 
     return (q8_8_t)result;
 }
+
+/*═══════════════════════════════════════════════════════════════════
+ * Block kernels
+ *
+ * Everything funnels into two primitives: mac16() (16x16 signed
+ * products summed into 32 bits) and fmul16() (the Q1.31 product behind
+ * q15_scale()).  The AVR versions keep the operands in r16..r23, where
+ * mulsu/fmulsu can reach them; the sequences follow Atmel AVR201.
+ *═══════════════════════════════════════════════════════════════════*/
+
+#if defined(__AVR__) && defined(__AVR_HAVE_MUL__)
+#  define FP_AVR_MUL 1
+#elif defined(__ARM_FEATURE_DSP)
+#  include <arm_acle.h>
+#  include <string.h>
+#  define FP_ARM_DSP 1
+#endif
+
+static inline int16_t sat16(int32_t v) {
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+}
+
+/* acc / 2^shift rounded to nearest, saturated; no overflow near the ends */
+static inline int16_t round_sat(int32_t acc, uint8_t shift) {
+    return sat16(((acc >> (shift - 1u)) + 1) >> 1);
+}
+
+#ifdef FP_AVR_MUL
+/* acc += x * y, all four partial products; z holds 0 */
+#define FP_MAC16                                                         \
+    "muls  %B[x], %B[y]\n\t"                                             \
+    "add   %C[acc], r0\n\t"                                              \
+    "adc   %D[acc], r1\n\t"                                              \
+    "mul   %A[x], %A[y]\n\t"                                             \
+    "add   %A[acc], r0\n\t"                                              \
+    "adc   %B[acc], r1\n\t"                                              \
+    "adc   %C[acc], %[z]\n\t"                                            \
+    "adc   %D[acc], %[z]\n\t"                                            \
+    "mulsu %B[x], %A[y]\n\t"                                             \
+    "sbc   %D[acc], %[z]\n\t"                                            \
+    "add   %B[acc], r0\n\t"                                              \
+    "adc   %C[acc], r1\n\t"                                              \
+    "adc   %D[acc], %[z]\n\t"                                            \
+    "mulsu %B[y], %A[x]\n\t"                                             \
+    "sbc   %D[acc], %[z]\n\t"                                            \
+    "add   %B[acc], r0\n\t"                                              \
+    "adc   %C[acc], r1\n\t"                                              \
+    "adc   %D[acc], %[z]\n\t"
+#endif
+
+/* acc + sum of a[i] * b[i] */
+static int32_t mac16(int32_t acc, const int16_t *a, const int16_t *b,
+                     uint16_t n) {
+    if (n == 0) {
+        return acc;
+    }
+#if defined(FP_AVR_MUL)
+    int16_t x, y;
+    uint8_t z;
+    /* 34 cycles per element: 4 loads, 4 multiplies, 14 adds, loop */
+    __asm__ __volatile__(
+        "clr   %[z]\n"
+        "1:\n\t"
+        "ld    %A[x], %a[pa]+\n\t"
+        "ld    %B[x], %a[pa]+\n\t"
+        "ld    %A[y], %a[pb]+\n\t"
+        "ld    %B[y], %a[pb]+\n\t"
+        FP_MAC16
+        "sbiw  %[n], 1\n\t"
+        "brne  1b\n\t"
+        "clr   __zero_reg__"
+        : [acc] "+r"(acc), [pa] "+x"(a), [pb] "+z"(b), [n] "+w"(n),
+          [x] "=&a"(x), [y] "=&a"(y), [z] "=&r"(z)
+        :
+        : "memory");
+#elif defined(FP_ARM_DSP)
+    for (; n >= 2; n -= 2, a += 2, b += 2) {
+        int32_t pa, pb;
+        memcpy(&pa, a, sizeof pa);          /* Halfword alignment is enough */
+        memcpy(&pb, b, sizeof pb);
+        acc = __smlad(pa, pb, acc);
+    }
+    if (n) {
+        acc += (int32_t)*a * *b;
+    }
+#else
+    while (n--) {
+        acc += (int32_t)*a++ * *b++;
+    }
+#endif
+    return acc;
+}
+
+/* x * y * 2: the Q15 product in Q1.31, -1 * -1 wrapping to INT32_MIN */
+static inline int32_t fmul16(int16_t x, int16_t y) {
+#if defined(FP_AVR_MUL)
+    int32_t p;
+    uint8_t z;
+    __asm__(
+        "clr    %[z]\n\t"
+        "fmuls  %B[x], %B[y]\n\t"
+        "movw   %C[p], r0\n\t"
+        "fmul   %A[x], %A[y]\n\t"
+        "adc    %C[p], %[z]\n\t"
+        "movw   %A[p], r0\n\t"
+        "fmulsu %B[x], %A[y]\n\t"
+        "sbc    %D[p], %[z]\n\t"
+        "add    %B[p], r0\n\t"
+        "adc    %C[p], r1\n\t"
+        "adc    %D[p], %[z]\n\t"
+        "fmulsu %B[y], %A[x]\n\t"
+        "sbc    %D[p], %[z]\n\t"
+        "add    %B[p], r0\n\t"
+        "adc    %C[p], r1\n\t"
+        "adc    %D[p], %[z]\n\t"
+        "clr    __zero_reg__"
+        : [p] "=&r"(p), [z] "=&r"(z)
+        : [x] "a"(x), [y] "a"(y));
+    return p;
+#else
+    return (int32_t)((uint32_t)((int32_t)x * y) << 1);
+#endif
+}
+
+/* Saturating 16-bit add, shared by both formats */
+static void add16(const int16_t *a, const int16_t *b, int16_t *y,
+                  uint16_t n) {
+#if defined(FP_ARM_DSP)
+    for (; n >= 2; n -= 2, a += 2, b += 2, y += 2) {
+        int32_t pa, pb, r;
+        memcpy(&pa, a, sizeof pa);
+        memcpy(&pb, b, sizeof pb);
+        r = __qadd16(pa, pb);
+        memcpy(y, &r, sizeof r);
+    }
+#endif
+    while (n--) {
+        *y++ = sat16((int32_t)*a++ + *b++);
+    }
+}
+
+/*─────────────────────────── Q8.8 ─────────────────────────────────*/
+
+q8_8_t q8_8_dot(const q8_8_t *a, const q8_8_t *b, uint16_t n) {
+    return round_sat(mac16(0, a, b, n), 8);
+}
+
+void q8_8_scale(const q8_8_t *x, q8_8_t k, q8_8_t *y, uint16_t n) {
+    while (n--) {
+        int16_t v = *x++;
+        *y++ = round_sat(mac16(0, &v, &k, 1), 8);
+    }
+}
+
+void q8_8_add(const q8_8_t *a, const q8_8_t *b, q8_8_t *y, uint16_t n) {
+    add16(a, b, y, n);
+}
+
+/*─────────────────────────── Q15 ──────────────────────────────────*/
+
+q15_t q15_from_acc(int32_t acc) {
+    return round_sat(acc, 15);
+}
+
+q15_t q15_mul(q15_t a, q15_t b) {
+    int32_t p = fmul16(a, b);
+    if (p == INT32_MIN) {
+        return Q15_MAX;                     /* Only -1 * -1 lands here */
+    }
+    return (q15_t)((p + 0x8000) >> 16);
+}
+
+int32_t q15_mac(int32_t acc, const q15_t *a, const q15_t *b, uint16_t n) {
+    return mac16(acc, a, b, n);
+}
+
+q15_t q15_dot(const q15_t *a, const q15_t *b, uint16_t n) {
+    return q15_from_acc(mac16(0, a, b, n));
+}
+
+void q15_scale(const q15_t *x, q15_t k, q15_t *y, uint16_t n) {
+    while (n--) {
+        *y++ = q15_mul(*x++, k);
+    }
+}
+
+void q15_add(const q15_t *a, const q15_t *b, q15_t *y, uint16_t n) {
+    add16(a, b, y, n);
+}
+
+void q15_fir_init(q15_fir_t *f, const q15_t *h, q15_t *delay, uint16_t ntaps) {
+    f->h = h;
+    f->delay = delay;
+    f->ntaps = ntaps;
+    f->pos = 0;
+    for (uint16_t i = 0; i < 2u * ntaps; i++) {
+        delay[i] = 0;
+    }
+}
+
+void q15_fir(q15_fir_t *f, const q15_t *x, q15_t *y, uint16_t n) {
+    uint16_t taps = f->ntaps;
+    uint16_t pos = f->pos;
+    q15_t *d = f->delay;
+
+    while (n--) {
+        /* Step back one slot: d[pos..pos+taps-1] is newest to oldest */
+        pos = pos ? pos - 1u : taps - 1u;
+        d[pos] = d[pos + taps] = *x++;
+        *y++ = q15_from_acc(mac16(0, f->h, d + pos, taps));
+    }
+    f->pos = pos;
+}
+
+void q15_biquad(q15_biquad_t *f, const q15_t *x, q15_t *y, uint16_t n) {
+    q15_t w[5];                             /* x[n], then the state */
+
+    w[1] = f->s[0];
+    w[2] = f->s[1];
+    w[3] = f->s[2];
+    w[4] = f->s[3];
+    while (n--) {
+        w[0] = *x++;
+        q15_t out = round_sat(mac16(0, f->c, w, 5), 14);
+        w[2] = w[1];
+        w[1] = w[0];
+        w[4] = w[3];
+        w[3] = out;
+        *y++ = out;
+    }
+    f->s[0] = w[1];
+    f->s[1] = w[2];
+    f->s[2] = w[3];
+    f->s[3] = w[4];
+}
@@ -8,8 +8,11 @@
 #if CONFIG_FS_ENABLED
 
 #include <errno.h>
+#include <stdbool.h>
 #include <string.h>
 
+#include "arch/common/hal.h"
+
 #ifndef HAVE_STRNLEN
 /* -------------------------------------------------------------------------
  * Portable fallback for systems lacking strnlen().
@@ -26,36 +29,87 @@ static size_t local_strnlen(const char *s, size_t max)
 #define strnlen local_strnlen
 #endif
 
-/** Simple in-memory disk image. Each block is \c FS_BLOCK_SIZE bytes. */
-static uint8_t disk[FS_NUM_BLOCKS][FS_BLOCK_SIZE];
+/** Simple in-memory disk image. Each block is \c FS_BLOCK_SIZE bytes;
+ *  aligned so an indirect block can be read as uint16_t addresses. */
+static _Alignas(uint16_t) uint8_t disk[FS_NUM_BLOCKS][FS_BLOCK_SIZE];
 
 /** Bitmap tracking used blocks. One bit per block. */
 static uint8_t bitmap[FS_NUM_BLOCKS / 8];
 
+/** No bitmap byte below this one has a free bit. */
+static uint8_t bhint;
+
+_Static_assert(FS_NUM_BLOCKS % 8 == 0, "bitmap bytes must be full");
+_Static_assert(FS_NUM_BLOCKS <= 256, "block numbers are scanned as uint8_t");
+
 /** Array of inodes. inode 0 is reserved for the root directory. */
 static dinode_t inodes[FS_NUM_INODES];
 
 /** Simple flat directory mapping inode numbers to filenames. */
 static char dir_name[FS_NUM_INODES][FS_MAX_NAME + 1];
 
-/** Helper: allocate a free block. Returns block number or -1. */
+/**
+ * Helper: allocate a free block. Returns block number or -1.
+ *
+ * Full bitmap bytes are skipped whole, starting at the hint, and the
+ * lowest clear bit of the first other byte is found with ctz.
+ */
 static int balloc(void) {
-    for (uint8_t i = 0; i < FS_NUM_BLOCKS; ++i) {
-        uint8_t byte = bitmap[i >> 3];
-        uint8_t mask = 1u << (i & 7);
-        if (!(byte & mask)) {
-            bitmap[i >> 3] |= mask;
-            memset(disk[i], 0, FS_BLOCK_SIZE);
-            return i;
+    for (uint8_t i = bhint; i < sizeof bitmap; ++i) {
+        uint8_t freeb = (uint8_t)~bitmap[i];
+        if (freeb) {
+            uint8_t b = (uint8_t)(i * 8u + (uint8_t)__builtin_ctz(freeb));
+            bitmap[i] |= (uint8_t)(freeb & -freeb);
+            bhint = i;
+            hal_memset_fast(disk[b], 0, FS_BLOCK_SIZE);
+            return b;
         }
     }
+    bhint = sizeof bitmap;                  /* full until a bfree() */
     return -1;
 }
 
 /** Helper: free a previously allocated block. */
-static void bfree(uint8_t b) __attribute__((unused));
 static void bfree(uint8_t b) {
     bitmap[b >> 3] &= ~(1u << (b & 7));
+    if ((b >> 3) < bhint) {
+        bhint = b >> 3;
+    }
+}
+
+/**
+ * Helper: disk block holding block @p bn of inode @p d.
+ *
+ * With @p alloc, missing blocks (and the indirect block) are allocated.
+ * Returns the block number, or -1 past the end of what is mapped.
+ */
+static int bmap(dinode_t *d, uint16_t bn, bool alloc) {
+    uint16_t *slot;
+
+    if (bn < FS_NDIRECT) {
+        slot = &d->addrs[bn];
+    } else if (bn < FS_MAX_FILE_BLOCKS) {
+        if (d->indirect == 0) {
+            int ib = alloc ? balloc() : -1;
+            if (ib < 0) {
+                return -1;
+            }
+            d->indirect = (uint16_t)ib;
+        }
+        uint16_t *ind = (uint16_t *)(void *)disk[d->indirect];
+        slot = &ind[bn - FS_NDIRECT];
+    } else {
+        return -1; /* no double-indirect blocks */
+    }
+
+    if (*slot == 0) {
+        int b = alloc ? balloc() : -1;
+        if (b < 0) {
+            return -1;
+        }
+        *slot = (uint16_t)b;
+    }
+    return *slot;
 }
 
 
@@ -67,6 +121,7 @@ static int ialloc(uint8_t type) {
             inodes[i].nlink = 1;
             inodes[i].size = 0;
             memset(inodes[i].addrs, 0, sizeof inodes[i].addrs);
+            inodes[i].indirect = 0;
             return i;
         }
     }
@@ -76,6 +131,7 @@ static int ialloc(uint8_t type) {
 void fs_init(void) {
     memset(disk, 0, sizeof disk);
     memset(bitmap, 0, sizeof bitmap);
+    bhint = 0;
     memset(inodes, 0, sizeof inodes);
     memset(dir_name, 0, sizeof dir_name);
 
@@ -142,24 +198,17 @@ int fs_write(file_t *f, const void *buf, uint16_t len) {
     uint16_t remaining = len;
 
     while (remaining > 0) {
-        uint8_t block_index = f->off / FS_BLOCK_SIZE;
-        if (block_index >= (sizeof d->addrs / sizeof d->addrs[0])) {
-            return len - remaining; /* no space for indirect blocks */
+        int b = bmap(d, f->off / FS_BLOCK_SIZE, true);
+        if (b < 0) {
+            break; /* out of blocks or past the largest file */
         }
-        if (d->addrs[block_index] == 0) {
-            int b = balloc();
-            if (b < 0) {
-                return len - remaining; /* out of blocks */
-            }
-            d->addrs[block_index] = b;
-        }
-        uint8_t *blk = disk[d->addrs[block_index]];
+        uint8_t *blk = disk[b];
         uint16_t off_in_block = f->off % FS_BLOCK_SIZE;
         uint16_t to_copy = FS_BLOCK_SIZE - off_in_block;
         if (to_copy > remaining) {
             to_copy = remaining;
         }
-        memcpy(blk + off_in_block, p, to_copy);
+        hal_memcpy_fast(blk + off_in_block, p, to_copy);
         f->off += to_copy;
         p += to_copy;
         remaining -= to_copy;
@@ -167,7 +216,7 @@ int fs_write(file_t *f, const void *buf, uint16_t len) {
     if (f->off > d->size) {
         d->size = f->off;
     }
-    return len;
+    return len - remaining;
 }
 
 int fs_read(file_t *f, void *buf, uint16_t len) {
@@ -184,20 +233,17 @@ int fs_read(file_t *f, void *buf, uint16_t len) {
 
     uint16_t read_len = remaining;
     while (remaining > 0) {
-        uint8_t block_index = f->off / FS_BLOCK_SIZE;
-        if (block_index >= (sizeof d->addrs / sizeof d->addrs[0])) {
-            break;
-        }
-        if (d->addrs[block_index] == 0) {
+        int b = bmap(d, f->off / FS_BLOCK_SIZE, false);
+        if (b < 0) {
             break;
         }
-        uint8_t *blk = disk[d->addrs[block_index]];
+        uint8_t *blk = disk[b];
         uint16_t off_in_block = f->off % FS_BLOCK_SIZE;
         uint16_t to_copy = FS_BLOCK_SIZE - off_in_block;
         if (to_copy > remaining) {
             to_copy = remaining;
         }
-        memcpy(p, blk + off_in_block, to_copy);
+        hal_memcpy_fast(p, blk + off_in_block, to_copy);
         f->off += to_copy;
         p += to_copy;
         remaining -= to_copy;
@@ -258,12 +304,22 @@ int fs_unlink(const char *name) {
         if (inodes[i].type && strncmp(dir_name[i], name, FS_MAX_NAME) == 0) {
             dinode_t *d = &inodes[i];
 
-            for (size_t j = 0; j < sizeof d->addrs / sizeof d->addrs[0]; ++j) {
+            for (size_t j = 0; j < FS_NDIRECT; ++j) {
                 if (d->addrs[j]) {
                     bfree(d->addrs[j]);
                     d->addrs[j] = 0;
                 }
             }
+            if (d->indirect) {
+                const uint16_t *ind = (const uint16_t *)(const void *)disk[d->indirect];
+                for (size_t j = 0; j < FS_NINDIRECT; ++j) {
+                    if (ind[j]) {
+                        bfree(ind[j]);
+                    }
+                }
+                bfree(d->indirect);
+                d->indirect = 0;
+            }
 
             memset(d, 0, sizeof *d);
             dir_name[i][0] = '\0';
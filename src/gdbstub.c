@@ -11,8 +11,10 @@
 #ifndef F_CPU
 #  define F_CPU 16000000UL
 #endif
-#define BAUD 115200
-#define UBRR_VAL ((F_CPU / 16 / BAUD) - 1)
+#ifndef GDBSTUB_BAUD
+#  define GDBSTUB_BAUD 115200UL
+#endif
+#define UBRR_VAL ((F_CPU / 16 / GDBSTUB_BAUD) - 1)
 
 static void uart_init(void)
 {
@@ -22,11 +22,13 @@
 
 /* Kernel subsystems */
 #include "../kernel/sched/scheduler.h"
+#include "../kernel/sched/nk_boot.h"
 #include "../kernel/mm/kalloc.h"
 #include "../drivers/tty/tty.h"
 #include "../drivers/fs/vfs.h"
 #include "../drivers/fs/romfs.h"
 #include "../drivers/fs/eepfs.h"
+#include "../kernel/lib/nk_warm.h"
 
 /* HAL */
 #include "../arch/common/hal.h"
@@ -80,6 +82,18 @@ static tty_t console_tty;
  */
 static volatile bool kernel_booted = false;
 
+/**
+ * Boot phases stamped with nk_boot_mark() (-Ddebug_boot_prof=true);
+ * read nk_boot_log from the debugger for the cycles each one took
+ */
+enum {
+    BOOT_PHASE_HW = 0,
+    BOOT_PHASE_KERNEL,
+    BOOT_PHASE_BANNER,
+    BOOT_PHASE_TASKS,
+    BOOT_PHASE_SCHED
+};
+
 /*═══════════════════════════════════════════════════════════════════════
  * HAL UART CALLBACKS (for TTY driver)
  *═══════════════════════════════════════════════════════════════════════*/
@@ -137,6 +151,12 @@ static void hardware_init(void)
     /* Disable interrupts during initialization */
     cli();
 
+    /* Reset cause, watchdog off, cycle counter for the boot stamps */
+    hal_init();
+
+    /* After a watchdog/software reset, .noinit state may be resumed */
+    nk_warm_init(hal_reset_reason());
+
     /* Initialize UART for console I/O */
     uart_init();
 
@@ -152,23 +172,73 @@ static void hardware_init(void)
  * KERNEL INITIALIZATION
  *═══════════════════════════════════════════════════════════════════════*/
 
-/**
- * @brief Initialize kernel subsystems
+/*
+ * Each subsystem is an nk_boot_item_t: the eager ones run here in
+ * priority order, the background ones from main_task once the
+ * scheduler is up, so mounting (and the EEPFS wear-levelling scan) is
+ * off the path every wake-up from power-down takes.
  */
-static void kernel_init(void)
+
+static bool boot_kalloc(void)
 {
-    /* Initialize memory allocator */
     kalloc_init();
+    return true;
+}
 
-    /* Initialize virtual filesystem */
+static bool boot_vfs(void)
+{
     vfs_init();
+    return true;
+}
 
-    /* TODO: Mount ROMFS and EEPFS (when filesystem data available) */
-    /* vfs_mount(VFS_TYPE_ROMFS, "/rom"); */
-    /* vfs_mount(VFS_TYPE_EEPFS, "/eeprom"); */
-
-    /* Initialize scheduler */
+static bool boot_sched(void)
+{
     scheduler_init();
+    return true;
+}
+
+static nk_boot_item_t kalloc_item = NK_BOOT_ITEM(boot_kalloc, 0, NK_BOOT_EAGER);
+static nk_boot_item_t vfs_item    = NK_BOOT_ITEM(boot_vfs, 10, NK_BOOT_EAGER);
+static nk_boot_item_t sched_item  = NK_BOOT_ITEM(boot_sched, 20, NK_BOOT_EAGER);
+
+#if CONFIG_FS_ROMFS_ENABLED
+static bool boot_romfs(void)
+{
+    return vfs_mount(VFS_TYPE_ROMFS, "/rom") == 0;
+}
+
+static nk_boot_item_t romfs_item = NK_BOOT_ITEM(boot_romfs, 30, NK_BOOT_BACKGROUND);
+#endif
+
+#if CONFIG_FS_EEPFS_ENABLED
+static bool boot_eepfs(void)
+{
+    if (vfs_mount(VFS_TYPE_EEPFS, "/eeprom") != 0)
+        return false;
+    eepfs_mount();              /* rebuild (or resume) the block map now */
+    return true;
+}
+
+static nk_boot_item_t eepfs_item = NK_BOOT_ITEM(boot_eepfs, 40, NK_BOOT_BACKGROUND);
+#endif
+
+/**
+ * @brief Initialize kernel subsystems
+ */
+static void kernel_init(void)
+{
+    nk_boot_register(&kalloc_item);
+    nk_boot_register(&vfs_item);
+    nk_boot_register(&sched_item);
+#if CONFIG_FS_ROMFS_ENABLED
+    nk_boot_register(&romfs_item);
+#endif
+#if CONFIG_FS_EEPFS_ENABLED
+    nk_boot_register(&eepfs_item);
+#endif
+
+    /* Allocator, VFS and scheduler; mounts are deferred to main_task */
+    nk_boot_run();
 
     /* Kernel is now ready */
     kernel_booted = true;
@@ -217,6 +287,11 @@ static void main_task(void)
 {
     uint32_t counter = 0;
 
+    /* Deferred initialization (mounts) before any real work */
+    while (nk_boot_step()) {
+        nk_yield();
+    }
+
     /* Main idle loop */
     while (1) {
         /* Heartbeat every 1000 iterations */
@@ -262,21 +337,25 @@ int main(void)
     /*───────────────────────────────────────────────────────────────
      * 1. HARDWARE INITIALIZATION
      *───────────────────────────────────────────────────────────────*/
+    nk_boot_mark(BOOT_PHASE_HW);
     hardware_init();
 
     /*───────────────────────────────────────────────────────────────
      * 2. KERNEL INITIALIZATION
      *───────────────────────────────────────────────────────────────*/
+    nk_boot_mark(BOOT_PHASE_KERNEL);
     kernel_init();
 
     /*───────────────────────────────────────────────────────────────
      * 3. BOOT BANNER
      *───────────────────────────────────────────────────────────────*/
+    nk_boot_mark(BOOT_PHASE_BANNER);
     print_boot_banner();
 
     /*───────────────────────────────────────────────────────────────
      * 4. CREATE MAIN TASK (PSE51: single-threaded)
      *───────────────────────────────────────────────────────────────*/
+    nk_boot_mark(BOOT_PHASE_TASKS);
     bool created = nk_task_create(
         &main_task_tcb,         /* TCB */
         main_task,              /* Entry point */
@@ -305,6 +384,7 @@ int main(void)
         uart_putc((uint8_t)hal_pgm_read_byte(&starting[i]));
     }
 
+    nk_boot_mark(BOOT_PHASE_SCHED);
     scheduler_run();  /* Enable interrupts and start scheduling */
 
     /* Should never reach here */
@@ -325,25 +405,6 @@ void __attribute__((weak)) __bad_interrupt(void)
     while (1);
 }
 
-/**
- * @brief UART RX Complete interrupt (optional, for interrupt-driven RX)
- */
-ISR(USART_RX_vect, ISR_BLOCK)
-{
-    /* Read byte from UART */
-    uint8_t c = UDR0;
-
-    /* Push to TTY RX buffer */
-    /* TODO: tty_rx_push(&console_tty, c); */
-    (void)c;  /* Suppress unused warning for now */
-}
-
-/**
- * @brief UART TX Complete interrupt (optional, for interrupt-driven TX)
- */
-ISR(USART_UDRE_vect, ISR_BLOCK)
-{
-    /* TODO: Pop from TTY TX buffer and send */
-    /* For now, disable interrupt (not using interrupt-driven TX yet) */
-    UCSR0B &= ~(1 << UDRIE0);
-}
+/* USART RX/UDRE: see hal_uart_attach() for the interrupt-driven console.
+ * The boot console here stays polled: it prints before interrupts are
+ * enabled. */
@@ -5,57 +5,85 @@
 /*───────────────────────── nk_fs.c ────────────────────────────
  * TinyLog-4  – 64-byte wear-levelled log for ATmega328P EEPROM.
  *──────────────────────────────────────────────────────────────*/
-#include "nk_fs.h"
 #include "avrix-config.h"
+#include "nk_fs.h"
+#include "arch/common/hal.h"
 
-#if CONFIG_FS_EEPFS_ENABLED && defined(__AVR__)
+#if CONFIG_FS_EEPFS_ENABLED && \
+    (defined(__AVR__) || defined(HAL_ARCH_HOST) || defined(NK_FS_EE_READ))
 
-#include <avr/eeprom.h>
-#include <avr/pgmspace.h>
+#include "kernel/lib/nk_crc.h"
+#include "kernel/lib/nk_warm.h"
 #include <stdbool.h>
 #include <stdint.h>
 
+/* EEPROM access; tests point these at a RAM image */
+#ifndef NK_FS_EE_READ
+#  if defined(__AVR__)
+#    include <avr/eeprom.h>
+#    define NK_FS_EE_READ(a)     eeprom_read_byte(ee_cptr(a))
+#    define NK_FS_EE_WRITE(a, v) eeprom_update_byte(ee_ptr(a), v)
+#  else                          /* the host HAL's mmap'd image */
+#    define NK_FS_EE_READ(a)     hal_eeprom_read_byte(a)
+#    define NK_FS_EE_WRITE(a, v) hal_eeprom_update_byte(a, v)
+#  endif
+#endif
+
 /* ─── 0 · Tunables ──────────────────────────────────────────── */
-enum : uint8_t {
+enum {
     ROWS        = 16,
     ROW_SZ      = 64,
     BLK_SZ      = 4,
+    ROW_BLKS    = 15,                           /* block 15 = header */
     DATA_BLKS   = (ROWS * (ROW_SZ / BLK_SZ)),   /* 256 logical blocks */
     TAG_PUT     = 0x01,
     TAG_DEL     = 0x02,
     TAG_ROW     = 0x7F,
     HDR_SEQ_OFF = ROW_SZ - 2,
     HDR_TAG_OFF = ROW_SZ - 1,
+    LIVE_MAX    = (ROWS - 2) * ROW_BLKS,    /* leaves GC two rows of slack */
 };
 
-#ifndef NK_FS_SMALL_CRC          /* set to 1 to drop LUT (smaller flash) */
-#  define NK_FS_SMALL_CRC 0
+_Static_assert(NK_FS_INDEX <= 255, "NK_FS_INDEX must fit a uint8_t slot");
+_Static_assert(NK_FS_BLOOM <= 256, "NK_FS_BLOOM is at most 256 bytes");
+
+typedef struct {
+    uint8_t tag, d0, d1, crc;
+} rec_t;
+
+/* ─── 1 · State ───────────────────────────────────────────────
+ * Everything mount derives from the EEPROM, in one block so that with
+ * NK_WARM it sits in .noinit and a warm reset skips the mount.
+ */
+#if NK_FS_INDEX > 0
+/* open addressing, linear probing; loc = row << 4 | block */
+typedef struct {
+    uint16_t key;                /* IDX_EMPTY = free */
+    uint8_t  loc;
+} idx_ent_t;
 #endif
 
-/* ─── 1 · State ─────────────────────────────────────────────── */
-static uint8_t cur_row = 0;      /* row currently writable      */
-static uint8_t cur_idx = 0;      /* next DATA block inside row  */
+static struct {
+    uint8_t   cur_row;           /* row currently writable      */
+    uint8_t   cur_idx;           /* next DATA block inside row  */
+    uint8_t   gc_pos;            /* next block of the row to erase   */
+    uint8_t   gc_left;           /* ≥ live records in it from gc_pos */
+    uint8_t   live_keys;         /* keys with a value in the log     */
+#if NK_FS_INDEX > 0
+    bool      idx_overflow;      /* some live key is not in the table */
+    idx_ent_t idx_tab[NK_FS_INDEX];
+#endif
+#if NK_FS_BLOOM > 0
+    uint8_t   bloom[NK_FS_BLOOM];
+#endif
+} fs NK_WARM_DATA;
 
-/* ─── 2 · CRC-8 helpers (Dallas/Maxim poly 0x31) ────────────── */
-#if !NK_FS_SMALL_CRC
-static const uint8_t LUT[32] PROGMEM = {
-    0x00,0x31,0x62,0x53,0xC4,0xF5,0xA6,0x97,
-    0xB9,0x88,0xDB,0xEA,0x7D,0x4C,0x1F,0x2E,
-    0x43,0x72,0x21,0x10,0x87,0xB6,0xE5,0xD4,
-    0xFA,0xCB,0x98,0xA9,0x3E,0x0F,0x5C,0x6D
-};
-static inline uint8_t crc8_update(uint8_t crc, uint8_t in) {
-    crc ^= in;
-    return pgm_read_byte(&LUT[crc & 0x1F]) ^ (crc >> 5);
-}
-#else /* bit-wise fallback → 24 B bigger SRAM, 32 B smaller flash */
+static nk_warm_hdr_t fs_warm NK_WARM_DATA;
+
+/* ─── 2 · CRC-8/MAXIM (kernel/lib/nk_crc.h; crc_strategy sizes it) ── */
 static inline uint8_t crc8_update(uint8_t crc, uint8_t in) {
-    crc ^= in;
-    for (uint8_t i = 0; i < 8; ++i)
-        crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
-    return crc;
+    return nk_crc8_byte(crc, in);
 }
-#endif
 
 static inline uint8_t crc3(uint8_t tag, uint8_t d0, uint8_t d1) {
     return crc8_update(crc8_update(crc8_update(0, tag), d0), d1);
@@ -66,144 +94,619 @@ static inline uint16_t addr(uint8_t row, uint8_t idx) {
     return (uint16_t)row * ROW_SZ + (uint16_t)idx * BLK_SZ;
 }
 
+static inline uint8_t prev_row(uint8_t row) { return (uint8_t)((row - 1U) & 0x0F); }
+static inline uint8_t next_row(uint8_t row) { return (uint8_t)((row + 1U) & 0x0F); }
+
+static inline uint16_t unpack_key(uint8_t d0, uint8_t d1) {
+    return (uint16_t)d0 << 3 | (d1 >> 5);
+}
+static inline uint16_t unpack_val(uint8_t d1) { return d1 & 0x1F; }
+
 /* erase 64-byte row with 0xFF (EEPROM-safe wear levelling) */
 static void erase_row(uint8_t row) {
     uint16_t base = (uint16_t)row * ROW_SZ;
     for (uint8_t i = 0; i < ROW_SZ; ++i)
-        eeprom_update_byte((uint8_t __eeprom *)(base + i), 0xFF);
+        NK_FS_EE_WRITE(base + i, 0xFF);
 }
 
-/* ─── 4 · Row rollover ──────────────────────────────────────── */
-static void open_next_row(void) {
-    const uint8_t next = (uint8_t)((cur_row + 1U) & 0x0F);
-    erase_row(next);
+/* row header → sequence number; false if the row is not in the log */
+static bool row_seq(uint8_t row, uint8_t *seq) {
+    uint16_t base = (uint16_t)row * ROW_SZ;
+    if (NK_FS_EE_READ(base + HDR_TAG_OFF) != TAG_ROW)
+        return false;
+    *seq = NK_FS_EE_READ(base + HDR_SEQ_OFF);
+    return true;
+}
 
-    /* fetch prev sequence, increment (wrap OK) */
-    uint8_t seq = eeprom_read_byte((const uint8_t __eeprom *)
-                    (addr(cur_row, 15) + HDR_SEQ_OFF));
-    seq++;
+static void set_row_seq(uint8_t row, uint8_t seq) {
+    uint16_t base = (uint16_t)row * ROW_SZ;
+    NK_FS_EE_WRITE(base + HDR_SEQ_OFF, seq);
+    NK_FS_EE_WRITE(base + HDR_TAG_OFF, TAG_ROW);
+}
 
-    uint16_t off = (uint16_t)next * ROW_SZ;
-    eeprom_update_byte((uint8_t __eeprom *)(off + HDR_SEQ_OFF), seq);
-    eeprom_update_byte((uint8_t __eeprom *)(off + HDR_TAG_OFF), TAG_ROW);
+/* one 4-byte record; false if unused, torn or corrupt */
+static bool read_rec(uint8_t row, uint8_t idx, rec_t *r) {
+    const uint16_t a = addr(row, idx);
+    r->tag = NK_FS_EE_READ(a);
+    r->d0  = NK_FS_EE_READ(a + 1);
+    r->d1  = NK_FS_EE_READ(a + 2);
+    r->crc = NK_FS_EE_READ(a + 3);
+    return (r->tag == TAG_PUT || r->tag == TAG_DEL) &&
+           r->crc == crc3(r->tag, r->d0, r->d1);
+}
 
-    cur_row = next;
-    cur_idx = 0;
+#if NK_FS_INDEX > 0 || NK_FS_BLOOM > 0
+/* oldest row of the log: follow consecutive headers back from cur_row */
+static uint8_t first_row(void) {
+    uint8_t r = fs.cur_row, seq, s;
+    if (!row_seq(r, &seq))
+        return r;
+    for (uint8_t n = 1; n < ROWS; ++n) {
+        uint8_t p = prev_row(r);
+        if (!row_seq(p, &s) || (uint8_t)(s + 1U) != seq)
+            break;
+        r = p;
+        seq = s;
+    }
+    return r;
 }
+#endif
 
-/* ─── 5 · Public API ────────────────────────────────────────── */
-void nk_fs_init(void) {
-    uint8_t best_seq = 0;
-    cur_row = 0;
+#define LOC_NONE 0xFFu           /* (15, 15) is a header, never a record */
 
-    /* scan all row headers → pick newest by signed delta */
-    for (uint8_t r = 0; r < ROWS; ++r) {
-        uint16_t hdr = addr(r, 15);
-        if (eeprom_read_byte((const uint8_t __eeprom *)(hdr + HDR_TAG_OFF)) == TAG_ROW) {
-            uint8_t seq = eeprom_read_byte((const uint8_t __eeprom *)(hdr + HDR_SEQ_OFF));
-            if ((int8_t)(seq - best_seq) > 0) {  /* signed distance */
-                best_seq = seq;
-                cur_row  = r;
-            }
+/* slot of the newest record for @p key, walking the log backwards */
+static uint8_t scan_newest(uint16_t key, rec_t *rec) {
+    uint8_t r = fs.cur_row, n = fs.cur_idx, seq = 0, s;
+    bool chained = row_seq(r, &seq);
+
+    for (uint8_t rows = 0; rows < ROWS; ++rows) {
+        while (n--) {
+            if (read_rec(r, n, rec) && unpack_key(rec->d0, rec->d1) == key)
+                return (uint8_t)(r << 4 | n);
         }
+        uint8_t p = prev_row(r);
+        if (!chained || !row_seq(p, &s) || (uint8_t)(s + 1U) != seq)
+            break;                           /* start of the log */
+        r = p;
+        seq = s;
+        n = ROW_BLKS;
     }
+    return LOC_NONE;
+}
 
-    /* locate first free slot in current row */
-    cur_idx = 0;
-    for (uint8_t i = 0; i < 15; ++i) {
-        uint16_t a  = addr(cur_row, i);
-        uint8_t  t  = eeprom_read_byte((const uint8_t __eeprom *)a);
-        uint8_t  d0 = eeprom_read_byte((const uint8_t __eeprom *)(a + 1));
-        uint8_t  d1 = eeprom_read_byte((const uint8_t __eeprom *)(a + 2));
-        uint8_t  c  = eeprom_read_byte((const uint8_t __eeprom *)(a + 3));
-        if (c != crc3(t, d0, d1)) {          /* corruption / unused */
-            cur_idx = i;
+/* ─── 4 · RAM index ─────────────────────────────────────────── */
+#if NK_FS_INDEX > 0
+#define IDX_EMPTY 0xFFFFu
+
+
+static inline uint8_t idx_home(uint16_t key) { return (uint8_t)(key % NK_FS_INDEX); }
+static inline uint8_t idx_next(uint8_t i) {
+    return (uint8_t)(i + 1U == NK_FS_INDEX ? 0U : i + 1U);
+}
+
+/* slot holding @p key, or NK_FS_INDEX */
+static uint8_t idx_find(uint16_t key) {
+    uint8_t i = idx_home(key);
+    for (uint8_t n = 0; n < NK_FS_INDEX; ++n, i = idx_next(i)) {
+        if (fs.idx_tab[i].key == key)
+            return i;
+        if (fs.idx_tab[i].key == IDX_EMPTY)
+            break;
+    }
+    return NK_FS_INDEX;
+}
+
+static void idx_set(uint16_t key, uint8_t loc) {
+    uint8_t i = idx_home(key);
+    for (uint8_t n = 0; n < NK_FS_INDEX; ++n, i = idx_next(i)) {
+        if (fs.idx_tab[i].key == key || fs.idx_tab[i].key == IDX_EMPTY) {
+            fs.idx_tab[i].key = key;
+            fs.idx_tab[i].loc = loc;
             return;
         }
     }
-    open_next_row();                         /* row full → next row */
+    fs.idx_overflow = true;         /* lookups of unindexed keys walk the log */
 }
 
+/* free slot @p i, pulling later members of its probe run back */
+static void idx_remove_at(uint8_t i) {
+    uint8_t j = i;
+    for (uint8_t n = 1; n < NK_FS_INDEX; ++n) {
+        j = idx_next(j);
+        if (fs.idx_tab[j].key == IDX_EMPTY)
+            break;
+        uint8_t h = idx_home(fs.idx_tab[j].key);
+        bool stays = (i <= j) ? (i < h && h <= j) : (i < h || h <= j);
+        if (!stays) {
+            fs.idx_tab[i] = fs.idx_tab[j];
+            i = j;
+        }
+    }
+    fs.idx_tab[i].key = IDX_EMPTY;
+}
+
+static void idx_drop(uint16_t key) {
+    uint8_t i = idx_find(key);
+    if (i < NK_FS_INDEX)
+        idx_remove_at(i);
+}
+
+/* forget records of a row about to be erased */
+static void idx_drop_row(uint8_t row) {
+    for (uint8_t i = 0; i < NK_FS_INDEX; ++i) {
+        while (fs.idx_tab[i].key != IDX_EMPTY && (fs.idx_tab[i].loc >> 4) == row)
+            idx_remove_at(i);
+    }
+}
+#endif /* NK_FS_INDEX > 0 */
+
+#if NK_FS_BLOOM > 0
+
+static inline uint16_t bloom_bit(uint16_t key, uint16_t mul) {
+    return (uint16_t)((uint16_t)(key * mul) >> 5) % (NK_FS_BLOOM * 8U);
+}
+
+static void bloom_add(uint16_t key) {
+    uint16_t a = bloom_bit(key, 40503U), b = bloom_bit(key, 13577U);
+    fs.bloom[a >> 3] |= (uint8_t)(1U << (a & 7));
+    fs.bloom[b >> 3] |= (uint8_t)(1U << (b & 7));
+}
+
+static bool bloom_maybe(uint16_t key) {
+    uint16_t a = bloom_bit(key, 40503U), b = bloom_bit(key, 13577U);
+    return (fs.bloom[a >> 3] >> (a & 7) & 1U) && (fs.bloom[b >> 3] >> (b & 7) & 1U);
+}
+#endif /* NK_FS_BLOOM > 0 */
+
+/* account for a record that is now the newest for its key */
+static inline void note_rec(uint8_t row, uint8_t idx, const rec_t *r) {
+    const uint16_t key = unpack_key(r->d0, r->d1);
+    (void)row; (void)idx; (void)key;
+#if NK_FS_INDEX > 0
+    if (r->tag == TAG_PUT)
+        idx_set(key, (uint8_t)(row << 4 | idx));
+    else
+        idx_drop(key);
+#endif
+#if NK_FS_BLOOM > 0
+    if (r->tag == TAG_PUT)
+        bloom_add(key);
+#endif
+}
+
+static void index_clear(void) {
+#if NK_FS_INDEX > 0
+    for (uint8_t i = 0; i < NK_FS_INDEX; ++i)
+        fs.idx_tab[i].key = IDX_EMPTY;
+    fs.idx_overflow = false;
+#endif
+#if NK_FS_BLOOM > 0
+    for (uint16_t i = 0; i < NK_FS_BLOOM; ++i)
+        fs.bloom[i] = 0;
+#endif
+}
+
+#if NK_FS_INDEX > 0 || NK_FS_BLOOM > 0
+/* apply rows from @p r up to cur_idx of cur_row; @p drop: r was erased first */
+static void index_replay(uint8_t r, bool drop) {
+    for (;; r = next_row(r), drop = true) {
+#if NK_FS_INDEX > 0
+        if (drop)
+            idx_drop_row(r);             /* as open_next_row() did */
+#endif
+        const uint8_t n = (r == fs.cur_row) ? fs.cur_idx : ROW_BLKS;
+        for (uint8_t i = 0; i < n; ++i) {
+            rec_t rec;
+            if (read_rec(r, i, &rec))
+                note_rec(r, i, &rec);
+        }
+        if (r == fs.cur_row)
+            break;
+    }
+}
+#endif
+
+/* replay the whole log, oldest record first */
+static void index_rebuild(void) {
+    index_clear();
+#if NK_FS_INDEX > 0 || NK_FS_BLOOM > 0
+    index_replay(first_row(), false);
+#endif
+}
+
+/* ─── 4b · Checkpoint ──────────────────────────────────────────
+ * Every ROWS / 2 rows, open_next_row() saves the index and bloom filter
+ * to one of two slots at NK_FS_CKPT_ADDR, alternately.  Mount restores
+ * the newest slot whose row still carries the saved sequence number and
+ * replays only the rows written since, instead of the whole log.
+ */
+#if NK_FS_CHECKPOINT && (NK_FS_INDEX > 0 || NK_FS_BLOOM > 0)
+#define CKPT       1
+#define CKPT_MAGIC 0xC7u
+#define CKPT_SZ    (4u + 3u * NK_FS_INDEX + NK_FS_BLOOM + 1u)  /* + CRC */
+#define CKPT_EVERY (ROWS / 2u)
+
+static inline uint16_t ckpt_addr(uint8_t slot) {
+    return (uint16_t)(NK_FS_CKPT_ADDR + slot * CKPT_SZ);
+}
+
+static inline uint16_t ckpt_put(uint16_t a, uint8_t v, uint8_t *crc) {
+    NK_FS_EE_WRITE(a, v);
+    *crc = crc8_update(*crc, v);
+    return (uint16_t)(a + 1U);
+}
+
+static inline uint8_t ckpt_get(uint16_t *a, uint8_t *crc) {
+    uint8_t v = NK_FS_EE_READ(*a);
+    *crc = crc8_update(*crc, v);
+    ++*a;
+    return v;
+}
+
+/* save the state as of block 0 of @p row, which has just been opened */
+static void ckpt_write(uint8_t row, uint8_t seq) {
+    const uint16_t base = ckpt_addr((uint8_t)((seq / CKPT_EVERY) & 1U));
+    uint8_t crc = crc8_update(0, CKPT_MAGIC);
+    uint16_t a = base + 1U;
+    uint8_t ovf = 0;
+
+    NK_FS_EE_WRITE(base, 0);                 /* invalid until complete */
+#if NK_FS_INDEX > 0
+    ovf = fs.idx_overflow;
+#endif
+    a = ckpt_put(a, seq, &crc);
+    a = ckpt_put(a, row, &crc);
+    a = ckpt_put(a, ovf, &crc);
+#if NK_FS_INDEX > 0
+    for (uint8_t i = 0; i < NK_FS_INDEX; ++i) {
+        a = ckpt_put(a, (uint8_t)fs.idx_tab[i].key, &crc);
+        a = ckpt_put(a, (uint8_t)(fs.idx_tab[i].key >> 8), &crc);
+        a = ckpt_put(a, fs.idx_tab[i].loc, &crc);
+    }
+#endif
+#if NK_FS_BLOOM > 0
+    for (uint16_t i = 0; i < NK_FS_BLOOM; ++i)
+        a = ckpt_put(a, fs.bloom[i], &crc);
+#endif
+    NK_FS_EE_WRITE(a, crc);
+    NK_FS_EE_WRITE(base, CKPT_MAGIC);
+}
+
+/* restore @p slot into the tables; false if it is torn or stale */
+static bool ckpt_load(uint8_t slot, uint8_t *row) {
+    uint16_t a = ckpt_addr(slot);
+    uint8_t crc = 0, seq, ovf, s;
+
+    if (ckpt_get(&a, &crc) != CKPT_MAGIC)
+        return false;
+    seq  = ckpt_get(&a, &crc);
+    *row = ckpt_get(&a, &crc);
+    ovf  = ckpt_get(&a, &crc);
+    (void)ovf;
+#if NK_FS_INDEX > 0
+    fs.idx_overflow = ovf != 0;
+    for (uint8_t i = 0; i < NK_FS_INDEX; ++i) {
+        fs.idx_tab[i].key  = ckpt_get(&a, &crc);
+        fs.idx_tab[i].key |= (uint16_t)ckpt_get(&a, &crc) << 8;
+        fs.idx_tab[i].loc  = ckpt_get(&a, &crc);
+    }
+#endif
+#if NK_FS_BLOOM > 0
+    for (uint16_t i = 0; i < NK_FS_BLOOM; ++i)
+        fs.bloom[i] = ckpt_get(&a, &crc);
+#endif
+    return *row < ROWS && NK_FS_EE_READ(a) == crc &&
+           row_seq(*row, &s) && s == seq;    /* row not recycled since */
+}
+
+/* fast mount: newest usable checkpoint, then the rows after it */
+static bool ckpt_resume(void) {
+    uint8_t s0 = NK_FS_EE_READ(ckpt_addr(0) + 1U);
+    uint8_t s1 = NK_FS_EE_READ(ckpt_addr(1) + 1U);
+    uint8_t first = (int8_t)(s1 - s0) > 0 ? 1U : 0U;
+    uint8_t row, seq, s;
+
+    if (!ckpt_load(first, &row) && !ckpt_load(first ^ 1U, &row)) {
+        index_clear();
+        return false;
+    }
+
+    /* follow consecutive headers to the newest row */
+    fs.cur_row = row;
+    row_seq(row, &seq);
+    for (uint8_t n = 1; n < ROWS; ++n) {
+        uint8_t nx = next_row(fs.cur_row);
+        if (!row_seq(nx, &s) || s != (uint8_t)(seq + 1U))
+            break;
+        fs.cur_row = nx;
+        seq = s;
+    }
+    fs.cur_idx = ROW_BLKS;
+    for (uint8_t i = 0; i < ROW_BLKS; ++i) {
+        rec_t rec;
+        if (!read_rec(fs.cur_row, i, &rec)) {
+            fs.cur_idx = i;
+            break;
+        }
+    }
+    index_replay(row, false);
+    return true;
+}
+#else
+#define CKPT 0
+#endif /* NK_FS_CHECKPOINT */
+
+/* ─── 5 · Row rollover ──────────────────────────────────────── */
+static void open_next_row(void) {
+    const uint8_t next = next_row(fs.cur_row);
+#if NK_FS_INDEX > 0
+    idx_drop_row(next);
+#endif
+    erase_row(next);
+
+    /* fetch prev sequence, increment (wrap OK) */
+    uint8_t seq = 0;
+    if (row_seq(fs.cur_row, &seq))
+        seq++;
+    set_row_seq(next, seq);
+#if CKPT
+    if (seq % CKPT_EVERY == 0)
+        ckpt_write(next, seq);
+#endif
+
+    fs.cur_row = next;
+    fs.cur_idx = 0;
+    fs.gc_pos  = 0;                             /* new row to clean ahead */
+    fs.gc_left = ROW_BLKS;
+}
+
+/* ─── 6 · Appending ─────────────────────────────────────────── */
 /* internal helper: write 1 block, bump cursor, roll row on full */
 static bool write_block(uint8_t tag, uint8_t d0, uint8_t d1) {
-    const uint16_t a   = addr(cur_row, cur_idx);
-    const uint8_t  crc = crc3(tag, d0, d1);
+    const uint16_t a   = addr(fs.cur_row, fs.cur_idx);
+    const rec_t    rec = { tag, d0, d1, crc3(tag, d0, d1) };
 
-    eeprom_update_byte((uint8_t __eeprom *)a,       tag);
-    eeprom_update_byte((uint8_t __eeprom *)(a + 1), d0);
-    eeprom_update_byte((uint8_t __eeprom *)(a + 2), d1);
-    eeprom_update_byte((uint8_t __eeprom *)(a + 3), crc);
+    NK_FS_EE_WRITE(a,     tag);
+    NK_FS_EE_WRITE(a + 1, d0);
+    NK_FS_EE_WRITE(a + 2, d1);
+    NK_FS_EE_WRITE(a + 3, rec.crc);
 
-    if (eeprom_read_byte((const uint8_t __eeprom *)(a + 3)) != crc)
+    if (NK_FS_EE_READ(a + 3) != rec.crc)
         return false;                         /* verify write */
 
-    if (++cur_idx >= 15)
+    note_rec(fs.cur_row, fs.cur_idx, &rec);
+    if (++fs.cur_idx >= ROW_BLKS)
         open_next_row();
     return true;
 }
 
-/* --- external key <16 KiB, value <32 ---------------------------------- */
-bool nk_fs_put(uint16_t key, uint16_t val) {
-    if (key >= 2048 || val >= 32) return false;
-    uint8_t d0 = key >> 3;
-    uint8_t d1 = (uint8_t)(((key & 0x07) << 5) | (val & 0x1F));
-    return write_block(TAG_PUT, d0, d1);
+/* ─── 7 · Garbage collection ──────────────────────────────────
+ * Rolling into the next row erases it, so before that happens the
+ * newest PUT of every key still in it is appended (copied forward).
+ * The row is cleaned from gc_pos on, one record per step; gc_left
+ * bounds how many live records it may still hold.  Keeping
+ * gc_left < free slots before each user write means the current row
+ * can never fill while the next one holds the only copy of a key.
+ * Tombstones are dropped: nothing older survives the erase.
+ */
+static bool is_live(uint8_t row, uint8_t idx, const rec_t *r) {
+    if (r->tag != TAG_PUT)
+        return false;
+    const uint16_t key = unpack_key(r->d0, r->d1);
+    const uint8_t  loc = (uint8_t)(row << 4 | idx);
+#if NK_FS_INDEX > 0
+    uint8_t i = idx_find(key);
+    if (i < NK_FS_INDEX)
+        return fs.idx_tab[i].loc == loc;
+    if (!fs.idx_overflow)
+        return false;                        /* deleted since */
+#endif
+    rec_t newest;
+    return scan_newest(key, &newest) == loc;
 }
 
-bool nk_fs_del(uint16_t key) {
-    if (key >= 2048) return false;
-    uint8_t d0 = key >> 3;
-    uint8_t d1 = (uint8_t)((key & 0x07) << 5);
-    return write_block(TAG_DEL, d0, d1);
+/* examine one record of the row to erase; false if a copy failed */
+static bool gc_step(void) {
+    const uint8_t row = next_row(fs.cur_row);
+    rec_t rec;
+
+    if (fs.gc_pos >= ROW_BLKS) {
+        fs.gc_left = 0;
+        return true;
+    }
+    const uint8_t i = fs.gc_pos++;
+    if (read_rec(row, i, &rec) && is_live(row, i, &rec)) {
+        if (fs.gc_left)
+            fs.gc_left--;
+        if (!write_block(rec.tag, rec.d0, rec.d1)) {   /* may roll over */
+            fs.gc_pos--;
+            fs.gc_left++;
+            return false;
+        }
+    }
+    if (fs.gc_left > ROW_BLKS - fs.gc_pos)
+        fs.gc_left = (uint8_t)(ROW_BLKS - fs.gc_pos);
+    return true;
 }
 
-static inline uint16_t unpack_key(uint8_t d0, uint8_t d1) {
-    return (uint16_t)d0 << 3 | (d1 >> 5);
+/* clean ahead until one more record fits without losing data */
+static bool gc_make_room(void) {
+    for (uint16_t budget = ROWS * ROW_BLKS; fs.gc_left >= ROW_BLKS - fs.cur_idx;) {
+        if (budget-- == 0 || !gc_step())
+            return false;                    /* every record live: full */
+    }
+    return true;
 }
-static inline uint16_t unpack_val(uint8_t d1) { return d1 & 0x1F; }
 
-bool nk_fs_get(uint16_t key, uint16_t *out) {
-    if (!out || key >= 2048) return false;
+/* newest value of @p key */
+static bool lookup(uint16_t key, uint16_t *out) {
+#if NK_FS_INDEX > 0
+    uint8_t i = idx_find(key);
+    if (i < NK_FS_INDEX) {
+        const uint8_t loc = fs.idx_tab[i].loc;
+        rec_t rec;
+        if (read_rec(loc >> 4, loc & 0x0F, &rec) && rec.tag == TAG_PUT &&
+            unpack_key(rec.d0, rec.d1) == key) {
+            *out = unpack_val(rec.d1);
+            return true;
+        }
+        idx_remove_at(i);                    /* EEPROM changed under us */
+        fs.idx_overflow = true;
+    } else if (!fs.idx_overflow) {
+        return false;                        /* index is complete */
+    }
+#endif
+#if NK_FS_BLOOM > 0
+    if (!bloom_maybe(key))
+        return false;                        /* never written since boot */
+#endif
+    rec_t rec;
+    if (scan_newest(key, &rec) == LOC_NONE || rec.tag == TAG_DEL)
+        return false;                        /* unknown or tombstone */
+    *out = unpack_val(rec.d1);
+    return true;
+}
 
-    uint8_t r = cur_row;
-    uint8_t i = cur_idx;
+/* ─── 8 · Public API ────────────────────────────────────────── */
+/* slow mount: newest row header, then the whole log */
+static void full_mount(void) {
+    uint8_t best_seq = 0;
+    bool found = false;
+    fs.cur_row = 0;
 
-    /* walk backwards through circular log */
-    for (;;) {
-        if (i == 0) {
-            r = (uint8_t)(r ? r - 1 : ROWS - 1);
-            i = 15;
-        } else {
-            --i;
+    /* scan all row headers → pick newest by signed delta */
+    for (uint8_t r = 0; r < ROWS; ++r) {
+        uint8_t seq;
+        if (row_seq(r, &seq) && (!found || (int8_t)(seq - best_seq) > 0)) {
+            best_seq = seq;
+            fs.cur_row  = r;
+            found    = true;
         }
-        uint16_t a  = addr(r, i);
-        uint8_t  t  = eeprom_read_byte((const uint8_t __eeprom *)a);
-        uint8_t  d0 = eeprom_read_byte((const uint8_t __eeprom *)(a + 1));
-        uint8_t  d1 = eeprom_read_byte((const uint8_t __eeprom *)(a + 2));
-        uint8_t  c  = eeprom_read_byte((const uint8_t __eeprom *)(a + 3));
-        if (c != crc3(t, d0, d1))           /* corruption → stop search */
+    }
+    if (!found)
+        set_row_seq(0, 0);                   /* blank EEPROM: start row 0 */
+
+    /* locate first free slot in current row */
+    fs.cur_idx = ROW_BLKS;
+    for (uint8_t i = 0; i < ROW_BLKS; ++i) {
+        rec_t rec;
+        if (!read_rec(fs.cur_row, i, &rec)) {   /* corruption / unused */
+            fs.cur_idx = i;
             break;
+        }
+    }
+    index_rebuild();
+}
 
-        if (unpack_key(d0, d1) == key) {
-            if (t == TAG_DEL) return false; /* tombstone */
-            *out = unpack_val(d1);
-            return true;
+/* where cleaning stopped is not stored: count what is left */
+static void count_live(void) {
+    const uint8_t next = next_row(fs.cur_row);
+    fs.gc_pos    = 0;
+    fs.gc_left   = 0;
+    fs.live_keys = 0;
+#if NK_FS_INDEX > 0
+    if (!fs.idx_overflow) {                  /* the index holds every live key */
+        for (uint8_t i = 0; i < NK_FS_INDEX; ++i) {
+            if (fs.idx_tab[i].key != IDX_EMPTY) {
+                fs.live_keys++;
+                fs.gc_left += (fs.idx_tab[i].loc >> 4) == next;
+            }
+        }
+        return;
+    }
+#endif
+    for (uint8_t r = next;; r = next_row(r)) {
+        for (uint8_t i = 0; i < ROW_BLKS; ++i) {
+            rec_t rec;
+            if (read_rec(r, i, &rec) && is_live(r, i, &rec)) {
+                fs.live_keys++;
+                fs.gc_left += (r == next);
+            }
         }
-        if (r == cur_row && i == 0) break;  /* full loop done */
+        if (r == fs.cur_row)
+            break;
     }
-    return false;
 }
 
-/* Simple GC placeholder – not yet needed for 1 kB log */
-void nk_fs_gc(void) {}
+/* Calls that write go through these so a reset in the middle of one
+ * makes the next boot mount from the EEPROM instead of from RAM. */
+static inline void warm_begin(void) { nk_warm_invalidate(&fs_warm); }
+static inline void warm_end(void) { nk_warm_save(&fs_warm, &fs, sizeof fs); }
+
+void nk_fs_init(void) {
+    if (nk_warm_restore(&fs_warm, &fs, sizeof fs))
+        return;                              /* warm reset: RAM is current */
+#if CKPT
+    if (!ckpt_resume())
+#endif
+        full_mount();
+    if (fs.cur_idx >= ROW_BLKS)
+        open_next_row();                     /* row full → next row */
+    count_live();
+    warm_end();
+}
+
+bool nk_fs_get(uint16_t key, uint16_t *out) {
+    if (!out || key >= 2048) return false;
+    return lookup(key, out);
+}
+
+/* --- external key <16 KiB, value <32 ---------------------------------- */
+static bool put_rec(uint16_t key, uint16_t val) {
+    uint16_t old;
+    const bool fresh = !lookup(key, &old);
+    if (fresh && fs.live_keys >= LIVE_MAX) return false;  /* store full */
+    if (!gc_make_room()) return false;
+    uint8_t d0 = key >> 3;
+    uint8_t d1 = (uint8_t)(((key & 0x07) << 5) | (val & 0x1F));
+    if (!write_block(TAG_PUT, d0, d1)) return false;
+    fs.live_keys += fresh;
+    return true;
+}
+
+bool nk_fs_put(uint16_t key, uint16_t val) {
+    if (key >= 2048 || val >= 32) return false;
+    warm_begin();
+    const bool ok = put_rec(key, val);
+    warm_end();
+    return ok;
+}
+
+static bool del_rec(uint16_t key) {
+    if (!gc_make_room()) return false;
+    uint8_t d0 = key >> 3;
+    uint8_t d1 = (uint8_t)((key & 0x07) << 5);
+    if (!write_block(TAG_DEL, d0, d1)) return false;
+    fs.live_keys--;
+    return true;
+}
+
+bool nk_fs_del(uint16_t key) {
+    uint16_t old;
+    if (key >= 2048) return false;
+    if (!lookup(key, &old)) return true;               /* nothing to delete */
+    warm_begin();
+    const bool ok = del_rec(key);
+    warm_end();
+    return ok;
+}
+
+bool nk_fs_gc(void) {
+    if (fs.gc_left == 0)
+        return false;
+    warm_begin();
+    gc_step();
+    warm_end();
+    return fs.gc_left != 0;
+}
 
 #else
 
-/* Stubs for non-AVR or disabled EEPFS */
+/* Stubs for other targets or disabled EEPFS */
 void nk_fs_init(void) {}
 bool nk_fs_put(uint16_t key, uint16_t val) { (void)key; (void)val; return false; }
 bool nk_fs_del(uint16_t key) { (void)key; return false; }
 bool nk_fs_get(uint16_t key, uint16_t *out) { (void)key; (void)out; return false; }
-void nk_fs_gc(void) {}
+bool nk_fs_gc(void) { return false; }
 
-#endif /* CONFIG_FS_EEPFS_ENABLED && __AVR__ */
+#endif /* CONFIG_FS_EEPFS_ENABLED && (__AVR__ || HAL_ARCH_HOST || NK_FS_EE_READ) */
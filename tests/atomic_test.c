@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* HAL fetch-and-op atomics (arch/common/hal.h) under host threads */
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include "arch/common/hal.h"
+
+#define THREADS 4
+#define ROUNDS  50000
+
+static volatile uint8_t  c8;
+static volatile uint16_t c16;
+static volatile uint32_t c32;
+static volatile uint32_t bits;
+
+static void *hammer(void *arg)
+{
+    uint32_t me = 1u << (uintptr_t)arg;
+    for (int i = 0; i < ROUNDS; ++i) {
+        hal_atomic_fetch_add_u8(&c8, 3);
+        hal_atomic_fetch_sub_u8(&c8, 1);
+        hal_atomic_fetch_add_u16(&c16, 1);
+        hal_atomic_fetch_add_u32(&c32, 2);
+
+        /* Each thread owns one bit: it must never see it already set */
+        assert(!(hal_atomic_fetch_or_u32(&bits, me) & me));
+        assert(hal_atomic_fetch_and_u32(&bits, ~me) & me);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    /* Return value is the old one; arithmetic wraps */
+    volatile uint8_t b = 250;
+    assert(hal_atomic_fetch_add_u8(&b, 10) == 250 && b == 4);
+    assert(hal_atomic_fetch_sub_u8(&b, 5) == 4 && b == 255);
+    assert(hal_atomic_fetch_or_u8(&b, 0) == 255);
+    assert(hal_atomic_fetch_and_u8(&b, 0x0F) == 255 && b == 0x0F);
+
+    volatile uint16_t h = 0x00F0;
+    assert(hal_atomic_fetch_or_u16(&h, 0x0F00) == 0x00F0 && h == 0x0FF0);
+    assert(hal_atomic_fetch_and_u16(&h, 0x0F00) == 0x0FF0 && h == 0x0F00);
+    assert(hal_atomic_fetch_sub_u16(&h, 0x0F01) == 0x0F00 && h == 0xFFFF);
+
+    volatile uint32_t w = 0xFFFFFFFFu;
+    assert(hal_atomic_fetch_add_u32(&w, 1) == 0xFFFFFFFFu && w == 0);
+    assert(hal_atomic_fetch_sub_u32(&w, 1) == 0 && w == 0xFFFFFFFFu);
+
+    pthread_t t[THREADS];
+    for (uintptr_t i = 0; i < THREADS; ++i) {
+        assert(pthread_create(&t[i], NULL, hammer, (void *)i) == 0);
+    }
+    for (int i = 0; i < THREADS; ++i) {
+        pthread_join(t[i], NULL);
+    }
+
+    assert(c8 == (uint8_t)(2u * THREADS * ROUNDS));
+    assert(c16 == (uint16_t)(THREADS * ROUNDS));
+    assert(c32 == 2u * THREADS * ROUNDS);
+    assert(bits == 0);
+
+    printf("atomics: %u adds per thread\n", (unsigned)ROUNDS);
+    return 0;
+}
@@ -0,0 +1,466 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Block cache, SPI NOR/SD backends and BLKFS over emulated chips */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../drivers/fs/blkdev.c"
+#include "../drivers/fs/blkdev_spi.c"
+#include "../drivers/fs/blkfs.c"
+#if CONFIG_FS_BLKDEV_ENABLED
+#  include "../drivers/fs/vfs.c"
+#  include "../kernel/mm/nk_pool.c"
+#endif
+
+/*─── Emulated 25-series NOR flash (256 KiB, 4 KiB sectors) ──────────*/
+static uint8_t  nor[256 * 1024];
+static bool     nor_cs, nor_wel;
+static uint8_t  nor_op;
+static uint32_t nor_addr, nor_pos;
+static unsigned nor_sessions, nor_reads, nor_programs, nor_erases, nor_bad;
+
+static void nor_select(bool on)
+{
+    if (on && !nor_cs) {
+        nor_sessions++;
+        nor_pos = 0;
+    }
+    if (!on && nor_cs) {
+        if (nor_op == NOR_ERASE_4K && nor_pos == 4) {
+            if (!nor_wel) nor_bad++;
+            memset(&nor[(nor_addr & ~(NOR_SECTOR - 1)) % sizeof(nor)], 0xFF, NOR_SECTOR);
+            nor_erases++;
+            nor_wel = false;
+        } else if (nor_op == NOR_PROGRAM) {
+            nor_programs++;
+            nor_wel = false;
+        }
+    }
+    nor_cs = on;
+}
+
+static uint8_t nor_xfer(uint8_t b)
+{
+    assert(nor_cs);
+    uint32_t at = nor_pos++;
+    if (at == 0) {
+        nor_op = b;
+        nor_addr = 0;
+        if (b == NOR_WREN) nor_wel = true;
+        if (b == NOR_READ) nor_reads++;
+        if (b == NOR_PROGRAM && !nor_wel) nor_bad++;
+        return 0xFF;
+    }
+    switch (nor_op) {
+    case NOR_JEDEC_ID:
+        return at == 1 ? 0xEF : at == 2 ? 0x40 : 0x12;    /* 2^18 bytes */
+    case NOR_RDSR:
+        return 0x00;
+    case NOR_READ:
+    case NOR_PROGRAM:
+    case NOR_ERASE_4K:
+        if (at <= 3) {
+            nor_addr = nor_addr << 8 | b;
+            return 0xFF;
+        }
+        if (nor_op == NOR_READ) {
+            return nor[nor_addr++ % sizeof(nor)];
+        }
+        if (nor_op == NOR_PROGRAM) {
+            /* Wraps within the page; bits only go from 1 to 0 */
+            uint32_t a = (nor_addr & ~0xFFu) | ((nor_addr + at - 4) & 0xFFu);
+            nor[a % sizeof(nor)] &= b;
+        }
+        return 0xFF;
+    default:
+        return 0xFF;
+    }
+}
+
+static unsigned block_calls;
+
+static void nor_xfer_block(const uint8_t *tx, uint8_t *rx, uint16_t n)
+{
+    block_calls++;
+    for (uint16_t i = 0; i < n; i++) {
+        uint8_t v = nor_xfer(tx ? tx[i] : 0xFF);
+        if (rx) rx[i] = v;
+    }
+}
+
+static const blkdev_spi_bus_t nor_bus = { nor_select, nor_xfer, nor_xfer_block };
+
+/*─── Emulated SDHC card in SPI mode (1 MiB) ──────────────────────────*/
+static uint8_t  card[2048][512];
+static uint8_t  sd_out[600];
+static uint16_t sd_head, sd_tail;
+static uint8_t  sd_cmdbuf[6], sd_cmdlen;
+static bool     sd_app;
+static uint8_t  sd_acmd41_left = 2;
+static enum { SD_IDLE, SD_READING, SD_WAIT_TOKEN, SD_RECEIVING } sd_state;
+static bool     sd_multi;
+static uint32_t sd_sector;
+static uint16_t sd_got;
+static uint8_t  sd_rx_buf[514];
+static unsigned sd_cmd18, sd_cmd25, sd_cmd17, sd_cmd24;
+
+static void sd_push(uint8_t b)
+{
+    assert(sd_tail < sizeof(sd_out));
+    sd_out[sd_tail++] = b;
+}
+
+static void sd_push_packet(const uint8_t *p, uint16_t n)
+{
+    sd_push(0xFF);
+    sd_push(SD_TOKEN_START);
+    for (uint16_t i = 0; i < n; i++) sd_push(p[i]);
+    sd_push(0x00);
+    sd_push(0x00);
+}
+
+static void sd_command(void)
+{
+    uint8_t cmd = sd_cmdbuf[0] & 0x3F;
+    uint32_t arg = (uint32_t)sd_cmdbuf[1] << 24 | (uint32_t)sd_cmdbuf[2] << 16 |
+                   (uint32_t)sd_cmdbuf[3] << 8 | sd_cmdbuf[4];
+    bool app = sd_app;
+    sd_app = false;
+
+    switch (cmd) {
+    case 0:  assert(sd_cmdbuf[5] == 0x95); sd_push(0x01); break;
+    case 8:
+        assert(sd_cmdbuf[5] == 0x87 && arg == 0x1AA);
+        sd_push(0x01); sd_push(0); sd_push(0); sd_push(0x01); sd_push(0xAA);
+        break;
+    case 55: sd_app = true; sd_push(0x01); break;
+    case 41:
+        assert(app && arg == 1ul << 30);
+        sd_push(sd_acmd41_left ? (sd_acmd41_left--, 0x01) : 0x00);
+        break;
+    case 58: sd_push(0x00); sd_push(0xC0); sd_push(0xFF); sd_push(0x80); sd_push(0x00); break;
+    case 9: {
+        uint8_t csd[16] = { 0x40 };        /* CSD 2.0, C_SIZE = 1 -> 1 MiB */
+        csd[9] = 1;
+        sd_push(0x00);
+        sd_push_packet(csd, sizeof(csd));
+        break;
+    }
+    case 17:
+        assert(arg < 2048);
+        sd_cmd17++;
+        sd_push(0x00);
+        sd_push_packet(card[arg], 512);
+        break;
+    case 18:
+        assert(arg < 2048);
+        sd_cmd18++;
+        sd_push(0x00);
+        sd_sector = arg;
+        sd_state = SD_READING;
+        break;
+    case 12:
+        sd_head = sd_tail = 0;
+        sd_state = SD_IDLE;
+        sd_push(0xFF); sd_push(0x00); sd_push(0x00);
+        break;
+    case 24:
+    case 25:
+        assert(arg < 2048);
+        cmd == 24 ? sd_cmd24++ : sd_cmd25++;
+        sd_push(0x00);
+        sd_sector = arg;
+        sd_multi = cmd == 25;
+        sd_state = SD_WAIT_TOKEN;
+        break;
+    default: sd_push(0x04); break;     /* illegal command */
+    }
+}
+
+static uint8_t sd_xfer(uint8_t b)
+{
+    uint8_t out = 0xFF;
+    if (sd_head < sd_tail) {
+        out = sd_out[sd_head++];
+    } else {
+        sd_head = sd_tail = 0;
+        if (sd_state == SD_READING) {
+            assert(sd_sector < 2048);
+            sd_push_packet(card[sd_sector++], 512);
+        }
+    }
+
+    if (sd_state == SD_WAIT_TOKEN) {
+        if (b == SD_TOKEN_START || b == SD_TOKEN_MULTI) {
+            sd_state = SD_RECEIVING;
+            sd_got = 0;
+        } else if (b == SD_TOKEN_STOP) {
+            sd_state = SD_IDLE;
+            sd_push(0x00);
+        }
+        return out;
+    }
+    if (sd_state == SD_RECEIVING) {
+        sd_rx_buf[sd_got++] = b;
+        if (sd_got == sizeof(sd_rx_buf)) {
+            memcpy(card[sd_sector++], sd_rx_buf, 512);
+            sd_push(0xE5);                  /* data accepted */
+            sd_push(0x00);                  /* busy */
+            sd_state = sd_multi ? SD_WAIT_TOKEN : SD_IDLE;
+        }
+        return out;
+    }
+    if (sd_cmdlen || (b & 0xC0) == 0x40) {
+        sd_cmdbuf[sd_cmdlen++] = b;
+        if (sd_cmdlen == 6) {
+            sd_cmdlen = 0;
+            if (sd_state == SD_READING) {
+                sd_head = sd_tail = 0;
+            }
+            sd_command();
+        }
+    }
+    return out;
+}
+
+static void sd_select(bool on) { (void)on; }
+
+static const blkdev_spi_bus_t sd_bus = { sd_select, sd_xfer, NULL };
+
+/*─── Helpers ─────────────────────────────────────────────────────────*/
+static uint8_t pattern(uint32_t i) { return (uint8_t)(i * 7 + (i >> 9)); }
+
+static void fill(uint8_t *p, uint32_t from, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) p[i] = pattern(from + i);
+}
+
+static bool check(const uint8_t *p, uint32_t from, uint16_t n)
+{
+    for (uint16_t i = 0; i < n; i++) {
+        if (p[i] != pattern(from + i)) return false;
+    }
+    return true;
+}
+
+/* Everything RAM-resident vanishes; the chip keeps what reached it. */
+static void power_cycle(blkdev_t *d)
+{
+    blkdev_invalidate(d);
+    memset(&bfs, 0, sizeof(bfs));
+    assert(blkfs_mount(d) == 0);
+}
+
+static uint8_t big[4 * BS];
+
+int main(void)
+{
+    /*── Raw NOR device: bursts and the cache ──*/
+    memset(nor, 0xA5, sizeof(nor));       /* previous owner's leftovers */
+    blkdev_t dev;
+    blkdev_spi_nor_t nst;
+    assert(blkdev_spi_nor_init(&dev, &nst, &nor_bus) == 0);
+    assert(dev.blocks == sizeof(nor) / BS && dev.erase_shift == 3);
+
+    assert(blkdev_erase(&dev, 8, 8) == 0 && nor_erases == 1);
+    assert(blkdev_erase(&dev, 9, 8) == -1);           /* not unit-aligned */
+    fill(big, 0, sizeof(big));
+    unsigned progs = nor_programs;
+    assert(blkdev_pwrite(&dev, 8 * BS, big, sizeof(big)) == 0);
+    assert(nor_programs - progs == sizeof(big) / NOR_PAGE && nor_bad == 0);
+
+    unsigned reads = nor_reads, calls = block_calls;
+    memset(big, 0, sizeof(big));
+    assert(blkdev_pread(&dev, 8 * BS, big, sizeof(big)) == 0);
+    assert(nor_reads - reads == 1);                   /* one READ streams all */
+    assert(block_calls - calls == sizeof(big) / BS);
+    assert(check(big, 0, sizeof(big)));
+
+    /* Partial access goes through a line: one fill, then RAM */
+    uint8_t small[20];
+    reads = nor_reads;
+    assert(blkdev_pread(&dev, 9 * BS + 3, small, sizeof(small)) == 0);
+    assert(blkdev_pread(&dev, 9 * BS + 40, small, sizeof(small)) == 0);
+    assert(nor_reads - reads == 1 && check(small, BS + 40, sizeof(small)));
+
+    /* Partial writes stay dirty until synced */
+    progs = nor_programs;
+    memset(small, 0x00, sizeof(small));
+    assert(blkdev_pwrite(&dev, 12 * BS + 100, small, sizeof(small)) == 0);
+    assert(nor_programs == progs);
+    assert(blkdev_pread(&dev, 12 * BS + 90, small, sizeof(small)) == 0);
+    assert(small[9] == 0xFF && small[10] == 0 && small[19] == 0);
+    assert(blkdev_sync(&dev) == 0 && nor_programs - progs == BS / NOR_PAGE);
+    assert(nor[12 * BS + 100] == 0x00 && nor[12 * BS + 99] == 0xFF);
+
+    /* A whole-block read sees dirty lines written back first */
+    small[0] = 0x11;
+    assert(blkdev_pwrite(&dev, 13 * BS, small, 1) == 0);
+    assert(blkdev_pread(&dev, 13 * BS, big, BS) == 0 && big[0] == 0x11);
+
+    /* Out of range */
+    assert(blkdev_pread(&dev, dev.blocks * BS - 4, small, 8) == -1);
+    assert(blkdev_pwrite(&dev, dev.blocks * BS, small, 1) == -1);
+
+    /*── BLKFS on NOR ──*/
+    assert(blkfs_mount(&dev) == -1);                  /* never formatted */
+    assert(blkfs_format(&dev) == 0);
+
+    const blkfs_file_t *log = blkfs_create("/log", 40000);
+    assert(log && log->start == 16 && log->cap == 80);
+    assert(blkfs_create("log", 10) == NULL);          /* name taken */
+    assert(blkfs_create("/a/b", 10) == NULL);         /* no directories */
+    assert(blkfs_create("twelve_chars", 10) == NULL);
+    assert(blkfs_create("huge", 1ul << 20) == NULL);
+    assert(blkfs_open("log") == log && blkfs_open("/nope") == NULL);
+
+    /* Appends in 100-byte records: the first unit is erased on demand */
+    unsigned erases = nor_erases;
+    uint8_t rec[100];
+    uint32_t size = 0;
+    for (int i = 0; i < 10; i++) {
+        fill(rec, size, sizeof(rec));
+        assert(blkfs_write(log, size, rec, sizeof(rec)) == (int)sizeof(rec));
+        size += sizeof(rec);
+    }
+    assert(nor_erases - erases == 1 && blkfs_size(log) == 1000);
+
+    /* Append-only on NOR, and no holes */
+    assert(blkfs_write(log, 10, rec, 1) == -1);
+    assert(blkfs_write(log, 1001, rec, 1) == -1);
+
+    /* Idle time erases the next unit; then nothing is left to do */
+    assert(blkfs_idle() == true);
+    assert(blkfs_idle() == false && nor_erases - erases == 2);
+
+    /* So growing into it needs no erase in the write path */
+    fill(big, size, sizeof(big));
+    assert(blkfs_write(log, size, big, sizeof(big)) == (int)sizeof(big));
+    size += sizeof(big);
+    assert(nor_erases - erases == 2);
+
+    /* Whole aligned blocks bypass the cache in one burst */
+    uint32_t aligned = (size + BS - 1) / BS * BS;
+    fill(big, size, (uint16_t)(aligned - size));
+    assert(blkfs_write(log, size, big, (uint16_t)(aligned - size)) > 0);
+    size = aligned;
+    fill(big, size, sizeof(big));
+    progs = nor_programs;
+    calls = block_calls;
+    assert(blkfs_write(log, size, big, sizeof(big)) == (int)sizeof(big));
+    size += sizeof(big);
+    assert(nor_programs - progs == sizeof(big) / NOR_PAGE);
+    assert(block_calls - calls == sizeof(big) / NOR_PAGE);
+    assert(nor_bad == 0);
+
+    /* Everything reads back */
+    for (uint32_t off = 0; off < size; off += sizeof(rec)) {
+        int n = blkfs_read(log, off, rec, sizeof(rec));
+        assert(n == (int)(size - off < sizeof(rec) ? size - off : sizeof(rec)));
+        assert(check(rec, off, (uint16_t)n));
+    }
+    assert(blkfs_read(log, size, rec, 1) == 0);
+
+    /* Directory survives a power cycle once synced */
+    assert(blkfs_sync() == 0);
+    power_cycle(&dev);
+    log = blkfs_open("/log");
+    assert(log && blkfs_size(log) == size);
+    assert(blkfs_read(log, 1234, rec, 50) == 50 && check(rec, 1234, 50));
+
+    /* Synced data, unsynced size: mount finds the appends in the tail unit */
+    fill(rec, size, 60);
+    assert(blkfs_write(log, size, rec, 60) == 60);
+    assert(blkdev_sync(&dev) == 0);
+    power_cycle(&dev);
+    log = blkfs_open("log");
+    assert(blkfs_size(log) == size + 60);
+    size += 60;
+
+    /* Data still in the cache is lost, and the file carries on */
+    fill(rec, size, 30);
+    assert(blkfs_write(log, size, rec, 30) == 30);
+    power_cycle(&dev);
+    log = blkfs_open("log");
+    assert(blkfs_size(log) == size);
+    fill(rec, size, 30);
+    assert(blkfs_write(log, size, rec, 30) == 30 && nor_bad == 0);
+    size += 30;
+    assert(blkfs_read(log, size - 40, rec, 40) == 40 && check(rec, size - 40, 40));
+    assert(blkfs_sync() == 0);
+
+    /* A torn directory write leaves the previous copy in charge */
+    const blkfs_file_t *cfg = blkfs_create("cfg", 100);
+    assert(cfg && cfg->start == 96);
+    assert(blkfs_sync() == 0);
+    uint8_t newest = bfs.slot;
+    nor[newest * 8 * BS + 20] ^= 0xFF;                /* damage it */
+    power_cycle(&dev);
+    assert(bfs.slot != newest && blkfs_open("cfg") == NULL);
+    assert(blkfs_size(blkfs_open("log")) == size);
+
+    /* Extents run out */
+    assert(blkfs_create("fill", (uint32_t)(dev.blocks - 96) * BS) != NULL);
+    assert(blkfs_create("more", 1) == NULL);
+
+#if CONFIG_FS_BLKDEV_ENABLED
+    /*── Through the VFS ──*/
+    assert(blkfs_format(&dev) == 0);
+    assert(blkfs_create("data", 4096) != NULL);
+    vfs_init();
+    assert(vfs_mount(VFS_TYPE_BLKFS, "/sd") == 0);
+    int fd = vfs_open("/sd/data", O_RDWR);
+    assert(fd >= 0);
+    fill(big, 0, 700);
+    assert(vfs_write(fd, big, 700) == 700);
+    assert(vfs_lseek(fd, 0, SEEK_END) == 700);
+    assert(vfs_close(fd) == 0 && !bfs.dirty);         /* close synced */
+    power_cycle(&dev);
+    fd = vfs_open("/sd/data", O_RDONLY);
+    memset(big, 0, 700);
+    assert(vfs_read(fd, big, sizeof(big)) == 700 && check(big, 0, 700));
+    vfs_close(fd);
+#endif
+
+    /*── SD card: CMD18/CMD25 bursts ──*/
+    blkdev_t sd;
+    blkdev_spi_sd_t sst;
+    assert(blkdev_spi_sd_init(&sd, &sst, &sd_bus) == 0);
+    assert(sst.block_addr && sd.blocks == 2048 * 512 / BS && sd.erase_shift == 0);
+
+    fill(big, 0, sizeof(big));
+    assert(blkdev_pwrite(&sd, 5 * BS, big, sizeof(big)) == 0);
+    assert(sd_cmd25 == 1 && sd_cmd24 == 0);
+    assert(check(card[5 * BS / 512], 0, 512) && check(card[5 * BS / 512 + 3], 3 * 512, 512));
+    memset(big, 0, sizeof(big));
+    assert(blkdev_pread(&sd, 5 * BS, big, sizeof(big)) == 0);
+    assert(sd_cmd18 == 1 && check(big, 0, sizeof(big)));
+
+    memset(small, 0x5A, sizeof(small));
+    assert(blkdev_pwrite(&sd, 9 * BS + 7, small, sizeof(small)) == 0);
+    assert(blkdev_sync(&sd) == 0 && card[9 * BS / 512][7] == 0x5A);
+
+    /* BLKFS on a card: no erase, so rewrites in place are fine */
+    assert(blkfs_format(&sd) == 0);
+    const blkfs_file_t *f = blkfs_create("/samples", 2000);
+    assert(f && f->start == 2 && f->cap == (2000 + BS - 1) / BS);
+    fill(rec, 0, sizeof(rec));
+    assert(blkfs_write(f, 0, rec, sizeof(rec)) == (int)sizeof(rec));
+    memset(rec, 0xEE, 10);
+    assert(blkfs_write(f, 0, rec, 10) == 10);
+    assert(blkfs_write(f, 1990, rec, 20) == -1);      /* hole */
+    assert(blkfs_idle() == false);
+    assert(blkfs_sync() == 0);
+    power_cycle(&sd);
+    f = blkfs_open("samples");
+    assert(f && blkfs_size(f) == sizeof(rec));
+    assert(blkfs_read(f, 0, rec, sizeof(rec)) == (int)sizeof(rec));
+    assert(rec[9] == 0xEE && check(rec + 10, 10, sizeof(rec) - 10));
+
+    printf("blkfs: ok\n");
+    return 0;
+}
@@ -0,0 +1,138 @@
+/* SPDX-License-Identifier: MIT */
+
+/**
+ * @file boot_test.c
+ * @brief Unit tests for the init registry and boot stamps
+ */
+
+#include <stdio.h>
+
+#define NK_BOOT_PROF 1
+#include "../kernel/sched/nk_boot.c"
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  ✓ %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  ✗ %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+static char order[16];
+static int  order_n = 0;
+static int  flaky_runs = 0;
+
+static bool fn_a(void) { order[order_n++] = 'a'; return true; }
+static bool fn_b(void) { order[order_n++] = 'b'; return true; }
+static bool fn_c(void) { order[order_n++] = 'c'; return true; }
+static bool fn_d(void) { order[order_n++] = 'd'; return true; }
+static bool fn_e(void) { order[order_n++] = 'e'; return true; }
+
+static bool fn_flaky(void) {
+    order[order_n++] = 'f';
+    return ++flaky_runs > 1;    /* fails the first time */
+}
+
+static nk_boot_item_t dep_item = NK_BOOT_ITEM(fn_d, 5, NK_BOOT_LAZY);
+
+static bool fn_needs_dep(void) {
+    if (!nk_boot_need(&dep_item)) return false;
+    order[order_n++] = 'n';
+    return true;
+}
+
+static nk_boot_item_t a  = NK_BOOT_ITEM(fn_a, 20, NK_BOOT_EAGER);
+static nk_boot_item_t b  = NK_BOOT_ITEM(fn_b, 10, NK_BOOT_EAGER);
+static nk_boot_item_t c  = NK_BOOT_ITEM(fn_c, 10, NK_BOOT_EAGER);
+static nk_boot_item_t bg = NK_BOOT_ITEM(fn_e, 1, NK_BOOT_BACKGROUND);
+static nk_boot_item_t fl = NK_BOOT_ITEM(fn_flaky, 2, NK_BOOT_BACKGROUND);
+static nk_boot_item_t lz = NK_BOOT_ITEM(fn_needs_dep, 0, NK_BOOT_LAZY);
+
+static void test_eager(void) {
+    printf("\nTest: Eager items in priority order\n");
+
+    nk_boot_register(&a);
+    nk_boot_register(&b);
+    nk_boot_register(&c);
+    nk_boot_register(&b);                   /* duplicate: ignored */
+    nk_boot_register(&bg);
+    nk_boot_register(&fl);
+    nk_boot_register(&lz);
+    nk_boot_register(&dep_item);
+
+    order_n = 0;
+    TEST_ASSERT(nk_boot_run() == 0, "No eager item failed");
+    TEST_ASSERT(order_n == 3 && order[0] == 'b' && order[1] == 'c' &&
+                order[2] == 'a', "Ran b, c (registration order), then a");
+    TEST_ASSERT(a.state == NK_BOOT_DONE && b.state == NK_BOOT_DONE,
+                "Eager items marked done");
+    TEST_ASSERT(bg.state == NK_BOOT_PENDING && lz.state == NK_BOOT_PENDING,
+                "Background and lazy items left alone");
+
+    order_n = 0;
+    nk_boot_run();
+    TEST_ASSERT(order_n == 0, "Second nk_boot_run() runs nothing");
+}
+
+static void test_background(void) {
+    printf("\nTest: Background items one per step\n");
+
+    order_n = 0;
+    TEST_ASSERT(nk_boot_step(), "First step: more remain");
+    TEST_ASSERT(order_n == 1 && order[0] == 'e', "Lowest prio ran first");
+    TEST_ASSERT(!nk_boot_step(), "Second step: none remain");
+    TEST_ASSERT(order_n == 2 && order[1] == 'f', "Flaky item ran");
+    TEST_ASSERT(fl.state == NK_BOOT_FAILED, "Failure recorded");
+    TEST_ASSERT(!nk_boot_step(), "Failed item is not retried by steps");
+    TEST_ASSERT(order_n == 2, "Nothing ran");
+
+    TEST_ASSERT(nk_boot_need(&fl), "nk_boot_need() retries a failed item");
+    TEST_ASSERT(flaky_runs == 2 && fl.state == NK_BOOT_DONE, "Retry succeeded");
+}
+
+static void test_lazy(void) {
+    printf("\nTest: Lazy items on first use\n");
+
+    order_n = 0;
+    TEST_ASSERT(nk_boot_need(&lz), "First need runs the item");
+    TEST_ASSERT(order_n == 2 && order[0] == 'd' && order[1] == 'n',
+                "Its dependency ran first, from inside it");
+    TEST_ASSERT(nk_boot_need(&lz) && nk_boot_need(&dep_item),
+                "Later needs succeed");
+    TEST_ASSERT(order_n == 2, "...without running anything again");
+}
+
+static void test_marks(void) {
+    printf("\nTest: Boot stamps\n");
+
+    for (uint8_t i = 0; i < NK_BOOT_MARKS + 2; ++i) {
+        nk_boot_mark(i);
+    }
+    uint8_t n;
+    const nk_boot_mark_t *m = nk_boot_marks(&n);
+    TEST_ASSERT(n == NK_BOOT_MARKS, "Kept NK_BOOT_MARKS stamps");
+    TEST_ASSERT(nk_boot_log.n == NK_BOOT_MARKS + 2, "Counted the rest");
+    bool mono = true;
+    for (uint8_t i = 1; i < n; ++i) {
+        mono = mono && m[i].phase == i &&
+               (int32_t)(m[i].cycles - m[i - 1].cycles) >= 0;
+    }
+    TEST_ASSERT(mono, "Phases in order, time non-decreasing");
+}
+
+int main(void) {
+    printf("=== nk_boot tests ===\n");
+
+    test_eager();
+    test_background();
+    test_lazy();
+    test_marks();
+
+    printf("\n%d passed, %d failed\n", tests_passed, tests_failed);
+    return tests_failed ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* nk_crc: the catalogue check values, and every table strategy against
+ * the bitwise reference at lengths that end mid-slice. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+/* One copy of nk_crc.c per strategy, renamed */
+#define NK_CRC8_STRATEGY  0
+#define NK_CRC16_STRATEGY 0
+#define NK_CRC32_STRATEGY 0
+#define nk_crc8  crc8_bitwise
+#define nk_crc16 crc16_bitwise
+#define nk_crc32 crc32_bitwise
+#include "../kernel/lib/nk_crc.c"
+#undef NK_CRC8_STRATEGY
+#undef NK_CRC16_STRATEGY
+#undef NK_CRC32_STRATEGY
+#undef nk_crc8
+#undef nk_crc16
+#undef nk_crc32
+
+#define NK_CRC8_STRATEGY  1
+#define NK_CRC16_STRATEGY 1
+#define NK_CRC32_STRATEGY 1
+#define nk_crc8  crc8_nibble_
+#define nk_crc16 crc16_nibble_
+#define nk_crc32 crc32_nibble_
+#include "../kernel/lib/nk_crc.c"
+#undef NK_CRC8_STRATEGY
+#undef NK_CRC16_STRATEGY
+#undef NK_CRC32_STRATEGY
+#undef nk_crc8
+#undef nk_crc16
+#undef nk_crc32
+#undef NK_CRC_TABLES_H
+
+#define NK_CRC8_STRATEGY  2
+#define NK_CRC16_STRATEGY 2
+#define NK_CRC32_STRATEGY 2
+#define nk_crc8  crc8_byte_
+#define nk_crc16 crc16_byte_
+#define nk_crc32 crc32_byte_
+#include "../kernel/lib/nk_crc.c"
+#undef NK_CRC8_STRATEGY
+#undef NK_CRC16_STRATEGY
+#undef NK_CRC32_STRATEGY
+#undef nk_crc8
+#undef nk_crc16
+#undef nk_crc32
+#undef NK_CRC_TABLES_H
+
+#define NK_CRC8_STRATEGY  3
+#define NK_CRC16_STRATEGY 3
+#define NK_CRC32_STRATEGY 3
+#define nk_crc8  crc8_slice4_
+#define nk_crc16 crc16_slice4_
+#define nk_crc32 crc32_slice4_
+#include "../kernel/lib/nk_crc.c"
+
+typedef uint8_t (*crc8_fn)(uint8_t, const void *, size_t);
+typedef uint16_t (*crc16_fn)(uint16_t, const void *, size_t);
+typedef uint32_t (*crc32_fn)(uint32_t, const void *, size_t);
+
+static const crc8_fn c8[] = { crc8_bitwise, crc8_nibble_, crc8_byte_, crc8_slice4_ };
+static const crc16_fn c16[] = { crc16_bitwise, crc16_nibble_, crc16_byte_, crc16_slice4_ };
+static const crc32_fn c32[] = { crc32_bitwise, crc32_nibble_, crc32_byte_, crc32_slice4_ };
+
+int main(void)
+{
+    static const char check[] = "123456789";
+    uint8_t buf[67];
+    uint32_t seed = 1;
+
+    for (size_t i = 0; i < sizeof buf; i++) {
+        seed = seed * 1103515245u + 12345u;
+        buf[i] = (uint8_t)(seed >> 16);
+    }
+
+    for (int s = 0; s < 4; s++) {
+        assert(c8[s](0, check, 9) == 0xA1);              /* CRC-8/MAXIM */
+        assert(c16[s](0, check, 9) == 0x31C3);           /* XMODEM */
+        assert(c16[s](0xFFFF, check, 9) == 0x29B1);      /* CCITT-FALSE */
+        assert(c32[s](0, check, 9) == 0xCBF43926u);      /* CRC-32 */
+        assert(c32[s](0, check, 0) == 0 && c8[s](0x5A, check, 0) == 0x5A);
+
+        for (size_t n = 0; n <= sizeof buf; n++) {
+            assert(c8[s](0, buf, n) == c8[0](0, buf, n));
+            assert(c16[s](0xFFFF, buf, n) == c16[0](0xFFFF, buf, n));
+            assert(c32[s](0, buf, n) == c32[0](0, buf, n));
+        }
+        /* Chaining: two pieces give the CRC of the whole */
+        for (size_t cut = 0; cut <= sizeof buf; cut += 5) {
+            size_t rest = sizeof buf - cut;
+            assert(c8[s](c8[s](0, buf, cut), buf + cut, rest) == c8[0](0, buf, sizeof buf));
+            assert(c16[s](c16[s](0, buf, cut), buf + cut, rest) == c16[0](0, buf, sizeof buf));
+            assert(c32[s](c32[s](0, buf, cut), buf + cut, rest) == c32[0](0, buf, sizeof buf));
+        }
+    }
+
+    printf("crc_test: ok\n");
+    return 0;
+}
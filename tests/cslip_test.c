@@ -0,0 +1,285 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* CSLIP: RFC 1144 header compression round trips and the IPv4 hooks */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "drivers/net/ipv4.h"
+#include "drivers/net/pbuf.h"
+#include "drivers/net/slip.h"
+#include "drivers/tty/tty.h"
+
+#define ME   0x0A000001u
+#define PEER 0x0A000002u
+
+/*─── A TCP segment under test ────────────────────────────────────────*/
+typedef struct {
+    uint16_t id, win, urg, sport, dport;
+    uint32_t seq, ack;
+    uint8_t  flags;
+    uint16_t len;                   /* payload bytes */
+} seg_t;
+
+static size_t build(uint8_t *d, const seg_t *s)
+{
+    ipv4_hdr_t h;
+    ipv4_init_header(&h, ME, PEER, IPV4_PROTO_TCP, (uint16_t)(20 + s->len));
+    h.id = ipv4_htons(s->id);
+    h.checksum = 0;
+    h.checksum = ipv4_htons(ipv4_checksum(&h, sizeof(h)));
+    memcpy(d, &h, 20);
+
+    uint8_t *t = d + 20;
+    t[0] = (uint8_t)(s->sport >> 8); t[1] = (uint8_t)s->sport;
+    t[2] = (uint8_t)(s->dport >> 8); t[3] = (uint8_t)s->dport;
+    for (int i = 0; i < 4; i++) {
+        t[4 + i] = (uint8_t)(s->seq >> (24 - 8 * i));
+        t[8 + i] = (uint8_t)(s->ack >> (24 - 8 * i));
+    }
+    t[12] = 0x50;
+    t[13] = s->flags;
+    t[14] = (uint8_t)(s->win >> 8); t[15] = (uint8_t)s->win;
+    t[16] = (uint8_t)(s->seq ^ 0x5A); t[17] = (uint8_t)s->len;  /* any checksum */
+    t[18] = (uint8_t)(s->urg >> 8); t[19] = (uint8_t)s->urg;
+    for (uint16_t i = 0; i < s->len; i++) {
+        d[40 + i] = (uint8_t)(s->seq + i);
+    }
+    return 40u + s->len;
+}
+
+static slip_vj_t tx, rx;
+
+/* Compress @p s with tx, expand with rx; returns the compressed frame size */
+static size_t round_trip(const seg_t *s)
+{
+    uint8_t pkt[IPV4_MTU], frame[IPV4_MTU];
+    size_t len = build(pkt, s);
+
+    uint8_t hdr[SLIP_VJ_TX_HDR];
+    size_t used = len < sizeof(hdr) ? len : sizeof(hdr);
+    memcpy(hdr, pkt, used);
+    size_t n = slip_vj_compress(&tx, hdr, &used, len);
+    size_t flen;
+    if (used) {
+        memcpy(frame, hdr, n);
+        memcpy(frame + n, pkt + used, len - used);
+        flen = n + len - used;
+    } else {
+        memcpy(frame, pkt, len);
+        flen = len;
+    }
+
+    int r = slip_vj_uncompress(&rx, frame, flen, sizeof(frame));
+    assert(r == (int)len);
+    assert(memcmp(frame, pkt, len) == 0);
+    return flen;
+}
+
+static void test_codec(void)
+{
+    slip_vj_init(&tx, SLIP_VJ_ON);
+    slip_vj_init(&rx, SLIP_VJ_ON);
+
+    seg_t s = { .id = 100, .win = 1024, .sport = 49152, .dport = 80,
+                .seq = 1000, .ack = 5000, .flags = 0x10, .len = 10 };
+
+    /* First segment of a connection: whole header, slot id inside */
+    assert(round_trip(&s) == 50);
+
+    /* Unidirectional data: SPECIAL_D, the slot id omitted → 3 bytes */
+    s.id++; s.seq += 10;
+    assert(round_trip(&s) == 3 + 10);
+
+    /* Echoed traffic: seq and ack both moved by the last length */
+    s.id++; s.seq += 10; s.ack += 10;
+    assert(round_trip(&s) == 3 + 10);
+
+    /* Window, ack, PSH and an IP id jump */
+    s.id += 7; s.seq += 10; s.ack += 3; s.win = 900; s.flags |= 0x08;
+    assert(round_trip(&s) <= 3 + 3 + 1 + 1 + 1 + 10);
+
+    /* A 16-bit sequence delta takes the three-byte form */
+    s.id++; s.seq += 300; s.flags = 0x10;
+    round_trip(&s);
+
+    /* A bare ACK, then data again after it */
+    s.id++; s.len = 0; s.ack += 1;
+    round_trip(&s);
+    s.id++; s.len = 20;
+    assert(round_trip(&s) < 40 + 20);
+
+    /* Retransmission (nothing changed) goes uncompressed */
+    assert(round_trip(&s) == 40 + 20);
+
+    /* A big sequence jump and a SYN also go uncompressed */
+    s.id++; s.seq += 100000u;
+    assert(round_trip(&s) == 40 + 20);
+    s.id++; s.flags = 0x12;
+    assert(round_trip(&s) == 40 + 20);
+    s.flags = 0x10;
+
+    /* Second connection: new slot; switching back sends the slot id
+     * (and an IP id delta: the SYN, sent as plain IP, used one) */
+    seg_t u = s;
+    u.sport = 49153; u.id = 7;
+    assert(round_trip(&u) == 40 + 20);
+    s.id++; s.seq += 20;
+    assert(round_trip(&s) == 5 + 20);
+    s.id++; s.seq += 20;
+    assert(round_trip(&s) == 3 + 20);
+    assert(rx.rx_errors == 0);
+}
+
+static void test_non_tcp(void)
+{
+    slip_vj_init(&tx, SLIP_VJ_ON);
+    slip_vj_init(&rx, SLIP_VJ_ON);
+
+    /* UDP passes through untouched both ways */
+    uint8_t pkt[48];
+    ipv4_hdr_t h;
+    ipv4_init_header(&h, ME, PEER, IPV4_PROTO_UDP, 28);
+    memcpy(pkt, &h, 20);
+    memset(pkt + 20, 0xAB, 28);
+    uint8_t hdr[SLIP_VJ_TX_HDR];
+    size_t used = sizeof(hdr);
+    memcpy(hdr, pkt, used);
+    slip_vj_compress(&tx, hdr, &used, sizeof(pkt));
+    assert(used == 0);
+    assert(slip_vj_uncompress(&rx, pkt, sizeof(pkt), sizeof(pkt)) == (int)sizeof(pkt));
+    assert(pkt[0] == 0x45);
+}
+
+static void test_errors(void)
+{
+    slip_vj_init(&tx, SLIP_VJ_ON);
+    slip_vj_init(&rx, SLIP_VJ_ON);
+    uint8_t f[IPV4_MTU];
+
+    /* A delta before any uncompressed header: tossed */
+    f[0] = 0x80 | 0x0F; f[1] = 0; f[2] = 0;
+    assert(slip_vj_uncompress(&rx, f, 3, sizeof(f)) == -1);
+    assert(rx.rx_errors == 1);
+
+    seg_t s = { .id = 1, .win = 512, .sport = 1000, .dport = 2000,
+                .seq = 1, .ack = 1, .flags = 0x10, .len = 4 };
+    round_trip(&s);
+
+    /* A slot id beyond the table or never filled: dropped, then toss */
+    f[0] = 0x80 | 0x40 | 0x0F; f[1] = 5; f[2] = 0; f[3] = 0;
+    assert(slip_vj_uncompress(&rx, f, 4, sizeof(f)) == -1);
+    assert(rx.toss);
+    f[0] = 0x80 | 0x0F;
+    assert(slip_vj_uncompress(&rx, f, 3, sizeof(f)) == -1);
+
+    /* Truncated delta */
+    f[0] = 0x80 | 0x40 | 0x02; f[1] = 0; f[2] = 0; f[3] = 0;
+    assert(slip_vj_uncompress(&rx, f, 4, sizeof(f)) == -1);
+
+    /* The next delta naming its slot recovers */
+    size_t errors = rx.rx_errors;
+    tx.tx_last = 0xFF;              /* force the slot id out */
+    s.id++; s.seq += 4;
+    assert(round_trip(&s) == 4 + 4);
+    assert(rx.rx_errors == errors && !rx.toss);
+
+    /* Off: frames are left alone */
+    slip_vj_init(&rx, SLIP_VJ_OFF);
+    f[0] = 0x80;
+    assert(slip_vj_uncompress(&rx, f, 3, sizeof(f)) == 3);
+}
+
+/*─── IPv4 hooks over a TTY ───────────────────────────────────────────*/
+static uint8_t out[2048], in[2048];
+static size_t  out_len, out_pos, in_len, in_pos;
+
+static void out_putc(uint8_t c) { assert(out_len < sizeof(out)); out[out_len++] = c; }
+static void in_putc(uint8_t c)  { assert(in_len < sizeof(in)); in[in_len++] = c; }
+static int  in_getc(void)       { return in_pos == in_len ? -1 : in[in_pos++]; }
+
+static tty_t   serial, wire;
+static uint8_t tty_rx[256], tty_tx[256], wire_rx[64], wire_tx[64];
+
+static size_t next_frame(uint8_t *f)
+{
+    size_t n = 0;
+    while (out_pos < out_len && out[out_pos] == SLIP_END) out_pos++;
+    while (out_pos < out_len && out[out_pos] != SLIP_END) {
+        uint8_t b = out[out_pos++];
+        if (b == SLIP_ESC) b = out[out_pos++] == SLIP_ESC_END ? SLIP_END : SLIP_ESC;
+        f[n++] = b;
+    }
+    return n;
+}
+
+static void test_ipv4(void)
+{
+    static slip_vj_t link, peer;
+    tty_init(&serial, tty_rx, tty_tx, sizeof(tty_rx), out_putc, in_getc);
+    tty_init(&wire, wire_rx, wire_tx, sizeof(wire_rx), in_putc, NULL);
+
+    /* Adaptive: plain until the peer compresses */
+    slip_vj_init(&link, SLIP_VJ_AUTO);
+    slip_vj_init(&peer, SLIP_VJ_ON);
+    ipv4_set_cslip(&link);
+
+    seg_t s = { .id = 10, .win = 1024, .sport = 80, .dport = 49152,
+                .seq = 77, .ack = 99, .flags = 0x10, .len = 8 };
+    uint8_t pkt[IPV4_MTU], f[IPV4_MTU];
+    size_t len = build(pkt, &s);
+    ipv4_output(&serial, pkt, 20, pkt + 20, len - 20);
+    assert(next_frame(f) == len && memcmp(f, pkt, len) == 0);
+
+    /* The peer's compressed segments come in expanded */
+    for (int i = 0; i < 2; i++) {
+        uint8_t hdr[SLIP_VJ_TX_HDR];
+        len = build(pkt, &s);
+        size_t used = sizeof(hdr);
+        memcpy(hdr, pkt, used);
+        size_t n = slip_vj_compress(&peer, hdr, &used, len);
+        assert(used == 40);
+        const slip_iov_t iov[2] = { { hdr, n }, { pkt + 40, len - 40 } };
+        slip_send_iov(&wire, iov, 2);
+        tty_poll(&serial);
+
+        ipv4_hdr_t h;
+        pbuf_t *p = ipv4_recv_pbuf(&serial, &h);
+        assert(p && p->len == len - 20);
+        assert(memcmp(&h, pkt, 20) == 0);
+        assert(memcmp(pbuf_data(p), pkt + 20, len - 20) == 0);
+        pbuf_free(p);
+        s.id++; s.seq += s.len;
+    }
+    assert(link.peer);
+
+    /* Now ours compress too: first the full header, then a delta */
+    slip_vj_init(&peer, SLIP_VJ_ON);
+    for (int i = 0; i < 2; i++) {
+        len = build(pkt, &s);
+        ipv4_output(&serial, pkt, 20, pkt + 20, len - 20);
+        size_t n = next_frame(f);
+        assert(n == (i == 0 ? len : 3u + s.len));
+        assert(slip_vj_uncompress(&peer, f, n, sizeof(f)) == (int)len);
+        assert(memcmp(f, pkt, len) == 0);
+        s.id++; s.seq += s.len;
+    }
+
+    ipv4_set_cslip(NULL);
+    len = build(pkt, &s);
+    ipv4_output(&serial, pkt, 20, pkt + 20, len - 20);
+    assert(next_frame(f) == len);
+}
+
+int main(void)
+{
+    test_codec();
+    test_non_tcp();
+    test_errors();
+    test_ipv4();
+    puts("cslip_test: ok");
+    return 0;
+}
@@ -0,0 +1,102 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Door round-trip cost: slab copy vs DOOR_F_ZEROCOPY vs batches (hal_cycles) */
+
+#define DOOR_PER_TARGET 1
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../kernel/ipc/door.c"
+#include "../kernel/lib/nk_crc.c"
+
+/*─── Stub scheduler: switching to task 1 runs the echo server ─────────*/
+static uint8_t current_tid;
+static unsigned long switches;
+
+uint8_t nk_current_tid(void) { return current_tid; }
+void nk_yield(void) { }
+
+uint8_t nk_task_priority(uint8_t tid) { (void)tid; return 0; }
+void nk_task_boost(uint8_t tid, uint8_t prio) { (void)tid; (void)prio; }
+void nk_task_unboost(uint8_t tid) { (void)tid; }
+
+void nk_switch_to(uint8_t tid)
+{
+    current_tid = tid;
+    if (tid == 1) {
+        switches++;
+        do {
+            uint8_t *m = (uint8_t *)door_message();
+            m[0]++;                  /* touch the request, reply in place */
+        } while (door_next());
+        door_return();
+    }
+}
+
+#define ROUNDS 100000u
+
+static uint32_t bench(uint8_t idx, uint8_t *buf)
+{
+    uint32_t best = UINT32_MAX;
+    for (int pass = 0; pass < 5; ++pass) {
+        uint32_t t0 = hal_cycles();
+        for (unsigned i = 0; i < ROUNDS; ++i) {
+            door_call(idx, buf);
+        }
+        uint32_t dt = hal_cycles() - t0;
+        if (dt < best) best = dt;
+    }
+    return hal_cycles_to_ns(best) / ROUNDS;
+}
+
+/* 16 eight-byte log records: one call each vs one door_callv() */
+static uint32_t bench_burst(bool batched)
+{
+    static uint8_t rec[16][8];
+    door_iov_t iov[16];
+    for (int i = 0; i < 16; ++i) iov[i] = (door_iov_t){ rec[i], 0 };
+
+    uint32_t best = UINT32_MAX;
+    for (int pass = 0; pass < 5; ++pass) {
+        uint32_t t0 = hal_cycles();
+        for (unsigned i = 0; i < ROUNDS / 16; ++i) {
+            if (batched) {
+                door_callv(0, iov, 16);
+            } else {
+                for (int j = 0; j < 16; ++j) door_call(0, rec[j]);
+            }
+        }
+        uint32_t dt = hal_cycles() - t0;
+        if (dt < best) best = dt;
+    }
+    return hal_cycles_to_ns(best) / (ROUNDS / 16);
+}
+
+int main(void)
+{
+    static uint8_t msg[120];
+
+    door_register(0, 1, 15, 0);
+    door_register(1, 1, 15, DOOR_F_ZEROCOPY);
+    door_register(2, 1, 15, DOOR_F_CRC);
+    door_register(3, 1, 15, DOOR_F_CRC | DOOR_F_ZEROCOPY);
+
+    printf("120-byte door round trip (ns):\n");
+    printf("  copy             %lu\n", (unsigned long)bench(0, msg));
+    printf("  zero-copy        %lu\n", (unsigned long)bench(1, msg));
+    printf("  copy + crc       %lu\n", (unsigned long)bench(2, msg));
+    printf("  zero-copy + crc  %lu\n", (unsigned long)bench(3, msg));
+
+    door_register(0, 1, 1, DOOR_F_ZEROCOPY);
+    switches = 0;
+    printf("16 x 8-byte burst (ns):\n");
+    printf("  16 door_call()   %lu\n", (unsigned long)bench_burst(false));
+    unsigned long single = switches;
+    printf("  1 door_callv()   %lu\n", (unsigned long)bench_burst(true));
+    printf("  server entries   %lu vs %lu\n", single, switches - single);
+
+    return msg[0] == (uint8_t)(4 * 5 * ROUNDS) ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Door capability table: probing, overwrite, full table (kernel/ipc/door.c) */
+
+#define DOOR_CAPS    4
+#define NK_MAX_TASKS 8     /* the server is task 7 */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../kernel/ipc/door.c"
+
+_Static_assert(sizeof(door_caps) == DOOR_CAPS * (sizeof(door_key_t) + sizeof(door_t)),
+               "RAM follows the table size, not tasks x slots");
+
+/*─── Stub scheduler: switching to task 7 runs its server ─────────────*/
+static uint8_t current_tid;
+static unsigned served;
+
+uint8_t nk_current_tid(void) { return current_tid; }
+void nk_yield(void) { assert(!"no channel should be contended"); }
+uint8_t nk_task_priority(uint8_t tid) { (void)tid; return 0; }
+void nk_task_boost(uint8_t tid, uint8_t prio) { (void)tid; (void)prio; }
+void nk_task_unboost(uint8_t tid) { (void)tid; }
+
+void nk_switch_to(uint8_t tid)
+{
+    uint8_t caller = current_tid;
+    current_tid = tid;
+    if (tid == 7) {
+        uint8_t *m = (uint8_t *)door_message();
+        m[0] = (uint8_t)(m[0] + door_words());
+        served++;
+        door_return();
+    }
+    current_tid = caller;
+}
+
+static int reg(uint8_t tid, uint8_t idx, uint8_t words)
+{
+    current_tid = tid;
+    return door_register(idx, 7, words, 0);
+}
+
+/* Index of the entry holding (tid, idx) */
+static long slot_of(uint8_t tid, uint8_t idx)
+{
+    const door_t *d = door_lookup(tid, idx);
+    return d ? (long)((const door_cap_t *)((const uint8_t *)d - offsetof(door_cap_t, door)) - door_caps)
+             : -1;
+}
+
+int main(void)
+{
+    /* home slot is tid % DOOR_CAPS here; collisions probe forward */
+    assert(reg(0, 0, 1) == 0 && slot_of(0, 0) == 0);
+    assert(reg(4, 0, 1) == 0 && slot_of(4, 0) == 1);
+    assert(reg(1, 0, 1) == 0 && slot_of(1, 0) == 2);
+    assert(reg(0, 1, 2) == 0 && slot_of(0, 1) == 3);
+
+    /* full: new keys are refused, registered ones still update in place */
+    assert(reg(2, 0, 1) == -1 && slot_of(2, 0) == -1);
+    assert(reg(4, 0, 3) == 0 && slot_of(4, 0) == 1);
+    assert(door_lookup(4, 0)->words == 3 && door_lookup(4, 0)->tgt_tid == 7);
+
+    /* a miss walks the whole full table and stops */
+    assert(door_lookup(3, 0) == NULL && door_lookup(0, 2) == NULL);
+    assert(door_lookup(0, DOOR_SLOTS) == NULL);
+    assert(reg(0, DOOR_SLOTS, 1) == -1 && reg(0, 0, 0) == -1);
+    assert(reg(0, 0, DOOR_SLAB_SIZE / 8 + 1) == -1);
+
+    /* calls resolve through the table; unknown doors do nothing */
+    uint8_t msg[24] = { 10 };
+    current_tid = 4;
+    door_call(0, msg);
+    assert(served == 1 && msg[0] == 13);
+    current_tid = 0;
+    door_call(1, msg);
+    assert(served == 2 && msg[0] == 15);
+    current_tid = 2;
+    door_call(0, msg);
+    door_iov_t iov[] = { { msg, 0 } };
+    assert(door_callv(0, iov, 1) == -1);
+    assert(served == 2 && msg[0] == 15);
+
+    printf("door caps: ok (%u bytes for %u doors)\n",
+           (unsigned)sizeof(door_caps), (unsigned)DOOR_CAPS);
+    return 0;
+}
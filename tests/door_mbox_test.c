@@ -0,0 +1,122 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* One-way and async doors (kernel/ipc/door_mbox.c) */
+
+#define DOOR_MBOX_DEPTH 4
+#define DOOR_TICKETS    3
+#define NK_IO_POLL      0   /* no nk_io_event in the stub scheduler */
+#define NK_MAX_TASKS    8   /* the client and server are tasks 0 and 1 */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../kernel/ipc/door.c"
+#include "../kernel/ipc/door_mbox.c"
+#include "../kernel/mm/nk_pool.c"
+
+/*─── Stub scheduler ───────────────────────────────────────────────────*/
+static uint8_t current_tid;
+static unsigned yields;
+
+uint8_t nk_current_tid(void) { return current_tid; }
+void nk_switch_to(uint8_t tid) { current_tid = tid; }
+
+uint8_t nk_task_priority(uint8_t tid) { (void)tid; return 0; }
+void nk_task_boost(uint8_t tid, uint8_t prio) { (void)tid; (void)prio; }
+void nk_task_unboost(uint8_t tid) { (void)tid; }
+
+/* Stub completion: records what door_complete() reported */
+static int16_t fut_result = -2;
+void nk_future_complete(nk_future_t *f, int16_t result)
+{
+    f->state = NK_FUT_DONE;
+    fut_result = result;
+}
+
+/* Waiting client lets the server (task 1) answer one request */
+static void serve_one(void);
+void nk_yield(void) { yields++; serve_one(); }
+
+static void serve_one(void)
+{
+    uint8_t save = current_tid;
+    uint8_t buf[DOOR_MBOX_MSG];
+    door_info_t info;
+
+    current_tid = 1;
+    int n = door_recv(buf, &info);
+    if (n > 0) {
+        for (int i = 0; i < n; ++i) buf[i] = (uint8_t)(buf[i] + 1);
+        door_complete(info.ticket, buf);
+    }
+    current_tid = save;
+}
+
+int main(void)
+{
+    current_tid = 0;
+    door_register(0, 1, 1, 0);           /* 8 bytes: queueable */
+    door_register(1, 1, 4, 0);           /* 32 bytes: too big to queue */
+
+    /* One-way: returns at once, bounded by the mailbox depth */
+    uint8_t tele[8] = { 10 };
+    for (int i = 0; i < DOOR_MBOX_DEPTH; ++i) {
+        tele[1] = (uint8_t)i;
+        assert(door_send(0, tele) == 0);
+    }
+    assert(door_send(0, tele) == -1);
+    assert(door_send(1, tele) == -1);
+    assert(door_send(DOOR_SLOTS, tele) == -1);
+
+    current_tid = 1;
+    assert(door_pending() == DOOR_MBOX_DEPTH);
+    for (int i = 0; i < DOOR_MBOX_DEPTH; ++i) {
+        uint8_t got[DOOR_MBOX_MSG];
+        door_info_t info;
+        assert(door_recv(got, &info) == 8);
+        assert(got[0] == 10 && got[1] == i);      /* FIFO order */
+        assert(info.caller == 0 && info.ticket == -1);
+        door_complete(info.ticket, got);          /* no-op for one-way */
+    }
+    assert(door_recv(tele, NULL) == -1);
+    current_tid = 0;
+
+    /* Async: pipeline three requests, then collect the replies */
+    uint8_t req[3][8];
+    int tk[3];
+    for (int i = 0; i < 3; ++i) {
+        memset(req[i], i * 10, sizeof(req[i]));
+        tk[i] = door_call_async(0, req[i]);
+        assert(tk[i] >= 0);
+    }
+    uint8_t extra[8];
+    assert(door_call_async(0, extra) == -1);    /* out of tickets */
+    assert(!door_poll(tk[0]));
+
+    yields = 0;
+    for (int i = 0; i < 3; ++i) {
+        assert(door_wait(tk[i]) == 0);
+        assert(req[i][0] == i * 10 + 1 && req[i][7] == i * 10 + 1);
+    }
+    assert(yields == 3);
+    assert(nk_pool_used(&door_tickets) == 0);
+    assert(door_wait(tk[0]) == -1);              /* released */
+
+    /* Future: completed with the reply length, ticket freed by the server */
+    nk_future_t f = NK_FUTURE_INIT;
+    memset(req[0], 5, sizeof(req[0]));
+    assert(door_call_future(0, req[0], &f) == 0);
+    assert(f.state == NK_FUT_PENDING && nk_pool_used(&door_tickets) == 1);
+    serve_one();
+    assert(nk_future_done(&f) && fut_result == 8);
+    assert(req[0][0] == 6);
+    assert(nk_pool_used(&door_tickets) == 0);
+    assert(door_call_future(1, req[0], &f) == -1);       /* too big to queue */
+    assert(door_call_future(0, req[0], NULL) == -1);
+
+    printf("door mailboxes ok\n");
+    return 0;
+}
@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Per-target door channels (kernel/ipc/door.c) */
+
+#define DOOR_PER_TARGET 1
+#define NK_MAX_TASKS    8     /* the priority tables below name eight tasks */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../kernel/ipc/door.c"
+
+/*─── Stub scheduler: switching to a server runs its handler ───────────*/
+static uint8_t current_tid;
+static void (*service[NK_MAX_TASKS])(void);
+
+uint8_t nk_current_tid(void) { return current_tid; }
+void nk_yield(void) { assert(!"no channel should be contended"); }
+
+/* Base and effective priorities, mirroring nk_task_boost()/unboost() */
+static uint8_t base_prio[NK_MAX_TASKS] = { 5, 20, 30, 10, 40, 50, 60, 60 };
+static uint8_t prio[NK_MAX_TASKS]      = { 5, 20, 30, 10, 40, 50, 60, 60 };
+
+uint8_t nk_task_priority(uint8_t tid) { return prio[tid]; }
+void nk_task_boost(uint8_t tid, uint8_t p) { if (p < prio[tid]) prio[tid] = p; }
+void nk_task_unboost(uint8_t tid) { prio[tid] = base_prio[tid]; }
+
+void nk_switch_to(uint8_t tid)
+{
+    current_tid = tid;
+    if (service[tid]) {
+        void (*fn)(void) = service[tid];
+        service[tid] = NULL;        /* handler returns via door_return() */
+        fn();
+        service[tid] = fn;
+    }
+}
+
+/*─── Servers ──────────────────────────────────────────────────────────*/
+static const void *seen_msg;
+
+static void zc_srv(void)             /* task 4: checks CRC, replies in place */
+{
+    uint8_t *m = (uint8_t *)door_message();
+    seen_msg = m;
+    assert(door_flags() == (DOOR_F_ZEROCOPY | DOOR_F_CRC));
+    assert(door_crc() == crc8_maxim(m, (uint8_t)(door_words() * 8)));
+    for (uint8_t i = 0; i < door_words() * 8; ++i) m[i] ^= 0xFF;
+    door_return();
+}
+
+static unsigned batch_seen;
+
+static void sum_srv(void)            /* task 5: batched, replies with sums */
+{
+    do {
+        uint8_t *m = (uint8_t *)door_message();
+        uint8_t sum = 0;
+        for (uint8_t i = 0; i < door_words() * 8; ++i) sum = (uint8_t)(sum + m[i]);
+        m[0] = sum;
+        batch_seen++;
+    } while (door_next());
+    door_return();
+}
+
+static uint8_t upper_prio[2], upper_calls;
+
+static void upper_srv(void)          /* task 2: upper-cases in place */
+{
+    char *m = (char *)door_message();
+    upper_prio[upper_calls++ & 1] = prio[2];
+    for (uint8_t i = 0; i < door_words() * 8; ++i)
+        if (m[i] >= 'a' && m[i] <= 'z') m[i] = (char)(m[i] - 32);
+    door_return();
+}
+
+static void relay_srv(void)          /* task 1: forwards to task 2 */
+{
+    char *m = (char *)door_message();
+    char copy[8];
+    memcpy(copy, m, sizeof(copy));
+
+    /* A second client, preempting mid-call, uses task 2 meanwhile */
+    uint8_t self = current_tid;
+    current_tid = 3;
+    char other[8] = "second";
+    door_call(0, other);
+    assert(strcmp(other, "SECOND") == 0);
+
+    /* Our own slab is untouched, and we can call onward */
+    current_tid = self;
+    assert(memcmp(m, copy, sizeof(copy)) == 0);
+    door_call(0, m);
+    m[7] = '!';
+    door_return();
+}
+
+int main(void)
+{
+    service[1] = relay_srv;
+    service[2] = upper_srv;
+
+    current_tid = 1;
+    door_register(0, 2, 1, 0);
+    current_tid = 3;
+    door_register(0, 2, 1, 0);
+    current_tid = 0;
+    door_register(0, 1, 1, 0);
+
+    char msg[8] = "hello";
+    door_call(0, msg);
+    assert(current_tid == 0);
+    assert(memcmp(msg, "HELLO\0\0!", 8) == 0);
+
+    /* Task 2 ran at task 3's priority (10), then task 0's via task 1 (5) */
+    assert(upper_prio[0] == 10 && upper_prio[1] == 5);
+    for (uint8_t t = 0; t < NK_MAX_TASKS; ++t)
+        assert(prio[t] == base_prio[t]);
+
+    /* A boost held before the call survives door_return() */
+    prio[2] = 7;
+    current_tid = 3;
+    char again[8] = "x";
+    door_call(0, again);
+    assert(upper_prio[0] == 7 && prio[2] == 7);
+    prio[2] = base_prio[2];
+    current_tid = 0;
+
+    /* Every channel is released once its caller has the reply */
+    for (uint8_t t = 0; t < DOOR_CHANNELS; ++t)
+        assert(door_chan[t].busy == 0);
+
+    /* Zero-copy: the server works on the caller's buffer itself */
+    service[4] = zc_srv;
+    uint8_t big[16];
+    for (uint8_t i = 0; i < sizeof(big); ++i) big[i] = i;
+    door_register(1, 4, 2, DOOR_F_ZEROCOPY | DOOR_F_CRC);
+    door_call(1, big);
+    assert(seen_msg == big);
+    for (uint8_t i = 0; i < sizeof(big); ++i) assert(big[i] + i == 0xFF);
+    assert(door_chan[4].busy == 0);
+
+    /* Batch: three messages, mixed sizes, one switch into the server */
+    service[5] = sum_srv;
+    uint8_t a[16], b[8], c[16];
+    memset(a, 1, sizeof(a));
+    memset(b, 2, sizeof(b));
+    memset(c, 3, sizeof(c));
+    door_iov_t iov[] = { { a, 0 }, { b, 1 }, { c, 0 } };
+    door_register(2, 5, 2, 0);
+    assert(door_callv(2, iov, 3) == 0);
+    assert(batch_seen == 3);
+    assert(a[0] == 16 && b[0] == 16 && c[0] == 48);
+    assert(door_chan[5].busy == 0);
+
+    door_iov_t big_iov[] = { { a, 3 } };
+    assert(door_callv(2, big_iov, 1) == -1);    /* larger than the door */
+    assert(door_callv(2, iov, 0) == 0 && batch_seen == 3);
+
+    printf("door channels ok\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Cross-core door calls through per-core call queues (kernel/ipc/door.c) */
+
+#define DOOR_PER_TARGET 1
+#define DOOR_XCORE      1
+#define DOOR_CORES      3
+#define NK_MAX_TASKS    8     /* home[] and the priority tables name eight */
+
+static unsigned char cpu, ipi;
+#define DOOR_THIS_CPU()     cpu
+#define DOOR_IPI_SEND(core) (ipi |= (unsigned char)(1u << (core)))
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../kernel/ipc/door.c"
+
+/*─── Stub scheduler: three cores, switching to a server runs it ───────*/
+static uint8_t cur[DOOR_CORES];                     /* running task per core */
+static const uint8_t home[NK_MAX_TASKS] = { 0, 1, 0, 1, 2, 1, 0, 0 };
+static void (*service[NK_MAX_TASKS])(void);
+static uint8_t woken, blocks;
+
+uint8_t nk_current_tid(void) { return cur[cpu]; }
+uint8_t nk_task_cpu(uint8_t tid) { return home[tid]; }
+void nk_yield(void) { assert(!"no channel should be contended"); }
+
+static uint8_t base_prio[NK_MAX_TASKS] = { 5, 20, 30, 10, 8, 40, 60, 60 };
+static uint8_t prio[NK_MAX_TASKS]      = { 5, 20, 30, 10, 8, 40, 60, 60 };
+
+uint8_t nk_task_priority(uint8_t tid) { return prio[tid]; }
+void nk_task_boost(uint8_t tid, uint8_t p) { if (p < prio[tid]) prio[tid] = p; }
+void nk_task_unboost(uint8_t tid) { prio[tid] = base_prio[tid]; }
+
+void nk_switch_to(uint8_t tid)
+{
+    cur[cpu] = tid;
+    if (service[tid]) {
+        void (*fn)(void) = service[tid];
+        service[tid] = NULL;        /* handler returns via door_return() */
+        fn();
+        service[tid] = fn;
+    }
+}
+
+uint32_t nk_sched_lock(void) { return 0; }
+void nk_sched_unlock(uint32_t s) { (void)s; }
+
+int nk_waitq_wake_one(nk_waitq_t *q)
+{
+    if (*q == 0) return -1;
+    int t = *q - 1;
+    *q = 0;
+    woken |= (uint8_t)(1u << t);
+    return t;
+}
+
+/* Take core @p c's pending IPI */
+static void take_ipi(uint8_t c)
+{
+    uint8_t was = cpu;
+    cpu = c;
+    ipi = (unsigned char)(ipi & ~(1u << c));
+    door_ipi();
+    cpu = was;
+}
+
+static void (*while_blocked)(void);
+
+/* The caller sleeps; meanwhile the other cores take their IPIs */
+void nk_waitq_block(nk_waitq_t *q)
+{
+    assert(*q == 0);
+    *q = (nk_waitq_t)(cur[cpu] + 1u);
+    blocks++;
+    if (while_blocked) {
+        void (*fn)(void) = while_blocked;
+        while_blocked = NULL;
+        fn();
+    }
+    for (uint8_t c = 0; c < DOOR_CORES; ++c) {
+        if (c != cpu && (ipi & (1u << c))) take_ipi(c);
+    }
+    assert(*q == 0);                /* woken by door_return() */
+}
+
+/*─── Servers ──────────────────────────────────────────────────────────*/
+static uint8_t ran_on[NK_MAX_TASKS], ran_prio[NK_MAX_TASKS];
+
+static void upper_srv(void)          /* tasks 1, 2, 5: upper-case in place */
+{
+    uint8_t self = nk_current_tid();
+    ran_on[self] = cpu;
+    ran_prio[self] = prio[self];
+    do {
+        char *m = (char *)door_message();
+        for (uint8_t i = 0; i < door_words() * 8; ++i)
+            if (m[i] >= 'a' && m[i] <= 'z') m[i] = (char)(m[i] - 32);
+    } while (door_next());
+    door_return();
+}
+
+/* Task 4 on core 2 calls task 5 on core 1 before core 1 takes its IPI */
+static char late[8] = "late";
+
+static void second_caller(void)
+{
+    uint8_t was = cpu;
+    cpu = 2;
+    door_call(0, late);
+    assert(cur[2] == 4);
+    cpu = was;
+}
+
+int main(void)
+{
+    service[1] = upper_srv;
+    service[2] = upper_srv;
+    service[5] = upper_srv;
+    cur[1] = 3;                     /* whatever core 1 is running */
+    cur[2] = 4;
+
+    cur[0] = 0;
+    door_register(0, 1, 1, 0);      /* task 1, core 1 */
+    door_register(1, 2, 1, 0);      /* task 2, our own core */
+    cpu = 2;
+    door_register(0, 5, 1, 0);      /* task 4 -> task 5, core 1 */
+    cpu = 0;
+
+    /* Same core: direct switch, no IPI, no sleep */
+    char near[8] = "near";
+    door_call(1, near);
+    assert(strcmp(near, "NEAR") == 0 && ran_on[2] == 0);
+    assert(ipi == 0 && blocks == 0 && !door_chan[2].remote);
+
+    /* Other core: queued, IPI, served there, caller woken */
+    char far[8] = "far";
+    door_call(0, far);
+    assert(strcmp(far, "FAR") == 0);
+    assert(ran_on[1] == 1 && blocks == 1 && woken == 1u << 0);
+    assert(cur[0] == 0 && cur[1] == 3);         /* core 1 back where it was */
+    assert(ran_prio[1] == 5 && prio[1] == base_prio[1]);
+    assert(door_chan[1].busy == 0 && ipi == 0);
+
+    /* Two cores queue for core 1 before it runs: one IPI serves both */
+    woken = 0;
+    blocks = 0;
+    while_blocked = second_caller;
+    strcpy(far, "again");
+    door_call(0, far);
+    assert(strcmp(far, "AGAIN") == 0 && strcmp(late, "LATE") == 0);
+    assert(woken == ((1u << 0) | (1u << 4)) && blocks == 2);
+    assert(ran_on[5] == 1 && ran_prio[5] == 8);
+    assert(door_xq[1].head == door_xq[1].tail && door_xq[1].tail == 3);
+    assert(cur[1] == 3 && cur[2] == 4);
+
+    /* Batches travel the same way */
+    char a[8] = "one", b[8] = "two";
+    door_iov_t v[2] = { { a, 0 }, { b, 0 } };
+    assert(door_callv(0, v, 2) == 0);
+    assert(strcmp(a, "ONE") == 0 && strcmp(b, "TWO") == 0);
+
+    /* An empty queue is a no-op */
+    take_ipi(1);
+    assert(cur[1] == 3);
+
+    printf("door xcore ok (%u calls through core 1's queue)\n",
+           (unsigned)door_xq[1].tail);
+    return 0;
+}
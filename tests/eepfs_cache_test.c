@@ -0,0 +1,92 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* EEPFS write-back cache (drivers/fs/eepfs.c) over a RAM EEPROM image */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+static uint8_t  eeprom[256];
+static unsigned ee_programmed;   /* bytes that actually changed */
+static unsigned ee_updates;      /* update_block calls */
+
+static void ee_read(void *dst, uint16_t addr, size_t n)
+{
+    assert(addr + n <= sizeof(eeprom));
+    memcpy(dst, &eeprom[addr], n);
+}
+
+static void ee_update(uint16_t addr, const void *src, size_t n)
+{
+    const uint8_t *s = src;
+    assert(addr + n <= sizeof(eeprom));
+    ee_updates++;
+    for (size_t i = 0; i < n; i++) {
+        if (eeprom[addr + i] != s[i]) {
+            eeprom[addr + i] = s[i];
+            ee_programmed++;
+        }
+    }
+}
+
+#define EEPFS_WEAR_LEVELING 0
+#define EEPFS_CACHE_LINES 2
+#define EEPFS_CACHE_LINE  4
+#define EEPFS_EE_READ(d, a, n)   ee_read(d, a, n)
+#define EEPFS_EE_UPDATE(a, s, n) ee_update(a, s, n)
+#include "../drivers/fs/eepfs.c"
+
+int main(void)
+{
+    eepfs_format();                        /* no EEPROM on the host: no-op */
+    memcpy(eeprom, "EEPROM FS\n", 10);
+
+    const eepfs_file_t *f = eepfs_open("/sys/message.txt");
+    assert(f && f->size == 10);
+    char buf[16];
+
+    /* Repeated writes coalesce in RAM; reads see them */
+    for (int i = 0; i < 50; i++) {
+        assert(eepfs_write(f, 1, "xy", 2) == 2);
+    }
+    assert(ee_updates == 0 && eepfs_dirty() == 1);
+    assert(eepfs_read(f, 0, buf, sizeof buf) == 10);
+    assert(memcmp(buf, "ExyROM FS\n", 10) == 0);
+    assert(memcmp(eeprom, "EEPROM FS\n", 10) == 0);
+
+    assert(eepfs_fsync(f) == 1);
+    assert(ee_programmed == 2 && eepfs_dirty() == 0);
+    assert(memcmp(eeprom, "ExyROM FS\n", 10) == 0);
+    assert(eepfs_sync() == 0);
+
+    /* Writing back what is already there programs nothing */
+    assert(eepfs_write(f, 0, "Exy", 3) == 3);
+    assert(eepfs_sync() == 1 && ee_programmed == 2);
+
+    /* A write spanning three lines evicts (flushes) the oldest */
+    ee_updates = 0;
+    assert(eepfs_write(f, 2, "1234567", 7) == 7);      /* lines 0, 4, 8 */
+    assert(ee_updates == 1 && eepfs_dirty() == 2);
+    assert(memcmp(eeprom, "Ex12OM FS\n", 10) == 0);     /* line 0 only */
+    assert(eepfs_read(f, 0, buf, 10) == 10);
+    assert(memcmp(buf, "Ex1234567\n", 10) == 0);
+
+    /* Background flushing: one line per step, oldest first */
+    assert(eepfs_sync_step());
+    assert(memcmp(eeprom, "Ex123456S\n", 10) == 0);
+    assert(!eepfs_sync_step());
+    assert(memcmp(eeprom, "Ex1234567\n", 10) == 0);
+    assert(!eepfs_sync_step() && eepfs_dirty() == 0);
+
+    /* Writes are still clipped at EOF */
+    assert(eepfs_write(f, 8, "abcd", 4) == 2);
+    assert(eepfs_write(f, 10, "z", 1) == 0);
+    assert(eepfs_sync() == 1 && memcmp(eeprom, "Ex123456ab", 10) == 0);
+    assert(eeprom[10] == 0);
+
+    printf("eepfs cache: %u bytes programmed\n", ee_programmed);
+    return 0;
+}
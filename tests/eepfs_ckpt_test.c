@@ -0,0 +1,148 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* EEPFS fast-mount checkpoints (drivers/fs/eepfs.c) over a RAM EEPROM */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+static uint8_t  eeprom[1024];
+static unsigned ee_read_bytes;
+static long     ee_budget = -1;         /* bytes left before "power loss" */
+
+static void ee_read(void *dst, uint16_t addr, size_t n)
+{
+    assert(addr + n <= sizeof(eeprom));
+    memcpy(dst, &eeprom[addr], n);
+    ee_read_bytes += (unsigned)n;
+}
+
+static void ee_update(uint16_t addr, const void *src, size_t n)
+{
+    const uint8_t *s = src;
+    assert(addr + n <= sizeof(eeprom));
+    for (size_t i = 0; i < n; i++) {
+        if (eeprom[addr + i] != s[i]) {
+            if (ee_budget == 0) {
+                return;
+            }
+            if (ee_budget > 0) {
+                ee_budget--;
+            }
+            eeprom[addr + i] = s[i];
+        }
+    }
+}
+
+#define EEPFS_WEAR_LEVELING 1
+#define EEPFS_CHECKPOINT    8
+#define EEPFS_CACHE_LINES   0
+#define EEPFS_EE_SIZE            sizeof(eeprom)
+#define EEPFS_EE_READ(d, a, n)   ee_read(d, a, n)
+#define EEPFS_EE_UPDATE(a, s, n) ee_update(a, s, n)
+#include "../drivers/fs/eepfs.c"
+
+static char expect[256];
+
+static void check(const eepfs_file_t *f, uint16_t size)
+{
+    char buf[256];
+    assert(eepfs_size(f) == size);
+    assert(eepfs_read(f, 0, buf, sizeof buf) == size);
+    assert(memcmp(buf, expect, size) == 0);
+}
+
+/* Mount cost in EEPROM bytes read */
+static unsigned mount_cost(void)
+{
+    ee_read_bytes = 0;
+    eepfs_mount();
+    return ee_read_bytes;
+}
+
+int main(void)
+{
+    eepfs_format();
+    const eepfs_file_t *f = eepfs_open("/sys/message.txt");
+    assert(f);
+    memcpy(expect, "EEPROM FS\n", 10);
+
+    /* A checkpoint taken by a growing append records the new size */
+    for (int i = 0; i < 10; i++) {
+        while (wl.seq - wl.ckpt_seq + 1 < wl.ckpt_every) {
+            expect[4] ^= 1;
+            assert(eepfs_write(f, 4, &expect[4], 1) == 1);
+        }
+        uint32_t ckpt = wl.ckpt_seq;
+        memcpy(expect + 10 + i * 10, "0123456789", 10);
+        assert(eepfs_write(f, eepfs_size(f), "0123456789", 10) == 10);
+        assert(wl.ckpt_seq != ckpt);
+        eepfs_mount();
+        check(f, (uint16_t)(20 + i * 10));
+    }
+    eepfs_format();
+    memcpy(expect, "EEPROM FS\n", 10);
+
+    /* Grow, then rewrite across many checkpoints */
+    for (int i = 0; i < 10; i++) {
+        memcpy(expect + 10 + i * 10, "0123456789", 10);
+        assert(eepfs_write(f, eepfs_size(f), "0123456789", 10) == 10);
+    }
+    for (int i = 0; i < 500; i++) {
+        expect[i % 110] = (char)('A' + i % 26);
+        assert(eepfs_write(f, (uint16_t)(i % 110), &expect[i % 110], 1) == 1);
+    }
+    assert(wl.ckpt_every == EEPFS_CHECKPOINT && wl.seq - wl.ckpt_seq < EEPFS_CHECKPOINT);
+    uint32_t seq = wl.seq;
+
+    /* Mount from the checkpoint reads far less than a full scan */
+    unsigned fast = mount_cost();
+    assert(wl.seq == seq);
+    check(f, 110);
+    const uint8_t erased = 0xFF;
+    uint8_t slot0 = eeprom[wl_ckpt_addr(0)], slot1 = eeprom[wl_ckpt_addr(1)];
+    ee_update(wl_ckpt_addr(0), &erased, 1);
+    ee_update(wl_ckpt_addr(1), &erased, 1);
+    unsigned full = mount_cost();
+    assert(wl.seq == seq);
+    check(f, 110);
+    assert(fast * 3 < full);
+    eeprom[wl_ckpt_addr(0)] = slot0;
+    eeprom[wl_ckpt_addr(1)] = slot1;
+
+    /* Power lost at every byte of writes that take a checkpoint */
+    for (long cut = 0; cut < 80; cut++) {
+        eepfs_mount();
+        while (wl.seq - wl.ckpt_seq + 1 < wl.ckpt_every) {
+            assert(eepfs_write(f, 3, &expect[3], 1) == 1);   /* no-op */
+            expect[4] ^= 1;
+            assert(eepfs_write(f, 4, &expect[4], 1) == 1);
+        }
+        char old = expect[40], now = (char)(old + 1);
+        ee_budget = cut;
+        eepfs_write(f, 40, &now, 1);          /* the checkpointing write */
+        ee_budget = -1;
+        eepfs_mount();
+        char got;
+        assert(eepfs_read(f, 40, &got, 1) == 1 && (got == old || got == now));
+        expect[40] = got;
+        check(f, 110);
+    }
+
+    /* A stale checkpoint (replayed into reused pages) is detected */
+    uint8_t saved[2 * WL_CKPT_PAGES * EEPFS_PAGE];
+    memcpy(saved, &eeprom[wl_ckpt_addr(0)], sizeof saved);
+    for (int i = 0; i < 200; i++) {
+        expect[i % 7] = (char)('a' + i % 26);
+        assert(eepfs_write(f, (uint16_t)(i % 7), &expect[i % 7], 1) == 1);
+    }
+    memcpy(&eeprom[wl_ckpt_addr(0)], saved, sizeof saved);
+    eepfs_mount();
+    check(f, 110);
+
+    printf("eepfs checkpoint: mount reads %u bytes instead of %u\n", fast, full);
+    return 0;
+}
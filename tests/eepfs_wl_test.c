@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* EEPFS wear levelling (drivers/fs/eepfs.c) over a RAM EEPROM image */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+static uint8_t  eeprom[512];
+static unsigned wear[sizeof(eeprom)];   /* programming cycles per byte */
+static unsigned ee_programmed;
+static unsigned ee_reads;
+static long     ee_budget = -1;         /* bytes left before "power loss" */
+
+static void ee_read(void *dst, uint16_t addr, size_t n)
+{
+    assert(addr + n <= sizeof(eeprom));
+    memcpy(dst, &eeprom[addr], n);
+    ee_reads++;
+}
+
+static void ee_update(uint16_t addr, const void *src, size_t n)
+{
+    const uint8_t *s = src;
+    assert(addr + n <= sizeof(eeprom));
+    for (size_t i = 0; i < n; i++) {
+        if (eeprom[addr + i] != s[i]) {
+            if (ee_budget == 0) {
+                return;                 /* torn: the rest never lands */
+            }
+            if (ee_budget > 0) {
+                ee_budget--;
+            }
+            eeprom[addr + i] = s[i];
+            wear[addr + i]++;
+            ee_programmed++;
+        }
+    }
+}
+
+#define NK_WARM 1
+#include "../kernel/lib/nk_warm.c"
+
+#define EEPFS_WEAR_LEVELING 1
+#define EEPFS_CACHE_LINES   0
+#define EEPFS_CHECKPOINT    0
+#define EEPFS_EE_SIZE            sizeof(eeprom)
+#define EEPFS_EE_READ(d, a, n)   ee_read(d, a, n)
+#define EEPFS_EE_UPDATE(a, s, n) ee_update(a, s, n)
+#include "../drivers/fs/eepfs.c"
+
+#define PAGES (sizeof(eeprom) / EEPFS_PAGE)
+
+int main(void)
+{
+    char buf[256];
+
+    memset(eeprom, 0xA5, sizeof eeprom);   /* garbage from the factory */
+    eepfs_format();
+    const eepfs_file_t *f = eepfs_open("/sys/message.txt");
+    assert(f && eepfs_size(f) == 10);
+    assert(eepfs_read(f, 0, buf, sizeof buf) == 10);
+    assert(memcmp(buf, "EEPROM FS\n", 10) == 0);
+
+    /* Files grow by appending, across blocks; holes are refused */
+    for (int i = 0; i < 10; i++) {
+        assert(eepfs_write(f, eepfs_size(f), "0123456789", 10) == 10);
+    }
+    assert(eepfs_size(f) == 110);
+    assert(eepfs_write(f, 111, "x", 1) == 0);
+    assert(eepfs_read(f, 100, buf, sizeof buf) == 10);
+    assert(memcmp(buf, "0123456789", 10) == 0);
+
+    /* Contents and size survive a remount */
+    eepfs_mount();
+    assert(eepfs_size(f) == 110);
+    assert(eepfs_read(f, 0, buf, sizeof buf) == 110);
+    assert(memcmp(buf, "EEPROM FS\n0123456789", 20) == 0);
+
+    /* Rewriting what is already there programs nothing */
+    unsigned before = ee_programmed;
+    assert(eepfs_write(f, 10, "0123456789", 10) == 10);
+    assert(ee_programmed == before);
+
+    /* A hot header rewritten 1000 times wears the whole device evenly */
+    memset(wear, 0, sizeof wear);
+    for (int i = 0; i < 1000; i++) {
+        char c = (char)('a' + i % 26);
+        assert(eepfs_write(f, 0, &c, 1) == 1);
+    }
+    unsigned hot = 0, pages_used = 0;
+    for (unsigned p = 0; p < PAGES; p++) {
+        unsigned w = wear[p * EEPFS_PAGE + 3];   /* low byte of seq */
+        hot = w > hot ? w : hot;
+        pages_used += w != 0;
+    }
+    assert(pages_used >= PAGES - 110 / WL_PAYLOAD - 1);
+    assert(hot <= 2 * 1000 / (PAGES - 6));       /* in-place would be 1000 */
+    assert(eepfs_read(f, 0, buf, 1) == 1 && buf[0] == (char)('a' + 999 % 26));
+
+    /* A write torn at any byte leaves the old or the new block */
+    for (long cut = 0; cut < EEPFS_PAGE; cut++) {
+        char old = 0, now;
+        assert(eepfs_read(f, 5, &old, 1) == 1);
+        now = (char)(old + 1);
+        ee_budget = cut;
+        eepfs_write(f, 5, &now, 1);
+        ee_budget = -1;
+        eepfs_mount();
+        assert(eepfs_size(f) == 110);
+        assert(eepfs_read(f, 5, buf, 1) == 1);
+        assert(buf[0] == old || buf[0] == now);
+        assert(eepfs_read(f, 10, buf, 100) == 100);
+        assert(memcmp(buf + 90, "0123456789", 10) == 0);
+    }
+
+    /* Capacity is EEPFS_MAX_BLOCKS blocks */
+    const uint16_t cap = EEPFS_MAX_BLOCKS * WL_PAYLOAD;
+    memset(buf, 'z', sizeof buf);
+    assert(eepfs_write(f, eepfs_size(f), buf, sizeof buf) == cap - 110);
+    assert(eepfs_size(f) == cap);
+    assert(eepfs_write(f, cap, buf, 1) == 0);
+
+    uint16_t used, total;
+    eepfs_stats(&used, &total);
+    assert(used == EEPFS_MAX_BLOCKS * EEPFS_PAGE && total == sizeof eeprom);
+
+    /* Format starts over */
+    eepfs_format();
+    assert(eepfs_size(f) == 10);
+    eepfs_mount();
+    assert(eepfs_size(f) == 10);
+
+    /* A warm reset straight after an append resumes with the new size */
+    nk_warm_init(HAL_RESET_WATCHDOG);                /* first boot: cold */
+    eepfs_mount();
+    assert(eepfs_write(f, 10, "warm", 4) == 4);
+    wl_mounted = false;
+    nk_warm_init(HAL_RESET_WATCHDOG);
+    assert(nk_warm_is_warm());
+    ee_reads = 0;
+    assert(eepfs_size(f) == 14 && ee_reads == 0);    /* no scan */
+    assert(eepfs_read(f, 10, buf, 4) == 4 && memcmp(buf, "warm", 4) == 0);
+
+    printf("eepfs wear levelling: hottest page %u/1000 writes\n", hot);
+    return 0;
+}
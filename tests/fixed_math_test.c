@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Fixed-point transcendentals (src/fixed_math.c) against libm over
+ * every input: the error bounds documented in fixed_point.h. */
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "fixed_point.h"
+
+static const double PI = 3.14159265358979323846;
+
+static double worst;
+
+static void check(double got, double want, double bound)
+{
+    double e = fabs(got - want);
+    if (e > worst) {
+        worst = e;
+    }
+    assert(e <= bound);
+}
+
+static void trig_tests(void)
+{
+    for (int32_t a = INT16_MIN; a <= INT16_MAX; a++) {
+        double r = a / 32768.0 * PI;
+        check(q15_sin((q15_t)a), fmin(32767.0, sin(r) * 32768.0), 1.5);
+        check(q15_cos((q15_t)a), fmin(32767.0, cos(r) * 32768.0), 1.5);
+        r = a / 256.0;                      /* Q8.8 radians, many turns */
+        check(q8_8_sin((q8_8_t)a), sin(r) * 256.0, 1.0);
+        check(q8_8_cos((q8_8_t)a), cos(r) * 256.0, 1.0);
+    }
+    assert(q15_sin(0) == 0 && q15_sin(0x4000) == Q15_MAX);
+    assert(q15_sin(Q15_MIN) == 0 && q15_cos(0) == Q15_MAX);
+    assert(q8_8_cos(0) == 0x0100);
+}
+
+static void atan2_tests(void)
+{
+    for (int32_t y = INT16_MIN; y <= INT16_MAX; y += 7) {
+        for (int32_t x = INT16_MIN; x <= INT16_MAX; x += 131) {
+            if (x == 0 && y == 0) {
+                continue;
+            }
+            double ref = atan2(y, x);
+            double got = q15_atan2((q15_t)y, (q15_t)x);
+            double want = ref / PI * 32768.0;
+            if (want - got > 32768.0) {
+                got += 65536.0;             /* -pi and pi are one angle */
+            }
+            check(got, want, 1.5);
+            check(q8_8_atan2((q8_8_t)y, (q8_8_t)x), ref * 256.0, 1.0);
+        }
+    }
+    assert(q15_atan2(0, 0) == 0 && q8_8_atan2(0, 0) == 0);
+    assert(q15_atan2(1, 1) == 0x2000 && q15_atan2(-5, 0) == -0x4000);
+    assert(q15_atan2(0, -1) == Q15_MIN);    /* pi */
+}
+
+static void sqrt_exp_tests(void)
+{
+    for (int32_t x = INT16_MIN; x <= INT16_MAX; x++) {
+        double s15 = x > 0 ? sqrt(x * 32768.0) : 0.0;
+        double s88 = x > 0 ? sqrt(x * 256.0) : 0.0;
+        check(q15_sqrt((q15_t)x), s15, 0.5);
+        check(q8_8_sqrt((q8_8_t)x), s88, 0.5);
+
+        check(q15_exp((q15_t)x), fmin(32767.0, exp(x / 32768.0) * 32768.0), 1.5);
+        double e = fmin(32767.0, exp(x / 256.0) * 256.0);
+        check(q8_8_exp((q8_8_t)x), e, fmax(1.0, e * 0.00005));
+    }
+    assert(q15_sqrt(0x2000) == 0x4000);     /* sqrt(1/4) = 1/2 */
+    assert(q8_8_sqrt(0x0400) == 0x0200);    /* sqrt(4) = 2 */
+    assert(q15_exp(0) == Q15_MAX && q8_8_exp(0) == 0x0100);
+    assert(q8_8_exp(INT16_MAX) == INT16_MAX && q8_8_exp(INT16_MIN) == 0);
+}
+
+int main(void)
+{
+    trig_tests();
+    atan2_tests();
+    sqrt_exp_tests();
+    printf("fixed_math_test: ok (worst error %.2f LSB)\n", worst);
+    return 0;
+}
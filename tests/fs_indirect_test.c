@@ -0,0 +1,56 @@
+#include "fs.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Files past FS_NDIRECT blocks, and block reuse after fs_unlink() */
+
+int main(void)
+{
+    fs_init();
+
+    /* Block zero doubles as "unmapped": keep it out of the way */
+    assert(fs_create("dummy", 1) >= 0);
+    file_t d;
+    assert(fs_open("dummy", &d) == 0);
+    char c = 'x';
+    assert(fs_write(&d, &c, 1) == 1);
+
+    /* A file larger than the direct blocks goes through the indirect one */
+    static uint8_t big[(FS_NDIRECT + 6) * FS_BLOCK_SIZE + 5];
+    for (size_t i = 0; i < sizeof big; ++i) {
+        big[i] = (uint8_t)(i * 7 + 1);
+    }
+    assert(fs_create("big", 1) >= 0);
+    file_t f;
+    assert(fs_open("big", &f) == 0);
+    assert(fs_write(&f, big, sizeof big) == (int)sizeof big);
+
+    static uint8_t back[sizeof big];
+    f.off = 0;
+    assert(fs_read(&f, back, sizeof back) == (int)sizeof big);
+    assert(memcmp(back, big, sizeof big) == 0);
+
+    /* Unaligned read straddling the direct/indirect boundary */
+    f.off = FS_NDIRECT * FS_BLOCK_SIZE - 3;
+    assert(fs_read(&f, back, 6) == 6);
+    assert(memcmp(back, big + FS_NDIRECT * FS_BLOCK_SIZE - 3, 6) == 0);
+
+    /* The disk fills up: 16 blocks = dummy + 11 data + 1 indirect + 3 */
+    static uint8_t more[FS_NUM_BLOCKS * FS_BLOCK_SIZE];
+    f.off = sizeof big;
+    int w = fs_write(&f, more, sizeof more);
+    assert(w == (int)(3 * FS_BLOCK_SIZE + FS_BLOCK_SIZE - 5));
+    assert(fs_write(&f, more, 1) == 0);
+
+    /* Unlink returns every block, the indirect one included */
+    assert(fs_unlink("big") == 0);
+    assert(fs_create("again", 1) >= 0);
+    assert(fs_open("again", &f) == 0);
+    w = fs_write(&f, more, sizeof more);
+    assert(w == (FS_NUM_BLOCKS - 2) * FS_BLOCK_SIZE);   /* all but dummy + indirect */
+
+    puts("fs indirect blocks passed");
+    return 0;
+}
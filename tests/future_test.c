@@ -0,0 +1,120 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* nk_future: nk_await(), nk_await_any() and callback completion */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arch/common/hal.h"
+#include "kernel/sched/scheduler.h"
+#include "kernel/sync/nk_future.h"
+
+
+static nk_tcb_t tm, tc;
+static uint8_t  sm[HAL_HOST_STACK], sc[HAL_HOST_STACK];
+
+static nk_future_t fa, fb, fc;
+static nk_future_t *volatile target;
+
+/* Completes `target` with 42 after a short nap, as an ISR would */
+static void completer(void)
+{
+    nk_sleep(5);
+    nk_future_complete(target, 42);
+    nk_task_exit(0);
+}
+
+static void complete_later(nk_future_t *f)
+{
+    target = f;
+    assert(nk_task_create(&tc, completer, 2, sc, HAL_HOST_STACK));
+}
+
+static void reap_child(void)
+{
+    assert(nk_task_wait(tc.pid) == 0);
+    nk_task_release(tc.pid);
+}
+
+static void await_one(void)
+{
+    nk_future_init(&fa);
+    assert(nk_await(&fa, NK_FUT_FOREVER) == -1);    /* never armed */
+
+    nk_future_arm(&fa);
+    assert(!nk_future_done(&fa));
+    uint32_t t0 = nk_ticks();
+    assert(nk_await(&fa, 5) == -1);
+    assert(nk_ticks() - t0 >= 5);
+
+    complete_later(&fa);
+    t0 = nk_ticks();
+    assert(nk_await(&fa, NK_FUT_FOREVER) == 0);
+    assert(nk_ticks() - t0 < 500);
+    assert(nk_future_result(&fa) == 42);
+    reap_child();
+
+    /* Done stays done; later completions are ignored */
+    nk_future_complete(&fa, 7);
+    assert(nk_await(&fa, 0) == 0 && nk_future_result(&fa) == 42);
+}
+
+static void await_any(void)
+{
+    nk_future_t *const set[] = { &fa, NULL, &fb, &fc };
+
+    nk_future_init(&fa);
+    nk_future_init(&fb);
+    nk_future_init(&fc);
+    assert(nk_await_any(set, 4, NK_FUT_FOREVER) == -1);  /* nothing armed */
+
+    nk_future_arm(&fa);
+    nk_future_arm(&fb);
+    nk_future_arm(&fc);
+    assert(nk_await_any(set, 4, 5) == -1);
+
+    /* One completion wakes the set; the index says which */
+    complete_later(&fc);
+    assert(nk_await_any(set, 4, NK_FUT_FOREVER) == 3);
+    assert(nk_future_result(&fc) == 42);
+    reap_child();
+    assert(nk_await_any(set, 4, 0) == 3);           /* still done */
+
+    /* A single-future waiter and the set see the same completion */
+    nk_future_init(&fc);
+    complete_later(&fb);
+    assert(nk_await_any(set, 4, 1000) == 2);
+    assert(nk_await(&fb, 0) == 0);
+    reap_child();
+    assert(!nk_future_done(&fa));
+}
+
+static void callbacks(void)
+{
+    static const uint8_t cfg[4] = { 1, 2, 3, 4 };
+
+    /* Callback-style drivers complete through nk_future_cb() */
+    nk_future_arm(&fa);
+    assert(hal_eeprom_write_async(0, cfg, sizeof(cfg), nk_future_cb, &fa));
+    assert(nk_await(&fa, 100) == 0 && nk_future_result(&fa) == 0);
+}
+
+static void main_task(void)
+{
+    await_one();
+    await_any();
+    callbacks();
+    printf("future_test: ok\n");
+    exit(0);
+}
+
+int main(void)
+{
+    nk_sched_init();
+    assert(nk_task_create(&tm, main_task, 1, sm, sizeof(sm)));
+    nk_sched_run();
+    return 1;
+}
@@ -0,0 +1,180 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Firmware update service: windowed transfer, go-back-N, CRC check and
+ * the A/B record swap (drivers/net/fwup.c) on the host flash emulation,
+ * where a page lands only erase_ns + write_ns after it was started */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "drivers/net/fwup.h"
+#include "kernel/lib/nk_crc.h"
+
+#define FLASH  (64u * 1024u)
+#define IMAGE  20000u
+
+static uint8_t image[IMAGE];
+static uint8_t reply[FWUP_HLEN];
+
+typedef struct {
+    uint8_t  status;
+    uint32_t next;
+    uint32_t credit;
+} ack_t;
+
+static ack_t last;
+
+static bool got(uint16_t n)
+{
+    const fwup_hdr_t *h = (const fwup_hdr_t *)reply;
+    if (n == 0) return false;
+    assert(n == FWUP_HLEN && h->op == FWUP_OP_ACK);
+    last.status = h->status;
+    last.next = ipv4_ntohl(h->off);
+    last.credit = ipv4_ntohl(h->arg);
+    return true;
+}
+
+static uint16_t req(uint8_t op, uint16_t session, uint32_t off, uint32_t arg,
+                    const void *data, uint16_t len)
+{
+    uint8_t msg[FWUP_HLEN + FWUP_MAX_DATA];
+    fwup_hdr_t h = { op, 0, ipv4_htons(session), ipv4_htonl(off), ipv4_htonl(arg) };
+    memcpy(msg, &h, FWUP_HLEN);
+    memcpy(msg + FWUP_HLEN, data, len);
+    return fwup_input(msg, (uint16_t)(FWUP_HLEN + len), reply);
+}
+
+static unsigned overlapped;     /* DATA taken while a page was programming */
+
+/* Send @p len bytes the way a windowed sender would, announcing @p crc;
+ * datagram number @p drop (if any) is lost on the line */
+static void send_image(uint16_t session, const uint8_t *img, uint32_t len, uint32_t crc,
+                       int drop)
+{
+    int dgram = 0;
+
+    assert(got(req(FWUP_OP_START, session, len, crc, NULL, 0)));
+    assert(last.status == FWUP_ST_OK && last.next == 0);
+    assert(last.credit == 2 * HAL_FLASH_PAGE_SIZE);
+    while (last.next < len) {
+        uint32_t sent = last.next, limit = last.next + last.credit;
+        bool nacked = false;
+
+        while (sent < limit && !nacked) {
+            uint16_t n = (uint16_t)(limit - sent < FWUP_MAX_DATA ? limit - sent : FWUP_MAX_DATA);
+            bool busy = hal_flash_busy();
+            uint32_t before = fwup_status()->next;
+
+            if (dgram++ != drop && got(req(FWUP_OP_DATA, session, sent, 0, img + sent, n))) {
+                nacked = last.status == FWUP_ST_RESEND;
+                assert(nacked || last.status == FWUP_ST_OK);
+                limit = last.next + last.credit;
+            }
+            overlapped += busy && fwup_status()->next > before;
+            sent += n;
+        }
+        if (nacked) continue;
+
+        /* out of credit: wait for a page to finish, or time out and ask */
+        uint32_t t0 = hal_cycles();
+        while (!got(fwup_step(reply))) {
+            if (hal_cycles() - t0 > 50000000u) {
+                assert(got(req(FWUP_OP_START, session, len, crc, NULL, 0)));
+                break;
+            }
+        }
+    }
+}
+
+static uint8_t commit(uint16_t session)
+{
+    do {
+        assert(got(req(FWUP_OP_COMMIT, session, 0, 0, NULL, 0)));
+    } while (last.status == FWUP_ST_BUSY);
+    return last.status;
+}
+
+static bool slot_holds(uint8_t slot, const uint8_t *img, uint32_t len)
+{
+    static uint8_t buf[IMAGE];
+    hal_flash_read(buf, fwup_slot_addr(slot), len);
+    return memcmp(buf, img, len) == 0;
+}
+
+int main(void)
+{
+    hal_host_flash.erase_ns = 2000000;              /* 2 ms + 2 us/byte a page */
+    hal_host_flash.write_ns = 2000;
+    assert(hal_host_nvm_map(&hal_host_flash, NULL, FLASH) == 0);
+    for (uint32_t i = 0; i < IMAGE; i++) {
+        image[i] = (uint8_t)(i * 7u + (i >> 8));
+    }
+
+    udp_init(0x0A000001);
+    assert(fwup_init(0) == 0 && udp_port(0) == FWUP_PORT);
+    assert(fwup_boot_slot() == -1 && fwup_status()->running == 0);
+    assert(fwup_slot_addr(1) == FLASH / 2);
+
+    /* refused: too big, unknown session, COMMIT before the data */
+    assert(got(req(FWUP_OP_START, 1, FLASH / 2, 0, NULL, 0)) && last.status == FWUP_ST_SIZE);
+    assert(got(req(FWUP_OP_DATA, 9, 0, 0, image, 16)) && last.status == FWUP_ST_SESSION);
+    assert(got(req(FWUP_OP_START, 1, IMAGE, nk_crc32(0, image, IMAGE), NULL, 0)));
+    assert(got(req(FWUP_OP_COMMIT, 1, 0, 0, NULL, 0)) && last.status == FWUP_ST_BAD);
+
+    /* out of order: one reminder of next per gap, then back in order */
+    assert(got(req(FWUP_OP_DATA, 1, 100, 0, image + 100, 16)) && last.next == 0);
+    assert(last.status == FWUP_ST_RESEND);
+    assert(!got(req(FWUP_OP_DATA, 1, 116, 0, image + 116, 16)));
+    assert(fwup_status()->rejected == 2);
+    assert(!got(req(FWUP_OP_DATA, 1, 0, 0, image, 100)) && fwup_status()->next == 100);
+    assert(got(req(FWUP_OP_DATA, 1, 0, 0, image, 100)) && last.next == 100);  /* a dup */
+    assert(last.credit == 2 * HAL_FLASH_PAGE_SIZE - 100);
+    assert(!got(req(FWUP_OP_DATA, 1, 100, 0, image + 100, 2 * HAL_FLASH_PAGE_SIZE)));
+    assert(fwup_status()->next == 100);             /* over the credit */
+
+    /* a whole image, one datagram lost on the way */
+    send_image(2, image, IMAGE, nk_crc32(0, image, IMAGE), 5);
+    const fwup_status_t *st = fwup_status();
+    assert(st->state == FWUP_RECV && st->next == IMAGE);
+    assert(overlapped > 0);                         /* the line ran during programming */
+    assert(commit(2) == FWUP_ST_OK && st->state == FWUP_DONE);
+    assert(st->pages == (IMAGE + HAL_FLASH_PAGE_SIZE - 1) / HAL_FLASH_PAGE_SIZE);
+    assert(slot_holds(1, image, IMAGE) && fwup_boot_slot() == 1);
+    assert(got(req(FWUP_OP_DATA, 2, 0, 0, image, 16)) && last.status == FWUP_ST_OK);
+    assert(commit(2) == FWUP_ST_OK);
+
+    /* "reboot" into slot 1: the next update goes to slot 0 */
+    assert(fwup_init(0) == 0 && fwup_status()->running == 1);
+    image[100] ^= 0x55;
+
+    /* an interrupted transfer leaves slot 1 in charge */
+    assert(got(req(FWUP_OP_START, 3, IMAGE, nk_crc32(0, image, IMAGE), NULL, 0)));
+    assert(!got(req(FWUP_OP_DATA, 3, 0, 0, image, 100)));
+    assert(got(req(FWUP_OP_ABORT, 3, 0, 0, NULL, 0)) && fwup_boot_slot() == 1);
+
+    /* a CRC that does not match what arrived is not committed */
+    send_image(4, image, IMAGE, 0x1234, -1);
+    assert(commit(4) == FWUP_ST_CRC && fwup_status()->state == FWUP_FAILED);
+    assert(fwup_boot_slot() == 1);
+
+    /* and a good one takes over, one generation up */
+    send_image(5, image, IMAGE, nk_crc32(0, image, IMAGE), -1);
+    assert(commit(5) == FWUP_ST_OK && fwup_boot_slot() == 0);
+    assert(slot_holds(0, image, IMAGE));
+    fwup_record_t r0, r1;
+    hal_flash_read(&r0, fwup_slot_addr(1) - HAL_FLASH_PAGE_SIZE, sizeof r0);
+    hal_flash_read(&r1, FLASH - HAL_FLASH_PAGE_SIZE, sizeof r1);
+    assert(r0.magic == FWUP_MAGIC && r1.magic == FWUP_MAGIC && r0.gen == r1.gen + 1);
+
+    /* a torn record is ignored: slot 1 boots again */
+    hal_host_flash.mem[fwup_slot_addr(1) - HAL_FLASH_PAGE_SIZE + 4] ^= 1;
+    assert(fwup_boot_slot() == 1);
+
+    printf("fwup: ok (%u pages, %u taken while programming, %llu ns flash busy)\n",
+           (unsigned)st->pages, overlapped, (unsigned long long)hal_host_flash.busy_ns);
+    return 0;
+}
@@ -0,0 +1,189 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* GDB remote stub (src/avr_gdbstub.c) against a scripted host: packet
+ * framing and acks, m/M/X memory access, run-length encoded replies,
+ * qXfer bulk reads and QBaud. */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NK_LOG_ENABLED 1
+#define NK_LOG_BUF 32
+#include "../kernel/sync/nk_log.c"
+#include "../src/avr_gdbstub.c"
+
+/* Host side of the line */
+static uint8_t to_stub[512];
+static size_t to_stub_len, to_stub_pos;
+static uint8_t from_stub[2048];
+static size_t from_stub_len;
+
+static void line_putc(uint8_t c) {
+    assert(from_stub_len < sizeof from_stub);
+    from_stub[from_stub_len++] = c;
+}
+
+static int line_getc(void) {
+    return to_stub_pos < to_stub_len ? to_stub[to_stub_pos++] : -1;
+}
+
+static void send_raw(const char *s, size_t n) {
+    memcpy(to_stub + to_stub_len, s, n);
+    to_stub_len += n;
+}
+
+/* Frame @p body (n bytes) as "$body#cs" followed by an ack for the reply */
+static void send(const char *body, size_t n) {
+    char tail[8];
+    uint8_t sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += (uint8_t)body[i];
+    }
+    send_raw("$", 1);
+    send_raw(body, n);
+    snprintf(tail, sizeof tail, "#%02x+", sum);
+    send_raw(tail, strlen(tail));
+}
+
+/* Check the framing and checksum of the last reply, return it decoded */
+static size_t reply_body(char *dst, size_t max) {
+    size_t i = 0;
+    assert(from_stub[i++] == '+');          /* Our packet was acked */
+    assert(from_stub[i++] == '$');
+    uint8_t sum = 0;
+    size_t n = 0;
+    while (from_stub[i] != '#') {
+        uint8_t c = from_stub[i++];
+        sum += c;
+        if (c == '*') {                     /* Run: previous char again */
+            uint8_t r = from_stub[i++];
+            sum += r;
+            assert(r != '#' && r != '$');
+            for (int k = 0; k < r - 29; k++) {
+                dst[n] = dst[n - 1];
+                n++;
+            }
+        } else {
+            dst[n++] = (char)c;
+        }
+        assert(n < max);
+    }
+    unsigned want;
+    assert(sscanf((const char *)from_stub + i + 1, "%2x", &want) == 1);
+    assert(want == sum);
+    dst[n] = '\0';
+    return n;
+}
+
+static size_t wire_len(void) {
+    size_t n = 0;
+    while (from_stub[n] != '#') n++;
+    return n + 3;
+}
+
+static size_t roundtrip(const char *body, size_t n, char *dst, size_t max) {
+    to_stub_len = to_stub_pos = from_stub_len = 0;
+    send(body, n);
+    gdbstub_poll();
+    return reply_body(dst, max);
+}
+
+static size_t cmd(const char *body, char *dst) {
+    return roundtrip(body, strlen(body), dst, 1024);
+}
+
+static uint32_t baud_set;
+static void set_baud(uint32_t baud) { baud_set = baud; }
+
+int main(void)
+{
+    static tty_t tty;
+    static uint8_t rx[64], tx[64];
+    static uint8_t mem[64];
+    char r[1024], q[128];
+
+    tty_init(&tty, rx, tx, 64, line_putc, line_getc);
+    to_stub[0] = '+';                       /* Ack the greeting */
+    to_stub_len = 1;
+    gdbstub_init(&tty);
+    assert(!memcmp(from_stub, "$OK#9a", 6));
+
+    cmd("?", r);
+    assert(!strcmp(r, "S05"));
+    cmd("qSupported:multiprocess+", r);
+    assert(strstr(r, "PacketSize=80") && strstr(r, "qXfer:nk:read+"));
+
+    /* m: hex read; the zero tail comes back run-length encoded */
+    memset(mem, 0, sizeof mem);
+    mem[0] = 0xAB;
+    mem[1] = 0x12;
+    snprintf(q, sizeof q, "m%lx,40", (unsigned long)(uintptr_t)mem);
+    assert(cmd(q, r) == 128);
+    assert(!strncmp(r, "ab12000000", 10));
+    assert(wire_len() < 16);
+
+    /* M: hex write */
+    snprintf(q, sizeof q, "M%lx,2:beef", (unsigned long)(uintptr_t)(mem + 8));
+    cmd(q, r);
+    assert(!strcmp(r, "OK") && mem[8] == 0xBE && mem[9] == 0xEF);
+
+    /* X: binary write, with escapes and a NUL in the data */
+    int n = snprintf(q, sizeof q, "X%lx,5:", (unsigned long)(uintptr_t)(mem + 16));
+    memcpy(q + n, "a}\x03\0#z", 6);         /* '}' 0x03 is '#' escaped */
+    memcpy(q + n + 4, "}\x04z", 3);         /* '$' escaped, then 'z' */
+    roundtrip(q, (size_t)n + 7, r, sizeof r);
+    assert(!strcmp(r, "OK"));
+    assert(!memcmp(mem + 16, "a#\0$z", 5));
+
+    /* Bad checksum: NAK and no reply */
+    to_stub_len = to_stub_pos = from_stub_len = 0;
+    send_raw("$?#00", 5);
+    gdbstub_poll();
+    assert(from_stub_len == 1 && from_stub[0] == '-');
+
+    /* qXfer: the log image in chunks */
+    nk_log_init();
+    NK_LOG("x %d", 1);
+    size_t img_len;
+    const uint8_t *img = nk_log_image(&img_len);
+    uint8_t got[sizeof nk_log_buf];
+    size_t off = 0;
+    for (;;) {
+        snprintf(q, sizeof q, "qXfer:nk:read:log:%lx,10", (unsigned long)off);
+        size_t m = cmd(q, r);
+        assert(r[0] == 'm' || r[0] == 'l');
+        for (size_t i = 1; i < m; i++) {    /* Undo the escapes */
+            uint8_t c = (uint8_t)r[i];
+            if (c == '}') c = (uint8_t)r[++i] ^ 0x20;
+            got[off++] = c;
+        }
+        if (r[0] == 'l') break;
+    }
+    assert(off == img_len && !memcmp(got, img, img_len));
+    cmd("qXfer:nk:read:nope:0,10", r);
+    assert(!strcmp(r, "E00"));
+
+    /* QBaud: refused without a hook, applied after the ack */
+    cmd("QBaud:7a120", r);
+    assert(!strcmp(r, "E01"));
+    gdbstub_set_baud_hook(set_baud);
+    cmd("QBaud:f4240", r);                  /* 1000000 */
+    assert(!strcmp(r, "OK") && baud_set == 1000000);
+    cmd("QBaud:1e8480", r);                 /* Above GDBSTUB_BAUD_MAX */
+    assert(!strcmp(r, "E01") && baud_set == 1000000);
+
+    /* No-ack mode: no '+' either way */
+    cmd("QStartNoAckMode", r);
+    assert(!strcmp(r, "OK"));
+    to_stub_len = to_stub_pos = from_stub_len = 0;
+    send_raw("$?#3f", 5);
+    gdbstub_poll();
+    assert(!memcmp(from_stub, "$S05#b8", 7));
+
+    printf("gdbstub_test: ok\n");
+    return 0;
+}
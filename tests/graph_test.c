@@ -0,0 +1,139 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* nk_graph: dependency-ordered passes, stepped and on worker tasks */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arch/common/hal.h"
+#include "kernel/sched/scheduler.h"
+#include "kernel/sched/nk_graph.h"
+
+
+static nk_tcb_t tm, tw0, tw1;
+static uint8_t  sm[HAL_HOST_STACK], sw0[HAL_HOST_STACK], sw1[HAL_HOST_STACK];
+
+/* sense -> {lpf, kalman} -> fuse -> act, plus an independent logger */
+enum { SENSE, LPF, KALMAN, FUSE, ACT, LOG, N };
+
+static volatile uint8_t seq[2 * N];
+static volatile uint8_t nseq;
+static volatile int     both;          /* filters seen running together */
+static volatile uint8_t in_filter;
+
+static void node(void *arg)
+{
+    uint8_t id = (uint8_t)(uintptr_t)arg;
+    uint32_t s = nk_sched_lock();
+    seq[nseq++] = id;
+    nk_sched_unlock(s);
+
+    if (id == LPF || id == KALMAN) {
+        s = nk_sched_lock();
+        in_filter++;
+        nk_sched_unlock(s);
+        nk_sleep(5);                   /* let the other worker run */
+        s = nk_sched_lock();
+        if (in_filter == 2) both = 1;
+        nk_sched_unlock(s);
+        nk_sleep(5);
+        s = nk_sched_lock();
+        in_filter--;
+        nk_sched_unlock(s);
+    }
+}
+
+#define ID(i) ((void *)(uintptr_t)(i))
+
+static const nk_graph_node_t nodes[N] = {
+    [SENSE]  = NK_GRAPH_NODE(node, ID(SENSE), LPF, KALMAN),
+    [LPF]    = NK_GRAPH_NODE(node, ID(LPF), FUSE),
+    [KALMAN] = NK_GRAPH_NODE(node, ID(KALMAN), FUSE),
+    [FUSE]   = NK_GRAPH_NODE(node, ID(FUSE), ACT),
+    [ACT]    = NK_GRAPH_SINK(node, ID(ACT)),
+    [LOG]    = NK_GRAPH_SINK(node, ID(LOG)),
+};
+NK_GRAPH_DEFINE(ctl, nodes);
+
+static const nk_graph_node_t loop_nodes[] = {
+    NK_GRAPH_NODE(node, ID(0), 1),
+    NK_GRAPH_NODE(node, ID(1), 2),
+    NK_GRAPH_NODE(node, ID(2), 1),     /* 1 -> 2 -> 1 */
+};
+NK_GRAPH_DEFINE(loop, loop_nodes);
+
+static const nk_graph_node_t bad_nodes[] = {
+    NK_GRAPH_NODE(node, ID(0), 7),
+};
+NK_GRAPH_DEFINE(bad, bad_nodes);
+
+static int pos(uint8_t id)
+{
+    for (uint8_t i = 0; i < nseq; i++) {
+        if (seq[i] == id) return i;
+    }
+    return -1;
+}
+
+static void check_order(void)
+{
+    assert(nseq == N);
+    for (uint8_t i = 0; i < N; i++) {
+        assert(pos(i) >= 0);
+    }
+    assert(pos(SENSE) < pos(LPF) && pos(SENSE) < pos(KALMAN));
+    assert(pos(LPF) < pos(FUSE) && pos(KALMAN) < pos(FUSE));
+    assert(pos(FUSE) < pos(ACT));
+}
+
+static void worker(void)
+{
+    nk_graph_worker(&ctl);
+}
+
+static void main_task(void)
+{
+    /* One caller stepping: sources first, then as inputs complete */
+    assert(!nk_graph_step(&ctl));
+    assert(nk_graph_start(&ctl));
+    assert(nk_graph_busy(&ctl));
+    assert(ctl.head - ctl.tail == 2);  /* SENSE and LOG */
+    while (nk_graph_step(&ctl)) {}
+    check_order();
+    assert(!nk_graph_busy(&ctl) && ctl.passes == 1);
+    nk_graph_wait(&ctl);               /* nothing running: returns */
+
+    assert(nk_task_create(&tw0, worker, 2, sw0, HAL_HOST_STACK));
+    assert(nk_task_create(&tw1, worker, 2, sw1, HAL_HOST_STACK));
+
+    /* Workers pick up each release; the filters overlap */
+    for (int pass = 0; pass < 3; pass++) {
+        nseq = 0;
+        assert(nk_graph_start(&ctl));
+        assert(!nk_graph_start(&ctl));  /* still running: overrun */
+        nk_graph_wait(&ctl);
+        check_order();
+    }
+    assert(both);
+    assert(ctl.passes == 4 && ctl.overruns == 3);
+    assert(!nk_graph_busy(&ctl));
+
+    printf("graph_test: ok\n");
+    exit(0);
+}
+
+int main(void)
+{
+    nk_sched_init();
+
+    assert(!nk_graph_init(&loop) && !nk_graph_start(&loop));
+    assert(!nk_graph_init(&bad));
+    assert(nk_graph_init(&ctl));
+
+    assert(nk_task_create(&tm, main_task, 1, sm, sizeof(sm)));
+    nk_sched_run();
+    return 1;
+}
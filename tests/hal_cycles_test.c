@@ -0,0 +1,37 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* hal_cycles() / hal_cycles_to_ns() on the host HAL */
+
+#include <assert.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "arch/common/hal.h"
+
+int main(void)
+{
+    /* Conversion: exact at whole periods, saturating past ~4.3 s */
+    assert(hal_cycles_to_ns(0) == 0);
+    assert(hal_cycles_to_ns(HAL_CYCLES_HZ / 1000u) == 1000000u);
+    assert(hal_cycles_to_ns(HAL_CYCLES_HZ / 1000000u) == 1000u);
+    assert(hal_cycles_to_ns(UINT32_MAX) <= UINT32_MAX);
+
+    /* Advances, and a 10 ms sleep measures as roughly 10 ms */
+    uint32_t t0 = hal_cycles();
+    uint32_t t1 = hal_cycles();
+    assert(t1 - t0 < HAL_CYCLES_HZ / 1000u);    /* back to back: < 1 ms */
+
+    t0 = hal_cycles();
+    nanosleep(&(struct timespec){ .tv_nsec = 10000000 }, NULL);
+    uint32_t ns = hal_cycles_to_ns(hal_cycles() - t0);
+    assert(ns >= 10000000u && ns < 500000000u);
+
+    /* Differences survive the 32-bit wrap */
+    uint32_t a = UINT32_MAX - 5u, b = 10u;
+    assert(b - a == 16u);
+
+    printf("hal_cycles_test: ok (10 ms = %lu ns)\n", (unsigned long)ns);
+    return 0;
+}
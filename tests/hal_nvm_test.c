@@ -0,0 +1,158 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Host HAL EEPROM and flash images (arch/common/hal_host_nvm.c)
+ *
+ * AVRIX_SOAK_PUTS=<n> lengthens the TinyLog-4 endurance run at the end;
+ * with AVRIX_EEPROM=<file> it accumulates wear in that image across runs.
+ */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "avrix-config.h"
+#include "arch/common/hal.h"
+#include "nk_fs.h"
+#if CONFIG_FS_BLKDEV_ENABLED
+#include "drivers/fs/blkdev.h"
+#endif
+
+static char img[64];
+
+static void test_unmapped(void)
+{
+    unsetenv("AVRIX_EEPROM");
+    unsetenv("AVRIX_EEPROM_SIZE");
+    assert(!hal_eeprom_available() && hal_eeprom_size() == 0);
+    assert(hal_eeprom_read_byte(0) == 0xFF);
+    hal_eeprom_write_byte(0, 0x12);                 /* dropped */
+    assert(hal_eeprom_read_word(0) == 0xFFFF);
+}
+
+static void test_eeprom(void)
+{
+    uint8_t buf[16];
+
+    setenv("AVRIX_EEPROM", img, 1);
+    setenv("AVRIX_EEPROM_SIZE", "4096", 1);
+    setenv("AVRIX_EEPROM_WRITE_NS", "3400000", 1); /* ATmega: 3.4 ms */
+    hal_host_eeprom.probed = false;
+    assert(hal_eeprom_available() && hal_eeprom_size() == 4096);
+    assert(hal_eeprom_read_dword(4092) == 0xFFFFFFFFu);
+
+    /* update skips unchanged bytes; write always programs */
+    hal_eeprom_update_block(100, "hello", 5);
+    hal_eeprom_update_block(100, "help!", 5);
+    assert(hal_host_eeprom.programmed == 7);
+    assert(hal_host_eeprom.wear[100] == 1 && hal_host_eeprom.wear[103] == 2);
+    hal_eeprom_write_byte(100, 'h');
+    assert(hal_host_eeprom.wear[100] == 2);
+    assert(hal_host_eeprom.busy_ns == 8ull * 3400000u);
+    hal_eeprom_update_dword(200, 0x11223344u);
+    assert(hal_eeprom_read_dword(200) == 0x11223344u);
+    assert(hal_eeprom_read_byte(200) == 0x44);
+
+    /* clipped at the end, reads past it are erased */
+    hal_eeprom_read_block(buf, 4090, sizeof buf);
+    assert(buf[5] == 0xFF && buf[6] == 0xFF && buf[15] == 0xFF);
+    hal_eeprom_write_block(4094, "abcd", 4);
+    assert(hal_eeprom_read_word(4094) == ('a' | 'b' << 8));
+
+    /* the image and its wear outlive the mapping, and grow erased */
+    hal_host_nvm_unmap(&hal_host_eeprom);
+    assert(hal_host_nvm_map(&hal_host_eeprom, img, 8192) == 0);
+    hal_eeprom_read_block(buf, 100, 5);
+    assert(memcmp(buf, "help!", 5) == 0);
+    assert(hal_host_eeprom.wear[103] == 2 && hal_host_eeprom.programmed == 0);
+    assert(hal_eeprom_read_byte(5000) == 0xFF && hal_host_eeprom.wear[5000] == 0);
+    assert(hal_host_nvm_max_wear(&hal_host_eeprom) == 2);
+
+    hal_eeprom_erase_all();
+    assert(hal_eeprom_read_byte(100) == 0xFF && hal_eeprom_read_byte(5000) == 0xFF);
+}
+
+static void test_flash(void)
+{
+    hal_host_nvm_t f = { .nor = true, .erase_ns = 45000000u };
+    assert(hal_host_nvm_map(&f, NULL, 8192) == 0);
+    assert(f.mem[0] == 0xFF && f.mem[8191] == 0xFF);
+
+    /* programming only clears bits until the sector is erased */
+    hal_host_nvm_write(&f, 10, "\x0F", 1, false);
+    hal_host_nvm_write(&f, 10, "\xF3", 1, false);
+    assert(f.mem[10] == 0x03 && f.wear[10] == 2);
+    hal_host_nvm_erase(&f, 0, 4096);
+    assert(f.mem[10] == 0xFF && f.wear[10] == 3 && f.wear[4096] == 0);
+    assert(f.erased == 4096 && f.busy_ns == 45000000u);
+    hal_host_nvm_unmap(&f);
+
+#if CONFIG_FS_BLKDEV_ENABLED
+    blkdev_t d;
+    uint8_t blk[BLKDEV_BLOCK_SIZE];
+    unsetenv("AVRIX_FLASH");
+    unsetenv("AVRIX_FLASH_SIZE");
+    assert(blkdev_host_nor_init(&d, &hal_host_flash) == 0);
+    assert(d.blocks == (1u << 20) / BLKDEV_BLOCK_SIZE);
+    memset(blk, 0xA5, sizeof blk);
+    assert(blkdev_pwrite(&d, 0, blk, sizeof blk) == 0 && blkdev_sync(&d) == 0);
+    assert(hal_host_flash.mem[0] == 0xA5 && hal_host_flash.wear[0] == 1);
+    assert(blkdev_erase(&d, 0, 1u << d.erase_shift) == 0);
+    assert(hal_host_flash.mem[0] == 0xFF && hal_host_flash.wear[0] == 2);
+#endif
+}
+
+#if CONFIG_FS_EEPFS_ENABLED
+/* TinyLog-4 straight on the HAL image: how evenly does it wear? */
+static void test_soak(void)
+{
+    const char *n = getenv("AVRIX_SOAK_PUTS");
+    unsigned puts = n ? (unsigned)strtoul(n, NULL, 0) : 4000u;
+    uint16_t v;
+
+    hal_host_eeprom.write_ns = 0;
+    hal_eeprom_erase_all();
+    nk_fs_init();
+    for (uint16_t k = 0; k < 8; k++) {
+        assert(nk_fs_put(k, k));
+    }
+    uint64_t before = hal_host_eeprom.programmed;
+    for (unsigned i = 0; i < puts; i++) {
+        assert(nk_fs_put(100 + i % 4, i % 32));
+    }
+    nk_fs_init();
+    for (uint16_t k = 0; k < 8; k++) {
+        assert(nk_fs_get(k, &v) && v == k);
+    }
+    assert(nk_fs_get(100 + (puts - 1) % 4, &v) && v == (puts - 1) % 32);
+
+    /* the log spreads the rewrites of four keys over all 1 KiB */
+    uint32_t max = hal_host_nvm_max_wear(&hal_host_eeprom);
+    double mean = (double)(hal_host_eeprom.programmed - before) / 1024.0;
+    printf("  %u puts: %llu bytes programmed, max wear %u (mean %.1f)\n", puts,
+           (unsigned long long)(hal_host_eeprom.programmed - before), max, mean);
+    assert(max <= 2u * (uint32_t)mean + 4u);
+}
+#endif
+
+int main(void)
+{
+    snprintf(img, sizeof img, "/tmp/hal_nvm_test.%ld.eep", (long)getpid());
+
+    test_unmapped();
+    test_eeprom();
+    test_flash();
+#if CONFIG_FS_EEPFS_ENABLED
+    test_soak();
+#endif
+
+    hal_host_nvm_unmap(&hal_host_eeprom);
+    unlink(img);
+    strcat(img, ".wear");
+    unlink(img);
+    printf("hal_nvm_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Idle governor level selection and the TTY TX hold (kernel/sched/idle.c) */
+
+#define NK_IDLE_GOVERNOR 1
+#define TTY_IDLE_HOLD    1
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "../kernel/sched/idle.c"
+#include "../drivers/tty/tty.c"
+
+/* A part with a timed middle level worth entering for 10+ ticks */
+static const hal_sleep_info_t tab[HAL_SLEEP_LEVELS] = {
+    [HAL_SLEEP_IDLE] = {    1,  0, HAL_SLEEP_F_TIMED },
+    [HAL_SLEEP_SAVE] = {  500, 10, HAL_SLEEP_F_TIMED },
+    [HAL_SLEEP_DEEP] = { 2000,  0, 0 },
+};
+
+static int kicks;
+static void kick(void) { kicks++; }
+
+int main(void)
+{
+    /* Deadline distance decides: untimed DEEP only with nothing due */
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_DEEP);
+    assert(nk_idle_select(tab, 20) == HAL_SLEEP_SAVE);
+    assert(nk_idle_select(tab, 10) == HAL_SLEEP_SAVE);
+    assert(nk_idle_select(tab, 9) == HAL_SLEEP_IDLE);
+    assert(nk_idle_select(tab, 1) == HAL_SLEEP_IDLE);
+
+    /* Latency bound skips the slow levels */
+    nk_idle_set_latency(1000);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_SAVE);
+    nk_idle_set_latency(100);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_IDLE);
+    nk_idle_set_latency(UINT16_MAX);
+
+    /* Holds nest; the shallowest one wins */
+    nk_idle_hold(HAL_SLEEP_SAVE);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_SAVE);
+    nk_idle_hold(HAL_SLEEP_IDLE);
+    nk_idle_hold(HAL_SLEEP_IDLE);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_IDLE);
+    nk_idle_release(HAL_SLEEP_IDLE);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_IDLE);
+    nk_idle_release(HAL_SLEEP_IDLE);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_SAVE);
+    nk_idle_release(HAL_SLEEP_SAVE);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_DEEP);
+
+    /* An unbalanced release does not wrap the count */
+    nk_idle_release(HAL_SLEEP_IDLE);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_DEEP);
+    nk_idle_hold(HAL_SLEEP_IDLE);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_IDLE);
+    nk_idle_release(HAL_SLEEP_IDLE);
+
+    /* Unimplemented levels are skipped */
+    hal_sleep_info_t none[HAL_SLEEP_LEVELS] = { tab[0], tab[1], tab[2] };
+    none[HAL_SLEEP_DEEP].flags = HAL_SLEEP_F_NONE;
+    assert(nk_idle_select(none, NK_IDLE_FOREVER) == HAL_SLEEP_SAVE);
+    none[HAL_SLEEP_SAVE].flags = HAL_SLEEP_F_NONE;
+    assert(nk_idle_select(none, NK_IDLE_FOREVER) == HAL_SLEEP_IDLE);
+
+    /* The host only idles, and the period is counted */
+    assert(nk_idle_select(hal_sleep_info(), NK_IDLE_FOREVER) == HAL_SLEEP_IDLE);
+    uint32_t n = nk_idle_count(HAL_SLEEP_IDLE);
+    nk_idle_enter(NK_IDLE_FOREVER);
+    assert(nk_idle_count(HAL_SLEEP_IDLE) == n + 1);
+    assert(nk_idle_count(HAL_SLEEP_DEEP) == 0);
+
+    /* Interrupt-driven TX holds IDLE from the kick until the ring drains */
+    static uint8_t rx[16], tx[16];
+    tty_t t;
+    tty_init_irq(&t, rx, tx, sizeof(rx), kick);
+    assert(tty_write(&t, (const uint8_t *)"abc", 3) == 3);
+    assert(tty_write(&t, (const uint8_t *)"de", 2) == 2);
+    assert(kicks == 2);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_IDLE);
+    int sent = 0;
+    while (tty_tx_isr(&t) >= 0) {
+        sent++;
+        assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_IDLE);
+    }
+    assert(sent == 5);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_DEEP);
+
+    /* Nothing queued: no hold */
+    assert(tty_write(&t, (const uint8_t *)"", 0) == 0);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_DEEP);
+    assert(tty_tx_isr(&t) < 0);
+    assert(nk_idle_select(tab, NK_IDLE_FOREVER) == HAL_SLEEP_DEEP);
+
+    printf("idle_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,161 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* IPv4 fragmentation on send, bounded reassembly on receive */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "drivers/net/udp.h"
+#include "drivers/net/slip.h"
+#include "drivers/tty/tty.h"
+
+/*─── Two one-way lines: ours → out[], in[] → ours ────────────────────*/
+static uint8_t out[4096], in[16384];
+static size_t  out_len, out_pos, in_len, in_pos, in_budget;
+
+static void out_putc(uint8_t c) { assert(out_len < sizeof(out)); out[out_len++] = c; }
+static void in_putc(uint8_t c)  { assert(in_len < sizeof(in)); in[in_len++] = c; }
+
+static int in_getc(void)
+{
+    if (in_pos == in_len || in_budget == 0) return -1;
+    in_budget--;
+    return in[in_pos++];
+}
+
+static tty_t   serial, wire;
+static uint8_t tty_rx[64], tty_tx[64], wire_rx[64], wire_tx[64];
+
+#define ME   0x0A000001u
+#define PEER 0x0A000002u
+
+static int pump(void)
+{
+    int n = 0;
+    for (;;) {
+        size_t before = in_pos;
+        in_budget = sizeof(tty_rx) - 1 - tty_rx_available(&serial);
+        tty_poll(&serial);
+        n += ipv4_poll(&serial);
+        if (in_pos == before) return n;
+    }
+}
+
+/* Next frame we sent, decoded; 0 if none */
+static size_t next_frame(uint8_t *f)
+{
+    size_t n = 0;
+    while (out_pos < out_len && out[out_pos] == SLIP_END) out_pos++;
+    while (out_pos < out_len && out[out_pos] != SLIP_END) {
+        uint8_t b = out[out_pos++];
+        if (b == SLIP_ESC) b = out[out_pos++] == SLIP_ESC_END ? SLIP_END : SLIP_ESC;
+        f[n++] = b;
+    }
+    return n;
+}
+
+static uint16_t frag_of(const uint8_t *f)
+{
+    return ipv4_ntohs(((const ipv4_hdr_t *)f)->frag);
+}
+
+int main(void)
+{
+#if CONFIG_NET_IPV4_FRAG_ENABLED && CONFIG_NET_UDP_ENABLED
+    static uint8_t frag[3][IPV4_MTU + 8], buf[2048], msg[1500];
+    size_t flen[3];
+    tty_init(&serial, tty_rx, tty_tx, sizeof(tty_rx), out_putc, in_getc);
+    tty_init(&wire, wire_rx, wire_tx, sizeof(wire_rx), in_putc, NULL);
+    udp_init(ME);
+    ipv4_timer(0);
+    int s = udp_bind(7000);
+    for (size_t i = 0; i < sizeof(msg); i++) msg[i] = (uint8_t)(i * 7 + (i >> 8));
+
+    /* 1508 UDP bytes: two full IPV4_FRAG_DATA fragments and the rest */
+    assert(udp_sendto(&serial, s, ME, 7000, msg, sizeof(msg)) == (int)sizeof(msg));
+    uint16_t id = 0;
+    for (unsigned i = 0; i < 3; i++) {
+        flen[i] = next_frame(frag[i]);
+        const ipv4_hdr_t *ip = (const ipv4_hdr_t *)frag[i];
+        assert(ipv4_checksum(ip, 20) == 0 && ip->proto == IPV4_PROTO_UDP);
+        assert(ipv4_ntohs(ip->len) == flen[i]);
+        assert((frag_of(frag[i]) & IPV4_OFFSET_MASK) * 8u == i * IPV4_FRAG_DATA);
+        assert(!(frag_of(frag[i]) & IPV4_DF));
+        assert(!!(frag_of(frag[i]) & IPV4_MF) == (i < 2));
+        if (i == 0) id = ip->id;
+        assert(ip->id == id);
+    }
+    assert(flen[0] == 20u + IPV4_FRAG_DATA && flen[1] == flen[0]);
+    assert(flen[2] == 20u + 8u + sizeof(msg) - 2u * IPV4_FRAG_DATA);
+    assert(next_frame(buf) == 0);
+
+    /* Back in, out of order: one datagram, copied out of the chain */
+    slip_send_packet(&wire, frag[2], flen[2]);
+    slip_send_packet(&wire, frag[0], flen[0]);
+    assert(pump() == 0 && pbuf_used() == 3);    /* two held, one spare */
+    slip_send_packet(&wire, frag[1], flen[1]);
+    assert(pump() == 1);
+    uint32_t from;
+    pbuf_t *p = udp_recv_pbuf(s, &from, NULL);
+    assert(p && p->next && from == ME && pbuf_chain_len(p) == sizeof(msg));
+    pbuf_free(p);
+    assert(pbuf_used() == 1);
+
+    slip_send_packet(&wire, frag[0], flen[0]);
+    slip_send_packet(&wire, frag[0], flen[0]);  /* duplicates are ignored */
+    slip_send_packet(&wire, frag[1], flen[1]);
+    slip_send_packet(&wire, frag[2], flen[2]);
+    assert(pump() == 1);
+    memset(buf, 0, sizeof(buf));
+    assert(udp_recvfrom(s, buf, sizeof(buf), NULL, NULL) == (int)sizeof(msg));
+    assert(memcmp(buf, msg, sizeof(msg)) == 0);
+    assert(pbuf_used() == 1 && ipv4_reasm_dropped() == 0);
+
+    /* A missing fragment: the others are freed when the timer expires */
+    slip_send_packet(&wire, frag[0], flen[0]);
+    slip_send_packet(&wire, frag[2], flen[2]);
+    assert(pump() == 0 && pbuf_used() == 3);
+    ipv4_timer(IPV4_REASM_TIMEOUT_MS - 1);
+    assert(pbuf_used() == 3);
+    ipv4_timer(IPV4_REASM_TIMEOUT_MS);
+    assert(pbuf_used() == 1 && ipv4_reasm_dropped() == 1);
+
+    /* Overlapping fragments drop the whole datagram */
+    ipv4_hdr_t *ip = (ipv4_hdr_t *)frag[1];
+    ip->frag = ipv4_htons(IPV4_MF | (IPV4_FRAG_DATA / 8u - 1u));
+    ip->checksum = 0;
+    ip->checksum = ipv4_htons(ipv4_checksum(ip, 20));
+    slip_send_packet(&wire, frag[0], flen[0]);
+    slip_send_packet(&wire, frag[1], flen[1]);
+    assert(pump() == 0 && pbuf_used() == 1 && ipv4_reasm_dropped() == 2);
+
+    /* A middle fragment of odd size cannot be placed */
+    ip->frag = ipv4_htons(IPV4_MF | (IPV4_FRAG_DATA / 8u));
+    ip->len = ipv4_htons((uint16_t)(flen[1] - 1));
+    ip->checksum = 0;
+    ip->checksum = ipv4_htons(ipv4_checksum(ip, 20));
+    slip_send_packet(&wire, frag[1], flen[1] - 1);
+    assert(pump() == 0 && pbuf_used() == 1 && ipv4_reasm_dropped() == 3);
+
+    /* Oversized datagrams with DF set are not sent at all */
+    static uint8_t dgram[IPV4_MTU * 2];
+    ipv4_init_header((ipv4_hdr_t *)dgram, ME, PEER, IPV4_PROTO_UDP, sizeof(dgram) - 20);
+    ((ipv4_hdr_t *)dgram)->frag = ipv4_htons(IPV4_DF);
+    ipv4_output(&serial, dgram, sizeof(dgram), NULL, 0);
+    assert(next_frame(buf) == 0);
+
+    /* Small ones still go whole with DF */
+    assert(udp_sendto(&serial, s, PEER, 7000, "x", 1) == 1);
+    assert(next_frame(buf) == 29 && frag_of(buf) == IPV4_DF);
+
+    udp_close(s);
+    assert(pbuf_used() == 1);
+    printf("ipv4_frag: ok\n");
+#else
+    printf("ipv4_frag: skipped (needs net_ipv4_frag_enabled and net_udp_enabled)\n");
+#endif
+    return 0;
+}
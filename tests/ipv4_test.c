@@ -12,6 +12,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <stdlib.h>
+#include <time.h>
 
 static int tests_passed = 0;
 static int tests_failed = 0;
@@ -59,7 +61,7 @@ static void test_ipv4_checksum(void) {
         0xac, 0x10, 0x0a, 0x0c   /* dst */
     };
     uint16_t sum4 = ipv4_checksum(header, 20);
-    TEST_ASSERT(sum4 != 0, "IPv4 header checksum computed");
+    TEST_ASSERT(sum4 == 0xB1E6, "IPv4 header checksum matches reference");
 
     printf("  → Checksum: 0x%04X\n", sum4);
 }
@@ -211,6 +213,111 @@ static void test_ipv4_transmission(void) {
     printf("  → Bytes transmitted: %u (includes SLIP framing)\n", tx_count);
 }
 
+/* The original byte-pair loop, as a reference for the fast paths */
+static uint16_t ref_checksum(const uint8_t *p, size_t len) {
+    uint32_t sum = 0;
+    for (; len > 1; p += 2, len -= 2) sum += (uint16_t)((p[0] << 8) | p[1]);
+    if (len) sum += (uint16_t)(p[0] << 8);
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+/**
+ * Test 7: Word-at-a-time checksum against the reference
+ */
+static void test_ipv4_checksum_fast(void) {
+    printf("\nTest 7: Optimised Checksum\n");
+    printf("--------------------------\n");
+
+    static uint8_t buf[IPV4_MTU + 8];
+    srand(1071);
+    for (size_t i = 0; i < sizeof(buf); i++) buf[i] = (uint8_t)rand();
+
+    int bad = 0;
+    for (size_t off = 0; off < 4; off++) {
+        for (size_t len = 0; len <= IPV4_MTU; len++) {
+            bad += ipv4_checksum(buf + off, len) != ref_checksum(buf + off, len);
+        }
+    }
+    TEST_ASSERT(bad == 0, "Matches reference for every length and alignment");
+
+    memset(buf, 0xFF, sizeof(buf));
+    TEST_ASSERT(ipv4_checksum(buf, IPV4_MTU) == ref_checksum(buf, IPV4_MTU),
+                "Matches reference with maximal carries");
+
+    /* Chained partial sums: even pieces, odd tail */
+    for (size_t i = 0; i < sizeof(buf); i++) buf[i] = (uint8_t)(i * 37u);
+    uint16_t sum = ipv4_checksum_partial(buf, 12, 0);
+    sum = ipv4_checksum_partial(buf + 12, 100, sum);
+    sum = ipv4_checksum_partial(buf + 112, 33, sum);
+    uint16_t folded = (uint16_t)~sum;
+    TEST_ASSERT(folded == ref_checksum(buf, 145), "Partial sums chain");
+}
+
+/**
+ * Test 8: Incremental update (RFC 1624)
+ */
+static void test_ipv4_checksum_adjust(void) {
+    printf("\nTest 8: Incremental Checksum Update\n");
+    printf("-----------------------------------\n");
+
+    ipv4_hdr_t hdr, full;
+    ipv4_init_header(&hdr, 0xC0A80001, 0x08080808, IPV4_PROTO_UDP, 32);
+
+    /* TTL decrements down to 1 stay valid */
+    int bad = 0;
+    while (hdr.ttl > 1) {
+        uint8_t ttl = hdr.ttl;
+        bad += !ipv4_dec_ttl(&hdr) || hdr.ttl != ttl - 1 || !ipv4_validate_header(&hdr);
+    }
+    TEST_ASSERT(bad == 0, "Decremented TTL keeps the header valid");
+    TEST_ASSERT(!ipv4_dec_ttl(&hdr) && hdr.ttl == 1, "TTL 1 is not forwarded");
+
+    /* NAT-style source rewrite equals a full recompute */
+    ipv4_init_header(&hdr, 0xC0A80001, 0x08080808, IPV4_PROTO_UDP, 32);
+    uint32_t old_src = hdr.saddr, new_src = ipv4_htonl(0x55AA1234);
+    hdr.saddr = new_src;
+    hdr.checksum = ipv4_htons(ipv4_checksum_adjust32(ipv4_ntohs(hdr.checksum),
+                                                     ipv4_ntohl(old_src),
+                                                     ipv4_ntohl(new_src)));
+    ipv4_init_header(&full, 0x55AA1234, 0x08080808, IPV4_PROTO_UDP, 32);
+    full.id = hdr.id;               /* each header gets its own id */
+    full.checksum = 0;
+    full.checksum = ipv4_htons(ipv4_checksum(&full, sizeof(full)));
+    TEST_ASSERT(hdr.checksum == full.checksum, "Address rewrite matches recompute");
+
+    /* Byte order does not matter if it is consistent */
+    uint16_t c = ipv4_checksum_adjust(0x1234, 0xAB00, 0x00CD);
+    uint16_t c_swapped = ipv4_checksum_adjust(0x3412, 0x00AB, 0xCD00);
+    TEST_ASSERT(c == (uint16_t)((c_swapped >> 8) | (c_swapped << 8)),
+                "Adjust is byte-order independent");
+}
+
+/**
+ * Test 9: Checksum throughput (informational)
+ */
+static void test_ipv4_checksum_bench(void) {
+    printf("\nTest 9: Checksum Benchmark\n");
+    printf("--------------------------\n");
+
+    static uint8_t buf[IPV4_MTU];
+    for (size_t i = 0; i < sizeof(buf); i++) buf[i] = (uint8_t)(i ^ 0x5A);
+
+    enum { ROUNDS = 20000 };
+    volatile uint16_t sink = 0;
+    clock_t t0 = clock();
+    for (int i = 0; i < ROUNDS; i++) sink ^= ref_checksum(buf, sizeof(buf));
+    clock_t t1 = clock();
+    for (int i = 0; i < ROUNDS; i++) sink ^= ipv4_checksum(buf, sizeof(buf));
+    clock_t t2 = clock();
+    (void)sink;
+
+    double ref_ns = (double)(t1 - t0) * 1e9 / CLOCKS_PER_SEC / ROUNDS / sizeof(buf);
+    double opt_ns = (double)(t2 - t1) * 1e9 / CLOCKS_PER_SEC / ROUNDS / sizeof(buf);
+    printf("  → reference: %.3f ns/byte, ipv4_checksum: %.3f ns/byte\n", ref_ns, opt_ns);
+    TEST_ASSERT(t2 >= t1, "Benchmark ran");
+}
+
 #endif /* CONFIG_NET_IPV4_ENABLED */
 
 /**
@@ -228,6 +335,9 @@ int main(void) {
     test_ipv4_endianness();
     test_ipv4_protocols();
     test_ipv4_transmission();
+    test_ipv4_checksum_fast();
+    test_ipv4_checksum_adjust();
+    test_ipv4_checksum_bench();
 #else
     printf("Skipping tests: IPv4 disabled in config\n");
 #endif
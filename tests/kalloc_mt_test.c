@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Magazine front end of the kernel allocator (kernel/mm/kalloc_mt.c) */
+
+#define NK_KALLOC_THREAD_SAFE 2
+#define NK_KALLOC_SLAB        0
+#define NK_KALLOC_TLSF        0
+#define NK_KALLOC_STATS       1
+#define NK_KALLOC_TASKS       8     /* tids 1 and 2 get their own magazines */
+#define NK_HEAP_SIZE          1024u
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../kernel/mm/kalloc.c"
+#include "../kernel/mm/kalloc_mt.c"
+
+static uint8_t cur_tid = 0;
+uint8_t nk_current_tid(void) { return cur_tid; }
+
+static uint8_t central_allocs(void)
+{
+    kalloc_stats_t st;
+    kalloc_get_stats(&st);
+    return st.alloc_count;
+}
+
+int main(void)
+{
+    kalloc_init();
+
+    /* A freed small block is recycled by the same task without the heap. */
+    cur_tid = 1;
+    void *a = kalloc(12);
+    assert(a && kalloc_usable(a) >= 16);
+    kfree(a);
+    uint8_t n = central_allocs();
+    assert(kalloc(9) == a);
+    assert(central_allocs() == n);
+
+    /* Another task has its own magazine. */
+    kfree(a);
+    cur_tid = 2;
+    void *b = kalloc(12);
+    assert(b && b != a);
+    assert(central_allocs() == n + 1);
+
+    /* Each class holds at most NK_KALLOC_MAG_DEPTH blocks. */
+    void *blk[NK_KALLOC_MAG_DEPTH + 2];
+    for (int i = 0; i < NK_KALLOC_MAG_DEPTH + 2; ++i)
+        assert((blk[i] = kalloc(30)) != NULL);
+    for (int i = 0; i < NK_KALLOC_MAG_DEPTH + 2; ++i)
+        kfree(blk[i]);
+    assert(mags[2][2].count == NK_KALLOC_MAG_DEPTH);
+
+    /* Large blocks and boot-context frees bypass the magazines. */
+    void *big = kalloc(200);
+    kfree(big);
+    cur_tid = 0xFF;
+    void *c = kalloc(12);
+    kfree(c);
+    assert(mags[2][3].count == 0);
+
+    /* Draining hands cached blocks back to the heap. */
+    kalloc_drain(1);
+    kalloc_drain(2);
+    kfree(b);           /* boot context: straight to the heap */
+    kalloc_stats_t st;
+    kalloc_get_stats(&st);
+    assert(st.used_bytes == 0);
+
+    printf("kalloc magazines ok\n");
+    return 0;
+}
@@ -0,0 +1,96 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Fast and bulk heap regions of the free-list allocator (kernel/mm/kalloc.c) */
+
+#define NK_KALLOC_SLAB        0
+#define NK_KALLOC_TLSF        0
+#define NK_KALLOC_THREAD_SAFE 0
+#define NK_KALLOC_STATS       1
+#define NK_KALLOC_REGIONS     3
+#define NK_HEAP_SIZE          256u
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../kernel/mm/kalloc.c"
+
+/* Stand-ins for external SRAM */
+static uint8_t xmem[2048] __attribute__((aligned(8)));
+static uint8_t spare[64];
+
+static bool in(const void *p, const void *base, size_t len)
+{
+    return (const uint8_t *)p >= (const uint8_t *)base &&
+           (const uint8_t *)p < (const uint8_t *)base + len;
+}
+
+int main(void)
+{
+    kalloc_init();
+
+    /* Without a bulk region every hint lands in heap[] */
+    void *a = kalloc_hint(16, KALLOC_BULK);
+    assert(a && in(a, heap, sizeof heap) && kalloc_kind(a) == KALLOC_FAST);
+    assert(kalloc_hint(16, KALLOC_BULK | KALLOC_ONLY) == NULL);
+    kfree(a);
+
+    /* Regions: misaligned base is rounded, overlaps and junk refused */
+    assert(kalloc_add_region(xmem + 1, sizeof xmem - 1, KALLOC_BULK) == 1);
+    assert(kalloc_add_region(xmem + 100, 64, KALLOC_BULK) == -1);
+    assert(kalloc_add_region(heap, sizeof heap, KALLOC_BULK) == -1);
+    assert(kalloc_add_region(spare, 2, KALLOC_FAST) == -1);
+    assert(kalloc_add_region(spare, sizeof spare, 7) == -1);
+    assert(kalloc_add_region(NULL, 64, KALLOC_FAST) == -1);
+    assert(kalloc_kind(spare) == -1);
+
+    /* Hints pick the region; kfree() finds it again */
+    uint8_t *bulk = kalloc_hint(200, KALLOC_BULK);
+    uint8_t *fast = kalloc(200);
+    assert(bulk && in(bulk, xmem, sizeof xmem) && kalloc_kind(bulk) == KALLOC_BULK);
+    assert(fast && in(fast, heap, sizeof heap) && kalloc_kind(fast) == KALLOC_FAST);
+    kfree(bulk);
+    assert(kalloc_hint(200, KALLOC_BULK) == bulk);  /* off its own free list */
+
+    /* A full fast heap spills into bulk unless KALLOC_ONLY */
+    assert(kalloc_hint(100, KALLOC_FAST | KALLOC_ONLY) == NULL);
+    uint8_t *spill = kalloc(100);
+    assert(spill && kalloc_kind(spill) == KALLOC_BULK);
+    kfree(fast);
+    assert(kalloc_hint(100, KALLOC_FAST | KALLOC_ONLY) == fast);
+
+    /* Per-region and summed statistics */
+    kalloc_stats_t r0, r1, sum;
+    assert(kalloc_get_region_stats(0, &r0) == KALLOC_FAST);
+    assert(kalloc_get_region_stats(1, &r1) == KALLOC_BULK);
+    assert(kalloc_get_region_stats(2, &r1) == -1);
+    assert(kalloc_get_region_stats(1, &r1) == KALLOC_BULK);
+    kalloc_get_stats(&sum);
+    assert(r0.total_size == NK_HEAP_SIZE && r1.total_size == sizeof xmem - 8);
+    assert(sum.total_size == r0.total_size + r1.total_size);
+    assert(sum.used_bytes == r0.used_bytes + r1.used_bytes);
+    assert(sum.used_bytes + sum.free_bytes == sum.total_size);
+    assert(r1.used_bytes >= 200 + 100 && sum.largest_free == r1.largest_free);
+
+    /* A second, fast region is tried before falling back to bulk */
+    static uint8_t fast2[256] __attribute__((aligned(8)));
+    assert(kalloc_add_region(fast2, sizeof fast2, KALLOC_FAST) == 2);
+    assert(kalloc_add_region(spare, sizeof spare, KALLOC_FAST) == -1);  /* all taken */
+    uint8_t *f2 = kalloc(100);
+    assert(f2 && in(f2, fast2, sizeof fast2));
+
+    kfree(f2);
+    kfree(fast);
+    kfree(spill);
+    kfree(bulk);
+
+    /* kalloc_init() forgets the added regions */
+    kalloc_init();
+    assert(kalloc_get_region_stats(1, &r1) == -1);
+    assert(kalloc_hint(16, KALLOC_BULK | KALLOC_ONLY) == NULL);
+
+    printf("kalloc regions ok (bulk largest free %zu)\n", sum.largest_free);
+    return 0;
+}
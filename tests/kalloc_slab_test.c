@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Size-class mode of the portable kernel allocator (kernel/mm/kalloc.c) */
+
+#define NK_KALLOC_SLAB 1
+#define NK_KALLOC_TLSF 0
+#define NK_KALLOC_THREAD_SAFE 0
+#define NK_HEAP_SIZE   1024u
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../kernel/mm/kalloc.c"
+
+int main(void)
+{
+    kalloc_init();
+
+    /* Same class: freed block comes straight back (LIFO per class). */
+    void *a = kalloc(10);
+    void *b = kalloc(12);
+    assert(a && b && a != b);
+    kfree(a);
+    assert(kalloc(16) == a);
+
+    /* A large free block is never handed to a small request. */
+    void *big = kalloc(200);
+    assert(big);
+    kfree(big);
+    void *small = kalloc(8);
+    assert(small && small != big);
+    assert(kalloc(129) == big);
+
+    /* Maximum request fits the top class. */
+    void *max = kalloc(255);
+    assert(max);
+    kfree(max);
+
+    /* Exhaust the heap with one class, then every block is reusable. */
+    void *blocks[128];
+    size_t count = 0;
+    for (; count < 128; ++count) {
+        blocks[count] = kalloc(32);
+        if (!blocks[count])
+            break;
+    }
+    assert(count > 0 && count < 128);
+    assert(kalloc(32) == NULL);
+
+    for (size_t i = 0; i < count; ++i)
+        kfree(blocks[i]);
+    for (size_t i = 0; i < count; ++i)
+        assert(kalloc(32) != NULL);
+    assert(kalloc(32) == NULL);
+
+    /* Zero-byte requests still fail. */
+    assert(kalloc(0) == NULL);
+
+    printf("kalloc slab blocks:%zu\n", count);
+    return 0;
+}
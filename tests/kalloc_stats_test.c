@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* kalloc statistics: accounting, histogram, per-task attribution */
+
+#define NK_KALLOC_SLAB        0
+#define NK_KALLOC_TLSF        0
+#define NK_KALLOC_THREAD_SAFE 0
+#define NK_KALLOC_STATS       1
+#define NK_KALLOC_TASK_STATS  1
+#define NK_KALLOC_REGIONS     1
+#define NK_KALLOC_TASKS       8     /* tids 1, 2 and 7 get their own counters */
+#define NK_HEAP_SIZE          512u
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "../kernel/mm/kalloc.c"
+
+static uint8_t cur_tid = 0xFF;
+uint8_t nk_current_tid(void) { return cur_tid; }
+
+static kalloc_stats_t get(void)
+{
+    kalloc_stats_t st;
+    kalloc_get_stats(&st);
+    assert(st.used_bytes + st.free_bytes == st.total_size);
+    return st;
+}
+
+int main(void)
+{
+    kalloc_init();
+    kalloc_stats_t st = get();
+    assert(st.used_bytes == 0 && st.free_blocks == 0);
+    assert(st.free_hist[5] == 1);                           /* 256..511 */
+    assert(st.largest_free == NK_HEAP_SIZE - sizeof(block_t));
+
+    /* Frees give bytes back, so usage returns to zero. */
+    cur_tid = 1;
+    void *a = kalloc(40);
+    cur_tid = 2;
+    void *b = kalloc(100);
+    void *c = kalloc(10);
+    st = get();
+    size_t peak = st.used_bytes;
+    assert(peak >= 150 && st.peak_used == peak);
+    assert(kalloc_task_used(1) >= 40 && kalloc_task_used(2) >= 110);
+    assert(kalloc_task_used(1) + kalloc_task_used(2) == st.used_bytes);
+
+    kfree(b);
+    st = get();
+    assert(st.used_bytes == peak - (sizeof(block_t) + align_size(100)));
+    assert(st.free_blocks == 1 && st.free_hist[3] == 1);  /* 64..127 */
+
+    /* Reuse by another owner moves the attribution. */
+    cur_tid = 0xFF;
+    void *d = kalloc(90);
+    assert(d == b);
+    assert(kalloc_task_used(7) == 0);
+    assert(kalloc_task_used(0xFF) == sizeof(block_t) + align_size(100));
+
+    kfree(a);
+    kfree(c);
+    kfree(d);
+    st = get();
+    assert(st.used_bytes == 0 && st.peak_used == peak);
+    assert(kalloc_task_used(1) == 0 && kalloc_task_used(2) == 0);
+    assert(st.free_blocks == 3);
+
+    kalloc_reset_peak();
+    assert(get().peak_used == 0);
+
+    printf("kalloc stats peak:%u largest:%u\n",
+           (unsigned)peak, (unsigned)st.largest_free);
+    return 0;
+}
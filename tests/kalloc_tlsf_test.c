@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* TLSF backend of the portable kernel allocator (kernel/mm/kalloc_tlsf.c) */
+
+#define NK_KALLOC_TLSF  1
+#define NK_KALLOC_SLAB  0
+#define NK_KALLOC_THREAD_SAFE 0
+#define NK_KALLOC_STATS 1
+#define NK_HEAP_SIZE    2048u
+#define NK_KALLOC_SIZE_BITS 16
+#define NK_KALLOC_REGIONS   2
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "../kernel/mm/kalloc_tlsf.c"
+
+static unsigned free_blocks(void)
+{
+    kalloc_stats_t st;
+    kalloc_get_stats(&st);
+    return st.free_blocks;
+}
+
+int main(void)
+{
+    kalloc_init();
+    assert(free_blocks() == 1);
+
+    /* Neighbours coalesce in either order. */
+    uint8_t *a = kalloc(40);
+    uint8_t *b = kalloc(40);
+    uint8_t *c = kalloc(40);
+    assert(a && b && c && a < b && b < c);
+    kfree(a);
+    kfree(c);               /* merges with the tail */
+    assert(free_blocks() == 2);
+    kfree(b);               /* bridges a and the tail */
+    assert(free_blocks() == 1);
+
+    /* Split remainder is reused rather than carving new space. */
+    uint8_t *d = kalloc(200);
+    kfree(d);
+    uint8_t *e = kalloc(8);
+    assert(e == d);
+    kfree(e);
+
+    /* Random churn must always return to one free block. */
+    void *live[32] = {0};
+    srand(1);
+    for (int i = 0; i < 5000; ++i) {
+        int k = rand() % 32;
+        if (live[k]) {
+            kfree(live[k]);
+            live[k] = NULL;
+        } else {
+            live[k] = kalloc((uint8_t)(1 + rand() % 255));
+            if (live[k])
+                ((uint8_t *)live[k])[0] = (uint8_t)k;
+        }
+    }
+    for (int k = 0; k < 32; ++k) {
+        if (live[k]) {
+            assert(((uint8_t *)live[k])[0] == (uint8_t)k);
+            kfree(live[k]);
+        }
+    }
+    assert(free_blocks() == 1);
+
+    kalloc_stats_t st;
+    kalloc_get_stats(&st);
+    assert(st.used_bytes == 0);
+
+    /* Exhaustion fails cleanly and the heap recovers. */
+    size_t count = 0;
+    void *blocks[64];
+    while (count < 64 && (blocks[count] = kalloc(255)) != NULL)
+        ++count;
+    assert(count > 0 && count < 64);
+    for (size_t i = 0; i < count; ++i)
+        kfree(blocks[i]);
+    assert(free_blocks() == 1);
+
+    /* 16-bit sizes: a request larger than 255 bytes is honoured. */
+    uint8_t *wide = kalloc(1500);
+    assert(wide && kalloc(1500) == NULL);
+    wide[1499] = 0xA5;
+    kfree(wide);
+    assert(free_blocks() == 1);
+    assert(kalloc(KALLOC_SIZE_MAX) == NULL);
+
+    /* A bulk region has its own bins: blocks merge within it only. */
+    static uint8_t xmem[4096 + 2];
+    assert(kalloc_add_region(xmem + 2, 4096, KALLOC_BULK) == 1);
+    assert(free_blocks() == 2);
+    uint8_t *x1 = kalloc_hint(3000, KALLOC_BULK);
+    uint8_t *x2 = kalloc_hint(500, KALLOC_BULK);
+    assert(x1 && x2 && kalloc_kind(x1) == KALLOC_BULK && kalloc_kind(x2) == KALLOC_BULK);
+    assert(((uintptr_t)x1 & 3u) == 0);
+    uint8_t *f = kalloc(1500);                  /* fast first */
+    assert(f && kalloc_kind(f) == KALLOC_FAST);
+    assert(kalloc_hint(1500, KALLOC_FAST | KALLOC_ONLY) == NULL);
+    kfree(x1);
+    kfree(f);
+    kfree(x2);
+    assert(free_blocks() == 2);
+    kalloc_stats_t xs;
+    assert(kalloc_get_region_stats(1, &xs) == KALLOC_BULK && xs.used_bytes == 0);
+
+    printf("kalloc tlsf blocks:%zu peak:%u\n", count, (unsigned)st.peak_used);
+    return 0;
+}
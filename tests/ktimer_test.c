@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: MIT */
+
+/**
+ * @file ktimer_test.c
+ * @brief Unit tests for kernel software timers
+ */
+
+#include "kernel/sched/ktimer.h"
+#include <stdio.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  ✓ %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  ✗ %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+static int fired[4];
+
+static void on_fire(void *arg) {
+    fired[(int)(long)arg]++;
+}
+
+/* Advance one tick at a time and run deferred callbacks */
+static void run_ticks(int n) {
+    while (n--) {
+        nk_timer_advance(1);
+        nk_work_run();
+    }
+}
+
+static void test_oneshot(void) {
+    printf("\nTest: One-shot timer\n");
+
+    nk_timer_t t;
+    nk_timer_init(&t, on_fire, (void *)0L);
+    TEST_ASSERT(!nk_timer_start(&t, 0, 0), "Zero delay rejected");
+    TEST_ASSERT(nk_timer_start(&t, 5, 0), "Armed for 5 ticks");
+    TEST_ASSERT(nk_timer_next() == 5, "Next expiry is 5 ticks away");
+
+    run_ticks(4);
+    TEST_ASSERT(fired[0] == 0, "Not fired after 4 ticks");
+    run_ticks(1);
+    TEST_ASSERT(fired[0] == 1, "Fired on tick 5");
+    run_ticks(10);
+    TEST_ASSERT(fired[0] == 1, "One-shot does not re-fire");
+    TEST_ASSERT(nk_timer_next() == UINT16_MAX, "No timers armed");
+}
+
+static void test_periodic_and_order(void) {
+    printf("\nTest: Periodic timers share the list\n");
+
+    nk_timer_t a, b;
+    nk_timer_init(&a, on_fire, (void *)1L);
+    nk_timer_init(&b, on_fire, (void *)2L);
+    nk_timer_start(&a, 3, 3);
+    nk_timer_start(&b, 10, 0);
+
+    run_ticks(9);
+    TEST_ASSERT(fired[1] == 3, "Periodic fired 3 times in 9 ticks");
+    TEST_ASSERT(fired[2] == 0, "Later one-shot still pending");
+    run_ticks(1);
+    TEST_ASSERT(fired[2] == 1, "One-shot fired at tick 10");
+
+    TEST_ASSERT(nk_timer_stop(&a), "Stop periodic timer");
+    run_ticks(10);
+    TEST_ASSERT(fired[1] == 3, "Stopped timer no longer fires");
+    TEST_ASSERT(!nk_timer_stop(&a), "Second stop reports not armed");
+}
+
+static void test_bulk_advance(void) {
+    printf("\nTest: Multi-tick advance (tickless catch-up)\n");
+
+    nk_timer_t t;
+    nk_timer_init(&t, on_fire, (void *)3L);
+    nk_timer_start(&t, 4, 4);
+    nk_timer_advance(9);
+    nk_work_run();
+    TEST_ASSERT(fired[3] == 2, "Two periods elapsed in one advance");
+    TEST_ASSERT(nk_timer_next() == 3, "Remaining delta carried over");
+    nk_timer_stop(&t);
+}
+
+int main(void) {
+    printf("═══════════════════════════════════════\n");
+    printf("  Software Timer Tests\n");
+    printf("═══════════════════════════════════════\n");
+
+    test_oneshot();
+    test_periodic_and_order();
+    test_bulk_advance();
+
+    printf("\n═══════════════════════════════════════\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("═══════════════════════════════════════\n");
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,294 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Lock throughput, wait latency and fairness under host threads
+ * (kernel/sync/spinlock.h, host HAL atomics)
+ *
+ *   lock_bench [-t 1,2,4,8] [-c 0,100,1000] [-w 100] [-d ms] [-l names] [-C]
+ *
+ * For every lock, thread count (-t) and critical-section length (-c, in
+ * units of one shared volatile increment), N threads loop lock / work /
+ * unlock / -w units of private work for -d ms.  Reported: acquisitions
+ * per second, percentiles of the time spent getting the lock (sampled,
+ * hal_cycles() ns), and Jain's index over per-thread acquisition counts
+ * (1.0 = every thread got the same share, 1/N = one thread got all).
+ * -C prints CSV instead of a table.  The critical section also checks
+ * mutual exclusion; any violation fails the run.
+ *
+ * nk_slock_t and nk_spinlock_t are built once per configuration, so the
+ * build has one binary each for the TAS base, NK_ENABLE_LATTICE and the
+ * MCS base; flock and the ticket qlock are in all of them.  With more
+ * threads than CPUs waiters sched_yield() (NK_SPIN_RELAX) so a preempted
+ * holder can finish.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static volatile int bench_yield;
+#define NK_SPIN_RELAX() (bench_yield ? (void)sched_yield() : hal_memory_barrier())
+#define NK_ENABLE_QLOCK 1
+#define NK_LOCK_STATS   0
+#define NK_TRACE        0
+#include "../kernel/sync/spinlock.c"
+
+#if NK_ENABLE_LATTICE
+#  define SLOCK_NAME "slock/lattice"
+#elif NK_SPINLOCK_IMPL == NK_SPINLOCK_MCS
+#  define SLOCK_NAME "slock/mcs"
+#elif NK_SPINLOCK_IMPL == NK_SPINLOCK_TICKET
+#  define SLOCK_NAME "slock/ticket"
+#else
+#  define SLOCK_NAME "slock/tas"
+#endif
+
+#define MAX_THREADS 64
+#define LAT_SAMPLES 4096u               /* per thread, ring of the latest */
+
+/*─── Locks under test ────────────────────────────────────────────────*/
+static nk_flock_t    fl;
+static nk_qlock_t    ql;
+static nk_slock_t    sl;
+static nk_spinlock_t sp;
+
+static void fl_init(void)   { nk_flock_init(&fl); }
+static void fl_lock(void)   { nk_flock_lock(&fl); }
+static void fl_unlock(void) { nk_flock_unlock(&fl); }
+static void ql_init(void)   { nk_qlock_init(&ql); }
+static void ql_lock(void)   { nk_qlock_lock(&ql); }
+static void ql_unlock(void) { nk_qlock_unlock(&ql); }
+static void sl_init(void)   { nk_slock_init(&sl); }
+static void sl_lock(void)   { nk_slock_lock(&sl); }
+static void sl_unlock(void) { nk_slock_unlock(&sl); }
+static void sp_init(void)   { nk_spinlock_global_init(); nk_spinlock_init(&sp); }
+static void sp_lock(void)   { nk_spinlock_lock(&sp, 0); }
+static void sp_unlock(void) { nk_spinlock_unlock(&sp); }
+static void rt_lock(void)   { nk_spinlock_lock_rt(&sp, 0); }
+static void rt_unlock(void) { nk_spinlock_unlock_rt(&sp); }
+
+typedef struct {
+    const char *name;
+    void (*init)(void);
+    void (*lock)(void);
+    void (*unlock)(void);
+} lock_ops_t;
+
+static const lock_ops_t locks[] = {
+    { "flock",       fl_init, fl_lock, fl_unlock },
+    { "qlock",       ql_init, ql_lock, ql_unlock },
+    { SLOCK_NAME,    sl_init, sl_lock, sl_unlock },
+    { "spinlock",    sp_init, sp_lock, sp_unlock },   /* BKL + instance */
+    { "spinlock_rt", sp_init, rt_lock, rt_unlock },   /* instance only */
+};
+
+/*─── One measurement point ───────────────────────────────────────────*/
+typedef struct {
+    pthread_t      th;
+    uint8_t        id;
+    unsigned long  acq;
+    uint32_t       lat[LAT_SAMPLES];
+} worker_t;
+
+static const lock_ops_t *cur;
+static worker_t         *workers;
+static unsigned          cs_units, think_units;
+static volatile int      go, stop;
+
+static struct {
+    volatile uint8_t       owner;       /* 0 = free, else holder's id */
+    volatile unsigned long count;       /* plain ++ under the lock */
+    volatile unsigned long work;
+    volatile unsigned long violations;
+} shared;
+
+static void *worker(void *arg)
+{
+    worker_t *w = arg;
+    volatile unsigned long mine = 0;
+
+    while (!go) {
+        sched_yield();
+    }
+    while (!stop) {
+        uint32_t t0 = hal_cycles();
+        cur->lock();
+        uint32_t t1 = hal_cycles();
+
+        if (shared.owner) shared.violations++;
+        shared.owner = w->id;
+        for (unsigned i = 0; i < cs_units; i++) {
+            shared.work++;
+        }
+        shared.count++;
+        if (shared.owner != w->id) shared.violations++;
+        shared.owner = 0;
+        cur->unlock();
+
+        w->lat[w->acq % LAT_SAMPLES] = t1 - t0;
+        w->acq++;
+        for (unsigned i = 0; i < think_units; i++) {
+            mine++;
+        }
+    }
+    return NULL;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static bool csv;
+
+/* false if mutual exclusion was broken */
+static bool run_point(const lock_ops_t *l, unsigned threads, unsigned cs, unsigned ms,
+                      long cpus)
+{
+    static uint32_t all[MAX_THREADS * LAT_SAMPLES];
+
+    cur = l;
+    cs_units = cs;
+    memset(&shared, 0, sizeof shared);
+    memset(workers, 0, threads * sizeof *workers);
+    bench_yield = (long)threads > cpus;
+    go = stop = 0;
+    l->init();
+
+    for (unsigned i = 0; i < threads; i++) {
+        workers[i].id = (uint8_t)(i + 1);
+        if (pthread_create(&workers[i].th, NULL, worker, &workers[i]) != 0) {
+            perror("pthread_create");
+            exit(2);
+        }
+    }
+    uint32_t t0 = hal_cycles();
+    go = 1;
+    struct timespec ts = { (time_t)(ms / 1000u), (long)(ms % 1000u) * 1000000L };
+    nanosleep(&ts, NULL);
+    stop = 1;
+    for (unsigned i = 0; i < threads; i++) {
+        pthread_join(workers[i].th, NULL);
+    }
+    double secs = (double)(uint32_t)(hal_cycles() - t0) / 1e9;
+
+    unsigned long total = 0;
+    double sq = 0;
+    size_t n = 0;
+    for (unsigned i = 0; i < threads; i++) {
+        unsigned long a = workers[i].acq;
+        size_t k = a < LAT_SAMPLES ? a : LAT_SAMPLES;
+        memcpy(&all[n], workers[i].lat, k * sizeof all[0]);
+        n += k;
+        total += a;
+        sq += (double)a * (double)a;
+    }
+    qsort(all, n, sizeof all[0], cmp_u32);
+#define PCT(p) (n ? all[(size_t)((double)(n - 1) * (p))] : 0u)
+    double jain = sq > 0 ? (double)total * (double)total / (threads * sq) : 0;
+
+    if (csv) {
+        printf("%s,%u,%u,%.0f,%u,%u,%u,%u,%.3f\n", l->name, threads, cs,
+               (double)total / secs, PCT(0.5), PCT(0.99), PCT(0.999), PCT(1.0), jain);
+    } else {
+        printf("%-14s %3u %5u %10.0f %7u %7u %8u %9u %6.3f\n", l->name, threads, cs,
+               (double)total / secs, PCT(0.5), PCT(0.99), PCT(0.999), PCT(1.0), jain);
+    }
+#undef PCT
+    fflush(stdout);
+
+    if (shared.violations || shared.count != total) {
+        fprintf(stderr, "%s: mutual exclusion broken (%lu violations, %lu/%lu)\n",
+                l->name, (unsigned long)shared.violations,
+                (unsigned long)shared.count, total);
+        return false;
+    }
+    return true;
+}
+
+/*─── Command line ────────────────────────────────────────────────────*/
+static unsigned parse_list(const char *s, unsigned *out, unsigned max)
+{
+    unsigned n = 0;
+    while (*s && n < max) {
+        char *end;
+        unsigned long v = strtoul(s, &end, 0);
+        if (end == s) break;
+        out[n++] = (unsigned)v;
+        s = *end == ',' ? end + 1 : end;
+    }
+    return n;
+}
+
+static bool selected(const char *names, const char *name)
+{
+    if (!names) return true;
+    size_t len = strlen(name);
+    for (const char *p = names; (p = strstr(p, name)) != NULL; p += len) {
+        if ((p == names || p[-1] == ',') && (p[len] == ',' || p[len] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned threads[16] = { 1, 2, 4, 8 }, nthreads = 4;
+    unsigned cs[16] = { 0, 100, 1000 }, ncs = 3;
+    unsigned ms = 200;
+    const char *names = NULL;
+    int opt;
+
+    think_units = 100;
+    while ((opt = getopt(argc, argv, "t:c:w:d:l:C")) != -1) {
+        switch (opt) {
+        case 't': nthreads = parse_list(optarg, threads, 16); break;
+        case 'c': ncs = parse_list(optarg, cs, 16); break;
+        case 'w': think_units = (unsigned)strtoul(optarg, NULL, 0); break;
+        case 'd': ms = (unsigned)strtoul(optarg, NULL, 0); break;
+        case 'l': names = optarg; break;
+        case 'C': csv = true; break;
+        default:
+            fprintf(stderr, "usage: %s [-t 1,2,4] [-c 0,100] [-w units] [-d ms] "
+                            "[-l flock,...] [-C]\n", argv[0]);
+            return 2;
+        }
+    }
+    for (unsigned i = 0; i < nthreads; i++) {
+        if (threads[i] == 0 || threads[i] > MAX_THREADS) {
+            fprintf(stderr, "threads must be 1..%d\n", MAX_THREADS);
+            return 2;
+        }
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = calloc(MAX_THREADS, sizeof *workers);
+    if (!workers) return 2;
+
+    if (csv) {
+        printf("lock,threads,cs,acq_per_s,p50_ns,p99_ns,p999_ns,max_ns,jain\n");
+    } else {
+        printf("%ld CPUs, %u ms per point, %u think units\n", cpus, ms, think_units);
+        printf("%-14s %3s %5s %10s %7s %7s %8s %9s %6s\n", "lock", "thr", "cs",
+               "acq/s", "p50ns", "p99ns", "p99.9ns", "maxns", "jain");
+    }
+
+    bool ok = true;
+    for (size_t l = 0; l < sizeof locks / sizeof locks[0]; l++) {
+        if (!selected(names, locks[l].name)) continue;
+        for (unsigned t = 0; t < nthreads; t++) {
+            for (unsigned c = 0; c < ncs; c++) {
+                ok &= run_point(&locks[l], threads[t], cs[c], ms, cpus);
+            }
+        }
+    }
+    free(workers);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Deferred-format binary log rings (kernel/sync/nk_log.c)
+ *
+ * With a file argument the drained records are written there, for
+ * feeding scripts/log_decode.py by hand (link with -no-pie so the IDs
+ * match the ELF). */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NK_LOG_ENABLED 1
+#define NK_LOG_BUF 32
+
+#include "../kernel/sync/nk_log.c"
+
+#define ID sizeof(nk_log_id_t)
+
+static uint16_t used(void)
+{
+    return (uint16_t)(nk_log_buf.ring[0].head - nk_log_buf.ring[0].tail);
+}
+
+int main(int argc, char **argv)
+{
+    uint8_t out[64];
+
+    /* Garbage from power-up is thrown away */
+    memset(&nk_log_buf, 0xA5, sizeof nk_log_buf);
+    nk_log_init();
+    assert(nk_log_buf.magic == NK_LOG_MAGIC);
+    assert(nk_log_buf.size == NK_LOG_BUF && used() == 0);
+
+    /* Arguments are stored at their promoted size */
+    uint8_t small = 7;
+    long big = -2;
+    NK_LOG("boot");
+    NK_LOG("task %u", small);
+    NK_LOG("sum %ld of %d", big, 3);
+    size_t rec0 = ID + 1;
+    size_t rec1 = ID + 1 + sizeof(int);
+    size_t rec2 = ID + 1 + sizeof(long) + sizeof(int);
+    assert(used() == rec0 + rec1 + rec2);
+
+    /* A warm reset keeps what was not drained */
+    nk_log_init();
+    assert(used() == rec0 + rec1 + rec2);
+
+    /* Whole records only */
+    assert(nk_log_read(0, out, rec0 + rec1 - 1) == rec0);
+    assert(out[ID] == 0);
+    size_t n = nk_log_read(0, out, sizeof out);
+    assert(n == rec1 + rec2 && used() == 0);
+    assert(out[ID] == NK_LOG_SZ_(small));
+    assert(out[ID + 1] == 7);
+    assert(nk_log_read(0, out, sizeof out) == 0);
+
+    /* Overflow: newest records go, their count comes back first */
+    int i = 0;
+    while (used() + rec1 <= NK_LOG_BUF) {
+        NK_LOG("fill %d", i++);
+    }
+    NK_LOG("lost %d", 1);
+    NK_LOG("lost %d", 2);
+    assert(nk_log_buf.ring[0].dropped == 2);
+    n = nk_log_read(0, out, sizeof out);
+    assert(n == (size_t)i * rec1);
+    NK_LOG("after %d", 3);
+    assert(nk_log_buf.ring[0].dropped == 0);
+    n = nk_log_read(0, out, sizeof out);
+    assert(n == ID + 3 + rec1);
+    nk_log_id_t id = 0;
+    memcpy(&id, out, ID);
+    assert(id == NK_LOG_ID_DROPPED && out[ID] == 1 && out[ID + 1] == 2);
+
+    size_t len;
+    assert(nk_log_image(&len) == &nk_log_buf && len == sizeof nk_log_buf);
+
+    if (argc > 1) {
+        FILE *f = fopen(argv[1], "wb");
+        assert(f);
+        NK_LOG("boot");
+        NK_LOG("task %u is 0x%04x", small, 0xBEEFu);
+        n = nk_log_read(0, out, sizeof out);
+        assert(fwrite(out, 1, n, f) == n);
+        NK_LOG("sum %ld of %d", big, 3);
+        for (int k = 0; k < 3; k++) {
+            NK_LOG("tick %d", k);
+        }
+        n = nk_log_read(0, out, sizeof out);
+        assert(fwrite(out, 1, n, f) == n);
+        fclose(f);
+    }
+    printf("log_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,314 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Network interfaces: per-link receive, LPM routes, zero-copy forwarding */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "drivers/net/netif.h"
+#include "drivers/net/udp.h"
+#include "drivers/net/slip.h"
+#include "drivers/tty/tty.h"
+
+#if CONFIG_NET_NETIF_ENABLED && CONFIG_NET_UDP_ENABLED
+
+/*─── Two SLIP links, each two one-way lines ──────────────────────────*/
+typedef struct {
+    uint8_t out[2048], in[2048];
+    size_t  out_len, out_pos, in_len, in_pos, budget;
+} line_t;
+
+static line_t line[2];
+
+static void out0(uint8_t c) { assert(line[0].out_len < 2048); line[0].out[line[0].out_len++] = c; }
+static void out1(uint8_t c) { assert(line[1].out_len < 2048); line[1].out[line[1].out_len++] = c; }
+static void in0(uint8_t c)  { assert(line[0].in_len < 2048); line[0].in[line[0].in_len++] = c; }
+static void in1(uint8_t c)  { assert(line[1].in_len < 2048); line[1].in[line[1].in_len++] = c; }
+
+static int line_getc(line_t *l)
+{
+    if (l->in_pos == l->in_len || l->budget == 0) return -1;
+    l->budget--;
+    return l->in[l->in_pos++];
+}
+static int get0(void) { return line_getc(&line[0]); }
+static int get1(void) { return line_getc(&line[1]); }
+
+static tty_t   serial[2], wire[2];
+static uint8_t tty_rx[2][64], tty_tx[2][64], wire_rx[2][64], wire_tx[2][64];
+static netif_t sl0, sl1;
+
+#define ADDR0 0x0A000001u           /* 10.0.0.1/24 */
+#define ADDR1 0x0A000101u           /* 10.0.1.1/24 */
+#define HOST0 0x0A000002u
+#define HOST1 0x0A000102u
+#define MASK  0xFFFFFF00u
+
+/* Let link @p i read at most @p n more bytes, then dispatch */
+static int feed(int i, size_t n)
+{
+    line[i].budget = n;
+    tty_poll(&serial[i]);
+    return ipv4_poll(&serial[i]);
+}
+
+static int pump(int i)
+{
+    int n = 0;
+    for (;;) {
+        size_t before = line[i].in_pos;
+        n += feed(i, sizeof(tty_rx[i]) - 1 - tty_rx_available(&serial[i]));
+        if (line[i].in_pos == before) return n;
+    }
+}
+
+static size_t next_frame(int i, uint8_t *f)
+{
+    line_t *l = &line[i];
+    size_t n = 0;
+    while (l->out_pos < l->out_len && l->out[l->out_pos] == SLIP_END) l->out_pos++;
+    while (l->out_pos < l->out_len && l->out[l->out_pos] != SLIP_END) {
+        uint8_t b = l->out[l->out_pos++];
+        if (b == SLIP_ESC) b = l->out[l->out_pos++] == SLIP_ESC_END ? SLIP_END : SLIP_ESC;
+        f[n++] = b;
+    }
+    return n;
+}
+
+/* A UDP datagram (no UDP checksum) into @p f */
+static size_t dgram(uint8_t *f, uint32_t src, uint32_t dst, uint16_t dport,
+                    uint8_t ttl, size_t len)
+{
+    ipv4_hdr_t h;
+    ipv4_init_header(&h, src, dst, IPV4_PROTO_UDP, (uint16_t)(8 + len));
+    h.ttl = ttl;
+    h.checksum = 0;
+    h.checksum = ipv4_htons(ipv4_checksum(&h, sizeof(h)));
+    memcpy(f, &h, 20);
+    f[20] = 0x30; f[21] = 0x39;     /* sport 12345 */
+    f[22] = (uint8_t)(dport >> 8); f[23] = (uint8_t)dport;
+    f[24] = (uint8_t)((8 + len) >> 8); f[25] = (uint8_t)(8 + len);
+    f[26] = 0; f[27] = 0;
+    for (size_t i = 0; i < len; i++) f[28 + i] = (uint8_t)(i ^ dport);
+    return 28 + len;
+}
+
+static void test_routes(void)
+{
+    assert(netif_route(HOST0) == &sl0 && netif_route(HOST1) == &sl1);
+    assert(netif_route(0xC0A80101u) == NULL);
+
+    assert(netif_route_add(0, 0, &sl0) == 0);
+    assert(netif_route(0xC0A80101u) == &sl0);
+    assert(netif_route_add(0xC0A80000u, 16, &sl1) == 0);
+    assert(netif_route(0xC0A80101u) == &sl1 && netif_route(0xC0A90101u) == &sl0);
+    assert(netif_route_add(0xC0A801FFu, 24, &sl0) == 0);    /* host bits ignored */
+    assert(netif_route(0xC0A80101u) == &sl0 && netif_route(0xC0A80201u) == &sl1);
+
+    /* A connected subnet beats an equally long table entry */
+    assert(netif_route_add(0x0A000100u, 24, &sl0) == 0);
+    assert(netif_route(HOST1) == &sl1);
+    netif_route_del(0x0A000100u, 24);
+
+    netif_route_del(0xC0A80100u, 24);
+    assert(netif_route(0xC0A80101u) == &sl1);
+    netif_route_del(0xC0A80000u, 16);
+    assert(netif_route(0xC0A80101u) == &sl0);
+    assert(netif_route_add(0, 33, &sl0) == -1 && netif_route_add(0, 8, NULL) == -1);
+    for (int i = 0; i < NETIF_ROUTES - 1; i++) {
+        assert(netif_route_add(0x64000000u + ((uint32_t)i << 8), 24, &sl1) == 0);
+    }
+    assert(netif_route_add(0x65000000u, 8, &sl1) == -1);    /* full */
+    assert(netif_route_add(0, 0, &sl1) == 0);               /* replacing still works */
+    for (int i = 0; i < NETIF_ROUTES - 1; i++) {
+        netif_route_del(0x64000000u + ((uint32_t)i << 8), 24);
+    }
+    netif_route_del(0, 0);
+    assert(netif_route(0xC0A80101u) == NULL);
+}
+
+static void test_interleaved_rx(int s)
+{
+    uint8_t a[64], b[64];
+    size_t na = dgram(a, HOST0, ADDR0, 7000, 64, 20);
+    size_t nb = dgram(b, HOST1, ADDR1, 7000, 64, 30);
+    slip_send_packet(&wire[0], a, na);
+    slip_send_packet(&wire[1], b, nb);
+
+    /* Half a frame on link 0, all of link 1, then the rest of link 0 */
+    assert(feed(0, na / 2) == 0);
+    assert(pump(1) == 1);
+    assert(pump(0) == 1);
+
+    uint8_t buf[64];
+    uint32_t from;
+    assert(udp_recvfrom(s, buf, sizeof(buf), &from, NULL) == 30 && from == HOST1);
+    assert(memcmp(buf, b + 28, 30) == 0);
+    assert(udp_recvfrom(s, buf, sizeof(buf), &from, NULL) == 20 && from == HOST0);
+    assert(memcmp(buf, a + 28, 20) == 0);
+
+    assert(sl0.stats.rx_packets == 1 && sl0.stats.rx_bytes == na);
+    assert(sl1.stats.rx_packets == 1 && sl1.stats.rx_bytes == nb);
+
+    /* Garbage counts against the link it came on */
+    a[0] = 0x46;
+    slip_send_packet(&wire[0], a, na);
+    assert(pump(0) == 0 && sl0.stats.rx_dropped == 1 && sl1.stats.rx_dropped == 0);
+}
+
+static void test_routed_send(int s)
+{
+    uint8_t f[64];
+    assert(udp_sendto(NULL, s, HOST1, 9, "hi", 2) == 2);
+    assert(next_frame(1, f) == 30 && next_frame(0, f) == 0);
+    assert(udp_sendto(NULL, s, HOST0, 9, "hey", 3) == 3);
+    assert(next_frame(0, f) == 31 && next_frame(1, f) == 0);
+    assert(udp_sendto(NULL, s, 0xAC100001u, 9, "x", 1) == -1);   /* no route */
+    assert(sl0.stats.tx_packets == 1 && sl0.stats.tx_bytes == 31);
+    assert(sl1.stats.tx_packets == 1 && sl1.stats.tx_bytes == 30);
+}
+
+static void test_forwarding(int s)
+{
+    uint8_t a[64], f[64];
+    uint8_t used = pbuf_used();
+    size_t na = dgram(a, HOST0, HOST1, 53, 9, 12);
+
+    /* Off: not ours, so nobody takes it */
+    slip_send_packet(&wire[0], a, na);
+    assert(pump(0) == 0 && next_frame(1, f) == 0);
+
+    netif_set_forwarding(true);
+    assert(netif_forwarding());
+    slip_send_packet(&wire[0], a, na);
+    assert(pump(0) == 1);
+    assert(next_frame(1, f) == na && next_frame(0, f) == 0);
+    assert(f[8] == 8 && ipv4_checksum(f, 20) == 0);
+    assert(memcmp(f + 9, a + 9, 1) == 0 && memcmp(f + 12, a + 12, na - 12) == 0);
+    assert(sl0.stats.forwarded == 1 && sl1.stats.forwarded == 0);
+    assert(pbuf_used() == used);
+
+    /* Still delivered locally when it is for one of our addresses */
+    size_t nb = dgram(a, HOST0, ADDR1, 7000, 9, 4);
+    slip_send_packet(&wire[0], a, nb);
+    assert(pump(0) == 1 && next_frame(1, f) == 0);
+    assert(udp_recvfrom(s, f, sizeof(f), NULL, NULL) == 4);
+
+    /* TTL running out, no route, or back out the way it came: dropped */
+    uint16_t dropped = sl0.stats.rx_dropped;
+    na = dgram(a, HOST0, HOST1, 53, 1, 12);
+    slip_send_packet(&wire[0], a, na);
+    na = dgram(a, HOST0, 0xAC100001u, 53, 9, 12);
+    slip_send_packet(&wire[0], a, na);
+    na = dgram(a, HOST0, 0x0A000009u, 53, 9, 12);
+    slip_send_packet(&wire[0], a, na);
+    assert(pump(0) == 0 && next_frame(0, f) == 0 && next_frame(1, f) == 0);
+    assert(sl0.stats.rx_dropped == dropped + 3 && sl0.stats.forwarded == 1);
+    assert(pbuf_used() == used);
+    netif_set_forwarding(false);
+}
+
+/*─── Links without a TTY ─────────────────────────────────────────────*/
+static netif_t radio_a, radio_b;
+static const uint8_t *sent;
+static size_t sent_len;
+static int sent_frames;
+
+static void radio_output(netif_t *nif, const slip_iov_t *iov, uint8_t cnt)
+{
+    assert(nif == &radio_b && cnt >= 1);
+    sent = iov[0].base;
+    sent_len = 0;
+    for (uint8_t i = 0; i < cnt; i++) sent_len += iov[i].len;
+    sent_frames++;
+}
+
+static void test_radio(int s)
+{
+    netif_remove(&sl0);
+    netif_remove(&sl1);
+    assert(netif_find(&serial[0]) == NULL && netif_route(HOST0) == NULL);
+
+    assert(netif_add(&radio_a, NULL, 0xC0A80001u, 0xFFFFFF00u) == 0);
+    assert(netif_add(&radio_b, NULL, 0xC0A80101u, 0xFFFFFF00u) == 0);
+    assert(netif_add(&radio_b, NULL, 0, 0) == -1);
+    radio_b.output = radio_output;
+    uint8_t used = pbuf_used();
+
+    /* Handed in whole, delivered like a received frame */
+    pbuf_t *p = pbuf_alloc(0);
+    assert(p);
+    p->len = (uint16_t)dgram(pbuf_data(p), 0xC0A80002u, 0xC0A80001u, 7000, 64, 5);
+    assert(netif_input(&radio_a, p));
+    uint8_t buf[8];
+    assert(udp_recvfrom(s, buf, sizeof(buf), NULL, NULL) == 5);
+    assert(radio_a.stats.rx_packets == 1 && pbuf_used() == used);
+
+    /* Forwarded: the very buffer that came in is what goes out */
+    netif_set_forwarding(true);
+    p = pbuf_alloc(0);
+    assert(p);
+    uint8_t *data = pbuf_data(p);
+    p->len = (uint16_t)dgram(data, 0xC0A80002u, 0xC0A80102u, 53, 64, 100);
+    size_t len = p->len;
+    assert(netif_input(&radio_a, p));
+    assert(sent_frames == 1 && sent == data && sent_len == len && data[8] == 63);
+    assert(radio_a.stats.forwarded == 1 && radio_b.stats.tx_packets == 1);
+    assert(pbuf_used() == used);
+
+    /* Replying to a routed source goes through the callback too */
+    assert(udp_sendto(NULL, s, 0xC0A80102u, 9, "z", 1) == 1 && sent_frames == 2);
+
+    /* Bad headers are dropped and counted */
+    p = pbuf_alloc(0);
+    assert(p);
+    p->len = (uint16_t)dgram(pbuf_data(p), 0xC0A80002u, 0xC0A80001u, 7000, 64, 5);
+    pbuf_data(p)[10] ^= 0xFF;
+    assert(!netif_input(&radio_a, p) && radio_a.stats.rx_dropped == 1);
+    assert(pbuf_used() == used);
+    netif_set_forwarding(false);
+
+    netif_remove(&radio_a);
+    netif_remove(&radio_b);
+}
+
+int main(void)
+{
+    tty_init(&serial[0], tty_rx[0], tty_tx[0], sizeof(tty_rx[0]), out0, get0);
+    tty_init(&serial[1], tty_rx[1], tty_tx[1], sizeof(tty_rx[1]), out1, get1);
+    tty_init(&wire[0], wire_rx[0], wire_tx[0], sizeof(wire_rx[0]), in0, NULL);
+    tty_init(&wire[1], wire_rx[1], wire_tx[1], sizeof(wire_rx[1]), in1, NULL);
+    udp_init(0);
+
+    assert(netif_add(&sl0, &serial[0], ADDR0, MASK) == 0);
+    assert(ipv4_addr() == ADDR0);
+    assert(netif_add(&sl1, &serial[1], ADDR1, MASK) == 0);
+    assert(ipv4_addr() == ADDR0);
+    assert(netif_add(&sl1, &serial[1], ADDR1, MASK) == -1);
+    assert(netif_find(&serial[1]) == &sl1 && netif_find_addr(ADDR1) == &sl1);
+    assert(netif_find(&wire[0]) == NULL);
+
+    int s = udp_bind(7000);
+    assert(s >= 0);
+    test_routes();
+    test_interleaved_rx(s);
+    test_routed_send(s);
+    test_forwarding(s);
+    test_radio(s);
+    udp_close(s);
+    printf("netif_test: ok\n");
+    return 0;
+}
+
+#else
+
+int main(void)
+{
+    printf("netif_test: skipped (needs net_netif_enabled and net_udp_enabled)\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Bump-pointer scratch arenas (kernel/mm/nk_arena.c) */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "nk_arena.h"
+#include "kernel/mm/kalloc.h"
+
+int main(void)
+{
+    static uint8_t buf[256];
+    nk_arena_t a;
+    nk_arena_init(&a, buf, sizeof(buf));
+
+    /* Allocations are aligned and packed in order. */
+    uint8_t *p = nk_arena_alloc(&a, 3);
+    uint8_t *q = nk_arena_alloc(&a, 8);
+    assert(p == buf && q > p);
+    assert((uintptr_t)q % NK_ARENA_ALIGN == 0);
+
+    /* Mark/release rewinds to the mark and no further. */
+    nk_arena_mark_t m = nk_arena_mark(&a);
+    size_t left = nk_arena_remaining(&a);
+    assert(nk_arena_alloc(&a, 100));
+    assert(nk_arena_alloc(&a, left) == NULL);
+    nk_arena_release(&a, m);
+    assert(nk_arena_remaining(&a) == left);
+    assert(a.peak > a.top);
+
+    /* Exhaustion fails without moving the pointer. */
+    assert(nk_arena_alloc(&a, 0) == NULL);
+    assert(nk_arena_alloc(&a, SIZE_MAX) == NULL);
+    assert(nk_arena_remaining(&a) == left);
+
+    nk_arena_reset(&a);
+    assert(nk_arena_alloc(&a, sizeof(buf)) == buf);
+
+    /* Heap-backed arenas return their block on destroy. */
+    kalloc_init();
+    nk_arena_t h;
+    assert(nk_arena_init_heap(&h, 64));
+    void *hp = nk_arena_alloc(&h, 64);      /* whatever kalloc() aligns to */
+    assert(hp && (uintptr_t)hp % NK_ARENA_ALIGN == 0);
+    nk_arena_destroy(&h);
+    assert(!nk_arena_init_heap(&h, (size_t)NK_HEAP_SIZE * 2));
+    assert(nk_arena_alloc(&h, 1) == NULL);
+
+    printf("nk_arena ok\n");
+    return 0;
+}
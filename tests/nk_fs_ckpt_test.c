@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* TinyLog-4 (src/nk_fs.c) fast mount from an index checkpoint */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+static uint8_t  eeprom[2048];
+static unsigned ee_reads;
+
+static uint8_t ee_read(uint16_t a)
+{
+    assert(a < sizeof(eeprom));
+    ee_reads++;
+    return eeprom[a];
+}
+
+static void ee_write(uint16_t a, uint8_t v)
+{
+    assert(a < sizeof(eeprom));
+    eeprom[a] = v;
+}
+
+#define NK_FS_INDEX      8
+#define NK_FS_BLOOM      16
+#define NK_FS_CHECKPOINT 1
+#define NK_FS_EE_READ(a)     ee_read(a)
+#define NK_FS_EE_WRITE(a, v) ee_write(a, v)
+#include "../src/nk_fs.c"
+
+static uint16_t get(uint16_t key)
+{
+    uint16_t v = 0xFFFF;
+    return nk_fs_get(key, &v) ? v : 0xFFFF;
+}
+
+/* slot holding the higher sequence number */
+static uint16_t newest_slot(void)
+{
+    uint8_t s0 = eeprom[NK_FS_CKPT_ADDR + 1];
+    uint8_t s1 = eeprom[NK_FS_CKPT_ADDR + CKPT_SZ + 1];
+    return (uint16_t)(NK_FS_CKPT_ADDR + ((int8_t)(s1 - s0) > 0 ? CKPT_SZ : 0));
+}
+
+/* rewrite the CRC after editing a slot by hand */
+static void reseal(uint16_t slot)
+{
+    uint8_t crc = 0;
+    for (uint16_t a = slot; a < slot + CKPT_SZ - 1; a++) {
+        crc = crc8_update(crc, eeprom[a]);
+    }
+    eeprom[slot + CKPT_SZ - 1] = crc;
+}
+
+static void check(unsigned hot)
+{
+    assert(get(7) == hot % 32);
+    for (uint16_t k = 0; k < 6; k++) {
+        assert(get(1000 + k) == k);
+    }
+    assert(get(200) == 0xFFFF);
+}
+
+int main(void)
+{
+    memset(eeprom, 0xFF, sizeof eeprom);
+    nk_fs_init();
+
+    for (uint16_t k = 0; k < 6; k++) {
+        assert(nk_fs_put(1000 + k, k));
+    }
+    assert(nk_fs_put(200, 1) && nk_fs_del(200));
+    unsigned i;
+    for (i = 0; i < 700; i++) {
+        assert(nk_fs_put(7, i % 32));
+    }
+    check(i - 1);
+
+    /* A checkpoint mount replays a few rows; without one, the whole log */
+    assert(eeprom[newest_slot()] == CKPT_MAGIC);
+    ee_reads = 0;
+    nk_fs_init();
+    const unsigned fast = ee_reads;
+    check(i - 1);
+
+    uint8_t m0 = eeprom[NK_FS_CKPT_ADDR], m1 = eeprom[NK_FS_CKPT_ADDR + CKPT_SZ];
+    eeprom[NK_FS_CKPT_ADDR] = eeprom[NK_FS_CKPT_ADDR + CKPT_SZ] = 0;
+    ee_reads = 0;
+    nk_fs_init();
+    const unsigned full = ee_reads;
+    check(i - 1);
+    assert(fast * 2 < full);
+    eeprom[NK_FS_CKPT_ADDR] = m0;
+    eeprom[NK_FS_CKPT_ADDR + CKPT_SZ] = m1;
+
+    /* Writes after a fast mount keep the log and new checkpoints right */
+    nk_fs_init();
+    for (; i < 1400; i++) {
+        assert(nk_fs_put(7, i % 32));
+    }
+    assert(nk_fs_put(1002, 9) && nk_fs_del(1003));
+    nk_fs_init();
+    assert(get(1002) == 9 && get(1003) == 0xFFFF);
+    assert(nk_fs_put(1002, 2) && nk_fs_put(1003, 3));
+    check(i - 1);
+
+    /* A torn newest slot falls back to the older one */
+    uint16_t slot = newest_slot();
+    eeprom[slot + 5] ^= 0x01;
+    nk_fs_init();
+    check(i - 1);
+    assert(nk_fs_put(7, 3) && get(7) == 3);
+    i = 4;
+
+    /* A slot whose row has been recycled since is not trusted */
+    for (; i < 1500; i++) {
+        assert(nk_fs_put(7, i % 32));
+    }
+    slot = newest_slot();
+    eeprom[slot + 1] -= ROWS;                 /* same row, one lap earlier */
+    eeprom[slot + 4] = 0;                     /* with a stale index */
+    reseal(slot);
+    nk_fs_init();
+    check(i - 1);
+
+    printf("nk_fs checkpoint: mount reads %u bytes instead of %u\n", fast, full);
+    return 0;
+}
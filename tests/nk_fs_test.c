@@ -0,0 +1,133 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* TinyLog-4 (src/nk_fs.c) index, bloom filter and GC over a RAM EEPROM */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+static uint8_t  eeprom[1024];
+static unsigned ee_reads, ee_writes;
+
+static uint8_t ee_read(uint16_t a)
+{
+    assert(a < sizeof(eeprom));
+    ee_reads++;
+    return eeprom[a];
+}
+
+static void ee_write(uint16_t a, uint8_t v)
+{
+    assert(a < sizeof(eeprom));
+    ee_writes += eeprom[a] != v;
+    eeprom[a] = v;
+}
+
+#define NK_FS_INDEX 8
+#define NK_FS_BLOOM 16
+#define NK_FS_CHECKPOINT 0      /* nk_fs_ckpt_test covers the saved index */
+#define NK_FS_EE_READ(a)     ee_read(a)
+#define NK_FS_EE_WRITE(a, v) ee_write(a, v)
+#include "../src/nk_fs.c"
+
+static uint16_t get(uint16_t key)
+{
+    uint16_t v = 0xFFFF;
+    return nk_fs_get(key, &v) ? v : 0xFFFF;
+}
+
+int main(void)
+{
+    memset(eeprom, 0xFF, sizeof eeprom);
+    nk_fs_init();
+
+    /* Indexed hit: one record read; indexed miss: none */
+    assert(nk_fs_put(100, 7) && nk_fs_put(200, 9) && nk_fs_put(100, 8));
+    ee_reads = 0;
+    assert(get(100) == 8 && ee_reads == 4);
+    ee_reads = 0;
+    assert(get(300) == 0xFFFF && ee_reads == 0);
+
+    assert(nk_fs_del(200));
+    ee_reads = 0;
+    assert(get(200) == 0xFFFF && ee_reads == 0);
+
+    /* Across row boundaries and a remount */
+    for (uint16_t i = 0; i < 40; i++) {
+        assert(nk_fs_put(500 + i % 5, i % 32));
+    }
+    nk_fs_init();
+    assert(get(100) == 8 && get(200) == 0xFFFF);
+    for (uint16_t k = 0; k < 5; k++) {
+        assert(get(500 + k) == (35 + k) % 32);
+    }
+
+    /* More live keys than index slots: overflow walks the log, */
+    for (uint16_t k = 0; k < 12; k++) {
+        assert(nk_fs_put(1000 + k, k));
+    }
+    for (uint16_t k = 0; k < 12; k++) {
+        assert(get(1000 + k) == k);
+    }
+    assert(get(100) == 8 && get(200) == 0xFFFF);
+
+    /* but the bloom filter still screens most unknown keys */
+    unsigned screened = 0;
+    for (uint16_t k = 1500; k < 1600; k++) {
+        ee_reads = 0;
+        assert(get(k) == 0xFFFF);
+        screened += ee_reads == 0;
+    }
+    assert(screened > 50);
+
+    /* Index rebuilt from the log agrees with it */
+    nk_fs_init();
+    for (uint16_t k = 0; k < 12; k++) {
+        assert(get(1000 + k) == k);
+    }
+    assert(get(100) == 8);
+
+    /* One hot key cycles the log many times; cold keys are carried along */
+    for (unsigned i = 0; i < 2000; i++) {
+        assert(nk_fs_put(7, i % 32));
+        if (i % 97 == 0) {
+            while (nk_fs_gc()) {
+            }
+        }
+    }
+    assert(get(7) == 1999 % 32 && get(100) == 8 && get(200) == 0xFFFF);
+    for (uint16_t k = 0; k < 12; k++) {
+        assert(get(1000 + k) == k);
+    }
+    nk_fs_init();
+    assert(get(7) == 1999 % 32 && get(1005) == 5 && get(502) == (35 + 2) % 32);
+
+    /* With the next row cleaned from idle, writes stay one record each */
+    while (nk_fs_gc()) {
+    }
+    for (unsigned i = 0; i < 3 && fs.cur_idx + 1 < ROW_BLKS; i++) {
+        ee_writes = 0;
+        assert(nk_fs_put(7, i));
+        assert(ee_writes <= 4);
+    }
+
+    /* A full store refuses writes instead of dropping keys */
+    uint16_t stored = 0;
+    while (stored < 400 && nk_fs_put(1100 + stored, stored % 32)) {
+        stored++;
+    }
+    assert(stored > 150 && stored < 400);
+    nk_fs_init();
+    for (uint16_t k = 0; k < stored; k++) {
+        assert(get(1100 + k) == k % 32);
+    }
+    assert(get(1005) == 5 && get(100) == 8);
+    assert(nk_fs_del(1100) && get(1100) == 0xFFFF);
+
+    printf("nk_fs: ok, %u/100 unknown keys screened, %u keys fill the log\n",
+           screened, stored);
+    return 0;
+}
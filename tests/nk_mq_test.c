@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Kernel message queues (kernel/ipc/nk_mq.c) */
+
+#define NK_MQ_POOL 2
+#define NK_MQ_BUF  64
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../kernel/ipc/nk_mq.c"
+#include "../kernel/mm/nk_pool.c"
+
+/*─── Stub scheduler: blocking runs the "other task" once ──────────────*/
+static void (*peer)(void);
+static unsigned blocks, wakes;
+
+uint32_t nk_sched_lock(void) { return 0; }
+void nk_sched_unlock(uint32_t s) { (void)s; }
+
+void nk_waitq_block(nk_waitq_t *q)
+{
+    blocks++;
+    *q = 1;                     /* we are queued ... */
+    assert(peer);
+    peer();                     /* ... until the peer's wake() */
+    assert(*q == 0);
+}
+
+int nk_waitq_wake_one(nk_waitq_t *q)
+{
+    if (!*q) return -1;
+    wakes++;
+    *q = 0;
+    return 0;
+}
+
+static nk_mq_t q;
+
+static void drain_one(void)
+{
+    uint8_t b[8];
+    assert(nk_mq_recv(&q, b, sizeof(b), NULL, false) >= 0);
+}
+
+static void fill_one(void)
+{
+    assert(nk_mq_send(&q, "late", 4, 9, false) == 0);
+}
+
+int main(void)
+{
+    /* Shape validation and pool limits */
+    nk_mq_t a, b, c;
+    assert(nk_mq_create(&a, 3, 4) == -1);        /* not a power of two */
+    assert(nk_mq_create(&a, 0, 4) == -1);
+    assert(nk_mq_create(&a, 4, 0) == -1);
+    assert(nk_mq_create(&a, 16, 8) == -1);       /* 16 * 11 > NK_MQ_BUF */
+    assert(nk_mq_create(&a, 4, 8) == 0);
+    assert(nk_mq_create(&b, 4, 8) == 0);
+    assert(nk_mq_create(&c, 4, 8) == -1);        /* pool exhausted */
+    nk_mq_destroy(&b);
+    assert(nk_mq_create(&c, 4, 8) == 0);
+    nk_mq_destroy(&a);
+    nk_mq_destroy(&c);
+
+    /* FIFO, bounds and priority tags */
+    assert(nk_mq_create(&q, 4, 8) == 0);
+    assert(nk_mq_depth(&q) == 4);
+    uint8_t buf[8], prio;
+    assert(nk_mq_recv(&q, buf, sizeof(buf), NULL, false) == -1);
+    assert(nk_mq_send(&q, "toolongmsg", 9, 0, false) == -1);
+    for (uint8_t i = 0; i < 4; ++i) {
+        uint8_t m[3] = { i, (uint8_t)(i * 2), 0 };
+        assert(nk_mq_send(&q, m, (uint8_t)(i % 3 + 1), i, false) == 0);
+    }
+    assert(nk_mq_send(&q, "x", 1, 0, false) == -1);
+    assert(nk_mq_count(&q) == 4);
+    assert(nk_mq_recv(&q, buf, 4, NULL, false) == -1);   /* cap < msgsize */
+    for (uint8_t i = 0; i < 4; ++i) {
+        assert(nk_mq_recv(&q, buf, sizeof(buf), &prio, false) == i % 3 + 1);
+        assert(buf[0] == i && prio == i);
+    }
+
+    /* Many laps around the ring (sequence bytes wrap) */
+    for (unsigned n = 0; n < 1000; ++n) {
+        uint8_t v = (uint8_t)n;
+        assert(nk_mq_send(&q, &v, 1, 0, false) == 0);
+        if (n & 1) {
+            assert(nk_mq_send(&q, &v, 1, 1, false) == 0);
+            assert(nk_mq_recv(&q, buf, sizeof(buf), &prio, false) == 1);
+            assert(buf[0] == v && prio == 0);
+            assert(nk_mq_recv(&q, buf, sizeof(buf), &prio, false) == 1);
+            assert(buf[0] == v && prio == 1);
+        } else {
+            assert(nk_mq_recv(&q, buf, sizeof(buf), NULL, false) == 1);
+            assert(buf[0] == v);
+        }
+    }
+    assert(nk_mq_count(&q) == 0);
+
+    /* Blocking receive: sleeps until a sender arrives */
+    peer = fill_one;
+    assert(nk_mq_recv(&q, buf, sizeof(buf), &prio, true) == 4);
+    assert(memcmp(buf, "late", 4) == 0 && prio == 9);
+    assert(blocks == 1 && wakes == 1);
+
+    /* Blocking send: sleeps until a receiver makes room */
+    for (int i = 0; i < 4; ++i) assert(nk_mq_send(&q, "f", 1, 0, false) == 0);
+    peer = drain_one;
+    assert(nk_mq_send(&q, "g", 1, 0, true) == 0);
+    assert(blocks == 2 && wakes == 2);
+    assert(nk_mq_count(&q) == 4);
+
+    /* No waiter, no wake-up call */
+    assert(nk_mq_recv(&q, buf, sizeof(buf), NULL, false) == 1);
+    assert(wakes == 2);
+
+    nk_mq_destroy(&q);
+    printf("nk_mq ok\n");
+    return 0;
+}
@@ -0,0 +1,95 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Adaptive spin-then-block mutex (kernel/sync/nk_mutex.c) */
+
+#define NK_MUTEX_SPIN 8
+
+#include <assert.h>
+#include <stdio.h>
+
+#include "../kernel/sync/nk_mutex.c"
+
+/*─── Stub scheduler ───────────────────────────────────────────────────*/
+static uint8_t current_tid;
+static unsigned running_calls, blocks;
+static bool owner_runs;
+static int release_after;      /* owner drops the lock after N polls */
+static nk_mutex_t *watched;
+static int wake_tid = -1;
+
+uint8_t nk_current_tid(void) { return current_tid; }
+uint32_t nk_sched_lock(void) { return 0; }
+void nk_sched_unlock(uint32_t s) { (void)s; }
+void nk_waitq_init(nk_waitq_t *q) { *q = NK_WAITQ_INIT; }
+void nk_waitq_block(nk_waitq_t *q) { *q = (uint8_t)(current_tid + 1); blocks++; }
+int nk_waitq_wake_one(nk_waitq_t *q)
+{
+    int t = wake_tid;
+    wake_tid = -1;
+    if (t >= 0) *q = 0;
+    return t;
+}
+
+bool nk_task_running(uint8_t tid)
+{
+    assert(tid == watched->owner);
+    running_calls++;
+    if (release_after > 0 && --release_after == 0) {
+        watched->owner = NK_MUTEX_NO_OWNER;
+        watched->lock = 0;             /* holder finished on another core */
+    }
+    return owner_runs;
+}
+
+int main(void)
+{
+    nk_mutex_t m = NK_MUTEX_INIT;
+    watched = &m;
+
+    /* Uncontended */
+    current_tid = 1;
+    assert(nk_mutex_trylock(&m) && m.owner == 1);
+    assert(!nk_mutex_trylock(&m));
+    nk_mutex_unlock(&m);
+    assert(m.lock == 0 && m.owner == NK_MUTEX_NO_OWNER);
+
+    /* Holder running elsewhere and about to finish: spin, never park */
+    nk_mutex_lock(&m);
+    current_tid = 2;
+    owner_runs = true;
+    release_after = 3;
+    nk_mutex_lock(&m);
+    assert(m.owner == 2 && running_calls == 3 && blocks == 0);
+    nk_mutex_unlock(&m);
+
+    /* Holder preempted: park right away */
+    current_tid = 1;
+    nk_mutex_lock(&m);
+    current_tid = 2;
+    owner_runs = false;
+    running_calls = 0;
+    nk_mutex_lock(&m);
+    assert(running_calls == 1 && blocks == 1 && m.waiters == 3);
+
+    /* Unlock hands the still-set lock to the waiter */
+    current_tid = 1;
+    wake_tid = 2;
+    nk_mutex_unlock(&m);
+    assert(m.lock == 1 && m.owner == 2 && m.waiters == 0);
+    current_tid = 2;
+    nk_mutex_unlock(&m);
+
+    /* Long critical section: spin budget runs out, then park */
+    current_tid = 1;
+    nk_mutex_lock(&m);
+    current_tid = 2;
+    owner_runs = true;
+    running_calls = 0;
+    nk_mutex_lock(&m);
+    assert(running_calls == NK_MUTEX_SPIN && blocks == 2);
+
+    printf("nk_mutex: spin=%d, %u parks\n", NK_MUTEX_SPIN, blocks);
+    return 0;
+}
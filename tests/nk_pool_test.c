@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Fixed-size object pools (kernel/mm/nk_pool.c) */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "nk_pool.h"
+
+typedef struct {
+    uint32_t id;
+    uint8_t  tag;
+} obj_t;
+
+NK_POOL_DEFINE(objs, obj_t, 11);
+NK_POOL_DEFINE_ISR(bytes, uint8_t, 3);
+
+int main(void)
+{
+    obj_t *o[11];
+
+    /* Slots come out lowest-first until the pool is exhausted. */
+    for (int i = 0; i < 11; ++i) {
+        o[i] = NK_POOL_ALLOC(objs);
+        assert(o[i] == &objs_slots[i]);
+        o[i]->id = (uint32_t)i;
+    }
+    assert(NK_POOL_ALLOC(objs) == NULL);
+    assert(nk_pool_used(&objs) == 11);
+
+    /* Freed slots are reused, lowest index first. */
+    assert(nk_pool_free(&objs, o[9]));
+    assert(nk_pool_free(&objs, o[2]));
+    assert(NK_POOL_ALLOC(objs) == o[2]);
+    assert(NK_POOL_ALLOC(objs) == o[9]);
+
+    /* Double free, foreign and misaligned pointers are rejected. */
+    obj_t other;
+    assert(nk_pool_free(&objs, o[4]));
+    assert(!nk_pool_free(&objs, o[4]));
+    assert(!nk_pool_free(&objs, &other));
+    assert(!nk_pool_free(&objs, (uint8_t *)o[5] + 1));
+    assert(!nk_pool_free(&objs, NULL));
+
+    /* Index lookup only resolves live slots. */
+    assert(nk_pool_index(&objs, o[7]) == 7);
+    assert(nk_pool_at(&objs, 7) == o[7]);
+    assert(nk_pool_at(&objs, 4) == NULL);
+    assert(nk_pool_at(&objs, 11) == NULL);
+    assert(nk_pool_at(&objs, -1) == NULL);
+
+    nk_pool_reset(&objs);
+    assert(nk_pool_used(&objs) == 0);
+
+    /* Atomic variant behaves the same. */
+    uint8_t *a = NK_POOL_ALLOC(bytes);
+    uint8_t *b = NK_POOL_ALLOC(bytes);
+    uint8_t *c = NK_POOL_ALLOC(bytes);
+    assert(a && b && c && NK_POOL_ALLOC(bytes) == NULL);
+    assert(nk_pool_free(&bytes, b) && !nk_pool_free(&bytes, b));
+    assert(NK_POOL_ALLOC(bytes) == b);
+
+    printf("nk_pool ok\n");
+    return 0;
+}
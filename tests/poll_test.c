@@ -0,0 +1,159 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* nk_event groups and vfs_poll() over pipes and a TTY (kernel_poll) */
+
+#define VFS_MAX_PIPES 2
+#define VFS_PIPE_BUF  16
+#define VFS_TASK_FDS  0         /* the children write fds main opened */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../drivers/fs/vfs.c"
+#include "drivers/tty/tty.h"
+#include "kernel/sync/nk_event.h"
+
+
+static nk_tcb_t tm, tc;
+static uint8_t  sm[HAL_HOST_STACK], sc[HAL_HOST_STACK];
+
+static nk_event_t ev = NK_EVENT_INIT;
+static tty_t      tty;
+static uint8_t    rx_buf[16], tx_buf[16];
+static int        pfd[2];
+
+static void kick(void) {}
+
+/* Sets one bit after a short nap */
+static void setter(void)
+{
+    nk_sleep(5);
+    nk_event_set(&ev, 0x04);
+    nk_task_exit(0);
+}
+
+/* Makes the pipe and the TTY ready in one go, as two ISRs might */
+static void feeder(void)
+{
+    nk_sleep(5);
+    uint32_t s = nk_sched_lock();
+    assert(vfs_write(pfd[1], "x", 1) == 1);
+    assert(tty_rx_isr(&tty, 'y'));
+    nk_sched_unlock(s);
+    nk_task_exit(0);
+}
+
+/* Only closes the write end */
+static void closer(void)
+{
+    nk_sleep(5);
+    assert(vfs_close(pfd[1]) == 0);
+    nk_task_exit(0);
+}
+
+static void run_child(void (*fn)(void))
+{
+    assert(nk_task_create(&tc, fn, 2, sc, HAL_HOST_STACK));
+}
+
+static void reap_child(void)
+{
+    assert(nk_task_wait(tc.pid) == 0);
+    nk_task_release(tc.pid);
+}
+
+static void event_group(void)
+{
+    assert(nk_event_wait(&ev, 0x01, 0, 0) == 0);
+    nk_event_set(&ev, 0x03);
+    assert(nk_event_wait(&ev, 0x01, NK_EV_CLEAR, 0) == 0x01);
+    assert(nk_event_get(&ev) == 0x02);
+    assert(nk_event_wait(&ev, 0x06, NK_EV_ALL, 0) == 0);
+    assert(nk_event_wait(&ev, 0x06, NK_EV_CLEAR, 0) == 0x02);
+    assert(nk_event_get(&ev) == 0);
+    assert(nk_event_clear(&ev, 0xFF) == 0);
+
+    uint32_t t0 = nk_ticks();
+    assert(nk_event_wait(&ev, 0x01, 0, 5) == 0);
+    assert(nk_ticks() - t0 >= 5);
+
+    /* A set from another task ends the wait early */
+    run_child(setter);
+    t0 = nk_ticks();
+    assert(nk_event_wait(&ev, 0x04, NK_EV_CLEAR, 1000) == 0x04);
+    assert(nk_ticks() - t0 < 500);
+    reap_child();
+
+    /* Sequence waits see a set made after the snapshot only */
+    uint8_t seq = nk_event_seq(&ev);
+    assert(nk_event_wait_seq(&ev, seq, 0) == -1);
+    nk_event_set(&ev, 0);
+    assert(nk_event_wait_seq(&ev, seq, 0) == 0);
+}
+
+static void poll_fds(void)
+{
+    vfs_init();
+    assert(vfs_pipe(pfd) == 0);
+    tty_init_irq(&tty, rx_buf, tx_buf, sizeof(rx_buf), kick);
+    int tfd = vfs_open_tty(&tty, O_RDWR);
+    assert(tfd >= 0);
+    assert(vfs_open_tty(NULL, O_RDWR) == -1);
+
+    /* Write ends and TTY TX are ready at once; bad fds say so */
+    vfs_pollfd_t w[3] = {
+        { pfd[1], VFS_POLLOUT, 0 }, { tfd, VFS_POLLOUT, 0 }, { -1, VFS_POLLIN, 0 },
+    };
+    assert(vfs_poll(w, 3, 0) == 2);
+    assert(w[0].revents == VFS_POLLOUT && w[1].revents == VFS_POLLOUT && !w[2].revents);
+    vfs_pollfd_t bad = { VFS_MAX_FDS + 1, VFS_POLLIN, 0 };
+    assert(vfs_poll(&bad, 1, 0) == 1 && bad.revents == VFS_POLLNVAL);
+    assert(vfs_poll(NULL, 1, 0) == -1);
+
+    /* Nothing to read: times out */
+    vfs_pollfd_t r[2] = { { pfd[0], VFS_POLLIN, 0 }, { tfd, VFS_POLLIN, 0 } };
+    uint32_t t0 = nk_ticks();
+    assert(vfs_poll(r, 2, 10) == 0);
+    assert(nk_ticks() - t0 >= 10);
+
+    /* Both sources turn ready together: one wake-up sees both */
+    run_child(feeder);
+    t0 = nk_ticks();
+    assert(vfs_poll(r, 2, VFS_POLL_FOREVER) == 2);
+    assert(nk_ticks() - t0 < 500);
+    assert(r[0].revents == VFS_POLLIN && r[1].revents == VFS_POLLIN);
+    reap_child();
+
+    char c;
+    assert(vfs_read(pfd[0], &c, 1) == 1 && c == 'x');
+    assert(vfs_read(tfd, &c, 1) == 1 && c == 'y');
+    assert(vfs_poll(r, 2, 0) == 0);
+
+    /* Closing the write end is a hang-up the reader sees */
+    run_child(closer);
+    assert(vfs_poll(r, 1, 1000) == 1);
+    assert(r[0].revents == (VFS_POLLIN | VFS_POLLHUP));
+    reap_child();
+
+    assert(vfs_close(pfd[0]) == 0);
+    assert(vfs_close(tfd) == 0);
+}
+
+static void main_task(void)
+{
+    event_group();
+    poll_fds();
+    printf("poll_test: ok\n");
+    exit(0);
+}
+
+int main(void)
+{
+    nk_sched_init();
+    assert(nk_task_create(&tm, main_task, 1, sm, sizeof(sm)));
+    nk_sched_run();
+    return 1;
+}
@@ -0,0 +1,142 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Counters as files (drivers/fs/procfs.c) read through the VFS: the
+ * root listing, windowed reads, sizes and files added by the caller */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "drivers/fs/vfs.h"
+#include "drivers/fs/procfs.h"
+#include "kernel/sched/scheduler.h"
+#if CONFIG_TTY_ENABLED
+#  include "drivers/tty/tty.h"
+#endif
+
+#define STACK 4096
+
+static nk_tcb_t t0, t1;
+static uint8_t  s0[STACK], s1[STACK];
+
+static void idle_task(void) { for (;;) nk_yield(); }
+
+static char buf[512];
+
+/* Whole file as one read, NUL-terminated in buf */
+static int slurp(const char *path)
+{
+    int fd = vfs_open(path, O_RDONLY);
+    assert(fd >= 0);
+    int n = vfs_read(fd, buf, sizeof buf - 1);
+    assert(n >= 0 && n < (int)sizeof buf - 1);
+    buf[n] = '\0';
+    assert(vfs_read(fd, buf + n, 8) == 0);          /* and then EOF */
+    vfs_close(fd);
+    return n;
+}
+
+static unsigned shows;
+
+static void show_answer(procfs_out_t *o, const void *arg)
+{
+    shows++;
+    procfs_kv(o, "answer", *(const uint32_t *)arg);
+}
+
+/* Longer than any window below */
+static void show_long(procfs_out_t *o, const void *arg)
+{
+    (void)arg;
+    for (uint32_t i = 0; i < 100; i++) procfs_kv(o, "line", i);
+}
+
+int main(void)
+{
+    nk_sched_init();
+    assert(nk_task_create(&t0, idle_task, 2, s0, STACK));
+    assert(nk_task_create(&t1, idle_task, 7, s1, STACK));
+
+    vfs_init();
+    assert(vfs_mount(VFS_TYPE_PROCFS, "/proc") == 0);
+
+    /* the root lists what is there */
+    slurp("/proc");
+    assert(strstr(buf, "sched\n") && strstr(buf, "vfs\n"));
+    assert(!strstr(buf, "answer"));
+    assert(vfs_open("/proc/nope", O_RDONLY) == -1);
+
+    /* one row per task under the header */
+    slurp("/proc/sched");
+    assert(strncmp(buf, "ticks ", 6) == 0);
+    char *rows = strstr(buf, "tid prio run vol invol stack\n");
+    assert(rows);
+    unsigned tid, prio;
+    rows = strchr(rows, '\n') + 1;
+    assert(sscanf(rows, "%u %u", &tid, &prio) == 2 && tid == 0 && prio == 2);
+    rows = strchr(rows, '\n') + 1;
+    assert(sscanf(rows, "%u %u", &tid, &prio) == 2 && tid == 1 && prio == 7);
+    assert(*strchr(rows, '\n') == '\n' && strchr(rows, '\n')[1] == '\0');
+
+    /* counts the descriptor reading it */
+    slurp("/proc/vfs");
+    assert(strstr(buf, "mounts 1\n") && strstr(buf, "fds 1\n"));
+
+    /* added files; names are unique and slots limited */
+    static const uint32_t answer = 42;
+    assert(procfs_add("answer", show_answer, &answer) == 0);
+    assert(procfs_add("answer", show_answer, &answer) == -1);
+    assert(procfs_add("sched", show_answer, &answer) == -1);
+    assert(procfs_add("a/b", show_answer, &answer) == -1);
+    assert(procfs_add("long", show_long, NULL) == 0);
+    for (int i = 2; i < PROCFS_ENTRIES; i++) {
+        static char names[PROCFS_ENTRIES][4];
+        snprintf(names[i], sizeof names[i], "x%d", i);
+        assert(procfs_add(names[i], show_answer, &answer) == 0);
+    }
+    assert(procfs_add("full", show_answer, &answer) == -1);
+    assert(slurp("/proc/answer") == 10 && strcmp(buf, "answer 42\n") == 0);
+    slurp("/proc/");
+    assert(strstr(buf, "answer\nlong\n"));
+
+    /* small reads in sequence give the same bytes as one large read */
+    int fd = vfs_open("/proc/long", O_RDONLY);
+    vfs_stat_t st;
+    assert(fd >= 0 && vfs_fstat(fd, &st) == 0);
+    char whole[1024];
+    uint16_t len = 0;
+    int n;
+    while ((n = vfs_read(fd, whole + len, 7)) > 0) len = (uint16_t)(len + n);
+    assert(len == st.size && len == 100 * 6 + 10 * 1 + 90 * 2);
+    assert(memcmp(whole, "line 0\nline 1\n", 14) == 0);
+    assert(memcmp(whole + len - 8, "line 99\n", 8) == 0);
+    assert(vfs_lseek(fd, -8, SEEK_END) == len - 8);
+    assert(vfs_read(fd, buf, 3) == 3 && memcmp(buf, "lin", 3) == 0);
+    assert(vfs_write(fd, "x", 1) == -1);
+    vfs_close(fd);
+    fd = vfs_open("/proc/long", O_RDWR);
+    assert(fd >= 0 && vfs_write(fd, "x", 1) == -1);
+    vfs_close(fd);
+
+    /* every read prints the file again */
+    shows = 0;
+    fd = vfs_open("/proc/answer", O_RDONLY);
+    assert(vfs_read(fd, buf, 4) == 4 && vfs_read(fd, buf, 64) == 6 && shows == 2);
+    vfs_close(fd);
+
+#if CONFIG_TTY_ENABLED
+    static tty_t tty;
+    static uint8_t rx[32], tx[32];
+    tty_init_irq(&tty, rx, tx, sizeof rx, NULL);
+    for (uint8_t c = 0; c < 5; c++) tty_rx_isr(&tty, c);
+    procfs_out_t o = { (uint8_t *)buf, 0, sizeof buf - 1, 0 };
+    procfs_show_tty(&o, &tty);
+    buf[o.pos] = '\0';
+    assert(strstr(buf, "rx_avail 5\n") && strstr(buf, "tx_free "));
+#endif
+
+    printf("procfs: ok (%u bytes of /proc/long in 7-byte reads)\n", (unsigned)len);
+    return 0;
+}
@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* PC-sampling profile histogram (kernel/sync/nk_prof.c)
+ *
+ * With a file argument the final image is written there, for feeding
+ * scripts/prof_fold.py by hand. */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NK_PROF 1
+#define NK_PROF_BINS 16
+#define NK_PROF_TEXT_END 0x8000u
+
+#include "../kernel/sync/nk_prof.c"
+
+int main(int argc, char **argv)
+{
+    /* Whole flash: 32 KB over 16 buckets is 2 KB each */
+    nk_prof_range(0, 0);
+    assert(nk_prof_buf.magic == NK_PROF_MAGIC);
+    assert(nk_prof_buf.version == NK_PROF_VERSION);
+    assert(nk_prof_buf.bins == NK_PROF_BINS);
+    assert(nk_prof_buf.base == 0 && nk_prof_buf.shift == 11);
+
+    /* An exact fit and one byte over it */
+    nk_prof_range(0x1000, 0x1010);
+    assert(nk_prof_buf.shift == 0);
+    nk_prof_range(0x1000, 0x1011);
+    assert(nk_prof_buf.shift == 1);
+
+    nk_prof_range(0x1000, 0x1100);      /* 16-byte buckets */
+    assert(nk_prof_buf.shift == 4);
+    nk_prof_hit(0x1000);
+    nk_prof_hit(0x100F);
+    nk_prof_hit(0x1010);
+    nk_prof_hit(0x10FF);
+    nk_prof_hit(0x0FFF);                /* Below and above the range */
+    nk_prof_hit(0x1100);
+    assert(nk_prof_buf.count[0] == 2);
+    assert(nk_prof_buf.count[1] == 1);
+    assert(nk_prof_buf.count[15] == 1);
+    assert(nk_prof_buf.samples == 6 && nk_prof_buf.outside == 2);
+
+    /* Counters stop at the top instead of wrapping */
+    nk_prof_buf.count[3] = UINT16_MAX - 1;
+    nk_prof_hit(0x1030);
+    nk_prof_hit(0x1030);
+    assert(nk_prof_buf.count[3] == UINT16_MAX);
+
+    /* A new range starts from a clean histogram */
+    nk_prof_range(0x1000, 0x1100);
+    assert(nk_prof_buf.samples == 0 && nk_prof_buf.count[0] == 0);
+
+    /* No profiling timer on the host */
+    assert(!nk_prof_start(997));
+    nk_prof_stop();
+    assert(nk_prof_buf.hz == 0);
+
+    size_t len;
+    const void *img = nk_prof_image(&len);
+    assert(img == &nk_prof_buf);
+    assert(len == 24 + NK_PROF_BINS * sizeof(uint16_t));
+
+    if (argc > 1) {
+        nk_prof_range(0, 0);
+        for (uint32_t i = 0; i < 300; i++) {
+            nk_prof_hit(0x0100 + (i % 3) * 0x40);
+        }
+        for (uint32_t i = 0; i < 100; i++) {
+            nk_prof_hit(0x2800);
+        }
+        nk_prof_buf.hz = 997;
+        FILE *f = fopen(argv[1], "wb");
+        assert(f && fwrite(img, 1, len, f) == len);
+        fclose(f);
+    }
+    printf("prof_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,181 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Protothreads: sleeps, yields, condition and TTY waits on one runner task */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arch/common/hal.h"
+#include "kernel/sched/scheduler.h"
+#include "kernel/sched/nk_pt.h"
+#include "drivers/tty/tty.h"
+
+
+static nk_tcb_t tm, tr;
+static uint8_t  sm[HAL_HOST_STACK], sr[HAL_HOST_STACK];
+
+/* State that must survive a wait lives beside the nk_pt_t */
+typedef struct {
+    nk_pt_t  pt;
+    uint8_t  i;
+    uint32_t at[3];
+} sleeper_t;
+
+typedef struct {
+    nk_pt_t pt;
+    uint8_t i;
+    char    tag;
+} yielder_t;
+
+static sleeper_t slp;
+static yielder_t ya = { .tag = 'a' }, yb = { .tag = 'b' };
+static nk_pt_t   waiter, timer, reader;
+
+static char     trail[8];
+static uint8_t  trail_len;
+static volatile uint8_t flag;
+static uint8_t  waited, timed_out;
+static uint8_t  got;
+
+static tty_t    tty;
+static uint8_t  rx_buf[16], tx_buf[16];
+
+static void kick(void) {}
+
+static int8_t sleeper_fn(nk_pt_t *pt)
+{
+    sleeper_t *s = (sleeper_t *)pt;
+    PT_BEGIN(pt);
+    for (s->i = 0; s->i < 3; s->i++) {
+        PT_SLEEP(pt, 10);
+        s->at[s->i] = nk_ticks();
+    }
+    PT_END(pt);
+}
+
+static int8_t yielder_fn(nk_pt_t *pt)
+{
+    yielder_t *y = (yielder_t *)pt;
+    PT_BEGIN(pt);
+    for (y->i = 0; y->i < 3; y->i++) {
+        trail[trail_len++] = y->tag;
+        PT_YIELD(pt);
+    }
+    PT_END(pt);
+}
+
+static int8_t waiter_fn(nk_pt_t *pt)
+{
+    PT_BEGIN(pt);
+    PT_WAIT_UNTIL(pt, flag);
+    waited = 1;
+    PT_END(pt);
+}
+
+static int8_t timer_fn(nk_pt_t *pt)
+{
+    PT_BEGIN(pt);
+    PT_WAIT_TIMEOUT(pt, flag == 2, 20);
+    timed_out = flag != 2;
+    PT_EXIT(pt);
+    timed_out = 0;                      /* not reached */
+    PT_END(pt);
+}
+
+static int8_t reader_fn(nk_pt_t *pt)
+{
+    PT_BEGIN(pt);
+    PT_AWAIT_TTY_RX(pt, &tty);
+    assert(tty_read(&tty, &got, 1) == 1);
+    PT_END(pt);
+}
+
+static void sleeps(void)
+{
+    uint32_t t0 = nk_ticks();
+    assert(nk_pt_spawn(&slp.pt, sleeper_fn));
+    assert(!nk_pt_spawn(&slp.pt, sleeper_fn));  /* still live */
+    assert(nk_pt_running(&slp.pt));
+    nk_sleep(100);
+    assert(!nk_pt_running(&slp.pt));
+    assert(slp.i == 3);
+    assert(slp.at[0] - t0 >= 10);
+    assert(slp.at[1] - slp.at[0] >= 10 && slp.at[2] - slp.at[1] >= 10);
+    assert(nk_pt_next() == UINT16_MAX);
+}
+
+static void yields(void)
+{
+    assert(nk_pt_spawn(&ya.pt, yielder_fn));
+    assert(nk_pt_spawn(&yb.pt, yielder_fn));
+    nk_sleep(20);
+    assert(!nk_pt_running(&ya.pt) && !nk_pt_running(&yb.pt));
+    assert(trail_len == 6);
+    for (uint8_t i = 1; i < trail_len; i++) {
+        assert(trail[i] != trail[i - 1]);       /* each yield lets the other in */
+    }
+}
+
+static void conditions(void)
+{
+    /* A condition changed by a task; nk_pt_wake() gets it re-tested */
+    assert(nk_pt_spawn(&waiter, waiter_fn));
+    assert(nk_pt_spawn(&timer, timer_fn));
+    nk_sleep(5);
+    assert(!waited && nk_pt_running(&waiter));
+    flag = 1;
+    nk_pt_wake();
+    nk_sleep(5);
+    assert(waited && !nk_pt_running(&waiter));
+
+    /* The other condition never holds: the deadline ends the wait */
+    nk_sleep(40);
+    assert(timed_out && !nk_pt_running(&timer));
+
+    /* Exited blocks can be spawned again */
+    flag = 2;
+    timed_out = 0;
+    assert(nk_pt_spawn(&timer, timer_fn));
+    nk_sleep(5);
+    assert(!timed_out && !nk_pt_running(&timer));
+}
+
+static void tty_wait(void)
+{
+    tty_init_irq(&tty, rx_buf, tx_buf, sizeof(rx_buf), kick);
+    assert(nk_pt_spawn(&reader, reader_fn));
+    nk_sleep(5);
+    assert(nk_pt_running(&reader));
+
+    uint32_t s = nk_sched_lock();
+    assert(tty_rx_isr(&tty, 'z'));
+    nk_sched_unlock(s);
+    nk_sleep(5);
+    assert(!nk_pt_running(&reader) && got == 'z');
+}
+
+static void main_task(void)
+{
+    assert(!nk_pt_spawn(NULL, waiter_fn));
+    assert(!nk_pt_spawn(&waiter, NULL));
+    assert(nk_task_create(&tr, nk_pt_task, 2, sr, HAL_HOST_STACK));
+
+    sleeps();
+    yields();
+    conditions();
+    tty_wait();
+    printf("pt_test: ok\n");
+    exit(0);
+}
+
+int main(void)
+{
+    nk_sched_init();
+    assert(nk_task_create(&tm, main_task, 1, sm, sizeof(sm)));
+    nk_sched_run();
+    return 1;
+}
@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* ROMFS lookup in large sorted and unsorted directories (drivers/fs/romfs.c) */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../drivers/fs/romfs.h"
+
+#define NFILES 300
+
+/* Built at startup; romfs.c only ever reads the tables */
+static char          names[NFILES][8];
+static uint8_t       data[NFILES];
+static romfs_file_t  file_table[NFILES + 1];
+static romfs_entry_t big_entries[NFILES];      /* sorted: f000..f299 */
+static romfs_entry_t mixed_entries[NFILES];    /* same names, shuffled */
+static const char    long_name[] = "a-name-longer-than-eleven-bytes.txt";
+static const char    sub_name[] = "sub";
+static const char    mixed_name[] = "z-mixed";
+
+static romfs_entry_t root_entries[3] = {
+    { long_name, ROMFS_FILE, NFILES },
+    { sub_name, ROMFS_DIR, 0 },
+    { mixed_name, ROMFS_DIR, 1 },
+};
+
+static romfs_dir_t dir_table[] = {
+    { big_entries, NFILES, ROMFS_DIR_SORTED },  /* 0: /sub/ */
+    { mixed_entries, NFILES, 0 },               /* 1: /z-mixed/ (linear) */
+    { root_entries, 3, ROMFS_DIR_SORTED },      /* 2: / */
+};
+
+#define ROMFS_ROOT (&dir_table[2])
+#include "../drivers/fs/romfs.c"
+
+static void build(void)
+{
+    for (uint16_t i = 0; i < NFILES; ++i) {
+        snprintf(names[i], sizeof names[i], "f%03u", (unsigned)i);
+        data[i] = (uint8_t)i;
+        file_table[i] = (romfs_file_t){ &data[i], 1, 0 };
+        big_entries[i] = (romfs_entry_t){ names[i], ROMFS_FILE, i };
+        uint16_t j = (uint16_t)((i * 7u) % NFILES);   /* 7 is coprime to 300 */
+        mixed_entries[i] = (romfs_entry_t){ names[j], ROMFS_FILE, j };
+    }
+    file_table[NFILES] = (romfs_file_t){ (const uint8_t *)"long", 4, 0 };
+}
+
+static int byte_at(const char *path)
+{
+    const romfs_file_t *f = romfs_open(path);
+    uint8_t b;
+    if (!f || romfs_read(f, 0, &b, 1) != 1) return -1;
+    return b;
+}
+
+int main(void)
+{
+    build();
+
+    char path[32];
+    for (unsigned i = 0; i < NFILES; ++i) {
+        snprintf(path, sizeof path, "/sub/f%03u", i);
+        assert(byte_at(path) == (int)(i & 0xFF));
+        snprintf(path, sizeof path, "/z-mixed/f%03u", i);
+        assert(byte_at(path) == (int)(i & 0xFF));
+    }
+
+    /* Misses on either side of and between sorted entries */
+    assert(!romfs_open("/sub/f"));
+    assert(!romfs_open("/sub/a"));
+    assert(!romfs_open("/sub/f0000"));
+    assert(!romfs_open("/sub/f300"));
+    assert(!romfs_open("/sub/g"));
+    assert(!romfs_open("/z-mixed/f3000"));
+
+    /* Names longer than the old 11-byte segment limit */
+    const romfs_file_t *f = romfs_open("/a-name-longer-than-eleven-bytes.txt");
+    assert(f && f->size == 4);
+    assert(!romfs_open("/a-name-longer-than-eleven"));
+
+    /* Directories are not files; files are not directories */
+    assert(!romfs_open("/sub"));
+    assert(!romfs_open("/sub/"));
+    assert(!romfs_open("/sub/f001/x"));
+    assert(romfs_open("//sub//f001") == &file_table[1]);
+
+    printf("romfs index: %d files per directory\n", NFILES);
+    return 0;
+}
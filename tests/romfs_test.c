@@ -20,6 +20,13 @@ int main(void)
     n = romfs_read(f, out_of_bounds_offset, buf, sizeof buf - 1);
     assert(n == 0);
 
+    // Vectored read: one file over several buffers, short at EOF
+    char v1[2] = {0}, v2[8] = {0};
+    const vfs_iovec_t iov[] = { { v1, sizeof v1 }, { NULL, 0 }, { v2, sizeof v2 } };
+    n = romfs_readv(f, 0, iov, 3);
+    assert(n == 4 && memcmp(v1, "1.", 2) == 0 && memcmp(v2, "0\n", 2) == 0);
+    assert(romfs_readv(f, 4, iov, 3) == 0);
+
     // Negative test cases for romfs_open
     const romfs_file_t *nf1 = romfs_open("/etc/config/does_not_exist.txt");
     assert(nf1 == NULL);
@@ -32,7 +39,11 @@ int main(void)
     assert(ef);
     char b2[12] = {0};
     int n2 = eepfs_read(ef, 0, b2, sizeof b2 - 1);
+#if CONFIG_FS_EEPFS_WEAR_LEVELING
+    assert(n2 == (int)eepfs_size(ef));  /* unformatted log: empty */
+#else
     assert(n2 > 0);
+#endif
     printf("eepfs:%s\n", b2);
 #endif
 
@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Sequence locks and reader-writer locks (kernel/sync) under host threads */
+
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#define NK_SPIN_RELAX() sched_yield()  /* threads may share one CPU */
+#include "kernel/sync/seqlock.h"
+#include "kernel/sync/rwlock.h"
+
+#define READERS 3
+#define ROUNDS  5000
+
+/* Writers keep a == b; readers must never see them differ */
+static nk_seqlock_t sl = NK_SEQLOCK_STATIC_INIT;
+static volatile uint32_t sa, sb;
+
+static nk_rwlock_t rw = NK_RWLOCK_STATIC_INIT;
+static volatile uint32_t ra, rb;
+static volatile int readers_in, max_readers;
+
+static void *seq_reader(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < ROUNDS; ++i) {
+        uint32_t a, b;
+        nk_seq_t seq;
+        do {
+            seq = nk_seq_read_begin(&sl);
+            a = sa;
+            b = sb;
+        } while (nk_seq_read_retry(&sl, seq));
+        assert(a == b);
+    }
+    return NULL;
+}
+
+static void *rw_reader(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < ROUNDS; ++i) {
+        nk_rwlock_read_lock(&rw);
+        int n = __atomic_add_fetch(&readers_in, 1, __ATOMIC_SEQ_CST);
+        if (n > max_readers) max_readers = n;
+        assert(ra == rb);
+        sched_yield();
+        __atomic_sub_fetch(&readers_in, 1, __ATOMIC_SEQ_CST);
+        nk_rwlock_read_unlock(&rw);
+    }
+    return NULL;
+}
+
+static void *writer(void *arg)
+{
+    (void)arg;
+    for (int i = 0; i < ROUNDS; ++i) {
+        nk_seq_write_lock(&sl);
+        sa = sa + 1;
+        sched_yield();
+        sb = sb + 1;
+        nk_seq_write_unlock(&sl);
+
+        nk_rwlock_write_lock(&rw);
+        assert(readers_in == 0);
+        ra = ra + 1;
+        sched_yield();
+        rb = rb + 1;
+        nk_rwlock_write_unlock(&rw);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    /* Sequence lock: odd while writing, retry after a write */
+    nk_seq_t s0 = nk_seq_read_begin(&sl);
+    assert(!nk_seq_read_retry(&sl, s0));
+    nk_seq_write_lock(&sl);
+    assert(sl.seq & 1u);
+    nk_seq_write_unlock(&sl);
+    assert(nk_seq_read_retry(&sl, s0));
+
+    /* RW lock: readers share, writers exclude */
+    assert(nk_rwlock_read_trylock(&rw) && nk_rwlock_read_trylock(&rw));
+    assert(!nk_rwlock_write_trylock(&rw));
+    nk_rwlock_read_unlock(&rw);
+    nk_rwlock_read_unlock(&rw);
+    assert(nk_rwlock_write_trylock(&rw));
+    assert(!nk_rwlock_read_trylock(&rw) && !nk_rwlock_write_trylock(&rw));
+    nk_rwlock_write_unlock(&rw);
+    assert(rw.state == 0u);
+
+    /* A waiting writer holds off new readers */
+    rw.state = NK_RW_WAIT_ONE;
+    assert(!nk_rwlock_read_trylock(&rw));
+    nk_rwlock_init(&rw);
+
+    pthread_t t[2 * READERS + 2];
+    int n = 0;
+    for (int i = 0; i < READERS; ++i) {
+        assert(pthread_create(&t[n++], NULL, seq_reader, NULL) == 0);
+        assert(pthread_create(&t[n++], NULL, rw_reader, NULL) == 0);
+    }
+    assert(pthread_create(&t[n++], NULL, writer, NULL) == 0);
+    assert(pthread_create(&t[n++], NULL, writer, NULL) == 0);
+    for (int i = 0; i < n; ++i) {
+        pthread_join(t[i], NULL);
+    }
+
+    assert(sa == 2u * ROUNDS && sb == sa && !(sl.seq & 1u));
+    assert(ra == 2u * ROUNDS && rb == ra && rw.state == 0u);
+
+    printf("seqlock/rwlock: %u writes, up to %d concurrent readers\n",
+           (unsigned)sa, max_readers);
+    return 0;
+}
@@ -0,0 +1,107 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* NK_SCHED_FIFO: no slicing among equals, still preempted by the more urgent */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arch/common/hal.h"
+#include "kernel/sched/scheduler.h"
+
+#define RUN_MS  60          /* six default slices */
+
+static nk_tcb_t tm, th, tw[2];
+static uint8_t  sm[HAL_HOST_STACK], sh[HAL_HOST_STACK], sw[2][HAL_HOST_STACK];
+
+static volatile uint8_t  started[2], overlap[2];
+static volatile uint8_t  done;
+static volatile uint32_t wakeups;
+
+/* Never yields; notes whether its peer got the CPU before it finished */
+static void worker(uint8_t me)
+{
+    started[me] = 1;
+    hal_timer_delay_ms(RUN_MS);
+    overlap[me] = started[!me];
+    nk_task_exit(0);
+}
+
+static void worker0(void) { worker(0); }
+static void worker1(void) { worker(1); }
+
+/* More urgent than the workers: must get in whatever their policy */
+static void ticker(void)
+{
+    while (!done) {
+        nk_sleep(5);
+        wakeups++;
+    }
+    nk_task_exit(0);
+}
+
+static void run_pair(uint8_t policy)
+{
+    static void (*const fn[2])(void) = { worker0, worker1 };
+    uint8_t tid[2];
+
+    started[0] = started[1] = 0;
+    done = 0;
+    wakeups = 0;
+    assert(nk_task_create(&th, ticker, 3, sh, HAL_HOST_STACK));
+    for (uint8_t i = 0; i < 2; i++) {
+        assert(nk_task_create(&tw[i], fn[i], 5, sw[i], HAL_HOST_STACK));
+        tid[i] = tw[i].pid;
+        assert(nk_task_set_policy(tid[i], policy));
+        assert(nk_task_policy(tid[i]) == policy);
+    }
+    assert(nk_task_wait(tid[0]) == 0);
+    assert(nk_task_wait(tid[1]) == 0);
+    done = 1;
+    assert(nk_task_wait(th.pid) == 0);
+    nk_task_release(th.pid);
+    nk_task_release(tid[0]);
+    nk_task_release(tid[1]);
+}
+
+static void main_task(void)
+{
+    uint8_t self = nk_current_tid();
+
+    assert(nk_task_policy(self) == NK_SCHED_RR);
+    assert(!nk_task_set_policy(self, 7));
+    assert(!nk_task_set_policy(0xFE, NK_SCHED_FIFO));
+    assert(nk_task_policy(0xFE) == 0xFF);
+
+    /* Priority changes stick, and do not undo an inherited boost */
+    assert(nk_task_set_priority(self, 2));
+    assert(nk_task_priority(self) == 2);
+    nk_task_boost(self, 0);
+    assert(nk_task_set_priority(self, 1));
+    assert(nk_task_priority(self) == 0);
+    nk_task_unboost(self);
+    assert(nk_task_priority(self) == 1);
+    assert(!nk_task_set_priority(0xFE, 1));
+
+    /* Round-robin: the slice hands the CPU to the peer mid-run */
+    run_pair(NK_SCHED_RR);
+    assert(overlap[0] && overlap[1]);
+
+    /* FIFO: the first to run finishes before the other starts */
+    run_pair(NK_SCHED_FIFO);
+    assert(overlap[0] != overlap[1]);
+    assert(wakeups >= RUN_MS / 5);      /* every 5 ticks, not every slice */
+
+    printf("sched_policy_test: ok\n");
+    exit(0);
+}
+
+int main(void)
+{
+    nk_sched_init();
+    assert(nk_task_create(&tm, main_task, 1, sm, sizeof(sm)));
+    nk_sched_run();
+    return 1;
+}
@@ -0,0 +1,151 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* nk_sig_*: pending/blocked masks, early wake-up and delivery points */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arch/common/hal.h"
+#include "kernel/sched/scheduler.h"
+
+
+#define SIG_A   10
+#define SIG_B   12
+
+static nk_tcb_t tm, tc;
+static uint8_t  sm[HAL_HOST_STACK], sc[HAL_HOST_STACK];
+
+static volatile uint32_t hits;
+static volatile uint8_t  last_sig, last_tid;
+static volatile uint8_t  phase;
+
+static void on_signal(uint8_t sig)
+{
+    last_sig = sig;
+    last_tid = nk_current_tid();
+    hits++;
+}
+
+/* Inherits the creator's mask, then naps until a signal cuts it short */
+static void sleeper(void)
+{
+    assert(nk_sig_blocked() == NK_SIG_BIT(SIG_B));
+    nk_sig_setmask(0);
+    uint32_t t0 = nk_ticks();
+    phase = 1;
+    nk_sleep(60000);
+    assert(nk_ticks() - t0 < 1000);
+    assert(last_tid == nk_current_tid() && last_sig == SIG_A);
+    nk_task_exit(0);
+}
+
+/* Never enters the scheduler itself: only the tick can deliver */
+static void spinner(void)
+{
+    uint32_t before = hits;
+    phase = 1;
+    while (hits == before) {}
+    assert(last_tid == nk_current_tid());
+    nk_task_exit(0);
+}
+
+/* A blocked signal does not end the wait; an unblocked one does */
+static void suspender(void)
+{
+    nk_sig_setmask(NK_SIG_BIT(SIG_A));
+    phase = 1;
+    assert(nk_sig_suspend(NK_SIG_BIT(SIG_B)) == 0);
+    assert(last_tid == nk_current_tid() && last_sig == SIG_A);
+    assert(nk_sig_blocked() == NK_SIG_BIT(SIG_A));
+    assert(nk_sig_pending() == NK_SIG_BIT(SIG_B));
+    nk_task_exit(0);
+}
+
+static void run_child(void (*fn)(void), void (*poke)(uint8_t tid))
+{
+    phase = 0;
+    assert(nk_task_create(&tc, fn, 2, sc, HAL_HOST_STACK));
+    uint8_t tid = tc.pid;
+    while (!phase) nk_sleep(1);
+    poke(tid);
+    assert(nk_task_wait(tid) == 0);
+    nk_task_release(tid);
+}
+
+static void poke_a(uint8_t tid)
+{
+    nk_sleep(2);
+    assert(nk_sig_post(tid, SIG_A) == 0);
+}
+
+static void poke_b_then_a(uint8_t tid)
+{
+    uint32_t before = hits;
+    assert(nk_sig_post(tid, SIG_B) == 0);
+    nk_sleep(5);
+    assert(hits == before);
+    assert(nk_sig_post(tid, SIG_A) == 0);
+}
+
+static void main_task(void)
+{
+    uint8_t self = nk_current_tid();
+
+    /* Bad arguments; signal 0 is an existence check */
+    assert(nk_sig_post(self, NK_SIG_MAX + 1) == -1);
+    assert(nk_sig_post(0xFE, SIG_A) == -1);
+    assert(nk_sig_post(self, 0) == 0);
+    assert(nk_sig_pending() == 0);
+
+    /* Posting to yourself only marks it; delivery runs the dispatcher */
+    assert(nk_sig_post(self, SIG_A) == 0);
+    assert(nk_sig_pending() == NK_SIG_BIT(SIG_A));
+    nk_sig_deliver();
+    assert(hits == 1 && last_sig == SIG_A && last_tid == self);
+    assert(nk_sig_pending() == 0);
+
+    /* Blocked until unmasked, and only once however often it was sent */
+    nk_sig_setmask(NK_SIG_BIT(SIG_B));
+    assert(nk_sig_post(self, SIG_B) == 0);
+    assert(nk_sig_post(self, SIG_B) == 0);
+    nk_sig_deliver();
+    nk_sleep(2);
+    assert(hits == 1);
+    assert(nk_sig_setmask(0) == NK_SIG_BIT(SIG_B));
+    nk_sig_deliver();
+    assert(hits == 2 && last_sig == SIG_B);
+
+    /* Lowest number first */
+    nk_sig_setmask(~(nk_sigset_t)0);
+    assert(nk_sig_post(self, SIG_B) == 0);
+    assert(nk_sig_post(self, SIG_A) == 0);
+    nk_sig_setmask(NK_SIG_BIT(SIG_B));
+    nk_sig_deliver();
+    assert(hits == 3 && last_sig == SIG_A);
+    nk_sig_setmask(0);
+    nk_sig_deliver();
+    assert(hits == 4 && last_sig == SIG_B);
+
+    /* The child starts with SIG_B blocked */
+    nk_sig_setmask(NK_SIG_BIT(SIG_B));
+    run_child(sleeper, poke_a);
+    nk_sig_setmask(0);
+
+    run_child(spinner, poke_a);
+    run_child(suspender, poke_b_then_a);
+
+    printf("signal_test: ok (%u deliveries)\n", (unsigned)hits);
+    exit(0);
+}
+
+int main(void)
+{
+    nk_sched_init();
+    nk_sig_dispatch(on_signal);
+    assert(nk_task_create(&tm, main_task, 1, sm, sizeof(sm)));
+    nk_sched_run();
+    return 1;
+}
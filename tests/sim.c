@@ -1,5 +1,5 @@
 #include <stdint.h>
 
-/* Simulated hardware memory for host-side testing (provided by avr_stub.c) */
+/* Simulated hardware memory for host-side testing (provided by avr_stub.c);
+ * the EEPROM is the host HAL's image (arch/common/hal_host_nvm.c) */
 extern uint8_t nk_sim_io[0x40];
-extern uint8_t nk_sim_eeprom[1024];
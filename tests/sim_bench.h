@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Shared helpers for the simavr benchmarks (sim_bench_*.c)
+ *
+ * Each result is one line on UART0, `bench <name> <cycles> <unit>`,
+ * cycles being hal_cycles() per <unit> with the cost of reading the
+ * counter taken off.  `bench done` ends the run; scripts/sim_bench.py
+ * turns the lines into JSON.  Built for the host the same lines go to
+ * stdout, which keeps the loops testable without a simulator.
+ */
+
+#ifndef TESTS_SIM_BENCH_H
+#define TESTS_SIM_BENCH_H
+
+#include <stdint.h>
+#include "arch/common/hal.h"
+
+#ifdef __AVR__
+#  include <avr/io.h>
+#  include <avr/interrupt.h>
+#  include <avr/sleep.h>
+#else
+#  include <stdio.h>
+#  include <stdlib.h>
+#endif
+
+/** Iterations per measurement; the best of BENCH_PASSES is reported */
+#ifndef BENCH_N
+#  define BENCH_N 64u
+#endif
+#define BENCH_PASSES 3u
+
+static uint32_t bench_overhead;     /* Cycles of an empty t0/t1 pair */
+
+static void bench_putc(char c)
+{
+#ifdef __AVR__
+    while (!(UCSR0A & (1 << UDRE0))) {
+    }
+    UDR0 = (uint8_t)c;
+#else
+    putchar(c);
+#endif
+}
+
+static void bench_puts(const char *s)
+{
+    while (*s) {
+        bench_putc(*s++);
+    }
+}
+
+static void bench_putu(uint32_t v)
+{
+    char d[10];
+    uint8_t n = 0;
+    do {
+        d[n++] = (char)('0' + v % 10u);
+        v /= 10u;
+    } while (v);
+    while (n) {
+        bench_putc(d[--n]);
+    }
+}
+
+/* Start the cycle counter and console, measure the counter's own cost */
+static void bench_init(void)
+{
+#ifdef __AVR__
+    hal_init();                         /* Timer1 behind hal_cycles() */
+    sei();
+    UBRR0H = 0;
+    UBRR0L = (uint8_t)(F_CPU / 16u / 115200u - 1u);
+    UCSR0B = (1 << TXEN0);
+    UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+#endif
+    bench_overhead = UINT32_MAX;
+    for (uint8_t i = 0; i < 8; i++) {
+        uint32_t t0 = hal_cycles();
+        uint32_t dt = hal_cycles() - t0;
+        if (dt < bench_overhead) bench_overhead = dt;
+    }
+}
+
+/* Report @p best cycles, taken over @p ops operations, per operation */
+static void bench_report(const char *name, uint32_t best, uint32_t ops,
+                         const char *unit)
+{
+    best = best > bench_overhead ? best - bench_overhead : 0;
+    bench_puts("bench ");
+    bench_puts(name);
+    bench_putc(' ');
+    bench_putu((best + ops / 2u) / ops);
+    bench_putc(' ');
+    bench_puts(unit);
+    bench_putc('\n');
+}
+
+/** Time `body` BENCH_N times per pass, each run being @p per units */
+#define BENCH_LOOP(name, unit, per, body)                                  \
+    do {                                                                   \
+        uint32_t best_ = UINT32_MAX;                                       \
+        for (uint8_t p_ = 0; p_ < BENCH_PASSES; p_++) {                    \
+            uint32_t t0_ = hal_cycles();                                   \
+            for (uint16_t i_ = 0; i_ < BENCH_N; i_++) {                    \
+                body;                                                      \
+            }                                                              \
+            uint32_t dt_ = hal_cycles() - t0_;                             \
+            if (dt_ < best_) best_ = dt_;                                  \
+        }                                                                  \
+        bench_report((name), best_, (uint32_t)BENCH_N * (per), (unit));     \
+    } while (0)
+
+/* Mark the end of the run and stop the simulator */
+static void bench_done(void)
+{
+    bench_puts("bench done\n");
+#ifdef __AVR__
+    cli();
+    sleep_enable();
+    sleep_cpu();                         /* simavr exits: asleep, IRQs off */
+#else
+    fflush(stdout);
+    exit(0);
+#endif
+}
+
+#endif /* TESTS_SIM_BENCH_H */
@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* door_call() round trips on the target (sim_bench.h)
+ *
+ * The scheduler is stubbed as in door_bench.c: switching to task 1
+ * runs the echo server inline, so the figures are the door path alone
+ * (claim, copy, CRC, donation).  A real call adds two ctx_switch
+ * results from sim_bench_kernel. */
+
+#include <stdint.h>
+
+#include "sim_bench.h"
+#include "../kernel/ipc/door.c"
+
+/*─── Stub scheduler: switching to task 1 runs the echo server ─────────*/
+static uint8_t current_tid;
+
+uint8_t nk_current_tid(void) { return current_tid; }
+void nk_yield(void) { }
+
+uint8_t nk_task_priority(uint8_t tid) { (void)tid; return 0; }
+void nk_task_boost(uint8_t tid, uint8_t prio) { (void)tid; (void)prio; }
+void nk_task_unboost(uint8_t tid) { (void)tid; }
+
+void nk_switch_to(uint8_t tid)
+{
+    current_tid = tid;
+    if (tid == 1) {
+        do {
+            uint8_t *m = (uint8_t *)door_message();
+            m[0]++;                  /* touch the request, reply in place */
+        } while (door_next());
+        door_return();
+    }
+}
+
+int main(void)
+{
+    static uint8_t msg[32];
+
+    bench_init();
+    door_register(0, 1, 1, 0);
+    door_register(1, 1, 4, 0);
+    door_register(2, 1, 4, DOOR_F_ZEROCOPY);
+    door_register(3, 1, 4, DOOR_F_CRC);
+
+    BENCH_LOOP("door_call_8", "call", 1, door_call(0, msg));
+    BENCH_LOOP("door_call_32", "call", 1, door_call(1, msg));
+    BENCH_LOOP("door_call_32_zerocopy", "call", 1, door_call(2, msg));
+    BENCH_LOOP("door_call_32_crc", "call", 1, door_call(3, msg));
+    bench_done();
+    return 0;
+}
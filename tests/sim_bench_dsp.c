@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Cycle counts of the fixed-point block kernels (fixed_point.h) against
+ * the per-sample q8_8_mul() loop they replace, and of the table-driven
+ * transcendentals (sim_bench.h) */
+
+#include <stdint.h>
+
+#include "sim_bench.h"
+#include "fixed_point.h"
+
+#define LEN  32u                        /* Block / tap count */
+
+static q15_t a[LEN], b[LEN], y[LEN];
+static q15_t delay[2 * LEN];
+static volatile int16_t sink;
+
+/* What callers did before the block kernels: one call per product */
+static q8_8_t dot_by_mul(const q8_8_t *x, const q8_8_t *k, uint16_t n)
+{
+    q8_8_t acc = 0;
+    while (n--) {
+        acc += q8_8_mul(*x++, *k++);
+    }
+    return acc;
+}
+
+int main(void)
+{
+    q15_fir_t fir;
+    q15_biquad_t bq = { { Q2_14(0.0125), Q2_14(0.025), Q2_14(0.0125),
+                          Q2_14(1.8), Q2_14(-0.85) }, { 0 } };
+
+    bench_init();
+    for (uint8_t i = 0; i < LEN; i++) {
+        a[i] = (q15_t)(i * 517 - 8000);
+        b[i] = (q15_t)(Q15(0.03) - i * 31);
+    }
+    q15_fir_init(&fir, b, delay, LEN);
+
+    BENCH_LOOP("q8_8_mul_loop", "tap", LEN, sink = dot_by_mul(a, b, LEN));
+    BENCH_LOOP("q8_8_dot", "tap", LEN, sink = q8_8_dot(a, b, LEN));
+    BENCH_LOOP("q15_dot", "tap", LEN, sink = q15_dot(a, b, LEN));
+    BENCH_LOOP("q15_fir", "tap", LEN, q15_fir(&fir, a, y, 1));
+    BENCH_LOOP("q15_biquad", "sample", LEN, q15_biquad(&bq, a, y, LEN));
+    BENCH_LOOP("q15_scale", "sample", LEN, q15_scale(a, Q15(0.7), y, LEN));
+    BENCH_LOOP("q8_8_scale", "sample", LEN, q8_8_scale(a, 0x0140, y, LEN));
+    BENCH_LOOP("q15_add", "sample", LEN, q15_add(a, b, y, LEN));
+
+    BENCH_LOOP("q15_sin", "call", 1, sink = q15_sin(a[i_ % LEN]));
+    BENCH_LOOP("q8_8_sin", "call", 1, sink = q8_8_sin(a[i_ % LEN]));
+    BENCH_LOOP("q15_atan2", "call", 1, sink = q15_atan2(a[i_ % LEN], b[i_ % LEN]));
+    BENCH_LOOP("q15_sqrt", "call", 1, sink = q15_sqrt(a[i_ % LEN] & 0x7FFF));
+    BENCH_LOOP("q8_8_sqrt", "call", 1, sink = q8_8_sqrt(a[i_ % LEN] & 0x7FFF));
+    BENCH_LOOP("q15_exp", "call", 1, sink = q15_exp(a[i_ % LEN] | INT16_MIN));
+    BENCH_LOOP("q8_8_exp", "call", 1, sink = q8_8_exp(a[i_ % LEN] >> 4));
+    bench_done();
+    return 0;
+}
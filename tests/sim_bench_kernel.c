@@ -0,0 +1,264 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Cycle counts on the running kernel: context switch, mutex hand-off,
+ * kalloc/kfree, each lock type, checksum, TTY, SLIP and ROMFS
+ * (sim_bench.h) */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "avrix-config.h"
+#include "sim_bench.h"
+#include "kernel/sched/scheduler.h"
+#include "kernel/mm/kalloc.h"
+#include "kernel/sync/spinlock.h"
+#include "kernel/sync/rwlock.h"
+#include "kernel/sync/seqlock.h"
+#include "kernel/sync/nk_mutex.h"
+#include "drivers/net/ipv4.h"
+#include "drivers/tty/tty.h"
+#include "drivers/net/slip.h"
+#include "drivers/fs/romfs.h"
+
+#ifdef __AVR__
+#  define STACK 192
+#else
+#  define STACK 32768                   /* host tasks: signal frames */
+#endif
+
+static nk_tcb_t tb, tp;
+static uint8_t  sb[STACK], sp[STACK];
+
+static volatile uint8_t stop;
+static volatile uint16_t sink;
+
+/*─── Context switch: two equal-priority tasks trading nk_yield() ───*/
+
+static void yielder(void)
+{
+    while (!stop) {
+        nk_yield();
+    }
+    nk_task_exit(0);
+}
+
+static void peer_start(void (*fn)(void), uint8_t prio)
+{
+    stop = 0;
+    (void)nk_task_create(&tp, fn, prio, sp, STACK);
+}
+
+static void peer_stop(void)
+{
+    stop = 1;
+    (void)nk_task_wait(tp.pid);
+    nk_task_release(tp.pid);
+}
+
+static void bench_switch(void)
+{
+    peer_start(yielder, 1);
+    nk_yield();
+    BENCH_LOOP("ctx_switch", "switch", 2, nk_yield());
+    peer_stop();
+}
+
+/*─── Contended mutex: every unlock hands the lock to the peer ──────*/
+
+static nk_mutex_t mtx = NK_MUTEX_INIT;
+
+static void locker(void)
+{
+    for (;;) {
+        nk_mutex_lock(&mtx);
+        bool done = stop;
+        nk_mutex_unlock(&mtx);
+        if (done) {
+            break;
+        }
+    }
+    nk_task_exit(0);
+}
+
+static void bench_mutex_contended(void)
+{
+    nk_mutex_lock(&mtx);
+    peer_start(locker, 2);
+    nk_sleep(2);                        /* peer now waits for mtx */
+    BENCH_LOOP("lock_nk_mutex_contended", "handoff", 2,
+               { nk_mutex_unlock(&mtx); nk_mutex_lock(&mtx); });
+    stop = 1;
+    nk_mutex_unlock(&mtx);
+    peer_stop();
+}
+
+/*─── Allocator and uncontended locks ───────────────────────────────*/
+
+static void bench_kalloc(void)
+{
+    kalloc_init();
+    BENCH_LOOP("kalloc_kfree", "pair", 1, { void *p = kalloc(16); kfree(p); });
+}
+
+static void bench_locks(void)
+{
+    static nk_spinlock_t spin;
+    static nk_flock_t    fl;
+#if NK_ENABLE_QLOCK
+    static nk_qlock_t    ql;
+#endif
+#if NK_SPINLOCK_IMPL == NK_SPINLOCK_MCS
+    static nk_mcslock_t  mcs;
+#endif
+    static nk_slock_t    sl;
+    static nk_rwlock_t   rw;
+    static nk_seqlock_t  seq;
+    static nk_mutex_t    m;
+
+    nk_spinlock_global_init();
+    nk_spinlock_init(&spin);
+    nk_flock_init(&fl);
+#if NK_ENABLE_QLOCK
+    nk_qlock_init(&ql);
+#endif
+#if NK_SPINLOCK_IMPL == NK_SPINLOCK_MCS
+    nk_mcs_init(&mcs);
+#endif
+    nk_slock_init(&sl);
+    nk_rwlock_init(&rw);
+    nk_seqlock_init(&seq);
+    nk_mutex_init(&m);
+
+    BENCH_LOOP("lock_spinlock", "pair", 1,
+               { nk_spinlock_lock(&spin, 0); nk_spinlock_unlock(&spin); });
+    BENCH_LOOP("lock_spinlock_rt", "pair", 1,
+               { nk_spinlock_lock_rt(&spin, 0); nk_spinlock_unlock_rt(&spin); });
+    BENCH_LOOP("lock_flock", "pair", 1, { nk_flock_lock(&fl); nk_flock_unlock(&fl); });
+#if NK_ENABLE_QLOCK
+    BENCH_LOOP("lock_qlock", "pair", 1, { nk_qlock_lock(&ql); nk_qlock_unlock(&ql); });
+#endif
+#if NK_SPINLOCK_IMPL == NK_SPINLOCK_MCS
+    BENCH_LOOP("lock_mcs", "pair", 1, { nk_mcs_lock(&mcs); nk_mcs_unlock(&mcs); });
+#endif
+    BENCH_LOOP("lock_slock", "pair", 1, { nk_slock_lock(&sl); nk_slock_unlock(&sl); });
+    BENCH_LOOP("lock_rwlock_read", "pair", 1,
+               { nk_rwlock_read_lock(&rw); nk_rwlock_read_unlock(&rw); });
+    BENCH_LOOP("lock_rwlock_write", "pair", 1,
+               { nk_rwlock_write_lock(&rw); nk_rwlock_write_unlock(&rw); });
+    BENCH_LOOP("lock_seqlock_write", "pair", 1,
+               { nk_seq_write_lock(&seq); nk_seq_write_unlock(&seq); });
+    BENCH_LOOP("lock_nk_mutex", "pair", 1, { nk_mutex_lock(&m); nk_mutex_unlock(&m); });
+
+    /* Contended, one core: the holder is preempted, so the cost that
+     * matters is a failed attempt before the caller backs off */
+    nk_spinlock_lock(&spin, 0);
+    BENCH_LOOP("lock_spinlock_contended", "try", 1,
+               sink += nk_spinlock_trylock(&spin, 0));
+    nk_spinlock_unlock(&spin);
+    nk_flock_lock(&fl);
+    BENCH_LOOP("lock_flock_contended", "try", 1, sink += nk_flock_try(&fl));
+    nk_flock_unlock(&fl);
+#if NK_ENABLE_QLOCK
+    nk_qlock_lock(&ql);
+    BENCH_LOOP("lock_qlock_contended", "try", 1, sink += nk_qlock_try(&ql));
+    nk_qlock_unlock(&ql);
+#endif
+#if NK_SPINLOCK_IMPL == NK_SPINLOCK_MCS
+    nk_mcs_lock(&mcs);
+    BENCH_LOOP("lock_mcs_contended", "try", 1, sink += nk_mcs_try(&mcs));
+    nk_mcs_unlock(&mcs);
+#endif
+    nk_slock_lock(&sl);
+    BENCH_LOOP("lock_slock_contended", "try", 1, sink += nk_slock_trylock(&sl));
+    nk_slock_unlock(&sl);
+    nk_rwlock_read_lock(&rw);
+    BENCH_LOOP("lock_rwlock_contended", "try", 1, sink += nk_rwlock_write_trylock(&rw));
+    nk_rwlock_read_unlock(&rw);
+}
+
+/*─── Per-byte data paths ───────────────────────────────────────────*/
+
+static uint8_t frame[128];
+
+#if CONFIG_NET_IPV4_ENABLED
+static void bench_checksum(void)
+{
+    BENCH_LOOP("ipv4_checksum", "byte", sizeof(frame),
+               sink += ipv4_checksum(frame, sizeof(frame)));
+}
+#endif
+
+#if CONFIG_TTY_ENABLED
+static tty_t   tty;
+static uint8_t tty_rx[64], tty_tx[64];
+
+static void drop(uint8_t c) { (void)c; }
+static int  none(void) { return -1; }
+
+static void bench_tty(void)
+{
+    tty_init(&tty, tty_rx, tty_tx, sizeof(tty_tx), drop, none);
+    BENCH_LOOP("tty_write", "byte", sizeof(tty_tx),
+               sink += (uint16_t)tty_write(&tty, frame, sizeof(tty_tx)));
+}
+#endif
+
+#if CONFIG_TTY_ENABLED && CONFIG_NET_SLIP_ENABLED
+static void bench_slip(void)
+{
+    frame[10] = SLIP_END;               /* two escapes per frame */
+    frame[90] = SLIP_ESC;
+    BENCH_LOOP("slip_encode", "byte", sizeof(frame),
+               slip_send_packet(&tty, frame, sizeof(frame)));
+}
+#endif
+
+#if CONFIG_FS_ROMFS_ENABLED
+static void bench_romfs(void)
+{
+    static const char path[] = "/etc/config/version.txt";
+    uint8_t buf[4];
+
+    BENCH_LOOP("romfs_open", "open", 1, sink += romfs_open(path) != NULL);
+    const romfs_file_t *f = romfs_open(path);
+    if (f) {
+        BENCH_LOOP("romfs_read", "read", 1,
+                   sink += (uint16_t)romfs_read(f, 0, buf, sizeof(buf)));
+    }
+}
+#endif
+
+static void bench_task(void)
+{
+    bench_init();
+    bench_switch();
+    bench_mutex_contended();
+    bench_kalloc();
+    bench_locks();
+    for (uint8_t i = 0; i < sizeof(frame); i++) {
+        frame[i] = i;
+    }
+#if CONFIG_NET_IPV4_ENABLED
+    bench_checksum();
+#endif
+#if CONFIG_TTY_ENABLED
+    bench_tty();
+#endif
+#if CONFIG_TTY_ENABLED && CONFIG_NET_SLIP_ENABLED
+    bench_slip();
+#endif
+#if CONFIG_FS_ROMFS_ENABLED
+    bench_romfs();
+#endif
+    bench_done();
+}
+
+int main(void)
+{
+    nk_sched_init();
+    (void)nk_task_create(&tb, bench_task, 1, sb, STACK);
+    nk_sched_run();
+    return 1;
+}
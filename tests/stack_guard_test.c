@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* MPU stack guard bookkeeping in the scheduler (kernel/sched/scheduler.c)
+ *
+ * The host has no MPU, so this builds the scheduler as if it did and
+ * records where hal_mpu_stack_guard() is pointed: at every switch, the
+ * block just under the stack of the task being switched to, which the
+ * stack layout keeps free of anything else.
+ */
+
+#define HAL_HAS_MPU 1
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../kernel/sched/scheduler.c"
+
+#if NK_OPT_STACK_GUARD
+_Static_assert(NK_OPT_MPU_GUARD, "MPU guard replaces the canaries");
+_Static_assert(NK_STACK_OVERHEAD == HAL_STACK_GUARD_SIZE, "no canary words");
+
+static const uint8_t *guard;
+static unsigned       guard_sets;
+
+void hal_mpu_stack_guard(const void *stack_lo)
+{
+    assert(stack_lo && ((uintptr_t)stack_lo & (HAL_STACK_GUARD_SIZE - 1)) == 0);
+    guard = stack_lo;
+    guard_sets++;
+}
+
+#define ROUNDS  50
+
+static nk_tcb_t tm, tw, tp;
+static uint8_t  sm[HAL_HOST_STACK], sw[HAL_HOST_STACK];
+static volatile unsigned spins;
+
+/* Caller buffers lose their unaligned bottom plus one guard block */
+static void check_trim(uint8_t tid, const uint8_t *buf)
+{
+    const uint8_t *b = nk_stk.base[tid];
+    assert(((uintptr_t)b & (HAL_STACK_GUARD_SIZE - 1)) == 0);
+    assert(b >= buf + HAL_STACK_GUARD_SIZE && b < buf + 2 * HAL_STACK_GUARD_SIZE);
+    assert(b + nk_stk.size[tid] == buf + HAL_HOST_STACK);
+}
+
+static void check_guard(void)
+{
+    assert(guard == nk_stk.base[nk_current_tid()]);
+}
+
+static void worker(void)
+{
+    for (;;) {
+        check_guard();
+        spins++;
+        nk_yield();
+    }
+}
+
+static void main_task(void)
+{
+    check_guard();
+    assert(nk_task_create(&tw, worker, 1, sw, sizeof(sw)));
+    check_trim(tw.pid, sw);
+
+    unsigned before = guard_sets;
+    for (unsigned i = 0; i < ROUNDS; i++) {
+        nk_yield();
+        check_guard();
+    }
+    assert(spins >= ROUNDS - 1);
+    assert(guard_sets - before >= 2 * ROUNDS);
+
+    /* a buffer too small to give up a guard block is refused */
+    static uint8_t tiny[HAL_STACK_GUARD_SIZE + 16];
+    nk_tcb_t tt;
+    assert(!nk_task_create(&tt, worker, 1, tiny, sizeof(tiny)));
+
+    printf("stack_guard_test: ok (%u guard moves)\n", guard_sets);
+    exit(0);
+}
+
+/* Never runs: priority 63 loses to the others, which never block */
+static void parked(void)
+{
+    abort();
+}
+
+int main(void)
+{
+    nk_sched_init();
+
+    /* Pooled stacks sit on guard-size boundaries, each above a free block */
+    assert(nk_task_create(&tp, parked, 63, NULL, 100));
+    uint8_t *b = nk_stk.base[tp.pid];
+    assert(b == nk_stack_pool + HAL_STACK_GUARD_SIZE);
+    assert(nk_stk.size[tp.pid] == 128 && nk_stk.brk == 128 + HAL_STACK_GUARD_SIZE);
+
+    assert(nk_task_create(&tm, main_task, 1, sm, sizeof(sm)));
+    check_trim(tm.pid, sm);
+    nk_sched_run();
+    return 1;
+}
+#else
+int main(void)
+{
+    printf("stack_guard_test: skipped (kernel_panic_on_fault off)\n");
+    return 0;
+}
+#endif
@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* nk_task_wait() blocks for a task's exit; nk_task_release() recycles slots */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arch/common/hal.h"
+#include "kernel/sched/scheduler.h"
+
+#define ROUNDS  40          /* well past kernel_task_max */
+
+static nk_tcb_t tp, tw[2];
+static uint8_t  sp[HAL_HOST_STACK], sw[2][HAL_HOST_STACK];
+static volatile uint32_t ran;
+
+static void worker(void)
+{
+    ran++;
+    nk_task_exit(0);
+}
+
+/* Lower priority than the parent: only runs once the parent blocks */
+static void parent(void)
+{
+    uint8_t first = 0xFF;
+
+    assert(nk_task_wait(nk_current_tid()) == -1);
+
+    /* Joinable: wait, then hand the slot back */
+    for (uint32_t i = 0; i < ROUNDS; i++) {
+        assert(nk_task_create(&tw[i & 1], worker, 3, sw[i & 1], HAL_HOST_STACK));
+        uint8_t tid = tw[i & 1].pid;
+        if (first == 0xFF) first = tid;
+        assert(tid == first);               /* same slot every time */
+        assert(ran == i);
+        assert(nk_task_wait(tid) == 0);
+        assert(ran == i + 1);
+        assert(nk_task_wait(tid) == 0);     /* already gone: no block */
+        nk_task_release(tid);
+    }
+
+    /* Detached: the slot frees itself as the worker exits */
+    for (uint32_t i = 0; i < ROUNDS; i++) {
+        assert(nk_task_create(&tw[0], worker, 3, sw[0], HAL_HOST_STACK));
+        assert(tw[0].pid == first);
+        nk_task_release(tw[0].pid);
+        uint32_t before = ran;
+        while (ran == before) nk_sleep(1);
+    }
+
+    /* Unreleased slots stay taken */
+    assert(nk_task_create(&tw[0], worker, 3, sw[0], HAL_HOST_STACK));
+    assert(nk_task_wait(tw[0].pid) == 0);
+    assert(nk_task_create(&tw[1], worker, 3, sw[1], HAL_HOST_STACK));
+    assert(tw[1].pid != tw[0].pid);
+    assert(nk_task_wait(tw[1].pid) == 0);
+
+    printf("task_reap_test: ok (%u workers)\n", (unsigned)ran);
+    exit(0);
+}
+
+int main(void)
+{
+    nk_sched_init();
+    assert(nk_task_create(&tp, parent, 1, sp, sizeof(sp)));
+    nk_sched_run();
+    return 1;
+}
@@ -0,0 +1,380 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* TCP against a scripted peer: handshakes, windows, retransmission, close */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "drivers/net/tcp.h"
+#include "drivers/net/slip.h"
+#include "drivers/tty/tty.h"
+
+#if CONFIG_NET_TCP_ENABLED && PBUF_COUNT >= 2 * TCP_WINDOW + 1
+
+/*─── Two one-way lines: ours → out[], in[] → ours ────────────────────*/
+static uint8_t out[16384], in[8192];
+static size_t  out_len, out_pos, in_len, in_pos, in_budget;
+
+static void out_putc(uint8_t c) { assert(out_len < sizeof(out)); out[out_len++] = c; }
+static void in_putc(uint8_t c)  { assert(in_len < sizeof(in)); in[in_len++] = c; }
+
+static int in_getc(void)
+{
+    if (in_pos == in_len || in_budget == 0) return -1;
+    in_budget--;
+    return in[in_pos++];
+}
+
+static tty_t   serial, wire;
+static uint8_t tty_rx[64], tty_tx[64], wire_rx[64], wire_tx[64];
+static uint32_t now;
+
+#define ME    0x0A000001u
+#define PEER  0x0A000002u
+#define PPORT 80u
+
+/* Deliver what the peer sent without overrunning the RX ring */
+static void pump(void)
+{
+    for (;;) {
+        size_t before = in_pos;
+        in_budget = sizeof(tty_rx) - 1 - tty_rx_available(&serial);
+        tty_poll(&serial);
+        ipv4_poll(&serial);
+        if (in_pos == before) return;
+    }
+}
+
+static void tick(uint32_t ms)
+{
+    now += ms;
+    tcp_timer(now);
+}
+
+/*─── Segments we sent, decoded and checked ───────────────────────────*/
+typedef struct {
+    uint16_t sport, dport, wnd, mss, len;
+    uint32_t seq, ack;
+    uint8_t  flags;
+    uint8_t  data[IPV4_MTU];
+} seg_t;
+
+static bool next_seg(seg_t *s)
+{
+    static uint8_t f[IPV4_MTU + 8];
+    size_t n = 0;
+
+    while (out_pos < out_len && out[out_pos] == SLIP_END) out_pos++;
+    if (out_pos == out_len) return false;
+    while (out[out_pos] != SLIP_END) {
+        uint8_t b = out[out_pos++];
+        if (b == SLIP_ESC) b = out[out_pos++] == SLIP_ESC_END ? SLIP_END : SLIP_ESC;
+        assert(n < sizeof(f));
+        f[n++] = b;
+    }
+
+    const ipv4_hdr_t *ip = (const ipv4_hdr_t *)f;
+    assert(n >= 40 && ipv4_checksum(f, 20) == 0 && ip->proto == IPV4_PROTO_TCP);
+    assert(ipv4_ntohl(ip->saddr) == ME && ipv4_ntohl(ip->daddr) == PEER);
+    assert(ipv4_ntohs(ip->len) == n);
+    uint16_t tlen = (uint16_t)(n - 20);
+    uint16_t sum = ipv4_pseudo_sum(ip->saddr, ip->daddr, IPV4_PROTO_TCP, tlen);
+    assert(ipv4_checksum_partial(f + 20, tlen, sum) == 0xFFFFu);
+
+    const tcp_hdr_t *th = (const tcp_hdr_t *)(f + 20);
+    uint16_t hlen = (uint16_t)((th->off >> 4) * 4u);
+    s->sport = ipv4_ntohs(th->sport);
+    s->dport = ipv4_ntohs(th->dport);
+    s->seq = ipv4_ntohl(th->seq);
+    s->ack = ipv4_ntohl(th->ack);
+    s->flags = th->flags;
+    s->wnd = ipv4_ntohs(th->wnd);
+    s->mss = hlen == 24 && f[40] == 2 ? (uint16_t)((f[42] << 8) | f[43]) : 0;
+    s->len = (uint16_t)(tlen - hlen);
+    memcpy(s->data, f + 20 + hlen, s->len);
+    return true;
+}
+
+static void expect_none(void)
+{
+    seg_t s;
+    assert(!next_seg(&s));
+}
+
+/*─── The peer ────────────────────────────────────────────────────────*/
+static uint16_t lport;                  /* our end of the current connection */
+
+static void peer_send(uint8_t flags, uint32_t seq, uint32_t ack, uint16_t wnd,
+                      const void *data, uint16_t len, uint16_t mss)
+{
+    struct __attribute__((packed)) {
+        ipv4_hdr_t ip;
+        tcp_hdr_t  tcp;
+        uint8_t    rest[IPV4_MTU];
+    } s;
+    uint16_t hlen = mss ? 24 : 20;
+    uint16_t tlen = (uint16_t)(hlen + len);
+
+    memset(&s, 0, sizeof(s));
+    s.tcp.sport = ipv4_htons(PPORT);
+    s.tcp.dport = ipv4_htons(lport);
+    s.tcp.seq = ipv4_htonl(seq);
+    s.tcp.ack = ipv4_htonl(ack);
+    s.tcp.off = (uint8_t)((hlen / 4) << 4);
+    s.tcp.flags = flags;
+    s.tcp.wnd = ipv4_htons(wnd);
+    if (mss) {
+        s.rest[0] = 2; s.rest[1] = 4;
+        s.rest[2] = (uint8_t)(mss >> 8); s.rest[3] = (uint8_t)mss;
+    }
+    if (len) memcpy(s.rest + (hlen - 20), data, len);
+    ipv4_init_header(&s.ip, PEER, ME, IPV4_PROTO_TCP, tlen);
+    uint16_t sum = ipv4_pseudo_sum(s.ip.saddr, s.ip.daddr, IPV4_PROTO_TCP, tlen);
+    s.tcp.checksum = ipv4_htons((uint16_t)~ipv4_checksum_partial(&s.tcp, tlen, sum));
+    slip_send_packet(&wire, (const uint8_t *)&s, 20u + tlen);
+    pump();
+}
+
+int main(void)
+{
+    tty_init(&serial, tty_rx, tty_tx, sizeof(tty_rx), out_putc, in_getc);
+    tty_init(&wire, wire_rx, wire_tx, sizeof(wire_rx), in_putc, NULL);
+    ipv4_set_addr(ME);
+    tcp_init();
+    tcp_timer(now);
+
+    seg_t s;
+    static uint8_t msg[2 * TCP_MSS];
+    for (size_t i = 0; i < sizeof(msg); i++) msg[i] = (uint8_t)(i * 7);
+
+    /* Active open: SYN carries our MSS; the SYN-ACK's MSS caps ours */
+    int c = tcp_connect(&serial, PEER, PPORT);
+    assert(c >= 0 && tcp_state(c) == TCP_SYN_SENT);
+    assert(next_seg(&s) && s.flags == TCP_SYN && s.mss == TCP_MSS && s.dport == PPORT);
+    lport = s.sport;
+    assert(lport == TCP_EPHEMERAL_BASE);
+    uint32_t snd = s.seq + 1, rcv = 5000;
+
+    peer_send(TCP_SYN | TCP_ACK, rcv - 1, snd, 4096, NULL, 0, 64);
+    assert(tcp_state(c) == TCP_ESTABLISHED);
+    assert(next_seg(&s) && s.flags == TCP_ACK && s.ack == rcv && s.seq == snd);
+    assert(s.wnd == TCP_WINDOW * TCP_MSS);
+    expect_none();
+
+    /* Sending: MSS-sized segments, at most TCP_WINDOW unacknowledged */
+    assert(tcp_sndbuf(c) == TCP_WINDOW * 64);
+    assert(tcp_send(c, msg, 1000) == TCP_WINDOW * 64 && tcp_sndbuf(c) == 0);
+    for (int i = 0; i < TCP_WINDOW; i++) {
+        assert(next_seg(&s) && s.len == 64 && s.seq == snd + 64u * i);
+        assert(memcmp(s.data, msg + 64 * i, 64) == 0 && (s.flags & TCP_ACK));
+    }
+    expect_none();
+    assert(tcp_send(c, msg, 10) == 0);
+
+    /* A partial ACK trims the oldest segment; a full one frees the window */
+    peer_send(TCP_ACK, rcv, snd + 32, 4096, NULL, 0, 0);
+    expect_none();
+    snd += TCP_WINDOW * 64u;
+    peer_send(TCP_ACK, rcv, snd, 4096, NULL, 0, 0);
+    assert(pbuf_used() == 1 && tcp_sndbuf(c) == TCP_WINDOW * 64);
+
+    /* An unacknowledged segment is resent with exponential backoff */
+    assert(tcp_send(c, "abc", 3) == 3);
+    assert(next_seg(&s) && s.len == 3 && s.seq == snd && memcmp(s.data, "abc", 3) == 0);
+    tick(TCP_RTO_MS - 1);
+    expect_none();
+    tick(1);                                         /* first timeout */
+    assert(next_seg(&s) && s.len == 3 && s.seq == snd);
+    tick(2 * TCP_RTO_MS - 1);
+    expect_none();
+    tick(1);                                         /* doubled */
+    assert(next_seg(&s) && s.len == 3 && s.seq == snd);
+    snd += 3;
+    peer_send(TCP_ACK, rcv, snd, 4096, NULL, 0, 0);
+    tick(8 * TCP_RTO_MS);
+    expect_none();                                   /* timer stopped */
+
+    /* Fast retransmit on the third duplicate ACK */
+    assert(tcp_send(c, msg, 128) == 128);
+    assert(next_seg(&s) && next_seg(&s) && s.seq == snd + 64);
+    for (int i = 0; i < 2; i++) peer_send(TCP_ACK, rcv, snd, 4096, NULL, 0, 0);
+    expect_none();
+    peer_send(TCP_ACK, rcv, snd, 4096, NULL, 0, 0);
+    assert(next_seg(&s) && s.seq == snd && s.len == 64 && memcmp(s.data, msg, 64) == 0);
+    snd += 128;
+    peer_send(TCP_ACK, rcv, snd, 4096, NULL, 0, 0);
+    expect_none();
+
+    /* A closed peer window holds data until the timer probes it */
+    peer_send(TCP_ACK, rcv, snd, 0, NULL, 0, 0);
+    assert(tcp_send(c, "zz", 2) == 2);
+    expect_none();
+    tick(TCP_RTO_MS);
+    assert(next_seg(&s) && s.len == 2 && s.seq == snd);
+    snd += 2;
+    peer_send(TCP_ACK, rcv, snd, 4096, NULL, 0, 0);
+
+    /* Receiving: delayed ACK by timer, immediate on every second segment */
+    peer_send(TCP_ACK | TCP_PSH, rcv, snd, 4096, "hello", 5, 0);
+    rcv += 5;
+    expect_none();
+    tick(TCP_DELACK_MS);
+    assert(next_seg(&s) && s.flags == TCP_ACK && s.ack == rcv);
+    peer_send(TCP_ACK, rcv, snd, 4096, " wor", 4, 0);
+    expect_none();
+    peer_send(TCP_ACK, rcv + 4, snd, 4096, "ld", 2, 0);
+    rcv += 6;
+    assert(next_seg(&s) && s.ack == rcv);
+    tick(TCP_DELACK_MS);
+    expect_none();
+    char buf[TCP_MSS];
+    assert(pbuf_used() == 2);                        /* small segments share one */
+    assert(tcp_recv(c, buf, 3) == 3 && memcmp(buf, "hel", 3) == 0);
+    assert(tcp_recv(c, buf, sizeof(buf)) == 8 && memcmp(buf, "lo world", 8) == 0);
+    assert(tcp_recv(c, buf, sizeof(buf)) == 0 && pbuf_used() == 1);
+
+    /* Duplicates are trimmed; out-of-order segments draw a duplicate ACK */
+    peer_send(TCP_ACK, rcv - 2, snd, 4096, "ld!", 3, 0);
+    rcv += 1;
+    peer_send(TCP_ACK, rcv + 100, snd, 4096, "later", 5, 0);
+    assert(next_seg(&s) && s.ack == rcv);
+    assert(tcp_recv(c, buf, sizeof(buf)) == 1 && buf[0] == '!');
+    peer_send(TCP_ACK, rcv - 1, snd, 4096, "!", 1, 0);   /* stale: ACK again */
+    assert(next_seg(&s) && s.ack == rcv);
+    expect_none();
+
+    /* Full-sized segments fill the window; one more is refused */
+    for (int i = 0; i < TCP_WINDOW; i++) {
+        peer_send(TCP_ACK, rcv, snd, 4096, msg + i * TCP_MSS % sizeof(msg), TCP_MSS, 0);
+        rcv += TCP_MSS;
+    }
+    while (next_seg(&s)) {}
+    tick(TCP_DELACK_MS);
+    while (next_seg(&s)) assert(s.ack == rcv);
+    assert(s.ack == rcv && s.wnd == 0);
+    peer_send(TCP_ACK, rcv, snd, 4096, "x", 1, 0);
+    assert(next_seg(&s) && s.ack == rcv && s.wnd == 0);
+    pbuf_t *p = tcp_recv_pbuf(c);                    /* window reopens */
+    assert(p && p->len == TCP_MSS && memcmp(pbuf_data(p), msg, TCP_MSS) == 0);
+    pbuf_free(p);
+    assert(next_seg(&s) && s.ack == rcv && s.wnd == TCP_MSS);
+    while ((p = tcp_recv_pbuf(c)) != NULL) pbuf_free(p);
+    while (next_seg(&s)) {}
+
+    /* Zero-copy send, then an active close through TIME-WAIT */
+    p = pbuf_alloc(PBUF_HLEN_TRANSPORT);
+    memcpy(pbuf_put(p, 4), "bye!", 4);
+    assert(tcp_send_pbuf(c, p) == 0);
+    assert(next_seg(&s) && s.len == 4 && memcmp(s.data, "bye!", 4) == 0);
+    tcp_close(c);
+    assert(next_seg(&s) && s.flags == (TCP_FIN | TCP_ACK) && s.seq == snd + 4);
+    snd += 5;
+    assert(tcp_state(c) == TCP_CLOSED && tcp_send(c, "x", 1) == -1);
+    peer_send(TCP_ACK, rcv, snd, 4096, NULL, 0, 0);          /* FIN_WAIT_2 */
+    expect_none();
+    peer_send(TCP_FIN | TCP_ACK, rcv, snd, 4096, NULL, 0, 0);  /* TIME_WAIT */
+    rcv += 1;
+    assert(next_seg(&s) && s.flags == TCP_ACK && s.ack == rcv);
+    peer_send(TCP_FIN | TCP_ACK, rcv - 1, snd, 4096, NULL, 0, 0);
+    assert(next_seg(&s) && s.ack == rcv);                  /* lost ACK redone */
+    assert(pbuf_used() == 1);
+
+    /* The TIME-WAIT slot comes back only after the timer */
+    int held[TCP_MAX_CONNS];
+    int n = 0;
+    while ((held[n] = tcp_listen(&serial, (uint16_t)(100 + n))) >= 0) n++;
+    assert(n == TCP_MAX_CONNS - 1);
+    tick(TCP_TIME_WAIT_MS);
+    assert((held[n] = tcp_listen(&serial, (uint16_t)(100 + n))) >= 0);
+    for (int i = 0; i <= n; i++) tcp_close(held[i]);
+
+    /* Passive open; the peer sends data with its FIN; we close last */
+    int l = tcp_listen(&serial, 7);
+    assert(l >= 0 && tcp_state(l) == TCP_LISTEN && tcp_listen(&serial, 7) == -1);
+    lport = 7;
+    rcv = 90000;
+    peer_send(TCP_SYN, rcv - 1, 0, 4096, NULL, 0, 0);      /* no MSS: 536 */
+    assert(tcp_state(l) == TCP_SYN_RCVD);
+    assert(next_seg(&s) && s.flags == (TCP_SYN | TCP_ACK) && s.ack == rcv && s.mss == TCP_MSS);
+    snd = s.seq + 1;
+    tick(TCP_RTO_MS);                                      /* SYN-ACK lost */
+    assert(next_seg(&s) && s.flags == (TCP_SYN | TCP_ACK) && s.seq == snd - 1);
+    peer_send(TCP_ACK | TCP_FIN, rcv, snd, 4096, "req", 3, 0);
+    rcv += 4;
+    assert(tcp_state(l) == TCP_CLOSE_WAIT);
+    assert(next_seg(&s) && s.ack == rcv);
+    assert(tcp_recv(l, buf, sizeof(buf)) == 3 && memcmp(buf, "req", 3) == 0);
+    assert(tcp_send(l, msg, TCP_MSS) == TCP_MSS);
+    assert(next_seg(&s) && s.len == TCP_MSS);              /* peer MSS 536 */
+    tcp_close(l);                                          /* FIN follows the data */
+    snd += TCP_MSS;
+    assert(next_seg(&s) && s.flags == (TCP_FIN | TCP_ACK) && s.seq == snd);
+    peer_send(TCP_ACK, rcv, snd, 4096, NULL, 0, 0);        /* data only */
+    expect_none();
+    peer_send(TCP_ACK, rcv, snd + 1, 4096, NULL, 0, 0);    /* slot free */
+    held[0] = tcp_connect(&serial, PEER, PPORT);
+    held[1] = tcp_connect(&serial, PEER, PPORT);
+    assert(held[0] >= 0 && held[1] >= 0);
+    tcp_abort(held[0]);
+    tcp_abort(held[1]);
+    while (next_seg(&s)) {}
+
+    /* Resets: unknown port, peer reset, refused and timed-out connects */
+    lport = 9;
+    peer_send(TCP_SYN, 41, 0, 4096, NULL, 0, 0);
+    assert(next_seg(&s) && s.flags == (TCP_RST | TCP_ACK) && s.ack == 42);
+    peer_send(TCP_ACK, 41, 777, 4096, NULL, 0, 0);
+    assert(next_seg(&s) && s.flags == TCP_RST && s.seq == 777);
+    peer_send(TCP_RST, 41, 0, 0, NULL, 0, 0);
+    expect_none();
+
+    c = tcp_connect(&serial, PEER, PPORT);
+    assert(next_seg(&s));
+    lport = s.sport;
+    peer_send(TCP_SYN | TCP_ACK, 99, s.seq + 1, 4096, NULL, 0, 0);
+    assert(next_seg(&s));
+    peer_send(TCP_RST, 99, 0, 0, NULL, 0, 0);               /* wrong seq */
+    assert(tcp_state(c) == TCP_ESTABLISHED);
+    peer_send(TCP_RST, 100, 0, 0, NULL, 0, 0);
+    assert(tcp_state(c) == TCP_CLOSED && tcp_reset(c));
+    tcp_close(c);
+
+    c = tcp_connect(&serial, PEER, PPORT);
+    assert(next_seg(&s));
+    lport = s.sport;
+    peer_send(TCP_RST | TCP_ACK, 0, s.seq + 1, 0, NULL, 0, 0);
+    assert(tcp_state(c) == TCP_CLOSED && tcp_reset(c));
+    tcp_close(c);
+
+    c = tcp_connect(&serial, PEER, PPORT);
+    assert(tcp_send(c, "early", 5) == 5);                   /* queued for later */
+    uint32_t rto = TCP_RTO_MS;
+    for (int i = 0; i <= TCP_MAX_RETRIES; i++) {
+        assert(next_seg(&s) && s.flags == TCP_SYN);
+        tick(rto);
+        rto = rto * 2 < 32000 ? rto * 2 : 32000;
+    }
+    assert(tcp_state(c) == TCP_CLOSED && tcp_reset(c) && pbuf_used() == 1);
+    expect_none();
+    tcp_close(c);
+
+    /* Bad handles */
+    assert(tcp_state(-1) == TCP_CLOSED && tcp_send(TCP_MAX_CONNS, "x", 1) == -1);
+    assert(tcp_recv(c, buf, 1) == -1 && tcp_recv_pbuf(c) == NULL);
+    assert(tcp_listen(&serial, 0) == -1 && tcp_connect(NULL, PEER, 1) == -1);
+    printf("tcp: ok\n");
+    return 0;
+}
+
+#else
+
+int main(void)
+{
+    printf("tcp: skipped (needs net_tcp_enabled and net_pbufs >= 2 * net_tcp_window + 1)\n");
+    return 0;
+}
+
+#endif
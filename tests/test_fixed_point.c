@@ -31,10 +31,132 @@ static void edge_case_tests(void)
     assert(q8_8_mul(Q8_8_MIN, Q8_8_MIN) == 0);
 }
 
+/* Reference arithmetic in 64 bits, round half up like the kernels */
+static int16_t ref_round(int64_t acc, unsigned shift)
+{
+    int64_t v = (acc + ((int64_t)1 << (shift - 1))) >> shift;
+    return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t)v;
+}
+
+static uint32_t rng = 12345u;
+static int16_t rnd16(void)
+{
+    rng = rng * 1103515245u + 12345u;
+    return (int16_t)(rng >> 16);
+}
+
+static void q15_scalar_tests(void)
+{
+    assert(q15_mul(Q15_MIN, Q15_MIN) == Q15_MAX);
+    assert(q15_mul(Q15_MAX, Q15_MAX) == 0x7FFE);
+    assert(q15_mul(Q15(0.5), Q15(0.5)) == Q15(0.25));
+    assert(q15_mul(Q15(-0.5), Q15(0.5)) == Q15(-0.25));
+    assert(q15_mul(Q15_MIN, Q15_MAX) == -Q15_MAX);
+    for (int i = 0; i < 2000; i++) {
+        int16_t a = rnd16(), b = rnd16();
+        assert(q15_mul(a, b) == ref_round((int64_t)a * b, 15));
+    }
+    assert(q15_from_acc(INT32_MAX) == Q15_MAX);
+    assert(q15_from_acc(INT32_MIN) == Q15_MIN);
+}
+
+static void vector_tests(void)
+{
+    enum { N = 37 };                        /* Odd: exercises pair tails */
+    int16_t a[N], b[N], y[N];
+    int64_t ref = 0;
+
+    for (int i = 0; i < N; i++) {
+        a[i] = (int16_t)(rnd16() / 64);     /* Keep sum |a*b| below 2.0 */
+        b[i] = rnd16();
+        ref += (int64_t)a[i] * b[i];
+    }
+    assert(q15_mac(0, a, b, N) == ref);
+    assert(q15_mac(100, a, b, 0) == 100);
+    assert(q15_dot(a, b, N) == ref_round(ref, 15));
+    assert(q8_8_dot(a, b, N) == ref_round(ref, 8));
+    assert(q15_dot(a, b, 0) == 0);
+
+    q15_scale(b, Q15(-0.75), y, N);
+    for (int i = 0; i < N; i++) {
+        assert(y[i] == q15_mul(b[i], Q15(-0.75)));
+    }
+    q8_8_scale(b, (q8_8_t)0x0180, y, N);    /* 1.5: saturates the big ones */
+    for (int i = 0; i < N; i++) {
+        assert(y[i] == ref_round((int64_t)b[i] * 0x0180, 8));
+    }
+
+    q15_add(a, b, y, N);
+    for (int i = 0; i < N; i++) {
+        assert(y[i] == ref_round(((int64_t)a[i] + b[i]) * 2, 1));
+    }
+    int16_t hi[3] = { Q15_MAX, Q15_MIN, 100 }, lo[3] = { 1, -1, -300 };
+    q8_8_add(hi, lo, hi, 3);                /* In place */
+    assert(hi[0] == Q15_MAX && hi[1] == Q15_MIN && hi[2] == -200);
+}
+
+static void fir_tests(void)
+{
+    enum { TAPS = 5, N = 40 };
+    static const q15_t h[TAPS] = { Q15(0.1), Q15(0.2), Q15(0.4), Q15(0.2), Q15(0.1) };
+    q15_t delay[2 * TAPS], x[N], y[N];
+    q15_fir_t f;
+
+    for (int i = 0; i < N; i++) {
+        x[i] = rnd16();
+    }
+    /* Block-size independent: one call, then sample by sample */
+    q15_fir_init(&f, h, delay, TAPS);
+    q15_fir(&f, x, y, N);
+    for (int i = 0; i < N; i++) {
+        int64_t acc = 0;
+        for (int k = 0; k < TAPS && k <= i; k++) {
+            acc += (int64_t)h[k] * x[i - k];
+        }
+        assert(y[i] == ref_round(acc, 15));
+    }
+    q15_t z[N];
+    q15_fir_init(&f, h, delay, TAPS);
+    for (int i = 0; i < N; i++) {
+        q15_fir(&f, &x[i], &z[i], 1);
+    }
+    for (int i = 0; i < N; i++) {
+        assert(z[i] == y[i]);
+    }
+}
+
+static void biquad_tests(void)
+{
+    /* Low-pass, poles at 0.9 +/- 0.2j: 1 - 1.8 z^-1 + 0.85 z^-2 */
+    q15_biquad_t f = { { Q2_14(0.0125), Q2_14(0.025), Q2_14(0.0125),
+                         Q2_14(1.8), Q2_14(-0.85) }, { 0 } };
+    q15_t x[64], y[64];
+    int64_t x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+
+    for (int i = 0; i < 64; i++) {
+        x[i] = i < 32 ? Q15(0.5) : rnd16() / 4;
+    }
+    q15_biquad(&f, x, y, 20);               /* Split call: state carries */
+    q15_biquad(&f, x + 20, y + 20, 44);
+    for (int i = 0; i < 64; i++) {
+        int64_t acc = f.c[0] * (int64_t)x[i] + f.c[1] * x1 + f.c[2] * x2 +
+                      f.c[3] * y1 + f.c[4] * y2;
+        int16_t out = ref_round(acc, 14);
+        assert(y[i] == out);
+        x2 = x1; x1 = x[i]; y2 = y1; y1 = out;
+    }
+    assert(y[31] > Q15(0.45) && y[31] < Q15(0.55));  /* DC gain 1 */
+}
+
 int main(void)
 {
     boundary_tests();
     edge_case_tests();
     puts("q8_8_mul boundary tests passed");
+    q15_scalar_tests();
+    vector_tests();
+    fir_tests();
+    biquad_tests();
+    puts("q15/q8.8 block kernels passed");
     return 0;
 }
@@ -0,0 +1,224 @@
+import random
+import shutil
+import subprocess
+import sys
+from pathlib import Path
+
+import pytest
+
+ROOT = Path(__file__).resolve().parent.parent
+sys.path.append(str(ROOT / "scripts"))
+import mkromfs
+
+
+def make_tree(base: Path) -> Path:
+    src = base / "assets"
+    (src / "etc" / "config").mkdir(parents=True)
+    (src / "www").mkdir()
+    (src / "etc" / "config" / "version.txt").write_bytes(b"1.0\n")
+    (src / "etc" / "README").write_bytes(b"same\n")
+    (src / "www" / "README").write_bytes(b"same\n")
+    (src / "www" / "index.html").write_bytes(b'<p class="x">?</p>\n')
+    (src / "Zeta").write_bytes(b"")
+    (src / "alpha.bin").write_bytes(bytes(range(256)) * 3)
+    return src
+
+
+def test_dedup_and_sorting(tmp_path):
+    src = make_tree(tmp_path)
+    img = mkromfs.Image()
+    img.add_dir(src, "")
+
+    assert len(img.files) == 5                # both READMEs share one file
+    assert list(img.names).count(b"README") == 1
+
+    root = img.dirs[-1]
+    assert [e[0] for e in root] == [b"Zeta", b"alpha.bin", b"etc", b"www"]
+    for entries in img.dirs:
+        names = [e[0] for e in entries]
+        assert names == sorted(names)
+
+
+def test_output_is_stable(tmp_path):
+    src = make_tree(tmp_path)
+    out = tmp_path / "romfs_image.h"
+    assert mkromfs.main(["mkromfs", str(src), str(out)]) == 0
+    first = out.read_text()
+    stamp = out.stat().st_mtime_ns
+    assert mkromfs.main(["mkromfs", str(src), str(out)]) == 0
+    assert out.read_text() == first
+    assert out.stat().st_mtime_ns == stamp     # unchanged: not rewritten
+    assert "ROMFS_DIR_SORTED" in first
+    assert "aligned(4)" in first
+
+
+def test_rejects_bad_align(tmp_path):
+    src = make_tree(tmp_path)
+    with pytest.raises(SystemExit):
+        mkromfs.main(["mkromfs", str(src), str(tmp_path / "x.h"), "--align", "3"])
+
+
+@pytest.mark.skipif(shutil.which("cc") is None, reason="no host C compiler")
+def test_image_round_trip(tmp_path):
+    src = make_tree(tmp_path)
+    out = tmp_path / "romfs_image.h"
+    mkromfs.main(["mkromfs", str(src), str(out)])
+
+    prog = tmp_path / "check.c"
+    prog.write_text(
+        f'#define ROMFS_IMAGE "{out}"\n'
+        '#include "drivers/fs/romfs.c"\n'
+        "#include <assert.h>\n"
+        "static int check(const char *p, const char *want, unsigned n) {\n"
+        "    const romfs_file_t *f = romfs_open(p);\n"
+        "    char buf[800];\n"
+        "    if (!f) return 0;\n"
+        "    int got = romfs_read(f, 0, buf, sizeof buf);\n"
+        "    return got == (int)n && memcmp(buf, want, n) == 0;\n"
+        "}\n"
+        "int main(void) {\n"
+        '    assert(check("/etc/config/version.txt", "1.0\\n", 4));\n'
+        '    assert(check("/etc/README", "same\\n", 5));\n'
+        '    assert(check("/www/README", "same\\n", 5));\n'
+        '    assert(check("/www/index.html", "<p class=\\"x\\">?</p>\\n", 19));\n'
+        '    assert(check("/Zeta", "", 0));\n'
+        '    assert(romfs_open("/www/README") == romfs_open("/etc/README"));\n'
+        '    assert(!romfs_open("/www/missing") && !romfs_open("/etc"));\n'
+        '    const romfs_file_t *a = romfs_open("/alpha.bin");\n'
+        "    assert(a && a->size == 768 && ((uintptr_t)a->data & 3) == 0);\n"
+        "    return 0;\n"
+        "}\n"
+    )
+    build_and_run(tmp_path, prog)
+
+
+@pytest.mark.skipif(shutil.which("cc") is None, reason="no host C compiler")
+def test_far_image_round_trip(tmp_path):
+    src = make_tree(tmp_path)
+    (src / "log.txt").write_bytes(b"tick 0000 ok\n" * 300)
+    out = tmp_path / "romfs_image.h"
+    mkromfs.main(["mkromfs", str(src), str(out), "--compress"])
+    text = out.read_text()
+    assert "ROMFS_FAR_FILE(romfs_blob0, " in text and "ROMFS_ADDR(romfs_blob0)" in text
+
+    # Host: the C table, with integer far addresses read via hal_*_far()
+    prog = tmp_path / "check.c"
+    prog.write_text(
+        "#define ROMFS_FAR 1\n"
+        "#define ROMFS_LZ_STREAMS 1\n"
+        f'#define ROMFS_IMAGE "{out}"\n'
+        '#include "drivers/fs/romfs.c"\n'
+        "#include <assert.h>\n"
+        "int main(void) {\n"
+        "    char buf[16];\n"
+        "    uint16_t n;\n"
+        '    const romfs_file_t *f = romfs_open("/etc/config/version.txt");\n'
+        "    assert(f && romfs_read(f, 0, buf, sizeof buf) == 4 && memcmp(buf, \"1.0\\n\", 4) == 0);\n"
+        "    assert(romfs_map(f, &n) && n == 4);\n"
+        '    f = romfs_open("/log.txt");\n'
+        "    assert(f && (f->flags & ROMFS_FILE_LZ) && !romfs_map(f, &n));\n"
+        "    assert(romfs_read(f, 13 * 200, buf, 13) == 13 && memcmp(buf, \"tick 0000 ok\\n\", 13) == 0);\n"
+        "    return 0;\n"
+        "}\n"
+    )
+    build_and_run(tmp_path, prog)
+
+
+def build_and_run(tmp_path: Path, prog: Path, *args: str) -> None:
+    exe = tmp_path / "check"
+    cfg = tmp_path / "cfg"
+    cfg.mkdir(exist_ok=True)
+    (cfg / "avrix-config.h").write_text("#define CONFIG_FS_ROMFS_ENABLED 1\n")
+    subprocess.run(
+        ["cc", "-std=gnu11", "-w",
+         f"-I{ROOT}", f"-I{ROOT / 'include'}", f"-I{cfg}", str(prog), "-o", str(exe)],
+        check=True,
+    )
+    subprocess.run([str(exe), *args], check=True)
+
+
+def test_lz_codec(tmp_path):
+    rng = random.Random(1)
+    samples = [
+        b"a",
+        b"abc" * 300,
+        bytes(rng.randrange(256) for _ in range(1000)),
+        b"".join(rng.choice([b"<td>", b"</td>", b"row", b"\n"]) for _ in range(2000)),
+    ]
+    for data in samples:
+        for wbits, shift in ((6, 9), (4, 4), (8, 15), (1, 5)):
+            packed = mkromfs.lz_compress(data, wbits, shift)
+            assert mkromfs.lz_expand(packed, len(data)) == data
+    text = samples[3]
+    assert len(mkromfs.lz_compress(text, 6, 9)) < len(text) // 2
+
+
+def test_compress_keeps_incompressible_raw(tmp_path):
+    src = make_tree(tmp_path)
+    (src / "page.html").write_bytes(b"<li>item</li>\n" * 100)
+    img = mkromfs.Image((6, 9))
+    img.add_dir(src, "")
+    flags = dict(zip(img.sizes, img.flags))
+    assert flags[1400] == "ROMFS_FILE_LZ"
+    assert flags[4] == "0"                     # version.txt: would grow
+
+
+@pytest.mark.skipif(shutil.which("cc") is None, reason="no host C compiler")
+def test_compressed_image_round_trip(tmp_path):
+    src = make_tree(tmp_path)
+    rng = random.Random(7)
+    words = [b"<tr>", b"</tr>", b"<td>", b"</td>", b"avrix", b"\n", b" "]
+    big = b"".join(rng.choice(words) for _ in range(3000))[:9000]
+    (src / "big.html").write_bytes(big)
+    (src / "log.txt").write_bytes(b"tick 0000 ok\n" * 300)
+    out = tmp_path / "romfs_image.h"
+    mkromfs.main(["mkromfs", str(src), str(out), "--compress", "--lz-block", "8"])
+    assert "ROMFS_FILE_LZ" in out.read_text()
+
+    prog = tmp_path / "check.c"
+    prog.write_text(
+        "#define ROMFS_LZ_STREAMS 2\n"
+        f'#define ROMFS_IMAGE "{out}"\n'
+        '#include "drivers/fs/romfs.c"\n'
+        "#include <assert.h>\n"
+        "#include <stdio.h>\n"
+        "#include <stdlib.h>\n"
+        "static unsigned char want[2][9000];\n"
+        "static void load(int i, const char *p, unsigned n) {\n"
+        "    FILE *fp = fopen(p, \"rb\");\n"
+        "    assert(fp && fread(want[i], 1, n, fp) == n);\n"
+        "    fclose(fp);\n"
+        "}\n"
+        "int main(int argc, char **argv) {\n"
+        "    (void)argc;\n"
+        "    const romfs_file_t *f[2] = { romfs_open(\"/big.html\"), romfs_open(\"/log.txt\") };\n"
+        "    unsigned n[2] = { f[0]->size, f[1]->size };\n"
+        "    assert((f[0]->flags & ROMFS_FILE_LZ) && (f[1]->flags & ROMFS_FILE_LZ));\n"
+        "    load(0, argv[1], n[0]);\n"
+        "    load(1, argv[2], n[1]);\n"
+        "    unsigned char buf[300];\n"
+        "    /* Two files read sequentially, interleaved, in odd chunks */\n"
+        "    unsigned pos[2] = { 0, 0 };\n"
+        "    while (pos[0] < n[0] || pos[1] < n[1]) {\n"
+        "        for (int i = 0; i < 2; i++) {\n"
+        "            int got = romfs_read(f[i], pos[i], buf, 37);\n"
+        "            unsigned left = n[i] - pos[i];\n"
+        "            assert(got == (int)(left < 37 ? left : 37));\n"
+        "            assert(memcmp(buf, want[i] + pos[i], got) == 0);\n"
+        "            pos[i] += got;\n"
+        "        }\n"
+        "    }\n"
+        "    /* Random seeks, backwards and across checkpoints */\n"
+        "    srand(3);\n"
+        "    for (int k = 0; k < 2000; k++) {\n"
+        "        int i = rand() & 1;\n"
+        "        unsigned off = rand() % (n[i] + 10), len = rand() % sizeof buf;\n"
+        "        int got = romfs_read(f[i], off, buf, len);\n"
+        "        unsigned exp = off >= n[i] ? 0 : (n[i] - off < len ? n[i] - off : len);\n"
+        "        assert(got == (int)exp);\n"
+        "        assert(memcmp(buf, want[i] + (off < n[i] ? off : 0), got) == 0);\n"
+        "    }\n"
+        "    return 0;\n"
+        "}\n"
+    )
+    build_and_run(tmp_path, prog, str(src / "big.html"), str(src / "log.txt"))
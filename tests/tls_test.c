@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* nk_tls_self follows the running task across (preemptive) switches */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arch/common/hal.h"
+#include "kernel/sched/scheduler.h"
+
+#define RUN_MS  50
+
+typedef struct {
+    uint32_t id;
+    uint32_t seen;
+} block_t;
+
+static nk_tcb_t tm, tw[2], tn;
+static uint8_t  sm[HAL_HOST_STACK], sw[2][HAL_HOST_STACK], sn[HAL_HOST_STACK];
+static block_t  blk[2];
+static volatile uint32_t bad;
+
+/* Spins through several slices; its block must never change under it */
+static void worker(void)
+{
+    block_t *b = nk_tls_self;
+    uint32_t t0 = hal_timer_ticks();
+
+    assert(b);
+    while (hal_timer_ticks() - t0 < RUN_MS) {
+        block_t *now = *(block_t *volatile *)&nk_tls_self;
+        if (now != b) bad++;
+        now->seen++;
+    }
+    nk_task_exit(0);
+}
+
+/* Never given a block */
+static void bare(void)
+{
+    assert(nk_tls_self == NULL);
+    assert(nk_task_tls(nk_current_tid()) == NULL);
+    nk_task_exit(0);
+}
+
+static void main_task(void)
+{
+    uint8_t self = nk_current_tid();
+    static block_t mine = { 99, 0 };
+
+    assert(nk_tls_self == NULL);
+    assert(nk_task_set_tls(self, &mine));
+    assert(nk_tls_self == &mine);               /* takes effect at once */
+    assert(nk_task_tls(self) == &mine);
+    assert(!nk_task_set_tls(0xFE, &mine));
+    assert(nk_task_tls(0xFE) == NULL);
+
+    for (uint8_t i = 0; i < 2; i++) {
+        blk[i].id = i;
+        assert(nk_task_create(&tw[i], worker, 3, sw[i], HAL_HOST_STACK));
+        assert(nk_task_set_tls(tw[i].pid, &blk[i]));
+    }
+    assert(nk_task_create(&tn, bare, 2, sn, HAL_HOST_STACK));
+
+    assert(nk_task_wait(tn.pid) == 0);
+    assert(nk_task_wait(tw[0].pid) == 0);
+    assert(nk_task_wait(tw[1].pid) == 0);
+    assert(nk_tls_self == &mine);               /* back after blocking */
+    assert(bad == 0 && blk[0].seen && blk[1].seen);
+
+    /* A recycled slot starts without one */
+    assert(nk_task_set_tls(tn.pid, &blk[0]));
+    nk_task_release(tn.pid);
+    assert(nk_task_create(&tn, bare, 2, sn, HAL_HOST_STACK));
+    assert(nk_task_wait(tn.pid) == 0);
+
+    printf("tls_test: ok (%u + %u)\n", (unsigned)blk[0].seen, (unsigned)blk[1].seen);
+    exit(0);
+}
+
+int main(void)
+{
+    nk_sched_init();
+    assert(nk_task_create(&tm, main_task, 1, sm, sizeof(sm)));
+    nk_sched_run();
+    return 1;
+}
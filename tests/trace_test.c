@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Binary event trace ring (kernel/sync/nk_trace.c)
+ *
+ * With a file argument the final image is written there, for feeding
+ * scripts/trace_decode.py by hand. */
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NK_TRACE 1
+#define NK_TRACE_EVENTS 8
+static volatile uint32_t fake_clock;
+#define NK_TRACE_CLOCK() fake_clock
+
+#include "../kernel/sync/nk_trace.c"
+
+static const nk_trace_ev_t *oldest(uint8_t k)
+{
+    uint16_t i = (uint16_t)(nk_trace_buf.head[0].next -
+                            nk_trace_buf.head[0].count + k);
+    return &nk_trace_buf.ev[0][i & (NK_TRACE_EVENTS - 1)];
+}
+
+int main(int argc, char **argv)
+{
+    /* Garbage from power-up is thrown away */
+    memset(&nk_trace_buf, 0xA5, sizeof nk_trace_buf);
+    nk_trace_init();
+    assert(nk_trace_buf.magic == NK_TRACE_MAGIC);
+    assert(nk_trace_buf.events == NK_TRACE_EVENTS);
+    assert(nk_trace_buf.cores == 1 && nk_trace_buf.head[0].count == 0);
+
+    fake_clock = 100;
+    nk_trace_switch(0xFF, 1);              /* boot: no task yet */
+    fake_clock = 150;
+    nk_trace_door_call(1, 3, 2);
+    assert(nk_trace_buf.head[0].count == 2);
+    assert(oldest(0)->type == NK_TR_SWITCH && oldest(0)->ts == 100);
+    assert(oldest(1)->type == NK_TR_DOOR_CALL);
+    assert(oldest(1)->a == 1 && oldest(1)->b == (3 | 2 << 8));
+
+    /* A warm reset keeps what was recorded */
+    nk_trace_init();
+    assert(nk_trace_buf.head[0].count == 2);
+
+    /* Full ring: the oldest records go first */
+    for (uint32_t i = 0; i < 20; i++) {
+        fake_clock = 1000 + i;
+        nk_trace_rec(NK_TR_USER, (uint8_t)i, 0);
+    }
+    assert(nk_trace_buf.head[0].count == NK_TRACE_EVENTS);
+    assert(nk_trace_buf.head[0].next == 22);
+    assert(oldest(0)->a == 12 && oldest(0)->ts == 1012);
+    assert(oldest(NK_TRACE_EVENTS - 1)->a == 19);
+
+    /* Nothing is recorded while paused */
+    nk_trace_pause(true);
+    nk_trace_rec(NK_TR_USER, 99, 0);
+    assert(nk_trace_buf.head[0].next == 22);
+    nk_trace_pause(false);
+
+    /* A short ISR and a contended lock for the decoder to show */
+    fake_clock = 2000;
+    nk_trace_isr_enter(NK_TRACE_IRQ_UART_RX);
+    fake_clock = 2040;
+    nk_trace_isr_exit(NK_TRACE_IRQ_UART_RX);
+    nk_trace_lock(1, (void *)0x1234);
+    nk_trace_door_return(2, 1);
+
+    size_t len;
+    const void *img = nk_trace_image(&len);
+    assert(img == &nk_trace_buf);
+    assert(len == 12 + 4 + NK_TRACE_EVENTS * sizeof(nk_trace_ev_t));
+
+    nk_trace_clear();
+    assert(nk_trace_buf.head[0].count == 0 && nk_trace_buf.magic);
+
+    if (argc > 1) {
+        nk_trace_door_call(1, 0, 2);
+        fake_clock += 300;
+        nk_trace_door_return(2, 1);
+        FILE *f = fopen(argv[1], "wb");
+        assert(f && fwrite(img, 1, len, f) == len);
+        fclose(f);
+    }
+    printf("trace_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,201 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Blocking tty_read_wait() / tty_write_wait() (drivers/tty/tty.c) */
+
+#define TTY_BLOCKING  1
+#define TTY_POLL      0         /* no nk_io_event in the stub scheduler */
+#define TTY_IDLE_HOLD 0         /* nor nk_idle_hold(): idle.c needs the real one */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../drivers/tty/tty.c"
+
+/*─── Stub scheduler: a blocked task lets the "hardware" run ─────────
+ * Each step is one tick in which the peer may raise one interrupt.  The
+ * task stays queued until an ISR wakes it (or its timeout expires). */
+static void (*peer)(void);
+static uint32_t fake_ticks;
+static unsigned blocks, wakes, steps;
+
+uint32_t nk_sched_lock(void) { return 0; }
+void nk_sched_unlock(uint32_t s) { (void)s; }
+uint32_t nk_ticks(void) { return fake_ticks; }
+
+void nk_waitq_block(nk_waitq_t *q)
+{
+    blocks++;
+    *q = 1;
+    while (*q) {
+        assert(peer && ++steps < 10000);
+        fake_ticks++;
+        peer();
+    }
+}
+
+int nk_waitq_block_timeout(nk_waitq_t *q, uint16_t ticks)
+{
+    blocks++;
+    *q = 1;
+    while (*q && ticks--) {
+        fake_ticks++;
+        peer();
+    }
+    if (*q) {
+        *q = 0;                 /* timed out: off the queue */
+        return -1;
+    }
+    return 0;
+}
+
+int nk_waitq_wake_one(nk_waitq_t *q)
+{
+    if (!*q) return -1;
+    wakes++;
+    *q = 0;
+    return 0;
+}
+
+static void reset(void) { blocks = wakes = steps = 0; }
+
+/*─── Fake UART ──────────────────────────────────────────────────────*/
+static tty_t   tty;
+static uint8_t rx[16], tx[16];
+static uint8_t script[64];              /* bytes still to "arrive" */
+static size_t  script_len, script_pos;
+static uint8_t wire[128];
+static size_t  wire_len;
+
+static void kick(void) {}
+
+static void arrive(const char *s)
+{
+    script_len = strlen(s);
+    memcpy(script, s, script_len);
+    script_pos = 0;
+}
+
+/* RX-complete interrupt for the next scripted byte, if any */
+static void rx_irq(void)
+{
+    if (script_pos < script_len) {
+        tty_rx_isr(&tty, script[script_pos++]);
+    }
+}
+
+/* TX-empty interrupt: one byte onto the wire */
+static void tx_irq(void)
+{
+    int c = tty_tx_isr(&tty);
+    if (c >= 0) wire[wire_len++] = (uint8_t)c;
+}
+
+/* Polled hardware: bytes show up in the UART, tty_poll() fetches them */
+static int uart_getc(void)
+{
+    return script_pos < script_len ? script[script_pos++] : -1;
+}
+
+static void poll_irq(void) { tty_poll(&tty); }
+
+static void uart_putc(uint8_t c) { wire[wire_len++] = c; }
+
+/*─── Tests ──────────────────────────────────────────────────────────*/
+
+static void test_read(void)
+{
+    uint8_t buf[32];
+    tty_init_irq(&tty, rx, tx, sizeof(rx), kick);
+    peer = rx_irq;
+
+    /* Ten bytes arriving one per tick: one sleep, one wakeup */
+    reset();
+    arrive("0123456789");
+    assert(tty_read_wait(&tty, buf, sizeof(buf), 10, TTY_WAIT_FOREVER) == 10);
+    assert(memcmp(buf, "0123456789", 10) == 0);
+    assert(blocks == 1 && wakes == 1);
+
+    /* Already buffered: no sleep, and min 0 never sleeps */
+    reset();
+    assert(tty_rx_isr(&tty, 'a') && tty_rx_isr(&tty, 'b'));
+    assert(tty_read_wait(&tty, buf, sizeof(buf), 2, TTY_WAIT_FOREVER) == 2);
+    assert(tty_read_wait(&tty, buf, sizeof(buf), 0, TTY_WAIT_FOREVER) == 0);
+    assert(blocks == 0 && memcmp(buf, "ab", 2) == 0);
+
+    /* After min, whatever else is ready comes too (up to len) */
+    reset();
+    for (uint8_t c = 0; c < 5; c++) tty_rx_isr(&tty, c);
+    assert(tty_read_wait(&tty, buf, 4, 1, TTY_WAIT_FOREVER) == 4 && blocks == 0);
+    assert(tty_read(&tty, buf, sizeof(buf)) == 1 && buf[0] == 4);
+
+    /* Timeout: three bytes, then the line goes quiet */
+    reset();
+    arrive("xyz");
+    uint32_t t0 = fake_ticks;
+    assert(tty_read_wait(&tty, buf, sizeof(buf), 8, 20) == 3);
+    assert(memcmp(buf, "xyz", 3) == 0 && fake_ticks - t0 == 20 && wakes == 0);
+    assert(!tty.rx_wait);
+
+    /* More than the ring holds: woken per full ring, nothing lost */
+    reset();
+    arrive("ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+    assert(tty_read_wait(&tty, buf, sizeof(buf), 26, 1000) == 26);
+    assert(memcmp(buf, "ABCDEFGHIJKLMNOPQRSTUVWXYZ", 26) == 0);
+    assert(wakes == 2 && !tty_overflow_occurred(&tty));
+}
+
+static void test_poll_wakes(void)
+{
+    uint8_t buf[8];
+    tty_init(&tty, rx, tx, sizeof(rx), uart_putc, uart_getc);
+    peer = poll_irq;
+
+    /* tty_poll() moves a burst in at once and wakes the reader once */
+    reset();
+    arrive("hello");
+    assert(tty_read_wait(&tty, buf, sizeof(buf), 5, TTY_WAIT_FOREVER) == 5);
+    assert(memcmp(buf, "hello", 5) == 0 && blocks == 1 && wakes == 1);
+}
+
+static void test_write(void)
+{
+    uint8_t msg[40];
+    for (size_t i = 0; i < sizeof(msg); i++) msg[i] = (uint8_t)('a' + i % 26);
+
+    /* Interrupt-driven: 40 bytes through a 16-byte ring */
+    tty_init_irq(&tty, rx, tx, sizeof(tx), kick);
+    peer = tx_irq;
+    reset();
+    wire_len = 0;
+    assert(tty_write_wait(&tty, msg, sizeof(msg), TTY_WAIT_FOREVER) == (int)sizeof(msg));
+    while (tty_tx_free(&tty) < 15) tx_irq();
+    assert(wire_len == sizeof(msg) && memcmp(wire, msg, sizeof(msg)) == 0);
+
+    /* Woken per half ring, not per byte: 15 up front, 8 + 8 + 8 + 1 */
+    assert(blocks == 4 && wakes == 4);
+
+    /* Timeout with a stalled UART: what fits is queued */
+    peer = kick;
+    reset();
+    assert(tty_write_wait(&tty, msg, sizeof(msg), 5) == 15);
+    assert(blocks == 1 && wakes == 0 && !tty.tx_wait);
+
+    /* Polled: putc flushes each chunk, never sleeps */
+    tty_init(&tty, rx, tx, sizeof(tx), uart_putc, NULL);
+    reset();
+    wire_len = 0;
+    assert(tty_write_wait(&tty, msg, sizeof(msg), TTY_WAIT_FOREVER) == (int)sizeof(msg));
+    assert(wire_len == sizeof(msg) && memcmp(wire, msg, sizeof(msg)) == 0 && blocks == 0);
+}
+
+int main(void)
+{
+    test_read();
+    test_poll_wakes();
+    test_write();
+    printf("tty_block_test: ok\n");
+    return 0;
+}
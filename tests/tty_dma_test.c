@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* DMA-driven TTY: a fake DMA engine in place of the UART's */
+
+#define TTY_DMA 1
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "drivers/tty/tty.h"
+
+static tty_t   tty;
+static uint8_t rx[16], tx[16];
+
+/*─── RX: circular DMA into the ring, idle-line ISR publishes ────────*/
+static uint16_t dma_pos;                /* size - remaining */
+
+static void line_rx(const char *s)
+{
+    for (; *s; s++) {
+        rx[dma_pos] = (uint8_t)*s;
+        dma_pos = (uint16_t)((dma_pos + 1u) % sizeof(rx));
+    }
+    tty_rx_dma_isr(&tty, dma_pos);      /* line went idle */
+}
+
+/*─── TX: one burst per contiguous span, chained from "complete" ───────*/
+static uint8_t  wire[256];
+static size_t   wire_len;
+static uint16_t inflight;
+static int      bursts;
+
+static void dma_start(void)
+{
+    const uint8_t *p;
+    inflight = tty_tx_dma_span(&tty, &p);
+    if (inflight) {
+        memcpy(wire + wire_len, p, inflight);
+        bursts++;
+    }
+}
+
+static void kick(void)
+{
+    if (!inflight) dma_start();
+}
+
+static void dma_tc_isr(void)
+{
+    wire_len += inflight;
+    tty_tx_dma_done(&tty, inflight);
+    dma_start();
+}
+
+static void test_rx(void)
+{
+    uint8_t buf[32];
+    tty_init_irq(&tty, rx, tx, sizeof(rx), kick);
+    dma_pos = 0;
+
+    /* A whole line becomes readable at once */
+    line_rx("hello");
+    assert(tty_rx_available(&tty) == 5);
+    assert(tty_read(&tty, buf, sizeof(buf)) == 5 && memcmp(buf, "hello", 5) == 0);
+
+    /* Across the wrap */
+    line_rx("0123456789ab");
+    assert(tty_rx_available(&tty) == 12);
+    assert(tty_read(&tty, buf, sizeof(buf)) == 12 && memcmp(buf, "0123456789ab", 12) == 0);
+    assert(tty.rx_head == (5 + 12) % 16 && !tty_overflow_occurred(&tty));
+
+    /* No progress, no change */
+    tty_rx_dma_isr(&tty, dma_pos);
+    assert(tty_rx_available(&tty) == 0);
+
+    /* More than was free: unread bytes were overwritten */
+    line_rx("abcdefghij");
+    line_rx("KLMNOPQ");
+    assert(tty_overflow_occurred(&tty));
+}
+
+static void test_tx(void)
+{
+    tty_init_irq(&tty, rx, tx, sizeof(tx), kick);
+    wire_len = 0;
+    inflight = 0;
+    bursts = 0;
+
+    /* One burst for the whole write */
+    assert(tty_write(&tty, (const uint8_t *)"hello", 5) == 5);
+    assert(bursts == 1 && inflight == 5);
+    dma_tc_isr();
+    assert(bursts == 1 && inflight == 0 && tty_tx_free(&tty) == 15);
+    assert(wire_len == 5 && memcmp(wire, "hello", 5) == 0);
+
+    /* Wrapping data goes out as two bursts: to the end, then the rest */
+    assert(tty_write(&tty, (const uint8_t *)"0123456789abcd", 14) == 14);
+    assert(inflight == 11);
+    dma_tc_isr();
+    assert(inflight == 3);
+    dma_tc_isr();
+    assert(inflight == 0 && bursts == 3);
+    assert(wire_len == 19 && memcmp(wire + 5, "0123456789abcd", 14) == 0);
+
+    /* Writes while a burst is in flight join the next one */
+    uint8_t msg[60];
+    for (size_t i = 0; i < sizeof(msg); i++) msg[i] = (uint8_t)('A' + i % 26);
+    size_t sent = 0;
+    while (sent < sizeof(msg) || inflight) {
+        if (sent < sizeof(msg)) {
+            size_t n = sizeof(msg) - sent < 7 ? sizeof(msg) - sent : 7;
+            sent += (size_t)tty_write(&tty, msg + sent, n);
+        }
+        if (inflight) dma_tc_isr();
+    }
+    assert(wire_len == 19 + sizeof(msg) && memcmp(wire + 19, msg, sizeof(msg)) == 0);
+    assert(tty_tx_free(&tty) == 15);
+}
+
+int main(void)
+{
+    test_rx();
+    test_tx();
+    printf("tty_dma_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Interrupt-driven TTY: the ISR halves called in place of the UART */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "drivers/tty/tty.h"
+
+/*─── A UART whose TX-empty "interrupt" runs while enabled ────────────*/
+static tty_t   tty;
+static uint8_t rx[16], tx[16];
+static bool    udrie;                   /* TX-empty interrupt enabled */
+static uint8_t wire[256];
+static size_t  wire_len;
+static int     kicks;
+
+static void kick(void) { udrie = true; kicks++; }
+
+/* One UDRE interrupt: send a byte, or disable when the ring is dry */
+static void udre_isr(void)
+{
+    int c = tty_tx_isr(&tty);
+    if (c < 0) {
+        udrie = false;
+    } else {
+        wire[wire_len++] = (uint8_t)c;
+    }
+}
+
+static void test_tx(void)
+{
+    tty_init_irq(&tty, rx, tx, sizeof(rx), kick);
+    assert(!udrie && tty_tx_isr(&tty) == -1);
+
+    /* Queued, not sent: the call returns before the UART is touched */
+    assert(tty_write(&tty, (const uint8_t *)"hello", 5) == 5);
+    assert(udrie && kicks == 1 && wire_len == 0 && tty_tx_free(&tty) == 10);
+
+    /* The ISR drains it and switches itself off */
+    while (udrie) udre_isr();
+    assert(wire_len == 5 && memcmp(wire, "hello", 5) == 0);
+    assert(tty_tx_free(&tty) == 15);
+
+    /* A full ring takes what fits; the rest is the caller's */
+    uint8_t msg[40];
+    for (size_t i = 0; i < sizeof(msg); i++) msg[i] = (uint8_t)('a' + i % 26);
+    assert(tty_write(&tty, msg, sizeof(msg)) == 15);
+    assert(tty_write(&tty, msg + 15, 1) == 0 && kicks == 2);
+
+    /* Writes interleaved with the ISR keep order across the wrap */
+    size_t sent = 15;
+    while (udrie || sent < sizeof(msg)) {
+        if (udrie) udre_isr();
+        if (sent < sizeof(msg)) {
+            sent += (size_t)tty_write(&tty, msg + sent, 3 < sizeof(msg) - sent ? 3 : sizeof(msg) - sent);
+        }
+    }
+    assert(wire_len == 5 + sizeof(msg) && memcmp(wire + 5, msg, sizeof(msg)) == 0);
+
+    /* Nothing queued, nothing kicked */
+    int k = kicks;
+    assert(tty_write(&tty, msg, 0) == 0 && kicks == k && !udrie);
+}
+
+static void test_rx(void)
+{
+    uint8_t buf[32];
+    tty_init_irq(&tty, rx, tx, sizeof(rx), kick);
+
+    /* Polling is a no-op: bytes only arrive through the ISR */
+    tty_poll(&tty);
+    assert(tty_rx_available(&tty) == 0);
+
+    for (uint8_t c = 0; c < 10; c++) assert(tty_rx_isr(&tty, c));
+    assert(tty_rx_available(&tty) == 10);
+    assert(tty_read(&tty, buf, 4) == 4 && buf[0] == 0 && buf[3] == 3);
+
+    /* Wraps, then overflows: the excess byte is dropped and flagged */
+    for (uint8_t c = 10; c < 19; c++) assert(tty_rx_isr(&tty, c));
+    assert(tty_rx_available(&tty) == 15);
+    assert(!tty_rx_isr(&tty, 99));
+    assert(tty_overflow_occurred(&tty) && !tty_overflow_occurred(&tty));
+    assert(tty_read(&tty, buf, sizeof(buf)) == 15);
+    for (int i = 0; i < 15; i++) assert(buf[i] == 4 + i);
+
+    /* An "interrupt" between every byte the reader takes */
+    uint8_t next = 0, expect = 0;
+    for (int round = 0; round < 200; round++) {
+        tty_rx_isr(&tty, next++);
+        if (round % 3 == 0) tty_rx_isr(&tty, next++);
+        uint8_t c;
+        while (tty_read(&tty, &c, 1) == 1) assert(c == expect++);
+    }
+    assert(expect == next && !tty_overflow_occurred(&tty));
+}
+
+/* Rings past 256 bytes need 16-bit indices */
+static void test_big_ring(void)
+{
+#if TTY_INDEX_BITS == 16
+    static uint8_t big_rx[1024], big_tx[16], buf[1024];
+    tty_init_irq(&tty, big_rx, big_tx, sizeof(big_rx), kick);
+    assert(tty.mask == 1023);
+
+    for (int i = 0; i < 1023; i++) assert(tty_rx_isr(&tty, (uint8_t)(i * 3)));
+    assert(!tty_rx_isr(&tty, 0) && tty_rx_available(&tty) == 1023);
+    assert(tty_read(&tty, buf, 700) == 700);
+    for (int i = 0; i < 700; i++) assert(buf[i] == (uint8_t)(i * 3));
+
+    /* Across the wrap: 323 left, 600 more */
+    for (int i = 0; i < 600; i++) assert(tty_rx_isr(&tty, (uint8_t)i));
+    assert(tty_read(&tty, buf, sizeof(buf)) == 923);
+    assert(buf[322] == (uint8_t)(1022 * 3) && buf[323] == 0 && buf[922] == (uint8_t)599);
+    assert(tty.rx_tail == (700 + 923) % 1024);
+#endif
+}
+
+int main(void)
+{
+    test_tx();
+    test_rx();
+    test_big_ring();
+    printf("tty_irq_test: ok\n");
+    return 0;
+}
@@ -348,6 +348,57 @@ static void test_bulk_operations(void) {
     printf("  → Bulk write successful\n");
 }
 
+/**
+ * Test 9: Bulk copies across the wrap point
+ */
+static uint8_t sink[64];
+static size_t sink_len = 0;
+
+static void sink_putc(uint8_t c) {
+    sink[sink_len++] = c;
+}
+
+static void test_bulk_wrap(void) {
+    printf("\nTest 9: Bulk Wrap\n");
+    printf("-----------------\n");
+
+    uint8_t rx_buf[16], tx_buf[16], out[32];
+    const uint8_t msg[] = "0123456789ABCDEFGHIJ";
+    tty_t tty;
+
+    tty_init(&tty, rx_buf, tx_buf, 16, sink_putc, mock_getc);
+
+    /* Start near the end so each write splits into two segments */
+    tty.tx_head = tty.tx_tail = 11;
+    int n = tty_write(&tty, msg, 10);
+    TEST_ASSERT(n == 10 && sink_len == 10, "Write across wrap sent 10 bytes");
+    TEST_ASSERT(memcmp(sink, msg, 10) == 0, "Wrapped write kept order");
+    TEST_ASSERT(tty.tx_head == 5 && tty.tx_tail == 5, "TX indices wrapped to 5");
+
+    n = tty_write(&tty, msg, 20);
+    TEST_ASSERT(n == 15, "Write clipped to 15 free slots");
+
+    /* RX: fill across the end, read in one call */
+    tty.rx_head = tty.rx_tail = 13;
+    for (int i = 0; i < 12; i++) {
+        mock_rx_byte = 'a' + i;
+        tty_poll(&tty);
+    }
+    n = tty_read(&tty, out, sizeof(out));
+    TEST_ASSERT(n == 12, "Read across wrap returned 12 bytes");
+    TEST_ASSERT(memcmp(out, "abcdefghijkl", 12) == 0, "Wrapped read kept order");
+    TEST_ASSERT(tty.rx_tail == 9 && tty_rx_available(&tty) == 0, "RX tail wrapped to 9");
+
+    /* Partial reads leave the rest in place */
+    for (int i = 0; i < 5; i++) {
+        mock_rx_byte = 'v' + i;
+        tty_poll(&tty);
+    }
+    n = tty_read(&tty, out, 3);
+    TEST_ASSERT(n == 3 && memcmp(out, "vwx", 3) == 0, "Partial read");
+    TEST_ASSERT(tty_read(&tty, out, 0) == 0 && tty_rx_available(&tty) == 2, "Zero-length read");
+}
+
 /**
  * Main test runner
  */
@@ -364,6 +415,7 @@ int main(void) {
     test_overflow_detection();
     test_buffer_space_calculation();
     test_bulk_operations();
+    test_bulk_wrap();
 
     /* Summary */
     printf("\n=== Test Summary ===\n");
@@ -0,0 +1,165 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* TTY RX-high / TX-low watermark events (drivers/tty/tty.c) */
+
+#define TTY_WATERMARKS 1
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../drivers/tty/tty.c"
+
+/*─── Stub work queue: one slot, run by hand ─────────────────────────*/
+static nk_work_fn posted_fn;
+static void      *posted_arg;
+static int        posts;
+
+bool nk_work_post(nk_work_fn fn, void *arg)
+{
+    if (posted_fn) return false;
+    posted_fn = fn;
+    posted_arg = arg;
+    posts++;
+    return true;
+}
+
+static void work_run(void)
+{
+    nk_work_fn fn = posted_fn;
+    posted_fn = NULL;
+    if (fn) fn(posted_arg);
+}
+
+/*─── An interrupt-driven TTY and an event log ───────────────────────*/
+static tty_t   tty;
+static uint8_t rx[16], tx[16];
+static uint8_t seen;
+static int     calls;
+
+static void kick(void) {}
+
+static void on_event(tty_t *t, uint8_t ev, void *arg)
+{
+    assert(t == &tty && arg == &seen);
+    seen |= ev;
+    calls++;
+}
+
+static void drain(void) { while (tty_tx_isr(&tty) >= 0) {} }
+
+static void test_rx_high(void)
+{
+    uint8_t buf[16];
+    tty_init_irq(&tty, rx, tx, sizeof(rx), kick);
+    tty_set_watermarks(&tty, 8, 0, on_event, &seen, false);
+    seen = 0; calls = 0;
+
+    /* Fires once, on the byte that reaches the mark */
+    for (uint8_t c = 0; c < 7; c++) tty_rx_isr(&tty, c);
+    assert(calls == 0);
+    tty_rx_isr(&tty, 7);
+    assert(calls == 1 && seen == TTY_EV_RX_HIGH);
+    tty_rx_isr(&tty, 8);
+    assert(calls == 1);
+
+    /* A read re-arms it; still above the mark, the next byte fires */
+    assert(tty_read(&tty, buf, 1) == 1);
+    tty_rx_isr(&tty, 9);
+    assert(calls == 2);
+
+    /* Drained and refilled */
+    assert(tty_read(&tty, buf, sizeof(buf)) == 9);
+    for (uint8_t c = 0; c < 8; c++) tty_rx_isr(&tty, c);
+    assert(calls == 3);
+
+    /* rx_high 0 turns the RX event off */
+    tty_read(&tty, buf, sizeof(buf));
+    tty_set_watermarks(&tty, 0, 0, on_event, &seen, false);
+    for (uint8_t c = 0; c < 15; c++) tty_rx_isr(&tty, c);
+    assert(calls == 3);
+}
+
+static void test_tx_low(void)
+{
+    uint8_t msg[15];
+    memset(msg, 'x', sizeof(msg));
+    tty_init_irq(&tty, rx, tx, sizeof(tx), kick);
+    tty_set_watermarks(&tty, 0, 4, on_event, &seen, false);
+    seen = 0; calls = 0;
+
+    /* Fires as the queue drains to 4 bytes, not before, not twice */
+    assert(tty_write(&tty, msg, sizeof(msg)) == 15);
+    for (int i = 0; i < 10; i++) tty_tx_isr(&tty);
+    assert(calls == 0);
+    tty_tx_isr(&tty);
+    assert(calls == 1 && seen == TTY_EV_TX_LOW);
+    drain();
+    assert(calls == 1);
+
+    /* A small write below the mark fires with the next byte out */
+    assert(tty_write(&tty, msg, 2) == 2);
+    tty_tx_isr(&tty);
+    assert(calls == 2);
+    drain();
+
+    /* Streaming: the callback refills, the ISR never sees an empty ring */
+    static const char text[] = "The quick brown fox jumps over the lazy dog, twice over.";
+    static size_t pos;
+    static char out[sizeof(text)];
+    size_t out_len = 0;
+    pos = (size_t)tty_write(&tty, (const uint8_t *)text, sizeof(text) - 1);
+    calls = 0;
+    while (out_len < sizeof(text) - 1) {
+        int c = tty_tx_isr(&tty);
+        assert(c >= 0);
+        out[out_len++] = (char)c;
+        if (seen & TTY_EV_TX_LOW) {
+            seen = 0;
+            pos += (size_t)tty_write(&tty, (const uint8_t *)text + pos, sizeof(text) - 1 - pos);
+        }
+    }
+    assert(memcmp(out, text, sizeof(text) - 1) == 0 && pos == sizeof(text) - 1);
+    assert(calls == 5);             /* four refills, then the tail */
+}
+
+static void test_deferred(void)
+{
+    tty_init_irq(&tty, rx, tx, sizeof(rx), kick);
+    tty_set_watermarks(&tty, 4, 2, on_event, &seen, true);
+    seen = 0; calls = 0; posts = 0;
+
+    /* The ISR only posts; both events coalesce into one run */
+    for (uint8_t c = 0; c < 4; c++) tty_rx_isr(&tty, c);
+    assert(posts == 1 && calls == 0);
+    assert(tty_write(&tty, (const uint8_t *)"abc", 3) == 3);
+    tty_tx_isr(&tty);
+    assert(posts == 1 && calls == 0);
+    work_run();
+    assert(calls == 1 && seen == (TTY_EV_RX_HIGH | TTY_EV_TX_LOW));
+
+    /* After the run, the next event posts again */
+    uint8_t buf[8];
+    tty_read(&tty, buf, sizeof(buf));
+    for (uint8_t c = 0; c < 4; c++) tty_rx_isr(&tty, c);
+    assert(posts == 2);
+    work_run();
+    assert(calls == 2);
+
+    /* Disabled: nothing fires */
+    tty_set_watermarks(&tty, 4, 2, NULL, NULL, false);
+    tty_read(&tty, buf, sizeof(buf));
+    for (uint8_t c = 0; c < 8; c++) tty_rx_isr(&tty, c);
+    assert(posts == 2 && calls == 2);
+}
+
+int main(void)
+{
+    test_rx_high();
+    test_tx_low();
+    test_deferred();
+    printf("tty_wm_test: ok\n");
+    return 0;
+}
@@ -0,0 +1,198 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* UDP sockets over a SLIP loopback: demux, checksums, zero-copy paths */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "drivers/net/udp.h"
+#include "drivers/net/slip.h"
+#include "drivers/tty/tty.h"
+
+/*─── Loopback line ───────────────────────────────────────────────────*/
+static uint8_t  line[4096];
+static size_t   line_len, line_pos, line_budget;
+
+static void line_putc(uint8_t c)
+{
+    assert(line_len < sizeof(line));
+    line[line_len++] = c;
+}
+
+static int line_getc(void)
+{
+    if (line_pos == line_len || line_budget == 0) return -1;
+    line_budget--;
+    return line[line_pos++];
+}
+
+static tty_t   serial;
+static uint8_t tty_rx[64], tty_tx[64];
+
+/* Deliver what the line holds without overrunning the RX ring, until
+ * it is empty or nothing more is taken; returns datagrams queued */
+static int pump(void)
+{
+    int n = 0;
+    for (;;) {
+        size_t before = line_pos;
+        line_budget = sizeof(tty_rx) - 1 - tty_rx_available(&serial);
+        tty_poll(&serial);
+        n += udp_poll(&serial);
+        if (line_pos == before) return n;
+    }
+}
+
+/* Last frame sent, decoded */
+static uint8_t last[128];
+static size_t  last_len;
+
+static void capture(size_t start)
+{
+    assert(line[start] == SLIP_END && line[line_len - 1] == SLIP_END);
+    last_len = 0;
+    for (size_t i = start + 1; i < line_len - 1; i++) {
+        uint8_t b = line[i];
+        if (b == SLIP_ESC) b = line[++i] == SLIP_ESC_END ? SLIP_END : SLIP_ESC;
+        assert(last_len < sizeof(last));
+        last[last_len++] = b;
+    }
+}
+
+#define ME   0x0A000001u
+#define PEER 0x0A000002u
+
+int main(void)
+{
+#if CONFIG_NET_UDP_ENABLED && PBUF_COUNT >= 2
+    tty_init(&serial, tty_rx, tty_tx, sizeof(tty_rx), line_putc, line_getc);
+    udp_init(ME);
+
+    /* Binding: conflicts, ephemeral ports, table size */
+    int s = udp_bind(7000);
+    assert(s >= 0 && udp_port(s) == 7000 && udp_bind(7000) == -1);
+    int e = udp_bind(0);
+    assert(e >= 0 && udp_port(e) == UDP_EPHEMERAL_BASE);
+    int more[UDP_MAX_SOCKETS];
+    int bound = 0;
+    while ((more[bound] = udp_bind(0)) >= 0) bound++;
+    assert(bound == UDP_MAX_SOCKETS - 2);
+    for (int i = 0; i < bound; i++) udp_close(more[i]);
+    assert(udp_port(more[0]) == 0 && udp_port(-1) == 0);
+
+    /* sendto → wire → recvfrom, with a checksum a peer would accept */
+    size_t start = line_len;
+    assert(udp_sendto(&serial, e, ME, 7000, "ping", 4) == 4);
+    capture(start);
+    assert(last_len == 20 + 8 + 4 && memcmp(last + 28, "ping", 4) == 0);
+    assert(ipv4_checksum(last, 20) == 0);
+    uint8_t ph[12 + 12];
+    memcpy(ph, last + 12, 8);                        /* saddr, daddr */
+    ph[8] = 0; ph[9] = IPV4_PROTO_UDP; ph[10] = 0; ph[11] = 12;
+    memcpy(ph + 12, last + 20, 12);
+    assert(ipv4_checksum(ph, sizeof(ph)) == 0);
+
+    assert(pump() == 1);
+    char buf[16];
+    uint32_t from = 0;
+    uint16_t port = 0;
+    assert(udp_recvfrom(s, buf, sizeof(buf), &from, &port) == 4);
+    assert(memcmp(buf, "ping", 4) == 0 && from == ME && port == UDP_EPHEMERAL_BASE);
+    assert(udp_recvfrom(s, buf, sizeof(buf), NULL, NULL) == 0);
+    assert(pbuf_used() == 1);                        /* the decoder's spare */
+
+    /* Zero-copy both ways: the payload never leaves its pbuf */
+    pbuf_t *p = pbuf_alloc(PBUF_HLEN_TRANSPORT);
+    memcpy(pbuf_put(p, 5), "hello", 5);
+    assert(udp_send_pbuf(&serial, s, ME, UDP_EPHEMERAL_BASE, p) == 0);
+    assert(p->off == PBUF_HLEN_TRANSPORT - 28 && p->len == 33);
+    pbuf_free(p);
+    assert(pump() == 1 && udp_recv_pbuf(s, NULL, NULL) == NULL);
+    p = udp_recv_pbuf(e, &from, &port);
+    assert(p && p->len == 5 && memcmp(pbuf_data(p), "hello", 5) == 0);
+    assert(p->off == 28 && port == 7000);
+    pbuf_free(p);
+    p = pbuf_alloc(PBUF_HLEN_IP);                    /* no room for UDP */
+    assert(udp_send_pbuf(&serial, s, ME, 9, p) == -1);
+    pbuf_free(p);
+
+    /* Odd payloads and the checksum's odd trailing byte */
+    assert(udp_sendto(&serial, e, ME, 7000, "abc", 3) == 3);
+    assert(udp_sendto(&serial, e, ME, 7000, NULL, 0) == 0);
+    assert(pump() == 2);
+    assert(udp_recvfrom(s, buf, sizeof(buf), NULL, NULL) == 3 && memcmp(buf, "abc", 3) == 0);
+    p = udp_recv_pbuf(s, NULL, NULL);
+    assert(p && p->len == 0);
+    pbuf_free(p);
+
+    /* Corrupted, checksum-less, padded and misdirected datagrams */
+    uint16_t dropped = udp_dropped();
+    start = line_len;
+    udp_sendto(&serial, e, ME, 7000, "data", 4);
+    capture(start);
+    line_len = start;                                /* replay by hand */
+
+    last[30] ^= 1;                                   /* payload flip */
+    slip_send_packet(&serial, last, last_len);
+    assert(pump() == 0 && udp_dropped() == dropped + 1);
+
+    last[30] ^= 1;
+    last[26] = last[27] = 0;                         /* no checksum */
+    slip_send_packet(&serial, last, last_len);
+    assert(pump() == 1 && udp_recvfrom(s, buf, sizeof(buf), NULL, NULL) == 4);
+
+    last[last_len] = 0xEE;                           /* trailing pad byte */
+    last[3] = (uint8_t)(last[3] + 1);                /* IPv4 length +1 */
+    last[10] = last[11] = 0;
+    uint16_t c = ipv4_htons(ipv4_checksum(last, 20));
+    memcpy(last + 10, &c, 2);
+    slip_send_packet(&serial, last, last_len + 1);
+    assert(pump() == 1 && udp_recvfrom(s, buf, sizeof(buf), NULL, NULL) == 4);
+
+    udp_sendto(&serial, e, ME, 7001, "x", 1);        /* unbound port */
+    assert(pump() == 0 && udp_dropped() == dropped + 2);
+
+    ipv4_hdr_t icmp;                                 /* not UDP */
+    ipv4_init_header(&icmp, PEER, ME, IPV4_PROTO_ICMP, 4);
+    ipv4_send(&serial, &icmp, "echo", 4);
+    assert(pump() == 0 && pbuf_used() == 1);
+
+#if PBUF_COUNT > UDP_RX_QUEUE
+    /* A full queue drops; closing frees what was queued */
+    for (int i = 0; i < UDP_RX_QUEUE + 1; i++) udp_sendto(&serial, e, ME, 7000, "q", 1);
+    assert(pump() == UDP_RX_QUEUE && udp_dropped() == dropped + 3);
+    assert(pbuf_used() == 1 + UDP_RX_QUEUE);
+    udp_close(s);
+    assert(pbuf_used() == 1);
+#else
+    /* Queued datagrams hold the whole pool: the next waits in the TTY */
+    for (int i = 0; i < PBUF_COUNT + 1; i++) udp_sendto(&serial, e, ME, 7000, "q", 1);
+    assert(pump() == PBUF_COUNT && pbuf_used() == PBUF_COUNT);
+    assert(tty_rx_available(&serial) > 0 && udp_dropped() == dropped + 2);
+    udp_close(s);
+    assert(pbuf_used() == 0);
+    s = udp_bind(7000);
+    assert(pump() == 1 && udp_recvfrom(s, buf, sizeof(buf), NULL, NULL) == 1);
+    udp_close(s);
+#endif
+    assert(udp_recvfrom(s, buf, sizeof(buf), NULL, NULL) == -1);
+
+    /* Bad arguments */
+    assert(udp_sendto(&serial, s, ME, 7000, "x", 1) == -1);
+    static uint8_t big[UDP_MAX_PAYLOAD + 1];
+    assert(udp_sendto(&serial, e, ME, 7000, big, sizeof(big)) == -1);
+    assert(udp_sendto(&serial, e, ME, 7000, big, UDP_MAX_PAYLOAD) == UDP_MAX_PAYLOAD);
+    line_pos = line_len;
+    assert(udp_sendto(NULL, e, ME, 7000, "x", 1) == -1);
+
+    udp_init(ME);
+    assert(udp_port(e) == 0);
+    printf("udp: ok\n");
+#else
+    printf("udp: skipped (needs net_udp_enabled and net_pbufs >= 2)\n");
+#endif
+    return 0;
+}
@@ -0,0 +1,144 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* vfs_open() path cache (drivers/fs/vfs.c) over stub filesystems */
+
+#define VFS_PATH_CACHE 2
+#define VFS_READAHEAD  0        /* counts every ROMFS walk and read */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../drivers/fs/vfs.c"
+#include "../kernel/mm/nk_pool.c"
+
+/*─── Stub filesystems: count directory walks ─────────────────────────*/
+static const romfs_file_t rom_files[3];
+static const eepfs_file_t eep_file;
+static unsigned rom_walks, eep_walks;
+
+const romfs_file_t *romfs_open(const char *path)
+{
+    rom_walks++;
+    if (strcmp(path, "/a") == 0) return &rom_files[0];
+    if (strcmp(path, "/b") == 0) return &rom_files[1];
+    if (strcmp(path, "/c") == 0) return &rom_files[2];
+    return NULL;
+}
+
+int romfs_read(const romfs_file_t *f, uint16_t off, void *buf, uint16_t len)
+{
+    (void)off; (void)buf; (void)len;
+    return (int)(f - rom_files);
+}
+
+int romfs_readv(const romfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt)
+{
+    (void)off; (void)iov; (void)cnt;
+    return (int)(f - rom_files);
+}
+
+const uint8_t *romfs_map(const romfs_file_t *f, uint16_t *len)
+{
+    (void)f; (void)len;
+    return NULL;
+}
+
+const eepfs_file_t *eepfs_open(const char *path)
+{
+    eep_walks++;
+    return strcmp(path, "/a") == 0 ? &eep_file : NULL;
+}
+
+int eepfs_read(const eepfs_file_t *f, uint16_t off, void *buf, uint16_t len)
+{
+    (void)f; (void)off; (void)buf; (void)len;
+    return 9;
+}
+
+int eepfs_write(const eepfs_file_t *f, uint16_t off, const void *buf, uint16_t len)
+{
+    (void)f; (void)off; (void)buf;
+    return len;
+}
+
+int eepfs_readv(const eepfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt)
+{
+    (void)f; (void)off; (void)iov; (void)cnt;
+    return 9;
+}
+
+int eepfs_writev(const eepfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt)
+{
+    (void)f; (void)off; (void)iov; (void)cnt;
+    return 0;
+}
+
+int eepfs_fsync(const eepfs_file_t *f)
+{
+    (void)f;
+    return 0;
+}
+
+uint16_t eepfs_size(const eepfs_file_t *f)
+{
+    (void)f;
+    return 0;
+}
+
+/* Open, identify by the stub's read result, close */
+static int which(const char *path)
+{
+    int fd = vfs_open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    char c;
+    int id = vfs_read(fd, &c, 1);
+    assert(vfs_close(fd) == 0);
+    return id;
+}
+
+int main(void)
+{
+    vfs_stats_t st;
+
+    vfs_init();
+    assert(vfs_mount(VFS_TYPE_ROMFS, "/rom") == 0);
+
+    /* Second open of a path skips the filesystem */
+    assert(which("/rom/a") == 0 && rom_walks == 1);
+    assert(which("/rom/a") == 0 && rom_walks == 1);
+    vfs_get_stats(&st);
+    assert(st.cache_hits == 1 && st.cache_misses == 1);
+
+    /* Failed lookups are not cached */
+    assert(which("/rom/zz") == -1 && rom_walks == 2);
+    assert(which("/rom/zz") == -1 && rom_walks == 3);
+
+    /* LRU: touching /a keeps it while /b is evicted by /c */
+    assert(which("/rom/b") == 1 && rom_walks == 4);
+    assert(which("/rom/a") == 0 && rom_walks == 4);
+    assert(which("/rom/c") == 2 && rom_walks == 5);
+    assert(which("/rom/a") == 0 && rom_walks == 5);
+    assert(which("/rom/b") == 1 && rom_walks == 6);
+
+    /* Mounting flushes: /eep/a must reach the new filesystem */
+    assert(vfs_mount(VFS_TYPE_EEPFS, "/eep") == 0);
+    assert(which("/rom/a") == 0 && rom_walks == 7);
+    assert(which("/eep/a") == 9 && eep_walks == 1);
+    assert(which("/eep/a") == 9 && eep_walks == 1);
+
+    /* Unmounting flushes: stale handles are not served */
+    assert(vfs_unmount("/eep") == 0);
+    assert(which("/eep/a") == -1 && eep_walks == 1);
+
+    /* Remount at the same point walks again */
+    assert(vfs_mount(VFS_TYPE_EEPFS, "/eep") == 0);
+    assert(which("/eep/a") == 9 && eep_walks == 2);
+
+    vfs_get_stats(&st);
+    printf("vfs path cache: %u hits, %u misses\n",
+           (unsigned)st.cache_hits, (unsigned)st.cache_misses);
+    return 0;
+}
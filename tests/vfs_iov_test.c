@@ -0,0 +1,102 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* vfs_readv()/vfs_writev() over wear-levelled EEPFS */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+static uint8_t eeprom[512];
+
+static void ee_read(void *dst, uint16_t addr, size_t n)
+{
+    assert(addr + n <= sizeof(eeprom));
+    memcpy(dst, &eeprom[addr], n);
+}
+
+static void ee_update(uint16_t addr, const void *src, size_t n)
+{
+    assert(addr + n <= sizeof(eeprom));
+    memcpy(&eeprom[addr], src, n);
+}
+
+#define EEPFS_WEAR_LEVELING 1
+#define EEPFS_CACHE_LINES   0
+#define EEPFS_EE_SIZE            sizeof(eeprom)
+#define EEPFS_EE_READ(d, a, n)   ee_read(d, a, n)
+#define EEPFS_EE_UPDATE(a, s, n) ee_update(a, s, n)
+#include "../drivers/fs/eepfs.c"
+#include "../drivers/fs/vfs.c"
+#include "../kernel/mm/nk_pool.c"
+
+int main(void)
+{
+    memset(eeprom, 0xFF, sizeof eeprom);
+    eepfs_format();
+    vfs_init();
+    assert(vfs_mount(VFS_TYPE_EEPFS, "/eep") == 0);
+
+    /* EEPFS: header, payload, CRC of one record in a single page write */
+    int fd = vfs_open("/eep/sys/message.txt", O_RDWR);
+    assert(fd >= 0);
+    uint8_t hdr[2] = { 'L', 6 }, crc = '!';
+    vfs_iovec_t wv[] = { { hdr, 2 }, { "record", 6 }, { NULL, 0 }, { &crc, 1 } };
+    uint32_t seq = wl.seq;
+    assert(vfs_writev(fd, wv, 4) == 9);
+    assert(wl.seq - seq == 1);
+    assert(vfs_lseek(fd, 0, SEEK_CUR) == 9);
+
+    /* The same record as three vfs_write()s costs three */
+    seq = wl.seq;
+    assert(vfs_lseek(fd, 0, SEEK_SET) == 0);
+    assert(vfs_write(fd, "l\007", 2) == 2 && vfs_write(fd, "RECORD", 6) == 6 &&
+           vfs_write(fd, "?", 1) == 1);
+    assert(wl.seq - seq == 3);
+
+    /* Spanning blocks: one page per block touched, read back in pieces */
+    static char big[3 * WL_PAYLOAD];
+    for (size_t i = 0; i < sizeof big; i++) {
+        big[i] = (char)('a' + i % 26);
+    }
+    vfs_iovec_t sv[] = { { big, 5 }, { big + 5, sizeof big - 5 } };
+    assert(vfs_lseek(fd, 0, SEEK_SET) == 0);
+    seq = wl.seq;
+    assert(vfs_writev(fd, sv, 2) == (int)sizeof big);
+    assert(wl.seq - seq == 3);
+    char back[sizeof big];
+    vfs_iovec_t bv[] = { { back, 1 }, { back + 1, WL_PAYLOAD }, { back + 1 + WL_PAYLOAD, sizeof back } };
+    assert(vfs_lseek(fd, 0, SEEK_SET) == 0);
+    assert(vfs_readv(fd, bv, 3) == (int)sizeof big);
+    assert(memcmp(back, big, sizeof big) == 0);
+
+    /* Backends without vectored ops get one call per segment */
+    vfs_ops_t plain = eepfs_ops;
+    plain.readv = NULL;
+    plain.writev = NULL;
+    get_fd(fd)->ops = &plain;
+    assert(vfs_lseek(fd, 0, SEEK_SET) == 0);
+    seq = wl.seq;
+    assert(vfs_writev(fd, wv, 4) == 9 && wl.seq - seq == 3);
+    memset(back, 0, sizeof back);
+    assert(vfs_lseek(fd, 0, SEEK_SET) == 0);
+    assert(vfs_readv(fd, bv, 2) == 1 + WL_PAYLOAD);
+    assert(memcmp(back, "L\006record!", 9) == 0);
+    get_fd(fd)->ops = &eepfs_ops;
+
+    /* Bad arguments */
+    assert(vfs_readv(fd, NULL, 1) == -1 && vfs_readv(fd, bv, -1) == -1);
+    assert(vfs_writev(fd, wv, VFS_IOV_MAX + 1) == -1);
+    assert(vfs_readv(fd, NULL, 0) == 0);
+    vfs_close(fd);
+
+    /* Read-only descriptors refuse */
+    fd = vfs_open("/eep/sys/message.txt", O_RDONLY);
+    assert(fd >= 0 && vfs_writev(fd, wv, 1) == -1);
+    vfs_close(fd);
+
+    printf("vfs iovec: ok\n");
+    return 0;
+}
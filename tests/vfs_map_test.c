@@ -0,0 +1,139 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* vfs_map() over the demo ROMFS, streamed out with slip_send_packet_P() */
+
+#define TTY_BLOCKING 0          /* the stub TTY below has no tty_write_wait() */
+#define VFS_POLL     0          /* nor tty_read() etc. for TTY descriptors */
+#define VFS_PROCFS   0          /* procfs.c would link the real tty.c */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../drivers/fs/vfs.c"
+#include "../drivers/fs/romfs.c"
+#include "../drivers/net/slip.c"
+#include "../kernel/mm/nk_pool.c"
+
+/*─── Stub EEPFS: opens, but cannot be mapped ─────────────────────────*/
+static const eepfs_file_t eep_file;
+
+const eepfs_file_t *eepfs_open(const char *path)
+{
+    return strcmp(path, "/msg") == 0 ? &eep_file : NULL;
+}
+
+int eepfs_read(const eepfs_file_t *f, uint16_t off, void *buf, uint16_t len)
+{
+    (void)f; (void)off; (void)buf; (void)len;
+    return 0;
+}
+
+int eepfs_write(const eepfs_file_t *f, uint16_t off, const void *buf, uint16_t len)
+{
+    (void)f; (void)off; (void)buf;
+    return len;
+}
+
+int eepfs_readv(const eepfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt)
+{
+    (void)f; (void)off; (void)iov; (void)cnt;
+    return 0;
+}
+
+int eepfs_writev(const eepfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt)
+{
+    (void)f; (void)off; (void)iov; (void)cnt;
+    return 0;
+}
+
+int eepfs_fsync(const eepfs_file_t *f)
+{
+    (void)f;
+    return 0;
+}
+
+uint16_t eepfs_size(const eepfs_file_t *f)
+{
+    (void)f;
+    return 0;
+}
+
+/*─── Stub TTY: capture what SLIP transmits ───────────────────────────*/
+static uint8_t wire[64];
+static size_t wire_len;
+static unsigned wire_calls;
+
+int tty_write(tty_t *t, const uint8_t *src, size_t len)
+{
+    (void)t;
+    wire_calls++;
+    assert(wire_len + len <= sizeof(wire));
+    memcpy(wire + wire_len, src, len);
+    wire_len += len;
+    return (int)len;
+}
+
+int tty_read(tty_t *t, uint8_t *dst, size_t len)
+{
+    (void)t; (void)dst; (void)len;
+    return 0;
+}
+
+size_t tty_rx_available(const tty_t *t)
+{
+    (void)t;
+    return 0;
+}
+
+int main(void)
+{
+    vfs_init();
+    assert(vfs_mount(VFS_TYPE_ROMFS, "/rom") == 0);
+    assert(vfs_mount(VFS_TYPE_EEPFS, "/eep") == 0);
+
+    const void *p;
+    size_t len;
+
+    /* Whole file, in place, with no copy */
+    int fd = vfs_open("/rom/README", O_RDONLY);
+    assert(fd >= 0);
+    assert(vfs_map(fd, &p, &len) == (HAL_PGM_SEPARATE ? VFS_MAP_PROGMEM : VFS_MAP_RAM));
+    assert(len == 11 && memcmp(p, "ROMFS demo\n", 11) == 0);
+    assert(p == romfs_open("/README")->data);
+
+    /* Maps from the file position, which it leaves alone */
+    assert(vfs_lseek(fd, 6, SEEK_SET) == 6);
+    assert(vfs_map(fd, &p, &len) >= 0);
+    assert(len == 5 && memcmp(p, "demo\n", 5) == 0);
+    assert(vfs_lseek(fd, 0, SEEK_CUR) == 6);
+    assert(vfs_lseek(fd, 0, SEEK_END) == 11);
+    assert(vfs_map(fd, &p, &len) >= 0 && len == 0);
+
+    /* Send a mapped file as a SLIP frame straight from flash */
+    int vfd = vfs_open("/rom/etc/config/version.txt", O_RDONLY);
+    assert(vfd >= 0 && vfs_map(vfd, &p, &len) >= 0);
+    slip_send_packet_P(NULL, p, len);
+    assert(wire_len == 0);                        /* no TTY: nothing sent */
+    tty_t fake;
+    slip_send_packet_P(&fake, p, len);
+    assert(wire_len == 6 && wire[0] == SLIP_END && wire[5] == SLIP_END);
+    assert(memcmp(wire + 1, "1.0\n", 4) == 0);
+    assert(wire_calls == 3);                      /* END, payload, END */
+    vfs_close(vfd);
+
+    /* Unmappable descriptors */
+    int efd = vfs_open("/eep/msg", O_RDONLY);
+    assert(efd >= 0);
+    assert(vfs_map(efd, &p, &len) == -1);
+    assert(vfs_map(fd, NULL, &len) == -1);
+    assert(vfs_map(VFS_MAX_FDS, &p, &len) == -1);
+    vfs_close(efd);
+    vfs_close(fd);
+    assert(vfs_map(fd, &p, &len) == -1);
+
+    printf("vfs_map: ok\n");
+    return 0;
+}
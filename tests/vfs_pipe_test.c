@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* VFS pipes (drivers/fs/vfs.c) */
+
+#define VFS_MAX_PIPES 2
+#define VFS_PIPE_BUF  16
+#define VFS_POLL      0         /* no nk_io_event in the stub scheduler */
+#define VFS_PROCFS    0         /* procfs.c would link the real one */
+#define VFS_TASK_FDS  0         /* per-task tables need the real scheduler */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../drivers/fs/vfs.c"
+#include "../kernel/mm/nk_pool.c"
+
+/*─── Stub scheduler: blocking runs the other end once ─────────────────*/
+static void (*peer)(void);
+static unsigned blocks;
+
+uint32_t nk_sched_lock(void) { return 0; }
+void nk_sched_unlock(uint32_t s) { (void)s; }
+
+void nk_waitq_block(nk_waitq_t *q)
+{
+    blocks++;
+    *q = 1;
+    assert(peer);
+    void (*fn)(void) = peer;
+    peer = NULL;
+    fn();
+}
+
+int nk_waitq_wake_one(nk_waitq_t *q)
+{
+    if (!*q) return -1;
+    *q = 0;
+    return 0;
+}
+
+uint8_t nk_waitq_wake_all(nk_waitq_t *q)
+{
+    uint8_t n = *q ? 1 : 0;
+    *q = 0;
+    return n;
+}
+
+static int fds[2];
+static char sink[64];
+static int sunk;
+
+static void reader(void)
+{
+    int n = vfs_read(fds[0], sink + sunk, 10);
+    assert(n > 0);
+    sunk += n;
+}
+
+static void writer(void)
+{
+    assert(vfs_write(fds[1], "wake", 4) == 4);
+}
+
+static void close_writer(void)
+{
+    assert(vfs_close(fds[1]) == 0);
+}
+
+int main(void)
+{
+    vfs_init();
+    assert(vfs_pipe(fds) == 0);
+    assert(fds[0] != fds[1]);
+
+    /* Direction and seeking */
+    char buf[32];
+    assert(vfs_write(fds[0], "x", 1) == -1);
+    assert(vfs_lseek(fds[1], 0, SEEK_SET) == -1);
+
+    /* Wrap-around in two segments, full capacity usable */
+    for (int lap = 0; lap < 5; ++lap) {
+        assert(vfs_write(fds[1], "0123456789", 10) == 10);
+        assert(vfs_read(fds[0], buf, 10) == 10);
+        assert(memcmp(buf, "0123456789", 10) == 0);
+    }
+    assert(vfs_write(fds[1], "ABCDEFGHIJKLMNOP", 16) == 16);
+    vfs_stat_t st;
+    assert(vfs_fstat(fds[0], &st) == 0 && st.size == 16);
+    assert(vfs_read(fds[0], buf, sizeof(buf)) == 16);
+    assert(memcmp(buf, "ABCDEFGHIJKLMNOP", 16) == 0);
+
+    /* Empty pipe: the reader blocks until the writer runs */
+    peer = writer;
+    assert(vfs_read(fds[0], buf, sizeof(buf)) == 4);
+    assert(memcmp(buf, "wake", 4) == 0 && blocks == 1);
+
+    /* Full pipe: the writer blocks until the reader drains */
+    peer = reader;
+    assert(vfs_write(fds[1], "abcdefghijklmnopqrst", 20) == 20);
+    assert(blocks == 2 && sunk == 10);
+    assert(vfs_read(fds[0], buf, sizeof(buf)) == 10);
+    assert(memcmp(sink, "abcdefghij", 10) == 0);
+    assert(memcmp(buf, "klmnopqrst", 10) == 0);
+
+    /* EOF once the write end closes, even while blocked */
+    peer = close_writer;
+    assert(vfs_read(fds[0], buf, sizeof(buf)) == 0);
+    assert(vfs_read(fds[0], buf, sizeof(buf)) == 0);
+    assert(vfs_close(fds[0]) == 0);
+    assert(nk_pool_used(&vfs_pipes) == 0);
+
+    /* Writing with no reader fails */
+    assert(vfs_pipe(fds) == 0);
+    assert(vfs_close(fds[0]) == 0);
+    assert(vfs_write(fds[1], "x", 1) == -1);
+    assert(vfs_close(fds[1]) == 0);
+
+    /* Pool and descriptor limits */
+    int a[2], b[2], c[2];
+    assert(vfs_pipe(a) == 0 && vfs_pipe(b) == 0);
+    assert(vfs_pipe(c) == -1);
+    vfs_stats_t vs;
+    vfs_get_stats(&vs);
+    assert(vs.fds_used == 4);
+    vfs_close(a[0]); vfs_close(a[1]); vfs_close(b[0]); vfs_close(b[1]);
+    vfs_get_stats(&vs);
+    assert(vs.fds_used == 0 && nk_pool_used(&vfs_pipes) == 0);
+
+    printf("vfs pipes ok\n");
+    return 0;
+}
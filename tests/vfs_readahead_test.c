@@ -0,0 +1,148 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Per-fd readahead and vfs_getc() (drivers/fs/vfs.c) over stub filesystems */
+
+#define VFS_READAHEAD 8
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../drivers/fs/vfs.c"
+#include "../kernel/mm/nk_pool.c"
+
+/*─── Stub filesystems backed by RAM: count backend reads ─────────────*/
+static const char rom_text[] = "key=value\nname=avrix\n";
+static const romfs_file_t rom_file = { .size = sizeof rom_text - 1 };
+static const eepfs_file_t eep_file;
+static char eep_text[24] = "0123456789abcdefghij";
+static unsigned backend_reads;
+
+static int ram_read(const char *src, uint16_t size, uint16_t off, void *buf, uint16_t len)
+{
+    backend_reads++;
+    if (off >= size) return 0;
+    if (len > size - off) len = (uint16_t)(size - off);
+    memcpy(buf, src + off, len);
+    return len;
+}
+
+const romfs_file_t *romfs_open(const char *path)
+{
+    return strcmp(path, "/cfg") == 0 ? &rom_file : NULL;
+}
+
+int romfs_read(const romfs_file_t *f, uint16_t off, void *buf, uint16_t len)
+{
+    (void)f;
+    return ram_read(rom_text, sizeof rom_text - 1, off, buf, len);
+}
+
+int romfs_readv(const romfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt)
+{
+    (void)f; (void)off; (void)iov; (void)cnt;
+    return -1;                                  /* unused here */
+}
+
+const uint8_t *romfs_map(const romfs_file_t *f, uint16_t *len)
+{
+    (void)f; (void)len;
+    return NULL;
+}
+
+const eepfs_file_t *eepfs_open(const char *path)
+{
+    return strcmp(path, "/msg") == 0 ? &eep_file : NULL;
+}
+
+int eepfs_read(const eepfs_file_t *f, uint16_t off, void *buf, uint16_t len)
+{
+    (void)f;
+    return ram_read(eep_text, 20, off, buf, len);
+}
+
+int eepfs_write(const eepfs_file_t *f, uint16_t off, const void *buf, uint16_t len)
+{
+    (void)f;
+    if (off + len > 20) len = (uint16_t)(20 - off);
+    memcpy(eep_text + off, buf, len);
+    return len;
+}
+
+int eepfs_readv(const eepfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt)
+{
+    (void)f; (void)off; (void)iov; (void)cnt;
+    return -1;
+}
+
+int eepfs_writev(const eepfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt)
+{
+    (void)f; (void)off; (void)iov; (void)cnt;
+    return -1;
+}
+
+int eepfs_fsync(const eepfs_file_t *f)
+{
+    (void)f;
+    return 0;
+}
+
+uint16_t eepfs_size(const eepfs_file_t *f)
+{
+    (void)f;
+    return 20;
+}
+
+int main(void)
+{
+    vfs_init();
+    assert(vfs_mount(VFS_TYPE_ROMFS, "/rom") == 0);
+    assert(vfs_mount(VFS_TYPE_EEPFS, "/eep") == 0);
+
+    /* Character at a time: one backend read per VFS_READAHEAD bytes */
+    int fd = vfs_open("/rom/cfg", O_RDONLY);
+    assert(fd >= 0);
+    char line[32];
+    size_t n = 0;
+    int c;
+    while ((c = vfs_getc(fd)) >= 0) {
+        line[n++] = (char)c;
+    }
+    assert(n == sizeof rom_text - 1 && memcmp(line, rom_text, n) == 0);
+    assert(backend_reads == 4);                 /* 21 bytes in 8s, then EOF */
+    assert(vfs_getc(fd) == -1);
+
+    /* Seeking inside the buffer keeps it; vfs_read() mixes with getc */
+    backend_reads = 0;
+    assert(vfs_lseek(fd, 10, SEEK_SET) == 10);
+    assert(vfs_getc(fd) == 'n' && backend_reads == 1);
+    assert(vfs_lseek(fd, 12, SEEK_SET) == 12);
+    assert(vfs_read(fd, line, 3) == 3 && memcmp(line, "me=", 3) == 0);
+    assert(backend_reads == 1 && vfs_lseek(fd, 0, SEEK_CUR) == 15);
+
+    /* Short reads stop at the end of the buffer, long ones bypass it */
+    assert(vfs_read(fd, line, 5) == 3 && memcmp(line, "avr", 3) == 0);
+    assert(vfs_lseek(fd, 0, SEEK_SET) == 0);
+    backend_reads = 0;
+    assert(vfs_read(fd, line, sizeof line) == (int)sizeof rom_text - 1);
+    assert(backend_reads == 1);
+    vfs_close(fd);
+
+    /* A write through another descriptor is seen by a buffered reader */
+    int r = vfs_open("/eep/msg", O_RDONLY);
+    int w = vfs_open("/eep/msg", O_RDWR);
+    assert(r >= 0 && w >= 0);
+    assert(vfs_getc(r) == '0' && vfs_getc(r) == '1');
+    assert(vfs_lseek(w, 2, SEEK_SET) == 2 && vfs_write(w, "XY", 2) == 2);
+    assert(vfs_getc(r) == 'X' && vfs_getc(r) == 'Y' && vfs_getc(r) == '4');
+    vfs_close(r);
+    vfs_close(w);
+
+    /* Bad descriptors */
+    assert(vfs_getc(-1) == -1 && vfs_getc(VFS_MAX_FDS) == -1);
+
+    printf("vfs readahead: ok\n");
+    return 0;
+}
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* ROMFS-only VFS (drivers/fs/vfs.c): direct dispatch, no ops pointers */
+
+#define VFS_ROMFS 1
+#define VFS_EEPFS 0
+#define VFS_BLKFS 0
+#define VFS_PROCFS 0
+#define VFS_MAX_PIPES 0
+#define VFS_POLL 0
+#define VFS_READAHEAD 0
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../drivers/fs/vfs.c"
+#include "../kernel/mm/nk_pool.c"
+
+_Static_assert(VFS_SOLE, "one backend, no pipes or devices");
+_Static_assert(offsetof(vfs_fd_t, position) == sizeof(const void *),
+               "descriptors carry no ops pointer");
+
+/*─── Stub ROMFS backed by RAM ────────────────────────────────────────*/
+static const char rom_text[] = "key=value\n";
+static const romfs_file_t rom_file = { .size = sizeof rom_text - 1 };
+static unsigned reads, readvs;
+
+const romfs_file_t *romfs_open(const char *path)
+{
+    return strcmp(path, "/cfg") == 0 ? &rom_file : NULL;
+}
+
+int romfs_read(const romfs_file_t *f, uint16_t off, void *buf, uint16_t len)
+{
+    (void)f;
+    reads++;
+    if (off >= sizeof rom_text - 1) return 0;
+    if (len > sizeof rom_text - 1 - off) len = (uint16_t)(sizeof rom_text - 1 - off);
+    memcpy(buf, rom_text + off, len);
+    return len;
+}
+
+int romfs_readv(const romfs_file_t *f, uint16_t off, const vfs_iovec_t *iov, uint8_t cnt)
+{
+    int total = 0;
+    readvs++;
+    for (uint8_t i = 0; i < cnt; i++) {
+        int n = romfs_read(f, (uint16_t)(off + total), iov[i].base, (uint16_t)iov[i].len);
+        total += n;
+    }
+    return total;
+}
+
+const uint8_t *romfs_map(const romfs_file_t *f, uint16_t *len)
+{
+    (void)f;
+    *len = sizeof rom_text - 1;
+    return (const uint8_t *)rom_text;
+}
+
+int main(void)
+{
+    char buf[16];
+
+    vfs_init();
+    assert(vfs_mount(VFS_TYPE_EEPFS, "/eep") == -1);   /* not compiled in */
+    assert(vfs_mount(VFS_TYPE_ROMFS, "/rom") == 0);
+    assert(vfs_mount(VFS_TYPE_ROMFS, "/etc") == 0);
+
+    int fd = vfs_open("/rom/cfg", O_RDONLY);
+    assert(fd >= 0 && vfs_open("/rom/none", O_RDONLY) == -1);
+    assert(vfs_read(fd, buf, 4) == 4 && memcmp(buf, "key=", 4) == 0);
+    assert(reads == 1);
+    assert(vfs_write(fd, "x", 1) == -1);
+
+    vfs_iovec_t iov[2] = { { buf, 2 }, { buf + 2, 8 } };
+    assert(vfs_readv(fd, iov, 2) == 6 && readvs == 1);
+    assert(memcmp(buf, "value\n", 6) == 0);
+
+    assert(vfs_lseek(fd, -3, SEEK_END) == 7);
+    const void *p;
+    size_t len;
+    assert(vfs_map(fd, &p, &len) == (HAL_PGM_SEPARATE ? VFS_MAP_PROGMEM : VFS_MAP_RAM));
+    assert(p == rom_text + 7 && len == 3);
+
+    vfs_stat_t st;
+    assert(vfs_fstat(fd, &st) == 0 && st.size == sizeof rom_text - 1);
+    assert(vfs_fsync(fd) == 0);                        /* no sync hook */
+
+    /* every fd shares the one table: any open file pins every mount */
+    assert(vfs_unmount("/etc") == -1);
+    assert(vfs_close(fd) == 0);
+    assert(vfs_unmount("/etc") == 0);
+    int pfd[2];
+    assert(vfs_pipe(pfd) == -1);
+
+    printf("vfs sole: ok\n");
+    return 0;
+}
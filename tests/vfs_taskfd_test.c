@@ -0,0 +1,87 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Per-task descriptor tables and shared open files (drivers/fs/vfs.c) */
+
+#define VFS_TASK_FDS  4
+#define VFS_MAX_PIPES 2
+#define VFS_POLL      0         /* no nk_io_event in the stub scheduler */
+#define VFS_PROCFS    0         /* procfs.c would link the real one */
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../drivers/fs/vfs.c"
+#include "../kernel/mm/nk_pool.c"
+
+/*─── Stub scheduler: nothing here ever needs to block ─────────────────*/
+static uint8_t current;
+
+uint8_t nk_current_tid(void) { return current; }
+uint32_t nk_sched_lock(void) { return 0; }
+void nk_sched_unlock(uint32_t s) { (void)s; }
+void nk_waitq_block(nk_waitq_t *q) { (void)q; assert(!"pipe should not block"); }
+int nk_waitq_wake_one(nk_waitq_t *q) { (void)q; return -1; }
+uint8_t nk_waitq_wake_all(nk_waitq_t *q) { (void)q; return 0; }
+
+static unsigned open_files(void)
+{
+    return nk_pool_used(&vfs_fds);
+}
+
+int main(void)
+{
+    int a[2], b[2];
+    char buf[8];
+
+    vfs_init();
+
+    /* every task numbers its descriptors from 0 */
+    current = 0;
+    assert(vfs_pipe(a) == 0 && a[0] == 0 && a[1] == 1);
+    current = 1;
+    assert(vfs_pipe(b) == 0 && b[0] == 0 && b[1] == 1);
+    assert(open_files() == 4);
+    assert(vfs_write(b[1], "one", 3) == 3);
+    current = 2;
+    assert(vfs_write(1, "x", 1) == -1 && vfs_close(0) == -1);
+    current = 0;
+    assert(vfs_write(a[1], "zero", 4) == 4);
+    assert(vfs_read(a[0], buf, sizeof buf) == 4 && memcmp(buf, "zero", 4) == 0);
+
+    /* dup shares the open file; the lowest free number comes back */
+    assert(vfs_dup(a[0]) == 2 && vfs_dup(a[1]) == 3);
+    assert(vfs_dup(a[0]) == -1);                       /* table full */
+    assert(open_files() == 4 && vfs_task[0].used == 0x0F);
+    assert(vfs_close(2) == 0 && open_files() == 4);
+    assert(vfs_dup(a[0]) == 2 && vfs_close(2) == 0);
+    assert(vfs_dup(7) == -1 && vfs_dup_to(a[0], NK_MAX_TASKS) == -1);
+
+    /* hand the write end to task 2: the pipe stays open until it closes */
+    int w2 = vfs_dup_to(a[1], 2);
+    assert(w2 == 0);
+    assert(vfs_close(a[1]) == 0 && vfs_close(3) == 0);
+    assert(((vfs_pipe_t *)file_at(vfs_task[0].file[a[0]])->fs_file)->writers == 1);
+    current = 2;
+    assert(vfs_write(w2, "hi", 2) == 2);
+    current = 0;
+    assert(vfs_read(a[0], buf, sizeof buf) == 2 && memcmp(buf, "hi", 2) == 0);
+    current = 2;
+    assert(vfs_close(w2) == 0);
+    current = 0;
+    assert(vfs_read(a[0], buf, sizeof buf) == 0);      /* last writer gone */
+
+    /* a task's exit closes all it left open, in one pass */
+    assert(vfs_close_task(1) == 2 && vfs_task[1].used == 0);
+    current = 1;
+    assert(vfs_read(b[0], buf, sizeof buf) == -1);
+    assert(vfs_close_task(NK_MAX_TASKS) == -1);
+    nk_task_exit_hook(0);
+    assert(open_files() == 0 && nk_pool_used(&vfs_pipes) == 0);
+    assert(vfs_close_task(0) == 0);
+
+    printf("vfs task fds: ok\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: MIT
+ * See LICENSE file in the repository root for full license information.
+ */
+
+/* Warm restart (kernel/lib/nk_warm.c) resuming TinyLog-4 without a mount */
+
+#include <assert.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+static uint8_t  eeprom[1024];
+static unsigned ee_reads;
+static int      ee_fuse = -1;          /* writes left before the "reset" */
+static jmp_buf  reset;
+
+static uint8_t ee_read(uint16_t a)
+{
+    assert(a < sizeof(eeprom));
+    ee_reads++;
+    return eeprom[a];
+}
+
+static void ee_write(uint16_t a, uint8_t v)
+{
+    assert(a < sizeof(eeprom));
+    if (ee_fuse == 0) {
+        ee_fuse = -1;
+        longjmp(reset, 1);             /* watchdog bites mid-write */
+    }
+    if (ee_fuse > 0)
+        ee_fuse--;
+    eeprom[a] = v;
+}
+
+#define NK_WARM 1
+#include "../kernel/lib/nk_warm.c"
+
+#define NK_FS_INDEX 8
+#define NK_FS_BLOOM 16
+#define NK_FS_CHECKPOINT 0
+#define NK_FS_EE_READ(a)     ee_read(a)
+#define NK_FS_EE_WRITE(a, v) ee_write(a, v)
+#include "../src/nk_fs.c"
+
+static uint16_t get(uint16_t key)
+{
+    uint16_t v = 0xFFFF;
+    return nk_fs_get(key, &v) ? v : 0xFFFF;
+}
+
+/* reboot for @p why and mount; returns the EEPROM reads it took */
+static unsigned boot(hal_reset_reason_t why)
+{
+    nk_warm_init(why);
+    ee_reads = 0;
+    nk_fs_init();
+    return ee_reads;
+}
+
+static void check(void)
+{
+    for (uint16_t k = 0; k < 6; k++) {
+        assert(get(100 + k) == k + 1);
+    }
+    assert(get(7) == 9);
+    assert(get(50) == 0xFFFF);
+}
+
+int main(void)
+{
+    memset(eeprom, 0xFF, sizeof eeprom);
+    assert(!nk_warm_is_warm());
+    nk_fs_init();                      /* before nk_warm_init: always cold */
+
+    for (uint16_t k = 0; k < 6; k++) {
+        assert(nk_fs_put(100 + k, k + 1));
+    }
+    for (unsigned i = 0; i <= 9; i++) {
+        assert(nk_fs_put(7, i));
+    }
+    assert(nk_fs_put(50, 3) && nk_fs_del(50));
+
+    /* the control block was never set up: cold, then warm */
+    assert(boot(HAL_RESET_WATCHDOG) > 0 && !nk_warm_is_warm());
+    check();
+    assert(boot(HAL_RESET_WATCHDOG) == 0 && nk_warm_is_warm());
+    check();
+    assert(boot(HAL_RESET_SOFTWARE) == 0);
+    assert(boot(HAL_RESET_EXTERNAL) == 0);
+    check();
+
+    /* power-on and brown-out never trust RAM */
+    assert(boot(HAL_RESET_POWER_ON) > 0);
+    check();
+    assert(boot(HAL_RESET_BROWNOUT) > 0);
+    assert(boot(HAL_RESET_UNKNOWN) > 0);
+    assert(boot(HAL_RESET_WATCHDOG) == 0);
+
+    /* a block from before a cold boot fails its CRC afterwards */
+    static uint8_t blob[8];
+    static nk_warm_hdr_t blob_warm;
+    nk_warm_save(&blob_warm, blob, sizeof blob);
+    assert(nk_warm_restore(&blob_warm, blob, sizeof blob));
+    assert(!nk_warm_restore(&blob_warm, blob, sizeof blob - 1));
+    nk_warm_init(HAL_RESET_POWER_ON);
+    nk_warm_init(HAL_RESET_WATCHDOG);
+    assert(!nk_warm_restore(&blob_warm, blob, sizeof blob));
+
+    /* damaged RAM: the CRC catches it and the log is mounted */
+    nk_fs_init();
+    fs.idx_tab[0].loc ^= 0x10;
+    assert(boot(HAL_RESET_WATCHDOG) > 0);
+    check();
+    assert(boot(HAL_RESET_WATCHDOG) == 0);
+
+    /* a reset inside a put leaves RAM behind the EEPROM: mount again */
+    ee_fuse = 2;
+    if (setjmp(reset) == 0) {
+        nk_fs_put(7, 11);
+        assert(!"the write should have been cut short");
+    }
+    assert(boot(HAL_RESET_WATCHDOG) > 0);
+    assert(get(7) == 9);               /* torn record ignored */
+    assert(nk_fs_put(7, 12));
+    assert(boot(HAL_RESET_WATCHDOG) == 0);
+    assert(get(7) == 12);
+
+    /* gc state survives too */
+    for (unsigned i = 0; i < 200; i++) {
+        assert(nk_fs_put(7, i % 32));
+    }
+    uint8_t row = fs.cur_row, idx = fs.cur_idx, left = fs.gc_left;
+    assert(boot(HAL_RESET_SOFTWARE) == 0);
+    assert(fs.cur_row == row && fs.cur_idx == idx && fs.gc_left == left);
+    assert(get(7) == 199 % 32);
+
+    printf("warm_test: ok\n");
+    return 0;
+}
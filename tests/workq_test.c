@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: MIT */
+
+/**
+ * @file workq_test.c
+ * @brief Unit tests for the deferred interrupt work queue
+ */
+
+#include "kernel/sched/workq.h"
+#include <stdio.h>
+
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (cond) { \
+        printf("  ✓ %s\n", msg); \
+        tests_passed++; \
+    } else { \
+        printf("  ✗ %s\n", msg); \
+        tests_failed++; \
+    } \
+} while(0)
+
+static int sum = 0;
+static int order[NK_WORKQ_LEN];
+static int order_n = 0;
+
+static void add_work(void *arg) {
+    int v = (int)(long)arg;
+    sum += v;
+    order[order_n++] = v;
+}
+
+static void test_fifo(void) {
+    printf("\nTest: FIFO execution\n");
+
+    sum = 0; order_n = 0;
+    TEST_ASSERT(nk_work_post(add_work, (void *)1L), "Post item 1");
+    TEST_ASSERT(nk_work_post(add_work, (void *)2L), "Post item 2");
+    TEST_ASSERT(nk_work_post(add_work, (void *)3L), "Post item 3");
+    TEST_ASSERT(nk_work_run() == 3, "Ran 3 items");
+    TEST_ASSERT(sum == 6, "All handlers executed");
+    TEST_ASSERT(order[0] == 1 && order[1] == 2 && order[2] == 3,
+                "Items ran in post order");
+    TEST_ASSERT(nk_work_run() == 0, "Queue empty after drain");
+}
+
+static void test_overflow(void) {
+    printf("\nTest: Full queue drops\n");
+
+    sum = 0; order_n = 0;
+    for (int i = 0; i < NK_WORKQ_LEN; ++i) {
+        nk_work_post(add_work, (void *)1L);
+    }
+    TEST_ASSERT(!nk_work_post(add_work, (void *)100L), "Post fails when full");
+    TEST_ASSERT(nk_work_dropped() == 1, "Drop counted");
+    TEST_ASSERT(nk_work_run() == NK_WORKQ_LEN, "Ran full queue");
+    TEST_ASSERT(sum == NK_WORKQ_LEN, "Dropped item did not run");
+    TEST_ASSERT(!nk_work_post(NULL, NULL), "NULL handler rejected");
+}
+
+static void test_wraparound(void) {
+    printf("\nTest: Index wraparound\n");
+
+    int ok = 1;
+    for (int i = 0; i < 300; ++i) {
+        sum = 0; order_n = 0;
+        nk_work_post(add_work, (void *)(long)i);
+        if (nk_work_run() != 1 || sum != i) ok = 0;
+    }
+    TEST_ASSERT(ok, "300 post/run cycles across uint8_t wrap");
+}
+
+int main(void) {
+    printf("═══════════════════════════════════════\n");
+    printf("  Deferred Work Queue Tests\n");
+    printf("═══════════════════════════════════════\n");
+
+    test_fifo();
+    test_overflow();
+    test_wraparound();
+
+    printf("\n═══════════════════════════════════════\n");
+    printf("  Results: %d passed, %d failed\n", tests_passed, tests_failed);
+    printf("═══════════════════════════════════════\n");
+
+    return tests_failed > 0 ? 1 : 0;
+}